@@ -22,6 +22,7 @@ MCU_EXCLUDES = \
             drivers/bus_spi.c \
             drivers/bus_spi_config.c \
             drivers/bus_spi_pinconfig.c \
+            drivers/bus_spi_transaction.c \
             drivers/dma.c \
             drivers/pwm_output.c \
             drivers/timer.c \
@@ -36,6 +37,7 @@ MCU_EXCLUDES = \
             drivers/rx_xn297.c \
             drivers/display_ug2864hsweg01.c \
             telemetry/crsf.c \
+            telemetry/crsf_parameters.c \
             telemetry/srxl.c \
             io/displayport_oled.c
 
@@ -61,7 +63,12 @@ LD_FLAGS     += \
 endif
 
 ifneq ($(DEBUG),GDB)
+ifeq ($(PGO),generate)
+# trained at the levels of the F4 and F7 builds, so that more of the profiled functions match theirs
+OPTIMISE_DEFAULT    := -O2
+else
 OPTIMISE_DEFAULT    := -Ofast
+endif
 OPTIMISE_SPEED      := -Ofast
 OPTIMISE_SIZE       := -Os
 
@@ -1,10 +1,13 @@
 COMMON_SRC = \
             build/build_config.c \
             build/debug.c \
+            build/trace.c \
             build/version.c \
             $(TARGET_DIR_SRC) \
             main.c \
+            common/arena.c \
             common/bitarray.c \
+            common/crc.c \
             common/encoding.c \
             common/filter.c \
             common/maths.c \
@@ -25,6 +28,7 @@ COMMON_SRC = \
             drivers/bus_spi_config.c \
             drivers/bus_spi_pinconfig.c \
             drivers/bus_spi_soft.c \
+            drivers/bus_spi_transaction.c \
             drivers/buttons.c \
             drivers/display.c \
             drivers/exti.c \
@@ -44,6 +48,7 @@ COMMON_SRC = \
             drivers/transponder_ir_arcitimer.c \
             drivers/transponder_ir_ilap.c \
             drivers/transponder_ir_erlt.c \
+            drivers/transponder_ir_waveform.c \
             fc/config.c \
             fc/fc_dispatch.c \
             fc/fc_hardfaults.c \
@@ -76,11 +81,16 @@ FC_SRC = \
             drivers/rx_spi.c \
             drivers/rx_xn297.c \
             drivers/pwm_esc_detect.c \
+            drivers/dshot.c \
             drivers/pwm_output.c \
             drivers/rx_pwm.c \
             drivers/serial_softserial.c \
             fc/fc_core.c \
+            fc/loop_benchmark.c \
+            fc/kernel_benchmark.c \
+            fc/dshot_benchmark.c \
             fc/fc_rc.c \
+            fc/perf_record.c \
             fc/rc_adjustments.c \
             fc/rc_controls.c \
             fc/rc_modes.c \
@@ -91,6 +101,7 @@ FC_SRC = \
             flight/imu.c \
             flight/mixer.c \
             flight/pid.c \
+            flight/rpm_filter.c \
             flight/servos.c \
             io/serial_4way.c \
             io/serial_4way_avrootloader.c \
@@ -105,6 +116,8 @@ FC_SRC = \
             rx/nrf24_v202.c \
             rx/pwm.c \
             rx/rx.c \
+            rx/rx_channels.c \
+            rx/rx_link_quality.c \
             rx/rx_spi.c \
             rx/crsf.c \
             rx/sbus.c \
@@ -115,12 +128,16 @@ FC_SRC = \
             sensors/acceleration.c \
             sensors/boardalignment.c \
             sensors/compass.c \
+            sensors/compass_calibration.c \
             sensors/gyro.c \
+            sensors/gyro_bias.c \
             sensors/gyroanalyse.c \
             sensors/initialisation.c \
             blackbox/blackbox.c \
             blackbox/blackbox_encoding.c \
+            blackbox/blackbox_compress.c \
             blackbox/blackbox_io.c \
+            blackbox/blackbox_preroll.c \
             cms/cms.c \
             cms/cms_menu_blackbox.c \
             cms/cms_menu_builtin.c \
@@ -146,7 +163,10 @@ FC_SRC = \
             sensors/sonar.c \
             sensors/barometer.c \
             telemetry/telemetry.c \
+            telemetry/telemetry_snapshot.c \
+            telemetry/telemetry_scheduler.c \
             telemetry/crsf.c \
+            telemetry/crsf_parameters.c \
             telemetry/srxl.c \
             telemetry/frsky.c \
             telemetry/hott.c \
@@ -179,6 +199,9 @@ SIZE_OPTIMISED_SRC  := ""
 
 ifneq ($(TARGET),$(filter $(TARGET),$(F1_TARGETS)))
 SPEED_OPTIMISED_SRC := $(SPEED_OPTIMISED_SRC) \
+            blackbox/blackbox_compress.c \
+            build/trace.c \
+            common/crc.c \
             common/encoding.c \
             common/filter.c \
             common/maths.c \
@@ -187,6 +210,7 @@ SPEED_OPTIMISED_SRC := $(SPEED_OPTIMISED_SRC) \
             drivers/buf_writer.c \
             drivers/bus.c \
             drivers/bus_spi.c \
+            drivers/dshot.c \
             drivers/exti.c \
             drivers/gyro_sync.c \
             drivers/io.c \
@@ -204,10 +228,13 @@ SPEED_OPTIMISED_SRC := $(SPEED_OPTIMISED_SRC) \
             flight/imu.c \
             flight/mixer.c \
             flight/pid.c \
+            flight/rpm_filter.c \
             io/serial.c \
             rx/ibus.c \
             rx/jetiexbus.c \
             rx/rx.c \
+            rx/rx_channels.c \
+            rx/rx_link_quality.c \
             rx/rx_spi.c \
             rx/crsf.c \
             rx/sbus.c \
@@ -219,6 +246,7 @@ SPEED_OPTIMISED_SRC := $(SPEED_OPTIMISED_SRC) \
             sensors/acceleration.c \
             sensors/boardalignment.c \
             sensors/gyro.c \
+            sensors/gyro_bias.c \
             sensors/gyroanalyse.c \
             $(CMSIS_SRC) \
             $(DEVICE_STDPERIPH_SRC) \
@@ -299,6 +327,7 @@ ifneq ($(filter SDCARD,$(FEATURES)),)
 SRC += \
             drivers/sdcard.c \
             drivers/sdcard_standard.c \
+            drivers/sdcard_stats.c \
             io/asyncfatfs/asyncfatfs.c \
             io/asyncfatfs/fat_standard.c
 endif
@@ -27,6 +27,7 @@
 #include "blackbox.h"
 #include "blackbox_encoding.h"
 #include "blackbox_io.h"
+#include "blackbox_preroll.h"
 
 #include "build/build_config.h"
 #include "build/debug.h"
@@ -63,6 +64,8 @@
 
 #include "rx/rx.h"
 
+#include "scheduler/scheduler.h"
+
 #include "sensors/acceleration.h"
 #include "sensors/barometer.h"
 #include "sensors/battery.h"
@@ -79,16 +82,21 @@
 #define DEFAULT_BLACKBOX_DEVICE     BLACKBOX_DEVICE_SERIAL
 #endif
 
-PG_REGISTER_WITH_RESET_TEMPLATE(blackboxConfig_t, blackboxConfig, PG_BLACKBOX_CONFIG, 0);
+PG_REGISTER_WITH_RESET_TEMPLATE(blackboxConfig_t, blackboxConfig, PG_BLACKBOX_CONFIG, 3);
 
 PG_RESET_TEMPLATE(blackboxConfig_t, blackboxConfig,
     .p_denom = 32,
     .device = DEFAULT_BLACKBOX_DEVICE,
     .on_motor_test = 0, // default off
-    .record_acc = 1
+    .record_acc = 1,
+    .mode = BLACKBOX_MODE_NORMAL,
+    .compression = 0,
+    .preroll_sec = 0
 );
 
 #define BLACKBOX_SHUTDOWN_TIMEOUT_MILLIS 200
+// Header sending calls made per update on the devices that take bursts
+#define BLACKBOX_HEADER_BURST_MAX_CALLS 4
 
 // Some macros to make writing FLIGHT_LOG_FIELD_* constants shorter:
 
@@ -159,8 +167,8 @@ typedef struct blackboxDeltaFieldDefinition_s {
 /**
  * Description of the blackbox fields we are writing in our main intra (I) and inter (P) frames. This description is
  * written into the flight log header so the log can be properly interpreted (but these definitions don't actually cause
- * the encoding to happen, we have to encode the flight log ourselves in write{Inter|Intra}frame() in a way that matches
- * the encoding we've promised here).
+ * the encoding to happen, blackboxBuildWritePlans() has to compile the plans write{Inter|Intra}frame() run through in a
+ * way that matches the encoding we've promised here).
  */
 static const blackboxDeltaFieldDefinition_t blackboxMainFields[] = {
     /* loopIteration doesn't appear in P frames since it always increments */
@@ -177,6 +185,10 @@ static const blackboxDeltaFieldDefinition_t blackboxMainFields[] = {
     {"axisD",       0, SIGNED,   .Ipredict = PREDICT(0),       .Iencode = ENCODING(SIGNED_VB),   .Ppredict = PREDICT(PREVIOUS),      .Pencode = ENCODING(SIGNED_VB), CONDITION(NONZERO_PID_D_0)},
     {"axisD",       1, SIGNED,   .Ipredict = PREDICT(0),       .Iencode = ENCODING(SIGNED_VB),   .Ppredict = PREDICT(PREVIOUS),      .Pencode = ENCODING(SIGNED_VB), CONDITION(NONZERO_PID_D_1)},
     {"axisD",       2, SIGNED,   .Ipredict = PREDICT(0),       .Iencode = ENCODING(SIGNED_VB),   .Ppredict = PREDICT(PREVIOUS),      .Pencode = ENCODING(SIGNED_VB), CONDITION(NONZERO_PID_D_2)},
+    /* feed forward terms, only logged when the corresponding gain is set */
+    {"axisF",       0, SIGNED,   .Ipredict = PREDICT(0),       .Iencode = ENCODING(SIGNED_VB),   .Ppredict = PREDICT(PREVIOUS),      .Pencode = ENCODING(SIGNED_VB), CONDITION(NONZERO_FF_0)},
+    {"axisF",       1, SIGNED,   .Ipredict = PREDICT(0),       .Iencode = ENCODING(SIGNED_VB),   .Ppredict = PREDICT(PREVIOUS),      .Pencode = ENCODING(SIGNED_VB), CONDITION(NONZERO_FF_1)},
+    {"axisF",       2, SIGNED,   .Ipredict = PREDICT(0),       .Iencode = ENCODING(SIGNED_VB),   .Ppredict = PREDICT(PREVIOUS),      .Pencode = ENCODING(SIGNED_VB), CONDITION(NONZERO_FF_2)},
     /* rcCommands are encoded together as a group in P-frames: */
     {"rcCommand",   0, SIGNED,   .Ipredict = PREDICT(0),       .Iencode = ENCODING(SIGNED_VB),   .Ppredict = PREDICT(PREVIOUS),      .Pencode = ENCODING(TAG8_4S16), CONDITION(ALWAYS)},
     {"rcCommand",   1, SIGNED,   .Ipredict = PREDICT(0),       .Iencode = ENCODING(SIGNED_VB),   .Ppredict = PREDICT(PREVIOUS),      .Pencode = ENCODING(TAG8_4S16), CONDITION(ALWAYS)},
@@ -207,10 +219,27 @@ static const blackboxDeltaFieldDefinition_t blackboxMainFields[] = {
     {"accSmooth",   0, SIGNED,   .Ipredict = PREDICT(0),       .Iencode = ENCODING(SIGNED_VB),   .Ppredict = PREDICT(AVERAGE_2),     .Pencode = ENCODING(SIGNED_VB), FLIGHT_LOG_FIELD_CONDITION_ACC},
     {"accSmooth",   1, SIGNED,   .Ipredict = PREDICT(0),       .Iencode = ENCODING(SIGNED_VB),   .Ppredict = PREDICT(AVERAGE_2),     .Pencode = ENCODING(SIGNED_VB), FLIGHT_LOG_FIELD_CONDITION_ACC},
     {"accSmooth",   2, SIGNED,   .Ipredict = PREDICT(0),       .Iencode = ENCODING(SIGNED_VB),   .Ppredict = PREDICT(AVERAGE_2),     .Pencode = ENCODING(SIGNED_VB), FLIGHT_LOG_FIELD_CONDITION_ACC},
-    {"debug",       0, SIGNED,   .Ipredict = PREDICT(0),       .Iencode = ENCODING(SIGNED_VB),   .Ppredict = PREDICT(AVERAGE_2),     .Pencode = ENCODING(SIGNED_VB), FLIGHT_LOG_FIELD_CONDITION_DEBUG},
-    {"debug",       1, SIGNED,   .Ipredict = PREDICT(0),       .Iencode = ENCODING(SIGNED_VB),   .Ppredict = PREDICT(AVERAGE_2),     .Pencode = ENCODING(SIGNED_VB), FLIGHT_LOG_FIELD_CONDITION_DEBUG},
-    {"debug",       2, SIGNED,   .Ipredict = PREDICT(0),       .Iencode = ENCODING(SIGNED_VB),   .Ppredict = PREDICT(AVERAGE_2),     .Pencode = ENCODING(SIGNED_VB), FLIGHT_LOG_FIELD_CONDITION_DEBUG},
-    {"debug",       3, SIGNED,   .Ipredict = PREDICT(0),       .Iencode = ENCODING(SIGNED_VB),   .Ppredict = PREDICT(AVERAGE_2),     .Pencode = ENCODING(SIGNED_VB), FLIGHT_LOG_FIELD_CONDITION_DEBUG},
+    /* each bank of four debug values is only logged when a debug mode is in it */
+    {"debug",       0, SIGNED,   .Ipredict = PREDICT(0),       .Iencode = ENCODING(SIGNED_VB),   .Ppredict = PREDICT(AVERAGE_2),     .Pencode = ENCODING(SIGNED_VB), FLIGHT_LOG_FIELD_CONDITION_DEBUG_0},
+    {"debug",       1, SIGNED,   .Ipredict = PREDICT(0),       .Iencode = ENCODING(SIGNED_VB),   .Ppredict = PREDICT(AVERAGE_2),     .Pencode = ENCODING(SIGNED_VB), FLIGHT_LOG_FIELD_CONDITION_DEBUG_0},
+    {"debug",       2, SIGNED,   .Ipredict = PREDICT(0),       .Iencode = ENCODING(SIGNED_VB),   .Ppredict = PREDICT(AVERAGE_2),     .Pencode = ENCODING(SIGNED_VB), FLIGHT_LOG_FIELD_CONDITION_DEBUG_0},
+    {"debug",       3, SIGNED,   .Ipredict = PREDICT(0),       .Iencode = ENCODING(SIGNED_VB),   .Ppredict = PREDICT(AVERAGE_2),     .Pencode = ENCODING(SIGNED_VB), FLIGHT_LOG_FIELD_CONDITION_DEBUG_0},
+    {"debug",       4, SIGNED,   .Ipredict = PREDICT(0),       .Iencode = ENCODING(SIGNED_VB),   .Ppredict = PREDICT(AVERAGE_2),     .Pencode = ENCODING(SIGNED_VB), FLIGHT_LOG_FIELD_CONDITION_DEBUG_1},
+    {"debug",       5, SIGNED,   .Ipredict = PREDICT(0),       .Iencode = ENCODING(SIGNED_VB),   .Ppredict = PREDICT(AVERAGE_2),     .Pencode = ENCODING(SIGNED_VB), FLIGHT_LOG_FIELD_CONDITION_DEBUG_1},
+    {"debug",       6, SIGNED,   .Ipredict = PREDICT(0),       .Iencode = ENCODING(SIGNED_VB),   .Ppredict = PREDICT(AVERAGE_2),     .Pencode = ENCODING(SIGNED_VB), FLIGHT_LOG_FIELD_CONDITION_DEBUG_1},
+    {"debug",       7, SIGNED,   .Ipredict = PREDICT(0),       .Iencode = ENCODING(SIGNED_VB),   .Ppredict = PREDICT(AVERAGE_2),     .Pencode = ENCODING(SIGNED_VB), FLIGHT_LOG_FIELD_CONDITION_DEBUG_1},
+#if DEBUG_VALUE_COUNT > 8
+    {"debug",       8, SIGNED,   .Ipredict = PREDICT(0),       .Iencode = ENCODING(SIGNED_VB),   .Ppredict = PREDICT(AVERAGE_2),     .Pencode = ENCODING(SIGNED_VB), FLIGHT_LOG_FIELD_CONDITION_DEBUG_2},
+    {"debug",       9, SIGNED,   .Ipredict = PREDICT(0),       .Iencode = ENCODING(SIGNED_VB),   .Ppredict = PREDICT(AVERAGE_2),     .Pencode = ENCODING(SIGNED_VB), FLIGHT_LOG_FIELD_CONDITION_DEBUG_2},
+    {"debug",      10, SIGNED,   .Ipredict = PREDICT(0),       .Iencode = ENCODING(SIGNED_VB),   .Ppredict = PREDICT(AVERAGE_2),     .Pencode = ENCODING(SIGNED_VB), FLIGHT_LOG_FIELD_CONDITION_DEBUG_2},
+    {"debug",      11, SIGNED,   .Ipredict = PREDICT(0),       .Iencode = ENCODING(SIGNED_VB),   .Ppredict = PREDICT(AVERAGE_2),     .Pencode = ENCODING(SIGNED_VB), FLIGHT_LOG_FIELD_CONDITION_DEBUG_2},
+#endif
+#if DEBUG_VALUE_COUNT > 12
+    {"debug",      12, SIGNED,   .Ipredict = PREDICT(0),       .Iencode = ENCODING(SIGNED_VB),   .Ppredict = PREDICT(AVERAGE_2),     .Pencode = ENCODING(SIGNED_VB), FLIGHT_LOG_FIELD_CONDITION_DEBUG_3},
+    {"debug",      13, SIGNED,   .Ipredict = PREDICT(0),       .Iencode = ENCODING(SIGNED_VB),   .Ppredict = PREDICT(AVERAGE_2),     .Pencode = ENCODING(SIGNED_VB), FLIGHT_LOG_FIELD_CONDITION_DEBUG_3},
+    {"debug",      14, SIGNED,   .Ipredict = PREDICT(0),       .Iencode = ENCODING(SIGNED_VB),   .Ppredict = PREDICT(AVERAGE_2),     .Pencode = ENCODING(SIGNED_VB), FLIGHT_LOG_FIELD_CONDITION_DEBUG_3},
+    {"debug",      15, SIGNED,   .Ipredict = PREDICT(0),       .Iencode = ENCODING(SIGNED_VB),   .Ppredict = PREDICT(AVERAGE_2),     .Pencode = ENCODING(SIGNED_VB), FLIGHT_LOG_FIELD_CONDITION_DEBUG_3},
+#endif
     /* Motors only rarely drops under minthrottle (when stick falls below mincommand), so predict minthrottle for it and use *unsigned* encoding (which is large for negative numbers but more compact for positive ones): */
     {"motor",       0, UNSIGNED, .Ipredict = PREDICT(MINMOTOR), .Iencode = ENCODING(UNSIGNED_VB), .Ppredict = PREDICT(AVERAGE_2), .Pencode = ENCODING(SIGNED_VB), CONDITION(AT_LEAST_MOTORS_1)},
     /* Subsequent motors base their I-frame values on the first one, P-frame values on the average of last two frames: */
@@ -226,6 +255,21 @@ static const blackboxDeltaFieldDefinition_t blackboxMainFields[] = {
     {"servo",       5, UNSIGNED, .Ipredict = PREDICT(1500),    .Iencode = ENCODING(SIGNED_VB),   .Ppredict = PREDICT(PREVIOUS),      .Pencode = ENCODING(SIGNED_VB), CONDITION(TRICOPTER)}
 };
 
+/**
+ * The main frames of blackbox_mode GYRO, written every gyro sample by write{Inter|Intra}frameGyro(). At the gyro rate
+ * the filtered gyro is smooth enough to extrapolate, but doing that to the unfiltered gyro would amplify its noise.
+ */
+static const blackboxDeltaFieldDefinition_t blackboxGyroFields[] = {
+    {"loopIteration",-1, UNSIGNED, .Ipredict = PREDICT(0),     .Iencode = ENCODING(UNSIGNED_VB), .Ppredict = PREDICT(INC),           .Pencode = FLIGHT_LOG_FIELD_ENCODING_NULL, CONDITION(ALWAYS)},
+    {"time",       -1, UNSIGNED, .Ipredict = PREDICT(0),       .Iencode = ENCODING(UNSIGNED_VB), .Ppredict = PREDICT(STRAIGHT_LINE), .Pencode = ENCODING(SIGNED_VB), CONDITION(ALWAYS)},
+    {"gyroADC",     0, SIGNED,   .Ipredict = PREDICT(0),       .Iencode = ENCODING(SIGNED_VB),   .Ppredict = PREDICT(STRAIGHT_LINE), .Pencode = ENCODING(SIGNED_VB), CONDITION(ALWAYS)},
+    {"gyroADC",     1, SIGNED,   .Ipredict = PREDICT(0),       .Iencode = ENCODING(SIGNED_VB),   .Ppredict = PREDICT(STRAIGHT_LINE), .Pencode = ENCODING(SIGNED_VB), CONDITION(ALWAYS)},
+    {"gyroADC",     2, SIGNED,   .Ipredict = PREDICT(0),       .Iencode = ENCODING(SIGNED_VB),   .Ppredict = PREDICT(STRAIGHT_LINE), .Pencode = ENCODING(SIGNED_VB), CONDITION(ALWAYS)},
+    {"gyroUnfilt",  0, SIGNED,   .Ipredict = PREDICT(0),       .Iencode = ENCODING(SIGNED_VB),   .Ppredict = PREDICT(PREVIOUS),      .Pencode = ENCODING(SIGNED_VB), CONDITION(ALWAYS)},
+    {"gyroUnfilt",  1, SIGNED,   .Ipredict = PREDICT(0),       .Iencode = ENCODING(SIGNED_VB),   .Ppredict = PREDICT(PREVIOUS),      .Pencode = ENCODING(SIGNED_VB), CONDITION(ALWAYS)},
+    {"gyroUnfilt",  2, SIGNED,   .Ipredict = PREDICT(0),       .Iencode = ENCODING(SIGNED_VB),   .Ppredict = PREDICT(PREVIOUS),      .Pencode = ENCODING(SIGNED_VB), CONDITION(ALWAYS)}
+};
+
 #ifdef GPS
 // GPS position/vel frame
 static const blackboxConditionalFieldDefinition_t blackboxGpsGFields[] = {
@@ -280,11 +324,13 @@ typedef struct blackboxMainState_s {
     int32_t axisPID_P[XYZ_AXIS_COUNT];
     int32_t axisPID_I[XYZ_AXIS_COUNT];
     int32_t axisPID_D[XYZ_AXIS_COUNT];
+    int32_t axisPID_F[XYZ_AXIS_COUNT];
 
     int16_t rcCommand[4];
     int16_t gyroADC[XYZ_AXIS_COUNT];
+    int16_t gyroUnfilt[XYZ_AXIS_COUNT];
     int16_t accSmooth[XYZ_AXIS_COUNT];
-    int16_t debug[DEBUG16_VALUE_COUNT];
+    int32_t debug[DEBUG_VALUE_COUNT];
     int16_t motor[MAX_SUPPORTED_MOTORS];
     int16_t servo[MAX_SUPPORTED_SERVOS];
 
@@ -328,6 +374,10 @@ static BlackboxState blackboxState = BLACKBOX_STATE_DISABLED;
 
 static uint32_t blackboxLastArmingBeep = 0;
 static uint32_t blackboxLastFlightModeFlags = 0; // New event tracking of flight modes
+static uint8_t blackboxLastLoadSheddingLevel = 0;
+// Main frames the device had no room for, see blackboxDeviceReserveFrameSpace()
+static uint32_t blackboxDroppedFrames = 0;
+static uint32_t blackboxDroppedFramesLogged = 0;
 
 static struct {
     uint32_t headerIndex;
@@ -375,6 +425,71 @@ static blackboxMainState_t blackboxHistoryRing[3];
 // These point into blackboxHistoryRing, use them to know where to store history of a given age (0, 1 or 2 generations old)
 static blackboxMainState_t* blackboxHistory[3];
 
+/*
+ * The main frame fields that are logged, with their conditions resolved, are compiled into a plan of ops for each
+ * frame type when the log starts, so the frame writers don't test the conditions of every field on every frame.
+ * Each op predicts and encodes one or more values of the same type next to each other in blackboxMainState_t.
+ */
+typedef enum {
+    BLACKBOX_FIELD_U32 = 0,
+    BLACKBOX_FIELD_S32,
+    BLACKBOX_FIELD_U16,
+    BLACKBOX_FIELD_S16
+} blackboxFieldType_e;
+
+typedef struct blackboxFieldOp_s {
+    uint8_t offset;         // of the first value in blackboxMainState_t
+    uint8_t type;           // blackboxFieldType_e
+    uint8_t count;
+    uint8_t predictor;      // FLIGHT_LOG_FIELD_PREDICTOR_*
+    uint8_t encoding;       // FLIGHT_LOG_FIELD_ENCODING_*
+    bool flush;             // encode the values gathered since the last flush, clear for all but the last op of a group encoding
+} blackboxFieldOp_t;
+
+STATIC_ASSERT(sizeof(blackboxMainState_t) <= UINT8_MAX, blackbox_main_state_too_large_for_field_offsets);
+
+// The values written by one encoder call, which is at most 8 for TAG8_8SVB
+#define BLACKBOX_WRITE_PLAN_MAX_VALUES 8
+#define BLACKBOX_WRITE_PLAN_MAX_OPS 24
+
+typedef struct blackboxWritePlan_s {
+    blackboxFieldOp_t ops[BLACKBOX_WRITE_PLAN_MAX_OPS];
+    uint8_t count;
+} blackboxWritePlan_t;
+
+static blackboxWritePlan_t blackboxIntraframePlan;
+static blackboxWritePlan_t blackboxInterframePlan;
+
+/*
+ * The PID loop only copies the state of the iterations to be logged into this queue, the blackbox task encodes and
+ * writes them out. The PID loop may run in the gyro interrupt, so only it writes the head and only the task writes
+ * the tail, with signal fences ordering the snapshot accesses against them, as for ringBuffer_t.
+ */
+#ifdef STM32F10X
+#define BLACKBOX_SNAPSHOT_COUNT 4
+#else
+#define BLACKBOX_SNAPSHOT_COUNT 8
+#endif
+
+typedef struct blackboxSnapshot_s {
+    blackboxMainState_t state;
+    uint32_t iteration;
+    bool intraframe;
+} blackboxSnapshot_t;
+
+static blackboxSnapshot_t blackboxSnapshots[BLACKBOX_SNAPSHOT_COUNT];
+static volatile uint8_t blackboxSnapshotHead;
+static volatile uint8_t blackboxSnapshotTail;
+
+// Owned by the PID loop side
+static volatile bool blackboxTimersRunning = false;    // PAUSED or RUNNING, so the iteration timers advance
+static volatile bool blackboxCapturing = false;        // RUNNING, so snapshots are taken
+static bool blackboxCaptureForceIntraframe;            // the frames before this one were dropped or not logged
+static volatile bool blackboxGyroOnly = false;         // blackbox_mode GYRO, cached when the log starts
+#ifdef GPS
+static volatile bool blackboxGpsHomeDue;
+#endif
+
 static bool blackboxModeActivationConditionPresent = false;
 
 /**
@@ -385,6 +500,12 @@ bool blackboxMayEditConfig(void)
     return blackboxState <= BLACKBOX_STATE_STOPPED;
 }
 
+// Main frames dropped for want of device space in the current or the last log
+uint32_t blackboxGetDroppedFrames(void)
+{
+    return blackboxDroppedFrames;
+}
+
 static bool blackboxIsOnlyLoggingIntraframes(void)
 {
     return blackboxConfig()->p_denom == 0;
@@ -414,6 +535,11 @@ static bool testBlackboxConditionUncached(FlightLogFieldCondition condition)
     case FLIGHT_LOG_FIELD_CONDITION_NONZERO_PID_D_2:
         return currentPidProfile->pid[condition - FLIGHT_LOG_FIELD_CONDITION_NONZERO_PID_D_0].D != 0;
 
+    case FLIGHT_LOG_FIELD_CONDITION_NONZERO_FF_0:
+    case FLIGHT_LOG_FIELD_CONDITION_NONZERO_FF_1:
+    case FLIGHT_LOG_FIELD_CONDITION_NONZERO_FF_2:
+        return currentPidProfile->feedForward[condition - FLIGHT_LOG_FIELD_CONDITION_NONZERO_FF_0] != 0;
+
     case FLIGHT_LOG_FIELD_CONDITION_MAG:
 #ifdef MAG
         return sensors(SENSOR_MAG);
@@ -450,8 +576,11 @@ static bool testBlackboxConditionUncached(FlightLogFieldCondition condition)
     case FLIGHT_LOG_FIELD_CONDITION_ACC:
         return sensors(SENSOR_ACC) && blackboxConfig()->record_acc;
 
-    case FLIGHT_LOG_FIELD_CONDITION_DEBUG:
-        return debugMode != DEBUG_NONE;
+    case FLIGHT_LOG_FIELD_CONDITION_DEBUG_0:
+    case FLIGHT_LOG_FIELD_CONDITION_DEBUG_1:
+    case FLIGHT_LOG_FIELD_CONDITION_DEBUG_2:
+    case FLIGHT_LOG_FIELD_CONDITION_DEBUG_3:
+        return debugModeForSlot(condition - FLIGHT_LOG_FIELD_CONDITION_DEBUG_0) != DEBUG_NONE;
 
     case FLIGHT_LOG_FIELD_CONDITION_NEVER:
         return false;
@@ -476,6 +605,146 @@ static bool testBlackboxCondition(FlightLogFieldCondition condition)
     return (blackboxConditionCache & (1 << condition)) != 0;
 }
 
+static size_t blackboxFieldTypeSize(blackboxFieldType_e type)
+{
+    return (type == BLACKBOX_FIELD_S16 || type == BLACKBOX_FIELD_U16) ? sizeof(int16_t) : sizeof(int32_t);
+}
+
+static void blackboxWritePlanAdd(blackboxWritePlan_t *plan, size_t offset, blackboxFieldType_e type, int count, uint8_t predictor, uint8_t encoding)
+{
+    if (count <= 0) {
+        return;
+    }
+
+    if (plan->count > 0) {
+        // Fields next to each other in the state that are predicted and encoded the same way become one op
+        blackboxFieldOp_t *last = &plan->ops[plan->count - 1];
+        const bool mergeable = encoding == FLIGHT_LOG_FIELD_ENCODING_SIGNED_VB
+            || encoding == FLIGHT_LOG_FIELD_ENCODING_UNSIGNED_VB
+            || encoding == FLIGHT_LOG_FIELD_ENCODING_TAG8_8SVB;
+        if (mergeable && last->type == type && last->predictor == predictor && last->encoding == encoding
+            && last->offset + last->count * blackboxFieldTypeSize(type) == offset
+            && last->count + count <= BLACKBOX_WRITE_PLAN_MAX_VALUES) {
+            last->count += count;
+            return;
+        }
+    }
+
+    if (plan->count < BLACKBOX_WRITE_PLAN_MAX_OPS) {
+        blackboxFieldOp_t *op = &plan->ops[plan->count++];
+        op->offset = offset;
+        op->type = type;
+        op->count = count;
+        op->predictor = predictor;
+        op->encoding = encoding;
+        op->flush = true;
+        if (encoding == FLIGHT_LOG_FIELD_ENCODING_TAG8_8SVB && plan->count > 1 && op[-1].encoding == encoding) {
+            // The values of a group encoding are gathered and written together by its last op
+            op[-1].flush = false;
+        }
+    }
+}
+
+// Adds a field to both main frame plans, with the columns of blackboxMainFields[]
+static void blackboxAddMainField(size_t offset, blackboxFieldType_e type, int count, uint8_t Ipredict, uint8_t Iencode, uint8_t Ppredict, uint8_t Pencode)
+{
+    blackboxWritePlanAdd(&blackboxIntraframePlan, offset, type, count, Ipredict, Iencode);
+    blackboxWritePlanAdd(&blackboxInterframePlan, offset, type, count, Ppredict, Pencode);
+}
+
+#define MAIN_FIELD(field, index) (offsetof(blackboxMainState_t, field) + (index) * sizeof(blackboxHistoryRing[0].field[0]))
+
+/*
+ * Compiles blackboxMainFields[] with the cached conditions into the ops write{Intra|Inter}frame() run through, in the
+ * same order. Must be called after blackboxBuildConditionCache().
+ */
+static void blackboxBuildWritePlans(void)
+{
+    blackboxIntraframePlan.count = 0;
+    blackboxInterframePlan.count = 0;
+
+    blackboxAddMainField(offsetof(blackboxMainState_t, time), BLACKBOX_FIELD_U32, 1,
+        PREDICT(0), ENCODING(UNSIGNED_VB), PREDICT(STRAIGHT_LINE), ENCODING(SIGNED_VB));
+    blackboxAddMainField(MAIN_FIELD(axisPID_P, 0), BLACKBOX_FIELD_S32, XYZ_AXIS_COUNT,
+        PREDICT(0), ENCODING(SIGNED_VB), PREDICT(PREVIOUS), ENCODING(SIGNED_VB));
+    blackboxAddMainField(MAIN_FIELD(axisPID_I, 0), BLACKBOX_FIELD_S32, XYZ_AXIS_COUNT,
+        PREDICT(0), ENCODING(SIGNED_VB), PREDICT(PREVIOUS), ENCODING(TAG2_3S32));
+    for (int x = 0; x < XYZ_AXIS_COUNT; x++) {
+        if (testBlackboxCondition(FLIGHT_LOG_FIELD_CONDITION_NONZERO_PID_D_0 + x)) {
+            blackboxAddMainField(MAIN_FIELD(axisPID_D, x), BLACKBOX_FIELD_S32, 1,
+                PREDICT(0), ENCODING(SIGNED_VB), PREDICT(PREVIOUS), ENCODING(SIGNED_VB));
+        }
+    }
+    for (int x = 0; x < XYZ_AXIS_COUNT; x++) {
+        if (testBlackboxCondition(FLIGHT_LOG_FIELD_CONDITION_NONZERO_FF_0 + x)) {
+            blackboxAddMainField(MAIN_FIELD(axisPID_F, x), BLACKBOX_FIELD_S32, 1,
+                PREDICT(0), ENCODING(SIGNED_VB), PREDICT(PREVIOUS), ENCODING(SIGNED_VB));
+        }
+    }
+
+    // The throttle has its own predictor in I-frames, all four are packed together in P-frames
+    blackboxWritePlanAdd(&blackboxIntraframePlan, MAIN_FIELD(rcCommand, 0), BLACKBOX_FIELD_S16, 3, PREDICT(0), ENCODING(SIGNED_VB));
+    blackboxWritePlanAdd(&blackboxIntraframePlan, MAIN_FIELD(rcCommand, THROTTLE), BLACKBOX_FIELD_S16, 1, PREDICT(MINTHROTTLE), ENCODING(UNSIGNED_VB));
+    blackboxWritePlanAdd(&blackboxInterframePlan, MAIN_FIELD(rcCommand, 0), BLACKBOX_FIELD_S16, 4, PREDICT(PREVIOUS), ENCODING(TAG8_4S16));
+
+    // The sensors that are updated periodically are packed together in P-frames, as their deltas are normally zero
+    if (testBlackboxCondition(FLIGHT_LOG_FIELD_CONDITION_VBAT)) {
+        blackboxAddMainField(offsetof(blackboxMainState_t, vbatLatest), BLACKBOX_FIELD_U16, 1,
+            PREDICT(VBATREF), ENCODING(NEG_14BIT), PREDICT(PREVIOUS), ENCODING(TAG8_8SVB));
+    }
+    if (testBlackboxCondition(FLIGHT_LOG_FIELD_CONDITION_AMPERAGE_ADC)) {
+        blackboxAddMainField(offsetof(blackboxMainState_t, amperageLatest), BLACKBOX_FIELD_U16, 1,
+            PREDICT(0), ENCODING(UNSIGNED_VB), PREDICT(PREVIOUS), ENCODING(TAG8_8SVB));
+    }
+#ifdef MAG
+    if (testBlackboxCondition(FLIGHT_LOG_FIELD_CONDITION_MAG)) {
+        blackboxAddMainField(MAIN_FIELD(magADC, 0), BLACKBOX_FIELD_S16, XYZ_AXIS_COUNT,
+            PREDICT(0), ENCODING(SIGNED_VB), PREDICT(PREVIOUS), ENCODING(TAG8_8SVB));
+    }
+#endif
+#ifdef BARO
+    if (testBlackboxCondition(FLIGHT_LOG_FIELD_CONDITION_BARO)) {
+        blackboxAddMainField(offsetof(blackboxMainState_t, BaroAlt), BLACKBOX_FIELD_S32, 1,
+            PREDICT(0), ENCODING(SIGNED_VB), PREDICT(PREVIOUS), ENCODING(TAG8_8SVB));
+    }
+#endif
+#ifdef SONAR
+    if (testBlackboxCondition(FLIGHT_LOG_FIELD_CONDITION_SONAR)) {
+        blackboxAddMainField(offsetof(blackboxMainState_t, sonarRaw), BLACKBOX_FIELD_S32, 1,
+            PREDICT(0), ENCODING(SIGNED_VB), PREDICT(PREVIOUS), ENCODING(TAG8_8SVB));
+    }
+#endif
+    if (testBlackboxCondition(FLIGHT_LOG_FIELD_CONDITION_RSSI)) {
+        blackboxAddMainField(offsetof(blackboxMainState_t, rssi), BLACKBOX_FIELD_U16, 1,
+            PREDICT(0), ENCODING(UNSIGNED_VB), PREDICT(PREVIOUS), ENCODING(TAG8_8SVB));
+    }
+
+    blackboxAddMainField(MAIN_FIELD(gyroADC, 0), BLACKBOX_FIELD_S16, XYZ_AXIS_COUNT,
+        PREDICT(0), ENCODING(SIGNED_VB), PREDICT(AVERAGE_2), ENCODING(SIGNED_VB));
+    if (testBlackboxCondition(FLIGHT_LOG_FIELD_CONDITION_ACC)) {
+        blackboxAddMainField(MAIN_FIELD(accSmooth, 0), BLACKBOX_FIELD_S16, XYZ_AXIS_COUNT,
+            PREDICT(0), ENCODING(SIGNED_VB), PREDICT(AVERAGE_2), ENCODING(SIGNED_VB));
+    }
+    // the banks in use are filled from the first, so the debug values logged are always the first ones
+    for (int slot = 0; slot < DEBUG_MODE_SLOT_COUNT; slot++) {
+        if (testBlackboxCondition(FLIGHT_LOG_FIELD_CONDITION_DEBUG_0 + slot)) {
+            blackboxAddMainField(MAIN_FIELD(debug, slot * DEBUG_MODE_VALUE_COUNT), BLACKBOX_FIELD_S32, DEBUG_MODE_VALUE_COUNT,
+                PREDICT(0), ENCODING(SIGNED_VB), PREDICT(AVERAGE_2), ENCODING(SIGNED_VB));
+        }
+    }
+
+    const int motorCount = getMotorCount();
+    blackboxAddMainField(MAIN_FIELD(motor, 0), BLACKBOX_FIELD_S16, MIN(motorCount, 1),
+        PREDICT(MINMOTOR), ENCODING(UNSIGNED_VB), PREDICT(AVERAGE_2), ENCODING(SIGNED_VB));
+    blackboxAddMainField(MAIN_FIELD(motor, 1), BLACKBOX_FIELD_S16, motorCount - 1,
+        PREDICT(MOTOR_0), ENCODING(SIGNED_VB), PREDICT(AVERAGE_2), ENCODING(SIGNED_VB));
+
+    if (testBlackboxCondition(FLIGHT_LOG_FIELD_CONDITION_TRICOPTER)) {
+        blackboxAddMainField(MAIN_FIELD(servo, 5), BLACKBOX_FIELD_S16, 1,
+            PREDICT(1500), ENCODING(SIGNED_VB), PREDICT(PREVIOUS), ENCODING(SIGNED_VB));
+    }
+}
+
 static void blackboxSetState(BlackboxState newState)
 {
     //Perform initial setup required for the new state
@@ -500,6 +769,19 @@ static void blackboxSetState(BlackboxState newState)
         break;
     case BLACKBOX_STATE_RUNNING:
         blackboxSlowFrameIterationTimer = blackboxSInterval; //Force a slow frame to be written on the first iteration
+#ifdef USE_BLACKBOX_COMPRESSION
+        // The headers are always plain, everything logged after them is in compressed blocks
+        blackboxDeviceSetCompression(blackboxDeviceCompressionEnabled());
+#endif
+        if (!blackboxTimersRunning) {
+            // The PID loop isn't capturing yet, so the queue can be reset from here
+            blackboxSnapshotHead = 0;
+            blackboxSnapshotTail = 0;
+#ifdef USE_BLACKBOX_PREROLL
+            // The log has just started, so follow the header with what happened before arming
+            blackboxPrerollStartDump();
+#endif
+        }
         break;
     case BLACKBOX_STATE_SHUTTING_DOWN:
         xmitState.u.startTime = millis();
@@ -508,95 +790,139 @@ static void blackboxSetState(BlackboxState newState)
         ;
     }
     blackboxState = newState;
+
+    blackboxCapturing = (newState == BLACKBOX_STATE_RUNNING);
+    blackboxTimersRunning = (newState == BLACKBOX_STATE_RUNNING || newState == BLACKBOX_STATE_PAUSED);
 }
 
-static void writeIntraframe(void)
+static void blackboxLoadFieldValues(int32_t *values, const blackboxMainState_t *state, const blackboxFieldOp_t *op)
 {
-    blackboxMainState_t *blackboxCurrent = blackboxHistory[0];
+    const void *field = (const uint8_t *)state + op->offset;
 
-    blackboxWrite('I');
-
-    blackboxWriteUnsignedVB(blackboxIteration);
-    blackboxWriteUnsignedVB(blackboxCurrent->time);
-
-    blackboxWriteSignedVBArray(blackboxCurrent->axisPID_P, XYZ_AXIS_COUNT);
-    blackboxWriteSignedVBArray(blackboxCurrent->axisPID_I, XYZ_AXIS_COUNT);
-
-    // Don't bother writing the current D term if the corresponding PID setting is zero
-    for (int x = 0; x < XYZ_AXIS_COUNT; x++) {
-        if (testBlackboxCondition(FLIGHT_LOG_FIELD_CONDITION_NONZERO_PID_D_0 + x)) {
-            blackboxWriteSignedVB(blackboxCurrent->axisPID_D[x]);
+    switch (op->type) {
+    case BLACKBOX_FIELD_S16:
+        for (int i = 0; i < op->count; i++) {
+            values[i] = ((const int16_t *)field)[i];
         }
+        break;
+    case BLACKBOX_FIELD_U16:
+        for (int i = 0; i < op->count; i++) {
+            values[i] = ((const uint16_t *)field)[i];
+        }
+        break;
+    default:
+        memcpy(values, field, op->count * sizeof(int32_t));
+        break;
     }
+}
 
-    // Write roll, pitch and yaw first:
-    blackboxWriteSigned16VBArray(blackboxCurrent->rcCommand, 3);
-
-    /*
-     * Write the throttle separately from the rest of the RC data so we can apply a predictor to it.
-     * Throttle lies in range [minthrottle..maxthrottle]:
-     */
-    blackboxWriteUnsignedVB(blackboxCurrent->rcCommand[THROTTLE] - motorConfig()->minthrottle);
-
-    if (testBlackboxCondition(FLIGHT_LOG_FIELD_CONDITION_VBAT)) {
-        /*
-         * Our voltage is expected to decrease over the course of the flight, so store our difference from
-         * the reference:
-         *
-         * Write 14 bits even if the number is negative (which would otherwise result in 32 bits)
-         */
-        blackboxWriteUnsignedVB((vbatReference - blackboxCurrent->vbatLatest) & 0x3FFF);
-    }
-
-    if (testBlackboxCondition(FLIGHT_LOG_FIELD_CONDITION_AMPERAGE_ADC)) {
-        // 12bit value directly from ADC
-        blackboxWriteUnsignedVB(blackboxCurrent->amperageLatest);
-    }
-
-#ifdef MAG
-    if (testBlackboxCondition(FLIGHT_LOG_FIELD_CONDITION_MAG)) {
-        blackboxWriteSigned16VBArray(blackboxCurrent->magADC, XYZ_AXIS_COUNT);
-    }
-#endif
+// Puts what is left of the op's current values after the prediction into values
+static void blackboxPredictFieldValues(int32_t *values, const blackboxFieldOp_t *op)
+{
+    int32_t prev1[BLACKBOX_WRITE_PLAN_MAX_VALUES];
+    int32_t prev2[BLACKBOX_WRITE_PLAN_MAX_VALUES];
+    int32_t predictor = 0;
 
-#ifdef BARO
-    if (testBlackboxCondition(FLIGHT_LOG_FIELD_CONDITION_BARO)) {
-        blackboxWriteSignedVB(blackboxCurrent->BaroAlt);
-    }
-#endif
+    blackboxLoadFieldValues(values, blackboxHistory[0], op);
 
-#ifdef SONAR
-    if (testBlackboxCondition(FLIGHT_LOG_FIELD_CONDITION_SONAR)) {
-        blackboxWriteSignedVB(blackboxCurrent->sonarRaw);
+    switch (op->predictor) {
+    case FLIGHT_LOG_FIELD_PREDICTOR_PREVIOUS:
+        blackboxLoadFieldValues(prev1, blackboxHistory[1], op);
+        for (int i = 0; i < op->count; i++) {
+            values[i] -= prev1[i];
+        }
+        return;
+    case FLIGHT_LOG_FIELD_PREDICTOR_STRAIGHT_LINE:
+        // Only used for the time, which may wrap
+        blackboxLoadFieldValues(prev1, blackboxHistory[1], op);
+        blackboxLoadFieldValues(prev2, blackboxHistory[2], op);
+        for (int i = 0; i < op->count; i++) {
+            values[i] = (int32_t)((uint32_t)values[i] - 2 * (uint32_t)prev1[i] + (uint32_t)prev2[i]);
+        }
+        return;
+    case FLIGHT_LOG_FIELD_PREDICTOR_AVERAGE_2:
+        blackboxLoadFieldValues(prev1, blackboxHistory[1], op);
+        blackboxLoadFieldValues(prev2, blackboxHistory[2], op);
+        for (int i = 0; i < op->count; i++) {
+            values[i] -= (prev1[i] + prev2[i]) / 2;
+        }
+        return;
+    case FLIGHT_LOG_FIELD_PREDICTOR_MINTHROTTLE:
+        predictor = motorConfig()->minthrottle;
+        break;
+    case FLIGHT_LOG_FIELD_PREDICTOR_MINMOTOR:
+        predictor = motorOutputLow;
+        break;
+    case FLIGHT_LOG_FIELD_PREDICTOR_MOTOR_0:
+        predictor = blackboxHistory[0]->motor[0];
+        break;
+    case FLIGHT_LOG_FIELD_PREDICTOR_1500:
+        predictor = 1500;
+        break;
+    case FLIGHT_LOG_FIELD_PREDICTOR_VBATREF:
+        predictor = vbatReference;
+        break;
+    default:
+        return;
     }
-#endif
 
-    if (testBlackboxCondition(FLIGHT_LOG_FIELD_CONDITION_RSSI)) {
-        blackboxWriteUnsignedVB(blackboxCurrent->rssi);
+    for (int i = 0; i < op->count; i++) {
+        values[i] -= predictor;
     }
+}
 
-    blackboxWriteSigned16VBArray(blackboxCurrent->gyroADC, XYZ_AXIS_COUNT);
-    if (testBlackboxCondition(FLIGHT_LOG_FIELD_CONDITION_ACC)) {
-        blackboxWriteSigned16VBArray(blackboxCurrent->accSmooth, XYZ_AXIS_COUNT);
+static void blackboxEncodeFieldValues(int32_t *values, int count, uint8_t encoding)
+{
+    switch (encoding) {
+    case FLIGHT_LOG_FIELD_ENCODING_SIGNED_VB:
+        blackboxWriteSignedVBArray(values, count);
+        break;
+    case FLIGHT_LOG_FIELD_ENCODING_UNSIGNED_VB:
+        for (int i = 0; i < count; i++) {
+            blackboxWriteUnsignedVB(values[i]);
+        }
+        break;
+    case FLIGHT_LOG_FIELD_ENCODING_NEG_14BIT:
+        // Write 14 bits even if the number is negative (which would otherwise result in 32 bits)
+        for (int i = 0; i < count; i++) {
+            blackboxWriteUnsignedVB(-values[i] & 0x3FFF);
+        }
+        break;
+    case FLIGHT_LOG_FIELD_ENCODING_TAG2_3S32:
+        blackboxWriteTag2_3S32(values);
+        break;
+    case FLIGHT_LOG_FIELD_ENCODING_TAG8_4S16:
+        blackboxWriteTag8_4S16(values);
+        break;
+    case FLIGHT_LOG_FIELD_ENCODING_TAG8_8SVB:
+        blackboxWriteTag8_8SVB(values, count);
+        break;
+    default:
+        break;
     }
+}
 
-    if (testBlackboxCondition(FLIGHT_LOG_FIELD_CONDITION_DEBUG)) {
-        blackboxWriteSigned16VBArray(blackboxCurrent->debug, DEBUG16_VALUE_COUNT);
+static void blackboxWriteMainFields(const blackboxWritePlan_t *plan)
+{
+    int32_t values[BLACKBOX_WRITE_PLAN_MAX_VALUES];
+    int valueCount = 0;
+
+    for (const blackboxFieldOp_t *op = plan->ops; op < plan->ops + plan->count; op++) {
+        blackboxPredictFieldValues(values + valueCount, op);
+        valueCount += op->count;
+        if (op->flush) {
+            blackboxEncodeFieldValues(values, valueCount, op->encoding);
+            valueCount = 0;
+        }
     }
+}
 
-    //Motors can be below minimum output when disarmed, but that doesn't happen much
-    blackboxWriteUnsignedVB(blackboxCurrent->motor[0] - motorOutputLow);
-
-    //Motors tend to be similar to each other so use the first motor's value as a predictor of the others
-    const int motorCount = getMotorCount();
-    for (int x = 1; x < motorCount; x++) {
-        blackboxWriteSignedVB(blackboxCurrent->motor[x] - blackboxCurrent->motor[0]);
-    }
+static void writeIntraframe(uint32_t iteration)
+{
+    blackboxWrite('I');
 
-    if (testBlackboxCondition(FLIGHT_LOG_FIELD_CONDITION_TRICOPTER)) {
-        //Assume the tail spends most of its time around the center
-        blackboxWriteSignedVB(blackboxCurrent->servo[5] - 1500);
-    }
+    blackboxWriteUnsignedVB(iteration);
+    blackboxWriteMainFields(&blackboxIntraframePlan);
 
     //Rotate our history buffers:
 
@@ -610,115 +936,56 @@ static void writeIntraframe(void)
     blackboxLoggedAnyFrames = true;
 }
 
-static void blackboxWriteMainStateArrayUsingAveragePredictor(int arrOffsetInHistory, int count)
-{
-    int16_t *curr  = (int16_t*) ((char*) (blackboxHistory[0]) + arrOffsetInHistory);
-    int16_t *prev1 = (int16_t*) ((char*) (blackboxHistory[1]) + arrOffsetInHistory);
-    int16_t *prev2 = (int16_t*) ((char*) (blackboxHistory[2]) + arrOffsetInHistory);
-
-    for (int i = 0; i < count; i++) {
-        // Predictor is the average of the previous two history states
-        int32_t predictor = (prev1[i] + prev2[i]) / 2;
-
-        blackboxWriteSignedVB(curr[i] - predictor);
-    }
-}
-
 static void writeInterframe(void)
 {
-    blackboxMainState_t *blackboxCurrent = blackboxHistory[0];
-    blackboxMainState_t *blackboxLast = blackboxHistory[1];
-
     blackboxWrite('P');
 
     //No need to store iteration count since its delta is always 1
+    blackboxWriteMainFields(&blackboxInterframePlan);
 
-    /*
-     * Since the difference between the difference between successive times will be nearly zero (due to consistent
-     * looptime spacing), use second-order differences.
-     */
-    blackboxWriteSignedVB((int32_t) (blackboxHistory[0]->time - 2 * blackboxHistory[1]->time + blackboxHistory[2]->time));
-
-    int32_t deltas[8];
-    arraySubInt32(deltas, blackboxCurrent->axisPID_P, blackboxLast->axisPID_P, XYZ_AXIS_COUNT);
-    blackboxWriteSignedVBArray(deltas, XYZ_AXIS_COUNT);
-
-    /*
-     * The PID I field changes very slowly, most of the time +-2, so use an encoding
-     * that can pack all three fields into one byte in that situation.
-     */
-    arraySubInt32(deltas, blackboxCurrent->axisPID_I, blackboxLast->axisPID_I, XYZ_AXIS_COUNT);
-    blackboxWriteTag2_3S32(deltas);
-
-    /*
-     * The PID D term is frequently set to zero for yaw, which makes the result from the calculation
-     * always zero. So don't bother recording D results when PID D terms are zero.
-     */
-    for (int x = 0; x < XYZ_AXIS_COUNT; x++) {
-        if (testBlackboxCondition(FLIGHT_LOG_FIELD_CONDITION_NONZERO_PID_D_0 + x)) {
-            blackboxWriteSignedVB(blackboxCurrent->axisPID_D[x] - blackboxLast->axisPID_D[x]);
-        }
-    }
+    //Rotate our history buffers
+    blackboxHistory[2] = blackboxHistory[1];
+    blackboxHistory[1] = blackboxHistory[0];
+    blackboxHistory[0] = ((blackboxHistory[0] - blackboxHistoryRing + 1) % 3) + blackboxHistoryRing;
 
-    /*
-     * RC tends to stay the same or fairly small for many frames at a time, so use an encoding that
-     * can pack multiple values per byte:
-     */
-    for (int x = 0; x < 4; x++) {
-        deltas[x] = blackboxCurrent->rcCommand[x] - blackboxLast->rcCommand[x];
-    }
+    blackboxLoggedAnyFrames = true;
+}
 
-    blackboxWriteTag8_4S16(deltas);
+static void writeIntraframeGyro(uint32_t iteration)
+{
+    blackboxMainState_t *blackboxCurrent = blackboxHistory[0];
 
-    //Check for sensors that are updated periodically (so deltas are normally zero)
-    int optionalFieldCount = 0;
+    blackboxWrite('I');
 
-    if (testBlackboxCondition(FLIGHT_LOG_FIELD_CONDITION_VBAT)) {
-        deltas[optionalFieldCount++] = (int32_t) blackboxCurrent->vbatLatest - blackboxLast->vbatLatest;
-    }
+    blackboxWriteUnsignedVB(iteration);
+    blackboxWriteUnsignedVB(blackboxCurrent->time);
 
-    if (testBlackboxCondition(FLIGHT_LOG_FIELD_CONDITION_AMPERAGE_ADC)) {
-        deltas[optionalFieldCount++] = (int32_t) blackboxCurrent->amperageLatest - blackboxLast->amperageLatest;
-    }
+    blackboxWriteSigned16VBArray(blackboxCurrent->gyroADC, XYZ_AXIS_COUNT);
+    blackboxWriteSigned16VBArray(blackboxCurrent->gyroUnfilt, XYZ_AXIS_COUNT);
 
-#ifdef MAG
-    if (testBlackboxCondition(FLIGHT_LOG_FIELD_CONDITION_MAG)) {
-        for (int x = 0; x < XYZ_AXIS_COUNT; x++) {
-            deltas[optionalFieldCount++] = blackboxCurrent->magADC[x] - blackboxLast->magADC[x];
-        }
-    }
-#endif
+    //Rotate our history buffers, with no other history the current state is also the "before, before" state
+    blackboxHistory[1] = blackboxHistory[0];
+    blackboxHistory[2] = blackboxHistory[0];
+    blackboxHistory[0] = ((blackboxHistory[0] - blackboxHistoryRing + 1) % 3) + blackboxHistoryRing;
 
-#ifdef BARO
-    if (testBlackboxCondition(FLIGHT_LOG_FIELD_CONDITION_BARO)) {
-        deltas[optionalFieldCount++] = blackboxCurrent->BaroAlt - blackboxLast->BaroAlt;
-    }
-#endif
+    blackboxLoggedAnyFrames = true;
+}
 
-#ifdef SONAR
-    if (testBlackboxCondition(FLIGHT_LOG_FIELD_CONDITION_SONAR)) {
-        deltas[optionalFieldCount++] = blackboxCurrent->sonarRaw - blackboxLast->sonarRaw;
-    }
-#endif
+static void writeInterframeGyro(void)
+{
+    const blackboxMainState_t *blackboxCurrent = blackboxHistory[0];
+    const blackboxMainState_t *blackboxLast = blackboxHistory[1];
+    const blackboxMainState_t *blackboxLastLast = blackboxHistory[2];
 
-    if (testBlackboxCondition(FLIGHT_LOG_FIELD_CONDITION_RSSI)) {
-        deltas[optionalFieldCount++] = (int32_t) blackboxCurrent->rssi - blackboxLast->rssi;
-    }
+    blackboxWrite('P');
 
-    blackboxWriteTag8_8SVB(deltas, optionalFieldCount);
+    blackboxWriteSignedVB((int32_t) (blackboxCurrent->time - 2 * blackboxLast->time + blackboxLastLast->time));
 
-    //Since gyros, accs and motors are noisy, base their predictions on the average of the history:
-    blackboxWriteMainStateArrayUsingAveragePredictor(offsetof(blackboxMainState_t, gyroADC),   XYZ_AXIS_COUNT);
-    if (testBlackboxCondition(FLIGHT_LOG_FIELD_CONDITION_ACC)) {
-        blackboxWriteMainStateArrayUsingAveragePredictor(offsetof(blackboxMainState_t, accSmooth), XYZ_AXIS_COUNT);
-    }
-    if (testBlackboxCondition(FLIGHT_LOG_FIELD_CONDITION_DEBUG)) {
-        blackboxWriteMainStateArrayUsingAveragePredictor(offsetof(blackboxMainState_t, debug), DEBUG16_VALUE_COUNT);
+    for (int x = 0; x < XYZ_AXIS_COUNT; x++) {
+        blackboxWriteSignedVB(blackboxCurrent->gyroADC[x] - (2 * blackboxLast->gyroADC[x] - blackboxLastLast->gyroADC[x]));
     }
-    blackboxWriteMainStateArrayUsingAveragePredictor(offsetof(blackboxMainState_t, motor),     getMotorCount());
-
-    if (testBlackboxCondition(FLIGHT_LOG_FIELD_CONDITION_TRICOPTER)) {
-        blackboxWriteSignedVB(blackboxCurrent->servo[5] - blackboxLast->servo[5]);
+    for (int x = 0; x < XYZ_AXIS_COUNT; x++) {
+        blackboxWriteSignedVB(blackboxCurrent->gyroUnfilt[x] - blackboxLast->gyroUnfilt[x]);
     }
 
     //Rotate our history buffers
@@ -806,6 +1073,7 @@ void blackboxValidateConfig(void)
     case BLACKBOX_DEVICE_SDCARD:
 #endif
     case BLACKBOX_DEVICE_SERIAL:
+    case BLACKBOX_DEVICE_MSP:
         // Device supported, leave the setting alone
         break;
 
@@ -841,6 +1109,8 @@ static void blackboxStart(void)
     blackboxHistory[1] = &blackboxHistoryRing[1];
     blackboxHistory[2] = &blackboxHistoryRing[2];
 
+    blackboxGyroOnly = (blackboxConfig()->mode == BLACKBOX_MODE_GYRO);
+
     vbatReference = getBatteryVoltageLatest();
 
     //No need to clear the content of blackboxHistoryRing since our first frame will be an intra which overwrites it
@@ -851,6 +1121,7 @@ static void blackboxStart(void)
      * cache those now.
      */
     blackboxBuildConditionCache();
+    blackboxBuildWritePlans();
 
     blackboxModeActivationConditionPresent = isModeActivationConditionPresent(BOXBLACKBOX);
 
@@ -862,6 +1133,9 @@ static void blackboxStart(void)
      */
     blackboxLastArmingBeep = getArmingBeepTimeMicros();
     memcpy(&blackboxLastFlightModeFlags, &rcModeActivationMask, sizeof(blackboxLastFlightModeFlags)); // record startup status
+    blackboxLastLoadSheddingLevel = schedulerGetLoadSheddingLevel();
+    blackboxDroppedFrames = 0;
+    blackboxDroppedFramesLogged = 0;
 
     blackboxSetState(BLACKBOX_STATE_PREPARE_LOG_FILE);
 }
@@ -869,6 +1143,8 @@ static void blackboxStart(void)
 /**
  * Begin Blackbox shutdown.
  */
+STATIC_UNIT_TESTED void blackboxLogSnapshots(timeUs_t currentTimeUs);
+
 void blackboxFinish(void)
 {
     switch (blackboxState) {
@@ -880,6 +1156,9 @@ void blackboxFinish(void)
 
     case BLACKBOX_STATE_RUNNING:
     case BLACKBOX_STATE_PAUSED:
+        blackboxTimersRunning = false;
+        blackboxCapturing = false;
+        blackboxLogSnapshots(micros());
         blackboxLogEvent(FLIGHT_LOG_EVENT_LOG_END, NULL);
 
         // Fall through
@@ -997,17 +1276,16 @@ static void writeGPSFrame(timeUs_t currentTimeUs)
 /**
  * Fill the current state of the blackbox using values read from the flight controller
  */
-static void loadMainState(timeUs_t currentTimeUs)
+static void loadMainState(blackboxMainState_t *blackboxCurrent, timeUs_t currentTimeUs)
 {
 #ifndef UNIT_TEST
-    blackboxMainState_t *blackboxCurrent = blackboxHistory[0];
-
     blackboxCurrent->time = currentTimeUs;
 
     for (int i = 0; i < XYZ_AXIS_COUNT; i++) {
         blackboxCurrent->axisPID_P[i] = axisPID_P[i];
         blackboxCurrent->axisPID_I[i] = axisPID_I[i];
         blackboxCurrent->axisPID_D[i] = axisPID_D[i];
+        blackboxCurrent->axisPID_F[i] = axisPID_F[i];
         blackboxCurrent->gyroADC[i] = lrintf(gyro.gyroADCf[i]);
         blackboxCurrent->accSmooth[i] = acc.accSmooth[i];
 #ifdef MAG
@@ -1019,7 +1297,7 @@ static void loadMainState(timeUs_t currentTimeUs)
         blackboxCurrent->rcCommand[i] = rcCommand[i];
     }
 
-    for (int i = 0; i < DEBUG16_VALUE_COUNT; i++) {
+    for (int i = 0; i < DEBUG_VALUE_COUNT; i++) {
         blackboxCurrent->debug[i] = debug[i];
     }
 
@@ -1047,10 +1325,29 @@ static void loadMainState(timeUs_t currentTimeUs)
     blackboxCurrent->servo[5] = servo[5];
 #endif
 #else
+    UNUSED(blackboxCurrent);
     UNUSED(currentTimeUs);
 #endif // UNIT_TEST
 }
 
+// The blackbox_mode GYRO part of the main state, the gyro before and after the filter chain
+static void loadGyroState(blackboxMainState_t *blackboxCurrent, timeUs_t currentTimeUs)
+{
+#ifndef UNIT_TEST
+    // the time the gyro signalled the sample, if it does, so the log shows the actual sample spacing
+    const timeUs_t sampleTimeUs = gyroGetSampleTimeUs();
+    blackboxCurrent->time = sampleTimeUs ? sampleTimeUs : currentTimeUs;
+
+    for (int i = 0; i < XYZ_AXIS_COUNT; i++) {
+        blackboxCurrent->gyroADC[i] = lrintf(gyro.gyroADCf[i]);
+        blackboxCurrent->gyroUnfilt[i] = lrintf(gyro.gyroUnfiltered[i]);
+    }
+#else
+    UNUSED(blackboxCurrent);
+    UNUSED(currentTimeUs);
+#endif
+}
+
 /**
  * Transmit the header information for the given field definitions. Transmitted header lines look like:
  *
@@ -1229,6 +1526,7 @@ static bool blackboxWriteSysinfo(void)
         BLACKBOX_PRINT_HEADER_LINE("looptime", "%d",                        gyro.targetLooptime);
         BLACKBOX_PRINT_HEADER_LINE("gyro_sync_denom", "%d",                 gyroConfig()->gyro_sync_denom);
         BLACKBOX_PRINT_HEADER_LINE("pid_process_denom", "%d",               pidConfig()->pid_process_denom);
+        BLACKBOX_PRINT_HEADER_LINE("motor_output_delay", "%d",              pidConfig()->motorOutputDelayUs);
         BLACKBOX_PRINT_HEADER_LINE("rc_rate", "%d",                         currentControlRateProfile->rcRate8);
         BLACKBOX_PRINT_HEADER_LINE("rc_expo", "%d",                         currentControlRateProfile->rcExpo8);
         BLACKBOX_PRINT_HEADER_LINE("rc_rate_yaw", "%d",                     currentControlRateProfile->rcYawRate8);
@@ -1282,6 +1580,10 @@ static bool blackboxWriteSysinfo(void)
         BLACKBOX_PRINT_HEADER_LINE("anti_gravity_gain", "%d",               currentPidProfile->itermAcceleratorGain);
         BLACKBOX_PRINT_HEADER_LINE("setpoint_relaxation_ratio", "%d",       currentPidProfile->setpointRelaxRatio);
         BLACKBOX_PRINT_HEADER_LINE("dterm_setpoint_weight", "%d",           currentPidProfile->dtermSetpointWeight);
+        BLACKBOX_PRINT_HEADER_LINE("feed_forward", "%d,%d,%d",              currentPidProfile->feedForward[ROLL],
+                                                                            currentPidProfile->feedForward[PITCH],
+                                                                            currentPidProfile->feedForward[YAW]);
+        BLACKBOX_PRINT_HEADER_LINE("feed_forward_smoothing", "%d",          currentPidProfile->feedForwardSmoothing);
         BLACKBOX_PRINT_HEADER_LINE("acc_limit_yaw", "%d",                   currentPidProfile->yawRateAccelLimit);
         BLACKBOX_PRINT_HEADER_LINE("acc_limit", "%d",                       currentPidProfile->rateAccelLimit);
         BLACKBOX_PRINT_HEADER_LINE("pidsum_limit", "%d",                    currentPidProfile->pidSumLimit);
@@ -1310,8 +1612,16 @@ static bool blackboxWriteSysinfo(void)
         BLACKBOX_PRINT_HEADER_LINE("motor_pwm_protocol", "%d",              motorConfig()->dev.motorPwmProtocol);
         BLACKBOX_PRINT_HEADER_LINE("motor_pwm_rate", "%d",                  motorConfig()->dev.motorPwmRate);
         BLACKBOX_PRINT_HEADER_LINE("dshot_idle_value", "%d",                motorConfig()->digitalIdleOffsetValue);
-        BLACKBOX_PRINT_HEADER_LINE("debug_mode", "%d",                      systemConfig()->debug_mode);
+        BLACKBOX_PRINT_HEADER_LINE("debug_mode", "%d",                      debugModeForSlot(0));
+        BLACKBOX_PRINT_HEADER_LINE("debug_modes", "%d,%d,%d,%d",            debugModeForSlot(0), debugModeForSlot(1),
+                                                                            debugModeForSlot(2), debugModeForSlot(3));
         BLACKBOX_PRINT_HEADER_LINE("features", "%d",                        featureConfig()->enabledFeatures);
+#ifdef USE_BLACKBOX_COMPRESSION
+        BLACKBOX_PRINT_HEADER_LINE("log_compression", "%d",                 blackboxDeviceCompressionEnabled());
+#endif
+#ifdef USE_BLACKBOX_PREROLL
+        BLACKBOX_PRINT_HEADER_LINE("blackbox_preroll", "%d,%d",             blackboxConfig()->preroll_sec, BLACKBOX_PREROLL_SAMPLE_COUNT);
+#endif
 
         default:
             return true;
@@ -1345,6 +1655,14 @@ void blackboxLogEvent(FlightLogEvent event, flightLogEventData_t *data)
         blackboxWriteUnsignedVB(data->flightMode.flags);
         blackboxWriteUnsignedVB(data->flightMode.lastFlags);
         break;
+    case FLIGHT_LOG_EVENT_LOAD_SHEDDING:
+        blackboxWrite(data->loadShedding.level);
+        blackboxWrite(data->loadShedding.lastLevel);
+        break;
+    case FLIGHT_LOG_EVENT_FRAMES_DROPPED:
+        blackboxWriteUnsignedVB(data->framesDropped.count);
+        blackboxWriteUnsignedVB(data->framesDropped.total);
+        break;
     case FLIGHT_LOG_EVENT_INFLIGHT_ADJUSTMENT:
         if (data->inflightAdjustment.floatFlag) {
             blackboxWrite(data->inflightAdjustment.adjustmentFunction + FLIGHT_LOG_EVENT_INFLIGHT_ADJUSTMENT_FUNCTION_FLOAT_VALUE_FLAG);
@@ -1358,6 +1676,14 @@ void blackboxLogEvent(FlightLogEvent event, flightLogEventData_t *data)
         blackboxWriteUnsignedVB(data->loggingResume.logIteration);
         blackboxWriteUnsignedVB(data->loggingResume.currentTime);
         break;
+    case FLIGHT_LOG_EVENT_PREROLL_SAMPLE:
+        blackboxWriteUnsignedVB(data->prerollSample.time);
+        blackboxWrite(data->prerollSample.flags);
+        blackboxWriteUnsignedVB(data->prerollSample.armingDisableFlags);
+        blackboxWriteSigned16VBArray(data->prerollSample.gyroADC, XYZ_AXIS_COUNT);
+        blackboxWriteSigned16VBArray(data->prerollSample.rcCommand, 4);
+        blackboxWriteSigned16VBArray(data->prerollSample.motor, 4);
+        break;
     case FLIGHT_LOG_EVENT_LOG_END:
         blackboxPrint("End of log");
         blackboxWrite(0);
@@ -1377,6 +1703,24 @@ static void blackboxCheckAndLogArmingBeep(void)
     }
 }
 
+#ifdef USE_BLACKBOX_PREROLL
+/*
+ * Write out the pre-roll, one sample per call so it doesn't add more to the device than a frame. A failsafe or
+ * crash recovery while paused also writes it, as the normal stream isn't recording then.
+ */
+static void blackboxCheckAndLogPreroll(void)
+{
+    if (!blackboxCapturing) {
+        blackboxPrerollCheckTriggers();
+    }
+
+    const flightLogEvent_prerollSample_t *sample = blackboxPrerollNextDumpSample();
+    if (sample) {
+        blackboxLogEvent(FLIGHT_LOG_EVENT_PREROLL_SAMPLE, (flightLogEventData_t *)sample);
+    }
+}
+#endif
+
 /* monitor the flight mode event status and trigger an event record if the state changes */
 static void blackboxCheckAndLogFlightMode(void)
 {
@@ -1390,6 +1734,34 @@ static void blackboxCheckAndLogFlightMode(void)
     }
 }
 
+/* Log the main frames dropped since the last frame written, returns true if there were any */
+static bool blackboxCheckAndLogFramesDropped(void)
+{
+    if (blackboxDroppedFrames == blackboxDroppedFramesLogged) {
+        return false;
+    }
+
+    flightLogEvent_framesDropped_t eventData;
+    eventData.count = blackboxDroppedFrames - blackboxDroppedFramesLogged;
+    eventData.total = blackboxDroppedFrames;
+    blackboxDroppedFramesLogged = blackboxDroppedFrames;
+    blackboxLogEvent(FLIGHT_LOG_EVENT_FRAMES_DROPPED, (flightLogEventData_t *)&eventData);
+    return true;
+}
+
+/* Log the scheduler stretching or restoring low priority task rates to protect the PID loop */
+static void blackboxCheckAndLogLoadShedding(void)
+{
+    const uint8_t level = schedulerGetLoadSheddingLevel();
+    if (level != blackboxLastLoadSheddingLevel) {
+        flightLogEvent_loadShedding_t eventData;
+        eventData.level = level;
+        eventData.lastLevel = blackboxLastLoadSheddingLevel;
+        blackboxLastLoadSheddingLevel = level;
+        blackboxLogEvent(FLIGHT_LOG_EVENT_LOAD_SHEDDING, (flightLogEventData_t *)&eventData);
+    }
+}
+
 STATIC_UNIT_TESTED bool blackboxShouldLogPFrame(void)
 {
     return blackboxPFrameIndex == 0 && blackboxConfig()->p_denom != 0;
@@ -1410,8 +1782,8 @@ STATIC_UNIT_TESTED bool blackboxShouldLogIFrame(void)
 #ifdef GPS
 STATIC_UNIT_TESTED bool blackboxShouldLogGpsHomeFrame(void)
 {
-    if (GPS_home[0] != gpsHistory.GPS_home[0] || GPS_home[1] != gpsHistory.GPS_home[1]
-        || (blackboxPFrameIndex == blackboxIInterval / 2 && blackboxIFrameIndex % 128 == 0)) {
+    if (GPS_home[0] != gpsHistory.GPS_home[0] || GPS_home[1] != gpsHistory.GPS_home[1] || blackboxGpsHomeDue) {
+        blackboxGpsHomeDue = false;
         return true;
     }
     return false;
@@ -1433,58 +1805,168 @@ STATIC_UNIT_TESTED void blackboxAdvanceIterationTimers(void)
     }
 }
 
-// Called once every FC loop in order to log the current state
-STATIC_UNIT_TESTED void blackboxLogIteration(timeUs_t currentTimeUs)
+static void blackboxCaptureIteration(timeUs_t currentTimeUs)
 {
-    // Write a keyframe every blackboxIInterval frames so we can resynchronise upon missing frames
-    if (blackboxShouldLogIFrame()) {
-        /*
-         * Don't log a slow frame if the slow data didn't change ("I" frames are already large enough without adding
-         * an additional item to write at the same time). Unless we're *only* logging "I" frames, then we have no choice.
-         */
-        if (blackboxIsOnlyLoggingIntraframes()) {
-            writeSlowFrameIfNeeded();
+    if (!blackboxTimersRunning) {
+        return;
+    }
+
+    if (!blackboxCapturing) {
+        // Paused, so the log has to resume from an I frame
+        blackboxCaptureForceIntraframe = true;
+    } else if (blackboxShouldLogIFrame() || blackboxShouldLogPFrame()) {
+        const uint8_t head = blackboxSnapshotHead;
+        const uint8_t next = (head + 1) % BLACKBOX_SNAPSHOT_COUNT;
+        if (next == blackboxSnapshotTail) {
+            // The task has fallen behind, the P frames after a gap can't be decoded so restart from an I frame
+            blackboxCaptureForceIntraframe = true;
+        } else {
+            blackboxSnapshot_t *snapshot = &blackboxSnapshots[head];
+            if (blackboxGyroOnly) {
+                loadGyroState(&snapshot->state, currentTimeUs);
+            } else {
+                loadMainState(&snapshot->state, currentTimeUs);
+            }
+            snapshot->iteration = blackboxIteration;
+            snapshot->intraframe = blackboxShouldLogIFrame() || blackboxCaptureForceIntraframe;
+            blackboxCaptureForceIntraframe = false;
+            __atomic_signal_fence(__ATOMIC_RELEASE);
+            blackboxSnapshotHead = next;
         }
+    }
 
-        loadMainState(currentTimeUs);
-        writeIntraframe();
-    } else {
-        blackboxCheckAndLogArmingBeep();
-        blackboxCheckAndLogFlightMode(); // Check for FlightMode status change event
+#ifdef GPS
+    if (blackboxPFrameIndex == blackboxIInterval / 2 && blackboxIFrameIndex % 128 == 0) {
+        blackboxGpsHomeDue = true;
+    }
+#endif
+
+    blackboxAdvanceIterationTimers();
+}
 
-        if (blackboxShouldLogPFrame()) {
+/**
+ * Call after every PID loop iteration, possibly from the gyro interrupt, to take a snapshot of the state if this
+ * iteration is to be logged. The encoding is left to blackboxUpdate().
+ */
+void blackboxCapture(timeUs_t currentTimeUs)
+{
+#ifdef USE_BLACKBOX_PREROLL
+    if (!blackboxCapturing) {
+        blackboxPrerollCapture(currentTimeUs);
+    }
+#endif
+    if (!blackboxGyroOnly) {
+        blackboxCaptureIteration(currentTimeUs);
+    }
+}
+
+// As blackboxCapture(), but called after every gyro update, for blackbox_mode GYRO
+void blackboxCaptureGyro(timeUs_t currentTimeUs)
+{
+    if (blackboxGyroOnly) {
+        blackboxCaptureIteration(currentTimeUs);
+    }
+}
+
+static bool blackboxSnapshotsPending(void)
+{
+    return blackboxSnapshotHead != blackboxSnapshotTail;
+}
+
+// Encode and write the snapshots taken by blackboxCapture()
+STATIC_UNIT_TESTED void blackboxLogSnapshots(timeUs_t currentTimeUs)
+{
+    while (blackboxSnapshotsPending()) {
+        __atomic_signal_fence(__ATOMIC_ACQUIRE);
+        const uint8_t tail = blackboxSnapshotTail;
+        const blackboxSnapshot_t *snapshot = &blackboxSnapshots[tail];
+
+        if (!blackboxDeviceReserveFrameSpace()) {
+            blackboxDroppedFrames++;
+            __atomic_signal_fence(__ATOMIC_RELEASE);
+            blackboxSnapshotTail = (tail + 1) % BLACKBOX_SNAPSHOT_COUNT;
+            continue;
+        }
+
+        // The P frames after a gap can't be decoded, so the log resumes with an I frame
+        const bool resumeAfterDrop = blackboxCheckAndLogFramesDropped();
+
+        // Write a keyframe every blackboxIInterval frames so we can resynchronise upon missing frames
+        if (snapshot->intraframe || resumeAfterDrop) {
+            /*
+             * Don't log a slow frame if the slow data didn't change ("I" frames are already large enough without adding
+             * an additional item to write at the same time). Unless we're *only* logging "I" frames, then we have no choice.
+             */
+            if (blackboxIsOnlyLoggingIntraframes()) {
+                writeSlowFrameIfNeeded();
+            }
+
+            memcpy(blackboxHistory[0], &snapshot->state, sizeof(blackboxMainState_t));
+            if (blackboxGyroOnly) {
+                writeIntraframeGyro(snapshot->iteration);
+            } else {
+                writeIntraframe(snapshot->iteration);
+            }
+        } else {
             /*
              * We assume that slow frames are only interesting in that they aid the interpretation of the main data stream.
              * So only log slow frames during loop iterations where we log a main frame.
              */
             writeSlowFrameIfNeeded();
 
-            loadMainState(currentTimeUs);
-            writeInterframe();
-        }
-#ifdef GPS
-        if (feature(FEATURE_GPS)) {
-            if (blackboxShouldLogGpsHomeFrame()) {
-                writeGPSHomeFrame();
-                writeGPSFrame(currentTimeUs);
-            } else if (gpsSol.numSat != gpsHistory.GPS_numSat
-                    || gpsSol.llh.lat != gpsHistory.GPS_coord[LAT]
-                    || gpsSol.llh.lon != gpsHistory.GPS_coord[LON]) {
-                //We could check for velocity changes as well but I doubt it changes independent of position
-                writeGPSFrame(currentTimeUs);
+            memcpy(blackboxHistory[0], &snapshot->state, sizeof(blackboxMainState_t));
+            if (blackboxGyroOnly) {
+                writeInterframeGyro();
+            } else {
+                writeInterframe();
             }
         }
+
+        __atomic_signal_fence(__ATOMIC_RELEASE);
+        blackboxSnapshotTail = (tail + 1) % BLACKBOX_SNAPSHOT_COUNT;
+    }
+
+    blackboxCheckAndLogArmingBeep();
+    blackboxCheckAndLogFlightMode(); // Check for FlightMode status change event
+    blackboxCheckAndLogLoadShedding();
+#ifdef USE_BLACKBOX_PREROLL
+    blackboxCheckAndLogPreroll();
 #endif
+
+#ifdef GPS
+    if (feature(FEATURE_GPS)) {
+        if (blackboxShouldLogGpsHomeFrame()) {
+            writeGPSHomeFrame();
+            writeGPSFrame(currentTimeUs);
+        } else if (gpsSol.numSat != gpsHistory.GPS_numSat
+                || gpsSol.llh.lat != gpsHistory.GPS_coord[LAT]
+                || gpsSol.llh.lon != gpsHistory.GPS_coord[LON]) {
+            //We could check for velocity changes as well but I doubt it changes independent of position
+            writeGPSFrame(currentTimeUs);
+        }
     }
+#else
+    UNUSED(currentTimeUs);
+#endif
 
     //Flush every iteration so that our runtime variance is minimized
     blackboxDeviceFlush();
 }
 
 /**
- * Call each flight loop iteration to perform blackbox logging.
+ * The blackbox task runs when there are snapshots to log, and otherwise at the PID loop rate to send the headers.
  */
-void blackboxUpdate(timeUs_t currentTimeUs)
+bool blackboxUpdateCheck(timeUs_t currentTimeUs, timeDelta_t currentDeltaTimeUs)
+{
+    UNUSED(currentTimeUs);
+
+    return blackboxSnapshotsPending() || currentDeltaTimeUs >= (timeDelta_t)targetPidLooptime;
+}
+
+/**
+ * Called from the blackbox task to log the snapshots taken by blackboxCapture() and perform the rest of the logging.
+ */
+static void blackboxUpdateState(timeUs_t currentTimeUs)
 {
     switch (blackboxState) {
     case BLACKBOX_STATE_STOPPED:
@@ -1509,11 +1991,13 @@ void blackboxUpdate(timeUs_t currentTimeUs)
 
         /*
          * Once the UART has had time to init, transmit the header in chunks so we don't overflow its transmit
-         * buffer, overflow the OpenLog's buffer, or keep the main loop busy for too long.
+         * buffer, overflow the OpenLog's buffer, or keep the main loop busy for too long. Flash and SD card
+         * have nothing to wait for and take as much as their buffers hold.
          */
-        if (millis() > xmitState.u.startTime + 100) {
-            if (blackboxDeviceReserveBufferSpace(BLACKBOX_TARGET_HEADER_BUDGET_PER_ITERATION) == BLACKBOX_RESERVE_SUCCESS) {
-                for (int i = 0; i < BLACKBOX_TARGET_HEADER_BUDGET_PER_ITERATION && blackboxHeader[xmitState.headerIndex] != '\0'; i++, xmitState.headerIndex++) {
+        if (blackboxDeviceAcceptsBursts() || millis() > xmitState.u.startTime + 100) {
+            const int32_t chunkSize = blackboxDeviceAcceptsBursts() ? blackboxHeaderBudget : BLACKBOX_TARGET_HEADER_BUDGET_PER_ITERATION;
+            if (chunkSize > 0 && blackboxDeviceReserveBufferSpace(chunkSize) == BLACKBOX_RESERVE_SUCCESS) {
+                for (int i = 0; i < chunkSize && blackboxHeader[xmitState.headerIndex] != '\0'; i++, xmitState.headerIndex++) {
                     blackboxWrite(blackboxHeader[xmitState.headerIndex]);
                     blackboxHeaderBudget--;
                 }
@@ -1526,8 +2010,12 @@ void blackboxUpdate(timeUs_t currentTimeUs)
     case BLACKBOX_STATE_SEND_MAIN_FIELD_HEADER:
         blackboxReplenishHeaderBudget();
         //On entry of this state, xmitState.headerIndex is 0 and xmitState.u.fieldIndex is -1
-        if (!sendFieldDefinition('I', 'P', blackboxMainFields, blackboxMainFields + 1, ARRAYLEN(blackboxMainFields),
-                &blackboxMainFields[0].condition, &blackboxMainFields[1].condition)) {
+        const bool mainFieldHeaderRemaining = blackboxGyroOnly
+            ? sendFieldDefinition('I', 'P', blackboxGyroFields, blackboxGyroFields + 1, ARRAYLEN(blackboxGyroFields),
+                &blackboxGyroFields[0].condition, &blackboxGyroFields[1].condition)
+            : sendFieldDefinition('I', 'P', blackboxMainFields, blackboxMainFields + 1, ARRAYLEN(blackboxMainFields),
+                &blackboxMainFields[0].condition, &blackboxMainFields[1].condition);
+        if (!mainFieldHeaderRemaining) {
 #ifdef GPS
             if (feature(FEATURE_GPS)) {
                 blackboxSetState(BLACKBOX_STATE_SEND_GPS_H_HEADER);
@@ -1573,14 +2061,17 @@ void blackboxUpdate(timeUs_t currentTimeUs)
              * (overflowing circular buffers causes all data to be discarded, so the first few logged iterations
              * could wipe out the end of the header if we weren't careful)
              */
-            if (blackboxDeviceFlushForce()) {
+            if (blackboxDeviceHeaderDelivered()) {
                 blackboxSetState(BLACKBOX_STATE_RUNNING);
             }
         }
         break;
     case BLACKBOX_STATE_PAUSED:
-        // Only allow resume to occur during an I-frame iteration, so that we have an "I" base to work from
-        if (IS_RC_MODE_ACTIVE(BOXBLACKBOX) && blackboxShouldLogIFrame()) {
+        // Write out what was captured before the pause
+        blackboxLogSnapshots(currentTimeUs);
+
+        // The PID loop keeps the logging timers ticking so our log iteration continues to advance, and resumes with an I frame
+        if (IS_RC_MODE_ACTIVE(BOXBLACKBOX)) {
             // Write a log entry so the decoder is aware that our large time/iteration skip is intended
             flightLogEvent_loggingResume_t resume;
 
@@ -1589,21 +2080,15 @@ void blackboxUpdate(timeUs_t currentTimeUs)
 
             blackboxLogEvent(FLIGHT_LOG_EVENT_LOGGING_RESUME, (flightLogEventData_t *) &resume);
             blackboxSetState(BLACKBOX_STATE_RUNNING);
-
-            blackboxLogIteration(currentTimeUs);
         }
-        // Keep the logging timers ticking so our log iteration continues to advance
-        blackboxAdvanceIterationTimers();
         break;
     case BLACKBOX_STATE_RUNNING:
         // On entry to this state, blackboxIteration, blackboxPFrameIndex and blackboxIFrameIndex are reset to 0
         // Prevent the Pausing of the log on the mode switch if in Motor Test Mode
         if (blackboxModeActivationConditionPresent && !IS_RC_MODE_ACTIVE(BOXBLACKBOX) && !startedLoggingInTestMode) {
             blackboxSetState(BLACKBOX_STATE_PAUSED);
-        } else {
-            blackboxLogIteration(currentTimeUs);
         }
-        blackboxAdvanceIterationTimers();
+        blackboxLogSnapshots(currentTimeUs);
         break;
     case BLACKBOX_STATE_SHUTTING_DOWN:
         //On entry of this state, startTime is set
@@ -1668,6 +2153,36 @@ void blackboxUpdate(timeUs_t currentTimeUs)
     }
 }
 
+static bool blackboxSendingHeader(void)
+{
+    return blackboxState >= BLACKBOX_STATE_SEND_HEADER && blackboxState <= BLACKBOX_STATE_SEND_SYSINFO;
+}
+
+void blackboxUpdate(timeUs_t currentTimeUs)
+{
+    blackboxUpdateState(currentTimeUs);
+
+    /*
+     * Each call sends one header line, or as much of it as the budget allows. Flash and SD card don't need that
+     * spread over many calls, so keep going while their buffers take it and logging starts within a few calls of
+     * arming. The number of calls is limited so a run of this task writes about a kilobyte at most.
+     */
+    if (blackboxDeviceAcceptsBursts()) {
+        for (int i = 0; i < BLACKBOX_HEADER_BURST_MAX_CALLS && blackboxSendingHeader(); i++) {
+            const BlackboxState state = blackboxState;
+            uint8_t xmitStateBefore[sizeof(xmitState)];
+            memcpy(xmitStateBefore, &xmitState, sizeof(xmitState));
+
+            blackboxUpdateState(currentTimeUs);
+
+            if (blackboxState == state && memcmp(xmitStateBefore, &xmitState, sizeof(xmitState)) == 0) {
+                // The device buffer is full
+                break;
+            }
+        }
+    }
+}
+
 /*
  * Returns start time in ISO 8601 format, YYYY-MM-DDThh:mm:ss
  * Year value of "0000" indicates time not set
@@ -1691,6 +2206,9 @@ int blackboxCalculatePDenom(int rateNum, int rateDenom)
 
 uint8_t blackboxGetRateNum(void)
 {
+    if (blackboxConfig()->mode == BLACKBOX_MODE_GYRO) {
+        return 1; // every gyro sample, so 1/1
+    }
     return blackboxGetRateDenom() * blackboxConfig()->p_denom / blackboxIInterval;
 }
 
@@ -1715,6 +2233,9 @@ void blackboxInit(void)
     } else {
         blackboxIInterval = (uint16_t)(32 * 1000 / gyro.targetLooptime);
     }
+#ifdef USE_BLACKBOX_PREROLL
+    blackboxPrerollInit(blackboxConfig()->preroll_sec);
+#endif
     // by default p_denom is 32 and a P-frame is written every 1ms
     // if p_denom is zero then no P-frames are logged
     if (blackboxConfig()->p_denom == 0) {
@@ -1724,6 +2245,10 @@ void blackboxInit(void)
     } else {
         blackboxPInterval = blackboxIInterval /  blackboxConfig()->p_denom;
     }
+    if (blackboxConfig()->mode == BLACKBOX_MODE_GYRO) {
+        // every gyro sample is logged, p_denom only applies to the normal mode
+        blackboxPInterval = 1;
+    }
     if (blackboxConfig()->device) {
         blackboxSetState(BLACKBOX_STATE_STOPPED);
     } else {
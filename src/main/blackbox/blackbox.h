@@ -31,14 +31,23 @@ typedef enum BlackboxDevice {
 #ifdef USE_SDCARD
     BLACKBOX_DEVICE_SDCARD = 2,
 #endif
-    BLACKBOX_DEVICE_SERIAL = 3
+    BLACKBOX_DEVICE_SERIAL = 3,
+    BLACKBOX_DEVICE_MSP = 4     // streamed live to the MSP ports as MSP_BLACKBOX_STREAM messages
 } BlackboxDevice_e;
 
+typedef enum BlackboxMode {
+    BLACKBOX_MODE_NORMAL = 0,
+    BLACKBOX_MODE_GYRO              // only the filtered and unfiltered gyro, at the gyro rate, for noise analysis
+} BlackboxMode_e;
+
 typedef struct blackboxConfig_s {
     uint16_t p_denom; // I-frame interval / P-frame interval
     uint8_t device;
     uint8_t on_motor_test;
     uint8_t record_acc;
+    uint8_t mode;       // see BlackboxMode_e
+    uint8_t compression; // compress the log written to flash or SD card
+    uint8_t preroll_sec; // seconds of state kept while not logging, written out on arming and on a failsafe or crash recovery
 } blackboxConfig_t;
 
 PG_DECLARE(blackboxConfig_t, blackboxConfig);
@@ -46,6 +55,9 @@ PG_DECLARE(blackboxConfig_t, blackboxConfig);
 void blackboxLogEvent(FlightLogEvent event, flightLogEventData_t *data);
 
 void blackboxInit(void);
+void blackboxCapture(timeUs_t currentTimeUs);
+void blackboxCaptureGyro(timeUs_t currentTimeUs);
+bool blackboxUpdateCheck(timeUs_t currentTimeUs, timeDelta_t currentDeltaTimeUs);
 void blackboxUpdate(timeUs_t currentTimeUs);
 const char *blackboxGetStartDateTime(void);
 void blackboxSetStartDateTime(const char *dateTime, timeMs_t timeNowMs);
@@ -55,8 +67,9 @@ uint8_t blackboxGetRateDenom(void);
 void blackboxValidateConfig(void);
 void blackboxFinish(void);
 bool blackboxMayEditConfig(void);
+uint32_t blackboxGetDroppedFrames(void);
 #ifdef UNIT_TEST
-STATIC_UNIT_TESTED void blackboxLogIteration(timeUs_t currentTimeUs);
+STATIC_UNIT_TESTED void blackboxLogSnapshots(timeUs_t currentTimeUs);
 STATIC_UNIT_TESTED bool blackboxShouldLogPFrame(void);
 STATIC_UNIT_TESTED bool blackboxShouldLogIFrame(void);
 STATIC_UNIT_TESTED bool blackboxShouldLogGpsHomeFrame(void);
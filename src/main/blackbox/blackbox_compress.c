@@ -0,0 +1,184 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "platform.h"
+
+#ifdef USE_BLACKBOX_COMPRESSION
+
+#include "blackbox/blackbox_compress.h"
+
+#include "common/maths.h"
+
+#define COMPRESS_HASH_BITS 8
+#define COMPRESS_HASH_SIZE (1 << COMPRESS_HASH_BITS)
+
+// Room for a block of incompressible data, with the token and length bytes each append adds
+#define COMPRESS_OUTPUT_SIZE (BLACKBOX_COMPRESSION_HEADER_SIZE + BLACKBOX_COMPRESSION_BLOCK_SIZE + BLACKBOX_COMPRESSION_BLOCK_SIZE / 16)
+
+static struct {
+    uint8_t history[BLACKBOX_COMPRESSION_BLOCK_SIZE];   // the uncompressed block so far, which the matches refer back to
+    uint8_t output[COMPRESS_OUTPUT_SIZE];
+    uint16_t hashTable[COMPRESS_HASH_SIZE];            // position + 1 of the last 4 bytes with each hash, 0 for none
+    uint16_t historyLength;
+    uint16_t outputLength;
+} compressor;
+
+static inline uint32_t read32(const uint8_t *data)
+{
+    uint32_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+static inline unsigned hash32(uint32_t value)
+{
+    return (value * 2654435761u) >> (32 - COMPRESS_HASH_BITS);
+}
+
+static uint8_t *writeLength(uint8_t *out, int length)
+{
+    while (length >= 255) {
+        *out++ = 255;
+        length -= 255;
+    }
+    *out++ = length;
+    return out;
+}
+
+static uint8_t *writeSequence(uint8_t *out, const uint8_t *literals, int literalCount, int offset, int matchLength)
+{
+    const int matchCode = matchLength ? matchLength - BLACKBOX_COMPRESSION_MIN_MATCH + 1 : 0;
+
+    *out++ = (MIN(literalCount, 15) << 4) | MIN(matchCode, 15);
+    if (literalCount >= 15) {
+        out = writeLength(out, literalCount - 15);
+    }
+    memcpy(out, literals, literalCount);
+    out += literalCount;
+
+    if (matchLength) {
+        *out++ = offset;
+        *out++ = offset >> 8;
+        if (matchCode >= 15) {
+            out = writeLength(out, matchCode - 15);
+        }
+    }
+    return out;
+}
+
+/*
+ * Compress history[start..end). Each byte costs at most one hash lookup, so the time taken is bounded by the number
+ * of bytes appended. Matches stop at end, as the bytes after it have not arrived yet.
+ */
+static void compressRange(int start, int end)
+{
+    const uint8_t *history = compressor.history;
+    uint8_t *out = &compressor.output[compressor.outputLength];
+    int literalStart = start;
+    int pos = start;
+
+    while (pos + BLACKBOX_COMPRESSION_MIN_MATCH <= end) {
+        const uint32_t sequence = read32(&history[pos]);
+        const unsigned hash = hash32(sequence);
+        const int candidate = compressor.hashTable[hash] - 1;
+        compressor.hashTable[hash] = pos + 1;
+
+        if (candidate < 0 || read32(&history[candidate]) != sequence) {
+            pos++;
+            continue;
+        }
+
+        int matchLength = BLACKBOX_COMPRESSION_MIN_MATCH;
+        while (pos + matchLength < end && history[candidate + matchLength] == history[pos + matchLength]) {
+            matchLength++;
+        }
+
+        out = writeSequence(out, &history[literalStart], pos - literalStart, pos - candidate, matchLength);
+        pos += matchLength;
+        literalStart = pos;
+    }
+
+    if (literalStart < end) {
+        out = writeSequence(out, &history[literalStart], end - literalStart, 0, 0);
+    }
+
+    compressor.outputLength = out - compressor.output;
+}
+
+void blackboxCompressorReset(void)
+{
+    memset(compressor.hashTable, 0, sizeof(compressor.hashTable));
+    compressor.historyLength = 0;
+    compressor.outputLength = BLACKBOX_COMPRESSION_HEADER_SIZE;
+}
+
+bool blackboxCompressorIsEmpty(void)
+{
+    return compressor.historyLength == 0;
+}
+
+/*
+ * Compress as much of data into the current block as fits and return the number of bytes taken. Less than count is
+ * only taken when the block is full, so it needs to be finished before appending the rest.
+ */
+int blackboxCompressorAppend(const uint8_t *data, int count)
+{
+    // A sequence with a match is never longer than the bytes it encodes, so only the last run of literals can grow
+    const int outputSpace = COMPRESS_OUTPUT_SIZE - compressor.outputLength - 2;
+    if (outputSpace <= 0) {
+        return 0;
+    }
+    count = MIN(count, BLACKBOX_COMPRESSION_BLOCK_SIZE - compressor.historyLength);
+    count = MIN(count, outputSpace * 128 / 129);
+    if (count <= 0) {
+        return 0;
+    }
+
+    const int start = compressor.historyLength;
+    memcpy(&compressor.history[start], data, count);
+    compressor.historyLength += count;
+    compressRange(start, compressor.historyLength);
+
+    return count;
+}
+
+/*
+ * Complete the current block and point *block at it, returning its length. The block stays valid until the next
+ * append, so it must be written out before then.
+ */
+int blackboxCompressorFinishBlock(const uint8_t **block)
+{
+    const int payloadLength = compressor.outputLength - BLACKBOX_COMPRESSION_HEADER_SIZE;
+    const int length = compressor.outputLength;
+
+    compressor.output[0] = BLACKBOX_COMPRESSION_BLOCK_MARKER;
+    compressor.output[1] = payloadLength;
+    compressor.output[2] = payloadLength >> 8;
+    compressor.output[3] = compressor.historyLength;
+    compressor.output[4] = compressor.historyLength >> 8;
+    *block = compressor.output;
+
+    blackboxCompressorReset();
+
+    return length;
+}
+
+#endif
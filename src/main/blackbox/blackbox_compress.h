@@ -0,0 +1,50 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+/*
+ * Streaming compressor for the blackbox log, an LZ77 variant in the style of LZ4 that only has to find matches within
+ * the current block. Every block can be decoded on its own, so a log cut short by a power loss is only missing its
+ * last block.
+ *
+ * A block is the marker byte, the payload length and the decoded length (both uint16, little endian) and then the
+ * payload, a run of sequences of:
+ *
+ *   token            high nibble: literal count, low nibble: match length - 3, or 0 if the sequence has no match
+ *   literal count    if the nibble is 15, the rest of the count as bytes of 255 ending with a byte of less than 255
+ *   literals
+ *   match offset     if there is a match, the distance back to copy from (uint16, little endian)
+ *   match length     if the nibble is 15, the rest of the length encoded like the literal count
+ *
+ * The matches may overlap the bytes being copied, so they have to be decoded a byte at a time.
+ */
+
+#if defined(STM32F4) || defined(STM32F7)
+#define BLACKBOX_COMPRESSION_BLOCK_SIZE 2048
+#else
+#define BLACKBOX_COMPRESSION_BLOCK_SIZE 512
+#endif
+
+#define BLACKBOX_COMPRESSION_BLOCK_MARKER 'Z'
+#define BLACKBOX_COMPRESSION_HEADER_SIZE 5
+#define BLACKBOX_COMPRESSION_MIN_MATCH 4
+
+void blackboxCompressorReset(void);
+bool blackboxCompressorIsEmpty(void);
+int blackboxCompressorAppend(const uint8_t *data, int count);
+int blackboxCompressorFinishBlock(const uint8_t **block);
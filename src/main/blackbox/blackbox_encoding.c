@@ -12,6 +12,7 @@
 #include "blackbox_io.h"
 
 #include "common/encoding.h"
+#include "common/maths.h"
 #include "common/printf.h"
 
 
@@ -65,17 +66,65 @@ void blackboxPrintfHeaderLine(const char *name, const char *fmt, ...)
     blackboxHeaderBudget -= written + 3;
 }
 
-/**
- * Write an unsigned integer to the blackbox serial port using variable byte encoding.
+/*
+ * The encoders below build each value, or a whole array of values, in a small buffer on the stack and hand it
+ * to the device buffer in one blackboxWriteBuf() call rather than one blackboxWrite() per byte.
+ *
+ * Field sizes are classified without branching on each threshold: ZigZag-style folding (v ^ (v >> 31)) turns a
+ * signed value into a magnitude that has the same number of significant bits as the value needs, less the sign
+ * bit, so the number of bits follows from a single CLZ.
  */
-void blackboxWriteUnsignedVB(uint32_t value)
+
+// The number of significant bits in a folded magnitude, 1 for 0 so the CLZ is always defined
+static inline int magnitudeBits(uint32_t magnitude)
+{
+    return 32 - __builtin_clz(magnitude | 1);
+}
+
+static inline uint32_t signedMagnitude(int32_t value)
+{
+    return (uint32_t)(value ^ (value >> 31));
+}
+
+// Returns the number of bytes minus one needed to hold the signed value, so 0 to 3
+static inline int signedByteClass(int32_t value)
+{
+    // a signed byte holds magnitudes of up to 7 bits
+    return magnitudeBits(signedMagnitude(value)) >> 3;
+}
+
+static uint8_t *encodeUnsignedVB(uint8_t *dest, uint32_t value)
 {
     //While this isn't the final byte (we can only write 7 bits at a time)
     while (value > 127) {
-        blackboxWrite((uint8_t) (value | 0x80)); // Set the high bit to mean "more bytes follow"
+        *dest++ = (uint8_t) (value | 0x80); // Set the high bit to mean "more bytes follow"
         value >>= 7;
     }
-    blackboxWrite(value);
+    *dest++ = value;
+    return dest;
+}
+
+/*
+ * Stores the 1 to 4 low bytes of value, least significant first. Always stores a whole word, so there must be room for
+ * 4 bytes at dest. All of the targets are little endian.
+ */
+static inline uint8_t *encodeBytesLE(uint8_t *dest, int32_t value, int byteCount)
+{
+    memcpy(dest, &value, sizeof(value));
+    return dest + byteCount;
+}
+
+/**
+ * Write an unsigned integer to the blackbox serial port using variable byte encoding.
+ */
+void blackboxWriteUnsignedVB(uint32_t value)
+{
+    if (value < 128) {
+        blackboxWrite(value);
+    } else {
+        uint8_t buf[5];
+        blackboxWriteBuf(buf, encodeUnsignedVB(buf, value) - buf);
+    }
 }
 
 /**
@@ -87,17 +136,34 @@ void blackboxWriteSignedVB(int32_t value)
     blackboxWriteUnsignedVB(zigzagEncode(value));
 }
 
+// The number of values encoded into the stack buffer before it is written out
+#define VB_ARRAY_BATCH_COUNT 8
+
 void blackboxWriteSignedVBArray(int32_t *array, int count)
 {
-    for (int i = 0; i < count; i++) {
-        blackboxWriteSignedVB(array[i]);
+    uint8_t buf[VB_ARRAY_BATCH_COUNT * 5];
+
+    for (int i = 0; i < count; i += VB_ARRAY_BATCH_COUNT) {
+        const int end = MIN(count, i + VB_ARRAY_BATCH_COUNT);
+        uint8_t *dest = buf;
+        for (int j = i; j < end; j++) {
+            dest = encodeUnsignedVB(dest, zigzagEncode(array[j]));
+        }
+        blackboxWriteBuf(buf, dest - buf);
     }
 }
 
 void blackboxWriteSigned16VBArray(int16_t *array, int count)
 {
-    for (int i = 0; i < count; i++) {
-        blackboxWriteSignedVB(array[i]);
+    uint8_t buf[VB_ARRAY_BATCH_COUNT * 3];
+
+    for (int i = 0; i < count; i += VB_ARRAY_BATCH_COUNT) {
+        const int end = MIN(count, i + VB_ARRAY_BATCH_COUNT);
+        uint8_t *dest = buf;
+        for (int j = i; j < end; j++) {
+            dest = encodeUnsignedVB(dest, zigzagEncode(array[j]));
+        }
+        blackboxWriteBuf(buf, dest - buf);
     }
 }
 
@@ -107,14 +173,39 @@ void blackboxWriteS16(int16_t value)
     blackboxWrite((value >> 8) & 0xFF);
 }
 
+/*
+ * The 32 bit scheme shared by the Tag2_3S encoders: a selector byte with a 2 bit byte count for each field, followed by
+ * the fields, least significant byte first. Returns the number of bytes written to dest, which needs room for 13.
+ */
+static int encodeTag2_3S32Fields(uint8_t *dest, int selector, const int32_t *values)
+{
+    /*
+     * Selector2 field possibilities
+     * 0 - 8 bits
+     * 1 - 16 bits
+     * 2 - 24 bits
+     * 3 - 32 bits
+     */
+    const int class0 = signedByteClass(values[0]);
+    const int class1 = signedByteClass(values[1]);
+    const int class2 = signedByteClass(values[2]);
+
+    //The first field is in the low bits
+    uint8_t *p = dest;
+    *p++ = (selector << 6) | (class2 << 4) | (class1 << 2) | class0;
+
+    p = encodeBytesLE(p, values[0], class0 + 1);
+    p = encodeBytesLE(p, values[1], class1 + 1);
+    p = encodeBytesLE(p, values[2], class2 + 1);
+
+    return p - dest;
+}
+
 /**
  * Write a 2 bit tag followed by 3 signed fields of 2, 4, 6 or 32 bits
  */
 void blackboxWriteTag2_3S32(int32_t *values)
 {
-    static const int NUM_FIELDS = 3;
-
-    //Need to be enums rather than const ints if we want to switch on them (due to being C)
     enum {
         BITS_2  = 0,
         BITS_4  = 1,
@@ -122,15 +213,6 @@ void blackboxWriteTag2_3S32(int32_t *values)
         BITS_32 = 3
     };
 
-    enum {
-        BYTES_1  = 0,
-        BYTES_2  = 1,
-        BYTES_3  = 2,
-        BYTES_4  = 3
-    };
-
-    int selector = BITS_2, selector2;
-
     /*
      * Find out how many bits the largest value requires to encode, and use it to choose one of the packing schemes
      * below:
@@ -141,94 +223,38 @@ void blackboxWriteTag2_3S32(int32_t *values)
      * 4 bits per field  ss00 1111 2222 3333
      * 6 bits per field  ss11 1111 0022 2222 0033 3333
      * 32 bits per field sstt tttt followed by fields of various byte counts
+     *
+     * The widest field decides, and the OR of the magnitudes has as many significant bits as the widest of them.
+     * 1 significant bit fits 2 bits signed, 2-3 fit 4 bits, 4-5 fit 6 bits.
      */
-    for (int x = 0; x < NUM_FIELDS; x++) {
-        //Require more than 6 bits?
-        if (values[x] >= 32 || values[x] < -32) {
-            selector = BITS_32;
-            break;
-        }
+    const uint32_t magnitude = signedMagnitude(values[0]) | signedMagnitude(values[1]) | signedMagnitude(values[2]);
+    const int selector = MIN(magnitudeBits(magnitude) >> 1, BITS_32);
 
-        //Require more than 4 bits?
-        if (values[x] >= 8 || values[x] < -8) {
-             if (selector < BITS_6) {
-                 selector = BITS_6;
-             }
-        } else if (values[x] >= 2 || values[x] < -2) { //Require more than 2 bits?
-            if (selector < BITS_4) {
-                selector = BITS_4;
-            }
-        }
-    }
+    uint8_t buf[13];
+    int length;
 
     switch (selector) {
     case BITS_2:
-        blackboxWrite((selector << 6) | ((values[0] & 0x03) << 4) | ((values[1] & 0x03) << 2) | (values[2] & 0x03));
+        buf[0] = (selector << 6) | ((values[0] & 0x03) << 4) | ((values[1] & 0x03) << 2) | (values[2] & 0x03);
+        length = 1;
         break;
     case BITS_4:
-        blackboxWrite((selector << 6) | (values[0] & 0x0F));
-        blackboxWrite((values[1] << 4) | (values[2] & 0x0F));
+        buf[0] = (selector << 6) | (values[0] & 0x0F);
+        buf[1] = (values[1] << 4) | (values[2] & 0x0F);
+        length = 2;
         break;
     case BITS_6:
-        blackboxWrite((selector << 6) | (values[0] & 0x3F));
-        blackboxWrite((uint8_t)values[1]);
-        blackboxWrite((uint8_t)values[2]);
+        buf[0] = (selector << 6) | (values[0] & 0x3F);
+        buf[1] = (uint8_t)values[1];
+        buf[2] = (uint8_t)values[2];
+        length = 3;
         break;
-    case BITS_32:
-        /*
-         * Do another round to compute a selector for each field, assuming that they are at least 8 bits each
-         *
-         * Selector2 field possibilities
-         * 0 - 8 bits
-         * 1 - 16 bits
-         * 2 - 24 bits
-         * 3 - 32 bits
-         */
-        selector2 = 0;
-
-        //Encode in reverse order so the first field is in the low bits:
-        for (int x = NUM_FIELDS - 1; x >= 0; x--) {
-            selector2 <<= 2;
-
-            if (values[x] < 128 && values[x] >= -128) {
-                selector2 |= BYTES_1;
-            } else if (values[x] < 32768 && values[x] >= -32768) {
-                selector2 |= BYTES_2;
-            } else if (values[x] < 8388608 && values[x] >= -8388608) {
-                selector2 |= BYTES_3;
-            } else {
-                selector2 |= BYTES_4;
-            }
-        }
-
-        //Write the selectors
-        blackboxWrite((selector << 6) | selector2);
-
-        //And now the values according to the selectors we picked for them
-        for (int x = 0; x < NUM_FIELDS; x++, selector2 >>= 2) {
-            switch (selector2 & 0x03) {
-            case BYTES_1:
-                blackboxWrite(values[x]);
-                break;
-            case BYTES_2:
-                blackboxWrite(values[x]);
-                blackboxWrite(values[x] >> 8);
-                break;
-            case BYTES_3:
-                blackboxWrite(values[x]);
-                blackboxWrite(values[x] >> 8);
-                blackboxWrite(values[x] >> 16);
-                break;
-            case BYTES_4:
-                blackboxWrite(values[x]);
-                blackboxWrite(values[x] >> 8);
-                blackboxWrite(values[x] >> 16);
-                blackboxWrite(values[x] >> 24);
-                break;
-            }
-        }
+    default:
+        length = encodeTag2_3S32Fields(buf, selector, values);
         break;
     }
+
+    blackboxWriteBuf(buf, length);
 }
 
 /**
@@ -236,7 +262,6 @@ void blackboxWriteTag2_3S32(int32_t *values)
  */
 int blackboxWriteTag2_3SVariable(int32_t *values)
 {
-    static const int FIELD_COUNT = 3;
     enum {
         BITS_2  = 0,
         BITS_554  = 1,
@@ -244,14 +269,6 @@ int blackboxWriteTag2_3SVariable(int32_t *values)
         BITS_32 = 3
     };
 
-    enum {
-        BYTES_1  = 0,
-        BYTES_2  = 1,
-        BYTES_3  = 2,
-        BYTES_4  = 3
-    };
-
-
     /*
      * Find out how many bits the largest value requires to encode, and use it to choose one of the packing schemes
      * below:
@@ -262,95 +279,46 @@ int blackboxWriteTag2_3SVariable(int32_t *values)
      * 554 bits per field  ss11 1112 2222 3333
      * 877 bits per field  ss11 1111 1122 2222 2333 3333
      * 32 bits per field sstt tttt followed by fields of various byte counts
+     *
+     * The fields have different widths, so each one is classified against its own limits and the widest class wins.
      */
-    int selector = BITS_2;
-    int selector2 = 0;
-    // Require more than 877 bits?
-    if (values[0] >= 256 || values[0] < -256
-            || values[1] >= 128 || values[1] < -128
-            || values[2] >= 128 || values[2] < -128) {
-        selector = BITS_32;
-   // Require more than 554 bits?
-    } else if (values[0] >= 16 || values[0] < -16
-            || values[1] >= 16 || values[1] < -16
-            || values[2] >= 8 || values[2] < -8) {
-        selector = BITS_877;
-        // Require more than 2 bits?
-    } else if (values[0] >= 2 || values[0] < -2
-            || values[1] >= 2 || values[1] < -2
-            || values[2] >= 2 || values[2] < -2) {
-        selector = BITS_554;
-    }
+    const int bits0 = magnitudeBits(signedMagnitude(values[0]));
+    const int bits1 = magnitudeBits(signedMagnitude(values[1]));
+    const int bits2 = magnitudeBits(signedMagnitude(values[2]));
+
+    const int class0 = (bits0 > 1) + (bits0 > 4) + (bits0 > 8);
+    const int class1 = (bits1 > 1) + (bits1 > 4) + (bits1 > 7);
+    const int class2 = (bits2 > 1) + (bits2 > 3) + (bits2 > 7);
+    const int selector = MAX(class0, MAX(class1, class2));
+
+    uint8_t buf[13];
+    int length;
 
     switch (selector) {
     case BITS_2:
-        blackboxWrite((selector << 6) | ((values[0] & 0x03) << 4) | ((values[1] & 0x03) << 2) | (values[2] & 0x03));
+        buf[0] = (selector << 6) | ((values[0] & 0x03) << 4) | ((values[1] & 0x03) << 2) | (values[2] & 0x03);
+        length = 1;
         break;
     case BITS_554:
         // 554 bits per field  ss11 1112 2222 3333
-        blackboxWrite((selector << 6) | ((values[0] & 0x1F) << 1) | ((values[1] & 0x1F) >> 4));
-        blackboxWrite(((values[1] & 0x0F) << 4) | (values[2] & 0x0F));
+        buf[0] = (selector << 6) | ((values[0] & 0x1F) << 1) | ((values[1] & 0x1F) >> 4);
+        buf[1] = ((values[1] & 0x0F) << 4) | (values[2] & 0x0F);
+        length = 2;
         break;
     case BITS_877:
         // 877 bits per field  ss11 1111 1122 2222 2333 3333
-        blackboxWrite((selector << 6) | ((values[0] & 0xFF) >> 2));
-        blackboxWrite(((values[0] & 0x03) << 6) | ((values[1] & 0x7F) >> 1));
-        blackboxWrite(((values[1] & 0x01) << 7) | (values[2] & 0x7F));
+        buf[0] = (selector << 6) | ((values[0] & 0xFF) >> 2);
+        buf[1] = ((values[0] & 0x03) << 6) | ((values[1] & 0x7F) >> 1);
+        buf[2] = ((values[1] & 0x01) << 7) | (values[2] & 0x7F);
+        length = 3;
+        break;
+    default:
+        length = encodeTag2_3S32Fields(buf, selector, values);
         break;
-    case BITS_32:
-        /*
-         * Do another round to compute a selector for each field, assuming that they are at least 8 bits each
-         *
-         * Selector2 field possibilities
-         * 0 - 8 bits
-         * 1 - 16 bits
-         * 2 - 24 bits
-         * 3 - 32 bits
-         */
-        selector2 = 0;
-        //Encode in reverse order so the first field is in the low bits:
-        for (int x = FIELD_COUNT - 1; x >= 0; x--) {
-            selector2 <<= 2;
-
-            if (values[x] < 128 && values[x] >= -128) {
-                selector2 |= BYTES_1;
-            } else if (values[x] < 32768 && values[x] >= -32768) {
-                selector2 |= BYTES_2;
-            } else if (values[x] < 8388608 && values[x] >= -8388608) {
-                selector2 |= BYTES_3;
-            } else {
-                selector2 |= BYTES_4;
-            }
-        }
-
-        //Write the selectors
-        blackboxWrite((selector << 6) | selector2);
-
-        //And now the values according to the selectors we picked for them
-        for (int x = 0; x < FIELD_COUNT; x++, selector2 >>= 2) {
-            switch (selector2 & 0x03) {
-            case BYTES_1:
-                blackboxWrite(values[x]);
-                break;
-            case BYTES_2:
-                blackboxWrite(values[x]);
-                blackboxWrite(values[x] >> 8);
-                break;
-            case BYTES_3:
-                blackboxWrite(values[x]);
-                blackboxWrite(values[x] >> 8);
-                blackboxWrite(values[x] >> 16);
-                break;
-            case BYTES_4:
-                blackboxWrite(values[x]);
-                blackboxWrite(values[x] >> 8);
-                blackboxWrite(values[x] >> 16);
-                blackboxWrite(values[x] >> 24);
-                break;
-            }
-        }
-    break;
     }
+
+    blackboxWriteBuf(buf, length);
+
     return selector;
 }
 
@@ -359,80 +327,41 @@ int blackboxWriteTag2_3SVariable(int32_t *values)
  */
 void blackboxWriteTag8_4S16(int32_t *values)
 {
+    // Field sizes by selector: zero, 4 bit, 8 bit and 16 bit
+    static const uint8_t fieldBits[] = { 0, 4, 8, 16 };
 
-    //Need to be enums rather than const ints if we want to switch on them (due to being C)
-    enum {
-        FIELD_ZERO  = 0,
-        FIELD_4BIT  = 1,
-        FIELD_8BIT  = 2,
-        FIELD_16BIT = 3
-    };
-
+    uint8_t buf[1 + 4 * 2];
     uint8_t selector = 0;
+
     //Encode in reverse order so the first field is in the low bits:
     for (int x = 3; x >= 0; x--) {
-        selector <<= 2;
-
-        if (values[x] == 0) {
-            selector |= FIELD_ZERO;
-        } else if (values[x] < 8 && values[x] >= -8) {
-            selector |= FIELD_4BIT;
-        } else if (values[x] < 128 && values[x] >= -128) {
-            selector |= FIELD_8BIT;
-        } else {
-            selector |= FIELD_16BIT;
-        }
+        const uint32_t magnitude = signedMagnitude(values[x]);
+        selector = (selector << 2) | ((values[x] != 0) + (magnitude >= 8) + (magnitude >= 128));
     }
+    buf[0] = selector;
 
-    blackboxWrite(selector);
-
-    int nibbleIndex = 0;
-    uint8_t buffer = 0;
+    /*
+     * The fields are packed as nibbles, high nibble first, so shift them into an accumulator and take whole bytes
+     * off the top. At most 4 bits are ever left over, so a 16 bit field always fits.
+     */
+    uint8_t *p = &buf[1];
+    uint32_t accumulator = 0;
+    int accumulatorBits = 0;
     for (int x = 0; x < 4; x++, selector >>= 2) {
-        switch (selector & 0x03) {
-        case FIELD_ZERO:
-            //No-op
-            break;
-        case FIELD_4BIT:
-            if (nibbleIndex == 0) {
-                //We fill high-bits first
-                buffer = values[x] << 4;
-                nibbleIndex = 1;
-            } else {
-                blackboxWrite(buffer | (values[x] & 0x0F));
-                nibbleIndex = 0;
-            }
-            break;
-        case FIELD_8BIT:
-            if (nibbleIndex == 0) {
-                blackboxWrite(values[x]);
-            } else {
-                //Write the high bits of the value first (mask to avoid sign extension)
-                blackboxWrite(buffer | ((values[x] >> 4) & 0x0F));
-                //Now put the leftover low bits into the top of the next buffer entry
-                buffer = values[x] << 4;
-            }
-            break;
-        case FIELD_16BIT:
-            if (nibbleIndex == 0) {
-                //Write high byte first
-                blackboxWrite(values[x] >> 8);
-                blackboxWrite(values[x]);
-            } else {
-                //First write the highest 4 bits
-                blackboxWrite(buffer | ((values[x] >> 12) & 0x0F));
-                // Then the middle 8
-                blackboxWrite(values[x] >> 4);
-                //Only the smallest 4 bits are still left to write
-                buffer = values[x] << 4;
-            }
-            break;
+        const int bits = fieldBits[selector & 0x03];
+        accumulator = (accumulator << bits) | (values[x] & ((1 << bits) - 1));
+        accumulatorBits += bits;
+        while (accumulatorBits >= 8) {
+            accumulatorBits -= 8;
+            *p++ = accumulator >> accumulatorBits;
         }
     }
     //Anything left over to write?
-    if (nibbleIndex == 1) {
-        blackboxWrite(buffer);
+    if (accumulatorBits) {
+        *p++ = accumulator << (8 - accumulatorBits);
     }
+
+    blackboxWriteBuf(buf, p - buf);
 }
 
 /**
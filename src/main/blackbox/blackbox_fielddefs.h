@@ -40,10 +40,17 @@ typedef enum FlightLogFieldCondition {
     FLIGHT_LOG_FIELD_CONDITION_NONZERO_PID_D_1,
     FLIGHT_LOG_FIELD_CONDITION_NONZERO_PID_D_2,
 
+    FLIGHT_LOG_FIELD_CONDITION_NONZERO_FF_0,
+    FLIGHT_LOG_FIELD_CONDITION_NONZERO_FF_1,
+    FLIGHT_LOG_FIELD_CONDITION_NONZERO_FF_2,
+
     FLIGHT_LOG_FIELD_CONDITION_NOT_LOGGING_EVERY_FRAME,
 
     FLIGHT_LOG_FIELD_CONDITION_ACC,
-    FLIGHT_LOG_FIELD_CONDITION_DEBUG,
+    FLIGHT_LOG_FIELD_CONDITION_DEBUG_0,     // a bank of debug values has a mode in it
+    FLIGHT_LOG_FIELD_CONDITION_DEBUG_1,
+    FLIGHT_LOG_FIELD_CONDITION_DEBUG_2,
+    FLIGHT_LOG_FIELD_CONDITION_DEBUG_3,
 
     FLIGHT_LOG_FIELD_CONDITION_NEVER,
 
@@ -111,6 +118,9 @@ typedef enum FlightLogEvent {
     FLIGHT_LOG_EVENT_INFLIGHT_ADJUSTMENT = 13,
     FLIGHT_LOG_EVENT_LOGGING_RESUME = 14,
     FLIGHT_LOG_EVENT_FLIGHTMODE = 30, // Add new event type for flight mode status.
+    FLIGHT_LOG_EVENT_LOAD_SHEDDING = 31,
+    FLIGHT_LOG_EVENT_PREROLL_SAMPLE = 32,
+    FLIGHT_LOG_EVENT_FRAMES_DROPPED = 33,
     FLIGHT_LOG_EVENT_LOG_END = 255
 } FlightLogEvent;
 
@@ -123,6 +133,17 @@ typedef struct flightLogEvent_flightMode_s { // New Event Data type
     uint32_t lastFlags;
 } flightLogEvent_flightMode_t;
 
+typedef struct flightLogEvent_loadShedding_s {
+    uint8_t level;
+    uint8_t lastLevel;
+} flightLogEvent_loadShedding_t;
+
+// Written before the I frame that resumes the log after main frames were dropped
+typedef struct flightLogEvent_framesDropped_s {
+    uint32_t count;     // since the last of these events
+    uint32_t total;     // since the log started
+} flightLogEvent_framesDropped_t;
+
 typedef struct flightLogEvent_inflightAdjustment_s {
     uint8_t adjustmentFunction;
     bool floatFlag;
@@ -137,6 +158,24 @@ typedef struct flightLogEvent_loggingResume_s {
 
 #define FLIGHT_LOG_EVENT_INFLIGHT_ADJUSTMENT_FUNCTION_FLOAT_VALUE_FLAG 128
 
+typedef enum {
+    FLIGHT_LOG_PREROLL_ARMED            = 1 << 0,
+    FLIGHT_LOG_PREROLL_RX_SIGNAL        = 1 << 1,
+    FLIGHT_LOG_PREROLL_FAILSAFE         = 1 << 2,
+    FLIGHT_LOG_PREROLL_CRASH_RECOVERY   = 1 << 3,
+    FLIGHT_LOG_PREROLL_GYRO_CALIBRATING = 1 << 4
+} flightLogPrerollFlags_e;
+
+// A compact sample of the state while the main log wasn't running, see blackbox_preroll.c
+typedef struct flightLogEvent_prerollSample_s {
+    uint32_t time;
+    uint32_t armingDisableFlags;
+    int16_t gyroADC[3];
+    int16_t rcCommand[4];
+    int16_t motor[4];
+    uint8_t flags;      // see flightLogPrerollFlags_e
+} flightLogEvent_prerollSample_t;
+
 typedef struct flightLogEvent_gtuneCycleResult_s {
     uint8_t gtuneAxis;
     int32_t gtuneGyroAVG;
@@ -146,9 +185,12 @@ typedef struct flightLogEvent_gtuneCycleResult_s {
 typedef union flightLogEventData_u {
     flightLogEvent_syncBeep_t syncBeep;
     flightLogEvent_flightMode_t flightMode; // New event data
+    flightLogEvent_loadShedding_t loadShedding;
+    flightLogEvent_framesDropped_t framesDropped;
     flightLogEvent_inflightAdjustment_t inflightAdjustment;
     flightLogEvent_loggingResume_t loggingResume;
     flightLogEvent_gtuneCycleResult_t gtuneCycleResult;
+    flightLogEvent_prerollSample_t prerollSample;
 } flightLogEventData_t;
 
 typedef struct flightLogEvent_s {
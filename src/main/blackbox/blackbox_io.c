@@ -9,6 +9,7 @@
 #ifdef BLACKBOX
 
 #include "blackbox.h"
+#include "blackbox_compress.h"
 #include "blackbox_io.h"
 
 #include "common/maths.h"
@@ -19,6 +20,7 @@
 #include "io/flashfs.h"
 #include "io/serial.h"
 
+#include "msp/msp_protocol.h"
 #include "msp/msp_serial.h"
 
 #define BLACKBOX_SERIAL_PORT_MODE MODE_TX
@@ -32,6 +34,28 @@ int32_t blackboxHeaderBudget;
 static serialPort_t *blackboxPort = NULL;
 static portSharing_e blackboxPortSharing;
 
+/*
+ * Encoded bytes are collected here and handed to the device in one write per logging iteration (or whenever the
+ * buffer fills), so the device is only chosen once per frame rather than once per byte.
+ */
+#define BLACKBOX_FRAME_BUFFER_SIZE 128
+
+static uint8_t blackboxFrameBuffer[BLACKBOX_FRAME_BUFFER_SIZE];
+static unsigned blackboxFrameBufferLength = 0;
+
+/*
+ * For BLACKBOX_DEVICE_MSP each commit of the frame buffer is pushed as one MSP_BLACKBOX_STREAM message, led by a
+ * sequence number so the receiver can tell when it missed one and has to wait for the next I frame.
+ */
+#define BLACKBOX_STREAM_PACKET_OVERHEAD (1 + 9)  // sequence number, and the MSP header and checksum
+
+static uint8_t blackboxStreamSequence;
+
+#ifdef USE_BLACKBOX_COMPRESSION
+// When set, the frame buffer goes through the compressor and the device is written a block at a time
+static bool blackboxCompressing = false;
+#endif
+
 #ifdef USE_SDCARD
 
 static struct {
@@ -63,61 +87,167 @@ void blackboxOpen()
     }
 }
 
-void blackboxWrite(uint8_t value)
+static void blackboxDeviceWrite(const uint8_t *data, unsigned length)
 {
     switch (blackboxConfig()->device) {
 #ifdef USE_FLASHFS
     case BLACKBOX_DEVICE_FLASH:
-        flashfsWriteByte(value); // Write byte asynchronously
+        flashfsWrite(data, length, false); // Write asynchronously
         break;
 #endif
 #ifdef USE_SDCARD
     case BLACKBOX_DEVICE_SDCARD:
-        afatfs_fputc(blackboxSDCard.logFile, value);
+        afatfs_fwrite(blackboxSDCard.logFile, data, length); // Ignore failures due to buffers filling up
         break;
 #endif
+    case BLACKBOX_DEVICE_MSP:
+        {
+            // Only the frame buffer is written here, storage devices are the only ones compressed
+            uint8_t packet[1 + BLACKBOX_FRAME_BUFFER_SIZE];
+            length = MIN(length, BLACKBOX_FRAME_BUFFER_SIZE);
+            packet[0] = blackboxStreamSequence++;
+            memcpy(&packet[1], data, length);
+            mspSerialPushStream(MSP_BLACKBOX_STREAM, packet, 1 + length);
+        }
+        break;
     case BLACKBOX_DEVICE_SERIAL:
     default:
-        serialWrite(blackboxPort, value);
+        if (blackboxPort) {
+            // serialWriteBuf() waits for room, so like serialWrite() drop what doesn't fit rather than stall the loop
+            serialWriteBuf(blackboxPort, data, MIN(length, serialTxBytesFree(blackboxPort)));
+        }
         break;
     }
 }
 
-// Print the null-terminated string 's' to the blackbox device and return the number of bytes written
-int blackboxPrint(const char *s)
+#ifdef USE_BLACKBOX_COMPRESSION
+/**
+ * Write out the block being compressed, if it holds anything.
+ */
+static void blackboxCompressedBlockCommit(void)
+{
+    if (!blackboxCompressorIsEmpty()) {
+        const uint8_t *block;
+        const int length = blackboxCompressorFinishBlock(&block);
+        blackboxDeviceWrite(block, length);
+    }
+}
+#endif
+
+/**
+ * Hand the bytes collected in the frame buffer to the blackbox device.
+ */
+static void blackboxFrameCommit(void)
 {
-    int length;
-    const uint8_t *pos;
+    if (blackboxFrameBufferLength == 0) {
+        return;
+    }
 
-    switch (blackboxConfig()->device) {
+#ifdef USE_BLACKBOX_COMPRESSION
+    if (blackboxCompressing) {
+        const uint8_t *data = blackboxFrameBuffer;
+        int remaining = blackboxFrameBufferLength;
+        while (remaining > 0) {
+            const int taken = blackboxCompressorAppend(data, remaining);
+            data += taken;
+            remaining -= taken;
+            if (remaining > 0) {
+                // The block is full
+                blackboxCompressedBlockCommit();
+            }
+        }
+        blackboxFrameBufferLength = 0;
+        return;
+    }
+#endif
+
+    blackboxDeviceWrite(blackboxFrameBuffer, blackboxFrameBufferLength);
+    blackboxFrameBufferLength = 0;
+}
+
+#ifdef USE_BLACKBOX_COMPRESSION
+// Only the storage devices are compressed, serial loggers keep getting the plain stream
+bool blackboxDeviceCompressionEnabled(void)
+{
+    if (!blackboxConfig()->compression) {
+        return false;
+    }
 
+    switch (blackboxConfig()->device) {
 #ifdef USE_FLASHFS
     case BLACKBOX_DEVICE_FLASH:
-        length = strlen(s);
-        flashfsWrite((const uint8_t*) s, length, false); // Write asynchronously
-        break;
-#endif // USE_FLASHFS
-
+        return true;
+#endif
 #ifdef USE_SDCARD
     case BLACKBOX_DEVICE_SDCARD:
-        length = strlen(s);
-        afatfs_fwrite(blackboxSDCard.logFile, (const uint8_t*) s, length); // Ignore failures due to buffers filling up
-        break;
-#endif // USE_SDCARD
-
-    case BLACKBOX_DEVICE_SERIAL:
+        return true;
+#endif
     default:
-        pos = (uint8_t*) s;
-        while (*pos) {
-            serialWrite(blackboxPort, *pos);
-            pos++;
-        }
+        return false;
+    }
+}
 
-        length = pos - (uint8_t*) s;
-        break;
+/**
+ * Start or stop compressing what is written from here on. Everything written before is sent to the device first.
+ */
+void blackboxDeviceSetCompression(bool enabled)
+{
+    if (enabled == blackboxCompressing) {
+        return;
     }
+    blackboxFrameCommit();
+    blackboxCompressedBlockCommit();
+    blackboxCompressing = enabled;
+}
+#endif
 
-    return length;
+void blackboxWrite(uint8_t value)
+{
+    if (blackboxFrameBufferLength == BLACKBOX_FRAME_BUFFER_SIZE) {
+        blackboxFrameCommit();
+    }
+    blackboxFrameBuffer[blackboxFrameBufferLength++] = value;
+}
+
+void blackboxWriteBuf(const uint8_t *data, int count)
+{
+    while (count > 0) {
+        if (blackboxFrameBufferLength == BLACKBOX_FRAME_BUFFER_SIZE) {
+            blackboxFrameCommit();
+        }
+        const int length = MIN(count, (int)(BLACKBOX_FRAME_BUFFER_SIZE - blackboxFrameBufferLength));
+        memcpy(&blackboxFrameBuffer[blackboxFrameBufferLength], data, length);
+        blackboxFrameBufferLength += length;
+        data += length;
+        count -= length;
+    }
+}
+
+#ifdef USE_KERNEL_BENCHMARK
+/*
+ * Lets the encoders be timed without producing any output, the bytes written after the mark are dropped by the
+ * rewind. False if less than the given bytes are free, as a write that filled the buffer would reach the device.
+ */
+bool blackboxFrameBufferMark(unsigned *mark, unsigned bytes)
+{
+    *mark = blackboxFrameBufferLength;
+    return blackboxFrameBufferLength + bytes <= BLACKBOX_FRAME_BUFFER_SIZE;
+}
+
+void blackboxFrameBufferRewind(unsigned mark)
+{
+    blackboxFrameBufferLength = mark;
+}
+#endif
+
+// Print the null-terminated string 's' to the blackbox device and return the number of bytes written
+int blackboxPrint(const char *s)
+{
+    const char *pos = s;
+    while (*pos) {
+        blackboxWrite(*pos++);
+    }
+    return pos - s;
 }
 
 /**
@@ -127,6 +257,8 @@ int blackboxPrint(const char *s)
  */
 void blackboxDeviceFlush(void)
 {
+    blackboxFrameCommit();
+
     switch (blackboxConfig()->device) {
 #ifdef USE_FLASHFS
         /*
@@ -134,7 +266,8 @@ void blackboxDeviceFlush(void)
          * devices will progressively write in the background without Blackbox calling anything.
          */
     case BLACKBOX_DEVICE_FLASH:
-        flashfsFlushAsync();
+        // Only whole pages, so each page is programmed in one go
+        flashfsFlushAsync(false);
         break;
 #endif // USE_FLASHFS
 
@@ -150,14 +283,23 @@ void blackboxDeviceFlush(void)
  */
 bool blackboxDeviceFlushForce(void)
 {
+    blackboxFrameCommit();
+#ifdef USE_BLACKBOX_COMPRESSION
+    blackboxCompressedBlockCommit();
+#endif
+
     switch (blackboxConfig()->device) {
     case BLACKBOX_DEVICE_SERIAL:
         // Nothing to speed up flushing on serial, as serial is continuously being drained out of its buffer
         return isSerialTransmitBufferEmpty(blackboxPort);
 
+    case BLACKBOX_DEVICE_MSP:
+        // Everything has been pushed to the ports that had room for it
+        return true;
+
 #ifdef USE_FLASHFS
     case BLACKBOX_DEVICE_FLASH:
-        return flashfsFlushAsync();
+        return flashfsFlushAsync(true);
 #endif // USE_FLASHFS
 
 #ifdef USE_SDCARD
@@ -178,12 +320,22 @@ bool blackboxDeviceFlushForce(void)
  */
 bool blackboxDeviceOpen(void)
 {
+    blackboxFrameBufferLength = 0;
+#ifdef USE_BLACKBOX_COMPRESSION
+    blackboxCompressing = false;
+    blackboxCompressorReset();
+#endif
+
     switch (blackboxConfig()->device) {
     case BLACKBOX_DEVICE_SERIAL:
         {
             serialPortConfig_t *portConfig = findSerialPortConfig(FUNCTION_BLACKBOX);
             baudRate_e baudRateIndex;
             portOptions_t portOptions = SERIAL_PARITY_NO | SERIAL_NOT_INVERTED;
+#ifdef USE_UART_CTS
+            // Loggers that can't always keep up, such as while their card is busy, can hold us with CTS
+            portOptions |= SERIAL_CTS;
+#endif
 
             if (!portConfig) {
                 return false;
@@ -237,6 +389,9 @@ bool blackboxDeviceOpen(void)
             return blackboxPort != NULL;
         }
         break;
+    case BLACKBOX_DEVICE_MSP:
+        blackboxStreamSequence = 0;
+        return true;
 #ifdef USE_FLASHFS
     case BLACKBOX_DEVICE_FLASH:
         if (flashfsGetSize() == 0 || isBlackboxDeviceFull()) {
@@ -302,6 +457,12 @@ bool isBlackboxErased(void)
  */
 void blackboxDeviceClose(void)
 {
+    blackboxFrameBufferLength = 0;
+#ifdef USE_BLACKBOX_COMPRESSION
+    blackboxCompressing = false;
+    blackboxCompressorReset();
+#endif
+
     switch (blackboxConfig()->device) {
     case BLACKBOX_DEVICE_SERIAL:
         // Since the serial port could be shared with other processes, we have to give it back here
@@ -364,7 +525,7 @@ static void blackboxCreateLogFile()
 
     blackboxSDCard.state = BLACKBOX_SDCARD_WAITING;
 
-    afatfs_fopen(filename, "as", blackboxLogFileCreated);
+    afatfs_fopen(filename, "ap", blackboxLogFileCreated);
 }
 
 /**
@@ -470,6 +631,11 @@ bool blackboxDeviceEndLog(bool retainLog)
     UNUSED(retainLog);
 #endif
 
+    blackboxFrameCommit();
+#ifdef USE_BLACKBOX_COMPRESSION
+    blackboxCompressedBlockCommit();
+#endif
+
     switch (blackboxConfig()->device) {
 #ifdef USE_SDCARD
     case BLACKBOX_DEVICE_SDCARD:
@@ -527,10 +693,18 @@ void blackboxReplenishHeaderBudget()
 {
     int32_t freeSpace;
 
+    // the budget is for the device buffers, so the bytes still held here have to go out first
+    blackboxFrameCommit();
+
     switch (blackboxConfig()->device) {
     case BLACKBOX_DEVICE_SERIAL:
         freeSpace = serialTxBytesFree(blackboxPort);
         break;
+    case BLACKBOX_DEVICE_MSP:
+        // Leave room for the overhead of each message the budget could be split into
+        freeSpace = MAX((int32_t)mspSerialStreamTxBytesFree()
+            - BLACKBOX_STREAM_PACKET_OVERHEAD * (BLACKBOX_MAX_ACCUMULATED_HEADER_BUDGET / BLACKBOX_FRAME_BUFFER_SIZE + 1), 0);
+        break;
 #ifdef USE_FLASHFS
     case BLACKBOX_DEVICE_FLASH:
         freeSpace = flashfsGetWriteBufferFreeSpace();
@@ -544,7 +718,81 @@ void blackboxReplenishHeaderBudget()
     default:
         freeSpace = 0;
     }
-    blackboxHeaderBudget = MIN(MIN(freeSpace, blackboxHeaderBudget + blackboxMaxHeaderBytesPerIteration), BLACKBOX_MAX_ACCUMULATED_HEADER_BUDGET);
+
+    if (blackboxDeviceAcceptsBursts()) {
+        // Nothing downstream needs the rate limited, so whatever fits in the device buffer can go now
+        blackboxHeaderBudget = MIN(freeSpace, BLACKBOX_MAX_ACCUMULATED_HEADER_BUDGET);
+    } else {
+        blackboxHeaderBudget = MIN(MIN(freeSpace, blackboxHeaderBudget + blackboxMaxHeaderBytesPerIteration), BLACKBOX_MAX_ACCUMULATED_HEADER_BUDGET);
+    }
+}
+
+/**
+ * Flash and SD card take whole pages and sectors at a time, unlike a serial logger such as the OpenLog, which has to be
+ * fed at a steady rate. So their header doesn't need to be trickled out, nor does the header streamed over MSP.
+ */
+bool blackboxDeviceAcceptsBursts(void)
+{
+    switch (blackboxConfig()->device) {
+    case BLACKBOX_DEVICE_MSP:
+        return true;
+#ifdef USE_FLASHFS
+    case BLACKBOX_DEVICE_FLASH:
+        return true;
+#endif
+#ifdef USE_SDCARD
+    case BLACKBOX_DEVICE_SDCARD:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+/**
+ * Returns true once the header written so far can no longer be lost to the log frames that follow it, so logging
+ * can begin.
+ */
+bool blackboxDeviceHeaderDelivered(void)
+{
+    switch (blackboxConfig()->device) {
+#ifdef USE_SDCARD
+    case BLACKBOX_DEVICE_SDCARD:
+        /*
+         * The header is held in the sector cache, and frames that don't fit are refused rather than overwriting it, so
+         * there is no need to wait for the card to write it.
+         */
+        blackboxFrameCommit();
+        return true;
+#endif
+    default:
+        //Overflowing the serial or flash buffers loses data, so wait for them to drain
+        return blackboxDeviceFlushForce();
+    }
+}
+
+/**
+ * Call before writing each main frame. Returns false if the frame should be dropped because the device may not have
+ * room for all of it, which would otherwise be truncated and leave the rest of the log undecodable.
+ *
+ * Only a serial logger or the MSP stream can't take a frame, when it can't keep up with the log rate or a logger holds
+ * CTS while its card is busy. The largest frames are I frames, which fit in the frame buffer for all but the largest
+ * sets of fields.
+ */
+bool blackboxDeviceReserveFrameSpace(void)
+{
+    switch (blackboxConfig()->device) {
+    case BLACKBOX_DEVICE_SERIAL:
+        // The bytes held here go out first, so the frame only has to fit in what's left after them
+        blackboxFrameCommit();
+        return blackboxPort && serialTxBytesFree(blackboxPort) >= BLACKBOX_FRAME_BUFFER_SIZE;
+    case BLACKBOX_DEVICE_MSP:
+        // Frames are kept whole in the messages, so a receiver that misses one loses whole frames
+        blackboxFrameCommit();
+        return mspSerialStreamTxBytesFree() >= BLACKBOX_STREAM_PACKET_OVERHEAD + BLACKBOX_FRAME_BUFFER_SIZE;
+    default:
+        return true;
+    }
 }
 
 /**
@@ -578,7 +826,7 @@ blackboxBufferReserveStatus_e blackboxDeviceReserveBufferSpace(int32_t bytes)
          * One byte of the tx buffer isn't available for user data (due to its circular list implementation),
          * hence the -1. Note that the USB VCP implementation doesn't use a buffer and has txBufferSize set to zero.
          */
-        if (blackboxPort->txBufferSize && bytes > (int32_t) blackboxPort->txBufferSize - 1) {
+        if (blackboxPort->txBuffer.size && bytes > (int32_t) blackboxPort->txBuffer.size - 1) {
             return BLACKBOX_RESERVE_PERMANENT_FAILURE;
         }
         return BLACKBOX_RESERVE_TEMPORARY_FAILURE;
@@ -595,7 +843,7 @@ blackboxBufferReserveStatus_e blackboxDeviceReserveBufferSpace(int32_t bytes)
              * that the Blackbox header writing code doesn't have to guess about the best time to ask flashfs to
              * flush, and doesn't stall waiting for a flush that would otherwise not automatically be called.
              */
-            flashfsFlushAsync();
+            flashfsFlushAsync(true);
         }
         return BLACKBOX_RESERVE_TEMPORARY_FAILURE;
 #endif // USE_FLASHFS
@@ -39,11 +39,18 @@ extern int32_t blackboxHeaderBudget;
 
 void blackboxOpen(void);
 void blackboxWrite(uint8_t value);
+void blackboxWriteBuf(const uint8_t *data, int count);
+#ifdef USE_KERNEL_BENCHMARK
+bool blackboxFrameBufferMark(unsigned *mark, unsigned bytes);
+void blackboxFrameBufferRewind(unsigned mark);
+#endif
 
 void blackboxDeviceFlush(void);
 bool blackboxDeviceFlushForce(void);
 bool blackboxDeviceOpen(void);
 void blackboxDeviceClose(void);
+bool blackboxDeviceCompressionEnabled(void);
+void blackboxDeviceSetCompression(bool enabled);
 
 void blackboxEraseAll(void);
 bool isBlackboxErased(void);
@@ -55,4 +62,7 @@ bool isBlackboxDeviceFull(void);
 unsigned int blackboxGetLogNumber();
 
 void blackboxReplenishHeaderBudget();
+bool blackboxDeviceAcceptsBursts(void);
+bool blackboxDeviceHeaderDelivered(void);
+bool blackboxDeviceReserveFrameSpace(void);
 blackboxBufferReserveStatus_e blackboxDeviceReserveBufferSpace(int32_t bytes);
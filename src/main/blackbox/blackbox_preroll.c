@@ -0,0 +1,153 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "platform.h"
+
+#ifdef USE_BLACKBOX_PREROLL
+
+#include "blackbox/blackbox_preroll.h"
+
+#include "common/axis.h"
+#include "common/maths.h"
+
+#include "fc/rc_controls.h"
+#include "fc/runtime_config.h"
+
+#include "flight/failsafe.h"
+#include "flight/mixer.h"
+#include "flight/pid.h"
+
+#include "rx/rx.h"
+
+#include "sensors/gyro.h"
+
+/*
+ * Pre-roll: while the main log isn't running (disarmed, sending the header, or paused with the blackbox mode switch)
+ * a compact sample of the state is kept in a ring holding the last few seconds. It is written into the log, as
+ * events alongside the normal stream, when logging starts on arming and when a failsafe or crash recovery begins
+ * while the log is paused.
+ *
+ * The samples are taken from the PID loop, which may run in the gyro interrupt, and written from the blackbox task.
+ * So rather than sharing the ring, taking samples stops while it is being written out.
+ */
+
+static flightLogEvent_prerollSample_t prerollSamples[BLACKBOX_PREROLL_SAMPLE_COUNT];
+static uint16_t prerollHead;            // next sample to be taken
+static uint16_t prerollCount;
+static volatile bool prerollDumping;
+static uint16_t prerollDumpRemaining;
+
+static timeDelta_t prerollIntervalUs;   // 0 when pre-roll is off
+static timeUs_t prerollLastSampleUs;
+
+static bool prerollTriggerActive;
+
+void blackboxPrerollInit(uint8_t seconds)
+{
+    seconds = MIN(seconds, BLACKBOX_PREROLL_MAX_SECONDS);
+    prerollIntervalUs = seconds * 1000000 / BLACKBOX_PREROLL_SAMPLE_COUNT;
+    prerollHead = 0;
+    prerollCount = 0;
+    prerollDumping = false;
+    prerollDumpRemaining = 0;
+    prerollLastSampleUs = 0;
+}
+
+// Call from the PID loop while the main log isn't capturing
+void blackboxPrerollCapture(timeUs_t currentTimeUs)
+{
+    if (!prerollIntervalUs || prerollDumping || cmpTimeUs(currentTimeUs, prerollLastSampleUs) < prerollIntervalUs) {
+        return;
+    }
+    prerollLastSampleUs = currentTimeUs;
+
+    flightLogEvent_prerollSample_t *sample = &prerollSamples[prerollHead];
+    sample->time = currentTimeUs;
+    sample->armingDisableFlags = getArmingDisableFlags();
+    for (int i = 0; i < XYZ_AXIS_COUNT; i++) {
+        sample->gyroADC[i] = lrintf(gyro.gyroADCf[i]);
+    }
+    for (int i = 0; i < 4; i++) {
+        sample->rcCommand[i] = lrintf(rcCommand[i]);
+    }
+    const int motorCount = MIN(getMotorCount(), 4);
+    for (int i = 0; i < 4; i++) {
+        sample->motor[i] = i < motorCount ? lrintf(motor[i]) : 0;
+    }
+    sample->flags = (ARMING_FLAG(ARMED) ? FLIGHT_LOG_PREROLL_ARMED : 0)
+        | (rxIsReceivingSignal() ? FLIGHT_LOG_PREROLL_RX_SIGNAL : 0)
+        | (failsafeIsActive() ? FLIGHT_LOG_PREROLL_FAILSAFE : 0)
+        | (pidCrashRecoveryActive() ? FLIGHT_LOG_PREROLL_CRASH_RECOVERY : 0)
+        | (isGyroCalibrationComplete() ? 0 : FLIGHT_LOG_PREROLL_GYRO_CALIBRATING);
+
+    prerollHead = (prerollHead + 1) % BLACKBOX_PREROLL_SAMPLE_COUNT;
+    if (prerollCount < BLACKBOX_PREROLL_SAMPLE_COUNT) {
+        prerollCount++;
+    }
+}
+
+/**
+ * Write out the samples taken so far, oldest first, with blackboxPrerollNextDumpSample(). Does nothing if a dump is
+ * already in progress or there is nothing to write.
+ */
+void blackboxPrerollStartDump(void)
+{
+    if (prerollDumping || prerollCount == 0) {
+        return;
+    }
+    prerollDumpRemaining = prerollCount;
+    prerollDumping = true;
+    __atomic_signal_fence(__ATOMIC_SEQ_CST);
+}
+
+// Starts a dump when a failsafe or a crash recovery begins
+void blackboxPrerollCheckTriggers(void)
+{
+    const bool triggerActive = failsafeIsActive() || pidCrashRecoveryActive();
+    if (triggerActive && !prerollTriggerActive) {
+        blackboxPrerollStartDump();
+    }
+    prerollTriggerActive = triggerActive;
+}
+
+/**
+ * Returns the next sample of the dump in progress, or NULL if there is none. The sample is only valid until the next
+ * call. The ring is empty once the dump is finished, and taking samples resumes.
+ */
+const flightLogEvent_prerollSample_t *blackboxPrerollNextDumpSample(void)
+{
+    if (!prerollDumping) {
+        return NULL;
+    }
+    if (prerollDumpRemaining == 0) {
+        prerollCount = 0;
+        __atomic_signal_fence(__ATOMIC_SEQ_CST);
+        prerollDumping = false;
+        return NULL;
+    }
+
+    const int index = (prerollHead + BLACKBOX_PREROLL_SAMPLE_COUNT - prerollDumpRemaining) % BLACKBOX_PREROLL_SAMPLE_COUNT;
+    prerollDumpRemaining--;
+    return &prerollSamples[index];
+}
+
+#endif
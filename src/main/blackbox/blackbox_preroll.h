@@ -0,0 +1,31 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "blackbox/blackbox_fielddefs.h"
+
+#include "common/time.h"
+
+#define BLACKBOX_PREROLL_SAMPLE_COUNT 256
+#define BLACKBOX_PREROLL_MAX_SECONDS 10
+
+void blackboxPrerollInit(uint8_t seconds);
+void blackboxPrerollCapture(timeUs_t currentTimeUs);
+void blackboxPrerollCheckTriggers(void);
+void blackboxPrerollStartDump(void);
+const flightLogEvent_prerollSample_t *blackboxPrerollNextDumpSample(void);
@@ -17,11 +17,17 @@
 
 #include "stdint.h"
 
+#include "common/utils.h"
 
 #include "debug.h"
 
-int16_t debug[DEBUG16_VALUE_COUNT];
-uint8_t debugMode;
+STATIC_ASSERT(DEBUG_COUNT <= 32, too_many_debug_modes_for_mask);
+
+int32_t debug[DEBUG_VALUE_COUNT];
+uint32_t debugModeMask;
+uint8_t debugModeOffset[DEBUG_COUNT];
+
+static uint8_t debugSlotMode[DEBUG_MODE_SLOT_COUNT];
 
 #ifdef DEBUG_SECTION_TIMES
 uint32_t sectionTimes[2][4];
@@ -49,5 +55,44 @@ const char * const debugModeNames[DEBUG_COUNT] = {
     "ALTITUDE",
     "FFT",
     "FFT_TIME",
-    "FFT_FREQ"
+    "FFT_FREQ",
+    "CYCLE_TRACE",
+    "LOAD_SHEDDING",
+    "DUAL_GYRO",
+    "RPM_FILTER",
+    "MOTOR_LATENCY",
+    "RX_DUAL",
+    "RX_LQ"
 };
+
+/*
+ * Gives each of the modes, in order, the next free bank of channels. NONE, repeats and the modes
+ * that do not fit any more are left out.
+ */
+void debugInit(const uint8_t *modes, int count)
+{
+    debugModeMask = 0;
+    for (int i = 0; i < DEBUG_MODE_SLOT_COUNT; i++) {
+        debugSlotMode[i] = DEBUG_NONE;
+    }
+    for (int i = 0; i < DEBUG_VALUE_COUNT; i++) {
+        debug[i] = 0;
+    }
+
+    int slot = 0;
+    for (int i = 0; i < count && slot < DEBUG_MODE_SLOT_COUNT; i++) {
+        const uint8_t mode = modes[i];
+        if (mode == DEBUG_NONE || mode >= DEBUG_COUNT || (debugModeMask & (1U << mode))) {
+            continue;
+        }
+        debugModeOffset[mode] = slot * DEBUG_MODE_VALUE_COUNT;
+        debugSlotMode[slot++] = mode;
+        debugModeMask |= 1U << mode;
+    }
+}
+
+// The mode logged in a bank of channels, NONE for an unused bank
+debugType_e debugModeForSlot(int slot)
+{
+    return (slot >= 0 && slot < DEBUG_MODE_SLOT_COUNT) ? debugSlotMode[slot] : DEBUG_NONE;
+}
@@ -17,33 +17,7 @@
 
 #pragma once
 
-#define DEBUG16_VALUE_COUNT 4
-extern int16_t debug[DEBUG16_VALUE_COUNT];
-extern uint8_t debugMode;
-
-#define DEBUG_SET(mode, index, value) {if (debugMode == (mode)) {debug[(index)] = (value);}}
-
-#define DEBUG_SECTION_TIMES
-
-#ifdef DEBUG_SECTION_TIMES
-extern uint32_t sectionTimes[2][4];
-
-#define TIME_SECTION_BEGIN(index) { \
-    extern uint32_t sectionTimes[2][4]; \
-    sectionTimes[0][index] = micros(); \
-}
-
-#define TIME_SECTION_END(index) { \
-    extern uint32_t sectionTimes[2][4]; \
-    sectionTimes[1][index] = micros(); \
-    debug[index] = sectionTimes[1][index] - sectionTimes[0][index]; \
-}
-#else
-
-#define TIME_SECTION_BEGIN(index) {}
-#define TIME_SECTION_END(index) {}
-
-#endif
+#include <stdint.h>
 
 typedef enum {
     DEBUG_NONE,
@@ -68,7 +42,71 @@ typedef enum {
     DEBUG_FFT,
     DEBUG_FFT_TIME,
     DEBUG_FFT_FREQ,
+    DEBUG_CYCLE_TRACE,
+    DEBUG_LOAD_SHEDDING,
+    DEBUG_DUAL_GYRO,
+    DEBUG_RPM_FILTER,
+    DEBUG_MOTOR_LATENCY,
+    DEBUG_RX_DUAL,
+    DEBUG_RX_LQ,
     DEBUG_COUNT
 } debugType_e;
 
 extern const char * const debugModeNames[DEBUG_COUNT];
+
+/*
+ * Debug values are 32 bit channels, logged to blackbox. Each active debug mode owns a bank of
+ * DEBUG_MODE_VALUE_COUNT of them, in the order the modes are configured, so as many modes as there
+ * are banks are logged at the same time.
+ */
+#ifndef DEBUG_VALUE_COUNT
+#if defined(STM32F7)
+#define DEBUG_VALUE_COUNT       16
+#else
+#define DEBUG_VALUE_COUNT       8
+#endif
+#endif
+#define DEBUG_MODE_VALUE_COUNT  4
+#define DEBUG_MODE_SLOT_COUNT   (DEBUG_VALUE_COUNT / DEBUG_MODE_VALUE_COUNT)
+
+#if DEBUG_VALUE_COUNT < 8 || DEBUG_VALUE_COUNT > 16 || DEBUG_VALUE_COUNT % DEBUG_MODE_VALUE_COUNT
+#error "DEBUG_VALUE_COUNT must be 8, 12 or 16"
+#endif
+
+// Modes with their probes compiled in, the probes of the others compile to nothing
+#ifndef DEBUG_MODES_COMPILED
+#define DEBUG_MODES_COMPILED    0xFFFFFFFF
+#endif
+
+extern int32_t debug[DEBUG_VALUE_COUNT];
+extern uint32_t debugModeMask;                  // bit per active mode
+extern uint8_t debugModeOffset[DEBUG_COUNT];    // first channel of the bank of an active mode
+
+#define DEBUG_MODE_IS_ACTIVE(mode) ((DEBUG_MODES_COMPILED & debugModeMask & (1U << (mode))) != 0)
+
+#define DEBUG_SET(mode, index, value) {if (DEBUG_MODE_IS_ACTIVE(mode)) {debug[debugModeOffset[(mode)] + (index)] = (value);}}
+
+void debugInit(const uint8_t *modes, int count);
+debugType_e debugModeForSlot(int slot);
+
+#define DEBUG_SECTION_TIMES
+
+#ifdef DEBUG_SECTION_TIMES
+extern uint32_t sectionTimes[2][4];
+
+#define TIME_SECTION_BEGIN(index) { \
+    extern uint32_t sectionTimes[2][4]; \
+    sectionTimes[0][index] = micros(); \
+}
+
+#define TIME_SECTION_END(index) { \
+    extern uint32_t sectionTimes[2][4]; \
+    sectionTimes[1][index] = micros(); \
+    debug[index] = sectionTimes[1][index] - sectionTimes[0][index]; \
+}
+#else
+
+#define TIME_SECTION_BEGIN(index) {}
+#define TIME_SECTION_END(index) {}
+
+#endif
@@ -0,0 +1,98 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "platform.h"
+
+#ifdef USE_CYCLE_TRACE
+
+#include "build/debug.h"
+#include "build/trace.h"
+
+#include "common/maths.h"
+
+#include "drivers/system.h"
+
+static traceEvent_t traceBuffer[TRACE_BUFFER_SIZE];
+static uint32_t traceHead;      // number of events recorded since boot, only accessed atomically
+static uint32_t traceTail;      // number of events consumed, owned by the reader
+static uint32_t traceBeginCycles[TRACE_POINT_COUNT];
+
+// CYCLE_TRACE debug value the duration of a point is written to, so it gets logged by blackbox
+static const int8_t traceDebugIndex[TRACE_POINT_COUNT] = {
+    [TRACE_SCHEDULER] = -1,
+    [TRACE_GYRO_READ] = 0,
+    [TRACE_GYRO_ANALYSE] = -1,
+    [TRACE_GYRO_FILTER_DYN_NOTCH] = -1,
+    [TRACE_GYRO_FILTER_NOTCH] = -1,
+    [TRACE_GYRO_FILTER_LPF] = -1,
+    [TRACE_PID] = 1,
+    [TRACE_MIXER] = 2,
+    [TRACE_MOTOR_WRITE] = 3,
+    [TRACE_GYRO_FILTER_RPM] = -1,
+    [TRACE_RX_TO_SETPOINT] = -1,
+};
+
+static void traceRecordAt(uint8_t point, uint32_t cycles)
+{
+    // trace points are hit from both task and interrupt context, so claim the slot atomically
+    const uint32_t slot = __atomic_fetch_add(&traceHead, 1, __ATOMIC_RELAXED) & (TRACE_BUFFER_SIZE - 1);
+    traceBuffer[slot].cycles = cycles;
+    traceBuffer[slot].point = point;
+
+    const uint8_t id = point & ~TRACE_EVENT_END;
+    if (point & TRACE_EVENT_END) {
+        if (traceDebugIndex[id] >= 0) {
+            DEBUG_SET(DEBUG_CYCLE_TRACE, traceDebugIndex[id], MIN(cycles - traceBeginCycles[id], INT32_MAX));
+        }
+    } else {
+        traceBeginCycles[id] = cycles;
+    }
+}
+
+void traceRecord(uint8_t point)
+{
+    traceRecordAt(point, getCycleCounter());
+}
+
+void traceRecordSpan(uint8_t point, uint32_t beginCycles)
+{
+    const uint32_t endCycles = getCycleCounter();
+    traceRecordAt(point | TRACE_EVENT_BEGIN, beginCycles);
+    traceRecordAt(point | TRACE_EVENT_END, endCycles);
+}
+
+// Copies up to maxCount of the oldest unread events, lostCount is set to the number of events overwritten before they were read
+int traceRead(traceEvent_t *events, int maxCount, uint32_t *lostCount)
+{
+    const uint32_t head = __atomic_load_n(&traceHead, __ATOMIC_ACQUIRE);
+
+    *lostCount = 0;
+    if (head - traceTail > TRACE_BUFFER_SIZE) {
+        *lostCount = head - traceTail - TRACE_BUFFER_SIZE;
+        traceTail = head - TRACE_BUFFER_SIZE;
+    }
+
+    int count = 0;
+    while (traceTail != head && count < maxCount) {
+        events[count++] = traceBuffer[traceTail++ & (TRACE_BUFFER_SIZE - 1)];
+    }
+    return count;
+}
+#endif
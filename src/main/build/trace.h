@@ -0,0 +1,75 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "build/debug.h"
+
+/*
+ * Cycle accurate tracing of the flight control hot path.
+ *
+ * Trace points stamp the DWT cycle counter into a ring buffer when debug_mode is CYCLE_TRACE. The ring
+ * buffer is overwritten when full, so the consumer always sees the most recent events. It is drained over
+ * MSP (MSP_CYCLE_TRACE), and the duration of a few points is also written to debug[] for blackbox.
+ */
+
+typedef enum {
+    TRACE_SCHEDULER = 0,
+    TRACE_GYRO_READ,
+    TRACE_GYRO_ANALYSE,
+    TRACE_GYRO_FILTER_DYN_NOTCH,
+    TRACE_GYRO_FILTER_NOTCH,
+    TRACE_GYRO_FILTER_LPF,
+    TRACE_PID,
+    TRACE_MIXER,
+    TRACE_MOTOR_WRITE,
+    TRACE_GYRO_FILTER_RPM,
+    TRACE_RX_TO_SETPOINT,           // from the receive interrupt that completed a frame to its setpoint
+    TRACE_POINT_COUNT
+} tracePoint_e;
+
+#define TRACE_EVENT_BEGIN   0x00
+#define TRACE_EVENT_END     0x80    // or'd into the point id
+
+typedef struct traceEvent_s {
+    uint32_t cycles;                // cycle counter when the point was reached
+    uint8_t point;                  // tracePoint_e, with TRACE_EVENT_END set at the end of the section
+} traceEvent_t;
+
+#define TRACE_BUFFER_SIZE 256       // must be a power of 2
+
+#ifdef USE_CYCLE_TRACE
+
+void traceRecord(uint8_t point);
+void traceRecordSpan(uint8_t point, uint32_t beginCycles);
+
+#define TRACE_BEGIN(point) {if (DEBUG_MODE_IS_ACTIVE(DEBUG_CYCLE_TRACE)) {traceRecord((point) | TRACE_EVENT_BEGIN);}}
+#define TRACE_END(point) {if (DEBUG_MODE_IS_ACTIVE(DEBUG_CYCLE_TRACE)) {traceRecord((point) | TRACE_EVENT_END);}}
+// records a section that began at a cycle count taken earlier, for points that are only worth logging in hindsight
+#define TRACE_SPAN(point, beginCycles) {if (DEBUG_MODE_IS_ACTIVE(DEBUG_CYCLE_TRACE)) {traceRecordSpan((point), (beginCycles));}}
+
+int traceRead(traceEvent_t *events, int maxCount, uint32_t *lostCount);
+
+#else
+
+#define TRACE_BEGIN(point) {}
+#define TRACE_END(point) {}
+#define TRACE_SPAN(point, beginCycles) {}
+
+#endif
@@ -259,6 +259,35 @@ static void cmsPadToSize(char *buf, int size)
     buf[size] = 0;
 }
 
+// The value text last written on each screen row. Polled entries are formatted again on every poll,
+// but only written to the display when their text changed.
+#define CMS_VALUE_CACHE_ROWS 16
+#define CMS_VALUE_CACHE_LEN  16
+
+typedef struct cmsValueCache_s {
+    uint8_t col;
+    char text[CMS_VALUE_CACHE_LEN];
+} cmsValueCache_t;
+
+static cmsValueCache_t cmsValueCache[CMS_VALUE_CACHE_ROWS];
+
+static int cmsDrawValue(displayPort_t *pDisplay, uint8_t col, uint8_t row, const char *text)
+{
+    if (row < CMS_VALUE_CACHE_ROWS) {
+        cmsValueCache_t *cache = &cmsValueCache[row];
+        if (cache->col == col && strcmp(cache->text, text) == 0) {
+            return 0;
+        }
+        if (strlen(text) < CMS_VALUE_CACHE_LEN) {
+            cache->col = col;
+            strcpy(cache->text, text);
+        } else {
+            cache->text[0] = 0;
+        }
+    }
+    return displayWrite(pDisplay, col, row, text);
+}
+
 static int cmsDrawMenuEntry(displayPort_t *pDisplay, OSD_Entry *p, uint8_t row)
 {
     #define CMS_DRAW_BUFFER_LEN 10
@@ -268,7 +297,7 @@ static int cmsDrawMenuEntry(displayPort_t *pDisplay, OSD_Entry *p, uint8_t row)
     switch (p->type) {
     case OME_String:
         if (IS_PRINTVALUE(p) && p->data) {
-            cnt = displayWrite(pDisplay, RIGHT_MENU_COLUMN(pDisplay), row, p->data);
+            cnt = cmsDrawValue(pDisplay, RIGHT_MENU_COLUMN(pDisplay), row, p->data);
             CLR_PRINTVALUE(p);
         }
         break;
@@ -284,11 +313,11 @@ static int cmsDrawMenuEntry(displayPort_t *pDisplay, OSD_Entry *p, uint8_t row)
                 // Special case of sub menu entry with optional value display.
 
                 char *str = ((CMSMenuOptFuncPtr)p->func)();
-                cnt = displayWrite(pDisplay, colPos, row, str);
+                cnt = cmsDrawValue(pDisplay, colPos, row, str);
                 colPos += strlen(str);
             }
 
-            cnt += displayWrite(pDisplay, colPos, row, ">");
+            cnt += cmsDrawValue(pDisplay, colPos, row, ">");
 
             CLR_PRINTVALUE(p);
         }
@@ -297,9 +326,9 @@ static int cmsDrawMenuEntry(displayPort_t *pDisplay, OSD_Entry *p, uint8_t row)
     case OME_Bool:
         if (IS_PRINTVALUE(p) && p->data) {
             if (*((uint8_t *)(p->data))) {
-                cnt = displayWrite(pDisplay, RIGHT_MENU_COLUMN(pDisplay), row, "YES");
+                cnt = cmsDrawValue(pDisplay, RIGHT_MENU_COLUMN(pDisplay), row, "YES");
             } else {
-                cnt = displayWrite(pDisplay, RIGHT_MENU_COLUMN(pDisplay), row, "NO ");
+                cnt = cmsDrawValue(pDisplay, RIGHT_MENU_COLUMN(pDisplay), row, "NO ");
             }
             CLR_PRINTVALUE(p);
         }
@@ -311,7 +340,7 @@ static int cmsDrawMenuEntry(displayPort_t *pDisplay, OSD_Entry *p, uint8_t row)
             char * str = (char *)ptr->names[*ptr->val];
             memcpy(buff, str, MAX(CMS_DRAW_BUFFER_LEN, strlen(str)));
             cmsPadToSize(buff, CMS_DRAW_BUFFER_LEN);
-            cnt = displayWrite(pDisplay, RIGHT_MENU_COLUMN(pDisplay), row, buff);
+            cnt = cmsDrawValue(pDisplay, RIGHT_MENU_COLUMN(pDisplay), row, buff);
             CLR_PRINTVALUE(p);
         }
         break;
@@ -322,9 +351,9 @@ static int cmsDrawMenuEntry(displayPort_t *pDisplay, OSD_Entry *p, uint8_t row)
             uint16_t *val = (uint16_t *)p->data;
 
             if (VISIBLE(*val)) {
-                cnt = displayWrite(pDisplay, RIGHT_MENU_COLUMN(pDisplay), row, "YES");
+                cnt = cmsDrawValue(pDisplay, RIGHT_MENU_COLUMN(pDisplay), row, "YES");
             } else {
-                cnt = displayWrite(pDisplay, RIGHT_MENU_COLUMN(pDisplay), row, "NO ");
+                cnt = cmsDrawValue(pDisplay, RIGHT_MENU_COLUMN(pDisplay), row, "NO ");
             }
             CLR_PRINTVALUE(p);
         }
@@ -336,7 +365,7 @@ static int cmsDrawMenuEntry(displayPort_t *pDisplay, OSD_Entry *p, uint8_t row)
             OSD_UINT8_t *ptr = p->data;
             itoa(*ptr->val, buff, 10);
             cmsPadToSize(buff, 5);
-            cnt = displayWrite(pDisplay, RIGHT_MENU_COLUMN(pDisplay), row, buff);
+            cnt = cmsDrawValue(pDisplay, RIGHT_MENU_COLUMN(pDisplay), row, buff);
             CLR_PRINTVALUE(p);
         }
         break;
@@ -346,7 +375,7 @@ static int cmsDrawMenuEntry(displayPort_t *pDisplay, OSD_Entry *p, uint8_t row)
             OSD_INT8_t *ptr = p->data;
             itoa(*ptr->val, buff, 10);
             cmsPadToSize(buff, 5);
-            cnt = displayWrite(pDisplay, RIGHT_MENU_COLUMN(pDisplay), row, buff);
+            cnt = cmsDrawValue(pDisplay, RIGHT_MENU_COLUMN(pDisplay), row, buff);
             CLR_PRINTVALUE(p);
         }
         break;
@@ -356,7 +385,7 @@ static int cmsDrawMenuEntry(displayPort_t *pDisplay, OSD_Entry *p, uint8_t row)
             OSD_UINT16_t *ptr = p->data;
             itoa(*ptr->val, buff, 10);
             cmsPadToSize(buff, 5);
-            cnt = displayWrite(pDisplay, RIGHT_MENU_COLUMN(pDisplay), row, buff);
+            cnt = cmsDrawValue(pDisplay, RIGHT_MENU_COLUMN(pDisplay), row, buff);
             CLR_PRINTVALUE(p);
         }
         break;
@@ -366,7 +395,7 @@ static int cmsDrawMenuEntry(displayPort_t *pDisplay, OSD_Entry *p, uint8_t row)
             OSD_UINT16_t *ptr = p->data;
             itoa(*ptr->val, buff, 10);
             cmsPadToSize(buff, 5);
-            cnt = displayWrite(pDisplay, RIGHT_MENU_COLUMN(pDisplay), row, buff);
+            cnt = cmsDrawValue(pDisplay, RIGHT_MENU_COLUMN(pDisplay), row, buff);
             CLR_PRINTVALUE(p);
         }
         break;
@@ -376,7 +405,7 @@ static int cmsDrawMenuEntry(displayPort_t *pDisplay, OSD_Entry *p, uint8_t row)
             OSD_FLOAT_t *ptr = p->data;
             cmsFormatFloat(*ptr->val * ptr->multipler, buff);
             cmsPadToSize(buff, 5);
-            cnt = displayWrite(pDisplay, RIGHT_MENU_COLUMN(pDisplay) - 1, row, buff); // XXX One char left ???
+            cnt = cmsDrawValue(pDisplay, RIGHT_MENU_COLUMN(pDisplay) - 1, row, buff); // XXX One char left ???
             CLR_PRINTVALUE(p);
         }
         break;
@@ -384,7 +413,7 @@ static int cmsDrawMenuEntry(displayPort_t *pDisplay, OSD_Entry *p, uint8_t row)
     case OME_Label:
         if (IS_PRINTVALUE(p) && p->data) {
             // A label with optional string, immediately following text
-            cnt = displayWrite(pDisplay, LEFT_MENU_COLUMN + 2 + strlen(p->text), row, p->data);
+            cnt = cmsDrawValue(pDisplay, LEFT_MENU_COLUMN + 2 + strlen(p->text), row, p->data);
             CLR_PRINTVALUE(p);
         }
         break;
@@ -399,7 +428,7 @@ static int cmsDrawMenuEntry(displayPort_t *pDisplay, OSD_Entry *p, uint8_t row)
     default:
 #ifdef CMS_MENU_DEBUG
         // Shouldn't happen. Notify creator of this menu content.
-        cnt = displayWrite(pDisplay, RIGHT_MENU_COLUMN(pDisplay), row, "BADENT");
+        cnt = cmsDrawValue(pDisplay, RIGHT_MENU_COLUMN(pDisplay), row, "BADENT");
 #endif
         break;
     }
@@ -433,6 +462,7 @@ static void cmsDrawMenu(displayPort_t *pDisplay, uint32_t currentTimeUs)
             SET_PRINTLABEL(p);
             SET_PRINTVALUE(p);
         }
+        memset(cmsValueCache, 0, sizeof(cmsValueCache));
         pDisplay->cleared = false;
     } else if (drawPolled) {
         for (p = pageTop ; p <= pageTop + pageMaxRow ; p++) {
@@ -621,7 +651,11 @@ long cmsMenuExit(displayPort_t *pDisplay, const void *ptr)
         if (currentCtx.menu->onExit)
             currentCtx.menu->onExit((OSD_Entry *)NULL); // Forced exit
 
-        saveConfigAndNotify();
+        if (exitType == CMS_EXIT_SAVEREBOOT) {
+            saveConfigAndNotify();
+        } else {
+            saveConfigAndNotifyAsync();
+        }
         break;
 
     case CMS_EXIT:
@@ -763,7 +797,7 @@ STATIC_UNIT_TESTED uint16_t cmsHandleKey(displayPort_t *pDisplay, uint8_t key)
                 if (key == KEY_RIGHT)
                     *val |= VISIBLE_FLAG;
                 else
-                    *val %= ~VISIBLE_FLAG;
+                    *val &= ~VISIBLE_FLAG;
                 SET_PRINTVALUE(p);
             }
             break;
@@ -981,6 +1015,11 @@ void cmsUpdate(uint32_t currentTimeUs)
 
         cmsDrawMenu(pCurrentDisplay, currentTimeUs);
 
+        // send what the menu changed, for devices that buffer their writes
+        if (!displayIsTransferInProgress(pCurrentDisplay)) {
+            displayDrawScreen(pCurrentDisplay);
+        }
+
         if (currentTimeMs > lastCmsHeartBeatMs + 500) {
             // Heart beat for external CMS display device @ 500msec
             // (Timeout @ 1000msec)
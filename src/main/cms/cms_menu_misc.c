@@ -94,7 +94,7 @@ static uint16_t motorConfig_minthrottle;
 static uint8_t motorConfig_digitalIdleOffsetValue;
 static uint8_t voltageSensorADCConfig_vbatscale;
 static uint8_t batteryConfig_vbatmaxcellvoltage;
-static debugType_e systemConfig_debug_mode;
+static uint8_t systemConfig_debug_mode;
 
 static long cmsx_menuMiscOnEnter(void)
 {
@@ -102,7 +102,7 @@ static long cmsx_menuMiscOnEnter(void)
     motorConfig_digitalIdleOffsetValue = motorConfig()->digitalIdleOffsetValue / 10;
     voltageSensorADCConfig_vbatscale = voltageSensorADCConfig(VOLTAGE_SENSOR_ADC_VBAT)->vbatscale;
     batteryConfig_vbatmaxcellvoltage = batteryConfig()->vbatmaxcellvoltage;
-    systemConfig_debug_mode = systemConfig()->debug_mode;
+    systemConfig_debug_mode = systemConfig()->debug_modes[0];
 
     return 0;
 }
@@ -115,7 +115,7 @@ static long cmsx_menuMiscOnExit(const OSD_Entry *self)
     motorConfigMutable()->digitalIdleOffsetValue = 10 * motorConfig_digitalIdleOffsetValue;
     voltageSensorADCConfigMutable(VOLTAGE_SENSOR_ADC_VBAT)->vbatscale = voltageSensorADCConfig_vbatscale;
     batteryConfigMutable()->vbatmaxcellvoltage = batteryConfig_vbatmaxcellvoltage;
-    systemConfigMutable()->debug_mode = systemConfig_debug_mode;
+    systemConfigMutable()->debug_modes[0] = systemConfig_debug_mode;
 
     return 0;
 }
@@ -0,0 +1,65 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "common/arena.h"
+
+static uint8_t *arenaNext = NULL;
+static uint8_t *arenaEnd = NULL;
+
+void arenaInit(void *pool, size_t size)
+{
+    arenaNext = pool;
+    arenaEnd = arenaNext + size;
+}
+
+size_t arenaFree(void)
+{
+    return arenaEnd - arenaNext;
+}
+
+/*
+ * Returns a zeroed buffer of the given size, or NULL when the arena does not have the room.
+ */
+void *arenaAlloc(size_t size)
+{
+    size = ARENA_ALIGN(size);
+    if (size == 0 || size > arenaFree()) {
+        return NULL;
+    }
+
+    void *buffer = arenaNext;
+    arenaNext += size;
+    memset(buffer, 0, size);
+    return buffer;
+}
+
+/*
+ * Returns the rest of the arena as a whole number of units, the size is stored in *size, or NULL when not even one unit
+ * is left. The arena is then used up, so only the last claim of the boot may be made this way.
+ */
+void *arenaAllocRemaining(size_t unit, size_t *size)
+{
+    *size = arenaFree() / unit * unit;
+    void *buffer = arenaAlloc(*size);
+    if (!buffer) {
+        *size = 0;
+    }
+    return buffer;
+}
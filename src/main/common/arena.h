@@ -0,0 +1,37 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+/*
+ * Boot time arena for the large buffers of optional features.
+ *
+ * The pool is sized for every feature built into the target, each feature claims its buffers from its init only when
+ * it is enabled, and a feature that can make use of more memory takes whatever is left after the others. Nothing is
+ * ever given back, so claims are made once from the init code and never while flying.
+ */
+
+#define ARENA_ALIGNMENT 4
+
+#define ARENA_ALIGN(size) (((size) + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1))
+
+void arenaInit(void *pool, size_t size);
+void *arenaAlloc(size_t size);
+void *arenaAllocRemaining(size_t unit, size_t *size);
+size_t arenaFree(void);
@@ -20,6 +20,8 @@
 #include <string.h>
 #include <math.h>
 
+#include "platform.h"
+
 #include "common/filter.h"
 #include "common/maths.h"
 #include "common/utils.h"
@@ -31,7 +33,7 @@
 
 // NULL filter
 
-float nullFilterApply(void *filter, float input)
+FAST_CODE float nullFilterApply(void *filter, float input)
 {
     UNUSED(filter);
     return input;
@@ -47,7 +49,7 @@ void pt1FilterInit(pt1Filter_t *filter, uint8_t f_cut, float dT)
     filter->k = filter->dT / (filter->RC + filter->dT);
 }
 
-float pt1FilterApply(pt1Filter_t *filter, float input)
+FAST_CODE float pt1FilterApply(pt1Filter_t *filter, float input)
 {
     filter->state = filter->state + filter->k * (input - filter->state);
     return filter->state;
@@ -73,12 +75,12 @@ float filterGetNotchQ(uint16_t centerFreq, uint16_t cutoff) {
 }
 
 /* sets up a biquad Filter */
-void biquadFilterInitLPF(biquadFilter_t *filter, float filterFreq, uint32_t refreshRate)
+void biquadFilterInitLPF(biquadFilter_t *filter, float filterFreq, float refreshRate)
 {
     biquadFilterInit(filter, filterFreq, refreshRate, BIQUAD_Q, FILTER_LPF);
 }
 
-void biquadFilterInit(biquadFilter_t *filter, float filterFreq, uint32_t refreshRate, float Q, biquadFilterType_e filterType)
+void biquadFilterInit(biquadFilter_t *filter, float filterFreq, float refreshRate, float Q, biquadFilterType_e filterType)
 {
     // setup variables
     const float omega = 2.0f * M_PI_FLOAT * filterFreq * refreshRate * 0.000001f;
@@ -128,7 +130,7 @@ void biquadFilterInit(biquadFilter_t *filter, float filterFreq, uint32_t refresh
     filter->d1 = filter->d2 = 0;
 }
 
-void biquadFilterUpdate(biquadFilter_t *filter, float filterFreq, uint32_t refreshRate, float Q, biquadFilterType_e filterType)
+void biquadFilterUpdate(biquadFilter_t *filter, float filterFreq, float refreshRate, float Q, biquadFilterType_e filterType)
 {
     // backup state
     float x1 = filter->x1;
@@ -167,7 +169,7 @@ float biquadFilterApplyDF1(biquadFilter_t *filter, float input)
 }
 
 /* Computes a biquadFilter_t filter in direct form 2 on a sample (higher precision but can't handle changes in coefficients */
-float biquadFilterApply(biquadFilter_t *filter, float input)
+FAST_CODE float biquadFilterApply(biquadFilter_t *filter, float input)
 {
     const float result = filter->b0 * input + filter->d1;
     filter->d1 = filter->b1 * input - filter->a1 * result + filter->d2;
@@ -272,9 +274,9 @@ float firFilterLastInput(const firFilter_t *filter)
     return filter->buf[index];
 }
 
-void firFilterDenoiseInit(firFilterDenoise_t *filter, uint8_t gyroSoftLpfHz, uint16_t targetLooptime)
+void firFilterDenoiseInit(firFilterDenoise_t *filter, uint8_t gyroSoftLpfHz, float targetLooptime)
 {
-    filter->targetCount = constrain(lrintf((1.0f / (0.000001f * (float)targetLooptime)) / gyroSoftLpfHz), 1, MAX_FIR_DENOISE_WINDOW_SIZE);
+    filter->targetCount = constrain(lrintf((1.0f / (0.000001f * targetLooptime)) / gyroSoftLpfHz), 1, MAX_FIR_DENOISE_WINDOW_SIZE);
 }
 
 // prototype function for denoising of signal by dynamic moving average. Mainly for test purposes
@@ -292,3 +294,218 @@ float firFilterDenoiseUpdate(firFilterDenoise_t *filter, float input)
         return filter->movingSum / ++filter->filledCount + 1;
 }
 
+
+/*
+ * Three axis filters
+ *
+ * Cortex-M4/M7 have no floating point SIMD, so these get their speed from running the three axes as
+ * independent dependency chains in one call: the inputs are all loaded before any state is written,
+ * which lets the compiler interleave the multiply-accumulates of the axes.
+ */
+
+FAST_CODE void nullFilterApplyXyz(void *filter, float values[XYZ_AXIS_COUNT])
+{
+    UNUSED(filter);
+    UNUSED(values);
+}
+
+void pt1FilterXyzInit(pt1FilterXyz_t *filter, uint8_t f_cut, float dT)
+{
+    const float RC = 1.0f / (2.0f * M_PI_FLOAT * f_cut);
+    filter->k = dT / (RC + dT);
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        filter->state[axis] = 0.0f;
+    }
+}
+
+FAST_CODE void pt1FilterXyzApply(pt1FilterXyz_t *filter, float values[XYZ_AXIS_COUNT])
+{
+    pt1FilterXyzApplyInline(filter, values);
+}
+
+// Settles the state on a constant input of values, so the filter carries on from there without a transient
+void pt1FilterXyzReset(pt1FilterXyz_t *filter, const float values[XYZ_AXIS_COUNT])
+{
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        filter->state[axis] = values[axis];
+    }
+}
+
+void biquadFilterXyzInitLPF(biquadFilterXyz_t *filter, float filterFreq, float refreshRate)
+{
+    biquadFilterXyzInit(filter, filterFreq, refreshRate, BIQUAD_Q, FILTER_LPF);
+}
+
+static void biquadFilterXyzSetCoefficients(biquadFilterXyz_t *filter, int axis, const biquadFilter_t *coefficients)
+{
+    filter->b0[axis] = coefficients->b0;
+    filter->b1[axis] = coefficients->b1;
+    filter->b2[axis] = coefficients->b2;
+    filter->a1[axis] = coefficients->a1;
+    filter->a2[axis] = coefficients->a2;
+}
+
+/*
+ * Notch retuning
+ *
+ * Notches that track a moving frequency get their sin and cos from a quarter wave table with linear
+ * interpolation instead of a full recalculation, which keeps retuning down to a couple of table lookups
+ * and one division. The interpolated sin and cos are within 2e-5, so the coefficients are within 4e-5,
+ * well below what moves a notch noticeably.
+ * The table is built by biquadFilterXyzInit(), which every filter goes through before it is retuned.
+ */
+
+#define FILTER_SIN_TABLE_SEGMENTS 128
+static float filterSinTable[FILTER_SIN_TABLE_SEGMENTS + 1];
+static bool filterSinTableReady = false;
+
+static void filterInitSinTable(void)
+{
+    for (int i = 0; i <= FILTER_SIN_TABLE_SEGMENTS; i++) {
+        filterSinTable[i] = sinf(0.5f * M_PI_FLOAT * i / FILTER_SIN_TABLE_SEGMENTS);
+    }
+    filterSinTableReady = true;
+}
+
+// x is the angle in 0..pi/2, scaled to 0..FILTER_SIN_TABLE_SEGMENTS
+static inline float filterSinQuarter(float x)
+{
+    const int i = MIN((int)x, FILTER_SIN_TABLE_SEGMENTS - 1);
+    return filterSinTable[i] + (x - i) * (filterSinTable[i + 1] - filterSinTable[i]);
+}
+
+// omega in 0..pi, i.e. up to nyquist
+static void filterSinCos(float omega, float *sn, float *cs)
+{
+    const float x = constrainf(omega, 0.0f, M_PI_FLOAT) * (2.0f * FILTER_SIN_TABLE_SEGMENTS / M_PI_FLOAT);
+    if (x <= FILTER_SIN_TABLE_SEGMENTS) {
+        *sn = filterSinQuarter(x);
+        *cs = filterSinQuarter(FILTER_SIN_TABLE_SEGMENTS - x);
+    } else {
+        *sn = filterSinQuarter(2 * FILTER_SIN_TABLE_SEGMENTS - x);
+        *cs = -filterSinQuarter(x - FILTER_SIN_TABLE_SEGMENTS);
+    }
+}
+
+// Only b0, b1 and a2 are returned, for a notch b2 == b0 and a1 == b1
+static void biquadNotchCoefficients(float filterFreq, float refreshRate, float Q, float *b0, float *b1, float *a2)
+{
+    float sn, cs;
+    filterSinCos(2.0f * M_PI_FLOAT * filterFreq * refreshRate * 0.000001f, &sn, &cs);
+    const float alpha = sn / (2.0f * Q);
+    const float a0Inv = 1.0f / (1.0f + alpha);
+
+    *b0 = a0Inv;
+    *b1 = -2.0f * cs * a0Inv;
+    *a2 = (1.0f - alpha) * a0Inv;
+}
+
+void biquadFilterXyzInit(biquadFilterXyz_t *filter, float filterFreq, float refreshRate, float Q, biquadFilterType_e filterType)
+{
+    if (!filterSinTableReady) {
+        filterInitSinTable();
+    }
+
+    biquadFilter_t coefficients;
+    biquadFilterInit(&coefficients, filterFreq, refreshRate, Q, filterType);
+
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        biquadFilterXyzSetCoefficients(filter, axis, &coefficients);
+
+        // zero initial samples
+        filter->x1[axis] = filter->x2[axis] = 0;
+        filter->y1[axis] = filter->y2[axis] = 0;
+        filter->d1[axis] = filter->d2[axis] = 0;
+    }
+}
+
+// Changes the coefficients of one axis, keeping the state
+void biquadFilterXyzUpdate(biquadFilterXyz_t *filter, int axis, float filterFreq, float refreshRate, float Q, biquadFilterType_e filterType)
+{
+    biquadFilter_t coefficients;
+    biquadFilterInit(&coefficients, filterFreq, refreshRate, Q, filterType);
+    biquadFilterXyzSetCoefficients(filter, axis, &coefficients);
+}
+
+/*
+ * Retune a notch, keeping the state. Cheap enough to run every loop for every notch.
+ * Use these with biquadFilterXyzApplyDF1(): its state is the recent input and output samples, which stay
+ * valid when the coefficients change, so a notch can sweep quickly without transients. The state of the
+ * direct form 2 is not, which is why it does not suit notches that move.
+ */
+void biquadFilterXyzUpdateNotchAxis(biquadFilterXyz_t *filter, int axis, float filterFreq, float refreshRate, float Q)
+{
+    float b0, b1, a2;
+    biquadNotchCoefficients(filterFreq, refreshRate, Q, &b0, &b1, &a2);
+
+    filter->b0[axis] = b0;
+    filter->b1[axis] = b1;
+    filter->b2[axis] = b0;
+    filter->a1[axis] = b1;
+    filter->a2[axis] = a2;
+}
+
+// Same frequency on all axes
+void biquadFilterXyzUpdateNotch(biquadFilterXyz_t *filter, float filterFreq, float refreshRate, float Q)
+{
+    float b0, b1, a2;
+    biquadNotchCoefficients(filterFreq, refreshRate, Q, &b0, &b1, &a2);
+
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        filter->b0[axis] = b0;
+        filter->b1[axis] = b1;
+        filter->b2[axis] = b0;
+        filter->a1[axis] = b1;
+        filter->a2[axis] = a2;
+    }
+}
+
+// Makes the filter pass its input through unchanged, keeping the state
+void biquadFilterXyzSetPassthrough(biquadFilterXyz_t *filter)
+{
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        filter->b0[axis] = 1.0f;
+        filter->b1[axis] = filter->b2[axis] = 0.0f;
+        filter->a1[axis] = filter->a2[axis] = 0.0f;
+    }
+}
+
+FAST_CODE void biquadFilterXyzApplyDF1(biquadFilterXyz_t *filter, float values[XYZ_AXIS_COUNT])
+{
+    biquadFilterXyzApplyDF1Inline(filter, values);
+}
+
+FAST_CODE void biquadFilterXyzApply(biquadFilterXyz_t *filter, float values[XYZ_AXIS_COUNT])
+{
+    biquadFilterXyzApplyInline(filter, values);
+}
+
+// Settles the state of both forms on a constant input of values, the output starts at the DC gain times the input
+void biquadFilterXyzReset(biquadFilterXyz_t *filter, const float values[XYZ_AXIS_COUNT])
+{
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        const float den = 1.0f + filter->a1[axis] + filter->a2[axis];
+        const float dcGain = fabsf(den) > 1e-6f ? (filter->b0[axis] + filter->b1[axis] + filter->b2[axis]) / den : 0.0f;
+        const float input = values[axis];
+        const float output = dcGain * input;
+
+        filter->x1[axis] = filter->x2[axis] = input;
+        filter->y1[axis] = filter->y2[axis] = output;
+        filter->d2[axis] = filter->b2[axis] * input - filter->a2[axis] * output;
+        filter->d1[axis] = filter->b1[axis] * input - filter->a1[axis] * output + filter->d2[axis];
+    }
+}
+
+void firFilterDenoiseXyzInit(firFilterDenoiseXyz_t *filter, uint8_t gyroSoftLpfHz, float targetLooptime)
+{
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        firFilterDenoiseInit(&filter->axis[axis], gyroSoftLpfHz, targetLooptime);
+    }
+}
+
+void firFilterDenoiseXyzUpdate(firFilterDenoiseXyz_t *filter, float values[XYZ_AXIS_COUNT])
+{
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        values[axis] = firFilterDenoiseUpdate(&filter->axis[axis], values[axis]);
+    }
+}
@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include "common/axis.h"
+
 #ifdef STM32F10X
 #define MAX_FIR_DENOISE_WINDOW_SIZE 60
 #else
@@ -67,13 +69,35 @@ typedef struct firFilter_s {
     uint8_t coeffsLength;
 } firFilter_t;
 
+/*
+ * Three axis filters, which run one filter stage on X, Y and Z in a single call. The state is kept
+ * as a structure of arrays, so that the three independent computations can be interleaved to keep the
+ * FPU pipeline busy, and a filter chain costs one indirect call per stage instead of one per axis.
+ * Coefficients are per axis, so that the dynamic notch can track a different frequency on each.
+ */
+typedef struct pt1FilterXyz_s {
+    float state[XYZ_AXIS_COUNT];
+    float k;
+} pt1FilterXyz_t;
+
+typedef struct biquadFilterXyz_s {
+    float b0[XYZ_AXIS_COUNT], b1[XYZ_AXIS_COUNT], b2[XYZ_AXIS_COUNT], a1[XYZ_AXIS_COUNT], a2[XYZ_AXIS_COUNT];
+    float x1[XYZ_AXIS_COUNT], x2[XYZ_AXIS_COUNT], y1[XYZ_AXIS_COUNT], y2[XYZ_AXIS_COUNT];
+    float d1[XYZ_AXIS_COUNT], d2[XYZ_AXIS_COUNT];
+} biquadFilterXyz_t;
+
+typedef struct firFilterDenoiseXyz_s {
+    firFilterDenoise_t axis[XYZ_AXIS_COUNT];
+} firFilterDenoiseXyz_t;
+
 typedef float (*filterApplyFnPtr)(void *filter, float input);
+typedef void (*filterApplyXyzFnPtr)(void *filter, float values[XYZ_AXIS_COUNT]);    // filters values in place
 
 float nullFilterApply(void *filter, float input);
 
-void biquadFilterInitLPF(biquadFilter_t *filter, float filterFreq, uint32_t refreshRate);
-void biquadFilterInit(biquadFilter_t *filter, float filterFreq, uint32_t refreshRate, float Q, biquadFilterType_e filterType);
-void biquadFilterUpdate(biquadFilter_t *filter, float filterFreq, uint32_t refreshRate, float Q, biquadFilterType_e filterType);
+void biquadFilterInitLPF(biquadFilter_t *filter, float filterFreq, float refreshRate);
+void biquadFilterInit(biquadFilter_t *filter, float filterFreq, float refreshRate, float Q, biquadFilterType_e filterType);
+void biquadFilterUpdate(biquadFilter_t *filter, float filterFreq, float refreshRate, float Q, biquadFilterType_e filterType);
 float biquadFilterApplyDF1(biquadFilter_t *filter, float input);
 float biquadFilterApply(biquadFilter_t *filter, float input);
 float filterGetNotchQ(uint16_t centerFreq, uint16_t cutoff);
@@ -95,6 +119,86 @@ float firFilterCalcPartialAverage(const firFilter_t *filter, uint8_t count);
 float firFilterCalcMovingAverage(const firFilter_t *filter);
 float firFilterLastInput(const firFilter_t *filter);
 
-void firFilterDenoiseInit(firFilterDenoise_t *filter, uint8_t gyroSoftLpfHz, uint16_t targetLooptime);
+void firFilterDenoiseInit(firFilterDenoise_t *filter, uint8_t gyroSoftLpfHz, float targetLooptime);
 float firFilterDenoiseUpdate(firFilterDenoise_t *filter, float input);
 
+void nullFilterApplyXyz(void *filter, float values[XYZ_AXIS_COUNT]);
+void pt1FilterXyzInit(pt1FilterXyz_t *filter, uint8_t f_cut, float dT);
+void pt1FilterXyzApply(pt1FilterXyz_t *filter, float values[XYZ_AXIS_COUNT]);
+void pt1FilterXyzReset(pt1FilterXyz_t *filter, const float values[XYZ_AXIS_COUNT]);
+void biquadFilterXyzInitLPF(biquadFilterXyz_t *filter, float filterFreq, float refreshRate);
+void biquadFilterXyzInit(biquadFilterXyz_t *filter, float filterFreq, float refreshRate, float Q, biquadFilterType_e filterType);
+void biquadFilterXyzUpdate(biquadFilterXyz_t *filter, int axis, float filterFreq, float refreshRate, float Q, biquadFilterType_e filterType);
+void biquadFilterXyzUpdateNotchAxis(biquadFilterXyz_t *filter, int axis, float filterFreq, float refreshRate, float Q);
+void biquadFilterXyzUpdateNotch(biquadFilterXyz_t *filter, float filterFreq, float refreshRate, float Q);
+void biquadFilterXyzSetPassthrough(biquadFilterXyz_t *filter);
+void biquadFilterXyzApplyDF1(biquadFilterXyz_t *filter, float values[XYZ_AXIS_COUNT]);
+void biquadFilterXyzApply(biquadFilterXyz_t *filter, float values[XYZ_AXIS_COUNT]);
+void biquadFilterXyzReset(biquadFilterXyz_t *filter, const float values[XYZ_AXIS_COUNT]);
+void firFilterDenoiseXyzInit(firFilterDenoiseXyz_t *filter, uint8_t gyroSoftLpfHz, float targetLooptime);
+void firFilterDenoiseXyzUpdate(firFilterDenoiseXyz_t *filter, float values[XYZ_AXIS_COUNT]);
+
+/*
+ * The three axis kernels are inline so that a filter chain built from them at compile time can be
+ * fused into one function. The functions above wrap them for use through filterApplyXyzFnPtr.
+ */
+static inline void pt1FilterXyzApplyInline(pt1FilterXyz_t *filter, float values[XYZ_AXIS_COUNT])
+{
+    const float k = filter->k;
+    const float x = values[X];
+    const float y = values[Y];
+    const float z = values[Z];
+
+    filter->state[X] += k * (x - filter->state[X]);
+    filter->state[Y] += k * (y - filter->state[Y]);
+    filter->state[Z] += k * (z - filter->state[Z]);
+
+    values[X] = filter->state[X];
+    values[Y] = filter->state[Y];
+    values[Z] = filter->state[Z];
+}
+
+/* Direct form 1, which copes with coefficients changing between samples */
+static inline void biquadFilterXyzApplyDF1Inline(biquadFilterXyz_t *filter, float values[XYZ_AXIS_COUNT])
+{
+    float input[XYZ_AXIS_COUNT];
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        input[axis] = values[axis];
+    }
+
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        const float result = filter->b0[axis] * input[axis] + filter->b1[axis] * filter->x1[axis] + filter->b2[axis] * filter->x2[axis]
+            - filter->a1[axis] * filter->y1[axis] - filter->a2[axis] * filter->y2[axis];
+
+        filter->x2[axis] = filter->x1[axis];
+        filter->x1[axis] = input[axis];
+
+        filter->y2[axis] = filter->y1[axis];
+        filter->y1[axis] = result;
+    }
+
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        values[axis] = filter->y1[axis];
+    }
+}
+
+/* Direct form 2, higher precision but can't handle changes in coefficients */
+static inline void biquadFilterXyzApplyInline(biquadFilterXyz_t *filter, float values[XYZ_AXIS_COUNT])
+{
+    float input[XYZ_AXIS_COUNT];
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        input[axis] = values[axis];
+    }
+
+    float result[XYZ_AXIS_COUNT];
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        result[axis] = filter->b0[axis] * input[axis] + filter->d1[axis];
+        filter->d1[axis] = filter->b1[axis] * input[axis] - filter->a1[axis] * result[axis] + filter->d2[axis];
+        filter->d2[axis] = filter->b2[axis] * input[axis] - filter->a2[axis] * result[axis];
+    }
+
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        values[axis] = result[axis];
+    }
+}
+
@@ -40,23 +40,58 @@
 #define sinPolyCoef7 -1.980661520e-4f                                          // Double: -1.980661520135080504411629636078917643846e-4
 #define sinPolyCoef9  2.600054768e-6f                                          // Double:  2.600054767890361277123254766503271638682e-6
 #endif
-float sin_approx(float x)
+// x already wrapped to -PI..PI, folded to -90..+90 Degree where the polynomial is accurate
+static inline float sinPoly(float x)
 {
-    int32_t xint = x;
-    if (xint < -32 || xint > 32) return 0.0f;                               // Stop here on error input (5 * 360 Deg)
-    while (x >  M_PIf) x -= (2.0f * M_PIf);                                 // always wrap input angle to -PI..PI
-    while (x < -M_PIf) x += (2.0f * M_PIf);
     if (x >  (0.5f * M_PIf)) x =  (0.5f * M_PIf) - (x - (0.5f * M_PIf));   // We just pick -90..+90 Degree
     else if (x < -(0.5f * M_PIf)) x = -(0.5f * M_PIf) - ((0.5f * M_PIf) + x);
-    float x2 = x * x;
+    const float x2 = x * x;
     return x + x * x2 * (sinPolyCoef3 + x2 * (sinPolyCoef5 + x2 * (sinPolyCoef7 + x2 * sinPolyCoef9)));
 }
 
+static inline float wrapPi(float x)
+{
+    while (x >  M_PIf) x -= (2.0f * M_PIf);                                 // always wrap input angle to -PI..PI
+    while (x < -M_PIf) x += (2.0f * M_PIf);
+    return x;
+}
+
+float sin_approx(float x)
+{
+    int32_t xint = x;
+    if (xint < -32 || xint > 32) return 0.0f;                               // Stop here on error input (5 * 360 Deg)
+    return sinPoly(wrapPi(x));
+}
+
 float cos_approx(float x)
 {
     return sin_approx(x + (0.5f * M_PIf));
 }
 
+// sin_approx and cos_approx of the same angle, the input is range checked and wrapped only once
+void sincos_approx(float x, float *sinx, float *cosx)
+{
+    int32_t xint = x;
+    if (xint < -32 || xint > 32) {
+        *sinx = 0.0f;
+        *cosx = 0.0f;
+        return;
+    }
+    x = wrapPi(x);
+    *sinx = sinPoly(x);
+    // x + PI/2 is at most 3/2 PI, one step brings it back to -PI..PI
+    const float xc = x + (0.5f * M_PIf);
+    *cosx = sinPoly(xc > M_PIf ? xc - (2.0f * M_PIf) : xc);
+}
+
+// Three angles at once, the six polynomials are independent so the FPU pipeline stays full
+void sincos3_approx(const float x[3], float sinx[3], float cosx[3])
+{
+    for (int i = 0; i < 3; i++) {
+        sincos_approx(x[i], &sinx[i], &cosx[i]);
+    }
+}
+
 // Initial implementation by Crashpilot1000 (https://github.com/Crashpilot1000/HarakiriWebstore1/blob/396715f73c6fcf859e0db0f34e12fe44bace6483/src/mw.c#L1292)
 // Polynomial coefficients by Andor (http://www.dsprelated.com/showthread/comp.dsp/21872-1.php) optimized by Ledvinap to save one multiplication
 // Max absolute error 0,000027 degree
@@ -115,6 +150,18 @@ float powerf(float base, int exp) {
     return result;
 }
 
+float fapplyDeadband(float value, float deadband)
+{
+    if (ABS(value) < deadband) {
+        value = 0;
+    } else if (value > 0) {
+        value -= deadband;
+    } else if (value < 0) {
+        value += deadband;
+    }
+    return value;
+}
+
 int32_t applyDeadband(int32_t value, int32_t deadband)
 {
     if (ABS(value) < deadband) {
@@ -185,12 +232,14 @@ void buildRotationMatrix(fp_angles_t *delta, float matrix[3][3])
     float cosx, sinx, cosy, siny, cosz, sinz;
     float coszcosx, sinzcosx, coszsinx, sinzsinx;
 
-    cosx = cos_approx(delta->angles.roll);
-    sinx = sin_approx(delta->angles.roll);
-    cosy = cos_approx(delta->angles.pitch);
-    siny = sin_approx(delta->angles.pitch);
-    cosz = cos_approx(delta->angles.yaw);
-    sinz = sin_approx(delta->angles.yaw);
+    float sinAngle[3], cosAngle[3];
+    sincos3_approx(delta->raw, sinAngle, cosAngle);
+    cosx = cosAngle[0];
+    sinx = sinAngle[0];
+    cosy = cosAngle[1];
+    siny = sinAngle[1];
+    cosz = cosAngle[2];
+    sinz = sinAngle[2];
 
     coszcosx = cosz * cosx;
     sinzcosx = sinz * cosx;
@@ -345,41 +394,3 @@ int16_t qMultiply(fix12_t q, int16_t input) {
 fix12_t  qConstruct(int16_t num, int16_t den) {
     return (num << 12) / den;
 }
-
-uint16_t crc16_ccitt(uint16_t crc, unsigned char a)
-{
-    crc ^= (uint16_t)a << 8;
-    for (int ii = 0; ii < 8; ++ii) {
-        if (crc & 0x8000) {
-            crc = (crc << 1) ^ 0x1021;
-        } else {
-            crc = crc << 1;
-        }
-    }
-    return crc;
-}
-
-uint16_t crc16_ccitt_update(uint16_t crc, const void *data, uint32_t length)
-{
-    const uint8_t *p = (const uint8_t *)data;
-    const uint8_t *pend = p + length;
-
-    for (; p != pend; p++) {
-        crc = crc16_ccitt(crc, *p);
-    }
-    return crc;
-}
-
-uint8_t crc8_dvb_s2(uint8_t crc, unsigned char a)
-{
-    crc ^= a;
-    for (int ii = 0; ii < 8; ++ii) {
-        if (crc & 0x80) {
-            crc = (crc << 1) ^ 0xD5;
-        } else {
-            crc = crc << 1;
-        }
-    }
-    return crc;
-}
-
@@ -79,6 +79,7 @@ typedef union {
 int gcd(int num, int denom);
 float powerf(float base, int exp);
 int32_t applyDeadband(int32_t value, int32_t deadband);
+float fapplyDeadband(float value, float deadband);
 
 void devClear(stdev_t *dev);
 void devPush(stdev_t *dev, float x);
@@ -103,15 +104,32 @@ float quickMedianFilter5f(float * v);
 float quickMedianFilter7f(float * v);
 float quickMedianFilter9f(float * v);
 
+/*
+ * Maximum absolute error against libm over -10 PI..10 PI, checked by the maths unit test.
+ * At large angles most of it is the rounding of the wrap to -PI..PI, not the polynomial.
+ *
+ *                                  VERY_FAST_MATH      FAST_MATH only
+ *   sin_approx, sincos_approx sin  2.8e-06             2.4e-06
+ *   cos_approx, sincos_approx cos  3.2e-06             3.0e-06
+ *   atan2_approx                   7.2e-07 rad         7.2e-07 rad
+ *   acos_approx                    6.8e-05 rad         6.8e-05 rad
+ *
+ * sincos3_approx gives the same values as sincos_approx. Angles beyond +-32 rad are treated
+ * as bad input and give 0.
+ */
 #if defined(FAST_MATH) || defined(VERY_FAST_MATH)
 float sin_approx(float x);
 float cos_approx(float x);
+void sincos_approx(float x, float *sinx, float *cosx);
+void sincos3_approx(const float x[3], float sinx[3], float cosx[3]);
 float atan2_approx(float y, float x);
 float acos_approx(float x);
 #define tan_approx(x)       (sin_approx(x) / cos_approx(x))
 #else
 #define sin_approx(x)   sinf(x)
 #define cos_approx(x)   cosf(x)
+#define sincos_approx(x, sinx, cosx) do { *(sinx) = sinf(x); *(cosx) = cosf(x); } while (0)
+#define sincos3_approx(x, sinx, cosx) do { for (int i_ = 0; i_ < 3; i_++) sincos_approx((x)[i_], &(sinx)[i_], &(cosx)[i_]); } while (0)
 #define atan2_approx(y,x)   atan2f(y,x)
 #define acos_approx(x)      acosf(x)
 #define tan_approx(x)       tanf(x)
@@ -142,6 +160,3 @@ static inline float constrainf(float amt, float low, float high)
     else
         return amt;
 }
-uint16_t crc16_ccitt(uint16_t crc, unsigned char a);
-uint16_t crc16_ccitt_update(uint16_t crc, const void *data, uint32_t length);
-uint8_t crc8_dvb_s2(uint8_t crc, unsigned char a);
@@ -0,0 +1,180 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * Single producer, single consumer byte ring buffer.
+ *
+ * Only the producer writes head and only the consumer writes tail, so one side may run from an
+ * interrupt handler and the other from a task without locking. Both sides run on the same core,
+ * so signal fences are enough to keep the data accesses ordered against the index that publishes
+ * them: the producer stores the bytes before moving head, the consumer reads them before moving tail.
+ *
+ * size must be a power of 2. One slot is always left empty so a full buffer can be told from an
+ * empty one, so a buffer of size bytes holds at most size - 1.
+ */
+
+typedef struct ringBuffer_s {
+    volatile uint8_t *buffer;
+    uint32_t size;
+    uint32_t head;      // next slot to write, owned by the producer
+    uint32_t tail;      // next slot to read, owned by the consumer
+} ringBuffer_t;
+
+static inline uint32_t ringBufferLoadIndex(const uint32_t *index)
+{
+    const uint32_t value = __atomic_load_n(index, __ATOMIC_RELAXED);
+    __atomic_signal_fence(__ATOMIC_ACQUIRE);
+    return value;
+}
+
+static inline void ringBufferStoreIndex(uint32_t *index, uint32_t value)
+{
+    __atomic_signal_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(index, value, __ATOMIC_RELAXED);
+}
+
+// Must only be called while neither side is using the buffer.
+static inline void ringBufferInit(ringBuffer_t *rb, volatile uint8_t *buffer, uint32_t size)
+{
+    rb->buffer = buffer;
+    rb->size = size;
+    rb->head = 0;
+    rb->tail = 0;
+}
+
+// Must only be called while neither side is using the buffer.
+static inline void ringBufferReset(ringBuffer_t *rb)
+{
+    rb->head = 0;
+    rb->tail = 0;
+}
+
+static inline uint32_t ringBufferCount(const ringBuffer_t *rb)
+{
+    return (ringBufferLoadIndex(&rb->head) - ringBufferLoadIndex(&rb->tail)) & (rb->size - 1);
+}
+
+static inline uint32_t ringBufferFree(const ringBuffer_t *rb)
+{
+    return (rb->size - 1) - ringBufferCount(rb);
+}
+
+static inline bool ringBufferIsEmpty(const ringBuffer_t *rb)
+{
+    return ringBufferLoadIndex(&rb->head) == ringBufferLoadIndex(&rb->tail);
+}
+
+// Producer side. Returns false, dropping the byte, if the buffer is full.
+static inline bool ringBufferPush(ringBuffer_t *rb, uint8_t data)
+{
+    const uint32_t head = rb->head;
+    const uint32_t next = (head + 1) & (rb->size - 1);
+    if (next == ringBufferLoadIndex(&rb->tail)) {
+        return false;
+    }
+    rb->buffer[head] = data;
+    ringBufferStoreIndex(&rb->head, next);
+    return true;
+}
+
+// Consumer side. Returns 0 if the buffer is empty, callers are expected to check the count first.
+static inline uint8_t ringBufferPop(ringBuffer_t *rb)
+{
+    const uint32_t tail = rb->tail;
+    if (tail == ringBufferLoadIndex(&rb->head)) {
+        return 0;
+    }
+    const uint8_t data = rb->buffer[tail];
+    ringBufferStoreIndex(&rb->tail, (tail + 1) & (rb->size - 1));
+    return data;
+}
+
+// Producer side. Copies as much of data as fits, in at most two chunks, and returns the number of bytes written.
+static inline uint32_t ringBufferWrite(ringBuffer_t *rb, const void *data, uint32_t count)
+{
+    const uint32_t head = rb->head;
+    const uint32_t space = (rb->size - 1) - ((head - ringBufferLoadIndex(&rb->tail)) & (rb->size - 1));
+    if (count > space) {
+        count = space;
+    }
+    const uint32_t chunk = (count < rb->size - head) ? count : rb->size - head;
+    memcpy((uint8_t *)&rb->buffer[head], data, chunk);
+    memcpy((uint8_t *)rb->buffer, (const uint8_t *)data + chunk, count - chunk);
+    ringBufferStoreIndex(&rb->head, (head + count) & (rb->size - 1));
+    return count;
+}
+
+// Consumer side. Copies up to count bytes out, in at most two chunks, and returns the number of bytes read.
+static inline uint32_t ringBufferRead(ringBuffer_t *rb, void *data, uint32_t count)
+{
+    const uint32_t tail = rb->tail;
+    const uint32_t used = (ringBufferLoadIndex(&rb->head) - tail) & (rb->size - 1);
+    if (count > used) {
+        count = used;
+    }
+    const uint32_t chunk = (count < rb->size - tail) ? count : rb->size - tail;
+    memcpy(data, (const uint8_t *)&rb->buffer[tail], chunk);
+    memcpy((uint8_t *)data + chunk, (const uint8_t *)rb->buffer, count - chunk);
+    ringBufferStoreIndex(&rb->tail, (tail + count) & (rb->size - 1));
+    return count;
+}
+
+/*
+ * Consumer side, zero copy. Points *data at the oldest byte and returns how many bytes can be read from
+ * there without wrapping. The bytes stay owned by the buffer until they are released with ringBufferAdvance().
+ */
+static inline uint32_t ringBufferPeekContiguous(const ringBuffer_t *rb, volatile uint8_t **data)
+{
+    const uint32_t head = ringBufferLoadIndex(&rb->head);
+    const uint32_t tail = rb->tail;
+    *data = &rb->buffer[tail];
+    return (head >= tail) ? head - tail : rb->size - tail;
+}
+
+// Consumer side. Releases count bytes, which must not be more than ringBufferCount() returned.
+static inline void ringBufferAdvance(ringBuffer_t *rb, uint32_t count)
+{
+    ringBufferStoreIndex(&rb->tail, (rb->tail + count) & (rb->size - 1));
+}
+
+/*
+ * Producer side, zero copy. Points *data at the next free slot and returns how many bytes can be written from
+ * there without wrapping. The consumer sees none of them until they are published with ringBufferCommit().
+ */
+static inline uint32_t ringBufferReserveContiguous(const ringBuffer_t *rb, volatile uint8_t **data)
+{
+    const uint32_t head = rb->head;
+    const uint32_t tail = ringBufferLoadIndex(&rb->tail);
+    *data = &rb->buffer[head];
+    if (tail > head) {
+        return tail - head - 1;
+    }
+    // Running up to the end is only allowed if that does not make head catch up with a tail at 0
+    return rb->size - head - (tail == 0 ? 1 : 0);
+}
+
+// Producer side. Publishes count bytes, which must not be more than ringBufferReserveContiguous() returned.
+static inline void ringBufferCommit(ringBuffer_t *rb, uint32_t count)
+{
+    ringBufferStoreIndex(&rb->head, (rb->head + count) & (rb->size - 1));
+}
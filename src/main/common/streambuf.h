@@ -17,7 +17,9 @@
 
 #pragma once
 
+#include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
 // simple buffer-based serializer/deserializer without implicit size check
 // little-endian encoding implemneted now
@@ -27,22 +29,118 @@ typedef struct sbuf_s {
     uint8_t *end;
 } sbuf_t;
 
-void sbufWriteU8(sbuf_t *dst, uint8_t val);
-void sbufWriteU16(sbuf_t *dst, uint16_t val);
-void sbufWriteU32(sbuf_t *dst, uint32_t val);
+// The per field accessors are inline, an MSP reply is built from hundreds of them. A handler writing a block of fields
+// checks for room once with sbufReserve() and fills the returned bytes directly, memcpy for data already in wire order.
+
+static inline void sbufWriteU8(sbuf_t *dst, uint8_t val)
+{
+    *dst->ptr++ = val;
+}
+
+static inline void sbufWriteU16(sbuf_t *dst, uint16_t val)
+{
+    dst->ptr[0] = val;
+    dst->ptr[1] = val >> 8;
+    dst->ptr += 2;
+}
+
+static inline void sbufWriteU32(sbuf_t *dst, uint32_t val)
+{
+    dst->ptr[0] = val;
+    dst->ptr[1] = val >> 8;
+    dst->ptr[2] = val >> 16;
+    dst->ptr[3] = val >> 24;
+    dst->ptr += 4;
+}
+
+static inline void sbufWriteData(sbuf_t *dst, const void *data, int len)
+{
+    memcpy(dst->ptr, data, len);
+    dst->ptr += len;
+}
+
 void sbufWriteU16BigEndian(sbuf_t *dst, uint16_t val);
 void sbufWriteU32BigEndian(sbuf_t *dst, uint32_t val);
-void sbufWriteData(sbuf_t *dst, const void *data, int len);
 void sbufWriteString(sbuf_t *dst, const char *string);
 
-uint8_t sbufReadU8(sbuf_t *src);
-uint16_t sbufReadU16(sbuf_t *src);
-uint32_t sbufReadU32(sbuf_t *src);
-void sbufReadData(sbuf_t *dst, void *data, int len);
+static inline uint8_t sbufReadU8(sbuf_t *src)
+{
+    return *src->ptr++;
+}
+
+static inline uint16_t sbufReadU16(sbuf_t *src)
+{
+    const uint16_t ret = src->ptr[0] | src->ptr[1] << 8;
+    src->ptr += 2;
+    return ret;
+}
+
+static inline uint32_t sbufReadU32(sbuf_t *src)
+{
+    const uint32_t ret = src->ptr[0] | src->ptr[1] << 8 | src->ptr[2] << 16 | (uint32_t)src->ptr[3] << 24;
+    src->ptr += 4;
+    return ret;
+}
+
+// copies without advancing, sbufAdvance() once the data is used
+static inline void sbufReadData(sbuf_t *src, void *data, int len)
+{
+    memcpy(data, src->ptr, len);
+}
+
+// reader - return bytes remaining in buffer
+// writer - return available space
+static inline int sbufBytesRemaining(sbuf_t *buf)
+{
+    return buf->end - buf->ptr;
+}
+
+static inline uint8_t* sbufPtr(sbuf_t *buf)
+{
+    return buf->ptr;
+}
+
+static inline const uint8_t* sbufConstPtr(const sbuf_t *buf)
+{
+    return buf->ptr;
+}
+
+// advance buffer pointer
+// reader - skip data
+// writer - commit written data
+static inline void sbufAdvance(sbuf_t *buf, int size)
+{
+    buf->ptr += size;
+}
+
+// writer - the next len bytes for the caller to fill in, NULL and nothing written when there is no room for them
+static inline uint8_t *sbufReserve(sbuf_t *dst, int len)
+{
+    if (dst->end - dst->ptr < len) {
+        return NULL;
+    }
+    uint8_t *data = dst->ptr;
+    dst->ptr += len;
+    return data;
+}
+
+// reader - the next len bytes, NULL and nothing read when fewer than that are left
+static inline const uint8_t *sbufReadView(sbuf_t *src, int len)
+{
+    return sbufReserve(src, len);
+}
+
+// little endian fields of a reserved block
+static inline uint8_t *sbufPutU16(uint8_t *data, uint16_t val)
+{
+    data[0] = val;
+    data[1] = val >> 8;
+    return data + 2;
+}
 
-int sbufBytesRemaining(sbuf_t *buf);
-uint8_t* sbufPtr(sbuf_t *buf);
-const uint8_t* sbufConstPtr(const sbuf_t *buf);
-void sbufAdvance(sbuf_t *buf, int size);
+static inline uint16_t sbufGetU16(const uint8_t *data)
+{
+    return data[0] | data[1] << 8;
+}
 
 void sbufSwitchToReader(sbuf_t *buf, uint8_t * base);
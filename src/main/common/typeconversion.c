@@ -14,11 +14,15 @@
  * You should have received a copy of the GNU General Public License
  * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
  */
+#include <stdbool.h>
 #include <stdint.h>
 #include <string.h>
 #include <math.h>
 #include "build/build_config.h"
 #include "maths.h"
+#include "utils.h"
+
+#include "typeconversion.h"
 
 #ifdef REQUIRE_PRINTF_LONG_SUPPORT
 
@@ -144,6 +148,94 @@ char *itoa(int i, char *a, int base)
 
 #endif
 
+static const char digitPairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+static const uint32_t powersOf10[] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000 };
+
+// Writes at least minDigits digits of value backwards from end, returns the first one
+static char *digitsBackwards(uint32_t value, char *end, uint8_t minDigits)
+{
+    char *p = end;
+    while (value >= 100) {
+        const uint32_t pair = value % 100;
+        value /= 100;
+        p -= 2;
+        p[0] = digitPairs[pair * 2];
+        p[1] = digitPairs[pair * 2 + 1];
+    }
+    if (value >= 10) {
+        p -= 2;
+        p[0] = digitPairs[value * 2];
+        p[1] = digitPairs[value * 2 + 1];
+    } else {
+        *--p = '0' + value;
+    }
+    while (end - p < minDigits) {
+        *--p = '0';
+    }
+    return p;
+}
+
+static char *fmtDigits(char *buf, const char *digits, const char *end, bool negative, uint8_t width, char pad)
+{
+    int length = end - digits + negative;
+    if (negative && pad == '0') {
+        *buf++ = '-';
+    }
+    for (; length < width; length++) {
+        *buf++ = pad;
+    }
+    if (negative && pad != '0') {
+        *buf++ = '-';
+    }
+    while (digits < end) {
+        *buf++ = *digits++;
+    }
+    *buf = '\0';
+    return buf;
+}
+
+char *fmtUint(char *buf, uint32_t value, uint8_t width, char pad)
+{
+    char digits[FMT_INT_BUFFER_LENGTH];
+    char *end = digits + sizeof(digits);
+    return fmtDigits(buf, digitsBackwards(value, end, 1), end, false, width, pad);
+}
+
+char *fmtInt(char *buf, int32_t value, uint8_t width, char pad)
+{
+    char digits[FMT_INT_BUFFER_LENGTH];
+    char *end = digits + sizeof(digits);
+    const uint32_t magnitude = value < 0 ? -(uint32_t)value : (uint32_t)value;
+    return fmtDigits(buf, digitsBackwards(magnitude, end, 1), end, value < 0, width, pad);
+}
+
+char *fmtFixed(char *buf, int32_t value, uint8_t decimals, uint8_t width)
+{
+    char digits[FMT_INT_BUFFER_LENGTH];
+    char *end = digits + sizeof(digits);
+    const uint32_t magnitude = value < 0 ? -(uint32_t)value : (uint32_t)value;
+    char *p = end;
+
+    decimals = MIN(decimals, ARRAYLEN(powersOf10) - 1);
+    if (decimals) {
+        p = digitsBackwards(magnitude % powersOf10[decimals], end, decimals);
+        *--p = '.';
+    }
+    p = digitsBackwards(magnitude / powersOf10[decimals], p, 1);
+    return fmtDigits(buf, p, end, value < 0, width, ' ');
+}
+
 char *ftoa(float x, char *floatString)
 {
     int32_t value;
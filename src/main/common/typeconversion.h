@@ -16,6 +16,8 @@
  */
 #pragma once
 
+#include <stdint.h>
+
 #define FTOA_BUFFER_LENGTH 11
 
 void uli2a(unsigned long int num, unsigned int base, int uc, char *bf);
@@ -26,6 +28,16 @@ char a2i(char ch, const char **src, int base, int *nump);
 char *ftoa(float x, char *floatString);
 float fastA2F(const char *p);
 
+// Formatters for the display and dump paths, no format string and two digits per division.
+// Each writes a terminated string right aligned to at least width, and returns a pointer to
+// the terminator so a unit or symbol can be appended. pad is ' ' or '0', as in %5d and %05d.
+#define FMT_INT_BUFFER_LENGTH 12        // longest int32_t with sign and terminator, or a fixed point with 9 decimals
+
+char *fmtUint(char *buf, uint32_t value, uint8_t width, char pad);
+char *fmtInt(char *buf, int32_t value, uint8_t width, char pad);
+// value in units of 10^-decimals, fmtFixed(buf, -5, 2, 0) is "-0.05"
+char *fmtFixed(char *buf, int32_t value, uint8_t decimals, uint8_t width);
+
 #ifndef HAVE_ITOA_FUNCTION
 char *itoa(int i, char *a, int r);
 #endif
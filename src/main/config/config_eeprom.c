@@ -23,6 +23,7 @@
 
 #include "build/build_config.h"
 
+#include "common/crc.h"
 #include "common/maths.h"
 
 #include "config/config_eeprom.h"
@@ -39,16 +40,25 @@ static uint16_t eepromConfigSize;
 typedef enum {
     CR_CLASSICATION_SYSTEM   = 0,
     CR_CLASSICATION_PROFILE_LAST = CR_CLASSICATION_SYSTEM,
+    CR_DELTA_CODED           = (1 << 2),
 } configRecordFlags_e;
 
 #define CR_CLASSIFICATION_MASK  (0x3)
 #define CRC_START_VALUE         0xFFFF
 #define CRC_CHECK_VALUE         0x1D0F  // pre-calculated value of CRC that includes the CRC itself
 
+/*
+ * The config area starts with a copy of every PG. Later saves append an update holding only the PGs that changed,
+ * so a save doesn't have to erase the flash. Records in later updates replace earlier ones. When the next update
+ * doesn't fit, the area is erased and a new complete copy is written.
+ */
+#define CONFIG_MAGIC_COMPLETE   0xBE
+#define CONFIG_MAGIC_UPDATE     0xBD
+
 // Header for the saved copy.
 typedef struct {
     uint8_t eepromConfigVersion;
-    uint8_t magic_be;           // magic number, should be 0xBE
+    uint8_t magic_be;           // magic number, 0xBE for the complete copy or 0xBD for an update appended to it
     char boardIdentifier[sizeof(TARGET_BOARD_IDENTIFIER)];
 } PG_PACKED configHeader_t;
 
@@ -65,6 +75,20 @@ typedef struct {
     uint8_t pg[];
 } PG_PACKED configRecord_t;
 
+/*
+ * Most of a PG is usually left at its defaults, so a record is delta coded when that is smaller: its data is a list
+ * of runs, each skipping bytes that are the same as the reset defaults of the PG and then giving the bytes that
+ * differ. Anything after the last run is at its defaults.
+ */
+typedef struct {
+    uint8_t skip;
+    uint8_t length;
+    uint8_t data[];
+} PG_PACKED configDeltaRun_t;
+
+#define CONFIG_DELTA_RUN_MAX    255
+#define CONFIG_DELTA_MIN_MATCH  3   // matching bytes that end a run, fewer cost less to repeat than a new run header
+
 // Footer for the saved copy.
 typedef struct {
     uint16_t terminator;
@@ -87,22 +111,32 @@ void initEEPROM(void)
     BUILD_BUG_ON(sizeof(configHeader_t) != 2 + sizeof(TARGET_BOARD_IDENTIFIER));
     BUILD_BUG_ON(sizeof(configFooter_t) != 2);
     BUILD_BUG_ON(sizeof(configRecord_t) != 6);
+    BUILD_BUG_ON(sizeof(configDeltaRun_t) != 2);
 }
 
-// Scan the EEPROM config. Returns true if the config is valid.
-bool isEEPROMContentValid(void)
+// The streamer pads each copy to a whole number of flash words
+static uint32_t alignToWord(uint32_t offset)
+{
+    return (offset + sizeof(uint32_t) - 1) & ~(sizeof(uint32_t) - 1);
+}
+
+// Check one saved copy starting at p. Returns the word aligned end of the copy as written by the streamer, or NULL if
+// the copy is not valid.
+static const uint8_t *scanEEPROMCopy(const uint8_t *p, uint8_t magic)
 {
-    const uint8_t *p = &__config_start;
     const configHeader_t *header = (const configHeader_t *)p;
 
+    if (p + sizeof(*header) >= &__config_end) {
+        return NULL;
+    }
     if (header->eepromConfigVersion != EEPROM_CONF_VERSION) {
-        return false;
+        return NULL;
     }
-    if (header->magic_be != 0xBE) {
-        return false;
+    if (header->magic_be != magic) {
+        return NULL;
     }
     if (strncasecmp(header->boardIdentifier, TARGET_BOARD_IDENTIFIER, sizeof(TARGET_BOARD_IDENTIFIER))) {
-        return false;
+        return NULL;
     }
 
     uint16_t crc = CRC_START_VALUE;
@@ -119,7 +153,7 @@ bool isEEPROMContentValid(void)
         if (p + record->size >= &__config_end
             || record->size < sizeof(*record)) {
             // Too big or too small.
-            return false;
+            return NULL;
         }
 
         crc = crc16_ccitt_update(crc, p, record->size);
@@ -127,6 +161,10 @@ bool isEEPROMContentValid(void)
         p += record->size;
     }
 
+    if (p + sizeof(configFooter_t) + sizeof(uint16_t) > &__config_end) {
+        return NULL;
+    }
+
     const configFooter_t *footer = (const configFooter_t *)p;
     crc = crc16_ccitt_update(crc, footer, sizeof(*footer));
     p += sizeof(*footer);
@@ -134,12 +172,34 @@ bool isEEPROMContentValid(void)
     // include stored CRC in the CRC calculation
     const uint16_t *storedCrc = (const uint16_t *)p;
     crc = crc16_ccitt_update(crc, storedCrc, sizeof(*storedCrc));
-    p += sizeof(storedCrc);
+    p += sizeof(*storedCrc);
+
+    // CRC has the property that if the CRC itself is included in the calculation the resulting CRC will have constant value
+    if (crc != CRC_CHECK_VALUE) {
+        return NULL;
+    }
+
+    return &__config_start + alignToWord(p - &__config_start);
+}
+
+// Scan the EEPROM config. Returns true if the config is valid.
+bool isEEPROMContentValid(void)
+{
+    const uint8_t *p = scanEEPROMCopy(&__config_start, CONFIG_MAGIC_COMPLETE);
+
+    if (!p) {
+        return false;
+    }
+
+    // Follow the updates, stopping at erased flash or at one that was cut short by a reset
+    const uint8_t *next;
+    while ((next = scanEEPROMCopy(p, CONFIG_MAGIC_UPDATE))) {
+        p = next;
+    }
 
     eepromConfigSize = p - &__config_start;
 
-    // CRC has the property that if the CRC itself is included in the calculation the resulting CRC will have constant value
-    return crc == CRC_CHECK_VALUE;
+    return true;
 }
 
 uint16_t getEEPROMConfigSize(void)
@@ -147,26 +207,121 @@ uint16_t getEEPROMConfigSize(void)
     return eepromConfigSize;
 }
 
-// find config record for reg + classification (profile info) in EEPROM
+// find config record for reg + classification (profile info) in EEPROM, the one in the latest update if there are several
 // return NULL when record is not found
 // this function assumes that EEPROM content is valid
 static const configRecord_t *findEEPROM(const pgRegistry_t *reg, configRecordFlags_e classification)
 {
+    const configRecord_t *found = NULL;
     const uint8_t *p = &__config_start;
-    p += sizeof(configHeader_t);             // skip header
-    while (true) {
-        const configRecord_t *record = (const configRecord_t *)p;
-        if (record->size == 0
-            || p + record->size >= &__config_end
-            || record->size < sizeof(*record))
+
+    while (p < &__config_start + eepromConfigSize) {
+        p += sizeof(configHeader_t);             // skip header
+        while (true) {
+            const configRecord_t *record = (const configRecord_t *)p;
+            if (record->size == 0
+                || p + record->size >= &__config_end
+                || record->size < sizeof(*record))
+                break;
+            if (pgN(reg) == record->pgn
+                && (record->flags & CR_CLASSIFICATION_MASK) == classification)
+                found = record;
+            p += record->size;
+        }
+        // skip footer and CRC, the next copy starts on a word boundary
+        p += sizeof(configFooter_t) + sizeof(uint16_t);
+        p = &__config_start + alignToWord(p - &__config_start);
+    }
+
+    return found;
+}
+
+// Apply the runs of a delta coded record to a copy of the PG that holds its defaults
+static void applyDeltaRecord(const configRecord_t *rec, uint8_t *base, int size)
+{
+    const uint8_t *p = rec->pg;
+    const uint8_t *end = (const uint8_t *)rec + rec->size;
+    int offset = 0;
+
+    while (p + sizeof(configDeltaRun_t) <= end) {
+        const configDeltaRun_t *run = (const configDeltaRun_t *)p;
+        offset += run->skip;
+        if (offset + run->length > size || p + sizeof(*run) + run->length > end) {
+            // saved by a build with a bigger PG, the rest is left at its defaults
             break;
-        if (pgN(reg) == record->pgn
-            && (record->flags & CR_CLASSIFICATION_MASK) == classification)
-            return record;
-        p += record->size;
+        }
+        memcpy(base + offset, run->data, run->length);
+        offset += run->length;
+        p += sizeof(*run) + run->length;
+    }
+}
+
+// Delta code the PG against its defaults, which have to be in reg->copy. Returns the size of the coded data, which
+// is written out as well when write is set.
+static uint16_t deltaCodePg(const pgRegistry_t *reg, void (*write)(const void *, uint32_t))
+{
+    const uint8_t *value = reg->address;
+    const uint8_t *defaults = reg->copy;
+    const int size = pgSize(reg);
+    uint16_t codedSize = 0;
+    int offset = 0;
+
+    while (offset < size) {
+        int skip = 0;
+        while (offset + skip < size && skip < CONFIG_DELTA_RUN_MAX && value[offset + skip] == defaults[offset + skip]) {
+            skip++;
+        }
+        if (offset + skip == size) {
+            break;
+        }
+
+        const int start = offset + skip;
+        int length = 0;
+        int matching = 0;
+        while (start + length < size && length < CONFIG_DELTA_RUN_MAX) {
+            if (value[start + length] != defaults[start + length]) {
+                matching = 0;
+            } else if (++matching == CONFIG_DELTA_MIN_MATCH) {
+                length -= CONFIG_DELTA_MIN_MATCH - 1;
+                break;
+            }
+            length++;
+        }
+
+        if (write) {
+            const configDeltaRun_t run = { .skip = skip, .length = length };
+            write(&run, sizeof(run));
+            write(value + start, length);
+        }
+        codedSize += sizeof(configDeltaRun_t) + length;
+        offset = start + length;
+    }
+
+    return codedSize;
+}
+
+// Size of the data of the record the PG is saved in, delta coded when that is smaller
+static uint16_t recordDataSize(const pgRegistry_t *reg)
+{
+    pgResetCopy(reg->copy, pgN(reg));
+    return MIN(deltaCodePg(reg, NULL), pgSize(reg));
+}
+
+// Returns true if the saved copy of the PG is the same as the one in RAM
+static bool isEEPROMRecordCurrent(const pgRegistry_t *reg)
+{
+    const configRecord_t *rec = findEEPROM(reg, CR_CLASSICATION_SYSTEM);
+
+    if (!rec || rec->version != pgVersion(reg)) {
+        return false;
     }
-    // record not found
-    return NULL;
+    if (rec->flags & CR_DELTA_CODED) {
+        pgResetCopy(reg->copy, pgN(reg));
+        applyDeltaRecord(rec, reg->copy, pgSize(reg));
+        return memcmp(reg->copy, reg->address, pgSize(reg)) == 0;
+    }
+    return rec->size == sizeof(configRecord_t) + pgSize(reg)
+        && memcmp(rec->pg, reg->address, pgSize(reg)) == 0;
 }
 
 // Initialize all PG records from EEPROM.
@@ -176,7 +331,13 @@ bool loadEEPROM(void)
 {
     PG_FOREACH(reg) {
         const configRecord_t *rec = findEEPROM(reg, CR_CLASSICATION_SYSTEM);
-        if (rec) {
+        if (rec && (rec->flags & CR_DELTA_CODED)) {
+            // a record of another version is left at the defaults, like pgLoad does
+            pgReset(reg);
+            if (rec->version == pgVersion(reg)) {
+                applyDeltaRecord(rec, reg->address, pgSize(reg));
+            }
+        } else if (rec) {
             // config from EEPROM is available, use it to initialize PG. pgLoad will handle version mismatch
             pgLoad(reg, rec->pg, rec->size - offsetof(configRecord_t, pg), rec->version);
         } else {
@@ -186,54 +347,171 @@ bool loadEEPROM(void)
     return true;
 }
 
-static bool writeSettingsToEEPROM(void)
-{
+/*
+ * A write in progress, so it can be streamed to the flash a few records at a time. Each call writes whole records so
+ * the data of a PG is saved as it was at one moment, even if it is changed between calls.
+ */
+#define CONFIG_WRITE_PGS_PER_CALL   16  // finding whether a PG has changed scans the saved config
+
+static struct {
     config_streamer_t streamer;
-    config_streamer_init(&streamer);
+    const pgRegistry_t *reg;    // next PG to write
+    uint8_t *end;               // end of the space checked to be erased for an update
+    uint16_t crc;
+    uint8_t magic;
+    bool inProgress;
+    bool overflow;              // a PG changed after the update was sized, it is left for the next write
+} configWrite;
+
+static void configWriteBytes(const void *p, uint32_t size)
+{
+    config_streamer_write(&configWrite.streamer, p, size);
+    configWrite.crc = crc16_ccitt_update(configWrite.crc, p, size);
+}
+
+// Start writing the config. Returns false if the config saved already matches the one in RAM, so nothing is written.
+bool beginConfigWriteToEEPROM(void)
+{
+    uint8_t magic = CONFIG_MAGIC_COMPLETE;
+    uint8_t *base = &__config_start;
+    uint8_t *end = &__config_end;
+
+    // Append an update with just the changed PGs if it fits after the saved copies
+    if (isEEPROMContentValid()) {
+        uint32_t updateSize = sizeof(configHeader_t) + sizeof(configFooter_t) + sizeof(uint16_t);
+        PG_FOREACH(reg) {
+            if (!isEEPROMRecordCurrent(reg)) {
+                updateSize += sizeof(configRecord_t) + recordDataSize(reg);
+            }
+        }
 
-    config_streamer_start(&streamer, (uintptr_t)&__config_start, &__config_end - &__config_start);
+        if (updateSize == sizeof(configHeader_t) + sizeof(configFooter_t) + sizeof(uint16_t)) {
+            // Nothing has changed
+            return false;
+        }
+
+        updateSize = alignToWord(updateSize);
+        if (eepromConfigSize + updateSize <= (uint32_t)(&__config_end - &__config_start)
+            && config_streamer_isErased((uintptr_t)&__config_start + eepromConfigSize, updateSize)) {
+            magic = CONFIG_MAGIC_UPDATE;
+            base += eepromConfigSize;
+            end = base + updateSize;
+        }
+    }
+
+    config_streamer_init(&configWrite.streamer);
+    config_streamer_start(&configWrite.streamer, (uintptr_t)base, &__config_end - base);
+
+    configWrite.reg = __pg_registry_start;
+    configWrite.end = end;
+    configWrite.crc = CRC_START_VALUE;
+    configWrite.magic = magic;
+    configWrite.inProgress = true;
+    configWrite.overflow = false;
 
     configHeader_t header = {
         .eepromConfigVersion =  EEPROM_CONF_VERSION,
-        .magic_be =             0xBE,
+        .magic_be =             magic,
         .boardIdentifier =      TARGET_BOARD_IDENTIFIER,
     };
 
-    config_streamer_write(&streamer, (uint8_t *)&header, sizeof(header));
-    uint16_t crc = CRC_START_VALUE;
-    crc = crc16_ccitt_update(crc, (uint8_t *)&header, sizeof(header));
-    PG_FOREACH(reg) {
+    configWriteBytes(&header, sizeof(header));
+
+    return true;
+}
+
+// Write records until at least maxBytes have been written, or CONFIG_WRITE_PGS_PER_CALL PGs have been looked at.
+// Returns the state of the write.
+configWriteStatus_e continueConfigWriteToEEPROM(uint32_t maxBytes)
+{
+    if (!configWrite.inProgress) {
+        return CONFIG_WRITE_IDLE;
+    }
+
+    const uintptr_t startAddress = configWrite.streamer.address;
+    const pgRegistry_t *lastReg = MIN(configWrite.reg + CONFIG_WRITE_PGS_PER_CALL, __pg_registry_end);
+
+    for (; configWrite.reg < lastReg && configWrite.streamer.address - startAddress < maxBytes; configWrite.reg++) {
+        const pgRegistry_t *reg = configWrite.reg;
+
+        if (configWrite.magic == CONFIG_MAGIC_UPDATE && isEEPROMRecordCurrent(reg)) {
+            continue;
+        }
+
         const uint16_t regSize = pgSize(reg);
+        const uint16_t dataSize = recordDataSize(reg);
         configRecord_t record = {
-            .size = sizeof(configRecord_t) + regSize,
+            .size = sizeof(configRecord_t) + dataSize,
             .pgn = pgN(reg),
             .version = pgVersion(reg),
             .flags = 0
         };
 
+        // Leave room for the footer and CRC
+        if (configWrite.streamer.address + configWrite.streamer.at + record.size + sizeof(configFooter_t) + sizeof(uint16_t)
+            > (uintptr_t)configWrite.end) {
+            configWrite.overflow = true;
+            continue;
+        }
+
         record.flags |= CR_CLASSICATION_SYSTEM;
-        config_streamer_write(&streamer, (uint8_t *)&record, sizeof(record));
-        crc = crc16_ccitt_update(crc, (uint8_t *)&record, sizeof(record));
-        config_streamer_write(&streamer, reg->address, regSize);
-        crc = crc16_ccitt_update(crc, reg->address, regSize);
+        if (dataSize < regSize) {
+            record.flags |= CR_DELTA_CODED;
+            configWriteBytes(&record, sizeof(record));
+            deltaCodePg(reg, configWriteBytes);
+        } else {
+            configWriteBytes(&record, sizeof(record));
+            configWriteBytes(reg->address, regSize);
+        }
+    }
+
+    if (configWrite.reg < __pg_registry_end && config_streamer_status(&configWrite.streamer) == 0) {
+        return CONFIG_WRITE_IN_PROGRESS;
     }
 
     configFooter_t footer = {
         .terminator = 0,
     };
 
-    config_streamer_write(&streamer, (uint8_t *)&footer, sizeof(footer));
-    crc = crc16_ccitt_update(crc, (uint8_t *)&footer, sizeof(footer));
+    configWriteBytes(&footer, sizeof(footer));
 
     // include inverted CRC in big endian format in the CRC
-    const uint16_t invertedBigEndianCrc = ~(((crc & 0xFF) << 8) | (crc >> 8));
-    config_streamer_write(&streamer, (uint8_t *)&invertedBigEndianCrc, sizeof(crc));
+    const uint16_t invertedBigEndianCrc = ~(((configWrite.crc & 0xFF) << 8) | (configWrite.crc >> 8));
+    config_streamer_write(&configWrite.streamer, (uint8_t *)&invertedBigEndianCrc, sizeof(invertedBigEndianCrc));
+
+    config_streamer_flush(&configWrite.streamer);
+
+    configWrite.inProgress = false;
+
+    if (config_streamer_finish(&configWrite.streamer) != 0 || !isEEPROMContentValid()) {
+        return CONFIG_WRITE_FAILED;
+    }
+
+    if (configWrite.overflow) {
+        // A PG that changed after an update was started still needs to be written, a complete copy that doesn't fit
+        // can't be saved
+        return configWrite.magic == CONFIG_MAGIC_UPDATE ? CONFIG_WRITE_INCOMPLETE : CONFIG_WRITE_FAILED;
+    }
 
-    config_streamer_flush(&streamer);
+    return CONFIG_WRITE_IDLE;
+}
 
-    const bool success = config_streamer_finish(&streamer) == 0;
+bool isConfigWriteInProgress(void)
+{
+    return configWrite.inProgress;
+}
+
+static bool writeSettingsToEEPROM(void)
+{
+    configWriteStatus_e status = CONFIG_WRITE_INCOMPLETE;
+
+    while (status == CONFIG_WRITE_INCOMPLETE && beginConfigWriteToEEPROM()) {
+        do {
+            status = continueConfigWriteToEEPROM(UINT32_MAX);
+        } while (status == CONFIG_WRITE_IN_PROGRESS);
+    }
 
-    return success;
+    return status != CONFIG_WRITE_FAILED;
 }
 
 void writeConfigToEEPROM(void)
@@ -246,7 +524,7 @@ void writeConfigToEEPROM(void)
         }
     }
 
-    if (success && isEEPROMContentValid()) {
+    if (success) {
         return;
     }
 
@@ -20,9 +20,19 @@
 #include <stdint.h>
 #include <stdbool.h>
 
-#define EEPROM_CONF_VERSION 159
+#define EEPROM_CONF_VERSION 160
+
+typedef enum {
+    CONFIG_WRITE_IDLE = 0,
+    CONFIG_WRITE_IN_PROGRESS,
+    CONFIG_WRITE_INCOMPLETE,    // written, but some changes were left for another write
+    CONFIG_WRITE_FAILED,
+} configWriteStatus_e;
 
 bool isEEPROMContentValid(void);
 bool loadEEPROM(void);
 void writeConfigToEEPROM(void);
+bool beginConfigWriteToEEPROM(void);
+configWriteStatus_e continueConfigWriteToEEPROM(uint32_t maxBytes);
+bool isConfigWriteInProgress(void);
 uint16_t getEEPROMConfigSize(void);
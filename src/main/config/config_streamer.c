@@ -19,6 +19,8 @@
 
 #include "platform.h"
 
+#include "common/maths.h"
+
 #include "drivers/system.h"
 
 #include "config/config_streamer.h"
@@ -263,6 +265,23 @@ static int write_word(config_streamer_t *c, uint32_t value)
     return 0;
 }
 
+/*
+ * Check that streaming size bytes starting at base only programs erased flash, so it can be done without erasing the
+ * data before base. Pages the write enters at their start are erased by the streamer, so only the page base is in
+ * needs checking.
+ */
+bool config_streamer_isErased(uintptr_t base, int size)
+{
+    const uintptr_t pageEnd = base - base % FLASH_PAGE_SIZE + FLASH_PAGE_SIZE;
+
+    for (const uint8_t *p = (const uint8_t *)base; (uintptr_t)p < MIN(base + size, pageEnd); p++) {
+        if (*p != 0xFF) {
+            return false;
+        }
+    }
+    return true;
+}
+
 int config_streamer_write(config_streamer_t *c, const uint8_t *p, uint32_t size)
 {
     for (const uint8_t *pat = p; pat != (uint8_t*)p + size; pat++) {
@@ -296,6 +315,8 @@ int config_streamer_finish(config_streamer_t *c)
     if (c->unlocked) {
 #if defined(STM32F7)
         HAL_FLASH_Lock();
+        // the data cache still holds what the config flash read before it was erased
+        SCB_CleanInvalidateDCache();
 #else
         FLASH_Lock();
 #endif
@@ -85,6 +85,29 @@ int pgStore(const pgRegistry_t* reg, void *to, int size)
     return take;
 }
 
+// FNV-1a, the groups are small and a change in any byte has to show
+static uint32_t pgHash(const pgRegistry_t* reg)
+{
+    const uint8_t *p = pgOffset(reg);
+    uint32_t hash = 2166136261U;
+    for (int i = 0; i < pgSize(reg); i++) {
+        hash = (hash ^ p[i]) * 16777619U;
+    }
+    return hash;
+}
+
+// Counts the changes of the group. A subsystem keeps the generation it set itself up from and only
+// has to set itself up again once the group reports a different one.
+uint16_t pgGeneration(const pgRegistry_t* reg)
+{
+    const uint32_t hash = pgHash(reg);
+    if (hash != reg->changes->hash) {
+        reg->changes->hash = hash;
+        reg->changes->generation++;
+    }
+    return reg->changes->generation;
+}
+
 void pgResetAll()
 {
     PG_FOREACH(reg) {
@@ -40,6 +40,12 @@ typedef enum {
 // function that resets a single parameter group instance
 typedef void (pgResetFunc)(void * /* base */, int /* size */);
 
+// Groups are written in place from many places, so changes are found by looking at the contents
+typedef struct pgChanges_s {
+    uint32_t hash;         // Hash of the group when it was last looked at
+    uint16_t generation;   // Bumped every time the group was found to have changed
+} pgChanges_t;
+
 typedef struct pgRegistry_s {
     pgn_t pgn;             // The parameter group number, the top 4 bits are reserved for version
     uint16_t size;         // Size of the group in RAM, the top 4 bits are reserved for flags
@@ -50,12 +56,15 @@ typedef struct pgRegistry_s {
         void *ptr;         // Pointer to init template
         pgResetFunc *fn;   // Popinter to pgResetFunc
     } reset;
+    pgChanges_t *changes;  // Change tracking of the group, see pgGeneration()
 } pgRegistry_t;
 
 static inline uint16_t pgN(const pgRegistry_t* reg) {return reg->pgn & PGR_PGN_MASK;}
 static inline uint8_t pgVersion(const pgRegistry_t* reg) {return (uint8_t)(reg->pgn >> 12);}
 static inline uint16_t pgSize(const pgRegistry_t* reg) {return reg->size & PGR_SIZE_MASK;}
 
+uint16_t pgGeneration(const pgRegistry_t* reg);
+
 #define PG_PACKED __attribute__((packed))
 
 #ifdef __APPLE__
@@ -94,8 +103,10 @@ extern const uint8_t __pg_resetdata_end[];
 #define PG_DECLARE(_type, _name)                                        \
     extern _type _name ## _System;                                      \
     extern _type _name ## _Copy;                                        \
+    extern const pgRegistry_t _name ## _Registry;                       \
     static inline const _type* _name(void) { return &_name ## _System; }\
     static inline _type* _name ## Mutable(void) { return &_name ## _System; }\
+    static inline uint16_t _name ## Generation(void) { return pgGeneration(&_name ## _Registry); }\
     struct _dummy                                                       \
     /**/
 
@@ -103,9 +114,11 @@ extern const uint8_t __pg_resetdata_end[];
 #define PG_DECLARE_ARRAY(_type, _size, _name)                           \
     extern _type _name ## _SystemArray[_size];                          \
     extern _type _name ## _CopyArray[_size];                            \
+    extern const pgRegistry_t _name ## _Registry;                       \
     static inline const _type* _name(int _index) { return &_name ## _SystemArray[_index]; } \
     static inline _type* _name ## Mutable(int _index) { return &_name ## _SystemArray[_index]; } \
     static inline _type (* _name ## _array(void))[_size] { return &_name ## _SystemArray; } \
+    static inline uint16_t _name ## Generation(void) { return pgGeneration(&_name ## _Registry); } \
     struct _dummy                                                       \
     /**/
 
@@ -113,6 +126,7 @@ extern const uint8_t __pg_resetdata_end[];
 #define PG_REGISTER_I(_type, _name, _pgn, _version, _reset)             \
     _type _name ## _System;                                             \
     _type _name ## _Copy;                                               \
+    pgChanges_t _name ## _Changes;                                      \
     /* Force external linkage for g++. Catch multi registration */      \
     extern const pgRegistry_t _name ## _Registry;                       \
     const pgRegistry_t _name ##_Registry PG_REGISTER_ATTRIBUTES = {     \
@@ -122,6 +136,7 @@ extern const uint8_t __pg_resetdata_end[];
         .copy = (uint8_t*)&_name ## _Copy,                              \
         .ptr = 0,                                                       \
         _reset,                                                         \
+        .changes = &_name ## _Changes,                                  \
     }                                                                   \
     /**/
 
@@ -143,6 +158,7 @@ extern const uint8_t __pg_resetdata_end[];
 #define PG_REGISTER_ARRAY_I(_type, _size, _name, _pgn, _version, _reset)  \
     _type _name ## _SystemArray[_size];                                 \
     _type _name ## _CopyArray[_size];                                   \
+    pgChanges_t _name ## _Changes;                                      \
     extern const pgRegistry_t _name ##_Registry;                        \
     const pgRegistry_t _name ## _Registry PG_REGISTER_ATTRIBUTES = {    \
         .pgn = _pgn | (_version << 12),                                 \
@@ -151,6 +167,7 @@ extern const uint8_t __pg_resetdata_end[];
         .copy = (uint8_t*)&_name ## _CopyArray,                         \
         .ptr = 0,                                                       \
         _reset,                                                         \
+        .changes = &_name ## _Changes,                                  \
     }                                                                   \
     /**/
 
@@ -111,7 +111,10 @@
 #define PG_SPI_PIN_CONFIG 520
 #define PG_ESCSERIAL_CONFIG 521
 #define PG_CAMERA_CONTROL_CONFIG 522
-#define PG_BETAFLIGHT_END 522
+#define PG_RPM_FILTER_CONFIG 523
+#define PG_GYRO_BIAS_TABLE 524
+#define PG_PERF_RECORD 525
+#define PG_BETAFLIGHT_END 525
 
 
 // OSD configuration (subject to change)
@@ -19,6 +19,7 @@
 
 #include "platform.h"
 #include "common/axis.h"
+#include "common/time.h"
 #include "drivers/exti.h"
 #include "drivers/bus.h"
 #include "drivers/sensor.h"
@@ -47,6 +48,8 @@ typedef enum {
     GYRO_RATE_32_kHz,
 } gyroRateKHz_e;
 
+#define GYRO_FIFO_SAMPLES_MAX 16    // samples burst read from the gyro FIFO in one loop
+
 typedef struct gyroDev_s {
     sensorGyroInitFuncPtr initFn;                             // initialize function
     sensorGyroReadFuncPtr readFn;                             // read 3 axis data function
@@ -56,13 +59,14 @@ typedef struct gyroDev_s {
     busDevice_t bus;
     float scale;                                            // scalefactor
     int32_t gyroZero[XYZ_AXIS_COUNT];
-    int32_t gyroADC[XYZ_AXIS_COUNT];                        // gyro data after calibration and alignment
     int16_t gyroADCRaw[XYZ_AXIS_COUNT];
     int16_t temperature;
     uint8_t lpf;
     gyroRateKHz_e gyroRateKHz;
     uint8_t mpuDividerDrops;
     bool dataReady;
+    volatile timeUs_t dataReadyTimeUs;                      // time of the last data ready interrupt, 0 if the gyro is polled
+    volatile uint32_t dataReadyCount;                       // data ready interrupts so far, the last of them at dataReadyTimeUs
 #if defined(SIMULATOR_BUILD) && defined(SIMULATOR_MULTITHREAD)
     pthread_mutex_t lock;
 #endif
@@ -70,6 +74,18 @@ typedef struct gyroDev_s {
     mpuDetectionResult_t mpuDetectionResult;
     ioTag_t mpuIntExtiTag;
     mpuConfiguration_t mpuConfiguration;
+#ifdef USE_GYRO_DMA
+    bool dmaEnabled;
+    volatile bool dmaSampleReady;                           // set by the DMA completion interrupt
+    int16_t dmaSample[XYZ_AXIS_COUNT];
+#endif
+#ifdef USE_GYRO_FIFO
+    sensorGyroReadFuncPtr readFifoFn;                         // read the samples queued in the FIFO, NULL if the driver has no FIFO support
+    bool fifoEnabled;
+    uint16_t fifoSpiDivisor;                                // SPI clock the driver reads at
+    uint8_t fifoSampleCount;
+    int16_t fifoData[GYRO_FIFO_SAMPLES_MAX][XYZ_AXIS_COUNT]; // oldest first
+#endif
 } gyroDev_t;
 
 typedef struct accDev_s {
@@ -33,9 +33,253 @@
 #include "drivers/accgyro/accgyro.h"
 #include "drivers/accgyro/accgyro_fake.h"
 
+#ifdef USE_FAKE_GYRO_MODEL
+#include <math.h>
+
+#include "common/maths.h"
+#include "common/time.h"
+
+#include "drivers/time.h"
+#endif
+
 static int16_t fakeGyroADC[XYZ_AXIS_COUNT];
 gyroDev_t *fakeGyroDev;
 
+#ifdef USE_FAKE_GYRO_MODEL
+/*
+ * The value set by fakeGyroSet() is sampled at the gyro rate, less the divider, with the motor vibration
+ * and white noise added and rounded to the resolution. Samples are queued as in the gyro FIFO, and only
+ * become readable latencyUs after they were taken. Polled reads return the newest readable sample, as
+ * the data registers would.
+ */
+
+#define FAKE_GYRO_FIFO_SIZE     128     // samples, a power of two, close to what the MPU6000 FIFO holds
+
+typedef struct fakeGyroSample_s {
+    timeUs_t timeUs;
+    int16_t data[XYZ_AXIS_COUNT];
+} fakeGyroSample_t;
+
+static bool fakeGyroModelOn;
+static fakeGyroModel_t fakeGyroModel;
+static fakeGyroSample_t fakeGyroFifo[FAKE_GYRO_FIFO_SIZE];
+static uint32_t fakeGyroTakenCount;
+static uint32_t fakeGyroReadyCount;
+static uint32_t fakeGyroReadCount;
+static timeUs_t fakeGyroNextSampleUs;
+static uint32_t fakeGyroPeriodUs;
+static float fakeGyroPeriodFractionUs;
+static float fakeGyroFractionUs;
+static float fakeGyroMotorPhaseStep;
+static float fakeGyroMotorPhase;
+static float fakeGyroLsbPerDps;
+static uint32_t fakeGyroNoiseSeed = 0x12345678; // fixed, so a lockstep run gives the same noise every time
+
+void fakeGyroSetModel(const fakeGyroModel_t *model)
+{
+    fakeGyroModelOn = model != NULL;
+    if (model) {
+        fakeGyroModel = *model;
+    }
+}
+
+static float fakeGyroNoise(void)
+{
+    // xorshift32 for two uniforms, and Box-Muller for a normal distribution
+    float u[2];
+    for (int i = 0; i < 2; i++) {
+        fakeGyroNoiseSeed ^= fakeGyroNoiseSeed << 13;
+        fakeGyroNoiseSeed ^= fakeGyroNoiseSeed >> 17;
+        fakeGyroNoiseSeed ^= fakeGyroNoiseSeed << 5;
+        u[i] = (fakeGyroNoiseSeed + 1.0f) / 4294967296.0f;
+    }
+    return sqrtf(-2.0f * logf(u[0])) * cosf(2.0f * M_PIf * u[1]);
+}
+
+static float fakeGyroVibration(void)
+{
+    float vibration = 0.0f;
+    float amplitude = fakeGyroModel.motorDps;
+    for (int harmonic = 1; harmonic <= fakeGyroModel.motorHarmonics; harmonic++) {
+        vibration += amplitude * sinf(harmonic * fakeGyroMotorPhase);
+        amplitude *= 0.5f;
+    }
+    fakeGyroMotorPhase += fakeGyroMotorPhaseStep;
+    if (fakeGyroMotorPhase >= 2.0f * M_PIf) {
+        fakeGyroMotorPhase -= 2.0f * M_PIf;
+    }
+    return vibration;
+}
+
+static void fakeGyroSampleUntil(timeUs_t nowUs)
+{
+    if (!fakeGyroPeriodUs) {
+        return; // the gyro is not initialised yet
+    }
+    while (cmpTimeUs(nowUs, fakeGyroNextSampleUs) >= 0) {
+        fakeGyroSample_t *sample = &fakeGyroFifo[fakeGyroTakenCount++ & (FAKE_GYRO_FIFO_SIZE - 1)];
+        sample->timeUs = fakeGyroNextSampleUs;
+
+        const float vibration = fakeGyroVibration();
+        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            float value = fakeGyroADC[axis] + (vibration + fakeGyroModel.noiseDps * fakeGyroNoise()) * fakeGyroLsbPerDps;
+            if (fakeGyroModel.quantisationLsb > 1) {
+                value = roundf(value / fakeGyroModel.quantisationLsb) * fakeGyroModel.quantisationLsb;
+            }
+            sample->data[axis] = lrintf(constrainf(value, INT16_MIN, INT16_MAX));
+        }
+
+        fakeGyroNextSampleUs += fakeGyroPeriodUs;
+        fakeGyroFractionUs += fakeGyroPeriodFractionUs;
+        if (fakeGyroFractionUs >= 1.0f) {
+            fakeGyroFractionUs -= 1.0f;
+            fakeGyroNextSampleUs++;
+        }
+    }
+}
+
+static bool fakeGyroSampleIsReady(uint32_t index, timeUs_t nowUs)
+{
+    return index != fakeGyroTakenCount && cmpTimeUs(nowUs, fakeGyroFifo[index & (FAKE_GYRO_FIFO_SIZE - 1)].timeUs + fakeGyroModel.latencyUs) >= 0;
+}
+
+static bool fakeGyroIsrUpdateActive(const gyroDev_t *gyro)
+{
+#ifdef USE_GYRO_FIFO
+    if (gyro->fifoEnabled) {
+        return false;
+    }
+#endif
+    return fakeGyroModel.dataReadyInterrupt && gyro->updateFn;
+}
+
+// Takes the samples due by now, the data ready interrupt then makes them readable one at a time
+static void fakeGyroAdvance(const gyroDev_t *gyro, timeUs_t nowUs)
+{
+    fakeGyroSampleUntil(nowUs);
+    if (!fakeGyroIsrUpdateActive(gyro)) {
+        while (fakeGyroSampleIsReady(fakeGyroReadyCount, nowUs)) {
+            fakeGyroReadyCount++;
+        }
+    }
+}
+
+static void fakeGyroModelInit(gyroDev_t *gyro)
+{
+    float periodUs;
+    switch (gyro->gyroRateKHz) {
+    case GYRO_RATE_32_kHz:
+        periodUs = 31.25f;
+        break;
+    case GYRO_RATE_8_kHz:
+        periodUs = 125.0f;
+        break;
+    case GYRO_RATE_3200_Hz:
+        periodUs = 312.5f;
+        break;
+    default:
+        periodUs = 1000.0f;
+        break;
+    }
+    periodUs *= gyro->mpuDividerDrops + 1;
+
+    fakeGyroPeriodUs = (uint32_t)periodUs;
+    fakeGyroPeriodFractionUs = periodUs - fakeGyroPeriodUs;
+    fakeGyroFractionUs = 0.0f;
+    fakeGyroNextSampleUs = micros();
+    fakeGyroTakenCount = 0;
+    fakeGyroReadyCount = 0;
+    fakeGyroReadCount = 0;
+    fakeGyroMotorPhase = 0.0f;
+    fakeGyroMotorPhaseStep = 2.0f * M_PIf * fakeGyroModel.motorHz * periodUs * 1e-6f;
+    fakeGyroLsbPerDps = 1.0f / gyro->scale;
+}
+
+static bool fakeGyroReadModel(gyroDev_t *gyro)
+{
+    gyroDevLock(gyro);
+    fakeGyroAdvance(gyro, micros());
+    if (fakeGyroReadyCount == fakeGyroReadCount) {
+        gyroDevUnLock(gyro);
+        return false;
+    }
+    const fakeGyroSample_t *sample = &fakeGyroFifo[(fakeGyroReadyCount - 1) & (FAKE_GYRO_FIFO_SIZE - 1)];
+    gyro->gyroADCRaw[X] = sample->data[X];
+    gyro->gyroADCRaw[Y] = sample->data[Y];
+    gyro->gyroADCRaw[Z] = sample->data[Z];
+    fakeGyroReadCount = fakeGyroReadyCount;
+
+    gyroDevUnLock(gyro);
+    return true;
+}
+
+#ifdef USE_GYRO_FIFO
+static bool fakeGyroReadFifo(gyroDev_t *gyro)
+{
+    gyroDevLock(gyro);
+    fakeGyroAdvance(gyro, micros());
+    if (fakeGyroTakenCount - fakeGyroReadCount > FAKE_GYRO_FIFO_SIZE) {
+        // overflowed while the loop was held up, the MPU driver resets its FIFO and loses the samples too
+        fakeGyroReadCount = fakeGyroReadyCount;
+        gyro->fifoSampleCount = 0;
+        gyroDevUnLock(gyro);
+        return false;
+    }
+    const uint8_t sampleCount = MIN(fakeGyroReadyCount - fakeGyroReadCount, GYRO_FIFO_SAMPLES_MAX);
+    if (sampleCount == 0) {
+        gyroDevUnLock(gyro);
+        return false;
+    }
+    for (int i = 0; i < sampleCount; i++) {
+        const fakeGyroSample_t *sample = &fakeGyroFifo[fakeGyroReadCount++ & (FAKE_GYRO_FIFO_SIZE - 1)];
+        gyro->fifoData[i][X] = sample->data[X];
+        gyro->fifoData[i][Y] = sample->data[Y];
+        gyro->fifoData[i][Z] = sample->data[Z];
+    }
+    gyro->fifoSampleCount = sampleCount;
+
+    gyro->gyroADCRaw[X] = gyro->fifoData[sampleCount - 1][X];
+    gyro->gyroADCRaw[Y] = gyro->fifoData[sampleCount - 1][Y];
+    gyro->gyroADCRaw[Z] = gyro->fifoData[sampleCount - 1][Z];
+
+    gyroDevUnLock(gyro);
+    return true;
+}
+#endif
+
+// Returns false unless the model raises data ready, see fakeGyroModel_t
+bool fakeGyroSetIsrUpdate(gyroDev_t *gyro, sensorGyroUpdateFuncPtr updateFn)
+{
+    if (!fakeGyroModelOn || !fakeGyroModel.dataReadyInterrupt) {
+        return false;
+    }
+    gyro->updateFn = updateFn;
+    return true;
+}
+
+// Stands in for the data ready interrupt, to be called whenever time has moved on
+void fakeGyroUpdate(void)
+{
+    gyroDev_t *gyro = fakeGyroDev;
+    if (!fakeGyroModelOn || !gyro) {
+        return;
+    }
+    const timeUs_t nowUs = micros();
+
+    gyroDevLock(gyro);
+    fakeGyroSampleUntil(nowUs);
+    gyroDevUnLock(gyro);
+
+    while (fakeGyroIsrUpdateActive(gyro) && fakeGyroSampleIsReady(fakeGyroReadyCount, nowUs)) {
+        const fakeGyroSample_t *sample = &fakeGyroFifo[fakeGyroReadyCount++ & (FAKE_GYRO_FIFO_SIZE - 1)];
+        gyro->dataReady = true;
+        gyro->dataReadyTimeUs = sample->timeUs + fakeGyroModel.latencyUs;
+        gyro->dataReadyCount++;
+        gyro->updateFn(gyro);
+    }
+}
+#endif
+
 static void fakeGyroInit(gyroDev_t *gyro)
 {
     fakeGyroDev = gyro;
@@ -44,12 +288,24 @@ static void fakeGyroInit(gyroDev_t *gyro)
         printf("Create gyro lock error!\n");
     }
 #endif
+#ifdef USE_FAKE_GYRO_MODEL
+    if (fakeGyroModelOn) {
+        fakeGyroModelInit(gyro);
+    }
+#endif
 }
 
 void fakeGyroSet(gyroDev_t *gyro, int16_t x, int16_t y, int16_t z)
 {
     gyroDevLock(gyro);
 
+#ifdef USE_FAKE_GYRO_MODEL
+    if (fakeGyroModelOn) {
+        // the samples up to now still see the previous value
+        fakeGyroSampleUntil(micros());
+    }
+#endif
+
     fakeGyroADC[X] = x;
     fakeGyroADC[Y] = y;
     fakeGyroADC[Z] = z;
@@ -87,6 +343,14 @@ bool fakeGyroDetect(gyroDev_t *gyro)
 {
     gyro->initFn = fakeGyroInit;
     gyro->readFn = fakeGyroRead;
+#ifdef USE_FAKE_GYRO_MODEL
+    if (fakeGyroModelOn) {
+        gyro->readFn = fakeGyroReadModel;
+#ifdef USE_GYRO_FIFO
+        gyro->readFifoFn = fakeGyroReadFifo;
+#endif
+    }
+#endif
     gyro->temperatureFn = fakeGyroReadTemperature;
 #if defined(SIMULATOR_BUILD)
     gyro->scale = 1.0f / 16.4f;
@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include "drivers/sensor.h"
+
 struct accDev_s;
 extern struct accDev_s *fakeAccDev;
 bool fakeAccDetect(struct accDev_s *acc);
@@ -26,3 +28,20 @@ struct gyroDev_s;
 extern struct gyroDev_s *fakeGyroDev;
 bool fakeGyroDetect(struct gyroDev_s *gyro);
 void fakeGyroSet(struct gyroDev_s *gyro, int16_t x, int16_t y, int16_t z);
+
+#ifdef USE_FAKE_GYRO_MODEL
+// Turns the value set by fakeGyroSet() into samples the way a real gyro would. Off until fakeGyroSetModel() is called.
+typedef struct fakeGyroModel_s {
+    float noiseDps;             // rms of the white noise
+    float motorHz;              // frequency of the motor vibration, 0 for none
+    float motorDps;             // amplitude of its fundamental, each harmonic has half the amplitude of the one below
+    uint8_t motorHarmonics;     // lines of the motor vibration, the fundamental included
+    uint8_t quantisationLsb;    // step the samples are rounded to, 0 or 1 for the full resolution
+    uint16_t latencyUs;         // from the sample instant until it can be read
+    bool dataReadyInterrupt;    // fakeGyroUpdate() raises data ready for each sample, only if it is called from the loop thread
+} fakeGyroModel_t;
+
+void fakeGyroSetModel(const fakeGyroModel_t *model);
+void fakeGyroUpdate(void);
+bool fakeGyroSetIsrUpdate(struct gyroDev_s *gyro, sensorGyroUpdateFuncPtr updateFn);
+#endif
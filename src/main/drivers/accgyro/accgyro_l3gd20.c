@@ -66,8 +66,8 @@
 
 #define BOOT                          ((uint8_t)0x80)
 
-#define ENABLE_L3GD20        IOLo(mpul3gd20CsPin)
-#define DISABLE_L3GD20       IOHi(mpul3gd20CsPin)
+#define ENABLE_L3GD20        spiBusSelectDevice(L3GD20_SPI, mpul3gd20CsPin)
+#define DISABLE_L3GD20       spiBusDeselectDevice(L3GD20_SPI, mpul3gd20CsPin)
 
 static IO_t mpul3gd20CsPin = IO_NONE;
 
@@ -32,6 +32,7 @@
 #include "drivers/bus.h"
 #include "drivers/bus_i2c.h"
 #include "drivers/bus_spi.h"
+#include "drivers/dma.h"
 #include "drivers/exti.h"
 #include "drivers/io.h"
 #include "drivers/nvic.h"
@@ -102,6 +103,174 @@ static void mpu6050FindRevision(gyroDev_t *gyro)
     }
 }
 
+#ifdef USE_GYRO_DMA
+/*
+ * The gyro sample is read by DMA, started from the data ready interrupt, so it is already latched when the loop
+ * asks for it. All other transfers to the gyro and the accelerometer wait for the DMA and keep it from starting
+ * until they are done. Transfers to other devices are not held off, so the gyro must have the bus to itself.
+ */
+#define MPU_DMA_TRANSFER_SIZE   7   // the register address, then X, Y and Z
+#define MPU_DMA_FLAGS           (DMA_IT_TCIF | DMA_IT_HTIF | DMA_IT_TEIF | DMA_IT_DMEIF | DMA_IT_FEIF)
+
+static const uint8_t mpuDmaTxBuffer[MPU_DMA_TRANSFER_SIZE] = { MPU_RA_GYRO_XOUT_H | 0x80, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+static uint8_t mpuDmaRxBuffer[MPU_DMA_TRANSFER_SIZE];
+static gyroDev_t *mpuDmaGyro;
+static dmaChannelDescriptor_t *mpuDmaTxDescriptor;
+static dmaChannelDescriptor_t *mpuDmaRxDescriptor;
+static volatile bool mpuDmaInProgress;
+static volatile bool mpuDmaBusLocked;
+
+static void mpuGyroDmaStart(gyroDev_t *gyro)
+{
+    SPI_TypeDef *instance = gyro->bus.busdev_u.spi.instance;
+    if (mpuDmaInProgress || mpuDmaBusLocked || spiBusIsInUse(instance)) {
+        // the task is using the bus, and reads the sample itself
+        return;
+    }
+    mpuDmaInProgress = true;
+
+    DMA_CLEAR_FLAG(mpuDmaTxDescriptor, MPU_DMA_FLAGS);
+    DMA_CLEAR_FLAG(mpuDmaRxDescriptor, MPU_DMA_FLAGS);
+    DMA_SetCurrDataCounter(GYRO_DMA_STREAM_TX, MPU_DMA_TRANSFER_SIZE);
+    DMA_SetCurrDataCounter(GYRO_DMA_STREAM_RX, MPU_DMA_TRANSFER_SIZE);
+
+    instance->DR; // discard anything left in the receive register
+    spiBusSelectDevice(instance, gyro->bus.busdev_u.spi.csnPin);
+    DMA_Cmd(GYRO_DMA_STREAM_RX, ENABLE);
+    DMA_Cmd(GYRO_DMA_STREAM_TX, ENABLE);
+    SPI_I2S_DMACmd(instance, SPI_I2S_DMAReq_Rx | SPI_I2S_DMAReq_Tx, ENABLE);
+}
+
+// Receive stream interrupt, the receive stream completes once the last byte has been clocked in
+static void mpuGyroDmaIrqHandler(dmaChannelDescriptor_t *descriptor)
+{
+    gyroDev_t *gyro = mpuDmaGyro;
+    const bool complete = DMA_GET_FLAG_STATUS(descriptor, DMA_IT_TCIF);
+    DMA_CLEAR_FLAG(descriptor, MPU_DMA_FLAGS);
+
+    SPI_I2S_DMACmd(gyro->bus.busdev_u.spi.instance, SPI_I2S_DMAReq_Rx | SPI_I2S_DMAReq_Tx, DISABLE);
+    spiBusDeselectDevice(gyro->bus.busdev_u.spi.instance, gyro->bus.busdev_u.spi.csnPin);
+
+    if (complete) {
+        gyro->dmaSample[X] = (int16_t)((mpuDmaRxBuffer[1] << 8) | mpuDmaRxBuffer[2]);
+        gyro->dmaSample[Y] = (int16_t)((mpuDmaRxBuffer[3] << 8) | mpuDmaRxBuffer[4]);
+        gyro->dmaSample[Z] = (int16_t)((mpuDmaRxBuffer[5] << 8) | mpuDmaRxBuffer[6]);
+        gyro->dmaSampleReady = true;
+    }
+    mpuDmaInProgress = false;
+
+    if (complete) {
+        gyro->dataReady = true;
+        if (gyro->updateFn) {
+            gyro->updateFn(gyro);
+        }
+    }
+}
+
+static bool mpuReadRegisterSPIDma(const busDevice_t *bus, uint8_t reg, uint8_t *data, uint8_t length)
+{
+    mpuDmaBusLocked = true;
+    while (mpuDmaInProgress);
+    const bool ack = spiBusReadRegisterBuffer(bus, reg, data, length);
+    mpuDmaBusLocked = false;
+    return ack;
+}
+
+static bool mpuWriteRegisterSPIDma(const busDevice_t *bus, uint8_t reg, uint8_t data)
+{
+    mpuDmaBusLocked = true;
+    while (mpuDmaInProgress);
+    const bool ack = spiBusWriteRegister(bus, reg, data);
+    mpuDmaBusLocked = false;
+    return ack;
+}
+
+static bool mpuGyroReadSPIDma(gyroDev_t *gyro)
+{
+    if (gyro->dmaSampleReady) {
+        ATOMIC_BLOCK(NVIC_PRIO_GYRO_DMA) {
+            gyro->gyroADCRaw[X] = gyro->dmaSample[X];
+            gyro->gyroADCRaw[Y] = gyro->dmaSample[Y];
+            gyro->gyroADCRaw[Z] = gyro->dmaSample[Z];
+            gyro->dmaSampleReady = false;
+        }
+        return true;
+    }
+
+    // no transfer has completed since the last read, so read the latest sample directly
+    uint8_t data[6];
+    if (!mpuReadRegisterSPIDma(&gyro->bus, MPU_RA_GYRO_XOUT_H, data, 6)) {
+        return false;
+    }
+    gyro->gyroADCRaw[X] = (int16_t)((data[0] << 8) | data[1]);
+    gyro->gyroADCRaw[Y] = (int16_t)((data[2] << 8) | data[3]);
+    gyro->gyroADCRaw[Z] = (int16_t)((data[4] << 8) | data[5]);
+    return true;
+}
+
+// Switches the gyro to DMA reads, the accelerometer must be initialised afterwards so it picks up the DMA aware register access
+void mpuGyroDmaInit(gyroDev_t *gyro)
+{
+    if (gyro->readFn != mpuGyroReadSPI || gyro->mpuIntExtiTag == IO_TAG_NONE) {
+        return;
+    }
+#ifdef USE_GYRO_FIFO
+    if (gyro->fifoEnabled) {
+        // there is no data ready interrupt to start the transfers
+        return;
+    }
+#endif
+    // the streams may already be held by another driver, the gyro is then read without DMA
+    const uint8_t resourceIndex = RESOURCE_INDEX(spiDeviceByInstance(gyro->bus.busdev_u.spi.instance));
+    const dmaIdentifier_e txIdentifier = dmaGetIdentifier(GYRO_DMA_STREAM_TX);
+    const dmaIdentifier_e rxIdentifier = dmaGetIdentifier(GYRO_DMA_STREAM_RX);
+    if (!dmaAllocate(txIdentifier, OWNER_SPI_DMA, resourceIndex)) {
+        return;
+    }
+    if (!dmaAllocate(rxIdentifier, OWNER_SPI_DMA, resourceIndex)) {
+        dmaRelease(txIdentifier);
+        return;
+    }
+
+    mpuDmaGyro = gyro;
+    mpuDmaTxDescriptor = getDmaDescriptor(GYRO_DMA_STREAM_TX);
+    mpuDmaRxDescriptor = getDmaDescriptor(GYRO_DMA_STREAM_RX);
+
+    DMA_DeInit(GYRO_DMA_STREAM_TX);
+    DMA_DeInit(GYRO_DMA_STREAM_RX);
+
+    DMA_InitTypeDef DMA_InitStructure;
+    DMA_StructInit(&DMA_InitStructure);
+    DMA_InitStructure.DMA_Channel = GYRO_DMA_CHANNEL;
+    DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32_t)(&(gyro->bus.busdev_u.spi.instance->DR));
+    DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte;
+    DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_Byte;
+    DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+    DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+    DMA_InitStructure.DMA_BufferSize = MPU_DMA_TRANSFER_SIZE;
+    DMA_InitStructure.DMA_Mode = DMA_Mode_Normal;
+    DMA_InitStructure.DMA_Priority = DMA_Priority_High;
+
+    DMA_InitStructure.DMA_Memory0BaseAddr = (uint32_t)mpuDmaRxBuffer;
+    DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralToMemory;
+    DMA_Init(GYRO_DMA_STREAM_RX, &DMA_InitStructure);
+
+    DMA_InitStructure.DMA_Memory0BaseAddr = (uint32_t)mpuDmaTxBuffer;
+    DMA_InitStructure.DMA_DIR = DMA_DIR_MemoryToPeripheral;
+    DMA_Init(GYRO_DMA_STREAM_TX, &DMA_InitStructure);
+
+    DMA_ITConfig(GYRO_DMA_STREAM_RX, DMA_IT_TC | DMA_IT_TE, ENABLE);
+    dmaSetHandler(rxIdentifier, mpuGyroDmaIrqHandler, NVIC_PRIO_GYRO_DMA, 0);
+
+    ATOMIC_BLOCK(NVIC_PRIO_MPU_INT_EXTI) {
+        gyro->mpuConfiguration.readFn = mpuReadRegisterSPIDma;
+        gyro->mpuConfiguration.writeFn = mpuWriteRegisterSPIDma;
+        gyro->readFn = mpuGyroReadSPIDma;
+        gyro->dmaEnabled = true;
+    }
+}
+#endif
+
 /*
  * Gyro interrupt service routine
  */
@@ -115,6 +284,15 @@ static void mpuIntExtiHandler(extiCallbackRec_t *cb)
     lastCalledAtUs = nowUs;
 #endif
     gyroDev_t *gyro = container_of(cb, gyroDev_t, exti);
+    gyro->dataReadyTimeUs = micros();
+    gyro->dataReadyCount++;
+#ifdef USE_GYRO_DMA
+    if (gyro->dmaEnabled) {
+        // the sample is signalled once the transfer completes
+        mpuGyroDmaStart(gyro);
+        return;
+    }
+#endif
     gyro->dataReady = true;
     if (gyro->updateFn) {
         gyro->updateFn(gyro);
@@ -214,6 +392,35 @@ bool mpuGyroRead(gyroDev_t *gyro)
     return true;
 }
 
+// Die temperature in degrees C, the scale and offset are from the datasheet of each chip
+bool mpuGyroReadTemperature(gyroDev_t *gyro, int16_t *temperatureData)
+{
+    uint8_t data[2];
+
+    if (!gyro->mpuConfiguration.readFn(&gyro->bus, MPU_RA_TEMP_OUT_H, data, 2)) {
+        return false;
+    }
+
+    const int32_t raw = (int16_t)((data[0] << 8) | data[1]);
+    switch (gyro->mpuDetectionResult.sensor) {
+    case MPU_60x0:
+    case MPU_60x0_SPI:
+        *temperatureData = (raw + 12420) / 340;     // 340 LSB/C, 36.53C at 0
+        break;
+    case ICM_20601_SPI:
+    case ICM_20602_SPI:
+    case ICM_20608_SPI:
+    case ICM_20689_SPI:
+        *temperatureData = (raw + 8170) / 327;      // 326.8 LSB/C, 25C at 0
+        break;
+    default:
+        *temperatureData = (raw + 7011) / 334;      // 333.87 LSB/C, 21C at 0
+        break;
+    }
+
+    return true;
+}
+
 bool mpuGyroReadSPI(gyroDev_t *gyro)
 {
     static const uint8_t dataToSend[7] = {MPU_RA_GYRO_XOUT_H | 0x80, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
@@ -231,6 +438,145 @@ bool mpuGyroReadSPI(gyroDev_t *gyro)
     return true;
 }
 
+/*
+ * The accelerometer, temperature and gyro output registers are adjacent from ACCEL_XOUT_H, so one 14 byte burst
+ * reads them all. The accelerometer samples are summed, and the accelerometer task reads the mean of the samples
+ * since its last run, which decimates the accelerometer to the task rate without a bus transaction of its own.
+ */
+static int32_t mpuBurstAccSum[XYZ_AXIS_COUNT];
+static uint16_t mpuBurstAccCount;
+
+static bool mpuGyroReadSPIWithAcc(gyroDev_t *gyro)
+{
+    static const uint8_t dataToSend[15] = {MPU_RA_ACCEL_XOUT_H | 0x80, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+    uint8_t data[15];
+
+    const bool ack = spiBusTransfer(&gyro->bus, dataToSend, data, 15);
+    if (!ack) {
+        return false;
+    }
+
+    mpuBurstAccSum[X] += (int16_t)((data[1] << 8) | data[2]);
+    mpuBurstAccSum[Y] += (int16_t)((data[3] << 8) | data[4]);
+    mpuBurstAccSum[Z] += (int16_t)((data[5] << 8) | data[6]);
+    mpuBurstAccCount++;
+
+    gyro->gyroADCRaw[X] = (int16_t)((data[9] << 8) | data[10]);
+    gyro->gyroADCRaw[Y] = (int16_t)((data[11] << 8) | data[12]);
+    gyro->gyroADCRaw[Z] = (int16_t)((data[13] << 8) | data[14]);
+
+    return true;
+}
+
+static bool mpuAccReadBurst(accDev_t *acc)
+{
+    int32_t sum[XYZ_AXIS_COUNT];
+    uint16_t count;
+
+    // the gyro may be read from its data ready interrupt
+    ATOMIC_BLOCK(NVIC_PRIO_MPU_INT_EXTI) {
+        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            sum[axis] = mpuBurstAccSum[axis];
+            mpuBurstAccSum[axis] = 0;
+        }
+        count = mpuBurstAccCount;
+        mpuBurstAccCount = 0;
+    }
+    if (!count) {
+        return false;
+    }
+
+    acc->ADCRaw[X] = sum[X] / count;
+    acc->ADCRaw[Y] = sum[Y] / count;
+    acc->ADCRaw[Z] = sum[Z] / count;
+
+    return true;
+}
+
+// Moves the accelerometer read into the gyro read, returns false unless both are read from the same SPI MPU
+bool mpuGyroSetAccBurstRead(gyroDev_t *gyro, accDev_t *acc)
+{
+    if (gyro->readFn != mpuGyroReadSPI || acc->readFn != mpuAccRead) {
+        return false;
+    }
+    mpuBurstAccCount = 0;
+    gyro->readFn = mpuGyroReadSPIWithAcc;
+    acc->readFn = mpuAccReadBurst;
+    return true;
+}
+
+#ifdef USE_GYRO_FIFO
+#define MPU_FIFO_GYRO_SAMPLE_SIZE 6     // X, Y and Z, big endian
+
+/*
+ * Streams the gyro samples into the FIFO instead of signalling each of them with the data ready interrupt,
+ * so the loop can read all the samples since its last run in one burst. Must be called at the SPI clock
+ * registers are written at, spiReadDivisor is the clock the driver reads at.
+ */
+void mpuGyroFifoInit(gyroDev_t *gyro, uint16_t spiReadDivisor)
+{
+    if (!gyro->fifoEnabled) {
+        return;
+    }
+    gyro->fifoSpiDivisor = spiReadDivisor;
+    gyro->fifoSampleCount = 0;
+
+    gyro->mpuConfiguration.writeFn(&gyro->bus, MPU_RA_INT_ENABLE, 0);
+    delayMicroseconds(15);
+    gyro->mpuConfiguration.writeFn(&gyro->bus, MPU_RA_FIFO_EN, MPU_FIFO_EN_GYRO_XYZ);
+    delayMicroseconds(15);
+    gyro->mpuConfiguration.writeFn(&gyro->bus, MPU_RA_USER_CTRL, MPU_BIT_I2C_IF_DIS | MPU_BIT_FIFO_EN | MPU_BIT_FIFO_RESET);
+    delayMicroseconds(15);
+}
+
+static void mpuGyroFifoReset(gyroDev_t *gyro)
+{
+    // registers can only be written at the slow clock
+    spiBusSetDivisor(&gyro->bus, SPI_CLOCK_INITIALIZATON);
+    spiBusWriteRegister(&gyro->bus, MPU_RA_USER_CTRL, MPU_BIT_I2C_IF_DIS | MPU_BIT_FIFO_EN | MPU_BIT_FIFO_RESET);
+    spiBusSetDivisor(&gyro->bus, gyro->fifoSpiDivisor);
+}
+
+// Burst reads up to GYRO_FIFO_SAMPLES_MAX queued samples into fifoData, the newest is also left in gyroADCRaw
+bool mpuGyroReadFifoSPI(gyroDev_t *gyro)
+{
+    uint8_t fifoCount[2];
+    if (!spiBusReadRegisterBuffer(&gyro->bus, MPU_RA_FIFO_COUNTH, fifoCount, 2)) {
+        return false;
+    }
+    const uint16_t fifoBytes = (fifoCount[0] << 8) | fifoCount[1];
+    if (fifoBytes % MPU_FIFO_GYRO_SAMPLE_SIZE) {
+        // the FIFO overflowed while the loop was held up, and no longer starts at a whole sample
+        mpuGyroFifoReset(gyro);
+        gyro->fifoSampleCount = 0;
+        return false;
+    }
+    // any samples left over are read by the next loop
+    const uint8_t sampleCount = MIN(fifoBytes / MPU_FIFO_GYRO_SAMPLE_SIZE, GYRO_FIFO_SAMPLES_MAX);
+    if (sampleCount == 0) {
+        return false;
+    }
+
+    uint8_t data[GYRO_FIFO_SAMPLES_MAX * MPU_FIFO_GYRO_SAMPLE_SIZE];
+    if (!spiBusReadRegisterBuffer(&gyro->bus, MPU_RA_FIFO_R_W, data, sampleCount * MPU_FIFO_GYRO_SAMPLE_SIZE)) {
+        return false;
+    }
+    for (int i = 0; i < sampleCount; i++) {
+        const uint8_t *sample = &data[i * MPU_FIFO_GYRO_SAMPLE_SIZE];
+        gyro->fifoData[i][X] = (int16_t)((sample[0] << 8) | sample[1]);
+        gyro->fifoData[i][Y] = (int16_t)((sample[2] << 8) | sample[3]);
+        gyro->fifoData[i][Z] = (int16_t)((sample[4] << 8) | sample[5]);
+    }
+    gyro->fifoSampleCount = sampleCount;
+
+    gyro->gyroADCRaw[X] = gyro->fifoData[sampleCount - 1][X];
+    gyro->gyroADCRaw[Y] = gyro->fifoData[sampleCount - 1][Y];
+    gyro->gyroADCRaw[Z] = gyro->fifoData[sampleCount - 1][Z];
+
+    return true;
+}
+#endif
+
 #ifdef USE_SPI
 static bool detectSPISensorsAndUpdateDetectionResult(gyroDev_t *gyro)
 {
@@ -27,6 +27,15 @@
 #define GYRO_USES_SPI
 #endif
 
+#if defined(GYRO_USES_SPI) && defined(USE_MPU_DATA_READY_SIGNAL)
+#define USE_GYRO_ISR_UPDATE
+#endif
+
+// The target defines GYRO_DMA_STREAM_TX, GYRO_DMA_STREAM_RX and GYRO_DMA_CHANNEL for its gyro SPI bus, only if the gyro has the bus to itself
+#if defined(USE_GYRO_ISR_UPDATE) && defined(MPU_INT_EXTI) && defined(STM32F4) && defined(GYRO_DMA_STREAM_RX)
+#define USE_GYRO_DMA
+#endif
+
 // MPU6050
 #define MPU_RA_WHO_AM_I         0x75
 #define MPU_RA_WHO_AM_I_LEGACY  0x00
@@ -138,6 +147,14 @@
 // RF = Register Flag
 #define MPU_RF_DATA_RDY_EN (1 << 0)
 
+// RA_USER_CTRL
+#define MPU_BIT_FIFO_EN         (1 << 6)
+#define MPU_BIT_I2C_IF_DIS      (1 << 4)
+#define MPU_BIT_FIFO_RESET      (1 << 2)
+
+// RA_FIFO_EN
+#define MPU_FIFO_EN_GYRO_XYZ    (0x70)
+
 typedef bool (*mpuReadRegisterFnPtr)(const busDevice_t *bus, uint8_t reg, uint8_t* data, uint8_t length);
 typedef bool (*mpuWriteRegisterFnPtr)(const busDevice_t *bus, uint8_t reg, uint8_t data);
 typedef void (*mpuResetFnPtr)(void);
@@ -209,5 +226,10 @@ struct accDev_s;
 bool mpuAccRead(struct accDev_s *acc);
 bool mpuGyroRead(struct gyroDev_s *gyro);
 bool mpuGyroReadSPI(struct gyroDev_s *gyro);
+bool mpuGyroSetAccBurstRead(struct gyroDev_s *gyro, struct accDev_s *acc);
+bool mpuGyroReadTemperature(struct gyroDev_s *gyro, int16_t *temperatureData);
 void mpuDetect(struct gyroDev_s *gyro);
 void mpuGyroSetIsrUpdate(struct gyroDev_s *gyro, sensorGyroUpdateFuncPtr updateFn);
+void mpuGyroDmaInit(struct gyroDev_s *gyro);
+void mpuGyroFifoInit(struct gyroDev_s *gyro, uint16_t spiReadDivisor);
+bool mpuGyroReadFifoSPI(struct gyroDev_s *gyro);
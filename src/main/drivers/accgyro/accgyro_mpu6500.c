@@ -95,6 +95,7 @@ bool mpu6500GyroDetect(gyroDev_t *gyro)
 
     gyro->initFn = mpu6500GyroInit;
     gyro->readFn = mpuGyroRead;
+    gyro->temperatureFn = mpuGyroReadTemperature;
 
     // 16.4 dps/lsb scalefactor
     gyro->scale = 1.0f / 16.4f;
@@ -100,7 +100,7 @@ uint8_t bmi160Detect(const busDevice_t *bus)
 
     IOInit(bus->busdev_u.spi.csnPin, OWNER_MPU_CS, 0);
     IOConfigGPIO(bus->busdev_u.spi.csnPin, SPI_IO_CS_CFG);
-    IOHi(bus->busdev_u.spi.csnPin);
+    spiBusDeselectDevice(bus->busdev_u.spi.instance, bus->busdev_u.spi.csnPin);
 
     spiSetDivisor(bus->busdev_u.spi.instance, BMI160_SPI_DIVISOR);
 
@@ -269,12 +269,12 @@ static int32_t BMI160_do_foc(const busDevice_t *bus)
 
 static int32_t BMI160_WriteReg(const busDevice_t *bus, uint8_t reg, uint8_t data)
 {
-    IOLo(busdev->busdev_u.spi.csnPin); // Enable
+    spiBusSelectDevice(busdev->busdev_u.spi.instance, busdev->busdev_u.spi.csnPin); // Enable
 
     spiTransferByte(BMI160_SPI_INSTANCE, 0x7f & reg);
     spiTransferByte(BMI160_SPI_INSTANCE, data);
 
-    IOHi(busdev->busdev_u.spi.csnPin); // Disable
+    spiBusDeselectDevice(busdev->busdev_u.spi.instance, busdev->busdev_u.spi.csnPin); // Disable
 
     return 0;
 }
@@ -324,9 +324,9 @@ bool bmi160AccRead(accDev_t *acc)
     uint8_t bmi160_rx_buf[BUFFER_SIZE];
     static const uint8_t bmi160_tx_buf[BUFFER_SIZE] = {BMI160_REG_ACC_DATA_X_LSB | 0x80, 0, 0, 0, 0, 0, 0};
 
-    IOLo(acc->bus.busdev_u.spi.csnPin);
+    spiBusSelectDevice(acc->bus.busdev_u.spi.instance, acc->bus.busdev_u.spi.csnPin);
     spiTransfer(acc->bus.busdev_u.spi.instance, bmi160_tx_buf, bmi160_rx_buf, BUFFER_SIZE);   // receive response
-    IOHi(acc->bus.busdev_u.spi.csnPin);
+    spiBusDeselectDevice(acc->bus.busdev_u.spi.instance, acc->bus.busdev_u.spi.csnPin);
 
     acc->ADCRaw[X] = (int16_t)((bmi160_rx_buf[IDX_ACCEL_XOUT_H] << 8) | bmi160_rx_buf[IDX_ACCEL_XOUT_L]);
     acc->ADCRaw[Y] = (int16_t)((bmi160_rx_buf[IDX_ACCEL_YOUT_H] << 8) | bmi160_rx_buf[IDX_ACCEL_YOUT_L]);
@@ -352,9 +352,9 @@ bool bmi160GyroRead(gyroDev_t *gyro)
     uint8_t bmi160_rx_buf[BUFFER_SIZE];
     static const uint8_t bmi160_tx_buf[BUFFER_SIZE] = {BMI160_REG_GYR_DATA_X_LSB | 0x80, 0, 0, 0, 0, 0, 0};
 
-    IOLo(gyro->bus.busdev_u.spi.csnPin);
+    spiBusSelectDevice(gyro->bus.busdev_u.spi.instance, gyro->bus.busdev_u.spi.csnPin);
     spiTransfer(gyro->bus.busdev_u.spi.instance, bmi160_tx_buf, bmi160_rx_buf, BUFFER_SIZE);   // receive response
-    IOHi(gyro->bus.busdev_u.spi.csnPin);
+    spiBusDeselectDevice(gyro->bus.busdev_u.spi.instance, gyro->bus.busdev_u.spi.csnPin);
 
     gyro->gyroADCRaw[X] = (int16_t)((bmi160_rx_buf[IDX_GYRO_XOUT_H] << 8) | bmi160_rx_buf[IDX_GYRO_XOUT_L]);
     gyro->gyroADCRaw[Y] = (int16_t)((bmi160_rx_buf[IDX_GYRO_YOUT_H] << 8) | bmi160_rx_buf[IDX_GYRO_YOUT_L]);
@@ -366,6 +366,7 @@ bool bmi160GyroRead(gyroDev_t *gyro)
 
 void bmi160SpiGyroInit(gyroDev_t *gyro)
 {
+    spiBusSetDivisor(&gyro->bus, BMI160_SPI_DIVISOR);
     BMI160_Init(gyro->bus.busdev_u.spi.csnPin);
     bmi160IntExtiInit(gyro);
 }
@@ -118,7 +118,7 @@ void icm20689GyroInit(gyroDev_t *gyro)
 {
     mpuGyroInit(gyro);
 
-    spiSetDivisor(gyro->bus.busdev_u.spi.instance, SPI_CLOCK_INITIALIZATON);
+    spiBusSetDivisor(&gyro->bus, SPI_CLOCK_INITIALIZATON);
 
     gyro->mpuConfiguration.writeFn(&gyro->bus, MPU_RA_PWR_MGMT_1, ICM20689_BIT_RESET);
     delay(100);
@@ -148,7 +148,11 @@ void icm20689GyroInit(gyroDev_t *gyro)
     gyro->mpuConfiguration.writeFn(&gyro->bus, MPU_RA_INT_ENABLE, 0x01); // RAW_RDY_EN interrupt enable
 #endif
 
-    spiSetDivisor(gyro->bus.busdev_u.spi.instance, SPI_CLOCK_STANDARD);
+#ifdef USE_GYRO_FIFO
+    mpuGyroFifoInit(gyro, SPI_CLOCK_STANDARD);
+#endif
+
+    spiBusSetDivisor(&gyro->bus, SPI_CLOCK_STANDARD);
 }
 
 bool icm20689SpiGyroDetect(gyroDev_t *gyro)
@@ -165,6 +169,10 @@ bool icm20689SpiGyroDetect(gyroDev_t *gyro)
 
     gyro->initFn = icm20689GyroInit;
     gyro->readFn = mpuGyroReadSPI;
+    gyro->temperatureFn = mpuGyroReadTemperature;
+#ifdef USE_GYRO_FIFO
+    gyro->readFifoFn = mpuGyroReadFifoSPI;
+#endif
 
     // 16.4 dps/lsb scalefactor
     gyro->scale = 1.0f / 16.4f;
@@ -105,13 +105,13 @@ void mpu6000SpiGyroInit(gyroDev_t *gyro)
 
     mpu6000AccAndGyroInit(gyro);
 
-    spiSetDivisor(gyro->bus.busdev_u.spi.instance, SPI_CLOCK_INITIALIZATON);
+    spiBusSetDivisor(&gyro->bus, SPI_CLOCK_INITIALIZATON);
 
     // Accel and Gyro DLPF Setting
     spiBusWriteRegister(&gyro->bus, MPU6000_CONFIG, gyro->lpf);
     delayMicroseconds(1);
 
-    spiSetDivisor(gyro->bus.busdev_u.spi.instance, SPI_CLOCK_FAST);  // 18 MHz SPI clock
+    spiBusSetDivisor(&gyro->bus, SPI_CLOCK_FAST);  // 18 MHz SPI clock
 
     mpuGyroRead(gyro);
 
@@ -178,7 +178,7 @@ static void mpu6000AccAndGyroInit(gyroDev_t *gyro)
         return;
     }
 
-    spiSetDivisor(gyro->bus.busdev_u.spi.instance, SPI_CLOCK_INITIALIZATON);
+    spiBusSetDivisor(&gyro->bus, SPI_CLOCK_INITIALIZATON);
 
     // Device Reset
     spiBusWriteRegister(&gyro->bus, MPU_RA_PWR_MGMT_1, BIT_H_RESET);
@@ -219,7 +219,11 @@ static void mpu6000AccAndGyroInit(gyroDev_t *gyro)
     delayMicroseconds(15);
 #endif
 
-    spiSetDivisor(gyro->bus.busdev_u.spi.instance, SPI_CLOCK_FAST);
+#ifdef USE_GYRO_FIFO
+    mpuGyroFifoInit(gyro, SPI_CLOCK_FAST);
+#endif
+
+    spiBusSetDivisor(&gyro->bus, SPI_CLOCK_FAST);
     delayMicroseconds(1);
 
     mpuSpi6000InitDone = true;
@@ -245,6 +249,10 @@ bool mpu6000SpiGyroDetect(gyroDev_t *gyro)
 
     gyro->initFn = mpu6000SpiGyroInit;
     gyro->readFn = mpuGyroReadSPI;
+    gyro->temperatureFn = mpuGyroReadTemperature;
+#ifdef USE_GYRO_FIFO
+    gyro->readFifoFn = mpuGyroReadFifoSPI;
+#endif
     // 16.4 dps/lsb scalefactor
     gyro->scale = 1.0f / 16.4f;
 
@@ -90,7 +90,7 @@ void mpu6500SpiAccInit(accDev_t *acc)
 
 void mpu6500SpiGyroInit(gyroDev_t *gyro)
 {
-    spiSetDivisor(gyro->bus.busdev_u.spi.instance, SPI_CLOCK_SLOW);
+    spiBusSetDivisor(&gyro->bus, SPI_CLOCK_SLOW);
     delayMicroseconds(1);
 
     mpu6500GyroInit(gyro);
@@ -99,7 +99,11 @@ void mpu6500SpiGyroInit(gyroDev_t *gyro)
     spiBusWriteRegister(&gyro->bus, MPU_RA_USER_CTRL, MPU6500_BIT_I2C_IF_DIS);
     delay(100);
 
-    spiSetDivisor(gyro->bus.busdev_u.spi.instance, SPI_CLOCK_FAST);
+#ifdef USE_GYRO_FIFO
+    mpuGyroFifoInit(gyro, SPI_CLOCK_FAST);
+#endif
+
+    spiBusSetDivisor(&gyro->bus, SPI_CLOCK_FAST);
     delayMicroseconds(1);
 }
 
@@ -137,6 +141,10 @@ bool mpu6500SpiGyroDetect(gyroDev_t *gyro)
 
     gyro->initFn = mpu6500SpiGyroInit;
     gyro->readFn = mpuGyroReadSPI;
+    gyro->temperatureFn = mpuGyroReadTemperature;
+#ifdef USE_GYRO_FIFO
+    gyro->readFifoFn = mpuGyroReadFifoSPI;
+#endif
 
     // 16.4 dps/lsb scalefactor
     gyro->scale = 1.0f / 16.4f;
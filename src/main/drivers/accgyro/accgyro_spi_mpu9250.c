@@ -52,11 +52,12 @@ static bool mpuSpi9250InitDone = false;
 
 bool mpu9250SpiWriteRegister(const busDevice_t *bus, uint8_t reg, uint8_t data)
 {
-    IOLo(bus->busdev_u.spi.csnPin);
+    spiBusApplyProfile(bus);
+    spiBusSelectDevice(bus->busdev_u.spi.instance, bus->busdev_u.spi.csnPin);
     delayMicroseconds(1);
     spiTransferByte(bus->busdev_u.spi.instance, reg);
     spiTransferByte(bus->busdev_u.spi.instance, data);
-    IOHi(bus->busdev_u.spi.csnPin);
+    spiBusDeselectDevice(bus->busdev_u.spi.instance, bus->busdev_u.spi.csnPin);
     delayMicroseconds(1);
 
     return true;
@@ -64,11 +65,12 @@ bool mpu9250SpiWriteRegister(const busDevice_t *bus, uint8_t reg, uint8_t data)
 
 static bool mpu9250SpiSlowReadRegisterBuffer(const busDevice_t *bus, uint8_t reg, uint8_t *data, uint8_t length)
 {
-    IOLo(bus->busdev_u.spi.csnPin);
+    spiBusApplyProfile(bus);
+    spiBusSelectDevice(bus->busdev_u.spi.instance, bus->busdev_u.spi.csnPin);
     delayMicroseconds(1);
     spiTransferByte(bus->busdev_u.spi.instance, reg | 0x80); // read transaction
     spiTransfer(bus->busdev_u.spi.instance, NULL, data, length);
-    IOHi(bus->busdev_u.spi.csnPin);
+    spiBusDeselectDevice(bus->busdev_u.spi.instance, bus->busdev_u.spi.csnPin);
     delayMicroseconds(1);
 
     return true;
@@ -95,7 +97,7 @@ void mpu9250SpiGyroInit(gyroDev_t *gyro)
 
     spiResetErrorCounter(gyro->bus.busdev_u.spi.instance);
 
-    spiSetDivisor(gyro->bus.busdev_u.spi.instance, SPI_CLOCK_FAST); //high speed now that we don't need to write to the slow registers
+    spiBusSetDivisor(&gyro->bus, SPI_CLOCK_FAST); //high speed now that we don't need to write to the slow registers
 
     mpuGyroRead(gyro);
 
@@ -136,7 +138,7 @@ static void mpu9250AccAndGyroInit(gyroDev_t *gyro) {
         return;
     }
 
-    spiSetDivisor(gyro->bus.busdev_u.spi.instance, SPI_CLOCK_INITIALIZATON); //low speed for writing to slow registers
+    spiBusSetDivisor(&gyro->bus, SPI_CLOCK_INITIALIZATON); //low speed for writing to slow registers
 
     mpu9250SpiWriteRegister(&gyro->bus, MPU_RA_PWR_MGMT_1, MPU9250_BIT_RESET);
     delay(50);
@@ -164,7 +166,7 @@ static void mpu9250AccAndGyroInit(gyroDev_t *gyro) {
     mpu9250SpiWriteRegisterVerify(&gyro->bus, MPU_RA_INT_ENABLE, 0x01); //this resets register MPU_RA_PWR_MGMT_1 and won't read back correctly.
 #endif
 
-    spiSetDivisor(gyro->bus.busdev_u.spi.instance, SPI_CLOCK_FAST);
+    spiBusSetDivisor(&gyro->bus, SPI_CLOCK_FAST);
 
     mpuSpi9250InitDone = true; //init done
 }
@@ -214,6 +216,7 @@ bool mpu9250SpiGyroDetect(gyroDev_t *gyro)
 
     gyro->initFn = mpu9250SpiGyroInit;
     gyro->readFn = mpuGyroReadSPI;
+    gyro->temperatureFn = mpuGyroReadTemperature;
 
     // 16.4 dps/lsb scalefactor
     gyro->scale = 1.0f / 16.4f;
@@ -32,7 +32,8 @@
 
 #ifdef USE_ADC
 adcOperatingConfig_t adcOperatingConfig[ADC_CHANNEL_COUNT];
-volatile uint16_t adcValues[ADC_CHANNEL_COUNT];
+DMA_RAM volatile uint16_t adcValues[ADC_CHANNEL_COUNT * ADC_SAMPLE_COUNT];
+uint8_t adcScanLength;  // channels converted per scan, the distance between two samples of a channel in adcValues
 
 uint8_t adcChannelByTag(ioTag_t ioTag)
 {
@@ -59,7 +60,12 @@ uint16_t adcGetChannel(uint8_t channel)
         debug[3] = adcValues[adcOperatingConfig[3].dmaIndex];
     }
 #endif
-    return adcValues[adcOperatingConfig[channel].dmaIndex];
+    const volatile uint16_t *samples = &adcValues[adcOperatingConfig[channel].dmaIndex];
+    uint32_t sum = 0;
+    for (int i = 0; i < ADC_SAMPLE_COUNT; i++) {
+        sum += samples[i * adcScanLength];
+    }
+    return sum / ADC_SAMPLE_COUNT;
 }
 
 #else
@@ -28,6 +28,9 @@
 #define ADC_TAG_MAP_COUNT 10
 #endif
 
+// Scans the circular DMA buffer holds. adcGetChannel() returns their average, a few milliseconds of samples.
+#define ADC_SAMPLE_COUNT 16
+
 typedef enum ADCDevice {
     ADCINVALID = -1,
     ADCDEV_1   = 0,
@@ -60,6 +63,7 @@ typedef struct adcDevice_s {
 extern const adcDevice_t adcHardware[];
 extern const adcTagMap_t adcTagMap[ADC_TAG_MAP_COUNT];
 extern adcOperatingConfig_t adcOperatingConfig[ADC_CHANNEL_COUNT];
-extern volatile uint16_t adcValues[ADC_CHANNEL_COUNT];
+extern volatile uint16_t adcValues[ADC_CHANNEL_COUNT * ADC_SAMPLE_COUNT];
+extern uint8_t adcScanLength;
 
 uint8_t adcChannelByTag(ioTag_t ioTag);
@@ -138,6 +138,15 @@ void adcInit(const adcConfig_t *config)
         return;
     }
 
+    const dmaChannelSpec_t *dmaSpec = dmaGetFreeChannelSpec(DMA_PERIPH_ADC, device, adc.DMAy_Streamx, OWNER_ADC, 0);
+    if (!dmaSpec) {
+        return;
+    }
+    adc.DMAy_Streamx = dmaSpec->ref;
+    adc.channel = dmaSpec->channel;
+
+    adcScanLength = configuredAdcChannels;
+
     RCC_ClockCmd(adc.rccADC, ENABLE);
 
     dmaInit(dmaGetIdentifier(adc.DMAy_Streamx), OWNER_ADC, 0);
@@ -149,9 +158,9 @@ void adcInit(const adcConfig_t *config)
     DMA_InitStructure.DMA_Channel = adc.channel;
     DMA_InitStructure.DMA_Memory0BaseAddr = (uint32_t)adcValues;
     DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralToMemory;
-    DMA_InitStructure.DMA_BufferSize = configuredAdcChannels;
+    DMA_InitStructure.DMA_BufferSize = configuredAdcChannels * ADC_SAMPLE_COUNT;
     DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
-    DMA_InitStructure.DMA_MemoryInc = configuredAdcChannels > 1 ? DMA_MemoryInc_Enable : DMA_MemoryInc_Disable;
+    DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
     DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_HalfWord;
     DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_HalfWord;
     DMA_InitStructure.DMA_Mode = DMA_Mode_Circular;
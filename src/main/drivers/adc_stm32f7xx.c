@@ -135,6 +135,8 @@ void adcInit(const adcConfig_t *config)
         return;
     }
 
+    adcScanLength = configuredAdcChannels;
+
     RCC_ClockCmd(adc.rccADC, ENABLE);
     dmaInit(dmaGetIdentifier(adc.DMAy_Streamx), OWNER_ADC, 0);
 
@@ -161,7 +163,7 @@ void adcInit(const adcConfig_t *config)
     adc.DmaHandle.Init.Channel = adc.channel;
     adc.DmaHandle.Init.Direction = DMA_PERIPH_TO_MEMORY;
     adc.DmaHandle.Init.PeriphInc = DMA_PINC_DISABLE;
-    adc.DmaHandle.Init.MemInc = configuredAdcChannels > 1 ? DMA_MINC_ENABLE : DMA_MINC_DISABLE;
+    adc.DmaHandle.Init.MemInc = DMA_MINC_ENABLE;
     adc.DmaHandle.Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
     adc.DmaHandle.Init.MemDataAlignment = DMA_MDATAALIGN_HALFWORD;
     adc.DmaHandle.Init.Mode = DMA_CIRCULAR;
@@ -200,7 +202,7 @@ void adcInit(const adcConfig_t *config)
 
     //HAL_CLEANINVALIDATECACHE((uint32_t*)&adcValues, configuredAdcChannels);
     /*##-4- Start the conversion process #######################################*/
-    if (HAL_ADC_Start_DMA(&adc.ADCHandle, (uint32_t*)&adcValues, configuredAdcChannels) != HAL_OK)
+    if (HAL_ADC_Start_DMA(&adc.ADCHandle, (uint32_t*)&adcValues, configuredAdcChannels * ADC_SAMPLE_COUNT) != HAL_OK)
     {
         /* Start Conversation Error */
     }
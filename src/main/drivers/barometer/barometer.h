@@ -22,6 +22,7 @@
 struct baroDev_s;
 
 typedef void (*baroOpFuncPtr)(struct baroDev_s *baro);                       // baro start operation
+typedef bool (*baroReadFuncPtr)(struct baroDev_s *baro);                     // baro read start, false if the bus is busy
 typedef void (*baroCalculateFuncPtr)(int32_t *pressure, int32_t *temperature); // baro calculation (filled params are pressure and temperature)
 
 typedef struct baroDev_s {
@@ -32,6 +33,8 @@ typedef struct baroDev_s {
     baroOpFuncPtr get_ut;
     baroOpFuncPtr start_up;
     baroOpFuncPtr get_up;
+    baroReadFuncPtr read_ut;    // optional, starts the read get_ut consumes once the bus is idle
+    baroReadFuncPtr read_up;    // optional, starts the read get_up consumes once the bus is idle
     baroCalculateFuncPtr calculate;
 } baroDev_t;
 
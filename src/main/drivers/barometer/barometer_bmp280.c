@@ -57,10 +57,12 @@ STATIC_UNIT_TESTED bmp280_calib_param_t bmp280_cal;
 // uncompensated pressure and temperature
 int32_t bmp280_up = 0;
 int32_t bmp280_ut = 0;
+static uint8_t bmp280_data[BMP280_DATA_FRAME_SIZE];    // filled by the read started in bmp280_read_up()
 
 static void bmp280_start_ut(baroDev_t *baro);
 static void bmp280_get_ut(baroDev_t *baro);
 static void bmp280_start_up(baroDev_t *baro);
+static bool bmp280_read_up(baroDev_t *baro);
 static void bmp280_get_up(baroDev_t *baro);
 
 STATIC_UNIT_TESTED void bmp280_calculate(int32_t *pressure, int32_t *temperature);
@@ -102,7 +104,7 @@ void bmp280BusInit(busDevice_t *busdev)
         IOInit(busdev->busdev_u.spi.csnPin, OWNER_BARO_CS, 0);
         IOConfigGPIO(busdev->busdev_u.spi.csnPin, IOCFG_OUT_PP);
         IOHi(busdev->busdev_u.spi.csnPin); // Disable
-        spiSetDivisor(busdev->busdev_u.spi.instance, SPI_CLOCK_STANDARD); // XXX
+        spiBusSetDivisor(busdev, SPI_CLOCK_STANDARD);
     }
 #else
     UNUSED(busdev);
@@ -140,7 +142,8 @@ bool bmp280Detect(baroDev_t *baro)
     // read calibration
     bmp280ReadRegister(busdev, BMP280_TEMPERATURE_CALIB_DIG_T1_LSB_REG, 24, (uint8_t *)&bmp280_cal);
 
-    // set oversampling + power mode (forced), and start sampling
+    // set standby + filter, then oversampling + power mode (normal), which keeps sampling by itself
+    bmp280WriteRegister(busdev, BMP280_CONFIG_REG, BMP280_CONFIG);
     bmp280WriteRegister(busdev, BMP280_CTRL_MEAS_REG, BMP280_MODE);
 
     // these are dummy as temperature is measured as part of pressure
@@ -150,7 +153,9 @@ bool bmp280Detect(baroDev_t *baro)
     // only _up part is executed, and gets both temperature and pressure
     baro->start_up = bmp280_start_up;
     baro->get_up = bmp280_get_up;
-    baro->up_delay = ((T_INIT_MAX + T_MEASURE_PER_OSRS_MAX * (((1 << BMP280_TEMPERATURE_OSR) >> 1) + ((1 << BMP280_PRESSURE_OSR) >> 1)) + (BMP280_PRESSURE_OSR ? T_SETUP_PRESSURE_MAX : 0) + 15) / 16) * 1000;
+    baro->read_up = bmp280_read_up;
+    // one conversion plus the standby, reading sooner only returns the same result again
+    baro->up_delay = ((T_INIT_MAX + T_MEASURE_PER_OSRS_MAX * (((1 << BMP280_TEMPERATURE_OSR) >> 1) + ((1 << BMP280_PRESSURE_OSR) >> 1)) + (BMP280_PRESSURE_OSR ? T_SETUP_PRESSURE_MAX : 0) + 15) / 16) * 1000 + BMP280_STANDBY_US;
     baro->calculate = bmp280_calculate;
 
     return true;
@@ -170,17 +175,21 @@ static void bmp280_get_ut(baroDev_t *baro)
 
 static void bmp280_start_up(baroDev_t *baro)
 {
-    // start measurement
-    // set oversampling + power mode (forced), and start sampling
-    bmp280WriteRegister(&baro->busdev, BMP280_CTRL_MEAS_REG, BMP280_MODE);
+    UNUSED(baro);
+    // dummy, the sensor converts continuously in normal mode
+}
+
+static bool bmp280_read_up(baroDev_t *baro)
+{
+    // read data from sensor
+    return busReadRegisterBufferStart(&baro->busdev, BMP280_PRESSURE_MSB_REG, bmp280_data, BMP280_DATA_FRAME_SIZE);
 }
 
 static void bmp280_get_up(baroDev_t *baro)
 {
-    uint8_t data[BMP280_DATA_FRAME_SIZE];
+    UNUSED(baro);
+    const uint8_t *data = bmp280_data;
 
-    // read data from sensor
-    bmp280ReadRegister(&baro->busdev, BMP280_PRESSURE_MSB_REG, BMP280_DATA_FRAME_SIZE, data);
     bmp280_up = (int32_t)((((uint32_t)(data[0])) << 12) | (((uint32_t)(data[1])) << 4) | ((uint32_t)data[2] >> 4));
     bmp280_ut = (int32_t)((((uint32_t)(data[3])) << 12) | (((uint32_t)(data[4])) << 4) | ((uint32_t)data[5] >> 4));
 }
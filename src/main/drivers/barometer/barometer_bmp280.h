@@ -33,6 +33,7 @@
 #define BMP280_TEMPERATURE_LSB_REG           (0xFB)  /* Temperature LSB Reg */
 #define BMP280_TEMPERATURE_XLSB_REG          (0xFC)  /* Temperature XLSB Reg */
 #define BMP280_FORCED_MODE                   (0x01)
+#define BMP280_NORMAL_MODE                   (0x03)
 
 #define BMP280_TEMPERATURE_CALIB_DIG_T1_LSB_REG             (0x88)
 #define BMP280_PRESSURE_TEMPERATURE_CALIB_DATA_LENGTH       (24)
@@ -45,10 +46,15 @@
 #define BMP280_OVERSAMP_8X               (0x04)
 #define BMP280_OVERSAMP_16X              (0x05)
 
-// configure pressure and temperature oversampling, forced sampling mode
+#define BMP280_STANDBY_0_5MS             (0x00)
+#define BMP280_FILTER_OFF                (0x00)
+
+// configure pressure and temperature oversampling, normal mode converts back to back with the shortest standby
 #define BMP280_PRESSURE_OSR              (BMP280_OVERSAMP_8X)
 #define BMP280_TEMPERATURE_OSR           (BMP280_OVERSAMP_1X)
-#define BMP280_MODE                      (BMP280_PRESSURE_OSR << 2 | BMP280_TEMPERATURE_OSR << 5 | BMP280_FORCED_MODE)
+#define BMP280_MODE                      (BMP280_PRESSURE_OSR << 2 | BMP280_TEMPERATURE_OSR << 5 | BMP280_NORMAL_MODE)
+#define BMP280_CONFIG                    (BMP280_STANDBY_0_5MS << 5 | BMP280_FILTER_OFF << 2)
+#define BMP280_STANDBY_US                (500)
 
 #define T_INIT_MAX                       (20)
 // 20/16 = 1.25 ms
@@ -27,6 +27,7 @@
 #include "barometer.h"
 #include "barometer_ms5611.h"
 
+#include "drivers/bus.h"
 #include "drivers/bus_i2c.h"
 #include "drivers/bus_i2c_busdev.h"
 #include "drivers/bus_spi.h"
@@ -49,8 +50,8 @@
 static void ms5611_reset(busDevice_t *busdev);
 static uint16_t ms5611_prom(busDevice_t *busdev, int8_t coef_num);
 STATIC_UNIT_TESTED int8_t ms5611_crc(uint16_t *prom);
-static uint32_t ms5611_read_adc(busDevice_t *busdev);
 static void ms5611_start_ut(baroDev_t *baro);
+static bool ms5611_read_adc(baroDev_t *baro);
 static void ms5611_get_ut(baroDev_t *baro);
 static void ms5611_start_up(baroDev_t *baro);
 static void ms5611_get_up(baroDev_t *baro);
@@ -60,6 +61,7 @@ STATIC_UNIT_TESTED uint32_t ms5611_ut;  // static result of temperature measurem
 STATIC_UNIT_TESTED uint32_t ms5611_up;  // static result of pressure measurement
 STATIC_UNIT_TESTED uint16_t ms5611_c[PROM_NB];  // on-chip ROM
 static uint8_t ms5611_osr = CMD_ADC_4096;
+static uint8_t ms5611_adc[3];   // filled by the read started in ms5611_read_adc()
 
 bool ms5611ReadCommand(busDevice_t *busdev, uint8_t cmd, uint8_t len, uint8_t *data)
 {
@@ -98,7 +100,7 @@ void ms5611BusInit(busDevice_t *busdev)
         IOInit(busdev->busdev_u.spi.csnPin, OWNER_BARO_CS, 0);
         IOConfigGPIO(busdev->busdev_u.spi.csnPin, IOCFG_OUT_PP);
         IOHi(busdev->busdev_u.spi.csnPin); // Disable
-        spiSetDivisor(busdev->busdev_u.spi.csnPin, SPI_CLOCK_STANDARD);
+        spiBusSetDivisor(busdev, SPI_CLOCK_STANDARD);
     }
 #else
     UNUSED(busdev);
@@ -153,6 +155,8 @@ bool ms5611Detect(baroDev_t *baro)
     baro->get_ut = ms5611_get_ut;
     baro->start_up = ms5611_start_up;
     baro->get_up = ms5611_get_up;
+    baro->read_ut = ms5611_read_adc;
+    baro->read_up = ms5611_read_adc;
     baro->calculate = ms5611_calculate;
 
     return true;
@@ -204,33 +208,31 @@ STATIC_UNIT_TESTED int8_t ms5611_crc(uint16_t *prom)
     return -1;
 }
 
-static uint32_t ms5611_read_adc(busDevice_t *busdev)
+static bool ms5611_read_adc(baroDev_t *baro)
 {
-    uint8_t rxbuf[3];
-
-    ms5611ReadCommand(busdev, CMD_ADC_READ, 3, rxbuf); // read ADC
-
-    return (rxbuf[0] << 16) | (rxbuf[1] << 8) | rxbuf[2];
+    return busReadRegisterBufferStart(&baro->busdev, CMD_ADC_READ, ms5611_adc, sizeof(ms5611_adc)); // read ADC
 }
 
 static void ms5611_start_ut(baroDev_t *baro)
 {
-    ms5611WriteCommand(&baro->busdev, CMD_ADC_CONV + CMD_ADC_D2 + ms5611_osr, 1); // D2 (temperature) conversion start!
+    busWriteRegisterStart(&baro->busdev, CMD_ADC_CONV + CMD_ADC_D2 + ms5611_osr, 1); // D2 (temperature) conversion start!
 }
 
 static void ms5611_get_ut(baroDev_t *baro)
 {
-    ms5611_ut = ms5611_read_adc(&baro->busdev);
+    UNUSED(baro);
+    ms5611_ut = (ms5611_adc[0] << 16) | (ms5611_adc[1] << 8) | ms5611_adc[2];
 }
 
 static void ms5611_start_up(baroDev_t *baro)
 {
-    ms5611WriteCommand(&baro->busdev, CMD_ADC_CONV + CMD_ADC_D1 + ms5611_osr, 1); // D1 (pressure) conversion start!
+    busWriteRegisterStart(&baro->busdev, CMD_ADC_CONV + CMD_ADC_D1 + ms5611_osr, 1); // D1 (pressure) conversion start!
 }
 
 static void ms5611_get_up(baroDev_t *baro)
 {
-    ms5611_up = ms5611_read_adc(&baro->busdev);
+    UNUSED(baro);
+    ms5611_up = (ms5611_adc[0] << 16) | (ms5611_adc[1] << 8) | ms5611_adc[2];
 }
 
 STATIC_UNIT_TESTED void ms5611_calculate(int32_t *pressure, int32_t *temperature)
@@ -23,8 +23,8 @@ typedef void (*bufWrite_t)(void *arg, void *data, int count);
 typedef struct bufWriter_s {
     bufWrite_t writer;
     void *arg;
-    uint8_t capacity;
-    uint8_t at;
+    uint16_t capacity;
+    uint16_t at;
     uint8_t data[];
 } bufWriter_t;
 
@@ -56,3 +56,44 @@ uint8_t busReadRegister(const busDevice_t *busdev, uint8_t reg)
     }
     return false;
 }
+
+bool busWriteRegisterStart(const busDevice_t *busdev, uint8_t reg, uint8_t data)
+{
+    switch (busdev->bustype) {
+    case BUSTYPE_SPI:
+        return spiBusWriteRegister(busdev, reg & 0x7f, data);
+    case BUSTYPE_I2C:
+        return i2cBusWriteRegisterStart(busdev, reg, data);
+    }
+    return false;
+}
+
+bool busReadRegisterBufferStart(const busDevice_t *busdev, uint8_t reg, uint8_t *data, uint8_t length)
+{
+    switch (busdev->bustype) {
+    case BUSTYPE_SPI:
+        return spiBusReadRegisterBuffer(busdev, reg | 0x80, data, length);
+    case BUSTYPE_I2C:
+        return i2cBusReadRegisterBufferStart(busdev, reg, data, length);
+    }
+    return false;
+}
+
+bool busBusy(const busDevice_t *busdev, bool *error)
+{
+    switch (busdev->bustype) {
+    case BUSTYPE_SPI:
+        // SPI transfers complete before the start functions return
+        if (error) {
+            *error = false;
+        }
+        return false;
+    case BUSTYPE_I2C:
+#ifdef USE_I2C
+        return i2cBusBusy(busdev, error);
+#else
+        break;
+#endif
+    }
+    return false;
+}
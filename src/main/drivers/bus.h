@@ -31,6 +31,8 @@ typedef struct busDevice_s {
             SPI_HandleTypeDef* handle; // cached here for efficiency
 #endif
             IO_t csnPin;
+            uint16_t divisor;       // SPIClockDivider_e the device runs at, 0 leaves the bus clock as it is
+            uint8_t clockMode;      // spiClockMode_e
         } spi;
         struct deviceI2C_s {
            I2CDevice device;
@@ -51,3 +53,8 @@ bool busWriteRegister(const busDevice_t *bus, uint8_t reg, uint8_t data);
 bool busReadRegisterBuffer(const busDevice_t *bus, uint8_t reg, uint8_t *data, uint8_t length);
 uint8_t busReadRegister(const busDevice_t *bus, uint8_t reg);
 
+// Start a transfer and return without waiting for it, false if the bus is still busy with another one.
+// The read buffer is filled once busBusy() returns false without an error. SPI transfers complete before returning.
+bool busWriteRegisterStart(const busDevice_t *bus, uint8_t reg, uint8_t data);
+bool busReadRegisterBufferStart(const busDevice_t *bus, uint8_t reg, uint8_t *data, uint8_t length);
+bool busBusy(const busDevice_t *bus, bool *error);
@@ -64,6 +64,12 @@ void i2cHardwareConfigure(void);
 void i2cInit(I2CDevice device);
 bool i2cWriteBuffer(I2CDevice device, uint8_t addr_, uint8_t reg_, uint8_t len_, uint8_t *data);
 bool i2cWrite(I2CDevice device, uint8_t addr_, uint8_t reg, uint8_t data);
+// Starts a write and returns without waiting for it to complete, false if the bus is still busy.
+// The data must stay valid until i2cBusy() returns false. Drivers without interrupt support complete the write before returning.
+bool i2cWriteBufferNonBlocking(I2CDevice device, uint8_t addr_, uint8_t reg_, uint8_t len_, uint8_t *data);
+bool i2cBusy(I2CDevice device, bool *error);
 bool i2cRead(I2CDevice device, uint8_t addr_, uint8_t reg, uint8_t len, uint8_t* buf);
+// As i2cWriteBufferNonBlocking(), the buffer is filled once i2cBusy() returns false without an error.
+bool i2cReadNonBlocking(I2CDevice device, uint8_t addr_, uint8_t reg, uint8_t len, uint8_t* buf);
 
 uint16_t i2cGetErrorCounter(void);
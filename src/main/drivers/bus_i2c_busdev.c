@@ -42,4 +42,28 @@ uint8_t i2cBusReadRegister(const busDevice_t *busdev, uint8_t reg)
     i2cRead(busdev->busdev_u.i2c.device, busdev->busdev_u.i2c.address, reg, 1, &data);
     return data;
 }
+
+// Register value of the write in flight on each bus, the driver sends it from the interrupt
+static uint8_t i2cBusWriteData[I2CDEV_COUNT];
+
+bool i2cBusWriteRegisterStart(const busDevice_t *busdev, uint8_t reg, uint8_t data)
+{
+    const I2CDevice device = busdev->busdev_u.i2c.device;
+
+    if (device == I2CINVALID || device >= I2CDEV_COUNT || i2cBusy(device, NULL)) {
+        return false;
+    }
+    i2cBusWriteData[device] = data;
+    return i2cWriteBufferNonBlocking(device, busdev->busdev_u.i2c.address, reg, 1, &i2cBusWriteData[device]);
+}
+
+bool i2cBusReadRegisterBufferStart(const busDevice_t *busdev, uint8_t reg, uint8_t *data, uint8_t length)
+{
+    return i2cReadNonBlocking(busdev->busdev_u.i2c.device, busdev->busdev_u.i2c.address, reg, length, data);
+}
+
+bool i2cBusBusy(const busDevice_t *busdev, bool *error)
+{
+    return i2cBusy(busdev->busdev_u.i2c.device, error);
+}
 #endif
@@ -204,6 +204,27 @@ bool i2cWriteBuffer(I2CDevice device, uint8_t addr, uint8_t reg, uint8_t len, ui
     return true;
 }
 
+// The software driver blocks, so the write has completed when this returns
+bool i2cWriteBufferNonBlocking(I2CDevice device, uint8_t addr_, uint8_t reg_, uint8_t len_, uint8_t *data)
+{
+    return i2cWriteBuffer(device, addr_, reg_, len_, data);
+}
+
+// The software driver blocks, so the read has completed when this returns
+bool i2cReadNonBlocking(I2CDevice device, uint8_t addr_, uint8_t reg_, uint8_t len, uint8_t* buf)
+{
+    return i2cRead(device, addr_, reg_, len, buf);
+}
+
+bool i2cBusy(I2CDevice device, bool *error)
+{
+    UNUSED(device);
+    if (error) {
+        *error = false;
+    }
+    return false;
+}
+
 bool i2cWrite(I2CDevice device, uint8_t addr, uint8_t reg, uint8_t data)
 {
     UNUSED(device);
@@ -121,7 +121,18 @@ static bool i2cHandleHardwareFailure(I2CDevice device)
     return false;
 }
 
-bool i2cWriteBuffer(I2CDevice device, uint8_t addr_, uint8_t reg_, uint8_t len_, uint8_t *data)
+// Waits for a transfer started by i2cWriteBufferNonBlocking() to finish before the bus is used again
+static bool i2cWaitForIdle(I2CDevice device)
+{
+    uint32_t timeout = I2C_DEFAULT_TIMEOUT;
+    while (i2cDevice[device].state.busy && --timeout > 0) {; }
+    if (timeout == 0)
+        return i2cHandleHardwareFailure(device);
+
+    return true;
+}
+
+bool i2cWriteBufferNonBlocking(I2CDevice device, uint8_t addr_, uint8_t reg_, uint8_t len_, uint8_t *data)
 {
     if (device == I2CINVALID || device > I2CDEV_COUNT) {
         return false;
@@ -136,6 +147,10 @@ bool i2cWriteBuffer(I2CDevice device, uint8_t addr_, uint8_t reg_, uint8_t len_,
     i2cState_t *state = &i2cDevice[device].state;
     uint32_t timeout = I2C_DEFAULT_TIMEOUT;
 
+    if (state->busy) {
+        return false;
+    }
+
     state->addr = addr_ << 1;
     state->reg = reg_;
     state->writing = 1;
@@ -156,12 +171,36 @@ bool i2cWriteBuffer(I2CDevice device, uint8_t addr_, uint8_t reg_, uint8_t len_,
         I2C_ITConfig(I2Cx, I2C_IT_EVT | I2C_IT_ERR, ENABLE);            // allow the interrupts to fire off again
     }
 
-    timeout = I2C_DEFAULT_TIMEOUT;
-    while (state->busy && --timeout > 0) {; }
-    if (timeout == 0)
-        return i2cHandleHardwareFailure(device);
+    return true;
+}
 
-    return !(state->error);
+bool i2cBusy(I2CDevice device, bool *error)
+{
+    if (device == I2CINVALID || device > I2CDEV_COUNT) {
+        return false;
+    }
+
+    if (error) {
+        *error = i2cDevice[device].state.error;
+    }
+    return i2cDevice[device].state.busy;
+}
+
+bool i2cWriteBuffer(I2CDevice device, uint8_t addr_, uint8_t reg_, uint8_t len_, uint8_t *data)
+{
+    if (device == I2CINVALID || device > I2CDEV_COUNT) {
+        return false;
+    }
+
+    if (!i2cWaitForIdle(device) || !i2cWriteBufferNonBlocking(device, addr_, reg_, len_, data)) {
+        return false;
+    }
+
+    if (!i2cWaitForIdle(device)) {
+        return false;
+    }
+
+    return !(i2cDevice[device].state.error);
 }
 
 bool i2cWrite(I2CDevice device, uint8_t addr_, uint8_t reg_, uint8_t data)
@@ -169,7 +208,7 @@ bool i2cWrite(I2CDevice device, uint8_t addr_, uint8_t reg_, uint8_t data)
     return i2cWriteBuffer(device, addr_, reg_, 1, &data);
 }
 
-bool i2cRead(I2CDevice device, uint8_t addr_, uint8_t reg_, uint8_t len, uint8_t* buf)
+bool i2cReadNonBlocking(I2CDevice device, uint8_t addr_, uint8_t reg_, uint8_t len, uint8_t* buf)
 {
     if (device == I2CINVALID || device > I2CDEV_COUNT) {
         return false;
@@ -184,6 +223,10 @@ bool i2cRead(I2CDevice device, uint8_t addr_, uint8_t reg_, uint8_t len, uint8_t
     i2cState_t *state = &i2cDevice[device].state;
     uint32_t timeout = I2C_DEFAULT_TIMEOUT;
 
+    if (state->busy) {
+        return false;
+    }
+
     state->addr = addr_ << 1;
     state->reg = reg_;
     state->writing = 0;
@@ -204,12 +247,24 @@ bool i2cRead(I2CDevice device, uint8_t addr_, uint8_t reg_, uint8_t len, uint8_t
         I2C_ITConfig(I2Cx, I2C_IT_EVT | I2C_IT_ERR, ENABLE);            // allow the interrupts to fire off again
     }
 
-    timeout = I2C_DEFAULT_TIMEOUT;
-    while (state->busy && --timeout > 0) {; }
-    if (timeout == 0)
-        return i2cHandleHardwareFailure(device);
+    return true;
+}
+
+bool i2cRead(I2CDevice device, uint8_t addr_, uint8_t reg_, uint8_t len, uint8_t* buf)
+{
+    if (device == I2CINVALID || device > I2CDEV_COUNT) {
+        return false;
+    }
+
+    if (!i2cWaitForIdle(device) || !i2cReadNonBlocking(device, addr_, reg_, len, buf)) {
+        return false;
+    }
+
+    if (!i2cWaitForIdle(device)) {
+        return false;
+    }
 
-    return !(state->error);
+    return !(i2cDevice[device].state.error);
 }
 
 static void i2c_er_handler(I2CDevice device) {
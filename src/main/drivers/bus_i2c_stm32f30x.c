@@ -127,7 +127,7 @@ uint16_t i2cGetErrorCounter(void)
     return i2cErrorCount;
 }
 
-bool i2cWrite(I2CDevice device, uint8_t addr_, uint8_t reg, uint8_t data)
+bool i2cWriteBuffer(I2CDevice device, uint8_t addr_, uint8_t reg, uint8_t len_, uint8_t *data)
 {
     if (device == I2CINVALID || device > I2CDEV_COUNT) {
         return false;
@@ -173,18 +173,20 @@ bool i2cWrite(I2CDevice device, uint8_t addr_, uint8_t reg, uint8_t data)
     }
 
     /* Configure slave address, nbytes, reload, end mode and start or stop generation */
-    I2C_TransferHandling(I2Cx, addr_, 1, I2C_AutoEnd_Mode, I2C_No_StartStop);
+    I2C_TransferHandling(I2Cx, addr_, len_, I2C_AutoEnd_Mode, I2C_No_StartStop);
 
-    /* Wait until TXIS flag is set */
-    i2cTimeout = I2C_LONG_TIMEOUT;
-    while (I2C_GetFlagStatus(I2Cx, I2C_ISR_TXIS) == RESET) {
-        if ((i2cTimeout--) == 0) {
-            return i2cTimeoutUserCallback();
+    for (unsigned i = 0; i < len_; i++) {
+        /* Wait until TXIS flag is set */
+        i2cTimeout = I2C_LONG_TIMEOUT;
+        while (I2C_GetFlagStatus(I2Cx, I2C_ISR_TXIS) == RESET) {
+            if ((i2cTimeout--) == 0) {
+                return i2cTimeoutUserCallback();
+            }
         }
-    }
 
-    /* Write data to TXDR */
-    I2C_SendData(I2Cx, data);
+        /* Write data to TXDR */
+        I2C_SendData(I2Cx, data[i]);
+    }
 
     /* Wait until STOPF flag is set */
     i2cTimeout = I2C_LONG_TIMEOUT;
@@ -200,6 +202,32 @@ bool i2cWrite(I2CDevice device, uint8_t addr_, uint8_t reg, uint8_t data)
     return true;
 }
 
+bool i2cWrite(I2CDevice device, uint8_t addr_, uint8_t reg, uint8_t data)
+{
+    return i2cWriteBuffer(device, addr_, reg, 1, &data);
+}
+
+// The F3 driver polls, so the write has completed when this returns
+bool i2cWriteBufferNonBlocking(I2CDevice device, uint8_t addr_, uint8_t reg_, uint8_t len_, uint8_t *data)
+{
+    return i2cWriteBuffer(device, addr_, reg_, len_, data);
+}
+
+// The F3 driver polls, so the read has completed when this returns
+bool i2cReadNonBlocking(I2CDevice device, uint8_t addr_, uint8_t reg_, uint8_t len, uint8_t* buf)
+{
+    return i2cRead(device, addr_, reg_, len, buf);
+}
+
+bool i2cBusy(I2CDevice device, bool *error)
+{
+    UNUSED(device);
+    if (error) {
+        *error = false;
+    }
+    return false;
+}
+
 bool i2cRead(I2CDevice device, uint8_t addr_, uint8_t reg, uint8_t len, uint8_t* buf)
 {
     if (device == I2CINVALID || device > I2CDEV_COUNT) {
@@ -28,6 +28,7 @@
 #include "drivers/bus_spi_impl.h"
 #include "drivers/exti.h"
 #include "drivers/io.h"
+#include "drivers/io_impl.h"
 #include "drivers/rcc.h"
 
 spiDevice_t spiDevice[SPIDEV_COUNT];
@@ -127,6 +128,9 @@ void spiInitDevice(SPIDevice device)
 
     SPI_Init(spi->dev, &spiInit);
     SPI_Cmd(spi->dev, ENABLE);
+    spi->divisor = 8;
+
+    spiTransactionInit(device);
 }
 
 bool spiInit(SPIDevice device)
@@ -215,8 +219,45 @@ bool spiIsBusBusy(SPI_TypeDef *instance)
 
 }
 
+/**
+ * Chip select for a device on the bus. The bus counts as in use until the device is deselected, so that interrupt code
+ * can tell it must not start a transfer of its own. Drivers that drive CS themselves use these too.
+ */
+void spiBusSelectDevice(SPI_TypeDef *instance, IO_t csnPin)
+{
+    const SPIDevice device = spiDeviceByInstance(instance);
+    if (device != SPIINVALID) {
+        spiDevice[device].deviceSelected = true;
+    }
+    IOLoFast(csnPin);
+}
+
+void spiBusDeselectDevice(SPI_TypeDef *instance, IO_t csnPin)
+{
+    IOHiFast(csnPin);
+    const SPIDevice device = spiDeviceByInstance(instance);
+    if (device != SPIINVALID) {
+        spiDevice[device].deviceSelected = false;
+    }
+}
+
+/**
+ * Return true while any device on the bus is selected, by a driver or by a queued transaction.
+ */
+bool spiBusIsInUse(SPI_TypeDef *instance)
+{
+    const SPIDevice device = spiDeviceByInstance(instance);
+    return device != SPIINVALID && spiDevice[device].deviceSelected;
+}
+
 bool spiTransfer(SPI_TypeDef *instance, const uint8_t *txData, uint8_t *rxData, int len)
 {
+#ifdef STM32F303xC
+    if (!spiTransferFifo(instance, txData, rxData, len)) {
+        return spiTimeoutUserCallback(instance);
+    }
+    return true;
+#else
     uint16_t spiTimeout = 1000;
 
     uint8_t b;
@@ -247,25 +288,58 @@ bool spiTransfer(SPI_TypeDef *instance, const uint8_t *txData, uint8_t *rxData,
     }
 
     return true;
+#endif
 }
 
 bool spiBusTransfer(const busDevice_t *bus, const uint8_t *txData, uint8_t *rxData, int length)
 {
-    IOLo(bus->busdev_u.spi.csnPin);
+    spiBusLock(bus->busdev_u.spi.instance);
+    spiBusApplyProfile(bus);
+    spiBusSelectDevice(bus->busdev_u.spi.instance, bus->busdev_u.spi.csnPin);
     spiTransfer(bus->busdev_u.spi.instance, txData, rxData, length);
-    IOHi(bus->busdev_u.spi.csnPin);
+    spiBusDeselectDevice(bus->busdev_u.spi.instance, bus->busdev_u.spi.csnPin);
+    spiBusUnlock(bus->busdev_u.spi.instance);
     return true;
 }
 
 void spiSetDivisor(SPI_TypeDef *instance, uint16_t divisor)
 {
 #define BR_CLEAR_MASK 0xFFC7
+    const SPIDevice device = spiDeviceByInstance(instance);
+    if (device != SPIINVALID && spiDevice[device].divisor == divisor) {
+        return;
+    }
+
     SPI_Cmd(instance, DISABLE);
 
     const uint16_t tempRegister = (instance->CR1 & BR_CLEAR_MASK);
     instance->CR1 = (tempRegister | ((ffs(divisor | 0x100) - 2) << 3));
 
     SPI_Cmd(instance, ENABLE);
+
+    if (device != SPIINVALID) {
+        spiDevice[device].divisor = divisor;
+    }
+}
+
+static void spiSetClockMode(SPI_TypeDef *instance, bool leadingEdge)
+{
+    const SPIDevice device = spiDeviceByInstance(instance);
+    if (device == SPIINVALID || spiDevice[device].leadingEdge == leadingEdge) {
+        return;
+    }
+
+    SPI_Cmd(instance, DISABLE);
+
+    if (leadingEdge) {
+        instance->CR1 &= ~(SPI_CR1_CPOL | SPI_CR1_CPHA);
+    } else {
+        instance->CR1 |= SPI_CR1_CPOL | SPI_CR1_CPHA;
+    }
+
+    SPI_Cmd(instance, ENABLE);
+
+    spiDevice[device].leadingEdge = leadingEdge;
 }
 
 uint16_t spiGetErrorCounter(SPI_TypeDef *instance)
@@ -287,20 +361,26 @@ void spiResetErrorCounter(SPI_TypeDef *instance)
 
 bool spiBusWriteRegister(const busDevice_t *bus, uint8_t reg, uint8_t data)
 {
-    IOLo(bus->busdev_u.spi.csnPin);
+    spiBusLock(bus->busdev_u.spi.instance);
+    spiBusApplyProfile(bus);
+    spiBusSelectDevice(bus->busdev_u.spi.instance, bus->busdev_u.spi.csnPin);
     spiTransferByte(bus->busdev_u.spi.instance, reg);
     spiTransferByte(bus->busdev_u.spi.instance, data);
-    IOHi(bus->busdev_u.spi.csnPin);
+    spiBusDeselectDevice(bus->busdev_u.spi.instance, bus->busdev_u.spi.csnPin);
+    spiBusUnlock(bus->busdev_u.spi.instance);
 
     return true;
 }
 
 bool spiBusReadRegisterBuffer(const busDevice_t *bus, uint8_t reg, uint8_t *data, uint8_t length)
 {
-    IOLo(bus->busdev_u.spi.csnPin);
+    spiBusLock(bus->busdev_u.spi.instance);
+    spiBusApplyProfile(bus);
+    spiBusSelectDevice(bus->busdev_u.spi.instance, bus->busdev_u.spi.csnPin);
     spiTransferByte(bus->busdev_u.spi.instance, reg | 0x80); // read transaction
     spiTransfer(bus->busdev_u.spi.instance, NULL, data, length);
-    IOHi(bus->busdev_u.spi.csnPin);
+    spiBusDeselectDevice(bus->busdev_u.spi.instance, bus->busdev_u.spi.csnPin);
+    spiBusUnlock(bus->busdev_u.spi.instance);
 
     return true;
 }
@@ -308,10 +388,13 @@ bool spiBusReadRegisterBuffer(const busDevice_t *bus, uint8_t reg, uint8_t *data
 uint8_t spiBusReadRegister(const busDevice_t *bus, uint8_t reg)
 {
     uint8_t data;
-    IOLo(bus->busdev_u.spi.csnPin);
+    spiBusLock(bus->busdev_u.spi.instance);
+    spiBusApplyProfile(bus);
+    spiBusSelectDevice(bus->busdev_u.spi.instance, bus->busdev_u.spi.csnPin);
     spiTransferByte(bus->busdev_u.spi.instance, reg | 0x80); // read transaction
     spiTransfer(bus->busdev_u.spi.instance, NULL, &data, 1);
-    IOHi(bus->busdev_u.spi.csnPin);
+    spiBusDeselectDevice(bus->busdev_u.spi.instance, bus->busdev_u.spi.csnPin);
+    spiBusUnlock(bus->busdev_u.spi.instance);
 
     return data;
 }
@@ -320,4 +403,27 @@ void spiBusSetInstance(busDevice_t *bus, SPI_TypeDef *instance)
 {
     bus->busdev_u.spi.instance = instance;
 }
+
+void spiBusSetDivisor(busDevice_t *bus, uint16_t divisor)
+{
+    bus->busdev_u.spi.divisor = divisor;
+    spiSetDivisor(bus->busdev_u.spi.instance, divisor);
+}
+
+void spiBusSetClockMode(busDevice_t *bus, spiClockMode_e clockMode)
+{
+    bus->busdev_u.spi.clockMode = clockMode;
+    spiBusApplyProfile(bus);
+}
+
+// Switch the bus to the clock and mode of the device about to be selected
+void spiBusApplyProfile(const busDevice_t *bus)
+{
+    if (bus->busdev_u.spi.divisor) {
+        spiSetDivisor(bus->busdev_u.spi.instance, bus->busdev_u.spi.divisor);
+    }
+    if (bus->busdev_u.spi.clockMode != SPI_CLOCK_MODE_BUS) {
+        spiSetClockMode(bus->busdev_u.spi.instance, bus->busdev_u.spi.clockMode == SPI_CLOCK_MODE_LEADING_EDGE);
+    }
+}
 #endif
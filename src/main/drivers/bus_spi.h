@@ -63,6 +63,13 @@ typedef enum {
 #endif
 } SPIClockDivider_e;
 
+// The bus is switched to a device's clock and mode when it is selected, and only reprogrammed when they differ
+typedef enum {
+    SPI_CLOCK_MODE_BUS = 0,         // keep the mode the bus was initialised with
+    SPI_CLOCK_MODE_LEADING_EDGE,    // CPOL 0, CPHA 0
+    SPI_CLOCK_MODE_TRAILING_EDGE    // CPOL 1, CPHA 1
+} spiClockMode_e;
+
 typedef enum SPIDevice {
     SPIINVALID = -1,
     SPIDEV_1   = 0,
@@ -86,11 +93,49 @@ typedef enum SPIDevice {
 #define SPI_CFG_TO_DEV(x)   ((x) - 1)
 #define SPI_DEV_TO_CFG(x)   ((x) + 1)
 
+#if defined(STM32F4) && !defined(USE_HAL_DRIVER) && (defined(SPI1_DMA_STREAM_TX) || defined(SPI2_DMA_STREAM_TX) || defined(SPI3_DMA_STREAM_TX))
+// Queued transactions are sent by DMA on the buses the target gives streams to, and polled on the others
+#define USE_SPI_TRANSACTION_DMA
+#endif
+
+typedef enum {
+    SPI_PRIORITY_HIGH = 0,      // gyro and other time critical reads
+    SPI_PRIORITY_NORMAL,
+    SPI_PRIORITY_LOW,           // bulk transfers such as flash writes
+    SPI_PRIORITY_COUNT
+} spiPriority_e;
+
+typedef struct spiSegment_s {
+    const uint8_t *txData;      // NULL sends 0xFF
+    uint8_t *rxData;            // NULL discards what is received
+    uint16_t length;
+    bool negateCS;              // raise CS after this segment, a higher priority transaction may then go first
+} spiSegment_t;
+
+struct spiTransaction_s;
+typedef void (*spiTransactionCallbackFn)(struct spiTransaction_s *transaction);
+
+typedef struct spiTransaction_s {
+    const busDevice_t *bus;
+    uint16_t divisor;           // SPIClockDivider_e to use while CS is low, 0 for the device's own
+    spiPriority_e priority;
+    const spiSegment_t *segments;
+    uint8_t segmentCount;       // CS is always raised after the last segment
+    spiTransactionCallbackFn callback;  // called once all segments are sent, from the DMA interrupt on a DMA bus
+    // Owned by the bus from submission until completion
+    uint8_t nextSegment;
+    volatile bool busy;
+    struct spiTransaction_s *next;
+} spiTransaction_t;
+
 void spiPreInitCs(ioTag_t iotag);
 bool spiInit(SPIDevice device);
 void spiSetDivisor(SPI_TypeDef *instance, uint16_t divisor);
 uint8_t spiTransferByte(SPI_TypeDef *instance, uint8_t data);
 bool spiIsBusBusy(SPI_TypeDef *instance);
+void spiBusSelectDevice(SPI_TypeDef *instance, IO_t csnPin);
+void spiBusDeselectDevice(SPI_TypeDef *instance, IO_t csnPin);
+bool spiBusIsInUse(SPI_TypeDef *instance);
 
 bool spiTransfer(SPI_TypeDef *instance, const uint8_t *txData, uint8_t *rxData, int len);
 
@@ -106,10 +151,25 @@ SPI_HandleTypeDef* spiHandleByInstance(SPI_TypeDef *instance);
 DMA_HandleTypeDef* spiSetDMATransmit(DMA_Stream_TypeDef *Stream, uint32_t Channel, SPI_TypeDef *Instance, const uint8_t *pData, uint16_t Size);
 #endif
 
+void spiTransactionInit(SPIDevice device);
+bool spiTransactionSubmit(spiTransaction_t *transaction);
+bool spiTransactionIsComplete(const spiTransaction_t *transaction);
+void spiTransactionWait(const spiTransaction_t *transaction);
+#ifdef USE_SPI_TRANSACTION_DMA
+void spiBusLock(SPI_TypeDef *instance);
+void spiBusUnlock(SPI_TypeDef *instance);
+#else
+#define spiBusLock(instance)    ((void)(instance))
+#define spiBusUnlock(instance)  ((void)(instance))
+#endif
+
 bool spiBusWriteRegister(const busDevice_t *bus, uint8_t reg, uint8_t data);
 bool spiBusReadRegisterBuffer(const busDevice_t *bus, uint8_t reg, uint8_t *data, uint8_t length);
 uint8_t spiBusReadRegister(const busDevice_t *bus, uint8_t reg);
 void spiBusSetInstance(busDevice_t *bus, SPI_TypeDef *instance);
+void spiBusSetDivisor(busDevice_t *bus, uint16_t divisor);
+void spiBusSetClockMode(busDevice_t *bus, spiClockMode_e clockMode);
+void spiBusApplyProfile(const busDevice_t *bus);
 
 typedef struct spiPinConfig_s {
     ioTag_t ioTagSck[SPIDEV_COUNT];
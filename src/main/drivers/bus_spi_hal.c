@@ -30,6 +30,7 @@
 #include "drivers/bus_spi_impl.h"
 #include "drivers/dma.h"
 #include "drivers/io.h"
+#include "drivers/io_impl.h"
 #include "drivers/nvic.h"
 #include "drivers/rcc.h"
 
@@ -211,6 +212,9 @@ void spiInitDevice(SPIDevice device)
     if (HAL_SPI_Init(&spiDevice[device].hspi) == HAL_OK)
     {
     }
+    spi->divisor = 256;
+
+    spiTransactionInit(device);
 }
 
 bool spiInit(SPIDevice device)
@@ -272,19 +276,41 @@ bool spiIsBusBusy(SPI_TypeDef *instance)
         return false;
 }
 
-bool spiTransfer(SPI_TypeDef *instance, const uint8_t *txData, uint8_t *rxData, int len)
+/**
+ * Chip select for a device on the bus. The bus counts as in use until the device is deselected, so that interrupt code
+ * can tell it must not start a transfer of its own. Drivers that drive CS themselves use these too.
+ */
+void spiBusSelectDevice(SPI_TypeDef *instance, IO_t csnPin)
 {
-    SPIDevice device = spiDeviceByInstance(instance);
-    HAL_StatusTypeDef status;
-
-    if (!rxData) { // Tx only
-        status = HAL_SPI_Transmit(&spiDevice[device].hspi, txData, len, SPI_DEFAULT_TIMEOUT);
-    } else if (!txData) { // Rx only
-        status = HAL_SPI_Receive(&spiDevice[device].hspi, rxData, len, SPI_DEFAULT_TIMEOUT);
-    } else { // Tx and Rx
-        status = HAL_SPI_TransmitReceive(&spiDevice[device].hspi, txData, rxData, len, SPI_DEFAULT_TIMEOUT);
+    const SPIDevice device = spiDeviceByInstance(instance);
+    if (device != SPIINVALID) {
+        spiDevice[device].deviceSelected = true;
     }
-    if (status != HAL_OK) {
+    IOLoFast(csnPin);
+}
+
+void spiBusDeselectDevice(SPI_TypeDef *instance, IO_t csnPin)
+{
+    IOHiFast(csnPin);
+    const SPIDevice device = spiDeviceByInstance(instance);
+    if (device != SPIINVALID) {
+        spiDevice[device].deviceSelected = false;
+    }
+}
+
+/**
+ * Return true while any device on the bus is selected, by a driver or by a queued transaction.
+ */
+bool spiBusIsInUse(SPI_TypeDef *instance)
+{
+    const SPIDevice device = spiDeviceByInstance(instance);
+    return device != SPIINVALID && spiDevice[device].deviceSelected;
+}
+
+// Blocking transfers drive the FIFO directly, the HAL calls stop the bus between bytes
+bool spiTransfer(SPI_TypeDef *instance, const uint8_t *txData, uint8_t *rxData, int len)
+{
+    if (!spiTransferFifo(instance, txData, rxData, len)) {
         spiTimeoutUserCallback(instance);
     }
     return true;
@@ -292,11 +318,7 @@ bool spiTransfer(SPI_TypeDef *instance, const uint8_t *txData, uint8_t *rxData,
 
 static bool spiBusReadBuffer(const busDevice_t *bus, uint8_t *out, int len)
 {
-    const HAL_StatusTypeDef status = HAL_SPI_Receive(bus->busdev_u.spi.handle, out, len, SPI_DEFAULT_TIMEOUT);
-    if (status != HAL_OK) {
-        spiTimeoutUserCallback(bus->busdev_u.spi.instance);
-    }
-    return true;
+    return spiTransfer(bus->busdev_u.spi.instance, NULL, out, len);
 }
 
 uint8_t spiTransferByte(SPI_TypeDef *instance, uint8_t txByte)
@@ -309,27 +331,26 @@ uint8_t spiTransferByte(SPI_TypeDef *instance, uint8_t txByte)
 
 static uint8_t spiBusTransferByte(const busDevice_t *bus, uint8_t in)
 {
-    const HAL_StatusTypeDef status = HAL_SPI_TransmitReceive(bus->busdev_u.spi.handle, &in, &in, 1, SPI_DEFAULT_TIMEOUT);
-    if (status != HAL_OK) {
-        spiTimeoutUserCallback(bus->busdev_u.spi.instance);
-    }
+    spiTransfer(bus->busdev_u.spi.instance, &in, &in, 1);
     return in;
 }
 
 bool spiBusTransfer(const busDevice_t *bus, const uint8_t *txData, uint8_t *rxData, int len)
 {
-    IOLo(bus->busdev_u.spi.csnPin);
-    const HAL_StatusTypeDef status = HAL_SPI_TransmitReceive(bus->busdev_u.spi.handle, txData, rxData, len, SPI_DEFAULT_TIMEOUT);
-    IOHi(bus->busdev_u.spi.csnPin);
-    if (status != HAL_OK) {
-        spiTimeoutUserCallback(bus->busdev_u.spi.instance);
-    }
+    spiBusApplyProfile(bus);
+    spiBusSelectDevice(bus->busdev_u.spi.instance, bus->busdev_u.spi.csnPin);
+    spiTransfer(bus->busdev_u.spi.instance, txData, rxData, len);
+    spiBusDeselectDevice(bus->busdev_u.spi.instance, bus->busdev_u.spi.csnPin);
     return true;
 }
 
 void spiSetDivisor(SPI_TypeDef *instance, uint16_t divisor)
 {
     SPIDevice device = spiDeviceByInstance(instance);
+    if (device == SPIINVALID || spiDevice[device].divisor == divisor) {
+        return;
+    }
+
     if (HAL_SPI_DeInit(&spiDevice[device].hspi) == HAL_OK)
     {
     }
@@ -345,6 +366,29 @@ void spiSetDivisor(SPI_TypeDef *instance, uint16_t divisor)
     if (HAL_SPI_Init(&spiDevice[device].hspi) == HAL_OK)
     {
     }
+    spiDevice[device].divisor = divisor;
+}
+
+static void spiSetClockMode(SPI_TypeDef *instance, bool leadingEdge)
+{
+    SPIDevice device = spiDeviceByInstance(instance);
+    if (device == SPIINVALID || spiDevice[device].leadingEdge == leadingEdge) {
+        return;
+    }
+
+    HAL_SPI_DeInit(&spiDevice[device].hspi);
+
+    if (leadingEdge) {
+        spiDevice[device].hspi.Init.CLKPolarity = SPI_POLARITY_LOW;
+        spiDevice[device].hspi.Init.CLKPhase = SPI_PHASE_1EDGE;
+    } else {
+        spiDevice[device].hspi.Init.CLKPolarity = SPI_POLARITY_HIGH;
+        spiDevice[device].hspi.Init.CLKPhase = SPI_PHASE_2EDGE;
+    }
+
+    HAL_SPI_Init(&spiDevice[device].hspi);
+
+    spiDevice[device].leadingEdge = leadingEdge;
 }
 
 uint16_t spiGetErrorCounter(SPI_TypeDef *instance)
@@ -366,20 +410,22 @@ void spiResetErrorCounter(SPI_TypeDef *instance)
 
 bool spiBusWriteRegister(const busDevice_t *bus, uint8_t reg, uint8_t data)
 {
-    IOLo(bus->busdev_u.spi.csnPin);
+    spiBusApplyProfile(bus);
+    spiBusSelectDevice(bus->busdev_u.spi.instance, bus->busdev_u.spi.csnPin);
     spiBusTransferByte(bus, reg);
     spiBusTransferByte(bus, data);
-    IOHi(bus->busdev_u.spi.csnPin);
+    spiBusDeselectDevice(bus->busdev_u.spi.instance, bus->busdev_u.spi.csnPin);
 
     return true;
 }
 
 bool spiBusReadRegisterBuffer(const busDevice_t *bus, uint8_t reg, uint8_t *data, uint8_t length)
 {
-    IOLo(bus->busdev_u.spi.csnPin);
+    spiBusApplyProfile(bus);
+    spiBusSelectDevice(bus->busdev_u.spi.instance, bus->busdev_u.spi.csnPin);
     spiBusTransferByte(bus, reg | 0x80); // read transaction
     spiBusReadBuffer(bus, data, length);
-    IOHi(bus->busdev_u.spi.csnPin);
+    spiBusDeselectDevice(bus->busdev_u.spi.instance, bus->busdev_u.spi.csnPin);
 
     return true;
 }
@@ -387,10 +433,11 @@ bool spiBusReadRegisterBuffer(const busDevice_t *bus, uint8_t reg, uint8_t *data
 uint8_t spiBusReadRegister(const busDevice_t *bus, uint8_t reg)
 {
     uint8_t data;
-    IOLo(bus->busdev_u.spi.csnPin);
+    spiBusApplyProfile(bus);
+    spiBusSelectDevice(bus->busdev_u.spi.instance, bus->busdev_u.spi.csnPin);
     spiBusTransferByte(bus, reg | 0x80); // read transaction
     spiBusReadBuffer(bus, &data, 1);
-    IOHi(bus->busdev_u.spi.csnPin);
+    spiBusDeselectDevice(bus->busdev_u.spi.instance, bus->busdev_u.spi.csnPin);
 
     return data;
 }
@@ -401,6 +448,29 @@ void spiBusSetInstance(busDevice_t *bus, SPI_TypeDef *instance)
     bus->busdev_u.spi.handle = spiHandleByInstance(instance);
 }
 
+void spiBusSetDivisor(busDevice_t *bus, uint16_t divisor)
+{
+    bus->busdev_u.spi.divisor = divisor;
+    spiSetDivisor(bus->busdev_u.spi.instance, divisor);
+}
+
+void spiBusSetClockMode(busDevice_t *bus, spiClockMode_e clockMode)
+{
+    bus->busdev_u.spi.clockMode = clockMode;
+    spiBusApplyProfile(bus);
+}
+
+// Switch the bus to the clock and mode of the device about to be selected
+void spiBusApplyProfile(const busDevice_t *bus)
+{
+    if (bus->busdev_u.spi.divisor) {
+        spiSetDivisor(bus->busdev_u.spi.instance, bus->busdev_u.spi.divisor);
+    }
+    if (bus->busdev_u.spi.clockMode != SPI_CLOCK_MODE_BUS) {
+        spiSetClockMode(bus->busdev_u.spi.instance, bus->busdev_u.spi.clockMode == SPI_CLOCK_MODE_LEADING_EDGE);
+    }
+}
+
 void dmaSPIIRQHandler(dmaChannelDescriptor_t* descriptor)
 {
     SPIDevice device = descriptor->userParam;
@@ -440,7 +510,8 @@ DMA_HandleTypeDef* spiSetDMATransmit(DMA_Stream_TypeDef *Stream, uint32_t Channe
     // DMA TX Interrupt
     dmaSetHandler(spiDevice[device].dmaIrqHandler, dmaSPIIRQHandler, NVIC_BUILD_PRIORITY(3, 0), (uint32_t)device);
 
-    //HAL_CLEANCACHE(pData,Size);
+    // the buffer is the caller's, the SD card sector cache for one, so it may still be in the data cache
+    dmaCacheClean(pData, Size);
     // And Transmit
     HAL_SPI_Transmit_DMA(&spiDevice[device].hspi, CONST_CAST(uint8_t*, pData), Size);
 
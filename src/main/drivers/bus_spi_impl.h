@@ -61,6 +61,8 @@ typedef struct SPIDevice_s {
 #endif
     rccPeriphTag_t rcc;
     volatile uint16_t errorCount;
+    volatile bool deviceSelected;   // a device on the bus has CS low, see spiBusIsInUse()
+    uint16_t divisor;
     bool leadingEdge;
 #if defined(USE_HAL_DRIVER)
     SPI_HandleTypeDef hspi;
@@ -71,3 +73,58 @@ typedef struct SPIDevice_s {
 
 extern spiDevice_t spiDevice[SPIDEV_COUNT];
 
+
+#if defined(STM32F3) || defined(STM32F7)
+// Bytes sent but not yet read back, the receive FIFO holds four so it can never overflow
+#define SPI_FIFO_DEPTH 4
+
+/*
+ * Keep the transmit FIFO topped up while reading back, so the bus clocks out a block without stopping between bytes.
+ * Two bytes at a time go in with one 16 bit write, which the SPI packs into two 8 bit frames.
+ *
+ * Returns false on a timeout.
+ */
+static inline bool spiTransferFifo(SPI_TypeDef *instance, const uint8_t *txData, uint8_t *rxData, int len)
+{
+    int txRemaining = len;
+    int rxRemaining = len;
+    uint16_t spiTimeout = 1000;
+    // DR is 32 bits wide on the F7, the access width picks how many frames go into the FIFO
+    __IO uint16_t *dr16 = (__IO uint16_t *)&instance->DR;
+
+    instance->CR2 |= SPI_CR2_FRXTH; // RXNE for every byte
+    instance->CR1 |= SPI_CR1_SPE;
+
+    while (instance->SR & SPI_SR_RXNE) {
+        *(__IO uint8_t *)&instance->DR; // discard anything left in the receive FIFO
+    }
+
+    while (rxRemaining) {
+        const int inFlight = rxRemaining - txRemaining;
+        if (txRemaining && inFlight < SPI_FIFO_DEPTH && (instance->SR & SPI_SR_TXE)) {
+            if (txRemaining >= 2 && inFlight <= SPI_FIFO_DEPTH - 2) {
+                *dr16 = txData ? (txData[0] | (txData[1] << 8)) : 0xFFFF;
+                if (txData) {
+                    txData += 2;
+                }
+                txRemaining -= 2;
+            } else {
+                *(__IO uint8_t *)&instance->DR = txData ? *(txData++) : 0xFF;
+                txRemaining--;
+            }
+        }
+        if (instance->SR & SPI_SR_RXNE) {
+            const uint8_t b = *(__IO uint8_t *)&instance->DR;
+            if (rxData) {
+                *(rxData++) = b;
+            }
+            rxRemaining--;
+            spiTimeout = 1000;
+        } else if ((spiTimeout--) == 0) {
+            return false;
+        }
+    }
+
+    return true;
+}
+#endif
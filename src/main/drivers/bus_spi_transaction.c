@@ -0,0 +1,366 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <platform.h>
+
+#ifdef USE_SPI
+
+#include "build/atomic.h"
+
+#include "drivers/bus.h"
+#include "drivers/bus_spi.h"
+#include "drivers/bus_spi_impl.h"
+#include "drivers/dma.h"
+#include "drivers/io.h"
+#include "drivers/io_impl.h"
+#include "drivers/nvic.h"
+
+/*
+ * Transactions are queued per bus, one FIFO for each priority. The bus sends one segment at a time, and whenever CS
+ * goes high it starts over with the highest priority transaction waiting, so a gyro read waits for at most one
+ * segment of a flash write.
+ *
+ * The blocking spiBus*() calls lock the bus instead of queueing, which holds the queue off at the next CS boundary
+ * until they are done. Drivers that drive CS themselves and call spiTransfer() directly are not held off, so they must
+ * not share a DMA bus with queued transactions.
+ */
+typedef struct spiQueue_s {
+    SPI_TypeDef *instance;
+    SPIDevice device;
+    spiTransaction_t *head[SPI_PRIORITY_COUNT];
+    spiTransaction_t *tail[SPI_PRIORITY_COUNT];
+    spiTransaction_t *selected;             // the transaction that has CS low
+    spiTransaction_t *current;              // the transaction the segment being sent belongs to
+    uint16_t savedDivisor;                  // bus clock to go back to when CS goes high
+#ifdef USE_SPI_TRANSACTION_DMA
+    DMA_Stream_TypeDef *txStream;
+    DMA_Stream_TypeDef *rxStream;
+    dmaChannelDescriptor_t *txDescriptor;
+    dmaChannelDescriptor_t *rxDescriptor;
+    volatile uint8_t lockCount;
+#endif
+} spiQueue_t;
+
+static spiQueue_t spiQueues[SPIDEV_COUNT];
+
+#ifdef USE_SPI_TRANSACTION_DMA
+#define SPI_QUEUE_DMA_FLAGS (DMA_IT_TCIF | DMA_IT_HTIF | DMA_IT_TEIF | DMA_IT_DMEIF | DMA_IT_FEIF)
+
+typedef struct spiQueueDmaConfig_s {
+    DMA_Stream_TypeDef *txStream;
+    DMA_Stream_TypeDef *rxStream;
+    uint32_t channel;
+} spiQueueDmaConfig_t;
+
+static const spiQueueDmaConfig_t spiQueueDmaConfig[SPIDEV_COUNT] = {
+#ifdef SPI1_DMA_STREAM_TX
+    [SPIDEV_1] = { SPI1_DMA_STREAM_TX, SPI1_DMA_STREAM_RX, SPI1_DMA_CHANNEL },
+#endif
+#ifdef SPI2_DMA_STREAM_TX
+    [SPIDEV_2] = { SPI2_DMA_STREAM_TX, SPI2_DMA_STREAM_RX, SPI2_DMA_CHANNEL },
+#endif
+#ifdef SPI3_DMA_STREAM_TX
+    [SPIDEV_3] = { SPI3_DMA_STREAM_TX, SPI3_DMA_STREAM_RX, SPI3_DMA_CHANNEL },
+#endif
+};
+#endif
+
+static spiQueue_t *spiQueueByInstance(SPI_TypeDef *instance)
+{
+    const SPIDevice device = spiDeviceByInstance(instance);
+    if (device == SPIINVALID || !spiQueues[device].instance) {
+        return NULL;
+    }
+    return &spiQueues[device];
+}
+
+static void spiQueueSelect(spiQueue_t *queue, spiTransaction_t *transaction)
+{
+    queue->savedDivisor = spiDevice[queue->device].divisor;
+    spiBusApplyProfile(transaction->bus);
+    if (transaction->divisor) {
+        spiSetDivisor(queue->instance, transaction->divisor);
+    }
+    spiDevice[queue->device].deviceSelected = true;
+    IOLoFast(transaction->bus->busdev_u.spi.csnPin);
+    queue->selected = transaction;
+}
+
+static void spiQueueDeselect(spiQueue_t *queue, spiTransaction_t *transaction)
+{
+    IOHiFast(transaction->bus->busdev_u.spi.csnPin);
+    spiDevice[queue->device].deviceSelected = false;
+    // put the clock back for drivers that set it themselves, spiSetDivisor() skips it if nothing changed
+    spiSetDivisor(queue->instance, queue->savedDivisor);
+    queue->selected = NULL;
+}
+
+// The transaction to send the next segment of, which is the one holding CS if there is one
+static spiTransaction_t *spiQueueNextTransaction(spiQueue_t *queue)
+{
+    if (queue->selected) {
+        return queue->selected;
+    }
+#ifdef USE_SPI_TRANSACTION_DMA
+    if (queue->lockCount) {
+        return NULL;
+    }
+#endif
+    for (int priority = 0; priority < SPI_PRIORITY_COUNT; priority++) {
+        spiTransaction_t *transaction = queue->head[priority];
+        if (transaction) {
+            spiQueueSelect(queue, transaction);
+            return transaction;
+        }
+    }
+    return NULL;
+}
+
+static void spiQueueSegmentDone(spiQueue_t *queue)
+{
+    spiTransaction_t *transaction = queue->current;
+    queue->current = NULL;
+
+    const spiSegment_t *segment = &transaction->segments[transaction->nextSegment++];
+    const bool last = transaction->nextSegment == transaction->segmentCount;
+    if (segment->negateCS || last) {
+        spiQueueDeselect(queue, transaction);
+    }
+    if (last) {
+        queue->head[transaction->priority] = transaction->next;
+        if (!transaction->next) {
+            queue->tail[transaction->priority] = NULL;
+        }
+        transaction->busy = false;
+        if (transaction->callback) {
+            transaction->callback(transaction);
+        }
+    }
+}
+
+#ifdef USE_SPI_TRANSACTION_DMA
+static void spiQueueStartDma(spiQueue_t *queue, const spiSegment_t *segment)
+{
+    static const uint8_t dummyTx = 0xFF;
+    static uint8_t dummyRx;
+
+    DMA_CLEAR_FLAG(queue->txDescriptor, SPI_QUEUE_DMA_FLAGS);
+    DMA_CLEAR_FLAG(queue->rxDescriptor, SPI_QUEUE_DMA_FLAGS);
+
+    // Without a buffer the stream keeps to the one dummy byte
+    if (segment->txData) {
+        queue->txStream->M0AR = (uint32_t)segment->txData;
+        queue->txStream->CR |= DMA_SxCR_MINC;
+    } else {
+        queue->txStream->M0AR = (uint32_t)&dummyTx;
+        queue->txStream->CR &= ~DMA_SxCR_MINC;
+    }
+    if (segment->rxData) {
+        queue->rxStream->M0AR = (uint32_t)segment->rxData;
+        queue->rxStream->CR |= DMA_SxCR_MINC;
+    } else {
+        queue->rxStream->M0AR = (uint32_t)&dummyRx;
+        queue->rxStream->CR &= ~DMA_SxCR_MINC;
+    }
+    DMA_SetCurrDataCounter(queue->txStream, segment->length);
+    DMA_SetCurrDataCounter(queue->rxStream, segment->length);
+
+    queue->instance->DR; // discard anything left in the receive register
+    DMA_Cmd(queue->rxStream, ENABLE);
+    DMA_Cmd(queue->txStream, ENABLE);
+    SPI_I2S_DMACmd(queue->instance, SPI_I2S_DMAReq_Rx | SPI_I2S_DMAReq_Tx, ENABLE);
+}
+#endif
+
+// Sends segments until the queue is empty or one is left running on DMA
+static void spiQueueRun(spiQueue_t *queue)
+{
+    while (!queue->current) {
+        spiTransaction_t *transaction = spiQueueNextTransaction(queue);
+        if (!transaction) {
+            return;
+        }
+        const spiSegment_t *segment = &transaction->segments[transaction->nextSegment];
+        queue->current = transaction;
+#ifdef USE_SPI_TRANSACTION_DMA
+        if (queue->rxStream && segment->length) {
+            spiQueueStartDma(queue, segment);
+            return;
+        }
+#endif
+        spiTransfer(queue->instance, segment->txData, segment->rxData, segment->length);
+        spiQueueSegmentDone(queue);
+    }
+}
+
+#ifdef USE_SPI_TRANSACTION_DMA
+// Receive stream interrupt, the receive stream completes once the last byte has been clocked in
+static void spiQueueDmaIrqHandler(dmaChannelDescriptor_t *descriptor)
+{
+    spiQueue_t *queue = &spiQueues[descriptor->userParam];
+
+    if (DMA_GET_FLAG_STATUS(descriptor, DMA_IT_TEIF)) {
+        spiDevice[descriptor->userParam].errorCount++;
+        DMA_Cmd(queue->txStream, DISABLE);
+    }
+    DMA_CLEAR_FLAG(descriptor, SPI_QUEUE_DMA_FLAGS);
+    SPI_I2S_DMACmd(queue->instance, SPI_I2S_DMAReq_Rx | SPI_I2S_DMAReq_Tx, DISABLE);
+
+    spiQueueSegmentDone(queue);
+    spiQueueRun(queue);
+}
+
+static void spiQueueDmaInit(spiQueue_t *queue, SPIDevice device)
+{
+    const spiQueueDmaConfig_t *config = &spiQueueDmaConfig[device];
+    if (!config->rxStream) {
+        return;
+    }
+
+    queue->txStream = config->txStream;
+    queue->rxStream = config->rxStream;
+    queue->txDescriptor = getDmaDescriptor(config->txStream);
+    queue->rxDescriptor = getDmaDescriptor(config->rxStream);
+
+    dmaInit(dmaGetIdentifier(config->txStream), OWNER_SPI_DMA, RESOURCE_INDEX(device));
+    dmaInit(dmaGetIdentifier(config->rxStream), OWNER_SPI_DMA, RESOURCE_INDEX(device));
+
+    DMA_DeInit(config->txStream);
+    DMA_DeInit(config->rxStream);
+
+    DMA_InitTypeDef DMA_InitStructure;
+    DMA_StructInit(&DMA_InitStructure);
+    DMA_InitStructure.DMA_Channel = config->channel;
+    DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32_t)(&(queue->instance->DR));
+    DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte;
+    DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_Byte;
+    DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+    DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+    DMA_InitStructure.DMA_BufferSize = 1;
+    DMA_InitStructure.DMA_Mode = DMA_Mode_Normal;
+    DMA_InitStructure.DMA_Priority = DMA_Priority_Medium;
+
+    DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralToMemory;
+    DMA_Init(config->rxStream, &DMA_InitStructure);
+
+    DMA_InitStructure.DMA_DIR = DMA_DIR_MemoryToPeripheral;
+    DMA_Init(config->txStream, &DMA_InitStructure);
+
+    DMA_ITConfig(config->rxStream, DMA_IT_TC | DMA_IT_TE, ENABLE);
+    dmaSetHandler(dmaGetIdentifier(config->rxStream), spiQueueDmaIrqHandler, NVIC_PRIO_SPI_DMA, device);
+}
+
+/**
+ * Hold queued transactions off the bus until spiBusUnlock(), waiting for the one that has CS low to finish with it.
+ * Must not be called from an interrupt at or above NVIC_PRIO_SPI_DMA.
+ */
+void spiBusLock(SPI_TypeDef *instance)
+{
+    spiQueue_t *queue = spiQueueByInstance(instance);
+    if (!queue || !queue->rxStream) {
+        return;
+    }
+
+    ATOMIC_BLOCK(NVIC_PRIO_SPI_DMA) {
+        queue->lockCount++;
+    }
+    while (queue->current || queue->selected);
+}
+
+void spiBusUnlock(SPI_TypeDef *instance)
+{
+    spiQueue_t *queue = spiQueueByInstance(instance);
+    if (!queue || !queue->rxStream) {
+        return;
+    }
+
+    ATOMIC_BLOCK(NVIC_PRIO_SPI_DMA) {
+        if (--queue->lockCount == 0) {
+            spiQueueRun(queue);
+        }
+    }
+}
+#endif
+
+void spiTransactionInit(SPIDevice device)
+{
+    spiQueue_t *queue = &spiQueues[device];
+    memset(queue, 0, sizeof(*queue));
+    queue->instance = spiDevice[device].dev;
+    queue->device = device;
+
+#ifdef USE_SPI_TRANSACTION_DMA
+    spiQueueDmaInit(queue, device);
+#endif
+}
+
+/**
+ * Queue a transaction on its bus. On a DMA bus it is sent in the background, otherwise it has been sent by the time
+ * this returns. The transaction and its buffers must be left untouched until spiTransactionIsComplete().
+ *
+ * Returns false if the transaction is still queued from an earlier submission or cannot be sent.
+ */
+bool spiTransactionSubmit(spiTransaction_t *transaction)
+{
+    spiQueue_t *queue = spiQueueByInstance(transaction->bus->busdev_u.spi.instance);
+    if (!queue || transaction->busy || !transaction->segmentCount || transaction->priority >= SPI_PRIORITY_COUNT) {
+        return false;
+    }
+
+    transaction->nextSegment = 0;
+    transaction->next = NULL;
+    transaction->busy = true;
+
+    ATOMIC_BLOCK(NVIC_PRIO_SPI_DMA) {
+        if (queue->tail[transaction->priority]) {
+            queue->tail[transaction->priority]->next = transaction;
+        } else {
+            queue->head[transaction->priority] = transaction;
+        }
+        queue->tail[transaction->priority] = transaction;
+
+#ifdef USE_SPI_TRANSACTION_DMA
+        if (queue->rxStream) {
+            spiQueueRun(queue);
+        }
+#endif
+    }
+
+#ifdef USE_SPI_TRANSACTION_DMA
+    if (!queue->rxStream)
+#endif
+    {
+        spiQueueRun(queue);
+    }
+
+    return true;
+}
+
+bool spiTransactionIsComplete(const spiTransaction_t *transaction)
+{
+    return !transaction->busy;
+}
+
+void spiTransactionWait(const spiTransaction_t *transaction)
+{
+    while (transaction->busy);
+}
+#endif
@@ -25,6 +25,8 @@
 #include "nvic.h"
 #include "pwm_output.h"
 #include "time.h"
+#include "common/maths.h"
+#include "common/utils.h"
 #include "config/parameter_group_ids.h"
 
 #if defined(STM32F40_41xxx)
@@ -45,10 +47,14 @@
 #endif
 
 #if !defined(STM32F411xE) && !defined(STM32F7)
+// TIM6 and TIM7 are free, they make the software PWM and time the key presses
 #define CAMERA_CONTROL_SOFTWARE_PWM_AVAILABLE
+#define CAMERA_CONTROL_RELEASE_TIMER_AVAILABLE
 #include "build/atomic.h"
 #endif
 
+#define CAMERA_CONTROL_RELEASE_TIMER_HZ 10000   // 0.1ms ticks, up to 6.5s in the 16 bit counter
+
 #define CAMERA_CONTROL_HARDWARE_PWM_AVAILABLE
 #include "timer.h"
 
@@ -67,16 +73,42 @@ static struct {
     IO_t io;
     timerChannel_t channel;
     uint32_t period;
+    volatile bool keyPressed;               // until the timer releases the key
+#ifdef CAMERA_CONTROL_SOFTWARE_PWM_AVAILABLE
+    volatile uint32_t periodsLeft;          // software PWM periods until the key is released
+#endif
 } cameraControlRuntime;
 
 static uint32_t endTimeMillis;
 
 #ifdef CAMERA_CONTROL_SOFTWARE_PWM_AVAILABLE
-void TIM6_DAC_IRQHandler()
+static void cameraControlSoftwarePwmRelease(void)
 {
+    // Disable timers and interrupt generation
+    TIM6->CR1 &= ~TIM_CR1_CEN;
+    TIM7->CR1 &= ~TIM_CR1_CEN;
+    TIM6->DIER = 0;
+    TIM7->DIER = 0;
+
+    // Reset to idle state
     IOHi(cameraControlRuntime.io);
+    cameraControlRuntime.keyPressed = false;
+}
+#endif
 
+#ifdef CAMERA_CONTROL_RELEASE_TIMER_AVAILABLE
+void TIM6_DAC_IRQHandler()
+{
     TIM6->SR = 0;
+
+    if (CAMERA_CONTROL_MODE_HARDWARE_PWM == cameraControlConfig()->mode) {
+        // one pulse mode, this is the end of the key press
+        *cameraControlRuntime.channel.ccr = cameraControlRuntime.period;
+        TIM6->DIER = 0;
+        cameraControlRuntime.keyPressed = false;
+    } else {
+        IOHi(cameraControlRuntime.io);
+    }
 }
 
 void TIM7_IRQHandler()
@@ -84,6 +116,26 @@ void TIM7_IRQHandler()
     IOLo(cameraControlRuntime.io);
 
     TIM7->SR = 0;
+
+    // the key press is counted in PWM periods, so it ends on time however busy the main loop is
+    if (--cameraControlRuntime.periodsLeft == 0) {
+        cameraControlSoftwarePwmRelease();
+    }
+}
+
+static void cameraControlStartReleaseTimer(uint32_t durationMs)
+{
+    const uint32_t ticks = durationMs * (CAMERA_CONTROL_RELEASE_TIMER_HZ / 1000);
+
+    TIM6->CR1 = 0;
+    TIM6->PSC = CAMERA_CONTROL_TIMER_MHZ * (1000000 / CAMERA_CONTROL_RELEASE_TIMER_HZ) - 1;
+    TIM6->ARR = constrain(ticks, 1, 0xFFFF);
+    TIM6->CNT = 0;
+    // load the prescaler now, the update this makes is not a release
+    TIM6->EGR = TIM_EGR_UG;
+    TIM6->SR = 0;
+    TIM6->DIER = TIM_IT_Update;
+    TIM6->CR1 = TIM_CR1_OPM | TIM_CR1_CEN;
 }
 #endif
 
@@ -113,6 +165,15 @@ void cameraControlInit()
 
         *cameraControlRuntime.channel.ccr = cameraControlRuntime.period;
         cameraControlRuntime.enabled = true;
+
+#ifdef CAMERA_CONTROL_RELEASE_TIMER_AVAILABLE
+        NVIC_InitTypeDef nvicTIM6 = {
+            TIM6_DAC_IRQn, NVIC_PRIORITY_BASE(NVIC_PRIO_TIMER), NVIC_PRIORITY_SUB(NVIC_PRIO_TIMER), ENABLE
+        };
+        NVIC_Init(&nvicTIM6);
+
+        RCC->APB1ENR |= RCC_APB1Periph_TIM6;
+#endif
 #endif
     } else if (CAMERA_CONTROL_MODE_SOFTWARE_PWM == cameraControlConfig()->mode) {
 #ifdef CAMERA_CONTROL_SOFTWARE_PWM_AVAILABLE
@@ -142,14 +203,14 @@ void cameraControlInit()
 
 void cameraControlProcess(uint32_t currentTimeUs)
 {
+    // only releases the hardware PWM key on targets without a timer to do it
     if (endTimeMillis && currentTimeUs >= 1000 * endTimeMillis) {
         if (CAMERA_CONTROL_MODE_HARDWARE_PWM == cameraControlConfig()->mode) {
             *cameraControlRuntime.channel.ccr = cameraControlRuntime.period;
-        } else if (CAMERA_CONTROL_MODE_SOFTWARE_PWM == cameraControlConfig()->mode) {
-
         }
 
         endTimeMillis = 0;
+        cameraControlRuntime.keyPressed = false;
     }
 }
 
@@ -185,26 +246,43 @@ void cameraControlKeyPress(cameraControlKey_e key, uint32_t holdDurationMs)
     (void) holdDurationMs;
 #endif
 
+    if (cameraControlRuntime.keyPressed) {
+        // the camera is still registering the previous key
+        return;
+    }
+
+    // Give the camera a chance at registering the key press
+    const uint32_t durationMs = cameraControlConfig()->keyDelayMs + holdDurationMs;
+
     if (CAMERA_CONTROL_MODE_HARDWARE_PWM == cameraControlConfig()->mode) {
 #ifdef CAMERA_CONTROL_HARDWARE_PWM_AVAILABLE
+        cameraControlRuntime.keyPressed = true;
         *cameraControlRuntime.channel.ccr = lrintf(dutyCycle * cameraControlRuntime.period);
-        endTimeMillis = millis() + cameraControlConfig()->keyDelayMs + holdDurationMs;
+#ifdef CAMERA_CONTROL_RELEASE_TIMER_AVAILABLE
+        cameraControlStartReleaseTimer(durationMs);
+#else
+        endTimeMillis = millis() + durationMs;
+#endif
 #endif
     } else if (CAMERA_CONTROL_MODE_SOFTWARE_PWM == cameraControlConfig()->mode) {
 #ifdef CAMERA_CONTROL_SOFTWARE_PWM_AVAILABLE
         const uint32_t hiTime = lrintf(dutyCycle * cameraControlRuntime.period);
 
+        cameraControlRuntime.keyPressed = true;
+        cameraControlRuntime.periodsLeft = MAX(durationMs * CAMERA_CONTROL_TIMER_MHZ * 1000 / cameraControlRuntime.period, 1);
+
+        // TIM7 pulls the line low every period and counts the key press down, TIM6 raises it again
+        // after the low time unless the key holds the line low throughout
+        TIM7->CNT = 0;
+        TIM7->ARR = cameraControlRuntime.period;
         if (0 == hiTime) {
             IOLo(cameraControlRuntime.io);
-            delay(cameraControlConfig()->keyDelayMs + holdDurationMs);
-            IOHi(cameraControlRuntime.io);
+            TIM7->CR1 = TIM_CR1_CEN;
+            TIM7->DIER = TIM_IT_Update;
         } else {
             TIM6->CNT = hiTime;
             TIM6->ARR = cameraControlRuntime.period;
 
-            TIM7->CNT = 0;
-            TIM7->ARR = cameraControlRuntime.period;
-
             // Start two timers as simultaneously as possible
             ATOMIC_BLOCK(NVIC_PRIO_TIMER) {
                 TIM6->CR1 = TIM_CR1_CEN;
@@ -214,20 +292,6 @@ void cameraControlKeyPress(cameraControlKey_e key, uint32_t holdDurationMs)
             // Enable interrupt generation
             TIM6->DIER = TIM_IT_Update;
             TIM7->DIER = TIM_IT_Update;
-
-            const uint32_t endTime = millis() + cameraControlConfig()->keyDelayMs + holdDurationMs;
-
-            // Wait to give the camera a chance at registering the key press
-            while (millis() < endTime);
-
-            // Disable timers and interrupt generation
-            TIM6->CR1 &= ~TIM_CR1_CEN;
-            TIM7->CR1 &= ~TIM_CR1_CEN;
-            TIM6->DIER = 0;
-            TIM7->DIER = 0;
-
-            // Reset to idle state
-            IOHi(cameraControlRuntime.io);
         }
 #endif
     } else if (CAMERA_CONTROL_MODE_DAC == cameraControlConfig()->mode) {
@@ -165,6 +165,16 @@ static void hmc5883lConfigureDataReadyInterruptHandling(void)
 #endif
 }
 
+static void hmc5883lConvert(const uint8_t *buf, int16_t *magData)
+{
+    // During calibration, magGain is 1.0, so the read returns normal non-calibrated values.
+    // After calibration is done, magGain is set to calculated gain values.
+
+    magData[X] = (int16_t)(buf[0] << 8 | buf[1]) * magGain[X];
+    magData[Z] = (int16_t)(buf[2] << 8 | buf[3]) * magGain[Z];
+    magData[Y] = (int16_t)(buf[4] << 8 | buf[5]) * magGain[Y];
+}
+
 static bool hmc5883lRead(int16_t *magData)
 {
     uint8_t buf[6];
@@ -176,16 +186,39 @@ static bool hmc5883lRead(int16_t *magData)
     if (!ack) {
         return false;
     }
-    // During calibration, magGain is 1.0, so the read returns normal non-calibrated values.
-    // After calibration is done, magGain is set to calculated gain values.
 
-    magData[X] = (int16_t)(buf[0] << 8 | buf[1]) * magGain[X];
-    magData[Z] = (int16_t)(buf[2] << 8 | buf[3]) * magGain[Z];
-    magData[Y] = (int16_t)(buf[4] << 8 | buf[5]) * magGain[Y];
+    hmc5883lConvert(buf, magData);
 
     return true;
 }
 
+#ifndef USE_MAG_SPI_HMC5883
+// Returns the data of the read started on the previous call and starts the next one,
+// false while there is no new data, so the compass task never waits for the bus.
+static bool hmc5883lReadNonBlocking(int16_t *magData)
+{
+    static uint8_t buf[6];
+    static bool readPending = false;
+    bool ack = false;
+
+    if (readPending) {
+        bool error;
+        if (i2cBusy(MAG_I2C_INSTANCE, &error)) {
+            return false;
+        }
+        readPending = false;
+        if (!error) {
+            hmc5883lConvert(buf, magData);
+            ack = true;
+        }
+    }
+
+    readPending = i2cReadNonBlocking(MAG_I2C_INSTANCE, MAG_ADDRESS, MAG_DATA_REGISTER, 6, buf);
+
+    return ack;
+}
+#endif
+
 static bool hmc5883lInit(void)
 {
     int16_t magADC[3];
@@ -305,7 +338,11 @@ bool hmc5883lDetect(magDev_t* mag, ioTag_t interruptTag)
         return false;
 
     mag->init = hmc5883lInit;
+#ifdef USE_MAG_SPI_HMC5883
     mag->read = hmc5883lRead;
+#else
+    mag->read = hmc5883lReadNonBlocking;
+#endif
 
     return true;
 }
@@ -29,8 +29,8 @@
 
 #ifdef USE_MAG_SPI_HMC5883
 
-#define DISABLE_HMC5883      IOHi(hmc5883CsPin)
-#define ENABLE_HMC5883       IOLo(hmc5883CsPin)
+#define DISABLE_HMC5883      spiBusDeselectDevice(HMC5883_SPI_INSTANCE, hmc5883CsPin)
+#define ENABLE_HMC5883       spiBusSelectDevice(HMC5883_SPI_INSTANCE, hmc5883CsPin)
 
 static IO_t hmc5883CsPin = IO_NONE;
 
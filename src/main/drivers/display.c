@@ -92,6 +92,11 @@ bool displayIsTransferInProgress(const displayPort_t *instance)
     return instance->vTable->isTransferInProgress(instance);
 }
 
+bool displayIsSynced(const displayPort_t *instance)
+{
+    return instance->vTable->isSynced(instance);
+}
+
 void displayHeartbeat(displayPort_t *instance)
 {
     instance->vTable->heartbeat(instance);
@@ -107,6 +112,15 @@ uint16_t displayTxBytesFree(const displayPort_t *instance)
     return instance->vTable->txBytesFree(instance);
 }
 
+// True when the display reports the start of each video field, vsyncAtUs is then the start of the current one
+bool displayGetVsync(const displayPort_t *instance, timeUs_t *vsyncAtUs)
+{
+    if (!instance->vTable->getVsync) {
+        return false;
+    }
+    return instance->vTable->getVsync(instance, vsyncAtUs);
+}
+
 void displayInit(displayPort_t *instance, const displayPortVTable_t *vTable)
 {
     instance->vTable = vTable;
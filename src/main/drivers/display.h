@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include "common/time.h"
+
 struct displayPortVTable_s;
 typedef struct displayPort_s {
     const struct displayPortVTable_s *vTable;
@@ -41,9 +43,11 @@ typedef struct displayPortVTable_s {
     int (*writeString)(displayPort_t *displayPort, uint8_t x, uint8_t y, const char *text);
     int (*writeChar)(displayPort_t *displayPort, uint8_t x, uint8_t y, uint8_t c);
     bool (*isTransferInProgress)(const displayPort_t *displayPort);
+    bool (*isSynced)(const displayPort_t *displayPort);
     int (*heartbeat)(displayPort_t *displayPort);
     void (*resync)(displayPort_t *displayPort);
     uint32_t (*txBytesFree)(const displayPort_t *displayPort);
+    bool (*getVsync)(const displayPort_t *displayPort, timeUs_t *vsyncAtUs);
 } displayPortVTable_t;
 
 typedef struct displayPortProfile_s {
@@ -65,7 +69,9 @@ void displaySetXY(displayPort_t *instance, uint8_t x, uint8_t y);
 int displayWrite(displayPort_t *instance, uint8_t x, uint8_t y, const char *s);
 int displayWriteChar(displayPort_t *instance, uint8_t x, uint8_t y, uint8_t c);
 bool displayIsTransferInProgress(const displayPort_t *instance);
+bool displayIsSynced(const displayPort_t *instance);
 void displayHeartbeat(displayPort_t *instance);
 void displayResync(displayPort_t *instance);
 uint16_t displayTxBytesFree(const displayPort_t *instance);
+bool displayGetVsync(const displayPort_t *instance, timeUs_t *vsyncAtUs);
 void displayInit(displayPort_t *instance, const displayPortVTable_t *vTable);
@@ -20,6 +20,7 @@
 
 #include "platform.h"
 
+#include "common/maths.h"
 #include "common/utils.h"
 
 #include "drivers/bus_i2c.h"
@@ -41,6 +42,25 @@
 
 unsigned char CHAR_FORMAT = NORMAL_CHAR_FORMAT;
 
+#define OLED_PAGE_COUNT (SCREEN_HEIGHT / 8)
+// longest run of columns sent in one I2C write
+#define OLED_FLUSH_SPAN_MAX 64
+
+// The text is drawn into a copy of the display RAM, i2c_OLED_flush() sends the changed columns of each page.
+static uint8_t oledFrameBuffer[OLED_PAGE_COUNT][SCREEN_WIDTH];
+// columns of each page that differ from the display, start > end when the page is up to date
+static uint8_t oledDirtyStart[OLED_PAGE_COUNT];
+static uint8_t oledDirtyEnd[OLED_PAGE_COUNT];
+static uint8_t oledCursorPage;
+static uint8_t oledCursorColumn;
+
+// a flush sends the address of a span, then its data in a second write once the first has completed
+static uint8_t oledFlushCommands[3];
+static uint8_t oledFlushPage;
+static uint8_t oledFlushColumn;
+static uint8_t oledFlushLength;
+static bool oledFlushDataPending;
+
 static const uint8_t multiWiiFont[][5] = { // Refer to "Times New Roman" Font Database... 5 x 7 font
         { 0x00, 0x00, 0x00, 0x00, 0x00 }, { 0x00, 0x00, 0x4F, 0x00, 0x00 }, //   (  1)  ! - 0x0021 Exclamation Mark
                 { 0x00, 0x07, 0x00, 0x07, 0x00 }, //   (  2)  " - 0x0022 Quotation Mark
@@ -194,25 +214,92 @@ static bool i2c_OLED_send_cmdarray(busDevice_t *bus, const uint8_t *commands, si
     return true;
 }
 
-static bool i2c_OLED_send_byte(busDevice_t *bus, uint8_t val)
+static void oledMarkDirty(uint8_t page, uint8_t startColumn, uint8_t endColumn)
 {
-    return i2cWrite(bus->busdev_u.i2c.device, bus->busdev_u.i2c.address, 0x40, val);
+    oledDirtyStart[page] = MIN(oledDirtyStart[page], startColumn);
+    oledDirtyEnd[page] = MAX(oledDirtyEnd[page], endColumn);
+}
+
+static void oledWriteByte(uint8_t value)
+{
+    uint8_t *column = &oledFrameBuffer[oledCursorPage][oledCursorColumn];
+    if (*column != value) {
+        *column = value;
+        oledMarkDirty(oledCursorPage, oledCursorColumn, oledCursorColumn);
+    }
+
+    // same wrap as the display's horizontal addressing mode
+    if (++oledCursorColumn >= SCREEN_WIDTH) {
+        oledCursorColumn = 0;
+        oledCursorPage = (oledCursorPage + 1) % OLED_PAGE_COUNT;
+    }
 }
 
 void i2c_OLED_clear_display_quick(busDevice_t *bus)
 {
-    static const uint8_t i2c_OLED_cmd_clear_display_quick[] = {
-        0xb0, // set page address to 0
-        0x40, // Display start line register to 0
-        0,    // Set low col address to 0
-        0x10, // Set high col address to 0
-    };
+    UNUSED(bus);
+
+    for (int page = 0; page < OLED_PAGE_COUNT; page++) {
+        for (int column = 0; column < SCREEN_WIDTH; column++) {
+            if (oledFrameBuffer[page][column]) {
+                oledFrameBuffer[page][column] = 0x00;
+                oledMarkDirty(page, column, column);
+            }
+        }
+    }
+    oledCursorPage = 0;
+    oledCursorColumn = 0;
+}
 
-    i2c_OLED_send_cmdarray(bus, i2c_OLED_cmd_clear_display_quick, ARRAYLEN(i2c_OLED_cmd_clear_display_quick));
+/*
+ * Sends the next part of the frame buffer that differs from the display, without waiting for the bus.
+ * Returns true once the display is up to date, call it again until then.
+ */
+bool i2c_OLED_flush(busDevice_t *bus)
+{
+    const I2CDevice device = bus->busdev_u.i2c.device;
+    const uint8_t address = bus->busdev_u.i2c.address;
 
-    for (uint16_t i = 0; i < 1024; i++) {      // fill the display's RAM with graphic... 128*64 pixel picture
-        i2c_OLED_send_byte(bus, 0x00);  // clear
+    if (i2cBusy(device, NULL)) {
+        return false;
     }
+
+    if (oledFlushDataPending) {
+        oledFlushDataPending = false;
+        if (!i2cWriteBufferNonBlocking(device, address, 0x40, oledFlushLength, &oledFrameBuffer[oledFlushPage][oledFlushColumn])) {
+            oledMarkDirty(oledFlushPage, oledFlushColumn, oledFlushColumn + oledFlushLength - 1);
+        }
+        return false;
+    }
+
+    for (int page = 0; page < OLED_PAGE_COUNT; page++) {
+        if (oledDirtyStart[page] > oledDirtyEnd[page]) {
+            continue;
+        }
+
+        oledFlushPage = page;
+        oledFlushColumn = oledDirtyStart[page];
+        oledFlushLength = MIN(oledDirtyEnd[page] - oledFlushColumn + 1, OLED_FLUSH_SPAN_MAX);
+        if (oledFlushColumn + oledFlushLength > oledDirtyEnd[page]) {
+            oledDirtyStart[page] = SCREEN_WIDTH - 1;
+            oledDirtyEnd[page] = 0;
+        } else {
+            oledDirtyStart[page] = oledFlushColumn + oledFlushLength;
+        }
+
+        oledFlushCommands[0] = 0xb0 + page;                             // set page address
+        oledFlushCommands[1] = 0x00 + (oledFlushColumn & 0x0f);         // set low col address
+        oledFlushCommands[2] = 0x10 + ((oledFlushColumn >> 4) & 0x0f);  // set high col address
+
+        if (i2cWriteBufferNonBlocking(device, address, 0x00, ARRAYLEN(oledFlushCommands), oledFlushCommands)) {
+            oledFlushDataPending = true;
+        } else {
+            oledMarkDirty(oledFlushPage, oledFlushColumn, oledFlushColumn + oledFlushLength - 1);
+        }
+        return false;
+    }
+
+    return true;
 }
 
 void i2c_OLED_clear_display(busDevice_t *bus)
@@ -226,7 +313,12 @@ void i2c_OLED_clear_display(busDevice_t *bus)
 
     i2c_OLED_send_cmdarray(bus, i2c_OLED_cmd_clear_display_pre, ARRAYLEN(i2c_OLED_cmd_clear_display_pre));
 
+    // the display RAM content is unknown, so all of it is sent again by i2c_OLED_flush()
     i2c_OLED_clear_display_quick(bus);
+    oledFlushDataPending = false;
+    for (int page = 0; page < OLED_PAGE_COUNT; page++) {
+        oledMarkDirty(page, 0, SCREEN_WIDTH - 1);
+    }
 
     static const uint8_t i2c_OLED_cmd_clear_display_post[] = {
         0x81, // Setup CONTRAST CONTROL, following byte is the contrast Value... always a 2 byte instruction
@@ -239,13 +331,10 @@ void i2c_OLED_clear_display(busDevice_t *bus)
 
 void i2c_OLED_set_xy(busDevice_t *bus, uint8_t col, uint8_t row)
 {
-    uint8_t i2c_OLED_cmd_set_xy[] = {
-        0xb0 + row,                                            //set page address
-        0x00 + ((CHARACTER_WIDTH_TOTAL * col) & 0x0f),         //set low col address
-        0x10 + (((CHARACTER_WIDTH_TOTAL * col) >> 4) & 0x0f)   //set high col address
-    };
+    UNUSED(bus);
 
-    i2c_OLED_send_cmdarray(bus, i2c_OLED_cmd_set_xy, ARRAYLEN(i2c_OLED_cmd_set_xy));
+    oledCursorPage = row % OLED_PAGE_COUNT;
+    oledCursorColumn = (CHARACTER_WIDTH_TOTAL * col) % SCREEN_WIDTH;
 }
 
 void i2c_OLED_set_line(busDevice_t *bus, uint8_t row)
@@ -255,14 +344,16 @@ void i2c_OLED_set_line(busDevice_t *bus, uint8_t row)
 
 void i2c_OLED_send_char(busDevice_t *bus, unsigned char ascii)
 {
+    UNUSED(bus);
+
     unsigned char i;
     uint8_t buffer;
     for (i = 0; i < 5; i++) {
         buffer = multiWiiFont[ascii - 32][i];
         buffer ^= CHAR_FORMAT;  // apply
-        i2c_OLED_send_byte(bus, buffer);
+        oledWriteByte(buffer);
     }
-    i2c_OLED_send_byte(bus, CHAR_FORMAT);    // the gap
+    oledWriteByte(CHAR_FORMAT);    // the gap
 }
 
 void i2c_OLED_send_string(busDevice_t *bus, const char *string)
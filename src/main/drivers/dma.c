@@ -65,11 +65,41 @@ DEFINE_DMA_IRQ_HANDLER(2, 5, DMA2_CH5_HANDLER)
 
 void dmaInit(dmaIdentifier_e identifier, resourceOwner_e owner, uint8_t resourceIndex)
 {
+    if (!dmaIsFree(identifier, owner, resourceIndex)) {
+        dmaDescriptors[identifier].conflictOwner = dmaDescriptors[identifier].owner;
+    }
     RCC_AHBPeriphClockCmd(dmaDescriptors[identifier].rcc, ENABLE);
     dmaDescriptors[identifier].owner = owner;
     dmaDescriptors[identifier].resourceIndex = resourceIndex;
 }
 
+// True if the stream or channel is unused, or already belongs to this owner and index
+bool dmaIsFree(dmaIdentifier_e identifier, resourceOwner_e owner, uint8_t resourceIndex)
+{
+    const dmaChannelDescriptor_t *descriptor = &dmaDescriptors[identifier];
+
+    return descriptor->owner == OWNER_FREE || (descriptor->owner == owner && descriptor->resourceIndex == resourceIndex);
+}
+
+// As dmaInit(), but leaves a stream or channel another driver holds alone and records the conflict instead
+bool dmaAllocate(dmaIdentifier_e identifier, resourceOwner_e owner, uint8_t resourceIndex)
+{
+    if (!dmaIsFree(identifier, owner, resourceIndex)) {
+        dmaDescriptors[identifier].conflictOwner = owner;
+        return false;
+    }
+    dmaInit(identifier, owner, resourceIndex);
+    return true;
+}
+
+// Hands the stream or channel back for another driver to take. The caller must have stopped its transfers.
+void dmaRelease(dmaIdentifier_e identifier)
+{
+    dmaDescriptors[identifier].irqHandlerCallback = NULL;
+    dmaDescriptors[identifier].owner = OWNER_FREE;
+    dmaDescriptors[identifier].resourceIndex = 0;
+}
+
 void dmaSetHandler(dmaIdentifier_e identifier, dmaCallbackHandlerFuncPtr callback, uint32_t priority, uint32_t userParam)
 {
     NVIC_InitTypeDef NVIC_InitStructure;
@@ -96,6 +126,11 @@ uint8_t dmaGetResourceIndex(dmaIdentifier_e identifier)
     return dmaDescriptors[identifier].resourceIndex;
 }
 
+resourceOwner_e dmaGetConflictOwner(dmaIdentifier_e identifier)
+{
+    return dmaDescriptors[identifier].conflictOwner;
+}
+
 dmaIdentifier_e dmaGetIdentifier(const DMA_Channel_TypeDef* channel)
 {
     for (int i = 0; i < DMA_MAX_DESCRIPTORS; i++) {
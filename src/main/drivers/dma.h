@@ -36,11 +36,37 @@ typedef struct dmaChannelDescriptor_s {
     uint32_t                    userParam;
     resourceOwner_e             owner;
     uint8_t                     resourceIndex;
+    resourceOwner_e             conflictOwner;  // last driver refused or displaced from the stream, OWNER_FREE if none
 } dmaChannelDescriptor_t;
 
+/*
+ * Data cache maintenance for DMA buffers outside DMA_RAM and FAST_RAM, which the F7 data cache may hold.
+ * Clean before the DMA reads memory, so it sees what the CPU wrote. Invalidate after the DMA wrote memory, so
+ * the CPU does not read stale lines. Invalidate drops whole cache lines, so a buffer it is used on must be
+ * DMA_DATA_ALIGNED and DMA_BUFFER_SIZE() long, or it loses whatever shares its first and last line.
+ */
 #if defined(STM32F7)
-//#define HAL_CLEANINVALIDATECACHE(addr, size) (SCB_CleanInvalidateDCache_by_Addr((uint32_t*)((uint32_t)addr & ~0x1f), ((uint32_t)(addr + size + 0x1f) & ~0x1f) - ((uint32_t)addr & ~0x1f)))
-//#define HAL_CLEANCACHE(addr, size) (SCB_CleanDCache_by_Addr((uint32_t*)((uint32_t)addr & ~0x1f), ((uint32_t)(addr + size + 0x1f) & ~0x1f) - ((uint32_t)addr & ~0x1f)))
+#define DMA_CACHE_LINE_SIZE         32
+#define DMA_DATA_ALIGNED            __attribute__((aligned(DMA_CACHE_LINE_SIZE)))
+#define DMA_BUFFER_SIZE(size)       (((size) + DMA_CACHE_LINE_SIZE - 1) & ~(DMA_CACHE_LINE_SIZE - 1))
+
+static inline void dmaCacheClean(const void *buffer, uint32_t size)
+{
+    const uint32_t start = (uint32_t)buffer & ~(DMA_CACHE_LINE_SIZE - 1);
+    SCB_CleanDCache_by_Addr((uint32_t *)start, (uint32_t)buffer + size - start);
+}
+
+static inline void dmaCacheInvalidate(void *buffer, uint32_t size)
+{
+    const uint32_t start = (uint32_t)buffer & ~(DMA_CACHE_LINE_SIZE - 1);
+    SCB_InvalidateDCache_by_Addr((uint32_t *)start, (uint32_t)buffer + size - start);
+}
+#else
+#define DMA_DATA_ALIGNED
+#define DMA_BUFFER_SIZE(size)       (size)
+
+#define dmaCacheClean(buffer, size)         do { (void)(buffer); (void)(size); } while (0)
+#define dmaCacheInvalidate(buffer, size)    do { (void)(buffer); (void)(size); } while (0)
 #endif
 
 #if defined(STM32F4) || defined(STM32F7)
@@ -71,7 +97,7 @@ typedef enum {
 #define DMA_OUTPUT_INDEX    0
 #define DMA_OUTPUT_STRING   "DMA%d Stream %d:"
 
-#define DEFINE_DMA_CHANNEL(d, s, f, i, r) {.dma = d, .ref = s, .irqHandlerCallback = NULL, .flagsShift = f, .irqN = i, .rcc = r, .userParam = 0, .owner = 0, .resourceIndex = 0 }
+#define DEFINE_DMA_CHANNEL(d, s, f, i, r) {.dma = d, .ref = s, .irqHandlerCallback = NULL, .flagsShift = f, .irqN = i, .rcc = r, .userParam = 0, .owner = 0, .resourceIndex = 0, .conflictOwner = 0 }
 #define DEFINE_DMA_IRQ_HANDLER(d, s, i) void DMA ## d ## _Stream ## s ## _IRQHandler(void) {\
                                                                 if (dmaDescriptors[i].irqHandlerCallback)\
                                                                     dmaDescriptors[i].irqHandlerCallback(&dmaDescriptors[i]);\
@@ -90,6 +116,24 @@ typedef enum {
 dmaIdentifier_e dmaGetIdentifier(const DMA_Stream_TypeDef* stream);
 dmaChannelDescriptor_t* getDmaDescriptor(const DMA_Stream_TypeDef* stream);
 
+#if defined(STM32F4)
+// Peripheral requests with a choice of streams, see dmaGetFreeChannelSpec()
+typedef enum {
+    DMA_PERIPH_UART_TX,
+    DMA_PERIPH_UART_RX,
+    DMA_PERIPH_ADC,
+} dmaPeripheral_e;
+
+typedef struct dmaChannelSpec_s {
+    dmaPeripheral_e peripheral;
+    uint8_t index;              // UARTDevice or ADCDevice
+    DMA_Stream_TypeDef *ref;
+    uint32_t channel;
+} dmaChannelSpec_t;
+
+const dmaChannelSpec_t *dmaGetFreeChannelSpec(dmaPeripheral_e peripheral, uint8_t index, const DMA_Stream_TypeDef *preferred, resourceOwner_e owner, uint8_t resourceIndex);
+#endif
+
 #else
 
 typedef enum {
@@ -115,7 +159,7 @@ typedef enum {
 #define DMA_OUTPUT_INDEX    0
 #define DMA_OUTPUT_STRING   "DMA%d Channel %d:"
 
-#define DEFINE_DMA_CHANNEL(d, c, f, i, r) {.dma = d, .ref = c, .irqHandlerCallback = NULL, .flagsShift = f, .irqN = i, .rcc = r, .userParam = 0, .owner = 0, .resourceIndex = 0 }
+#define DEFINE_DMA_CHANNEL(d, c, f, i, r) {.dma = d, .ref = c, .irqHandlerCallback = NULL, .flagsShift = f, .irqN = i, .rcc = r, .userParam = 0, .owner = 0, .resourceIndex = 0, .conflictOwner = 0 }
 #define DEFINE_DMA_IRQ_HANDLER(d, c, i) void DMA ## d ## _Channel ## c ## _IRQHandler(void) {\
                                                                         if (dmaDescriptors[i].irqHandlerCallback)\
                                                                             dmaDescriptors[i].irqHandlerCallback(&dmaDescriptors[i]);\
@@ -133,7 +177,11 @@ dmaIdentifier_e dmaGetIdentifier(const DMA_Channel_TypeDef* channel);
 #endif
 
 void dmaInit(dmaIdentifier_e identifier, resourceOwner_e owner, uint8_t resourceIndex);
+bool dmaIsFree(dmaIdentifier_e identifier, resourceOwner_e owner, uint8_t resourceIndex);
+bool dmaAllocate(dmaIdentifier_e identifier, resourceOwner_e owner, uint8_t resourceIndex);
+void dmaRelease(dmaIdentifier_e identifier);
 void dmaSetHandler(dmaIdentifier_e identifier, dmaCallbackHandlerFuncPtr callback, uint32_t priority, uint32_t userParam);
 
 resourceOwner_e dmaGetOwner(dmaIdentifier_e identifier);
 uint8_t dmaGetResourceIndex(dmaIdentifier_e identifier);
+resourceOwner_e dmaGetConflictOwner(dmaIdentifier_e identifier);
@@ -21,7 +21,13 @@
 
 #include <platform.h>
 
+#include "common/utils.h"
+
+#include "drivers/adc.h"
+#include "drivers/adc_impl.h"
 #include "drivers/nvic.h"
+#include "drivers/serial.h"
+#include "drivers/serial_uart.h"
 #include "dma.h"
 #include "resource.h"
 
@@ -70,11 +76,41 @@ DEFINE_DMA_IRQ_HANDLER(2, 7, DMA2_ST7_HANDLER)
 
 void dmaInit(dmaIdentifier_e identifier, resourceOwner_e owner, uint8_t resourceIndex)
 {
+    if (!dmaIsFree(identifier, owner, resourceIndex)) {
+        dmaDescriptors[identifier].conflictOwner = dmaDescriptors[identifier].owner;
+    }
     RCC_AHB1PeriphClockCmd(dmaDescriptors[identifier].rcc, ENABLE);
     dmaDescriptors[identifier].owner = owner;
     dmaDescriptors[identifier].resourceIndex = resourceIndex;
 }
 
+// True if the stream or channel is unused, or already belongs to this owner and index
+bool dmaIsFree(dmaIdentifier_e identifier, resourceOwner_e owner, uint8_t resourceIndex)
+{
+    const dmaChannelDescriptor_t *descriptor = &dmaDescriptors[identifier];
+
+    return descriptor->owner == OWNER_FREE || (descriptor->owner == owner && descriptor->resourceIndex == resourceIndex);
+}
+
+// As dmaInit(), but leaves a stream or channel another driver holds alone and records the conflict instead
+bool dmaAllocate(dmaIdentifier_e identifier, resourceOwner_e owner, uint8_t resourceIndex)
+{
+    if (!dmaIsFree(identifier, owner, resourceIndex)) {
+        dmaDescriptors[identifier].conflictOwner = owner;
+        return false;
+    }
+    dmaInit(identifier, owner, resourceIndex);
+    return true;
+}
+
+// Hands the stream or channel back for another driver to take. The caller must have stopped its transfers.
+void dmaRelease(dmaIdentifier_e identifier)
+{
+    dmaDescriptors[identifier].irqHandlerCallback = NULL;
+    dmaDescriptors[identifier].owner = OWNER_FREE;
+    dmaDescriptors[identifier].resourceIndex = 0;
+}
+
 void dmaSetHandler(dmaIdentifier_e identifier, dmaCallbackHandlerFuncPtr callback, uint32_t priority, uint32_t userParam)
 {
     NVIC_InitTypeDef NVIC_InitStructure;
@@ -115,6 +151,11 @@ uint8_t dmaGetResourceIndex(dmaIdentifier_e identifier)
     return dmaDescriptors[identifier].resourceIndex;
 }
 
+resourceOwner_e dmaGetConflictOwner(dmaIdentifier_e identifier)
+{
+    return dmaDescriptors[identifier].conflictOwner;
+}
+
 dmaIdentifier_e dmaGetIdentifier(const DMA_Stream_TypeDef* stream)
 {
     for (int i = 0; i < DMA_MAX_DESCRIPTORS; i++) {
@@ -134,3 +175,59 @@ dmaChannelDescriptor_t* getDmaDescriptor(const DMA_Stream_TypeDef* stream)
     }
     return NULL;
 }
+
+/*
+ * Streams each peripheral request can use, from the DMA request mapping in RM0090.
+ * Where there is a choice, the stream the drivers used before comes first.
+ */
+static const dmaChannelSpec_t dmaChannelSpecs[] = {
+    { DMA_PERIPH_UART_TX,  UARTDEV_1, DMA2_Stream7, DMA_Channel_4 },
+    { DMA_PERIPH_UART_RX,  UARTDEV_1, DMA2_Stream5, DMA_Channel_4 },
+    { DMA_PERIPH_UART_RX,  UARTDEV_1, DMA2_Stream2, DMA_Channel_4 },
+    { DMA_PERIPH_UART_TX,  UARTDEV_2, DMA1_Stream6, DMA_Channel_4 },
+    { DMA_PERIPH_UART_RX,  UARTDEV_2, DMA1_Stream5, DMA_Channel_4 },
+    { DMA_PERIPH_UART_TX,  UARTDEV_3, DMA1_Stream3, DMA_Channel_4 },
+    { DMA_PERIPH_UART_TX,  UARTDEV_3, DMA1_Stream4, DMA_Channel_7 },
+    { DMA_PERIPH_UART_RX,  UARTDEV_3, DMA1_Stream1, DMA_Channel_4 },
+    { DMA_PERIPH_UART_TX,  UARTDEV_4, DMA1_Stream4, DMA_Channel_4 },
+    { DMA_PERIPH_UART_RX,  UARTDEV_4, DMA1_Stream2, DMA_Channel_4 },
+    { DMA_PERIPH_UART_TX,  UARTDEV_5, DMA1_Stream7, DMA_Channel_4 },
+    { DMA_PERIPH_UART_RX,  UARTDEV_5, DMA1_Stream0, DMA_Channel_4 },
+    { DMA_PERIPH_UART_TX,  UARTDEV_6, DMA2_Stream6, DMA_Channel_5 },
+    { DMA_PERIPH_UART_TX,  UARTDEV_6, DMA2_Stream7, DMA_Channel_5 },
+    { DMA_PERIPH_UART_RX,  UARTDEV_6, DMA2_Stream1, DMA_Channel_5 },
+    { DMA_PERIPH_UART_RX,  UARTDEV_6, DMA2_Stream2, DMA_Channel_5 },
+    { DMA_PERIPH_ADC,      ADCDEV_1,  DMA2_Stream4, DMA_Channel_0 },
+    { DMA_PERIPH_ADC,      ADCDEV_1,  DMA2_Stream0, DMA_Channel_0 },
+    { DMA_PERIPH_ADC,      ADCDEV_2,  DMA2_Stream2, DMA_Channel_1 },
+    { DMA_PERIPH_ADC,      ADCDEV_2,  DMA2_Stream3, DMA_Channel_1 },
+    { DMA_PERIPH_ADC,      ADCDEV_3,  DMA2_Stream0, DMA_Channel_2 },
+    { DMA_PERIPH_ADC,      ADCDEV_3,  DMA2_Stream1, DMA_Channel_2 },
+};
+
+/*
+ * Pick a stream for the request that no other driver holds, the preferred one if that is free.
+ * Returns NULL when every option is taken, the caller then runs without DMA.
+ */
+const dmaChannelSpec_t *dmaGetFreeChannelSpec(dmaPeripheral_e peripheral, uint8_t index, const DMA_Stream_TypeDef *preferred, resourceOwner_e owner, uint8_t resourceIndex)
+{
+    const dmaChannelSpec_t *found = NULL;
+
+    for (unsigned i = 0; i < ARRAYLEN(dmaChannelSpecs); i++) {
+        const dmaChannelSpec_t *spec = &dmaChannelSpecs[i];
+        if (spec->peripheral != peripheral || spec->index != index || !dmaIsFree(dmaGetIdentifier(spec->ref), owner, resourceIndex)) {
+            continue;
+        }
+        if (spec->ref == preferred) {
+            return spec;
+        }
+        if (!found) {
+            found = spec;
+        }
+    }
+
+    if (!found && preferred) {
+        dmaDescriptors[dmaGetIdentifier(preferred)].conflictOwner = owner;
+    }
+    return found;
+}
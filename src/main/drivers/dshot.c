@@ -0,0 +1,111 @@
+/*
+ * This file is part of Betaflight.
+ *
+ * Betaflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Betaflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Betaflight. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "platform.h"
+
+#ifdef USE_DSHOT_TELEMETRY
+
+#include "common/maths.h"
+
+#include "drivers/dshot.h"
+
+/*
+ * The reply is 16 bits, 12 bits of eRPM period and a checksum, GCR encoded into 20 bits and sent as
+ * 21 bits at 5/4 of the DShot bit rate. Every 1 in the encoded bits is a transition of the line,
+ * so the bits are recovered from the time between the captured edges.
+ */
+
+#define DSHOT_TELEMETRY_BITS 21
+#define GCR_INVALID 0xff
+
+static const uint8_t gcrDecode[32] = {
+    GCR_INVALID, GCR_INVALID, GCR_INVALID, GCR_INVALID, GCR_INVALID, GCR_INVALID, GCR_INVALID, GCR_INVALID,
+    GCR_INVALID, 9, 10, 11, GCR_INVALID, 13, 14, 15,
+    GCR_INVALID, GCR_INVALID, 2, 3, GCR_INVALID, 5, 6, 7,
+    GCR_INVALID, 0, 8, 1, GCR_INVALID, 4, 12, GCR_INVALID,
+};
+
+uint32_t dshotDecodeTelemetry(const uint32_t *edges, int edgeCount, uint32_t bitTicks)
+{
+    if (edgeCount < 1) {
+        return DSHOT_TELEMETRY_INVALID;
+    }
+
+    // a reply bit is 4/5 of a transmitted bit, run lengths are rounded to the nearest reply bit
+    const uint32_t replyBitTicksX5 = bitTicks * 4;
+    uint32_t value = 0;
+    int bits = 0;
+    // the line returns to idle after the reply, any edge past the last bit is ignored
+    for (int i = 1; i <= edgeCount && bits < DSHOT_TELEMETRY_BITS; i++) {
+        int len;
+        if (i < edgeCount) {
+            // the counter is 16 bits on most timers
+            const uint16_t diff = edges[i] - edges[i - 1];
+            len = (diff * 5 + replyBitTicksX5 / 2) / replyBitTicksX5;
+        } else {
+            // no edge after the last run, it fills the rest of the reply
+            len = DSHOT_TELEMETRY_BITS - bits;
+        }
+        if (len < 1) {
+            return DSHOT_TELEMETRY_INVALID;
+        }
+        // the line may return to idle some time after the last bit
+        len = MIN(len, DSHOT_TELEMETRY_BITS - bits);
+        // a transition, then no transition for the rest of the run
+        value = (value << len) | (1 << (len - 1));
+        bits += len;
+    }
+    if (bits != DSHOT_TELEMETRY_BITS) {
+        return DSHOT_TELEMETRY_INVALID;
+    }
+
+    // the leading start bit drops out of the 20 bits decoded
+    uint32_t decoded = 0;
+    for (int nibble = 0; nibble < 4; nibble++) {
+        const uint8_t data = gcrDecode[(value >> (5 * nibble)) & 0x1f];
+        if (data == GCR_INVALID) {
+            return DSHOT_TELEMETRY_INVALID;
+        }
+        decoded |= data << (4 * nibble);
+    }
+
+    // the checksum nibble is inverted in bidirectional replies
+    uint32_t csum = decoded ^ (decoded >> 8);
+    csum ^= csum >> 4;
+    if ((csum & 0xf) != 0xf) {
+        return DSHOT_TELEMETRY_INVALID;
+    }
+    decoded >>= 4;
+
+    if (decoded == 0x0fff) {
+        // the longest period is sent for a stopped motor
+        return 0;
+    }
+
+    // 3 bit shift, 9 bit period in us
+    const uint32_t periodUs = (decoded & 0x1ff) << (decoded >> 9);
+    if (!periodUs) {
+        return DSHOT_TELEMETRY_INVALID;
+    }
+
+    return (1000000 * 60 / 100 + periodUs / 2) / periodUs;
+}
+
+#endif
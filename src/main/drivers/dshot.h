@@ -0,0 +1,30 @@
+/*
+ * This file is part of Betaflight.
+ *
+ * Betaflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Betaflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Betaflight. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#define DSHOT_TELEMETRY_INPUT_LEN   32  // captured edges, a reply has at most 21
+#define DSHOT_TELEMETRY_INVALID     UINT32_MAX
+
+/*
+ * Decodes the eRPM reply of a bidirectional DShot ESC from the timer counter values captured at each edge of
+ * the line. bitTicks is the length of a transmitted DShot bit in timer ticks. Returns the eRPM / 100, the
+ * same unit as the ESC sensor, or DSHOT_TELEMETRY_INVALID if the reply was incomplete or corrupt.
+ */
+uint32_t dshotDecodeTelemetry(const uint32_t *edges, int edgeCount, uint32_t bitTicks);
@@ -22,12 +22,20 @@
 
 #ifdef USE_FLASH_M25P16
 
+#include "common/utils.h"
+
 #include "flash.h"
 #include "flash_m25p16.h"
 #include "drivers/bus_spi.h"
+#include "drivers/dma.h"
 #include "drivers/io.h"
 #include "drivers/time.h"
 
+#if defined(M25P16_SPI_SHARED) && defined(M25P16_DMA_CHANNEL_TX)
+// Another device on the bus could start a transfer while a page is still being sent, a shared bus queues it instead
+#undef M25P16_DMA_CHANNEL_TX
+#endif
+
 #define M25P16_INSTRUCTION_RDID             0x9F
 #define M25P16_INSTRUCTION_READ_BYTES       0x03
 #define M25P16_INSTRUCTION_READ_STATUS_REG  0x05
@@ -37,6 +45,7 @@
 #define M25P16_INSTRUCTION_PAGE_PROGRAM     0x02
 #define M25P16_INSTRUCTION_SECTOR_ERASE     0xD8
 #define M25P16_INSTRUCTION_BULK_ERASE       0xC7
+#define M25P16_INSTRUCTION_ENTER_4BYTE_ADDRESS_MODE 0xB7
 
 #define M25P16_STATUS_FLAG_WRITE_IN_PROGRESS 0x01
 #define M25P16_STATUS_FLAG_WRITE_ENABLED     0x02
@@ -50,9 +59,17 @@
 #define JEDEC_ID_MICRON_N25Q128        0x20ba18
 #define JEDEC_ID_WINBOND_W25Q128       0xEF4018
 #define JEDEC_ID_MACRONIX_MX25L25635E  0xC22019
+#define JEDEC_ID_MICRON_N25Q256        0x20BA19
+#define JEDEC_ID_WINBOND_W25Q256       0xEF4019
+#define JEDEC_ID_MACRONIX_MX66L51235F  0xC2201A
+#define JEDEC_ID_WINBOND_W25Q512       0xEF4020
 
-#define DISABLE_M25P16       IOHi(m25p16CsPin); __NOP()
-#define ENABLE_M25P16        __NOP(); IOLo(m25p16CsPin)
+// Chips larger than this need 4 byte addresses
+#define M25P16_3BYTE_ADDRESS_LIMIT     (16 * 1024 * 1024)
+
+// Hold queued transactions for other devices off the bus while the flash is selected
+#define DISABLE_M25P16       spiBusDeselectDevice(M25P16_SPI_INSTANCE, m25p16CsPin); __NOP(); spiBusUnlock(M25P16_SPI_INSTANCE)
+#define ENABLE_M25P16        spiBusLock(M25P16_SPI_INSTANCE); __NOP(); spiBusSelectDevice(M25P16_SPI_INSTANCE, m25p16CsPin)
 
 // The timeout we expect between being able to issue page program instructions
 #define DEFAULT_TIMEOUT_MILLIS       6
@@ -65,6 +82,9 @@ static flashGeometry_t geometry = {.pageSize = M25P16_PAGESIZE};
 
 static IO_t m25p16CsPin = IO_NONE;
 
+// Whether the chip has been put into 4 byte address mode, for chips above 16MB
+static bool use4ByteAddress = false;
+
 /*
  * Whether we've performed an action that could have made the device busy for writes.
  *
@@ -72,6 +92,21 @@ static IO_t m25p16CsPin = IO_NONE;
  */
 static bool couldBeBusy = false;
 
+#ifdef M25P16_DMA_CHANNEL_TX
+// Whether the data of a page program is still being sent by DMA, with the chip still selected
+static bool dmaTransferInProgress = false;
+#if defined(USE_HAL_DRIVER)
+static DMA_HandleTypeDef *m25p16DMAHandle;
+#endif
+#elif defined(USE_SPI_TRANSACTION_DMA)
+// Page programs are queued on the bus behind, and interleaved with, the transfers of the other devices
+static busDevice_t m25p16Bus;
+static const uint8_t m25p16WriteEnable = M25P16_INSTRUCTION_WRITE_ENABLE;
+static uint8_t m25p16PageProgramCommand[5];
+static spiSegment_t m25p16PageProgramSegments[3];
+static spiTransaction_t m25p16PageProgramTransaction;
+#endif
+
 /**
  * Send the given command byte to the device.
  */
@@ -112,6 +147,10 @@ static uint8_t m25p16_readStatus(void)
 
 bool m25p16_isReady(void)
 {
+    if (m25p16_isTransferInProgress()) {
+        return false;
+    }
+
     // If couldBeBusy is false, don't bother to poll the flash chip for its status
     couldBeBusy = couldBeBusy && ((m25p16_readStatus() & M25P16_STATUS_FLAG_WRITE_IN_PROGRESS) != 0);
 
@@ -130,6 +169,24 @@ bool m25p16_waitForReady(uint32_t timeoutMillis)
     return true;
 }
 
+/**
+ * Fill in the instruction and address of a command, returning the length of the command.
+ */
+static int m25p16_buildCommand(uint8_t *command, uint8_t instruction, uint32_t address)
+{
+    int length = 0;
+
+    command[length++] = instruction;
+    if (use4ByteAddress) {
+        command[length++] = (address >> 24) & 0xFF;
+    }
+    command[length++] = (address >> 16) & 0xFF;
+    command[length++] = (address >> 8) & 0xFF;
+    command[length++] = address & 0xFF;
+
+    return length;
+}
+
 /**
  * Read chip identification and geometry information (into global `geometry`).
  *
@@ -180,9 +237,16 @@ static bool m25p16_readIdentification(void)
         geometry.pagesPerSector = 256;
         break;
     case JEDEC_ID_MACRONIX_MX25L25635E:
+    case JEDEC_ID_MICRON_N25Q256:
+    case JEDEC_ID_WINBOND_W25Q256:
         geometry.sectors = 512;
         geometry.pagesPerSector = 256;
         break;
+    case JEDEC_ID_MACRONIX_MX66L51235F:
+    case JEDEC_ID_WINBOND_W25Q512:
+        geometry.sectors = 1024;
+        geometry.pagesPerSector = 256;
+        break;
     default:
         // Unsupported chip or not an SPI NOR flash
         geometry.sectors = 0;
@@ -196,6 +260,13 @@ static bool m25p16_readIdentification(void)
     geometry.sectorSize = geometry.pagesPerSector * geometry.pageSize;
     geometry.totalSize = geometry.sectorSize * geometry.sectors;
 
+    if (geometry.totalSize > M25P16_3BYTE_ADDRESS_LIMIT) {
+        // Micron chips only accept the mode change once writes are enabled, which does no harm on the others
+        m25p16_performOneByteCommand(M25P16_INSTRUCTION_WRITE_ENABLE);
+        m25p16_performOneByteCommand(M25P16_INSTRUCTION_ENTER_4BYTE_ADDRESS_MODE);
+        use4ByteAddress = true;
+    }
+
     couldBeBusy = true; // Just for luck we'll assume the chip could be busy even though it isn't specced to be
 
     return true;
@@ -227,6 +298,15 @@ bool m25p16_init(const flashConfig_t *flashConfig)
 
     DISABLE_M25P16;
 
+#if !defined(M25P16_DMA_CHANNEL_TX) && defined(USE_SPI_TRANSACTION_DMA)
+    m25p16Bus.busdev_u.spi.instance = M25P16_SPI_INSTANCE;
+    m25p16Bus.busdev_u.spi.csnPin = m25p16CsPin;
+#endif
+
+#ifdef M25P16_DMA_CHANNEL_TX
+    dmaInit(dmaGetIdentifier(M25P16_DMA_CHANNEL_TX), OWNER_FLASH, 0);
+#endif
+
 #ifndef M25P16_SPI_SHARED
     //Maximum speed for standard READ command is 20mHz, other commands tolerate 25mHz
     spiSetDivisor(M25P16_SPI_INSTANCE, SPI_CLOCK_FAST);
@@ -240,7 +320,8 @@ bool m25p16_init(const flashConfig_t *flashConfig)
  */
 void m25p16_eraseSector(uint32_t address)
 {
-    const uint8_t out[] = { M25P16_INSTRUCTION_SECTOR_ERASE, (address >> 16) & 0xFF, (address >> 8) & 0xFF, address & 0xFF};
+    uint8_t out[5];
+    const int outLength = m25p16_buildCommand(out, M25P16_INSTRUCTION_SECTOR_ERASE, address);
 
     m25p16_waitForReady(SECTOR_ERASE_TIMEOUT_MILLIS);
 
@@ -248,7 +329,7 @@ void m25p16_eraseSector(uint32_t address)
 
     ENABLE_M25P16;
 
-    spiTransfer(M25P16_SPI_INSTANCE, out, NULL, sizeof(out));
+    spiTransfer(M25P16_SPI_INSTANCE, out, NULL, outLength);
 
     DISABLE_M25P16;
 }
@@ -264,7 +345,8 @@ void m25p16_eraseCompletely(void)
 
 void m25p16_pageProgramBegin(uint32_t address)
 {
-    const uint8_t command[] = { M25P16_INSTRUCTION_PAGE_PROGRAM, (address >> 16) & 0xFF, (address >> 8) & 0xFF, address & 0xFF};
+    uint8_t command[5];
+    const int commandLength = m25p16_buildCommand(command, M25P16_INSTRUCTION_PAGE_PROGRAM, address);
 
     m25p16_waitForReady(DEFAULT_TIMEOUT_MILLIS);
 
@@ -272,7 +354,7 @@ void m25p16_pageProgramBegin(uint32_t address)
 
     ENABLE_M25P16;
 
-    spiTransfer(M25P16_SPI_INSTANCE, command, NULL, sizeof(command));
+    spiTransfer(M25P16_SPI_INSTANCE, command, NULL, commandLength);
 }
 
 void m25p16_pageProgramContinue(const uint8_t *data, int length)
@@ -309,6 +391,142 @@ void m25p16_pageProgram(uint32_t address, const uint8_t *data, int length)
     m25p16_pageProgramFinish();
 }
 
+/**
+ * Start writing bytes to a flash page, which the flash must be ready for (see m25p16_isReady()). Address must not cross
+ * a page boundary.
+ *
+ * When the target has a DMA channel for the flash the data is sent in the background, and must be left untouched until
+ * m25p16_isTransferInProgress() returns false. Otherwise it has been sent by the time this returns.
+ */
+void m25p16_pageProgramAsync(uint32_t address, const uint8_t *data, int length)
+{
+#ifdef M25P16_DMA_CHANNEL_TX
+    m25p16_pageProgramBegin(address);
+
+#if defined(USE_HAL_DRIVER)
+    m25p16DMAHandle = spiSetDMATransmit(M25P16_DMA_CHANNEL_TX, M25P16_DMA_CHANNEL, M25P16_SPI_INSTANCE, data, length);
+#else
+#ifdef M25P16_DMA_CLK
+    RCC_AHB1PeriphClockCmd(M25P16_DMA_CLK, ENABLE);
+#endif
+    DMA_InitTypeDef DMA_InitStructure;
+
+    DMA_StructInit(&DMA_InitStructure);
+#ifdef M25P16_DMA_CHANNEL
+    DMA_InitStructure.DMA_Channel = M25P16_DMA_CHANNEL;
+    DMA_InitStructure.DMA_Memory0BaseAddr = (uint32_t) data;
+    DMA_InitStructure.DMA_DIR = DMA_DIR_MemoryToPeripheral;
+#else
+    DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
+    DMA_InitStructure.DMA_MemoryBaseAddr = (uint32_t) data;
+    DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralDST;
+#endif
+    DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32_t) &M25P16_SPI_INSTANCE->DR;
+    DMA_InitStructure.DMA_Priority = DMA_Priority_Low;
+    DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+    DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte;
+
+    DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+    DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_Byte;
+
+    DMA_InitStructure.DMA_BufferSize = length;
+    DMA_InitStructure.DMA_Mode = DMA_Mode_Normal;
+
+    DMA_DeInit(M25P16_DMA_CHANNEL_TX);
+    DMA_Init(M25P16_DMA_CHANNEL_TX, &DMA_InitStructure);
+
+    DMA_Cmd(M25P16_DMA_CHANNEL_TX, ENABLE);
+
+    SPI_I2S_DMACmd(M25P16_SPI_INSTANCE, SPI_I2S_DMAReq_Tx, ENABLE);
+#endif
+
+    dmaTransferInProgress = true;
+#elif defined(USE_SPI_TRANSACTION_DMA)
+    m25p16_waitForReady(DEFAULT_TIMEOUT_MILLIS);
+
+    const int commandLength = m25p16_buildCommand(m25p16PageProgramCommand, M25P16_INSTRUCTION_PAGE_PROGRAM, address);
+
+    m25p16PageProgramSegments[0] = (spiSegment_t){ .txData = &m25p16WriteEnable, .length = 1, .negateCS = true };
+    m25p16PageProgramSegments[1] = (spiSegment_t){ .txData = m25p16PageProgramCommand, .length = commandLength };
+    m25p16PageProgramSegments[2] = (spiSegment_t){ .txData = data, .length = length, .negateCS = true };
+
+    m25p16PageProgramTransaction.bus = &m25p16Bus;
+    m25p16PageProgramTransaction.priority = SPI_PRIORITY_LOW;
+    m25p16PageProgramTransaction.segments = m25p16PageProgramSegments;
+    m25p16PageProgramTransaction.segmentCount = ARRAYLEN(m25p16PageProgramSegments);
+
+    couldBeBusy = true;
+    spiTransactionSubmit(&m25p16PageProgramTransaction);
+#else
+    m25p16_pageProgram(address, data, length);
+#endif
+}
+
+/**
+ * Returns true while the data of the last m25p16_pageProgramAsync() is still being sent. Once it has all gone out this
+ * finishes off the page program, and the flash goes on to be busy programming the page.
+ */
+bool m25p16_isTransferInProgress(void)
+{
+#ifdef M25P16_DMA_CHANNEL_TX
+    if (!dmaTransferInProgress) {
+        return false;
+    }
+
+#if defined(USE_HAL_DRIVER)
+    if (m25p16DMAHandle->State != HAL_DMA_STATE_READY) {
+        return true;
+    }
+
+    // Drain anything left in the Rx FIFO (we didn't read it during the write)
+    while (__HAL_SPI_GET_FLAG(spiHandleByInstance(M25P16_SPI_INSTANCE), SPI_FLAG_RXNE) == SET) {
+        M25P16_SPI_INSTANCE->DR;
+    }
+
+    // Wait for the final bit to be transmitted
+    while (spiIsBusBusy(M25P16_SPI_INSTANCE)) {
+    }
+
+    HAL_SPI_DMAStop(spiHandleByInstance(M25P16_SPI_INSTANCE));
+#else
+#ifdef M25P16_DMA_CHANNEL
+    if (DMA_GetFlagStatus(M25P16_DMA_CHANNEL_TX, M25P16_DMA_CHANNEL_TX_COMPLETE_FLAG) != SET) {
+        return true;
+    }
+    DMA_ClearFlag(M25P16_DMA_CHANNEL_TX, M25P16_DMA_CHANNEL_TX_COMPLETE_FLAG);
+#else
+    if (DMA_GetFlagStatus(M25P16_DMA_CHANNEL_TX_COMPLETE_FLAG) != SET) {
+        return true;
+    }
+    DMA_ClearFlag(M25P16_DMA_CHANNEL_TX_COMPLETE_FLAG);
+#endif
+
+    DMA_Cmd(M25P16_DMA_CHANNEL_TX, DISABLE);
+
+    // Drain anything left in the Rx FIFO (we didn't read it during the write)
+    while (SPI_I2S_GetFlagStatus(M25P16_SPI_INSTANCE, SPI_I2S_FLAG_RXNE) == SET) {
+        M25P16_SPI_INSTANCE->DR;
+    }
+
+    // Wait for the final bit to be transmitted
+    while (spiIsBusBusy(M25P16_SPI_INSTANCE)) {
+    }
+
+    SPI_I2S_DMACmd(M25P16_SPI_INSTANCE, SPI_I2S_DMAReq_Tx, DISABLE);
+#endif
+
+    m25p16_pageProgramFinish();
+
+    dmaTransferInProgress = false;
+#elif defined(USE_SPI_TRANSACTION_DMA)
+    if (!spiTransactionIsComplete(&m25p16PageProgramTransaction)) {
+        return true;
+    }
+#endif
+
+    return false;
+}
+
 /**
  * Read `length` bytes into the provided `buffer` from the flash starting from the given `address` (which need not lie
  * on a page boundary).
@@ -319,7 +537,8 @@ void m25p16_pageProgram(uint32_t address, const uint8_t *data, int length)
  */
 int m25p16_readBytes(uint32_t address, uint8_t *buffer, int length)
 {
-    const uint8_t command[] = { M25P16_INSTRUCTION_READ_BYTES, (address >> 16) & 0xFF, (address >> 8) & 0xFF, address & 0xFF};
+    uint8_t command[5];
+    const int commandLength = m25p16_buildCommand(command, M25P16_INSTRUCTION_READ_BYTES, address);
 
     if (!m25p16_waitForReady(DEFAULT_TIMEOUT_MILLIS)) {
         return 0;
@@ -327,7 +546,7 @@ int m25p16_readBytes(uint32_t address, uint8_t *buffer, int length)
 
     ENABLE_M25P16;
 
-    spiTransfer(M25P16_SPI_INSTANCE, command, NULL, sizeof(command));
+    spiTransfer(M25P16_SPI_INSTANCE, command, NULL, commandLength);
     spiTransfer(M25P16_SPI_INSTANCE, NULL, buffer, length);
 
     DISABLE_M25P16;
@@ -7,6 +7,7 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <math.h>
 
 #include "platform.h"
 
@@ -60,3 +61,48 @@ uint8_t gyroMPU6xxxGetDividerDrops(const gyroDev_t *gyro)
 {
     return gyro->mpuDividerDrops;
 }
+
+void gyroSampleClockInit(gyroSampleClock_t *clock, float nominalIntervalUs)
+{
+    clock->nominalIntervalUs = nominalIntervalUs;
+    clock->intervalUs = nominalIntervalUs;
+    clock->lastWindowIntervalUs = 0;
+    clock->windowStarted = false;
+}
+
+/*
+ * Called now and then with the time and count of the latest data ready interrupt, returns true when a new interval
+ * has been measured. A polled gyro has no interrupt times and keeps the nominal interval.
+ */
+bool gyroSampleClockUpdate(gyroSampleClock_t *clock, timeUs_t dataReadyTimeUs, uint32_t dataReadyCount)
+{
+    if (dataReadyTimeUs == 0) {
+        return false;
+    }
+    if (!clock->windowStarted) {
+        clock->windowStartUs = dataReadyTimeUs;
+        clock->windowStartCount = dataReadyCount;
+        clock->windowStarted = true;
+        return false;
+    }
+
+    const timeDelta_t elapsedUs = cmpTimeUs(dataReadyTimeUs, clock->windowStartUs);
+    const uint32_t intervals = dataReadyCount - clock->windowStartCount;
+    if (elapsedUs < GYRO_SAMPLE_CLOCK_WINDOW_US || intervals == 0) {
+        return false;
+    }
+
+    const float intervalUs = (float)elapsedUs / intervals;
+    const float lastWindowIntervalUs = clock->lastWindowIntervalUs;
+    clock->lastWindowIntervalUs = intervalUs;
+    clock->windowStartUs = dataReadyTimeUs;
+    clock->windowStartCount = dataReadyCount;
+
+    if (fabsf(intervalUs - clock->nominalIntervalUs) > clock->nominalIntervalUs * GYRO_SAMPLE_CLOCK_TOLERANCE
+        || fabsf(intervalUs - lastWindowIntervalUs) > intervalUs * GYRO_SAMPLE_CLOCK_AGREEMENT) {
+        return false;
+    }
+
+    clock->intervalUs = (intervalUs + lastWindowIntervalUs) / 2;
+    return true;
+}
@@ -10,3 +10,24 @@
 bool gyroSyncCheckUpdate(gyroDev_t *gyro);
 uint8_t gyroMPU6xxxGetDividerDrops(const gyroDev_t *gyro);
 uint32_t gyroSetSampleRate(gyroDev_t *gyro, uint8_t lpf, uint8_t gyroSyncDenominator, bool gyro_use_32khz);
+
+/*
+ * The gyro samples on its own oscillator, which can be a few percent off the rate set in its registers. The real interval
+ * between data ready interrupts is measured from their count and the times of the first and the last over a window long
+ * enough that the jitter of a single interrupt hardly matters.
+ */
+#define GYRO_SAMPLE_CLOCK_WINDOW_US     1000000
+#define GYRO_SAMPLE_CLOCK_TOLERANCE     0.05f   // further than this from the nominal interval it is not the gyro's clock
+#define GYRO_SAMPLE_CLOCK_AGREEMENT     0.001f  // two windows in a row agree, so neither lost interrupts to a stall
+
+typedef struct gyroSampleClock_s {
+    float nominalIntervalUs;
+    float intervalUs;                   // measured interval, the nominal one until a measurement is accepted
+    float lastWindowIntervalUs;
+    timeUs_t windowStartUs;
+    uint32_t windowStartCount;
+    bool windowStarted;
+} gyroSampleClock_t;
+
+void gyroSampleClockInit(gyroSampleClock_t *clock, float nominalIntervalUs);
+bool gyroSampleClockUpdate(gyroSampleClock_t *clock, timeUs_t dataReadyTimeUs, uint32_t dataReadyCount);
@@ -56,3 +56,30 @@ uint16_t IO_Pin(IO_t io);
 
 uint32_t IO_EXTI_Line(IO_t io);
 ioRec_t *IO_Rec(IO_t io);
+
+// Inlined IOHi()/IOLo() for hot paths such as SPI chip select.
+// The ioRec_t already holds the port and pin mask, so the set or reset is a single store to the
+// atomic set/reset register with no call and no HAL indirection.
+static inline void IOHiFast(IO_t io)
+{
+    ioRec_t *ioRec = io;
+    if (!ioRec)
+        return;
+#if defined(STM32F4) && !defined(USE_HAL_DRIVER)
+    ioRec->gpio->BSRRL = ioRec->pin;
+#else
+    ioRec->gpio->BSRR = ioRec->pin;
+#endif
+}
+
+static inline void IOLoFast(IO_t io)
+{
+    ioRec_t *ioRec = io;
+    if (!ioRec)
+        return;
+#if defined(STM32F4) && !defined(USE_HAL_DRIVER)
+    ioRec->gpio->BSRRH = ioRec->pin;
+#else
+    ioRec->gpio->BSRR = (uint32_t)ioRec->pin << 16;
+#endif
+}
@@ -36,15 +36,12 @@
 
 #include "common/color.h"
 #include "common/colorconversion.h"
+#include "common/utils.h"
 #include "dma.h"
 #include "drivers/io.h"
 #include "light_ws2811strip.h"
 
-#if defined(STM32F1) || defined(STM32F3)
-uint8_t ledStripDMABuffer[WS2811_DMA_BUFFER_SIZE];
-#else
-uint32_t ledStripDMABuffer[WS2811_DMA_BUFFER_SIZE];
-#endif
+DMA_RAM ws2811DmaValue_t ledStripDMABuffer[WS2811_DMA_BUFFER_SIZE];
 volatile uint8_t ws2811LedDataTransferInProgress = 0;
 
 uint16_t BIT_COMPARE_1 = 0;
@@ -52,9 +49,40 @@ uint16_t BIT_COMPARE_0 = 0;
 
 static hsvColor_t ledColorBuffer[WS2811_LED_STRIP_LENGTH];
 
+#ifdef USE_LED_STRIP_STREAMING
+// a half of the DMA buffer that only holds the reset must cover the 50us latch time
+STATIC_ASSERT(WS2811_DMA_HALF_BUFFER_SIZE >= WS2811_DELAY_BUFFER_LENGTH, ws2811_stream_chunk_too_small);
+
+static uint16_t streamLedIndex;
+static bool streamHalfIsReset[2];
+#else
+// The DMA buffer keeps the expanded colour of every LED between updates,
+// so only the LEDs whose colour changed since the last update are converted again.
+STATIC_ASSERT(WS2811_LED_STRIP_LENGTH <= 32, ledDirtyMask_too_small);
+static uint32_t ledDirtyMask;
+#endif
+
+// Compare values for every 4 bit pattern, MSB first
+STATIC_UNIT_TESTED ws2811DmaValue_t ledNibbleLookup[16][4];
+static uint16_t ledNibbleLookupCompare0;
+static uint16_t ledNibbleLookupCompare1;
+
+static void setLedDirty(uint16_t index)
+{
+#ifdef USE_LED_STRIP_STREAMING
+    // every LED is expanded again as it is streamed out
+    UNUSED(index);
+#else
+    ledDirtyMask |= 1U << index;
+#endif
+}
+
 void setLedHsv(uint16_t index, const hsvColor_t *color)
 {
-    ledColorBuffer[index] = *color;
+    if (ledColorBuffer[index].h != color->h || ledColorBuffer[index].s != color->s || ledColorBuffer[index].v != color->v) {
+        ledColorBuffer[index] = *color;
+        setLedDirty(index);
+    }
 }
 
 void getLedHsv(uint16_t index, hsvColor_t *color)
@@ -64,12 +92,15 @@ void getLedHsv(uint16_t index, hsvColor_t *color)
 
 void setLedValue(uint16_t index, const uint8_t value)
 {
-    ledColorBuffer[index].v = value;
+    if (ledColorBuffer[index].v != value) {
+        ledColorBuffer[index].v = value;
+        setLedDirty(index);
+    }
 }
 
 void scaleLedValue(uint16_t index, const uint8_t scalePercent)
 {
-    ledColorBuffer[index].v = ((uint16_t)ledColorBuffer[index].v * scalePercent / 100);
+    setLedValue(index, (uint16_t)ledColorBuffer[index].v * scalePercent / 100);
 }
 
 void setStripColor(const hsvColor_t *color)
@@ -95,6 +126,9 @@ void ws2811LedStripInit(ioTag_t ioTag)
 
     const hsvColor_t hsv_white = { 0, 255, 255 };
     setStripColor(&hsv_white);
+#ifndef USE_LED_STRIP_STREAMING
+    ledDirtyMask = ~0U;
+#endif
     ws2811UpdateStrip();
 }
 
@@ -109,13 +143,36 @@ static int16_t ledIndex;
 #define USE_FAST_DMA_BUFFER_IMPL
 #ifdef USE_FAST_DMA_BUFFER_IMPL
 
+static void updateNibbleLookup(void)
+{
+    if (ledNibbleLookupCompare0 == BIT_COMPARE_0 && ledNibbleLookupCompare1 == BIT_COMPARE_1) {
+        return;
+    }
+
+    for (unsigned nibble = 0; nibble < 16; nibble++) {
+        for (unsigned bit = 0; bit < 4; bit++) {
+            ledNibbleLookup[nibble][bit] = (nibble & (0x08 >> bit)) ? BIT_COMPARE_1 : BIT_COMPARE_0;
+        }
+    }
+    ledNibbleLookupCompare0 = BIT_COMPARE_0;
+    ledNibbleLookupCompare1 = BIT_COMPARE_1;
+}
+
 STATIC_UNIT_TESTED void fastUpdateLEDDMABuffer(rgbColor24bpp_t *color)
 {
     uint32_t grb = (color->rgb.g << 16) | (color->rgb.r << 8) | (color->rgb.b);
 
-    for (int8_t index = 23; index >= 0; index--) {
-        ledStripDMABuffer[dmaBufferOffset++] = (grb & (1 << index)) ? BIT_COMPARE_1 : BIT_COMPARE_0;
+    updateNibbleLookup();
+
+    ws2811DmaValue_t *dst = &ledStripDMABuffer[dmaBufferOffset];
+    for (int8_t shift = 20; shift >= 0; shift -= 4) {
+        const ws2811DmaValue_t *bits = ledNibbleLookup[(grb >> shift) & 0x0F];
+        *dst++ = bits[0];
+        *dst++ = bits[1];
+        *dst++ = bits[2];
+        *dst++ = bits[3];
     }
+    dmaBufferOffset += WS2811_BITS_PER_LED;
 }
 #else
 STATIC_UNIT_TESTED void updateLEDDMABuffer(uint8_t componentValue)
@@ -137,6 +194,37 @@ STATIC_UNIT_TESTED void updateLEDDMABuffer(uint8_t componentValue)
 }
 #endif
 
+#ifdef USE_LED_STRIP_STREAMING
+static void streamFillHalf(unsigned half)
+{
+    dmaBufferOffset = half * WS2811_DMA_HALF_BUFFER_SIZE;
+    const uint16_t halfEnd = dmaBufferOffset + WS2811_DMA_HALF_BUFFER_SIZE;
+
+    streamHalfIsReset[half] = (streamLedIndex >= WS2811_LED_STRIP_LENGTH);
+
+    while (dmaBufferOffset < halfEnd && streamLedIndex < WS2811_LED_STRIP_LENGTH) {
+        fastUpdateLEDDMABuffer(hsvToRgb24(&ledColorBuffer[streamLedIndex++]));
+    }
+
+    // after the last LED the line is held low, which starts the reset
+    memset(&ledStripDMABuffer[dmaBufferOffset], 0, (halfEnd - dmaBufferOffset) * sizeof(ledStripDMABuffer[0]));
+}
+
+/*
+ * Called from the DMA ISR when a half of the buffer has gone out, refills it with the next LEDs.
+ * Returns true once a half holding only the reset has been sent, the DMA can then be stopped.
+ */
+bool ws2811StreamHalfSent(unsigned half)
+{
+    if (streamHalfIsReset[half]) {
+        return true;
+    }
+
+    streamFillHalf(half);
+    return false;
+}
+#endif
+
 /*
  * This method is non-blocking unless an existing LED update is in progress.
  * it does not wait until all the LEDs have been updated, that happens in the background.
@@ -150,13 +238,28 @@ void ws2811UpdateStrip(void)
         return;
     }
 
-    dmaBufferOffset = 0;                // reset buffer memory index
+#ifdef USE_LED_STRIP_STREAMING
+    UNUSED(rgb24);
+    UNUSED(ledIndex);
+
+    // only the first two chunks are expanded here, the DMA ISR expands the rest while they go out
+    streamLedIndex = 0;
+    streamFillHalf(0);
+    streamFillHalf(1);
+#else
     ledIndex = 0;                       // reset led index
 
     // fill transmit buffer with correct compare values to achieve
-    // correct pulse widths according to color values
-    while (ledIndex < WS2811_LED_STRIP_LENGTH)
+    // correct pulse widths according to color values, LEDs that did not change keep theirs
+    while (ledDirtyMask)
     {
+        if (!(ledDirtyMask & (1U << ledIndex))) {
+            ledIndex++;
+            continue;
+        }
+        ledDirtyMask &= ~(1U << ledIndex);
+        dmaBufferOffset = ledIndex * WS2811_BITS_PER_LED;
+
         rgb24 = hsvToRgb24(&ledColorBuffer[ledIndex]);
 
 #ifdef USE_FAST_DMA_BUFFER_IMPL
@@ -169,6 +272,7 @@ void ws2811UpdateStrip(void)
 
         ledIndex++;
     }
+#endif
 
     ws2811LedDataTransferInProgress = 1;
     ws2811LedStripDMAEnable();
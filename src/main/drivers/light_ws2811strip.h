@@ -19,14 +19,26 @@
 
 #include "drivers/io_types.h"
 
+#ifndef WS2811_LED_STRIP_LENGTH
 #define WS2811_LED_STRIP_LENGTH    32
+#endif
 #define WS2811_BITS_PER_LED        24
 // for 50us delay
 #define WS2811_DELAY_BUFFER_LENGTH 42
 
+#ifdef USE_LED_STRIP_STREAMING
+// The DMA runs circular over two halves of WS2811_STREAM_CHUNK_LEDS LEDs each,
+// the DMA ISR expands the next LEDs into a half once it has gone out.
+#ifndef WS2811_STREAM_CHUNK_LEDS
+#define WS2811_STREAM_CHUNK_LEDS   4
+#endif
+#define WS2811_DMA_HALF_BUFFER_SIZE (WS2811_BITS_PER_LED * WS2811_STREAM_CHUNK_LEDS)
+#define WS2811_DMA_BUFFER_SIZE     (2 * WS2811_DMA_HALF_BUFFER_SIZE)
+#else
 #define WS2811_DATA_BUFFER_SIZE    (WS2811_BITS_PER_LED * WS2811_LED_STRIP_LENGTH)
 // number of bytes needed is #LEDs * 24 bytes + 42 trailing bytes)
 #define WS2811_DMA_BUFFER_SIZE     (WS2811_DATA_BUFFER_SIZE + WS2811_DELAY_BUFFER_LENGTH)
+#endif
 
 #define WS2811_TIMER_MHZ           48
 #define WS2811_CARRIER_HZ          800000
@@ -49,11 +61,19 @@ void setStripColors(const hsvColor_t *colors);
 
 bool isWS2811LedStripReady(void);
 
+#ifdef USE_LED_STRIP_STREAMING
+bool ws2811StreamHalfSent(unsigned half);
+#endif
+
 #if defined(STM32F1) || defined(STM32F3)
-extern uint8_t ledStripDMABuffer[WS2811_DMA_BUFFER_SIZE];
+typedef uint8_t ws2811DmaValue_t;
 #else
-extern uint32_t ledStripDMABuffer[WS2811_DMA_BUFFER_SIZE];
+// F4/F7 run the DMA stream in direct mode, where the memory size follows the peripheral size,
+// and the strip may sit on a 32 bit timer (TIM2/TIM5), so the compare values stay words.
+typedef uint32_t ws2811DmaValue_t;
 #endif
+
+extern ws2811DmaValue_t ledStripDMABuffer[WS2811_DMA_BUFFER_SIZE];
 extern volatile uint8_t ws2811LedDataTransferInProgress;
 
 extern uint16_t BIT_COMPARE_1;
@@ -22,6 +22,10 @@
 
 #ifdef LED_STRIP
 
+#ifdef USE_LED_STRIP_STREAMING
+#error "LED strip streaming is only implemented for the standard peripheral driver"
+#endif
+
 #include "common/color.h"
 #include "light_ws2811strip.h"
 #include "drivers/nvic.h"
@@ -42,6 +42,26 @@ static DMA_Channel_TypeDef *dmaRef = NULL;
 #endif
 static TIM_TypeDef *timer = NULL;
 
+#ifdef USE_LED_STRIP_STREAMING
+static void WS2811_DMA_IRQHandler(dmaChannelDescriptor_t *descriptor)
+{
+    bool sent = false;
+
+    if (DMA_GET_FLAG_STATUS(descriptor, DMA_IT_HTIF)) {
+        DMA_CLEAR_FLAG(descriptor, DMA_IT_HTIF);
+        sent = ws2811StreamHalfSent(0);
+    }
+    if (DMA_GET_FLAG_STATUS(descriptor, DMA_IT_TCIF)) {
+        DMA_CLEAR_FLAG(descriptor, DMA_IT_TCIF);
+        sent = sent || ws2811StreamHalfSent(1);
+    }
+
+    if (sent) {
+        DMA_Cmd(descriptor->ref, DISABLE);
+        ws2811LedDataTransferInProgress = 0;
+    }
+}
+#else
 static void WS2811_DMA_IRQHandler(dmaChannelDescriptor_t *descriptor)
 {
     if (DMA_GET_FLAG_STATUS(descriptor, DMA_IT_TCIF)) {
@@ -50,6 +70,7 @@ static void WS2811_DMA_IRQHandler(dmaChannelDescriptor_t *descriptor)
         DMA_CLEAR_FLAG(descriptor, DMA_IT_TCIF);
     }
 }
+#endif
 
 void ws2811LedStripHardwareInit(ioTag_t ioTag)
 {
@@ -148,11 +169,19 @@ void ws2811LedStripHardwareInit(ioTag_t ioTag)
     DMA_InitStructure.DMA_Priority = DMA_Priority_High;
     DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
 #endif
+#ifdef USE_LED_STRIP_STREAMING
+    DMA_InitStructure.DMA_Mode = DMA_Mode_Circular;
+#else
     DMA_InitStructure.DMA_Mode = DMA_Mode_Normal;
+#endif
 
     DMA_Init(dmaRef, &DMA_InitStructure);
     TIM_DMACmd(timer, timerDmaSource(timerHardware->channel), ENABLE);
+#ifdef USE_LED_STRIP_STREAMING
+    DMA_ITConfig(dmaRef, DMA_IT_HT | DMA_IT_TC, ENABLE);
+#else
     DMA_ITConfig(dmaRef, DMA_IT_TC, ENABLE);
+#endif
     ws2811Initialised = true;
 }
 
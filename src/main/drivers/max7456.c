@@ -28,6 +28,7 @@
 
 #include "drivers/bus_spi.h"
 #include "drivers/dma.h"
+#include "drivers/exti.h"
 #include "drivers/io.h"
 #include "drivers/light_led.h"
 #include "drivers/max7456.h"
@@ -153,15 +154,15 @@
 // On shared SPI buss we want to change clock for OSD chip and restore for other devices.
 
 #ifdef MAX7456_SPI_CLK
-    #define ENABLE_MAX7456        {spiSetDivisor(MAX7456_SPI_INSTANCE, MAX7456_SPI_CLK);IOLo(max7456CsPin);}
+    #define ENABLE_MAX7456        {spiSetDivisor(MAX7456_SPI_INSTANCE, MAX7456_SPI_CLK);spiBusSelectDevice(MAX7456_SPI_INSTANCE, max7456CsPin);}
 #else
-    #define ENABLE_MAX7456        IOLo(max7456CsPin)
+    #define ENABLE_MAX7456        spiBusSelectDevice(MAX7456_SPI_INSTANCE, max7456CsPin)
 #endif
 
 #ifdef MAX7456_RESTORE_CLK
-    #define DISABLE_MAX7456       {IOHi(max7456CsPin);spiSetDivisor(MAX7456_SPI_INSTANCE, MAX7456_RESTORE_CLK);}
+    #define DISABLE_MAX7456       {spiBusDeselectDevice(MAX7456_SPI_INSTANCE, max7456CsPin);spiSetDivisor(MAX7456_SPI_INSTANCE, MAX7456_RESTORE_CLK);}
 #else
-    #define DISABLE_MAX7456       IOHi(max7456CsPin)
+    #define DISABLE_MAX7456       spiBusDeselectDevice(MAX7456_SPI_INSTANCE, max7456CsPin)
 #endif
 
 uint16_t maxScreenSize = VIDEO_BUFFER_CHARS_PAL;
@@ -169,18 +170,28 @@ uint16_t maxScreenSize = VIDEO_BUFFER_CHARS_PAL;
 // We write everything in screenBuffer and then compare
 // screenBuffer with shadowBuffer to upgrade only changed chars.
 // This solution is faster then redrawing entire screen.
+// Both are claimed from the arena by max7456Init, so they only take RAM when the OSD is enabled.
 
-static uint8_t screenBuffer[VIDEO_BUFFER_CHARS_PAL+40]; // For faster writes we use memcpy so we need some space to don't overwrite buffer
-static uint8_t shadowBuffer[VIDEO_BUFFER_CHARS_PAL];
+static uint8_t *screenBuffer;
+static uint8_t *shadowBuffer;
 
-//Max chars to update in one idle
+// Changed characters are sent in runs using the auto-increment mode: the start address and DMM once,
+// then a DMDI write per character, ended by writing the 0xFF escape.
+// Unchanged characters between two changes are sent along when that is cheaper than starting a new run.
+
+#define MAX7456_RUN_OVERHEAD    8   // DMAH, DMAL, DMM and the terminating DMDI write
+#define MAX7456_RUN_GAP_MAX     (MAX7456_RUN_OVERHEAD / 2)
 
-#define MAX_CHARS2UPDATE    100
 #ifdef MAX7456_DMA_CHANNEL_TX
 volatile bool dmaTransactionInProgress = false;
+// A DMA transfer costs no CPU time, so a single one can carry the whole screen
+#define MAX7456_SPI_BUFF_SIZE   (VIDEO_BUFFER_CHARS_PAL * 2 + MAX7456_RUN_OVERHEAD * 4)
+#else
+//Max bytes to send in one idle
+#define MAX7456_SPI_BUFF_SIZE   600
 #endif
 
-static uint8_t spiBuff[MAX_CHARS2UPDATE*6];
+static uint8_t spiBuff[MAX7456_SPI_BUFF_SIZE];
 
 static uint8_t  videoSignalCfg;
 static uint8_t  videoSignalReg  = OSD_ENABLE; // OSD_ENABLE required to trigger first ReInit
@@ -193,6 +204,36 @@ static bool  max7456Lock        = false;
 static bool fontIsLoading       = false;
 static IO_t max7456CsPin        = IO_NONE;
 
+#ifdef MAX7456_VSYNC_PIN
+// No VSYNC for this long means there is no video signal to follow
+#define MAX7456_VSYNC_TIMEOUT_US    100000
+
+static IO_t max7456VsyncPin     = IO_NONE;
+static extiCallbackRec_t max7456VsyncCallbackRec;
+static volatile timeUs_t max7456VsyncAtUs = 0;
+
+static void max7456VsyncHandler(extiCallbackRec_t *cb)
+{
+    UNUSED(cb);
+    max7456VsyncAtUs = micros();
+}
+
+static void max7456VsyncInit(void)
+{
+    max7456VsyncPin = IOGetByTag(IO_TAG(MAX7456_VSYNC_PIN));
+    IOInit(max7456VsyncPin, OWNER_OSD_VSYNC, 0);
+#if defined(STM32F7)
+    EXTIHandlerInit(&max7456VsyncCallbackRec, max7456VsyncHandler);
+    EXTIConfig(max7456VsyncPin, &max7456VsyncCallbackRec, NVIC_PRIO_MAX7456_VSYNC, IO_CONFIG(GPIO_MODE_INPUT, 0, GPIO_PULLUP));
+#else
+    IOConfigGPIO(max7456VsyncPin, IOCFG_IPU);
+    EXTIHandlerInit(&max7456VsyncCallbackRec, max7456VsyncHandler);
+    EXTIConfig(max7456VsyncPin, &max7456VsyncCallbackRec, NVIC_PRIO_MAX7456_VSYNC, EXTI_Trigger_Falling);
+    EXTIEnable(max7456VsyncPin, true);
+#endif
+}
+#endif
+
 
 static uint8_t max7456Send(uint8_t add, uint8_t data)
 {
@@ -390,6 +431,11 @@ void max7456ReInit(void)
 
 void max7456Init(const vcdProfile_t *pVcdProfile)
 {
+    if (!screenBuffer) {
+        screenBuffer = arenaAlloc(MAX7456_SCREEN_BUFFER_SIZE);
+        shadowBuffer = arenaAlloc(VIDEO_BUFFER_CHARS_PAL);
+    }
+
     max7456HardwareReset();
 
 #ifdef MAX7456_SPI_CS_PIN
@@ -414,6 +460,10 @@ void max7456Init(const vcdProfile_t *pVcdProfile)
     dmaSetHandler(MAX7456_DMA_IRQ_HANDLER_ID, max7456_dma_irq_handler, NVIC_PRIO_MAX7456_DMA, 0);
 #endif
 
+#ifdef MAX7456_VSYNC_PIN
+    max7456VsyncInit();
+#endif
+
     // Real init will be made later when driver detect idle.
 }
 
@@ -475,6 +525,29 @@ void max7456Write(uint8_t x, uint8_t y, const char *buff)
             screenBuffer[y*CHARS_PER_LINE+x+i] = *(buff+i);
 }
 
+bool max7456BuffersSynced(void)
+{
+    return memcmp(screenBuffer, shadowBuffer, maxScreenSize) == 0;
+}
+
+/**
+ * Returns true while the VSYNC output of the chip is connected and pulsing,
+ * with the time the current video field started.
+ */
+bool max7456GetVsync(timeUs_t *vsyncAtUs)
+{
+#ifdef MAX7456_VSYNC_PIN
+    const timeUs_t lastVsyncAtUs = max7456VsyncAtUs;
+    if (lastVsyncAtUs && cmpTimeUs(micros(), lastVsyncAtUs) < MAX7456_VSYNC_TIMEOUT_US) {
+        *vsyncAtUs = lastVsyncAtUs;
+        return true;
+    }
+#else
+    UNUSED(vsyncAtUs);
+#endif
+    return false;
+}
+
 bool max7456DmaInProgress(void)
 {
 #ifdef MAX7456_DMA_CHANNEL_TX
@@ -486,6 +559,88 @@ bool max7456DmaInProgress(void)
 
 #include "build/debug.h"
 
+static bool max7456CharChanged(uint16_t pos)
+{
+    return screenBuffer[pos] != shadowBuffer[pos];
+}
+
+// Fills spiBuff with the writes for the changed characters from *pos on, and returns its length
+static int max7456BuildUpdate(uint16_t *pos)
+{
+    int len = 0;
+
+    for (uint16_t scanned = 0; scanned < maxScreenSize; ) {
+        const uint16_t start = *pos;
+
+        if (!max7456CharChanged(start)) {
+            scanned++;
+        } else if (screenBuffer[start] == END_STRING) {
+            // 0xFF ends an auto-increment run, so this character gets a write of its own
+            if (len + 6 + 2 > MAX7456_SPI_BUFF_SIZE) {
+                break;
+            }
+            spiBuff[len++] = MAX7456ADD_DMAH;
+            spiBuff[len++] = start >> 8;
+            spiBuff[len++] = MAX7456ADD_DMAL;
+            spiBuff[len++] = start & 0xff;
+            spiBuff[len++] = MAX7456ADD_DMDI;
+            spiBuff[len++] = END_STRING;
+            shadowBuffer[start] = END_STRING;
+            scanned++;
+        } else {
+            if (len + MAX7456_RUN_OVERHEAD + 2 + 2 > MAX7456_SPI_BUFF_SIZE) {
+                break;
+            }
+            spiBuff[len++] = MAX7456ADD_DMAH;
+            spiBuff[len++] = start >> 8;
+            spiBuff[len++] = MAX7456ADD_DMAL;
+            spiBuff[len++] = start & 0xff;
+            spiBuff[len++] = MAX7456ADD_DMM;
+            spiBuff[len++] = displayMemoryModeReg | 1;
+
+            // a run never wraps around the end of the screen, and always leaves room for its terminator and the final DMM write
+            uint16_t end = start;
+            while (end < maxScreenSize && screenBuffer[end] != END_STRING && len + 2 + 4 <= MAX7456_SPI_BUFF_SIZE) {
+                if (!max7456CharChanged(end)) {
+                    uint16_t next = end;
+                    while (next < maxScreenSize && next - end <= MAX7456_RUN_GAP_MAX && !max7456CharChanged(next)) {
+                        next++;
+                    }
+                    if (next >= maxScreenSize || next - end > MAX7456_RUN_GAP_MAX || screenBuffer[next] == END_STRING
+                        || len + (next - end + 1) * 2 + 4 > MAX7456_SPI_BUFF_SIZE) {
+                        break;
+                    }
+                }
+                spiBuff[len++] = MAX7456ADD_DMDI;
+                spiBuff[len++] = screenBuffer[end];
+                shadowBuffer[end] = screenBuffer[end];
+                end++;
+            }
+
+            spiBuff[len++] = MAX7456ADD_DMDI;
+            spiBuff[len++] = END_STRING;
+
+            scanned += end - start;
+            *pos = end;
+            if (*pos >= maxScreenSize) {
+                *pos = 0;
+            }
+            continue;
+        }
+
+        if (++(*pos) >= maxScreenSize) {
+            *pos = 0;
+        }
+    }
+
+    if (len) {
+        spiBuff[len++] = MAX7456ADD_DMM;
+        spiBuff[len++] = displayMemoryModeReg;
+    }
+
+    return len;
+}
+
 void max7456DrawScreen(void)
 {
     uint8_t stallCheck;
@@ -494,7 +649,7 @@ void max7456DrawScreen(void)
     uint32_t nowMs;
     static uint32_t videoDetectTimeMs = 0;
     static uint16_t pos = 0;
-    int k = 0, buff_len=0;
+    int buff_len;
 
     if (!max7456Lock && !fontIsLoading) {
 
@@ -549,32 +704,14 @@ void max7456DrawScreen(void)
 
         //------------   end of (re)init-------------------------------------
 
-        for (k=0; k< MAX_CHARS2UPDATE; k++) {
-            if (screenBuffer[pos] != shadowBuffer[pos]) {
-                spiBuff[buff_len++] = MAX7456ADD_DMAH;
-                spiBuff[buff_len++] = pos >> 8;
-                spiBuff[buff_len++] = MAX7456ADD_DMAL;
-                spiBuff[buff_len++] = pos & 0xff;
-                spiBuff[buff_len++] = MAX7456ADD_DMDI;
-                spiBuff[buff_len++] = screenBuffer[pos];
-                shadowBuffer[pos] = screenBuffer[pos];
-                k++;
-            }
-
-            if (++pos >= maxScreenSize) {
-                pos = 0;
-                break;
-            }
-        }
+        buff_len = max7456BuildUpdate(&pos);
 
         if (buff_len) {
             #ifdef MAX7456_DMA_CHANNEL_TX
-            if (buff_len > 0)
-                max7456SendDma(spiBuff, NULL, buff_len);
+            max7456SendDma(spiBuff, NULL, buff_len);
             #else
             ENABLE_MAX7456;
-            for (k=0; k < buff_len; k++)
-                spiTransferByte(MAX7456_SPI_INSTANCE, spiBuff[k]);
+            spiTransfer(MAX7456_SPI_INSTANCE, spiBuff, NULL, buff_len);
             DISABLE_MAX7456;
             #endif // MAX7456_DMA_CHANNEL_TX
         }
@@ -643,7 +780,8 @@ void max7456WriteNvm(uint8_t char_address, const uint8_t *font_data)
 
     // Wait until bit 5 in the status register returns to 0 (12ms)
 
-    while ((max7456Send(MAX7456ADD_STAT, 0x00) & STAT_NVR_BUSY) != 0x00);
+    while ((max7456Send(MAX7456ADD_STAT, 0x00) & STAT_NVR_BUSY) != 0x00) {
+    }
 
     DISABLE_MAX7456;
 
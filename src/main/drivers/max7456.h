@@ -17,6 +17,9 @@
 
 #pragma once
 
+#include "common/arena.h"
+#include "common/time.h"
+
 #ifndef WHITEBRIGHTNESS
   #define WHITEBRIGHTNESS 0x01
 #endif
@@ -32,6 +35,10 @@
 #define VIDEO_LINES_NTSC          13
 #define VIDEO_LINES_PAL           16
 
+// For faster writes we use memcpy so the screen buffer has some space past the end not to overwrite anything
+#define MAX7456_SCREEN_BUFFER_SIZE  (VIDEO_BUFFER_CHARS_PAL + 40)
+#define MAX7456_ARENA_SIZE          (ARENA_ALIGN(MAX7456_SCREEN_BUFFER_SIZE) + ARENA_ALIGN(VIDEO_BUFFER_CHARS_PAL))
+
 extern uint16_t maxScreenSize;
 
 struct vcdProfile_s;
@@ -48,3 +55,5 @@ void    max7456ClearScreen(void);
 void    max7456RefreshAll(void);
 uint8_t* max7456GetScreenBuffer(void);
 bool    max7456DmaInProgress(void);
+bool    max7456BuffersSynced(void);
+bool    max7456GetVsync(timeUs_t *vsyncAtUs);
@@ -21,12 +21,16 @@
 #include <math.h>
 
 #include "platform.h"
+#include "common/maths.h"
+#include "common/utils.h"
+
 #include "drivers/time.h"
 
 #include "drivers/io.h"
 #include "pwm_output.h"
 #include "timer.h"
 #include "drivers/pwm_output.h"
+#include "drivers/sound_beeper.h"
 
 static pwmWriteFunc *pwmWrite;
 static pwmOutputPort_t motors[MAX_SUPPORTED_MOTORS];
@@ -43,10 +47,43 @@ static pwmOutputPort_t servos[MAX_SUPPORTED_SERVOS];
 #ifdef BEEPER
 static pwmOutputPort_t beeperPwm;
 static uint16_t freqBeep = 0;
+static const timerHardware_t *beeperTimer = NULL;
+static timerOvrHandlerRec_t beeperOverflowCb;
+static uint16_t beeperTicksPerStep;                     // tone periods in one 10ms step of a sequence
+static const uint8_t * volatile beeperSequence = NULL;  // NULL when no sequence is playing
+static volatile uint8_t beeperSequencePos;
+static volatile uint32_t beeperSequenceTicks;
+static volatile bool beeperSequenceOn;
+static bool beeperSequenceAudible;
 #endif
 
 static bool pwmMotorsEnabled = false;
 static bool isDshot = false;
+#ifdef USE_DSHOT_DMAR
+bool useBurstDshot = false;
+#endif
+#ifdef USE_DSHOT_TELEMETRY
+bool useDshotTelemetry = false;
+#endif
+
+#ifdef USE_DSHOT
+#define DSHOT_COMMAND_QUEUE_SIZE 8
+#define DSHOT_COMMAND_INTERVAL_US 1000      // between the frames of a command, and after the last one
+
+typedef struct dshotCommand_s {
+    uint8_t index;                          // motor index or DSHOT_ALL_MOTORS
+    uint8_t command;
+    dshotCommandCompleteFnPtr completeFn;
+} dshotCommand_t;
+
+// queued from tasks, sent from the motor update, which may run in the gyro interrupt
+static dshotCommand_t dshotCommandQueue[DSHOT_COMMAND_QUEUE_SIZE];
+static volatile uint8_t dshotCommandHead;
+static volatile uint8_t dshotCommandTail;
+static uint8_t dshotCommandFramesSent;
+static timeUs_t dshotCommandNextFrameUs;
+static bool dshotCommandFrame;              // the motor values loaded next carry the command at the tail
+#endif
 
 static void pwmOCConfig(TIM_TypeDef *tim, uint8_t channel, uint16_t value, uint8_t output)
 {
@@ -143,6 +180,14 @@ static void pwmWriteStandard(uint8_t index, float value)
 #ifdef USE_DSHOT
 static void pwmWriteDshot(uint8_t index, float value)
 {
+    if (dshotCommandFrame) {
+        const dshotCommand_t *command = &dshotCommandQueue[dshotCommandTail];
+        if (command->index == DSHOT_ALL_MOTORS || command->index == index) {
+            getMotorDmaOutput(index)->requestTelemetry = true;
+            pwmWriteDshotInt(index, command->command);
+            return;
+        }
+    }
     pwmWriteDshotInt(index, lrintf(value));
 }
 
@@ -216,15 +261,30 @@ static void pwmCompleteOneshotMotorUpdate(uint8_t motorCount)
     }
 }
 
+#ifdef USE_DSHOT
+static void dshotCommandUpdate(void);
+#endif
+
 void pwmCompleteMotorUpdate(uint8_t motorCount)
 {
     pwmCompleteWrite(motorCount);
+#ifdef USE_DSHOT
+    if (isDshot) {
+        dshotCommandUpdate();
+    }
+#endif
 }
 
 void motorDevInit(const motorDevConfig_t *motorConfig, uint16_t idlePulse, uint8_t motorCount)
 {
     memset(motors, 0, sizeof(motors));
 
+#ifdef USE_DSHOT_DMAR
+    useBurstDshot = false;
+#endif
+#ifdef USE_DSHOT_TELEMETRY
+    useDshotTelemetry = false;
+#endif
     bool useUnsyncedPwm = motorConfig->useUnsyncedPwm;
 
     float sMin = 0;
@@ -269,10 +329,25 @@ void motorDevInit(const motorDevConfig_t *motorConfig, uint16_t idlePulse, uint8
         loadDmaBuffer = &loadDmaBufferDshot;
         pwmCompleteWrite = &pwmCompleteDshotMotorUpdate;
         isDshot = true;
+#ifdef USE_DSHOT_TELEMETRY
+        useDshotTelemetry = motorConfig->useDshotTelemetry;
+#endif
         break;
 #endif
     }
 
+#ifdef USE_DSHOT_DMAR
+    if (isDshot) {
+        useBurstDshot = motorConfig->useBurstDshot;
+#ifdef USE_DSHOT_TELEMETRY
+        // the replies are captured by a stream per channel
+        if (useDshotTelemetry) {
+            useBurstDshot = false;
+        }
+#endif
+    }
+#endif
+
     if (!isDshot) {
         pwmWrite = &pwmWriteStandard;
         pwmCompleteWrite = useUnsyncedPwm ? &pwmCompleteWriteUnused : &pwmCompleteOneshotMotorUpdate;
@@ -294,10 +369,17 @@ void motorDevInit(const motorDevConfig_t *motorConfig, uint16_t idlePulse, uint8
 
 #ifdef USE_DSHOT
         if (isDshot) {
+            uint8_t output = motorConfig->motorPwmInversion ? timerHardware->output ^ TIMER_OUTPUT_INVERTED : timerHardware->output;
+#ifdef USE_DSHOT_TELEMETRY
+            // bidirectional frames are sent inverted, so the line idles high for the reply of the ESC
+            if (useDshotTelemetry) {
+                output ^= TIMER_OUTPUT_INVERTED;
+            }
+#endif
             pwmDshotMotorHardwareConfig(timerHardware, 
                 motorIndex, 
                 motorConfig->motorPwmProtocol,
-                motorConfig->motorPwmInversion ? timerHardware->output ^ TIMER_OUTPUT_INVERTED : timerHardware->output);
+                output);
             motors[motorIndex].enabled = true;
             continue;
         }
@@ -372,28 +454,83 @@ uint32_t getDshotHz(motorPwmProtocolTypes_e pwmProtocolType)
     }
 }
 
+// the ESCs only act on settings commands that are received several times in a row
+static unsigned dshotCommandRepeats(uint8_t command)
+{
+    switch (command) {
+    case DSHOT_CMD_SPIN_DIRECTION_1:
+    case DSHOT_CMD_SPIN_DIRECTION_2:
+    case DSHOT_CMD_3D_MODE_OFF:
+    case DSHOT_CMD_3D_MODE_ON:
+    case DSHOT_CMD_SAVE_SETTINGS:
+    case DSHOT_CMD_SPIN_DIRECTION_NORMAL:
+    case DSHOT_CMD_SPIN_DIRECTION_REVERSED:
+        return 10;
+    default:
+        return 1;
+    }
+}
+
+/*
+ * Queues a command to be sent with the following motor updates, one frame at a time with
+ * DSHOT_COMMAND_INTERVAL_US in between, in place of the motor value. The motors must be
+ * stopped while commands are sent. completeFn, if set, is called from the motor update once
+ * the command has gone out, so it must be short. Returns false if the queue is full.
+ */
+bool pwmQueueDshotCommand(uint8_t index, uint8_t command, dshotCommandCompleteFnPtr completeFn)
+{
+    if (!isDshot || command > DSHOT_MAX_COMMAND) {
+        return false;
+    }
+    const uint8_t head = dshotCommandHead;
+    const uint8_t next = (head + 1) % DSHOT_COMMAND_QUEUE_SIZE;
+    if (next == dshotCommandTail) {
+        return false;
+    }
+    dshotCommandQueue[head].index = index;
+    dshotCommandQueue[head].command = command;
+    dshotCommandQueue[head].completeFn = completeFn;
+    __atomic_signal_fence(__ATOMIC_RELEASE); // the entry is complete before the motor update can see it
+    dshotCommandHead = next;
+    return true;
+}
+
+bool pwmDshotCommandQueueEmpty(void)
+{
+    return dshotCommandHead == dshotCommandTail;
+}
+
+// Called after each motor update, picks whether the next one carries a frame of the queued command
+static void dshotCommandUpdate(void)
+{
+    dshotCommandFrame = false;
+    if (dshotCommandTail == dshotCommandHead || cmpTimeUs(micros(), dshotCommandNextFrameUs) < 0) {
+        return;
+    }
+
+    const dshotCommand_t *command = &dshotCommandQueue[dshotCommandTail];
+    if (dshotCommandFramesSent == dshotCommandRepeats(command->command)) {
+        // the last frame has had its interval, so the ESCs have acted on it
+        if (command->completeFn) {
+            command->completeFn(command->index, command->command);
+        }
+        dshotCommandFramesSent = 0;
+        dshotCommandTail = (dshotCommandTail + 1) % DSHOT_COMMAND_QUEUE_SIZE;
+        return;
+    }
+
+    dshotCommandFrame = true;
+    dshotCommandFramesSent++;
+    dshotCommandNextFrameUs = micros() + DSHOT_COMMAND_INTERVAL_US;
+}
+
+// Sends a command right away, waiting between the frames. Only for use with the motor updates disabled.
 void pwmWriteDshotCommand(uint8_t index, uint8_t command)
 {
     if (isDshot && (command <= DSHOT_MAX_COMMAND)) {
         motorDmaOutput_t *const motor = getMotorDmaOutput(index);
 
-        unsigned repeats;
-        switch (command) {
-        case DSHOT_CMD_SPIN_DIRECTION_1:
-        case DSHOT_CMD_SPIN_DIRECTION_2:
-        case DSHOT_CMD_3D_MODE_OFF:
-        case DSHOT_CMD_3D_MODE_ON:
-        case DSHOT_CMD_SAVE_SETTINGS:
-        case DSHOT_CMD_SPIN_DIRECTION_NORMAL:
-        case DSHOT_CMD_SPIN_DIRECTION_REVERSED:
-            repeats = 10;
-            break;
-        default:
-            repeats = 1;
-            break;
-        }
-
-        for (; repeats; repeats--) {
+        for (unsigned repeats = dshotCommandRepeats(command); repeats; repeats--) {
             motor->requestTelemetry = true;
             pwmWriteDshotInt(index, command);
             pwmCompleteDshotMotorUpdate(0);
@@ -407,13 +544,14 @@ uint16_t prepareDshotPacket(motorDmaOutput_t *const motor, const uint16_t value)
     uint16_t packet = (value << 1) | (motor->requestTelemetry ? 1 : 0);
     motor->requestTelemetry = false;    // reset telemetry request to make sure it's triggered only once in a row
 
-    // compute checksum
-    int csum = 0;
-    int csum_data = packet;
-    for (int i = 0; i < 3; i++) {
-        csum ^=  csum_data;   // xor data by nibbles
-        csum_data >>= 4;
+    // compute checksum, the xor of the three nibbles of the packet
+    int csum = packet ^ (packet >> 4) ^ (packet >> 8);
+#ifdef USE_DSHOT_TELEMETRY
+    // an inverted checksum asks the ESC for a bidirectional reply
+    if (useDshotTelemetry) {
+        csum = ~csum;
     }
+#endif
     csum &= 0xf;
     // append checksum
     packet = (packet << 4) | csum;
@@ -480,6 +618,82 @@ void pwmToggleBeeper(void)
         pwmWriteBeeper(!beeperPwm.enabled);
 }
 
+// moves on to the next step with a length, false once the sequence has stopped
+static bool beeperPwmSequenceStep(const uint8_t *sequence)
+{
+    uint8_t pos = beeperSequencePos;
+    uint8_t length;
+    while ((length = sequence[pos]) == 0 || length == BEEPER_SEQUENCE_REPEAT) {
+        // a zero length step is skipped, repeating starts again with the first on step
+        pos = (length == BEEPER_SEQUENCE_REPEAT) ? 0 : pos + 1;
+    }
+    if (length == BEEPER_SEQUENCE_STOP) {
+        pwmWriteBeeper(false);
+        beeperSequenceOn = false;
+        beeperSequence = NULL;
+        return false;
+    }
+
+    // even steps are on and odd steps are off
+    const bool on = !(pos & 1);
+    if (beeperSequenceAudible) {
+        pwmWriteBeeper(on);
+    }
+    beeperSequenceOn = on;
+    beeperSequenceTicks = (uint32_t)length * beeperTicksPerStep;
+    beeperSequencePos = pos + 1;
+    return true;
+}
+
+static void beeperPwmOverflow(timerOvrHandlerRec_t *cbRec, captureCompare_t capture)
+{
+    UNUSED(cbRec);
+    UNUSED(capture);
+
+    const uint8_t *sequence = beeperSequence;
+    if (sequence && --beeperSequenceTicks == 0) {
+        beeperPwmSequenceStep(sequence);
+    }
+}
+
+bool beeperPwmSequenceStart(const uint8_t *sequence, bool audible)
+{
+    if (!beeperTimer) {
+        return false;
+    }
+
+    // the interrupt leaves a NULL sequence alone, so it can not step this one while it is set up
+    beeperSequence = NULL;
+    pwmWriteBeeper(false);
+    beeperSequenceAudible = audible;
+    beeperSequencePos = 0;
+    if (beeperPwmSequenceStep(sequence)) {
+        beeperSequence = sequence;
+        timerChConfigCallbacks(beeperTimer, NULL, &beeperOverflowCb);
+    }
+    return true;
+}
+
+void beeperPwmSequenceStop(void)
+{
+    beeperSequence = NULL;
+    if (beeperTimer) {
+        timerChConfigCallbacks(beeperTimer, NULL, NULL);
+    }
+    pwmWriteBeeper(false);
+    beeperSequenceOn = false;
+}
+
+bool beeperPwmSequenceIsActive(void)
+{
+    return beeperSequence != NULL;
+}
+
+bool beeperPwmSequenceIsOn(void)
+{
+    return beeperSequenceOn;
+}
+
 void beeperPwmInit(const ioTag_t tag, uint16_t frequency)
 {
         beeperPwm.io = IOGetByTag(tag);
@@ -492,7 +706,13 @@ void beeperPwmInit(const ioTag_t tag, uint16_t frequency)
             IOConfigGPIO(beeperPwm.io, IOCFG_AF_PP);
 #endif
             freqBeep = frequency;
-            pwmOutConfig(&beeperPwm.channel, timer, PWM_TIMER_1MHZ, PWM_TIMER_1MHZ / freqBeep, (PWM_TIMER_1MHZ / freqBeep) / 2, 0);
+            const uint16_t period = PWM_TIMER_1MHZ / freqBeep;
+            // also enables the timer interrupt the sequences are counted in
+            timerConfigure(timer, period, PWM_TIMER_1MHZ);
+            pwmOutConfig(&beeperPwm.channel, timer, PWM_TIMER_1MHZ, period, period / 2, 0);
+            timerChOvrHandlerInit(&beeperOverflowCb, beeperPwmOverflow);
+            beeperTimer = timer;
+            beeperTicksPerStep = MAX(10000 / period, 1);
         }
         *beeperPwm.channel.ccr = 0;
         beeperPwm.enabled = false;
@@ -99,11 +99,21 @@ typedef enum {
 
 
 #define DSHOT_DMA_BUFFER_SIZE   18 /* resolution + frame reset (2us) */
+#ifdef USE_DSHOT_TELEMETRY
+#include "drivers/dshot.h"
+#endif
 #define PROSHOT_DMA_BUFFER_SIZE 6  /* resolution + frame reset (2us) */
 
 typedef struct {
     TIM_TypeDef *timer;
     uint16_t timerDmaSources;
+#ifdef USE_DSHOT_DMAR
+    DMA_Stream_TypeDef *dmaBurstRef;    // the update request stream, NULL if each channel has its own stream
+    uint8_t dmaBurstFirstChannel;       // channel index of the first compare register written by a burst
+    uint8_t dmaBurstChannelCount;       // compare registers written per update
+    uint16_t dmaBurstLength;
+    uint32_t dmaBurstBuffer[DSHOT_DMA_BUFFER_SIZE * 4];  // interleaved compare values of the timer channels
+#endif
 } motorDmaTimer_t;
 
 typedef struct {
@@ -111,12 +121,22 @@ typedef struct {
     const timerHardware_t *timerHardware;
     uint16_t value;
     uint16_t timerDmaSource;
+#ifdef USE_DSHOT_DMAR
+    uint8_t timerIndex;
+#endif
     volatile bool requestTelemetry;
 #if defined(STM32F3) || defined(STM32F4) || defined(STM32F7)
     uint32_t dmaBuffer[DSHOT_DMA_BUFFER_SIZE];
 #else
     uint8_t dmaBuffer[DSHOT_DMA_BUFFER_SIZE];
 #endif
+#ifdef USE_DSHOT_TELEMETRY
+    uint8_t output;                     // TIMER_OUTPUT_* flags the channel was configured with
+    volatile bool isInput;              // capturing the reply of the ESC
+    uint16_t telemetryValue;            // eRPM / 100
+    uint8_t telemetryAge;               // frames since the last valid reply, saturating
+    uint32_t dmaInputBuffer[DSHOT_TELEMETRY_INPUT_LEN];
+#endif
 #if defined(STM32F7)
     TIM_HandleTypeDef TimHandle;
     DMA_HandleTypeDef hdma_tim;
@@ -149,6 +169,8 @@ typedef struct motorDevConfig_s {
     uint8_t  motorPwmInversion;             // Active-High vs Active-Low. Useful for brushed FCs converted for brushless operation
     uint8_t  useUnsyncedPwm;
     ioTag_t  ioTags[MAX_SUPPORTED_MOTORS];
+    uint8_t  useDshotTelemetry;             // Bidirectional DShot, the ESC replies with its eRPM on the motor line
+    uint8_t  useBurstDshot;                 // One DMA burst per timer for all of its motors, instead of a stream per motor
 } motorDevConfig_t;
 
 void motorDevInit(const motorDevConfig_t *motorDevConfig, uint16_t idlePulse, uint8_t motorCount);
@@ -173,17 +195,40 @@ uint16_t prepareDshotPacket(motorDmaOutput_t *const motor, uint16_t value);
 
 extern loadDmaBufferFunc *loadDmaBuffer;
 
+#define DSHOT_ALL_MOTORS 255
+
+typedef void (*dshotCommandCompleteFnPtr)(uint8_t index, uint8_t command);
+
 uint32_t getDshotHz(motorPwmProtocolTypes_e pwmProtocolType);
+bool pwmQueueDshotCommand(uint8_t index, uint8_t command, dshotCommandCompleteFnPtr completeFn);
+bool pwmDshotCommandQueueEmpty(void);
 void pwmWriteDshotCommand(uint8_t index, uint8_t command);
 void pwmWriteDshotInt(uint8_t index, uint16_t value);
 void pwmDshotMotorHardwareConfig(const timerHardware_t *timerHardware, uint8_t motorIndex, motorPwmProtocolTypes_e pwmProtocolType, uint8_t output);
 void pwmCompleteDshotMotorUpdate(uint8_t motorCount);
 #endif
 
+#ifdef USE_DSHOT_DMAR
+extern bool useBurstDshot;
+#endif
+
+#ifdef USE_DSHOT_TELEMETRY
+extern bool useDshotTelemetry;
+
+bool isDshotTelemetryActive(void);
+uint16_t getDshotTelemetry(uint8_t index);
+uint8_t getDshotTelemetryAge(uint8_t index);
+void pwmDshotResetTimers(void);
+#endif
+
 #ifdef BEEPER
 void pwmWriteBeeper(bool onoffBeep);
 void pwmToggleBeeper(void);
 void beeperPwmInit(const ioTag_t tag, uint16_t frequency);
+bool beeperPwmSequenceStart(const uint8_t *sequence, bool audible);
+void beeperPwmSequenceStop(void);
+bool beeperPwmSequenceIsActive(void);
+bool beeperPwmSequenceIsOn(void);
 #endif
 void pwmOutConfig(timerChannel_t *channel, const timerHardware_t *timerHardware, uint32_t hz, uint16_t period, uint16_t value, uint8_t inversion);
 
@@ -16,12 +16,16 @@
  */
 #include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
 #include <math.h>
 
 #include "platform.h"
 
 #ifdef USE_DSHOT
 
+#include "common/maths.h"
+#include "common/utils.h"
+
 #include "drivers/io.h"
 #include "timer.h"
 #if defined(STM32F4)
@@ -36,6 +40,7 @@
 
 static uint8_t dmaMotorTimerCount = 0;
 static motorDmaTimer_t dmaMotorTimers[MAX_DMA_TIMERS];
+// not FAST_RAM, the DMA can not reach the CCM of the F4
 static motorDmaOutput_t dmaMotors[MAX_SUPPORTED_MOTORS];
 
 motorDmaOutput_t *getMotorDmaOutput(uint8_t index)
@@ -54,14 +59,301 @@ uint8_t getTimerIndex(TIM_TypeDef *timer)
     return dmaMotorTimerCount-1;
 }
 
+static void pwmDshotOCConfig(const timerHardware_t *timerHardware, uint8_t output)
+{
+    TIM_OCInitTypeDef TIM_OCInitStructure;
+
+    TIM_OCStructInit(&TIM_OCInitStructure);
+    TIM_OCInitStructure.TIM_OCMode = TIM_OCMode_PWM1;
+    if (output & TIMER_OUTPUT_N_CHANNEL) {
+        TIM_OCInitStructure.TIM_OutputNState = TIM_OutputNState_Enable;
+        TIM_OCInitStructure.TIM_OCNIdleState = TIM_OCNIdleState_Reset;
+        TIM_OCInitStructure.TIM_OCNPolarity = (output & TIMER_OUTPUT_INVERTED) ? TIM_OCNPolarity_Low : TIM_OCNPolarity_High;
+    } else {
+        TIM_OCInitStructure.TIM_OutputState = TIM_OutputState_Enable;
+        TIM_OCInitStructure.TIM_OCIdleState = TIM_OCIdleState_Set;
+        TIM_OCInitStructure.TIM_OCPolarity =  (output & TIMER_OUTPUT_INVERTED) ? TIM_OCPolarity_Low : TIM_OCPolarity_High;
+    }
+    TIM_OCInitStructure.TIM_Pulse = 0;
+
+    timerOCInit(timerHardware->tim, timerHardware->channel, &TIM_OCInitStructure);
+    timerOCPreloadConfig(timerHardware->tim, timerHardware->channel, TIM_OCPreload_Enable);
+}
+
+static void pwmDshotDmaConfig(motorDmaOutput_t *const motor, uint32_t bufferSize)
+{
+    const timerHardware_t *timerHardware = motor->timerHardware;
+    DMA_InitTypeDef DMA_InitStructure;
+
+#if defined(STM32F3)
+    DMA_Channel_TypeDef *dmaRef = timerHardware->dmaRef;
+#elif defined(STM32F4)
+    DMA_Stream_TypeDef *dmaRef = timerHardware->dmaRef;
+#else
+#error "No MCU specified in DSHOT"
+#endif
+
+    DMA_Cmd(dmaRef, DISABLE);
+    DMA_DeInit(dmaRef);
+
+    DMA_StructInit(&DMA_InitStructure);
+#if defined(STM32F3)
+    DMA_InitStructure.DMA_MemoryBaseAddr = (uint32_t)motor->dmaBuffer;
+    DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralDST;
+    DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
+#elif defined(STM32F4)
+    DMA_InitStructure.DMA_Channel = timerHardware->dmaChannel;
+    DMA_InitStructure.DMA_Memory0BaseAddr = (uint32_t)motor->dmaBuffer;
+    DMA_InitStructure.DMA_DIR = DMA_DIR_MemoryToPeripheral;
+    DMA_InitStructure.DMA_FIFOMode = DMA_FIFOMode_Enable;
+    DMA_InitStructure.DMA_FIFOThreshold = DMA_FIFOThreshold_1QuarterFull;
+    DMA_InitStructure.DMA_MemoryBurst = DMA_MemoryBurst_Single;
+    DMA_InitStructure.DMA_PeripheralBurst = DMA_PeripheralBurst_Single;
+#endif
+    DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32_t)timerChCCR(timerHardware);
+    DMA_InitStructure.DMA_BufferSize = bufferSize;
+    DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+    DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+    DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Word;
+    DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_Word;
+    DMA_InitStructure.DMA_Mode = DMA_Mode_Normal;
+    DMA_InitStructure.DMA_Priority = DMA_Priority_High;
+
+    DMA_Init(dmaRef, &DMA_InitStructure);
+    DMA_ITConfig(dmaRef, DMA_IT_TC, ENABLE);
+}
+
+#ifdef USE_DSHOT_TELEMETRY
+/*
+ * Bidirectional DShot: once a frame is out the channel is switched to input capture, and the DMA stream
+ * stores the counter at every edge of the reply into dmaInputBuffer. The channel is switched back to output,
+ * and the reply decoded, when the next frame is written. The complementary outputs cannot capture, so
+ * motors on them get no telemetry.
+ */
+static bool pwmDshotCanReceive(const motorDmaOutput_t *motor)
+{
+    return !(motor->output & TIMER_OUTPUT_N_CHANNEL);
+}
+
+static void pwmDshotSetDirectionInput(motorDmaOutput_t *const motor)
+{
+    const timerHardware_t *timerHardware = motor->timerHardware;
+    TIM_TypeDef *timer = timerHardware->tim;
+    DMA_Stream_TypeDef *dmaRef = timerHardware->dmaRef;
+
+    // all channels of the timer finish their frames together, so the counter can run free from the next update
+    timer->ARR = 0xffff;
+
+    TIM_ICInitTypeDef TIM_ICInitStructure;
+    TIM_ICStructInit(&TIM_ICInitStructure);
+    TIM_ICInitStructure.TIM_Channel = timerHardware->channel;
+    TIM_ICInitStructure.TIM_ICPolarity = TIM_ICPolarity_BothEdge;
+    TIM_ICInitStructure.TIM_ICSelection = TIM_ICSelection_DirectTI;
+    TIM_ICInitStructure.TIM_ICPrescaler = TIM_ICPSC_DIV1;
+    TIM_ICInitStructure.TIM_ICFilter = 2;
+    TIM_ICInit(timer, &TIM_ICInitStructure);
+
+    DMA_InitTypeDef DMA_InitStructure;
+    DMA_DeInit(dmaRef);
+    DMA_StructInit(&DMA_InitStructure);
+    DMA_InitStructure.DMA_Channel = timerHardware->dmaChannel;
+    DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32_t)timerChCCR(timerHardware);
+    DMA_InitStructure.DMA_Memory0BaseAddr = (uint32_t)motor->dmaInputBuffer;
+    DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralToMemory;
+    DMA_InitStructure.DMA_BufferSize = DSHOT_TELEMETRY_INPUT_LEN;
+    DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+    DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+    DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Word;
+    DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_Word;
+    DMA_InitStructure.DMA_Mode = DMA_Mode_Normal;
+    DMA_InitStructure.DMA_Priority = DMA_Priority_High;
+    DMA_Init(dmaRef, &DMA_InitStructure);
+
+    motor->isInput = true;
+    DMA_Cmd(dmaRef, ENABLE);
+    TIM_DMACmd(timer, motor->timerDmaSource, ENABLE);
+}
+
+static void pwmDshotSetDirectionOutput(motorDmaOutput_t *const motor)
+{
+    const timerHardware_t *timerHardware = motor->timerHardware;
+    TIM_TypeDef *timer = timerHardware->tim;
+
+    TIM_DMACmd(timer, motor->timerDmaSource, DISABLE);
+
+    pwmDshotOCConfig(timerHardware, motor->output);
+    // CCxNP is only cleared on the advanced timers, and must be clear for output on the others
+    timer->CCER &= ~(TIM_CCER_CC1NP << timerHardware->channel);
+    timer->ARR = MOTOR_BITLENGTH;
+    // load the period and the idle compare value now, the counter is still running free
+    TIM_GenerateEvent(timer, TIM_EventSource_Update);
+
+    pwmDshotDmaConfig(motor, DSHOT_DMA_BUFFER_SIZE);
+    motor->isInput = false;
+}
+
+static void pwmDshotReadTelemetry(motorDmaOutput_t *const motor)
+{
+    const int edgeCount = DSHOT_TELEMETRY_INPUT_LEN - DMA_GetCurrDataCounter(motor->timerHardware->dmaRef);
+    const uint32_t value = dshotDecodeTelemetry(motor->dmaInputBuffer, edgeCount, MOTOR_BITLENGTH + 1);
+    if (value != DSHOT_TELEMETRY_INVALID) {
+        motor->telemetryValue = value;
+        motor->telemetryAge = 0;
+    } else if (motor->telemetryAge < UINT8_MAX) {
+        motor->telemetryAge++;
+    }
+}
+
+bool isDshotTelemetryActive(void)
+{
+    return useDshotTelemetry;
+}
+
+uint16_t getDshotTelemetry(uint8_t index)
+{
+    return dmaMotors[index].telemetryValue;
+}
+
+uint8_t getDshotTelemetryAge(uint8_t index)
+{
+    return dmaMotors[index].telemetryAge;
+}
+
+// Stops the motor streams and forgets the timers, so that motorDevInit() can set them up again at another rate
+void pwmDshotResetTimers(void)
+{
+    for (int i = 0; i < MAX_SUPPORTED_MOTORS; i++) {
+        const timerHardware_t *timerHardware = dmaMotors[i].timerHardware;
+        if (timerHardware && timerHardware->dmaRef) {
+            DMA_Cmd(timerHardware->dmaRef, DISABLE);
+        }
+    }
+    for (int i = 0; i < dmaMotorTimerCount; i++) {
+#ifdef USE_DSHOT_DMAR
+        if (dmaMotorTimers[i].dmaBurstRef) {
+            DMA_Cmd(dmaMotorTimers[i].dmaBurstRef, DISABLE);
+        }
+#endif
+        TIM_DMACmd(dmaMotorTimers[i].timer, dmaMotorTimers[i].timerDmaSources | TIM_DMA_Update, DISABLE);
+    }
+
+    memset(dmaMotorTimers, 0, sizeof(dmaMotorTimers));
+    dmaMotorTimerCount = 0;
+}
+#endif
+
+#ifdef USE_DSHOT_DMAR
+/*
+ * Burst mode: the compare values of all motors on a timer are interleaved into one buffer, and the update
+ * request of the timer writes them to its compare registers through TIMx_DMAR, one set per DShot bit.
+ * That is one stream and one interrupt per timer, and the channel streams are left for other peripherals.
+ */
+static void motor_DMAR_IRQHandler(dmaChannelDescriptor_t *descriptor)
+{
+    if (DMA_GET_FLAG_STATUS(descriptor, DMA_IT_TCIF)) {
+        motorDmaTimer_t *const burstTimer = &dmaMotorTimers[descriptor->userParam];
+        DMA_Cmd(burstTimer->dmaBurstRef, DISABLE);
+        TIM_DMACmd(burstTimer->timer, TIM_DMA_Update, DISABLE);
+        DMA_CLEAR_FLAG(descriptor, DMA_IT_TCIF);
+    }
+}
+
+static void pwmDshotBurstConfig(motorDmaTimer_t *const burstTimer, uint8_t timerIndex, uint8_t motorIndex)
+{
+    uint32_t dmaChannel;
+    DMA_Stream_TypeDef *dmaRef = timerUpDmaRef(burstTimer->timer, &dmaChannel);
+    if (!dmaRef) {
+        return;
+    }
+    const dmaIdentifier_e dmaIdentifier = dmaGetIdentifier(dmaRef);
+    if (dmaGetOwner(dmaIdentifier) != OWNER_FREE) {
+        // fall back to a stream per channel
+        return;
+    }
+
+    dmaInit(dmaIdentifier, OWNER_MOTOR, RESOURCE_INDEX(motorIndex));
+    dmaSetHandler(dmaIdentifier, motor_DMAR_IRQHandler, NVIC_BUILD_PRIORITY(1, 2), timerIndex);
+
+    DMA_InitTypeDef DMA_InitStructure;
+    DMA_Cmd(dmaRef, DISABLE);
+    DMA_DeInit(dmaRef);
+    DMA_StructInit(&DMA_InitStructure);
+    DMA_InitStructure.DMA_Channel = dmaChannel;
+    DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32_t)&burstTimer->timer->DMAR;
+    DMA_InitStructure.DMA_Memory0BaseAddr = (uint32_t)burstTimer->dmaBurstBuffer;
+    DMA_InitStructure.DMA_DIR = DMA_DIR_MemoryToPeripheral;
+    DMA_InitStructure.DMA_FIFOMode = DMA_FIFOMode_Enable;
+    DMA_InitStructure.DMA_FIFOThreshold = DMA_FIFOThreshold_Full;
+    DMA_InitStructure.DMA_MemoryBurst = DMA_MemoryBurst_Single;
+    DMA_InitStructure.DMA_PeripheralBurst = DMA_PeripheralBurst_Single;
+    DMA_InitStructure.DMA_BufferSize = ARRAYLEN(burstTimer->dmaBurstBuffer);
+    DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+    DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+    DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Word;
+    DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_Word;
+    DMA_InitStructure.DMA_Mode = DMA_Mode_Normal;
+    DMA_InitStructure.DMA_Priority = DMA_Priority_High;
+    DMA_Init(dmaRef, &DMA_InitStructure);
+    DMA_ITConfig(dmaRef, DMA_IT_TC, ENABLE);
+
+    burstTimer->dmaBurstRef = dmaRef;
+    burstTimer->dmaBurstChannelCount = 0;
+}
+
+// Widens the burst of the timer to the compare register of the channel.
+static void pwmDshotBurstAddChannel(motorDmaTimer_t *const burstTimer, uint8_t channel)
+{
+    // TIM_Channel_1 to TIM_Channel_4 are 0, 4, 8 and 12, the compare registers are consecutive
+    const uint8_t channelIndex = channel >> 2;
+    if (burstTimer->dmaBurstChannelCount == 0) {
+        burstTimer->dmaBurstFirstChannel = channelIndex;
+        burstTimer->dmaBurstChannelCount = 1;
+    } else {
+        const uint8_t last = MAX(burstTimer->dmaBurstFirstChannel + burstTimer->dmaBurstChannelCount - 1, channelIndex);
+        burstTimer->dmaBurstFirstChannel = MIN(burstTimer->dmaBurstFirstChannel, channelIndex);
+        burstTimer->dmaBurstChannelCount = last - burstTimer->dmaBurstFirstChannel + 1;
+    }
+    TIM_DMAConfig(burstTimer->timer, TIM_DMABase_CCR1 + burstTimer->dmaBurstFirstChannel, (burstTimer->dmaBurstChannelCount - 1) << 8);
+}
+
+static void pwmDshotBurstLoad(motorDmaOutput_t *const motor, uint8_t bufferSize)
+{
+    motorDmaTimer_t *const burstTimer = &dmaMotorTimers[motor->timerIndex];
+    const uint8_t stride = burstTimer->dmaBurstChannelCount;
+    uint32_t *burst = &burstTimer->dmaBurstBuffer[(motor->timerHardware->channel >> 2) - burstTimer->dmaBurstFirstChannel];
+    for (int i = 0; i < bufferSize; i++) {
+        burst[i * stride] = motor->dmaBuffer[i];
+    }
+    burstTimer->dmaBurstLength = bufferSize * stride;
+}
+#endif
+
 void pwmWriteDshotInt(uint8_t index, uint16_t value)
 {
     motorDmaOutput_t *const motor = &dmaMotors[index];
 
-    if (!motor->timerHardware || !motor->timerHardware->dmaRef) {
+    if (!motor->timerHardware) {
+        return;
+    }
+
+#ifdef USE_DSHOT_DMAR
+    if (dmaMotorTimers[motor->timerIndex].dmaBurstRef) {
+        pwmDshotBurstLoad(motor, loadDmaBuffer(motor, prepareDshotPacket(motor, value)));
+        return;
+    }
+#endif
+
+    if (!motor->timerHardware->dmaRef) {
         return;
     }
 
+#ifdef USE_DSHOT_TELEMETRY
+    if (motor->isInput) {
+        pwmDshotReadTelemetry(motor);
+        pwmDshotSetDirectionOutput(motor);
+    }
+#endif
+
     uint16_t packet = prepareDshotPacket(motor, value);
 
     uint8_t bufferSize = loadDmaBuffer(motor, packet);
@@ -75,6 +367,16 @@ void pwmCompleteDshotMotorUpdate(uint8_t motorCount)
     UNUSED(motorCount);
 
     for (int i = 0; i < dmaMotorTimerCount; i++) {
+#ifdef USE_DSHOT_DMAR
+        motorDmaTimer_t *const burstTimer = &dmaMotorTimers[i];
+        if (burstTimer->dmaBurstRef) {
+            DMA_SetCurrDataCounter(burstTimer->dmaBurstRef, burstTimer->dmaBurstLength);
+            DMA_Cmd(burstTimer->dmaBurstRef, ENABLE);
+            TIM_SetCounter(burstTimer->timer, 0);
+            TIM_DMACmd(burstTimer->timer, TIM_DMA_Update, ENABLE);
+            continue;
+        }
+#endif
         TIM_SetCounter(dmaMotorTimers[i].timer, 0);
         TIM_DMACmd(dmaMotorTimers[i].timer, dmaMotorTimers[i].timerDmaSources, ENABLE);
     }
@@ -87,16 +389,24 @@ static void motor_DMA_IRQHandler(dmaChannelDescriptor_t *descriptor)
         DMA_Cmd(motor->timerHardware->dmaRef, DISABLE);
         TIM_DMACmd(motor->timerHardware->tim, motor->timerDmaSource, DISABLE);
         DMA_CLEAR_FLAG(descriptor, DMA_IT_TCIF);
+#ifdef USE_DSHOT_TELEMETRY
+        if (useDshotTelemetry && pwmDshotCanReceive(motor)) {
+            pwmDshotSetDirectionInput(motor);
+        }
+#endif
     }
 }
 
 void pwmDshotMotorHardwareConfig(const timerHardware_t *timerHardware, uint8_t motorIndex, motorPwmProtocolTypes_e pwmProtocolType, uint8_t output)
 {
-    TIM_OCInitTypeDef TIM_OCInitStructure;
-    DMA_InitTypeDef DMA_InitStructure;
-
     motorDmaOutput_t * const motor = &dmaMotors[motorIndex];
     motor->timerHardware = timerHardware;
+#ifdef USE_DSHOT_TELEMETRY
+    motor->output = output;
+    motor->isInput = false;
+    // nothing received yet
+    motor->telemetryAge = UINT8_MAX;
+#endif
 
     TIM_TypeDef *timer = timerHardware->tim;
     const IO_t motorIO = IOGetByTag(timerHardware->tag);
@@ -122,21 +432,7 @@ void pwmDshotMotorHardwareConfig(const timerHardware_t *timerHardware, uint8_t m
         TIM_TimeBaseInit(timer, &TIM_TimeBaseStructure);
     }
 
-    TIM_OCStructInit(&TIM_OCInitStructure);
-    TIM_OCInitStructure.TIM_OCMode = TIM_OCMode_PWM1;
-    if (output & TIMER_OUTPUT_N_CHANNEL) {
-        TIM_OCInitStructure.TIM_OutputNState = TIM_OutputNState_Enable;
-        TIM_OCInitStructure.TIM_OCNIdleState = TIM_OCNIdleState_Reset;
-        TIM_OCInitStructure.TIM_OCNPolarity = (output & TIMER_OUTPUT_INVERTED) ? TIM_OCNPolarity_Low : TIM_OCNPolarity_High;
-    } else {
-        TIM_OCInitStructure.TIM_OutputState = TIM_OutputState_Enable;
-        TIM_OCInitStructure.TIM_OCIdleState = TIM_OCIdleState_Set;
-        TIM_OCInitStructure.TIM_OCPolarity =  (output & TIMER_OUTPUT_INVERTED) ? TIM_OCPolarity_Low : TIM_OCPolarity_High;
-    }
-    TIM_OCInitStructure.TIM_Pulse = 0;
-
-    timerOCInit(timer, timerHardware->channel, &TIM_OCInitStructure);
-    timerOCPreloadConfig(timer, timerHardware->channel, TIM_OCPreload_Enable);
+    pwmDshotOCConfig(timerHardware, output);
     motor->timerDmaSource = timerDmaSource(timerHardware->channel);
     dmaMotorTimers[timerIndex].timerDmaSources |= motor->timerDmaSource;
 
@@ -148,49 +444,25 @@ void pwmDshotMotorHardwareConfig(const timerHardware_t *timerHardware, uint8_t m
         TIM_Cmd(timer, ENABLE);
     }
 
-#if defined(STM32F3)
-    DMA_Channel_TypeDef *dmaRef = timerHardware->dmaRef;
-#elif defined(STM32F4)
-    DMA_Stream_TypeDef *dmaRef = timerHardware->dmaRef;
-#else
-#error "No MCU specified in DSHOT"
+#ifdef USE_DSHOT_DMAR
+    motor->timerIndex = timerIndex;
+    if (configureTimer && useBurstDshot) {
+        pwmDshotBurstConfig(&dmaMotorTimers[timerIndex], timerIndex, motorIndex);
+    }
+    if (dmaMotorTimers[timerIndex].dmaBurstRef) {
+        pwmDshotBurstAddChannel(&dmaMotorTimers[timerIndex], timerHardware->channel);
+        return;
+    }
 #endif
 
-    if (dmaRef == NULL) {
+    if (timerHardware->dmaRef == NULL) {
         return;
     }
 
     dmaInit(timerHardware->dmaIrqHandler, OWNER_MOTOR, RESOURCE_INDEX(motorIndex));
     dmaSetHandler(timerHardware->dmaIrqHandler, motor_DMA_IRQHandler, NVIC_BUILD_PRIORITY(1, 2), motorIndex);
 
-    DMA_Cmd(dmaRef, DISABLE);
-    DMA_DeInit(dmaRef);
-
-    DMA_StructInit(&DMA_InitStructure);
-#if defined(STM32F3)
-    DMA_InitStructure.DMA_MemoryBaseAddr = (uint32_t)motor->dmaBuffer;
-    DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralDST;
-    DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
-#elif defined(STM32F4)
-    DMA_InitStructure.DMA_Channel = timerHardware->dmaChannel;
-    DMA_InitStructure.DMA_Memory0BaseAddr = (uint32_t)motor->dmaBuffer;
-    DMA_InitStructure.DMA_DIR = DMA_DIR_MemoryToPeripheral;
-    DMA_InitStructure.DMA_FIFOMode = DMA_FIFOMode_Enable;
-    DMA_InitStructure.DMA_FIFOThreshold = DMA_FIFOThreshold_1QuarterFull;
-    DMA_InitStructure.DMA_MemoryBurst = DMA_MemoryBurst_Single;
-    DMA_InitStructure.DMA_PeripheralBurst = DMA_PeripheralBurst_Single;
-#endif
-    DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32_t)timerChCCR(timerHardware);
-    DMA_InitStructure.DMA_BufferSize = pwmProtocolType == PWM_TYPE_PROSHOT1000 ? PROSHOT_DMA_BUFFER_SIZE : DSHOT_DMA_BUFFER_SIZE;
-    DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
-    DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
-    DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Word;
-    DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_Word;
-    DMA_InitStructure.DMA_Mode = DMA_Mode_Normal;
-    DMA_InitStructure.DMA_Priority = DMA_Priority_High;
-
-    DMA_Init(dmaRef, &DMA_InitStructure);
-    DMA_ITConfig(dmaRef, DMA_IT_TC, ENABLE);
+    pwmDshotDmaConfig(motor, pwmProtocolType == PWM_TYPE_PROSHOT1000 ? PROSHOT_DMA_BUFFER_SIZE : DSHOT_DMA_BUFFER_SIZE);
 }
 
 #endif
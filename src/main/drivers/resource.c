@@ -66,5 +66,10 @@ const char * const ownerNames[OWNER_TOTAL_COUNT] = {
     "RX_BIND_PLUG",
     "ESCSERIAL",
     "CAMERA_CONTROL",
+    "SERIAL_CTS",
+    "FLASH",
+    "RX_SPI_EXTI",
+    "OSD_VSYNC",
+    "SPI_DMA",
 };
 
@@ -66,6 +66,11 @@ typedef enum {
     OWNER_RX_BIND_PLUG,
     OWNER_ESCSERIAL,
     OWNER_CAMERA_CONTROL,
+    OWNER_SERIAL_CTS,
+    OWNER_FLASH,
+    OWNER_RX_SPI_EXTI,
+    OWNER_OSD_VSYNC,
+    OWNER_SPI_DMA,
     OWNER_TOTAL_COUNT
 } resourceOwner_e;
 
@@ -211,16 +211,32 @@ void NRF24L01_SetChannel(uint8_t channel)
 
 bool NRF24L01_ReadPayloadIfAvailable(uint8_t *data, uint8_t length)
 {
+    // the RX FIFO holds up to three packets, but the IRQ line only signals new arrivals
+    static bool rxFifoMayHoldPacket = false;
+
+    if (!rxFifoMayHoldPacket && !rxSpiIrqAsserted()) {
+        return false;
+    }
     if (NRF24L01_ReadReg(NRF24L01_17_FIFO_STATUS) & BV(NRF24L01_17_FIFO_STATUS_RX_EMPTY)) {
+        rxFifoMayHoldPacket = false;
         return false;
     }
     NRF24L01_ReadPayload(data, length);
+    // release the IRQ line, the FIFO is checked again on the next call
+    NRF24L01_WriteReg(NRF24L01_07_STATUS, BV(NRF24L01_07_STATUS_RX_DR) | BV(NRF24L01_07_STATUS_TX_DS));
+    rxFifoMayHoldPacket = true;
     return true;
 }
 
 #ifndef UNIT_TEST
+#ifdef RX_SPI_INSTANCE
+// Select through the bus helpers, so the gyro data ready interrupt can see the radio has the bus
+#define DISABLE_RX()    {spiBusDeselectDevice(RX_SPI_INSTANCE, DEFIO_IO(RX_NSS_PIN));}
+#define ENABLE_RX()     {spiBusSelectDevice(RX_SPI_INSTANCE, DEFIO_IO(RX_NSS_PIN));}
+#else
 #define DISABLE_RX()    {IOHi(DEFIO_IO(RX_NSS_PIN));}
 #define ENABLE_RX()     {IOLo(DEFIO_IO(RX_NSS_PIN));}
+#endif
 /*
  * Fast read of payload, for use in interrupt service routine
  */
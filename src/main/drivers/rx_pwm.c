@@ -27,6 +27,7 @@
 
 #include "common/utils.h"
 
+#include "drivers/dma.h"
 #include "drivers/nvic.h"
 #include "drivers/io.h"
 #include "timer.h"
@@ -110,8 +111,15 @@ ppmDevice_t ppmDev;
 #define PPM_IN_MIN_NUM_CHANNELS     4
 #define PPM_IN_MAX_NUM_CHANNELS     PWM_PORTS_OR_PPM_CAPTURE_COUNT
 
+#ifdef USE_PPM_DMA
+static void ppmDmaProcess(void);
+#endif
+
 bool isPPMDataBeingReceived(void)
 {
+#ifdef USE_PPM_DMA
+    ppmDmaProcess();
+#endif
     return (ppmFrameCount != lastPPMFrameCount);
 }
 
@@ -161,6 +169,8 @@ static void ppmResetDevice(void)
     ppmDev.overflowed   = false;
 }
 
+static void ppmDecodePulse(void);
+
 static void ppmOverflowCallback(timerOvrHandlerRec_t* cbRec, captureCompare_t capture)
 {
     UNUSED(cbRec);
@@ -177,8 +187,6 @@ static void ppmEdgeCallback(timerCCHandlerRec_t* cbRec, captureCompare_t capture
     UNUSED(cbRec);
     ppmISREvent(SOURCE_EDGE, capture);
 
-    int32_t i;
-
     uint32_t previousTime = ppmDev.currentTime;
     uint32_t previousCapture = ppmDev.currentCapture;
 
@@ -211,6 +219,86 @@ static void ppmEdgeCallback(timerCCHandlerRec_t* cbRec, captureCompare_t capture
     ppmDev.currentTime = currentTime;
     ppmDev.currentCapture = capture;
 
+    ppmDecodePulse();
+}
+
+#ifdef USE_PPM_DMA
+#define PPM_DMA_BUFFER_SIZE 64     // rising edge timestamps, about seven frames of eight channels
+
+static volatile uint16_t ppmDmaBuffer[PPM_DMA_BUFFER_SIZE];
+static const timerHardware_t *ppmDmaTimer;
+static uint8_t ppmDmaReadIndex;
+static uint16_t ppmDmaLastCapture;
+
+/*
+ * Let the DMA copy each capture into a circular buffer instead of taking an interrupt per edge.
+ * Only used with the 1MHz timer to itself, so the difference of two 16 bit timestamps is the pulse width.
+ */
+static bool ppmDmaInit(const timerHardware_t *timer)
+{
+    if (!timer->dmaRef || ppmCountDivisor != 1 || !dmaAllocate(timer->dmaIrqHandler, OWNER_PPMINPUT, 0)) {
+        return false;
+    }
+
+    DMA_InitTypeDef DMA_InitStructure;
+
+    DMA_Cmd(timer->dmaRef, DISABLE);
+    DMA_DeInit(timer->dmaRef);
+    DMA_StructInit(&DMA_InitStructure);
+    DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32_t)timerCCR(timer->tim, timer->channel);
+    DMA_InitStructure.DMA_BufferSize = PPM_DMA_BUFFER_SIZE;
+    DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+    DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+    DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_HalfWord;
+    DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_HalfWord;
+    DMA_InitStructure.DMA_Mode = DMA_Mode_Circular;
+    DMA_InitStructure.DMA_Priority = DMA_Priority_Medium;
+#if defined(STM32F4)
+    DMA_InitStructure.DMA_Channel = timer->dmaChannel;
+    DMA_InitStructure.DMA_Memory0BaseAddr = (uint32_t)ppmDmaBuffer;
+    DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralToMemory;
+#else
+    DMA_InitStructure.DMA_MemoryBaseAddr = (uint32_t)ppmDmaBuffer;
+    DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralSRC;
+    DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
+#endif
+    DMA_Init(timer->dmaRef, &DMA_InitStructure);
+
+    ppmDmaReadIndex = 0;
+    ppmDmaTimer = timer;
+
+    DMA_Cmd(timer->dmaRef, ENABLE);
+    TIM_DMACmd(timer->tim, timerDmaSource(timer->channel), ENABLE);
+
+    return true;
+}
+
+// Decode the edges captured since the last call, from the RX task
+static void ppmDmaProcess(void)
+{
+    if (!ppmDmaTimer) {
+        return;
+    }
+
+    const uint8_t writeIndex = (PPM_DMA_BUFFER_SIZE - DMA_GetCurrDataCounter(ppmDmaTimer->dmaRef)) % PPM_DMA_BUFFER_SIZE;
+
+    while (ppmDmaReadIndex != writeIndex) {
+        const uint16_t capture = ppmDmaBuffer[ppmDmaReadIndex];
+        ppmDmaReadIndex = (ppmDmaReadIndex + 1) % PPM_DMA_BUFFER_SIZE;
+
+        ppmDev.deltaTime = (uint16_t)(capture - ppmDmaLastCapture);
+        ppmDmaLastCapture = capture;
+
+        ppmDecodePulse();
+    }
+}
+#endif
+
+// Runs the frame state machine on the pulse width in ppmDev.deltaTime
+static void ppmDecodePulse(void)
+{
+    int32_t i;
+
     /* Sync pulse detection */
     if (ppmDev.deltaTime > PPM_IN_MIN_SYNC_PULSE_US) {
         if (ppmDev.pulseIndex == ppmDev.numChannelsPrevFrame
@@ -449,9 +537,14 @@ void ppmRxInit(const ppmConfig_t *ppmConfig)
 #endif
 
     timerConfigure(timer, (uint16_t)PPM_TIMER_PERIOD, PWM_TIMER_1MHZ);
-    timerChCCHandlerInit(&port->edgeCb, ppmEdgeCallback);
-    timerChOvrHandlerInit(&port->overflowCb, ppmOverflowCallback);
-    timerChConfigCallbacks(timer, &port->edgeCb, &port->overflowCb);
+#ifdef USE_PPM_DMA
+    if (!ppmDmaInit(timer))
+#endif
+    {
+        timerChCCHandlerInit(&port->edgeCb, ppmEdgeCallback);
+        timerChOvrHandlerInit(&port->overflowCb, ppmOverflowCallback);
+        timerChConfigCallbacks(timer, &port->edgeCb, &port->overflowCb);
+    }
 
 #if defined(USE_HAL_DRIVER)
     pwmICConfig(timer->tim, timer->channel, TIM_ICPOLARITY_RISING);
@@ -30,15 +30,24 @@
 
 #include "drivers/bus_spi.h"
 #include "bus_spi_soft.h"
+#include "drivers/exti.h"
 #include "drivers/gpio.h"
 #include "drivers/io.h"
 #include "io_impl.h"
+#include "drivers/nvic.h"
 #include "rcc.h"
 #include "rx_spi.h"
 #include "drivers/system.h"
+#include "drivers/time.h"
 
+#ifdef RX_SPI_INSTANCE
+// Select through the bus helpers, so the gyro data ready interrupt can see the radio has the bus
+#define DISABLE_RX()    {spiBusDeselectDevice(RX_SPI_INSTANCE, DEFIO_IO(RX_NSS_PIN));}
+#define ENABLE_RX()     {spiBusSelectDevice(RX_SPI_INSTANCE, DEFIO_IO(RX_NSS_PIN));}
+#else
 #define DISABLE_RX()    {IOHi(DEFIO_IO(RX_NSS_PIN));}
 #define ENABLE_RX()     {IOLo(DEFIO_IO(RX_NSS_PIN));}
+#endif
 
 #ifdef USE_RX_SOFTSPI
 static const softSPIDevice_t softSPIDevice = {
@@ -51,6 +60,34 @@ static const softSPIDevice_t softSPIDevice = {
 static bool useSoftSPI = false;
 #endif // USE_RX_SOFTSPI
 
+#ifdef RX_IRQ_PIN
+// The radio pulls its IRQ line low when a packet has arrived, so the SPI bus is only used when there is something to read
+static IO_t rxIrqIO;
+static extiCallbackRec_t rxSpiExtiCallbackRec;
+static volatile uint32_t rxSpiIrqTimeUs = 0;
+
+static void rxSpiExtiHandler(extiCallbackRec_t *cb)
+{
+    UNUSED(cb);
+    rxSpiIrqTimeUs = micros();
+}
+
+static void rxSpiExtiInit(void)
+{
+    rxIrqIO = IOGetByTag(IO_TAG(RX_IRQ_PIN));
+    IOInit(rxIrqIO, OWNER_RX_SPI_EXTI, 0);
+#if defined(STM32F7)
+    EXTIHandlerInit(&rxSpiExtiCallbackRec, rxSpiExtiHandler);
+    EXTIConfig(rxIrqIO, &rxSpiExtiCallbackRec, NVIC_PRIO_RX_SPI_EXTI, IO_CONFIG(GPIO_MODE_INPUT, 0, GPIO_PULLUP));
+#else
+    IOConfigGPIO(rxIrqIO, IOCFG_IPU);
+    EXTIHandlerInit(&rxSpiExtiCallbackRec, rxSpiExtiHandler);
+    EXTIConfig(rxIrqIO, &rxSpiExtiCallbackRec, NVIC_PRIO_RX_SPI_EXTI, EXTI_Trigger_Falling);
+    EXTIEnable(rxIrqIO, true);
+#endif
+}
+#endif // RX_IRQ_PIN
+
 void rxSpiDeviceInit(rx_spi_type_e spiType)
 {
     static bool hardwareInitialised = false;
@@ -75,10 +112,33 @@ void rxSpiDeviceInit(rx_spi_type_e spiType)
 
 #ifdef RX_SPI_INSTANCE
     spiSetDivisor(RX_SPI_INSTANCE, SPI_CLOCK_STANDARD);
+#endif
+#ifdef RX_IRQ_PIN
+    rxSpiExtiInit();
 #endif
     hardwareInitialised = true;
 }
 
+// True when the radio may have something to report, always true if its IRQ line isn't connected
+bool rxSpiIrqAsserted(void)
+{
+#ifdef RX_IRQ_PIN
+    return !IORead(rxIrqIO);
+#else
+    return true;
+#endif
+}
+
+// Arrival of the last packet, taken on the IRQ edge when there is one rather than when the packet is read
+uint32_t rxSpiPacketTimeUs(void)
+{
+#ifdef RX_IRQ_PIN
+    return rxSpiIrqTimeUs;
+#else
+    return micros();
+#endif
+}
+
 uint8_t rxSpiTransferByte(uint8_t data)
 {
 #ifdef USE_RX_SOFTSPI
@@ -23,6 +23,7 @@
 
 #include "rx_spi.h"
 #include "rx_nrf24l01.h"
+#include "common/crc.h"
 #include "common/maths.h"
 
 
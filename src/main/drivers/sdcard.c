@@ -32,12 +32,12 @@
 #include "sdcard.h"
 #include "sdcard_standard.h"
 
-#ifdef AFATFS_USE_INTROSPECTIVE_LOGGING
+#if defined(AFATFS_USE_INTROSPECTIVE_LOGGING) || defined(USE_SDCARD_STATS)
     #define SDCARD_PROFILING
 #endif
 
-#define SET_CS_HIGH          IOHi(sdCardCsPin)
-#define SET_CS_LOW           IOLo(sdCardCsPin)
+#define SET_CS_HIGH          spiBusDeselectDevice(SDCARD_SPI_INSTANCE, sdCardCsPin)
+#define SET_CS_LOW           spiBusSelectDevice(SDCARD_SPI_INSTANCE, sdCardCsPin)
 
 #define SDCARD_INIT_NUM_DUMMY_BYTES 10
 #define SDCARD_MAXIMUM_BYTE_DELAY_FOR_CMD_REPLY 8
@@ -45,6 +45,7 @@
 #define SDCARD_IF_COND_CHECK_PATTERN 0xAB
 
 #define SDCARD_TIMEOUT_INIT_MILLIS      200
+#define SDCARD_POWER_UP_MILLIS          1000    // the card needs 1ms, this leaves a wide margin for slow supplies
 #define SDCARD_MAX_CONSECUTIVE_FAILURES 8
 
 /* Break up 512-byte SD card sectors into chunks of this size when writing without DMA to reduce the peak overhead
@@ -55,6 +56,7 @@
 typedef enum {
     // In these states we run at the initialization 400kHz clockspeed:
     SDCARD_STATE_NOT_PRESENT = 0,
+    SDCARD_STATE_POWER_UP,
     SDCARD_STATE_RESET,
     SDCARD_STATE_CARD_INIT_IN_PROGRESS,
     SDCARD_STATE_INITIALIZATION_RECEIVE_CID,
@@ -100,6 +102,9 @@ typedef struct sdcard_t {
 #ifdef SDCARD_PROFILING
     sdcard_profilerCallback_c profiler;
 #endif
+#ifdef USE_SDCARD_STATS
+    uint32_t busyStartTime;
+#endif
 } sdcard_t;
 
 static sdcard_t sdcard;
@@ -566,9 +571,14 @@ void sdcard_init(bool useDMA)
     // Max frequency is initially 400kHz
     spiSetDivisor(SDCARD_SPI_INSTANCE, SDCARD_SPI_INITIALIZATION_CLOCK_DIVIDER);
 
-    // SDCard wants 1ms minimum delay after power is applied to it
-    delay(1000);
+    // The card is given its power up time by sdcard_poll(), so that the rest of the system can start meanwhile
+    sdcard.operationStartTime = millis();
+    sdcard.state = SDCARD_STATE_POWER_UP;
+    sdcard.failureCount = 0;
+}
 
+static void sdcard_startUp(void)
+{
     // Transmit at least 74 dummy clock cycles with CS high so the SD card can start up
     SET_CS_HIGH;
 
@@ -586,7 +596,6 @@ void sdcard_init(bool useDMA)
 
     sdcard.operationStartTime = millis();
     sdcard.state = SDCARD_STATE_RESET;
-    sdcard.failureCount = 0;
 }
 
 static bool sdcard_setBlockLength(uint32_t blockLen)
@@ -639,6 +648,23 @@ static sdcardOperationStatus_e sdcard_endWriteBlocks()
     }
 }
 
+#ifdef SDCARD_PROFILING
+static void sdcard_profileOperation(sdcardBlockOperation_e operation)
+{
+    const uint32_t duration = micros() - sdcard.pendingOperation.profileStartTime;
+
+#ifdef USE_SDCARD_STATS
+    if (operation == SDCARD_BLOCK_OPERATION_WRITE) {
+        sdcardStats_recordWrite(duration);
+    }
+#endif
+
+    if (sdcard.profiler) {
+        sdcard.profiler(operation, sdcard.pendingOperation.blockIndex, duration);
+    }
+}
+#endif
+
 /**
  * Call periodically for the SD card to perform in-progress transfers.
  *
@@ -655,6 +681,13 @@ bool sdcard_poll(void)
 
     doMore:
     switch (sdcard.state) {
+        case SDCARD_STATE_POWER_UP:
+            if (millis() - sdcard.operationStartTime >= SDCARD_POWER_UP_MILLIS) {
+                sdcard_startUp();
+                goto doMore;
+            }
+        break;
+
         case SDCARD_STATE_RESET:
             sdcard_select();
 
@@ -799,6 +832,9 @@ bool sdcard_poll(void)
                     // The SD card is now busy committing that write to the card
                     sdcard.state = SDCARD_STATE_WAITING_FOR_WRITE;
                     sdcard.operationStartTime = millis();
+#ifdef USE_SDCARD_STATS
+                    sdcard.busyStartTime = micros();
+#endif
 
                     // Since we've transmitted the buffer we can go ahead and tell the caller their operation is complete
                     if (sdcard.pendingOperation.callback) {
@@ -824,6 +860,9 @@ bool sdcard_poll(void)
 #ifdef SDCARD_PROFILING
                 profilingComplete = true;
 #endif
+#ifdef USE_SDCARD_STATS
+                sdcardStats_recordBusy(micros() - sdcard.busyStartTime);
+#endif
 
                 sdcard.failureCount = 0; // Assume the card is good if it can complete a write
 
@@ -848,8 +887,8 @@ bool sdcard_poll(void)
                 }
 
 #ifdef SDCARD_PROFILING
-                if (profilingComplete && sdcard.profiler) {
-                    sdcard.profiler(SDCARD_BLOCK_OPERATION_WRITE, sdcard.pendingOperation.blockIndex, micros() - sdcard.pendingOperation.profileStartTime);
+                if (profilingComplete) {
+                    sdcard_profileOperation(SDCARD_BLOCK_OPERATION_WRITE);
                 }
 #endif
             } else if (millis() > sdcard.operationStartTime + SDCARD_TIMEOUT_WRITE_MSEC) {
@@ -871,9 +910,7 @@ bool sdcard_poll(void)
                     sdcard.failureCount = 0; // Assume the card is good if it can complete a read
 
 #ifdef SDCARD_PROFILING
-                    if (sdcard.profiler) {
-                        sdcard.profiler(SDCARD_BLOCK_OPERATION_READ, sdcard.pendingOperation.blockIndex, micros() - sdcard.pendingOperation.profileStartTime);
-                    }
+                    sdcard_profileOperation(SDCARD_BLOCK_OPERATION_READ);
 #endif
 
                     if (sdcard.pendingOperation.callback) {
@@ -916,9 +953,7 @@ bool sdcard_poll(void)
                 sdcard.state = SDCARD_STATE_READY;
 
 #ifdef SDCARD_PROFILING
-                if (sdcard.profiler) {
-                    sdcard.profiler(SDCARD_BLOCK_OPERATION_WRITE, sdcard.pendingOperation.blockIndex, micros() - sdcard.pendingOperation.profileStartTime);
-                }
+                sdcard_profileOperation(SDCARD_BLOCK_OPERATION_WRITE);
 #endif
             } else if (millis() > sdcard.operationStartTime + SDCARD_TIMEOUT_WRITE_MSEC) {
                 sdcard_reset();
@@ -75,3 +75,22 @@ bool sdcard_poll();
 const sdcardMetadata_t* sdcard_getMetadata();
 
 void sdcard_setProfilerCallback(sdcard_profilerCallback_c callback);
+
+#define SDCARD_STATS_BUCKET_COUNT 12
+#define SDCARD_STATS_FIRST_BUCKET_SHIFT 8
+
+typedef struct sdcardStats_s {
+    uint32_t writeCount;
+    // Bucket n counts the blocks that took less than 2^(n + 8)us, the last bucket counts all the slower ones
+    uint32_t writeLatencyHistogram[SDCARD_STATS_BUCKET_COUNT];
+    uint32_t busyHistogram[SDCARD_STATS_BUCKET_COUNT];
+    uint32_t maxWriteLatencyUs;
+    uint32_t maxBusyUs;
+} sdcardStats_t;
+
+void sdcardStats_recordWrite(uint32_t latencyUs);
+void sdcardStats_recordBusy(uint32_t busyUs);
+const sdcardStats_t *sdcardStats_get(void);
+uint32_t sdcardStats_getWriteLatencyPercentileUs(uint16_t percentile);
+uint32_t sdcardStats_getBusyPercentileUs(uint16_t percentile);
+uint32_t sdcardStats_getWriteRate(void);
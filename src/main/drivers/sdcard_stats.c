@@ -0,0 +1,137 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "platform.h"
+
+#ifdef USE_SDCARD_STATS
+
+#include "common/maths.h"
+
+#include "drivers/time.h"
+
+#include "sdcard.h"
+#include "sdcard_standard.h"
+
+// A longer pause between writes means nothing was being logged, so it doesn't count towards the write rate
+#define SDCARD_STATS_IDLE_GAP_US 100000
+
+static sdcardStats_t sdcardStats;
+
+static uint32_t lastWriteAtUs;
+static uint64_t writeActiveUs;
+static uint32_t writeActiveCount;
+
+static void sdcardStats_addToHistogram(uint32_t *histogram, uint32_t durationUs)
+{
+    int bucket = 0;
+
+    durationUs >>= SDCARD_STATS_FIRST_BUCKET_SHIFT;
+    while (durationUs && bucket < SDCARD_STATS_BUCKET_COUNT - 1) {
+        durationUs >>= 1;
+        bucket++;
+    }
+
+    histogram[bucket]++;
+}
+
+/**
+ * Record the time taken to write one block, from the write being started until the card finished programming it.
+ */
+void sdcardStats_recordWrite(uint32_t latencyUs)
+{
+    const uint32_t nowUs = micros();
+
+    if (sdcardStats.writeCount > 0 && nowUs - lastWriteAtUs < SDCARD_STATS_IDLE_GAP_US) {
+        writeActiveUs += nowUs - lastWriteAtUs;
+        writeActiveCount++;
+    }
+    lastWriteAtUs = nowUs;
+
+    sdcardStats.writeCount++;
+    sdcardStats.maxWriteLatencyUs = MAX(sdcardStats.maxWriteLatencyUs, latencyUs);
+    sdcardStats_addToHistogram(sdcardStats.writeLatencyHistogram, latencyUs);
+}
+
+/**
+ * Record the time the card held the bus busy while it programmed a block we had finished sending.
+ */
+void sdcardStats_recordBusy(uint32_t busyUs)
+{
+    sdcardStats.maxBusyUs = MAX(sdcardStats.maxBusyUs, busyUs);
+    sdcardStats_addToHistogram(sdcardStats.busyHistogram, busyUs);
+}
+
+const sdcardStats_t *sdcardStats_get(void)
+{
+    return &sdcardStats;
+}
+
+static uint32_t sdcardStats_getPercentileUs(const uint32_t *histogram, uint32_t maxUs, uint16_t percentile)
+{
+    uint32_t total = 0;
+    for (int i = 0; i < SDCARD_STATS_BUCKET_COUNT; i++) {
+        total += histogram[i];
+    }
+    if (total == 0) {
+        return 0;
+    }
+
+    // Number of samples that have to be at or below the percentile, rounded up
+    const uint32_t target = ((uint64_t)total * percentile + 9999) / 10000;
+    uint32_t count = 0;
+
+    for (int i = 0; i < SDCARD_STATS_BUCKET_COUNT - 1; i++) {
+        count += histogram[i];
+        if (count >= target) {
+            return MIN((uint32_t)1 << (i + SDCARD_STATS_FIRST_BUCKET_SHIFT), maxUs);
+        }
+    }
+
+    // The last bucket is open ended
+    return maxUs;
+}
+
+/**
+ * Get an upper bound on the block write latency percentile, given in hundredths of a percent (9900 for p99).
+ *
+ * Returns 0 if nothing has been written yet.
+ */
+uint32_t sdcardStats_getWriteLatencyPercentileUs(uint16_t percentile)
+{
+    return sdcardStats_getPercentileUs(sdcardStats.writeLatencyHistogram, sdcardStats.maxWriteLatencyUs, percentile);
+}
+
+uint32_t sdcardStats_getBusyPercentileUs(uint16_t percentile)
+{
+    return sdcardStats_getPercentileUs(sdcardStats.busyHistogram, sdcardStats.maxBusyUs, percentile);
+}
+
+/**
+ * Get the rate blocks have been written at while logging, in bytes per second.
+ */
+uint32_t sdcardStats_getWriteRate(void)
+{
+    if (writeActiveUs == 0) {
+        return 0;
+    }
+    return (uint64_t)writeActiveCount * SDCARD_BLOCK_SIZE * 1000000 / writeActiveUs;
+}
+
+#endif
@@ -71,6 +71,28 @@ uint8_t serialRead(serialPort_t *instance)
     return instance->vTable->serialRead(instance);
 }
 
+// Reads up to count received bytes, returns the number read
+uint32_t serialReadBuf(serialPort_t *instance, uint8_t *data, uint32_t count)
+{
+    if (instance->vTable->readBuf)
+        return instance->vTable->readBuf(instance, data, count);
+
+    uint32_t read = 0;
+    while (read < count && serialRxBytesWaiting(instance)) {
+        data[read++] = serialRead(instance);
+    }
+    return read;
+}
+
+// Returns false if the port can't time the gaps itself, the caller then has to pace the bytes
+bool serialSetTxByteGap(serialPort_t *instance, uint32_t gapUs)
+{
+    if (!instance->vTable->setTxByteGap)
+        return false;
+
+    return instance->vTable->setTxByteGap(instance, gapUs);
+}
+
 void serialSetBaudRate(serialPort_t *instance, uint32_t baudRate)
 {
     instance->vTable->serialSetBaudRate(instance, baudRate);
@@ -102,3 +124,36 @@ void serialEndWrite(serialPort_t *instance)
     if (instance->vTable->endWrite)
         instance->vTable->endWrite(instance);
 }
+
+// Set from receive interrupts and read by the serial task, see serialCheckRxEvent()
+static volatile bool serialRxEvent;
+
+// Called by drivers when data that is read by the serial task has been received
+void serialSignalRxEvent(void)
+{
+    serialRxEvent = true;
+}
+
+// Returns true, clearing the event, if data has been received since the last call
+bool serialCheckRxEvent(void)
+{
+    if (!serialRxEvent) {
+        return false;
+    }
+    serialRxEvent = false;
+    return true;
+}
+
+// Returns 0 if the port can't be written in place, otherwise the number of bytes that can be written at *data
+uint32_t serialReserveWrite(serialPort_t *instance, uint8_t **data)
+{
+    if (instance->vTable->reserveWrite)
+        return instance->vTable->reserveWrite(instance, data);
+    return 0;
+}
+
+// Sends count bytes written in place after serialReserveWrite()
+void serialCommitWrite(serialPort_t *instance, uint32_t count)
+{
+    instance->vTable->commitWrite(instance, count);
+}
@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include "common/ringbuffer.h"
+
 #include "drivers/io.h"
 #include "config/parameter_group.h"
 
@@ -44,7 +46,10 @@ typedef enum portOptions_t {
      * to actual data bytes.
      */
     SERIAL_BIDIR_OD      = 0 << 4,
-    SERIAL_BIDIR_PP      = 1 << 4
+    SERIAL_BIDIR_PP      = 1 << 4,
+
+    // Hold transmission while the other end deasserts CTS. Ignored by ports with no CTS pin assigned.
+    SERIAL_CTS           = 1 << 5
 } portOptions_t;
 
 typedef void (*serialReceiveCallbackPtr)(uint16_t data);   // used by serial drivers to return frames to app
@@ -59,14 +64,8 @@ typedef struct serialPort_s {
 
     uint32_t baudRate;
 
-    uint32_t rxBufferSize;
-    uint32_t txBufferSize;
-    volatile uint8_t *rxBuffer;
-    volatile uint8_t *txBuffer;
-    uint32_t rxBufferHead;
-    uint32_t rxBufferTail;
-    uint32_t txBufferHead;
-    uint32_t txBufferTail;
+    ringBuffer_t rxBuffer;
+    ringBuffer_t txBuffer;
 
     serialReceiveCallbackPtr rxCallback;
 } serialPort_t;
@@ -85,6 +84,7 @@ typedef struct serialPinConfig_s {
     ioTag_t ioTagTx[SERIAL_PORT_MAX_INDEX];
     ioTag_t ioTagRx[SERIAL_PORT_MAX_INDEX];
     ioTag_t ioTagInverter[SERIAL_PORT_MAX_INDEX];
+    ioTag_t ioTagCts[SERIAL_PORT_MAX_INDEX];
 } serialPinConfig_t;
 
 PG_DECLARE(serialPinConfig_t, serialPinConfig);
@@ -108,6 +108,13 @@ struct serialPortVTable {
     // Optional functions used to buffer large writes.
     void (*beginWrite)(serialPort_t *instance);
     void (*endWrite)(serialPort_t *instance);
+    // Optional functions used to write in place into the transmit buffer.
+    uint32_t (*reserveWrite)(serialPort_t *instance, uint8_t **data);
+    void (*commitWrite)(serialPort_t *instance, uint32_t count);
+    // Optional function used to read received bytes in blocks.
+    uint32_t (*readBuf)(serialPort_t *instance, uint8_t *data, uint32_t count);
+    // Optional function to hold the line idle for at least gapUs after each transmitted byte.
+    bool (*setTxByteGap)(serialPort_t *instance, uint32_t gapUs);
 };
 
 void serialWrite(serialPort_t *instance, uint8_t ch);
@@ -115,6 +122,8 @@ uint32_t serialRxBytesWaiting(const serialPort_t *instance);
 uint32_t serialTxBytesFree(const serialPort_t *instance);
 void serialWriteBuf(serialPort_t *instance, const uint8_t *data, int count);
 uint8_t serialRead(serialPort_t *instance);
+uint32_t serialReadBuf(serialPort_t *instance, uint8_t *data, uint32_t count);
+bool serialSetTxByteGap(serialPort_t *instance, uint32_t gapUs);
 void serialSetBaudRate(serialPort_t *instance, uint32_t baudRate);
 void serialSetMode(serialPort_t *instance, portMode_t mode);
 bool isSerialTransmitBufferEmpty(const serialPort_t *instance);
@@ -125,3 +134,7 @@ uint32_t serialGetBaudRate(serialPort_t *instance);
 void serialWriteBufShim(void *instance, const uint8_t *data, int count);
 void serialBeginWrite(serialPort_t *instance);
 void serialEndWrite(serialPort_t *instance);
+uint32_t serialReserveWrite(serialPort_t *instance, uint8_t **data);
+void serialSignalRxEvent(void);
+bool serialCheckRxEvent(void);
+void serialCommitWrite(serialPort_t *instance, uint32_t count);
@@ -37,6 +37,7 @@
 #include "drivers/pwm_output.h"
 #include "drivers/serial.h"
 #include "drivers/serial_escserial.h"
+#include "drivers/serial_uart.h"
 #include "drivers/time.h"
 #include "drivers/timer.h"
 
@@ -207,7 +208,7 @@ static bool isTimerPeriodTooLarge(uint32_t timerPeriod)
 static bool isEscSerialTransmitBufferEmpty(const serialPort_t *instance)
 {
     // start listening
-    return instance->txBufferHead == instance->txBufferTail;
+    return ringBufferIsEmpty(&instance->txBuffer);
 }
 
 static void escSerialOutputPortConfig(const timerHardware_t *timerHardwarePtr)
@@ -231,10 +232,7 @@ static void processTxStateBL(escSerial_t *escSerial)
         }
 
         // data to send
-        byteToSend = escSerial->port.txBuffer[escSerial->port.txBufferTail++];
-        if (escSerial->port.txBufferTail >= escSerial->port.txBufferSize) {
-            escSerial->port.txBufferTail = 0;
-        }
+        byteToSend = ringBufferPop(&escSerial->port.txBuffer);
 
         // build internal buffer, MSB = Stop Bit (1) + data bits (MSB to LSB) + start bit(0) LSB
         escSerial->internalTxBuffer = (1 << (TX_TOTAL_BITS - 1)) | (byteToSend << 1);
@@ -286,8 +284,7 @@ static void extractAndStoreRxByteBL(escSerial_t *escSerial)
     if (escSerial->port.rxCallback) {
         escSerial->port.rxCallback(rxByte);
     } else {
-        escSerial->port.rxBuffer[escSerial->port.rxBufferHead] = rxByte;
-        escSerial->port.rxBufferHead = (escSerial->port.rxBufferHead + 1) % escSerial->port.rxBufferSize;
+        ringBufferPush(&escSerial->port.rxBuffer, rxByte);
     }
 }
 
@@ -462,10 +459,7 @@ reload:
         }
         else{
             // data to send
-            byteToSend = escSerial->port.txBuffer[escSerial->port.txBufferTail++];
-            if (escSerial->port.txBufferTail >= escSerial->port.txBufferSize) {
-                escSerial->port.txBufferTail = 0;
-            }
+            byteToSend = ringBufferPop(&escSerial->port.txBuffer);
         }
 
 
@@ -562,8 +556,7 @@ static void extractAndStoreRxByteEsc(escSerial_t *escSerial)
     if (escSerial->port.rxCallback) {
         escSerial->port.rxCallback(rxByte);
     } else {
-        escSerial->port.rxBuffer[escSerial->port.rxBufferHead] = rxByte;
-        escSerial->port.rxBufferHead = (escSerial->port.rxBufferHead + 1) % escSerial->port.rxBufferSize;
+        ringBufferPush(&escSerial->port.rxBuffer, rxByte);
     }
 }
 
@@ -643,15 +636,8 @@ static void escSerialTimerRxConfig(const timerHardware_t *timerHardwarePtr, uint
 
 static void resetBuffers(escSerial_t *escSerial)
 {
-    escSerial->port.rxBufferSize = ESCSERIAL_BUFFER_SIZE;
-    escSerial->port.rxBuffer = escSerial->rxBuffer;
-    escSerial->port.rxBufferTail = 0;
-    escSerial->port.rxBufferHead = 0;
-
-    escSerial->port.txBuffer = escSerial->txBuffer;
-    escSerial->port.txBufferSize = ESCSERIAL_BUFFER_SIZE;
-    escSerial->port.txBufferTail = 0;
-    escSerial->port.txBufferHead = 0;
+    ringBufferInit(&escSerial->port.rxBuffer, escSerial->rxBuffer, ESCSERIAL_BUFFER_SIZE);
+    ringBufferInit(&escSerial->port.txBuffer, escSerial->txBuffer, ESCSERIAL_BUFFER_SIZE);
 }
 
 static serialPort_t *openEscSerial(escSerialPortIndex_e portIndex, serialReceiveCallbackPtr callback, uint16_t output, uint32_t baud, portOptions_t options, uint8_t mode)
@@ -773,26 +759,16 @@ static uint32_t escSerialTotalBytesWaiting(const serialPort_t *instance)
         return 0;
     }
 
-    escSerial_t *s = (escSerial_t *)instance;
-
-    return (s->port.rxBufferHead - s->port.rxBufferTail) & (s->port.rxBufferSize - 1);
+    return ringBufferCount(&instance->rxBuffer);
 }
 
 static uint8_t escSerialReadByte(serialPort_t *instance)
 {
-    uint8_t ch;
-
     if ((instance->mode & MODE_RX) == 0) {
         return 0;
     }
 
-    if (escSerialTotalBytesWaiting(instance) == 0) {
-        return 0;
-    }
-
-    ch = instance->rxBuffer[instance->rxBufferTail];
-    instance->rxBufferTail = (instance->rxBufferTail + 1) % instance->rxBufferSize;
-    return ch;
+    return ringBufferPop(&instance->rxBuffer);
 }
 
 static void escSerialWriteByte(serialPort_t *s, uint8_t ch)
@@ -801,8 +777,7 @@ static void escSerialWriteByte(serialPort_t *s, uint8_t ch)
         return;
     }
 
-    s->txBuffer[s->txBufferHead] = ch;
-    s->txBufferHead = (s->txBufferHead + 1) % s->txBufferSize;
+    ringBufferPush(&s->txBuffer, ch);
 }
 
 static void escSerialSetBaudRate(serialPort_t *s, uint32_t baudRate)
@@ -822,11 +797,7 @@ static uint32_t escSerialTxBytesFree(const serialPort_t *instance)
         return 0;
     }
 
-    escSerial_t *s = (escSerial_t *)instance;
-
-    uint8_t bytesUsed = (s->port.txBufferHead - s->port.txBufferTail) & (s->port.txBufferSize - 1);
-
-    return (s->port.txBufferSize - 1) - bytesUsed;
+    return ringBufferFree(&instance->txBuffer);
 }
 
 const struct serialPortVTable escSerialVTable[] = {
@@ -840,7 +811,9 @@ const struct serialPortVTable escSerialVTable[] = {
         .setMode = escSerialSetMode,
         .writeBuf = NULL,
         .beginWrite = NULL,
-        .endWrite = NULL
+        .endWrite = NULL,
+        .reserveWrite = NULL,
+        .commitWrite = NULL
     }
 };
 
@@ -914,6 +887,21 @@ static bool processExitCommand(uint8_t c)
 }
 
 
+// BLHeli and KISS are plain 8N1, a free UART that has the motor pin among its TX pins runs them in hardware
+static serialPort_t *openEscUart(uint16_t output, uint32_t baud, uint8_t mode)
+{
+#if defined(STM32F3) || defined(STM32F4)
+    if ((mode == PROTOCOL_BLHELI || mode == PROTOCOL_KISS) && !(timerHardware[output].output & TIMER_OUTPUT_INVERTED)) {
+        return uartOpenOnTxPin(timerHardware[output].tag, NULL, baud, (mode == PROTOCOL_KISS) ? MODE_TX : MODE_RXTX);
+    }
+#else
+    UNUSED(output);
+    UNUSED(baud);
+    UNUSED(mode);
+#endif
+    return NULL;
+}
+
 void escEnablePassthrough(serialPort_t *escPassthroughPort, uint16_t output, uint8_t mode)
 {
     bool exitEsc = false;
@@ -957,7 +945,11 @@ void escEnablePassthrough(serialPort_t *escPassthroughPort, uint16_t output, uin
         }
     }
 
-    escPort = openEscSerial(ESCSERIAL1, NULL, motor_output, escBaudrate, 0, mode);
+    serialPort_t *escUart = NULL;
+    if (mode != PROTOCOL_KISSALL) {
+        escUart = openEscUart(motor_output, escBaudrate, mode);
+    }
+    escPort = escUart ? escUart : openEscSerial(ESCSERIAL1, NULL, motor_output, escBaudrate, 0, mode);
 
     if (!escPort) {
         return;
@@ -991,11 +983,17 @@ void escEnablePassthrough(serialPort_t *escPassthroughPort, uint16_t output, uin
                     serialWrite(escPassthroughPort, 0x00);
                     serialWrite(escPassthroughPort, 0xF4);
                     serialWrite(escPassthroughPort, 0xF4);
-                    closeEscSerial(ESCSERIAL1, mode);
+                    if (escUart) {
+#if defined(STM32F3) || defined(STM32F4)
+                        uartCloseOnTxPin(escUart);
+#endif
+                    } else {
+                        closeEscSerial(ESCSERIAL1, mode);
+                    }
                     return;
                 }
-                if (mode==PROTOCOL_BLHELI) {
-                    serialWrite(escPassthroughPort, ch); // blheli loopback
+                if (mode==PROTOCOL_BLHELI && !escUart) {
+                    serialWrite(escPassthroughPort, ch); // blheli loopback, a half duplex UART echoes by itself
                 }
                 serialWrite(escPort, ch);
             }
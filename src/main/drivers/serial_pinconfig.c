@@ -258,7 +258,7 @@ static const serialDefaultPin_t serialDefaultPin[] = {
 #endif
 };
 
-PG_REGISTER_WITH_RESET_FN(serialPinConfig_t, serialPinConfig, PG_SERIAL_PIN_CONFIG, 0);
+PG_REGISTER_WITH_RESET_FN(serialPinConfig_t, serialPinConfig, PG_SERIAL_PIN_CONFIG, 1);
 
 void pgResetFn_serialPinConfig(serialPinConfig_t *serialPinConfig)
 {
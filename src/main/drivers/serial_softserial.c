@@ -32,10 +32,14 @@
 
 #include "build/debug.h"
 
+#include "common/maths.h"
 #include "common/utils.h"
 
 #include "drivers/nvic.h"
 #include "drivers/io.h"
+#ifdef USE_SOFTSERIAL_DMA
+#include "drivers/dma.h"
+#endif
 #include "timer.h"
 
 #include "serial.h"
@@ -60,6 +64,14 @@ typedef enum {
 #define ICPOLARITY_RISING true
 #define ICPOLARITY_FALLING false
 
+#ifdef USE_SOFTSERIAL_DMA
+#define SOFTSERIAL_DMA_TICKS_PER_BIT 16     // at least, the prescaler is rounded down
+#define SOFTSERIAL_DMA_PERIOD_BITS 24       // counter period, the overflow interrupt decodes what arrived in it
+#define SOFTSERIAL_DMA_RX_EDGES 64          // more than the edges of a period
+#define SOFTSERIAL_DMA_TX_BYTES 4           // per transfer, the completion interrupt queues the next one
+#define SOFTSERIAL_DMA_TURNAROUND_PERIODS 2 // after the last edge, so that the stop bit is out before receiving again
+#endif
+
 typedef struct softSerial_s {
     serialPort_t     port;
 
@@ -83,6 +95,9 @@ typedef struct softSerial_s {
 
     uint8_t          isTransmittingData;
     int8_t           bitsLeftToTransmit;
+    uint32_t         txGapUs;           // idle time after each byte
+    uint8_t          txGapBits;         // txGapUs in bit periods at the current baud rate
+    uint8_t          txGapBitsLeft;
 
     uint16_t         internalTxBuffer;  // includes start and stop bits
     uint16_t         internalRxBuffer;  // includes start and stop bits
@@ -95,6 +110,31 @@ typedef struct softSerial_s {
 
     timerOvrHandlerRec_t overCb;
     timerCCHandlerRec_t edgeCb;
+
+#ifdef USE_SOFTSERIAL_DMA
+    bool             useDma;
+    const timerHardware_t *txTimerHardware;
+
+    uint32_t         bitTicksQ8;        // bit period in counter ticks of the receive timer, 24.8 fixed point
+    uint16_t         periodTicks;
+    uint32_t         txBitTicksQ8;
+    uint16_t         txPeriodTicks;
+
+    volatile uint32_t rxEdges[SOFTSERIAL_DMA_RX_EDGES]; // counter at every edge, written by the DMA in a circle
+    uint8_t          rxEdgeIndex;
+    uint16_t         rxCount;           // counter when last decoded
+    uint32_t         rxTime;            // ticks since the input was activated when last decoded
+    uint32_t         rxLastEdgeTime;
+    uint32_t         rxFrameStart;
+    uint16_t         rxFrame;
+    uint8_t          rxFrameBit;
+    bool             rxFrameActive;
+    bool             rxLineMark;
+
+    uint32_t         txEdges[SOFTSERIAL_DMA_TX_BYTES * TX_TOTAL_BITS + 1]; // compare value of every edge, then of the end of the transfer
+    uint16_t         txEnd;
+    uint8_t          txTurnaroundPeriods;
+#endif
 } softSerial_t;
 
 static const struct serialPortVTable softSerialVTable; // Forward
@@ -225,17 +265,402 @@ static void serialTimerConfigureTimebase(const timerHardware_t *timerHardwarePtr
 
 static void resetBuffers(softSerial_t *softSerial)
 {
-    softSerial->port.rxBufferSize = SOFTSERIAL_BUFFER_SIZE;
-    softSerial->port.rxBuffer = softSerial->rxBuffer;
-    softSerial->port.rxBufferTail = 0;
-    softSerial->port.rxBufferHead = 0;
+    ringBufferInit(&softSerial->port.rxBuffer, softSerial->rxBuffer, SOFTSERIAL_BUFFER_SIZE);
+    ringBufferInit(&softSerial->port.txBuffer, softSerial->txBuffer, SOFTSERIAL_BUFFER_SIZE);
+}
+
+#ifdef USE_SOFTSERIAL_DMA
+/*
+ * DMA engine
+ *
+ * The receive channel captures both edges, and a circular DMA stores the counter at every edge. The edges are
+ * decoded by the overflow interrupt, once per counter period of SOFTSERIAL_DMA_PERIOD_BITS, and when the
+ * received bytes are asked for. The transmit channel toggles its output on compare, and a DMA loads the compare
+ * value of the next edge, SOFTSERIAL_DMA_TX_BYTES at a time. The bit banging ISR engine is used when the timer
+ * channels have no free DMA.
+ */
+
+static bool softSerialDmaIsAvailable(const timerHardware_t *timerHardware, uint8_t resourceIndex)
+{
+    if (!timerHardware->dmaRef || (timerHardware->output & TIMER_OUTPUT_N_CHANNEL)) {
+        return false;
+    }
+
+    const dmaIdentifier_e identifier = dmaGetIdentifier(timerHardware->dmaRef);
+    const resourceOwner_e owner = dmaGetOwner(identifier);
+
+    // a port that is opened again still owns its DMA
+    return owner == OWNER_FREE || ((owner == OWNER_SERIAL_RX || owner == OWNER_SERIAL_TX) && dmaGetResourceIndex(identifier) == resourceIndex);
+}
+
+static void softSerialDmaConfigureTimebase(const timerHardware_t *timerHardware, uint32_t baud, uint32_t *bitTicksQ8, uint16_t *periodTicks)
+{
+    const uint32_t clock = timerClock(timerHardware->tim);
+    const uint32_t prescaler = MAX(clock / (baud * SOFTSERIAL_DMA_TICKS_PER_BIT), 1);
+    const uint32_t hz = clock / prescaler;
+
+    *bitTicksQ8 = ((uint64_t)hz << 8) / baud;
+    *periodTicks = (SOFTSERIAL_DMA_PERIOD_BITS * *bitTicksQ8) >> 8;
+
+    timerConfigure(timerHardware, *periodTicks, hz);
+}
+
+static void softSerialDmaSetTimebase(softSerial_t *softSerial, uint32_t baud)
+{
+    softSerialDmaConfigureTimebase(softSerial->timerHardware, baud, &softSerial->bitTicksQ8, &softSerial->periodTicks);
+
+    if (softSerial->txTimerHardware->tim != softSerial->timerHardware->tim) {
+        softSerialDmaConfigureTimebase(softSerial->txTimerHardware, baud, &softSerial->txBitTicksQ8, &softSerial->txPeriodTicks);
+    } else {
+        softSerial->txBitTicksQ8 = softSerial->bitTicksQ8;
+        softSerial->txPeriodTicks = softSerial->periodTicks;
+    }
+}
+
+static void softSerialDmaConfigure(const timerHardware_t *timerHardware, volatile uint32_t *buffer, uint32_t count, bool transmit)
+{
+    DMA_InitTypeDef DMA_InitStructure;
+
+    DMA_Cmd(timerHardware->dmaRef, DISABLE);
+    DMA_DeInit(timerHardware->dmaRef);
+
+    DMA_StructInit(&DMA_InitStructure);
+#if defined(STM32F3)
+    DMA_InitStructure.DMA_MemoryBaseAddr = (uint32_t)buffer;
+    DMA_InitStructure.DMA_DIR = transmit ? DMA_DIR_PeripheralDST : DMA_DIR_PeripheralSRC;
+    DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
+#elif defined(STM32F4)
+    DMA_InitStructure.DMA_Channel = timerHardware->dmaChannel;
+    DMA_InitStructure.DMA_Memory0BaseAddr = (uint32_t)buffer;
+    DMA_InitStructure.DMA_DIR = transmit ? DMA_DIR_MemoryToPeripheral : DMA_DIR_PeripheralToMemory;
+#endif
+    DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32_t)timerChCCR(timerHardware);
+    DMA_InitStructure.DMA_BufferSize = count;
+    DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+    DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+    DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Word;
+    DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_Word;
+    DMA_InitStructure.DMA_Mode = transmit ? DMA_Mode_Normal : DMA_Mode_Circular;
+    DMA_InitStructure.DMA_Priority = DMA_Priority_High;
+
+    DMA_Init(timerHardware->dmaRef, &DMA_InitStructure);
+}
 
-    softSerial->port.txBuffer = softSerial->txBuffer;
-    softSerial->port.txBufferSize = SOFTSERIAL_BUFFER_SIZE;
-    softSerial->port.txBufferTail = 0;
-    softSerial->port.txBufferHead = 0;
+// Changes the output compare mode without disabling the channel, as TIM_SelectOCxM() does
+static void softSerialDmaSetOCMode(const timerHardware_t *timerHardware, uint16_t mode)
+{
+    TIM_TypeDef *tim = timerHardware->tim;
+    const unsigned shift = (timerHardware->channel == TIM_Channel_2 || timerHardware->channel == TIM_Channel_4) ? 8 : 0;
+
+    if (timerHardware->channel <= TIM_Channel_2) {
+        tim->CCMR1 = (tim->CCMR1 & ~(TIM_CCMR1_OC1M << shift)) | (mode << shift);
+    } else {
+        tim->CCMR2 = (tim->CCMR2 & ~(TIM_CCMR2_OC3M << shift)) | (mode << shift);
+    }
+}
+
+static uint16_t softSerialDmaTicksSince(uint16_t from, uint16_t to, uint16_t period)
+{
+    return (to >= from) ? to - from : to + period - from;
 }
 
+static void softSerialDmaStoreRxByte(softSerial_t *softSerial, uint8_t rxByte)
+{
+    if (softSerial->port.rxCallback) {
+        softSerial->port.rxCallback(rxByte);
+    } else {
+        ringBufferPush(&softSerial->port.rxBuffer, rxByte);
+        serialSignalRxEvent();
+    }
+}
+
+// Samples the line at the centre of every bit of the frame up to time
+static void softSerialDmaSampleBits(softSerial_t *softSerial, uint32_t time)
+{
+    while (softSerial->rxFrameActive) {
+        const uint32_t bitCentre = ((2 * softSerial->rxFrameBit + 1) * softSerial->bitTicksQ8) >> 9;
+        if (time - softSerial->rxFrameStart < bitCentre) {
+            return;
+        }
+
+        if (softSerial->rxLineMark) {
+            softSerial->rxFrame |= 1 << softSerial->rxFrameBit;
+        }
+
+        if (++softSerial->rxFrameBit == RX_TOTAL_BITS) {
+            softSerial->rxFrameActive = false;
+
+            // start bit space, stop bit mark
+            if ((softSerial->rxFrame & (1 | (1 << (RX_TOTAL_BITS - 1)))) == (1 << (RX_TOTAL_BITS - 1))) {
+                softSerialDmaStoreRxByte(softSerial, (softSerial->rxFrame >> 1) & 0xFF);
+            } else {
+                softSerial->receiveErrors++;
+            }
+        }
+    }
+}
+
+static void softSerialDmaRxEdge(softSerial_t *softSerial, uint32_t time)
+{
+    softSerialDmaSampleBits(softSerial, time);
+
+    softSerial->rxLineMark = !softSerial->rxLineMark;
+    softSerial->rxLastEdgeTime = time;
+
+    if (!softSerial->rxFrameActive && !softSerial->rxLineMark) {
+        softSerial->rxFrameActive = true;
+        softSerial->rxFrameStart = time;
+        softSerial->rxFrameBit = 0;
+        softSerial->rxFrame = 0;
+    }
+}
+
+static uint8_t softSerialDmaRxEdgeWriteIndex(const softSerial_t *softSerial)
+{
+    return (SOFTSERIAL_DMA_RX_EDGES - DMA_GetCurrDataCounter(softSerial->timerHardware->dmaRef)) % SOFTSERIAL_DMA_RX_EDGES;
+}
+
+// Must run at least once per counter period, which the overflow interrupt makes sure of
+static void softSerialDmaDecode(softSerial_t *softSerial)
+{
+    const uint16_t period = softSerial->periodTicks;
+
+    // all edges before the DMA write position were captured before the counter is read
+    const uint8_t writeIndex = softSerialDmaRxEdgeWriteIndex(softSerial);
+    const uint16_t count = softSerial->timerHardware->tim->CNT;
+
+    softSerial->rxTime += softSerialDmaTicksSince(softSerial->rxCount, count, period);
+    softSerial->rxCount = count;
+
+    while (softSerial->rxEdgeIndex != writeIndex) {
+        const uint16_t capture = softSerial->rxEdges[softSerial->rxEdgeIndex];
+        softSerialDmaRxEdge(softSerial, softSerial->rxTime - softSerialDmaTicksSince(capture, count, period));
+        softSerial->rxEdgeIndex = (softSerial->rxEdgeIndex + 1) % SOFTSERIAL_DMA_RX_EDGES;
+    }
+
+    softSerialDmaSampleBits(softSerial, softSerial->rxTime);
+
+    if (!softSerial->rxFrameActive && softSerial->rxTime - softSerial->rxLastEdgeTime > (RX_TOTAL_BITS * softSerial->bitTicksQ8 >> 8)) {
+        // a glitch leaves the line level wrong, the pin tells once the line has been quiet for a frame
+        const bool lineMark = IORead(softSerial->rxIO) != !!(softSerial->port.options & SERIAL_INVERTED);
+        if (softSerialDmaRxEdgeWriteIndex(softSerial) == writeIndex) {
+            softSerial->rxLineMark = lineMark;
+        }
+    }
+}
+
+static void softSerialDmaInputActivate(softSerial_t *softSerial)
+{
+    const timerHardware_t *timerHardware = softSerial->timerHardware;
+
+    IOConfigGPIOAF(softSerial->rxIO, (softSerial->port.options & SERIAL_INVERTED) ? IOCFG_AF_PP_PD : IOCFG_AF_PP_UP, timerHardware->alternateFunction);
+
+    TIM_ICInitTypeDef TIM_ICInitStructure;
+    TIM_ICStructInit(&TIM_ICInitStructure);
+    TIM_ICInitStructure.TIM_Channel = timerHardware->channel;
+    TIM_ICInitStructure.TIM_ICPolarity = TIM_ICPolarity_BothEdge;
+    TIM_ICInitStructure.TIM_ICSelection = TIM_ICSelection_DirectTI;
+    TIM_ICInitStructure.TIM_ICPrescaler = TIM_ICPSC_DIV1;
+    TIM_ICInitStructure.TIM_ICFilter = 2;
+    TIM_ICInit(timerHardware->tim, &TIM_ICInitStructure);
+
+    softSerialDmaConfigure(timerHardware, softSerial->rxEdges, SOFTSERIAL_DMA_RX_EDGES, false);
+
+    softSerial->rxEdgeIndex = 0;
+    softSerial->rxCount = timerHardware->tim->CNT;
+    softSerial->rxTime = 0;
+    softSerial->rxLastEdgeTime = 0;
+    softSerial->rxFrameActive = false;
+    softSerial->rxLineMark = IORead(softSerial->rxIO) != !!(softSerial->port.options & SERIAL_INVERTED);
+
+    DMA_Cmd(timerHardware->dmaRef, ENABLE);
+    TIM_DMACmd(timerHardware->tim, timerDmaSource(timerHardware->channel), ENABLE);
+
+    softSerial->rxActive = true;
+}
+
+static void softSerialDmaInputDeActivate(softSerial_t *softSerial)
+{
+    const timerHardware_t *timerHardware = softSerial->timerHardware;
+
+    softSerialDmaDecode(softSerial);
+
+    TIM_DMACmd(timerHardware->tim, timerDmaSource(timerHardware->channel), DISABLE);
+    DMA_Cmd(timerHardware->dmaRef, DISABLE);
+    TIM_CCxCmd(timerHardware->tim, timerHardware->channel, TIM_CCx_Disable);
+
+    softSerial->rxActive = false;
+}
+
+// Switches the channel to output, with the line held at mark
+static void softSerialDmaOutputActivate(softSerial_t *softSerial)
+{
+    const timerHardware_t *timerHardware = softSerial->txTimerHardware;
+
+    TIM_OCInitTypeDef TIM_OCInitStructure;
+    TIM_OCStructInit(&TIM_OCInitStructure);
+    TIM_OCInitStructure.TIM_OCMode = TIM_OCMode_Timing;
+    TIM_OCInitStructure.TIM_OutputState = TIM_OutputState_Disable;
+    TIM_OCInitStructure.TIM_OCIdleState = TIM_OCIdleState_Set;
+    TIM_OCInitStructure.TIM_OCPolarity = (softSerial->port.options & SERIAL_INVERTED) ? TIM_OCPolarity_Low : TIM_OCPolarity_High;
+    timerOCInit(timerHardware->tim, timerHardware->channel, &TIM_OCInitStructure);
+    timerOCPreloadConfig(timerHardware->tim, timerHardware->channel, TIM_OCPreload_Disable);
+
+    softSerialDmaSetOCMode(timerHardware, TIM_ForcedAction_Active);
+    TIM_CCxCmd(timerHardware->tim, timerHardware->channel, TIM_CCx_Enable);
+    TIM_CtrlPWMOutputs(timerHardware->tim, ENABLE);
+
+    IOConfigGPIOAF(softSerial->txIO, IOCFG_AF_PP, timerHardware->alternateFunction);
+}
+
+// Queues the next bytes of the transmit buffer, with the first start bit at compare value start
+static void softSerialDmaStartTx(softSerial_t *softSerial, uint16_t start)
+{
+    const timerHardware_t *timerHardware = softSerial->txTimerHardware;
+    const uint16_t period = softSerial->txPeriodTicks;
+    uint32_t timeQ8 = start << 8;
+    unsigned edgeCount = 0;
+    bool lineMark = true;
+
+    for (int byteCount = 0; byteCount < SOFTSERIAL_DMA_TX_BYTES && !ringBufferIsEmpty(&softSerial->port.txBuffer); byteCount++) {
+        // stop bit (1) + data bits (MSB to LSB) + start bit (0)
+        const uint16_t frame = (1 << (TX_TOTAL_BITS - 1)) | (ringBufferPop(&softSerial->port.txBuffer) << 1);
+
+        for (int bit = 0; bit < TX_TOTAL_BITS; bit++) {
+            const bool bitMark = frame & (1 << bit);
+            if (bitMark != lineMark) {
+                softSerial->txEdges[edgeCount++] = (timeQ8 >> 8) % period;
+                lineMark = bitMark;
+            }
+            timeQ8 += softSerial->txBitTicksQ8;
+        }
+    }
+
+    // The last transfer only moves the compare past the final stop bit, the completion interrupt then holds the line
+    softSerial->txEnd = (timeQ8 >> 8) % period;
+    softSerial->txEdges[edgeCount] = softSerial->txEnd;
+
+    *timerChCCR(timerHardware) = softSerial->txEdges[0];
+    TIM_ClearFlag(timerHardware->tim, TIM_FLAG_CC1 << (timerHardware->channel >> 2));
+
+    softSerialDmaConfigure(timerHardware, &softSerial->txEdges[1], edgeCount, true);
+    DMA_ITConfig(timerHardware->dmaRef, DMA_IT_TC, ENABLE);
+    DMA_Cmd(timerHardware->dmaRef, ENABLE);
+    TIM_DMACmd(timerHardware->tim, timerDmaSource(timerHardware->channel), ENABLE);
+
+    softSerialDmaSetOCMode(timerHardware, TIM_OCMode_Toggle);
+
+    softSerial->isTransmittingData = true;
+}
+
+static void softSerialDmaKickTx(softSerial_t *softSerial)
+{
+    ATOMIC_BLOCK(NVIC_PRIO_TIMER) {
+        if (!softSerial->isTransmittingData && !ringBufferIsEmpty(&softSerial->port.txBuffer)) {
+            if (softSerial->rxActive && (softSerial->port.options & SERIAL_BIDIR)) {
+                // Half-duplex: Deactivate receiver, activate transmitter
+                softSerialDmaInputDeActivate(softSerial);
+                softSerialDmaOutputActivate(softSerial);
+            }
+            softSerial->txTurnaroundPeriods = 0;
+
+            // two bits of lead for the time taken to queue the bytes
+            const uint16_t lead = (2 * softSerial->txBitTicksQ8) >> 8;
+            softSerialDmaStartTx(softSerial, (softSerial->txTimerHardware->tim->CNT + lead) % softSerial->txPeriodTicks);
+        }
+    }
+}
+
+static void softSerialDmaTxIrqHandler(dmaChannelDescriptor_t *descriptor)
+{
+    if (DMA_GET_FLAG_STATUS(descriptor, DMA_IT_TCIF)) {
+        softSerial_t *softSerial = &softSerialPorts[descriptor->userParam];
+        const timerHardware_t *timerHardware = softSerial->txTimerHardware;
+
+        DMA_Cmd(timerHardware->dmaRef, DISABLE);
+        TIM_DMACmd(timerHardware->tim, timerDmaSource(timerHardware->channel), DISABLE);
+        DMA_CLEAR_FLAG(descriptor, DMA_IT_TCIF);
+
+        // the last edge, to mark, has just been output
+        softSerialDmaSetOCMode(timerHardware, TIM_ForcedAction_Active);
+
+        if (!ringBufferIsEmpty(&softSerial->port.txBuffer)) {
+            // an extra stop bit leaves time to queue the bytes
+            softSerialDmaStartTx(softSerial, (softSerial->txEnd + (softSerial->txBitTicksQ8 >> 8)) % softSerial->txPeriodTicks);
+            return;
+        }
+
+        softSerial->isTransmittingData = false;
+        if (softSerial->port.options & SERIAL_BIDIR) {
+            softSerial->txTurnaroundPeriods = SOFTSERIAL_DMA_TURNAROUND_PERIODS;
+        }
+    }
+}
+
+static void onSerialDmaTimerOverflow(timerOvrHandlerRec_t *cbRec, captureCompare_t capture)
+{
+    UNUSED(capture);
+    softSerial_t *self = container_of(cbRec, softSerial_t, overCb);
+
+    if (self->rxActive) {
+        softSerialDmaDecode(self);
+    }
+
+    if (self->txTurnaroundPeriods && --self->txTurnaroundPeriods == 0) {
+        softSerialDmaInputActivate(self);
+    }
+}
+
+static bool softSerialDmaOpen(softSerial_t *softSerial)
+{
+    const portMode_t mode = softSerial->port.mode;
+    const bool bidir = softSerial->port.options & SERIAL_BIDIR;
+    const bool duplex = !bidir && (mode & MODE_RX) && (mode & MODE_TX);
+    const uint8_t resourceIndex = RESOURCE_INDEX(softSerial->softSerialPortIndex + RESOURCE_SOFT_OFFSET);
+
+    softSerial->useDma = false;
+    softSerial->txTimerHardware = duplex ? softSerial->exTimerHardware : softSerial->timerHardware;
+
+    if (!softSerialDmaIsAvailable(softSerial->timerHardware, resourceIndex)) {
+        return false;
+    }
+    if (duplex && !(softSerial->txTimerHardware && softSerialDmaIsAvailable(softSerial->txTimerHardware, resourceIndex)
+        && softSerial->txTimerHardware->dmaRef != softSerial->timerHardware->dmaRef)) {
+        return false;
+    }
+
+    softSerial->useDma = true;
+    softSerial->txTurnaroundPeriods = 0;
+
+    softSerialDmaSetTimebase(softSerial, softSerial->port.baudRate);
+
+    const bool receive = (mode & MODE_RX) || bidir;
+    if (mode & MODE_TX) {
+        const dmaIdentifier_e identifier = dmaGetIdentifier(softSerial->txTimerHardware->dmaRef);
+        dmaInit(identifier, OWNER_SERIAL_TX, resourceIndex);
+        dmaSetHandler(identifier, softSerialDmaTxIrqHandler, NVIC_PRIO_TIMER, softSerial->softSerialPortIndex);
+    }
+    if (receive && !bidir) {
+        dmaInit(dmaGetIdentifier(softSerial->timerHardware->dmaRef), OWNER_SERIAL_RX, resourceIndex);
+    }
+
+    if (receive) {
+        // the overflow interrupt decodes, and turns half-duplex ports around
+        timerChOvrHandlerInit(&softSerial->overCb, onSerialDmaTimerOverflow);
+        timerChConfigCallbacks(softSerial->timerHardware, NULL, &softSerial->overCb);
+    }
+
+    if ((mode & MODE_TX) && !bidir) {
+        softSerialDmaOutputActivate(softSerial);
+    }
+    if (receive) {
+        softSerialDmaInputActivate(softSerial);
+    }
+
+    return true;
+}
+#endif
+
 serialPort_t *openSoftSerial(softSerialPortIndex_e portIndex, serialReceiveCallbackPtr rxCallback, uint32_t baud, portMode_t mode, portOptions_t options)
 {
     softSerial_t *softSerial = &(softSerialPorts[portIndex]);
@@ -308,6 +733,15 @@ serialPort_t *openSoftSerial(softSerialPortIndex_e portIndex, serialReceiveCallb
 
     softSerial->rxActive = false;
     softSerial->isTransmittingData = false;
+    softSerial->txGapUs = 0;
+    softSerial->txGapBits = 0;
+    softSerial->txGapBitsLeft = 0;
+
+#ifdef USE_SOFTSERIAL_DMA
+    if (softSerialDmaOpen(softSerial)) {
+        return &softSerial->port;
+    }
+#endif
 
     // Configure master timer (on RX); time base and input capture
 
@@ -367,12 +801,16 @@ void processTxState(softSerial_t *softSerial)
             return;
         }
 
-        // data to send
-        uint8_t byteToSend = softSerial->port.txBuffer[softSerial->port.txBufferTail++];
-        if (softSerial->port.txBufferTail >= softSerial->port.txBufferSize) {
-            softSerial->port.txBufferTail = 0;
+        // the line stays idle for the gap after the previous byte
+        if (softSerial->txGapBitsLeft) {
+            softSerial->txGapBitsLeft--;
+            return;
         }
 
+        // data to send
+        uint8_t byteToSend = ringBufferPop(&softSerial->port.txBuffer);
+        softSerial->txGapBitsLeft = softSerial->txGapBits;
+
         // build internal buffer, MSB = Stop Bit (1) + data bits (MSB to LSB) + start bit(0) LSB
         softSerial->internalTxBuffer = (1 << (TX_TOTAL_BITS - 1)) | (byteToSend << 1);
         softSerial->bitsLeftToTransmit = TX_TOTAL_BITS;
@@ -448,8 +886,8 @@ void extractAndStoreRxByte(softSerial_t *softSerial)
     if (softSerial->port.rxCallback) {
         softSerial->port.rxCallback(rxByte);
     } else {
-        softSerial->port.rxBuffer[softSerial->port.rxBufferHead] = rxByte;
-        softSerial->port.rxBufferHead = (softSerial->port.rxBufferHead + 1) % softSerial->port.rxBufferSize;
+        ringBufferPush(&softSerial->port.rxBuffer, rxByte);
+        serialSignalRxEvent();
     }
 }
 
@@ -561,9 +999,16 @@ uint32_t softSerialRxBytesWaiting(const serialPort_t *instance)
         return 0;
     }
 
-    softSerial_t *s = (softSerial_t *)instance;
+#ifdef USE_SOFTSERIAL_DMA
+    softSerial_t *softSerial = (softSerial_t *)instance;
+    if (softSerial->useDma && softSerial->rxActive) {
+        ATOMIC_BLOCK(NVIC_PRIO_TIMER) {
+            softSerialDmaDecode(softSerial);
+        }
+    }
+#endif
 
-    return (s->port.rxBufferHead - s->port.rxBufferTail) & (s->port.rxBufferSize - 1);
+    return ringBufferCount(&instance->rxBuffer);
 }
 
 uint32_t softSerialTxBytesFree(const serialPort_t *instance)
@@ -572,38 +1017,55 @@ uint32_t softSerialTxBytesFree(const serialPort_t *instance)
         return 0;
     }
 
-    softSerial_t *s = (softSerial_t *)instance;
-
-    uint8_t bytesUsed = (s->port.txBufferHead - s->port.txBufferTail) & (s->port.txBufferSize - 1);
-
-    return (s->port.txBufferSize - 1) - bytesUsed;
+    return ringBufferFree(&instance->txBuffer);
 }
 
 uint8_t softSerialReadByte(serialPort_t *instance)
 {
-    uint8_t ch;
-
     if ((instance->mode & MODE_RX) == 0) {
         return 0;
     }
 
-    if (softSerialRxBytesWaiting(instance) == 0) {
-        return 0;
+    return ringBufferPop(&instance->rxBuffer);
+}
+
+void softSerialWriteByte(serialPort_t *s, uint8_t ch)
+{
+    if ((s->mode & MODE_TX) == 0) {
+        return;
     }
 
-    ch = instance->rxBuffer[instance->rxBufferTail];
-    instance->rxBufferTail = (instance->rxBufferTail + 1) % instance->rxBufferSize;
-    return ch;
+    ringBufferPush(&s->txBuffer, ch);
+
+#ifdef USE_SOFTSERIAL_DMA
+    if (((softSerial_t *)s)->useDma) {
+        softSerialDmaKickTx((softSerial_t *)s);
+    }
+#endif
 }
 
-void softSerialWriteByte(serialPort_t *s, uint8_t ch)
+void softSerialWriteBuf(serialPort_t *s, const void *data, int count)
 {
     if ((s->mode & MODE_TX) == 0) {
         return;
     }
 
-    s->txBuffer[s->txBufferHead] = ch;
-    s->txBufferHead = (s->txBufferHead + 1) % s->txBufferSize;
+    const uint8_t *p = data;
+    while (count > 0) {
+        const uint32_t written = ringBufferWrite(&s->txBuffer, p, count);
+        p += written;
+        count -= written;
+#ifdef USE_SOFTSERIAL_DMA
+        if (((softSerial_t *)s)->useDma) {
+            softSerialDmaKickTx((softSerial_t *)s);
+        }
+#endif
+    }
+}
+
+static uint8_t softSerialGapBits(uint32_t gapUs, uint32_t baudRate)
+{
+    return MIN(((uint64_t)gapUs * baudRate + 999999) / 1000000, UINT8_MAX);
 }
 
 void softSerialSetBaudRate(serialPort_t *s, uint32_t baudRate)
@@ -611,6 +1073,19 @@ void softSerialSetBaudRate(serialPort_t *s, uint32_t baudRate)
     softSerial_t *softSerial = (softSerial_t *)s;
 
     softSerial->port.baudRate = baudRate;
+    softSerial->txGapBits = softSerialGapBits(softSerial->txGapUs, baudRate);
+
+#ifdef USE_SOFTSERIAL_DMA
+    if (softSerial->useDma) {
+        ATOMIC_BLOCK(NVIC_PRIO_TIMER) {
+            softSerialDmaSetTimebase(softSerial, baudRate);
+            if (softSerial->rxActive) {
+                softSerialDmaInputActivate(softSerial);
+            }
+        }
+        return;
+    }
+#endif
 
     serialTimerConfigureTimebase(softSerial->timerHardware, baudRate);
 }
@@ -622,7 +1097,24 @@ void softSerialSetMode(serialPort_t *instance, portMode_t mode)
 
 bool isSoftSerialTransmitBufferEmpty(const serialPort_t *instance)
 {
-    return instance->txBufferHead == instance->txBufferTail;
+    return ringBufferIsEmpty(&instance->txBuffer);
+}
+
+// The bit timer counts the gap, so the bytes can be queued at once
+static bool softSerialSetTxByteGap(serialPort_t *instance, uint32_t gapUs)
+{
+    softSerial_t *softSerial = (softSerial_t *)instance;
+
+#ifdef USE_SOFTSERIAL_DMA
+    // transfers are timed within one counter period, a gap doesn't fit in it
+    if (softSerial->useDma) {
+        return gapUs == 0;
+    }
+#endif
+
+    softSerial->txGapUs = gapUs;
+    softSerial->txGapBits = softSerialGapBits(gapUs, instance->baudRate);
+    return true;
 }
 
 static const struct serialPortVTable softSerialVTable = {
@@ -633,9 +1125,12 @@ static const struct serialPortVTable softSerialVTable = {
     .serialSetBaudRate = softSerialSetBaudRate,
     .isSerialTransmitBufferEmpty = isSoftSerialTransmitBufferEmpty,
     .setMode = softSerialSetMode,
-    .writeBuf = NULL,
+    .writeBuf = softSerialWriteBuf,
     .beginWrite = NULL,
-    .endWrite = NULL
+    .endWrite = NULL,
+    .reserveWrite = NULL,
+    .commitWrite = NULL,
+    .setTxByteGap = softSerialSetTxByteGap
 };
 
 #endif
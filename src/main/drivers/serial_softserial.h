@@ -28,6 +28,7 @@ serialPort_t *openSoftSerial(softSerialPortIndex_e portIndex, serialReceiveCallb
 
 // serialPort API
 void softSerialWriteByte(serialPort_t *instance, uint8_t ch);
+void softSerialWriteBuf(serialPort_t *instance, const void *data, int count);
 uint32_t softSerialRxBytesWaiting(const serialPort_t *instance);
 uint32_t softSerialTxBytesFree(const serialPort_t *instance);
 uint8_t softSerialReadByte(serialPort_t *instance);
@@ -50,8 +50,12 @@ static void onData(dyad_Event *e) {
 }
 static void onClose(dyad_Event *e) {
 	tcpPort_t* s = (tcpPort_t*)(e->udata);
-	s->clientCount--;
-	s->conn = NULL;
+	for (int i = 0; i < TCP_MAX_CLIENTS; i++) {
+		if (s->clients[i] == e->stream) {
+			s->clients[i] = NULL;
+			s->clientCount--;
+		}
+	}
 	fprintf(stderr, "[CLS]UART%u: %d,%d\n", s->id + 1, s->connected, s->clientCount);
 	if (s->clientCount == 0) {
 		s->connected = false;
@@ -61,14 +65,18 @@ static void onAccept(dyad_Event *e) {
 	tcpPort_t* s = (tcpPort_t*)(e->udata);
 	fprintf(stderr, "New connection on UART%u, %d\n", s->id + 1, s->clientCount);
 
-	s->connected = true;
-	if (s->clientCount > 0) {
+	int slot = 0;
+	while (slot < TCP_MAX_CLIENTS && s->clients[slot]) {
+		slot++;
+	}
+	if (slot == TCP_MAX_CLIENTS) {
 		dyad_close(e->remote);
 		return;
 	}
+	s->clients[slot] = e->remote;
 	s->clientCount++;
+	s->connected = true;
 	fprintf(stderr, "[NEW]UART%u: %d,%d\n", s->id + 1, s->connected, s->clientCount);
-	s->conn = e->remote;
 	dyad_setNoDelay(e->remote, 1);
 	dyad_setTimeout(e->remote, 120);
 	dyad_addListener(e->remote, DYAD_EVENT_DATA, onData, e->udata);
@@ -98,15 +106,18 @@ static tcpPort_t* tcpReconfigure(tcpPort_t *s, int id)
 	s->connected = false;
 	s->clientCount = 0;
 	s->id = id;
-	s->conn = NULL;
+	for (int i = 0; i < TCP_MAX_CLIENTS; i++) {
+		s->clients[i] = NULL;
+	}
 	s->serv = dyad_newStream();
 	dyad_setNoDelay(s->serv, 1);
 	dyad_addListener(s->serv, DYAD_EVENT_ACCEPT, onAccept, s);
 
-	if (dyad_listenEx(s->serv, NULL, BASE_PORT + id + 1, 10) == 0) {
-		fprintf(stderr, "bind port %u for UART%u\n", (unsigned)BASE_PORT + id + 1, (unsigned)id + 1);
+	const int port = BASE_PORT + simulatorPortOffset() + id + 1;
+	if (dyad_listenEx(s->serv, NULL, port, 10) == 0) {
+		fprintf(stderr, "bind port %u for UART%u\n", (unsigned)port, (unsigned)id + 1);
 	} else {
-		fprintf(stderr, "bind port %u for UART%u failed!!\n", (unsigned)BASE_PORT + id + 1, (unsigned)id + 1);
+		fprintf(stderr, "bind port %u for UART%u failed!!\n", (unsigned)port, (unsigned)id + 1);
 	}
 	return s;
 }
@@ -126,12 +137,8 @@ serialPort_t *serTcpOpen(int id, serialReceiveCallbackPtr rxCallback, uint32_t b
     s->port.vTable = &tcpVTable;
 
     // common serial initialisation code should move to serialPort::init()
-    s->port.rxBufferHead = s->port.rxBufferTail = 0;
-    s->port.txBufferHead = s->port.txBufferTail = 0;
-	s->port.rxBufferSize = RX_BUFFER_SIZE;
-	s->port.txBufferSize = TX_BUFFER_SIZE;
-	s->port.rxBuffer = s->rxBuffer;
-	s->port.txBuffer = s->txBuffer;
+    ringBufferInit(&s->port.rxBuffer, s->rxBuffer, RX_BUFFER_SIZE);
+    ringBufferInit(&s->port.txBuffer, s->txBuffer, TX_BUFFER_SIZE);
 
     // callback works for IRQ-based RX ONLY
     s->port.rxCallback = rxCallback;
@@ -147,11 +154,7 @@ uint32_t tcpTotalRxBytesWaiting(const serialPort_t *instance)
     tcpPort_t *s = (tcpPort_t*)instance;
     uint32_t count;
     pthread_mutex_lock(&s->rxLock);
-    if (s->port.rxBufferHead >= s->port.rxBufferTail) {
-        count = s->port.rxBufferHead - s->port.rxBufferTail;
-    } else {
-        count = s->port.rxBufferSize + s->port.rxBufferHead - s->port.rxBufferTail;
-    }
+    count = ringBufferCount(&s->port.rxBuffer);
     pthread_mutex_unlock(&s->rxLock);
 
     return count;
@@ -160,15 +163,9 @@ uint32_t tcpTotalRxBytesWaiting(const serialPort_t *instance)
 uint32_t tcpTotalTxBytesFree(const serialPort_t *instance)
 {
     tcpPort_t *s = (tcpPort_t*)instance;
-    uint32_t bytesUsed;
 
     pthread_mutex_lock(&s->txLock);
-    if (s->port.txBufferHead >= s->port.txBufferTail) {
-        bytesUsed = s->port.txBufferHead - s->port.txBufferTail;
-    } else {
-        bytesUsed = s->port.txBufferSize + s->port.txBufferHead - s->port.txBufferTail;
-    }
-    uint32_t bytesFree = (s->port.txBufferSize - 1) - bytesUsed;
+    uint32_t bytesFree = ringBufferFree(&s->port.txBuffer);
     pthread_mutex_unlock(&s->txLock);
 
     return bytesFree;
@@ -178,7 +175,7 @@ bool isTcpTransmitBufferEmpty(const serialPort_t *instance)
 {
     tcpPort_t *s = (tcpPort_t *)instance;
     pthread_mutex_lock(&s->txLock);
-    bool isEmpty = s->port.txBufferTail == s->port.txBufferHead;
+    bool isEmpty = ringBufferIsEmpty(&s->port.txBuffer);
     pthread_mutex_unlock(&s->txLock);
     return isEmpty;
 }
@@ -189,12 +186,7 @@ uint8_t tcpRead(serialPort_t *instance)
     tcpPort_t *s = (tcpPort_t *)instance;
     pthread_mutex_lock(&s->rxLock);
 
-    ch = s->port.rxBuffer[s->port.rxBufferTail];
-    if (s->port.rxBufferTail + 1 >= s->port.rxBufferSize) {
-        s->port.rxBufferTail = 0;
-    } else {
-        s->port.rxBufferTail++;
-    }
+    ch = ringBufferPop(&s->port.rxBuffer);
     pthread_mutex_unlock(&s->rxLock);
 
     return ch;
@@ -205,53 +197,59 @@ void tcpWrite(serialPort_t *instance, uint8_t ch)
     tcpPort_t *s = (tcpPort_t *)instance;
     pthread_mutex_lock(&s->txLock);
 
-    s->port.txBuffer[s->port.txBufferHead] = ch;
-    if (s->port.txBufferHead + 1 >= s->port.txBufferSize) {
-        s->port.txBufferHead = 0;
-    } else {
-        s->port.txBufferHead++;
-    }
+    ringBufferPush(&s->port.txBuffer, ch);
     pthread_mutex_unlock(&s->txLock);
+}
 
-    tcpDataOut(s);
+void tcpWriteBuf(serialPort_t *instance, const void *data, int count)
+{
+    tcpPort_t *s = (tcpPort_t *)instance;
+
+    // never waits for the network, what doesn't fit is dropped as on a UART
+    pthread_mutex_lock(&s->txLock);
+    ringBufferWrite(&s->port.txBuffer, data, count);
+    pthread_mutex_unlock(&s->txLock);
 }
 
+// Sends the transmit buffer to every client, or drops it when there are none
 void tcpDataOut(tcpPort_t *instance)
 {
     tcpPort_t *s = (tcpPort_t *)instance;
-    if (s->conn == NULL) return;
     pthread_mutex_lock(&s->txLock);
 
-    if (s->port.txBufferHead < s->port.txBufferTail) {
-        // send data till end of buffer
-        int chunk = s->port.txBufferSize - s->port.txBufferTail;
-        dyad_write(s->conn, (const void *)&s->port.txBuffer[s->port.txBufferTail], chunk);
-        s->port.txBufferTail = 0;
+    // at most two chunks, up to the end of the buffer and then from its start
+    volatile uint8_t *data;
+    uint32_t chunk;
+    while ((chunk = ringBufferPeekContiguous(&s->port.txBuffer, &data))) {
+        for (int i = 0; i < TCP_MAX_CLIENTS; i++) {
+            if (s->clients[i]) {
+                dyad_write(s->clients[i], (const void *)data, chunk);
+            }
+        }
+        ringBufferAdvance(&s->port.txBuffer, chunk);
     }
-    int chunk = s->port.txBufferHead - s->port.txBufferTail;
-    if (chunk)
-        dyad_write(s->conn, (const void*)&s->port.txBuffer[s->port.txBufferTail], chunk);
-    s->port.txBufferTail = s->port.txBufferHead;
 
     pthread_mutex_unlock(&s->txLock);
 }
 
+// dyad is not thread safe, so the flight code only fills the ring buffers and the dyad thread moves the data
+void tcpUpdate(void)
+{
+    for (int id = 0; id < SERIAL_PORT_COUNT; id++) {
+        if (tcpPortInitialized[id]) {
+            tcpDataOut(&tcpSerialPorts[id]);
+        }
+    }
+}
+
 void tcpDataIn(tcpPort_t *instance, uint8_t* ch, int size)
 {
     tcpPort_t *s = (tcpPort_t *)instance;
 	pthread_mutex_lock(&s->rxLock);
 
-	while (size--) {
-//		printf("%c", *ch);
-		s->port.rxBuffer[s->port.rxBufferHead] = *(ch++);
-		if (s->port.rxBufferHead + 1 >= s->port.rxBufferSize) {
-		    s->port.rxBufferHead = 0;
-		} else {
-		    s->port.rxBufferHead++;
-		}
-	}
+	ringBufferWrite(&s->port.rxBuffer, ch, size);
+	serialSignalRxEvent();
 	pthread_mutex_unlock(&s->rxLock);
-//	printf("\n");
 }
 
 static const struct serialPortVTable tcpVTable = {
@@ -262,7 +260,9 @@ static const struct serialPortVTable tcpVTable = {
         .serialSetBaudRate = NULL,
         .isSerialTransmitBufferEmpty = isTcpTransmitBufferEmpty,
         .setMode = NULL,
-        .writeBuf = NULL,
+        .writeBuf = tcpWriteBuf,
         .beginWrite = NULL,
         .endWrite = NULL,
+        .reserveWrite = NULL,
+        .commitWrite = NULL,
 };
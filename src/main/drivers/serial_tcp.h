@@ -21,8 +21,10 @@
 #include <pthread.h>
 #include "dyad.h"
 
-#define RX_BUFFER_SIZE    1400
-#define TX_BUFFER_SIZE    1400
+#define RX_BUFFER_SIZE    2048
+#define TX_BUFFER_SIZE    2048
+
+#define TCP_MAX_CLIENTS   4     // per port, e.g. a configurator and an MSP viewer
 
 typedef struct {
     serialPort_t port;
@@ -30,7 +32,7 @@ typedef struct {
     uint8_t txBuffer[TX_BUFFER_SIZE];
 
     dyad_Stream *serv;
-    dyad_Stream *conn;
+    dyad_Stream *clients[TCP_MAX_CLIENTS];
     pthread_mutex_t txLock;
     pthread_mutex_t rxLock;
     bool connected;
@@ -40,9 +42,10 @@ typedef struct {
 
 serialPort_t *serTcpOpen(int id, serialReceiveCallbackPtr rxCallback, uint32_t baudRate, portMode_t mode, portOptions_t options);
 
-// tcpPort API
+// tcpPort API, called from the dyad thread only
 void tcpDataIn(tcpPort_t *instance, uint8_t* ch, int size);
 void tcpDataOut(tcpPort_t *instance);
+void tcpUpdate(void);
 
 bool tcpIsStart(void);
 bool* tcpGetUsed(void);
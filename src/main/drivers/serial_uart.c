@@ -24,12 +24,14 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "platform.h"
 
 #include "build/build_config.h"
 #include "build/atomic.h"
 
+#include "common/maths.h"
 #include "common/utils.h"
 
 #include "drivers/dma.h"
@@ -42,6 +44,10 @@
 #include "drivers/serial_uart.h"
 #include "drivers/serial_uart_impl.h"
 
+// The port buffers are ring buffers, which index by masking
+STATIC_ASSERT((UART_RX_BUFFER_SIZE & (UART_RX_BUFFER_SIZE - 1)) == 0, uart_rx_buffer_size_not_power_of_2);
+STATIC_ASSERT((UART_TX_BUFFER_SIZE & (UART_TX_BUFFER_SIZE - 1)) == 0, uart_tx_buffer_size_not_power_of_2);
+
 void uartSetBaudRate(serialPort_t *instance, uint32_t baudRate)
 {
     uartPort_t *uartPort = (uartPort_t *)instance;
@@ -78,23 +84,19 @@ void uartTryStartTxDMA(uartPort_t *s)
 
         // DMA_Cmd(s->txDMAStream, DISABLE); // XXX It's already disabled.
 
-        if (s->port.txBufferHead == s->port.txBufferTail) {
+        if (ringBufferIsEmpty(&s->port.txBuffer)) {
             // No more data to transmit.
             s->txDMAEmpty = true;
             return;
         }
 
-        // Start a new transaction.
-
-        DMA_MemoryTargetConfig(s->txDMAStream, (uint32_t)&s->port.txBuffer[s->port.txBufferTail], DMA_Memory_0);
-        //s->txDMAStream->M0AR = (uint32_t)&s->port.txBuffer[s->port.txBufferTail];
-        if (s->port.txBufferHead > s->port.txBufferTail) {
-            s->txDMAStream->NDTR = s->port.txBufferHead - s->port.txBufferTail;
-            s->port.txBufferTail = s->port.txBufferHead;
-        }
-        else {
-            s->txDMAStream->NDTR = s->port.txBufferSize - s->port.txBufferTail;
-            s->port.txBufferTail = 0;
+        // Start a new transaction on the contiguous part of the buffer, the rest goes on the next TC.
+        {
+            volatile uint8_t *data;
+            const uint32_t size = ringBufferPeekContiguous(&s->port.txBuffer, &data);
+            DMA_MemoryTargetConfig(s->txDMAStream, (uint32_t)data, DMA_Memory_0);
+            s->txDMAStream->NDTR = size;
+            ringBufferAdvance(&s->port.txBuffer, size);
         }
         s->txDMAEmpty = false;
 
@@ -115,21 +117,19 @@ void uartTryStartTxDMA(uartPort_t *s)
             goto reenable;
         }
 
-        if (s->port.txBufferHead == s->port.txBufferTail) {
+        if (ringBufferIsEmpty(&s->port.txBuffer)) {
             // No more data to transmit.
             s->txDMAEmpty = true;
             return;
         }
 
-        // Start a new transaction.
-
-        s->txDMAChannel->CMAR = (uint32_t)&s->port.txBuffer[s->port.txBufferTail];
-        if (s->port.txBufferHead > s->port.txBufferTail) {
-            s->txDMAChannel->CNDTR = s->port.txBufferHead - s->port.txBufferTail;
-            s->port.txBufferTail = s->port.txBufferHead;
-        } else {
-            s->txDMAChannel->CNDTR = s->port.txBufferSize - s->port.txBufferTail;
-            s->port.txBufferTail = 0;
+        // Start a new transaction on the contiguous part of the buffer, the rest goes on the next TC.
+        {
+            volatile uint8_t *data;
+            const uint32_t size = ringBufferPeekContiguous(&s->port.txBuffer, &data);
+            s->txDMAChannel->CMAR = (uint32_t)data;
+            s->txDMAChannel->CNDTR = size;
+            ringBufferAdvance(&s->port.txBuffer, size);
         }
         s->txDMAEmpty = false;
 
@@ -152,28 +152,69 @@ uint32_t uartTotalRxBytesWaiting(const serialPort_t *instance)
         if (rxDMAHead >= s->rxDMAPos) {
             return rxDMAHead - s->rxDMAPos;
         } else {
-            return s->port.rxBufferSize + rxDMAHead - s->rxDMAPos;
+            return s->port.rxBuffer.size + rxDMAHead - s->rxDMAPos;
         }
     }
 
-    if (s->port.rxBufferHead >= s->port.rxBufferTail) {
-        return s->port.rxBufferHead - s->port.rxBufferTail;
-    } else {
-        return s->port.rxBufferSize + s->port.rxBufferHead - s->port.rxBufferTail;
+    return ringBufferCount(&s->port.rxBuffer);
+}
+
+#ifdef USE_UART_RX_DMA
+static bool uartRxDMAEnabled;
+
+// A UART only takes its RX DMA stream or channel once uartEnableRxDMA() has been called, and only if it is still free
+bool uartIsRxDMAAvailable(dmaIdentifier_e identifier)
+{
+    const resourceOwner_e owner = dmaGetOwner(identifier);
+
+    return uartRxDMAEnabled && (owner == OWNER_FREE || owner == OWNER_SERIAL_RX);
+}
+
+/*
+ * Called once the other drivers have taken the DMA they need. The ports already open are opened again to start using
+ * RX DMA, after they have sent what is in their transmit buffers. Anything received and not yet read is lost.
+ */
+void uartEnableRxDMA(void)
+{
+    uartRxDMAEnabled = true;
+
+    for (int device = 0; device < UARTDEV_COUNT_MAX; device++) {
+        uartDevice_t *uartdev = uartDevmap[device];
+        if (!uartdev || !uartdev->port.USARTx || !(uartdev->port.port.mode & MODE_RX)) {
+            // Not opened
+            continue;
+        }
+
+        uartPort_t *s = &uartdev->port;
+        while (!isUartTransmitBufferEmpty(&s->port)) {
+        }
+        uartOpen(device, s->port.rxCallback, s->port.baudRate, s->port.mode, s->port.options);
     }
 }
 
+/*
+ * Pass what the RX DMA has received to the port's callback. Called when the line goes idle at the end of a frame, or
+ * when the DMA buffer is half or completely full, so the callback gets whole frames rather than an interrupt per byte.
+ */
+void uartRxDMAToCallback(uartPort_t *s)
+{
+    if (!s->port.rxCallback) {
+        // The bytes are left for uartRead() in the serial task
+        serialSignalRxEvent();
+        return;
+    }
+
+    while (uartTotalRxBytesWaiting(&s->port) > 0) {
+        s->port.rxCallback(uartRead(&s->port));
+    }
+}
+#endif
+
 uint32_t uartTotalTxBytesFree(const serialPort_t *instance)
 {
     const uartPort_t *s = (const uartPort_t*)instance;
 
-    uint32_t bytesUsed;
-
-    if (s->port.txBufferHead >= s->port.txBufferTail) {
-        bytesUsed = s->port.txBufferHead - s->port.txBufferTail;
-    } else {
-        bytesUsed = s->port.txBufferSize + s->port.txBufferHead - s->port.txBufferTail;
-    }
+    uint32_t bytesUsed = ringBufferCount(&s->port.txBuffer);
 
 #ifdef STM32F4
     if (s->txDMAStream) {
@@ -198,12 +239,12 @@ uint32_t uartTotalTxBytesFree(const serialPort_t *instance)
          *
          * Be kind to callers and pretend like our buffer can only ever be 100% full.
          */
-        if (bytesUsed >= s->port.txBufferSize - 1) {
+        if (bytesUsed >= s->port.txBuffer.size - 1) {
             return 0;
         }
     }
 
-    return (s->port.txBufferSize - 1) - bytesUsed;
+    return (s->port.txBuffer.size - 1) - bytesUsed;
 }
 
 bool isUartTransmitBufferEmpty(const serialPort_t *instance)
@@ -216,7 +257,7 @@ bool isUartTransmitBufferEmpty(const serialPort_t *instance)
 #endif
         return s->txDMAEmpty;
     else
-        return s->port.txBufferTail == s->port.txBufferHead;
+        return ringBufferIsEmpty(&s->port.txBuffer);
 }
 
 uint8_t uartRead(serialPort_t *instance)
@@ -229,43 +270,125 @@ uint8_t uartRead(serialPort_t *instance)
 #else
     if (s->rxDMAChannel) {
 #endif
-        ch = s->port.rxBuffer[s->port.rxBufferSize - s->rxDMAPos];
+        ch = s->port.rxBuffer.buffer[s->port.rxBuffer.size - s->rxDMAPos];
         if (--s->rxDMAPos == 0)
-            s->rxDMAPos = s->port.rxBufferSize;
+            s->rxDMAPos = s->port.rxBuffer.size;
     } else {
-        ch = s->port.rxBuffer[s->port.rxBufferTail];
-        if (s->port.rxBufferTail + 1 >= s->port.rxBufferSize) {
-            s->port.rxBufferTail = 0;
-        } else {
-            s->port.rxBufferTail++;
-        }
+        ch = ringBufferPop(&s->port.rxBuffer);
     }
 
     return ch;
 }
 
-void uartWrite(serialPort_t *instance, uint8_t ch)
+// Copies up to count received bytes out, in at most two chunks, rather than a call per byte
+uint32_t uartReadBuf(serialPort_t *instance, uint8_t *data, uint32_t count)
 {
     uartPort_t *s = (uartPort_t *)instance;
-    s->port.txBuffer[s->port.txBufferHead] = ch;
-    if (s->port.txBufferHead + 1 >= s->port.txBufferSize) {
-        s->port.txBufferHead = 0;
-    } else {
-        s->port.txBufferHead++;
+
+#ifdef STM32F4
+    if (s->rxDMAStream) {
+#else
+    if (s->rxDMAChannel) {
+#endif
+        count = MIN(count, uartTotalRxBytesWaiting(instance));
+        uint32_t remaining = count;
+        while (remaining > 0) {
+            // rxDMAPos counts down to the end of the buffer, where the DMA wraps
+            const uint32_t chunk = MIN(remaining, s->rxDMAPos);
+            memcpy(data, (const uint8_t *)&s->port.rxBuffer.buffer[s->port.rxBuffer.size - s->rxDMAPos], chunk);
+            data += chunk;
+            remaining -= chunk;
+            s->rxDMAPos -= chunk;
+            if (s->rxDMAPos == 0)
+                s->rxDMAPos = s->port.rxBuffer.size;
+        }
+        return count;
     }
 
+    return ringBufferRead(&s->port.rxBuffer, data, count);
+}
+
+static void uartStartTx(uartPort_t *s)
+{
 #ifdef STM32F4
     if (s->txDMAStream)
 #else
     if (s->txDMAChannel)
 #endif
     {
-        uartTryStartTxDMA(s); 
+        uartTryStartTxDMA(s);
     } else {
         USART_ITConfig(s->USARTx, USART_IT_TXE, ENABLE);
     }
 }
 
+void uartWrite(serialPort_t *instance, uint8_t ch)
+{
+    uartPort_t *s = (uartPort_t *)instance;
+    ringBufferPush(&s->port.txBuffer, ch);
+    uartStartTx(s);
+}
+
+// Queues the buffer in chunks and kicks the transmitter once per chunk, rather than once per byte.
+// Blocks until all of the buffer has been queued.
+void uartWriteBuf(serialPort_t *instance, const void *data, int count)
+{
+    uartPort_t *s = (uartPort_t *)instance;
+    const uint8_t *p = data;
+
+    while (count > 0) {
+        // The ring buffer's own free space still includes the bytes of a DMA transfer in progress
+        const uint32_t chunk = MIN((uint32_t)count, uartTotalTxBytesFree(instance));
+        if (chunk) {
+            const uint32_t written = ringBufferWrite(&s->port.txBuffer, p, chunk);
+            uartStartTx(s);
+            p += written;
+            count -= written;
+        }
+    }
+}
+
+/*
+ * Points *data at the free space that can be written without wrapping, for the caller to fill and pass to
+ * uartCommitWrite(). An empty buffer that nothing is being sent from is rewound first, so all of it is in one piece.
+ */
+uint32_t uartReserveWrite(serialPort_t *instance, uint8_t **data)
+{
+    uartPort_t *s = (uartPort_t *)instance;
+
+    if (ringBufferIsEmpty(&s->port.txBuffer)) {
+#ifdef STM32F4
+        if (s->txDMAStream) {
+#else
+        if (s->txDMAChannel) {
+#endif
+            // The tail moves when a transfer starts, so the buffer is only free once the transfer has completed
+            if (s->txDMAEmpty) {
+                ringBufferReset(&s->port.txBuffer);
+            }
+        } else {
+            // With TXE off the interrupt handler no longer looks at the buffer
+            USART_ITConfig(s->USARTx, USART_IT_TXE, DISABLE);
+            ringBufferReset(&s->port.txBuffer);
+        }
+    }
+
+    volatile uint8_t *head;
+    const uint32_t contiguous = ringBufferReserveContiguous(&s->port.txBuffer, &head);
+    *data = (uint8_t *)head;
+
+    // The bytes of a DMA transfer in progress are the last ones before the tail, leave them alone
+    const uint32_t txFree = uartTotalTxBytesFree(instance);
+    return MIN(contiguous, txFree);
+}
+
+void uartCommitWrite(serialPort_t *instance, uint32_t count)
+{
+    uartPort_t *s = (uartPort_t *)instance;
+    ringBufferCommit(&s->port.txBuffer, count);
+    uartStartTx(s);
+}
+
 const struct serialPortVTable uartVTable[] = {
     {
         .serialWrite = uartWrite,
@@ -275,12 +398,27 @@ const struct serialPortVTable uartVTable[] = {
         .serialSetBaudRate = uartSetBaudRate,
         .isSerialTransmitBufferEmpty = isUartTransmitBufferEmpty,
         .setMode = uartSetMode,
-        .writeBuf = NULL,
+        .writeBuf = uartWriteBuf,
         .beginWrite = NULL,
         .endWrite = NULL,
+        .reserveWrite = uartReserveWrite,
+        .commitWrite = uartCommitWrite,
+        .readBuf = uartReadBuf,
     }
 };
 
+// Overruns on all the UARTs since power up, the F1 does not count them
+uint32_t uartGetOverrunCounter(void)
+{
+    uint32_t overruns = 0;
+    for (int i = 0; i < UARTDEV_COUNT_MAX; i++) {
+        if (uartDevmap[i]) {
+            overruns += uartDevmap[i]->port.overrunErrors;
+        }
+    }
+    return overruns;
+}
+
 #ifdef USE_UART1
 // USART1 Rx/Tx IRQ Handler
 void USART1_IRQHandler(void)
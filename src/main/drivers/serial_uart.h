@@ -69,15 +69,28 @@ typedef struct uartPort_s {
     UART_HandleTypeDef Handle;
 #endif
     USART_TypeDef *USARTx;
+    volatile uint16_t overrunErrors;    // received bytes lost because the last one had not been read yet
 } uartPort_t;
 
 void uartPinConfigure(const serialPinConfig_t *pSerialPinConfig);
+uint32_t uartGetOverrunCounter(void);
 serialPort_t *uartOpen(UARTDevice device, serialReceiveCallbackPtr rxCallback, uint32_t baudRate, portMode_t mode, portOptions_t options);
+#ifdef USE_UART_RX_DMA
+void uartEnableRxDMA(void);
+#endif
+#if defined(STM32F3) || defined(STM32F4)
+serialPort_t *uartOpenOnTxPin(ioTag_t txTag, serialReceiveCallbackPtr rxCallback, uint32_t baudRate, portMode_t mode);
+void uartCloseOnTxPin(serialPort_t *instance);
+#endif
 
 // serialPort API
 void uartWrite(serialPort_t *instance, uint8_t ch);
+void uartWriteBuf(serialPort_t *instance, const void *data, int count);
+uint32_t uartReserveWrite(serialPort_t *instance, uint8_t **data);
+void uartCommitWrite(serialPort_t *instance, uint32_t count);
 uint32_t uartTotalRxBytesWaiting(const serialPort_t *instance);
 uint32_t uartTotalTxBytesFree(const serialPort_t *instance);
 uint8_t uartRead(serialPort_t *instance);
+uint32_t uartReadBuf(serialPort_t *instance, uint8_t *data, uint32_t count);
 void uartSetBaudRate(serialPort_t *s, uint32_t baudRate);
 bool isUartTransmitBufferEmpty(const serialPort_t *s);
@@ -29,6 +29,7 @@
 
 #include "build/build_config.h"
 
+#include "common/maths.h"
 #include "common/utils.h"
 #include "drivers/io.h"
 #include "drivers/nvic.h"
@@ -82,7 +83,7 @@ void uartReconfigure(uartPort_t *uartPort)
     uartPort->Handle.Init.WordLength = (uartPort->port.options & SERIAL_PARITY_EVEN) ? UART_WORDLENGTH_9B : UART_WORDLENGTH_8B;
     uartPort->Handle.Init.StopBits = (uartPort->port.options & SERIAL_STOPBITS_2) ? USART_STOPBITS_2 : USART_STOPBITS_1;
     uartPort->Handle.Init.Parity = (uartPort->port.options & SERIAL_PARITY_EVEN) ? USART_PARITY_EVEN : USART_PARITY_NONE;
-    uartPort->Handle.Init.HwFlowCtl = UART_HWCONTROL_NONE;
+    uartPort->Handle.Init.HwFlowCtl = (uartPort->port.options & SERIAL_CTS) ? UART_HWCONTROL_CTS : UART_HWCONTROL_NONE;
     uartPort->Handle.Init.OneBitSampling = UART_ONE_BIT_SAMPLE_DISABLE;
     uartPort->Handle.Init.Mode = 0;
 
@@ -128,7 +129,7 @@ void uartReconfigure(uartPort_t *uartPort)
             /* Associate the initialized DMA handle to the UART handle */
             __HAL_LINKDMA(&uartPort->Handle, hdmarx, uartPort->rxDMAHandle);
 
-            HAL_UART_Receive_DMA(&uartPort->Handle, (uint8_t*)uartPort->port.rxBuffer, uartPort->port.rxBufferSize);
+            HAL_UART_Receive_DMA(&uartPort->Handle, (uint8_t*)uartPort->port.rxBuffer.buffer, uartPort->port.rxBuffer.size);
 
             uartPort->rxDMAPos = __HAL_DMA_GET_COUNTER(&uartPort->rxDMAHandle);
 
@@ -190,11 +191,15 @@ serialPort_t *uartOpen(UARTDevice device, serialReceiveCallbackPtr callback, uin
         return (serialPort_t *)s;
     }
 
+    if (!uartDevmap[device]->cts) {
+        options &= ~SERIAL_CTS;
+    }
+
     s->txDMAEmpty = true;
 
     // common serial initialisation code should move to serialPort::init()
-    s->port.rxBufferHead = s->port.rxBufferTail = 0;
-    s->port.txBufferHead = s->port.txBufferTail = 0;
+    ringBufferReset(&s->port.rxBuffer);
+    ringBufferReset(&s->port.txBuffer);
     // callback works for IRQ-based RX ONLY
     s->port.rxCallback = callback;
     s->port.mode = mode;
@@ -222,24 +227,20 @@ void uartSetMode(serialPort_t *instance, portMode_t mode)
 
 void uartStartTxDMA(uartPort_t *s)
 {
-    uint16_t size = 0;
-    uint32_t fromwhere=0;
     HAL_UART_StateTypeDef state = HAL_UART_GetState(&s->Handle);
     if ((state & HAL_UART_STATE_BUSY_TX) == HAL_UART_STATE_BUSY_TX)
         return;
 
-    if (s->port.txBufferHead > s->port.txBufferTail) {
-        size = s->port.txBufferHead - s->port.txBufferTail;
-        fromwhere = s->port.txBufferTail;
-        s->port.txBufferTail = s->port.txBufferHead;
-    } else {
-        size = s->port.txBufferSize - s->port.txBufferTail;
-        fromwhere = s->port.txBufferTail;
-        s->port.txBufferTail = 0;
+    volatile uint8_t *data;
+    const uint16_t size = ringBufferPeekContiguous(&s->port.txBuffer, &data);
+    if (!size) {
+        s->txDMAEmpty = true;
+        return;
     }
+    ringBufferAdvance(&s->port.txBuffer, size);
     s->txDMAEmpty = false;
-    //HAL_CLEANCACHE((uint8_t *)&s->port.txBuffer[fromwhere],size);
-    HAL_UART_Transmit_DMA(&s->Handle, (uint8_t *)&s->port.txBuffer[fromwhere], size);
+    //HAL_CLEANCACHE((uint8_t *)data,size);
+    HAL_UART_Transmit_DMA(&s->Handle, (uint8_t *)data, size);
 }
 
 uint32_t uartTotalRxBytesWaiting(const serialPort_t *instance)
@@ -252,28 +253,18 @@ uint32_t uartTotalRxBytesWaiting(const serialPort_t *instance)
         if (rxDMAHead >= s->rxDMAPos) {
             return rxDMAHead - s->rxDMAPos;
         } else {
-            return s->port.rxBufferSize + rxDMAHead - s->rxDMAPos;
+            return s->port.rxBuffer.size + rxDMAHead - s->rxDMAPos;
         }
     }
 
-    if (s->port.rxBufferHead >= s->port.rxBufferTail) {
-        return s->port.rxBufferHead - s->port.rxBufferTail;
-    } else {
-        return s->port.rxBufferSize + s->port.rxBufferHead - s->port.rxBufferTail;
-    }
+    return ringBufferCount(&s->port.rxBuffer);
 }
 
 uint32_t uartTotalTxBytesFree(const serialPort_t *instance)
 {
     uartPort_t *s = (uartPort_t*)instance;
 
-    uint32_t bytesUsed;
-
-    if (s->port.txBufferHead >= s->port.txBufferTail) {
-        bytesUsed = s->port.txBufferHead - s->port.txBufferTail;
-    } else {
-        bytesUsed = s->port.txBufferSize + s->port.txBufferHead - s->port.txBufferTail;
-    }
+    uint32_t bytesUsed = ringBufferCount(&s->port.txBuffer);
 
     if (s->txDMAStream) {
         /*
@@ -290,12 +281,12 @@ uint32_t uartTotalTxBytesFree(const serialPort_t *instance)
          *
          * Be kind to callers and pretend like our buffer can only ever be 100% full.
          */
-        if (bytesUsed >= s->port.txBufferSize - 1) {
+        if (bytesUsed >= s->port.txBuffer.size - 1) {
             return 0;
         }
     }
 
-    return (s->port.txBufferSize - 1) - bytesUsed;
+    return (s->port.txBuffer.size - 1) - bytesUsed;
 }
 
 bool isUartTransmitBufferEmpty(const serialPort_t *instance)
@@ -305,7 +296,7 @@ bool isUartTransmitBufferEmpty(const serialPort_t *instance)
 
         return s->txDMAEmpty;
     else
-        return s->port.txBufferTail == s->port.txBufferHead;
+        return ringBufferIsEmpty(&s->port.txBuffer);
 }
 
 uint8_t uartRead(serialPort_t *instance)
@@ -316,31 +307,18 @@ uint8_t uartRead(serialPort_t *instance)
 
     if (s->rxDMAStream) {
 
-        ch = s->port.rxBuffer[s->port.rxBufferSize - s->rxDMAPos];
+        ch = s->port.rxBuffer.buffer[s->port.rxBuffer.size - s->rxDMAPos];
         if (--s->rxDMAPos == 0)
-            s->rxDMAPos = s->port.rxBufferSize;
+            s->rxDMAPos = s->port.rxBuffer.size;
     } else {
-        ch = s->port.rxBuffer[s->port.rxBufferTail];
-        if (s->port.rxBufferTail + 1 >= s->port.rxBufferSize) {
-            s->port.rxBufferTail = 0;
-        } else {
-            s->port.rxBufferTail++;
-        }
+        ch = ringBufferPop(&s->port.rxBuffer);
     }
 
     return ch;
 }
 
-void uartWrite(serialPort_t *instance, uint8_t ch)
+static void uartStartTx(uartPort_t *s)
 {
-    uartPort_t *s = (uartPort_t *)instance;
-    s->port.txBuffer[s->port.txBufferHead] = ch;
-    if (s->port.txBufferHead + 1 >= s->port.txBufferSize) {
-        s->port.txBufferHead = 0;
-    } else {
-        s->port.txBufferHead++;
-    }
-
     if (s->txDMAStream) {
         if (!(s->txDMAStream->CR & 1))
             uartStartTxDMA(s);
@@ -349,6 +327,32 @@ void uartWrite(serialPort_t *instance, uint8_t ch)
     }
 }
 
+void uartWrite(serialPort_t *instance, uint8_t ch)
+{
+    uartPort_t *s = (uartPort_t *)instance;
+    ringBufferPush(&s->port.txBuffer, ch);
+    uartStartTx(s);
+}
+
+// Queues the buffer in chunks and kicks the transmitter once per chunk, rather than once per byte.
+// Blocks until all of the buffer has been queued.
+void uartWriteBuf(serialPort_t *instance, const void *data, int count)
+{
+    uartPort_t *s = (uartPort_t *)instance;
+    const uint8_t *p = data;
+
+    while (count > 0) {
+        // The ring buffer's own free space still includes the bytes of a DMA transfer in progress
+        const uint32_t chunk = MIN((uint32_t)count, uartTotalTxBytesFree(instance));
+        if (chunk) {
+            const uint32_t written = ringBufferWrite(&s->port.txBuffer, p, chunk);
+            uartStartTx(s);
+            p += written;
+            count -= written;
+        }
+    }
+}
+
 const struct serialPortVTable uartVTable[] = {
     {
         .serialWrite = uartWrite,
@@ -358,9 +362,11 @@ const struct serialPortVTable uartVTable[] = {
         .serialSetBaudRate = uartSetBaudRate,
         .isSerialTransmitBufferEmpty = isUartTransmitBufferEmpty,
         .setMode = uartSetMode,
-        .writeBuf = NULL,
+        .writeBuf = uartWriteBuf,
         .beginWrite = NULL,
         .endWrite = NULL,
+        .reserveWrite = NULL,
+        .commitWrite = NULL,
     }
 };
 
@@ -152,6 +152,7 @@ typedef struct uartDevice_s {
     const uartHardware_t *hardware;
     ioTag_t rx;
     ioTag_t tx;
+    ioTag_t cts;
     volatile uint8_t rxBuffer[UART_RX_BUFFER_SIZE];
     volatile uint8_t txBuffer[UART_TX_BUFFER_SIZE];
 } uartDevice_t;
@@ -172,3 +173,8 @@ uartPort_t *serialUART(UARTDevice device, uint32_t baudRate, portMode_t mode, po
 void uartIrqHandler(uartPort_t *s);
 
 void uartReconfigure(uartPort_t *uartPort);
+
+#ifdef USE_UART_RX_DMA
+bool uartIsRxDMAAvailable(dmaIdentifier_e identifier);
+void uartRxDMAToCallback(uartPort_t *s);
+#endif
@@ -34,6 +34,7 @@
 #include "build/build_config.h"
 
 #include "common/utils.h"
+#include "drivers/dma.h"
 #include "drivers/gpio.h"
 #include "drivers/inverter.h"
 #include "drivers/rcc.h"
@@ -93,7 +94,7 @@ void uartReconfigure(uartPort_t *uartPort)
     USART_InitStructure.USART_StopBits = (uartPort->port.options & SERIAL_STOPBITS_2) ? USART_StopBits_2 : USART_StopBits_1;
     USART_InitStructure.USART_Parity   = (uartPort->port.options & SERIAL_PARITY_EVEN) ? USART_Parity_Even : USART_Parity_No;
 
-    USART_InitStructure.USART_HardwareFlowControl = USART_HardwareFlowControl_None;
+    USART_InitStructure.USART_HardwareFlowControl = (uartPort->port.options & SERIAL_CTS) ? USART_HardwareFlowControl_CTS : USART_HardwareFlowControl_None;
     USART_InitStructure.USART_Mode = 0;
     if (uartPort->port.mode & MODE_RX)
         USART_InitStructure.USART_Mode |= USART_Mode_Rx;
@@ -119,11 +120,15 @@ serialPort_t *uartOpen(UARTDevice device, serialReceiveCallbackPtr rxCallback, u
     if (!s)
         return (serialPort_t *)s;
 
+    if (!uartDevmap[device]->cts) {
+        options &= ~SERIAL_CTS;
+    }
+
     s->txDMAEmpty = true;
 
     // common serial initialisation code should move to serialPort::init()
-    s->port.rxBufferHead = s->port.rxBufferTail = 0;
-    s->port.txBufferHead = s->port.txBufferTail = 0;
+    ringBufferReset(&s->port.rxBuffer);
+    ringBufferReset(&s->port.txBuffer);
     // callback works for IRQ-based RX ONLY
     s->port.rxCallback = rxCallback;
     s->port.mode = mode;
@@ -159,27 +164,44 @@ serialPort_t *uartOpen(UARTDevice device, serialReceiveCallbackPtr rxCallback, u
             DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
             DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_Byte;
 #endif
-            DMA_InitStructure.DMA_BufferSize = s->port.rxBufferSize;
+            DMA_InitStructure.DMA_BufferSize = s->port.rxBuffer.size;
 
 #ifdef STM32F4
             DMA_InitStructure.DMA_Channel = s->rxDMAChannel;
             DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralToMemory;
             DMA_InitStructure.DMA_Mode = DMA_Mode_Circular;
-            DMA_InitStructure.DMA_Memory0BaseAddr = (uint32_t)s->port.rxBuffer;
+            DMA_InitStructure.DMA_Memory0BaseAddr = (uint32_t)s->port.rxBuffer.buffer;
             DMA_DeInit(s->rxDMAStream);
             DMA_Init(s->rxDMAStream, &DMA_InitStructure);
+#ifdef USE_UART_RX_DMA
+            if (rxCallback) {
+                DMA_ITConfig(s->rxDMAStream, DMA_IT_HT | DMA_IT_TC, ENABLE);
+            }
+#endif
             DMA_Cmd(s->rxDMAStream, ENABLE);
             USART_DMACmd(s->USARTx, USART_DMAReq_Rx, ENABLE);
             s->rxDMAPos = DMA_GetCurrDataCounter(s->rxDMAStream);
 #else
             DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralSRC;
             DMA_InitStructure.DMA_Mode = DMA_Mode_Circular;
-            DMA_InitStructure.DMA_MemoryBaseAddr = (uint32_t)s->port.rxBuffer;
+            DMA_InitStructure.DMA_MemoryBaseAddr = (uint32_t)s->port.rxBuffer.buffer;
             DMA_DeInit(s->rxDMAChannel);
             DMA_Init(s->rxDMAChannel, &DMA_InitStructure);
+#ifdef USE_UART_RX_DMA
+            if (rxCallback) {
+                DMA_ITConfig(s->rxDMAChannel, DMA_IT_HT | DMA_IT_TC, ENABLE);
+            }
+#endif
             DMA_Cmd(s->rxDMAChannel, ENABLE);
             USART_DMACmd(s->USARTx, USART_DMAReq_Rx, ENABLE);
             s->rxDMAPos = DMA_GetCurrDataCounter(s->rxDMAChannel);
+#endif
+#ifdef USE_UART_RX_DMA
+            // The port may have been receiving by interrupt before it was reopened with DMA
+            USART_ITConfig(s->USARTx, USART_IT_RXNE, DISABLE);
+            // Hand a frame to the callback, or wake the serial task, as soon as the line goes quiet
+            USART_ClearITPendingBit(s->USARTx, USART_IT_IDLE);
+            USART_ITConfig(s->USARTx, USART_IT_IDLE, ENABLE);
 #endif
         } else {
             USART_ClearITPendingBit(s->USARTx, USART_IT_RXNE);
@@ -213,7 +235,7 @@ serialPort_t *uartOpen(UARTDevice device, serialReceiveCallbackPtr rxCallback, u
             DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
             DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_Byte;
 #endif
-            DMA_InitStructure.DMA_BufferSize = s->port.txBufferSize;
+            DMA_InitStructure.DMA_BufferSize = s->port.txBuffer.size;
 
 #ifdef STM32F4
             DMA_InitStructure.DMA_Channel = s->txDMAChannel;
@@ -31,12 +31,16 @@
 
 #include "build/build_config.h"
 
+#include "common/utils.h"
+
+#include "drivers/dma.h"
+#include "drivers/io.h"
 #include "drivers/rcc.h"
 #include "drivers/serial.h"
 #include "drivers/serial_uart.h"
 #include "drivers/serial_uart_impl.h"
 
-uartDevice_t uartDevice[UARTDEV_COUNT];      // Only those configured in target.h
+DMA_RAM uartDevice_t uartDevice[UARTDEV_COUNT];  // Only those configured in target.h, the buffers are DMA targets
 uartDevice_t *uartDevmap[UARTDEV_COUNT_MAX]; // Full array
 
 void uartPinConfigure(const serialPinConfig_t *pSerialPinConfig)
@@ -57,8 +61,57 @@ void uartPinConfigure(const serialPinConfig_t *pSerialPinConfig)
         }
 
         if (uartdev->rx || uartdev->tx) {
+            // Only USART1-3 and USART6 have flow control, and the pin has to be the CTS pin of the USART
+            uartdev->cts = pSerialPinConfig->ioTagCts[device];
             uartdev->hardware = hardware;
             uartDevmap[device] = uartdev++;
         }
     }
 }
+
+#if defined(STM32F3) || defined(STM32F4)
+// the TX pins that the UARTs opened on another pin are configured for
+static ioTag_t uartConfiguredTx[UARTDEV_COUNT];
+
+/*
+ * Opens a UART that is not in use as a single wire half duplex port on another of its TX pins, a motor output for
+ * instance. The line is open drain with the pull up, as the ESCs expect it. NULL if no free UART has the pin.
+ */
+serialPort_t *uartOpenOnTxPin(ioTag_t txTag, serialReceiveCallbackPtr rxCallback, uint32_t baudRate, portMode_t mode)
+{
+    if (!txTag) {
+        return NULL;
+    }
+
+    for (size_t index = 0; index < UARTDEV_COUNT; index++) {
+        uartDevice_t *uartdev = &uartDevice[index];
+        const uartHardware_t *hardware = uartdev->hardware;
+        if (!hardware || uartdev->port.port.vTable) {
+            continue;   // not configured or already open
+        }
+
+        for (int pindex = 0 ; pindex < UARTHARDWARE_MAX_PINS ; pindex++) {
+            if (hardware->txPins[pindex] == txTag) {
+                uartConfiguredTx[index] = uartdev->tx;
+                uartdev->tx = txTag;
+
+                serialPort_t *port = uartOpen(hardware->device, rxCallback, baudRate, mode, SERIAL_BIDIR);
+                IOConfigGPIOAF(IOGetByTag(txTag), IOCFG_AF_OD_UP, hardware->af);
+                return port;
+            }
+        }
+    }
+    return NULL;
+}
+
+void uartCloseOnTxPin(serialPort_t *instance)
+{
+    uartDevice_t *uartdev = container_of((uartPort_t *)instance, uartDevice_t, port);
+
+    serialSetMode(instance, 0);
+    IOConfigGPIO(IOGetByTag(uartdev->tx), IOCFG_IPU);
+
+    uartdev->tx = uartConfiguredTx[uartdev - uartDevice];
+    uartdev->port.port.vTable = NULL;
+}
+#endif
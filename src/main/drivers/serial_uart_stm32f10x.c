@@ -129,10 +129,8 @@ uartPort_t *serialUART(UARTDevice device, uint32_t baudRate, portMode_t mode, po
 
     s->port.baudRate = baudRate;
 
-    s->port.rxBuffer = uartdev->rxBuffer;
-    s->port.txBuffer = uartdev->txBuffer;
-    s->port.rxBufferSize = ARRAYLEN(uartdev->rxBuffer);
-    s->port.txBufferSize = ARRAYLEN(uartdev->txBuffer);
+    ringBufferInit(&s->port.rxBuffer, uartdev->rxBuffer, ARRAYLEN(uartdev->rxBuffer));
+    ringBufferInit(&s->port.txBuffer, uartdev->txBuffer, ARRAYLEN(uartdev->txBuffer));
 
     const uartHardware_t *hardware = uartdev->hardware;
 
@@ -195,18 +193,13 @@ void uartIrqHandler(uartPort_t *s)
         if (s->port.rxCallback) {
             s->port.rxCallback(s->USARTx->DR);
         } else {
-            s->port.rxBuffer[s->port.rxBufferHead++] = s->USARTx->DR;
-            if (s->port.rxBufferHead >= s->port.rxBufferSize) {
-                s->port.rxBufferHead = 0;
-            }
+            ringBufferPush(&s->port.rxBuffer, s->USARTx->DR);
+            serialSignalRxEvent();
         }
     }
     if (SR & USART_FLAG_TXE) {
-        if (s->port.txBufferTail != s->port.txBufferHead) {
-            s->USARTx->DR = s->port.txBuffer[s->port.txBufferTail++];
-            if (s->port.txBufferTail >= s->port.txBufferSize) {
-                s->port.txBufferTail = 0;
-            }
+        if (!ringBufferIsEmpty(&s->port.txBuffer)) {
+            s->USARTx->DR = ringBufferPop(&s->port.txBuffer);
         } else {
             USART_ITConfig(s->USARTx, USART_IT_TXE, DISABLE);
         }
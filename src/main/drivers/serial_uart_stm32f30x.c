@@ -173,6 +173,16 @@ static void handleUsartTxDma(dmaChannelDescriptor_t* descriptor)
     uartTryStartTxDMA(s);
 }
 
+#ifdef USE_UART_RX_DMA
+static void handleUsartRxDma(dmaChannelDescriptor_t* descriptor)
+{
+    uartPort_t *s = (uartPort_t*)(descriptor->userParam);
+    DMA_CLEAR_FLAG(descriptor, DMA_IT_HTIF | DMA_IT_TCIF);
+
+    uartRxDMAToCallback(s);
+}
+#endif
+
 void serialUARTInitIO(IO_t txIO, IO_t rxIO, portMode_t mode, portOptions_t options, uint8_t af, uint8_t index)
 {
     if ((options & SERIAL_BIDIR) && txIO) {
@@ -216,10 +226,8 @@ uartPort_t *serialUART(UARTDevice device, uint32_t baudRate, portMode_t mode, po
 
     s->port.baudRate = baudRate;
 
-    s->port.rxBuffer = uartDev->rxBuffer;
-    s->port.txBuffer = uartDev->txBuffer;
-    s->port.rxBufferSize = sizeof(uartDev->rxBuffer);
-    s->port.txBufferSize = sizeof(uartDev->txBuffer);
+    ringBufferInit(&s->port.rxBuffer, uartDev->rxBuffer, sizeof(uartDev->rxBuffer));
+    ringBufferInit(&s->port.txBuffer, uartDev->txBuffer, sizeof(uartDev->txBuffer));
 
     const uartHardware_t *hardware = uartDev->hardware;
 
@@ -227,11 +235,23 @@ uartPort_t *serialUART(UARTDevice device, uint32_t baudRate, portMode_t mode, po
 
     RCC_ClockCmd(hardware->rcc, ENABLE);
 
+#ifdef USE_UART_RX_DMA
+    if (hardware->rxDMAChannel && uartIsRxDMAAvailable(dmaGetIdentifier(hardware->rxDMAChannel))) {
+        const dmaIdentifier_e identifier = dmaGetIdentifier(hardware->rxDMAChannel);
+        dmaInit(identifier, OWNER_SERIAL_RX, RESOURCE_INDEX(device));
+        dmaSetHandler(identifier, handleUsartRxDma, hardware->rxPriority, (uint32_t)s);
+        s->rxDMAChannel = hardware->rxDMAChannel;
+        s->rxDMAPeripheralBaseAddr = (uint32_t)&s->USARTx->RDR;
+    } else {
+        s->rxDMAChannel = NULL;
+    }
+#else
     if (hardware->rxDMAChannel) {
         dmaInit(dmaGetIdentifier(hardware->rxDMAChannel), OWNER_SERIAL_RX, RESOURCE_INDEX(device));
         s->rxDMAChannel = hardware->rxDMAChannel;
         s->rxDMAPeripheralBaseAddr = (uint32_t)&s->USARTx->RDR;
     }
+#endif
 
     if (hardware->txDMAChannel) {
         const dmaIdentifier_e identifier = dmaGetIdentifier(hardware->txDMAChannel);
@@ -243,7 +263,11 @@ uartPort_t *serialUART(UARTDevice device, uint32_t baudRate, portMode_t mode, po
 
     serialUARTInitIO(IOGetByTag(uartDev->tx), IOGetByTag(uartDev->rx), mode, options, hardware->af, device);
 
-    if (!s->rxDMAChannel || !s->txDMAChannel) {
+#ifndef USE_UART_RX_DMA
+    if (!s->rxDMAChannel || !s->txDMAChannel)
+#endif
+    {
+        // With RX DMA the interrupt is still needed for the idle line
         NVIC_InitTypeDef NVIC_InitStructure;
 
         NVIC_InitStructure.NVIC_IRQChannel = hardware->irqn;
@@ -264,19 +288,21 @@ void uartIrqHandler(uartPort_t *s)
         if (s->port.rxCallback) {
             s->port.rxCallback(s->USARTx->RDR);
         } else {
-            s->port.rxBuffer[s->port.rxBufferHead++] = s->USARTx->RDR;
-            if (s->port.rxBufferHead >= s->port.rxBufferSize) {
-                s->port.rxBufferHead = 0;
-            }
+            ringBufferPush(&s->port.rxBuffer, s->USARTx->RDR);
+            serialSignalRxEvent();
         }
     }
 
+#ifdef USE_UART_RX_DMA
+    if (s->rxDMAChannel && (ISR & USART_FLAG_IDLE)) {
+        USART_ClearITPendingBit(s->USARTx, USART_IT_IDLE);
+        uartRxDMAToCallback(s);
+    }
+#endif
+
     if (!s->txDMAChannel && (ISR & USART_FLAG_TXE)) {
-        if (s->port.txBufferTail != s->port.txBufferHead) {
-            USART_SendData(s->USARTx, s->port.txBuffer[s->port.txBufferTail++]);
-            if (s->port.txBufferTail >= s->port.txBufferSize) {
-                s->port.txBufferTail = 0;
-            }
+        if (!ringBufferIsEmpty(&s->port.txBuffer)) {
+            USART_SendData(s->USARTx, ringBufferPop(&s->port.txBuffer));
         } else {
             USART_ITConfig(s->USARTx, USART_IT_TXE, DISABLE);
         }
@@ -285,6 +311,7 @@ void uartIrqHandler(uartPort_t *s)
     if (ISR & USART_FLAG_ORE)
     {
         USART_ClearITPendingBit (s->USARTx, USART_IT_ORE);
+        s->overrunErrors++;
     }
 }
 #endif // USE_UART
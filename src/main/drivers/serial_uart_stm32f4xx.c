@@ -192,6 +192,16 @@ void dmaIRQHandler(dmaChannelDescriptor_t* descriptor)
     }
 }
 
+#ifdef USE_UART_RX_DMA
+static void handleUsartRxDma(dmaChannelDescriptor_t* descriptor)
+{
+    uartPort_t *s = &(((uartDevice_t*)(descriptor->userParam))->port);
+    DMA_CLEAR_FLAG(descriptor, DMA_IT_HTIF | DMA_IT_TCIF | DMA_IT_TEIF | DMA_IT_DMEIF | DMA_IT_FEIF);
+
+    uartRxDMAToCallback(s);
+}
+#endif
+
 // XXX Should serialUART be consolidated?
 
 uartPort_t *serialUART(UARTDevice device, uint32_t baudRate, portMode_t mode, portOptions_t options)
@@ -210,27 +220,52 @@ uartPort_t *serialUART(UARTDevice device, uint32_t baudRate, portMode_t mode, po
 
     s->port.baudRate = baudRate;
 
-    s->port.rxBuffer = uart->rxBuffer;
-    s->port.txBuffer = uart->txBuffer;
-    s->port.rxBufferSize = sizeof(uart->rxBuffer);
-    s->port.txBufferSize = sizeof(uart->txBuffer);
+    ringBufferInit(&s->port.rxBuffer, uart->rxBuffer, sizeof(uart->rxBuffer));
+    ringBufferInit(&s->port.txBuffer, uart->txBuffer, sizeof(uart->txBuffer));
 
     s->USARTx = hardware->reg;
 
+    // The target's stream is used if it is free, otherwise one of the others the request maps to
+    const dmaChannelSpec_t *rxDmaSpec = NULL;
     if (hardware->rxDMAStream) {
-        dmaInit(dmaGetIdentifier(hardware->rxDMAStream), OWNER_SERIAL_RX, RESOURCE_INDEX(device));
-        s->rxDMAChannel = hardware->DMAChannel;
-        s->rxDMAStream = hardware->rxDMAStream;
+        rxDmaSpec = dmaGetFreeChannelSpec(DMA_PERIPH_UART_RX, device, hardware->rxDMAStream, OWNER_SERIAL_RX, RESOURCE_INDEX(device));
+    }
+#ifdef USE_UART_RX_DMA
+    if (rxDmaSpec && uartIsRxDMAAvailable(dmaGetIdentifier(rxDmaSpec->ref))) {
+        const dmaIdentifier_e identifier = dmaGetIdentifier(rxDmaSpec->ref);
+        dmaInit(identifier, OWNER_SERIAL_RX, RESOURCE_INDEX(device));
+        // Same priority as the UART interrupt, so the two never pass the received bytes on at the same time
+        dmaSetHandler(identifier, handleUsartRxDma, hardware->rxPriority, (uint32_t)uart);
+        s->rxDMAChannel = rxDmaSpec->channel;
+        s->rxDMAStream = rxDmaSpec->ref;
+        s->rxDMAPeripheralBaseAddr = (uint32_t)&s->USARTx->DR;
+    } else {
+        s->rxDMAChannel = 0;
+        s->rxDMAStream = NULL;
+    }
+#else
+    if (rxDmaSpec) {
+        dmaInit(dmaGetIdentifier(rxDmaSpec->ref), OWNER_SERIAL_RX, RESOURCE_INDEX(device));
+        s->rxDMAChannel = rxDmaSpec->channel;
+        s->rxDMAStream = rxDmaSpec->ref;
         s->rxDMAPeripheralBaseAddr = (uint32_t)&s->USARTx->DR;
     }
+#endif
 
+    const dmaChannelSpec_t *txDmaSpec = NULL;
     if (hardware->txDMAStream) {
-        const dmaIdentifier_e identifier = dmaGetIdentifier(hardware->txDMAStream);
+        txDmaSpec = dmaGetFreeChannelSpec(DMA_PERIPH_UART_TX, device, hardware->txDMAStream, OWNER_SERIAL_TX, RESOURCE_INDEX(device));
+    }
+    if (txDmaSpec) {
+        const dmaIdentifier_e identifier = dmaGetIdentifier(txDmaSpec->ref);
         dmaInit(identifier, OWNER_SERIAL_TX, RESOURCE_INDEX(device));
         dmaSetHandler(identifier, dmaIRQHandler, hardware->txPriority, (uint32_t)uart);
-        s->txDMAChannel = hardware->DMAChannel;
-        s->txDMAStream = hardware->txDMAStream;
+        s->txDMAChannel = txDmaSpec->channel;
+        s->txDMAStream = txDmaSpec->ref;
         s->txDMAPeripheralBaseAddr = (uint32_t)&s->USARTx->DR;
+    } else {
+        s->txDMAChannel = 0;
+        s->txDMAStream = NULL;
     }
 
     IO_t txIO = IOGetByTag(uart->tx);
@@ -255,7 +290,17 @@ uartPort_t *serialUART(UARTDevice device, uint32_t baudRate, portMode_t mode, po
         }
     }
 
-    if (!(s->rxDMAChannel)) {
+    if ((options & SERIAL_CTS) && uart->cts) {
+        const IO_t ctsIO = IOGetByTag(uart->cts);
+        IOInit(ctsIO, OWNER_SERIAL_CTS, RESOURCE_INDEX(device));
+        IOConfigGPIOAF(ctsIO, IOCFG_AF_PP_UP, hardware->af);
+    }
+
+#ifndef USE_UART_RX_DMA
+    if (!(s->rxDMAChannel))
+#endif
+    {
+        // With RX DMA the interrupt is still needed for the idle line and to transmit without DMA
         NVIC_InitTypeDef NVIC_InitStructure;
 
         NVIC_InitStructure.NVIC_IRQChannel = hardware->irqn;
@@ -274,15 +319,23 @@ void uartIrqHandler(uartPort_t *s)
         if (s->port.rxCallback) {
             s->port.rxCallback(s->USARTx->DR);
         } else {
-            s->port.rxBuffer[s->port.rxBufferHead] = s->USARTx->DR;
-            s->port.rxBufferHead = (s->port.rxBufferHead + 1) % s->port.rxBufferSize;
+            ringBufferPush(&s->port.rxBuffer, s->USARTx->DR);
+            serialSignalRxEvent();
         }
     }
 
+#ifdef USE_UART_RX_DMA
+    if (s->rxDMAStream && (USART_GetITStatus(s->USARTx, USART_IT_IDLE) == SET)) {
+        // Reading SR then DR clears the idle flag, the DMA has already taken the data
+        (void)s->USARTx->SR;
+        (void)s->USARTx->DR;
+        uartRxDMAToCallback(s);
+    }
+#endif
+
     if (!s->txDMAStream && (USART_GetITStatus(s->USARTx, USART_IT_TXE) == SET)) {
-        if (s->port.txBufferTail != s->port.txBufferHead) {
-            USART_SendData(s->USARTx, s->port.txBuffer[s->port.txBufferTail]);
-            s->port.txBufferTail = (s->port.txBufferTail + 1) % s->port.txBufferSize;
+        if (!ringBufferIsEmpty(&s->port.txBuffer)) {
+            USART_SendData(s->USARTx, ringBufferPop(&s->port.txBuffer));
         } else {
             USART_ITConfig(s->USARTx, USART_IT_TXE, DISABLE);
         }
@@ -291,6 +344,7 @@ void uartIrqHandler(uartPort_t *s)
     if (USART_GetITStatus(s->USARTx, USART_FLAG_ORE) == SET)
     {
         USART_ClearITPendingBit (s->USARTx, USART_IT_ORE);
+        s->overrunErrors++;
     }
 }
 #endif
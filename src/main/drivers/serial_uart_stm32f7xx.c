@@ -235,8 +235,8 @@ void uartIrqHandler(uartPort_t *s)
         if (s->port.rxCallback) {
             s->port.rxCallback(rbyte);
         } else {
-            s->port.rxBuffer[s->port.rxBufferHead] = rbyte;
-            s->port.rxBufferHead = (s->port.rxBufferHead + 1) % s->port.rxBufferSize;
+            ringBufferPush(&s->port.rxBuffer, rbyte);
+            serialSignalRxEvent();
         }
         CLEAR_BIT(huart->Instance->CR1, (USART_CR1_PEIE));
 
@@ -268,6 +268,7 @@ void uartIrqHandler(uartPort_t *s)
     if ((__HAL_UART_GET_IT(huart, UART_IT_ORE) != RESET))
     {
       __HAL_UART_CLEAR_IT(huart, UART_CLEAR_OREF);
+      s->overrunErrors++;
     }
 
     /* UART in mode Transmitter ------------------------------------------------*/
@@ -287,7 +288,7 @@ void uartIrqHandler(uartPort_t *s)
 
 static void handleUsartTxDma(uartPort_t *s)
 {
-    if (s->port.txBufferHead != s->port.txBufferTail)
+    if (!ringBufferIsEmpty(&s->port.txBuffer))
         uartStartTxDMA(s);
     else
     {
@@ -316,10 +317,8 @@ uartPort_t *serialUART(UARTDevice device, uint32_t baudRate, portMode_t mode, po
 
     s->port.baudRate = baudRate;
 
-    s->port.rxBuffer = uartdev->rxBuffer;
-    s->port.txBuffer = uartdev->txBuffer;
-    s->port.rxBufferSize = ARRAYLEN(uartdev->rxBuffer);
-    s->port.txBufferSize = ARRAYLEN(uartdev->txBuffer);
+    ringBufferInit(&s->port.rxBuffer, uartdev->rxBuffer, ARRAYLEN(uartdev->rxBuffer));
+    ringBufferInit(&s->port.txBuffer, uartdev->txBuffer, ARRAYLEN(uartdev->txBuffer));
 
     const uartHardware_t *hardware = uartdev->hardware;
 
@@ -362,6 +361,12 @@ uartPort_t *serialUART(UARTDevice device, uint32_t baudRate, portMode_t mode, po
         }
     }
 
+    if ((options & SERIAL_CTS) && uartdev->cts) {
+        const IO_t ctsIO = IOGetByTag(uartdev->cts);
+        IOInit(ctsIO, OWNER_SERIAL_CTS, RESOURCE_INDEX(device));
+        IOConfigGPIOAF(ctsIO, IOCFG_AF_PP_UP, hardware->af);
+    }
+
     // DMA TX Interrupt
     dmaInit(hardware->txIrq, OWNER_SERIAL_TX, RESOURCE_INDEX(device));
     dmaSetHandler(hardware->txIrq, dmaIRQHandler, hardware->txPriority, (uint32_t)uartdev);
@@ -166,6 +166,26 @@ static void usbVcpEndWrite(serialPort_t *instance)
     usbVcpFlush(port);
 }
 
+#ifdef STM32F4
+// Replies are written straight into the buffer the CDC core sends from
+static uint32_t usbVcpReserveWrite(serialPort_t *instance, uint8_t **data)
+{
+    vcpPort_t *port = container_of(instance, vcpPort_t, port);
+
+    if (!usbVcpFlush(port)) {
+        return 0;
+    }
+    return CDC_Send_Reserve(data);
+}
+
+static void usbVcpCommitWrite(serialPort_t *instance, uint32_t count)
+{
+    UNUSED(instance);
+
+    CDC_Send_Commit(count);
+}
+#endif
+
 static const struct serialPortVTable usbVTable[] = {
     {
         .serialWrite = usbVcpWrite,
@@ -177,7 +197,14 @@ static const struct serialPortVTable usbVTable[] = {
         .setMode = usbVcpSetMode,
         .writeBuf = usbVcpWriteBuf,
         .beginWrite = usbVcpBeginWrite,
-        .endWrite = usbVcpEndWrite
+        .endWrite = usbVcpEndWrite,
+#ifdef STM32F4
+        .reserveWrite = usbVcpReserveWrite,
+        .commitWrite = usbVcpCommitWrite
+#else
+        .reserveWrite = NULL,
+        .commitWrite = NULL
+#endif
     }
 };
 
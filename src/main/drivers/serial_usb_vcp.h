@@ -20,8 +20,8 @@
 typedef struct {
     serialPort_t port;
 
-    // Buffer used during bulk writes.
-    uint8_t txBuf[20];
+    // Buffer used during bulk writes, one full speed USB packet.
+    uint8_t txBuf[64];
     uint8_t txAt;
     // Set if the port is in bulk write mode and can buffer.
     bool buffering;
@@ -25,8 +25,10 @@
 #include "drivers/exti.h"
 #include "drivers/io.h"
 #include "drivers/nvic.h"
+#include "drivers/pwm_output.h"
 #include "drivers/sonar_hcsr04.h"
 #include "drivers/time.h"
+#include "drivers/timer.h"
 
 /* HC-SR04 consists of ultrasonic transmitter, receiver, and control circuits.
  * When triggered it sends out a series of 40KHz ultrasonic pulses and receives
@@ -35,8 +37,14 @@
  *
  * *** Warning: HC-SR04 operates at +5V ***
  *
+ * When the pins are on timer channels the timers do the work: the trigger is an output compare pulse
+ * repeated every ping period, and the echo width is taken from input capture timestamps. Otherwise the
+ * trigger is toggled in software and the echo timed with micros() in an EXTI handler.
  */
 
+#define HCSR04_PING_PERIOD_US   60000   // the repeat interval of trig signal should be greater than 60ms to avoid interference between consecutive measurements
+#define HCSR04_TRIGGER_PULSE_US 11      // the width of trig signal must be greater than 10us
+
 #if defined(SONAR)
 STATIC_UNIT_TESTED volatile int32_t measurement = -1;
 static uint32_t lastMeasurementAt;
@@ -46,6 +54,43 @@ extiCallbackRec_t hcsr04_extiCallbackRec;
 static IO_t echoIO;
 static IO_t triggerIO;
 
+static const timerHardware_t *echoTimer;
+static timerCCHandlerRec_t hcsr04_edgeCallbackRec;
+static timerChannel_t triggerChannel;
+static bool triggerByTimer;
+
+static void hcsr04_edgeHandler(timerCCHandlerRec_t *cbRec, captureCompare_t capture)
+{
+    static captureCompare_t captureRise;
+    static bool echoHigh;
+    UNUSED(cbRec);
+
+    if (!echoHigh) {
+        captureRise = capture;
+        timerChICPolarity(echoTimer, false);
+    } else {
+        // the timer counts modulo the ping period, longer echoes are out of range anyway
+        measurement = capture >= captureRise ? capture - captureRise : capture + HCSR04_PING_PERIOD_US - captureRise;
+        timerChICPolarity(echoTimer, true);
+    }
+    echoHigh = !echoHigh;
+}
+
+// The timer runs at 1MHz over the ping period, so it must not be running anything else
+static bool hcsr04_timerAvailable(const timerHardware_t *timer)
+{
+    if (!timer) {
+        return false;
+    }
+    const pwmOutputPort_t *motors = pwmGetMotors();
+    for (int motorIndex = 0; motorIndex < MAX_SUPPORTED_MOTORS; motorIndex++) {
+        if (motors[motorIndex].enabled && motors[motorIndex].channel.tim == timer->tim) {
+            return false;
+        }
+    }
+    return true;
+}
+
 void hcsr04_extiHandler(extiCallbackRec_t* cb)
 {
     static uint32_t timing_start;
@@ -81,21 +126,48 @@ void hcsr04_init(const sonarConfig_t *sonarConfig, sonarRange_t *sonarRange)
     RCC_APB2PeriphClockCmd(RCC_APB2Periph_SYSCFG, ENABLE);
 #endif
 
-    // trigger pin
-    triggerIO = IOGetByTag(sonarConfig->triggerTag);
-    IOInit(triggerIO, OWNER_SONAR_TRIGGER, 0);
-    IOConfigGPIO(triggerIO, IOCFG_OUT_PP);
-
     // echo pin
     echoIO = IOGetByTag(sonarConfig->echoTag);
     IOInit(echoIO, OWNER_SONAR_ECHO, 0);
-    IOConfigGPIO(echoIO, IOCFG_IN_FLOATING);
-
+    const timerHardware_t *echoTimerHardware = timerGetByTag(sonarConfig->echoTag, TIM_USE_ANY);
+    if (hcsr04_timerAvailable(echoTimerHardware)) {
+        echoTimer = echoTimerHardware;
+#ifdef STM32F1
+        IOConfigGPIO(echoIO, IOCFG_IN_FLOATING);
+#elif defined(STM32F7)
+        IOConfigGPIOAF(echoIO, IOCFG_AF_PP, echoTimer->alternateFunction);
+#else
+        IOConfigGPIO(echoIO, IOCFG_AF_PP);
+#endif
+        timerConfigure(echoTimer, HCSR04_PING_PERIOD_US, PWM_TIMER_1MHZ);
+        timerChCCHandlerInit(&hcsr04_edgeCallbackRec, hcsr04_edgeHandler);
+        timerChConfigCallbacks(echoTimer, &hcsr04_edgeCallbackRec, NULL);
+        timerChConfigIC(echoTimer, true, 0);
+    } else {
+        IOConfigGPIO(echoIO, IOCFG_IN_FLOATING);
 #ifdef USE_EXTI
-    EXTIHandlerInit(&hcsr04_extiCallbackRec, hcsr04_extiHandler);
-    EXTIConfig(echoIO, &hcsr04_extiCallbackRec, NVIC_PRIO_SONAR_EXTI, EXTI_Trigger_Rising_Falling); // TODO - priority!
-    EXTIEnable(echoIO, true);
+        EXTIHandlerInit(&hcsr04_extiCallbackRec, hcsr04_extiHandler);
+        EXTIConfig(echoIO, &hcsr04_extiCallbackRec, NVIC_PRIO_SONAR_EXTI, EXTI_Trigger_Rising_Falling); // TODO - priority!
+        EXTIEnable(echoIO, true);
 #endif
+    }
+
+    // trigger pin, configured after the echo so a timer shared by both ends up with the output enabled
+    triggerIO = IOGetByTag(sonarConfig->triggerTag);
+    IOInit(triggerIO, OWNER_SONAR_TRIGGER, 0);
+    const timerHardware_t *triggerTimerHardware = timerGetByTag(sonarConfig->triggerTag, TIM_USE_ANY);
+    if (hcsr04_timerAvailable(triggerTimerHardware)) {
+#if defined(USE_HAL_DRIVER)
+        IOConfigGPIOAF(triggerIO, IOCFG_AF_PP, triggerTimerHardware->alternateFunction);
+#else
+        IOConfigGPIO(triggerIO, IOCFG_AF_PP);
+#endif
+        pwmOutConfig(&triggerChannel, triggerTimerHardware, PWM_TIMER_1MHZ, HCSR04_PING_PERIOD_US, 0, 0);
+        *triggerChannel.ccr = HCSR04_TRIGGER_PULSE_US;
+        triggerByTimer = true;
+    } else {
+        IOConfigGPIO(triggerIO, IOCFG_OUT_PP);
+    }
 
     lastMeasurementAt = millis() - 60; // force 1st measurement in hcsr04_get_distance()
 #else
@@ -107,6 +179,10 @@ void hcsr04_init(const sonarConfig_t *sonarConfig, sonarRange_t *sonarRange)
 void hcsr04_start_reading(void)
 {
 #if !defined(UNIT_TEST)
+    if (triggerByTimer) {
+        return; // the timer pings by itself
+    }
+
     uint32_t now = millis();
 
     if (now < (lastMeasurementAt + 60)) {
@@ -76,3 +76,50 @@ void beeperInit(const beeperDevConfig_t *config)
     UNUSED(config);
 #endif
 }
+
+/*
+ * Plays a sequence on the timer of a PWM beeper, so the steps keep their length whatever the
+ * scheduler is doing. Returns false when the beeper has no timer, the caller then steps the
+ * sequence itself.
+ */
+bool beeperSequenceStart(const uint8_t *sequence, bool audible)
+{
+#ifdef BEEPER
+    if (beeperFrequency) {
+        return beeperPwmSequenceStart(sequence, audible);
+    }
+#else
+    UNUSED(sequence);
+    UNUSED(audible);
+#endif
+    return false;
+}
+
+void beeperSequenceStop(void)
+{
+#ifdef BEEPER
+    if (beeperFrequency) {
+        beeperPwmSequenceStop();
+    }
+#endif
+}
+
+bool beeperSequenceIsActive(void)
+{
+#ifdef BEEPER
+    if (beeperFrequency) {
+        return beeperPwmSequenceIsActive();
+    }
+#endif
+    return false;
+}
+
+bool beeperSequenceIsOn(void)
+{
+#ifdef BEEPER
+    if (beeperFrequency) {
+        return beeperPwmSequenceIsOn();
+    }
+#endif
+    return false;
+}
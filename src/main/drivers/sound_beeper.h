@@ -29,6 +29,10 @@
 #define BEEP_ON     do {} while (0)
 #endif
 
+// a sequence is the on and off times in 10ms steps, starting with on and ended by one of these
+#define BEEPER_SEQUENCE_REPEAT  0xFE
+#define BEEPER_SEQUENCE_STOP    0xFF
+
 typedef struct beeperDevConfig_s {
     ioTag_t ioTag;
     uint8_t isInverted;
@@ -40,3 +44,8 @@ void systemBeep(bool on);
 void systemBeepToggle(void);
 void beeperInit(const beeperDevConfig_t *beeperDevConfig);
 
+bool beeperSequenceStart(const uint8_t *sequence, bool audible);
+void beeperSequenceStop(void);
+bool beeperSequenceIsActive(void);
+bool beeperSequenceIsOn(void);
+
@@ -23,14 +23,21 @@
 
 #include "build/debug.h"
 
+#include "common/maths.h"
 #include "common/utils.h"
 
 #include "drivers/stack_check.h"
 
 #define STACK_FILL_CHAR 0xa5
+#define STACK_FILL_WORD 0xa5a5a5a5
+#define STACK_REPAINT_MARGIN 64 // bytes below the stack pointer that are never repainted, room for this code's own frame
 
 extern char _estack; // end of stack, declared in .LD file
 extern char _Min_Stack_Size; // declared in .LD file
+#ifdef STACK_CHECK
+extern char _sdata, _edata; // initialised data, declared in .LD file
+extern char _sbss, _ebss; // zero initialised data, declared in .LD file
+#endif
 
 /*
  * The ARM processor uses a full descending stack. This means the stack pointer holds the address
@@ -74,7 +81,8 @@ void taskStackCheck(timeUs_t currentTimeUs)
         }
     }
 
-    usedStackSize = (uint32_t)stackHighMem - (uint32_t)p;
+    // the stack may have been repainted since it was deepest, by stackSampleUsage()
+    usedStackSize = MAX(usedStackSize, (uint32_t)stackHighMem - (uint32_t)p);
 
     DEBUG_SET(DEBUG_STACK, 0, (uint32_t)stackHighMem & 0xffff);
     DEBUG_SET(DEBUG_STACK, 1, (uint32_t)stackLowMem & 0xffff);
@@ -86,6 +94,48 @@ uint32_t stackUsedSize(void)
 {
     return usedStackSize;
 }
+
+#ifdef USE_TASK_STACK_STATISTICS
+/*
+ * Returns the deepest the stack has been since the previous call, and repaints the stack below the
+ * stack pointer with the fill pattern, so the next call measures afresh. Called by the scheduler
+ * before and after a task runs, this gives the stack used by the task and any interrupts taken
+ * meanwhile. Whatever lies below the stack pointer is dead, so repainting it is safe even if an
+ * interrupt is taken while doing so.
+ */
+uint32_t stackSampleUsage(void)
+{
+    char * const stackHighMem = &_estack;
+    volatile uint32_t * const stackLowMem = (uint32_t *)(stackHighMem - (uint32_t)&_Min_Stack_Size);
+    volatile uint32_t * const stackCurrent = (uint32_t *)(__get_MSP() - STACK_REPAINT_MARGIN);
+
+    volatile uint32_t *p;
+    for (p = stackLowMem; p < stackCurrent; ++p) {
+        if (*p != STACK_FILL_WORD) {
+            break;
+        }
+    }
+    const uint32_t used = (uint32_t)stackHighMem - (uint32_t)p;
+    usedStackSize = MAX(usedStackSize, used);
+
+    // volatile, so the compiler does not turn this into a call to memset(), which would need stack of its own
+    for (; p < stackCurrent; ++p) {
+        *p = STACK_FILL_WORD;
+    }
+
+    return used;
+}
+#endif
+
+uint32_t ramDataSize(void)
+{
+    return (uint32_t)(intptr_t)(&_edata - &_sdata);
+}
+
+uint32_t ramBssSize(void)
+{
+    return (uint32_t)(intptr_t)(&_ebss - &_sbss);
+}
 #endif
 
 uint32_t stackTotalSize(void)
@@ -21,5 +21,8 @@
 
 void taskStackCheck(timeUs_t currentTimeUs);
 uint32_t stackUsedSize(void);
+uint32_t stackSampleUsage(void);
+uint32_t ramDataSize(void);
+uint32_t ramBssSize(void);
 uint32_t stackTotalSize(void);
 uint32_t stackHighMem(void);
@@ -17,6 +17,7 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "platform.h"
 
@@ -44,12 +45,85 @@ void cycleCounterInit(void)
     RCC_GetClocksFreq(&clocks);
     usTicks = clocks.SYSCLK_Frequency / 1000000;
 #endif
+
+#ifndef STM32F1 // the F1 CMSIS headers do not describe the DWT
+    // enable the DWT cycle counter, used for cycle accurate measurements
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+#if defined(STM32F7)
+    DWT->LAR = 0xC5ACCE55; // unlock the DWT registers
+#endif
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+}
+
+#ifndef STM32F1
+uint32_t getCycleCounter(void)
+{
+    return DWT->CYCCNT;
+}
+#endif
+
+uint32_t getCyclesPerMicrosecond(void)
+{
+    return usTicks;
+}
+
+#if defined(USE_ITCM_RAM) || defined(USE_FAST_RAM) || defined(USE_DMA_RAM)
+// Sets up the sections the startup code knows nothing about, before anything in them is used
+void initialiseMemorySections(void)
+{
+#ifdef USE_ITCM_RAM
+    // symbols from the linker script, tcm_code is where the code is stored in flash
+    extern uint8_t tcm_code_start;
+    extern uint8_t tcm_code_end;
+    extern uint8_t tcm_code;
+    memcpy(&tcm_code_start, &tcm_code, (size_t)(&tcm_code_end - &tcm_code_start));
+    // the code was written through the data bus and is fetched through the instruction bus
+    __DSB();
+    __ISB();
+#endif
+#ifdef USE_FAST_RAM
+    extern uint8_t _sfastram_bss;
+    extern uint8_t _efastram_bss;
+    memset(&_sfastram_bss, 0, (size_t)(&_efastram_bss - &_sfastram_bss));
+#endif
+#ifdef USE_DMA_RAM
+    extern uint8_t _sdmaram_bss;
+    extern uint8_t _edmaram_bss;
+    memset(&_sdmaram_bss, 0, (size_t)(&_edmaram_bss - &_sdmaram_bss));
+    // the data cache only goes on once the DMA buffers are out of its reach
+    enableDataCache();
+#endif
 }
+#endif
 
 // SysTick
 
 static volatile int sysTickPending = 0;
 
+// A single deadline, the tick expires it however long the scheduler is held up by other tasks
+static sysTickDeadlineFunc *sysTickDeadlineFn = NULL;
+static volatile uint32_t sysTickDeadline;
+static volatile bool sysTickDeadlineArmed = false;
+
+void sysTickDeadlineInit(sysTickDeadlineFunc *fn)
+{
+    sysTickDeadlineArmed = false;
+    sysTickDeadlineFn = fn;
+}
+
+// Re-arming before the deadline postpones it, the function is called once per arming
+void sysTickDeadlineArm(uint32_t delayUs)
+{
+    // rounded up, the tick that is due may come at any time
+    const uint32_t delayTicks = delayUs / 1000 + 1;
+    ATOMIC_BLOCK(NVIC_PRIO_MAX) {
+        sysTickDeadline = sysTickUptime + delayTicks;
+        sysTickDeadlineArmed = true;
+    }
+}
+
 void SysTick_Handler(void)
 {
     ATOMIC_BLOCK(NVIC_PRIO_MAX) {
@@ -57,6 +131,12 @@ void SysTick_Handler(void)
         sysTickPending = 0;
         (void)(SysTick->CTRL);
     }
+    if (sysTickDeadlineArmed && (int32_t)(sysTickUptime - sysTickDeadline) >= 0) {
+        sysTickDeadlineArmed = false;
+        if (sysTickDeadlineFn) {
+            sysTickDeadlineFn();
+        }
+    }
 #ifdef USE_HAL_DRIVER
     // used by the HAL for some timekeeping and timeouts, should always be 1ms
     HAL_IncTick();
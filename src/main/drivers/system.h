@@ -21,6 +21,8 @@
 #include <stdbool.h>
 
 void systemInit(void);
+void initialiseMemorySections(void);
+void enableDataCache(void);
 
 typedef enum {
     FAILURE_DEVELOPER = 0,
@@ -41,8 +43,15 @@ void systemReset(void);
 void systemResetToBootloader(void);
 bool isMPUSoftReset(void);
 void cycleCounterInit(void);
+uint32_t getCycleCounter(void);
+uint32_t getCyclesPerMicrosecond(void);
 void checkForBootLoaderRequest(void);
 
+// deadline watched by the tick interrupt, independent of the scheduler
+typedef void sysTickDeadlineFunc(void);
+void sysTickDeadlineInit(sysTickDeadlineFunc *fn);
+void sysTickDeadlineArm(uint32_t delayUs);
+
 void enableGPIOPowerUsageAndNoiseReductions(void);
 // current crystal frequency - 8 or 12MHz
 
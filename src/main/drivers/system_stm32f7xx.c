@@ -186,6 +186,36 @@ void systemInit(void)
     HAL_SYSTICK_CLKSourceConfig(SYSTICK_CLKSOURCE_HCLK);
 }
 
+#ifdef USE_DMA_RAM
+// DMA_RAM is the region the linker script gives it, a power of two in size and aligned to it as the MPU needs
+void enableDataCache(void)
+{
+    extern uint8_t _dmaram_origin;
+    extern uint8_t _dmaram_length;
+    const uint32_t length = (uint32_t)&_dmaram_length;
+
+    MPU_Region_InitTypeDef region = {
+        .Enable = MPU_REGION_ENABLE,
+        .Number = MPU_REGION_NUMBER0,
+        .BaseAddress = (uint32_t)&_dmaram_origin,
+        .Size = 30 - __CLZ(length),                 // encoded as log2(length) - 1
+        .SubRegionDisable = 0x00,
+        .TypeExtField = MPU_TEX_LEVEL1,             // normal memory, with the bits below not cacheable
+        .AccessPermission = MPU_REGION_FULL_ACCESS,
+        .DisableExec = MPU_INSTRUCTION_ACCESS_DISABLE,
+        .IsShareable = MPU_ACCESS_SHAREABLE,
+        .IsCacheable = MPU_ACCESS_NOT_CACHEABLE,
+        .IsBufferable = MPU_ACCESS_NOT_BUFFERABLE,
+    };
+
+    HAL_MPU_Disable();
+    HAL_MPU_ConfigRegion(&region);
+    HAL_MPU_Enable(MPU_PRIVILEGED_DEFAULT);         // the default memory map everywhere else
+
+    SCB_EnableDCache();
+}
+#endif
+
 void(*bootJump)(void);
 void checkForBootLoaderRequest(void)
 {
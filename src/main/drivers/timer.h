@@ -201,6 +201,11 @@ void timerOCPreloadConfig(TIM_TypeDef *tim, uint8_t channel, uint16_t preload);
 volatile timCCR_t *timerCCR(TIM_TypeDef *tim, uint8_t channel);
 uint16_t timerDmaSource(uint8_t channel);
 
+#ifdef USE_DSHOT_DMAR
+// Returns the DMA stream of the update request of the timer and sets its channel, or NULL if it has none.
+DMA_Stream_TypeDef *timerUpDmaRef(const TIM_TypeDef *tim, uint32_t *dmaChannel);
+#endif
+
 uint16_t timerGetPrescalerByDesiredHertz(TIM_TypeDef *tim, uint32_t hz);
 uint16_t timerGetPrescalerByDesiredMhz(TIM_TypeDef *tim, uint16_t mhz);
 uint16_t timerGetPeriodByPrescaler(TIM_TypeDef *tim, uint16_t prescaler, uint32_t hz);
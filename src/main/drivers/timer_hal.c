@@ -52,8 +52,15 @@
 
 #define TIM_IT_CCx(ch) (TIM_IT_CC1 << ((ch) / 4))
 
+// capture/compare dispatch entry, resolved when the callback is configured so the IRQ handler needs no lookups
+typedef struct timerCCDispatch_s {
+    timerCCHandlerCallback *fn;
+    timerCCHandlerRec_t *cb;
+    volatile timCCR_t *ccr;
+} timerCCDispatch_t;
+
 typedef struct timerConfig_s {
-    timerCCHandlerRec_t *edgeCallback[CC_CHANNELS_PER_TIMER];
+    timerCCDispatch_t edge[CC_CHANNELS_PER_TIMER];    // indexed by channel, TIM_IT_CC1..4 are status bits 1..4
     timerOvrHandlerRec_t *overflowCallback[CC_CHANNELS_PER_TIMER];
     timerOvrHandlerRec_t *overflowCallbackActive; // null-terminated linkded list of active overflow callbacks
     uint32_t forcedOverflowTimerValue;
@@ -375,6 +382,13 @@ static void timerChConfig_UpdateOverflow(timerConfig_t *cfg, TIM_TypeDef *tim) {
         __HAL_TIM_DISABLE_IT(&timerHandle[timerIndex].Handle, TIM_IT_UPDATE);
 }
 
+static void timerChSetEdgeDispatch(timerCCDispatch_t *edge, timerCCHandlerRec_t *edgeCallback, volatile timCCR_t *ccr)
+{
+    edge->fn = edgeCallback ? edgeCallback->fn : NULL;
+    edge->cb = edgeCallback;
+    edge->ccr = ccr;
+}
+
 // config edge and overflow callback for channel. Try to avoid overflowCallback, it is a bit expensive
 void timerChConfigCallbacks(const timerHardware_t *timHw, timerCCHandlerRec_t *edgeCallback, timerOvrHandlerRec_t *overflowCallback)
 {
@@ -386,7 +400,7 @@ void timerChConfigCallbacks(const timerHardware_t *timHw, timerCCHandlerRec_t *e
     if (edgeCallback == NULL)   // disable irq before changing callback to NULL
         __HAL_TIM_DISABLE_IT(&timerHandle[timerIndex].Handle, TIM_IT_CCx(timHw->channel));
     // setup callback info
-    timerConfig[timerIndex].edgeCallback[channelIndex] = edgeCallback;
+    timerChSetEdgeDispatch(&timerConfig[timerIndex].edge[channelIndex], edgeCallback, timerChCCR(timHw));
     timerConfig[timerIndex].overflowCallback[channelIndex] = overflowCallback;
     // enable channel IRQ
     if (edgeCallback)
@@ -414,8 +428,8 @@ void timerChConfigCallbacksDual(const timerHardware_t *timHw, timerCCHandlerRec_
         __HAL_TIM_DISABLE_IT(&timerHandle[timerIndex].Handle, TIM_IT_CCx(chHi));
 
     // setup callback info
-    timerConfig[timerIndex].edgeCallback[channelIndex] = edgeCallbackLo;
-    timerConfig[timerIndex].edgeCallback[channelIndex + 1] = edgeCallbackHi;
+    timerChSetEdgeDispatch(&timerConfig[timerIndex].edge[channelIndex], edgeCallbackLo, timerChCCRLo(timHw));
+    timerChSetEdgeDispatch(&timerConfig[timerIndex].edge[channelIndex + 1], edgeCallbackHi, timerChCCRHi(timHw));
     timerConfig[timerIndex].overflowCallback[channelIndex] = overflowCallback;
     timerConfig[timerIndex].overflowCallback[channelIndex + 1] = NULL;
 
@@ -606,75 +620,34 @@ void timerChConfigOC(const timerHardware_t* timHw, bool outEnable, bool stateHig
 
 static void timCCxHandler(TIM_TypeDef *tim, timerConfig_t *timerConfig)
 {
-    uint16_t capture;
-    unsigned tim_status;
-    tim_status = tim->SR & tim->DIER;
-#if 1
+    // CCxOF flags share bit positions with the DMA request enables in DIER, so keep only the flags that raise this IRQ
+    unsigned tim_status = tim->SR & tim->DIER & (TIM_IT_UPDATE | TIM_IT_CC1 | TIM_IT_CC2 | TIM_IT_CC3 | TIM_IT_CC4);
     while (tim_status) {
         // flags will be cleared by reading CCR in dual capture, make sure we call handler correctly
         // currrent order is highest bit first. Code should not rely on specific order (it will introduce race conditions anyway)
-        unsigned bit = __builtin_clz(tim_status);
-        unsigned mask = ~(0x80000000 >> bit);
+        unsigned bit = 31 - __builtin_clz(tim_status);
+        unsigned mask = ~(1U << bit);
         tim->SR = mask;
         tim_status &= mask;
-        switch (bit) {
-            case __builtin_clz(TIM_IT_UPDATE): {
-
-                if (timerConfig->forcedOverflowTimerValue != 0) {
-                    capture = timerConfig->forcedOverflowTimerValue - 1;
-                    timerConfig->forcedOverflowTimerValue = 0;
-                } else {
-                    capture = tim->ARR;
-                }
-
-                timerOvrHandlerRec_t *cb = timerConfig->overflowCallbackActive;
-                while (cb) {
-                    cb->fn(cb, capture);
-                    cb = cb->next;
-                }
-                break;
+        if (bit) {
+            const timerCCDispatch_t *edge = &timerConfig->edge[bit - 1];
+            edge->fn(edge->cb, *edge->ccr);
+        } else {
+            uint16_t capture;
+            if (timerConfig->forcedOverflowTimerValue != 0) {
+                capture = timerConfig->forcedOverflowTimerValue - 1;
+                timerConfig->forcedOverflowTimerValue = 0;
+            } else {
+                capture = tim->ARR;
+            }
+
+            timerOvrHandlerRec_t *cb = timerConfig->overflowCallbackActive;
+            while (cb) {
+                cb->fn(cb, capture);
+                cb = cb->next;
             }
-            case __builtin_clz(TIM_IT_CC1):
-                timerConfig->edgeCallback[0]->fn(timerConfig->edgeCallback[0], tim->CCR1);
-                break;
-            case __builtin_clz(TIM_IT_CC2):
-                timerConfig->edgeCallback[1]->fn(timerConfig->edgeCallback[1], tim->CCR2);
-                break;
-            case __builtin_clz(TIM_IT_CC3):
-                timerConfig->edgeCallback[2]->fn(timerConfig->edgeCallback[2], tim->CCR3);
-                break;
-            case __builtin_clz(TIM_IT_CC4):
-                timerConfig->edgeCallback[3]->fn(timerConfig->edgeCallback[3], tim->CCR4);
-                break;
-        }
-    }
-#else
-    if (tim_status & (int)TIM_IT_Update) {
-        tim->SR = ~TIM_IT_Update;
-        capture = tim->ARR;
-        timerOvrHandlerRec_t *cb = timerConfig->overflowCallbackActive;
-        while (cb) {
-            cb->fn(cb, capture);
-            cb = cb->next;
         }
     }
-    if (tim_status & (int)TIM_IT_CC1) {
-        tim->SR = ~TIM_IT_CC1;
-        timerConfig->edgeCallback[0]->fn(timerConfig->edgeCallback[0], tim->CCR1);
-    }
-    if (tim_status & (int)TIM_IT_CC2) {
-        tim->SR = ~TIM_IT_CC2;
-        timerConfig->edgeCallback[1]->fn(timerConfig->edgeCallback[1], tim->CCR2);
-    }
-    if (tim_status & (int)TIM_IT_CC3) {
-        tim->SR = ~TIM_IT_CC3;
-        timerConfig->edgeCallback[2]->fn(timerConfig->edgeCallback[2], tim->CCR3);
-    }
-    if (tim_status & (int)TIM_IT_CC4) {
-        tim->SR = ~TIM_IT_CC4;
-        timerConfig->edgeCallback[3]->fn(timerConfig->edgeCallback[3], tim->CCR4);
-    }
-#endif
 }
 
 // handler for shared interrupts when both timers need to check status bits
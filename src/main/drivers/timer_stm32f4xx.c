@@ -95,3 +95,34 @@ uint32_t timerClock(TIM_TypeDef *tim)
     #error "No timer clock defined correctly for MCU"
 #endif
 }
+
+#ifdef USE_DSHOT_DMAR
+typedef struct timerUpDma_s {
+    TIM_TypeDef *TIMx;
+    DMA_Stream_TypeDef *dmaRef;
+    uint32_t dmaChannel;
+} timerUpDma_t;
+
+// the streams of the update requests, from the DMA request mapping in RM0090
+static const timerUpDma_t timerUpDmas[] = {
+    { .TIMx = TIM1, .dmaRef = DMA2_Stream5, .dmaChannel = DMA_Channel_6 },
+    { .TIMx = TIM2, .dmaRef = DMA1_Stream1, .dmaChannel = DMA_Channel_3 },
+    { .TIMx = TIM3, .dmaRef = DMA1_Stream2, .dmaChannel = DMA_Channel_5 },
+    { .TIMx = TIM4, .dmaRef = DMA1_Stream6, .dmaChannel = DMA_Channel_2 },
+    { .TIMx = TIM5, .dmaRef = DMA1_Stream0, .dmaChannel = DMA_Channel_6 },
+#if !defined(STM32F411xE) && !defined(STM32F446xx)
+    { .TIMx = TIM8, .dmaRef = DMA2_Stream1, .dmaChannel = DMA_Channel_7 },
+#endif
+};
+
+DMA_Stream_TypeDef *timerUpDmaRef(const TIM_TypeDef *tim, uint32_t *dmaChannel)
+{
+    for (unsigned i = 0; i < ARRAYLEN(timerUpDmas); i++) {
+        if (timerUpDmas[i].TIMx == tim) {
+            *dmaChannel = timerUpDmas[i].dmaChannel;
+            return timerUpDmas[i].dmaRef;
+        }
+    }
+    return NULL;
+}
+#endif
@@ -23,6 +23,9 @@
 
 #ifdef TRANSPONDER
 
+#include "common/arena.h"
+#include "common/utils.h"
+
 #include "dma.h"
 #include "drivers/nvic.h"
 #include "drivers/io.h"
@@ -49,13 +52,33 @@ static DMA_Stream_TypeDef *dmaRef = NULL;
 
 transponder_t transponder;
 
+static transponderIrDMAValue_t *transponderIrDMARing; // claimed from the arena once a provider is configured
+static uint8_t transponderIrQuietHalves;
+
 static void TRANSPONDER_DMA_IRQHandler(dmaChannelDescriptor_t* descriptor)
 {
-    if (DMA_GET_FLAG_STATUS(descriptor, DMA_IT_TCIF)) {
-        transponderIrDataTransferInProgress = 0;
+    transponderIrDMAValue_t *half;
 
-        DMA_Cmd(descriptor->ref, DISABLE);
+    // refill the half of the ring the DMA has just finished sending
+    if (DMA_GET_FLAG_STATUS(descriptor, DMA_IT_HTIF)) {
+        DMA_CLEAR_FLAG(descriptor, DMA_IT_HTIF);
+        half = &transponderIrDMARing[0];
+    } else if (DMA_GET_FLAG_STATUS(descriptor, DMA_IT_TCIF)) {
         DMA_CLEAR_FLAG(descriptor, DMA_IT_TCIF);
+        half = &transponderIrDMARing[TRANSPONDER_DMA_RING_SIZE / 2];
+    } else {
+        return;
+    }
+
+    if (transponderIrWaveformFill(&transponder, half, TRANSPONDER_DMA_RING_SIZE / 2)) {
+        transponderIrQuietHalves = 0;
+        return;
+    }
+
+    // the last waveform period has gone out once both halves have been refilled with quiet periods
+    if (++transponderIrQuietHalves >= 2) {
+        DMA_Cmd(descriptor->ref, DISABLE);
+        transponderIrDataTransferInProgress = 0;
     }
 }
 
@@ -123,15 +146,15 @@ void transponderIrHardwareInit(ioTag_t ioTag, transponder_t *transponder)
     DMA_StructInit(&DMA_InitStructure);
     DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32_t)timerCCR(timer, timerHardware->channel);
 #if defined(STM32F3)
-    DMA_InitStructure.DMA_MemoryBaseAddr = (uint32_t)&(transponder->transponderIrDMABuffer);
+    DMA_InitStructure.DMA_MemoryBaseAddr = (uint32_t)transponderIrDMARing;
     DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralDST;
     DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
 #elif defined(STM32F4)
     DMA_InitStructure.DMA_Channel = timerHardware->dmaChannel;
-    DMA_InitStructure.DMA_Memory0BaseAddr = (uint32_t)&(transponder->transponderIrDMABuffer);
+    DMA_InitStructure.DMA_Memory0BaseAddr = (uint32_t)transponderIrDMARing;
     DMA_InitStructure.DMA_DIR = DMA_DIR_MemoryToPeripheral;
 #endif
-    DMA_InitStructure.DMA_BufferSize = transponder->dma_buffer_size;
+    DMA_InitStructure.DMA_BufferSize = TRANSPONDER_DMA_RING_SIZE;
     DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
     DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
 #if defined(STM32F3)
@@ -142,14 +165,14 @@ void transponderIrHardwareInit(ioTag_t ioTag, transponder_t *transponder)
     DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Word;
     DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_Word;
 #endif
-    DMA_InitStructure.DMA_Mode = DMA_Mode_Normal;
+    DMA_InitStructure.DMA_Mode = DMA_Mode_Circular;
     DMA_InitStructure.DMA_Priority = DMA_Priority_High;
 
     DMA_Init(dmaRef, &DMA_InitStructure);
 
     TIM_DMACmd(timer, timerDmaSource(timerHardware->channel), ENABLE);
 
-    DMA_ITConfig(dmaRef, DMA_IT_TC, ENABLE);
+    DMA_ITConfig(dmaRef, DMA_IT_HT | DMA_IT_TC, ENABLE);
 }
 
 bool transponderIrInit(const ioTag_t ioTag, const transponderProvider_e provider)
@@ -172,6 +195,10 @@ bool transponderIrInit(const ioTag_t ioTag, const transponderProvider_e provider
             return false;
     }
 
+    if (!transponderIrDMARing) {
+        transponderIrDMARing = arenaAlloc(TRANSPONDER_ARENA_SIZE);
+    }
+
     transponderIrHardwareInit(ioTag, &transponder);
 
     return true;
@@ -182,8 +209,6 @@ bool isTransponderIrReady(void)
     return !transponderIrDataTransferInProgress;
 }
 
-static uint16_t dmaBufferOffset;
-
 void transponderIrWaitForTransmitComplete(void)
 {
     static uint32_t waitCounter = 0;
@@ -201,7 +226,9 @@ void transponderIrUpdateData(const uint8_t* transponderData)
 
 void transponderIrDMAEnable(transponder_t *transponder)
 {
-    DMA_SetCurrDataCounter(dmaRef, transponder->dma_buffer_size);  // load number of bytes to be transferred
+    UNUSED(transponder);
+
+    DMA_SetCurrDataCounter(dmaRef, TRANSPONDER_DMA_RING_SIZE);
     TIM_SetCounter(timer, 0);
     TIM_Cmd(timer, ENABLE);
     DMA_Cmd(dmaRef, ENABLE);
@@ -226,7 +253,9 @@ void transponderIrTransmit(void)
 {
     transponderIrWaitForTransmitComplete();
 
-    dmaBufferOffset = 0;
+    transponderIrWaveformRewind(&transponder);
+    transponderIrWaveformFill(&transponder, transponderIrDMARing, TRANSPONDER_DMA_RING_SIZE);
+    transponderIrQuietHalves = 0;
 
     transponderIrDataTransferInProgress = 1;
     transponderIrDMAEnable(&transponder);
@@ -63,39 +63,38 @@
 
 /*
  * Implementation note:
- * Using around over 700 bytes for a transponder DMA buffer is a little excessive, likely an alternative implementation that uses a fast
- * ISR to generate the output signal dynamically based on state would be more memory efficient and would likely be more appropriate for
- * other targets.  However this approach requires very little CPU time and is just fire-and-forget.
- *
- * On an STM32F303CC 720 bytes is currently fine and that is the target for which this code was designed for.
+ * The encoders no longer write one compare value per carrier period. Each code is encoded once, when the transponder data
+ * changes, into a list of runs of pulsed or quiet carrier periods (at most a few hundred bytes of waveform become about a
+ * hundred bytes of runs). A transmission replays the runs through a small circular DMA ring, refilling one half from the
+ * half-transfer and transfer-complete interrupts while the other half is being sent.
  */
-#if defined(STM32F3) || defined(UNIT_TEST)
+#define TRANSPONDER_RUN_COUNT_MAX       128     // ILAP needs at most 2 runs for each of its 60 bits
+#define TRANSPONDER_RUN_PULSED          0x80
+#define TRANSPONDER_RUN_LENGTH_MAX      0x7F
+#define TRANSPONDER_DMA_RING_SIZE       64      // carrier periods, refilled half at a time
+
+#if defined(STM32F4)
+typedef uint32_t transponderIrDMAValue_t;
+#else
+typedef uint8_t transponderIrDMAValue_t;
+#endif
 
-    typedef union transponderIrDMABuffer_s {
-        uint8_t arcitimer[TRANSPONDER_DMA_BUFFER_SIZE_ARCITIMER]; // 620
-        uint8_t ilap[TRANSPONDER_DMA_BUFFER_SIZE_ILAP]; // 720
-        uint8_t erlt[TRANSPONDER_DMA_BUFFER_SIZE_ERLT]; // 91-200
-    } transponderIrDMABuffer_t;
+#define TRANSPONDER_ARENA_SIZE          (TRANSPONDER_DMA_RING_SIZE * sizeof(transponderIrDMAValue_t))
 
-#elif defined(STM32F4)
-
-    typedef union transponderIrDMABuffer_s {
-        uint32_t arcitimer[TRANSPONDER_DMA_BUFFER_SIZE_ARCITIMER]; // 620
-        uint32_t ilap[TRANSPONDER_DMA_BUFFER_SIZE_ILAP]; // 720
-        uint32_t erlt[TRANSPONDER_DMA_BUFFER_SIZE_ERLT]; // 91-200
-    } transponderIrDMABuffer_t;
-#endif
+typedef struct transponderIrWaveform_s {
+    uint8_t run[TRANSPONDER_RUN_COUNT_MAX];     // TRANSPONDER_RUN_PULSED | length in carrier periods
+    uint8_t runCount;
+    uint8_t runIndex;                           // replay position
+    uint8_t runRemaining;
+} transponderIrWaveform_t;
 
 typedef struct transponder_s {
     uint8_t gap_toggles;
     uint32_t timer_hz;
     uint32_t timer_carrier_hz;
     uint16_t bitToggleOne;
-    uint32_t dma_buffer_size;
 
-    #if defined(STM32F3) || defined(STM32F4)|| defined(UNIT_TEST)
-        transponderIrDMABuffer_t transponderIrDMABuffer;
-    #endif
+    transponderIrWaveform_t waveform;
 
     const struct transponderVTable *vTable;
 } transponder_t;
@@ -116,6 +115,11 @@ struct transponderVTable {
 bool transponderIrInit(const ioTag_t ioTag, const transponderProvider_e provider);
 void transponderIrDisable(void);
 
+void transponderIrWaveformClear(transponder_t *transponder);
+void transponderIrWaveformAdd(transponder_t *transponder, unsigned periods, bool pulsed);
+void transponderIrWaveformRewind(transponder_t *transponder);
+bool transponderIrWaveformFill(transponder_t *transponder, transponderIrDMAValue_t *buffer, unsigned count);
+
 void transponderIrHardwareInit(ioTag_t ioTag, transponder_t *transponder);
 void transponderIrDMAEnable(transponder_t *transponder);
 
@@ -24,37 +24,32 @@
 #if defined(STM32F3) || defined(STM32F4) || defined(UNIT_TEST)
 
 extern const struct transponderVTable arcitimerTansponderVTable;
-static uint16_t dmaBufferOffset;
 
 void transponderIrInitArcitimer(transponder_t *transponder){
     // from drivers/transponder_ir.h
     transponder->gap_toggles        = TRANSPONDER_GAP_TOGGLES_ARCITIMER;
-    transponder->dma_buffer_size    = TRANSPONDER_DMA_BUFFER_SIZE_ARCITIMER;
     transponder->vTable             = &arcitimerTansponderVTable;
     transponder->timer_hz           = TRANSPONDER_TIMER_MHZ_ARCITIMER;
     transponder->timer_carrier_hz   = TRANSPONDER_CARRIER_HZ_ARCITIMER;
-    memset(&(transponder->transponderIrDMABuffer.arcitimer), 0, TRANSPONDER_DMA_BUFFER_SIZE_ARCITIMER);
+    transponderIrWaveformClear(transponder);
 }
 
 void updateTransponderDMABufferArcitimer(transponder_t *transponder, const uint8_t* transponderData)
 {
     uint8_t byteIndex;
     uint8_t bitIndex;
-    uint8_t hightStateIndex;
+    transponderIrWaveformClear(transponder);
     for (byteIndex = 0; byteIndex < TRANSPONDER_DATA_LENGTH_ARCITIMER; byteIndex++) {
         uint8_t byteToSend = *transponderData;
         transponderData++;
         for (bitIndex = 0; bitIndex < TRANSPONDER_BITS_PER_BYTE_ARCITIMER; bitIndex++)
         {
             bool isHightState = byteToSend & (1 << (bitIndex));
-            for (hightStateIndex = 0; hightStateIndex < TRANSPONDER_TOGGLES_PER_BIT_ARCITIMER; hightStateIndex++)
-            {
-                transponder->transponderIrDMABuffer.arcitimer[dmaBufferOffset] = isHightState ? transponder->bitToggleOne : 0;
-                dmaBufferOffset++;
-            }
+            transponderIrWaveformAdd(transponder, TRANSPONDER_TOGGLES_PER_BIT_ARCITIMER, isHightState);
         }
     }
-    dmaBufferOffset = 0;
+    // stay quiet for the rest of the frame
+    transponderIrWaveformAdd(transponder, TRANSPONDER_DMA_BUFFER_SIZE_ARCITIMER - TRANSPONDER_DATA_LENGTH_ARCITIMER * TRANSPONDER_BITS_PER_BYTE_ARCITIMER * TRANSPONDER_TOGGLES_PER_BIT_ARCITIMER, false);
 }
 
 
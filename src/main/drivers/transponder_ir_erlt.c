@@ -23,22 +23,18 @@
 
 #if defined(STM32F3) || defined(STM32F4) || defined(UNIT_TEST)
 
-static uint16_t dmaBufferOffset;
 extern const struct transponderVTable erltTansponderVTable;
 
 void transponderIrInitERLT(transponder_t *transponder){
-    transponder->dma_buffer_size    = TRANSPONDER_DMA_BUFFER_SIZE_ERLT;
     transponder->vTable             = &erltTansponderVTable;
     transponder->timer_hz           = TRANSPONDER_TIMER_MHZ_ERLT;
     transponder->timer_carrier_hz   = TRANSPONDER_CARRIER_HZ_ERLT;
-    memset(&(transponder->transponderIrDMABuffer.erlt), 0, TRANSPONDER_DMA_BUFFER_SIZE_ERLT);
+    transponderIrWaveformClear(transponder);
 }
 
-void addBitToBuffer(transponder_t *transponder, uint8_t cycles, uint8_t pulsewidth)
+void addBitToBuffer(transponder_t *transponder, uint8_t cycles, uint16_t pulsewidth)
 {
-	for (int i = 0; i < cycles; i++) {
-		transponder->transponderIrDMABuffer.erlt[dmaBufferOffset++] = pulsewidth;
-    }
+	transponderIrWaveformAdd(transponder, cycles, pulsewidth != ERLTBitQuiet);
 }
 
 void updateTransponderDMABufferERLT(transponder_t *transponder, const uint8_t* transponderData)
@@ -46,7 +42,7 @@ void updateTransponderDMABufferERLT(transponder_t *transponder, const uint8_t* t
 	uint8_t byteToSend = ~(*transponderData); //transponderData is stored inverted, so invert before using
 	uint8_t paritysum = 0; //sum of one bits
 
-	dmaBufferOffset = 0; //reset buffer count
+	transponderIrWaveformClear(transponder);
 
 	//start bit 1, always pulsed, bit value = 0
 	addBitToBuffer(transponder, ERLTCyclesForZeroBit, transponder->bitToggleOne);
@@ -66,10 +62,7 @@ void updateTransponderDMABufferERLT(transponder_t *transponder, const uint8_t* t
 	addBitToBuffer(transponder, ((paritysum % 2) ?  ERLTCyclesForOneBit : ERLTCyclesForZeroBit), transponder->bitToggleOne);
 
 	//add final zero after the pulsed parity bit to stop pulses until the next update
-	transponder->transponderIrDMABuffer.erlt[dmaBufferOffset++] = ERLTBitQuiet;
-
-	//reset buffer size to that required by this ERLT id
-	transponder->dma_buffer_size = dmaBufferOffset;
+	addBitToBuffer(transponder, 1, ERLTBitQuiet);
 }
 
 const struct transponderVTable erltTansponderVTable = {
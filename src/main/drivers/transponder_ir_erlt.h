@@ -18,4 +18,4 @@
 
 void transponderIrInitERLT(transponder_t *transponder);
 void updateTransponderDMABufferERLT(transponder_t *transponder, const uint8_t* transponderData);
-void addBitToBuffer(transponder_t *transponder, uint8_t cycles, uint8_t pulsewidth);
+void addBitToBuffer(transponder_t *transponder, uint8_t cycles, uint16_t pulsewidth);
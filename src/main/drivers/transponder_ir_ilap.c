@@ -23,17 +23,15 @@
 
 #if defined(STM32F3) || defined(STM32F4) || defined(UNIT_TEST)
 
-static uint16_t dmaBufferOffset;
 extern const struct transponderVTable ilapTansponderVTable;
 
 void transponderIrInitIlap(transponder_t *transponder){
     // from drivers/transponder_ir.h
     transponder->gap_toggles        = TRANSPONDER_GAP_TOGGLES_ILAP;
-    transponder->dma_buffer_size    = TRANSPONDER_DMA_BUFFER_SIZE_ILAP;
     transponder->vTable             = &ilapTansponderVTable;
     transponder->timer_hz           = TRANSPONDER_TIMER_MHZ_ILAP;
     transponder->timer_carrier_hz   = TRANSPONDER_CARRIER_HZ_ILAP;
-    memset(&(transponder->transponderIrDMABuffer.ilap), 0, TRANSPONDER_DMA_BUFFER_SIZE_ILAP);
+    transponderIrWaveformClear(transponder);
 
 }
 
@@ -41,7 +39,7 @@ void updateTransponderDMABufferIlap(transponder_t *transponder, const uint8_t* t
 {
         uint8_t byteIndex;
         uint8_t bitIndex;
-        uint8_t toggleIndex;
+        transponderIrWaveformClear(transponder);
         for (byteIndex = 0; byteIndex < TRANSPONDER_DATA_LENGTH_ILAP; byteIndex++) {
             uint8_t byteToSend = *transponderData;
             transponderData++;
@@ -57,21 +55,10 @@ void updateTransponderDMABufferIlap(transponder_t *transponder, const uint8_t* t
                 else {
                     doToggles = byteToSend & (1 << (bitIndex - 1));
                 }
-                for (toggleIndex = 0; toggleIndex < TRANSPONDER_TOGGLES_PER_BIT_ILAP; toggleIndex++)
-                {
-                    if (doToggles) {
-                        transponder->transponderIrDMABuffer.ilap[dmaBufferOffset] = transponder->bitToggleOne;
-                    }
-                    else {
-                        transponder->transponderIrDMABuffer.ilap[dmaBufferOffset] = 0;
-                    }
-                    dmaBufferOffset++;
-                }
-                transponder->transponderIrDMABuffer.ilap[dmaBufferOffset] = 0;
-                dmaBufferOffset++;
+                transponderIrWaveformAdd(transponder, TRANSPONDER_TOGGLES_PER_BIT_ILAP, doToggles);
+                transponderIrWaveformAdd(transponder, TRANSPONDER_GAP_TOGGLES_ILAP, false);
             }
         }
-        dmaBufferOffset = 0;
 }
 
 const struct transponderVTable ilapTansponderVTable = {
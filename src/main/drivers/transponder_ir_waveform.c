@@ -0,0 +1,92 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdbool.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <platform.h>
+#include "drivers/transponder_ir.h"
+
+#if defined(STM32F3) || defined(STM32F4) || defined(UNIT_TEST)
+
+void transponderIrWaveformClear(transponder_t *transponder)
+{
+    memset(&transponder->waveform, 0, sizeof(transponder->waveform));
+}
+
+// append carrier periods, merging with the previous run when it has the same state
+void transponderIrWaveformAdd(transponder_t *transponder, unsigned periods, bool pulsed)
+{
+    transponderIrWaveform_t *waveform = &transponder->waveform;
+    const uint8_t state = pulsed ? TRANSPONDER_RUN_PULSED : 0;
+
+    while (periods) {
+        uint8_t *run = waveform->runCount ? &waveform->run[waveform->runCount - 1] : NULL;
+        if (!run || (*run & TRANSPONDER_RUN_PULSED) != state || (*run & TRANSPONDER_RUN_LENGTH_MAX) == TRANSPONDER_RUN_LENGTH_MAX) {
+            if (waveform->runCount >= TRANSPONDER_RUN_COUNT_MAX) {
+                return;
+            }
+            run = &waveform->run[waveform->runCount++];
+            *run = state;
+        }
+        const unsigned space = TRANSPONDER_RUN_LENGTH_MAX - (*run & TRANSPONDER_RUN_LENGTH_MAX);
+        const unsigned length = periods < space ? periods : space;
+        *run += length;
+        periods -= length;
+    }
+}
+
+void transponderIrWaveformRewind(transponder_t *transponder)
+{
+    transponder->waveform.runIndex = 0;
+    transponder->waveform.runRemaining = transponder->waveform.runCount ? transponder->waveform.run[0] & TRANSPONDER_RUN_LENGTH_MAX : 0;
+}
+
+// expand the next count carrier periods into compare values, quiet once the runs are used up.
+// returns false when none of the written periods came from the waveform.
+bool transponderIrWaveformFill(transponder_t *transponder, transponderIrDMAValue_t *buffer, unsigned count)
+{
+    transponderIrWaveform_t *waveform = &transponder->waveform;
+    bool written = false;
+
+    while (count) {
+        if (waveform->runIndex >= waveform->runCount) {
+            memset(buffer, 0, count * sizeof(*buffer));
+            break;
+        }
+        if (!waveform->runRemaining) {
+            if (++waveform->runIndex < waveform->runCount) {
+                waveform->runRemaining = waveform->run[waveform->runIndex] & TRANSPONDER_RUN_LENGTH_MAX;
+            }
+            continue;
+        }
+
+        const transponderIrDMAValue_t value = (waveform->run[waveform->runIndex] & TRANSPONDER_RUN_PULSED) ? transponder->bitToggleOne : 0;
+        const unsigned length = count < waveform->runRemaining ? count : waveform->runRemaining;
+        for (unsigned i = 0; i < length; i++) {
+            buffer[i] = value;
+        }
+        buffer += length;
+        count -= length;
+        waveform->runRemaining -= length;
+        written = true;
+    }
+
+    return written;
+}
+
+#endif
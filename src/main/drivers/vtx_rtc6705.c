@@ -30,7 +30,9 @@
 #if defined(VTX_RTC6705) && !defined(VTX_RTC6705SOFTSPI)
 
 #include "common/maths.h"
+#include "common/utils.h"
 
+#include "drivers/bus.h"
 #include "drivers/bus_spi.h"
 #include "drivers/io.h"
 #include "drivers/time.h"
@@ -90,14 +92,14 @@ static IO_t vtxPowerPin     = IO_NONE;
 #endif
 static IO_t vtxCSPin        = IO_NONE;
 
-#define DISABLE_RTC6705()   IOHi(vtxCSPin)
+#define DISABLE_RTC6705()   spiBusDeselectDevice(RTC6705_SPI_INSTANCE, vtxCSPin)
 
 #ifdef USE_RTC6705_CLK_HACK
 static IO_t vtxCLKPin       = IO_NONE;
 // HACK for missing pull up on CLK line - drive the CLK high *before* enabling the CS pin.
-#define ENABLE_RTC6705()    {IOHi(vtxCLKPin); delayMicroseconds(5); IOLo(vtxCSPin); }
+#define ENABLE_RTC6705()    {IOHi(vtxCLKPin); delayMicroseconds(5); spiBusSelectDevice(RTC6705_SPI_INSTANCE, vtxCSPin); }
 #else
-#define ENABLE_RTC6705()    IOLo(vtxCSPin)
+#define ENABLE_RTC6705()    spiBusSelectDevice(RTC6705_SPI_INSTANCE, vtxCSPin)
 #endif
 
 #define DP_5G_MASK          0x7000 // b111000000000000
@@ -115,6 +117,26 @@ static IO_t vtxCLKPin       = IO_NONE;
 #define ENABLE_VTX_POWER()          IOLo(vtxPowerPin)
 #define DISABLE_VTX_POWER()         IOHi(vtxPowerPin)
 
+#ifndef USE_RTC6705_CLK_HACK
+// The register frames are queued on the SPI bus, the CLK hack needs the pins driven by hand around CS
+#define USE_RTC6705_TRANSACTIONS
+#endif
+
+#define RTC6705_MAX_FRAMES          2   // register writes in one change
+
+#ifdef USE_RTC6705_TRANSACTIONS
+typedef struct rtc6705Batch_s {
+    spiTransaction_t transaction;
+    spiSegment_t segments[RTC6705_MAX_FRAMES];
+    uint8_t frames[RTC6705_MAX_FRAMES][4];
+} rtc6705Batch_t;
+
+static busDevice_t rtc6705Bus;
+// A change can be queued while the one before is still on the bus
+static rtc6705Batch_t rtc6705Batches[2];
+static uint8_t rtc6705NextBatch;
+#endif
+
 
 // Define variables
 static const uint32_t channelArray[RTC6705_BAND_COUNT][RTC6705_CHANNEL_COUNT] = {
@@ -169,8 +191,47 @@ void rtc6705IOInit(void)
     // GPIO bit is enabled so here so the output is not pulled low when the GPIO is set in output mode.
     // Note: It's critical to ensure that incorrect signals are not sent to the VTX.
     IOConfigGPIO(vtxCSPin, IOCFG_OUT_PP);
+
+#ifdef USE_RTC6705_TRANSACTIONS
+    rtc6705Bus.bustype = BUSTYPE_SPI;
+    rtc6705Bus.busdev_u.spi.instance = RTC6705_SPI_INSTANCE;
+    rtc6705Bus.busdev_u.spi.csnPin = vtxCSPin;
+    rtc6705Bus.busdev_u.spi.divisor = SPI_CLOCK_SLOW;
+#endif
 }
 
+#ifdef USE_RTC6705_TRANSACTIONS
+/**
+ * Queue 25bit packets to RTC6705, each in its own CS cycle
+ * They are sent as 32bit packets LSB first like rtc6705Transfer() does,
+ * the call returns without waiting for the bus
+ */
+static void rtc6705Write(const uint32_t *commands, uint8_t count)
+{
+    rtc6705Batch_t *batch = &rtc6705Batches[rtc6705NextBatch];
+    rtc6705NextBatch = (rtc6705NextBatch + 1) % ARRAYLEN(rtc6705Batches);
+
+    // Only waits when changes come in faster than the bus sends them
+    spiTransactionWait(&batch->transaction);
+
+    for (int i = 0; i < count; i++) {
+        const uint32_t command = reverse32(commands[i]);
+
+        batch->frames[i][0] = (command >> 24) & 0xFF;
+        batch->frames[i][1] = (command >> 16) & 0xFF;
+        batch->frames[i][2] = (command >> 8) & 0xFF;
+        batch->frames[i][3] = (command >> 0) & 0xFF;
+        batch->segments[i] = (spiSegment_t){ .txData = batch->frames[i], .length = 4, .negateCS = true };
+    }
+
+    batch->transaction.bus = &rtc6705Bus;
+    batch->transaction.priority = SPI_PRIORITY_LOW;
+    batch->transaction.segments = batch->segments;
+    batch->transaction.segmentCount = count;
+
+    spiTransactionSubmit(&batch->transaction);
+}
+#else
 /**
  * Transfer a 25bit packet to RTC6705
  * This will just send it as a 32bit packet LSB meaning
@@ -194,6 +255,19 @@ static void rtc6705Transfer(uint32_t command)
     delayMicroseconds(2);
 }
 
+static void rtc6705Write(const uint32_t *commands, uint8_t count)
+{
+    spiSetDivisor(RTC6705_SPI_INSTANCE, SPI_CLOCK_SLOW);
+
+    for (int i = 0; i < count; i++) {
+        if (i) {
+            delayMicroseconds(10);
+        }
+        rtc6705Transfer(commands[i]);
+    }
+}
+#endif
+
 /**
  * Set a band and channel
  */
@@ -202,10 +276,8 @@ void rtc6705SetBandAndChannel(uint8_t band, uint8_t channel)
     band = constrain(band, 0, RTC6705_BAND_COUNT - 1);
     channel = constrain(channel, 0, RTC6705_CHANNEL_COUNT - 1);
 
-    spiSetDivisor(RTC6705_SPI_INSTANCE, SPI_CLOCK_SLOW);
-
-    rtc6705Transfer(RTC6705_SET_HEAD);
-    rtc6705Transfer(channelArray[band][channel]);
+    const uint32_t commands[] = { RTC6705_SET_HEAD, channelArray[band][channel] };
+    rtc6705Write(commands, ARRAYLEN(commands));
 }
 
  /**
@@ -225,25 +297,20 @@ void rtc6705SetFreq(uint16_t frequency)
     val_hex |= (val_a << 5);
     val_hex |= (val_n << 12);
 
-    spiSetDivisor(RTC6705_SPI_INSTANCE, SPI_CLOCK_SLOW);
-
-    rtc6705Transfer(RTC6705_SET_HEAD);
-    delayMicroseconds(10);
-    rtc6705Transfer(val_hex);
+    const uint32_t commands[] = { RTC6705_SET_HEAD, val_hex };
+    rtc6705Write(commands, ARRAYLEN(commands));
 }
 
 void rtc6705SetRFPower(uint8_t rf_power)
 {
     rf_power = constrain(rf_power, 0, RTC6705_RF_POWER_COUNT - 1);
 
-    spiSetDivisor(RTC6705_SPI_INSTANCE, SPI_CLOCK_SLOW);
-
     uint32_t val_hex = RTC6705_RW_CONTROL_BIT; // write
     val_hex |= RTC6705_ADDRESS; // address
     uint32_t data = rf_power == 0 ? (PA_CONTROL_DEFAULT | PD_Q5G_MASK) & (~(PA5G_PW_MASK | PA5G_BS_MASK)) : PA_CONTROL_DEFAULT;
     val_hex |= data << 5; // 4 address bits and 1 rw bit.
 
-    rtc6705Transfer(val_hex);
+    rtc6705Write(&val_hex, 1);
 }
 
 void rtc6705Disable(void)
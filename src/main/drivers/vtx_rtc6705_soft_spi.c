@@ -80,7 +80,7 @@ static void rtc6705_write_register(uint8_t addr, uint32_t data)
     uint8_t i;
 
     RTC6705_SPILE_OFF;
-    delay(1);
+    delayMicroseconds(1);
     // send address
     for (i=0; i<4; i++) {
         if ((addr >> i) & 1)
@@ -89,26 +89,26 @@ static void rtc6705_write_register(uint8_t addr, uint32_t data)
             RTC6705_SPIDATA_OFF;
 
         RTC6705_SPICLK_ON;
-        delay(1);
+        delayMicroseconds(1);
         RTC6705_SPICLK_OFF;
-        delay(1);
+        delayMicroseconds(1);
     }
     // Write bit
 
     RTC6705_SPIDATA_ON;
     RTC6705_SPICLK_ON;
-    delay(1);
+    delayMicroseconds(1);
     RTC6705_SPICLK_OFF;
-    delay(1);
+    delayMicroseconds(1);
     for (i=0; i<20; i++) {
         if ((data >> i) & 1)
             RTC6705_SPIDATA_ON;
         else
             RTC6705_SPIDATA_OFF;
         RTC6705_SPICLK_ON;
-        delay(1);
+        delayMicroseconds(1);
         RTC6705_SPICLK_OFF;
-        delay(1);
+        delayMicroseconds(1);
     }
     RTC6705_SPILE_ON;
 }
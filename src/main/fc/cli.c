@@ -43,6 +43,7 @@ extern uint8_t __config_end;
 
 #include "common/axis.h"
 #include "common/color.h"
+#include "common/crc.h"
 #include "common/maths.h"
 #include "common/printf.h"
 #include "common/typeconversion.h"
@@ -86,6 +87,9 @@ extern uint8_t __config_end;
 #include "fc/fc_core.h"
 #include "fc/fc_msp.h"
 #include "fc/fc_msp_box.h"
+#include "fc/dshot_benchmark.h"
+#include "fc/kernel_benchmark.h"
+#include "fc/loop_benchmark.h"
 #include "fc/rc_adjustments.h"
 #include "fc/rc_controls.h"
 #include "fc/runtime_config.h"
@@ -138,7 +142,12 @@ static serialPort_t *cliPort;
 // Space required to set array parameters
 #define CLI_IN_BUFFER_SIZE 256
 #endif
+#ifdef STM32F1
 #define CLI_OUT_BUFFER_SIZE 64
+#else
+// Output is only pushed to the port when this fills up or a command is done, a dump goes out in large writes
+#define CLI_OUT_BUFFER_SIZE 256
+#endif
 
 static bufWriter_t *cliWriter;
 static uint8_t cliWriteBuffer[sizeof(*cliWriter) + CLI_OUT_BUFFER_SIZE];
@@ -148,6 +157,12 @@ static uint32_t bufferIndex = 0;
 
 static bool configIsInCopy = false;
 
+#ifdef USE_CLI_BATCH
+// Between "batch start" and "batch end" the work that depends on more than one line is left until the end
+static bool cliBatchMode = false;
+static uint8_t cliBatchErrorCount = 0;
+#endif
+
 static const char* const emptyName = "-";
 static const char* const emptryString = "";
 
@@ -199,7 +214,6 @@ static void cliPrint(const char *str)
     while (*str) {
         bufWriterAppend(cliWriter, *str++);
     }
-    bufWriterFlush(cliWriter);
 }
 
 static void cliPrintLinefeed()
@@ -241,13 +255,11 @@ typedef enum {
 static void cliPrintfva(const char *format, va_list va)
 {
     tfp_format(cliWriter, cliPutp, format, va);
-    bufWriterFlush(cliWriter);
 }
 
 static void cliPrintLinefva(const char *format, va_list va)
 {
     tfp_format(cliWriter, cliPutp, format, va);
-    bufWriterFlush(cliWriter);
     cliPrintLinefeed();
 }
 
@@ -301,6 +313,33 @@ static void cliPrintLinef(const char *format, ...)
     va_end(va);
 }
 
+static void cliCountError(void)
+{
+#ifdef USE_CLI_BATCH
+    if (cliBatchMode && cliBatchErrorCount < UINT8_MAX) {
+        cliBatchErrorCount++;
+    }
+#endif
+}
+
+static void cliPrintErrorLinef(const char *format, ...)
+{
+    cliCountError();
+
+    va_list va;
+    va_start(va, format);
+    cliPrintLinefva(format, va);
+    va_end(va);
+}
+
+
+// Settings are printed by the hundred in a dump, this skips the format parsing of cliPrintf("%d")
+static void cliPrintInt(int value)
+{
+    char buf[FMT_INT_BUFFER_LENGTH];
+    fmtInt(buf, value, 0, ' ');
+    cliPrint(buf);
+}
 
 static void printValuePointer(const clivalue_t *var, const void *valuePointer, bool full)
 {
@@ -310,22 +349,22 @@ static void printValuePointer(const clivalue_t *var, const void *valuePointer, b
             default:
             case VAR_UINT8:
                 // uint8_t array
-                cliPrintf("%d", ((uint8_t *)valuePointer)[i]);
+                cliPrintInt(((uint8_t *)valuePointer)[i]);
                 break;
 
             case VAR_INT8:
                 // int8_t array
-                cliPrintf("%d", ((int8_t *)valuePointer)[i]);
+                cliPrintInt(((int8_t *)valuePointer)[i]);
                 break;
 
             case VAR_UINT16:
                 // uin16_t array
-                cliPrintf("%d", ((uint16_t *)valuePointer)[i]);
+                cliPrintInt(((uint16_t *)valuePointer)[i]);
                 break;
 
             case VAR_INT16:
                 // int16_t array
-                cliPrintf("%d", ((int16_t *)valuePointer)[i]);
+                cliPrintInt(((int16_t *)valuePointer)[i]);
                 break;
             }
 
@@ -353,9 +392,12 @@ static void printValuePointer(const clivalue_t *var, const void *valuePointer, b
 
         switch (var->type & VALUE_MODE_MASK) {
         case MODE_DIRECT:
-            cliPrintf("%d", value);
+            cliPrintInt(value);
             if (full) {
-                cliPrintf(" %d %d", var->config.minmax.min, var->config.minmax.max);
+                cliPrint(" ");
+                cliPrintInt(var->config.minmax.min);
+                cliPrint(" ");
+                cliPrintInt(var->config.minmax.max);
             }
             break;
         case MODE_LOOKUP:
@@ -434,12 +476,28 @@ static void dumpPgValue(const clivalue_t *value, uint8_t dumpMask)
 
 static void dumpAllValues(uint16_t valueSection, uint8_t dumpMask)
 {
+    const pgRegistry_t *pg = NULL;
+    bool pgEqualsDefault = false;
+
     for (uint32_t i = 0; i < valueTableEntryCount; i++) {
         const clivalue_t *value = &valueTable[i];
-        bufWriterFlush(cliWriter);
-        if ((value->type & VALUE_SECTION_MASK) == valueSection) {
-            dumpPgValue(value, dumpMask);
+        if ((value->type & VALUE_SECTION_MASK) != valueSection) {
+            continue;
+        }
+
+        if (dumpMask & DO_DIFF) {
+            // The values of a group are mostly next to each other in the table, one compare of the
+            // whole group skips all of them when nothing in it was changed from the defaults
+            if (!pg || pgN(pg) != value->pgn) {
+                pg = pgFind(value->pgn);
+                pgEqualsDefault = pg && memcmp(pg->copy, pg->address, pgSize(pg)) == 0;
+            }
+            if (pgEqualsDefault) {
+                continue;
+            }
         }
+
+        dumpPgValue(value, dumpMask);
     }
 }
 
@@ -513,12 +571,12 @@ static void cliPrompt(void)
 
 static void cliShowParseError(void)
 {
-    cliPrintLine("Parse error");
+    cliPrintErrorLinef("Parse error");
 }
 
 static void cliShowArgumentRangeError(char *name, int min, int max)
 {
-    cliPrintLinef("%s not between %d and %d", name, min, max);
+    cliPrintErrorLinef("%s not between %d and %d", name, min, max);
 }
 
 static const char *nextArg(const char *currentArg)
@@ -747,6 +805,7 @@ static void cliAux(char *cmdline)
             if (validArgumentCount != 4) {
                 memset(mac, 0, sizeof(modeActivationCondition_t));
             }
+            analyzeModeActivationConditions();
         } else {
             cliShowArgumentRangeError("index", 0, MAX_MODE_ACTIVATION_CONDITION_COUNT - 1);
         }
@@ -939,6 +998,7 @@ static void cliSerialPassthrough(char *cmdline)
     }
 
     cliPrintLine("Forwarding, power cycle to exit.");
+    bufWriterFlush(cliWriter);
 
     serialPassthrough(cliPort, passThroughPort, NULL, NULL);
 }
@@ -1035,6 +1095,7 @@ static void cliAdjustmentRange(char *cmdline)
                 memset(ar, 0, sizeof(adjustmentRange_t));
                 cliShowParseError();
             }
+            analyzeModeActivationConditions();
         } else {
             cliShowArgumentRangeError("index", 0, MAX_ADJUSTMENT_RANGE_COUNT - 1);
         }
@@ -1103,7 +1164,7 @@ static void cliMotorMix(char *cmdline)
             len = strlen(ptr);
             for (uint32_t i = 0; ; i++) {
                 if (mixerNames[i] == NULL) {
-                    cliPrintLine("Invalid name");
+                    cliPrintErrorLinef("Invalid name");
                     break;
                 }
                 if (strncasecmp(ptr, mixerNames[i], len) == 0) {
@@ -1246,7 +1307,13 @@ static void cliLed(char *cmdline)
         i = atoi(ptr);
         if (i < LED_MAX_STRIP_LENGTH) {
             ptr = nextArg(cmdline);
-            if (!parseLedStripConfig(i, ptr)) {
+#ifdef USE_CLI_BATCH
+            // the strip layout is worked out once when the batch ends
+            const bool parsed = cliBatchMode ? parseLedStripConfigNoUpdate(i, ptr) : parseLedStripConfig(i, ptr);
+#else
+            const bool parsed = parseLedStripConfig(i, ptr);
+#endif
+            if (!parsed) {
                 cliShowParseError();
             }
         } else {
@@ -1558,7 +1625,7 @@ static void cliServoMix(char *cmdline)
             len = strlen(ptr);
             for (uint32_t i = 0; ; i++) {
                 if (mixerNames[i] == NULL) {
-                    cliPrintLine("Invalid name");
+                    cliPrintErrorLinef("Invalid name");
                     break;
                 }
                 if (strncasecmp(ptr, mixerNames[i], len) == 0) {
@@ -1718,6 +1785,34 @@ static void cliSdInfo(char *cmdline)
         break;
     }
     cliPrintLinefeed();
+
+#ifdef USE_SDCARD_STATS
+    const sdcardStats_t *stats = sdcardStats_get();
+    if (stats->writeCount == 0) {
+        return;
+    }
+
+    const uint32_t writeRate = sdcardStats_getWriteRate();
+    const uint32_t writeLatencyP99 = sdcardStats_getWriteLatencyPercentileUs(9900);
+    cliPrintLinef("Writes: %u blocks at %uB/s", stats->writeCount, writeRate);
+    cliPrintLinef("Write latency/us p50 %u p99 %u p99.9 %u max %u",
+        sdcardStats_getWriteLatencyPercentileUs(5000), writeLatencyP99, sdcardStats_getWriteLatencyPercentileUs(9990), stats->maxWriteLatencyUs);
+    cliPrintLinef("Busy/us p50 %u p99 %u p99.9 %u max %u",
+        sdcardStats_getBusyPercentileUs(5000), sdcardStats_getBusyPercentileUs(9900), sdcardStats_getBusyPercentileUs(9990), stats->maxBusyUs);
+
+    cliPrint("Write histogram/us:");
+    for (int i = 0; i < SDCARD_STATS_BUCKET_COUNT - 1; i++) {
+        cliPrintf(" <%u:%u", 1 << (i + SDCARD_STATS_FIRST_BUCKET_SHIFT), stats->writeLatencyHistogram[i]);
+    }
+    cliPrintLinef(" more:%u", stats->writeLatencyHistogram[SDCARD_STATS_BUCKET_COUNT - 1]);
+
+    // Frames are dropped if the cache fills up at the logging rate before a slow write completes
+    const uint32_t cacheSize = afatfs_getCacheSize();
+    if (writeRate > 0 && (uint64_t)writeLatencyP99 * writeRate > (uint64_t)cacheSize * 1000000) {
+        cliPrintLinef("WARNING: p99 write latency is longer than the %ums the %uB cache lasts at this rate, use a faster card or a lower blackbox rate",
+            (uint32_t)((uint64_t)cacheSize * 1000 / writeRate), cacheSize);
+    }
+#endif
 }
 
 #endif
@@ -1990,7 +2085,7 @@ static void cliFeature(char *cmdline)
 
         for (uint32_t i = 0; ; i++) {
             if (featureNames[i] == NULL) {
-                cliPrintLine("Invalid name");
+                cliPrintErrorLinef("Invalid name");
                 break;
             }
 
@@ -2071,7 +2166,7 @@ static void cliBeeper(char *cmdline)
 
         for (uint32_t i = 0; ; i++) {
             if (i == beeperCount) {
-                cliPrintLine("Invalid name");
+                cliPrintErrorLinef("Invalid name");
                 break;
             }
             if (strncasecmp(cmdline, beeperNameForTableIndex(i), len) == 0) {
@@ -2222,6 +2317,7 @@ static void cliGpsPassthrough(char *cmdline)
 {
     UNUSED(cmdline);
 
+    bufWriterFlush(cliWriter);
     gpsEnablePassthrough(cliPort);
 }
 #endif
@@ -2229,11 +2325,11 @@ static void cliGpsPassthrough(char *cmdline)
 static int parseOutputIndex(char *pch, bool allowAllEscs) {
     int outputIndex = atoi(pch);
     if ((outputIndex >= 0) && (outputIndex < getMotorCount())) {
-        tfp_printf("Using output %d.\r\n", outputIndex);
+        cliPrintLinef("Using output %d.", outputIndex);
     } else if (allowAllEscs && outputIndex == ALL_MOTORS) {
-        tfp_printf("Using all outputs.\r\n");
+        cliPrintLine("Using all outputs.");
     } else {
-        tfp_printf("Invalid output number, range: 0 to %d.\r\n", getMotorCount() - 1);
+        cliPrintLinef("Invalid output number, range: 0 to %d.", getMotorCount() - 1);
 
         return -1;
     }
@@ -2266,7 +2362,7 @@ void printEscInfo(const uint8_t *escInfoBytes, uint8_t bytesRead)
             || ((escInfoVersion == 2) && (bytesRead == ESC_INFO_V2_EXPECTED_FRAME_SIZE))) {
             escInfoReceived = true;
 
-            if (calculateCrc8(escInfoBytes, frameLength - 1) == escInfoBytes[frameLength - 1]) {
+            if (crc8_ccitt_update(0, escInfoBytes, frameLength - 1) == escInfoBytes[frameLength - 1]) {
                 uint8_t firmwareVersion;
                 char firmwareSubVersion;
                 uint8_t escType;
@@ -2485,7 +2581,7 @@ static void cliMixer(char *cmdline)
 
     for (uint32_t i = 0; ; i++) {
         if (mixerNames[i] == NULL) {
-            cliPrintLine("Invalid name");
+            cliPrintErrorLinef("Invalid name");
             return;
         }
         if (strncasecmp(cmdline, mixerNames[i], len) == 0) {
@@ -2642,10 +2738,64 @@ static void cliDumpRateProfile(uint8_t rateProfileIndex, uint8_t dumpMask)
     dumpAllValues(PROFILE_RATE_VALUE, dumpMask);
 }
 
+#ifdef USE_CLI_BATCH
+// Applies what the lines of the batch left undone and checks the settings that depend on each other,
+// true when the batch can be saved
+static bool cliBatchEnd(void)
+{
+#ifdef LED_STRIP
+    reevaluateLedConfig();
+#endif
+
+    if (!isSerialConfigValid(serialConfig())) {
+        cliPrintErrorLinef("###ERROR: serial port configuration is not valid###");
+    }
+
+#ifdef BLACKBOX
+    const uint8_t blackboxDevice = blackboxConfig()->device;
+    blackboxValidateConfig();
+    if (blackboxConfig()->device != blackboxDevice) {
+        cliPrintLine("blackbox_device not supported, changed to SERIAL");
+    }
+#endif
+
+    cliBatchMode = false;
+    if (cliBatchErrorCount) {
+        cliPrintLinef("###ERROR: %d errors in the batch###", cliBatchErrorCount);
+        return false;
+    }
+    return true;
+}
+
+static void cliBatch(char *cmdline)
+{
+    if (strncasecmp(cmdline, "start", 5) == 0) {
+        cliBatchMode = true;
+        cliBatchErrorCount = 0;
+        cliPrintLine("Command batch started");
+    } else if (strncasecmp(cmdline, "end", 3) == 0) {
+        if (!cliBatchMode) {
+            cliPrintLine("No batch started");
+        } else if (cliBatchEnd()) {
+            cliPrintLine("Command batch ended");
+        }
+    } else {
+        cliShowParseError();
+    }
+}
+#endif
+
 static void cliSave(char *cmdline)
 {
     UNUSED(cmdline);
 
+#ifdef USE_CLI_BATCH
+    if (cliBatchMode && !cliBatchEnd()) {
+        cliPrintLine("Not saving, fix the errors and save again");
+        return;
+    }
+#endif
+
     cliPrintHashLine("saving");
     writeEEPROM();
     cliReboot();
@@ -2656,6 +2806,13 @@ static void cliDefaults(char *cmdline)
     UNUSED(cmdline);
 
     cliPrintHashLine("resetting to defaults");
+#ifdef USE_CLI_BATCH
+    if (cliBatchMode) {
+        // the rest of the batch goes on top of the defaults and is written with them by save
+        resetConfigs();
+        return;
+    }
+#endif
     resetEEPROM();
     cliReboot();
 }
@@ -2683,7 +2840,7 @@ STATIC_UNIT_TESTED void cliGet(char *cmdline)
         return;
     }
 
-    cliPrintLine("Invalid name");
+    cliPrintErrorLinef("Invalid name");
 }
 
 static char *skipSpace(char *buffer)
@@ -2727,113 +2884,108 @@ STATIC_UNIT_TESTED void cliSet(char *cmdline)
         eqptr++;
         eqptr = skipSpace(eqptr);
 
-        for (uint32_t i = 0; i < valueTableEntryCount; i++) {
-            const clivalue_t *val = &valueTable[i];
+        const clivalue_t *val = settingFind(cmdline, variableNameLength);
+        if (val) {
+            bool valueChanged = false;
+            int16_t value  = 0;
+            switch (val->type & VALUE_MODE_MASK) {
+                case MODE_DIRECT: {
+                    int16_t value = atoi(eqptr);
+
+                    if (value >= val->config.minmax.min && value <= val->config.minmax.max) {
+                        cliSetVar(val, value);
+                        valueChanged = true;
+                    }
+                }
 
-            // ensure exact match when setting to prevent setting variables with shorter names
-            if (strncasecmp(cmdline, val->name, strlen(val->name)) == 0 && variableNameLength == strlen(val->name)) {
+                break;
+                case MODE_LOOKUP: {
+                    const lookupTableEntry_t *tableEntry = &lookupTables[val->config.lookup.tableIndex];
+                    bool matched = false;
+                    for (uint32_t tableValueIndex = 0; tableValueIndex < tableEntry->valueCount && !matched; tableValueIndex++) {
+                        matched = strcasecmp(tableEntry->values[tableValueIndex], eqptr) == 0;
 
-                bool valueChanged = false;
-                int16_t value  = 0;
-                switch (val->type & VALUE_MODE_MASK) {
-                    case MODE_DIRECT: {
-                        int16_t value = atoi(eqptr);
+                        if (matched) {
+                            value = tableValueIndex;
 
-                        if (value >= val->config.minmax.min && value <= val->config.minmax.max) {
                             cliSetVar(val, value);
                             valueChanged = true;
                         }
                     }
+                }
 
-                    break;
-                    case MODE_LOOKUP: {
-                        const lookupTableEntry_t *tableEntry = &lookupTables[val->config.lookup.tableIndex];
-                        bool matched = false;
-                        for (uint32_t tableValueIndex = 0; tableValueIndex < tableEntry->valueCount && !matched; tableValueIndex++) {
-                            matched = strcasecmp(tableEntry->values[tableValueIndex], eqptr) == 0;
-
-                            if (matched) {
-                                value = tableValueIndex;
+                break;
+                case MODE_ARRAY: {
+                    const uint8_t arrayLength = val->config.array.length;
+                    char *valPtr = eqptr;
+
+                    for (int i = 0; i < arrayLength; i++) {
+                        // skip spaces
+                        valPtr = skipSpace(valPtr);
+                        // find next comma (or end of string)
+                        char *valEndPtr = strchr(valPtr, ',');
+
+                        // comma found or last item?
+                        if ((valEndPtr != NULL) || (i == arrayLength - 1)){
+                            // process substring [valPtr, valEndPtr[
+                            // note: no need to copy substrings for atoi()
+                            //       it stops at the first character that cannot be converted...
+                            switch (val->type & VALUE_TYPE_MASK) {
+                            default:
+                            case VAR_UINT8: {
+                                // fetch data pointer
+                                uint8_t *data = (uint8_t *)getValuePointer(val) + i;
+                                // store value
+                                *data = (uint8_t)atoi((const char*) valPtr);
+                                }
+                                break;
 
-                                cliSetVar(val, value);
-                                valueChanged = true;
-                            }
-                        }
-                    }
+                            case VAR_INT8: {
+                                // fetch data pointer
+                                int8_t *data = (int8_t *)getValuePointer(val) + i;
+                                // store value
+                                *data = (int8_t)atoi((const char*) valPtr);
+                                }
+                                break;
 
-                    break;
-                    case MODE_ARRAY: {
-                        const uint8_t arrayLength = val->config.array.length;
-                        char *valPtr = eqptr;
-
-                        for (int i = 0; i < arrayLength; i++) {
-                            // skip spaces
-                            valPtr = skipSpace(valPtr);
-                            // find next comma (or end of string)
-                            char *valEndPtr = strchr(valPtr, ',');
-
-                            // comma found or last item?
-                            if ((valEndPtr != NULL) || (i == arrayLength - 1)){
-                                // process substring [valPtr, valEndPtr[
-                                // note: no need to copy substrings for atoi()
-                                //       it stops at the first character that cannot be converted...
-                                switch (val->type & VALUE_TYPE_MASK) {
-                                default:
-                                case VAR_UINT8: {
-                                    // fetch data pointer
-                                    uint8_t *data = (uint8_t *)getValuePointer(val) + i;
-                                    // store value
-                                    *data = (uint8_t)atoi((const char*) valPtr);
-                                    }
-                                    break;
-
-                                case VAR_INT8: {
-                                    // fetch data pointer
-                                    int8_t *data = (int8_t *)getValuePointer(val) + i;
-                                    // store value
-                                    *data = (int8_t)atoi((const char*) valPtr);
-                                    }
-                                    break;
-
-                                case VAR_UINT16: {
-                                    // fetch data pointer
-                                    uint16_t *data = (uint16_t *)getValuePointer(val) + i;
-                                    // store value
-                                    *data = (uint16_t)atoi((const char*) valPtr);
-                                    }
-                                    break;
-
-                                case VAR_INT16: {
-                                    // fetch data pointer
-                                    int16_t *data = (int16_t *)getValuePointer(val) + i;
-                                    // store value
-                                    *data = (int16_t)atoi((const char*) valPtr);
-                                    }
-                                    break;
+                            case VAR_UINT16: {
+                                // fetch data pointer
+                                uint16_t *data = (uint16_t *)getValuePointer(val) + i;
+                                // store value
+                                *data = (uint16_t)atoi((const char*) valPtr);
                                 }
-                                // mark as changed
-                                valueChanged = true;
+                                break;
 
-                                // prepare to parse next item
-                                valPtr = valEndPtr + 1;
+                            case VAR_INT16: {
+                                // fetch data pointer
+                                int16_t *data = (int16_t *)getValuePointer(val) + i;
+                                // store value
+                                *data = (int16_t)atoi((const char*) valPtr);
+                                }
+                                break;
                             }
+                            // mark as changed
+                            valueChanged = true;
+
+                            // prepare to parse next item
+                            valPtr = valEndPtr + 1;
                         }
                     }
-                    break;
-                }
-
-                if (valueChanged) {
-                    cliPrintf("%s set to ", val->name);
-                    cliPrintVar(val, 0);
-                } else {
-                    cliPrintLine("Invalid value");
-                    cliPrintVarRange(val);
                 }
+                break;
+            }
 
-                return;
+            if (valueChanged) {
+                cliPrintf("%s set to ", val->name);
+                cliPrintVar(val, 0);
+            } else {
+                cliPrintErrorLinef("Invalid value");
+                cliPrintVarRange(val);
             }
+
+            return;
         }
-        cliPrintLine("Invalid name");
+        cliPrintErrorLinef("Invalid name");
     } else {
         // no equals, check for matching variables.
         cliGet(cmdline);
@@ -2882,6 +3034,9 @@ static void cliStatus(char *cmdline)
     cliPrintf("Stack used: %d, ", stackUsedSize());
 #endif
     cliPrintLinef("Stack size: %d, Stack address: 0x%x", stackTotalSize(), stackHighMem());
+#ifdef STACK_CHECK
+    cliPrintLinef("RAM data: %d, bss: %d", ramDataSize(), ramBssSize());
+#endif
 
     cliPrintLinef("I2C Errors: %d, config size: %d, max available config: %d", i2cErrorCounter, getEEPROMConfigSize(), &__config_end - &__config_start);
 
@@ -2904,10 +3059,160 @@ static void cliStatus(char *cmdline)
 #endif
 }
 
+#ifdef USE_LOOP_BENCHMARK
+static void cliBenchmark(char *cmdline)
+{
+    UNUSED(cmdline);
+
+    cliPrintLine("Benchmarking, please wait ...");
+    bufWriterFlush(cliWriter);
+
+    loopBenchmarkResult_t results[LOOP_BENCHMARK_MAX_RESULTS];
+    const int count = loopBenchmarkRun(results);
+
+    cliPrintf("looptime rate denom  gyro/cyc   pid/cyc   mix/cyc");
+    for (int i = 0; i < LOOP_BENCHMARK_DENOM_COUNT; i++) {
+        cliPrintf("  load/%d", loopBenchmarkDenoms[i]);
+    }
+    cliPrintLinefeed();
+    for (int i = 0; i < count; i++) {
+        const loopBenchmarkResult_t *result = &results[i];
+        cliPrintf("%8d %4s %5d %9d %9d %9d", result->gyroLooptimeUs, result->gyroUse32kHz ? "32k" : "8k",
+            result->gyroSyncDenom, result->gyroCycles, result->pidCycles, result->mixerCycles);
+        for (int j = 0; j < LOOP_BENCHMARK_DENOM_COUNT; j++) {
+            cliPrintf(" %6d%%", result->loadPercent[j]);
+        }
+        cliPrintLinefeed();
+    }
+}
+#endif
+
+#ifdef USE_DSHOT_BENCHMARK
+static void cliDshotBenchmark(char *cmdline)
+{
+    const bool apply = strcasecmp(cmdline, "apply") == 0;
+    if (!isEmpty(cmdline) && !apply) {
+        cliShowParseError();
+        return;
+    }
+    if (!isMotorProtocolDshot()) {
+        cliPrintLine("The motor protocol must be DSHOT");
+        return;
+    }
+
+    cliPrintLine("Benchmarking, props off, please wait ...");
+    bufWriterFlush(cliWriter);
+
+    const uint8_t motorCount = getMotorCount();
+    dshotBenchmarkResult_t results[DSHOT_BENCHMARK_MAX_RESULTS];
+    const int count = dshotBenchmarkRun(results, motorCount);
+
+    cliPrintf("protocol   need/us  fits");
+    for (int i = 0; i < motorCount; i++) {
+        cliPrintf("  err%d", i + 1);
+    }
+    cliPrintLinefeed();
+    for (int i = 0; i < count; i++) {
+        const dshotBenchmarkResult_t *result = &results[i];
+        cliPrintf("DSHOT%-5d %7d %5s", result->kbitRate, result->requiredLooptimeUs, result->fitsLooptime ? "yes" : "no");
+        for (int j = 0; j < motorCount; j++) {
+            cliPrintf(" %4d%c", result->errorPermille[j] / 10, '%');
+        }
+        cliPrintLinefeed();
+    }
+
+    const motorPwmProtocolTypes_e recommended = dshotBenchmarkRecommend(results, count, motorCount);
+    if (recommended == PWM_TYPE_MAX) {
+        cliPrintLine("No rate was run reliably by all motors");
+        return;
+    }
+    for (int i = 0; i < count; i++) {
+        if (results[i].protocol == recommended) {
+            cliPrintLinef("Recommended: DSHOT%d", results[i].kbitRate);
+        }
+    }
+    if (apply) {
+        motorConfigMutable()->dev.motorPwmProtocol = recommended;
+        cliPrintLine("Applied, save to use it");
+    }
+}
+#endif
+
+#ifdef USE_KERNEL_BENCHMARK
+static void cliKernelBenchmark(char *cmdline)
+{
+    UNUSED(cmdline);
+
+    cliPrintLine("Benchmarking, please wait ...");
+    bufWriterFlush(cliWriter);
+
+    kernelBenchmarkResult_t results[KERNEL_BENCHMARK_MAX_RESULTS];
+    const int count = kernelBenchmarkRun(results);
+
+    cliPrintLinef("  min/cyc   avg/cyc   max/cyc kernel");
+    for (int i = 0; i < count; i++) {
+        const kernelBenchmarkResult_t *result = &results[i];
+        cliPrintLinef("%9d %9d %9d %s", result->minCycles, result->avgCycles, result->maxCycles, result->name);
+    }
+}
+#endif
+
 #ifndef SKIP_TASK_STATISTICS
+#ifdef USE_TASK_STATISTICS_HISTOGRAM
+static void cliTasksHistogram(void)
+{
+    cliPrintLine("Task histogram        exec/us p50   p99 p99.9  late/us p50   p99 p99.9   missed");
+    for (cfTaskId_e taskId = 0; taskId < TASK_COUNT; taskId++) {
+        cfTaskInfo_t taskInfo;
+        getTaskInfo(taskId, &taskInfo);
+        cfTaskHistogram_t histogram;
+        if (taskInfo.isEnabled && getTaskHistogram(taskId, &histogram)) {
+            cliPrintLinef("%02d - (%15s) %9d %5d %5d %11d %5d %5d %8d",
+                taskId, taskInfo.taskName,
+                taskHistogramPercentile(histogram.executionTime, 5000),
+                taskHistogramPercentile(histogram.executionTime, 9900),
+                taskHistogramPercentile(histogram.executionTime, 9990),
+                taskHistogramPercentile(histogram.lateness, 5000),
+                taskHistogramPercentile(histogram.lateness, 9900),
+                taskHistogramPercentile(histogram.lateness, 9990),
+                histogram.missedPeriods);
+        }
+    }
+}
+#endif
+
+#ifdef USE_TASK_STACK_STATISTICS
+static void cliTasksStack(void)
+{
+    cliPrintLinef("Task stack, size %d   peak/bytes", stackTotalSize());
+    for (cfTaskId_e taskId = 0; taskId < TASK_COUNT; taskId++) {
+        cfTaskInfo_t taskInfo;
+        getTaskInfo(taskId, &taskInfo);
+        if (taskInfo.isEnabled) {
+            cliPrintLinef("%02d - (%15s) %10d", taskId, taskInfo.taskName, taskInfo.maxStackUsage);
+        }
+    }
+    cliPrintLinef("Peak stack used: %d", stackUsedSize());
+}
+#endif
+
 static void cliTasks(char *cmdline)
 {
+#ifdef USE_TASK_STATISTICS_HISTOGRAM
+    if (strncasecmp(cmdline, "hist", 4) == 0) {
+        cliTasksHistogram();
+        return;
+    }
+#endif
+#ifdef USE_TASK_STACK_STATISTICS
+    if (strncasecmp(cmdline, "stack", 5) == 0) {
+        cliTasksStack();
+        return;
+    }
+#endif
+#if !defined(USE_TASK_STATISTICS_HISTOGRAM) && !defined(USE_TASK_STACK_STATISTICS)
     UNUSED(cmdline);
+#endif
     int maxLoadSum = 0;
     int averageLoadSum = 0;
 
@@ -2959,6 +3264,7 @@ static void cliTasks(char *cmdline)
         cfCheckFuncInfo_t checkFuncInfo;
         getCheckFuncInfo(&checkFuncInfo);
         cliPrintLinef("RX Check Function %19d %7d %25d", checkFuncInfo.maxExecutionTime, checkFuncInfo.averageExecutionTime, checkFuncInfo.totalExecutionTime / 1000);
+        cliPrintLinef("Scheduler Overhead %18d %7d", checkFuncInfo.maxSchedulingTime, checkFuncInfo.averageSchedulingTime);
         cliPrintLinef("Total (excluding SERIAL) %25d.%1d%% %4d.%1d%%", maxLoadSum/10, maxLoadSum%10, averageLoadSum/10, averageLoadSum%10);
     }
 }
@@ -3013,6 +3319,9 @@ const cliResourceValue_t resourceTable[] = {
 #ifdef USE_INVERTER
     { OWNER_INVERTER,      PG_SERIAL_PIN_CONFIG, offsetof(serialPinConfig_t, ioTagInverter[0]), SERIAL_PORT_MAX_INDEX },
 #endif
+#ifdef USE_UART_CTS
+    { OWNER_SERIAL_CTS,    PG_SERIAL_PIN_CONFIG, offsetof(serialPinConfig_t, ioTagCts[0]), SERIAL_PORT_MAX_INDEX },
+#endif
 #ifdef USE_I2C
     { OWNER_I2C_SCL,       PG_I2C_CONFIG, offsetof(i2cConfig_t, ioTagScl[0]), I2CDEV_COUNT },
     { OWNER_I2C_SDA,       PG_I2C_CONFIG, offsetof(i2cConfig_t, ioTagSda[0]), I2CDEV_COUNT },
@@ -3177,10 +3486,15 @@ static void cliResource(char *cmdline)
             cliPrintf(DMA_OUTPUT_STRING, i / DMA_MOD_VALUE + 1, (i % DMA_MOD_VALUE) + DMA_MOD_OFFSET);
             uint8_t resourceIndex = dmaGetResourceIndex(i);
             if (resourceIndex > 0) {
-                cliPrintLinef(" %s %d", owner, resourceIndex);
+                cliPrintf(" %s %d", owner, resourceIndex);
             } else {
-                cliPrintLinef(" %s", owner);
+                cliPrintf(" %s", owner);
             }
+            const resourceOwner_e conflictOwner = dmaGetConflictOwner(i);
+            if (conflictOwner != OWNER_FREE) {
+                cliPrintf(" (CONFLICT: %s)", ownerNames[conflictOwner]);
+            }
+            cliPrintLinefeed();
         }
 
 #ifndef MINIMAL_CLI
@@ -3318,6 +3632,13 @@ static void printConfig(char *cmdline, bool doDiff)
         cliPrintHashLine("version");
         cliVersion(NULL);
 
+#ifdef USE_CLI_BATCH
+        if (dumpMask & DUMP_ALL) {
+            cliPrintHashLine("start the command batch");
+            cliPrintLine("batch start");
+        }
+#endif
+
         if ((dumpMask & (DUMP_ALL | DO_DIFF)) == (DUMP_ALL | DO_DIFF)) {
             cliPrintHashLine("reset configuration to default settings");
             cliPrint("defaults");
@@ -3477,17 +3798,29 @@ static void cliHelp(char *cmdline);
 const clicmd_t cmdTable[] = {
     CLI_COMMAND_DEF("adjrange", "configure adjustment ranges", NULL, cliAdjustmentRange),
     CLI_COMMAND_DEF("aux", "configure modes", NULL, cliAux),
+#ifdef USE_CLI_BATCH
+    CLI_COMMAND_DEF("batch", "start or end a batch of commands", "start | end", cliBatch),
+#endif
 #ifdef BEEPER
     CLI_COMMAND_DEF("beeper", "turn on/off beeper", "list\r\n"
         "\t<+|->[name]", cliBeeper),
 #endif
+#ifdef USE_KERNEL_BENCHMARK
+    CLI_COMMAND_DEF("bench", "measure cycles per call of the hot path kernels", NULL, cliKernelBenchmark),
+#endif
+#ifdef USE_LOOP_BENCHMARK
+    CLI_COMMAND_DEF("benchmark", "measure gyro/PID loop CPU load at each loop rate", NULL, cliBenchmark),
+#endif
 #ifdef LED_STRIP
     CLI_COMMAND_DEF("color", "configure colors", NULL, cliColor),
 #endif
-    CLI_COMMAND_DEF("defaults", "reset to defaults and reboot", NULL, cliDefaults),
+    CLI_COMMAND_DEF("defaults", "reset to defaults and reboot, only reset when in a batch", NULL, cliDefaults),
     CLI_COMMAND_DEF("bl", "reboot into bootloader", NULL, cliBootloader),
     CLI_COMMAND_DEF("diff", "list configuration changes from default",
         "[master|profile|rates|all] {showdefaults}", cliDiff),
+#ifdef USE_DSHOT_BENCHMARK
+    CLI_COMMAND_DEF("dshot_benchmark", "find the fastest DShot rate the ESCs run reliably, props off", "[apply]", cliDshotBenchmark),
+#endif
 #ifdef USE_DSHOT
     CLI_COMMAND_DEF("dshotprog", "program DShot ESC(s)", "<index> <command>+", cliDshotProg),
 #endif
@@ -3556,7 +3889,15 @@ const clicmd_t cmdTable[] = {
 #endif
     CLI_COMMAND_DEF("status", "show status", NULL, cliStatus),
 #ifndef SKIP_TASK_STATISTICS
+#if defined(USE_TASK_STATISTICS_HISTOGRAM) && defined(USE_TASK_STACK_STATISTICS)
+    CLI_COMMAND_DEF("tasks", "show task stats", "[hist|stack]", cliTasks),
+#elif defined(USE_TASK_STATISTICS_HISTOGRAM)
+    CLI_COMMAND_DEF("tasks", "show task stats", "[hist]", cliTasks),
+#elif defined(USE_TASK_STACK_STATISTICS)
+    CLI_COMMAND_DEF("tasks", "show task stats", "[stack]", cliTasks),
+#else
     CLI_COMMAND_DEF("tasks", "show task stats", NULL, cliTasks),
+#endif
 #endif
     CLI_COMMAND_DEF("version", "show version", NULL, cliVersion),
 #ifdef VTX_CONTROL
@@ -3664,8 +4005,10 @@ void cliProcess(void)
                 }
                 if (cmd < cmdTable + ARRAYLEN(cmdTable))
                     cmd->func(options);
-                else
+                else {
+                    cliCountError();
                     cliPrint("Unknown command, try 'help'");
+                }
                 bufferIndex = 0;
             }
 
@@ -3689,6 +4032,8 @@ void cliProcess(void)
             cliWrite(c);
         }
     }
+
+    bufWriterFlush(cliWriter);
 }
 
 void cliEnter(serialPort_t *serialPort)
@@ -87,6 +87,8 @@
 #include "rx/rx.h"
 #include "rx/rx_spi.h"
 
+#include "scheduler/scheduler.h"
+
 #include "sensors/acceleration.h"
 #include "sensors/barometer.h"
 #include "sensors/battery.h"
@@ -117,14 +119,14 @@ PG_RESET_TEMPLATE(featureConfig_t, featureConfig,
     .enabledFeatures = DEFAULT_FEATURES | DEFAULT_RX_FEATURE
 );
 
-PG_REGISTER_WITH_RESET_TEMPLATE(systemConfig_t, systemConfig, PG_SYSTEM_CONFIG, 0);
+PG_REGISTER_WITH_RESET_TEMPLATE(systemConfig_t, systemConfig, PG_SYSTEM_CONFIG, 1);
 
 #ifndef USE_OSD_SLAVE
 #if defined(STM32F4) && !defined(DISABLE_OVERCLOCK)
 PG_RESET_TEMPLATE(systemConfig_t, systemConfig,
     .pidProfileIndex = 0,
     .activeRateProfile = 0,
-    .debug_mode = DEBUG_MODE,
+    .debug_modes = { DEBUG_MODE },
     .task_statistics = true,
     .cpu_overclock = false,
     .name = { 0 } // FIXME misplaced, see PG_PILOT_CONFIG in CF v1.x
@@ -133,7 +135,7 @@ PG_RESET_TEMPLATE(systemConfig_t, systemConfig,
 PG_RESET_TEMPLATE(systemConfig_t, systemConfig,
     .pidProfileIndex = 0,
     .activeRateProfile = 0,
-    .debug_mode = DEBUG_MODE,
+    .debug_modes = { DEBUG_MODE },
     .task_statistics = true,
     .name = { 0 } // FIXME misplaced, see PG_PILOT_CONFIG in CF v1.x
 );
@@ -142,7 +144,7 @@ PG_RESET_TEMPLATE(systemConfig_t, systemConfig,
 
 #ifdef USE_OSD_SLAVE
 PG_RESET_TEMPLATE(systemConfig_t, systemConfig,
-    .debug_mode = DEBUG_MODE,
+    .debug_modes = { DEBUG_MODE },
     .task_statistics = true
 );
 #endif
@@ -276,7 +278,7 @@ static void setPidProfile(uint8_t pidProfileIndex)
     if (pidProfileIndex < MAX_PROFILE_COUNT) {
         systemConfigMutable()->pidProfileIndex = pidProfileIndex;
         currentPidProfile = pidProfilesMutable(pidProfileIndex);
-        pidInit(currentPidProfile); // re-initialise pid controller to re-initialise filters and config
+        pidInitIfChanged(currentPidProfile); // re-initialise pid controller to re-initialise filters and config
     }
 }
 
@@ -460,7 +462,29 @@ void validateAndFixGyroConfig(void)
 #endif
     }
 
-#if !defined(GYRO_USES_SPI) || !defined(USE_MPU_DATA_READY_SIGNAL)
+#ifdef USE_GYRO_FIFO
+    if (gyroConfig()->gyro_use_fifo) {
+        // the FIFO replaces the data ready interrupt, and has to be read before it holds more than a burst, allowing for scheduler jitter
+        gyroConfigMutable()->gyro_isr_update = false;
+        gyroConfigMutable()->gyro_sync_denom = MIN(gyroConfig()->gyro_sync_denom, GYRO_FIFO_SAMPLES_MAX / 2);
+    }
+#else
+    gyroConfigMutable()->gyro_use_fifo = false;
+#endif
+
+#ifndef USE_GYRO_BIAS_TRACKING
+    gyroConfigMutable()->gyro_bias_tracking = false;
+#endif
+
+#ifndef USE_DSHOT_TELEMETRY
+    motorConfigMutable()->dev.useDshotTelemetry = false;
+#endif
+
+#ifndef USE_DSHOT_DMAR
+    motorConfigMutable()->dev.useBurstDshot = false;
+#endif
+
+#ifndef USE_GYRO_ISR_UPDATE
     gyroConfigMutable()->gyro_isr_update = false;
 #endif
 
@@ -504,16 +528,8 @@ void validateAndFixGyroConfig(void)
 }
 #endif
 
-void readEEPROM(void)
+static void validateAndActivateConfig(void)
 {
-#ifndef USE_OSD_SLAVE
-    suspendRxSignal();
-#endif
-
-    // Sanity check, read flash
-    if (!loadEEPROM()) {
-        failureMode(FAILURE_INVALID_EEPROM_CONTENTS);
-    }
 #ifndef USE_OSD_SLAVE
     if (systemConfig()->activeRateProfile >= CONTROL_RATE_PROFILE_COUNT) {// sanity check
         systemConfigMutable()->activeRateProfile = 0;
@@ -528,6 +544,104 @@ void readEEPROM(void)
 
     validateAndFixConfig();
     activateConfig();
+}
+
+#ifdef USE_ASYNC_CONFIG_SAVE
+#define CONFIG_SAVE_BYTES_PER_CALL 64   // a few records, short enough not to delay the other tasks much
+
+static bool configSaveRequested;        // another save was asked for while the config was being written
+static bool configSaveNotify;
+
+void configSaveUpdate(timeUs_t currentTimeUs)
+{
+    UNUSED(currentTimeUs);
+
+    const configWriteStatus_e status = continueConfigWriteToEEPROM(CONFIG_SAVE_BYTES_PER_CALL);
+    if (status == CONFIG_WRITE_IN_PROGRESS) {
+        return;
+    }
+
+    if (status == CONFIG_WRITE_FAILED) {
+        // Retry in the foreground, this stops with a failure if the flash can't be written
+        writeConfigToEEPROM();
+    } else if (status == CONFIG_WRITE_INCOMPLETE || configSaveRequested) {
+        configSaveRequested = false;
+        if (beginConfigWriteToEEPROM()) {
+            return;
+        }
+    }
+
+    setTaskEnabled(TASK_CONFIG_SAVE, false);
+#ifndef USE_OSD_SLAVE
+    unsetArmingDisabled(ARMING_DISABLED_CONFIG_SAVE);
+#endif
+    if (configSaveNotify) {
+        beeperConfirmationBeeps(1);
+        configSaveNotify = false;
+    }
+}
+
+// Complete a save running in the background before the saved config is read or written in the foreground
+static void finishConfigSave(void)
+{
+    while (isConfigWriteInProgress()) {
+        configSaveUpdate(0);
+    }
+}
+
+/*
+ * Save the config from a low priority task, a few records at a time, so the other tasks keep running. The config is
+ * activated straight away as it would be after reading it back. Arming is disabled until the save completes.
+ */
+static void startConfigSave(bool notify)
+{
+    validateAndActivateConfig();
+
+    configSaveNotify |= notify;
+
+    if (isConfigWriteInProgress()) {
+        configSaveRequested = true;
+        return;
+    }
+
+#ifndef USE_OSD_SLAVE
+    // Starting a complete copy erases the flash
+    suspendRxSignal();
+#endif
+    const bool started = beginConfigWriteToEEPROM();
+#ifndef USE_OSD_SLAVE
+    resumeRxSignal();
+#endif
+
+    if (!started) {
+        // Already saved
+        configSaveUpdate(0);
+        return;
+    }
+
+#ifndef USE_OSD_SLAVE
+    setArmingDisabled(ARMING_DISABLED_CONFIG_SAVE);
+#endif
+    setTaskEnabled(TASK_CONFIG_SAVE, true);
+}
+#endif
+
+void readEEPROM(void)
+{
+#ifdef USE_ASYNC_CONFIG_SAVE
+    finishConfigSave();
+#endif
+
+#ifndef USE_OSD_SLAVE
+    suspendRxSignal();
+#endif
+
+    // Sanity check, read flash
+    if (!loadEEPROM()) {
+        failureMode(FAILURE_INVALID_EEPROM_CONTENTS);
+    }
+
+    validateAndActivateConfig();
 
 #ifndef USE_OSD_SLAVE
     resumeRxSignal();
@@ -536,6 +650,10 @@ void readEEPROM(void)
 
 void writeEEPROM(void)
 {
+#ifdef USE_ASYNC_CONFIG_SAVE
+    finishConfigSave();
+#endif
+
 #ifndef USE_OSD_SLAVE
     suspendRxSignal();
 #endif
@@ -547,6 +665,18 @@ void writeEEPROM(void)
 #endif
 }
 
+// Save the config without stopping the scheduler while the flash is written, falling back to writeEEPROM() and
+// readEEPROM() when the config can only be saved in the foreground
+void writeEEPROMAsync(void)
+{
+#ifdef USE_ASYNC_CONFIG_SAVE
+    startConfigSave(false);
+#else
+    writeEEPROM();
+    readEEPROM();
+#endif
+}
+
 void resetEEPROM(void)
 {
     resetConfigs();
@@ -568,6 +698,15 @@ void saveConfigAndNotify(void)
     beeperConfirmationBeeps(1);
 }
 
+void saveConfigAndNotifyAsync(void)
+{
+#ifdef USE_ASYNC_CONFIG_SAVE
+    startConfigSave(true);
+#else
+    saveConfigAndNotify();
+#endif
+}
+
 #ifndef USE_OSD_SLAVE
 void changePidProfile(uint8_t pidProfileIndex)
 {
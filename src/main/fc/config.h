@@ -20,6 +20,10 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#include "build/debug.h"
+
+#include "common/time.h"
+
 #include "config/parameter_group.h"
 
 #include "drivers/adc.h"
@@ -64,7 +68,7 @@ typedef enum {
 typedef struct systemConfig_s {
     uint8_t pidProfileIndex;
     uint8_t activeRateProfile;
-    uint8_t debug_mode;
+    uint8_t debug_modes[DEBUG_MODE_SLOT_COUNT];     // logged at the same time, each in its own bank of debug values
     uint8_t task_statistics;
 #if defined(STM32F4) && !defined(DISABLE_OVERCLOCK)
     uint8_t cpu_overclock;
@@ -75,7 +79,7 @@ typedef struct systemConfig_s {
 
 #ifdef USE_OSD_SLAVE
 typedef struct systemConfig_s {
-    uint8_t debug_mode;
+    uint8_t debug_modes[DEBUG_MODE_SLOT_COUNT];
     uint8_t task_statistics;
 } systemConfig_t;
 #endif
@@ -105,9 +109,12 @@ void initEEPROM(void);
 void resetEEPROM(void);
 void readEEPROM(void);
 void writeEEPROM();
+void writeEEPROMAsync(void);
 void ensureEEPROMContainsValidData(void);
 
 void saveConfigAndNotify(void);
+void saveConfigAndNotifyAsync(void);
+void configSaveUpdate(timeUs_t currentTimeUs);
 void validateAndFixConfig(void);
 void validateAndFixGyroConfig(void);
 void activateConfig(void);
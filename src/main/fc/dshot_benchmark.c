@@ -0,0 +1,151 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "platform.h"
+
+#ifdef USE_DSHOT_BENCHMARK
+
+#include "common/maths.h"
+#include "common/utils.h"
+
+#include "drivers/pwm_output.h"
+#include "drivers/time.h"
+
+#include "fc/dshot_benchmark.h"
+
+#include "flight/mixer.h"
+#include "flight/pid.h"
+
+/*
+ * Runs the motors at each DShot rate with bidirectional telemetry and counts, per motor, the frames the ESC did
+ * not send a valid reply to. A reply is only sent for a frame that arrived intact, so that is the frame error
+ * rate of the line and the ESC together. The motors are held stopped throughout.
+ *
+ * Most ESCs pick the protocol when the signal starts, so each rate is preceded by a gap in the signal and then
+ * stopped frames for the ESC to lock on. An ESC that only does so at power up replies at the rate it started
+ * with and at no other.
+ */
+
+#define DSHOT_BENCHMARK_SIGNAL_GAP_MS       300     // no signal, the ESCs go back to looking for a protocol
+#define DSHOT_BENCHMARK_SETTLE_FRAMES       2000    // stopped frames to lock on and arm
+#define DSHOT_BENCHMARK_FRAMES              1000
+#define DSHOT_BENCHMARK_FRAME_INTERVAL_US   500     // room for the frame and the reply at the slowest rate
+
+// ESCs wait about this long after a frame before replying
+#define DSHOT_TELEMETRY_TURNAROUND_US       30
+// a frame is 16 bits, the reply 21 bits at 5/4 of the rate
+#define DSHOT_TELEMETRY_FRAME_BITS          (16 + 21 * 4 / 5)
+
+static const struct {
+    motorPwmProtocolTypes_e protocol;
+    uint16_t kbitRate;
+} dshotBenchmarkRates[DSHOT_BENCHMARK_MAX_RESULTS] = {
+    { PWM_TYPE_DSHOT150, 150 },
+    { PWM_TYPE_DSHOT300, 300 },
+    { PWM_TYPE_DSHOT600, 600 },
+    { PWM_TYPE_DSHOT1200, 1200 },
+};
+
+static void dshotBenchmarkInitMotors(const motorDevConfig_t *config, uint8_t motorCount)
+{
+    pwmDshotResetTimers();
+    // the idle pulse is not used by DShot
+    motorDevInit(config, 0, motorCount);
+}
+
+static void dshotBenchmarkWriteStop(uint8_t motorCount)
+{
+    for (int i = 0; i < motorCount; i++) {
+        pwmWriteDshotInt(i, DSHOT_CMD_MOTOR_STOP);
+    }
+    pwmCompleteDshotMotorUpdate(motorCount);
+    delayMicroseconds(DSHOT_BENCHMARK_FRAME_INTERVAL_US);
+}
+
+static void dshotBenchmarkRate(dshotBenchmarkResult_t *result, motorPwmProtocolTypes_e protocol, uint16_t kbitRate, uint8_t motorCount)
+{
+    result->protocol = protocol;
+    result->kbitRate = kbitRate;
+    result->requiredLooptimeUs = DSHOT_TELEMETRY_FRAME_BITS * 1000 / kbitRate + DSHOT_TELEMETRY_TURNAROUND_US;
+    result->fitsLooptime = result->requiredLooptimeUs <= targetPidLooptime;
+
+    motorDevConfig_t config = motorConfig()->dev;
+    config.motorPwmProtocol = protocol;
+    config.useDshotTelemetry = true;
+
+    delay(DSHOT_BENCHMARK_SIGNAL_GAP_MS);
+    dshotBenchmarkInitMotors(&config, motorCount);
+
+    for (int frame = 0; frame < DSHOT_BENCHMARK_SETTLE_FRAMES; frame++) {
+        dshotBenchmarkWriteStop(motorCount);
+    }
+
+    uint16_t errors[MAX_SUPPORTED_MOTORS] = { 0 };
+    for (int frame = 0; frame < DSHOT_BENCHMARK_FRAMES; frame++) {
+        // writing a frame decodes the reply to the one before
+        dshotBenchmarkWriteStop(motorCount);
+        for (int i = 0; i < motorCount; i++) {
+            if (getDshotTelemetryAge(i) != 0) {
+                errors[i]++;
+            }
+        }
+    }
+
+    for (int i = 0; i < motorCount; i++) {
+        result->errorPermille[i] = errors[i] * 1000 / DSHOT_BENCHMARK_FRAMES;
+    }
+}
+
+int dshotBenchmarkRun(dshotBenchmarkResult_t *results, uint8_t motorCount)
+{
+    motorCount = MIN(motorCount, MAX_SUPPORTED_MOTORS);
+    int count = 0;
+
+    for (int i = 0; i < DSHOT_BENCHMARK_MAX_RESULTS; i++) {
+        dshotBenchmarkRate(&results[count++], dshotBenchmarkRates[i].protocol, dshotBenchmarkRates[i].kbitRate, motorCount);
+    }
+
+    // back to the configured protocol, again with a gap so the ESCs pick it up
+    delay(DSHOT_BENCHMARK_SIGNAL_GAP_MS);
+    dshotBenchmarkInitMotors(&motorConfig()->dev, motorCount);
+
+    return count;
+}
+
+motorPwmProtocolTypes_e dshotBenchmarkRecommend(const dshotBenchmarkResult_t *results, int count, uint8_t motorCount)
+{
+    motorPwmProtocolTypes_e recommended = PWM_TYPE_MAX;
+
+    for (int i = 0; i < count; i++) {
+        bool reliable = results[i].fitsLooptime;
+        for (int j = 0; j < motorCount && j < MAX_SUPPORTED_MOTORS; j++) {
+            reliable = reliable && results[i].errorPermille[j] <= DSHOT_BENCHMARK_MAX_ERROR_PERMILLE;
+        }
+        // the rates are benchmarked slowest first
+        if (reliable) {
+            recommended = results[i].protocol;
+        }
+    }
+
+    return recommended;
+}
+
+#endif
@@ -0,0 +1,36 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "drivers/pwm_output.h"
+
+#define DSHOT_BENCHMARK_MAX_RESULTS 4               // DSHOT150 to DSHOT1200
+#define DSHOT_BENCHMARK_MAX_ERROR_PERMILLE 10       // a motor missing more replies than this does not run the rate reliably
+
+typedef struct dshotBenchmarkResult_s {
+    motorPwmProtocolTypes_e protocol;
+    uint16_t kbitRate;
+    uint16_t requiredLooptimeUs;                    // frame, turnaround and reply
+    bool fitsLooptime;                              // in the configured PID loop
+    uint16_t errorPermille[MAX_SUPPORTED_MOTORS];   // replies missing or corrupt, per mille of the frames sent
+} dshotBenchmarkResult_t;
+
+// Must only be called while disarmed, with the motors on DShot. Returns the number of results filled in.
+int dshotBenchmarkRun(dshotBenchmarkResult_t *results, uint8_t motorCount);
+// PWM_TYPE_MAX if no rate was run reliably by all the motors
+motorPwmProtocolTypes_e dshotBenchmarkRecommend(const dshotBenchmarkResult_t *results, int count, uint8_t motorCount);
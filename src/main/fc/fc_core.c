@@ -22,6 +22,7 @@
 #include "platform.h"
 
 #include "build/debug.h"
+#include "build/trace.h"
 
 #include "blackbox/blackbox.h"
 
@@ -52,6 +53,7 @@
 #include "fc/controlrate_profile.h"
 #include "fc/fc_core.h"
 #include "fc/fc_rc.h"
+#include "fc/perf_record.h"
 #include "fc/rc_adjustments.h"
 #include "fc/rc_controls.h"
 #include "fc/runtime_config.h"
@@ -81,6 +83,11 @@
 #include "flight/pid.h"
 #include "flight/servos.h"
 
+#if defined(USE_GYRO_ISR_UPDATE) && !defined(SIMULATOR_BUILD)
+#include "build/atomic.h"
+#include "drivers/nvic.h"
+#endif
+
 
 // June 2013     V2.2-dev
 
@@ -109,6 +116,9 @@ int16_t magHold;
 int16_t headFreeModeHold;
 
 static bool reverseMotors = false;
+#ifdef USE_DSHOT
+static bool armPending = false;     // arming requested, waiting for the spin direction to reach the ESCs
+#endif
 static uint32_t disarmAt;     // Time of automatic disarm when "Don't spin the motors when armed" is enabled and auto_disarm_delay is nonzero
 
 bool isRXDataNew;
@@ -204,6 +214,11 @@ void disarm(void)
 #endif
         BEEP_OFF;
         beeper(BEEPER_DISARMING);      // emit disarm tone
+
+        saveRcAdjustments();
+#ifdef USE_PERF_RECORD
+        perfRecordDisarmed();
+#endif
     }
 }
 
@@ -221,22 +236,32 @@ void tryArm(void)
         }
 #ifdef USE_DSHOT
         if (isMotorProtocolDshot()) {
-            if (!IS_RC_MODE_ACTIVE(BOXDSHOTREVERSE)) {
-                reverseMotors = false;
-                for (unsigned index = 0; index < getMotorCount(); index++) {
-                    pwmWriteDshotCommand(index, DSHOT_CMD_SPIN_DIRECTION_NORMAL);
-                }
-            } else {
-                reverseMotors = true;
-                for (unsigned index = 0; index < getMotorCount(); index++) {
-                    pwmWriteDshotCommand(index, DSHOT_CMD_SPIN_DIRECTION_REVERSED);
+            // the direction is queued once and arming is left pending until the motor updates
+            // have sent it; processRx() then calls tryArm() again to finish
+            static uint8_t queuedDirection = 0;
+            const uint8_t direction = IS_RC_MODE_ACTIVE(BOXDSHOTREVERSE) ? DSHOT_CMD_SPIN_DIRECTION_REVERSED : DSHOT_CMD_SPIN_DIRECTION_NORMAL;
+            if (direction != queuedDirection) {
+                if (pwmQueueDshotCommand(DSHOT_ALL_MOTORS, direction, NULL)) {
+                    queuedDirection = direction;
                 }
+                armPending = true;
+                return;
+            }
+            if (!pwmDshotCommandQueueEmpty()) {
+                armPending = true;
+                return;
             }
+            reverseMotors = (direction == DSHOT_CMD_SPIN_DIRECTION_REVERSED);
+            queuedDirection = 0;
+            armPending = false;
         }
 #endif
 
         ENABLE_ARMING_FLAG(ARMED);
         ENABLE_ARMING_FLAG(WAS_EVER_ARMED);
+#ifdef USE_PERF_RECORD
+        perfRecordArmed();
+#endif
         headFreeModeHold = DECIDEGREES_TO_DEGREES(attitude.values.yaw);
 
         disarmAt = millis() + armingConfig()->auto_disarm_delay * 1000;   // start disarm timeout, will be extended when throttle is nonzero
@@ -254,6 +279,9 @@ void tryArm(void)
         beeper(BEEPER_ARMING);
 #endif
     } else {
+#ifdef USE_DSHOT
+        armPending = false;
+#endif
         if (!isFirstArmingGyroCalibrationRunning()) {
             int armingDisabledReason = ffs(getArmingDisableFlags());
             if (lastArmingDisabledReason != armingDisabledReason) {
@@ -410,6 +438,18 @@ void processRx(timeUs_t currentTimeUs)
 
     processRcStickPositions(throttleStatus);
 
+#ifdef USE_DSHOT
+    // stick arming calls tryArm() once per gesture, so finish an arm that was waiting on the
+    // spin direction here, unless the arm switch has been released in the meantime
+    if (armPending) {
+        if (isUsingSticksForArming() || IS_RC_MODE_ACTIVE(BOXARM)) {
+            tryArm();
+        } else {
+            armPending = false;
+        }
+    }
+#endif
+
     if (feature(FEATURE_INFLIGHT_ACC_CAL)) {
         updateInflightCalibrationState();
     }
@@ -518,22 +558,16 @@ void processRx(timeUs_t currentTimeUs)
 static void subTaskPidController(timeUs_t currentTimeUs)
 {
     uint32_t startTime = 0;
-    if (debugMode == DEBUG_PIDLOOP) {startTime = micros();}
+    if (DEBUG_MODE_IS_ACTIVE(DEBUG_PIDLOOP)) {startTime = micros();}
     // PID - note this is function pointer set by setPIDController()
+    TRACE_BEGIN(TRACE_PID);
     pidController(currentPidProfile, &accelerometerConfig()->accelerometerTrims, currentTimeUs);
+    TRACE_END(TRACE_PID);
     DEBUG_SET(DEBUG_PIDLOOP, 1, micros() - startTime);
 }
 
-static void subTaskMainSubprocesses(timeUs_t currentTimeUs)
+static void updateMainPidLoopInputs(void)
 {
-    uint32_t startTime = 0;
-    if (debugMode == DEBUG_PIDLOOP) {startTime = micros();}
-
-    // Read out gyro temperature if used for telemmetry
-    if (feature(FEATURE_TELEMETRY)) {
-        gyroReadTemperature();
-    }
-
 #ifdef MAG
     if (sensors(SENSOR_MAG)) {
         updateMagHold();
@@ -571,29 +605,36 @@ static void subTaskMainSubprocesses(timeUs_t currentTimeUs)
     }
 
     processRcCommand();
+}
 
-#ifdef GPS
-    if (sensors(SENSOR_GPS)) {
-        if ((FLIGHT_MODE(GPS_HOME_MODE) || FLIGHT_MODE(GPS_HOLD_MODE)) && STATE(GPS_FIX_HOME)) {
-            updateGpsStateForHomeAndHoldMode();
-        }
+static void subTaskMainSubprocesses(timeUs_t currentTimeUs)
+{
+    uint32_t startTime = 0;
+    if (DEBUG_MODE_IS_ACTIVE(DEBUG_PIDLOOP)) {startTime = micros();}
+
+    // Read out gyro temperature if used for telemmetry
+    if (feature(FEATURE_TELEMETRY)) {
+        gyroReadTemperature();
+    }
+
+#if defined(USE_GYRO_ISR_UPDATE) && !defined(SIMULATOR_BUILD)
+    // The PID loop may run from the gyro data ready interrupt, so hold it off while its inputs change.
+    // An interrupt arriving meanwhile is taken as soon as the block ends.
+    ATOMIC_BLOCK(NVIC_PRIO_MPU_INT_EXTI) {
+        updateMainPidLoopInputs();
     }
+#else
+    updateMainPidLoopInputs();
 #endif
 
 #ifdef USE_SDCARD
     afatfs_poll();
 #endif
 
-#ifdef BLACKBOX
-    if (!cliMode && blackboxConfig()->device) {
-        blackboxUpdate(currentTimeUs);
-    }
-#else
-    UNUSED(currentTimeUs);
-#endif
-
 #ifdef TRANSPONDER
     transponderUpdate(currentTimeUs);
+#else
+    UNUSED(currentTimeUs);
 #endif
     DEBUG_SET(DEBUG_PIDLOOP, 2, micros() - startTime);
 }
@@ -601,18 +642,21 @@ static void subTaskMainSubprocesses(timeUs_t currentTimeUs)
 static void subTaskMotorUpdate(void)
 {
     uint32_t startTime = 0;
-    if (debugMode == DEBUG_CYCLETIME) {
-        startTime = micros();
+    if (DEBUG_MODE_IS_ACTIVE(DEBUG_CYCLETIME)) {
         static uint32_t previousMotorUpdateTime;
-        const uint32_t currentDeltaTime = startTime - previousMotorUpdateTime;
-        debug[2] = currentDeltaTime;
-        debug[3] = currentDeltaTime - targetPidLooptime;
-        previousMotorUpdateTime = startTime;
-    } else if (debugMode == DEBUG_PIDLOOP) {
+        const uint32_t currentTime = micros();
+        const uint32_t currentDeltaTime = currentTime - previousMotorUpdateTime;
+        DEBUG_SET(DEBUG_CYCLETIME, 2, currentDeltaTime);
+        DEBUG_SET(DEBUG_CYCLETIME, 3, currentDeltaTime - targetPidLooptime);
+        previousMotorUpdateTime = currentTime;
+    }
+    if (DEBUG_MODE_IS_ACTIVE(DEBUG_PIDLOOP)) {
         startTime = micros();
     }
 
+    TRACE_BEGIN(TRACE_MIXER);
     mixTable(currentPidProfile->vbatPidCompensation);
+    TRACE_END(TRACE_MIXER);
 
 #ifdef USE_SERVOS
     // motor outputs are used as sources for servo mixing, so motors must be calculated using mixTable() before servos.
@@ -621,7 +665,23 @@ static void subTaskMotorUpdate(void)
     }
 #endif
 
-    writeMotors();
+    // with a motor output delay the outputs start at a fixed time after the gyro sample, so the latency
+    // does not vary with how long the loop took. It is capped to leave the loop time for the rest of the loop.
+    const timeUs_t gyroSampleTimeUs = gyroGetSampleTimeUs();
+    const timeDelta_t motorOutputDelayUs = MIN(pidConfig()->motorOutputDelayUs, targetPidLooptime * 3 / 4);
+    const timeDelta_t readyLatencyUs = cmpTimeUs(micros(), gyroSampleTimeUs);
+    if (gyroSampleTimeUs && motorOutputDelayUs > readyLatencyUs) {
+        writeMotorsAt(gyroSampleTimeUs + motorOutputDelayUs);
+    } else {
+        writeMotors();
+    }
+
+    if (DEBUG_MODE_IS_ACTIVE(DEBUG_MOTOR_LATENCY) && gyroSampleTimeUs) {
+        const timeDelta_t outputLatencyUs = cmpTimeUs(micros(), gyroSampleTimeUs);
+        DEBUG_SET(DEBUG_MOTOR_LATENCY, 0, outputLatencyUs);                     // gyro sample to motor output started
+        DEBUG_SET(DEBUG_MOTOR_LATENCY, 1, readyLatencyUs);                      // gyro sample to motor outputs loaded
+        DEBUG_SET(DEBUG_MOTOR_LATENCY, 2, outputLatencyUs - readyLatencyUs);    // held back for the motor output delay, and the output itself
+    }
 
     DEBUG_SET(DEBUG_PIDLOOP, 3, micros() - startTime);
 }
@@ -635,25 +695,16 @@ uint8_t setPidUpdateCountDown(void)
     }
 }
 
-// Function for loop trigger
-void taskMainPidLoop(timeUs_t currentTimeUs)
-{
-    static bool runTaskMainSubprocesses;
-    static uint8_t pidUpdateCountdown;
-
-#if defined(SIMULATOR_BUILD) && defined(SIMULATOR_GYROPID_SYNC)
-    if (lockMainPID() != 0) return;
+static volatile bool runTaskMainSubprocesses;
+#ifdef USE_GYRO_ISR_UPDATE
+static bool mainPidLoopInIsr;
+static volatile bool mainPidLoopRunning;
+static volatile bool mainPidLoopIsrPending;
 #endif
 
-    if (debugMode == DEBUG_CYCLETIME) {
-        debug[0] = getTaskDeltaTime(TASK_SELF);
-        debug[1] = averageSystemLoadPercent;
-    }
-
-    if (runTaskMainSubprocesses) {
-        subTaskMainSubprocesses(currentTimeUs);
-        runTaskMainSubprocesses = false;
-    }
+static void runMainPidLoop(timeUs_t currentTimeUs)
+{
+    static uint8_t pidUpdateCountdown;
 
     // DEBUG_PIDLOOP, timings for:
     // 0 - gyroUpdate()
@@ -661,9 +712,12 @@ void taskMainPidLoop(timeUs_t currentTimeUs)
     // 2 - subTaskMainSubprocesses()
     // 3 - subTaskMotorUpdate()
     uint32_t startTime = 0;
-    if (debugMode == DEBUG_PIDLOOP) {startTime = micros();}
+    if (DEBUG_MODE_IS_ACTIVE(DEBUG_PIDLOOP)) {startTime = micros();}
     gyroUpdate();
     DEBUG_SET(DEBUG_PIDLOOP, 0, micros() - startTime);
+#ifdef BLACKBOX
+    blackboxCaptureGyro(currentTimeUs);
+#endif
 
     if (pidUpdateCountdown) {
         pidUpdateCountdown--;
@@ -671,10 +725,72 @@ void taskMainPidLoop(timeUs_t currentTimeUs)
         pidUpdateCountdown = setPidUpdateCountDown();
         subTaskPidController(currentTimeUs);
         subTaskMotorUpdate();
+#ifdef BLACKBOX
+        blackboxCapture(currentTimeUs);
+#endif
         runTaskMainSubprocesses = true;
     }
 }
 
+#ifdef USE_GYRO_ISR_UPDATE
+// Called from the gyro data ready interrupt
+static void mainPidLoopIsr(void)
+{
+    if (mainPidLoopRunning || gyroIsBusInUse()) {
+        // The gyro is being accessed from task context, so leave this update to taskMainPidLoop()
+        mainPidLoopIsrPending = true;
+        return;
+    }
+    mainPidLoopRunning = true;
+    runMainPidLoop(micros());
+    mainPidLoopRunning = false;
+}
+
+// Moves the gyro update, PID controller and motor update into the gyro data ready interrupt, so they are
+// no longer delayed by whichever task happens to be running. Returns false if the interrupt is not available.
+bool mainPidLoopIsrInit(void)
+{
+    mainPidLoopInIsr = gyroSetIsrUpdate(mainPidLoopIsr);
+    return mainPidLoopInIsr;
+}
+#else
+bool mainPidLoopIsrInit(void)
+{
+    return false;
+}
+#endif
+
+// Function for loop trigger
+void taskMainPidLoop(timeUs_t currentTimeUs)
+{
+#if defined(SIMULATOR_BUILD) && defined(SIMULATOR_GYROPID_SYNC)
+    if (lockMainPID() != 0) return;
+#endif
+
+    DEBUG_SET(DEBUG_CYCLETIME, 0, getTaskDeltaTime(TASK_SELF));
+    DEBUG_SET(DEBUG_CYCLETIME, 1, averageSystemLoadPercent);
+
+    if (runTaskMainSubprocesses) {
+        runTaskMainSubprocesses = false;
+        subTaskMainSubprocesses(currentTimeUs);
+    }
+
+#ifdef USE_GYRO_ISR_UPDATE
+    if (mainPidLoopInIsr) {
+        // Claim the loop before checking for a pending update, an interrupt arriving after this will be deferred
+        mainPidLoopRunning = true;
+        if (mainPidLoopIsrPending) {
+            mainPidLoopIsrPending = false;
+            runMainPidLoop(micros());
+        }
+        mainPidLoopRunning = false;
+        return;
+    }
+#endif
+
+    runMainPidLoop(currentTimeUs);
+}
+
 bool isMotorsReversed()
 {
     return reverseMotors;
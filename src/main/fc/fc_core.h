@@ -47,5 +47,6 @@ void processRx(timeUs_t currentTimeUs);
 void updateArmingStatus(void);
 void updateRcCommands(void);
 
+bool mainPidLoopIsrInit(void);
 void taskMainPidLoop(timeUs_t currentTimeUs);
 bool isMotorsReversed(void);
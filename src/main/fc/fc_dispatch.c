@@ -21,13 +21,36 @@
 
 #include <platform.h>
 
+#include "common/maths.h"
 #include "common/utils.h"
 
 #include "drivers/time.h"
 
 #include "fc/fc_dispatch.h"
 
-static dispatchEntry_t *head = NULL;
+/*
+ * Entries are kept in a hierarchical timer wheel. Level 0 has one slot per tick, each higher level has one slot per
+ * revolution of the level below it. Filing an entry is O(1), and when a level wraps the next slot of the level above
+ * is refiled into the finer levels.
+ *
+ * dispatchAdd() only pushes the entry onto a lock free list, so it may be called from interrupt handlers. The wheel
+ * itself is only touched from dispatchProcess(), which files the new entries before turning the wheel.
+ */
+
+#define DISPATCH_WHEEL_TICK_SHIFT   4   // 16us ticks
+#define DISPATCH_WHEEL_TICK_US      (1 << DISPATCH_WHEEL_TICK_SHIFT)
+#define DISPATCH_WHEEL_LEVEL_SHIFT  5
+#define DISPATCH_WHEEL_SLOTS        (1 << DISPATCH_WHEEL_LEVEL_SHIFT)
+#define DISPATCH_WHEEL_SLOT_MASK    (DISPATCH_WHEEL_SLOTS - 1)
+#define DISPATCH_WHEEL_LEVELS       4   // 16us * 32^4, about 16.7s, longer delays are refiled until they fit
+#define DISPATCH_WHEEL_MAX_TICKS    ((1 << (DISPATCH_WHEEL_LEVEL_SHIFT * DISPATCH_WHEEL_LEVELS)) - 1)
+
+static dispatchEntry_t *incoming = NULL;
+static dispatchEntry_t *wheel[DISPATCH_WHEEL_LEVELS][DISPATCH_WHEEL_SLOTS];
+static uint32_t wheelLevel0Occupied;    // bit per non empty level 0 slot
+static uint32_t wheelTick;              // next tick to process
+static uint32_t wheelTickStartUs;       // time at which wheelTick is due
+static uint32_t wheelEntryCount;
 static bool dispatchEnabled = false;
 
 bool dispatchIsEnabled(void)
@@ -40,24 +63,113 @@ void dispatchEnable(void)
     dispatchEnabled = true;
 }
 
-void dispatchProcess(uint32_t currentTime)
+bool dispatchIsPending(const dispatchEntry_t *entry)
+{
+    return __atomic_load_n(&entry->pending, __ATOMIC_RELAXED);
+}
+
+static void dispatchWheelInsert(dispatchEntry_t *entry)
 {
-    for (dispatchEntry_t **p = &head; *p; ) {
-        if (cmp32(currentTime, (*p)->delayedUntil) < 0)
+    const int32_t delayUs = cmp32(entry->delayedUntil, wheelTickStartUs);
+    // round up, so an entry is never dispatched early
+    uint32_t ticks = delayUs > 0 ? ((uint32_t)delayUs + DISPATCH_WHEEL_TICK_US - 1) >> DISPATCH_WHEEL_TICK_SHIFT : 0;
+    if (ticks > DISPATCH_WHEEL_MAX_TICKS) {
+        ticks = DISPATCH_WHEEL_MAX_TICKS;
+    }
+
+    int level = 0;
+    while (ticks >> (DISPATCH_WHEEL_LEVEL_SHIFT * (level + 1))) {
+        level++;
+    }
+
+    const uint32_t expiry = wheelTick + ticks;
+    const unsigned slot = (expiry >> (DISPATCH_WHEEL_LEVEL_SHIFT * level)) & DISPATCH_WHEEL_SLOT_MASK;
+    entry->next = wheel[level][slot];
+    wheel[level][slot] = entry;
+    if (level == 0) {
+        wheelLevel0Occupied |= 1U << slot;
+    }
+    wheelEntryCount++;
+}
+
+static void dispatchWheelCascade(int level)
+{
+    const unsigned slot = (wheelTick >> (DISPATCH_WHEEL_LEVEL_SHIFT * level)) & DISPATCH_WHEEL_SLOT_MASK;
+    dispatchEntry_t *entry = wheel[level][slot];
+    wheel[level][slot] = NULL;
+    while (entry) {
+        dispatchEntry_t *next = entry->next;
+        wheelEntryCount--;
+        dispatchWheelInsert(entry);
+        entry = next;
+    }
+}
+
+static void dispatchWheelTick(void)
+{
+    for (int level = 1; level < DISPATCH_WHEEL_LEVELS; level++) {
+        if (wheelTick & ((1U << (DISPATCH_WHEEL_LEVEL_SHIFT * level)) - 1)) {
             break;
+        }
+        dispatchWheelCascade(level);
+    }
+
+    const unsigned slot = wheelTick & DISPATCH_WHEEL_SLOT_MASK;
+    dispatchEntry_t *entry = wheel[0][slot];
+    wheel[0][slot] = NULL;
+    wheelLevel0Occupied &= ~(1U << slot);
+    wheelTick++;
+    wheelTickStartUs += DISPATCH_WHEEL_TICK_US;
+
+    while (entry) {
         // unlink entry first, so handler can replan self
-        dispatchEntry_t *current = *p;
-        *p = (*p)->next;
+        dispatchEntry_t *current = entry;
+        entry = entry->next;
+        wheelEntryCount--;
+        __atomic_store_n(&current->pending, false, __ATOMIC_RELEASE);
         (*current->dispatch)(current);
     }
 }
 
+void dispatchProcess(uint32_t currentTime)
+{
+    if (!wheelEntryCount) {
+        // nothing filed, so the wheel can jump straight to the present
+        wheelTickStartUs = currentTime;
+    }
+
+    // entries added from here on, including by the handlers, wait for the next call
+    dispatchEntry_t *entry = __atomic_exchange_n(&incoming, NULL, __ATOMIC_ACQUIRE);
+    while (entry) {
+        dispatchEntry_t *next = entry->next;
+        dispatchWheelInsert(entry);
+        entry = next;
+    }
+
+    while (wheelEntryCount && cmp32(currentTime, wheelTickStartUs) >= 0) {
+        const unsigned slot = wheelTick & DISPATCH_WHEEL_SLOT_MASK;
+        if (slot && !(wheelLevel0Occupied >> slot)) {
+            // nothing is due before level 0 wraps, skip the empty slots
+            const uint32_t ticksDue = ((uint32_t)cmp32(currentTime, wheelTickStartUs) >> DISPATCH_WHEEL_TICK_SHIFT) + 1;
+            const uint32_t ticks = MIN(DISPATCH_WHEEL_SLOTS - slot, ticksDue);
+            wheelTick += ticks;
+            wheelTickStartUs += ticks * DISPATCH_WHEEL_TICK_US;
+            continue;
+        }
+        dispatchWheelTick();
+    }
+}
+
 void dispatchAdd(dispatchEntry_t *entry, int delayUs)
 {
-    uint32_t delayedUntil = micros() + delayUs;
-    dispatchEntry_t **p = &head;
-    while (*p && cmp32((*p)->delayedUntil, delayedUntil) < 0)
-        p = &(*p)->next;
-    entry->next = *p;
-    *p = entry;
+    if (__atomic_exchange_n(&entry->pending, true, __ATOMIC_ACQUIRE)) {
+        // already queued, keep the original time
+        return;
+    }
+    entry->delayedUntil = micros() + delayUs;
+
+    dispatchEntry_t *head = __atomic_load_n(&incoming, __ATOMIC_RELAXED);
+    do {
+        entry->next = head;
+    } while (!__atomic_compare_exchange_n(&incoming, &head, entry, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
 }
@@ -24,9 +24,12 @@ typedef struct dispatchEntry_s {
     dispatchFunc *dispatch;
     uint32_t delayedUntil;
     struct dispatchEntry_s *next;
+    bool pending;
 } dispatchEntry_t;
 
 bool dispatchIsEnabled(void);
 void dispatchEnable(void);
 void dispatchProcess(uint32_t currentTime);
+// Safe to call from interrupt handlers. Adding an entry that is still pending does nothing.
 void dispatchAdd(dispatchEntry_t *entry, int delayUs);
+bool dispatchIsPending(const dispatchEntry_t *entry);
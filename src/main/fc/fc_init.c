@@ -23,6 +23,7 @@
 
 #include "blackbox/blackbox.h"
 
+#include "common/arena.h"
 #include "common/axis.h"
 #include "common/color.h"
 #include "common/maths.h"
@@ -144,6 +145,28 @@ serialPort_t *loopbackPort;
 
 uint8_t systemState = SYSTEM_STATE_INITIALISING;
 
+// The arena holds the buffers of every optional feature built in, each claims its own only when enabled
+#ifdef USE_MAX7456
+#define ARENA_SIZE_MAX7456      MAX7456_ARENA_SIZE
+#else
+#define ARENA_SIZE_MAX7456      0
+#endif
+#ifdef TRANSPONDER
+#define ARENA_SIZE_TRANSPONDER  ARENA_ALIGN(TRANSPONDER_ARENA_SIZE)
+#else
+#define ARENA_SIZE_TRANSPONDER  0
+#endif
+#ifdef USE_FLASHFS
+#define ARENA_SIZE_FLASHFS      FLASHFS_ARENA_SIZE
+#else
+#define ARENA_SIZE_FLASHFS      0
+#endif
+
+#if defined(USE_MAX7456) || defined(TRANSPONDER) || defined(USE_FLASHFS)
+#define USE_ARENA
+static uint8_t arenaPool[ARENA_SIZE_MAX7456 + ARENA_SIZE_TRANSPONDER + ARENA_SIZE_FLASHFS] __attribute__((aligned(ARENA_ALIGNMENT)));
+#endif
+
 void processLoopback(void)
 {
 #ifdef SOFTSERIAL_LOOPBACK
@@ -241,10 +264,19 @@ void spiPreInit(void)
 
 void init(void)
 {
+#if defined(USE_ITCM_RAM) || defined(USE_FAST_RAM) || defined(USE_DMA_RAM)
+    // first, FAST_CODE, FAST_RAM and DMA_RAM are not usable before this
+    initialiseMemorySections();
+#endif
+
 #ifdef USE_HAL_DRIVER
     HAL_Init();
 #endif
 
+#ifdef USE_ARENA
+    arenaInit(arenaPool, sizeof(arenaPool));
+#endif
+
     printfSupportInit();
 
     systemInit();
@@ -283,7 +315,7 @@ void init(void)
 
     //i2cSetOverclock(masterConfig.i2c_overclock);
 
-    debugMode = systemConfig()->debug_mode;
+    debugInit(systemConfig()->debug_modes, DEBUG_MODE_SLOT_COUNT);
 
     // Latch active features to be used for feature() in the remainder of init().
     latchActiveFeatures();
@@ -351,7 +383,7 @@ void init(void)
     busSwitchInit();
 #endif
 
-#if defined(USE_UART)
+#if defined(USE_UART) && !defined(SITL)
     uartPinConfigure(serialPinConfig());
 #endif
 
@@ -504,25 +536,18 @@ void init(void)
 
     systemState |= SYSTEM_STATE_SENSORS_READY;
 
-    LED1_ON;
     LED0_OFF;
+    LED1_OFF;
     LED2_OFF;
 
-    for (int i = 0; i < 10; i++) {
-        LED1_TOGGLE;
-        LED0_TOGGLE;
-        delay(25);
-        if (!(getBeeperOffMask() & (1 << (BEEPER_SYSTEM_INIT - 1)))) BEEP_ON;
-        delay(25);
-        BEEP_OFF;
-    }
-    LED0_OFF;
-    LED1_OFF;
+    // The init beeps and the warning led flashes with them are played by the beeper task instead of holding up the start
+    beeper(BEEPER_SYSTEM_INIT);
 
     // gyro.targetLooptime set in sensorsAutodetect(), so we are ready to call pidInit()
     pidInit(currentPidProfile);
 
 #ifdef USE_SERVOS
+    servosInitUpdateRate();
     servosFilterInit();
 #endif
 
@@ -631,6 +656,7 @@ void init(void)
 #if defined(USE_FLASH_M25P16)
     m25p16_init(flashConfig());
 #endif
+    // takes what is left of the arena, so the features claiming from it must all be initialised by now
     flashfsInit();
 #endif
 
@@ -724,5 +750,10 @@ void init(void)
     rcSplitInit();
 #endif // USE_RCSPLIT
 
+#ifdef USE_UART_RX_DMA
+    // Last, so that the UARTs only get the DMA streams nothing else wanted
+    uartEnableRxDMA();
+#endif
+
     systemState |= SYSTEM_STATE_READY;
 }
@@ -23,9 +23,11 @@
 #include "platform.h"
 
 #include "blackbox/blackbox.h"
+#include "blackbox/blackbox_compress.h"
 
 #include "build/build_config.h"
 #include "build/debug.h"
+#include "build/trace.h"
 #include "build/version.h"
 
 #include "common/axis.h"
@@ -49,6 +51,7 @@
 #include "drivers/sdcard.h"
 #include "drivers/serial.h"
 #include "drivers/serial_escserial.h"
+#include "drivers/stack_check.h"
 #include "drivers/system.h"
 #include "drivers/vcd.h"
 #include "drivers/vtx_common.h"
@@ -61,6 +64,7 @@
 #include "fc/fc_msp.h"
 #include "fc/fc_msp_box.h"
 #include "fc/fc_rc.h"
+#include "fc/perf_record.h"
 #include "fc/rc_adjustments.h"
 #include "fc/rc_controls.h"
 #include "fc/rc_modes.h"
@@ -76,6 +80,7 @@
 
 #include "io/asyncfatfs/asyncfatfs.h"
 #include "io/beeper.h"
+#include "io/displayport_msp.h"
 #include "io/flashfs.h"
 #include "io/gimbal.h"
 #include "io/gps.h"
@@ -144,6 +149,8 @@ typedef enum {
 } mspSDCardFlags_e;
 
 #define RATEPROFILE_MASK (1 << 7)
+
+#define MSP_CYCLE_TRACE_MAX_EVENTS 32 // 5 bytes per event, keeps the reply well within the MSP port buffer
 #endif //USE_OSD_SLAVE
 
 #ifdef USE_SERIAL_4WAY_BLHELI_INTERFACE
@@ -287,7 +294,16 @@ static void serializeDataflashSummaryReply(sbuf_t *dst)
 }
 
 #ifdef USE_FLASHFS
-static void serializeDataflashReadReply(sbuf_t *dst, uint32_t address, const uint16_t size, bool useLegacyFormat)
+typedef enum {
+    DATAFLASH_COMPRESSION_NONE = 0,
+    DATAFLASH_COMPRESSION_BLACKBOX_BLOCK = 1, // a block in the format of the compressed blackbox log
+} dataflashCompression_e;
+
+/*
+ * Returns the number of bytes of flash the reply holds, which can be fewer than the size asked for at the end of the
+ * volume or when the reply is compressed.
+ */
+static uint16_t serializeDataflashReadReply(sbuf_t *dst, uint32_t address, const uint16_t size, bool useLegacyFormat, bool allowCompression)
 {
     BUILD_BUG_ON(MSP_PORT_DATAFLASH_INFO_SIZE < 16);
 
@@ -301,15 +317,47 @@ static void serializeDataflashReadReply(sbuf_t *dst, uint32_t address, const uin
         // truncate the request
         readLen = flashfsGetSize() - address;
     }
+#ifdef USE_BLACKBOX_COMPRESSION
+    // The compressor is the one blackbox logs with, so replies are only compressed while it isn't logging
+    allowCompression = allowCompression && !useLegacyFormat && blackboxMayEditConfig();
+    if (allowCompression) {
+        readLen = MIN(readLen, BLACKBOX_COMPRESSION_BLOCK_SIZE);
+    }
+#else
+    UNUSED(allowCompression);
+#endif
+
     sbufWriteU32(dst, address);
+    uint8_t *readLenPtr = sbufPtr(dst);
     if (!useLegacyFormat) {
         // new format supports variable read lengths
         sbufWriteU16(dst, readLen);
-        sbufWriteU8(dst, 0); // placeholder for compression format
+        sbufWriteU8(dst, DATAFLASH_COMPRESSION_NONE);
     }
 
     // bytesRead will equal readLen
     const int bytesRead = flashfsReadAbs(address, sbufPtr(dst), readLen);
+
+#ifdef USE_BLACKBOX_COMPRESSION
+    if (allowCompression && bytesRead > 0) {
+        blackboxCompressorReset();
+        const int bytesCompressed = blackboxCompressorAppend(sbufPtr(dst), bytesRead);
+        const uint8_t *block;
+        const int blockLength = blackboxCompressorFinishBlock(&block);
+
+        // Data that doesn't compress is sent as it is
+        if (blockLength < bytesCompressed) {
+            readLenPtr[0] = bytesCompressed & 0xff;
+            readLenPtr[1] = bytesCompressed >> 8;
+            readLenPtr[2] = DATAFLASH_COMPRESSION_BLACKBOX_BLOCK;
+            sbufWriteData(dst, block, blockLength);
+            return bytesCompressed;
+        }
+    }
+#else
+    UNUSED(readLenPtr);
+#endif
+
     sbufAdvance(dst, bytesRead);
 
     if (useLegacyFormat) {
@@ -318,6 +366,29 @@ static void serializeDataflashReadReply(sbuf_t *dst, uint32_t address, const uin
             sbufWriteU8(dst, 0);
         }
     }
+
+    return bytesRead;
+}
+
+static struct {
+    uint32_t address;
+    uint32_t endAddress;
+    uint16_t chunkSize;
+    bool allowCompression;
+} dataflashStream;
+
+static bool mspFcDataflashStreamNext(mspPacket_t *packet)
+{
+    // Reading the flash holds up everything else, so the stream ends on arming
+    if (ARMING_FLAG(ARMED) || dataflashStream.address >= dataflashStream.endAddress) {
+        return false;
+    }
+
+    const uint16_t size = MIN(dataflashStream.chunkSize, dataflashStream.endAddress - dataflashStream.address);
+    packet->cmd = MSP_DATAFLASH_READ;
+    dataflashStream.address += serializeDataflashReadReply(&packet->buf, dataflashStream.address, size, false, dataflashStream.allowCompression);
+
+    return true;
 }
 #endif // USE_FLASHFS
 #endif // USE_OSD_SLAVE
@@ -390,17 +461,67 @@ static bool mspCommonProcessOutCommand(uint8_t cmdMSP, sbuf_t *dst, mspPostProce
         // output some useful QA statistics
         // debug[x] = ((hse_value / 1000000) * 1000) + (SystemCoreClock / 1000000);         // XX0YY [crystal clock : core clock]
 
-        for (int i = 0; i < DEBUG16_VALUE_COUNT; i++) {
+        // the first bank, the message keeps its four 16 bit values
+        for (int i = 0; i < DEBUG_MODE_VALUE_COUNT; i++) {
             sbufWriteU16(dst, debug[i]);      // 4 variables are here for general monitoring purpose
         }
         break;
 
+#ifdef USE_CYCLE_TRACE
+    case MSP_CYCLE_TRACE:
+        {
+            traceEvent_t events[MSP_CYCLE_TRACE_MAX_EVENTS];
+            uint32_t lostCount;
+            const int count = traceRead(events, MSP_CYCLE_TRACE_MAX_EVENTS, &lostCount);
+            sbufWriteU16(dst, getCyclesPerMicrosecond());
+            sbufWriteU32(dst, lostCount);
+            sbufWriteU8(dst, count);
+            for (int i = 0; i < count; i++) {
+                sbufWriteU32(dst, events[i].cycles);
+                sbufWriteU8(dst, events[i].point);
+            }
+        }
+        break;
+#endif
+
+#ifdef STACK_CHECK
+    case MSP_MEMORY_STATS:
+        sbufWriteU32(dst, ramDataSize());
+        sbufWriteU32(dst, ramBssSize());
+        sbufWriteU32(dst, stackTotalSize());
+        sbufWriteU32(dst, stackUsedSize());
+#ifdef USE_TASK_STACK_STATISTICS
+        sbufWriteU8(dst, TASK_COUNT);
+        for (cfTaskId_e taskId = 0; taskId < TASK_COUNT; taskId++) {
+            cfTaskInfo_t taskInfo;
+            getTaskInfo(taskId, &taskInfo);
+            sbufWriteU16(dst, taskInfo.maxStackUsage);
+        }
+#else
+        sbufWriteU8(dst, 0);
+#endif
+        break;
+#endif
+
     case MSP_UID:
         sbufWriteU32(dst, U_ID_0);
         sbufWriteU32(dst, U_ID_1);
         sbufWriteU32(dst, U_ID_2);
         break;
 
+#ifdef USE_PERF_RECORD
+    case MSP_PERF_RECORD: {
+        const perfRecord_t *record = perfRecord();
+        sbufWriteU16(dst, record->flights);
+        sbufWriteU16(dst, record->flightsWithErrors);
+        sbufWriteU8(dst, sizeof(perfFlightStats_t) / sizeof(uint16_t));
+        // both flights as uint16_t fields in the order of perfFlightStats_t
+        sbufWriteData(dst, &record->lastFlight, sizeof(record->lastFlight));
+        sbufWriteData(dst, &record->worstFlight, sizeof(record->worstFlight));
+        break;
+    }
+#endif
+
     case MSP_FEATURE_CONFIG:
         sbufWriteU32(dst, featureMask());
         break;
@@ -585,9 +706,7 @@ static bool mspCommonProcessOutCommand(uint8_t cmdMSP, sbuf_t *dst, mspPostProce
         sbufWriteU16(dst, osdConfig()->alt_alarm);
 
         // Element position and visibility
-        for (int i = 0; i < OSD_ITEM_COUNT; i++) {
-            sbufWriteU16(dst, osdConfig()->item_pos[i]);
-        }
+        sbufWriteData(dst, osdConfig()->item_pos, sizeof(osdConfig()->item_pos));
 
         // Post flight statistics
         sbufWriteU8(dst, OSD_STAT_COUNT);
@@ -742,9 +861,7 @@ static bool mspFcProcessOutCommand(uint8_t cmdMSP, sbuf_t *dst)
         break;
 
     case MSP_RC:
-        for (int i = 0; i < rxRuntimeConfig.channelCount; i++) {
-            sbufWriteU16(dst, rcData[i]);
-        }
+        sbufWriteData(dst, rcData, rxRuntimeConfig.channelCount * sizeof(rcData[0]));
         break;
 
     case MSP_ATTITUDE:
@@ -795,46 +912,59 @@ static bool mspFcProcessOutCommand(uint8_t cmdMSP, sbuf_t *dst)
         sbufWriteU8(dst, currentControlRateProfile->rcYawRate8);
         break;
 
-    case MSP_PID:
+    case MSP_PID: {
+        uint8_t *data = sbufReserve(dst, PID_ITEM_COUNT * 3);
+        if (!data) {
+            break;
+        }
         for (int i = 0; i < PID_ITEM_COUNT; i++) {
-            sbufWriteU8(dst, currentPidProfile->pid[i].P);
-            sbufWriteU8(dst, currentPidProfile->pid[i].I);
-            sbufWriteU8(dst, currentPidProfile->pid[i].D);
+            *data++ = currentPidProfile->pid[i].P;
+            *data++ = currentPidProfile->pid[i].I;
+            *data++ = currentPidProfile->pid[i].D;
         }
         break;
+    }
 
     case MSP_PIDNAMES:
-        for (const char *c = pidnames; *c; c++) {
-            sbufWriteU8(dst, *c);
-        }
+        sbufWriteString(dst, pidnames);
         break;
 
     case MSP_PID_CONTROLLER:
         sbufWriteU8(dst, PID_CONTROLLER_BETAFLIGHT);
         break;
 
-    case MSP_MODE_RANGES:
+    case MSP_MODE_RANGES: {
+        uint8_t *data = sbufReserve(dst, MAX_MODE_ACTIVATION_CONDITION_COUNT * 4);
+        if (!data) {
+            break;
+        }
         for (int i = 0; i < MAX_MODE_ACTIVATION_CONDITION_COUNT; i++) {
             const modeActivationCondition_t *mac = modeActivationConditions(i);
             const box_t *box = findBoxByBoxId(mac->modeId);
-            sbufWriteU8(dst, box->permanentId);
-            sbufWriteU8(dst, mac->auxChannelIndex);
-            sbufWriteU8(dst, mac->range.startStep);
-            sbufWriteU8(dst, mac->range.endStep);
+            *data++ = box->permanentId;
+            *data++ = mac->auxChannelIndex;
+            *data++ = mac->range.startStep;
+            *data++ = mac->range.endStep;
         }
         break;
+    }
 
-    case MSP_ADJUSTMENT_RANGES:
+    case MSP_ADJUSTMENT_RANGES: {
+        uint8_t *data = sbufReserve(dst, MAX_ADJUSTMENT_RANGE_COUNT * 6);
+        if (!data) {
+            break;
+        }
         for (int i = 0; i < MAX_ADJUSTMENT_RANGE_COUNT; i++) {
             const adjustmentRange_t *adjRange = adjustmentRanges(i);
-            sbufWriteU8(dst, adjRange->adjustmentIndex);
-            sbufWriteU8(dst, adjRange->auxChannelIndex);
-            sbufWriteU8(dst, adjRange->range.startStep);
-            sbufWriteU8(dst, adjRange->range.endStep);
-            sbufWriteU8(dst, adjRange->adjustmentFunction);
-            sbufWriteU8(dst, adjRange->auxSwitchChannelIndex);
+            *data++ = adjRange->adjustmentIndex;
+            *data++ = adjRange->auxChannelIndex;
+            *data++ = adjRange->range.startStep;
+            *data++ = adjRange->range.endStep;
+            *data++ = adjRange->adjustmentFunction;
+            *data++ = adjRange->auxSwitchChannelIndex;
         }
         break;
+    }
 
     case MSP_MOTOR_CONFIG:
         sbufWriteU16(dst, motorConfig()->minthrottle);
@@ -964,19 +1094,13 @@ static bool mspFcProcessOutCommand(uint8_t cmdMSP, sbuf_t *dst)
 
 #ifdef LED_STRIP
     case MSP_LED_COLORS:
-        for (int i = 0; i < LED_CONFIGURABLE_COLOR_COUNT; i++) {
-            const hsvColor_t *color = &ledStripConfig()->colors[i];
-            sbufWriteU16(dst, color->h);
-            sbufWriteU8(dst, color->s);
-            sbufWriteU8(dst, color->v);
-        }
+        // the colours are kept as they are sent, h then s and v
+        BUILD_BUG_ON(sizeof(hsvColor_t) != 4);
+        sbufWriteData(dst, ledStripConfig()->colors, LED_CONFIGURABLE_COLOR_COUNT * sizeof(hsvColor_t));
         break;
 
     case MSP_LED_STRIP_CONFIG:
-        for (int i = 0; i < LED_MAX_STRIP_LENGTH; i++) {
-            const ledConfig_t *ledConfig = &ledStripConfig()->ledConfigs[i];
-            sbufWriteU32(dst, *ledConfig);
-        }
+        sbufWriteData(dst, ledStripConfig()->ledConfigs, LED_MAX_STRIP_LENGTH * sizeof(ledConfig_t));
         break;
 
     case MSP_LED_STRIP_MODECOLOR:
@@ -1024,6 +1148,31 @@ static bool mspFcProcessOutCommand(uint8_t cmdMSP, sbuf_t *dst)
         serializeSDCardSummaryReply(dst);
         break;
 
+#ifdef USE_SDCARD_STATS
+    case MSP_SDCARD_STATS:
+        {
+            const sdcardStats_t *stats = sdcardStats_get();
+            sbufWriteU32(dst, stats->writeCount);
+            sbufWriteU32(dst, sdcardStats_getWriteRate());
+            sbufWriteU32(dst, afatfs_getCacheSize());
+            sbufWriteU32(dst, stats->maxWriteLatencyUs);
+            sbufWriteU32(dst, stats->maxBusyUs);
+            sbufWriteU8(dst, SDCARD_STATS_BUCKET_COUNT);
+            sbufWriteU8(dst, SDCARD_STATS_FIRST_BUCKET_SHIFT);
+            for (int i = 0; i < SDCARD_STATS_BUCKET_COUNT; i++) {
+                sbufWriteU32(dst, stats->writeLatencyHistogram[i]);
+            }
+            for (int i = 0; i < SDCARD_STATS_BUCKET_COUNT; i++) {
+                sbufWriteU32(dst, stats->busyHistogram[i]);
+            }
+        }
+        break;
+#endif
+
+    case MSP_EEPROM_WRITE_STATUS:
+        sbufWriteU8(dst, isConfigWriteInProgress() ? 1 : 0);
+        break;
+
     case MSP_MOTOR_3D_CONFIG:
         sbufWriteU16(dst, flight3DConfig()->deadband3d_low);
         sbufWriteU16(dst, flight3DConfig()->deadband3d_high);
@@ -1149,6 +1298,26 @@ static mspResult_e mspFcProcessOutCommandWithArg(uint8_t cmdMSP, sbuf_t *arg, sb
             serializeBoxReply(dst, page, &serializeBoxPermanentIdFn);
         }
         break;
+#ifdef USE_TASK_STATISTICS_HISTOGRAM
+    case MSP_TASK_HISTOGRAM:
+        {
+            const cfTaskId_e taskId = sbufBytesRemaining(arg) ? sbufReadU8(arg) : TASK_GYROPID;
+            cfTaskHistogram_t histogram;
+            if (!getTaskHistogram(taskId, &histogram)) {
+                return MSP_RESULT_ERROR;
+            }
+            sbufWriteU8(dst, taskId);
+            sbufWriteU8(dst, TASK_HISTOGRAM_BUCKET_COUNT);
+            sbufWriteU32(dst, histogram.missedPeriods);
+            for (int i = 0; i < TASK_HISTOGRAM_BUCKET_COUNT; i++) {
+                sbufWriteU32(dst, histogram.executionTime[i]);
+            }
+            for (int i = 0; i < TASK_HISTOGRAM_BUCKET_COUNT; i++) {
+                sbufWriteU32(dst, histogram.lateness[i]);
+            }
+        }
+        break;
+#endif
     default:
         return MSP_RESULT_CMD_UNKNOWN;
     }
@@ -1194,7 +1363,179 @@ static void mspFcDataFlashReadCommand(sbuf_t *dst, sbuf_t *src)
         useLegacyFormat = true;
     }
 
-    serializeDataflashReadReply(dst, readAddress, readLength, useLegacyFormat);
+    bool allowCompression = false;
+    if (dataSize >= sizeof(uint32_t) + sizeof(uint16_t) + sizeof(uint8_t)) {
+        allowCompression = sbufReadU8(src);
+    }
+
+    serializeDataflashReadReply(dst, readAddress, readLength, useLegacyFormat, allowCompression);
+}
+
+/*
+ * Sends the range as a stream of MSP_DATAFLASH_READ replies, each of up to the chunk size, without waiting for the host
+ * to ask for each one. Any command from the host stops the stream.
+ */
+static mspResult_e mspFcDataFlashStreamCommand(sbuf_t *src)
+{
+    if (sbufBytesRemaining(src) < 10) {
+        return MSP_RESULT_ERROR;
+    }
+
+    const uint32_t address = sbufReadU32(src);
+    const uint32_t length = sbufReadU32(src);
+    const uint16_t chunkSize = sbufReadU16(src);
+    const bool allowCompression = sbufBytesRemaining(src) >= 1 && sbufReadU8(src);
+
+    if (address >= flashfsGetSize()) {
+        return MSP_RESULT_ERROR;
+    }
+
+    dataflashStream.address = address;
+    dataflashStream.endAddress = address + MIN(length, flashfsGetSize() - address);
+    dataflashStream.chunkSize = chunkSize;
+    dataflashStream.allowCompression = allowCompression;
+
+    if (chunkSize > 0 && length > 0) {
+        mspSerialStartStream(mspFcDataflashStreamNext);
+    }
+
+    return MSP_RESULT_ACK;
+}
+#endif
+
+#ifndef USE_OSD_SLAVE
+#define MSP_PG_ENTRY_HEADER_SIZE 5  // PGN, version and size
+#define MSP_PG_READ_MAX_PGNS 32
+
+static struct {
+    const pgRegistry_t *reg;        // next PG to send, NULL once the transfer has ended
+    uint8_t pgnCount;               // 0 to send every PG
+    pgn_t pgns[MSP_PG_READ_MAX_PGNS];
+} pgReadStream;
+
+static bool isPgRequested(const pgRegistry_t *reg)
+{
+    if (pgReadStream.pgnCount == 0) {
+        return true;
+    }
+    for (int i = 0; i < pgReadStream.pgnCount; i++) {
+        if (pgReadStream.pgns[i] == pgN(reg)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * Write as many of the requested PGs as fit, each as PGN, version, size and the contents as stored in the config.
+ * A PG too large for an MSP packet is sent with a size of 0. Returns the number of PGs written.
+ */
+static int serializePgReadReply(sbuf_t *dst)
+{
+    int count = 0;
+
+    for (; pgReadStream.reg < __pg_registry_end; pgReadStream.reg++) {
+        const pgRegistry_t *reg = pgReadStream.reg;
+        if (!isPgRequested(reg)) {
+            continue;
+        }
+
+        const int entrySize = MSP_PG_ENTRY_HEADER_SIZE + pgSize(reg);
+        if (entrySize > sbufBytesRemaining(dst)) {
+            if (count > 0) {
+                break;
+            }
+            sbufWriteU16(dst, pgN(reg));
+            sbufWriteU8(dst, pgVersion(reg));
+            sbufWriteU16(dst, 0);
+        } else {
+            sbufWriteU16(dst, pgN(reg));
+            sbufWriteU8(dst, pgVersion(reg));
+            sbufWriteU16(dst, pgSize(reg));
+            sbufAdvance(dst, pgStore(reg, sbufPtr(dst), pgSize(reg)));
+        }
+        count++;
+    }
+
+    return count;
+}
+
+static bool mspFcPgReadStreamNext(mspPacket_t *packet)
+{
+    if (!pgReadStream.reg) {
+        return false;
+    }
+
+    packet->cmd = MSP_PG_READ;
+    if (serializePgReadReply(&packet->buf) == 0) {
+        // This empty packet ends the transfer
+        pgReadStream.reg = NULL;
+    }
+
+    return true;
+}
+
+/*
+ * Reads the PGs listed in the request, or every PG if the list is empty, in one transfer. The reply holds as many as
+ * fit, the rest follow as a stream of MSP_PG_READ packets. The transfer ends with an MSP_PG_READ packet holding no PGs.
+ */
+static mspResult_e mspFcPgReadCommand(sbuf_t *dst, sbuf_t *src)
+{
+    const int pgnCount = sbufBytesRemaining(src) / sizeof(pgn_t);
+    if (pgnCount > MSP_PG_READ_MAX_PGNS) {
+        return MSP_RESULT_ERROR;
+    }
+
+    pgReadStream.pgnCount = pgnCount;
+    for (int i = 0; i < pgnCount; i++) {
+        pgReadStream.pgns[i] = sbufReadU16(src);
+    }
+    pgReadStream.reg = __pg_registry_start;
+
+    if (serializePgReadReply(dst) > 0) {
+        mspSerialStartStream(mspFcPgReadStreamNext);
+    } else {
+        pgReadStream.reg = NULL;
+    }
+
+    return MSP_RESULT_ACK;
+}
+
+/*
+ * Writes PGs given as PGN, version, size and contents, as sent by MSP_PG_READ. Nothing is written unless every PG is
+ * known and has the version and size of this firmware, so a set of PGs is applied together or not at all.
+ */
+static mspResult_e mspFcSetPgCommand(sbuf_t *src)
+{
+    if (ARMING_FLAG(ARMED)) {
+        return MSP_RESULT_ERROR;
+    }
+
+    for (int pass = 0; pass < 2; pass++) {
+        uint8_t *start = sbufPtr(src);
+
+        while (sbufBytesRemaining(src) > 0) {
+            if (sbufBytesRemaining(src) < MSP_PG_ENTRY_HEADER_SIZE) {
+                return MSP_RESULT_ERROR;
+            }
+            const pgRegistry_t *reg = pgFind(sbufReadU16(src));
+            const uint8_t version = sbufReadU8(src);
+            const uint16_t size = sbufReadU16(src);
+            if (!reg || version != pgVersion(reg) || size != pgSize(reg) || size > sbufBytesRemaining(src)) {
+                return MSP_RESULT_ERROR;
+            }
+
+            if (pass == 1) {
+                pgLoad(reg, sbufPtr(src), size, version);
+            }
+            sbufAdvance(src, size);
+        }
+
+        // Apply the PGs once they have all been checked
+        src->ptr = start;
+    }
+
+    return MSP_RESULT_ACK;
 }
 #endif
 
@@ -1249,10 +1590,12 @@ static mspResult_e mspFcProcessInCommand(uint8_t cmdMSP, sbuf_t *src)
             if (channelCount > MAX_SUPPORTED_RC_CHANNEL_COUNT) {
                 return MSP_RESULT_ERROR;
             } else {
-                uint16_t frame[MAX_SUPPORTED_RC_CHANNEL_COUNT];
-                for (int i = 0; i < channelCount; i++) {
-                    frame[i] = sbufReadU16(src);
+                const uint8_t *data = sbufReadView(src, channelCount * sizeof(uint16_t));
+                if (!data) {
+                    return MSP_RESULT_ERROR;
                 }
+                uint16_t frame[MAX_SUPPORTED_RC_CHANNEL_COUNT];
+                memcpy(frame, data, channelCount * sizeof(uint16_t));
                 rxMspFrameReceive(frame, channelCount);
             }
         }
@@ -1270,14 +1613,19 @@ static mspResult_e mspFcProcessInCommand(uint8_t cmdMSP, sbuf_t *src)
     case MSP_SET_PID_CONTROLLER:
         break;
 
-    case MSP_SET_PID:
+    case MSP_SET_PID: {
+        const uint8_t *data = sbufReadView(src, PID_ITEM_COUNT * 3);
+        if (!data) {
+            return MSP_RESULT_ERROR;
+        }
         for (int i = 0; i < PID_ITEM_COUNT; i++) {
-            currentPidProfile->pid[i].P = sbufReadU8(src);
-            currentPidProfile->pid[i].I = sbufReadU8(src);
-            currentPidProfile->pid[i].D = sbufReadU8(src);
+            currentPidProfile->pid[i].P = *data++;
+            currentPidProfile->pid[i].I = *data++;
+            currentPidProfile->pid[i].D = *data++;
         }
         pidInitConfig(currentPidProfile);
         break;
+    }
 
     case MSP_SET_MODE_RANGE:
         i = sbufReadU8(src);
@@ -1312,6 +1660,8 @@ static mspResult_e mspFcProcessInCommand(uint8_t cmdMSP, sbuf_t *src)
                 adjRange->range.endStep = sbufReadU8(src);
                 adjRange->adjustmentFunction = sbufReadU8(src);
                 adjRange->auxSwitchChannelIndex = sbufReadU8(src);
+
+                analyzeModeActivationConditions();
             } else {
                 return MSP_RESULT_ERROR;
             }
@@ -1459,27 +1809,34 @@ static mspResult_e mspFcProcessInCommand(uint8_t cmdMSP, sbuf_t *src)
         break;
 
     case MSP_SET_FILTER_CONFIG:
-        gyroConfigMutable()->gyro_soft_lpf_hz = sbufReadU8(src);
-        currentPidProfile->dterm_lpf_hz = sbufReadU16(src);
-        currentPidProfile->yaw_lpf_hz = sbufReadU16(src);
-        if (sbufBytesRemaining(src) >= 8) {
-            gyroConfigMutable()->gyro_soft_notch_hz_1 = sbufReadU16(src);
-            gyroConfigMutable()->gyro_soft_notch_cutoff_1 = sbufReadU16(src);
-            currentPidProfile->dterm_notch_hz = sbufReadU16(src);
-            currentPidProfile->dterm_notch_cutoff = sbufReadU16(src);
-        }
-        if (sbufBytesRemaining(src) >= 4) {
-            gyroConfigMutable()->gyro_soft_notch_hz_2 = sbufReadU16(src);
-            gyroConfigMutable()->gyro_soft_notch_cutoff_2 = sbufReadU16(src);
-        }
-        if (sbufBytesRemaining(src) >= 1) {
-            currentPidProfile->dterm_filter_type = sbufReadU8(src);
+        {
+            const uint16_t gyroGeneration = gyroConfigGeneration();
+            const uint16_t pidGeneration = pidProfilesGeneration();
+            gyroConfigMutable()->gyro_soft_lpf_hz = sbufReadU8(src);
+            currentPidProfile->dterm_lpf_hz = sbufReadU16(src);
+            currentPidProfile->yaw_lpf_hz = sbufReadU16(src);
+            if (sbufBytesRemaining(src) >= 8) {
+                gyroConfigMutable()->gyro_soft_notch_hz_1 = sbufReadU16(src);
+                gyroConfigMutable()->gyro_soft_notch_cutoff_1 = sbufReadU16(src);
+                currentPidProfile->dterm_notch_hz = sbufReadU16(src);
+                currentPidProfile->dterm_notch_cutoff = sbufReadU16(src);
+            }
+            if (sbufBytesRemaining(src) >= 4) {
+                gyroConfigMutable()->gyro_soft_notch_hz_2 = sbufReadU16(src);
+                gyroConfigMutable()->gyro_soft_notch_cutoff_2 = sbufReadU16(src);
+            }
+            if (sbufBytesRemaining(src) >= 1) {
+                currentPidProfile->dterm_filter_type = sbufReadU8(src);
+            }
+            validateAndFixGyroConfig();
+            // reinitialize only the filters whose settings changed, setting them up again resets their state
+            if (gyroConfigGeneration() != gyroGeneration) {
+                gyroInitFilters();
+            }
+            if (pidProfilesGeneration() != pidGeneration) {
+                pidInitFilters(currentPidProfile);
+            }
         }
-        // reinitialize the gyro filters with the new values
-        validateAndFixGyroConfig();
-        gyroInitFilters();
-        // reinitialize the PID filters with the new values
-        pidInitFilters(currentPidProfile);
         break;
 
     case MSP_SET_PID_ADVANCED:
@@ -1533,8 +1890,7 @@ static mspResult_e mspFcProcessInCommand(uint8_t cmdMSP, sbuf_t *src)
         if (ARMING_FLAG(ARMED)) {
             return MSP_RESULT_ERROR;
         }
-        writeEEPROM();
-        readEEPROM();
+        writeEEPROMAsync();
         break;
 
 #ifdef BLACKBOX
@@ -1768,14 +2124,14 @@ static mspResult_e mspFcProcessInCommand(uint8_t cmdMSP, sbuf_t *src)
         break;
 
 #ifdef LED_STRIP
-    case MSP_SET_LED_COLORS:
-        for (int i = 0; i < LED_CONFIGURABLE_COLOR_COUNT; i++) {
-            hsvColor_t *color = &ledStripConfigMutable()->colors[i];
-            color->h = sbufReadU16(src);
-            color->s = sbufReadU8(src);
-            color->v = sbufReadU8(src);
+    case MSP_SET_LED_COLORS: {
+        const uint8_t *data = sbufReadView(src, LED_CONFIGURABLE_COLOR_COUNT * sizeof(hsvColor_t));
+        if (!data) {
+            return MSP_RESULT_ERROR;
         }
+        memcpy(ledStripConfigMutable()->colors, data, LED_CONFIGURABLE_COLOR_COUNT * sizeof(hsvColor_t));
         break;
+    }
 
     case MSP_SET_LED_STRIP_CONFIG:
         {
@@ -2036,6 +2392,14 @@ mspResult_e mspFcProcessCommand(mspPacket_t *cmd, mspPacket_t *reply, mspPostPro
     } else if (cmdMSP == MSP_DATAFLASH_READ) {
         mspFcDataFlashReadCommand(dst, src);
         ret = MSP_RESULT_ACK;
+    } else if (cmdMSP == MSP_DATAFLASH_STREAM) {
+        ret = mspFcDataFlashStreamCommand(src);
+#endif
+#ifndef USE_OSD_SLAVE
+    } else if (cmdMSP == MSP_PG_READ) {
+        ret = mspFcPgReadCommand(dst, src);
+    } else if (cmdMSP == MSP_SET_PG) {
+        ret = mspFcSetPgCommand(src);
 #endif
     } else {
         ret = mspCommonProcessInCommand(cmdMSP, src);
@@ -2070,6 +2434,14 @@ void mspFcProcessReply(mspPacket_t *reply)
         }
 #endif
 
+#if defined(USE_MSP_DISPLAYPORT) && !defined(USE_OSD_SLAVE)
+    case MSP_DISPLAYPORT:
+        if (sbufBytesRemaining(src) && sbufReadU8(src) == MSP_DISPLAYPORT_FRAME_ACK) {
+            displayPortMspFrameAcknowledged();
+        }
+        break;
+#endif
+
 #ifdef USE_OSD_SLAVE
     case MSP_DISPLAYPORT:
         {
@@ -22,6 +22,7 @@
 #include "platform.h"
 
 #include "common/bitarray.h"
+#include "common/maths.h"
 #include "common/streambuf.h"
 #include "common/utils.h"
 
@@ -83,6 +84,19 @@ static const box_t boxes[CHECKBOX_ITEM_COUNT] = {
 
 static boxBitmask_t activeBoxIds;
 
+// active boxes in MSP index order, the order BOXNAMES, BOXIDS and the status flags are sent in
+static const box_t *activeBoxes[CHECKBOX_ITEM_COUNT];
+static uint8_t activeBoxCount;
+
+// last packed status flags and the mode state they were packed from
+static struct {
+    bool valid;
+    bool armed;
+    uint16_t flightModeFlags;
+    boxBitmask_t rcModes;
+    boxBitmask_t mspFlightModeFlags;
+} flightModeFlagsCache;
+
 const box_t *findBoxByBoxId(boxId_e boxId)
 {
     for (unsigned i = 0; i < ARRAYLEN(boxes); i++) {
@@ -112,8 +126,12 @@ static bool activeBoxIdGet(boxId_e boxId)
 
 void serializeBoxNameFn(sbuf_t *dst, const box_t *box)
 {
-    sbufWriteString(dst, box->boxName);
-    sbufWriteU8(dst, ';');
+    const int len = strlen(box->boxName);
+    uint8_t *data = sbufReserve(dst, len + 1);
+    if (data) {
+        memcpy(data, box->boxName, len);
+        data[len] = ';';
+    }
 }
 
 void serializeBoxPermanentIdFn(sbuf_t *dst, const box_t *box)
@@ -125,16 +143,10 @@ void serializeBoxPermanentIdFn(sbuf_t *dst, const box_t *box)
 // Each page contains at most 32 boxes
 void serializeBoxReply(sbuf_t *dst, int page, serializeBoxFn *serializeBox)
 {
-    unsigned boxIdx = 0;
-    unsigned pageStart = page * 32;
-    unsigned pageEnd = pageStart + 32;
-    for (boxId_e id = 0; id < CHECKBOX_ITEM_COUNT; id++) {
-        if (activeBoxIdGet(id)) {
-            if (boxIdx >= pageStart && boxIdx < pageEnd) {
-                (*serializeBox)(dst, findBoxByBoxId(id));
-            }
-            boxIdx++;                 // count active boxes
-        }
+    const unsigned pageStart = page * 32;
+    const unsigned pageEnd = MIN(pageStart + 32, activeBoxCount);
+    for (unsigned boxIdx = pageStart; boxIdx < pageEnd; boxIdx++) {
+        (*serializeBox)(dst, activeBoxes[boxIdx]);
     }
 }
 
@@ -257,62 +269,78 @@ void initActiveBoxIds(void)
             bitArrayClr(&ena, boxId);                 // this should not happen, but handle it gracefully
 
     activeBoxIds = ena;                               // set global variable
+
+    activeBoxCount = 0;
+    for (boxId_e boxId = 0; boxId < CHECKBOX_ITEM_COUNT; boxId++) {
+        if (activeBoxIdGet(boxId)) {
+            activeBoxes[activeBoxCount++] = findBoxByBoxId(boxId);
+        }
+    }
+    flightModeFlagsCache.valid = false;               // MSP indexes have changed
 }
 
 // pack used flightModeFlags into supplied array
 // returns number of bits used
 int packFlightModeFlags(boxBitmask_t *mspFlightModeFlags)
 {
-    // Serialize the flags in the order we delivered them, ignoring BOXNAMES and BOXINDEXES
-    memset(mspFlightModeFlags, 0, sizeof(boxBitmask_t));
+    // enable BOXes dependent on rcMode bits, indexes are the same.
+    // only subset of BOXes depend on rcMode, use mask to select them
+#define BM(x) (1ULL << (x))
+    // limited to 64 BOXes now to keep code simple
+    const uint64_t rcModeCopyMask = BM(BOXHEADADJ) | BM(BOXCAMSTAB) | BM(BOXCAMTRIG) | BM(BOXBEEPERON)
+        | BM(BOXLEDMAX) | BM(BOXLEDLOW) | BM(BOXLLIGHTS) | BM(BOXCALIB) | BM(BOXGOV) | BM(BOXOSD)
+        | BM(BOXTELEMETRY) | BM(BOXGTUNE) | BM(BOXBLACKBOX) | BM(BOXBLACKBOXERASE) | BM(BOXAIRMODE)
+        | BM(BOXANTIGRAVITY) | BM(BOXFPVANGLEMIX) | BM(BOXDSHOTREVERSE) | BM(BOX3DDISABLE);
+#undef BM
+    STATIC_ASSERT(sizeof(rcModeCopyMask) * 8 >= CHECKBOX_ITEM_COUNT, copy_mask_too_small_for_boxes);
 
-    // enabled BOXes, bits indexed by boxId_e
-    boxBitmask_t boxEnabledMask;
-    memset(&boxEnabledMask, 0, sizeof(boxEnabledMask));
+    // the flags only change with the modes and the arming state, which a status poll rarely sees move
+    boxBitmask_t rcModes;
+    for (unsigned i = 0; i < ARRAYLEN(rcModes.bits); i++) {
+        rcModes.bits[i] = rcModeActivationMask.bits[i] & (uint32_t)(rcModeCopyMask >> (i * 32));
+    }
+    const bool armed = ARMING_FLAG(ARMED);
+    if (flightModeFlagsCache.valid
+        && flightModeFlagsCache.flightModeFlags == flightModeFlags
+        && flightModeFlagsCache.armed == armed
+        && memcmp(&flightModeFlagsCache.rcModes, &rcModes, sizeof(rcModes)) == 0) {
+        memcpy(mspFlightModeFlags, &flightModeFlagsCache.mspFlightModeFlags, sizeof(boxBitmask_t));
+        return activeBoxCount;
+    }
+
+    // enabled BOXes, bits indexed by boxId_e, starting with the rcMode ones
+    boxBitmask_t boxEnabledMask = rcModes;
 
     // enable BOXes dependent on FLIGHT_MODE, use mapping table (from runtime_config.h)
     // flightMode_boxId_map[HORIZON_MODE] == BOXHORIZON
     static const int8_t flightMode_boxId_map[] = FLIGHT_MODE_BOXID_MAP_INITIALIZER;
-    flightModeFlags_e flightModeCopyMask = ~0;  // only modes with bit set will be copied
     for (unsigned i = 0; i < ARRAYLEN(flightMode_boxId_map); i++) {
         if (flightMode_boxId_map[i] != -1        // boxId_e does exist for this FLIGHT_MODE
-           && (flightModeCopyMask & (1 << i))   // this flightmode is copy is enabled
            && FLIGHT_MODE(1 << i)) {            // this flightmode is active
             bitArraySet(&boxEnabledMask, flightMode_boxId_map[i]);
         }
     }
 
-    // enable BOXes dependent on rcMode bits, indexes are the same.
-    // only subset of BOXes depend on rcMode, use mask to select them
-#define BM(x) (1ULL << (x))
-    // limited to 64 BOXes now to keep code simple
-    const uint64_t rcModeCopyMask = BM(BOXHEADADJ) | BM(BOXCAMSTAB) | BM(BOXCAMTRIG) | BM(BOXBEEPERON)
-        | BM(BOXLEDMAX) | BM(BOXLEDLOW) | BM(BOXLLIGHTS) | BM(BOXCALIB) | BM(BOXGOV) | BM(BOXOSD)
-        | BM(BOXTELEMETRY) | BM(BOXGTUNE) | BM(BOXBLACKBOX) | BM(BOXBLACKBOXERASE) | BM(BOXAIRMODE)
-        | BM(BOXANTIGRAVITY) | BM(BOXFPVANGLEMIX) | BM(BOXDSHOTREVERSE) | BM(BOX3DDISABLE);
-    STATIC_ASSERT(sizeof(rcModeCopyMask) * 8 >= CHECKBOX_ITEM_COUNT, copy_mask_too_small_for_boxes);
-    for (unsigned i = 0; i < CHECKBOX_ITEM_COUNT; i++) {
-        if ((rcModeCopyMask & BM(i))    // mode copy is enabled
-           && IS_RC_MODE_ACTIVE(i)) {    // mode is active
-            bitArraySet(&boxEnabledMask, i);
-        }
-    }
-#undef BM
     // copy ARM state
-    if (ARMING_FLAG(ARMED))
+    if (armed)
         bitArraySet(&boxEnabledMask, BOXARM);
 
     // map boxId_e enabled bits to MSP status indexes
     // only active boxIds are sent in status over MSP, other bits are not counted
-    unsigned mspBoxIdx = 0;           // index of active boxId (matches sent permanentId and boxNames)
-    for (boxId_e boxId = 0; boxId < CHECKBOX_ITEM_COUNT; boxId++) {
-        if (activeBoxIdGet(boxId)) {
-            if (bitArrayGet(&boxEnabledMask,  boxId))
-                bitArraySet(mspFlightModeFlags,  mspBoxIdx);      // box is enabled
-            mspBoxIdx++;                                          // box is active, count it
-        }
+    boxBitmask_t *packed = &flightModeFlagsCache.mspFlightModeFlags;
+    memset(packed, 0, sizeof(boxBitmask_t));
+    for (unsigned mspBoxIdx = 0; mspBoxIdx < activeBoxCount; mspBoxIdx++) {
+        if (bitArrayGet(&boxEnabledMask, activeBoxes[mspBoxIdx]->boxId))
+            bitArraySet(packed, mspBoxIdx);                       // box is enabled
     }
+
+    flightModeFlagsCache.flightModeFlags = flightModeFlags;
+    flightModeFlagsCache.armed = armed;
+    flightModeFlagsCache.rcModes = rcModes;
+    flightModeFlagsCache.valid = true;
+
+    memcpy(mspFlightModeFlags, packed, sizeof(boxBitmask_t));
     // return count of used bits
-    return mspBoxIdx;
+    return activeBoxCount;
 }
 #endif // USE_OSD_SLAVE
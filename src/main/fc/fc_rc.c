@@ -22,12 +22,15 @@
 #include "platform.h"
 
 #include "build/debug.h"
+#include "build/trace.h"
 
 #include "common/maths.h"
 #include "common/axis.h"
 #include "common/utils.h"
 #include "common/filter.h"
 
+#include "drivers/time.h"
+
 #include "config/feature.h"
 #include "config/parameter_group.h"
 #include "config/parameter_group_ids.h"
@@ -50,12 +53,21 @@
 #include "flight/mixer.h"
 
 static float setpointRate[3], rcDeflection[3], rcDeflectionAbs[3];
+static float setpointRateDerivative[3];
 static float throttlePIDAttenuation;
 
 float getSetpointRate(int axis) {
     return setpointRate[axis];
 }
 
+static uint8_t rcSmoothingCutoffHz;     // 0 while the smoothing filter isn't in use
+static biquadFilter_t rcSmoothingFilter[4];
+static pt1Filter_t rcSmoothingDerivativeFilter[3];
+
+float getSetpointRateDerivative(int axis) {
+    return rcSmoothingCutoffHz ? rcSmoothingDerivativeFilter[axis].state : setpointRateDerivative[axis];
+}
+
 float getRcDeflection(int axis) {
     return rcDeflection[axis];
 }
@@ -97,7 +109,7 @@ int16_t rcLookupThrottle(int32_t tmp)
 #define SETPOINT_RATE_LIMIT 1998.0f
 #define RC_RATE_INCREMENTAL 14.54f
 
-static void calculateSetpointRate(int axis)
+static float applyRates(int axis, float rcCommandf, const float rcCommandfAbs)
 {
     uint8_t rcExpo;
     float rcRate;
@@ -112,11 +124,6 @@ static void calculateSetpointRate(int axis)
         rcRate += RC_RATE_INCREMENTAL * (rcRate - 2.0f);
     }
 
-    float rcCommandf = rcCommand[axis] / 500.0f;
-    rcDeflection[axis] = rcCommandf;
-    const float rcCommandfAbs = ABS(rcCommandf);
-    rcDeflectionAbs[axis] = rcCommandfAbs;
-
     if (rcExpo) {
         const float expof = rcExpo / 100.0f;
         rcCommandf = rcCommandf * power3(rcCommandfAbs) * expof + rcCommandf * (1-expof);
@@ -128,11 +135,111 @@ static void calculateSetpointRate(int axis)
         angleRate *= rcSuperfactor;
     }
 
+    return angleRate;
+}
+
+/*
+ * The rate curves are tabulated for the deflection of the stick and interpolated, the curve is the same in both
+ * directions. Towards full deflection super rate makes the curve bend more and more, from the first segment where
+ * the straight line misses the curve by more than RATE_CURVE_MAX_ERROR the rate is worked out exactly.
+ */
+#ifdef STM32F10X
+#define RATE_CURVE_SEGMENTS     32      // saves RAM, more of the curve is worked out exactly
+#else
+#define RATE_CURVE_SEGMENTS     64
+#endif
+#define RATE_CURVE_MAX_ERROR    0.25f   // deg/s
+
+typedef struct rateCurve_s {
+    float angleRate[RATE_CURVE_SEGMENTS + 1];
+    float exactFromDeflection;
+} rateCurve_t;
+
+static rateCurve_t rateCurves[3];
+static const controlRateConfig_t *rateCurvesProfile;
+static uint16_t rateCurvesGeneration;
+
+static void generateRateCurves(void)
+{
+    for (int axis = FD_ROLL; axis <= FD_YAW; axis++) {
+        rateCurve_t *curve = &rateCurves[axis];
+
+        for (int i = 0; i <= RATE_CURVE_SEGMENTS; i++) {
+            const float deflection = (float)i / RATE_CURVE_SEGMENTS;
+            curve->angleRate[i] = applyRates(axis, deflection, deflection);
+        }
+
+        curve->exactFromDeflection = 1.0f;
+        for (int i = 0; i < RATE_CURVE_SEGMENTS; i++) {
+            const float deflection = (i + 0.5f) / RATE_CURVE_SEGMENTS;
+            const float interpolated = (curve->angleRate[i] + curve->angleRate[i + 1]) / 2;
+            if (fabsf(applyRates(axis, deflection, deflection) - interpolated) > RATE_CURVE_MAX_ERROR) {
+                curve->exactFromDeflection = (float)i / RATE_CURVE_SEGMENTS;
+                break;
+            }
+        }
+    }
+}
+
+// Generate the curves again when another rate profile is in use, or the rates were changed
+static void updateRateCurves(void)
+{
+    const uint16_t generation = controlRateProfilesGeneration();
+    if (currentControlRateProfile != rateCurvesProfile || generation != rateCurvesGeneration) {
+        rateCurvesProfile = currentControlRateProfile;
+        rateCurvesGeneration = generation;
+        generateRateCurves();
+    }
+}
+
+static float lookupRates(int axis, float rcCommandf, const float rcCommandfAbs)
+{
+    const rateCurve_t *curve = &rateCurves[axis];
+    if (rcCommandfAbs >= curve->exactFromDeflection) {
+        return applyRates(axis, rcCommandf, rcCommandfAbs);
+    }
+
+    const float position = rcCommandfAbs * RATE_CURVE_SEGMENTS;
+    const int index = (int)position;
+    const float angleRate = curve->angleRate[index] + (position - index) * (curve->angleRate[index + 1] - curve->angleRate[index]);
+    return rcCommandf < 0 ? -angleRate : angleRate;
+}
+
+static void calculateSetpointRate(int axis)
+{
+    const float rcCommandf = rcCommand[axis] / 500.0f;
+    rcDeflection[axis] = rcCommandf;
+    const float rcCommandfAbs = ABS(rcCommandf);
+    rcDeflectionAbs[axis] = rcCommandfAbs;
+
+    const float angleRate = lookupRates(axis, rcCommandf, rcCommandfAbs);
+
     DEBUG_SET(DEBUG_ANGLERATE, axis, angleRate);
 
     setpointRate[axis] = constrainf(angleRate, -SETPOINT_RATE_LIMIT, SETPOINT_RATE_LIMIT); // Rate limit protection (deg/sec)
 }
 
+/*
+ * The setpoint only moves when an RX frame arrives, so its derivative is taken from frame to frame,
+ * over the nominal frame interval of the RX or the measured one when frames were missed. Interpolated
+ * or not, the setpoint covers that delta within one frame, so the derivative is held for the frame
+ * and dropped when the next frame is overdue.
+ */
+static void updateSetpointRateDerivative(uint16_t frameIntervalUs)
+{
+    static float previousFrameSetpointRate[3];
+    const float smoothing = currentPidProfile->feedForwardSmoothing / 100.0f;
+    const float frameRateHz = 1e6f / frameIntervalUs;
+
+    for (int axis = FD_ROLL; axis <= FD_YAW; axis++) {
+        const float rcCommandf = rcCommand[axis] / 500.0f;
+        const float frameSetpointRate = constrainf(lookupRates(axis, rcCommandf, ABS(rcCommandf)), -SETPOINT_RATE_LIMIT, SETPOINT_RATE_LIMIT);
+        const float derivative = (frameSetpointRate - previousFrameSetpointRate[axis]) * frameRateHz;
+        previousFrameSetpointRate[axis] = frameSetpointRate;
+        setpointRateDerivative[axis] = setpointRateDerivative[axis] * smoothing + derivative * (1.0f - smoothing);
+    }
+}
+
 static void scaleRcCommandToFpvCamAngle(void) {
     //recalculate sin/cos only when rxConfig()->fpvCamAngleDegrees changed
     static uint8_t lastFpvCamAngleDegrees = 0;
@@ -141,8 +248,7 @@ static void scaleRcCommandToFpvCamAngle(void) {
 
     if (lastFpvCamAngleDegrees != rxConfig()->fpvCamAngleDegrees) {
         lastFpvCamAngleDegrees = rxConfig()->fpvCamAngleDegrees;
-        cosFactor = cos_approx(rxConfig()->fpvCamAngleDegrees * RAD);
-        sinFactor = sin_approx(rxConfig()->fpvCamAngleDegrees * RAD);
+        sincos_approx(rxConfig()->fpvCamAngleDegrees * RAD, &sinFactor, &cosFactor);
     }
 
     float roll = setpointRate[ROLL];
@@ -151,6 +257,46 @@ static void scaleRcCommandToFpvCamAngle(void) {
     setpointRate[YAW]  = constrainf(yaw  * cosFactor + roll * sinFactor, -SETPOINT_RATE_LIMIT, SETPOINT_RATE_LIMIT);
 }
 
+#define RC_SMOOTHING_FILTER_Q 0.7071f         // butterworth
+#define RC_SMOOTHING_FILTER_MIN_HZ 10
+#define RC_SMOOTHING_FILTER_MAX_HZ 255
+
+/*
+ * Instead of interpolating, the smoothing filter runs the RC commands through a second order
+ * lowpass and the setpoint derivative through a first order one. The cutoff is half the measured
+ * frame rate, so the steps between frames are removed whatever the link runs at, with the least
+ * delay a fast link allows. It follows rate changes, with some hysteresis so jitter in the measured
+ * interval doesn't recalculate the filters on every frame.
+ */
+static void rcSmoothingFilterUpdate(uint16_t frameIntervalUs)
+{
+    const int maxCutoffHz = MIN(RC_SMOOTHING_FILTER_MAX_HZ, 1000000 / targetPidLooptime / 4);
+    const uint8_t cutoffHz = constrain(500000 / frameIntervalUs, RC_SMOOTHING_FILTER_MIN_HZ, maxCutoffHz);
+
+    if (rcSmoothingCutoffHz == 0) {
+        for (int channel = ROLL; channel <= THROTTLE; channel++) {
+            biquadFilterInit(&rcSmoothingFilter[channel], cutoffHz, targetPidLooptime, RC_SMOOTHING_FILTER_Q, FILTER_LPF);
+            // start settled on the current command, not ramping up from zero
+            biquadFilter_t *filter = &rcSmoothingFilter[channel];
+            filter->x1 = filter->x2 = filter->y1 = filter->y2 = rcCommand[channel];
+        }
+        for (int axis = FD_ROLL; axis <= FD_YAW; axis++) {
+            pt1FilterInit(&rcSmoothingDerivativeFilter[axis], cutoffHz, targetPidLooptime * 1e-6f);
+            rcSmoothingDerivativeFilter[axis].state = setpointRateDerivative[axis];
+        }
+    } else if (ABS(cutoffHz - rcSmoothingCutoffHz) > rcSmoothingCutoffHz / 10) {
+        for (int channel = ROLL; channel <= THROTTLE; channel++) {
+            biquadFilterUpdate(&rcSmoothingFilter[channel], cutoffHz, targetPidLooptime, RC_SMOOTHING_FILTER_Q, FILTER_LPF);
+        }
+        for (int axis = FD_ROLL; axis <= FD_YAW; axis++) {
+            pt1FilterInit(&rcSmoothingDerivativeFilter[axis], cutoffHz, targetPidLooptime * 1e-6f);
+        }
+    } else {
+        return;
+    }
+    rcSmoothingCutoffHz = cutoffHz;
+}
+
 #define THROTTLE_BUFFER_MAX 20
 #define THROTTLE_DELTA_MS 100
 
@@ -179,19 +325,58 @@ void processRcCommand(void)
     static float rcStepSize[4] = { 0, 0, 0, 0 };
     static int16_t rcInterpolationStepCount;
     static uint16_t currentRxRefreshRate;
+    static uint16_t feedForwardHoldCount;
     const uint8_t interpolationChannels = rxConfig()->rcInterpolationChannels + 2; //"RP", "RPY", "RPYT"
     uint16_t rxRefreshRate;
     bool readyToCalculateRate = false;
     uint8_t readyToCalculateRateAxisCnt = 0;
 
     if (isRXDataNew) {
-        currentRxRefreshRate = constrain(getTaskDeltaTime(TASK_RX),1000,20000);
+        // the interval measured between frame arrivals, the RX task interval until there is one
+        const timeDelta_t measuredFrameIntervalUs = rxGetFrameIntervalUs();
+        currentRxRefreshRate = constrain(measuredFrameIntervalUs ? measuredFrameIntervalUs : getTaskDeltaTime(TASK_RX), 1000, 20000);
         if (isAntiGravityModeActive()) {
             checkForThrottleErrorResetState(currentRxRefreshRate);
         }
+
+        updateRateCurves();
+
+        // rcCommand still holds the new frame here, before it is interpolated
+        const uint16_t frameIntervalUs = MAX(rxGetRefreshRate(), currentRxRefreshRate);
+        updateSetpointRateDerivative(frameIntervalUs);
+        feedForwardHoldCount = 2 * frameIntervalUs / targetPidLooptime;
+    } else if (feedForwardHoldCount > 0 && --feedForwardHoldCount == 0) {
+        for (int axis = FD_ROLL; axis <= FD_YAW; axis++) {
+            setpointRateDerivative[axis] = 0;
+        }
     }
 
-    if (rxConfig()->rcInterpolation) {
+    if (rxConfig()->rcInterpolation == RC_SMOOTHING_FILTER) {
+        static float rcCommandFrame[4];
+
+        if (isRXDataNew) {
+            for (int channel = ROLL; channel < interpolationChannels; channel++) {
+                rcCommandFrame[channel] = rcCommand[channel];
+            }
+            rcSmoothingFilterUpdate(currentRxRefreshRate);
+
+            DEBUG_SET(DEBUG_RC_INTERPOLATION, 0, lrintf(rcCommand[0]));
+            DEBUG_SET(DEBUG_RC_INTERPOLATION, 1, rcSmoothingCutoffHz);
+        }
+
+        // nothing to filter until the first frame has set the cutoff
+        if (rcSmoothingCutoffHz) {
+            for (int channel = ROLL; channel < interpolationChannels; channel++) {
+                rcCommand[channel] = biquadFilterApplyDF1(&rcSmoothingFilter[channel], rcCommandFrame[channel]);
+            }
+            for (int axis = FD_ROLL; axis <= FD_YAW; axis++) {
+                pt1FilterApply(&rcSmoothingDerivativeFilter[axis], setpointRateDerivative[axis]);
+            }
+            readyToCalculateRateAxisCnt = FD_YAW;
+            readyToCalculateRate = true;
+        }
+        rcInterpolationStepCount = 0;
+    } else if (rxConfig()->rcInterpolation) {
          // Set RC refresh rate for sampling and channels to filter
         switch (rxConfig()->rcInterpolation) {
             case(RC_SMOOTHING_AUTO):
@@ -207,18 +392,17 @@ void processRcCommand(void)
         }
 
         if (isRXDataNew && rxRefreshRate > 0) {
-            rcInterpolationStepCount = rxRefreshRate / targetPidLooptime;
+            // the next frame is due one interval after this one arrived, not after it is processed
+            const timeUs_t frameTimeUs = rxGetFrameTimeUs();
+            const timeDelta_t frameAgeUs = frameTimeUs ? constrain(cmpTimeUs(micros(), frameTimeUs), 0, rxRefreshRate / 2) : 0;
+            rcInterpolationStepCount = MAX((rxRefreshRate - frameAgeUs) / targetPidLooptime, 1);
 
             for (int channel=ROLL; channel < interpolationChannels; channel++) {
                 rcStepSize[channel] = (rcCommand[channel] - rcCommandInterp[channel]) / (float)rcInterpolationStepCount;
             }
 
-            if (debugMode == DEBUG_RC_INTERPOLATION) {
-                debug[0] = lrintf(rcCommand[0]);
-                debug[1] = lrintf(getTaskDeltaTime(TASK_RX) / 1000);
-                //debug[1] = lrintf(rcCommandInterp[0]);
-                //debug[1] = lrintf(rcStepSize[0]*100);
-            }
+            DEBUG_SET(DEBUG_RC_INTERPOLATION, 0, lrintf(rcCommand[0]));
+            DEBUG_SET(DEBUG_RC_INTERPOLATION, 1, lrintf(getTaskDeltaTime(TASK_RX) / 1000));
         } else {
             rcInterpolationStepCount--;
         }
@@ -235,6 +419,9 @@ void processRcCommand(void)
     } else {
         rcInterpolationStepCount = 0; // reset factor in case of level modes flip flopping
     }
+    if (rxConfig()->rcInterpolation != RC_SMOOTHING_FILTER) {
+        rcSmoothingCutoffHz = 0;    // settle the filters again when they are next used
+    }
 
     if (readyToCalculateRate || isRXDataNew) {
         if (isRXDataNew)
@@ -243,14 +430,18 @@ void processRcCommand(void)
         for (int axis = 0; axis <= readyToCalculateRateAxisCnt; axis++)
             calculateSetpointRate(axis);
 
-        if (debugMode == DEBUG_RC_INTERPOLATION) {
-            debug[2] = rcInterpolationStepCount;
-            debug[3] = setpointRate[0];
-        }
+        DEBUG_SET(DEBUG_RC_INTERPOLATION, 2, rcInterpolationStepCount);
+        DEBUG_SET(DEBUG_RC_INTERPOLATION, 3, setpointRate[0]);
         // Scaling of AngleRate to camera angle (Mixing Roll and Yaw)
         if (rxConfig()->fpvCamAngleDegrees && IS_RC_MODE_ACTIVE(BOXFPVANGLEMIX) && !FLIGHT_MODE(HEADFREE_MODE))
             scaleRcCommandToFpvCamAngle();
 
+#ifdef USE_CYCLE_TRACE
+        const uint32_t frameCycles = rxGetFrameCycles();
+        if (isRXDataNew && frameCycles) {
+            TRACE_SPAN(TRACE_RX_TO_SETPOINT, frameCycles);
+        }
+#endif
         isRXDataNew = false;
     }
 }
@@ -313,8 +504,8 @@ void updateRcCommands(void)
 
     if (FLIGHT_MODE(HEADFREE_MODE)) {
         const float radDiff = degreesToRadians(DECIDEGREES_TO_DEGREES(attitude.values.yaw) - headFreeModeHold);
-        const float cosDiff = cos_approx(radDiff);
-        const float sinDiff = sin_approx(radDiff);
+        float sinDiff, cosDiff;
+        sincos_approx(radDiff, &sinDiff, &cosDiff);
         const float rcCommand_PITCH = rcCommand[PITCH] * cosDiff + rcCommand[ROLL] * sinDiff;
         rcCommand[ROLL] = rcCommand[ROLL] * cosDiff - rcCommand[PITCH] * sinDiff;
         rcCommand[PITCH] = rcCommand_PITCH;
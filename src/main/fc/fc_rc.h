@@ -18,9 +18,11 @@
 
 void processRcCommand(void);
 float getSetpointRate(int axis);
+float getSetpointRateDerivative(int axis);
 float getRcDeflection(int axis);
 float getRcDeflectionAbs(int axis);
 float getThrottlePIDAttenuation(void);
 void updateRcCommands(void);
 void resetYawAxis(void);
 void generateThrottleCurve(void);
+int16_t rcLookupThrottle(int32_t tmp);
@@ -18,9 +18,12 @@
 #include <stdbool.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <math.h>
 
 #include <platform.h>
 
+#include "blackbox/blackbox.h"
+
 #include "cms/cms.h"
 
 #include "build/debug.h"
@@ -87,6 +90,11 @@
 #include "io/osd_slave.h"
 #include "io/rcsplit.h"
 
+#if defined(USE_GYRO_ISR_UPDATE) && !defined(SIMULATOR_BUILD)
+#include "build/atomic.h"
+#include "drivers/nvic.h"
+#endif
+
 #ifdef USE_BST
 void taskBstMasterProcess(timeUs_t currentTimeUs);
 #endif
@@ -104,11 +112,13 @@ static void taskUpdateAccelerometer(timeUs_t currentTimeUs)
 }
 #endif
 
+// Ports that can't signal received data, like a UART with RX DMA on F1, are still looked at this often
+#define TASK_SERIAL_IDLE_POLL_PERIOD_US TASK_PERIOD_HZ(10)
+
 bool taskSerialCheck(timeUs_t currentTimeUs, timeDelta_t currentDeltaTimeUs) {
     UNUSED(currentTimeUs);
-    UNUSED(currentDeltaTimeUs);
 
-    return mspSerialWaiting();
+    return serialCheckRxEvent() || currentDeltaTimeUs >= TASK_SERIAL_IDLE_POLL_PERIOD_US;
 }
 
 static void taskHandleSerial(timeUs_t currentTimeUs)
@@ -118,6 +128,8 @@ static void taskHandleSerial(timeUs_t currentTimeUs)
     // in cli mode, all serial stuff goes to here. enter cli mode by sending #
     if (cliMode) {
         cliProcess();
+        // The CLI sends what it printed at the start of its next run, so keep it running
+        serialSignalRxEvent();
         return;
     }
 #endif
@@ -127,6 +139,11 @@ static void taskHandleSerial(timeUs_t currentTimeUs)
     bool evaluateMspData = osdSlaveIsLocked ?  MSP_SKIP_NON_MSP_DATA : MSP_EVALUATE_NON_MSP_DATA;;
 #endif
     mspSerialProcess(evaluateMspData, mspFcProcessCommand, mspFcProcessReply);
+
+    // One call handles a frame per port, run again straight away if there is more
+    if (mspSerialWaiting()) {
+        serialSignalRxEvent();
+    }
 }
 
 void taskBatteryAlerts(timeUs_t currentTimeUs)
@@ -143,14 +160,43 @@ void taskBatteryAlerts(timeUs_t currentTimeUs)
 }
 
 #ifndef USE_OSD_SLAVE
+static uint8_t gyroPidTaskDenom = 1;
+static float gyroPidTaskClockScale = 1.0f;
+
+// the loop keeps pace with the gyro, so its period is on the gyro's sample clock rather than the nominal one
+static uint32_t gyroPidTaskPeriod(void)
+{
+    return lrintf(gyro.targetLooptime * gyroPidTaskClockScale * gyroPidTaskDenom);
+}
+
+// once the gyro has measured its sample clock, which it only does while disarmed, the PID controller and the loop follow it
+static void followGyroSampleClock(void)
+{
+    const float scale = gyroSampleClockScale();
+    if (scale != gyroPidTaskClockScale && !ARMING_FLAG(ARMED)) {
+        gyroPidTaskClockScale = scale;
+        pidInit(currentPidProfile);
+        rescheduleTask(TASK_GYROPID, gyroPidTaskPeriod());
+    }
+}
+
 static void taskUpdateRxMain(timeUs_t currentTimeUs)
 {
     processRx(currentTimeUs);
     isRXDataNew = true;
 
+    followGyroSampleClock();
+
 #if !defined(BARO) && !defined(SONAR)
     // updateRcCommands sets rcCommand, which is needed by updateAltHoldState and updateSonarAltHoldState
+#if defined(USE_GYRO_ISR_UPDATE) && !defined(SIMULATOR_BUILD)
+    // rcCommand is read by the mixer, which may run from the gyro data ready interrupt
+    ATOMIC_BLOCK(NVIC_PRIO_MPU_INT_EXTI) {
+        updateRcCommands();
+    }
+#else
     updateRcCommands();
+#endif
 #endif
     updateArmingStatus();
 
@@ -206,6 +252,15 @@ static void taskCalculateAltitude(timeUs_t currentTimeUs)
     }}
 #endif
 
+#ifdef BLACKBOX
+static void taskBlackbox(timeUs_t currentTimeUs)
+{
+    if (!cliMode && blackboxConfig()->device) {
+        blackboxUpdate(currentTimeUs);
+    }
+}
+#endif
+
 #ifdef TELEMETRY
 static void taskTelemetry(timeUs_t currentTimeUs)
 {
@@ -273,7 +328,12 @@ void fcTasksInit(void)
     schedulerInit();
 
     if (sensors(SENSOR_GYRO)) {
-        rescheduleTask(TASK_GYROPID, gyro.targetLooptime);
+        if (gyroConfig()->gyro_isr_update && mainPidLoopIsrInit()) {
+            // the PID loop runs from the gyro interrupt, the task only has to run the subprocesses once per PID update
+            gyroPidTaskDenom = pidConfig()->pid_process_denom;
+        }
+        gyroPidTaskClockScale = gyroSampleClockScale();
+        rescheduleTask(TASK_GYROPID, gyroPidTaskPeriod());
         setTaskEnabled(TASK_GYROPID, true);
     }
 
@@ -295,12 +355,17 @@ void fcTasksInit(void)
     setTaskEnabled(TASK_BATTERY_ALERTS, (useBatteryVoltage || useBatteryCurrent) && useBatteryAlerts);
 
     setTaskEnabled(TASK_RX, true);
+    // a signalled frame is processed as soon as the PID loop allows, instead of waiting for its priority to grow
+    setTaskEventDeadline(TASK_RX, rxFrameEventSchedulingEnabled());
 
     setTaskEnabled(TASK_DISPATCH, dispatchIsEnabled());
 
 #ifdef BEEPER
     setTaskEnabled(TASK_BEEPER, true);
 #endif
+#ifdef BLACKBOX
+    setTaskEnabled(TASK_BLACKBOX, true);
+#endif
 #ifdef GPS
     setTaskEnabled(TASK_GPS, feature(FEATURE_GPS));
 #endif
@@ -417,12 +482,12 @@ cfTask_t cfTasks[TASK_COUNT] = {
     [TASK_SERIAL] = {
         .taskName = "SERIAL",
         .taskFunc = taskHandleSerial,
+        .checkFunc = taskSerialCheck,               // runs when data has been received
 #ifdef USE_OSD_SLAVE
-        .checkFunc = taskSerialCheck,
         .desiredPeriod = TASK_PERIOD_HZ(100),
         .staticPriority = TASK_PRIORITY_REALTIME,
 #else
-        .desiredPeriod = TASK_PERIOD_HZ(100),       // 100 Hz should be enough to flush up to 115 bytes @ 115200 baud
+        .desiredPeriod = TASK_PERIOD_HZ(100),       // how fast the priority of a waiting run grows
         .staticPriority = TASK_PRIORITY_LOW,
 #endif
     },
@@ -466,6 +531,16 @@ cfTask_t cfTasks[TASK_COUNT] = {
     },
 #endif
 
+#ifdef BLACKBOX
+    [TASK_BLACKBOX] = {
+        .taskName = "BLACKBOX",
+        .checkFunc = blackboxUpdateCheck,
+        .taskFunc = taskBlackbox,
+        .desiredPeriod = TASK_PERIOD_HZ(1000),      // If event-based scheduling doesn't work, fallback to periodic scheduling
+        .staticPriority = TASK_PRIORITY_MEDIUM,
+    },
+#endif
+
 #ifdef GPS
     [TASK_GPS] = {
         .taskName = "GPS",
@@ -481,6 +556,7 @@ cfTask_t cfTasks[TASK_COUNT] = {
         .taskFunc = taskUpdateCompass,
         .desiredPeriod = TASK_PERIOD_HZ(10),        // Compass is updated at 10 Hz
         .staticPriority = TASK_PRIORITY_LOW,
+        .sheddable = true,
     },
 #endif
 
@@ -526,16 +602,24 @@ cfTask_t cfTasks[TASK_COUNT] = {
     [TASK_DASHBOARD] = {
         .taskName = "DASHBOARD",
         .taskFunc = dashboardUpdate,
-        .desiredPeriod = TASK_PERIOD_HZ(10),
+        .desiredPeriod = TASK_PERIOD_HZ(100),   // pages are drawn at 5Hz, the runs in between send them to the display
         .staticPriority = TASK_PRIORITY_LOW,
+        .sheddable = true,
     },
 #endif
 #ifdef OSD
     [TASK_OSD] = {
         .taskName = "OSD",
+#ifdef MAX7456_VSYNC_PIN
+        .checkFunc = osdUpdateCheck,                // runs at the start of each video field
+#endif
         .taskFunc = osdUpdate,
-        .desiredPeriod = TASK_PERIOD_HZ(60),        // 60 Hz
+        .desiredPeriod = TASK_PERIOD_HZ(OSD_TASK_FREQUENCY_HZ), // 60 Hz
+#ifdef MAX7456_VSYNC_PIN
+        .staticPriority = TASK_PRIORITY_HIGH,       // the screen can only be sent during vertical blanking
+#else
         .staticPriority = TASK_PRIORITY_LOW,
+#endif
     },
 #endif
 #endif
@@ -557,6 +641,7 @@ cfTask_t cfTasks[TASK_COUNT] = {
         .taskFunc = taskTelemetry,
         .desiredPeriod = TASK_PERIOD_HZ(250),       // 250 Hz, 4ms
         .staticPriority = TASK_PRIORITY_LOW,
+        .sheddable = true,
     },
 #endif
 
@@ -566,6 +651,7 @@ cfTask_t cfTasks[TASK_COUNT] = {
         .taskFunc = ledStripUpdate,
         .desiredPeriod = TASK_PERIOD_HZ(100),       // 100 Hz, 10ms
         .staticPriority = TASK_PRIORITY_LOW,
+        .sheddable = true,
     },
 #endif
 
@@ -582,7 +668,8 @@ cfTask_t cfTasks[TASK_COUNT] = {
     [TASK_ESC_SENSOR] = {
         .taskName = "ESC_SENSOR",
         .taskFunc = escSensorProcess,
-        .desiredPeriod = TASK_PERIOD_HZ(100),       // 100 Hz, 10ms
+        .checkFunc = escSensorCheck,                // runs when a frame is in or the request has timed out
+        .desiredPeriod = TASK_PERIOD_HZ(1000),      // how fast the priority of a waiting run grows
         .staticPriority = TASK_PRIORITY_LOW,
     },
 #endif
@@ -611,6 +698,7 @@ cfTask_t cfTasks[TASK_COUNT] = {
         .taskFunc = taskVtxControl,
         .desiredPeriod = TASK_PERIOD_HZ(5),          // 5 Hz, 200ms
         .staticPriority = TASK_PRIORITY_IDLE,
+        .sheddable = true,
     },
 #endif
 
@@ -632,4 +720,14 @@ cfTask_t cfTasks[TASK_COUNT] = {
     },
 #endif
 #endif
+
+#ifdef USE_ASYNC_CONFIG_SAVE
+    // Enabled while a save is being written
+    [TASK_CONFIG_SAVE] = {
+        .taskName = "CONFIGSAVE",
+        .taskFunc = configSaveUpdate,
+        .desiredPeriod = TASK_PERIOD_HZ(100),       // 100 Hz, 10ms
+        .staticPriority = TASK_PRIORITY_LOW,
+    },
+#endif
 };
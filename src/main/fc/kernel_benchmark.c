@@ -0,0 +1,258 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "platform.h"
+
+#ifdef USE_KERNEL_BENCHMARK
+
+#include "blackbox/blackbox_encoding.h"
+#include "blackbox/blackbox_io.h"
+
+#include "common/axis.h"
+#include "common/filter.h"
+#include "common/maths.h"
+#include "common/utils.h"
+
+#include "drivers/pwm_output.h"
+#include "drivers/system.h"
+#include "drivers/time.h"
+
+#include "fc/config.h"
+#include "fc/kernel_benchmark.h"
+
+#include "flight/mixer.h"
+#include "flight/pid.h"
+
+#include "sensors/acceleration.h"
+#include "sensors/gyro.h"
+#include "sensors/gyroanalyse.h"
+
+/*
+ * Times single calls of the hot path kernels with the cycle counter, so the cost of a change to one
+ * of them can be seen on the target itself rather than through the load of the whole loop. Unlike
+ * loop_benchmark.c every call is timed on its own, the spread from min to max shows the branches
+ * and flash wait states a kernel hits. A call that is interrupted is counted with the interrupt,
+ * which mostly shows in the max.
+ */
+
+#define KERNEL_BENCHMARK_ITERATIONS 512
+#define KERNEL_BENCHMARK_WARMUP 32
+#define KERNEL_BENCHMARK_SAMPLE_COUNT 64    // power of 2
+#define KERNEL_BENCHMARK_BLACKBOX_VALUES 8
+#define KERNEL_BENCHMARK_BLACKBOX_BYTES (1 + KERNEL_BENCHMARK_BLACKBOX_VALUES * 5) // tag and worst case 5 byte VBs
+
+typedef void kernelBenchmarkFn_t(int iteration);
+
+typedef struct kernelBenchmark_s {
+    const char *name;
+    kernelBenchmarkFn_t *fn;
+    bool (*available)(void);    // NULL if the kernel can always run
+} kernelBenchmark_t;
+
+static int16_t benchmarkSamples[KERNEL_BENCHMARK_SAMPLE_COUNT][XYZ_AXIS_COUNT];
+static pt1Filter_t benchmarkPt1Filter;
+static biquadFilter_t benchmarkBiquadFilter;
+static biquadFilterXyz_t benchmarkBiquadFilterXyz;
+static timeUs_t benchmarkTimeUs;
+static volatile float benchmarkResult; // keeps the compiler from dropping the filter calls
+
+// noisy samples, so the filters see data like that from a spinning motor
+static void benchmarkInitSamples(void)
+{
+    uint32_t seed = 0x12345678;
+    for (int i = 0; i < KERNEL_BENCHMARK_SAMPLE_COUNT; i++) {
+        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            seed = seed * 1664525 + 1013904223;
+            benchmarkSamples[i][axis] = (int16_t)((seed >> 16) & 0x3ff) - 0x200;
+        }
+    }
+}
+
+static const int16_t *benchmarkSample(int iteration)
+{
+    return benchmarkSamples[iteration & (KERNEL_BENCHMARK_SAMPLE_COUNT - 1)];
+}
+
+static void benchmarkPt1(int iteration)
+{
+    benchmarkResult = pt1FilterApply(&benchmarkPt1Filter, benchmarkSample(iteration)[X]);
+}
+
+static void benchmarkBiquad(int iteration)
+{
+    benchmarkResult = biquadFilterApply(&benchmarkBiquadFilter, benchmarkSample(iteration)[X]);
+}
+
+static void benchmarkBiquadXyz(int iteration)
+{
+    const int16_t *sample = benchmarkSample(iteration);
+    float values[XYZ_AXIS_COUNT] = { sample[X], sample[Y], sample[Z] };
+    biquadFilterXyzApply(&benchmarkBiquadFilterXyz, values);
+    benchmarkResult = values[X];
+}
+
+// the configured gyro filter chain, from the sample to gyro.gyroADCf
+static void benchmarkGyro(int iteration)
+{
+    gyroSetSyntheticSample(benchmarkSample(iteration));
+    gyroUpdate();
+}
+
+static void benchmarkPid(int iteration)
+{
+    UNUSED(iteration);
+    pidController(currentPidProfile, &accelerometerConfig()->accelerometerTrims, benchmarkTimeUs);
+}
+
+static void benchmarkMixer(int iteration)
+{
+    UNUSED(iteration);
+    mixTable(currentPidProfile->vbatPidCompensation);
+}
+
+#ifdef BLACKBOX
+// the encoded bytes are taken out of the frame buffer again, so nothing reaches the log
+static void benchmarkBlackbox(int iteration)
+{
+    const int16_t *sample = benchmarkSample(iteration);
+    int32_t values[KERNEL_BENCHMARK_BLACKBOX_VALUES];
+    for (int i = 0; i < KERNEL_BENCHMARK_BLACKBOX_VALUES; i++) {
+        values[i] = sample[i % XYZ_AXIS_COUNT] >> (i & 7);
+    }
+    unsigned mark;
+    blackboxFrameBufferMark(&mark, 0);
+    blackboxWriteTag8_8SVB(values, KERNEL_BENCHMARK_BLACKBOX_VALUES);
+    blackboxFrameBufferRewind(mark);
+}
+
+static bool benchmarkBlackboxAvailable(void)
+{
+    unsigned mark;
+    return blackboxFrameBufferMark(&mark, KERNEL_BENCHMARK_BLACKBOX_BYTES);
+}
+#endif
+
+#ifdef USE_GYRO_DATA_ANALYSE
+static biquadFilterXyz_t benchmarkNotchFilterDyn[GYRO_DYN_NOTCH_COUNT_MAX];
+
+// one step of the FFT state machine per call, so the min and max are those of the cheapest and dearest step
+static void benchmarkFft(int iteration)
+{
+    UNUSED(iteration);
+    gyroDataAnalyseUpdate(benchmarkNotchFilterDyn);
+}
+#endif
+
+#ifdef USE_DSHOT
+static void benchmarkDshot(int iteration)
+{
+    static motorDmaOutput_t motor;
+    motor.requestTelemetry = iteration & 1;
+    benchmarkResult = prepareDshotPacket(&motor, DSHOT_MIN_THROTTLE + (iteration & 0x3ff));
+}
+#endif
+
+static const kernelBenchmark_t kernelBenchmarks[] = {
+    { "pt1", benchmarkPt1, NULL },
+    { "biquad", benchmarkBiquad, NULL },
+    { "biquadxyz", benchmarkBiquadXyz, NULL },
+    { "gyro", benchmarkGyro, NULL },
+    { "pid", benchmarkPid, NULL },
+    { "mixer", benchmarkMixer, NULL },
+#ifdef BLACKBOX
+    { "blackbox", benchmarkBlackbox, benchmarkBlackboxAvailable },
+#endif
+#ifdef USE_GYRO_DATA_ANALYSE
+    { "fft", benchmarkFft, isDynamicFilterActive },
+#endif
+#ifdef USE_DSHOT
+    { "dshot", benchmarkDshot, NULL },
+#endif
+};
+
+STATIC_ASSERT(ARRAYLEN(kernelBenchmarks) <= KERNEL_BENCHMARK_MAX_RESULTS, kernel_benchmark_results_too_small);
+
+// the cost of reading the cycle counter twice, taken off every timed call
+static uint32_t benchmarkOverhead(void)
+{
+    uint32_t overhead = UINT32_MAX;
+    for (int i = 0; i < KERNEL_BENCHMARK_WARMUP; i++) {
+        const uint32_t startCycles = getCycleCounter();
+        overhead = MIN(overhead, getCycleCounter() - startCycles);
+    }
+    return overhead;
+}
+
+static void benchmarkKernel(kernelBenchmarkResult_t *result, const kernelBenchmark_t *kernel, uint32_t overhead)
+{
+    for (int i = 0; i < KERNEL_BENCHMARK_WARMUP; i++) {
+        kernel->fn(i);
+    }
+
+    uint32_t minCycles = UINT32_MAX;
+    uint32_t maxCycles = 0;
+    uint32_t totalCycles = 0;
+    for (int i = 0; i < KERNEL_BENCHMARK_ITERATIONS; i++) {
+        const uint32_t startCycles = getCycleCounter();
+        kernel->fn(i);
+        const uint32_t cycles = getCycleCounter() - startCycles;
+        minCycles = MIN(minCycles, cycles);
+        maxCycles = MAX(maxCycles, cycles);
+        totalCycles += cycles;
+    }
+
+    const uint32_t avgCycles = (totalCycles + KERNEL_BENCHMARK_ITERATIONS / 2) / KERNEL_BENCHMARK_ITERATIONS;
+    result->name = kernel->name;
+    result->minCycles = minCycles > overhead ? minCycles - overhead : 0;
+    result->avgCycles = avgCycles > overhead ? avgCycles - overhead : 0;
+    result->maxCycles = maxCycles > overhead ? maxCycles - overhead : 0;
+}
+
+int kernelBenchmarkRun(kernelBenchmarkResult_t *results)
+{
+    const uint32_t looptimeUs = gyro.targetLooptime;
+    int count = 0;
+
+    benchmarkInitSamples();
+    pt1FilterInit(&benchmarkPt1Filter, 100, looptimeUs * 1e-6f);
+    biquadFilterInitLPF(&benchmarkBiquadFilter, 100, looptimeUs);
+    biquadFilterXyzInitLPF(&benchmarkBiquadFilterXyz, 100, looptimeUs);
+    benchmarkTimeUs = micros();
+    gyroSyntheticBegin();
+
+    const uint32_t overhead = benchmarkOverhead();
+    for (unsigned i = 0; i < ARRAYLEN(kernelBenchmarks); i++) {
+        const kernelBenchmark_t *kernel = &kernelBenchmarks[i];
+        if (!kernel->available || kernel->available()) {
+            benchmarkKernel(&results[count++], kernel, overhead);
+        }
+    }
+
+    // clear the state built up from the synthetic data
+    gyroInitFilters();
+    pidInit(currentPidProfile);
+    pidResetErrorGyroState();
+
+    gyroSyntheticEnd();
+
+    return count;
+}
+
+#endif
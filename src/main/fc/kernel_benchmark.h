@@ -0,0 +1,30 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#define KERNEL_BENCHMARK_MAX_RESULTS 9
+
+typedef struct kernelBenchmarkResult_s {
+    const char *name;
+    uint32_t minCycles;         // cycles per call, less the cost of reading the cycle counter
+    uint32_t avgCycles;
+    uint32_t maxCycles;
+} kernelBenchmarkResult_t;
+
+// Must only be called while disarmed. Returns the number of results filled in.
+int kernelBenchmarkRun(kernelBenchmarkResult_t *results);
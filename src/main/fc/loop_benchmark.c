@@ -0,0 +1,174 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "platform.h"
+
+#ifdef USE_LOOP_BENCHMARK
+
+#include "common/axis.h"
+#include "common/utils.h"
+
+#include "drivers/system.h"
+#include "drivers/time.h"
+
+#include "fc/config.h"
+#include "fc/loop_benchmark.h"
+
+#include "flight/mixer.h"
+#include "flight/pid.h"
+
+#include "sensors/acceleration.h"
+#include "sensors/gyro.h"
+
+/*
+ * Runs the real gyro filter chain, PID controller and mixer against synthetic gyro data, for each
+ * gyro rate the hardware can be configured to, so the CPU budget of a loop rate can be checked
+ * before flying it. The measured cycles include any interrupts taken while benchmarking, so
+ * they slightly overestimate. Motor output is not included.
+ */
+
+#define LOOP_BENCHMARK_ITERATIONS 1000
+#define LOOP_BENCHMARK_WARMUP 100
+#define LOOP_BENCHMARK_SAMPLE_COUNT 64  // power of 2
+
+const uint8_t loopBenchmarkDenoms[LOOP_BENCHMARK_DENOM_COUNT] = { 1, 2, 4, 8 };
+
+static int16_t benchmarkSamples[LOOP_BENCHMARK_SAMPLE_COUNT][XYZ_AXIS_COUNT];
+
+// noisy samples, so the filters see data like that from a spinning motor
+static void benchmarkInitSamples(void)
+{
+    uint32_t seed = 0x12345678;
+    for (int i = 0; i < LOOP_BENCHMARK_SAMPLE_COUNT; i++) {
+        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            seed = seed * 1664525 + 1013904223;
+            benchmarkSamples[i][axis] = (int16_t)((seed >> 16) & 0x3ff) - 0x200;
+        }
+    }
+}
+
+static void benchmarkGyroUpdate(int iteration)
+{
+    gyroSetSyntheticSample(benchmarkSamples[iteration & (LOOP_BENCHMARK_SAMPLE_COUNT - 1)]);
+    gyroUpdate();
+}
+
+static uint32_t benchmarkGyro(void)
+{
+    for (int i = 0; i < LOOP_BENCHMARK_WARMUP; i++) {
+        benchmarkGyroUpdate(i);
+    }
+    const timeUs_t startTimeUs = micros();
+    for (int i = 0; i < LOOP_BENCHMARK_ITERATIONS; i++) {
+        benchmarkGyroUpdate(i);
+    }
+    return cmpTimeUs(micros(), startTimeUs);
+}
+
+static uint32_t benchmarkPid(void)
+{
+    for (int i = 0; i < LOOP_BENCHMARK_WARMUP; i++) {
+        benchmarkGyroUpdate(i);
+        pidController(currentPidProfile, &accelerometerConfig()->accelerometerTrims, micros());
+    }
+    const timeUs_t startTimeUs = micros();
+    for (int i = 0; i < LOOP_BENCHMARK_ITERATIONS; i++) {
+        pidController(currentPidProfile, &accelerometerConfig()->accelerometerTrims, startTimeUs);
+    }
+    return cmpTimeUs(micros(), startTimeUs);
+}
+
+static uint32_t benchmarkMixer(void)
+{
+    const uint8_t vbatPidCompensation = currentPidProfile->vbatPidCompensation;
+    for (int i = 0; i < LOOP_BENCHMARK_WARMUP; i++) {
+        mixTable(vbatPidCompensation);
+    }
+    const timeUs_t startTimeUs = micros();
+    for (int i = 0; i < LOOP_BENCHMARK_ITERATIONS; i++) {
+        mixTable(vbatPidCompensation);
+    }
+    return cmpTimeUs(micros(), startTimeUs);
+}
+
+static uint32_t benchmarkCyclesPerCall(uint32_t elapsedUs)
+{
+    return (elapsedUs * getCyclesPerMicrosecond() + LOOP_BENCHMARK_ITERATIONS / 2) / LOOP_BENCHMARK_ITERATIONS;
+}
+
+static void benchmarkLooptime(loopBenchmarkResult_t *result, bool use32kHz, uint8_t gyroSyncDenom)
+{
+    // same sample periods as gyroSetSampleRate()
+    const float gyroSamplePeriod = use32kHz ? 31.5f : 125.0f;
+    const uint32_t looptimeUs = (uint32_t)(gyroSyncDenom * gyroSamplePeriod);
+
+    gyro.targetLooptime = looptimeUs;
+    gyro.sampleLooptime = looptimeUs;
+    gyroInitFilters();
+    // the PID filters cost the same at any rate, so the PID controller is measured at the gyro rate
+    pidSetTargetLooptime(looptimeUs);
+    pidInitFilters(currentPidProfile);
+
+    result->gyroLooptimeUs = looptimeUs;
+    result->gyroSyncDenom = gyroSyncDenom;
+    result->gyroUse32kHz = use32kHz;
+    result->gyroCycles = benchmarkCyclesPerCall(benchmarkGyro());
+    result->pidCycles = benchmarkCyclesPerCall(benchmarkPid());
+    result->mixerCycles = benchmarkCyclesPerCall(benchmarkMixer());
+
+    // the gyro is updated every loop, the PID controller and mixer every pid_process_denom loops
+    const uint32_t cyclesPerLoop = looptimeUs * getCyclesPerMicrosecond();
+    for (int i = 0; i < LOOP_BENCHMARK_DENOM_COUNT; i++) {
+        const uint32_t cycles = result->gyroCycles + (result->pidCycles + result->mixerCycles) / loopBenchmarkDenoms[i];
+        result->loadPercent[i] = (cycles * 100 + cyclesPerLoop / 2) / cyclesPerLoop;
+    }
+}
+
+int loopBenchmarkRun(loopBenchmarkResult_t *results)
+{
+    const uint32_t gyroTargetLooptime = gyro.targetLooptime;
+    const float gyroSampleLooptime = gyro.sampleLooptime;
+    int count = 0;
+
+    benchmarkInitSamples();
+    gyroSyntheticBegin();
+
+    for (int i = 0; i < LOOP_BENCHMARK_DENOM_COUNT; i++) {
+        benchmarkLooptime(&results[count++], false, loopBenchmarkDenoms[i]);
+    }
+    if (gyroSupports32kHz()) {
+        for (int i = 0; i < LOOP_BENCHMARK_DENOM_COUNT; i++) {
+            benchmarkLooptime(&results[count++], true, loopBenchmarkDenoms[i]);
+        }
+    }
+
+    // restore the configured loop and clear the state built up from the synthetic data
+    gyro.targetLooptime = gyroTargetLooptime;
+    gyro.sampleLooptime = gyroSampleLooptime;
+    gyroInitFilters();
+    pidInit(currentPidProfile);
+    pidResetErrorGyroState();
+
+    gyroSyntheticEnd();
+
+    return count;
+}
+
+#endif
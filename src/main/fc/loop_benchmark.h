@@ -0,0 +1,37 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#define LOOP_BENCHMARK_DENOM_COUNT 4
+#define LOOP_BENCHMARK_MAX_RESULTS (2 * LOOP_BENCHMARK_DENOM_COUNT)  // 8kHz and 32kHz sampling
+
+// the gyro_sync_denom and pid_process_denom values that are benchmarked
+extern const uint8_t loopBenchmarkDenoms[LOOP_BENCHMARK_DENOM_COUNT];
+
+typedef struct loopBenchmarkResult_s {
+    uint16_t gyroLooptimeUs;
+    uint8_t gyroSyncDenom;
+    bool gyroUse32kHz;
+    uint32_t gyroCycles;        // cycles per gyroUpdate()
+    uint32_t pidCycles;         // cycles per pidController()
+    uint32_t mixerCycles;       // cycles per mixTable()
+    uint16_t loadPercent[LOOP_BENCHMARK_DENOM_COUNT]; // projected gyro/PID loop load, for each pid_process_denom
+} loopBenchmarkResult_t;
+
+// Must only be called while disarmed. Returns the number of results filled in.
+int loopBenchmarkRun(loopBenchmarkResult_t *results);
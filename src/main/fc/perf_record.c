@@ -0,0 +1,191 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "platform.h"
+
+#ifdef USE_PERF_RECORD
+
+#include "blackbox/blackbox.h"
+
+#include "common/maths.h"
+#include "common/utils.h"
+
+#include "config/parameter_group.h"
+#include "config/parameter_group_ids.h"
+
+#include "drivers/bus_i2c.h"
+#include "drivers/bus_spi.h"
+#include "drivers/sdcard.h"
+#include "drivers/serial.h"
+#include "drivers/serial_uart.h"
+
+#include "fc/config.h"
+#include "fc/fc_dispatch.h"
+#include "fc/perf_record.h"
+#include "fc/runtime_config.h"
+
+#include "scheduler/scheduler.h"
+
+#include "sensors/gyro.h"
+
+/*
+ * The counters the drivers keep since power up are taken on arming and again on disarming, the
+ * difference is what the flight added, and the peaks are followed while flying. The record is kept
+ * with the configuration, so a board that has started to lose timing shows it over MSP however often
+ * it has been powered since. It is only saved on disarming when the flight had errors or set a new
+ * worst, so a healthy board does not write its flash after every flight, the flight count then goes
+ * out with the next save.
+ */
+
+#define PERF_RECORD_UPDATE_PERIOD_US    100000  // the system load is worked out at 10Hz
+
+PG_REGISTER(perfRecord_t, perfRecord, PG_PERF_RECORD, 0);
+
+typedef struct perfCounters_s {
+    uint32_t uartOverruns;
+    uint32_t spiErrors;
+    uint32_t i2cErrors;
+    uint32_t gyroOverflows;
+#ifdef USE_TASK_STATISTICS_HISTOGRAM
+    uint32_t missedLoopPeriods;
+    uint32_t loopLateness[TASK_HISTOGRAM_BUCKET_COUNT];
+#endif
+} perfCounters_t;
+
+static perfCounters_t countersAtArm;
+static uint16_t peakSystemLoadPercent;
+static bool flying;
+
+static uint16_t saturatedU16(uint32_t value)
+{
+    return MIN(value, UINT16_MAX);
+}
+
+static void perfCountersRead(perfCounters_t *counters)
+{
+    memset(counters, 0, sizeof(*counters));
+#if defined(USE_UART) && !defined(SITL)
+    counters->uartOverruns = uartGetOverrunCounter();
+#endif
+#ifdef USE_SPI
+    for (int device = 0; device < SPIDEV_COUNT; device++) {
+        counters->spiErrors += spiGetErrorCounter(spiInstanceByDevice(device));
+    }
+#endif
+#ifdef USE_I2C
+    counters->i2cErrors = i2cGetErrorCounter();
+#endif
+    counters->gyroOverflows = gyroGetOverflowCount();
+#ifdef USE_TASK_STATISTICS_HISTOGRAM
+    cfTaskHistogram_t histogram;
+    if (getTaskHistogram(TASK_GYROPID, &histogram)) {
+        counters->missedLoopPeriods = histogram.missedPeriods;
+        memcpy(counters->loopLateness, histogram.lateness, sizeof(counters->loopLateness));
+    }
+#endif
+}
+
+static void perfRecordUpdate(dispatchEntry_t *self)
+{
+    if (!flying) {
+        return;
+    }
+    peakSystemLoadPercent = MAX(peakSystemLoadPercent, averageSystemLoadPercent);
+    dispatchAdd(self, PERF_RECORD_UPDATE_PERIOD_US);
+}
+
+static dispatchEntry_t perfRecordDispatch = { .dispatch = perfRecordUpdate };
+
+void perfRecordArmed(void)
+{
+    perfCountersRead(&countersAtArm);
+    peakSystemLoadPercent = averageSystemLoadPercent;
+    flying = true;
+    dispatchEnable();
+    dispatchAdd(&perfRecordDispatch, PERF_RECORD_UPDATE_PERIOD_US);
+}
+
+static bool perfFlightHasErrors(const perfFlightStats_t *flight)
+{
+    return flight->missedLoopPeriods || flight->uartOverruns || flight->spiErrors || flight->i2cErrors
+        || flight->blackboxDroppedFrames || flight->gyroOverflows;
+}
+
+// Adds the flight to the record, returns true if it had errors or is worse than the flights before in any way
+bool perfRecordAddFlight(perfRecord_t *record, const perfFlightStats_t *flight)
+{
+    const bool hasErrors = perfFlightHasErrors(flight);
+    record->flights = MIN(record->flights + 1, UINT16_MAX);
+    if (hasErrors) {
+        record->flightsWithErrors = MIN(record->flightsWithErrors + 1, UINT16_MAX);
+    }
+    record->lastFlight = *flight;
+
+    // the fields are all uint16_t, so the worst of each is taken field by field
+    const uint16_t *value = (const uint16_t *)flight;
+    uint16_t *worst = (uint16_t *)&record->worstFlight;
+    bool newWorst = false;
+    for (unsigned i = 0; i < sizeof(*flight) / sizeof(uint16_t); i++) {
+        if (value[i] > worst[i]) {
+            worst[i] = value[i];
+            newWorst = true;
+        }
+    }
+    return hasErrors || newWorst;
+}
+
+void perfRecordDisarmed(void)
+{
+    if (!flying) {
+        return;
+    }
+    flying = false;
+
+    perfCounters_t counters;
+    perfCountersRead(&counters);
+
+    perfFlightStats_t flight;
+    memset(&flight, 0, sizeof(flight));
+    flight.peakSystemLoadPercent = MAX(peakSystemLoadPercent, averageSystemLoadPercent);
+    flight.uartOverruns = saturatedU16(counters.uartOverruns - countersAtArm.uartOverruns);
+    flight.spiErrors = saturatedU16(counters.spiErrors - countersAtArm.spiErrors);
+    flight.i2cErrors = saturatedU16(counters.i2cErrors - countersAtArm.i2cErrors);
+    flight.gyroOverflows = saturatedU16(counters.gyroOverflows - countersAtArm.gyroOverflows);
+#ifdef USE_TASK_STATISTICS_HISTOGRAM
+    flight.missedLoopPeriods = saturatedU16(counters.missedLoopPeriods - countersAtArm.missedLoopPeriods);
+    for (int i = 0; i < TASK_HISTOGRAM_BUCKET_COUNT; i++) {
+        counters.loopLateness[i] -= countersAtArm.loopLateness[i];
+    }
+    flight.maxLoopLatenessUs = saturatedU16(taskHistogramPercentile(counters.loopLateness, 10000));
+#endif
+#ifdef BLACKBOX
+    // the log starts on arming, so its dropped frames are those of the flight
+    flight.blackboxDroppedFrames = saturatedU16(blackboxGetDroppedFrames());
+#endif
+#ifdef USE_SDCARD_STATS
+    flight.sdcardMaxWriteLatencyMs = saturatedU16(sdcardStats_get()->maxWriteLatencyUs / 1000);
+#endif
+
+    if (perfRecordAddFlight(perfRecordMutable(), &flight)) {
+        writeEEPROMAsync();
+    }
+}
+#endif // USE_PERF_RECORD
@@ -0,0 +1,50 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "config/parameter_group.h"
+
+// What one flight put the board through, all saturating
+typedef struct perfFlightStats_s {
+    uint16_t maxLoopLatenessUs;         // the PID loop's worst lateness, rounded up to a power of two less one
+    uint16_t missedLoopPeriods;         // whole PID loop periods skipped
+    uint16_t peakSystemLoadPercent;
+    uint16_t uartOverruns;
+    uint16_t spiErrors;
+    uint16_t i2cErrors;
+    uint16_t blackboxDroppedFrames;
+    uint16_t gyroOverflows;
+    uint16_t sdcardMaxWriteLatencyMs;   // slowest block write since power up
+} perfFlightStats_t;
+
+typedef struct perfRecord_s {
+    uint16_t flights;                   // flights recorded, saturating
+    uint16_t flightsWithErrors;         // flights that skipped loop periods or lost serial, bus, log or gyro data
+    perfFlightStats_t lastFlight;
+    perfFlightStats_t worstFlight;      // the highest of each over the flights recorded
+} perfRecord_t;
+
+PG_DECLARE(perfRecord_t, perfRecord);
+
+bool perfRecordAddFlight(perfRecord_t *record, const perfFlightStats_t *flight);
+
+void perfRecordArmed(void);
+void perfRecordDisarmed(void);
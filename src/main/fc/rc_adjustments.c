@@ -46,6 +46,7 @@
 #include "fc/controlrate_profile.h"
 #include "fc/rc_adjustments.h"
 #include "fc/rc_controls.h"
+#include "fc/rc_modes.h"
 #include "fc/fc_rc.h"
 
 #include "rx/rx.h"
@@ -54,6 +55,8 @@ PG_REGISTER_ARRAY(adjustmentRange_t, MAX_ADJUSTMENT_RANGE_COUNT, adjustmentRange
 
 static pidProfile_t *pidProfile;
 
+static bool adjustmentsUnsaved;
+
 static void blackboxLogInflightAdjustmentEvent(adjustmentFunction_e adjustmentFunction, int32_t newValue)
 {
 #ifndef BLACKBOX
@@ -216,6 +219,24 @@ STATIC_UNIT_TESTED void configureAdjustment(uint8_t index, uint8_t auxSwitchChan
     MARK_ADJUSTMENT_FUNCTION_AS_READY(index);
 }
 
+// the rates are read as they are, the pid settings are what the controller derives its gains from
+static bool isPidAdjustment(uint8_t adjustmentFunction)
+{
+    switch (adjustmentFunction) {
+    case ADJUSTMENT_RC_RATE:
+    case ADJUSTMENT_RC_EXPO:
+    case ADJUSTMENT_THROTTLE_EXPO:
+    case ADJUSTMENT_PITCH_ROLL_RATE:
+    case ADJUSTMENT_YAW_RATE:
+    case ADJUSTMENT_PITCH_RATE:
+    case ADJUSTMENT_ROLL_RATE:
+    case ADJUSTMENT_RC_RATE_YAW:
+        return false;
+    default:
+        return true;
+    }
+}
+
 static void applyStepAdjustment(controlRateConfig_t *controlRateConfig, uint8_t adjustmentFunction, int delta)
 {
 
@@ -355,6 +376,7 @@ static void applySelectAdjustment(uint8_t adjustmentFunction, uint8_t position)
             if (pidProfile->pid[PID_LEVEL].D != newValue) {
                 beeps = ((newValue - pidProfile->pid[PID_LEVEL].D) / 8) + 1;
                 pidProfile->pid[PID_LEVEL].D = newValue;
+                pidInitGains(pidProfile);
                 blackboxLogInflightAdjustmentEvent(ADJUSTMENT_HORIZON_STRENGTH, position);
             }
             break;
@@ -362,6 +384,7 @@ static void applySelectAdjustment(uint8_t adjustmentFunction, uint8_t position)
     }
 
     if (beeps) {
+        adjustmentsUnsaved = true;
         beeperConfirmationBeeps(beeps);
     }
 
@@ -414,7 +437,10 @@ void processRcAdjustments(controlRateConfig_t *controlRateConfig)
             }
 
             applyStepAdjustment(controlRateConfig, adjustmentFunction, delta);
-            pidInitConfig(pidProfile);
+            adjustmentsUnsaved = true;
+            if (isPidAdjustment(adjustmentFunction)) {
+                pidInitGains(pidProfile);
+            }
         } else if (adjustmentState->config->mode == ADJUSTMENT_MODE_SELECT) {
             const uint16_t rangeWidth = ((2100 - 900) / adjustmentState->config->data.switchPositions);
             const uint8_t position = (constrain(rcData[channelIndex], 900, 2100 - 1) - 900) / rangeWidth;
@@ -429,17 +455,68 @@ void resetAdjustmentStates(void)
     memset(adjustmentStates, 0, sizeof(adjustmentStates));
 }
 
-void updateAdjustmentStates(void)
+// the ranges that are set up, by the aux channel that selects them
+static uint16_t auxChannelAdjustmentRangeMask[MAX_AUX_CHANNEL_COUNT];
+static uint16_t adjustmentRangesGenerationUsed;
+
+static void analyzeAdjustmentRanges(void)
 {
+    memset(auxChannelAdjustmentRangeMask, 0, sizeof(auxChannelAdjustmentRangeMask));
+
     for (int index = 0; index < MAX_ADJUSTMENT_RANGE_COUNT; index++) {
         const adjustmentRange_t * const adjustmentRange = adjustmentRanges(index);
-        if (isRangeActive(adjustmentRange->auxChannelIndex, &adjustmentRange->range)) {
-            const adjustmentConfig_t *adjustmentConfig = &defaultAdjustmentConfigs[adjustmentRange->adjustmentFunction - ADJUSTMENT_FUNCTION_CONFIG_INDEX_OFFSET];
-            configureAdjustment(adjustmentRange->adjustmentIndex, adjustmentRange->auxSwitchChannelIndex, adjustmentConfig);
+
+        if (IS_RANGE_USABLE(&adjustmentRange->range)
+            && adjustmentRange->auxChannelIndex < MAX_AUX_CHANNEL_COUNT
+            && adjustmentRange->adjustmentFunction > ADJUSTMENT_NONE
+            && adjustmentRange->adjustmentFunction < ADJUSTMENT_FUNCTION_COUNT
+            && adjustmentRange->adjustmentIndex < MAX_SIMULTANEOUS_ADJUSTMENT_COUNT) {
+            auxChannelAdjustmentRangeMask[adjustmentRange->auxChannelIndex] |= (1 << index);
         }
     }
 }
 
+void updateAdjustmentStates(void)
+{
+    // ranges can only become active when one of the aux channels has moved to a new step
+    const uint32_t auxChannelChangedMask = getAuxChannelChangedMask();
+    if (!auxChannelChangedMask) {
+        return;
+    }
+
+    const uint16_t generation = adjustmentRangesGeneration();
+    if (generation != adjustmentRangesGenerationUsed) {
+        adjustmentRangesGenerationUsed = generation;
+        analyzeAdjustmentRanges();
+    }
+
+    uint16_t rangesToCheck = 0;
+    for (int auxChannelIndex = 0; auxChannelIndex < MAX_AUX_CHANNEL_COUNT; auxChannelIndex++) {
+        if (auxChannelChangedMask & (1 << auxChannelIndex)) {
+            rangesToCheck |= auxChannelAdjustmentRangeMask[auxChannelIndex];
+        }
+    }
+
+    for (int index = 0; index < MAX_ADJUSTMENT_RANGE_COUNT; index++) {
+        if (rangesToCheck & (1 << index)) {
+            const adjustmentRange_t * const adjustmentRange = adjustmentRanges(index);
+            if (isRangeActive(adjustmentRange->auxChannelIndex, &adjustmentRange->range)) {
+                const adjustmentConfig_t *adjustmentConfig = &defaultAdjustmentConfigs[adjustmentRange->adjustmentFunction - ADJUSTMENT_FUNCTION_CONFIG_INDEX_OFFSET];
+                configureAdjustment(adjustmentRange->adjustmentIndex, adjustmentRange->auxSwitchChannelIndex, adjustmentConfig);
+            }
+        }
+    }
+}
+
+// The adjusted values only live in RAM while flying, they are saved in the background once the craft is disarmed
+void saveRcAdjustments(void)
+{
+    if (adjustmentsUnsaved) {
+        adjustmentsUnsaved = false;
+        writeEEPROMAsync();
+    }
+}
+
 void useAdjustmentConfig(pidProfile_t *pidProfileToUse)
 {
     pidProfile = pidProfileToUse;
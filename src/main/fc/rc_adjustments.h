@@ -99,6 +99,7 @@ PG_DECLARE_ARRAY(adjustmentRange_t, MAX_ADJUSTMENT_RANGE_COUNT, adjustmentRanges
 
 void resetAdjustmentStates(void);
 void updateAdjustmentStates(void);
+void saveRcAdjustments(void);
 struct controlRateConfig_s;
 void processRcAdjustments(struct controlRateConfig_s *controlRateConfig);
 struct pidProfile_s;
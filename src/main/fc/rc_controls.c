@@ -330,4 +330,6 @@ void useRcControlsConfig(pidProfile_t *pidProfileToUse)
     pidProfile = pidProfileToUse;
 
     isUsingSticksToArm = !isModeActivationConditionPresent(BOXARM);
+
+    analyzeModeActivationConditions();
 }
@@ -35,15 +35,17 @@
 
 boxBitmask_t rcModeActivationMask; // one bit per mode defined in boxId_e
 
+#define AUX_CHANNEL_STEP_UNKNOWN 0xff
+
+static uint8_t auxChannelSteps[MAX_AUX_CHANNEL_COUNT];       // last range step seen on each aux channel
+static uint32_t auxChannelChangedMask;                       // aux channels whose step changed in the last update
+static uint32_t auxChannelConditionMask[MAX_AUX_CHANNEL_COUNT]; // activation conditions that depend on each aux channel
+static uint32_t activeConditionMask;                         // one bit per modeActivationConditions entry
+
 PG_REGISTER_ARRAY(modeActivationCondition_t, MAX_MODE_ACTIVATION_CONDITION_COUNT, modeActivationConditions,
                   PG_MODE_ACTIVATION_PROFILE, 0);
 
 
-bool IS_RC_MODE_ACTIVE(boxId_e boxId)
-{
-    return bitArrayGet(&rcModeActivationMask, boxId);
-}
-
 void rcModeUpdate(boxBitmask_t *newState)
 {
     rcModeActivationMask = *newState;
@@ -68,18 +70,85 @@ bool isRangeActive(uint8_t auxChannelIndex, const channelRange_t *range) {
 }
 
 
+/*
+ * Must be called whenever the mode activation conditions or adjustment ranges change.
+ * Every aux channel is reported as changed on the next update, so everything gets evaluated again.
+ */
+void analyzeModeActivationConditions(void)
+{
+    memset(auxChannelConditionMask, 0, sizeof(auxChannelConditionMask));
+
+    for (int index = 0; index < MAX_MODE_ACTIVATION_CONDITION_COUNT; index++) {
+        const modeActivationCondition_t *modeActivationCondition = modeActivationConditions(index);
+
+        if (IS_RANGE_USABLE(&modeActivationCondition->range)
+            && modeActivationCondition->auxChannelIndex < MAX_AUX_CHANNEL_COUNT
+            && modeActivationCondition->modeId < CHECKBOX_ITEM_COUNT) {
+            auxChannelConditionMask[modeActivationCondition->auxChannelIndex] |= (1 << index);
+        }
+    }
+
+    memset(auxChannelSteps, AUX_CHANNEL_STEP_UNKNOWN, sizeof(auxChannelSteps));
+    activeConditionMask = 0;
+}
+
+static void updateAuxChannelSteps(void)
+{
+    auxChannelChangedMask = 0;
+
+    for (int auxChannelIndex = 0; auxChannelIndex < MAX_AUX_CHANNEL_COUNT; auxChannelIndex++) {
+        // same quantisation as isRangeActive(), so an unchanged step can't change any range result
+        const uint16_t channelValue = constrain(rcData[auxChannelIndex + NON_AUX_CHANNEL_COUNT], CHANNEL_RANGE_MIN, CHANNEL_RANGE_MAX - 1);
+        const uint8_t step = (channelValue - CHANNEL_RANGE_MIN) / 25;
+
+        if (step != auxChannelSteps[auxChannelIndex]) {
+            auxChannelSteps[auxChannelIndex] = step;
+            auxChannelChangedMask |= (1 << auxChannelIndex);
+        }
+    }
+}
+
+uint32_t getAuxChannelChangedMask(void)
+{
+    return auxChannelChangedMask;
+}
+
 void updateActivatedModes(void)
 {
+    updateAuxChannelSteps();
+
+    uint32_t conditionsToCheck = 0;
+    for (int auxChannelIndex = 0; auxChannelIndex < MAX_AUX_CHANNEL_COUNT; auxChannelIndex++) {
+        if (auxChannelChangedMask & (1 << auxChannelIndex)) {
+            conditionsToCheck |= auxChannelConditionMask[auxChannelIndex];
+        }
+    }
+    if (!conditionsToCheck) {
+        return;
+    }
+
+    uint32_t newActiveConditionMask = activeConditionMask & ~conditionsToCheck;
+    for (int index = 0; index < MAX_MODE_ACTIVATION_CONDITION_COUNT; index++) {
+        if (conditionsToCheck & (1 << index)) {
+            const modeActivationCondition_t *modeActivationCondition = modeActivationConditions(index);
+            const uint8_t step = auxChannelSteps[modeActivationCondition->auxChannelIndex];
+
+            if (step >= modeActivationCondition->range.startStep && step < modeActivationCondition->range.endStep) {
+                newActiveConditionMask |= (1 << index);
+            }
+        }
+    }
+    if (newActiveConditionMask == activeConditionMask) {
+        return;
+    }
+    activeConditionMask = newActiveConditionMask;
+
     boxBitmask_t newMask;
     memset(&newMask, 0, sizeof(newMask));
 
     for (int index = 0; index < MAX_MODE_ACTIVATION_CONDITION_COUNT; index++) {
-        const modeActivationCondition_t *modeActivationCondition = modeActivationConditions(index);
-
-        if (isRangeActive(modeActivationCondition->auxChannelIndex, &modeActivationCondition->range)) {
-            boxId_e mode = modeActivationCondition->modeId;
-            if (mode < CHECKBOX_ITEM_COUNT)
-                bitArraySet(&newMask, mode);
+        if (activeConditionMask & (1 << index)) {
+            bitArraySet(&newMask, modeActivationConditions(index)->modeId);
         }
     }
     rcModeUpdate(&newMask);
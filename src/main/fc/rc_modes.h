@@ -98,12 +98,21 @@ typedef struct modeActivationProfile_s {
 
 #define IS_RANGE_USABLE(range) ((range)->startStep < (range)->endStep)
 
-bool IS_RC_MODE_ACTIVE(boxId_e boxId);
+extern boxBitmask_t rcModeActivationMask; // one bit per mode defined in boxId_e
+
+// modes are only evaluated when the aux channels move, checking one is a bit test
+static inline bool IS_RC_MODE_ACTIVE(boxId_e boxId)
+{
+    return rcModeActivationMask.bits[boxId / 32] & (1U << (boxId % 32));
+}
+
 void rcModeUpdate(boxBitmask_t *newState);
 
 bool isAirmodeActive(void);
 bool isAntiGravityModeActive(void);
 
 bool isRangeActive(uint8_t auxChannelIndex, const channelRange_t *range);
+void analyzeModeActivationConditions(void);
+uint32_t getAuxChannelChangedMask(void);
 void updateActivatedModes(void);
 bool isModeActivationConditionPresent(boxId_e modeId);
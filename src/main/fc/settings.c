@@ -28,9 +28,11 @@
 #include "build/debug.h"
 
 #include "blackbox/blackbox.h"
+#include "blackbox/blackbox_preroll.h"
 
 #include "cms/cms.h"
 
+#include "common/maths.h"
 #include "common/utils.h"
 
 #include "config/parameter_group.h"
@@ -52,6 +54,7 @@
 #include "flight/mixer.h"
 #include "flight/navigation.h"
 #include "flight/pid.h"
+#include "flight/rpm_filter.h"
 #include "flight/servos.h"
 
 #include "io/dashboard.h"
@@ -71,6 +74,7 @@
 #include "sensors/compass.h"
 #include "sensors/esc_sensor.h"
 #include "sensors/gyro.h"
+#include "sensors/gyroanalyse.h"
 
 #include "telemetry/frsky.h"
 #include "telemetry/telemetry.h"
@@ -109,6 +113,16 @@ static const char * const lookupTableCrashRecovery[] = {
     "OFF", "ON" ,"BEEP"
 };
 
+#ifdef USE_ITERM_RELAX
+static const char * const lookupTableItermRelax[] = {
+    "OFF", "RP", "RPY", "RP_INC", "RPY_INC"
+};
+
+static const char * const lookupTableItermRelaxType[] = {
+    "GYRO", "SETPOINT"
+};
+#endif
+
 static const char * const lookupTableUnit[] = {
     "IMPERIAL", "METRIC"
 };
@@ -151,7 +165,11 @@ static const char * const lookupTableGimbalMode[] = {
 
 #ifdef BLACKBOX
 static const char * const lookupTableBlackboxDevice[] = {
-    "NONE", "SPIFLASH", "SDCARD", "SERIAL"
+    "NONE", "SPIFLASH", "SDCARD", "SERIAL", "MSP"
+};
+
+static const char * const lookupTableBlackboxMode[] = {
+    "NORMAL", "GYRO"
 };
 #endif
 
@@ -224,7 +242,7 @@ static const char * const lookupTablePwmProtocol[] = {
 };
 
 static const char * const lookupTableRcInterpolation[] = {
-    "OFF", "PRESET", "AUTO", "MANUAL"
+    "OFF", "PRESET", "AUTO", "MANUAL", "FILTER"
 };
 
 static const char * const lookupTableRcInterpolationChannels[] = {
@@ -243,6 +261,15 @@ static const char * const lookupTableBusType[] = {
     "NONE", "I2C", "SPI"
 };
 
+#ifdef USE_GYRO_DATA_ANALYSE
+static const char * const lookupTableFftWindow[] = {
+    "32", "64",
+#ifndef STM32F3
+    "128", "256"
+#endif
+};
+#endif
+
 const lookupTableEntry_t lookupTables[] = {
     { lookupTableOffOn, sizeof(lookupTableOffOn) / sizeof(char *) },
     { lookupTableUnit, sizeof(lookupTableUnit) / sizeof(char *) },
@@ -253,6 +280,7 @@ const lookupTableEntry_t lookupTables[] = {
 #endif
 #ifdef BLACKBOX
     { lookupTableBlackboxDevice, sizeof(lookupTableBlackboxDevice) / sizeof(char *) },
+    { lookupTableBlackboxMode, sizeof(lookupTableBlackboxMode) / sizeof(char *) },
 #endif
     { lookupTableCurrentSensor, sizeof(lookupTableCurrentSensor) / sizeof(char *) },
     { lookupTableBatterySensor, sizeof(lookupTableBatterySensor) / sizeof(char *) },
@@ -282,6 +310,10 @@ const lookupTableEntry_t lookupTables[] = {
     { lookupTableLowpassType, sizeof(lookupTableLowpassType) / sizeof(char *) },
     { lookupTableFailsafe, sizeof(lookupTableFailsafe) / sizeof(char *) },
     { lookupTableCrashRecovery, sizeof(lookupTableCrashRecovery) / sizeof(char *) },
+#ifdef USE_ITERM_RELAX
+    { lookupTableItermRelax, sizeof(lookupTableItermRelax) / sizeof(char *) },
+    { lookupTableItermRelaxType, sizeof(lookupTableItermRelaxType) / sizeof(char *) },
+#endif
 #ifdef OSD
     { lookupTableOsdType, sizeof(lookupTableOsdType) / sizeof(char *) },
 #endif
@@ -289,6 +321,9 @@ const lookupTableEntry_t lookupTables[] = {
     { lookupTableCameraControlMode, sizeof(lookupTableCameraControlMode) / sizeof(char *) },
 #endif
     { lookupTableBusType, sizeof(lookupTableBusType) / sizeof(char *) },
+#ifdef USE_GYRO_DATA_ANALYSE
+    { lookupTableFftWindow, sizeof(lookupTableFftWindow) / sizeof(char *) },
+#endif
 };
 
 const clivalue_t valueTable[] = {
@@ -303,21 +338,38 @@ const clivalue_t valueTable[] = {
     { "gyro_notch2_hz",             VAR_UINT16 | MASTER_VALUE, .config.minmax = { 0, 16000 }, PG_GYRO_CONFIG, offsetof(gyroConfig_t, gyro_soft_notch_hz_2) },
     { "gyro_notch2_cutoff",         VAR_UINT16 | MASTER_VALUE, .config.minmax = { 1, 16000 }, PG_GYRO_CONFIG, offsetof(gyroConfig_t, gyro_soft_notch_cutoff_2) },
     { "moron_threshold",            VAR_UINT8  | MASTER_VALUE, .config.minmax = { 0,  200 }, PG_GYRO_CONFIG, offsetof(gyroConfig_t, gyroMovementCalibrationThreshold) },
-#if defined(GYRO_USES_SPI)
-#if defined(USE_GYRO_SPI_MPU6500) || defined(USE_GYRO_SPI_MPU9250) || defined(USE_GYRO_SPI_ICM20689)
+#if defined(GYRO_USES_SPI) || defined(USE_FAKE_GYRO_MODEL)
+#if defined(USE_GYRO_SPI_MPU6500) || defined(USE_GYRO_SPI_MPU9250) || defined(USE_GYRO_SPI_ICM20689) || defined(USE_FAKE_GYRO_MODEL)
     { "gyro_use_32khz",             VAR_UINT8  | MASTER_VALUE | MODE_LOOKUP, .config.lookup = { TABLE_OFF_ON }, PG_GYRO_CONFIG, offsetof(gyroConfig_t, gyro_use_32khz) },
 #endif
-#if defined(USE_MPU_DATA_READY_SIGNAL)
+#if defined(USE_MPU_DATA_READY_SIGNAL) || defined(USE_FAKE_GYRO_MODEL)
     { "gyro_isr_update",            VAR_UINT8  | MASTER_VALUE | MODE_LOOKUP, .config.lookup = { TABLE_OFF_ON }, PG_GYRO_CONFIG, offsetof(gyroConfig_t, gyro_isr_update) },
 #endif
 #endif
+#ifdef USE_GYRO_FIFO
+    { "gyro_use_fifo",              VAR_UINT8  | MASTER_VALUE | MODE_LOOKUP, .config.lookup = { TABLE_OFF_ON }, PG_GYRO_CONFIG, offsetof(gyroConfig_t, gyro_use_fifo) },
+#endif
+#ifdef USE_GYRO_BIAS_TRACKING
+    { "gyro_bias_tracking",         VAR_UINT8  | MASTER_VALUE | MODE_LOOKUP, .config.lookup = { TABLE_OFF_ON }, PG_GYRO_CONFIG, offsetof(gyroConfig_t, gyro_bias_tracking) },
+#endif
+#ifdef USE_GYRO_OVERFLOW_CHECK
+    { "gyro_overflow_detect",       VAR_UINT8  | MASTER_VALUE | MODE_LOOKUP, .config.lookup = { TABLE_OFF_ON }, PG_GYRO_CONFIG, offsetof(gyroConfig_t, gyro_overflow_detect) },
+    { "yaw_spin_recovery",          VAR_UINT8  | MASTER_VALUE | MODE_LOOKUP, .config.lookup = { TABLE_OFF_ON }, PG_GYRO_CONFIG, offsetof(gyroConfig_t, yaw_spin_recovery) },
+    { "yaw_spin_threshold",         VAR_UINT16 | MASTER_VALUE, .config.minmax = { 500, 1950 }, PG_GYRO_CONFIG, offsetof(gyroConfig_t, yaw_spin_threshold) },
+#endif
+#ifdef USE_GYRO_DATA_ANALYSE
+    { "dyn_fft_window",             VAR_UINT8  | MASTER_VALUE | MODE_LOOKUP, .config.lookup = { TABLE_FFT_WINDOW }, PG_GYRO_CONFIG, offsetof(gyroConfig_t, dyn_fft_window) },
+    { "dyn_fft_decimation",         VAR_UINT8  | MASTER_VALUE, .config.minmax = { 1, 4 }, PG_GYRO_CONFIG, offsetof(gyroConfig_t, dyn_fft_decimation) },
+    { "dyn_notch_count",            VAR_UINT8  | MASTER_VALUE, .config.minmax = { 1, GYRO_DYN_NOTCH_COUNT_MAX }, PG_GYRO_CONFIG, offsetof(gyroConfig_t, dyn_notch_count) },
+#endif
 #ifdef USE_DUAL_GYRO
-    { "gyro_to_use",                VAR_UINT8  | MASTER_VALUE, .config.minmax = { 0, 1 }, PG_GYRO_CONFIG, offsetof(gyroConfig_t, gyro_to_use) },
+    { "gyro_to_use",                VAR_UINT8  | MASTER_VALUE, .config.minmax = { 0, GYRO_CONFIG_USE_GYRO_BLEND }, PG_GYRO_CONFIG, offsetof(gyroConfig_t, gyro_to_use) },
 #endif
 
 // PG_ACCELEROMETER_CONFIG
     { "align_acc",                  VAR_UINT8  | MASTER_VALUE | MODE_LOOKUP, .config.lookup = { TABLE_ALIGNMENT }, PG_ACCELEROMETER_CONFIG, offsetof(accelerometerConfig_t, acc_align) },
     { "acc_hardware",               VAR_UINT8  | MASTER_VALUE | MODE_LOOKUP, .config.lookup = { TABLE_ACC_HARDWARE }, PG_ACCELEROMETER_CONFIG, offsetof(accelerometerConfig_t, acc_hardware) },
+    { "acc_burst_read",             VAR_UINT8  | MASTER_VALUE | MODE_LOOKUP, .config.lookup = { TABLE_OFF_ON }, PG_ACCELEROMETER_CONFIG, offsetof(accelerometerConfig_t, acc_burst_read) },
     { "acc_lpf_hz",                 VAR_UINT16 | MASTER_VALUE, .config.minmax = { 0, 400 }, PG_ACCELEROMETER_CONFIG, offsetof(accelerometerConfig_t, acc_lpf_hz) },
     { "acc_trim_pitch",             VAR_INT16  | MASTER_VALUE, .config.minmax = { -300, 300 }, PG_ACCELEROMETER_CONFIG, offsetof(accelerometerConfig_t, accelerometerTrims.values.pitch) },
     { "acc_trim_roll",              VAR_INT16  | MASTER_VALUE, .config.minmax = { -300, 300 }, PG_ACCELEROMETER_CONFIG, offsetof(accelerometerConfig_t, accelerometerTrims.values.roll) },
@@ -327,6 +379,9 @@ const clivalue_t valueTable[] = {
     { "align_mag",                  VAR_UINT8  | MASTER_VALUE | MODE_LOOKUP, .config.lookup = { TABLE_ALIGNMENT }, PG_COMPASS_CONFIG, offsetof(compassConfig_t, mag_align) },
     { "mag_hardware",               VAR_UINT8  | MASTER_VALUE | MODE_LOOKUP, .config.lookup = { TABLE_MAG_HARDWARE }, PG_COMPASS_CONFIG, offsetof(compassConfig_t, mag_hardware) },
     { "mag_declination",            VAR_INT16  | MASTER_VALUE, .config.minmax = { -18000, 18000 }, PG_COMPASS_CONFIG, offsetof(compassConfig_t, mag_declination) },
+#ifdef USE_MAG_BACKGROUND_CALIBRATION
+    { "mag_background_cal",         VAR_UINT8  | MASTER_VALUE | MODE_LOOKUP, .config.lookup = { TABLE_OFF_ON }, PG_COMPASS_CONFIG, offsetof(compassConfig_t, mag_background_calibration) },
+#endif
     { "magzero_x",                  VAR_INT16  | MASTER_VALUE, .config.minmax = { INT16_MIN, INT16_MAX }, PG_COMPASS_CONFIG, offsetof(compassConfig_t, magZero.raw[X]) },
     { "magzero_y",                  VAR_INT16  | MASTER_VALUE, .config.minmax = { INT16_MIN, INT16_MAX }, PG_COMPASS_CONFIG, offsetof(compassConfig_t, magZero.raw[Y]) },
     { "magzero_z",                  VAR_INT16  | MASTER_VALUE, .config.minmax = { INT16_MIN, INT16_MAX }, PG_COMPASS_CONFIG, offsetof(compassConfig_t, magZero.raw[Z]) },
@@ -342,8 +397,6 @@ const clivalue_t valueTable[] = {
     { "baro_hardware",              VAR_UINT8  | MASTER_VALUE | MODE_LOOKUP, .config.lookup = { TABLE_BARO_HARDWARE }, PG_BAROMETER_CONFIG, offsetof(barometerConfig_t, baro_hardware) },
     { "baro_tab_size",              VAR_UINT8  | MASTER_VALUE, .config.minmax = { 0, BARO_SAMPLE_COUNT_MAX }, PG_BAROMETER_CONFIG, offsetof(barometerConfig_t, baro_sample_count) },
     { "baro_noise_lpf",             VAR_UINT16  | MASTER_VALUE, .config.minmax = { 0, 1000 }, PG_BAROMETER_CONFIG, offsetof(barometerConfig_t, baro_noise_lpf) },
-    { "baro_cf_vel",                VAR_UINT16  | MASTER_VALUE, .config.minmax = { 0, 1000 }, PG_BAROMETER_CONFIG, offsetof(barometerConfig_t, baro_cf_vel) },
-    { "baro_cf_alt",                VAR_UINT16  | MASTER_VALUE, .config.minmax = { 0, 1000 }, PG_BAROMETER_CONFIG, offsetof(barometerConfig_t, baro_cf_alt) },
 #endif
 
 // PG_RX_CONFIG
@@ -362,6 +415,10 @@ const clivalue_t valueTable[] = {
     { "serialrx_provider",          VAR_UINT8  | MASTER_VALUE | MODE_LOOKUP, .config.lookup = { TABLE_SERIAL_RX }, PG_RX_CONFIG, offsetof(rxConfig_t, serialrx_provider) },
     { "sbus_inversion",             VAR_UINT8  | MASTER_VALUE | MODE_LOOKUP, .config.lookup = { TABLE_OFF_ON }, PG_RX_CONFIG, offsetof(rxConfig_t, sbus_inversion) },
 #endif
+#ifdef USE_SERIALRX_DUAL
+    { "serialrx_dual",              VAR_UINT8  | MASTER_VALUE | MODE_LOOKUP, .config.lookup = { TABLE_OFF_ON }, PG_RX_CONFIG, offsetof(rxConfig_t, dualSerialRx) },
+    { "serialrx_provider_2",        VAR_UINT8  | MASTER_VALUE | MODE_LOOKUP, .config.lookup = { TABLE_SERIAL_RX }, PG_RX_CONFIG, offsetof(rxConfig_t, serialrx_provider_secondary) },
+#endif
 #ifdef USE_SPEKTRUM_BIND
     { "spektrum_sat_bind",          VAR_UINT8  | MASTER_VALUE, .config.minmax = { SPEKTRUM_SAT_BIND_DISABLED, SPEKTRUM_SAT_BIND_MAX}, PG_RX_CONFIG, offsetof(rxConfig_t, spektrum_sat_bind) },
     { "spektrum_sat_bind_autoreset",VAR_UINT8  | MASTER_VALUE, .config.minmax = { 0, 1 }, PG_RX_CONFIG, offsetof(rxConfig_t, spektrum_sat_bind_autoreset) },
@@ -369,6 +426,7 @@ const clivalue_t valueTable[] = {
     { "airmode_start_throttle",     VAR_UINT16 | MASTER_VALUE, .config.minmax = { 1000, 2000 }, PG_RX_CONFIG, offsetof(rxConfig_t, airModeActivateThreshold) },
     { "rx_min_usec",                VAR_UINT16 | MASTER_VALUE, .config.minmax = { PWM_PULSE_MIN, PWM_PULSE_MAX }, PG_RX_CONFIG, offsetof(rxConfig_t, rx_min_usec) },
     { "rx_max_usec",                VAR_UINT16 | MASTER_VALUE, .config.minmax = { PWM_PULSE_MIN, PWM_PULSE_MAX }, PG_RX_CONFIG, offsetof(rxConfig_t, rx_max_usec) },
+    { "rx_frame_event",             VAR_UINT8  | MASTER_VALUE | MODE_LOOKUP, .config.lookup = { TABLE_OFF_ON }, PG_RX_CONFIG, offsetof(rxConfig_t, frameEventScheduling) },
 #ifdef STM32F4
     { "serialrx_halfduplex",        VAR_UINT8  | MASTER_VALUE | MODE_LOOKUP, .config.lookup = { TABLE_OFF_ON }, PG_RX_CONFIG, offsetof(rxConfig_t, halfDuplex) },
 #endif
@@ -384,6 +442,13 @@ const clivalue_t valueTable[] = {
     { "blackbox_device",            VAR_UINT8  | MASTER_VALUE | MODE_LOOKUP, .config.lookup = { TABLE_BLACKBOX_DEVICE }, PG_BLACKBOX_CONFIG, offsetof(blackboxConfig_t, device) },
     { "blackbox_on_motor_test",     VAR_UINT8  | MASTER_VALUE | MODE_LOOKUP, .config.lookup = { TABLE_OFF_ON }, PG_BLACKBOX_CONFIG, offsetof(blackboxConfig_t, on_motor_test) },
     { "blackbox_record_acc",        VAR_UINT8  | MASTER_VALUE | MODE_LOOKUP, .config.lookup = { TABLE_OFF_ON }, PG_BLACKBOX_CONFIG, offsetof(blackboxConfig_t, record_acc) },
+    { "blackbox_mode",              VAR_UINT8  | MASTER_VALUE | MODE_LOOKUP, .config.lookup = { TABLE_BLACKBOX_MODE }, PG_BLACKBOX_CONFIG, offsetof(blackboxConfig_t, mode) },
+#ifdef USE_BLACKBOX_COMPRESSION
+    { "blackbox_compression",       VAR_UINT8  | MASTER_VALUE | MODE_LOOKUP, .config.lookup = { TABLE_OFF_ON }, PG_BLACKBOX_CONFIG, offsetof(blackboxConfig_t, compression) },
+#endif
+#ifdef USE_BLACKBOX_PREROLL
+    { "blackbox_preroll_sec",       VAR_UINT8  | MASTER_VALUE, .config.minmax = { 0, BLACKBOX_PREROLL_MAX_SECONDS }, PG_BLACKBOX_CONFIG, offsetof(blackboxConfig_t, preroll_sec) },
+#endif
 #endif
 
 // PG_MOTOR_CONFIG
@@ -397,6 +462,16 @@ const clivalue_t valueTable[] = {
     { "motor_pwm_protocol",         VAR_UINT8  | MASTER_VALUE | MODE_LOOKUP, .config.lookup = { TABLE_MOTOR_PWM_PROTOCOL }, PG_MOTOR_CONFIG, offsetof(motorConfig_t, dev.motorPwmProtocol) },
     { "motor_pwm_rate",             VAR_UINT16 | MASTER_VALUE, .config.minmax = { 200, 32000 }, PG_MOTOR_CONFIG, offsetof(motorConfig_t, dev.motorPwmRate) },
     { "motor_pwm_inversion",        VAR_UINT8  | MASTER_VALUE | MODE_LOOKUP, .config.lookup = { TABLE_OFF_ON }, PG_MOTOR_CONFIG, offsetof(motorConfig_t, dev.motorPwmInversion) },
+#ifdef USE_DSHOT_TELEMETRY
+    { "dshot_bidir",                VAR_UINT8  | MASTER_VALUE | MODE_LOOKUP, .config.lookup = { TABLE_OFF_ON }, PG_MOTOR_CONFIG, offsetof(motorConfig_t, dev.useDshotTelemetry) },
+#endif
+    { "thrust_curve",               VAR_UINT8  | MASTER_VALUE | MODE_ARRAY, .config.array.length = THRUST_CURVE_POINTS, PG_MOTOR_CONFIG, offsetof(motorConfig_t, thrustCurve) },
+#ifdef USE_RPM_FILTER
+    { "thrust_rpm_trim",            VAR_UINT8  | MASTER_VALUE, .config.minmax = { 0, 25 }, PG_MOTOR_CONFIG, offsetof(motorConfig_t, thrustRpmTrim) },
+#endif
+#ifdef USE_DSHOT_DMAR
+    { "dshot_burst",                VAR_UINT8  | MASTER_VALUE | MODE_LOOKUP, .config.lookup = { TABLE_OFF_ON }, PG_MOTOR_CONFIG, offsetof(motorConfig_t, dev.useBurstDshot) },
+#endif
 
 // PG_THROTTLE_CORRECTION_CONFIG
     { "thr_corr_value",             VAR_UINT8  | MASTER_VALUE, .config.minmax = { 0,  150 }, PG_THROTTLE_CORRECTION_CONFIG, offsetof(throttleCorrectionConfig_t, throttle_correction_value) },
@@ -409,6 +484,7 @@ const clivalue_t valueTable[] = {
     { "failsafe_kill_switch",       VAR_UINT8  | MASTER_VALUE | MODE_LOOKUP, .config.lookup = { TABLE_OFF_ON }, PG_FAILSAFE_CONFIG, offsetof(failsafeConfig_t, failsafe_kill_switch) },
     { "failsafe_throttle_low_delay",VAR_UINT16 | MASTER_VALUE, .config.minmax = { 0, 300 }, PG_FAILSAFE_CONFIG, offsetof(failsafeConfig_t, failsafe_throttle_low_delay) },
     { "failsafe_procedure",         VAR_UINT8  | MASTER_VALUE | MODE_LOOKUP, .config.lookup = { TABLE_FAILSAFE }, PG_FAILSAFE_CONFIG, offsetof(failsafeConfig_t, failsafe_procedure) },
+    { "failsafe_lq_warning",        VAR_UINT8  | MASTER_VALUE, .config.minmax = { 0, 100 }, PG_FAILSAFE_CONFIG, offsetof(failsafeConfig_t, failsafe_lq_warning) },
 
 // PG_BOARDALIGNMENT_CONFIG
     { "align_board_roll",           VAR_INT16  | MASTER_VALUE, .config.minmax = { -180, 360 }, PG_BOARD_ALIGNMENT, offsetof(boardAlignment_t, rollDegrees) },
@@ -516,6 +592,9 @@ const clivalue_t valueTable[] = {
     { "nav_speed_min",              VAR_UINT16 | MASTER_VALUE, .config.minmax = { 10, 2000 }, PG_NAVIGATION_CONFIG, offsetof(navigationConfig_t, nav_speed_min) },
     { "nav_speed_max",              VAR_UINT16 | MASTER_VALUE, .config.minmax = { 10, 2000 }, PG_NAVIGATION_CONFIG, offsetof(navigationConfig_t, nav_speed_max) },
     { "nav_slew_rate",              VAR_UINT8  | MASTER_VALUE, .config.minmax = { 0, 100 }, PG_NAVIGATION_CONFIG, offsetof(navigationConfig_t, nav_slew_rate) },
+#ifdef BARO
+    { "nav_rth_altitude",           VAR_UINT16 | MASTER_VALUE, .config.minmax = { 0, 1000 }, PG_NAVIGATION_CONFIG, offsetof(navigationConfig_t, nav_rth_altitude) },
+#endif
 #endif
 
 // PG_AIRPLANE_CONFIG
@@ -532,6 +611,7 @@ const clivalue_t valueTable[] = {
 
 // PG_PID_CONFIG
     { "pid_process_denom",          VAR_UINT8  | MASTER_VALUE,  .config.minmax = { 1, MAX_PID_PROCESS_DENOM }, PG_PID_CONFIG, offsetof(pidConfig_t, pid_process_denom) },
+    { "motor_output_delay",         VAR_UINT16 | MASTER_VALUE, .config.minmax = { 0, 1000 }, PG_PID_CONFIG, offsetof(pidConfig_t, motorOutputDelayUs) },
 
 // PG_PID_PROFILE
     { "dterm_lowpass_type",         VAR_UINT8  | PROFILE_VALUE | MODE_LOOKUP, .config.lookup = { TABLE_LOWPASS_TYPE }, PG_PID_PROFILE, offsetof(pidProfile_t, dterm_filter_type) },
@@ -544,6 +624,8 @@ const clivalue_t valueTable[] = {
     { "anti_gravity_gain",          VAR_UINT16 | PROFILE_VALUE, .config.minmax = { 1000, 30000 }, PG_PID_PROFILE, offsetof(pidProfile_t, itermAcceleratorGain) },
     { "setpoint_relax_ratio",       VAR_UINT8  | PROFILE_VALUE, .config.minmax = { 0, 100 }, PG_PID_PROFILE, offsetof(pidProfile_t, setpointRelaxRatio) },
     { "dterm_setpoint_weight",      VAR_UINT8  | PROFILE_VALUE, .config.minmax = { 0, 254 }, PG_PID_PROFILE, offsetof(pidProfile_t, dtermSetpointWeight) },
+    { "feed_forward",               VAR_UINT8  | PROFILE_VALUE | MODE_ARRAY, .config.array.length = XYZ_AXIS_COUNT, PG_PID_PROFILE, offsetof(pidProfile_t, feedForward) },
+    { "feed_forward_smoothing",     VAR_UINT8  | PROFILE_VALUE, .config.minmax = { 0, 95 }, PG_PID_PROFILE, offsetof(pidProfile_t, feedForwardSmoothing) },
     { "acc_limit_yaw",              VAR_UINT16 | PROFILE_VALUE, .config.minmax = { 1, 500 }, PG_PID_PROFILE, offsetof(pidProfile_t, yawRateAccelLimit) },
     { "acc_limit",                  VAR_UINT16 | PROFILE_VALUE, .config.minmax = { 1, 500 }, PG_PID_PROFILE, offsetof(pidProfile_t, rateAccelLimit) },
     { "crash_dthreshold",           VAR_UINT16 | PROFILE_VALUE, .config.minmax = { 0, 2000 }, PG_PID_PROFILE, offsetof(pidProfile_t, crash_dthreshold) },
@@ -555,6 +637,18 @@ const clivalue_t valueTable[] = {
     { "crash_recovery",             VAR_UINT8  | PROFILE_VALUE | MODE_LOOKUP, .config.lookup = { TABLE_CRASH_RECOVERY }, PG_PID_PROFILE, offsetof(pidProfile_t, crash_recovery) },
 
     { "iterm_windup",               VAR_UINT8  | PROFILE_VALUE, .config.minmax = { 30, 100 }, PG_PID_PROFILE, offsetof(pidProfile_t, itermWindupPointPercent) },
+#ifdef USE_ITERM_RELAX
+    { "iterm_relax",                VAR_UINT8  | PROFILE_VALUE | MODE_LOOKUP, .config.lookup = { TABLE_ITERM_RELAX }, PG_PID_PROFILE, offsetof(pidProfile_t, itermRelax) },
+    { "iterm_relax_type",           VAR_UINT8  | PROFILE_VALUE | MODE_LOOKUP, .config.lookup = { TABLE_ITERM_RELAX_TYPE }, PG_PID_PROFILE, offsetof(pidProfile_t, itermRelaxType) },
+#endif
+#if defined(USE_ITERM_RELAX) || defined(USE_ABSOLUTE_CONTROL)
+    { "iterm_relax_cutoff",         VAR_UINT8  | PROFILE_VALUE, .config.minmax = { 1, 100 }, PG_PID_PROFILE, offsetof(pidProfile_t, itermRelaxCutoff) },
+#endif
+#ifdef USE_ABSOLUTE_CONTROL
+    { "abs_control_gain",           VAR_UINT8  | PROFILE_VALUE, .config.minmax = { 0, 20 }, PG_PID_PROFILE, offsetof(pidProfile_t, absControlGain) },
+    { "abs_control_limit",          VAR_UINT8  | PROFILE_VALUE, .config.minmax = { 10, 255 }, PG_PID_PROFILE, offsetof(pidProfile_t, absControlLimit) },
+    { "abs_control_error_limit",    VAR_UINT8  | PROFILE_VALUE, .config.minmax = { 1, 45 }, PG_PID_PROFILE, offsetof(pidProfile_t, absControlErrorLimit) },
+#endif
     { "yaw_lowpass",                VAR_UINT16 | PROFILE_VALUE, .config.minmax = { 0, 500 }, PG_PID_PROFILE, offsetof(pidProfile_t, yaw_lpf_hz) },
     { "pidsum_limit",               VAR_UINT16 | PROFILE_VALUE, .config.minmax = { 100, 1000 }, PG_PID_PROFILE, offsetof(pidProfile_t, pidSumLimit) },
     { "pidsum_limit_yaw",           VAR_UINT16 | PROFILE_VALUE, .config.minmax = { 100, 1000 }, PG_PID_PROFILE, offsetof(pidProfile_t, pidSumLimitYaw) },
@@ -672,6 +766,7 @@ const clivalue_t valueTable[] = {
     { "osd_nvario_pos",             VAR_UINT16  | MASTER_VALUE, .config.minmax = { 0, OSD_POSCFG_MAX }, PG_OSD_CONFIG, offsetof(osdConfig_t, item_pos[OSD_NUMERICAL_VARIO]) },
     { "osd_esc_tmp_pos",            VAR_UINT16  | MASTER_VALUE, .config.minmax = { 0, OSD_POSCFG_MAX }, PG_OSD_CONFIG, offsetof(osdConfig_t, item_pos[OSD_ESC_TMP]) },
     { "osd_esc_rpm_pos",            VAR_UINT16  | MASTER_VALUE, .config.minmax = { 0, OSD_POSCFG_MAX }, PG_OSD_CONFIG, offsetof(osdConfig_t, item_pos[OSD_ESC_RPM]) },
+    { "osd_lq_pos",                 VAR_UINT16  | MASTER_VALUE, .config.minmax = { 0, OSD_POSCFG_MAX }, PG_OSD_CONFIG, offsetof(osdConfig_t, item_pos[OSD_LINK_QUALITY]) },
 
     { "osd_stat_max_spd",           VAR_UINT8   | MASTER_VALUE | MODE_LOOKUP, .config.lookup = { TABLE_OFF_ON }, PG_OSD_CONFIG, offsetof(osdConfig_t, enabled_stats[OSD_STAT_MAX_SPEED])},
     { "osd_stat_max_dist",          VAR_UINT8   | MASTER_VALUE | MODE_LOOKUP, .config.lookup = { TABLE_OFF_ON }, PG_OSD_CONFIG, offsetof(osdConfig_t, enabled_stats[OSD_STAT_MAX_DISTANCE])},
@@ -691,7 +786,14 @@ const clivalue_t valueTable[] = {
 #ifndef SKIP_TASK_STATISTICS
     { "task_statistics",            VAR_INT8   | MASTER_VALUE | MODE_LOOKUP, .config.lookup = { TABLE_OFF_ON }, PG_SYSTEM_CONFIG, offsetof(systemConfig_t, task_statistics) },
 #endif
-    { "debug_mode",                 VAR_UINT8  | MASTER_VALUE | MODE_LOOKUP, .config.lookup = { TABLE_DEBUG }, PG_SYSTEM_CONFIG, offsetof(systemConfig_t, debug_mode) },
+    { "debug_mode",                 VAR_UINT8  | MASTER_VALUE | MODE_LOOKUP, .config.lookup = { TABLE_DEBUG }, PG_SYSTEM_CONFIG, offsetof(systemConfig_t, debug_modes[0]) },
+    { "debug_mode_2",               VAR_UINT8  | MASTER_VALUE | MODE_LOOKUP, .config.lookup = { TABLE_DEBUG }, PG_SYSTEM_CONFIG, offsetof(systemConfig_t, debug_modes[1]) },
+#if DEBUG_MODE_SLOT_COUNT > 2
+    { "debug_mode_3",               VAR_UINT8  | MASTER_VALUE | MODE_LOOKUP, .config.lookup = { TABLE_DEBUG }, PG_SYSTEM_CONFIG, offsetof(systemConfig_t, debug_modes[2]) },
+#endif
+#if DEBUG_MODE_SLOT_COUNT > 3
+    { "debug_mode_4",               VAR_UINT8  | MASTER_VALUE | MODE_LOOKUP, .config.lookup = { TABLE_DEBUG }, PG_SYSTEM_CONFIG, offsetof(systemConfig_t, debug_modes[3]) },
+#endif
 #if defined(STM32F4) && !defined(DISABLE_OVERCLOCK)
     { "cpu_overclock",              VAR_UINT8  | MASTER_VALUE | MODE_LOOKUP, .config.lookup = { TABLE_OFF_ON }, PG_SYSTEM_CONFIG, offsetof(systemConfig_t, cpu_overclock) },
 #endif
@@ -727,6 +829,13 @@ const clivalue_t valueTable[] = {
 
 #ifdef USE_ESC_SENSOR
     { "esc_sensor_halfduplex",          VAR_UINT8  | MASTER_VALUE | MODE_LOOKUP, .config.lookup = { TABLE_OFF_ON }, PG_ESC_SENSOR_CONFIG, offsetof(escSensorConfig_t, halfDuplex) },
+#endif
+#ifdef USE_RPM_FILTER
+    { "rpm_notch_harmonics",            VAR_UINT8  | MASTER_VALUE, .config.minmax = { 0, RPM_FILTER_HARMONICS_MAX }, PG_RPM_FILTER_CONFIG, offsetof(rpmFilterConfig_t, rpm_notch_harmonics) },
+    { "rpm_notch_min_hz",               VAR_UINT8  | MASTER_VALUE, .config.minmax = { 50, 200 }, PG_RPM_FILTER_CONFIG, offsetof(rpmFilterConfig_t, rpm_notch_min_hz) },
+    { "rpm_notch_q",                    VAR_UINT16 | MASTER_VALUE, .config.minmax = { 100, 3000 }, PG_RPM_FILTER_CONFIG, offsetof(rpmFilterConfig_t, rpm_notch_q) },
+    { "rpm_lpf_hz",                     VAR_UINT8  | MASTER_VALUE, .config.minmax = { 10, 255 }, PG_RPM_FILTER_CONFIG, offsetof(rpmFilterConfig_t, rpm_lpf_hz) },
+    { "motor_poles",                    VAR_UINT8  | MASTER_VALUE, .config.minmax = { 4, 64 }, PG_RPM_FILTER_CONFIG, offsetof(rpmFilterConfig_t, motor_poles) },
 #endif
     { "led_inversion",                  VAR_UINT8  | MASTER_VALUE, .config.minmax = { 0, ((1 << STATUS_LED_NUMBER) - 1) }, PG_STATUS_LED_CONFIG, offsetof(statusLedConfig_t, inversion) },
 #ifdef USE_DASHBOARD
@@ -744,6 +853,132 @@ const clivalue_t valueTable[] = {
 
 const uint16_t valueTableEntryCount = ARRAYLEN(valueTable);
 
+// Compares a name of the given length, which need not be terminated, with a setting name, ignoring case
+static int settingNameCompare(const char *name, uint8_t length, const char *settingName)
+{
+    const int result = strncasecmp(name, settingName, length);
+    if (result) {
+        return result;
+    }
+    return settingName[length] ? -1 : 0;
+}
+
+#ifdef USE_SETTING_INDEX
+// valueTable in name order, sorted on the first lookup rather than kept in flash, as valueTable differs with every target
+static uint16_t settingNameIndex[ARRAYLEN(valueTable)];
+static bool settingNameIndexReady;
+
+static void settingNameIndexBuild(void)
+{
+    // binary insertion, only the index entries move
+    for (unsigned i = 0; i < ARRAYLEN(valueTable); i++) {
+        unsigned low = 0;
+        unsigned high = i;
+        while (low < high) {
+            const unsigned mid = (low + high) / 2;
+            if (strcasecmp(valueTable[i].name, valueTable[settingNameIndex[mid]].name) < 0) {
+                high = mid;
+            } else {
+                low = mid + 1;
+            }
+        }
+        memmove(&settingNameIndex[low + 1], &settingNameIndex[low], (i - low) * sizeof(settingNameIndex[0]));
+        settingNameIndex[low] = i;
+    }
+    settingNameIndexReady = true;
+}
+#endif
+
+// The setting with exactly this name, ignoring case, NULL if there is none
+const clivalue_t *settingFind(const char *name, uint8_t length)
+{
+#ifdef USE_SETTING_INDEX
+    if (!settingNameIndexReady) {
+        settingNameIndexBuild();
+    }
+    unsigned low = 0;
+    unsigned high = ARRAYLEN(valueTable);
+    while (low < high) {
+        const unsigned mid = (low + high) / 2;
+        const clivalue_t *value = &valueTable[settingNameIndex[mid]];
+        const int result = settingNameCompare(name, length, value->name);
+        if (result == 0) {
+            return value;
+        }
+        if (result < 0) {
+            high = mid;
+        } else {
+            low = mid + 1;
+        }
+    }
+#else
+    for (unsigned i = 0; i < ARRAYLEN(valueTable); i++) {
+        if (settingNameCompare(name, length, valueTable[i].name) == 0) {
+            return &valueTable[i];
+        }
+    }
+#endif
+    return NULL;
+}
+
+// Where a setting lives in the current profiles, for the protocols that change settings without the CLI
+void *settingGetValuePointer(const clivalue_t *value)
+{
+    uint16_t offset = value->offset;
+    switch (value->type & VALUE_SECTION_MASK) {
+    case PROFILE_VALUE:
+        offset += sizeof(pidProfile_t) * getCurrentPidProfileIndex();
+        break;
+    case PROFILE_RATE_VALUE:
+        offset += sizeof(controlRateConfig_t) * getCurrentControlRateProfileIndex();
+        break;
+    }
+    return pgFind(value->pgn)->address + offset;
+}
+
+int32_t settingGetValue(const clivalue_t *value)
+{
+    const void *ptr = settingGetValuePointer(value);
+    switch (value->type & VALUE_TYPE_MASK) {
+    case VAR_INT8:
+        return *(int8_t *)ptr;
+    case VAR_UINT16:
+        return *(uint16_t *)ptr;
+    case VAR_INT16:
+        return *(int16_t *)ptr;
+    case VAR_UINT8:
+    default:
+        return *(uint8_t *)ptr;
+    }
+}
+
+// Numbers are constrained to the setting's range, returns false if a lookup index is out of its table
+bool settingSetValue(const clivalue_t *value, int32_t newValue)
+{
+    if ((value->type & VALUE_MODE_MASK) == MODE_LOOKUP) {
+        if (newValue < 0 || newValue >= lookupTables[value->config.lookup.tableIndex].valueCount) {
+            return false;
+        }
+    } else {
+        const int32_t min = value->config.minmax.min;
+        const int32_t max = (value->type & VALUE_TYPE_MASK) == VAR_UINT16 ? (uint16_t)value->config.minmax.max : value->config.minmax.max;
+        newValue = constrain(newValue, min, max);
+    }
+
+    void *ptr = settingGetValuePointer(value);
+    switch (value->type & VALUE_TYPE_MASK) {
+    case VAR_UINT8:
+    case VAR_INT8:
+        *(uint8_t *)ptr = newValue;
+        break;
+    case VAR_UINT16:
+    case VAR_INT16:
+        *(uint16_t *)ptr = newValue;
+        break;
+    }
+    return true;
+}
+
 void settingsBuildCheck() {
     BUILD_BUG_ON(LOOKUP_TABLE_COUNT != ARRAYLEN(lookupTables));
 }
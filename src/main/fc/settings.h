@@ -28,6 +28,7 @@ typedef enum {
 #endif
 #ifdef BLACKBOX
     TABLE_BLACKBOX_DEVICE,
+    TABLE_BLACKBOX_MODE,
 #endif
     TABLE_CURRENT_METER,
     TABLE_VOLTAGE_METER,
@@ -57,6 +58,10 @@ typedef enum {
     TABLE_LOWPASS_TYPE,
     TABLE_FAILSAFE,
     TABLE_CRASH_RECOVERY,
+#ifdef USE_ITERM_RELAX
+    TABLE_ITERM_RELAX,
+    TABLE_ITERM_RELAX_TYPE,
+#endif
 #ifdef OSD
     TABLE_OSD,
 #endif
@@ -64,6 +69,9 @@ typedef enum {
     TABLE_CAMERA_CONTROL_MODE,
 #endif
     TABLE_BUS_TYPE,
+#ifdef USE_GYRO_DATA_ANALYSE
+    TABLE_FFT_WINDOW,
+#endif
     LOOKUP_TABLE_COUNT
 } lookupTableIndex_e;
 
@@ -133,6 +141,11 @@ extern const lookupTableEntry_t lookupTables[];
 extern const uint16_t valueTableEntryCount;
 
 extern const clivalue_t valueTable[];
+
+const clivalue_t *settingFind(const char *name, uint8_t length);
+void *settingGetValuePointer(const clivalue_t *value);
+int32_t settingGetValue(const clivalue_t *value);
+bool settingSetValue(const clivalue_t *value, int32_t newValue);
 //extern const uint8_t lookupTablesEntryCount;
 
 extern const char * const lookupTableGyroHardware[];
@@ -75,6 +75,13 @@ static int16_t initialThrottleHold;
 // 40hz update rate (20hz LPF on acc)
 #define BARO_UPDATE_FREQUENCY_40HZ (1000 * 25)
 
+// Noise the altitude Kalman filter gains are computed for
+#define ALTITUDE_KF_ACC_NOISE       50.0f   // cm/s/s, vertical acceleration after the deadband
+#define ALTITUDE_KF_ACC_BIAS_DRIFT  10.0f   // cm/s/s per sqrt(s), random walk of the acc zero
+#define ALTITUDE_KF_BARO_NOISE      50.0f   // cm
+#define ALTITUDE_KF_SONAR_NOISE     3.0f    // cm
+#define ALTITUDE_KF_GAIN_ITERATIONS 1000
+
 #define DEGREES_80_IN_DECIDEGREES 800
 
 static void applyMultirotorAltHold(void)
@@ -167,6 +174,105 @@ bool isThrustFacingDownwards(attitudeEulerAngles_t *attitude)
     return ABS(attitude->values.roll) < DEGREES_80_IN_DECIDEGREES && ABS(attitude->values.pitch) < DEGREES_80_IN_DECIDEGREES;
 }
 
+/*
+ * Altitude, vertical velocity and acc bias, predicted from the earth frame acc and corrected by the baro
+ * or the sonar. The update rate is fixed, so the filter runs on its steady state gains: they are computed
+ * once per measurement source, and each update then costs the same few multiplies.
+ */
+typedef enum {
+    ALTITUDE_SOURCE_BARO = 0,
+    ALTITUDE_SOURCE_SONAR,
+    ALTITUDE_SOURCE_COUNT
+} altitudeSource_e;
+
+typedef struct altitudeKalman_s {
+    float altitude;     // cm
+    float velocity;     // cm/s
+    float accBias;      // cm/s/s
+    float gain[ALTITUDE_SOURCE_COUNT][3];
+    bool gainsReady;
+} altitudeKalman_t;
+
+static altitudeKalman_t altitudeKalman;
+
+// Iterates the covariance to its steady state for a measurement of the altitude with the given variance
+static void altitudeKalmanSteadyStateGain(float dt, float measurementVariance, float gain[3])
+{
+    const float F[3][3] = {
+        { 1.0f, dt, -0.5f * dt * dt },
+        { 0.0f, 1.0f, -dt },
+        { 0.0f, 0.0f, 1.0f }
+    };
+    const float G[3] = { 0.5f * dt * dt, dt, 0.0f };
+    float P[3][3] = {
+        { measurementVariance, 0.0f, 0.0f },
+        { 0.0f, sq(ALTITUDE_KF_ACC_NOISE), 0.0f },
+        { 0.0f, 0.0f, sq(ALTITUDE_KF_ACC_NOISE) }
+    };
+
+    for (int iteration = 0; iteration < ALTITUDE_KF_GAIN_ITERATIONS; iteration++) {
+        // P = F P F' + Q
+        float FP[3][3];
+        for (int i = 0; i < 3; i++) {
+            for (int j = 0; j < 3; j++) {
+                FP[i][j] = F[i][0] * P[0][j] + F[i][1] * P[1][j] + F[i][2] * P[2][j];
+            }
+        }
+        for (int i = 0; i < 3; i++) {
+            for (int j = 0; j < 3; j++) {
+                P[i][j] = FP[i][0] * F[j][0] + FP[i][1] * F[j][1] + FP[i][2] * F[j][2] + G[i] * G[j] * sq(ALTITUDE_KF_ACC_NOISE);
+            }
+        }
+        P[2][2] += sq(ALTITUDE_KF_ACC_BIAS_DRIFT) * dt;
+
+        // K = P H' / (H P H' + R), P = (I - K H) P
+        const float innovationVariance = P[0][0] + measurementVariance;
+        const float previousGain = gain[0];
+        for (int i = 0; i < 3; i++) {
+            gain[i] = P[i][0] / innovationVariance;
+        }
+        for (int i = 0; i < 3; i++) {
+            for (int j = 0; j < 3; j++) {
+                P[i][j] -= gain[i] * P[0][j];
+            }
+        }
+        if (iteration > 0 && gain[0] == previousGain) {
+            break;
+        }
+    }
+}
+
+static void altitudeKalmanInitGains(void)
+{
+    const float dt = BARO_UPDATE_FREQUENCY_40HZ * 1e-6f;
+    altitudeKalmanSteadyStateGain(dt, sq(ALTITUDE_KF_BARO_NOISE), altitudeKalman.gain[ALTITUDE_SOURCE_BARO]);
+    altitudeKalmanSteadyStateGain(dt, sq(ALTITUDE_KF_SONAR_NOISE), altitudeKalman.gain[ALTITUDE_SOURCE_SONAR]);
+    altitudeKalman.gainsReady = true;
+}
+
+static void altitudeKalmanReset(float altitude)
+{
+    altitudeKalman.altitude = altitude;
+    altitudeKalman.velocity = 0.0f;
+    altitudeKalman.accBias = 0.0f;
+}
+
+static void altitudeKalmanPredict(float accZ, float dt)
+{
+    const float acc = accZ - altitudeKalman.accBias;
+    altitudeKalman.altitude += (altitudeKalman.velocity + 0.5f * acc * dt) * dt;
+    altitudeKalman.velocity += acc * dt;
+}
+
+static void altitudeKalmanCorrect(altitudeSource_e source, float measuredAltitude)
+{
+    const float *gain = altitudeKalman.gain[source];
+    const float innovation = measuredAltitude - altitudeKalman.altitude;
+    altitudeKalman.altitude += gain[0] * innovation;
+    altitudeKalman.velocity += gain[1] * innovation;
+    altitudeKalman.accBias += gain[2] * innovation;
+}
+
 int32_t calculateAltHoldThrottleAdjustment(int32_t vel_tmp, float accZ_tmp, float accZ_old)
 {
     int32_t result = 0;
@@ -212,80 +318,65 @@ void calculateEstimatedAltitude(timeUs_t currentTimeUs)
     }
     previousTimeUs = currentTimeUs;
 
-    static float vel = 0.0f;
-    static float accAlt = 0.0f;
-
-    int32_t baroAlt = 0;
-#ifdef BARO
-    if (sensors(SENSOR_BARO)) {
-        if (!isBaroCalibrationComplete()) {
-            performBaroCalibrationCycle();
-            vel = 0;
-            accAlt = 0;
-        } else {
-            baroAlt = baroCalculateAltitude();
-            estimatedAltitude = baroAlt;
-        }
+    if (!altitudeKalman.gainsReady) {
+        altitudeKalmanInitGains();
     }
-#endif
-
-#ifdef SONAR
-    if (sensors(SENSOR_SONAR)) {
-        int32_t sonarAlt = sonarCalculateAltitude(sonarRead(), getCosTiltAngle());
-        if (sonarAlt > 0 && sonarAlt >= sonarCfAltCm && sonarAlt <= sonarMaxAltWithTiltCm) {
-            // SONAR in range, so use complementary filter
-            float sonarTransition = (float)(sonarMaxAltWithTiltCm - sonarAlt) / (sonarMaxAltWithTiltCm - sonarCfAltCm);
-            sonarAlt = (float)sonarAlt * sonarTransition + baroAlt * (1.0f - sonarTransition);
-            estimatedAltitude = sonarAlt;
-        }
-    }
-#endif
 
     float accZ_tmp = 0;
 #ifdef ACC
     if (sensors(SENSOR_ACC)) {
-        const float dt = accTimeSum * 1e-6f; // delta acc reading time in seconds
-
-        // Integrator - velocity, cm/sec
         if (accSumCount) {
             accZ_tmp = (float)accSum[2] / accSumCount;
         }
-        const float vel_acc = accZ_tmp * accVelScale * (float)accTimeSum;
-
-        // Integrator - Altitude in cm
-        accAlt += (vel_acc * 0.5f) * dt + vel * dt;  // integrate velocity to get distance (x= a/2 * t^2)
-        accAlt = accAlt * CONVERT_PARAMETER_TO_FLOAT(barometerConfig()->baro_cf_alt) + (float)baro.BaroAlt * (1.0f - CONVERT_PARAMETER_TO_FLOAT(barometerConfig()->baro_cf_alt));    // complementary filter for altitude estimation (baro & acc)
-        vel += vel_acc;
-        estimatedAltitude = accAlt;
-    }
+        // the acc sum covers the time since the last run, so the mean acc integrates over the same time
+        const float dt = accTimeSum * 1e-6f;
+        altitudeKalmanPredict(accZ_tmp * accVelScale * 1e6f, dt);
+    } else
 #endif
+    {
+        altitudeKalmanPredict(0.0f, dTime * 1e-6f);
+    }
 
-    DEBUG_SET(DEBUG_ALTITUDE, DEBUG_ALTITUDE_ACC, accSum[2] / accSumCount);
-    DEBUG_SET(DEBUG_ALTITUDE, DEBUG_ALTITUDE_VEL, vel);
-    DEBUG_SET(DEBUG_ALTITUDE, DEBUG_ALTITUDE_HEIGHT, accAlt);
+    DEBUG_SET(DEBUG_ALTITUDE, DEBUG_ALTITUDE_ACC, accSumCount ? accSum[2] / accSumCount : 0);
 
     imuResetAccelerationSum();
 
-    int32_t baroVel = 0;
+    bool measured = false;
+#ifdef SONAR
+    if (sensors(SENSOR_SONAR)) {
+        const int32_t sonarAlt = sonarCalculateAltitude(sonarRead(), getCosTiltAngle());
+        if (sonarAlt > 0 && sonarAlt <= sonarMaxAltWithTiltCm) {
+            altitudeKalmanCorrect(ALTITUDE_SOURCE_SONAR, sonarAlt);
+            measured = true;
+        }
+    }
+#endif
+
 #ifdef BARO
     if (sensors(SENSOR_BARO)) {
         if (!isBaroCalibrationComplete()) {
+            performBaroCalibrationCycle();
+            altitudeKalmanReset(0.0f);
             return;
         }
+        const int32_t baroAlt = baroCalculateAltitude();
+        if (!measured) {
+            altitudeKalmanCorrect(ALTITUDE_SOURCE_BARO, baroAlt);
+            measured = true;
+        }
+    }
+#endif
 
-        static int32_t lastBaroAlt = 0;
-        baroVel = (baroAlt - lastBaroAlt) * 1000000.0f / dTime;
-        lastBaroAlt = baroAlt;
-
-        baroVel = constrain(baroVel, -1500, 1500);  // constrain baro velocity +/- 1500cm/s
-        baroVel = applyDeadband(baroVel, 10);       // to reduce noise near zero
+    if (!measured) {
+        // no reference, keep the last estimate rather than integrate the acc away
+        altitudeKalmanReset(altitudeKalman.altitude);
     }
-#endif // BARO
 
-    // apply Complimentary Filter to keep the calculated velocity based on baro velocity (i.e. near real velocity).
-    // By using CF it's possible to correct the drift of integrated accZ (velocity) without loosing the phase, i.e without delay
-    vel = vel * CONVERT_PARAMETER_TO_FLOAT(barometerConfig()->baro_cf_vel) + baroVel * (1.0f - CONVERT_PARAMETER_TO_FLOAT(barometerConfig()->baro_cf_vel));
-    int32_t vel_tmp = lrintf(vel);
+    estimatedAltitude = lrintf(altitudeKalman.altitude);
+    const int32_t vel_tmp = lrintf(altitudeKalman.velocity);
+
+    DEBUG_SET(DEBUG_ALTITUDE, DEBUG_ALTITUDE_VEL, vel_tmp);
+    DEBUG_SET(DEBUG_ALTITUDE, DEBUG_ALTITUDE_HEIGHT, estimatedAltitude);
 
     // set vario
     estimatedVario = applyDeadband(vel_tmp, 5);
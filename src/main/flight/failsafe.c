@@ -41,6 +41,7 @@
 #include "io/motors.h"
 
 #include "rx/rx.h"
+#include "rx/rx_link_quality.h"
 
 /*
  * Usage:
@@ -63,7 +64,8 @@ PG_RESET_TEMPLATE(failsafeConfig_t, failsafeConfig,
     .failsafe_throttle = 1000,                       // default throttle off.
     .failsafe_throttle_low_delay = 100,              // default throttle low delay for "just disarm" on failsafe condition
     .failsafe_kill_switch = 0,                       // default failsafe switch action is identical to rc link loss
-    .failsafe_procedure = FAILSAFE_PROCEDURE_DROP_IT // default full failsafe procedure is 0: auto-landing
+    .failsafe_procedure = FAILSAFE_PROCEDURE_DROP_IT, // default full failsafe procedure is 0: auto-landing
+    .failsafe_lq_warning = 50,                       // warn when half the frames are lost
 );
 
 /*
@@ -80,6 +82,7 @@ void failsafeReset(void)
     failsafeState.receivingRxDataPeriodPreset = 0;
     failsafeState.phase = FAILSAFE_IDLE;
     failsafeState.rxLinkState = FAILSAFE_RXLINK_DOWN;
+    failsafeState.linkDegraded = false;
 }
 
 void failsafeInit(void)
@@ -133,6 +136,11 @@ static void failsafeApplyControlInput(void)
     rcData[THROTTLE] = failsafeConfig()->failsafe_throttle;
 }
 
+bool failsafeIsLinkDegraded(void)
+{
+    return failsafeState.linkDegraded;
+}
+
 bool failsafeIsReceivingRxData(void)
 {
     return (failsafeState.rxLinkState == FAILSAFE_RXLINK_UP);
@@ -181,6 +189,19 @@ void failsafeUpdateState(void)
         beeperMode = BEEPER_RX_LOST;
     }
 
+    // Early warning: the link still delivers, but enough frames are lost that a failsafe may follow
+    const uint8_t linkQualityWarning = failsafeConfig()->failsafe_lq_warning;
+    if (!receivingRxData || !linkQualityWarning) {
+        failsafeState.linkDegraded = false;
+    } else if (failsafeState.linkDegraded) {
+        failsafeState.linkDegraded = rxGetLinkQuality() < linkQualityWarning + FAILSAFE_LQ_WARNING_HYSTERESIS;
+    } else {
+        failsafeState.linkDegraded = rxGetLinkQuality() < linkQualityWarning;
+    }
+    if (failsafeState.linkDegraded && armed) {
+        beeperMode = BEEPER_RX_LQ_LOW;
+    }
+
     bool reprocessState;
 
     do {
@@ -27,6 +27,7 @@
 #define PERIOD_OF_30_SECONDS          30 * MILLIS_PER_SECOND
 #define PERIOD_RXDATA_FAILURE        200    // millis
 #define PERIOD_RXDATA_RECOVERY       200    // millis
+#define FAILSAFE_LQ_WARNING_HYSTERESIS 5    // percent
 
 
 typedef struct failsafeConfig_s {
@@ -36,6 +37,7 @@ typedef struct failsafeConfig_s {
     uint16_t failsafe_throttle_low_delay;   // Time throttle stick must have been below 'min_check' to "JustDisarm" instead of "full failsafe procedure".
     uint8_t failsafe_kill_switch;           // failsafe switch action is 0: identical to rc link loss, 1: disarms instantly
     uint8_t failsafe_procedure;             // selected full failsafe procedure is 0: auto-landing, 1: Drop it
+    uint8_t failsafe_lq_warning;            // link quality in percent below which an armed craft warns of a degrading link, 0 disables
 } failsafeConfig_t;
 
 PG_DECLARE(failsafeConfig_t, failsafeConfig);
@@ -72,6 +74,7 @@ typedef struct failsafeState_s {
     uint32_t receivingRxDataPeriodPreset;   // preset for the required period of valid rxData
     failsafePhase_e phase;
     failsafeRxLinkState_e rxLinkState;
+    bool linkDegraded;                      // still receiving, but link quality is below failsafe_lq_warning
 } failsafeState_t;
 
 void failsafeInit(void);
@@ -84,6 +87,7 @@ failsafePhase_e failsafePhase();
 bool failsafeIsMonitoring(void);
 bool failsafeIsActive(void);
 bool failsafeIsReceivingRxData(void);
+bool failsafeIsLinkDegraded(void);
 void failsafeOnRxSuspend(uint32_t suspendPeriod);
 void failsafeOnRxResume(void);
 
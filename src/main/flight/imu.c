@@ -234,10 +234,26 @@ static void imuCalculateAcceleration(uint32_t deltaT)
     accSumCount++;
 }
 
+#ifdef STM32F10X
+// no FPU, the bit level estimate refined by two Newton-Raphson steps is far cheaper than the library sqrtf and divide
+static float invSqrt(float x)
+{
+    union {
+        float f;
+        int32_t i;
+    } conv = { .f = x };
+    conv.i = 0x5f3759df - (conv.i >> 1);
+    conv.f *= 1.5f - (0.5f * x * conv.f * conv.f);
+    conv.f *= 1.5f - (0.5f * x * conv.f * conv.f);
+    return conv.f;
+}
+#else
+// VSQRT and VDIV are single instructions on the FPU
 static float invSqrt(float x)
 {
     return 1.0f / sqrtf(x);
 }
+#endif
 
 static bool imuUseFastGains(void)
 {
@@ -254,6 +270,7 @@ static float imuGetPGainScaleFactor(void)
     }
 }
 
+// gx, gy and gz are the rotation over dt measured by the gyro, in radians
 static void imuMahonyAHRSupdate(float dt, float gx, float gy, float gz,
                                 bool useAcc, float ax, float ay, float az,
                                 bool useMag, float mx, float my, float mz,
@@ -262,7 +279,7 @@ static void imuMahonyAHRSupdate(float dt, float gx, float gy, float gz,
     static float integralFBx = 0.0f,  integralFBy = 0.0f, integralFBz = 0.0f;    // integral error terms scaled by Ki
 
     // Calculate general spin rate (rad/s)
-    const float spin_rate = sqrtf(sq(gx) + sq(gy) + sq(gz));
+    const float spin_rate = dt > 0.0f ? sqrtf(sq(gx) + sq(gy) + sq(gz)) / dt : 0.0f;
 
     // Use raw heading error (from GPS or whatever else)
     float ez = 0;
@@ -336,22 +353,27 @@ static void imuMahonyAHRSupdate(float dt, float gx, float gy, float gz,
     const float dcmKpGain = imuRuntimeConfig.dcm_kp * imuGetPGainScaleFactor();
 
     // Apply proportional and integral feedback
-    gx += dcmKpGain * ex + integralFBx;
-    gy += dcmKpGain * ey + integralFBy;
-    gz += dcmKpGain * ez + integralFBz;
-
-    // Integrate rate of change of quaternion
-    gx *= (0.5f * dt);
-    gy *= (0.5f * dt);
-    gz *= (0.5f * dt);
+    gx += (dcmKpGain * ex + integralFBx) * dt;
+    gy += (dcmKpGain * ey + integralFBy) * dt;
+    gz += (dcmKpGain * ez + integralFBz) * dt;
+
+    // Rotate the quaternion by the whole rotation vector in one step, exact for any angle
+    const float angle = sqrtf(sq(gx) + sq(gy) + sq(gz));
+    float sinHalfAngle, cosHalfAngle;
+    sincos_approx(0.5f * angle, &sinHalfAngle, &cosHalfAngle);
+    const float sinHalfAngleByAngle = angle > 1e-6f ? sinHalfAngle / angle : 0.5f;
+    gx *= sinHalfAngleByAngle;
+    gy *= sinHalfAngleByAngle;
+    gz *= sinHalfAngleByAngle;
 
     const float qa = q0;
     const float qb = q1;
     const float qc = q2;
-    q0 += (-qb * gx - qc * gy - q3 * gz);
-    q1 += (qa * gx + qc * gz - q3 * gy);
-    q2 += (qa * gy - qb * gz + q3 * gx);
-    q3 += (qa * gz + qb * gy - qc * gx);
+    const float qd = q3;
+    q0 = cosHalfAngle * qa - qb * gx - qc * gy - qd * gz;
+    q1 = cosHalfAngle * qb + qa * gx + qc * gz - qd * gy;
+    q2 = cosHalfAngle * qc + qa * gy - qb * gz + qd * gx;
+    q3 = cosHalfAngle * qd + qa * gz + qb * gy - qc * gx;
 
     // Normalise quaternion
     recipNorm = invSqrt(sq(q0) + sq(q1) + sq(q2) + sq(q3));
@@ -367,9 +389,9 @@ static void imuMahonyAHRSupdate(float dt, float gx, float gy, float gz,
 STATIC_UNIT_TESTED void imuUpdateEulerAngles(void)
 {
     /* Compute pitch/roll angles */
-    attitude.values.roll = lrintf(atan2f(rMat[2][1], rMat[2][2]) * (1800.0f / M_PIf));
-    attitude.values.pitch = lrintf(((0.5f * M_PIf) - acosf(-rMat[2][0])) * (1800.0f / M_PIf));
-    attitude.values.yaw = lrintf((-atan2f(rMat[1][0], rMat[0][0]) * (1800.0f / M_PIf) + magneticDeclination));
+    attitude.values.roll = lrintf(atan2_approx(rMat[2][1], rMat[2][2]) * (1800.0f / M_PIf));
+    attitude.values.pitch = lrintf(((0.5f * M_PIf) - acos_approx(-rMat[2][0])) * (1800.0f / M_PIf));
+    attitude.values.yaw = lrintf((-atan2_approx(rMat[1][0], rMat[0][0]) * (1800.0f / M_PIf) + magneticDeclination));
 
     if (attitude.values.yaw < 0)
         attitude.values.yaw += 3600;
@@ -439,8 +461,13 @@ static void imuCalculateEstimatedAttitude(timeUs_t currentTimeUs)
     deltaT = imuDeltaT;
 #endif
 
+    // the rotation summed over every gyro sample since the last update, rather than the latest rate times deltaT
+    float gyroRotation[XYZ_AXIS_COUNT];
+    timeUs_t gyroDeltaT;
+    gyroGetDeltaAngle(gyroRotation, &gyroDeltaT);
+
     imuMahonyAHRSupdate(deltaT * 1e-6f,
-                        DEGREES_TO_RADIANS(gyro.gyroADCf[X]), DEGREES_TO_RADIANS(gyro.gyroADCf[Y]), DEGREES_TO_RADIANS(gyro.gyroADCf[Z]),
+                        gyroRotation[X], gyroRotation[Y], gyroRotation[Z],
                         useAcc, acc.accSmooth[X], acc.accSmooth[Y], acc.accSmooth[Z],
                         useMag, mag.magADC[X], mag.magADC[Y], mag.magADC[Z],
                         useYaw, rawYawError);
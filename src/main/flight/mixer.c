@@ -23,6 +23,7 @@
 #include "platform.h"
 
 #include "build/build_config.h"
+#include "build/trace.h"
 
 #include "common/axis.h"
 #include "common/filter.h"
@@ -48,6 +49,7 @@
 #include "flight/imu.h"
 #include "flight/mixer.h"
 #include "flight/pid.h"
+#include "flight/rpm_filter.h"
 
 #include "rx/rx.h"
 
@@ -63,7 +65,7 @@ PG_RESET_TEMPLATE(mixerConfig_t, mixerConfig,
     .yaw_motors_reversed = false,
 );
 
-PG_REGISTER_WITH_RESET_FN(motorConfig_t, motorConfig, PG_MOTOR_CONFIG, 0);
+PG_REGISTER_WITH_RESET_FN(motorConfig_t, motorConfig, PG_MOTOR_CONFIG, 3);
 
 void pgResetFn_motorConfig(motorConfig_t *motorConfig)
 {
@@ -90,6 +92,9 @@ void pgResetFn_motorConfig(motorConfig_t *motorConfig)
     motorConfig->maxthrottle = 2000;
     motorConfig->mincommand = 1000;
     motorConfig->digitalIdleOffsetValue = 450;
+    for (int i = 0; i < THRUST_CURVE_POINTS; i++) {
+        motorConfig->thrustCurve[i] = i * 100 / (THRUST_CURVE_POINTS - 1);
+    }
 
     int motorIndex = 0;
     for (int i = 0; i < USABLE_TIMER_CHANNEL_COUNT && motorIndex < MAX_SUPPORTED_MOTORS; i++) {
@@ -118,7 +123,49 @@ float motor[MAX_SUPPORTED_MOTORS];
 float motor_disarmed[MAX_SUPPORTED_MOTORS];
 
 mixerMode_e currentMixerMode;
-static motorMixer_t currentMixer[MAX_SUPPORTED_MOTORS];
+static FAST_RAM motorMixer_t currentMixer[MAX_SUPPORTED_MOTORS];
+
+// currentMixer by axis, with the motor and yaw directions folded in
+typedef struct mixerCoefficients_s {
+    float roll[MAX_SUPPORTED_MOTORS];
+    float pitch[MAX_SUPPORTED_MOTORS];
+    float yaw[MAX_SUPPORTED_MOTORS];
+    float throttle[MAX_SUPPORTED_MOTORS];
+} mixerCoefficients_t;
+
+static mixerCoefficients_t mixerCoefficients;
+static bool mixerCoefficientsReversed;
+
+// the configuration the output stage depends on, features only change on reboot
+#define MIXER_FLAG_3D           (1 << 0)
+#define MIXER_FLAG_DSHOT        (1 << 1)
+#define MIXER_FLAG_MOTOR_STOP   (1 << 2)
+
+static uint8_t mixerFlags;
+
+/*
+ * Thrust linearisation. Propeller thrust grows about with the square of the motor output, so the same
+ * change in output does much more at high throttle than at low. The thrust curve maps the thrust the mix
+ * asks for to the motor output that gives it, interpolated between the configured points. Something like
+ * 0,32,45,55,63,71,77,84,89,95,100 undoes a square law, the default straight line is skipped.
+ */
+static float thrustCurve[THRUST_CURVE_POINTS];
+static bool thrustCurveActive;
+
+#ifdef USE_RPM_FILTER
+/*
+ * Motor matching from the RPM telemetry. In steady flight all motors give about the same thrust, so their
+ * RPM per unit of output should be the same. Each motor is trimmed towards the average, slowly and within
+ * the configured limit, which takes out differences between motors, ESCs and props.
+ */
+#define THRUST_RPM_TRIM_CUTOFF_HZ       1
+#define THRUST_RPM_TRIM_MIN_DEMAND      0.15f   // the RPM of motors close to idle says little about their thrust
+#define THRUST_RPM_TRIM_MAX_MIX_RANGE   0.1f    // only trim while the motors are asked for about the same
+
+static float thrustRpmTrim[MAX_SUPPORTED_MOTORS];
+static pt1Filter_t thrustRpmTrimFilter[MAX_SUPPORTED_MOTORS];
+static float thrustRpmTrimLimit;
+#endif
 
 float pidSumLimit;
 float pidSumLimitYaw;
@@ -383,6 +430,97 @@ void pidInitMixer(const struct pidProfile_s *pidProfile)
 {
     pidSumLimit = CONVERT_PARAMETER_TO_FLOAT(pidProfile->pidSumLimit);
     pidSumLimitYaw = CONVERT_PARAMETER_TO_FLOAT(pidProfile->pidSumLimitYaw);
+
+#ifdef USE_RPM_FILTER
+    // the trims are updated with every mix, at the PID loop rate
+    thrustRpmTrimLimit = motorConfig()->thrustRpmTrim / 100.0f;
+    for (int i = 0; i < MAX_SUPPORTED_MOTORS; i++) {
+        thrustRpmTrim[i] = 1.0f;
+        pt1FilterInit(&thrustRpmTrimFilter[i], THRUST_RPM_TRIM_CUTOFF_HZ, targetPidLooptime * 1e-6f);
+        thrustRpmTrimFilter[i].state = 1.0f;
+    }
+#endif
+}
+
+static void mixerUpdateCoefficients(bool motorsReversed)
+{
+    const int motorDirection = GET_DIRECTION(motorsReversed);
+    const int yawDirection = -GET_DIRECTION(mixerConfig()->yaw_motors_reversed) * motorDirection;
+
+    for (int i = 0; i < motorCount; i++) {
+        mixerCoefficients.roll[i] = currentMixer[i].roll * motorDirection;
+        mixerCoefficients.pitch[i] = currentMixer[i].pitch * motorDirection;
+        mixerCoefficients.yaw[i] = currentMixer[i].yaw * yawDirection;
+        mixerCoefficients.throttle[i] = currentMixer[i].throttle;
+    }
+    mixerCoefficientsReversed = motorsReversed;
+}
+
+static void mixerInitThrustCurve(void)
+{
+    thrustCurveActive = false;
+    for (int i = 0; i < THRUST_CURVE_POINTS; i++) {
+        const uint8_t point = MIN(motorConfig()->thrustCurve[i], 100);
+        thrustCurve[i] = point / 100.0f;
+        if (point != i * 100 / (THRUST_CURVE_POINTS - 1)) {
+            thrustCurveActive = true;
+        }
+    }
+}
+
+// Returns the motor output for a thrust demand. Demands outside 0 to 1 are clipped later, so they are passed through.
+static float mixerApplyThrustCurve(float demand)
+{
+    if (demand <= 0.0f || demand >= 1.0f) {
+        return demand;
+    }
+    const float position = demand * (THRUST_CURVE_POINTS - 1);
+    const int index = (int)position;
+    return thrustCurve[index] + (position - index) * (thrustCurve[index + 1] - thrustCurve[index]);
+}
+
+#ifdef USE_RPM_FILTER
+static void mixerUpdateThrustRpmTrim(const float demand[MAX_SUPPORTED_MOTORS])
+{
+    if (motorMixRange > THRUST_RPM_TRIM_MAX_MIX_RANGE) {
+        return;
+    }
+
+    float rpmPerDemand[MAX_SUPPORTED_MOTORS];
+    float rpmPerDemandSum = 0;
+    for (int i = 0; i < motorCount; i++) {
+        const float motorHz = rpmFilterGetMotorFrequencyHz(i);
+        if (demand[i] < THRUST_RPM_TRIM_MIN_DEMAND || motorHz <= 0.0f) {
+            return;
+        }
+        rpmPerDemand[i] = motorHz / demand[i];
+        rpmPerDemandSum += rpmPerDemand[i];
+    }
+
+    // the demands include the trims, so the RPM per demand of a motor does not depend on its trim
+    const float rpmPerDemandAverage = rpmPerDemandSum / motorCount;
+    for (int i = 0; i < motorCount; i++) {
+        const float trim = pt1FilterApply(&thrustRpmTrimFilter[i], rpmPerDemandAverage / rpmPerDemand[i]);
+        thrustRpmTrim[i] = constrainf(trim, 1.0f - thrustRpmTrimLimit, 1.0f + thrustRpmTrimLimit);
+    }
+}
+#endif
+
+static void mixerInitOutputStage(void)
+{
+    mixerFlags = 0;
+    if (feature(FEATURE_3D)) {
+        mixerFlags |= MIXER_FLAG_3D;
+    }
+    if (isMotorProtocolDshot()) {
+        mixerFlags |= MIXER_FLAG_DSHOT;
+    }
+    if (feature(FEATURE_MOTOR_STOP)) {
+        mixerFlags |= MIXER_FLAG_MOTOR_STOP;
+    }
+
+    mixerUpdateCoefficients(isMotorsReversed());
+    mixerInitThrustCurve();
 }
 
 #ifndef USE_QUAD_MIXER_ONLY
@@ -423,6 +561,7 @@ void mixerConfigureOutput(void)
         }
     }
 
+    mixerInitOutputStage();
     mixerResetDisarmedMotors();
 }
 
@@ -451,6 +590,7 @@ void mixerConfigureOutput(void)
         currentMixer[i] = mixerQuadX[i];
     }
 
+    mixerInitOutputStage();
     mixerResetDisarmedMotors();
 }
 #endif
@@ -469,7 +609,24 @@ void writeMotors(void)
         for (int i = 0; i < motorCount; i++) {
             pwmWriteMotor(i, motor[i]);
         }
+        TRACE_BEGIN(TRACE_MOTOR_WRITE);
         pwmCompleteMotorUpdate(motorCount);
+        TRACE_END(TRACE_MOTOR_WRITE);
+    }
+}
+
+// As writeMotors(), but once the outputs are loaded waits until outputTimeUs before starting them
+void writeMotorsAt(timeUs_t outputTimeUs)
+{
+    if (pwmAreMotorsEnabled()) {
+        for (int i = 0; i < motorCount; i++) {
+            pwmWriteMotor(i, motor[i]);
+        }
+        while (cmpTimeUs(outputTimeUs, micros()) > 0) {
+        }
+        TRACE_BEGIN(TRACE_MOTOR_WRITE);
+        pwmCompleteMotorUpdate(motorCount);
+        TRACE_END(TRACE_MOTOR_WRITE);
     }
 }
 
@@ -506,14 +663,14 @@ void calculateThrottleAndCurrentMotorEndpoints(void)
     static uint16_t throttlePrevious = 0;   // Store the last throttle direction for deadband transitions
     float currentThrottleInputRange = 0;
 
-    if(feature(FEATURE_3D)) {
+    if (mixerFlags & MIXER_FLAG_3D) {
         if (!ARMING_FLAG(ARMED)) throttlePrevious = rxConfig()->midrc; // When disarmed set to mid_rc. It always results in positive direction after arming.
 
         if((rcCommand[THROTTLE] <= (rxConfig()->midrc - flight3DConfig()->deadband3d_throttle))) {
             motorOutputMax = deadbandMotor3dLow;
             motorOutputMin = motorOutputLow;
             currentThrottleInputRange = rcCommandThrottleRange3dLow;
-            if(isMotorProtocolDshot()) mixerInversion = true;
+            if (mixerFlags & MIXER_FLAG_DSHOT) mixerInversion = true;
         } else if(rcCommand[THROTTLE] >= (rxConfig()->midrc + flight3DConfig()->deadband3d_throttle)) {
             motorOutputMax = motorOutputHigh;
             motorOutputMin = deadbandMotor3dHigh;
@@ -525,7 +682,7 @@ void calculateThrottleAndCurrentMotorEndpoints(void)
             motorOutputMin = motorOutputLow;
             throttle = rxConfig()->midrc - flight3DConfig()->deadband3d_throttle;
             currentThrottleInputRange = rcCommandThrottleRange3dLow;
-            if(isMotorProtocolDshot()) mixerInversion = true;
+            if (mixerFlags & MIXER_FLAG_DSHOT) mixerInversion = true;
         } else {
             motorOutputMax = motorOutputHigh;
             motorOutputMin = deadbandMotor3dHigh;
@@ -543,91 +700,106 @@ void calculateThrottleAndCurrentMotorEndpoints(void)
     motorOutputRange = motorOutputMax - motorOutputMin;
 }
 
-void applyMixToMotors(float motorMix[MAX_SUPPORTED_MOTORS]) {
-    // Now add in the desired throttle, but keep in a range that doesn't clip adjusted
-    // roll/pitch/yaw. This could move throttle down, but also up for those low throttle flips.
-    for (uint32_t i = 0; i < motorCount; i++) {
-        float motorOutput = motorOutputMin + motorOutputRange * (motorMix[i] + (throttle * currentMixer[i].throttle));
+static void applyMixToMotors(const float motorMix[MAX_SUPPORTED_MOTORS], float motorMixScale)
+{
+    // Disarmed mode
+    if (!ARMING_FLAG(ARMED)) {
+        for (int i = 0; i < motorCount; i++) {
+            motor[i] = motor_disarmed[i];
+        }
+        return;
+    }
 
-        // Dshot works exactly opposite in lower 3D section.
-        if (mixerInversion) {
-            motorOutput = motorOutputMin + (motorOutputMax - motorOutput);
+    // Motor stop handling
+    if ((mixerFlags & MIXER_FLAG_MOTOR_STOP) && !(mixerFlags & MIXER_FLAG_3D) && !isAirmodeActive() && rcData[THROTTLE] < rxConfig()->mincheck) {
+        for (int i = 0; i < motorCount; i++) {
+            motor[i] = disarmMotorOutput;
         }
+        return;
+    }
 
-        if (failsafeIsActive()) {
-            if (isMotorProtocolDshot()) {
-                motorOutput = (motorOutput < motorOutputMin) ? disarmMotorOutput : motorOutput; // Prevent getting into special reserved range
-            }
+    // Dshot works exactly opposite in lower 3D section.
+    const float outputBase = mixerInversion ? motorOutputMax : motorOutputMin;
+    const float outputRange = mixerInversion ? -motorOutputRange : motorOutputRange;
 
-            motorOutput = constrain(motorOutput, disarmMotorOutput, motorOutputMax);
-        } else {
-            motorOutput = constrain(motorOutput, motorOutputMin, motorOutputMax);
-        }
+    const bool failsafe = failsafeIsActive();
+    // Prevent getting into special reserved range
+    const bool dshotFailsafe = failsafe && (mixerFlags & MIXER_FLAG_DSHOT);
+    const float outputMin = failsafe ? disarmMotorOutput : motorOutputMin;
 
-        // Motor stop handling
-        if (feature(FEATURE_MOTOR_STOP) && ARMING_FLAG(ARMED) && !feature(FEATURE_3D) && !isAirmodeActive()) {
-            if (((rcData[THROTTLE]) < rxConfig()->mincheck)) {
-                motorOutput = disarmMotorOutput;
-            }
+    // Now add in the desired throttle, but keep in a range that doesn't clip adjusted
+    // roll/pitch/yaw. This could move throttle down, but also up for those low throttle flips.
+    float demand[MAX_SUPPORTED_MOTORS];
+    for (int i = 0; i < motorCount; i++) {
+        demand[i] = motorMixScale * motorMix[i] + throttle * mixerCoefficients.throttle[i];
+        if (thrustCurveActive) {
+            demand[i] = mixerApplyThrustCurve(demand[i]);
         }
-        motor[i] = motorOutput;
+#ifdef USE_RPM_FILTER
+        demand[i] *= thrustRpmTrim[i];
+#endif
+        float motorOutput = outputBase + outputRange * demand[i];
+        if (dshotFailsafe && motorOutput < motorOutputMin) {
+            motorOutput = disarmMotorOutput;
+        }
+        motor[i] = constrain(motorOutput, outputMin, motorOutputMax);
     }
 
-    // Disarmed mode
-    if (!ARMING_FLAG(ARMED)) {
-        for (int i = 0; i < motorCount; i++) {
-            motor[i] = motor_disarmed[i];
-        }
+#ifdef USE_RPM_FILTER
+    if (thrustRpmTrimLimit > 0.0f && !failsafe && isRpmFilterEnabled()) {
+        mixerUpdateThrustRpmTrim(demand);
     }
+#endif
 }
 
-void mixTable(uint8_t vbatPidCompensation)
+FAST_CODE void mixTable(uint8_t vbatPidCompensation)
 {
     // Find min and max throttle based on conditions. Throttle has to be known before mixing
     calculateThrottleAndCurrentMotorEndpoints();
 
-    float motorMix[MAX_SUPPORTED_MOTORS];
+    // the motors are reversed by the crash flip mode on arming
+    const bool motorsReversed = isMotorsReversed();
+    if (motorsReversed != mixerCoefficientsReversed) {
+        mixerUpdateCoefficients(motorsReversed);
+    }
 
     // Calculate and Limit the PIDsum
-    const float scaledAxisPidRoll =
-        constrainf((axisPID_P[FD_ROLL] + axisPID_I[FD_ROLL] + axisPID_D[FD_ROLL]) / PID_MIXER_SCALING, -pidSumLimit, pidSumLimit);
-    const float scaledAxisPidPitch =
-        constrainf((axisPID_P[FD_PITCH] + axisPID_I[FD_PITCH] + axisPID_D[FD_PITCH]) / PID_MIXER_SCALING, -pidSumLimit, pidSumLimit);
-    const float scaledAxisPidYaw =
-        constrainf((axisPID_P[FD_YAW] + axisPID_I[FD_YAW]) / PID_MIXER_SCALING, -pidSumLimitYaw, pidSumLimitYaw);
-
-    // Calculate voltage compensation
-    const float vbatCompensationFactor = (vbatPidCompensation)  ? calculateVbatPidCompensation() : 1.0f;
+    float scaledAxisPidRoll =
+        constrainf((axisPID_P[FD_ROLL] + axisPID_I[FD_ROLL] + axisPID_D[FD_ROLL] + axisPID_F[FD_ROLL]) / PID_MIXER_SCALING, -pidSumLimit, pidSumLimit);
+    float scaledAxisPidPitch =
+        constrainf((axisPID_P[FD_PITCH] + axisPID_I[FD_PITCH] + axisPID_D[FD_PITCH] + axisPID_F[FD_PITCH]) / PID_MIXER_SCALING, -pidSumLimit, pidSumLimit);
+    float scaledAxisPidYaw =
+        constrainf((axisPID_P[FD_YAW] + axisPID_I[FD_YAW] + axisPID_F[FD_YAW]) / PID_MIXER_SCALING, -pidSumLimitYaw, pidSumLimitYaw);
+
+    // Calculate voltage compensation, applied to the PID sums instead of to every motor
+    if (vbatPidCompensation) {
+        const float vbatCompensationFactor = getVbatPidCompensation();
+        if (vbatCompensationFactor > 1.0f) {
+            scaledAxisPidRoll *= vbatCompensationFactor;
+            scaledAxisPidPitch *= vbatCompensationFactor;
+            scaledAxisPidYaw *= vbatCompensationFactor;
+        }
+    }
 
     // Find roll/pitch/yaw desired output
+    float motorMix[MAX_SUPPORTED_MOTORS];
     float motorMixMax = 0, motorMixMin = 0;
-    const int yawDirection = GET_DIRECTION(mixerConfig()->yaw_motors_reversed);
-    int motorDirection = GET_DIRECTION(isMotorsReversed());
-  
     for (int i = 0; i < motorCount; i++) {
-        float mix =
-            scaledAxisPidRoll  * currentMixer[i].roll  * (motorDirection) +
-            scaledAxisPidPitch * currentMixer[i].pitch * (motorDirection) +
-            scaledAxisPidYaw   * currentMixer[i].yaw * (-yawDirection) * (motorDirection);
+        const float mix =
+            scaledAxisPidRoll  * mixerCoefficients.roll[i] +
+            scaledAxisPidPitch * mixerCoefficients.pitch[i] +
+            scaledAxisPidYaw   * mixerCoefficients.yaw[i];
 
-        if (vbatCompensationFactor > 1.0f) {
-            mix *= vbatCompensationFactor;  // Add voltage compensation
-        }
-
-        if (mix > motorMixMax) {
-            motorMixMax = mix;
-        } else if (mix < motorMixMin) {
-            motorMixMin = mix;
-        }
+        motorMixMax = MAX(motorMixMax, mix);
+        motorMixMin = MIN(motorMixMin, mix);
         motorMix[i] = mix;
     }
 
     motorMixRange = motorMixMax - motorMixMin;
 
+    float motorMixScale = 1.0f;
     if (motorMixRange > 1.0f) {
-        for (int i = 0; i < motorCount; i++) {
-            motorMix[i] /= motorMixRange;
-        }
+        motorMixScale = 1.0f / motorMixRange;
         // Get the maximum correction by setting offset to center when airmode enabled
         if (isAirmodeActive()) {
             throttle = 0.5f;
@@ -639,8 +811,8 @@ void mixTable(uint8_t vbatPidCompensation)
         }
     }
 
-    // Apply the mix to motor endpoints
-    applyMixToMotors(motorMix);
+    // Apply the mix to motor endpoints, the mix is scaled into range on the way
+    applyMixToMotors(motorMix, motorMixScale);
 }
 
 float convertExternalToMotor(uint16_t externalValue)
@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include "common/time.h"
 #include "config/parameter_group.h"
 #include "drivers/io_types.h"
 #include "drivers/pwm_output.h"
@@ -87,12 +88,16 @@ typedef struct mixerConfig_s {
 
 PG_DECLARE(mixerConfig_t, mixerConfig);
 
+#define THRUST_CURVE_POINTS 11
+
 typedef struct motorConfig_s {
     motorDevConfig_t dev;
     uint16_t digitalIdleOffsetValue;        // Idle value for DShot protocol, full motor output = 10000
     uint16_t minthrottle;                   // Set the minimum throttle command sent to the ESC (Electronic Speed Controller). This is the minimum value that allow motors to run at a idle speed.
     uint16_t maxthrottle;                   // This is the maximum value for the ESCs at full power this value can be increased up to 2000
     uint16_t mincommand;                    // This is the value for the ESCs when they are not armed. In some cases, this value must be lowered down to 900 for some specific ESCs
+    uint8_t thrustCurve[THRUST_CURVE_POINTS];   // Motor output in percent for 0, 10 ... 100 percent thrust, a straight line is off
+    uint8_t thrustRpmTrim;                  // Limit in percent of the per motor output trim, that matches the motors from their RPM. 0 is off
 } motorConfig_t;
 
 PG_DECLARE(motorConfig_t, motorConfig);
@@ -121,6 +126,7 @@ void mixerResetDisarmedMotors(void);
 void mixTable(uint8_t vbatPidCompensation);
 void syncMotors(bool enabled);
 void writeMotors(void);
+void writeMotorsAt(timeUs_t outputTimeUs);
 void stopMotors(void);
 void stopPwmAllMotors(void);
 
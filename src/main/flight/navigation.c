@@ -40,6 +40,7 @@
 #include "fc/rc_modes.h"
 #include "fc/runtime_config.h"
 
+#include "flight/altitude.h"
 #include "flight/imu.h"
 #include "flight/navigation.h"
 #include "flight/pid.h"
@@ -64,7 +65,8 @@ PG_RESET_TEMPLATE(navigationConfig_t, navigationConfig,
     .nav_controls_heading = 1,
     .nav_speed_min = 100,
     .nav_speed_max = 300,
-    .ap_mode = 40
+    .ap_mode = 40,
+    .nav_rth_altitude = 20
 );
 
 bool areSticksInApModePosition(uint16_t ap_mode);
@@ -107,11 +109,11 @@ void navigationInit(void)
 #define GPS_FILTERING              1    // add a 5 element moving average filter to GPS coordinates, helps eliminate gps noise but adds latency
 #define GPS_LOW_SPEED_D_FILTER     1    // below .5m/s speed ignore D term for POSHOLD_RATE, theoretically this also removed D term induced noise
 
-static void GPS_distance_cm_bearing(int32_t * lat1, int32_t * lon1, int32_t * lat2, int32_t * lon2, uint32_t * dist, int32_t * bearing);
-//static void GPS_distance(int32_t lat1, int32_t lon1, int32_t lat2, int32_t lon2, uint16_t* dist, int16_t* bearing);
+static void navVectorDistanceBearing(float north, float east, uint32_t *dist, int32_t *bearing);
 static void GPS_calc_longitude_scaling(int32_t lat);
 static void GPS_calc_velocity(void);
-static void GPS_calc_location_error(int32_t * target_lat, int32_t * target_lng, int32_t * gps_lat, int32_t * gps_lng);
+static void GPS_calc_location_error(void);
+static void GPS_calc_angles(void);
 
 #ifdef USE_NAV
 static bool check_missed_wp(void);
@@ -199,6 +201,7 @@ static void reset_PID(PID *pid)
 #define CROSSTRACK_GAIN            1
 #define NAV_SLOW_NAV               true
 #define NAV_BANK_MAX               3000 // 30deg max banking when navigating (just for security and testing)
+#define NAV_SLEW_RATE_LOOP_HZ      400  // rate nav_slew_rate steps were applied at when it ran in the main loop
 
 static float dTnav;             // Delta Time in milliseconds for navigation computations, updated with every good GPS read
 static int16_t actual_speed[2] = { 0, 0 };
@@ -257,12 +260,41 @@ static int32_t nav_bearing;
 // saves the bearing at takeof (1deg = 1) used to rotate to takeoff direction when arrives at home
 static int16_t nav_takeoff_bearing;
 
+////////////////////////////////////////////////////////////////////////////////////
+// Local tangent plane around navOrigin (home once it is set)
+// Positions are north/east offsets in 1/10 000 000 degree of latitude (about 1.1cm), the longitude scale is
+// worked out once for the origin's latitude. A fix then costs two subtractions and a multiply to place, and
+// distances and bearings come from the difference of two local vectors instead of from the coordinates.
+//
+static int32_t navOrigin[2];
+static bool navOriginValid = false;
+static float navPosition[2];    // current position, [LAT] north, [LON] east
+static float navTarget[2];      // GPS_WP
+
+static void navToLocal(int32_t lat, int32_t lon, float *local)
+{
+    local[LAT] = lat - navOrigin[LAT];
+    local[LON] = (float)(lon - navOrigin[LON]) * GPS_scaleLonDown;
+}
+
+static void navSetOrigin(int32_t lat, int32_t lon)
+{
+    navOrigin[LAT] = lat;
+    navOrigin[LON] = lon;
+    GPS_calc_longitude_scaling(lat);
+    navOriginValid = true;
+
+    navToLocal(GPS_WP[LAT], GPS_WP[LON], navTarget);
+}
+
 void GPS_calculateDistanceAndDirectionToHome(void)
 {
     if (STATE(GPS_FIX_HOME)) {      // If we don't have home set, do not display anything
         uint32_t dist;
         int32_t dir;
-        GPS_distance_cm_bearing(&gpsSol.llh.lat, &gpsSol.llh.lon, &GPS_home[LAT], &GPS_home[LON], &dist, &dir);
+        float home[2];
+        navToLocal(GPS_home[LAT], GPS_home[LON], home);
+        navVectorDistanceBearing(home[LAT] - navPosition[LAT], home[LON] - navPosition[LON], &dist, &dir);
         GPS_distanceToHome = dist / 100;
         GPS_directionToHome = dir / 100;
     } else {
@@ -321,6 +353,11 @@ void onGpsNewData(void)
     // prevent runup from bad GPS
     dTnav = MIN(dTnav, 1.0f);
 
+    if (!navOriginValid) {
+        navSetOrigin(gpsSol.llh.lat, gpsSol.llh.lon);
+    }
+    navToLocal(gpsSol.llh.lat, gpsSol.llh.lon, navPosition);
+
     GPS_calculateDistanceAndDirectionToHome();
 
     // calculate the current velocity based on gps coordinates continously to get a valid speed at the moment when we start navigating
@@ -331,8 +368,7 @@ void onGpsNewData(void)
         // we are navigating
 
         // gps nav calculations, these are common for nav and poshold
-        GPS_distance_cm_bearing(&gpsSol.llh.lat, &gpsSol.llh.lon, &GPS_WP[LAT], &GPS_WP[LON], &wp_distance, &target_bearing);
-        GPS_calc_location_error(&GPS_WP[LAT], &GPS_WP[LON], &gpsSol.llh.lat, &gpsSol.llh.lon);
+        GPS_calc_location_error();
 
         uint16_t speed;
         switch (nav_mode) {
@@ -347,6 +383,13 @@ void onGpsNewData(void)
             // Desired output is in nav_lat and nav_lon where 1deg inclination is 100
             GPS_calc_nav_rate(speed);
 
+#ifdef BARO
+            // with alt hold running, coming home raises the held altitude to the return altitude, it never lowers it
+            if (FLIGHT_MODE(GPS_HOME_MODE) && FLIGHT_MODE(BARO_MODE) && navigationConfig()->nav_rth_altitude) {
+                AltHold = MAX(AltHold, navigationConfig()->nav_rth_altitude * 100);
+            }
+#endif
+
             // Tail control
             if (navigationConfig()->nav_controls_heading) {
                 if (NAV_TAIL_FIRST) {
@@ -368,6 +411,10 @@ void onGpsNewData(void)
         }
     }                   //end of gps calcs
 #endif
+
+    if ((FLIGHT_MODE(GPS_HOME_MODE) || FLIGHT_MODE(GPS_HOLD_MODE)) && STATE(GPS_FIX_HOME)) {
+        GPS_calc_angles();
+    }
 }
 
 void GPS_reset_home_position(void)
@@ -375,7 +422,7 @@ void GPS_reset_home_position(void)
     if (STATE(GPS_FIX) && gpsSol.numSat >= 5) {
         GPS_home[LAT] = gpsSol.llh.lat;
         GPS_home[LON] = gpsSol.llh.lon;
-        GPS_calc_longitude_scaling(gpsSol.llh.lat); // need an initial value for distance and bearing calc
+        navSetOrigin(GPS_home[LAT], GPS_home[LON]);
         nav_takeoff_bearing = DECIDEGREES_TO_DEGREES(attitude.values.yaw);              // save takeoff heading
         // Set ground altitude
         ENABLE_STATE(GPS_FIX_HOME);
@@ -429,7 +476,7 @@ void gpsUsePIDs(pidProfile_t *pidProfile)
 
 ////////////////////////////////////////////////////////////////////////////////////
 // this is used to offset the shrinking longitude as we go towards the poles
-// It's ok to calculate this once per waypoint setting, since it changes a little within the reach of a multicopter
+// It's ok to calculate this once for the local frame origin, since it changes a little within the reach of a multicopter
 //
 static void GPS_calc_longitude_scaling(int32_t lat)
 {
@@ -445,11 +492,16 @@ void GPS_set_next_wp(int32_t *lat, int32_t *lon)
     GPS_WP[LAT] = *lat;
     GPS_WP[LON] = *lon;
 
-    GPS_calc_longitude_scaling(*lat);
-    GPS_distance_cm_bearing(&gpsSol.llh.lat, &gpsSol.llh.lon, &GPS_WP[LAT], &GPS_WP[LON], &wp_distance, &target_bearing);
+    if (navOriginValid) {
+        navToLocal(GPS_WP[LAT], GPS_WP[LON], navTarget);
+    } else {
+        navSetOrigin(GPS_WP[LAT], GPS_WP[LON]);
+    }
+    navToLocal(gpsSol.llh.lat, gpsSol.llh.lon, navPosition);
+
+    GPS_calc_location_error();
 
     nav_bearing = target_bearing;
-    GPS_calc_location_error(&GPS_WP[LAT], &GPS_WP[LON], &gpsSol.llh.lat, &gpsSol.llh.lon);
     original_target_bearing = target_bearing;
     waypoint_speed_gov = navigationConfig()->nav_speed_min;
 }
@@ -471,30 +523,17 @@ static bool check_missed_wp(void)
 #define TAN_89_99_DEGREES 5729.57795f
 
 ////////////////////////////////////////////////////////////////////////////////////
-// Get distance between two points in cm
-// Get bearing from pos1 to pos2, returns an 1deg = 100 precision
-static void GPS_distance_cm_bearing(int32_t *currentLat1, int32_t *currentLon1, int32_t *destinationLat2, int32_t *destinationLon2, uint32_t *dist, int32_t *bearing)
+// Get the length in cm of a local frame vector
+// Get its bearing, returns an 1deg = 100 precision
+static void navVectorDistanceBearing(float north, float east, uint32_t *dist, int32_t *bearing)
 {
-    float dLat = *destinationLat2 - *currentLat1; // difference of latitude in 1/10 000 000 degrees
-    float dLon = (float)(*destinationLon2 - *currentLon1) * GPS_scaleLonDown;
-    *dist = sqrtf(sq(dLat) + sq(dLon)) * DISTANCE_BETWEEN_TWO_LONGITUDE_POINTS_AT_EQUATOR_IN_HUNDREDS_OF_KILOMETERS;
+    *dist = sqrtf(sq(north) + sq(east)) * DISTANCE_BETWEEN_TWO_LONGITUDE_POINTS_AT_EQUATOR_IN_HUNDREDS_OF_KILOMETERS;
 
-    *bearing = 9000.0f + atan2_approx(-dLat, dLon) * TAN_89_99_DEGREES;      // Convert the output radians to 100xdeg
+    *bearing = 9000.0f + atan2_approx(-north, east) * TAN_89_99_DEGREES;      // Convert the output radians to 100xdeg
     if (*bearing < 0)
         *bearing += 36000;
 }
 
-////////////////////////////////////////////////////////////////////////////////////
-// keep old calculation function for compatibility (could be removed later) distance in meters, bearing in degree
-//
-//static void GPS_distance(int32_t lat1, int32_t lon1, int32_t lat2, int32_t lon2, uint16_t* dist, int16_t* bearing) {
-//  uint32_t d1;
-//  int32_t  d2;
-//  GPS_distance_cm_bearing(&lat1,&lon1,&lat2,&lon2,&d1,&d2);
-//  *dist = d1 / 100;          //convert to meters
-//  *bearing = d2 /  100;      //convert to degrees
-//}
-
 ////////////////////////////////////////////////////////////////////////////////////
 // Calculate our current speed vector from gps position data
 //
@@ -529,11 +568,16 @@ static void GPS_calc_velocity(void)
 //      1800    = 19.80m = 60 feet
 //      3000    = 33m
 //      10000   = 111m
+// The distance and bearing to the waypoint come from the same vector
 //
-static void GPS_calc_location_error(int32_t *target_lat, int32_t *target_lng, int32_t *gps_lat, int32_t *gps_lng)
+static void GPS_calc_location_error(void)
 {
-    error[LON] = (float)(*target_lng - *gps_lng) * GPS_scaleLonDown;   // X Error
-    error[LAT] = *target_lat - *gps_lat;        // Y Error
+    const float north = navTarget[LAT] - navPosition[LAT];
+    const float east = navTarget[LON] - navPosition[LON];
+    error[LON] = east;      // X Error
+    error[LAT] = north;     // Y Error
+
+    navVectorDistanceBearing(north, east, &wp_distance, &target_bearing);
 }
 
 #ifdef USE_NAV
@@ -581,8 +625,7 @@ static void GPS_calc_nav_rate(uint16_t max_speed)
 
     // nav_bearing includes crosstrack
     temp = (9000l - nav_bearing) * RADX100;
-    trig[GPS_X] = cos_approx(temp);
-    trig[GPS_Y] = sin_approx(temp);
+    sincos_approx(temp, &trig[GPS_Y], &trig[GPS_X]);
 
     for (axis = 0; axis < 2; axis++) {
         rate_error[axis] = (trig[axis] * max_speed) - actual_speed[axis];
@@ -667,13 +710,19 @@ static int32_t wrap_36000(int32_t angle)
 }
 #endif
 
-void updateGpsStateForHomeAndHoldMode(void)
+////////////////////////////////////////////////////////////////////////////////////
+// Turn the earth frame nav output into the roll and pitch angles the level mode adds,
+// once per GPS update rather than in the PID loop
+//
+static void GPS_calc_angles(void)
 {
-    float sin_yaw_y = sin_approx(DECIDEGREES_TO_DEGREES(attitude.values.yaw) * 0.0174532925f);
-    float cos_yaw_x = cos_approx(DECIDEGREES_TO_DEGREES(attitude.values.yaw) * 0.0174532925f);
+    float sin_yaw_y, cos_yaw_x;
+    sincos_approx(DECIDEGREES_TO_DEGREES(attitude.values.yaw) * 0.0174532925f, &sin_yaw_y, &cos_yaw_x);
     if (navigationConfig()->nav_slew_rate) {
-        nav_rated[LON] += constrain(wrap_18000(nav[LON] - nav_rated[LON]), -navigationConfig()->nav_slew_rate, navigationConfig()->nav_slew_rate); // TODO check this on uint8
-        nav_rated[LAT] += constrain(wrap_18000(nav[LAT] - nav_rated[LAT]), -navigationConfig()->nav_slew_rate, navigationConfig()->nav_slew_rate);
+        // nav_slew_rate is a step per main loop iteration of the original code, scale it to the time between updates
+        const int16_t slew = MAX(navigationConfig()->nav_slew_rate * NAV_SLEW_RATE_LOOP_HZ * dTnav, 1);
+        nav_rated[LON] += constrain(wrap_18000(nav[LON] - nav_rated[LON]), -slew, slew);
+        nav_rated[LAT] += constrain(wrap_18000(nav[LAT] - nav_rated[LAT]), -slew, slew);
         GPS_angle[AI_ROLL] = (nav_rated[LON] * cos_yaw_x - nav_rated[LAT] * sin_yaw_y) / 10;
         GPS_angle[AI_PITCH] = (nav_rated[LON] * sin_yaw_y + nav_rated[LAT] * cos_yaw_x) / 10;
     } else {
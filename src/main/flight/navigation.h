@@ -36,6 +36,7 @@ typedef struct navigationConfig_s {
     uint16_t nav_speed_min;                 // cm/sec
     uint16_t nav_speed_max;                 // cm/sec
     uint16_t ap_mode;                       // Temporarily Disables GPS_HOLD_MODE to be able to make it possible to adjust the Hold-position when moving the sticks, creating a deadspan for GPS
+    uint16_t nav_rth_altitude;              // m, least altitude alt hold keeps while coming home, 0 leaves the held altitude alone
 } navigationConfig_t;
 
 PG_DECLARE(navigationConfig_t, navigationConfig);
@@ -54,8 +55,8 @@ void navigationInit(void);
 void GPS_reset_home_position(void);
 void GPS_reset_nav(void);
 void GPS_set_next_wp(int32_t* lat, int32_t* lon);
+struct pidProfile_s;
 void gpsUsePIDs(struct pidProfile_s *pidProfile);
-void updateGpsStateForHomeAndHoldMode(void);
 void updateGpsWaypointsAndMode(void);
 
 void onGpsNewData(void);
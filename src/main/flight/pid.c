@@ -52,11 +52,12 @@
 uint32_t targetPidLooptime;
 static bool pidStabilisationEnabled;
 
-float axisPID_P[3], axisPID_I[3], axisPID_D[3];
+float axisPID_P[3], axisPID_I[3], axisPID_D[3], axisPID_F[3];
 
 static float dT;
+static float pidLooptimeUs;    // targetPidLooptime on the gyro's sample clock
 
-PG_REGISTER_WITH_RESET_TEMPLATE(pidConfig_t, pidConfig, PG_PID_CONFIG, 1);
+PG_REGISTER_WITH_RESET_TEMPLATE(pidConfig_t, pidConfig, PG_PID_CONFIG, 2);
 
 #ifdef STM32F10X
 #define PID_PROCESS_DENOM_DEFAULT       1
@@ -66,10 +67,11 @@ PG_REGISTER_WITH_RESET_TEMPLATE(pidConfig_t, pidConfig, PG_PID_CONFIG, 1);
 #define PID_PROCESS_DENOM_DEFAULT       2
 #endif
 PG_RESET_TEMPLATE(pidConfig_t, pidConfig,
-    .pid_process_denom = PID_PROCESS_DENOM_DEFAULT
+    .pid_process_denom = PID_PROCESS_DENOM_DEFAULT,
+    .motorOutputDelayUs = 0
 );
 
-PG_REGISTER_ARRAY_WITH_RESET_FN(pidProfile_t, MAX_PROFILE_COUNT, pidProfiles, PG_PID_PROFILE, 0);
+PG_REGISTER_ARRAY_WITH_RESET_FN(pidProfile_t, MAX_PROFILE_COUNT, pidProfiles, PG_PID_PROFILE, 2);
 
 void resetPidProfile(pidProfile_t *pidProfile)
 {
@@ -113,7 +115,15 @@ void resetPidProfile(pidProfile_t *pidProfile)
         .crash_gthreshold = 500,    // 500 degrees/second
         .crash_recovery = PID_CRASH_RECOVERY_OFF, // off by default
         .horizon_tilt_effect = 75,
-        .horizon_tilt_expert_mode = false
+        .horizon_tilt_expert_mode = false,
+        .feedForward = { 0, 0, 0 },
+        .feedForwardSmoothing = 30,
+        .itermRelax = ITERM_RELAX_OFF,
+        .itermRelaxType = ITERM_RELAX_GYRO,
+        .itermRelaxCutoff = 20,
+        .absControlGain = 0,
+        .absControlLimit = 90,
+        .absControlErrorLimit = 20
     );
 }
 
@@ -127,13 +137,21 @@ void pgResetFn_pidProfiles(pidProfile_t *pidProfiles)
 void pidSetTargetLooptime(uint32_t pidLooptime)
 {
     targetPidLooptime = pidLooptime;
-    dT = (float)targetPidLooptime * 0.000001f;
+    pidLooptimeUs = targetPidLooptime;
+    dT = pidLooptimeUs * 0.000001f;
 }
 
+#ifdef USE_ABSOLUTE_CONTROL
+static float axisError[XYZ_AXIS_COUNT];
+#endif
+
 void pidResetErrorGyroState(void)
 {
     for (int axis = 0; axis < 3; axis++) {
         axisPID_I[axis] = 0.0f;
+#ifdef USE_ABSOLUTE_CONTROL
+        axisError[axis] = 0.0f;
+#endif
     }
 }
 
@@ -150,22 +168,27 @@ void pidStabilisationState(pidStabilisationState_e pidControllerState)
 
 const angle_index_t rcAliasToAngleIndexMap[] = { AI_ROLL, AI_PITCH };
 
-static filterApplyFnPtr dtermNotchFilterApplyFn;
-static void *dtermFilterNotch[2];
-static filterApplyFnPtr dtermLpfApplyFn;
-static void *dtermFilterLpf[2];
+// the D term filters run on all three axes in one call, the yaw result is not used
+static filterApplyXyzFnPtr dtermNotchFilterApplyFn = nullFilterApplyXyz;
+static void *dtermFilterNotch;
+static filterApplyXyzFnPtr dtermLpfApplyFn = nullFilterApplyXyz;
+static void *dtermFilterLpf;
 static filterApplyFnPtr ptermYawFilterApplyFn;
 static void *ptermYawFilter;
+#if defined(USE_ITERM_RELAX) || defined(USE_ABSOLUTE_CONTROL)
+static bool windupLpfEnabled;
+static FAST_RAM pt1Filter_t windupLpf[XYZ_AXIS_COUNT];
+#endif
 
 void pidInitFilters(const pidProfile_t *pidProfile)
 {
-    BUILD_BUG_ON(FD_YAW != 2); // only setting up Dterm filters on roll and pitch axes, so ensure yaw axis is 2
+    BUILD_BUG_ON(FD_YAW != 2); // Dterm filters are applied to the roll and pitch lanes of a three axis filter, so ensure yaw axis is 2
 
-    static biquadFilter_t biquadFilterNotch[2];
-    static pt1Filter_t pt1Filter[2];
-    static biquadFilter_t biquadFilter[2];
-    static firFilterDenoise_t denoisingFilter[2];
-    static pt1Filter_t pt1FilterYaw;
+    static FAST_RAM biquadFilterXyz_t biquadFilterNotch;
+    static FAST_RAM pt1FilterXyz_t pt1Filter;
+    static FAST_RAM biquadFilterXyz_t biquadFilter;
+    static FAST_RAM firFilterDenoiseXyz_t denoisingFilter;
+    static FAST_RAM pt1Filter_t pt1FilterYaw;
 
     uint32_t pidFrequencyNyquist = (1.0f / dT) / 2; // No rounding needed
 
@@ -181,43 +204,35 @@ void pidInitFilters(const pidProfile_t *pidProfile)
     }
 
     if (!dTermNotchHz) {
-        dtermNotchFilterApplyFn = nullFilterApply;
+        dtermNotchFilterApplyFn = nullFilterApplyXyz;
     } else {
-        dtermNotchFilterApplyFn = (filterApplyFnPtr)biquadFilterApply;
+        dtermNotchFilterApplyFn = (filterApplyXyzFnPtr)biquadFilterXyzApply;
         const float notchQ = filterGetNotchQ(dTermNotchHz, pidProfile->dterm_notch_cutoff);
-        for (int axis = FD_ROLL; axis <= FD_PITCH; axis++) {
-            dtermFilterNotch[axis] = &biquadFilterNotch[axis];
-            biquadFilterInit(dtermFilterNotch[axis], dTermNotchHz, targetPidLooptime, notchQ, FILTER_NOTCH);
-        }
+        dtermFilterNotch = &biquadFilterNotch;
+        biquadFilterXyzInit(dtermFilterNotch, dTermNotchHz, pidLooptimeUs, notchQ, FILTER_NOTCH);
     }
 
     if (pidProfile->dterm_lpf_hz == 0 || pidProfile->dterm_lpf_hz > pidFrequencyNyquist) {
-        dtermLpfApplyFn = nullFilterApply;
+        dtermLpfApplyFn = nullFilterApplyXyz;
     } else {
         switch (pidProfile->dterm_filter_type) {
         default:
-            dtermLpfApplyFn = nullFilterApply;
+            dtermLpfApplyFn = nullFilterApplyXyz;
             break;
         case FILTER_PT1:
-            dtermLpfApplyFn = (filterApplyFnPtr)pt1FilterApply;
-            for (int axis = FD_ROLL; axis <= FD_PITCH; axis++) {
-                dtermFilterLpf[axis] = &pt1Filter[axis];
-                pt1FilterInit(dtermFilterLpf[axis], pidProfile->dterm_lpf_hz, dT);
-            }
+            dtermLpfApplyFn = (filterApplyXyzFnPtr)pt1FilterXyzApply;
+            dtermFilterLpf = &pt1Filter;
+            pt1FilterXyzInit(dtermFilterLpf, pidProfile->dterm_lpf_hz, dT);
             break;
         case FILTER_BIQUAD:
-            dtermLpfApplyFn = (filterApplyFnPtr)biquadFilterApply;
-            for (int axis = FD_ROLL; axis <= FD_PITCH; axis++) {
-                dtermFilterLpf[axis] = &biquadFilter[axis];
-                biquadFilterInitLPF(dtermFilterLpf[axis], pidProfile->dterm_lpf_hz, targetPidLooptime);
-            }
+            dtermLpfApplyFn = (filterApplyXyzFnPtr)biquadFilterXyzApply;
+            dtermFilterLpf = &biquadFilter;
+            biquadFilterXyzInitLPF(dtermFilterLpf, pidProfile->dterm_lpf_hz, pidLooptimeUs);
             break;
         case FILTER_FIR:
-            dtermLpfApplyFn = (filterApplyFnPtr)firFilterDenoiseUpdate;
-            for (int axis = FD_ROLL; axis <= FD_PITCH; axis++) {
-                dtermFilterLpf[axis] = &denoisingFilter[axis];
-                firFilterDenoiseInit(dtermFilterLpf[axis], pidProfile->dterm_lpf_hz, targetPidLooptime);
-            }
+            dtermLpfApplyFn = (filterApplyXyzFnPtr)firFilterDenoiseXyzUpdate;
+            dtermFilterLpf = &denoisingFilter;
+            firFilterDenoiseXyzInit(dtermFilterLpf, pidProfile->dterm_lpf_hz, pidLooptimeUs);
             break;
         }
     }
@@ -229,11 +244,29 @@ void pidInitFilters(const pidProfile_t *pidProfile)
         ptermYawFilter = &pt1FilterYaw;
         pt1FilterInit(ptermYawFilter, pidProfile->yaw_lpf_hz, dT);
     }
+
+#if defined(USE_ITERM_RELAX) || defined(USE_ABSOLUTE_CONTROL)
+    // the setpoint low pass that I term relax and absolute control measure stick moves against
+    windupLpfEnabled = pidProfile->itermRelax != ITERM_RELAX_OFF || pidProfile->absControlGain;
+    for (int axis = FD_ROLL; axis <= FD_YAW; axis++) {
+        pt1FilterInit(&windupLpf[axis], pidProfile->itermRelaxCutoff, dT);
+    }
+#endif
 }
 
-static float Kp[3], Ki[3], Kd[3], maxVelocity[3];
+static float Kp[3], Ki[3], Kd[3], Kf[3], maxVelocity[3];
 static float relaxFactor;
 static float dtermSetpointWeight;
+static bool setpointRelaxEnabled;
+static bool crashRecoveryEnabled;
+#ifdef USE_ITERM_RELAX
+static bool itermRelaxAxis[XYZ_AXIS_COUNT];
+static bool itermRelaxIncreaseOnly;
+static uint8_t itermRelaxType;
+#endif
+#ifdef USE_ABSOLUTE_CONTROL
+static float acGain, acLimit, acErrorLimit;
+#endif
 static float levelGain, horizonGain, horizonTransition, horizonCutoffDegrees,
              horizonFactorRatio, ITermWindupPoint, ITermWindupPointInv;
 static uint8_t horizonTiltExpertMode;
@@ -245,17 +278,26 @@ static float crashDtermThreshold;
 static float crashGyroThreshold;
 static float inCrashRecoveryMaybe;
 
-void pidInitConfig(const pidProfile_t *pidProfile) {
+// The settings the in-flight adjustments change, the controller picks them up on its next run
+void pidInitGains(const pidProfile_t *pidProfile)
+{
     for (int axis = FD_ROLL; axis <= FD_YAW; axis++) {
         Kp[axis] = PTERM_SCALE * pidProfile->pid[axis].P;
-        Ki[axis] = ITERM_SCALE * pidProfile->pid[axis].I;
-        Kd[axis] = DTERM_SCALE * pidProfile->pid[axis].D;
+        // the loop time is folded into the I and D gains, so the controller does not scale by it every loop
+        Ki[axis] = ITERM_SCALE * pidProfile->pid[axis].I * dT;
+        Kd[axis] = DTERM_SCALE * pidProfile->pid[axis].D / dT;
+        Kf[axis] = FTERM_SCALE * pidProfile->feedForward[axis];
     }
     dtermSetpointWeight = pidProfile->dtermSetpointWeight / 127.0f;
     relaxFactor = 1.0f / (pidProfile->setpointRelaxRatio / 100.0f);
+    setpointRelaxEnabled = pidProfile->setpointRelaxRatio < 100;
     levelGain = pidProfile->pid[PID_LEVEL].P / 10.0f;
     horizonGain = pidProfile->pid[PID_LEVEL].I / 10.0f;
     horizonTransition = (float)pidProfile->pid[PID_LEVEL].D;
+}
+
+void pidInitConfig(const pidProfile_t *pidProfile) {
+    pidInitGains(pidProfile);
     horizonTiltExpertMode = pidProfile->horizon_tilt_expert_mode;
     horizonCutoffDegrees = (175 - pidProfile->horizon_tilt_effect) * 1.8f;
     horizonFactorRatio = (100 - pidProfile->horizon_tilt_effect) * 0.01f;
@@ -268,15 +310,52 @@ void pidInitConfig(const pidProfile_t *pidProfile) {
     crashRecoveryAngleDeciDegrees = pidProfile->crash_recovery_angle * 10;
     crashRecoveryRate = pidProfile->crash_recovery_rate;
     crashGyroThreshold = pidProfile->crash_gthreshold;
-    crashDtermThreshold = pidProfile->crash_dthreshold;
+    crashDtermThreshold = pidProfile->crash_dthreshold * dT; // compared with the D term input change of one loop
+    // the accelerometer is only detected at boot, so it can be checked here rather than every loop
+    crashRecoveryEnabled = pidProfile->crash_recovery != PID_CRASH_RECOVERY_OFF && sensors(SENSOR_ACC);
+#ifdef USE_ITERM_RELAX
+    const bool itermRelaxYaw = pidProfile->itermRelax == ITERM_RELAX_RPY || pidProfile->itermRelax == ITERM_RELAX_RPY_INC;
+    itermRelaxAxis[FD_ROLL] = itermRelaxAxis[FD_PITCH] = pidProfile->itermRelax != ITERM_RELAX_OFF;
+    itermRelaxAxis[FD_YAW] = itermRelaxYaw;
+    itermRelaxIncreaseOnly = pidProfile->itermRelax == ITERM_RELAX_RP_INC || pidProfile->itermRelax == ITERM_RELAX_RPY_INC;
+    itermRelaxType = pidProfile->itermRelaxType;
+#endif
+#ifdef USE_ABSOLUTE_CONTROL
+    acGain = (float)pidProfile->absControlGain;
+    acLimit = (float)pidProfile->absControlLimit;
+    acErrorLimit = (float)pidProfile->absControlErrorLimit;
+#endif
+}
+
+static const pidProfile_t *pidInitProfile;
+static uint16_t pidInitGeneration;
+
+// the profiles and the pid config are all the controller is set up from
+static uint16_t pidGeneration(void)
+{
+    return pidProfilesGeneration() + pidConfigGeneration();
 }
 
 void pidInit(const pidProfile_t *pidProfile)
 {
     pidSetTargetLooptime(gyro.targetLooptime * pidConfig()->pid_process_denom); // Initialize pid looptime
+    // the loop is paced by the gyro, so it really runs on the gyro's own clock
+    pidLooptimeUs *= gyroSampleClockScale();
+    dT = pidLooptimeUs * 0.000001f;
     pidInitFilters(pidProfile);
     pidInitConfig(pidProfile);
     pidInitMixer(pidProfile);
+
+    pidInitProfile = pidProfile;
+    pidInitGeneration = pidGeneration();
+}
+
+// Re-initialising resets the filters, so a config reload that left the controller's settings alone keeps them running
+void pidInitIfChanged(const pidProfile_t *pidProfile)
+{
+    if (pidProfile != pidInitProfile || pidGeneration() != pidInitGeneration) {
+        pidInit(pidProfile);
+    }
 }
 
 // calculates strength of horizon leveling; 0 = none, 1.0 = most leveling
@@ -370,20 +449,82 @@ static float accelerationLimit(int axis, float currentPidSetpoint) {
     return currentPidSetpoint;
 }
 
+#ifdef USE_ITERM_RELAX
+#define ITERM_RELAX_SETPOINT_THRESHOLD 30.0f // deg/sec of setpoint high pass at which the I term stops growing
+
+// Holds back the I term while the setpoint moves faster than the quad can follow, so it does not wind up during flips and rolls
+static float applyItermRelax(float iterm, float itermErrorRate, float gyroRate, float setpointLpf, float setpointHpf)
+{
+    const bool isDecreasingI = (iterm > 0 && itermErrorRate < 0) || (iterm < 0 && itermErrorRate > 0);
+    if (itermRelaxIncreaseOnly && isDecreasingI) {
+        return itermErrorRate;
+    }
+    if (itermRelaxType == ITERM_RELAX_SETPOINT) {
+        return itermErrorRate * MAX(0.0f, 1.0f - setpointHpf / ITERM_RELAX_SETPOINT_THRESHOLD);
+    }
+    // gyro: only integrate what the gyro is off the smoothed setpoint, by more than the setpoint is moving
+    return fapplyDeadband(setpointLpf - gyroRate, setpointHpf);
+}
+#endif
+
+#ifdef USE_ABSOLUTE_CONTROL
+/*
+ * Accumulates the attitude error from the gyro leaving a band around the smoothed setpoint, which is as
+ * wide as the setpoint is moving, and returns the rate correction that flies it back. Inside the band the
+ * accumulated error is wound back towards zero, but not past it.
+ */
+static float applyAbsoluteControl(int axis, float gyroRate, float setpointLpf, float setpointHpf)
+{
+    const float gmaxac = setpointLpf + 2 * setpointHpf;
+    const float gminac = setpointLpf - 2 * setpointHpf;
+    float acErrorRate;
+    if (gyroRate >= gminac && gyroRate <= gmaxac) {
+        const float acErrorRate1 = gmaxac - gyroRate;
+        const float acErrorRate2 = gminac - gyroRate;
+        acErrorRate = (acErrorRate1 * axisError[axis] < 0) ? acErrorRate1 : acErrorRate2;
+        if (fabsf(acErrorRate * dT) > fabsf(axisError[axis])) {
+            acErrorRate = -axisError[axis] / dT;
+        }
+    } else {
+        acErrorRate = (gyroRate > gmaxac ? gmaxac : gminac) - gyroRate;
+    }
+
+    axisError[axis] = constrainf(axisError[axis] + acErrorRate * dT, -acErrorLimit, acErrorLimit);
+    return constrainf(axisError[axis] * acGain, -acLimit, acLimit);
+}
+#endif
+
+static bool inCrashRecoveryMode = false;
+
+bool pidCrashRecoveryActive(void)
+{
+    return inCrashRecoveryMode;
+}
+
 // Betaflight pid controller, which will be maintained in the future with additional features specialised for current (mini) multirotor usage.
 // Based on 2DOF reference design (matlab)
-void pidController(const pidProfile_t *pidProfile, const rollAndPitchTrims_t *angleTrim, timeUs_t currentTimeUs)
+FAST_CODE void pidController(const pidProfile_t *pidProfile, const rollAndPitchTrims_t *angleTrim, timeUs_t currentTimeUs)
 {
     static float previousRateError[2];
     const float tpaFactor = getThrottlePIDAttenuation();
     const float motorMixRange = getMotorMixRange();
-    static bool inCrashRecoveryMode = false;
     static timeUs_t crashDetectedAtUs;
     static timeUs_t crashDetectedMaybeAtUs;
 
     // Dynamic ki component to gradually scale back integration when above windup point
     const float dynKi = MIN((1.0f - motorMixRange) * ITermWindupPointInv, 1.0f);
 
+    // apply the D term filters to all axes at once
+    float gyroRateFiltered[XYZ_AXIS_COUNT] = { gyro.gyroADCf[FD_ROLL], gyro.gyroADCf[FD_PITCH], gyro.gyroADCf[FD_YAW] };
+    dtermNotchFilterApplyFn(dtermFilterNotch, gyroRateFiltered);
+    dtermLpfApplyFn(dtermFilterLpf, gyroRateFiltered);
+
+    // the flight modes only change between loops, so they are resolved once for all axes
+    const bool levelModeActive = FLIGHT_MODE(ANGLE_MODE) || FLIGHT_MODE(HORIZON_MODE);
+    const bool dtermRelaxActive = setpointRelaxEnabled && !flightModeFlags;
+    // a yaw spin, usually fed by a clipped gyro, is stopped by P and D alone: the I term it wound up is dropped
+    const bool yawSpinRecoveryActive = gyroYawSpinDetected();
+
     // ----------PID controller----------
     for (int axis = FD_ROLL; axis <= FD_YAW; axis++) {
         float currentPidSetpoint = getSetpointRate(axis);
@@ -392,7 +533,7 @@ void pidController(const pidProfile_t *pidProfile, const rollAndPitchTrims_t *an
             currentPidSetpoint = accelerationLimit(axis, currentPidSetpoint);
 
         // Yaw control is GYRO based, direct sticks control is applied to rate PID
-        if ((FLIGHT_MODE(ANGLE_MODE) || FLIGHT_MODE(HORIZON_MODE)) && axis != YAW) {
+        if (levelModeActive && axis != YAW) {
             currentPidSetpoint = pidLevel(axis, pidProfile, angleTrim, currentPidSetpoint);
         }
 
@@ -414,8 +555,35 @@ void pidController(const pidProfile_t *pidProfile, const rollAndPitchTrims_t *an
                 BEEP_OFF;
             }
         }
+        if (yawSpinRecoveryActive) {
+            currentPidSetpoint = 0;
+        }
         const float gyroRate = gyro.gyroADCf[axis]; // Process variable from gyro output in deg/sec
 
+#if defined(USE_ITERM_RELAX) || defined(USE_ABSOLUTE_CONTROL)
+        float setpointLpf = 0;
+        float setpointHpf = 0;
+        if (windupLpfEnabled) {
+            setpointLpf = pt1FilterApply(&windupLpf[axis], currentPidSetpoint);
+            setpointHpf = fabsf(currentPidSetpoint - setpointLpf);
+        }
+#endif
+
+        // the I term relax is worked out on the error before the absolute control correction is added
+        float itermErrorRate = currentPidSetpoint - gyroRate;
+#ifdef USE_ITERM_RELAX
+        if (itermRelaxAxis[axis]) {
+            itermErrorRate = applyItermRelax(axisPID_I[axis], itermErrorRate, gyroRate, setpointLpf, setpointHpf);
+        }
+#endif
+#ifdef USE_ABSOLUTE_CONTROL
+        if (acGain > 0 && pidStabilisationEnabled) {
+            const float acCorrection = applyAbsoluteControl(axis, gyroRate, setpointLpf, setpointHpf);
+            currentPidSetpoint += acCorrection;
+            itermErrorRate += acCorrection;
+        }
+#endif
+
         // --------low-level gyro-based PID based on 2DOF PID controller. ----------
         // 2-DOF PID controller with optional filter on derivative term.
         // b = 1 and only c (dtermSetpointWeight) can be tuned (amount derivative on measurement or error).
@@ -431,8 +599,8 @@ void pidController(const pidProfile_t *pidProfile, const rollAndPitchTrims_t *an
 
         // -----calculate I component
         const float ITerm = axisPID_I[axis];
-        const float ITermNew = ITerm + Ki[axis] * errorRate * dT * dynKi * itermAccelerator;
-        const bool outputSaturated = mixerIsOutputSaturated(axis, errorRate);
+        const float ITermNew = ITerm + Ki[axis] * itermErrorRate * dynKi * itermAccelerator;
+        const bool outputSaturated = mixerIsOutputSaturated(axis, itermErrorRate);
         if (outputSaturated == false || ABS(ITermNew) < ABS(ITerm)) {
             // Only increase ITerm if output is not saturated
             axisPID_I[axis] = ITermNew;
@@ -440,22 +608,18 @@ void pidController(const pidProfile_t *pidProfile, const rollAndPitchTrims_t *an
 
         // -----calculate D component
         if (axis != FD_YAW) {
-            // apply filters
-            float gyroRateFiltered = dtermNotchFilterApplyFn(dtermFilterNotch[axis], gyroRate);
-            gyroRateFiltered = dtermLpfApplyFn(dtermFilterLpf[axis], gyroRateFiltered);
-
             float dynC = 0;
-            if ( (pidProfile->setpointRelaxRatio < 100) && (!flightModeFlags) ) {
+            if (dtermRelaxActive) {
                 dynC = dtermSetpointWeight * MIN(getRcDeflectionAbs(axis) * relaxFactor, 1.0f);
             }
-            const float rD = dynC * currentPidSetpoint - gyroRateFiltered;    // cr - y
-            // Divide rate change by dT to get differential (ie dr/dt)
-            float delta = (rD - previousRateError[axis]) / dT;
+            const float rD = dynC * currentPidSetpoint - gyroRateFiltered[axis];    // cr - y
+            // rate change over one loop, Kd includes the division by dT to make it a differential (ie dr/dt)
+            const float delta = rD - previousRateError[axis];
 
             previousRateError[axis] = rD;
 
             // if crash recovery is on and accelerometer enabled then check for a crash
-            if (pidProfile->crash_recovery && sensors(SENSOR_ACC) && inCrashRecoveryMode == false) {
+            if (crashRecoveryEnabled && inCrashRecoveryMode == false) {
                     // inCrashRecoveryMode = true only if the error is longer than crashTimeLimitMaybeUs
                 if (motorMixRange >= 1.0f && ABS(errorRate) > crashGyroThreshold  && inCrashRecoveryMaybe == true
                     && ABS(delta) > crashDtermThreshold && cmpTimeUs(currentTimeUs, crashDetectedMaybeAtUs) > crashTimeLimitMaybeUs) {
@@ -477,11 +641,23 @@ void pidController(const pidProfile_t *pidProfile, const rollAndPitchTrims_t *an
             axisPID_D[axis] = Kd[axis] * delta * tpaFactor;
         }
 
+        // -----calculate F component, only while the setpoint comes from the sticks
+        if (!inCrashRecoveryMode && !yawSpinRecoveryActive && (axis == FD_YAW || !levelModeActive)) {
+            axisPID_F[axis] = Kf[axis] * getSetpointRateDerivative(axis) * tpaFactor;
+        } else {
+            axisPID_F[axis] = 0;
+        }
+
+        if (yawSpinRecoveryActive) {
+            axisPID_I[axis] = 0;
+        }
+
         // Disable PID control at zero throttle
         if (!pidStabilisationEnabled) {
             axisPID_P[axis] = 0;
             axisPID_I[axis] = 0;
             axisPID_D[axis] = 0;
+            axisPID_F[axis] = 0;
         }
     }
 }
@@ -19,6 +19,7 @@
 
 #ifndef USE_OSD_SLAVE
 #include <stdbool.h>
+#include "common/axis.h"
 #include "common/time.h"
 #include "config/parameter_group.h"
 
@@ -33,6 +34,7 @@
 #define PTERM_SCALE 0.032029f
 #define ITERM_SCALE 0.244381f
 #define DTERM_SCALE 0.000529f
+#define FTERM_SCALE 0.000529f
 
 typedef enum {
     PID_ROLL,
@@ -65,6 +67,19 @@ typedef enum {
     PID_CRASH_RECOVERY_BEEP
 } pidCrashRecovery_e;
 
+typedef enum {
+    ITERM_RELAX_OFF = 0,
+    ITERM_RELAX_RP,
+    ITERM_RELAX_RPY,
+    ITERM_RELAX_RP_INC,                     // as RP and RPY, but the I term is always allowed to shrink
+    ITERM_RELAX_RPY_INC
+} itermRelax_e;
+
+typedef enum {
+    ITERM_RELAX_GYRO = 0,
+    ITERM_RELAX_SETPOINT
+} itermRelaxType_e;
+
 typedef struct pid8_s {
     uint8_t P;
     uint8_t I;
@@ -105,12 +120,21 @@ typedef struct pidProfile_s {
     uint8_t crash_recovery_angle;           // degrees
     uint8_t crash_recovery_rate;            // degree/second
     pidCrashRecovery_e crash_recovery;      // off, on, on and beeps when it is in crash recovery mode
+    uint8_t feedForward[XYZ_AXIS_COUNT];    // Feed forward gain on the stick setpoint derivative
+    uint8_t feedForwardSmoothing;           // Percent of the previous RX frame's setpoint derivative kept, against RC link jitter
+    uint8_t itermRelax;                     // Axes on which I term growth is held back during fast stick moves
+    uint8_t itermRelaxType;                 // Relax the error towards the smoothed setpoint (gyro) or scale it down (setpoint)
+    uint8_t itermRelaxCutoff;               // Cutoff in Hz of the setpoint low pass the stick moves are measured against
+    uint8_t absControlGain;                 // Gain of the accumulated attitude error fed back into the setpoint, 0 is off
+    uint8_t absControlLimit;                // Limit of the absolute control correction in deg/sec
+    uint8_t absControlErrorLimit;           // Limit of the accumulated attitude error in degrees
 } pidProfile_t;
 
 PG_DECLARE_ARRAY(pidProfile_t, MAX_PROFILE_COUNT, pidProfiles);
 
 typedef struct pidConfig_s {
     uint8_t pid_process_denom;              // Processing denominator for PID controller vs gyro sampling rate
+    uint16_t motorOutputDelayUs;            // Fixed time from the gyro data ready interrupt to the motor output, 0 outputs as soon as possible
 } pidConfig_t;
 
 PG_DECLARE(pidConfig_t, pidConfig);
@@ -118,7 +142,7 @@ PG_DECLARE(pidConfig_t, pidConfig);
 union rollAndPitchTrims_u;
 void pidController(const pidProfile_t *pidProfile, const union rollAndPitchTrims_u *angleTrim, timeUs_t currentTimeUs);
 
-extern float axisPID_P[3], axisPID_I[3], axisPID_D[3];
+extern float axisPID_P[3], axisPID_I[3], axisPID_D[3], axisPID_F[3];
 bool airmodeWasActivated;
 extern uint32_t targetPidLooptime;
 
@@ -130,7 +154,10 @@ void pidStabilisationState(pidStabilisationState_e pidControllerState);
 void pidSetTargetLooptime(uint32_t pidLooptime);
 void pidSetItermAccelerator(float newItermAccelerator);
 void pidInitFilters(const pidProfile_t *pidProfile);
+void pidInitGains(const pidProfile_t *pidProfile);
 void pidInitConfig(const pidProfile_t *pidProfile);
 void pidInit(const pidProfile_t *pidProfile);
+void pidInitIfChanged(const pidProfile_t *pidProfile);
+bool pidCrashRecoveryActive(void);
 
 #endif
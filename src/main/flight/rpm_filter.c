@@ -0,0 +1,183 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "platform.h"
+
+#ifdef USE_RPM_FILTER
+
+#include "build/debug.h"
+
+#include "common/filter.h"
+#include "common/maths.h"
+#include "common/utils.h"
+
+#include "config/parameter_group.h"
+#include "config/parameter_group_ids.h"
+
+#include "flight/mixer.h"
+#include "flight/rpm_filter.h"
+
+#include "drivers/pwm_output.h"
+
+#include "sensors/esc_sensor.h"
+
+/*
+ * Notches at the rotation frequency of each motor and its harmonics, placed from the ESC telemetry.
+ *
+ * Bidirectional DShot replies are used when enabled, as they come with every motor frame. Otherwise the
+ * ESC sensor telemetry is read one motor at a time, so the frequencies change slowly. One motor is
+ * updated per gyro loop, which keeps the coefficient calculation to RPM_FILTER_HARMONICS_MAX notches
+ * per loop. A notch is switched to pass through when its frequency is out of range or the telemetry
+ * of its motor is stale, so filtering each sample never has to branch.
+ */
+
+#define RPM_FILTER_ESC_DATA_AGE_MAX 10      // requests without a reply before the telemetry of a motor is not trusted
+#define RPM_FILTER_DSHOT_TELEMETRY_AGE_MAX 50  // frames without a valid bidirectional reply, likewise
+#define RPM_FILTER_NYQUIST_MARGIN   0.9f    // keep the notches this far below nyquist
+
+PG_REGISTER_WITH_RESET_TEMPLATE(rpmFilterConfig_t, rpmFilterConfig, PG_RPM_FILTER_CONFIG, 0);
+
+PG_RESET_TEMPLATE(rpmFilterConfig_t, rpmFilterConfig,
+    .rpm_notch_harmonics = 3,
+    .rpm_notch_min_hz = 100,
+    .rpm_notch_q = 500,
+    .rpm_lpf_hz = 150,
+    .motor_poles = 14
+);
+
+static biquadFilterXyz_t rpmNotch[MAX_SUPPORTED_MOTORS][RPM_FILTER_HARMONICS_MAX];
+static pt1Filter_t rpmMotorFreqFilter[MAX_SUPPORTED_MOTORS];
+static float rpmMotorFreqHz[MAX_SUPPORTED_MOTORS];
+
+static uint8_t rpmHarmonics;
+static uint8_t rpmMotorCount;
+static uint8_t rpmUpdateMotor;
+static float rpmLooptimeUs;
+static float rpmMinHz;
+static float rpmMaxHz;
+static float rpmNotchQ;
+static float rpmErpmToHz;
+static float rpmMotorFreqDt;
+
+void rpmFilterInit(float targetLooptimeUs)
+{
+    const rpmFilterConfig_t *config = rpmFilterConfig();
+
+    rpmHarmonics = MIN(config->rpm_notch_harmonics, RPM_FILTER_HARMONICS_MAX);
+    rpmMotorCount = MIN(getMotorCount(), MAX_SUPPORTED_MOTORS);
+    rpmUpdateMotor = 0;
+    rpmLooptimeUs = targetLooptimeUs;
+    rpmMinHz = config->rpm_notch_min_hz;
+    rpmMaxHz = RPM_FILTER_NYQUIST_MARGIN * 0.5f * 1e6f / targetLooptimeUs;
+    rpmNotchQ = config->rpm_notch_q / 100.0f;
+    // the ESC reports eRPM / 100, and there is one electrical revolution per pole pair
+    rpmErpmToHz = 100.0f / 60.0f / (MAX(config->motor_poles, 2) / 2);
+    // each motor is updated once every rpmMotorCount loops
+    rpmMotorFreqDt = targetLooptimeUs * 1e-6f * MAX(rpmMotorCount, 1);
+
+    for (int motor = 0; motor < MAX_SUPPORTED_MOTORS; motor++) {
+        rpmMotorFreqHz[motor] = 0;
+        pt1FilterInit(&rpmMotorFreqFilter[motor], config->rpm_lpf_hz, rpmMotorFreqDt);
+        rpmMotorFreqFilter[motor].state = 0;
+        for (int i = 0; i < RPM_FILTER_HARMONICS_MAX; i++) {
+            biquadFilterXyzInit(&rpmNotch[motor][i], 400, targetLooptimeUs, rpmNotchQ, FILTER_NOTCH);
+            biquadFilterXyzSetPassthrough(&rpmNotch[motor][i]);
+        }
+    }
+}
+
+static bool isRpmSourceActive(void)
+{
+#ifdef USE_DSHOT_TELEMETRY
+    if (isDshotTelemetryActive()) {
+        return true;
+    }
+#endif
+    return isEscSensorActive();
+}
+
+bool isRpmFilterEnabled(void)
+{
+    return rpmHarmonics > 0 && rpmMotorCount > 0 && isRpmSourceActive();
+}
+
+float rpmFilterGetMotorFrequencyHz(int motor)
+{
+    return rpmMotorFreqHz[motor];
+}
+
+// Returns false if the motor has no recent telemetry.
+static bool rpmFilterReadErpm(int motor, uint32_t *erpm)
+{
+#ifdef USE_DSHOT_TELEMETRY
+    if (isDshotTelemetryActive()) {
+        *erpm = getDshotTelemetry(motor);
+        return getDshotTelemetryAge(motor) <= RPM_FILTER_DSHOT_TELEMETRY_AGE_MAX;
+    }
+#endif
+    const escSensorData_t *escData = getEscSensorData(motor);
+    if (!escData || escData->dataAge > RPM_FILTER_ESC_DATA_AGE_MAX) {
+        return false;
+    }
+    *erpm = ABS(escData->rpm);
+    return true;
+}
+
+static void rpmFilterUpdateMotor(int motor)
+{
+    uint32_t erpm;
+    float freqHz = 0;
+    if (rpmFilterReadErpm(motor, &erpm)) {
+        freqHz = pt1FilterApply(&rpmMotorFreqFilter[motor], erpm * rpmErpmToHz);
+    }
+    rpmMotorFreqHz[motor] = freqHz;
+    DEBUG_SET(DEBUG_RPM_FILTER, motor, lrintf(freqHz));
+
+    for (int i = 0; i < rpmHarmonics; i++) {
+        const float notchHz = freqHz * (i + 1);
+        if (notchHz >= rpmMinHz && notchHz <= rpmMaxHz) {
+            biquadFilterXyzUpdateNotch(&rpmNotch[motor][i], notchHz, rpmLooptimeUs, rpmNotchQ);
+        } else {
+            biquadFilterXyzSetPassthrough(&rpmNotch[motor][i]);
+        }
+    }
+}
+
+void rpmFilterGyro(float values[XYZ_AXIS_COUNT])
+{
+    if (!isRpmFilterEnabled()) {
+        return;
+    }
+
+    rpmFilterUpdateMotor(rpmUpdateMotor);
+    if (++rpmUpdateMotor >= rpmMotorCount) {
+        rpmUpdateMotor = 0;
+    }
+
+    for (int motor = 0; motor < rpmMotorCount; motor++) {
+        for (int i = 0; i < rpmHarmonics; i++) {
+            // DF1, as the coefficients change while filtering
+            biquadFilterXyzApplyDF1Inline(&rpmNotch[motor][i], values);
+        }
+    }
+}
+
+#endif // USE_RPM_FILTER
@@ -0,0 +1,38 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "common/axis.h"
+#include "config/parameter_group.h"
+
+#define RPM_FILTER_HARMONICS_MAX 3
+
+typedef struct rpmFilterConfig_s {
+    uint8_t rpm_notch_harmonics;    // notches per motor, at its rotation frequency and the harmonics above, 0 is off
+    uint8_t rpm_notch_min_hz;       // notches below this frequency are switched off
+    uint16_t rpm_notch_q;           // notch Q * 100
+    uint8_t rpm_lpf_hz;             // smoothing of the motor frequencies reported by the ESCs
+    uint8_t motor_poles;            // magnet poles of the motors, to get the RPM from the ESC eRPM
+} rpmFilterConfig_t;
+
+PG_DECLARE(rpmFilterConfig_t, rpmFilterConfig);
+
+void rpmFilterInit(float targetLooptimeUs);
+bool isRpmFilterEnabled(void);
+void rpmFilterGyro(float values[XYZ_AXIS_COUNT]);
+float rpmFilterGetMotorFrequencyHz(int motor);
@@ -300,8 +300,27 @@ static void updateGimbalServos(uint8_t firstServoIndex)
 static void servoTable(void);
 static void filterServos(void);
 
+// PID loops per servo update, the servos only take a new position once per servo PWM period
+static uint16_t servoUpdateDenom = 1;
+static uint32_t servoUpdateLooptime;
+
+void servosInitUpdateRate(void)
+{
+    servoUpdateDenom = MAX(1, (1000000 / servoConfig()->dev.servoPwmRate) / targetPidLooptime);
+    servoUpdateLooptime = servoUpdateDenom * targetPidLooptime;
+}
+
+// Called at the PID rate, mixes and writes the servos every servoUpdateDenom calls
 void writeServos(void)
 {
+    static uint16_t servoUpdateCountdown;
+
+    if (servoUpdateCountdown) {
+        servoUpdateCountdown--;
+        return;
+    }
+    servoUpdateCountdown = servoUpdateDenom - 1;
+
     servoTable();
     filterServos();
 
@@ -378,9 +397,9 @@ STATIC_UNIT_TESTED void servoMixer(void)
         input[INPUT_STABILIZED_YAW] = rcCommand[YAW];
     } else {
         // Assisted modes (gyro only or gyro+acc according to AUX configuration in Gui
-        input[INPUT_STABILIZED_ROLL] = (axisPID_P[FD_ROLL] + axisPID_I[FD_ROLL] + axisPID_D[FD_ROLL]) * PID_SERVO_MIXER_SCALING;
-        input[INPUT_STABILIZED_PITCH] = (axisPID_P[FD_PITCH] + axisPID_I[FD_PITCH] + axisPID_D[FD_PITCH]) * PID_SERVO_MIXER_SCALING;
-        input[INPUT_STABILIZED_YAW] = (axisPID_P[FD_YAW] + axisPID_I[FD_YAW]) * PID_SERVO_MIXER_SCALING;
+        input[INPUT_STABILIZED_ROLL] = (axisPID_P[FD_ROLL] + axisPID_I[FD_ROLL] + axisPID_D[FD_ROLL] + axisPID_F[FD_ROLL]) * PID_SERVO_MIXER_SCALING;
+        input[INPUT_STABILIZED_PITCH] = (axisPID_P[FD_PITCH] + axisPID_I[FD_PITCH] + axisPID_D[FD_PITCH] + axisPID_F[FD_PITCH]) * PID_SERVO_MIXER_SCALING;
+        input[INPUT_STABILIZED_YAW] = (axisPID_P[FD_YAW] + axisPID_I[FD_YAW] + axisPID_F[FD_YAW]) * PID_SERVO_MIXER_SCALING;
 
         // Reverse yaw servo when inverted in 3D mode
         if (feature(FEATURE_3D) && (rcData[THROTTLE] < rxConfig()->midrc)) {
@@ -425,10 +444,12 @@ STATIC_UNIT_TESTED void servoMixer(void)
             if (currentServoMixer[i].speed == 0)
                 currentOutput[i] = input[from];
             else {
+                // the speed is per PID loop, and the mixer runs every servoUpdateDenom loops
+                const int32_t step = currentServoMixer[i].speed * servoUpdateDenom;
                 if (currentOutput[i] < input[from])
-                    currentOutput[i] = constrain(currentOutput[i] + currentServoMixer[i].speed, currentOutput[i], input[from]);
+                    currentOutput[i] = constrain(currentOutput[i] + step, currentOutput[i], input[from]);
                 else if (currentOutput[i] > input[from])
-                    currentOutput[i] = constrain(currentOutput[i] - currentServoMixer[i].speed, input[from], currentOutput[i]);
+                    currentOutput[i] = constrain(currentOutput[i] - step, input[from], currentOutput[i]);
             }
 
             servo[target] += servoDirection(target, from) * constrain(((int32_t)currentOutput[i] * currentServoMixer[i].rate) / 100, min, max);
@@ -500,12 +521,16 @@ bool isMixerUsingServos(void)
 }
 
 static biquadFilter_t servoFilter[MAX_SUPPORTED_SERVOS];
+static bool servoFilterEnabled;
 
+// Must be called after servosInitUpdateRate(), the filters run at the servo update rate
 void servosFilterInit(void)
 {
-    if (servoConfig()->servo_lowpass_freq) {
+    const uint32_t servoUpdateNyquist = 1000000 / servoUpdateLooptime / 2;
+    servoFilterEnabled = servoConfig()->servo_lowpass_freq && servoConfig()->servo_lowpass_freq < servoUpdateNyquist;
+    if (servoFilterEnabled) {
         for (int servoIdx = 0; servoIdx < MAX_SUPPORTED_SERVOS; servoIdx++) {
-            biquadFilterInitLPF(&servoFilter[servoIdx], servoConfig()->servo_lowpass_freq, targetPidLooptime);
+            biquadFilterInitLPF(&servoFilter[servoIdx], servoConfig()->servo_lowpass_freq, servoUpdateLooptime);
         }
     }
 
@@ -516,7 +541,7 @@ static void filterServos(void)
     uint32_t startTime = micros();
 #endif
 
-    if (servoConfig()->servo_lowpass_freq) {
+    if (servoFilterEnabled) {
         for (int servoIdx = 0; servoIdx < MAX_SUPPORTED_SERVOS; servoIdx++) {
             servo[servoIdx] = lrintf(biquadFilterApply(&servoFilter[servoIdx], (float)servo[servoIdx]));
             // Sanity check
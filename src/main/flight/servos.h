@@ -132,4 +132,5 @@ void loadCustomServoMixer(void);
 int servoDirection(int servoIndex, int fromChannel);
 void servoConfigureOutput(void);
 void servosInit(void);
+void servosInitUpdateRate(void);
 void servosFilterInit(void);
@@ -36,7 +36,17 @@
     #define ONLY_EXPOSE_FOR_TESTING static
 #endif
 
+/*
+ * A deeper cache lets blackbox keep logging through the SD card's occasional long write latencies. Targets with RAM to
+ * spare can define a larger one.
+ */
+#ifndef AFATFS_NUM_CACHE_SECTORS
+#if defined(STM32F7)
+#define AFATFS_NUM_CACHE_SECTORS 32
+#else
 #define AFATFS_NUM_CACHE_SECTORS 8
+#endif
+#endif
 
 // FAT filesystems are allowed to differ from these parameters, but we choose not to support those weird filesystems:
 #define AFATFS_SECTOR_SIZE  512
@@ -70,6 +80,8 @@
 #define AFATFS_FILE_MODE_CREATE           16
 // The file's directory entry should be locked in cache so we can read it with no latency:
 #define AFATFS_FILE_MODE_RETAIN_DIRECTORY 32
+// Claim a large run of superclusters with the first write and give back the unused part on close (contiguous files only):
+#define AFATFS_FILE_MODE_PREALLOCATE      64
 
 // Open the cache sector for read access (it will be read from disk)
 #define AFATFS_CACHE_READ         1
@@ -88,6 +100,14 @@
 // When allocating a freefile, leave this many clusters un-allocated for regular files to use
 #define AFATFS_FREEFILE_LEAVE_CLUSTERS 100
 
+/*
+ * How much of the freefile a preallocated file claims at once. Writes within it need no FAT or directory updates, a
+ * file which outgrows it goes back to claiming one supercluster at a time.
+ */
+#ifndef AFATFS_PREALLOCATE_SIZE
+#define AFATFS_PREALLOCATE_SIZE (64 * 1024 * 1024)
+#endif
+
 // Filename in 8.3 format:
 #define AFATFS_FREESPACE_FILENAME "FREESPAC.E"
 
@@ -305,8 +325,23 @@ typedef struct afatfsDeleteFile_t {
     afatfsCallback_t callback;
 } afatfsUnlinkFile_t;
 
+typedef enum {
+    AFATFS_CLOSE_FILE_PHASE_INITIAL = 0,
+    AFATFS_CLOSE_FILE_PHASE_SAVE_DIRECTORY = 0,
+#ifdef AFATFS_USE_FREEFILE
+    AFATFS_CLOSE_FILE_PHASE_SHRINK_DIRECTORY,
+    AFATFS_CLOSE_FILE_PHASE_TERMINATE_CHAIN,
+    AFATFS_CLOSE_FILE_PHASE_RELEASE_PREALLOCATION
+#endif
+} afatfsCloseFilePhase_e;
+
 typedef struct afatfsCloseFile_t {
+    // We need to call this as a sub-operation so we have it as our first member to be compatible with its memory layout:
+    afatfsTruncateFile_t truncateFile;
+
     afatfsCallback_t callback;
+    afatfsCloseFilePhase_e phase;
+    uint32_t terminateCluster;
 } afatfsCloseFile_t;
 
 typedef enum {
@@ -441,6 +476,7 @@ typedef struct afatfs_t {
 
     int cacheDirtyEntries; // The number of cache entries in the AFATFS_CACHE_STATE_DIRTY state
     bool cacheFlushInProgress;
+    uint32_t cacheFlushNextSector; // The sector after the one most recently sent to the card, to continue the run with
 
     afatfsFile_t openFiles[AFATFS_MAX_OPEN_FILES];
 
@@ -672,6 +708,22 @@ static void afatfs_sdcardWriteComplete(sdcardBlockOperation_e operation, uint32_
     }
 }
 
+/**
+ * Find the dirty cache entry that can be flushed for the given sector, or -1 if there isn't one.
+ */
+static int afatfs_findFlushableCacheSector(uint32_t sectorIndex)
+{
+    for (int i = 0; i < AFATFS_NUM_CACHE_SECTORS; i++) {
+        if (afatfs.cacheDescriptor[i].sectorIndex == sectorIndex
+            && afatfs.cacheDescriptor[i].state == AFATFS_CACHE_STATE_DIRTY && !afatfs.cacheDescriptor[i].locked
+        ) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
 /**
  * Attempt to flush the dirty cache entry with the given index to the SDcard.
  */
@@ -680,8 +732,21 @@ static void afatfs_cacheFlushSector(int cacheIndex)
     afatfsCacheBlockDescriptor_t *cacheDescriptor = &afatfs.cacheDescriptor[cacheIndex];
 
 #ifdef AFATFS_MIN_MULTIPLE_BLOCK_WRITE_COUNT
-    if (cacheDescriptor->consecutiveEraseBlockCount) {
-        sdcard_beginWriteBlocks(cacheDescriptor->sectorIndex, cacheDescriptor->consecutiveEraseBlockCount);
+    uint32_t eraseCount = cacheDescriptor->consecutiveEraseBlockCount;
+
+    if (eraseCount == 0) {
+        // Combine the run of consecutive dirty sectors that starts here into a single multi-block write
+        while (eraseCount < UINT16_MAX && afatfs_findFlushableCacheSector(cacheDescriptor->sectorIndex + eraseCount) > -1) {
+            eraseCount++;
+        }
+
+        if (eraseCount < AFATFS_MIN_MULTIPLE_BLOCK_WRITE_COUNT) {
+            eraseCount = 0;
+        }
+    }
+
+    if (eraseCount) {
+        sdcard_beginWriteBlocks(cacheDescriptor->sectorIndex, eraseCount);
     }
 #endif
 
@@ -691,12 +756,14 @@ static void afatfs_cacheFlushSector(int cacheIndex)
             afatfs.cacheDirtyEntries--;
             cacheDescriptor->state = AFATFS_CACHE_STATE_WRITING;
             afatfs.cacheFlushInProgress = true;
+            afatfs.cacheFlushNextSector = cacheDescriptor->sectorIndex + 1;
             break;
 
         case SDCARD_OPERATION_SUCCESS:
             // Buffer is already transmitted
             afatfs.cacheDirtyEntries--;
             cacheDescriptor->state = AFATFS_CACHE_STATE_IN_SYNC;
+            afatfs.cacheFlushNextSector = cacheDescriptor->sectorIndex + 1;
             break;
 
         case SDCARD_OPERATION_BUSY:
@@ -809,21 +876,25 @@ static int afatfs_allocateCacheSector(uint32_t sectorIndex)
 bool afatfs_flush()
 {
     if (afatfs.cacheDirtyEntries > 0) {
-        // Flush the oldest flushable sector
-        uint32_t earliestSectorTime = 0xFFFFFFFF;
-        int earliestSectorIndex = -1;
-
-        for (int i = 0; i < AFATFS_NUM_CACHE_SECTORS; i++) {
-            if (afatfs.cacheDescriptor[i].state == AFATFS_CACHE_STATE_DIRTY && !afatfs.cacheDescriptor[i].locked
-                && (earliestSectorIndex == -1 || afatfs.cacheDescriptor[i].writeTimestamp < earliestSectorTime)
-            ) {
-                earliestSectorIndex = i;
-                earliestSectorTime = afatfs.cacheDescriptor[i].writeTimestamp;
+        // Continuing on from the last sector written keeps the card in its multi-block write
+        int flushIndex = afatfs_findFlushableCacheSector(afatfs.cacheFlushNextSector);
+
+        if (flushIndex == -1) {
+            // Otherwise flush the oldest flushable sector
+            uint32_t earliestSectorTime = 0xFFFFFFFF;
+
+            for (int i = 0; i < AFATFS_NUM_CACHE_SECTORS; i++) {
+                if (afatfs.cacheDescriptor[i].state == AFATFS_CACHE_STATE_DIRTY && !afatfs.cacheDescriptor[i].locked
+                    && (flushIndex == -1 || afatfs.cacheDescriptor[i].writeTimestamp < earliestSectorTime)
+                ) {
+                    flushIndex = i;
+                    earliestSectorTime = afatfs.cacheDescriptor[i].writeTimestamp;
+                }
             }
         }
 
-        if (earliestSectorIndex > -1) {
-            afatfs_cacheFlushSector(earliestSectorIndex);
+        if (flushIndex > -1) {
+            afatfs_cacheFlushSector(flushIndex);
 
             // That flush will take time to complete so we may as well tell caller to come back later
             return false;
@@ -1623,6 +1694,22 @@ uint32_t afatfs_superClusterSize()
     return afatfs_fatEntriesPerSector() * afatfs_clusterSize();
 }
 
+/**
+ * How many superclusters to claim from the freefile for the next append to the given file.
+ */
+static uint32_t afatfs_appendSuperclusterCount(afatfsFilePtr_t file, uint32_t previousCluster)
+{
+    // Only the first append to a preallocated file claims more than one supercluster
+    if ((file->mode & AFATFS_FILE_MODE_PREALLOCATE) == 0 || previousCluster != 0) {
+        return 1;
+    }
+
+    // Take whole superclusters only, so the freefile keeps its fractional tail and never becomes empty
+    uint32_t superClusterSize = afatfs_superClusterSize();
+
+    return MAX(MIN(AFATFS_PREALLOCATE_SIZE / superClusterSize, afatfs.freeFile.logicalSize / superClusterSize), 1);
+}
+
 /**
  * Continue to attempt to add a supercluster to the end of the given file.
  *
@@ -1638,15 +1725,17 @@ static afatfsOperationStatus_e afatfs_appendSuperclusterContinue(afatfsFile_t *f
     afatfsAppendSupercluster_t *opState = &file->operation.state.appendSupercluster;
 
     afatfsOperationStatus_e status = AFATFS_OPERATION_FAILURE;
+    uint32_t superclusterCount;
 
     doMore:
     switch (opState->phase) {
         case AFATFS_APPEND_SUPERCLUSTER_PHASE_INIT:
             // Our file steals the first cluster of the freefile
+            superclusterCount = afatfs_appendSuperclusterCount(file, opState->previousCluster);
 
             // We can go ahead and write to that space before the FAT and directory are updated
             file->cursorCluster = afatfs.freeFile.firstCluster;
-            file->physicalSize += afatfs_superClusterSize();
+            file->physicalSize += superclusterCount * afatfs_superClusterSize();
 
             /* Remove the first supercluster from the freefile
              *
@@ -1656,13 +1745,13 @@ static afatfsOperationStatus_e afatfs_appendSuperclusterContinue(afatfsFile_t *f
              * Note that normally the freefile can't become empty because it is allocated as a non-integer number
              * of superclusters to avoid precisely this situation.
              */
-            afatfs.freeFile.firstCluster += afatfs_fatEntriesPerSector();
-            afatfs.freeFile.logicalSize -= afatfs_superClusterSize();
-            afatfs.freeFile.physicalSize -= afatfs_superClusterSize();
+            afatfs.freeFile.firstCluster += superclusterCount * afatfs_fatEntriesPerSector();
+            afatfs.freeFile.logicalSize -= superclusterCount * afatfs_superClusterSize();
+            afatfs.freeFile.physicalSize -= superclusterCount * afatfs_superClusterSize();
 
-            // The new supercluster needs to have its clusters chained contiguously and marked with a terminator at the end
+            // The new superclusters need to have their clusters chained contiguously and marked with a terminator at the end
             opState->fatRewriteStartCluster = file->cursorCluster;
-            opState->fatRewriteEndCluster = opState->fatRewriteStartCluster + afatfs_fatEntriesPerSector();
+            opState->fatRewriteEndCluster = opState->fatRewriteStartCluster + superclusterCount * afatfs_fatEntriesPerSector();
 
             if (opState->previousCluster == 0) {
                 // This is the new first cluster in the file so we need to update the directory entry
@@ -2799,6 +2888,42 @@ static void afatfs_fcloseContinue(afatfsFilePtr_t file)
     afatfsCacheBlockDescriptor_t *descriptor;
     afatfsCloseFile_t *opState = &file->operation.state.closeFile;
 
+#ifdef AFATFS_USE_FREEFILE
+    afatfsOperationStatus_e status;
+
+    doMore:
+    switch (opState->phase) {
+        case AFATFS_CLOSE_FILE_PHASE_SHRINK_DIRECTORY:
+            // Stop the directory entry claiming the preallocation before we cut it off
+            status = afatfs_saveDirectoryEntry(file, AFATFS_SAVE_DIRECTORY_NORMAL);
+
+            if (status == AFATFS_OPERATION_SUCCESS) {
+                opState->phase = AFATFS_CLOSE_FILE_PHASE_TERMINATE_CHAIN;
+                goto doMore;
+            }
+        return;
+        case AFATFS_CLOSE_FILE_PHASE_TERMINATE_CHAIN:
+            // End the FAT chain after the last supercluster we used, the unused tail is left as an orphaned chain
+            status = afatfs_FATFillWithPattern(AFATFS_FAT_PATTERN_TERMINATED_CHAIN, &opState->terminateCluster, opState->truncateFile.startCluster);
+
+            if (status == AFATFS_OPERATION_SUCCESS) {
+                opState->phase = AFATFS_CLOSE_FILE_PHASE_RELEASE_PREALLOCATION;
+                goto doMore;
+            }
+        return;
+        case AFATFS_CLOSE_FILE_PHASE_RELEASE_PREALLOCATION:
+            // Give the orphaned tail back to the start of the freefile
+            if (afatfs_ftruncateContinue(file, false) == AFATFS_OPERATION_IN_PROGRESS) {
+                return;
+            }
+
+            opState->phase = AFATFS_CLOSE_FILE_PHASE_SAVE_DIRECTORY;
+        break;
+        case AFATFS_CLOSE_FILE_PHASE_SAVE_DIRECTORY:
+        break;
+    }
+#endif
+
     /*
      * Directories don't update their parent directory entries over time, because their fileSize field in the directory
      * never changes (when we add the first cluster to the directory we save the directory entry at that point and it
@@ -2857,10 +2982,37 @@ bool afatfs_fclose(afatfsFilePtr_t file, afatfsCallback_t callback)
     } else if (afatfs_fileIsBusy(file)) {
         return false;
     } else {
+        afatfsCloseFile_t *opState = &file->operation.state.closeFile;
+
         afatfs_fileUpdateFilesize(file);
 
         file->operation.operation = AFATFS_FILE_OPERATION_CLOSE;
-        file->operation.state.closeFile.callback = callback;
+        opState->callback = callback;
+        opState->phase = AFATFS_CLOSE_FILE_PHASE_INITIAL;
+
+#ifdef AFATFS_USE_FREEFILE
+        if ((file->mode & AFATFS_FILE_MODE_PREALLOCATE) != 0 && file->firstCluster != 0) {
+            // Keep the superclusters which hold the file's contents (the file is contiguous up to the freefile)
+            uint32_t superClusterSize = afatfs_superClusterSize();
+            uint32_t superclusterCount = MAX((file->logicalSize + superClusterSize - 1) / superClusterSize, 1);
+            uint32_t keepEndCluster = file->firstCluster + superclusterCount * afatfs_fatEntriesPerSector();
+
+            if (keepEndCluster < afatfs.freeFile.firstCluster) {
+                file->physicalSize = superclusterCount * superClusterSize;
+
+                opState->phase = AFATFS_CLOSE_FILE_PHASE_SHRINK_DIRECTORY;
+                opState->terminateCluster = keepEndCluster - afatfs_fatEntriesPerSector();
+
+                // The directory entry was already shrunk, so the truncation starts at the FAT
+                opState->truncateFile.phase = AFATFS_TRUNCATE_FILE_ERASE_FAT_CHAIN_CONTIGUOUS;
+                opState->truncateFile.callback = NULL;
+                opState->truncateFile.startCluster = keepEndCluster;
+                opState->truncateFile.currentCluster = keepEndCluster;
+                opState->truncateFile.endCluster = afatfs.freeFile.firstCluster;
+            }
+        }
+#endif
+
         afatfs_fcloseContinue(file);
         return true;
     }
@@ -2950,6 +3102,10 @@ bool afatfs_chdir(afatfsFilePtr_t directory)
  * ws   If the file is already non-empty or freefile support is not compiled in then it will fall back to non-contiguous
  *      operation.
  *
+ * ap - As above, but the first write claims AFATFS_PREALLOCATE_SIZE of the freefile at once, so writes after that need
+ * wp   no FAT or directory updates. The unused part is returned to the freefile by fclose(). If power is lost before
+ *      the file is closed, its directory entry covers the whole preallocation.
+ *
  * All other mode strings are illegal. In particular, don't add "b" to the end of the mode string.
  *
  * Returns false if the the open failed really early (out of file handles).
@@ -2982,6 +3138,11 @@ bool afatfs_fopen(const char *filename, const char *mode, afatfsFileCallback_t c
         case 's':
 #ifdef AFATFS_USE_FREEFILE
             fileMode |= AFATFS_FILE_MODE_CONTIGUOUS | AFATFS_FILE_MODE_RETAIN_DIRECTORY;
+#endif
+        break;
+        case 'p':
+#ifdef AFATFS_USE_FREEFILE
+            fileMode |= AFATFS_FILE_MODE_CONTIGUOUS | AFATFS_FILE_MODE_RETAIN_DIRECTORY | AFATFS_FILE_MODE_PREALLOCATE;
 #endif
         break;
     }
@@ -3643,6 +3804,14 @@ bool afatfs_destroy(bool dirty)
     return true;
 }
 
+/**
+ * Get the size of the sector cache, the most that can be buffered while the card is busy.
+ */
+uint32_t afatfs_getCacheSize()
+{
+    return AFATFS_NUM_CACHE_SECTORS * AFATFS_SECTOR_SIZE;
+}
+
 /**
  * Get a pessimistic estimate of the amount of buffer space that we have available to write to immediately.
  */
@@ -84,6 +84,7 @@ void afatfs_init();
 bool afatfs_destroy(bool dirty);
 void afatfs_poll();
 
+uint32_t afatfs_getCacheSize();
 uint32_t afatfs_getFreeBufferSpace();
 uint32_t afatfs_getContiguousFreeSpace();
 bool afatfs_isFull();
@@ -79,9 +79,10 @@ PG_RESET_TEMPLATE(beeperDevConfig_t, beeperDevConfig,
 #endif
 
 #define MAX_MULTI_BEEPS 64   //size limit for 'beep_multiBeeps[]'
+#define BEEPER_STEP_US  10000
 
-#define BEEPER_COMMAND_REPEAT 0xFE
-#define BEEPER_COMMAND_STOP   0xFF
+#define BEEPER_COMMAND_REPEAT BEEPER_SEQUENCE_REPEAT
+#define BEEPER_COMMAND_STOP   BEEPER_SEQUENCE_STOP
 
 #ifdef BEEPER
 /* Beeper Sound Sequences: (Square wave generation)
@@ -121,10 +122,19 @@ static const uint8_t beep_critBatteryBeep[] = {
     50, 2, BEEPER_COMMAND_STOP
 };
 
+// power on, played by the beeper task while the rest of the system starts
+static const uint8_t beep_systemInit[] = {
+    3, 2, 3, 2, 3, 2, 3, 2, 3, 2, 3, 2, 3, 2, 3, 2, 3, 2, 3, 2, BEEPER_COMMAND_STOP
+};
+
 // transmitter-signal-lost tone
 static const uint8_t beep_txLostBeep[] = {
     50, 50, BEEPER_COMMAND_STOP
 };
+// link quality warning, short double beep then a pause
+static const uint8_t beep_linkQualityLowBeep[] = {
+    10, 10, 10, 70, BEEPER_COMMAND_STOP
+};
 // SOS morse code:
 static const uint8_t beep_sos[] = {
     10, 10, 10, 10, 10, 40, 40, 10, 40, 10, 40, 40, 10, 10, 10, 10, 10, 70, BEEPER_COMMAND_STOP
@@ -167,10 +177,13 @@ static uint8_t beeperIsOn = 0;
 static uint16_t beeperPos = 0;
 // Time when beeper routine must act next time
 static uint32_t beeperNextToggleTime = 0;
+// Sequence is played by the beeper timer, the task only follows it
+static bool beeperTimed = false;
 // Time of last arming beep in microseconds (for blackbox)
 static uint32_t armingBeepTimeMicros = 0;
 
 static void beeperProcessCommand(timeUs_t currentTimeUs);
+static void beeperStarted(void);
 
 typedef struct beeperTableEntry_s {
     uint8_t mode;
@@ -204,11 +217,12 @@ typedef struct beeperTableEntry_s {
     { BEEPER_ENTRY(BEEPER_MULTI_BEEPS,           13, beep_multiBeeps,      "MULTI_BEEPS") }, // FIXME having this listed makes no sense since the beep array will not be initialised.
     { BEEPER_ENTRY(BEEPER_DISARM_REPEAT,         14, beep_disarmRepeatBeep, "DISARM_REPEAT") },
     { BEEPER_ENTRY(BEEPER_ARMED,                 15, beep_armedBeep,       "ARMED") },
-    { BEEPER_ENTRY(BEEPER_SYSTEM_INIT,           16, NULL,                 "SYSTEM_INIT") },
+    { BEEPER_ENTRY(BEEPER_SYSTEM_INIT,           16, beep_systemInit,      "SYSTEM_INIT") },
     { BEEPER_ENTRY(BEEPER_USB,                   17, NULL,                 "ON_USB") },
     { BEEPER_ENTRY(BEEPER_BLACKBOX_ERASE,        18, beep_2shortBeeps,     "BLACKBOX_ERASE") },
-    { BEEPER_ENTRY(BEEPER_ALL,                   19, NULL,                 "ALL") },
-    { BEEPER_ENTRY(BEEPER_PREFERENCE,            20, NULL,                 "PREFERRED") },
+    { BEEPER_ENTRY(BEEPER_RX_LQ_LOW,             19, beep_linkQualityLowBeep, "RX_LQ_LOW") },
+    { BEEPER_ENTRY(BEEPER_ALL,                   20, NULL,                 "ALL") },
+    { BEEPER_ENTRY(BEEPER_PREFERENCE,            21, NULL,                 "PREFERRED") },
 };
 
 static const beeperTableEntry_t *currentBeeperEntry = NULL;
@@ -258,10 +272,18 @@ void beeper(beeperMode_e mode)
 
     beeperPos = 0;
     beeperNextToggleTime = 0;
+
+    const bool audible = !(getBeeperOffMask() & (1 << (currentBeeperEntry->mode - 1)));
+    beeperTimed = beeperSequenceStart(currentBeeperEntry->sequence, audible);
+    if (beeperTimed) {
+        beeperStarted();
+    }
 }
 
 void beeperSilence(void)
 {
+    beeperSequenceStop();
+    beeperTimed = false;
     BEEP_OFF;
     warningLedDisable();
     warningLedRefresh();
@@ -358,17 +380,31 @@ void beeperUpdate(timeUs_t currentTimeUs)
         return;
     }
 
+    if (beeperTimed) {
+        // the timer steps the sequence, the warning led follows it and the entry ends with it
+        const bool on = beeperSequenceIsOn();
+        if (on != beeperIsOn) {
+            beeperIsOn = on;
+            if (on) {
+                warningLedEnable();
+            } else {
+                warningLedDisable();
+            }
+            warningLedRefresh();
+        }
+        if (!beeperSequenceIsActive()) {
+            beeperSilence();
+        }
+        return;
+    }
+
     if (beeperNextToggleTime > currentTimeUs) {
         return;
     }
 
-    #ifdef USE_DSHOT
-    if (!ARMING_FLAG(ARMED) && currentBeeperEntry->mode == BEEPER_RX_SET) {
-        for (unsigned index = 0; index < getMotorCount(); index++) {
-            pwmWriteDshotCommand(index, DSHOT_CMD_BEEP3);
-        }
+    if (beeperPos == 0 && beeperNextToggleTime == 0) {
+        beeperStarted();
     }
-    #endif
 
     if (!beeperIsOn) {
         beeperIsOn = 1;
@@ -377,13 +413,6 @@ void beeperUpdate(timeUs_t currentTimeUs)
                 BEEP_ON;
             warningLedEnable();
             warningLedRefresh();
-            // if this was arming beep then mark time (for blackbox)
-            if (
-                beeperPos == 0
-                && (currentBeeperEntry->mode == BEEPER_ARMING || currentBeeperEntry->mode == BEEPER_ARMING_GPS_FIX)
-            ) {
-                armingBeepTimeMicros = micros();
-            }
         }
     } else {
         beeperIsOn = 0;
@@ -397,6 +426,27 @@ void beeperUpdate(timeUs_t currentTimeUs)
     beeperProcessCommand(currentTimeUs);
 }
 
+/*
+ * Marks the start of a sequence, however it is played.
+ */
+static void beeperStarted(void)
+{
+#ifdef USE_DSHOT
+    // one beacon per sequence, the ESCs need a while between beeps anyway
+    if (!ARMING_FLAG(ARMED) && currentBeeperEntry->mode == BEEPER_RX_SET) {
+        pwmQueueDshotCommand(DSHOT_ALL_MOTORS, DSHOT_CMD_BEEP3, NULL);
+    }
+#endif
+
+    // if this is the arming beep then mark time (for blackbox)
+    if (
+        currentBeeperEntry->sequence[0] != 0
+        && (currentBeeperEntry->mode == BEEPER_ARMING || currentBeeperEntry->mode == BEEPER_ARMING_GPS_FIX)
+    ) {
+        armingBeepTimeMicros = micros();
+    }
+}
+
 /*
  * Calculates array position when next to change beeper state is due.
  */
@@ -407,8 +457,11 @@ static void beeperProcessCommand(timeUs_t currentTimeUs)
     } else if (currentBeeperEntry->sequence[beeperPos] == BEEPER_COMMAND_STOP) {
         beeperSilence();
     } else {
-        // Otherwise advance the sequence and calculate next toggle time
-        beeperNextToggleTime = currentTimeUs + 1000 * 10 * currentBeeperEntry->sequence[beeperPos];
+        // Otherwise advance the sequence and calculate next toggle time. Steps follow on from when the
+        // last one was due rather than from when the task got to it, unless the task is a whole step late.
+        const timeUs_t stepUs = BEEPER_STEP_US * currentBeeperEntry->sequence[beeperPos];
+        const bool onSchedule = beeperNextToggleTime && cmpTimeUs(currentTimeUs, beeperNextToggleTime) < BEEPER_STEP_US;
+        beeperNextToggleTime = (onSchedule ? beeperNextToggleTime : currentTimeUs) + stepUs;
         beeperPos++;
     }
 }
@@ -457,7 +510,7 @@ int beeperTableEntryCount(void)
  */
 bool isBeeperOn(void)
 {
-    return beeperIsOn;
+    return beeperTimed ? beeperSequenceIsOn() : beeperIsOn;
 }
 
 #else
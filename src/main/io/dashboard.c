@@ -611,6 +611,11 @@ void dashboardUpdate(timeUs_t currentTimeUs)
     }
 #endif
 
+    // the last page drawn goes out a span per task run, a new one is only drawn once it is all sent
+    if (dashboardPresent && !i2c_OLED_flush(bus)) {
+        return;
+    }
+
     const bool updateNow = (int32_t)(currentTimeUs - nextDisplayUpdateAt) >= 0L;
     if (!updateNow) {
         return;
@@ -672,6 +677,7 @@ void dashboardUpdate(timeUs_t currentTimeUs)
         updateTicker();
     }
 
+    i2c_OLED_flush(bus);
 }
 
 void dashboardInit(void)
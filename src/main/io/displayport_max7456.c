@@ -117,6 +117,12 @@ static bool isTransferInProgress(const displayPort_t *displayPort)
     return max7456DmaInProgress();
 }
 
+static bool isSynced(const displayPort_t *displayPort)
+{
+    UNUSED(displayPort);
+    return max7456BuffersSynced();
+}
+
 static void resync(displayPort_t *displayPort)
 {
     UNUSED(displayPort);
@@ -137,6 +143,12 @@ static uint32_t txBytesFree(const displayPort_t *displayPort)
     return UINT32_MAX;
 }
 
+static bool getVsync(const displayPort_t *displayPort, timeUs_t *vsyncAtUs)
+{
+    UNUSED(displayPort);
+    return max7456GetVsync(vsyncAtUs);
+}
+
 static const displayPortVTable_t max7456VTable = {
     .grab = grab,
     .release = release,
@@ -146,9 +158,11 @@ static const displayPortVTable_t max7456VTable = {
     .writeString = writeString,
     .writeChar = writeChar,
     .isTransferInProgress = isTransferInProgress,
+    .isSynced = isSynced,
     .heartbeat = heartbeat,
     .resync = resync,
     .txBytesFree = txBytesFree,
+    .getVsync = getVsync,
 };
 
 displayPort_t *max7456DisplayPortInit(const vcdProfile_t *vcdProfile)
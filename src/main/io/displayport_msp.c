@@ -24,12 +24,14 @@
 
 #ifdef USE_MSP_DISPLAYPORT
 
+#include "common/maths.h"
 #include "common/utils.h"
 
 #include "config/parameter_group.h"
 #include "config/parameter_group_ids.h"
 
 #include "drivers/display.h"
+#include "drivers/time.h"
 
 #include "fc/fc_msp.h"
 
@@ -43,6 +45,32 @@ PG_REGISTER(displayPortProfile_t, displayPortProfileMsp, PG_DISPLAY_PORT_MSP_CON
 
 static displayPort_t mspDisplayPort;
 
+// The screen is kept here and only the characters the remote does not show yet are sent, as string writes
+// covering the changed spans of a row. Short runs of unchanged characters between two changes are sent along,
+// as that is cheaper than the framing of another write.
+
+#define MSP_DISPLAYPORT_MAX_ROWS        16
+#define MSP_DISPLAYPORT_MAX_COLS        32  // one bit per column in the dirty masks
+#define MSP_OSD_MAX_STRING_LENGTH       30
+#define MSP_DISPLAYPORT_FRAME_OVERHEAD  (6 + 4)     // MSP v1 header and checksum, subcommand, row, column and attribute
+#define MSP_DISPLAYPORT_GAP_MAX         MSP_DISPLAYPORT_FRAME_OVERHEAD
+
+static uint8_t screenBuffer[MSP_DISPLAYPORT_MAX_ROWS][MSP_DISPLAYPORT_MAX_COLS];
+static uint32_t dirtyColumns[MSP_DISPLAYPORT_MAX_ROWS];    // characters the remote does not have yet
+static bool fullRefresh = true;     // the remote state is unknown, clear it and send everything
+static bool drawPending = false;    // the remote has not been told to draw the latest writes
+
+// An OSD slave acknowledges each frame once it is on its display. When it does, the frames are sent as fast as it takes
+// them rather than only as fast as the link drains, with a few in flight to cover the round trip. A remote that does not
+// acknowledge, or stops doing so, is paced by the link alone.
+
+#define MSP_DISPLAYPORT_FRAMES_IN_FLIGHT_MAX    2
+#define MSP_DISPLAYPORT_ACK_TIMEOUT_MS          200
+
+static bool remoteAcknowledges = false;
+static uint8_t framesInFlight = 0;
+static timeMs_t lastFrameSentMs = 0;
+
 #ifdef USE_CLI
 extern uint8_t cliMode;
 #endif
@@ -72,6 +100,7 @@ static int heartbeat(displayPort_t *displayPort)
 
 static int grab(displayPort_t *displayPort)
 {
+    fullRefresh = true;
     return heartbeat(displayPort);
 }
 
@@ -82,62 +111,199 @@ static int release(displayPort_t *displayPort)
     return output(displayPort, MSP_DISPLAYPORT, subcmd, sizeof(subcmd));
 }
 
-static int clearScreen(displayPort_t *displayPort)
+static uint8_t visibleRows(const displayPort_t *displayPort)
 {
-    uint8_t subcmd[] = { 2 };
+    return MIN(displayPort->rows, MSP_DISPLAYPORT_MAX_ROWS);
+}
 
-    return output(displayPort, MSP_DISPLAYPORT, subcmd, sizeof(subcmd));
+static uint8_t visibleCols(const displayPort_t *displayPort)
+{
+    return MIN(displayPort->cols, MSP_DISPLAYPORT_MAX_COLS);
 }
 
-static int drawScreen(displayPort_t *displayPort)
+// Mask of n columns starting at the first one
+static uint32_t columnMask(uint8_t n)
 {
-    uint8_t subcmd[] = { 4 };
-    return output(displayPort, MSP_DISPLAYPORT, subcmd, sizeof(subcmd));
+    return n < 32 ? (1U << n) - 1 : ~0U;
 }
 
-static int screenSize(const displayPort_t *displayPort)
+static void bufferChar(uint8_t col, uint8_t row, uint8_t c)
 {
-    return displayPort->rows * displayPort->cols;
+    if (screenBuffer[row][col] != c) {
+        screenBuffer[row][col] = c;
+        dirtyColumns[row] |= 1U << col;
+    }
 }
 
-static int writeString(displayPort_t *displayPort, uint8_t col, uint8_t row, const char *string)
+static int clearScreen(displayPort_t *displayPort)
 {
-#define MSP_OSD_MAX_STRING_LENGTH 30 // FIXME move this
-    uint8_t buf[MSP_OSD_MAX_STRING_LENGTH + 4];
+    UNUSED(displayPort);
+
+    for (int row = 0; row < MSP_DISPLAYPORT_MAX_ROWS; row++) {
+        for (int col = 0; col < MSP_DISPLAYPORT_MAX_COLS; col++) {
+            bufferChar(col, row, ' ');
+        }
+    }
+    return 0;
+}
 
-    int len = strlen(string);
-    if (len >= MSP_OSD_MAX_STRING_LENGTH) {
-        len = MSP_OSD_MAX_STRING_LENGTH;
+static bool canSend(int len)
+{
+    return mspSerialTxBytesFree() >= (uint32_t)(MSP_DISPLAYPORT_FRAME_OVERHEAD + len);
+}
+
+// Sends the changed span of a row starting at the first changed column, returns false when the link has no room for it
+static bool sendRowSpan(displayPort_t *displayPort, uint8_t row)
+{
+    const uint8_t cols = visibleCols(displayPort);
+    const uint32_t dirty = dirtyColumns[row];
+    const uint8_t start = __builtin_ctz(dirty);
+
+    uint8_t end = start + 1;    // one past the last column sent
+    for (uint8_t col = end; col < cols && col - start < MSP_OSD_MAX_STRING_LENGTH; col++) {
+        if (dirty & (1U << col)) {
+            end = col + 1;
+        } else if (col - end >= MSP_DISPLAYPORT_GAP_MAX) {
+            break;
+        }
     }
 
+    const int len = end - start;
+    if (!canSend(len)) {
+        return false;
+    }
+
+    uint8_t buf[MSP_OSD_MAX_STRING_LENGTH + 4];
     buf[0] = 3;
     buf[1] = row;
-    buf[2] = col;
+    buf[2] = start;
     buf[3] = 0;
-    memcpy(&buf[4], string, len);
+    memcpy(&buf[4], &screenBuffer[row][start], len);
+    output(displayPort, MSP_DISPLAYPORT, buf, len + 4);
+
+    dirtyColumns[row] &= ~(columnMask(len) << start);
+    drawPending = true;
+    return true;
+}
+
+void displayPortMspFrameAcknowledged(void)
+{
+    remoteAcknowledges = true;
+    if (framesInFlight) {
+        framesInFlight--;
+    }
+}
+
+static bool awaitingAcknowledgement(void)
+{
+    if (!remoteAcknowledges || framesInFlight < MSP_DISPLAYPORT_FRAMES_IN_FLIGHT_MAX) {
+        return false;
+    }
+    if (cmp32(millis(), lastFrameSentMs) > MSP_DISPLAYPORT_ACK_TIMEOUT_MS) {
+        remoteAcknowledges = false;
+        framesInFlight = 0;
+        return false;
+    }
+    return true;
+}
+
+// Sends the changes for as long as the serial link and the remote have room for them, the rest go on the following calls
+static int drawScreen(displayPort_t *displayPort)
+{
+    if (awaitingAcknowledgement()) {
+        return 0;
+    }
+
+    if (fullRefresh) {
+        if (!canSend(1)) {
+            return 0;
+        }
+        uint8_t subcmd[] = { 2 };
+        output(displayPort, MSP_DISPLAYPORT, subcmd, sizeof(subcmd));
+        for (int row = 0; row < MSP_DISPLAYPORT_MAX_ROWS; row++) {
+            dirtyColumns[row] = 0;
+            for (int col = 0; col < MSP_DISPLAYPORT_MAX_COLS; col++) {
+                if (screenBuffer[row][col] != ' ') {
+                    dirtyColumns[row] |= 1U << col;
+                }
+            }
+        }
+        fullRefresh = false;
+        drawPending = true;
+    }
+
+    const uint8_t rows = visibleRows(displayPort);
+    const uint32_t visibleMask = columnMask(visibleCols(displayPort));
+    for (uint8_t row = 0; row < rows; row++) {
+        // changes outside the visible area can never be shown
+        dirtyColumns[row] &= visibleMask;
+        while (dirtyColumns[row]) {
+            if (!sendRowSpan(displayPort, row)) {
+                return 0;
+            }
+        }
+    }
+
+    if (drawPending && canSend(1)) {
+        uint8_t subcmd[] = { 4 };
+        output(displayPort, MSP_DISPLAYPORT, subcmd, sizeof(subcmd));
+        drawPending = false;
+        if (remoteAcknowledges) {
+            framesInFlight++;
+            lastFrameSentMs = millis();
+        }
+    }
+    return 0;
+}
 
-    return output(displayPort, MSP_DISPLAYPORT, buf, len + 4);
+static int screenSize(const displayPort_t *displayPort)
+{
+    return displayPort->rows * displayPort->cols;
+}
+
+static int writeString(displayPort_t *displayPort, uint8_t col, uint8_t row, const char *string)
+{
+    if (row >= visibleRows(displayPort)) {
+        return 0;
+    }
+    for (; *string && col < visibleCols(displayPort); string++, col++) {
+        bufferChar(col, row, *string);
+    }
+    return 0;
 }
 
 static int writeChar(displayPort_t *displayPort, uint8_t col, uint8_t row, uint8_t c)
 {
-    char buf[2];
+    if (row < visibleRows(displayPort) && col < visibleCols(displayPort)) {
+        bufferChar(col, row, c);
+    }
+    return 0;
+}
 
-    buf[0] = c;
-    buf[1] = 0;
-    return writeString(displayPort, col, row, buf); //!!TODO - check if there is a direct MSP command to do this
+static bool isSynced(const displayPort_t *displayPort)
+{
+    if (fullRefresh || drawPending) {
+        return false;
+    }
+    for (int row = 0; row < visibleRows(displayPort); row++) {
+        if (dirtyColumns[row]) {
+            return false;
+        }
+    }
+    return true;
 }
 
+// The changes wait for the serial link to drain or the remote to catch up
 static bool isTransferInProgress(const displayPort_t *displayPort)
 {
-    UNUSED(displayPort);
-    return false;
+    return !isSynced(displayPort) && (!canSend(MSP_OSD_MAX_STRING_LENGTH) || awaitingAcknowledgement());
 }
 
 static void resync(displayPort_t *displayPort)
 {
     displayPort->rows = 13 + displayPortProfileMsp()->rowAdjust; // XXX Will reflect NTSC/PAL in the future
     displayPort->cols = 30 + displayPortProfileMsp()->colAdjust;
+    fullRefresh = true;
 }
 
 static uint32_t txBytesFree(const displayPort_t *displayPort)
@@ -155,6 +321,7 @@ static const displayPortVTable_t mspDisplayPortVTable = {
     .writeString = writeString,
     .writeChar = writeChar,
     .isTransferInProgress = isTransferInProgress,
+    .isSynced = isSynced,
     .heartbeat = heartbeat,
     .resync = resync,
     .txBytesFree = txBytesFree
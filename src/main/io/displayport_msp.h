@@ -24,3 +24,4 @@ PG_DECLARE(displayPortProfile_t, displayPortProfileMsp);
 
 struct displayPort_s;
 struct displayPort_s *displayPortMspInit(void);
+void displayPortMspFrameAcknowledged(void);
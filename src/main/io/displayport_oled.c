@@ -22,6 +22,7 @@
 
 #include "common/utils.h"
 
+#include "drivers/bus_i2c.h"
 #include "drivers/display.h"
 #include "drivers/display_ug2864hsweg01.h"
 
@@ -47,7 +48,7 @@ static int oledClearScreen(displayPort_t *displayPort)
 
 static int oledDrawScreen(displayPort_t *displayPort)
 {
-    UNUSED(displayPort);
+    i2c_OLED_flush(displayPort->device);
     return 0;
 }
 
@@ -72,8 +73,8 @@ static int oledWriteChar(displayPort_t *displayPort, uint8_t x, uint8_t y, uint8
 
 static bool oledIsTransferInProgress(const displayPort_t *displayPort)
 {
-    UNUSED(displayPort);
-    return false;
+    const busDevice_t *bus = displayPort->device;
+    return i2cBusy(bus->busdev_u.i2c.device, NULL);
 }
 
 static int oledHeartbeat(displayPort_t *displayPort)
@@ -82,6 +83,12 @@ static int oledHeartbeat(displayPort_t *displayPort)
     return 0;
 }
 
+static bool oledIsSynced(const displayPort_t *displayPort)
+{
+    UNUSED(displayPort);
+    return true;
+}
+
 static void oledResync(displayPort_t *displayPort)
 {
     UNUSED(displayPort);
@@ -102,6 +109,7 @@ static const displayPortVTable_t oledVTable = {
     .writeString = oledWriteString,
     .writeChar = oledWriteChar,
     .isTransferInProgress = oledIsTransferInProgress,
+    .isSynced = oledIsSynced,
     .heartbeat = oledHeartbeat,
     .resync = oledResync,
     .txBytesFree = oledTxBytesFree
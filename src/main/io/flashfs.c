@@ -25,6 +25,9 @@
  * Note that bits can only be set to 0 when writing, not back to 1 from 0. You must erase sectors in order
  * to bring bits back to 1 again.
  *
+ * Writes are buffered and programmed a page at a time. When the target has a DMA channel for the flash, a page is
+ * sent in the background while the rest of the buffer keeps filling.
+ *
  * In future, we can add support for multiple different flash chips by adding a flash device driver vtable
  * and make calls through that, at the moment flashfs just calls m25p16_* routines explicitly.
  */
@@ -33,45 +36,75 @@
 #include <stdbool.h>
 #include <string.h>
 
+#include "platform.h"
+
+#include "common/arena.h"
+#include "common/maths.h"
+#include "common/utils.h"
+
 #include "drivers/flash.h"
 #include "drivers/flash_m25p16.h"
 
 #include "io/flashfs.h"
 
-static uint8_t flashWriteBuffer[FLASHFS_WRITE_BUFFER_SIZE];
+STATIC_ASSERT(FLASHFS_WRITE_BUFFER_SIZE % M25P16_PAGESIZE == 0, flashfs_write_buffer_not_whole_pages);
+
+static uint8_t *flashWriteBuffer = NULL;
+static uint32_t flashWriteBufferSize = 0;
 
-/* The position of our head and tail in the circular flash write buffer.
+/*
+ * The buffer holds the bytes from the tail address up to the head address that have yet to be written to flash.
  *
- * The head is the index that a byte would be inserted into on writing, while the tail is the index of the
- * oldest byte that has yet to be written to flash.
+ * Each byte is kept at its flash address modulo the size of the buffer, which is a whole number of pages, so every
+ * page of flash lies in one piece in the buffer and is programmed with a single transfer while the other pages fill.
  *
- * When the circular buffer is empty, head == tail
+ * When the buffer is empty, headAddress == tailAddress
  */
-static uint8_t bufferHead = 0, bufferTail = 0;
-
-// The position of the buffer's tail in the overall flash address space:
+static uint32_t headAddress = 0;
 static uint32_t tailAddress = 0;
 
+// The bytes from the tail that are being sent to the flash, they stay in the buffer until they have been sent
+static uint32_t programLength = 0;
+
+static void flashfsReleaseProgrammed(void)
+{
+    if (programLength > 0 && !m25p16_isTransferInProgress()) {
+        tailAddress += programLength;
+        programLength = 0;
+    }
+}
+
+static void flashfsWaitForProgram(void)
+{
+    while (programLength > 0) {
+        flashfsReleaseProgrammed();
+    }
+}
+
+// Throw away the buffered data that isn't already being sent to the flash
 static void flashfsClearBuffer()
 {
-    bufferTail = bufferHead = 0;
+    headAddress = tailAddress + programLength;
 }
 
 static bool flashfsBufferIsEmpty()
 {
-    return bufferTail == bufferHead;
+    return headAddress == tailAddress;
 }
 
 static void flashfsSetTailAddress(uint32_t address)
 {
+    flashfsWaitForProgram();
+
     tailAddress = address;
+    headAddress = address;
 }
 
 void flashfsEraseCompletely()
 {
-    m25p16_eraseCompletely();
+    flashfsWaitForProgram();
 
-    flashfsClearBuffer();
+    m25p16_eraseCompletely();
 
     flashfsSetTailAddress(0);
 }
@@ -118,10 +151,7 @@ uint32_t flashfsGetSize()
 
 static uint32_t flashfsTransmitBufferUsed()
 {
-    if (bufferHead >= bufferTail)
-        return bufferHead - bufferTail;
-
-    return FLASHFS_WRITE_BUFFER_SIZE - bufferTail + bufferHead;
+    return headAddress - tailAddress;
 }
 
 /**
@@ -129,7 +159,7 @@ static uint32_t flashfsTransmitBufferUsed()
  */
 uint32_t flashfsGetWriteBufferSize()
 {
-    return FLASHFS_WRITE_BUFFER_USABLE;
+    return flashWriteBufferSize;
 }
 
 /**
@@ -146,125 +176,52 @@ const flashGeometry_t* flashfsGetGeometry()
 }
 
 /**
- * Write the given buffers to flash sequentially at the current tail address, advancing the tail address after
- * each write.
- *
- * In synchronous mode, waits for the flash to become ready before writing so that every byte requested can be written.
+ * Start programming the oldest buffered bytes, up to the end of their page, to the flash at the tail address.
  *
- * In asynchronous mode, if the flash is busy, then the write is aborted and the routine returns immediately.
- * In this case the returned number of bytes written will be less than the total amount requested.
- *
- * Modifies the supplied buffer pointers and sizes to reflect how many bytes remain in each of them.
- *
- * bufferCount: the number of buffers provided
- * buffers: an array of pointers to the beginning of buffers
- * bufferSizes: an array of the sizes of those buffers
- * sync: true if we should wait for the device to be idle before writes, otherwise if the device is busy the
+ * partial: unless set, only a whole page is programmed, so that a page being filled is written with one program
+ *          operation rather than piece by piece.
+ * sync: true if we should wait for the device to be idle before the write, otherwise if the device is busy the
  *       write will be aborted and this routine will return immediately.
  *
- * Returns the number of bytes written
+ * Returns true if a program was started, the tail only moves on once its data has been sent.
  */
-static uint32_t flashfsWriteBuffers(uint8_t const **buffers, uint32_t *bufferSizes, int bufferCount, bool sync)
+static bool flashfsProgram(bool partial, bool sync)
 {
-    uint32_t bytesTotal = 0;
+    flashfsReleaseProgrammed();
 
-    int i;
+    if (programLength > 0) {
+        if (!sync) {
+            return false;
+        }
+        flashfsWaitForProgram();
+    }
 
-    for (i = 0; i < bufferCount; i++) {
-        bytesTotal += bufferSizes[i];
+    const uint32_t pageOffset = tailAddress % M25P16_PAGESIZE;
+    const uint32_t length = MIN(M25P16_PAGESIZE - pageOffset, flashfsTransmitBufferUsed());
+
+    if (length == 0 || (!partial && pageOffset + length < M25P16_PAGESIZE)) {
+        return false;
     }
 
     if (!sync && !m25p16_isReady()) {
-        return 0;
+        return false;
     }
 
-    uint32_t bytesTotalRemaining = bytesTotal;
-
-    while (bytesTotalRemaining > 0) {
-        uint32_t bytesTotalThisIteration;
-        uint32_t bytesRemainThisIteration;
-
-        /*
-         * Each page needs to be saved in a separate program operation, so
-         * if we would cross a page boundary, only write up to the boundary in this iteration:
-         */
-        if (tailAddress % M25P16_PAGESIZE + bytesTotalRemaining > M25P16_PAGESIZE) {
-            bytesTotalThisIteration = M25P16_PAGESIZE - tailAddress % M25P16_PAGESIZE;
-        } else {
-            bytesTotalThisIteration = bytesTotalRemaining;
-        }
-
-        // Are we at EOF already? Abort.
-        if (flashfsIsEOF()) {
-            // May as well throw away any buffered data
-            flashfsClearBuffer();
-
-            break;
-        }
-
-        m25p16_pageProgramBegin(tailAddress);
-
-        bytesRemainThisIteration = bytesTotalThisIteration;
-
-        for (i = 0; i < bufferCount; i++) {
-            if (bufferSizes[i] > 0) {
-                // Is buffer larger than our write limit? Write our limit out of it
-                if (bufferSizes[i] >= bytesRemainThisIteration) {
-                    m25p16_pageProgramContinue(buffers[i], bytesRemainThisIteration);
-
-                    buffers[i] += bytesRemainThisIteration;
-                    bufferSizes[i] -= bytesRemainThisIteration;
-
-                    bytesRemainThisIteration = 0;
-                    break;
-                } else {
-                    // We'll still have more to write after finishing this buffer off
-                    m25p16_pageProgramContinue(buffers[i], bufferSizes[i]);
-
-                    bytesRemainThisIteration -= bufferSizes[i];
-
-                    buffers[i] += bufferSizes[i];
-                    bufferSizes[i] = 0;
-                }
-            }
-        }
-
-        m25p16_pageProgramFinish();
-
-        bytesTotalRemaining -= bytesTotalThisIteration;
-
-        // Advance the cursor in the file system to match the bytes we wrote
-        flashfsSetTailAddress(tailAddress + bytesTotalThisIteration);
+    // Are we at EOF already? Abort.
+    if (flashfsIsEOF()) {
+        // May as well throw away any buffered data
+        flashfsClearBuffer();
 
-        /*
-         * We'll have to wait for that write to complete before we can issue the next one, so if
-         * the user requested asynchronous writes, break now.
-         */
-        if (!sync)
-            break;
+        return false;
     }
 
-    return bytesTotal - bytesTotalRemaining;
-}
+    m25p16_pageProgramAsync(tailAddress, flashWriteBuffer + tailAddress % flashWriteBufferSize, length);
+    programLength = length;
 
-/*
- * Since the buffered data might wrap around the end of the circular buffer, we can have two segments of data to write,
- * an initial portion and a possible wrapped portion.
- *
- * This routine will fill the details of those buffers into the provided arrays, which must be at least 2 elements long.
- */
-static void flashfsGetDirtyDataBuffers(uint8_t const *buffers[], uint32_t bufferSizes[])
-{
-    buffers[0] = flashWriteBuffer + bufferTail;
-    buffers[1] = flashWriteBuffer + 0;
-
-    if (bufferHead >= bufferTail) {
-        bufferSizes[0] = bufferHead - bufferTail;
-        bufferSizes[1] = 0;
-    } else {
-        bufferSizes[0] = FLASHFS_WRITE_BUFFER_SIZE - bufferTail;
-        bufferSizes[1] = bufferHead;
-    }
+    // Without DMA the data has been sent already
+    flashfsReleaseProgrammed();
+
+    return true;
 }
 
 /**
@@ -272,76 +229,41 @@ static void flashfsGetDirtyDataBuffers(uint8_t const *buffers[], uint32_t buffer
  */
 uint32_t flashfsGetOffset()
 {
-    uint8_t const * buffers[2];
-    uint32_t bufferSizes[2];
-
-    // Dirty data in the buffers contributes to the offset
-
-    flashfsGetDirtyDataBuffers(buffers, bufferSizes);
-
-    return tailAddress + bufferSizes[0] + bufferSizes[1];
-}
-
-/**
- * Called after bytes have been written from the buffer to advance the position of the tail by the given amount.
- */
-static void flashfsAdvanceTailInBuffer(uint32_t delta)
-{
-    bufferTail += delta;
-
-    // Wrap tail around the end of the buffer
-    if (bufferTail >= FLASHFS_WRITE_BUFFER_SIZE) {
-        bufferTail -= FLASHFS_WRITE_BUFFER_SIZE;
-    }
-
-    if (flashfsBufferIsEmpty()) {
-        flashfsClearBuffer(); // Bring buffer pointers back to the start to be tidier
-    }
+    // Dirty data in the buffer contributes to the offset
+    return headAddress;
 }
 
 /**
- * If the flash is ready to accept writes, flush the buffer to it.
+ * If the flash is ready to accept writes, start writing the buffer to it.
+ *
+ * force: unless set, only whole pages are written, leaving a partly filled page in the buffer to be completed.
  *
  * Returns true if all data in the buffer has been flushed to the device, or false if
  * there is still data to be written (call flush again later).
  */
-bool flashfsFlushAsync()
+bool flashfsFlushAsync(bool force)
 {
     if (flashfsBufferIsEmpty()) {
         return true; // Nothing to flush
     }
 
-    uint8_t const * buffers[2];
-    uint32_t bufferSizes[2];
-    uint32_t bytesWritten;
-
-    flashfsGetDirtyDataBuffers(buffers, bufferSizes);
-    bytesWritten = flashfsWriteBuffers(buffers, bufferSizes, 2, false);
-    flashfsAdvanceTailInBuffer(bytesWritten);
+    flashfsProgram(force, false);
 
     return flashfsBufferIsEmpty();
 }
 
 /**
- * Wait for the flash to become ready and begin flushing any buffered data to flash.
+ * Wait for the flash to become ready and write all the buffered data to flash.
  *
  * The flash will still be busy some time after this sync completes, but space will
  * be freed up to accept more writes in the write buffer.
  */
 void flashfsFlushSync()
 {
-    if (flashfsBufferIsEmpty()) {
-        return; // Nothing to flush
+    while (flashfsProgram(true, true)) {
     }
 
-    uint8_t const * buffers[2];
-    uint32_t bufferSizes[2];
-
-    flashfsGetDirtyDataBuffers(buffers, bufferSizes);
-    flashfsWriteBuffers(buffers, bufferSizes, 2, true);
-
-    // We've written our entire buffer now:
-    flashfsClearBuffer();
+    flashfsWaitForProgram();
 }
 
 void flashfsSeekAbs(uint32_t offset)
@@ -363,15 +285,15 @@ void flashfsSeekRel(int32_t offset)
  */
 void flashfsWriteByte(uint8_t byte)
 {
-    flashWriteBuffer[bufferHead++] = byte;
+    flashfsReleaseProgrammed();
 
-    if (bufferHead >= FLASHFS_WRITE_BUFFER_SIZE) {
-        bufferHead = 0;
+    if (flashfsTransmitBufferUsed() < flashWriteBufferSize) {
+        flashWriteBuffer[headAddress % flashWriteBufferSize] = byte;
+        headAddress++;
     }
 
-    if (flashfsTransmitBufferUsed() >= FLASHFS_WRITE_BUFFER_AUTO_FLUSH_LEN) {
-        flashfsFlushAsync();
-    }
+    // Program the page if that completed it
+    flashfsProgram(false, false);
 }
 
 /**
@@ -382,80 +304,42 @@ void flashfsWriteByte(uint8_t byte)
  */
 void flashfsWrite(const uint8_t *data, unsigned int len, bool sync)
 {
-    uint8_t const * buffers[3];
-    uint32_t bufferSizes[3];
-
-    // There could be two dirty buffers to write out already:
-    flashfsGetDirtyDataBuffers(buffers, bufferSizes);
-
-    // Plus the buffer the user supplied:
-    buffers[2] = data;
-    bufferSizes[2] = len;
-
-    /*
-     * Would writing this data to our buffer cause our buffer to reach the flush threshold? If so try to write through
-     * to the flash now
-     */
-    if (bufferSizes[0] + bufferSizes[1] + bufferSizes[2] >= FLASHFS_WRITE_BUFFER_AUTO_FLUSH_LEN) {
-        uint32_t bytesWritten;
+    if (flashWriteBufferSize == 0) {
+        return;
+    }
 
-        // Attempt to write all three buffers through to the flash asynchronously
-        bytesWritten = flashfsWriteBuffers(buffers, bufferSizes, 3, false);
+    // Make what room we can without waiting
+    flashfsProgram(false, false);
 
-        if (bufferSizes[0] == 0 && bufferSizes[1] == 0) {
-            // We wrote all the data that was previously buffered
-            flashfsClearBuffer();
+    if (!sync && len > flashfsGetWriteBufferFreeSpace()) {
+        /*
+         * Silently drop the data the user asked to write (i.e. no-op) since we can't buffer it and they
+         * requested async.
+         */
+        return;
+    }
 
-            if (bufferSizes[2] == 0) {
-                // And we wrote all the data the user supplied! Job done!
-                return;
-            }
-        } else {
-            // We only wrote a portion of the old data, so advance the tail to remove the bytes we did write from the buffer
-            flashfsAdvanceTailInBuffer(bytesWritten);
+    while (len > 0) {
+        if (flashfsGetWriteBufferFreeSpace() == 0) {
+            // Only a synchronous write can get here, so wait for a page to be written out to make room
+            flashfsProgram(true, true);
+            flashfsWaitForProgram();
+            continue;
         }
 
-        // Is the remainder of the data to be written too big to fit in the buffers?
-        if (bufferSizes[0] + bufferSizes[1] + bufferSizes[2] > FLASHFS_WRITE_BUFFER_USABLE) {
-            if (sync) {
-                // Write it through synchronously
-                flashfsWriteBuffers(buffers, bufferSizes, 3, true);
-                flashfsClearBuffer();
-            } else {
-                /*
-                 * Silently drop the data the user asked to write (i.e. no-op) since we can't buffer it and they
-                 * requested async.
-                 */
-            }
+        // Copy up to the end of the buffer, the rest wraps around to its start
+        const uint32_t index = headAddress % flashWriteBufferSize;
+        const uint32_t chunk = MIN(MIN(len, flashfsGetWriteBufferFreeSpace()), flashWriteBufferSize - index);
 
-            return;
-        }
+        memcpy(flashWriteBuffer + index, data, chunk);
 
-        // Fall through and add the remainder of the incoming data to our buffer
-        data = buffers[2];
-        len = bufferSizes[2];
+        headAddress += chunk;
+        data += chunk;
+        len -= chunk;
     }
 
-    // Buffer up the data the user supplied instead of writing it right away
-
-    // First write the portion before we wrap around the end of the circular buffer
-    unsigned int bufferBytesBeforeWrap = FLASHFS_WRITE_BUFFER_SIZE - bufferHead;
-
-    unsigned int firstPortion = len < bufferBytesBeforeWrap ? len : bufferBytesBeforeWrap;
-
-    memcpy(flashWriteBuffer + bufferHead, data, firstPortion);
-
-    bufferHead += firstPortion;
-
-    data += firstPortion;
-    len -= firstPortion;
-
-    // If we wrap the head around, write the remainder to the start of the buffer (if any)
-    if (bufferHead == FLASHFS_WRITE_BUFFER_SIZE) {
-        memcpy(flashWriteBuffer + 0, data, len);
-
-        bufferHead = len;
-    }
+    // Start on any pages that are now complete
+    flashfsProgram(false, false);
 }
 
 /**
@@ -481,62 +365,60 @@ int flashfsReadAbs(uint32_t address, uint8_t *buffer, unsigned int len)
     return bytesRead;
 }
 
+enum {
+    /* We don't expect valid data to ever contain this many consecutive uint32_t's of all 1 bits: */
+    FREE_SPACE_TEST_SIZE_INTS = 4, // i.e. 16 bytes
+    FREE_SPACE_TEST_SIZE_BYTES = FREE_SPACE_TEST_SIZE_INTS * sizeof(uint32_t)
+};
+
+typedef union {
+    uint8_t bytes[FREE_SPACE_TEST_SIZE_BYTES];
+    uint32_t ints[FREE_SPACE_TEST_SIZE_INTS];
+} freeSpaceTestBuffer_t;
+
+static bool flashfsIsTestBufferErased(const freeSpaceTestBuffer_t *testBuffer)
+{
+    // Checking the buffer 4 bytes at a time like this is probably faster than byte-by-byte, but I didn't benchmark it :)
+    for (int i = 0; i < FREE_SPACE_TEST_SIZE_INTS; i++) {
+        if (testBuffer->ints[i] != 0xFFFFFFFF) {
+            return false;
+        }
+    }
+    return true;
+}
+
 /**
  * Find the offset of the start of the free space on the device (or the size of the device if it is full).
  */
 int flashfsIdentifyStartOfFreeSpace()
 {
-    /* Find the start of the free space on the device by examining the beginning of blocks with a binary search,
-     * looking for ones that appear to be erased. We can achieve this with good accuracy because an erased block
-     * is all bits set to 1, which pretty much never appears in reasonable size substrings of blackbox logs.
+    /* Find the start of the free space on the device by examining the beginning of pages with a binary search,
+     * looking for ones that appear to be erased. We can achieve this with good accuracy because an erased page
+     * is all bits set to 1, which pretty much never appears in reasonable size substrings of blackbox logs. The
+     * search only reads a few bytes from each of log2(pages) pages, so even a 128MB chip is searched in a couple of
+     * dozen reads.
      *
      * To do better we might write a volume header instead, which would mark how much free space remains. But keeping
      * a header up to date while logging would incur more writes to the flash, which would consume precious write
      * bandwidth and block more often.
      */
 
-    enum {
-        /* We can choose whatever power of 2 size we like, which determines how much wastage of free space we'll have
-         * at the end of the last written data. But smaller blocksizes will require more searching.
-         */
-        FREE_BLOCK_SIZE = 2048,
-
-        /* We don't expect valid data to ever contain this many consecutive uint32_t's of all 1 bits: */
-        FREE_BLOCK_TEST_SIZE_INTS = 4, // i.e. 16 bytes
-        FREE_BLOCK_TEST_SIZE_BYTES = FREE_BLOCK_TEST_SIZE_INTS * sizeof(uint32_t)
-    };
-
-    union {
-        uint8_t bytes[FREE_BLOCK_TEST_SIZE_BYTES];
-        uint32_t ints[FREE_BLOCK_TEST_SIZE_INTS];
-    } testBuffer;
+    freeSpaceTestBuffer_t testBuffer;
 
-    int left = 0; // Smallest block index in the search region
-    int right = flashfsGetSize() / FREE_BLOCK_SIZE; // One past the largest block index in the search region
-    int mid;
+    int left = 0; // Smallest page index in the search region
+    int right = flashfsGetSize() / M25P16_PAGESIZE; // One past the largest page index in the search region
     int result = right;
-    int i;
-    bool blockErased;
 
     while (left < right) {
-        mid = (left + right) / 2;
+        const int mid = (left + right) / 2;
 
-        if (m25p16_readBytes(mid * FREE_BLOCK_SIZE, testBuffer.bytes, FREE_BLOCK_TEST_SIZE_BYTES) < FREE_BLOCK_TEST_SIZE_BYTES) {
+        if (m25p16_readBytes(mid * M25P16_PAGESIZE, testBuffer.bytes, FREE_SPACE_TEST_SIZE_BYTES) < FREE_SPACE_TEST_SIZE_BYTES) {
             // Unexpected timeout from flash, so bail early (reporting the device fuller than it really is)
-            break;
+            return result * M25P16_PAGESIZE;
         }
 
-        // Checking the buffer 4 bytes at a time like this is probably faster than byte-by-byte, but I didn't benchmark it :)
-        blockErased = true;
-        for (i = 0; i < FREE_BLOCK_TEST_SIZE_INTS; i++) {
-            if (testBuffer.ints[i] != 0xFFFFFFFF) {
-                blockErased = false;
-                break;
-            }
-        }
-
-        if (blockErased) {
-            /* This erased block might be the leftmost erased block in the volume, but we'll need to continue the
+        if (flashfsIsTestBufferErased(&testBuffer)) {
+            /* This erased page might be the leftmost erased page in the volume, but we'll need to continue the
              * search leftwards to find out:
              */
             result = mid;
@@ -547,7 +429,33 @@ int flashfsIdentifyStartOfFreeSpace()
         }
     }
 
-    return result * FREE_BLOCK_SIZE;
+    if (result == 0) {
+        return 0;
+    }
+
+    /* The last written page is usually only partly filled, so the free space starts after its last test-sized run of
+     * data that isn't erased. A log that ended with a few erased bytes loses nothing when they are written again.
+     */
+    const uint32_t pageStart = (result - 1) * M25P16_PAGESIZE;
+    uint32_t address = pageStart + M25P16_PAGESIZE;
+
+    while (address > pageStart) {
+        address -= FREE_SPACE_TEST_SIZE_BYTES;
+
+        if (m25p16_readBytes(address, testBuffer.bytes, FREE_SPACE_TEST_SIZE_BYTES) < FREE_SPACE_TEST_SIZE_BYTES) {
+            return result * M25P16_PAGESIZE;
+        }
+
+        if (!flashfsIsTestBufferErased(&testBuffer)) {
+            int length = FREE_SPACE_TEST_SIZE_BYTES;
+            while (testBuffer.bytes[length - 1] == 0xFF) {
+                length--;
+            }
+            return address + length;
+        }
+    }
+
+    return pageStart;
 }
 
 /**
@@ -564,6 +472,13 @@ void flashfsInit()
 {
     // If we have a flash chip present at all
     if (flashfsGetSize() > 0) {
+        // The last claim on the arena, so that the buffer gets the memory of every feature that is disabled
+        if (!flashWriteBuffer) {
+            size_t size;
+            flashWriteBuffer = arenaAllocRemaining(M25P16_PAGESIZE, &size);
+            flashWriteBufferSize = size;
+        }
+
         // Start the file pointer off at the beginning of free space so caller can start writing immediately
         flashfsSeekAbs(flashfsIdentifyStartOfFreeSpace());
     }
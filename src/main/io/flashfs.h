@@ -17,11 +17,29 @@
 
 #pragma once
 
-#define FLASHFS_WRITE_BUFFER_SIZE 128
-#define FLASHFS_WRITE_BUFFER_USABLE (FLASHFS_WRITE_BUFFER_SIZE - 1)
+#include <stdbool.h>
+#include <stdint.h>
 
-// Automatically trigger a flush when this much data is in the buffer
-#define FLASHFS_WRITE_BUFFER_AUTO_FLUSH_LEN 64
+#include "drivers/flash_m25p16.h"
+
+/*
+ * The write buffer is a whole number of flash pages, so one page can be filled while another is programmed. Targets
+ * with RAM to spare can define a larger one to ride out the flash being busy for longer.
+ *
+ * This is the size reserved for it in the arena, the buffer takes whatever the arena has left once the other features
+ * have claimed theirs, so it grows by the buffers of the features that are disabled.
+ */
+#ifndef FLASHFS_WRITE_BUFFER_SIZE
+#if defined(STM32F7)
+#define FLASHFS_WRITE_BUFFER_SIZE (8 * M25P16_PAGESIZE)
+#elif defined(STM32F10X)
+#define FLASHFS_WRITE_BUFFER_SIZE M25P16_PAGESIZE
+#else
+#define FLASHFS_WRITE_BUFFER_SIZE (2 * M25P16_PAGESIZE)
+#endif
+#endif
+
+#define FLASHFS_ARENA_SIZE FLASHFS_WRITE_BUFFER_SIZE
 
 void flashfsEraseCompletely();
 void flashfsEraseRange(uint32_t start, uint32_t end);
@@ -42,7 +60,7 @@ void flashfsWrite(const uint8_t *data, unsigned int len, bool sync);
 
 int flashfsReadAbs(uint32_t offset, uint8_t *data, unsigned int len);
 
-bool flashfsFlushAsync();
+bool flashfsFlushAsync(bool force);
 void flashfsFlushSync();
 
 void flashfsInit();
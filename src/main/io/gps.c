@@ -30,7 +30,6 @@
 #include "build/debug.h"
 
 #include "common/axis.h"
-#include "common/gps_conversion.h"
 #include "common/maths.h"
 #include "common/utils.h"
 
@@ -63,6 +62,7 @@
 #define LOG_UBLOX_SVINFO 'I'
 #define LOG_UBLOX_POSLLH 'P'
 #define LOG_UBLOX_VELNED 'V'
+#define LOG_UBLOX_PVT    'T'
 
 #define GPS_SV_MAXSATS   16
 
@@ -84,6 +84,7 @@ uint8_t GPS_svinfo_cno[GPS_SV_MAXSATS];     // Carrier to Noise Ratio (Signal St
 
 // GPS timeout for wrong baud rate/disconnection/etc in milliseconds (default 2.5second)
 #define GPS_TIMEOUT (2500)
+#define GPS_RX_BLOCK_SIZE 64
 // How many entries in gpsInitData array below
 #define GPS_INIT_ENTRIES (GPS_BAUDRATE_MAX + 1)
 #define GPS_BAUDRATE_CHANGE_DELAY (200)
@@ -109,6 +110,19 @@ static const gpsInitData_t gpsInitData[] = {
 
 #define GPS_INIT_DATA_ENTRY_COUNT (sizeof(gpsInitData) / sizeof(gpsInitData[0]))
 
+// Baud rate detection listens at each rate in turn, starting with the configured one, and keeps the first
+// rate that carries the start of an NMEA sentence or a UBX frame. At a wrong rate the receiver's output turns
+// into framing garbage straight away, so a rate is given up after GPS_DETECT_GARBAGE_BYTES without a frame
+// start, and only a silent rate costs the full GPS_DETECT_SILENCE_MS.
+#define GPS_DETECT_SILENCE_MS 1100      // longer than the gap between two 1Hz NMEA bursts
+#define GPS_DETECT_GARBAGE_BYTES 64
+
+static uint8_t gpsDetectPrevious;
+static uint16_t gpsDetectByteCount;
+static bool gpsDetectSeen;
+static bool gpsBaudDetected;
+static uint8_t gpsDetectedIndex;        // into gpsInitData
+
 #define DEFAULT_BAUD_RATE_INDEX 0
 
 static const uint8_t ubloxInit[] = {
@@ -149,10 +163,35 @@ static const uint8_t ubloxInit[] = {
     //0xB5, 0x62, 0x06, 0x01, 0x03, 0x00, 0x01, 0x30, 0x01, 0x3C, 0xA3,           // set SVINFO MSG rate (every cycle - high bandwidth)
     0xB5, 0x62, 0x06, 0x01, 0x03, 0x00, 0x01, 0x30, 0x05, 0x40, 0xA7,           // set SVINFO MSG rate (evey 5 cycles - low bandwidth)
     0xB5, 0x62, 0x06, 0x01, 0x03, 0x00, 0x01, 0x12, 0x01, 0x1E, 0x67,           // set VELNED MSG rate
+    0xB5, 0x62, 0x06, 0x01, 0x03, 0x00, 0x01, 0x07, 0x01, 0x13, 0x51,           // set PVT MSG rate (u-blox 7 and later, ignored by older receivers)
 
-    0xB5, 0x62, 0x06, 0x08, 0x06, 0x00, 0xC8, 0x00, 0x01, 0x00, 0x01, 0x00, 0xDE, 0x6A,             // set rate to 5Hz (measurement period: 200ms, navigation rate: 1 cycle)
+    // the navigation rate is set afterwards, see GPS_MESSAGE_STATE_RATE
 };
 
+// Once NAV-PVT has been seen it carries everything, the messages it replaces only use up the link
+static const uint8_t ubloxLegacyOff[] = {
+    0xB5, 0x62, 0x06, 0x01, 0x03, 0x00, 0x01, 0x02, 0x00, 0x0D, 0x46,           // disable POSLLH
+    0xB5, 0x62, 0x06, 0x01, 0x03, 0x00, 0x01, 0x03, 0x00, 0x0E, 0x48,           // disable STATUS
+    0xB5, 0x62, 0x06, 0x01, 0x03, 0x00, 0x01, 0x06, 0x00, 0x11, 0x4E,           // disable SOL
+    0xB5, 0x62, 0x06, 0x01, 0x03, 0x00, 0x01, 0x12, 0x00, 0x1D, 0x66,           // disable VELNED
+};
+
+// Measurement periods tried from the fastest the link can carry down, the first one the receiver acknowledges is kept.
+// 25, 20, 18, 10 and 5Hz, an M8 takes up to 18Hz with GPS only and 10Hz with several constellations.
+static const uint16_t ubloxNavRatesMs[] = { 40, 50, 55, 100, 200 };
+#define UBLOX_ACK_TIMEOUT_MS 500
+
+typedef enum {
+    UBLOX_ACK_WAITING,
+    UBLOX_ACK_GOT_ACK,
+    UBLOX_ACK_GOT_NACK
+} ubloxAckState_e;
+
+static uint8_t ubloxNavRateIndex;
+static ubloxAckState_e ubloxAckState;
+static bool ubloxHavePvt;
+static bool ubloxLegacyDisabled;
+
 // UBlox 6 Protocol documentation - GPS.G6-SW-10018-F
 // SBAS Configuration Settings Desciption, Page 4/210
 // 31.21 CFG-SBAS (0x06 0x16), Page 142/210
@@ -183,6 +222,7 @@ static const ubloxSbas_t ubloxSbas[] = {
 
 typedef enum {
     GPS_UNKNOWN,
+    GPS_DETECT_BAUD,
     GPS_INITIALIZING,
     GPS_CHANGE_BAUD,
     GPS_CONFIGURE,
@@ -212,8 +252,10 @@ static void shiftPacketLog(void)
 }
 
 static void gpsNewData(uint16_t c);
+static void gpsNewDataBlock(const uint8_t *data, uint32_t length);
 static bool gpsNewFrameNMEA(char c);
 static bool gpsNewFrameUBLOX(uint8_t data);
+static void ubloxUpdateChecksum(const uint8_t *data, uint32_t length, uint8_t *ckA, uint8_t *ckB);
 
 static void gpsSetState(gpsState_e state)
 {
@@ -228,6 +270,7 @@ void gpsInit(void)
     gpsData.baudrateIndex = 0;
     gpsData.errors = 0;
     gpsData.timeouts = 0;
+    gpsBaudDetected = false;
 
     memset(gpsPacketLog, 0x00, sizeof(gpsPacketLog));
 
@@ -265,7 +308,62 @@ void gpsInit(void)
     }
 
     // signal GPS "thread" to initialize when it gets to it
-    gpsSetState(GPS_INITIALIZING);
+    gpsSetState(gpsConfig()->autoBaud ? GPS_DETECT_BAUD : GPS_INITIALIZING);
+}
+
+static bool gpsDetectBaudData(const uint8_t *data, uint32_t length)
+{
+    for (uint32_t i = 0; i < length; i++) {
+        const uint8_t c = data[i];
+        if ((gpsDetectPrevious == '$' && (c == 'G' || c == 'P')) || (gpsDetectPrevious == 0xB5 && c == 0x62)) {
+            return true;
+        }
+        gpsDetectPrevious = c;
+    }
+    gpsDetectByteCount += length;
+    return false;
+}
+
+static void gpsDetectBaud(void)
+{
+    const uint32_t now = millis();
+
+    if (gpsDetectSeen) {
+        gpsDetectSeen = false;
+        // state_position has already moved past the rate being listened at
+        const uint8_t index = (gpsData.baudrateIndex + gpsData.state_position - 1) % GPS_INIT_DATA_ENTRY_COUNT;
+        if (index == gpsData.baudrateIndex || gpsConfig()->provider != GPS_UBLOX) {
+            // NMEA receivers can't be told to change rate, they are used at whichever rate they talk
+            gpsData.baudrateIndex = index;
+            gpsSetState(GPS_CHANGE_BAUD);
+        } else {
+            // only the rate the receiver was heard at needs to be told to switch to ours
+            gpsDetectedIndex = index;
+            gpsBaudDetected = true;
+            gpsSetState(GPS_INITIALIZING);
+        }
+        return;
+    }
+
+    if (gpsData.state_position > 0 && now - gpsData.state_ts < GPS_DETECT_SILENCE_MS && gpsDetectByteCount < GPS_DETECT_GARBAGE_BYTES) {
+        return;
+    }
+
+    if (gpsData.state_position >= GPS_INIT_DATA_ENTRY_COUNT) {
+        // nothing recognisable at any rate, configure blind
+        gpsSetState(GPS_INITIALIZING);
+        return;
+    }
+
+    const uint8_t index = (gpsData.baudrateIndex + gpsData.state_position) % GPS_INIT_DATA_ENTRY_COUNT;
+    serialSetBaudRate(gpsPort, baudRates[gpsInitData[index].baudrateIndex]);
+    while (serialRxBytesWaiting(gpsPort)) {
+        serialRead(gpsPort);
+    }
+    gpsDetectPrevious = 0;
+    gpsDetectByteCount = 0;
+    gpsData.state_ts = now;
+    gpsData.state_position++;
 }
 
 void gpsInitNmea(void)
@@ -317,6 +415,22 @@ void gpsInitNmea(void)
     }
 }
 
+static void ubloxSendNavRate(uint16_t measurementPeriodMs)
+{
+    // CFG-RATE: measurement period, one navigation solution per measurement, aligned to GPS time
+    uint8_t message[] = { 0xB5, 0x62, 0x06, 0x08, 0x06, 0x00,
+        measurementPeriodMs & 0xFF, measurementPeriodMs >> 8, 0x01, 0x00, 0x01, 0x00, 0x00, 0x00 };
+    uint8_t ckA = 0;
+    uint8_t ckB = 0;
+    ubloxUpdateChecksum(&message[2], sizeof(message) - 4, &ckA, &ckB);
+    message[sizeof(message) - 2] = ckA;
+    message[sizeof(message) - 1] = ckB;
+
+    ubloxAckState = UBLOX_ACK_WAITING;
+    gpsData.state_ts = millis();
+    serialWriteBuf(gpsPort, message, sizeof(message));
+}
+
 void gpsInitUblox(void)
 {
     uint32_t now;
@@ -334,8 +448,9 @@ void gpsInitUblox(void)
                 return;
 
             if (gpsData.state_position < GPS_INIT_ENTRIES) {
-                // try different speed to INIT
-                baudRate_e newBaudRateIndex = gpsInitData[gpsData.state_position].baudrateIndex;
+                // try different speed to INIT, or only the one the receiver was detected at
+                const uint8_t initIndex = gpsBaudDetected ? gpsDetectedIndex : gpsData.state_position;
+                baudRate_e newBaudRateIndex = gpsInitData[initIndex].baudrateIndex;
 
                 gpsData.state_ts = now;
 
@@ -348,7 +463,7 @@ void gpsInitUblox(void)
                 // print our FIXED init string for the baudrate we want to be at
                 serialPrint(gpsPort, gpsInitData[gpsData.baudrateIndex].ubx);
 
-                gpsData.state_position++;
+                gpsData.state_position = gpsBaudDetected ? GPS_INIT_ENTRIES : gpsData.state_position + 1;
             } else {
                 // we're now (hopefully) at the correct rate, next state will switch to it
                 gpsSetState(GPS_CHANGE_BAUD);
@@ -373,8 +488,10 @@ void gpsInitUblox(void)
             if (gpsData.messageState == GPS_MESSAGE_STATE_INIT) {
 
                 if (gpsData.state_position < sizeof(ubloxInit)) {
-                    serialWrite(gpsPort, ubloxInit[gpsData.state_position]);
-                    gpsData.state_position++;
+                    // as much as the (empty) transmit buffer takes, usually all of it
+                    const uint32_t count = MIN(sizeof(ubloxInit) - gpsData.state_position, serialTxBytesFree(gpsPort));
+                    serialWriteBuf(gpsPort, &ubloxInit[gpsData.state_position], count);
+                    gpsData.state_position += count;
                 } else {
                     gpsData.state_position = 0;
                     gpsData.messageState++;
@@ -382,14 +499,31 @@ void gpsInitUblox(void)
             }
 
             if (gpsData.messageState == GPS_MESSAGE_STATE_SBAS) {
-                if (gpsData.state_position < UBLOX_SBAS_PREFIX_LENGTH) {
-                    serialWrite(gpsPort, ubloxSbasPrefix[gpsData.state_position]);
+                uint8_t sbas[UBLOX_SBAS_PREFIX_LENGTH + UBLOX_SBAS_MESSAGE_LENGTH];
+                memcpy(sbas, ubloxSbasPrefix, UBLOX_SBAS_PREFIX_LENGTH);
+                memcpy(&sbas[UBLOX_SBAS_PREFIX_LENGTH], ubloxSbas[gpsConfig()->sbasMode].message, UBLOX_SBAS_MESSAGE_LENGTH);
+                serialWriteBuf(gpsPort, sbas, sizeof(sbas));
+                gpsData.messageState++;
+            }
+
+            if (gpsData.messageState == GPS_MESSAGE_STATE_RATE) {
+                if (gpsData.state_position == 0) {
+                    // start where a solution per period still fits in the link with all messages enabled
+                    const uint32_t baudRate = serialGetBaudRate(gpsPort);
+                    ubloxNavRateIndex = baudRate >= 115200 ? 0 : baudRate >= 57600 ? 3 : 4;
                     gpsData.state_position++;
-                } else if (gpsData.state_position < UBLOX_SBAS_PREFIX_LENGTH + UBLOX_SBAS_MESSAGE_LENGTH) {
-                    serialWrite(gpsPort, ubloxSbas[gpsConfig()->sbasMode].message[gpsData.state_position - UBLOX_SBAS_PREFIX_LENGTH]);
+                }
+                if (gpsData.state_position == 1) {
+                    ubloxSendNavRate(ubloxNavRatesMs[ubloxNavRateIndex]);
                     gpsData.state_position++;
-                } else {
+                } else if (ubloxAckState == UBLOX_ACK_GOT_ACK) {
                     gpsData.messageState++;
+                } else if (ubloxAckState == UBLOX_ACK_GOT_NACK || millis() - gpsData.state_ts > UBLOX_ACK_TIMEOUT_MS) {
+                    if (++ubloxNavRateIndex < ARRAYLEN(ubloxNavRatesMs)) {
+                        gpsData.state_position = 1;
+                    } else {
+                        gpsData.messageState++;
+                    }
                 }
             }
 
@@ -427,14 +561,25 @@ void gpsUpdate(timeUs_t currentTimeUs)
 {
     // read out available GPS bytes
     if (gpsPort) {
-        while (serialRxBytesWaiting(gpsPort))
-            gpsNewData(serialRead(gpsPort));
+        uint8_t block[GPS_RX_BLOCK_SIZE];
+        uint32_t count;
+        while ((count = serialReadBuf(gpsPort, block, sizeof(block))) > 0) {
+            if (gpsData.state == GPS_DETECT_BAUD) {
+                gpsDetectSeen |= gpsDetectBaudData(block, count);
+            } else {
+                gpsNewDataBlock(block, count);
+            }
+        }
     }
 
     switch (gpsData.state) {
         case GPS_UNKNOWN:
             break;
 
+        case GPS_DETECT_BAUD:
+            gpsDetectBaud();
+            break;
+
         case GPS_INITIALIZING:
         case GPS_CHANGE_BAUD:
         case GPS_CONFIGURE:
@@ -443,15 +588,15 @@ void gpsUpdate(timeUs_t currentTimeUs)
 
         case GPS_LOST_COMMUNICATION:
             gpsData.timeouts++;
-            if (gpsConfig()->autoBaud) {
-                // try another rate
-                gpsData.baudrateIndex++;
-                gpsData.baudrateIndex %= GPS_INIT_ENTRIES;
-            }
+            gpsBaudDetected = false;
             gpsData.lastMessage = millis();
             gpsSol.numSat = 0;
             DISABLE_STATE(GPS_FIX);
-            gpsSetState(GPS_INITIALIZING);
+            // the receiver may have been replaced, configuration starts over
+            ubloxHavePvt = false;
+            ubloxLegacyDisabled = false;
+            // with auto baud the rate is found by listening instead of by waiting for another timeout
+            gpsSetState(gpsConfig()->autoBaud ? GPS_DETECT_BAUD : GPS_INITIALIZING);
             break;
 
         case GPS_RECEIVING_DATA:
@@ -460,6 +605,9 @@ void gpsUpdate(timeUs_t currentTimeUs)
                 // remove GPS from capability
                 sensorsClear(SENSOR_GPS);
                 gpsSetState(GPS_LOST_COMMUNICATION);
+            } else if (ubloxHavePvt && !ubloxLegacyDisabled && gpsConfig()->autoConfig == GPS_AUTOCONFIG_ON && isSerialTransmitBufferEmpty(gpsPort)) {
+                serialWriteBuf(gpsPort, ubloxLegacyOff, sizeof(ubloxLegacyOff));
+                ubloxLegacyDisabled = true;
             }
             break;
     }
@@ -468,12 +616,8 @@ void gpsUpdate(timeUs_t currentTimeUs)
     }
 }
 
-static void gpsNewData(uint16_t c)
+static void gpsHandleNewFrame(void)
 {
-    if (!gpsNewFrame(c)) {
-        return;
-    }
-
     // new data received and parsed, we're in business
     gpsData.lastLastMessage = gpsData.lastMessage;
     gpsData.lastMessage = millis();
@@ -491,6 +635,35 @@ static void gpsNewData(uint16_t c)
     onGpsNewData();
 }
 
+static void gpsNewData(uint16_t c)
+{
+    if (gpsNewFrame(c)) {
+        gpsHandleNewFrame();
+    }
+}
+
+static uint32_t gpsNewFrameUBLOXBlock(const uint8_t *data, uint32_t length, bool *newFrame);
+
+static void gpsNewDataBlock(const uint8_t *data, uint32_t length)
+{
+    if (gpsConfig()->provider != GPS_UBLOX) {
+        for (uint32_t i = 0; i < length; i++) {
+            gpsNewData(data[i]);
+        }
+        return;
+    }
+
+    while (length > 0) {
+        bool newFrame;
+        const uint32_t used = gpsNewFrameUBLOXBlock(data, length, &newFrame);
+        if (newFrame) {
+            gpsHandleNewFrame();
+        }
+        data += used;
+        length -= used;
+    }
+}
+
 bool gpsNewFrame(uint8_t c)
 {
     switch (gpsConfig()->provider) {
@@ -517,6 +690,9 @@ bool gpsNewFrame(uint8_t c)
      // added by Mis
      - GPS altitude (for OSD displaying)
      - GPS speed (for OSD displaying)
+
+   Fields are decoded as their characters arrive, so no field is kept as a string and nothing is
+   scanned a second time once the ',' comes. Sentences we have no use for only go through the checksum.
 */
 
 #define NO_FRAME   0
@@ -524,67 +700,83 @@ bool gpsNewFrame(uint8_t c)
 #define FRAME_RMC  2
 #define FRAME_GSV  3
 
+// Last characters of the sentence address, talker first ("GPGSV" is kept as 'P','G','S','V')
+#define NMEA_TAG(a, b, c, d) (((uint32_t)(a) << 24) | ((uint32_t)(b) << 16) | ((uint32_t)(c) << 8) | (uint32_t)(d))
 
-// This code is used for parsing NMEA data
+#define NMEA_FRACTION_DIGITS 5
 
-/* Alex optimization
-  The latitude or longitude is coded this way in NMEA frames
+/* The latitude or longitude is coded this way in NMEA frames
   dm.f   coded as degrees + minutes + minute decimal
   Where:
     - d can be 1 or more char long. generally: 2 char long for latitude, 3 char long for longitude
     - m is always 2 char long
-    - f can be 1 or more char long
-  This function converts this format in a unique unsigned long where 1 degree = 10 000 000
+    - f can be 1 or more char long, only the first NMEA_FRACTION_DIGITS are used
+  The integer part arrives as the number ddmm, so degrees and minutes are split with a single division
+  once the field is complete. The result is an integer where 1 degree = 10 000 000.
+*/
 
-  EOS increased the precision here, even if we think that the gps is not precise enough, with 10e5 precision it has 76cm resolution
-  with 10e7 it's around 1 cm now. Increasing it further is irrelevant, since even 1cm resolution is unrealistic, however increased
-  resolution also increased precision of nav calculations
-static uint32_t GPS_coord_to_degrees(char *coordinateString)
+// Value of the field being received, built up one character at a time
+typedef struct nmeaField_s {
+    uint32_t integer;           // digits before the '.'
+    uint32_t fraction;          // first fractionDigits digits after the '.'
+    uint8_t fractionDigits;
+    bool decimal;
+    char first;                 // first character, for the single letter fields
+} nmeaField_t;
+
+// Scales nmeaField_t.fraction to NMEA_FRACTION_DIGITS digits, indexed by fractionDigits
+static const uint32_t nmeaFractionScale[NMEA_FRACTION_DIGITS + 1] = { 0, 10000, 1000, 100, 10, 1 };
+
+static void nmeaFieldAddChar(nmeaField_t *field, char c)
 {
-    char *p = s, *d = s;
-    uint8_t min, deg = 0;
-    uint16_t frac = 0, mult = 10000;
-
-    while (*p) {                // parse the string until its end
-        if (d != s) {
-            frac += (*p - '0') * mult;  // calculate only fractional part on up to 5 digits  (d != s condition is true when the . is located)
-            mult /= 10;
-        }
-        if (*p == '.')
-            d = p;              // locate '.' char in the string
-        p++;
+    if (!field->first) {
+        field->first = c;
     }
-    if (p == s)
-        return 0;
-    while (s < d - 2) {
-        deg *= 10;              // convert degrees : all chars before minutes ; for the first iteration, deg = 0
-        deg += *(s++) - '0';
+    if (c >= '0' && c <= '9') {
+        if (!field->decimal) {
+            if (field->integer < 100000000) {
+                field->integer = field->integer * 10 + (c - '0');
+            }
+        } else if (field->fractionDigits < NMEA_FRACTION_DIGITS) {
+            field->fraction = field->fraction * 10 + (c - '0');
+            field->fractionDigits++;
+        }
+    } else if (c == '.') {
+        field->decimal = true;
     }
-    min = *(d - 1) - '0' + (*(d - 2) - '0') * 10;       // convert minutes : 2 previous char before '.'
-    return deg * 10000000UL + (min * 100000UL + frac) * 10UL / 6;
 }
-*/
 
-// helper functions
-static uint32_t grab_fields(char *src, uint8_t mult)
-{                               // convert string to uint32
-    uint32_t i;
-    uint32_t tmp = 0;
-    for (i = 0; src[i] != 0; i++) {
-        if (src[i] == '.') {
-            i++;
-            if (mult == 0)
-                break;
-            else
-                src[i + mult] = 0;
-        }
-        tmp *= 10;
-        if (src[i] >= '0' && src[i] <= '9')
-            tmp += src[i] - '0';
-        if (i >= 15)
-            return 0; // out of bounds
+static uint32_t nmeaFieldFraction(const nmeaField_t *field)
+{
+    return field->fraction * nmeaFractionScale[field->fractionDigits];
+}
+
+// Integer part with one decimal, e.g. knots * 10 or degrees * 10
+static uint32_t nmeaFieldTenths(const nmeaField_t *field)
+{
+    return field->integer * 10 + nmeaFieldFraction(field) / 10000;
+}
+
+static uint32_t nmeaFieldCoordinate(const nmeaField_t *field)
+{
+    const uint32_t degrees = field->integer / 100;
+    const uint32_t minutes = field->integer - degrees * 100;
+    return degrees * 10000000UL + (minutes * 100000UL + nmeaFieldFraction(field)) * 10UL / 6;
+}
+
+static uint8_t nmeaFrameType(uint32_t tag)
+{
+    switch (tag & 0x00FFFFFF) {
+    case NMEA_TAG(0, 'G', 'G', 'A'):
+        return FRAME_GGA;
+    case NMEA_TAG(0, 'R', 'M', 'C'):
+        return FRAME_RMC;
+    }
+    // Each constellation numbers its own GSV messages, only the GPS ones fill the satellite table
+    if (tag == NMEA_TAG('P', 'G', 'S', 'V')) {
+        return FRAME_GSV;
     }
-    return tmp;
+    return NO_FRAME;
 }
 
 typedef struct gpsDataNmea_s {
@@ -594,15 +786,17 @@ typedef struct gpsDataNmea_s {
     uint16_t altitude;
     uint16_t speed;
     uint16_t ground_course;
+    bool fix;
 } gpsDataNmea_t;
 
 static bool gpsNewFrameNMEA(char c)
 {
     static gpsDataNmea_t gps_Msg;
+    static nmeaField_t field;
+    static uint32_t tag;
 
     uint8_t frameOK = 0;
-    static uint8_t param = 0, offset = 0, parity = 0;
-    static char string[15];
+    static uint8_t param = 0, parity = 0, checksum = 0;
     static uint8_t checksum_param, gps_frame = NO_FRAME;
     static uint8_t svMessageNum = 0;
     uint8_t svSatNum = 0, svPacketIdx = 0, svSatParam = 0;
@@ -610,20 +804,16 @@ static bool gpsNewFrameNMEA(char c)
     switch (c) {
         case '$':
             param = 0;
-            offset = 0;
             parity = 0;
+            checksum_param = 0;
+            tag = 0;
+            gps_frame = NO_FRAME;
+            memset(&field, 0, sizeof(field));
             break;
         case ',':
         case '*':
-            string[offset] = 0;
             if (param == 0) {       //frame identification
-                gps_frame = NO_FRAME;
-                if (string[0] == 'G' && string[1] == 'P' && string[2] == 'G' && string[3] == 'G' && string[4] == 'A')
-                    gps_frame = FRAME_GGA;
-                if (string[0] == 'G' && string[1] == 'P' && string[2] == 'R' && string[3] == 'M' && string[4] == 'C')
-                    gps_frame = FRAME_RMC;
-                if (string[0] == 'G' && string[1] == 'P' && string[2] == 'G' && string[3] == 'S' && string[4] == 'V')
-                    gps_frame = FRAME_GSV;
+                gps_frame = nmeaFrameType(tag);
             }
 
             switch (gps_frame) {
@@ -632,41 +822,37 @@ static bool gpsNewFrameNMEA(char c)
             //          case 1:             // Time information
             //              break;
                         case 2:
-                            gps_Msg.latitude = GPS_coord_to_degrees(string);
+                            gps_Msg.latitude = nmeaFieldCoordinate(&field);
                             break;
                         case 3:
-                            if (string[0] == 'S')
+                            if (field.first == 'S')
                                 gps_Msg.latitude *= -1;
                             break;
                         case 4:
-                            gps_Msg.longitude = GPS_coord_to_degrees(string);
+                            gps_Msg.longitude = nmeaFieldCoordinate(&field);
                             break;
                         case 5:
-                            if (string[0] == 'W')
+                            if (field.first == 'W')
                                 gps_Msg.longitude *= -1;
                             break;
                         case 6:
-                            if (string[0] > '0') {
-                                ENABLE_STATE(GPS_FIX);
-                            } else {
-                                DISABLE_STATE(GPS_FIX);
-                            }
+                            gps_Msg.fix = field.first > '0';
                             break;
                         case 7:
-                            gps_Msg.numSat = grab_fields(string, 0);
+                            gps_Msg.numSat = field.integer;
                             break;
                         case 9:
-                            gps_Msg.altitude = grab_fields(string, 0);     // altitude in meters added by Mis
+                            gps_Msg.altitude = field.integer;     // altitude in meters added by Mis
                             break;
                     }
                     break;
                 case FRAME_RMC:        //************* GPRMC FRAME parsing
                     switch (param) {
                         case 7:
-                            gps_Msg.speed = ((grab_fields(string, 1) * 5144L) / 1000L);    // speed in cm/s added by Mis
+                            gps_Msg.speed = ((nmeaFieldTenths(&field) * 5144L) / 1000L);    // speed in cm/s added by Mis
                             break;
                         case 8:
-                            gps_Msg.ground_course = (grab_fields(string, 1));      // ground course deg * 10
+                            gps_Msg.ground_course = nmeaFieldTenths(&field);      // ground course deg * 10
                             break;
                     }
                     break;
@@ -677,11 +863,11 @@ static bool gpsNewFrameNMEA(char c)
                             break; */
                         case 2:
                             // Message number
-                            svMessageNum = grab_fields(string, 0);
+                            svMessageNum = field.integer;
                             break;
                         case 3:
                             // Total number of SVs visible
-                            GPS_numCh = grab_fields(string, 0);
+                            GPS_numCh = field.integer;
                             break;
                     }
                     if (param < 4)
@@ -698,7 +884,7 @@ static bool gpsNewFrameNMEA(char c)
                         case 1:
                             // SV PRN number
                             GPS_svinfo_chn[svSatNum - 1]  = svSatNum;
-                            GPS_svinfo_svid[svSatNum - 1] = grab_fields(string, 0);
+                            GPS_svinfo_svid[svSatNum - 1] = field.integer;
                             break;
                       /*case 2:
                             // Elevation, in degrees, 90 maximum
@@ -708,7 +894,7 @@ static bool gpsNewFrameNMEA(char c)
                             break; */
                         case 4:
                             // SNR, 00 through 99 dB (null when not tracking)
-                            GPS_svinfo_cno[svSatNum - 1] = grab_fields(string, 0);
+                            GPS_svinfo_cno[svSatNum - 1] = field.integer;
                             GPS_svinfo_quality[svSatNum - 1] = 0; // only used by ublox
                             break;
                     }
@@ -719,17 +905,18 @@ static bool gpsNewFrameNMEA(char c)
             }
 
             param++;
-            offset = 0;
-            if (c == '*')
+            memset(&field, 0, sizeof(field));
+            if (c == '*') {
                 checksum_param = 1;
-            else
+                checksum = 0;
+            } else {
                 parity ^= c;
+            }
             break;
         case '\r':
         case '\n':
             if (checksum_param) {   //parity checksum
                 shiftPacketLog();
-                uint8_t checksum = 16 * ((string[0] >= 'A') ? string[0] - 'A' + 10 : string[0] - '0') + ((string[1] >= 'A') ? string[1] - 'A' + 10 : string[1] - '0');
                 if (checksum == parity) {
                     *gpsPacketLogChar = LOG_IGNORED;
                     GPS_packetCount++;
@@ -737,11 +924,14 @@ static bool gpsNewFrameNMEA(char c)
                     case FRAME_GGA:
                       *gpsPacketLogChar = LOG_NMEA_GGA;
                       frameOK = 1;
-                      if (STATE(GPS_FIX)) {
+                      if (gps_Msg.fix) {
+                            ENABLE_STATE(GPS_FIX);
                             gpsSol.llh.lat = gps_Msg.latitude;
                             gpsSol.llh.lon = gps_Msg.longitude;
                             gpsSol.numSat = gps_Msg.numSat;
                             gpsSol.llh.alt = gps_Msg.altitude;
+                        } else {
+                            DISABLE_STATE(GPS_FIX);
                         }
                         break;
                     case FRAME_RMC:
@@ -757,10 +947,16 @@ static bool gpsNewFrameNMEA(char c)
             checksum_param = 0;
             break;
         default:
-            if (offset < 15)
-                string[offset++] = c;
-            if (!checksum_param)
-                parity ^= c;
+            if (checksum_param) {
+                checksum = (checksum << 4) | ((c >= 'A') ? c - 'A' + 10 : c - '0');
+                break;
+            }
+            parity ^= c;
+            if (param == 0) {
+                tag = (tag << 8) | (uint8_t)c;
+            } else if (gps_frame != NO_FRAME) {
+                nmeaFieldAddChar(&field, c);
+            }
     }
     return frameOK;
 }
@@ -826,6 +1022,41 @@ typedef struct {
     uint32_t heading_accuracy;
 } ubx_nav_velned;
 
+typedef struct {
+    uint32_t time;              // GPS msToW
+    uint16_t year;
+    uint8_t month;
+    uint8_t day;
+    uint8_t hour;
+    uint8_t min;
+    uint8_t sec;
+    uint8_t valid;
+    uint32_t time_accuracy;
+    int32_t time_nsec;
+    uint8_t fix_type;
+    uint8_t fix_status;
+    uint8_t fix_status2;
+    uint8_t satellites;
+    int32_t longitude;
+    int32_t latitude;
+    int32_t altitude_ellipsoid;
+    int32_t altitude_msl;
+    uint32_t horizontal_accuracy;
+    uint32_t vertical_accuracy;
+    int32_t ned_north;          // mm/s
+    int32_t ned_east;
+    int32_t ned_down;
+    int32_t speed_2d;           // mm/s
+    int32_t heading_2d;         // deg * 100000, heading of motion
+    uint32_t speed_accuracy;
+    uint32_t heading_accuracy;
+    uint16_t position_DOP;
+    uint8_t res[6];
+    int32_t heading_vehicle;
+    int16_t magnetic_declination;
+    uint16_t magnetic_declination_accuracy;
+} ubx_nav_pvt;
+
 typedef struct {
     uint8_t chn;                // Channel number, 255 for SVx not assigned to channel
     uint8_t svid;               // Satellite ID
@@ -856,6 +1087,7 @@ enum {
     MSG_POSLLH = 0x2,
     MSG_STATUS = 0x3,
     MSG_SOL = 0x6,
+    MSG_PVT = 0x7,
     MSG_VELNED = 0x12,
     MSG_SVINFO = 0x30,
     MSG_CFG_PRT = 0x00,
@@ -921,15 +1153,27 @@ static union {
     ubx_nav_solution solution;
     ubx_nav_velned velned;
     ubx_nav_svinfo svinfo;
+    ubx_nav_pvt pvt;
     uint8_t bytes[UBLOX_PAYLOAD_SIZE];
 } _buffer;
 
-void _update_checksum(uint8_t *data, uint8_t len, uint8_t *ck_a, uint8_t *ck_b)
+static void ubloxUpdateChecksum(const uint8_t *data, uint32_t length, uint8_t *ckA, uint8_t *ckB)
+{
+    uint8_t a = *ckA;
+    uint8_t b = *ckB;
+    while (length--) {
+        a += *data++;
+        b += a;
+    }
+    *ckA = a;
+    *ckB = b;
+}
+
+static void ubloxHandleAck(void)
 {
-    while (len--) {
-        *ck_a += *data;
-        *ck_b += *ck_a;
-        data++;
+    // only the navigation rate waits for an answer
+    if (_payload_length >= 2 && _buffer.bytes[0] == CLASS_CFG && _buffer.bytes[1] == MSG_CFG_RATE) {
+        ubloxAckState = (_msg_id == MSG_ACK_ACK) ? UBLOX_ACK_GOT_ACK : UBLOX_ACK_GOT_NACK;
     }
 }
 
@@ -940,6 +1184,19 @@ static bool UBLOX_parse_gps(void)
 
     *gpsPacketLogChar = LOG_IGNORED;
 
+    if (_class == CLASS_ACK) {
+        ubloxHandleAck();
+        return false;
+    }
+    if (_class != CLASS_NAV) {
+        return false;
+    }
+
+    // NAV-PVT replaces these, don't let a late one overwrite the newer solution
+    if (ubloxHavePvt && (_msg_id == MSG_POSLLH || _msg_id == MSG_STATUS || _msg_id == MSG_SOL || _msg_id == MSG_VELNED)) {
+        return false;
+    }
+
     switch (_msg_id) {
     case MSG_POSLLH:
         *gpsPacketLogChar = LOG_UBLOX_POSLLH;
@@ -975,6 +1232,26 @@ static bool UBLOX_parse_gps(void)
         gpsSol.groundCourse = (uint16_t) (_buffer.velned.heading_2d / 10000);     // Heading 2D deg * 100000 rescaled to deg * 10
         _new_speed = true;
         break;
+    case MSG_PVT:
+        *gpsPacketLogChar = LOG_UBLOX_PVT;
+        ubloxHavePvt = true;
+        next_fix = (_buffer.pvt.fix_status & NAV_STATUS_FIX_VALID) && (_buffer.pvt.fix_type == FIX_3D);
+        if (next_fix) {
+            ENABLE_STATE(GPS_FIX);
+        } else {
+            DISABLE_STATE(GPS_FIX);
+        }
+        gpsSol.llh.lon = _buffer.pvt.longitude;
+        gpsSol.llh.lat = _buffer.pvt.latitude;
+        gpsSol.llh.alt = _buffer.pvt.altitude_msl / 10 / 100;  //alt in m
+        gpsSol.numSat = _buffer.pvt.satellites;
+        gpsSol.hdop = _buffer.pvt.position_DOP;
+        gpsSol.groundSpeed = _buffer.pvt.speed_2d / 10;    // mm/s rescaled to cm/s
+        gpsSol.groundCourse = (uint16_t) (_buffer.pvt.heading_2d / 10000);     // Heading 2D deg * 100000 rescaled to deg * 10
+        // one message has it all
+        _new_position = true;
+        _new_speed = true;
+        break;
     case MSG_SVINFO:
         *gpsPacketLogChar = LOG_UBLOX_SVINFO;
         GPS_numCh = _buffer.svinfo.numCh;
@@ -1087,6 +1364,33 @@ static bool gpsNewFrameUBLOX(uint8_t data)
     return parsed;
 }
 
+// Takes the payload of a frame a span at a time and everything else byte by byte. Returns the number of bytes used,
+// stopping after a frame that completed a solution so that it is handled before the next frame is parsed.
+static uint32_t gpsNewFrameUBLOXBlock(const uint8_t *data, uint32_t length, bool *newFrame)
+{
+    uint32_t i = 0;
+
+    *newFrame = false;
+    while (i < length) {
+        if (_step == 6) {
+            const uint32_t span = MIN(length - i, (uint32_t)(_payload_length - _payload_counter));
+            ubloxUpdateChecksum(&data[i], span, &_ck_a, &_ck_b);
+            if (_payload_counter < UBLOX_PAYLOAD_SIZE) {
+                memcpy(&_buffer.bytes[_payload_counter], &data[i], MIN(span, (uint32_t)(UBLOX_PAYLOAD_SIZE - _payload_counter)));
+            }
+            _payload_counter += span;
+            i += span;
+            if (_payload_counter >= _payload_length) {
+                _step++;
+            }
+        } else if (gpsNewFrameUBLOX(data[i++])) {
+            *newFrame = true;
+            break;
+        }
+    }
+    return i;
+}
+
 static void gpsHandlePassthrough(uint8_t data)
  {
      gpsNewData(data);
@@ -135,6 +135,20 @@ STATIC_UNIT_TESTED int8_t lowestXValueForEast;
 
 STATIC_UNIT_TESTED ledCounts_t ledCounts;
 
+// LED indexes grouped by base function and by overlay, in strip order, rebuilt by reevaluateLedConfig().
+// The LEDs of function fn are ledFunctionLeds[ledFunctionStart[fn]] up to ledFunctionLeds[ledFunctionStart[fn + 1]],
+// the extra group at LED_BASEFUNCTION_COUNT holds LEDs with an unknown function.
+// Overlays work the same way, an LED appears once for each of its overlays.
+static uint8_t ledFunctionLeds[LED_MAX_STRIP_LENGTH];
+static uint8_t ledFunctionStart[LED_BASEFUNCTION_COUNT + 2];
+static uint8_t ledOverlayLeds[LED_OVERLAY_COUNT * LED_MAX_STRIP_LENGTH];
+static uint16_t ledOverlayStart[LED_OVERLAY_COUNT + 1];
+
+#define FOR_EACH_FUNCTION_LED(fn, ledIndex) \
+    for (int _i = ledFunctionStart[fn], ledIndex; _i < ledFunctionStart[(fn) + 1] && (ledIndex = ledFunctionLeds[_i], true); _i++)
+#define FOR_EACH_OVERLAY_LED(ol, ledIndex) \
+    for (int _i = ledOverlayStart[ol], ledIndex; _i < ledOverlayStart[(ol) + 1] && (ledIndex = ledOverlayLeds[_i], true); _i++)
+
 static const modeColorIndexes_t defaultModeColors[] = {
     //                          NORTH             EAST               SOUTH            WEST             UP          DOWN
     [LED_MODE_ORIENTATION] = {{ COLOR_WHITE,      COLOR_DARK_VIOLET, COLOR_RED,       COLOR_DEEP_PINK, COLOR_BLUE, COLOR_ORANGE }},
@@ -246,9 +260,55 @@ STATIC_UNIT_TESTED void updateLedCount(void)
     ledCounts.larson = countScanner;
 }
 
+static int ledFunctionGroup(const ledConfig_t *ledConfig)
+{
+    const int fn = ledGetFunction(ledConfig);
+    return fn < LED_BASEFUNCTION_COUNT ? fn : LED_BASEFUNCTION_COUNT;
+}
+
+static void updateLedLayerIndexes(void)
+{
+    // counting sort, which keeps the strip order within every group
+    memset(ledFunctionStart, 0, sizeof(ledFunctionStart));
+    memset(ledOverlayStart, 0, sizeof(ledOverlayStart));
+
+    for (int ledIndex = 0; ledIndex < ledCounts.count; ledIndex++) {
+        const ledConfig_t *ledConfig = &ledStripConfig()->ledConfigs[ledIndex];
+        ledFunctionStart[ledFunctionGroup(ledConfig) + 1]++;
+        for (int ol = 0; ol < LED_OVERLAY_COUNT; ol++) {
+            if (ledGetOverlayBit(ledConfig, ol)) {
+                ledOverlayStart[ol + 1]++;
+            }
+        }
+    }
+
+    for (int fn = 0; fn <= LED_BASEFUNCTION_COUNT; fn++) {
+        ledFunctionStart[fn + 1] += ledFunctionStart[fn];
+    }
+    for (int ol = 0; ol < LED_OVERLAY_COUNT; ol++) {
+        ledOverlayStart[ol + 1] += ledOverlayStart[ol];
+    }
+
+    uint8_t functionFill[LED_BASEFUNCTION_COUNT + 1];
+    uint16_t overlayFill[LED_OVERLAY_COUNT];
+    memcpy(functionFill, ledFunctionStart, sizeof(functionFill));
+    memcpy(overlayFill, ledOverlayStart, sizeof(overlayFill));
+
+    for (int ledIndex = 0; ledIndex < ledCounts.count; ledIndex++) {
+        const ledConfig_t *ledConfig = &ledStripConfig()->ledConfigs[ledIndex];
+        ledFunctionLeds[functionFill[ledFunctionGroup(ledConfig)]++] = ledIndex;
+        for (int ol = 0; ol < LED_OVERLAY_COUNT; ol++) {
+            if (ledGetOverlayBit(ledConfig, ol)) {
+                ledOverlayLeds[overlayFill[ol]++] = ledIndex;
+            }
+        }
+    }
+}
+
 void reevaluateLedConfig(void)
 {
     updateLedCount();
+    updateLedLayerIndexes();
     updateDimensions();
     updateLedRingCounts();
 }
@@ -265,7 +325,8 @@ static const char overlayCodes[LED_OVERLAY_COUNT]   = { 'T', 'O', 'B', 'V', 'I',
 
 #define CHUNK_BUFFER_SIZE 11
 
-bool parseLedStripConfig(int ledIndex, const char *config)
+// Leaves the counts and the layers derived from the strip alone, for a run of leds followed by one reevaluateLedConfig()
+bool parseLedStripConfigNoUpdate(int ledIndex, const char *config)
 {
     if (ledIndex >= LED_MAX_STRIP_LENGTH)
         return false;
@@ -347,6 +408,15 @@ bool parseLedStripConfig(int ledIndex, const char *config)
 
     *ledConfig = DEFINE_LED(x, y, color, direction_flags, baseFunction, overlay_flags, 0);
 
+    return true;
+}
+
+bool parseLedStripConfig(int ledIndex, const char *config)
+{
+    if (!parseLedStripConfigNoUpdate(ledIndex, config)) {
+        return false;
+    }
+
     reevaluateLedConfig();
 
     return true;
@@ -443,45 +513,29 @@ static const struct {
 
 static void applyLedFixedLayers()
 {
-    for (int ledIndex = 0; ledIndex < ledCounts.count; ledIndex++) {
-        const ledConfig_t *ledConfig = &ledStripConfig()->ledConfigs[ledIndex];
-        hsvColor_t color = *getSC(LED_SCOLOR_BACKGROUND);
-        hsvColor_t nextColor = *getSC(LED_SCOLOR_BACKGROUND); //next color above the one selected, or color 0 if your are at the maximum
-        hsvColor_t previousColor = *getSC(LED_SCOLOR_BACKGROUND); //Previous color to the one selected, modulo color count
+    const hsvColor_t background = *getSC(LED_SCOLOR_BACKGROUND);
+
+    for (int fn = 0; fn <= LED_BASEFUNCTION_COUNT; fn++) {
+        if (ledFunctionStart[fn] == ledFunctionStart[fn + 1]) {
+            continue;
+        }
 
-        int fn = ledGetFunction(ledConfig);
+        // the parts of the colour shared by all LEDs of this function
+        hsvColor_t functionColor = background;
         int hOffset = HSV_HUE_MAX;
 
         switch (fn) {
-        case LED_FUNCTION_COLOR:
-            color = ledStripConfig()->colors[ledGetColor(ledConfig)];
-            nextColor = ledStripConfig()->colors[(ledGetColor(ledConfig) + 1 + LED_CONFIGURABLE_COLOR_COUNT) % LED_CONFIGURABLE_COLOR_COUNT];
-            previousColor = ledStripConfig()->colors[(ledGetColor(ledConfig) - 1 + LED_CONFIGURABLE_COLOR_COUNT) % LED_CONFIGURABLE_COLOR_COUNT];
-            break;
-
-        case LED_FUNCTION_FLIGHT_MODE:
-            for (unsigned i = 0; i < ARRAYLEN(flightModeToLed); i++)
-                if (!flightModeToLed[i].flightMode || FLIGHT_MODE(flightModeToLed[i].flightMode)) {
-                    const hsvColor_t *directionalColor = getDirectionalModeColor(ledIndex, &ledStripConfig()->modeColors[flightModeToLed[i].ledMode]);
-                    if (directionalColor) {
-                        color = *directionalColor;
-                    }
-
-                    break; // stop on first match
-                }
-            break;
-
         case LED_FUNCTION_ARM_STATE:
-            color = ARMING_FLAG(ARMED) ? *getSC(LED_SCOLOR_ARMED) : *getSC(LED_SCOLOR_DISARMED);
+            functionColor = ARMING_FLAG(ARMED) ? *getSC(LED_SCOLOR_ARMED) : *getSC(LED_SCOLOR_DISARMED);
             break;
 
         case LED_FUNCTION_BATTERY:
-            color = HSV(RED);
+            functionColor = HSV(RED);
             hOffset += scaleRange(calculateBatteryPercentageRemaining(), 0, 100, -30, 120);
             break;
 
         case LED_FUNCTION_RSSI:
-            color = HSV(RED);
+            functionColor = HSV(RED);
             hOffset += scaleRange(rssi * 100, 0, 1023, -30, 120);
             break;
 
@@ -489,33 +543,57 @@ static void applyLedFixedLayers()
             break;
         }
 
-        if (ledGetOverlayBit(ledConfig, LED_OVERLAY_THROTTLE))   //smooth fade with selected Aux channel of all HSV values from previousColor through color to nextColor
-    {
-        int centerPWM = (PWM_RANGE_MIN + PWM_RANGE_MAX) / 2;
-            if (auxInput < centerPWM)
-                {
+        FOR_EACH_FUNCTION_LED(fn, ledIndex) {
+            const ledConfig_t *ledConfig = &ledStripConfig()->ledConfigs[ledIndex];
+            hsvColor_t color = functionColor;
+            hsvColor_t nextColor = background; //next color above the one selected, or color 0 if your are at the maximum
+            hsvColor_t previousColor = background; //Previous color to the one selected, modulo color count
+
+            if (fn == LED_FUNCTION_COLOR) {
+                color = ledStripConfig()->colors[ledGetColor(ledConfig)];
+                nextColor = ledStripConfig()->colors[(ledGetColor(ledConfig) + 1 + LED_CONFIGURABLE_COLOR_COUNT) % LED_CONFIGURABLE_COLOR_COUNT];
+                previousColor = ledStripConfig()->colors[(ledGetColor(ledConfig) - 1 + LED_CONFIGURABLE_COLOR_COUNT) % LED_CONFIGURABLE_COLOR_COUNT];
+            } else if (fn == LED_FUNCTION_FLIGHT_MODE) {
+                for (unsigned i = 0; i < ARRAYLEN(flightModeToLed); i++)
+                    if (!flightModeToLed[i].flightMode || FLIGHT_MODE(flightModeToLed[i].flightMode)) {
+                        const hsvColor_t *directionalColor = getDirectionalModeColor(ledIndex, &ledStripConfig()->modeColors[flightModeToLed[i].ledMode]);
+                        if (directionalColor) {
+                            color = *directionalColor;
+                        }
+
+                        break; // stop on first match
+                    }
+            }
+
+            if (ledGetOverlayBit(ledConfig, LED_OVERLAY_THROTTLE)) {  //smooth fade with selected Aux channel of all HSV values from previousColor through color to nextColor
+                int centerPWM = (PWM_RANGE_MIN + PWM_RANGE_MAX) / 2;
+                if (auxInput < centerPWM) {
                     color.h = scaleRange(auxInput, PWM_RANGE_MIN, centerPWM, previousColor.h, color.h);
                     color.s = scaleRange(auxInput, PWM_RANGE_MIN, centerPWM, previousColor.s, color.s);
                     color.v = scaleRange(auxInput, PWM_RANGE_MIN, centerPWM, previousColor.v, color.v);
-                }
-            else
-                {
+                } else {
                     color.h = scaleRange(auxInput, centerPWM, PWM_RANGE_MAX, color.h, nextColor.h);
                     color.s = scaleRange(auxInput, centerPWM, PWM_RANGE_MAX, color.s, nextColor.s);
                     color.v = scaleRange(auxInput, centerPWM, PWM_RANGE_MAX, color.v, nextColor.v);
                 }
-       }
-        color.h = (color.h + hOffset) % (HSV_HUE_MAX + 1);
-        setLedHsv(ledIndex, &color);
+            }
+            color.h = (color.h + hOffset) % (HSV_HUE_MAX + 1);
+            setLedHsv(ledIndex, &color);
+        }
     }
 }
 
-static void applyLedHsv(uint32_t mask, const hsvColor_t *color)
+static void applyFunctionHsv(ledBaseFunctionId_e fn, const hsvColor_t *color)
 {
-    for (int ledIndex = 0; ledIndex < ledCounts.count; ledIndex++) {
-        const ledConfig_t *ledConfig = &ledStripConfig()->ledConfigs[ledIndex];
-        if ((*ledConfig & mask) == mask)
-            setLedHsv(ledIndex, color);
+    FOR_EACH_FUNCTION_LED(fn, ledIndex) {
+        setLedHsv(ledIndex, color);
+    }
+}
+
+static void applyOverlayHsv(ledOverlayId_e ol, const hsvColor_t *color)
+{
+    FOR_EACH_OVERLAY_LED(ol, ledIndex) {
+        setLedHsv(ledIndex, color);
     }
 }
 
@@ -573,7 +651,7 @@ static void applyLedWarningLayer(bool updateNow, timeUs_t *timer)
     }
 
     if (warningColor) {
-        applyLedHsv(LED_MOV_OVERLAY(LED_FLAG_OVERLAY(LED_OVERLAY_WARNING)), warningColor);
+        applyOverlayHsv(LED_OVERLAY_WARNING, warningColor);
     }
 }
 
@@ -620,27 +698,27 @@ static void applyLedVtxLayer(bool updateNow, timeUs_t *timer)
     hsvColor_t color = {0, 0, 0};
     if (showSettings) { // show settings
         uint8_t vtxLedCount = 0;
-        for (int i = 0; i < ledCounts.count && vtxLedCount < 6; ++i) {
-            const ledConfig_t *ledConfig = &ledStripConfig()->ledConfigs[i];
-            if (ledGetOverlayBit(ledConfig, LED_OVERLAY_VTX)) {
-                if (vtxLedCount == 0) {
-                    color.h = HSV(GREEN).h;
-                    color.s = HSV(GREEN).s;
-                    color.v = blink ? 15 : 0; // blink received settings
-                }
-                else if (vtxLedCount > 0 && power >= vtxLedCount && !pit) { // show power
-                    color.h = HSV(ORANGE).h;
-                    color.s = HSV(ORANGE).s;
-                    color.v = blink ? 15 : 0; // blink received settings
-                }
-                else { // turn rest off
-                    color.h = HSV(BLACK).h;
-                    color.s = HSV(BLACK).s;
-                    color.v = HSV(BLACK).v;
-                }
-                setLedHsv(i, &color);
-                ++vtxLedCount;
+        FOR_EACH_OVERLAY_LED(LED_OVERLAY_VTX, i) {
+            if (vtxLedCount >= 6) {
+                break;
+            }
+            if (vtxLedCount == 0) {
+                color.h = HSV(GREEN).h;
+                color.s = HSV(GREEN).s;
+                color.v = blink ? 15 : 0; // blink received settings
+            }
+            else if (vtxLedCount > 0 && power >= vtxLedCount && !pit) { // show power
+                color.h = HSV(ORANGE).h;
+                color.s = HSV(ORANGE).s;
+                color.v = blink ? 15 : 0; // blink received settings
             }
+            else { // turn rest off
+                color.h = HSV(BLACK).h;
+                color.s = HSV(BLACK).s;
+                color.v = HSV(BLACK).v;
+            }
+            setLedHsv(i, &color);
+            ++vtxLedCount;
         }
     }
     else { // show frequency
@@ -651,7 +729,7 @@ static void applyLedVtxLayer(bool updateNow, timeUs_t *timer)
         color.h = hue;
         color.s = 0;
         color.v = pit ? (blink ? 15 : 0) : 255; // blink when in pit mode`
-        applyLedHsv(LED_MOV_OVERLAY(LED_FLAG_OVERLAY(LED_OVERLAY_VTX)), &color);
+        applyOverlayHsv(LED_OVERLAY_VTX, &color);
     }
 }
 #endif
@@ -687,7 +765,7 @@ static void applyLedBatteryLayer(bool updateNow, timeUs_t *timer)
 
     if (!flash) {
        const hsvColor_t *bgc = getSC(LED_SCOLOR_BACKGROUND);
-       applyLedHsv(LED_MOV_FUNCTION(LED_FUNCTION_BATTERY), bgc);
+       applyFunctionHsv(LED_FUNCTION_BATTERY, bgc);
     }
 }
 
@@ -716,7 +794,7 @@ static void applyLedRssiLayer(bool updateNow, timeUs_t *timer)
 
     if (!flash) {
         const hsvColor_t *bgc = getSC(LED_SCOLOR_BACKGROUND);
-        applyLedHsv(LED_MOV_FUNCTION(LED_FUNCTION_RSSI), bgc);
+        applyFunctionHsv(LED_FUNCTION_RSSI, bgc);
     }
 }
 
@@ -754,7 +832,7 @@ static void applyLedGpsLayer(bool updateNow, timeUs_t *timer)
         }
     }
 
-    applyLedHsv(LED_MOV_FUNCTION(LED_FUNCTION_GPS), gpsColor);
+    applyFunctionHsv(LED_FUNCTION_GPS, gpsColor);
 }
 
 #endif
@@ -795,12 +873,9 @@ static void applyLedIndicatorLayer(bool updateNow, timeUs_t *timer)
         quadrants |= QUADRANT_SOUTH;
     }
 
-    for (int ledIndex = 0; ledIndex < ledCounts.count; ledIndex++) {
-        const ledConfig_t *ledConfig = &ledStripConfig()->ledConfigs[ledIndex];
-        if (ledGetOverlayBit(ledConfig, LED_OVERLAY_INDICATOR)) {
-            if (getLedQuadrant(ledIndex) & quadrants)
-                setLedHsv(ledIndex, flashColor);
-        }
+    FOR_EACH_OVERLAY_LED(LED_OVERLAY_INDICATOR, ledIndex) {
+        if (getLedQuadrant(ledIndex) & quadrants)
+            setLedHsv(ledIndex, flashColor);
     }
 }
 
@@ -835,24 +910,22 @@ static void applyLedThrustRingLayer(bool updateNow, timeUs_t *timer)
         *timer += HZ_TO_US(5 + (45 * scaledThrottle) / 100);  // 5 - 50Hz update rate
     }
 
-    for (int ledIndex = 0; ledIndex < ledCounts.count; ledIndex++) {
+    FOR_EACH_FUNCTION_LED(LED_FUNCTION_THRUST_RING, ledIndex) {
         const ledConfig_t *ledConfig = &ledStripConfig()->ledConfigs[ledIndex];
-        if (ledGetFunction(ledConfig) == LED_FUNCTION_THRUST_RING) {
-
-            bool applyColor;
-            if (ARMING_FLAG(ARMED)) {
-                applyColor = (ledRingIndex + rotationPhase) % ledCounts.ringSeqLen < ROTATION_SEQUENCE_LED_WIDTH;
-            } else {
-                applyColor = !(ledRingIndex % 2); // alternating pattern
-            }
 
-            if (applyColor) {
-                const hsvColor_t *ringColor = &ledStripConfig()->colors[ledGetColor(ledConfig)];
-                setLedHsv(ledIndex, ringColor);
-            }
+        bool applyColor;
+        if (ARMING_FLAG(ARMED)) {
+            applyColor = (ledRingIndex + rotationPhase) % ledCounts.ringSeqLen < ROTATION_SEQUENCE_LED_WIDTH;
+        } else {
+            applyColor = !(ledRingIndex % 2); // alternating pattern
+        }
 
-            ledRingIndex++;
+        if (applyColor) {
+            const hsvColor_t *ringColor = &ledStripConfig()->colors[ledGetColor(ledConfig)];
+            setLedHsv(ledIndex, ringColor);
         }
+
+        ledRingIndex++;
     }
 }
 
@@ -904,17 +977,12 @@ static void applyLarsonScannerLayer(bool updateNow, timeUs_t *timer)
     }
 
     int scannerLedIndex = 0;
-    for (unsigned i = 0; i < ledCounts.count; i++) {
-
-        const ledConfig_t *ledConfig = &ledStripConfig()->ledConfigs[i];
-
-        if (ledGetOverlayBit(ledConfig, LED_OVERLAY_LARSON_SCANNER)) {
-            hsvColor_t ledColor;
-            getLedHsv(i, &ledColor);
-            ledColor.v = brightnessForLarsonIndex(&larsonParameters, scannerLedIndex);
-            setLedHsv(i, &ledColor);
-            scannerLedIndex++;
-        }
+    FOR_EACH_OVERLAY_LED(LED_OVERLAY_LARSON_SCANNER, i) {
+        hsvColor_t ledColor;
+        getLedHsv(i, &ledColor);
+        ledColor.v = brightnessForLarsonIndex(&larsonParameters, scannerLedIndex);
+        setLedHsv(i, &ledColor);
+        scannerLedIndex++;
     }
 }
 
@@ -934,13 +1002,7 @@ static void applyLedBlinkLayer(bool updateNow, timeUs_t *timer)
 
     bool ledOn = (blinkMask & 1);  // b_b_____...
     if (!ledOn) {
-        for (int i = 0; i < ledCounts.count; ++i) {
-            const ledConfig_t *ledConfig = &ledStripConfig()->ledConfigs[i];
-
-            if (ledGetOverlayBit(ledConfig, LED_OVERLAY_BLINK)) {
-                setLedHsv(i, getSC(LED_SCOLOR_BLINKBACKGROUND));
-            }
-        }
+        applyOverlayHsv(LED_OVERLAY_BLINK, getSC(LED_SCOLOR_BLINKBACKGROUND));
     }
 }
 
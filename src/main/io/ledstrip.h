@@ -22,7 +22,9 @@
 #include "config/parameter_group.h"
 #include "drivers/io_types.h"
 
+#ifndef LED_MAX_STRIP_LENGTH
 #define LED_MAX_STRIP_LENGTH           32
+#endif
 #define LED_CONFIGURABLE_COLOR_COUNT   16
 #define LED_MODE_COUNT                  6
 #define LED_DIRECTION_COUNT             6
@@ -179,6 +181,7 @@ PG_DECLARE(specialColorIndexes_t, specialColors);
 bool parseColor(int index, const char *colorConfig);
 
 bool parseLedStripConfig(int ledIndex, const char *config);
+bool parseLedStripConfigNoUpdate(int ledIndex, const char *config);
 void generateLedConfig(ledConfig_t *ledConfig, char *ledConfigBuffer, size_t bufferSize);
 void reevaluateLedConfig(void);
 
@@ -72,11 +72,15 @@
 #include "fc/runtime_config.h"
 
 #include "flight/altitude.h"
+#include "flight/failsafe.h"
 #include "flight/navigation.h"
 #include "flight/pid.h"
 #include "flight/imu.h"
 
 #include "rx/rx.h"
+#include "rx/rx_link_quality.h"
+
+#include "scheduler/scheduler.h"
 
 #include "sensors/barometer.h"
 #include "sensors/battery.h"
@@ -89,6 +93,10 @@
 
 #define VIDEO_BUFFER_CHARS_PAL    480
 
+// Time after a vertical sync during which the screen can be updated without tearing,
+// vertical blanking lasts about 20 lines on NTSC and 25 on PAL, at 64us each
+#define OSD_VBLANK_US             1000
+
 const char * const osdTimerSourceNames[] = {
     "ON TIME  ",
     "TOTAL ARM",
@@ -106,6 +114,26 @@ static uint32_t blinkBits[(OSD_ITEM_COUNT + 31)/32];
 #define IS_BLINK(item) (blinkBits[(item) / 32] & (1 << ((item) % 32)))
 #define BLINK(item) (IS_BLINK(item) && blinkState)
 
+// Dirty region tracking
+
+// What a text element last put on the screen, so a refresh only rewrites the elements whose text changed
+typedef struct osdElementCache_s {
+    uint8_t posX;
+    uint8_t posY;
+    uint8_t length;     // cells covered, 0 while the element is not on the screen
+    char text[OSD_ELEMENT_BUFFER_LENGTH];
+} osdElementCache_t;
+
+static osdElementCache_t osdElementCache[OSD_ITEM_COUNT];
+
+#define AH_BAR_COUNT 9
+// Position and symbol of each artificial horizon bar character, symbol 0 when the column is empty
+static uint8_t osdHorizonBarY[AH_BAR_COUNT];
+static uint8_t osdHorizonBarSymbol[AH_BAR_COUNT];
+
+static bool osdRedrawAll = true;    // something other than the elements has drawn on the screen
+static bool osdHidden = false;
+
 // Things in both OSD and CMS
 
 #define IS_HI(X)  (rcData[X] > 1750)
@@ -208,7 +236,24 @@ static int32_t osdGetMetersToSelectedUnit(int32_t meters)
 
 static void osdFormatPID(char * buff, const char * label, const pid8_t * pid)
 {
-    tfp_sprintf(buff, "%s %3d %3d %3d", label, pid->P, pid->I, pid->D);
+    const uint8_t gains[] = { pid->P, pid->I, pid->D };
+    const size_t labelLength = strlen(label);
+
+    memcpy(buff, label, labelLength);
+    buff += labelLength;
+    for (unsigned i = 0; i < ARRAYLEN(gains); i++) {
+        *buff++ = ' ';
+        buff = fmtUint(buff, gains[i], 3, ' ');
+    }
+}
+
+// One decimal of a value in hundredths, the sign in front as the altitude has always been shown
+static void osdFormatSignedTenths(char *buff, int32_t hundredths, char symbol)
+{
+    buff[0] = hundredths < 0 ? '-' : ' ';
+    char *p = fmtFixed(buff + 1, abs(hundredths) / 10, 1, 0);
+    *p++ = symbol;
+    *p = '\0';
 }
 
 static uint8_t osdGetHeadingIntoDiscreteDirections(int heading, int directions)
@@ -265,15 +310,19 @@ STATIC_UNIT_TESTED void osdFormatTime(char * buff, osd_timer_precision_e precisi
     const int minutes = seconds / 60;
     seconds = seconds % 60;
 
+    buff = fmtInt(buff, minutes, 2, '0');
+    *buff++ = ':';
+    buff = fmtInt(buff, seconds, 2, '0');
+
     switch (precision) {
     case OSD_TIMER_PREC_SECOND:
     default:
-        tfp_sprintf(buff, "%02d:%02d", minutes, seconds);
         break;
     case OSD_TIMER_PREC_HUNDREDTHS:
         {
             const int hundredths = (time / 10000) % 100;
-            tfp_sprintf(buff, "%02d:%02d.%02d", minutes, seconds, hundredths);
+            *buff++ = '.';
+            fmtInt(buff, hundredths, 2, '0');
             break;
         }
     }
@@ -291,9 +340,91 @@ STATIC_UNIT_TESTED void osdFormatTimer(char *buff, bool showSymbol, int timerInd
     osdFormatTime(buff, OSD_TIMER_PRECISION(timer), osdGetTimerValue(src));
 }
 
+static void osdClearScreen(void)
+{
+    displayClearScreen(osdDisplayPort);
+
+    memset(osdElementCache, 0, sizeof(osdElementCache));
+    memset(osdHorizonBarSymbol, 0, sizeof(osdHorizonBarSymbol));
+}
+
+static void osdWriteHorizonSidebars(uint8_t x, uint8_t y, bool clear)
+{
+    const int8_t hudwidth = AH_SIDEBAR_WIDTH_POS;
+    const int8_t hudheight = AH_SIDEBAR_HEIGHT_POS;
+
+    // Draw AH sides
+    for (int i = -hudheight; i <= hudheight; i++) {
+        displayWriteChar(osdDisplayPort, x - hudwidth, y + i, clear ? ' ' : SYM_AH_DECORATION);
+        displayWriteChar(osdDisplayPort, x + hudwidth, y + i, clear ? ' ' : SYM_AH_DECORATION);
+    }
+
+    // AH level indicators
+    displayWriteChar(osdDisplayPort, x - hudwidth + 1, y, clear ? ' ' : SYM_AH_LEFT);
+    displayWriteChar(osdDisplayPort, x + hudwidth - 1, y, clear ? ' ' : SYM_AH_RIGHT);
+}
+
+static void osdClearElement(uint8_t item)
+{
+    osdElementCache_t *cache = &osdElementCache[item];
+
+    switch (item) {
+    case OSD_ARTIFICIAL_HORIZON:
+        for (int i = 0; i < AH_BAR_COUNT; i++) {
+            if (osdHorizonBarSymbol[i]) {
+                displayWriteChar(osdDisplayPort, cache->posX + i, osdHorizonBarY[i], ' ');
+                osdHorizonBarSymbol[i] = 0;
+            }
+        }
+        osdClearElement(OSD_HORIZON_SIDEBARS);
+        break;
+
+    case OSD_HORIZON_SIDEBARS:
+        if (cache->length) {
+            osdWriteHorizonSidebars(cache->posX, cache->posY, true);
+        }
+        break;
+
+    default:
+        for (int i = 0; i < cache->length; i++) {
+            displayWriteChar(osdDisplayPort, cache->posX + i, cache->posY, ' ');
+        }
+        break;
+    }
+
+    cache->length = 0;
+    cache->text[0] = 0;
+}
+
+// Writes the text of an element, touching the screen only when it differs from what the element shows already
+static void osdWriteElement(uint8_t item, uint8_t x, uint8_t y, const char *text)
+{
+    osdElementCache_t *cache = &osdElementCache[item];
+    const uint8_t length = strlen(text);
+
+    if (x != cache->posX || y != cache->posY) {
+        osdClearElement(item);
+    } else if (length == cache->length && strcmp(text, cache->text) == 0) {
+        return;
+    } else {
+        // blank the cells the new text no longer covers
+        for (int i = length; i < cache->length; i++) {
+            displayWriteChar(osdDisplayPort, x + i, y, ' ');
+        }
+    }
+
+    displayWrite(osdDisplayPort, x, y, text);
+
+    cache->posX = x;
+    cache->posY = y;
+    cache->length = length;
+    strcpy(cache->text, text);
+}
+
 static void osdDrawSingleElement(uint8_t item)
 {
     if (!VISIBLE(osdConfig()->item_pos[item]) || BLINK(item)) {
+        osdClearElement(item);
         return;
     }
 
@@ -310,38 +441,46 @@ static void osdDrawSingleElement(uint8_t item)
                 osdRssi = 99;
 
             buff[0] = SYM_RSSI;
-            tfp_sprintf(buff + 1, "%d", osdRssi);
+            fmtUint(buff + 1, osdRssi, 0, ' ');
             break;
         }
 
     case OSD_MAIN_BATT_VOLTAGE:
-        buff[0] = osdGetBatterySymbol(osdGetBatteryAverageCellVoltage());
-        tfp_sprintf(buff + 1, "%d.%1d%c", getBatteryVoltage() / 10, getBatteryVoltage() % 10, SYM_VOLT);
-        break;
+        {
+            buff[0] = osdGetBatterySymbol(osdGetBatteryAverageCellVoltage());
+            char *p = fmtFixed(buff + 1, getBatteryVoltage(), 1, 0);
+            *p++ = SYM_VOLT;
+            *p = '\0';
+            break;
+        }
 
     case OSD_CURRENT_DRAW:
         {
             const int32_t amperage = getAmperage();
             buff[0] = SYM_AMP;
-            tfp_sprintf(buff + 1, "%d.%02d", abs(amperage) / 100, abs(amperage) % 100);
+            fmtFixed(buff + 1, abs(amperage), 2, 0);
             break;
         }
 
     case OSD_MAH_DRAWN:
         buff[0] = SYM_MAH;
-        tfp_sprintf(buff + 1, "%d", getMAhDrawn());
+        fmtInt(buff + 1, getMAhDrawn(), 0, ' ');
         break;
 
 #ifdef GPS
     case OSD_GPS_SATS:
         buff[0] = 0x1f;
-        tfp_sprintf(buff + 1, "%d", gpsSol.numSat);
+        fmtUint(buff + 1, gpsSol.numSat, 0, ' ');
         break;
 
     case OSD_GPS_SPEED:
         // FIXME ideally we want to use SYM_KMH symbol but it's not in the font any more, so we use K.
-        tfp_sprintf(buff, "%3dK", CM_S_TO_KM_H(gpsSol.groundSpeed));
-        break;
+        {
+            char *p = fmtInt(buff, CM_S_TO_KM_H(gpsSol.groundSpeed), 3, ' ');
+            *p++ = 'K';
+            *p = '\0';
+            break;
+        }
 
     case OSD_GPS_LAT:
     case OSD_GPS_LON:
@@ -411,7 +550,7 @@ static void osdDrawSingleElement(uint8_t item)
     case OSD_ALTITUDE:
         {
             const int32_t alt = osdGetMetersToSelectedUnit(getEstimatedAltitude());
-            tfp_sprintf(buff, "%c%d.%01d%c", alt < 0 ? '-' : ' ', abs(alt / 100), abs((alt % 100) / 10), osdGetMetersToSelectedUnitSymbol());
+            osdFormatSignedTenths(buff, alt, osdGetMetersToSelectedUnitSymbol());
             break;
         }
 
@@ -437,7 +576,7 @@ static void osdDrawSingleElement(uint8_t item)
             else if (FLIGHT_MODE(HORIZON_MODE))
                 p = "HOR";
 
-            displayWrite(osdDisplayPort, elemPosX, elemPosY, p);
+            osdWriteElement(item, elemPosX, elemPosY, p);
             return;
         }
 
@@ -456,7 +595,7 @@ static void osdDrawSingleElement(uint8_t item)
     case OSD_THROTTLE_POS:
         buff[0] = SYM_THR;
         buff[1] = SYM_THR1;
-        tfp_sprintf(buff + 2, "%d", (constrain(rcData[THROTTLE], PWM_RANGE_MIN, PWM_RANGE_MAX) - PWM_RANGE_MIN) * 100 / (PWM_RANGE_MAX - PWM_RANGE_MIN));
+        fmtInt(buff + 2, (constrain(rcData[THROTTLE], PWM_RANGE_MIN, PWM_RANGE_MAX) - PWM_RANGE_MIN) * 100 / (PWM_RANGE_MAX - PWM_RANGE_MIN), 0, ' ');
         break;
 
 #if defined(VTX_COMMON)
@@ -502,13 +641,39 @@ static void osdDrawSingleElement(uint8_t item)
             // Convert pitchAngle to y compensation value
             pitchAngle = (pitchAngle / 8) - 41; // 41 = 4 * 9 + 5
 
+            osdElementCache_t *cache = &osdElementCache[item];
+            cache->posX = elemPosX - 4;
+
+            bool changed = false;
             for (int x = -4; x <= 4; x++) {
+                const int i = x + 4;
                 int y = (-rollAngle * x) / 64;
                 y -= pitchAngle;
                 // y += 41; // == 4 * 9 + 5
+                uint8_t symbol = 0;
+                uint8_t barY = 0;
                 if (y >= 0 && y <= 81) {
-                    displayWriteChar(osdDisplayPort, elemPosX + x, elemPosY + (y / 9), (SYM_AH_BAR9_0 + (y % 9)));
+                    symbol = SYM_AH_BAR9_0 + (y % 9);
+                    barY = elemPosY + (y / 9);
+                }
+                if (symbol == osdHorizonBarSymbol[i] && (!symbol || barY == osdHorizonBarY[i])) {
+                    continue;
+                }
+                if (osdHorizonBarSymbol[i] && (!symbol || barY != osdHorizonBarY[i])) {
+                    displayWriteChar(osdDisplayPort, elemPosX + x, osdHorizonBarY[i], ' ');
+                }
+                if (symbol) {
+                    displayWriteChar(osdDisplayPort, elemPosX + x, barY, symbol);
                 }
+                osdHorizonBarSymbol[i] = symbol;
+                osdHorizonBarY[i] = barY;
+                changed = true;
+            }
+
+            if (changed) {
+                // the bars may have covered or uncovered the crosshairs, which are drawn after the horizon
+                osdElementCache[OSD_CROSSHAIRS].length = 0;
+                osdElementCache[OSD_CROSSHAIRS].text[0] = 0;
             }
 
             osdDrawSingleElement(OSD_HORIZON_SIDEBARS);
@@ -525,18 +690,16 @@ static void osdDrawSingleElement(uint8_t item)
                 ++elemPosY;
             }
 
-            // Draw AH sides
-            const int8_t hudwidth = AH_SIDEBAR_WIDTH_POS;
-            const int8_t hudheight = AH_SIDEBAR_HEIGHT_POS;
-            for (int y = -hudheight; y <= hudheight; y++) {
-                displayWriteChar(osdDisplayPort, elemPosX - hudwidth, elemPosY + y, SYM_AH_DECORATION);
-                displayWriteChar(osdDisplayPort, elemPosX + hudwidth, elemPosY + y, SYM_AH_DECORATION);
+            // The sidebars never move, so they are drawn once
+            osdElementCache_t *cache = &osdElementCache[item];
+            if (!cache->length || cache->posX != elemPosX || cache->posY != elemPosY) {
+                osdClearElement(item);
+                osdWriteHorizonSidebars(elemPosX, elemPosY, false);
+                cache->posX = elemPosX;
+                cache->posY = elemPosY;
+                cache->length = 1;
             }
 
-            // AH level indicators
-            displayWriteChar(osdDisplayPort, elemPosX - hudwidth + 1, elemPosY, SYM_AH_LEFT);
-            displayWriteChar(osdDisplayPort, elemPosX + hudwidth - 1, elemPosY, SYM_AH_RIGHT);
-
             return;
         }
 
@@ -562,8 +725,12 @@ static void osdDrawSingleElement(uint8_t item)
         }
 
     case OSD_POWER:
-        tfp_sprintf(buff, "%dW", getAmperage() * getBatteryVoltage() / 1000);
-        break;
+        {
+            char *p = fmtInt(buff, getAmperage() * getBatteryVoltage() / 1000, 0, ' ');
+            *p++ = 'W';
+            *p = '\0';
+            break;
+        }
 
     case OSD_PIDRATE_PROFILE:
         {
@@ -586,6 +753,12 @@ static void osdDrawSingleElement(uint8_t item)
             break;
         }
 
+        /* Show link quality warning, the link is still up but a failsafe may follow */
+        if (failsafeIsLinkDegraded()) {
+            tfp_sprintf(buff, "  LOW LQ");
+            break;
+        }
+
         /* Show battery state warning */
         switch (getBatteryState()) {
         case BATTERY_WARNING:
@@ -601,7 +774,7 @@ static void osdDrawSingleElement(uint8_t item)
             if (showVisualBeeper) {
                 tfp_sprintf(buff, "  * * * *");
             } else {
-                return;
+                buff[0] = 0;
             }
             break;
 
@@ -612,19 +785,34 @@ static void osdDrawSingleElement(uint8_t item)
         {
             const int cellV = osdGetBatteryAverageCellVoltage();
             buff[0] = osdGetBatterySymbol(cellV);
-            tfp_sprintf(buff + 1, "%d.%02d%c", cellV / 100, cellV % 100, SYM_VOLT);
+            char *p = fmtFixed(buff + 1, cellV, 2, 0);
+            *p++ = SYM_VOLT;
+            *p = '\0';
             break;
         }
 
     case OSD_DEBUG:
-        tfp_sprintf(buff, "DBG %5d %5d %5d %5d", debug[0], debug[1], debug[2], debug[3]);
-        break;
+        {
+            // the values are 32 bit, clipped so the four always fit the row
+            char *p = buff;
+            memcpy(p, "DBG", 3);
+            p += 3;
+            for (int i = 0; i < DEBUG_MODE_VALUE_COUNT; i++) {
+                *p++ = ' ';
+                p = fmtInt(p, constrain(debug[i], -9999, 99999), 5, ' ');
+            }
+            break;
+        }
 
     case OSD_PITCH_ANGLE:
     case OSD_ROLL_ANGLE:
         {
             const int angle = (item == OSD_PITCH_ANGLE) ? attitude.values.pitch : attitude.values.roll;
-            tfp_sprintf(buff, "%c%02d.%01d", angle < 0 ? '-' : ' ', abs(angle / 10), abs(angle % 10));
+            buff[0] = angle < 0 ? '-' : ' ';
+            char *p = fmtUint(buff + 1, abs(angle) / 10, 2, '0');
+            *p++ = '.';
+            *p++ = '0' + abs(angle) % 10;
+            *p = '\0';
             break;
         }
 
@@ -661,15 +849,16 @@ static void osdDrawSingleElement(uint8_t item)
     case OSD_DISARMED:
         if (!ARMING_FLAG(ARMED)) {
             tfp_sprintf(buff, "DISARMED");
-            break;
         } else {
-            return;
+            buff[0] = 0;
         }
+        break;
 
     case OSD_NUMERICAL_HEADING:
         {
             const int heading = DECIDEGREES_TO_DEGREES(attitude.values.yaw);
-            tfp_sprintf(buff, "%c%03d", osdGetDirectionSymbolFromHeading(heading), heading);
+            buff[0] = osdGetDirectionSymbolFromHeading(heading);
+            fmtInt(buff + 1, heading, 3, '0');
             break;
         }
 
@@ -677,84 +866,203 @@ static void osdDrawSingleElement(uint8_t item)
         {
             const int verticalSpeed = osdGetMetersToSelectedUnit(getEstimatedVario());
             const char directionSymbol = verticalSpeed < 0 ? SYM_ARROW_SOUTH : SYM_ARROW_NORTH;
-            tfp_sprintf(buff, "%c%01d.%01d", directionSymbol, abs(verticalSpeed / 100), abs((verticalSpeed % 100) / 10));
+            buff[0] = directionSymbol;
+            fmtFixed(buff + 1, abs(verticalSpeed) / 10, 1, 0);
             break;
         }
 #ifdef USE_ESC_SENSOR
     case OSD_ESC_TMP:
         buff[0] = SYM_TEMP_C;
-        tfp_sprintf(buff + 1, "%d", escData == NULL ? 0 : escData->temperature);
+        fmtInt(buff + 1, escData == NULL ? 0 : escData->temperature, 0, ' ');
         break;
 
     case OSD_ESC_RPM:
-        tfp_sprintf(buff, "%d", escData == NULL ? 0 : escData->rpm);
+        fmtInt(buff, escData == NULL ? 0 : escData->rpm, 0, ' ');
         break;
 #endif
 
+    case OSD_LINK_QUALITY:
+        buff[0] = 'L';
+        buff[1] = 'Q';
+        fmtUint(buff + 2, rxGetLinkQuality(), 3, ' ');
+        break;
+
     default:
         return;
     }
 
-    displayWrite(osdDisplayPort, elemPosX + elemOffsetX, elemPosY, buff);
+    osdWriteElement(item, elemPosX + elemOffsetX, elemPosY, buff);
 }
 
-static void osdDrawElements(void)
+// Drawing order, elements drawn later win where they overlap
+static const uint8_t osdElementDisplayOrder[] = {
+    OSD_ARTIFICIAL_HORIZON,
+    OSD_MAIN_BATT_VOLTAGE,
+    OSD_RSSI_VALUE,
+    OSD_CROSSHAIRS,
+    OSD_ITEM_TIMER_1,
+    OSD_ITEM_TIMER_2,
+    OSD_FLYMODE,
+    OSD_THROTTLE_POS,
+    OSD_VTX_CHANNEL,
+    OSD_CURRENT_DRAW,
+    OSD_MAH_DRAWN,
+    OSD_CRAFT_NAME,
+    OSD_ALTITUDE,
+    OSD_ROLL_PIDS,
+    OSD_PITCH_PIDS,
+    OSD_YAW_PIDS,
+    OSD_POWER,
+    OSD_PIDRATE_PROFILE,
+    OSD_WARNINGS,
+    OSD_AVG_CELL_VOLTAGE,
+    OSD_DEBUG,
+    OSD_PITCH_ANGLE,
+    OSD_ROLL_ANGLE,
+    OSD_MAIN_BATT_USAGE,
+    OSD_DISARMED,
+    OSD_NUMERICAL_HEADING,
+    OSD_NUMERICAL_VARIO,
+    OSD_COMPASS_BAR,
+    OSD_LINK_QUALITY,
+#ifdef GPS
+    OSD_GPS_SATS,
+    OSD_GPS_SPEED,
+    OSD_GPS_LAT,
+    OSD_GPS_LON,
+    OSD_HOME_DIST,
+    OSD_HOME_DIR,
+#endif
+#ifdef USE_ESC_SENSOR
+    OSD_ESC_TMP,
+    OSD_ESC_RPM,
+#endif
+};
+
+#define OSD_ELEMENT_DISPLAY_COUNT ARRAYLEN(osdElementDisplayOrder)
+
+// Elements that change slowly, everything not listed here is redrawn on every refresh
+static const uint8_t osdElementDefaultRefresh[OSD_ITEM_COUNT] = {
+    [OSD_MAIN_BATT_VOLTAGE] = OSD_REFRESH_MEDIUM,
+    [OSD_RSSI_VALUE]        = OSD_REFRESH_MEDIUM,
+    [OSD_ITEM_TIMER_1]      = OSD_REFRESH_MEDIUM,
+    [OSD_ITEM_TIMER_2]      = OSD_REFRESH_MEDIUM,
+    [OSD_CURRENT_DRAW]      = OSD_REFRESH_MEDIUM,
+    [OSD_ALTITUDE]          = OSD_REFRESH_MEDIUM,
+    [OSD_POWER]             = OSD_REFRESH_MEDIUM,
+    [OSD_AVG_CELL_VOLTAGE]  = OSD_REFRESH_MEDIUM,
+    [OSD_DISARMED]          = OSD_REFRESH_MEDIUM,
+    [OSD_NUMERICAL_VARIO]   = OSD_REFRESH_MEDIUM,
+    [OSD_LINK_QUALITY]      = OSD_REFRESH_MEDIUM,
+    [OSD_GPS_SPEED]         = OSD_REFRESH_MEDIUM,
+    [OSD_HOME_DIST]         = OSD_REFRESH_MEDIUM,
+    [OSD_ESC_RPM]           = OSD_REFRESH_MEDIUM,
+    [OSD_MAH_DRAWN]         = OSD_REFRESH_SLOW,
+    [OSD_VTX_CHANNEL]       = OSD_REFRESH_SLOW,
+    [OSD_CRAFT_NAME]        = OSD_REFRESH_SLOW,
+    [OSD_ROLL_PIDS]         = OSD_REFRESH_SLOW,
+    [OSD_PITCH_PIDS]        = OSD_REFRESH_SLOW,
+    [OSD_YAW_PIDS]          = OSD_REFRESH_SLOW,
+    [OSD_PIDRATE_PROFILE]   = OSD_REFRESH_SLOW,
+    [OSD_MAIN_BATT_USAGE]   = OSD_REFRESH_SLOW,
+    [OSD_GPS_SATS]          = OSD_REFRESH_SLOW,
+    [OSD_GPS_LAT]           = OSD_REFRESH_SLOW,
+    [OSD_GPS_LON]           = OSD_REFRESH_SLOW,
+    [OSD_ESC_TMP]           = OSD_REFRESH_SLOW,
+};
+
+static const timeDelta_t osdRefreshPeriodUs[] = {
+    [OSD_REFRESH_DEFAULT] = 0,
+    [OSD_REFRESH_FAST]    = 0,                  // every refresh
+    [OSD_REFRESH_MEDIUM]  = REFRESH_1S / 5,
+    [OSD_REFRESH_SLOW]    = REFRESH_1S,
+};
+
+static timeUs_t osdElementDueAt[OSD_ITEM_COUNT];
+static uint8_t osdElementNext;      // where the last refresh ran out of time
+static bool osdElementsPending;
+
+static bool osdElementAvailable(uint8_t item)
 {
-    displayClearScreen(osdDisplayPort);
+    switch (item) {
+    case OSD_ARTIFICIAL_HORIZON:
+        return sensors(SENSOR_ACC);
+#ifdef GPS
+    case OSD_GPS_SATS:
+    case OSD_GPS_SPEED:
+    case OSD_GPS_LAT:
+    case OSD_GPS_LON:
+    case OSD_HOME_DIST:
+    case OSD_HOME_DIR:
+        return sensors(SENSOR_GPS);
+#endif
+#ifdef USE_ESC_SENSOR
+    case OSD_ESC_TMP:
+    case OSD_ESC_RPM:
+        return feature(FEATURE_ESC_SENSOR);
+#endif
+    default:
+        return true;
+    }
+}
 
-    /* Hide OSD when OSDSW mode is active */
-    if (IS_RC_MODE_ACTIVE(BOXOSD))
-      return;
+static bool osdElementDue(uint8_t item, timeUs_t currentTimeUs)
+{
+    // blinking elements and elements with nothing on the screen, e.g. after a blink or a clear, are drawn straight away
+    return IS_BLINK(item) || osdElementCache[item].length == 0 || cmp32(currentTimeUs, osdElementDueAt[item]) >= 0;
+}
 
-    if (sensors(SENSOR_ACC)) {
-        osdDrawSingleElement(OSD_ARTIFICIAL_HORIZON);
+static osd_refresh_e osdElementRefresh(uint8_t item)
+{
+    osd_refresh_e refresh = OSD_REFRESH_CLASS(osdConfig()->item_pos[item]);
+    if (refresh == OSD_REFRESH_DEFAULT) {
+        refresh = osdElementDefaultRefresh[item];
     }
+    return refresh;
+}
 
-    osdDrawSingleElement(OSD_MAIN_BATT_VOLTAGE);
-    osdDrawSingleElement(OSD_RSSI_VALUE);
-    osdDrawSingleElement(OSD_CROSSHAIRS);
-    osdDrawSingleElement(OSD_ITEM_TIMER_1);
-    osdDrawSingleElement(OSD_ITEM_TIMER_2);
-    osdDrawSingleElement(OSD_FLYMODE);
-    osdDrawSingleElement(OSD_THROTTLE_POS);
-    osdDrawSingleElement(OSD_VTX_CHANNEL);
-    osdDrawSingleElement(OSD_CURRENT_DRAW);
-    osdDrawSingleElement(OSD_MAH_DRAWN);
-    osdDrawSingleElement(OSD_CRAFT_NAME);
-    osdDrawSingleElement(OSD_ALTITUDE);
-    osdDrawSingleElement(OSD_ROLL_PIDS);
-    osdDrawSingleElement(OSD_PITCH_PIDS);
-    osdDrawSingleElement(OSD_YAW_PIDS);
-    osdDrawSingleElement(OSD_POWER);
-    osdDrawSingleElement(OSD_PIDRATE_PROFILE);
-    osdDrawSingleElement(OSD_WARNINGS);
-    osdDrawSingleElement(OSD_AVG_CELL_VOLTAGE);
-    osdDrawSingleElement(OSD_DEBUG);
-    osdDrawSingleElement(OSD_PITCH_ANGLE);
-    osdDrawSingleElement(OSD_ROLL_ANGLE);
-    osdDrawSingleElement(OSD_MAIN_BATT_USAGE);
-    osdDrawSingleElement(OSD_DISARMED);
-    osdDrawSingleElement(OSD_NUMERICAL_HEADING);
-    osdDrawSingleElement(OSD_NUMERICAL_VARIO);
-    osdDrawSingleElement(OSD_COMPASS_BAR);
+static void osdDrawElements(timeUs_t currentTimeUs)
+{
+    /* Hide OSD when OSDSW mode is active */
+    if (IS_RC_MODE_ACTIVE(BOXOSD)) {
+        if (!osdHidden || osdRedrawAll) {
+            osdClearScreen();
+            osdHidden = true;
+            osdRedrawAll = false;
+        }
+        osdElementsPending = false;
+        return;
+    }
 
-#ifdef GPS
-    if (sensors(SENSOR_GPS)) {
-        osdDrawSingleElement(OSD_GPS_SATS);
-        osdDrawSingleElement(OSD_GPS_SPEED);
-        osdDrawSingleElement(OSD_GPS_LAT);
-        osdDrawSingleElement(OSD_GPS_LON);
-        osdDrawSingleElement(OSD_HOME_DIST);
-        osdDrawSingleElement(OSD_HOME_DIR);
+    if (osdRedrawAll) {
+        osdClearScreen();
+        osdRedrawAll = false;
     }
-#endif // GPS
+    osdHidden = false;
 
-#ifdef USE_ESC_SENSOR
-  if (feature(FEATURE_ESC_SENSOR)) {
-      osdDrawSingleElement(OSD_ESC_TMP);
-      osdDrawSingleElement(OSD_ESC_RPM);
-  }
-#endif
+    // Draw the elements that are due, for as long as the time left before the next PID loop allows,
+    // the rest are drawn on the following calls
+    osdElementsPending = false;
+    for (unsigned i = 0; i < OSD_ELEMENT_DISPLAY_COUNT; i++) {
+        const uint8_t index = (osdElementNext + i) % OSD_ELEMENT_DISPLAY_COUNT;
+        const uint8_t item = osdElementDisplayOrder[index];
+
+        if (!osdElementAvailable(item) || !osdElementDue(item, currentTimeUs)) {
+            continue;
+        }
+
+        const timeUs_t drawStartUs = micros();
+        osdDrawSingleElement(item);
+        const timeDelta_t drawTimeUs = cmpTimeUs(micros(), drawStartUs);
+
+        osdElementDueAt[item] = currentTimeUs + osdRefreshPeriodUs[osdElementRefresh(item)];
+
+        if (schedulerGetTaskTimeBudgetUs() <= drawTimeUs && i + 1 < OSD_ELEMENT_DISPLAY_COUNT) {
+            osdElementNext = (index + 1) % OSD_ELEMENT_DISPLAY_COUNT;
+            osdElementsPending = true;
+            return;
+        }
+    }
 }
 
 void pgResetFn_osdConfig(osdConfig_t *osdConfig)
@@ -796,6 +1104,7 @@ void pgResetFn_osdConfig(osdConfig_t *osdConfig)
     osdConfig->item_pos[OSD_NUMERICAL_VARIO]    = OSD_POS(23, 8)  | VISIBLE_FLAG;
     osdConfig->item_pos[OSD_ESC_TMP]            = OSD_POS(18, 2)  | VISIBLE_FLAG;
     osdConfig->item_pos[OSD_ESC_RPM]            = OSD_POS(19, 2)  | VISIBLE_FLAG;
+    osdConfig->item_pos[OSD_LINK_QUALITY]       = OSD_POS(8, 3)   | VISIBLE_FLAG;
 
     osdConfig->enabled_stats[OSD_STAT_MAX_SPEED]       = true;
     osdConfig->enabled_stats[OSD_STAT_MIN_BATTERY]     = true;
@@ -849,6 +1158,7 @@ void osdInit(displayPort_t *osdDisplayPortToUse)
     memset(blinkBits, 0, sizeof(blinkBits));
 
     displayClearScreen(osdDisplayPort);
+    osdRedrawAll = true;
 
     osdDrawLogo(3, 1);
 
@@ -877,6 +1187,11 @@ void osdUpdateAlarms(void)
     else
         CLR_BLINK(OSD_RSSI_VALUE);
 
+    if (failsafeIsLinkDegraded())
+        SET_BLINK(OSD_LINK_QUALITY);
+    else
+        CLR_BLINK(OSD_LINK_QUALITY);
+
     if (getBatteryState() == BATTERY_OK) {
         CLR_BLINK(OSD_WARNINGS);
         CLR_BLINK(OSD_MAIN_BATT_VOLTAGE);
@@ -919,6 +1234,7 @@ void osdUpdateAlarms(void)
 void osdResetAlarms(void)
 {
     CLR_BLINK(OSD_RSSI_VALUE);
+    CLR_BLINK(OSD_LINK_QUALITY);
     CLR_BLINK(OSD_MAIN_BATT_VOLTAGE);
     CLR_BLINK(OSD_WARNINGS);
     CLR_BLINK(OSD_GPS_SATS);
@@ -1026,6 +1342,7 @@ static void osdShowStats(void)
     char buff[10];
 
     displayClearScreen(osdDisplayPort);
+    osdRedrawAll = true;
     displayWrite(osdDisplayPort, 2, top++, "  --- STATS ---");
 
     if (osdConfig()->enabled_stats[OSD_STAT_TIMER_1]) {
@@ -1079,17 +1396,17 @@ static void osdShowStats(void)
 
     if (osdConfig()->enabled_stats[OSD_STAT_MAX_ALTITUDE]) {
         int32_t alt = osdGetMetersToSelectedUnit(stats.max_altitude);
-        tfp_sprintf(buff, "%c%d.%01d%c", alt < 0 ? '-' : ' ', abs(alt / 100), abs((alt % 100) / 10), osdGetMetersToSelectedUnitSymbol());
+        osdFormatSignedTenths(buff, alt, osdGetMetersToSelectedUnitSymbol());
         osdDisplayStatisticLabel(top++, "MAX ALTITUDE", buff);
     }
 
 #ifdef BLACKBOX
-    if (osdConfig()->enabled_stats[OSD_STAT_BLACKBOX] && blackboxConfig()->device && blackboxConfig()->device != BLACKBOX_DEVICE_SERIAL) {
+    if (osdConfig()->enabled_stats[OSD_STAT_BLACKBOX] && blackboxConfig()->device && blackboxConfig()->device != BLACKBOX_DEVICE_SERIAL && blackboxConfig()->device != BLACKBOX_DEVICE_MSP) {
         osdGetBlackboxStatusString(buff);
         osdDisplayStatisticLabel(top++, "BLACKBOX", buff);
     }
 
-    if (osdConfig()->enabled_stats[OSD_STAT_BLACKBOX_NUMBER] && blackboxConfig()->device && blackboxConfig()->device != BLACKBOX_DEVICE_SERIAL) {
+    if (osdConfig()->enabled_stats[OSD_STAT_BLACKBOX_NUMBER] && blackboxConfig()->device && blackboxConfig()->device != BLACKBOX_DEVICE_SERIAL && blackboxConfig()->device != BLACKBOX_DEVICE_MSP) {
         itoa(blackboxGetLogNumber(), buff, 10);
         osdDisplayStatisticLabel(top++, "BB LOG NUM", buff);
     }
@@ -1102,6 +1419,7 @@ static void osdShowStats(void)
 static void osdShowArmed(void)
 {
     displayClearScreen(osdDisplayPort);
+    osdRedrawAll = true;
     displayWrite(osdDisplayPort, 12, 7, "ARMED");
 }
 
@@ -1144,7 +1462,6 @@ STATIC_UNIT_TESTED void osdRefresh(timeUs_t currentTimeUs)
             displayHeartbeat(osdDisplayPort);
             return;
         } else {
-            displayClearScreen(osdDisplayPort);
             resumeRefreshAt = 0;
         }
     }
@@ -1160,16 +1477,36 @@ STATIC_UNIT_TESTED void osdRefresh(timeUs_t currentTimeUs)
 #ifdef CMS
     if (!displayIsGrabbed(osdDisplayPort)) {
         osdUpdateAlarms();
-        osdDrawElements();
+        osdDrawElements(currentTimeUs);
         displayHeartbeat(osdDisplayPort);
-#ifdef OSD_CALLS_CMS
     } else {
+        // the menu draws over the elements, so they are all drawn again once it is released
+        osdRedrawAll = true;
+#ifdef OSD_CALLS_CMS
         cmsUpdate(currentTimeUs);
 #endif
     }
 #endif
 }
 
+// Start of the video field the OSD last worked in, when the display reports them
+static timeUs_t osdVsyncHandledAtUs = 0;
+
+/*
+ * With a display that reports vertical syncs the OSD runs once per video field, as soon as it starts,
+ * otherwise at the task rate.
+ */
+bool osdUpdateCheck(timeUs_t currentTimeUs, timeDelta_t currentDeltaTimeUs)
+{
+    UNUSED(currentTimeUs);
+
+    timeUs_t vsyncAtUs;
+    if (osdDisplayPort && displayGetVsync(osdDisplayPort, &vsyncAtUs)) {
+        return vsyncAtUs != osdVsyncHandledAtUs;
+    }
+    return currentDeltaTimeUs >= 1000000 / OSD_TASK_FREQUENCY_HZ;
+}
+
 /*
  * Called periodically by the scheduler
  */
@@ -1181,6 +1518,12 @@ void osdUpdate(timeUs_t currentTimeUs)
         showVisualBeeper = true;
     }
 
+    timeUs_t vsyncAtUs;
+    const bool fieldSynced = displayGetVsync(osdDisplayPort, &vsyncAtUs);
+    if (fieldSynced) {
+        osdVsyncHandledAtUs = vsyncAtUs;
+    }
+
 #ifdef MAX7456_DMA_CHANNEL_TX
     // don't touch buffers if DMA transaction is in progress
     if (displayIsTransferInProgress(osdDisplayPort)) {
@@ -1190,9 +1533,9 @@ void osdUpdate(timeUs_t currentTimeUs)
 
     // redraw values in buffer
 #ifdef USE_MAX7456
-#define DRAW_FREQ_DENOM 5
+#define DRAW_FREQ_DENOM 3
 #else
-#define DRAW_FREQ_DENOM 10 // MWOSD @ 115200 baud (
+#define DRAW_FREQ_DENOM 5 // MWOSD @ 115200 baud (
 #endif
 
 #ifdef USE_SLOW_MSP_DISPLAYPORT_RATE_WHEN_UNARMED
@@ -1204,12 +1547,37 @@ void osdUpdate(timeUs_t currentTimeUs)
     }
 #endif
 
+    if (fieldSynced) {
+        // send what was drawn during the previous field while this one is still in vertical blanking,
+        // so the overlay never changes part way down the picture
+        while (!displayIsSynced(osdDisplayPort)
+            && !displayIsTransferInProgress(osdDisplayPort)
+            && cmpTimeUs(micros(), vsyncAtUs) < OSD_VBLANK_US) {
+            displayDrawScreen(osdDisplayPort);
+        }
+    }
+
     if (counter++ % DRAW_FREQ_DENOM == 0) {
         osdRefresh(currentTimeUs);
 
         showVisualBeeper = false;
-    } else { // rest of time redraw screen 10 chars per idle so it doesn't lock the main idle
-        displayDrawScreen(osdDisplayPort);
+    } else {
+        if (osdElementsPending && !displayIsGrabbed(osdDisplayPort)) {
+            // the elements the last refresh ran out of time for
+            osdDrawElements(currentTimeUs);
+        }
+
+        if (!fieldSynced) {
+            // rest of time redraw the screen in chunks, for as long as the time left before the next PID loop allows
+            timeDelta_t chunkTimeUs;
+            do {
+                const timeUs_t chunkStartUs = micros();
+                displayDrawScreen(osdDisplayPort);
+                chunkTimeUs = cmpTimeUs(micros(), chunkStartUs);
+            } while (!displayIsSynced(osdDisplayPort)
+                && !displayIsTransferInProgress(osdDisplayPort)
+                && schedulerGetTaskTimeBudgetUs() > chunkTimeUs);
+        }
     }
 
 #ifdef CMS
@@ -26,10 +26,17 @@ extern const char * const osdTimerSourceNames[OSD_NUM_TIMER_TYPES];
 
 #define OSD_ELEMENT_BUFFER_LENGTH 32
 
+#define OSD_TASK_FREQUENCY_HZ 60
+
 #define VISIBLE_FLAG  0x0800
 #define VISIBLE(x)    (x & VISIBLE_FLAG)
 #define OSD_POS_MAX   0x3FF
-#define OSD_POSCFG_MAX   (VISIBLE_FLAG|0x3FF) // For CLI values
+#define OSD_POSCFG_MAX   (OSD_REFRESH_MASK|VISIBLE_FLAG|0x3FF) // For CLI values
+
+// Refresh class, stored in the two bits above the visible flag
+#define OSD_REFRESH_SHIFT 12
+#define OSD_REFRESH_MASK  (0x03 << OSD_REFRESH_SHIFT)
+#define OSD_REFRESH_CLASS(x) ((x & OSD_REFRESH_MASK) >> OSD_REFRESH_SHIFT)
 
 // Character coordinate
 #define OSD_POSITION_BITS 5 // 5 bits gives a range 0-31
@@ -83,6 +90,7 @@ typedef enum {
     OSD_COMPASS_BAR,
     OSD_ESC_TMP,
     OSD_ESC_RPM,
+    OSD_LINK_QUALITY,
     OSD_ITEM_COUNT // MUST BE LAST
 } osd_items_e;
 
@@ -102,6 +110,13 @@ typedef enum {
     OSD_STAT_COUNT // MUST BE LAST
 } osd_stats_e;
 
+typedef enum {
+    OSD_REFRESH_DEFAULT,    // the element's own rate
+    OSD_REFRESH_FAST,       // every refresh
+    OSD_REFRESH_MEDIUM,     // 5Hz
+    OSD_REFRESH_SLOW        // 1Hz
+} osd_refresh_e;
+
 typedef enum {
     OSD_UNIT_IMPERIAL,
     OSD_UNIT_METRIC
@@ -148,6 +163,7 @@ struct displayPort_s;
 void osdInit(struct displayPort_s *osdDisplayPort);
 void osdResetConfig(osdConfig_t *osdProfile);
 void osdResetAlarms(void);
+bool osdUpdateCheck(timeUs_t currentTimeUs, timeDelta_t currentDeltaTimeUs);
 void osdUpdate(timeUs_t currentTimeUs);
 
 #endif
@@ -29,6 +29,7 @@
 #include "build/debug.h"
 #include "build/version.h"
 
+#include "common/maths.h"
 #include "common/printf.h"
 #include "common/utils.h"
 
@@ -38,6 +39,9 @@
 
 #include "io/osd_slave.h"
 
+#include "msp/msp_protocol.h"
+#include "msp/msp_serial.h"
+
 //#define OSD_SLAVE_DEBUG
 
 // when locked the system ignores requests to enter cli or bootloader mode via serial connection.
@@ -56,31 +60,74 @@ static void osdDrawLogo(int x, int y)
     }
 }
 
-bool displayDrawScreenQueued = false;
-bool receivingScreen = false;
+// The frame the FC is sending is put together here and only committed to the display when the FC asks for it to be
+// drawn, so a frame is never shown half written. The characters that changed since the last commit are copied over and
+// the display sends them on as run-length DMA updates, the FC is acknowledged so it can send the next frame right away.
+
+#define OSD_SLAVE_MAX_ROWS  16
+#define OSD_SLAVE_MAX_COLS  32  // one bit per column in the dirty masks
+
+static uint8_t frame[OSD_SLAVE_MAX_ROWS][OSD_SLAVE_MAX_COLS];
+static uint32_t frameDirty[OSD_SLAVE_MAX_ROWS];
+static bool frameReady = false;     // the FC has asked for the frame to be drawn
+static bool drawing = false;        // the display has not sent all of the last commit yet
 bool stalled = false;
 
+static void frameChar(uint8_t x, uint8_t y, uint8_t c)
+{
+    if (y < MIN(osdDisplayPort->rows, OSD_SLAVE_MAX_ROWS) && x < MIN(osdDisplayPort->cols, OSD_SLAVE_MAX_COLS) && frame[y][x] != c) {
+        frame[y][x] = c;
+        frameDirty[y] |= 1U << x;
+    }
+}
+
+// What the display shows is not the frame, commit all of it next time
+static void frameResync(void)
+{
+    for (int row = 0; row < OSD_SLAVE_MAX_ROWS; row++) {
+        frameDirty[row] = ~0U;
+    }
+}
+
+static void frameCommit(void)
+{
+    for (int row = 0; row < MIN(osdDisplayPort->rows, OSD_SLAVE_MAX_ROWS); row++) {
+        uint32_t dirty = frameDirty[row] & (osdDisplayPort->cols < 32 ? (1U << osdDisplayPort->cols) - 1 : ~0U);
+        while (dirty) {
+            const int col = __builtin_ctz(dirty);
+            displayWriteChar(osdDisplayPort, col, row, frame[row][col]);
+            dirty &= dirty - 1;
+        }
+        frameDirty[row] = 0;
+    }
+}
+
 void osdSlaveDrawScreen(void)
 {
-    displayDrawScreenQueued = true;
+    frameReady = true;
 }
 
 static uint32_t timeoutAt = 0;
 
 void osdSlaveClearScreen(void)
 {
-    displayClearScreen(osdDisplayPort);
-    receivingScreen = true;
+    for (int row = 0; row < OSD_SLAVE_MAX_ROWS; row++) {
+        for (int col = 0; col < OSD_SLAVE_MAX_COLS; col++) {
+            frameChar(col, row, ' ');
+        }
+    }
 }
 
 void osdSlaveWriteChar(const uint8_t x, const uint8_t y, const uint8_t c)
 {
-    displayWriteChar(osdDisplayPort, x, y, c);
+    frameChar(x, y, c);
 }
 
 void osdSlaveWrite(const uint8_t x, const uint8_t y, const char *s)
 {
-    displayWrite(osdDisplayPort, x, y, s);
+    for (uint8_t col = x; *s; s++, col++) {
+        frameChar(col, y, *s);
+    }
 }
 
 void osdSlaveHeartbeat(void)
@@ -107,7 +154,8 @@ void osdSlaveInit(displayPort_t *osdDisplayPortToUse)
 
     displayResync(osdDisplayPort);
 
-    displayDrawScreenQueued = true;
+    frameResync();
+    drawing = true;
 }
 
 bool osdSlaveCheck(timeUs_t currentTimeUs, timeDelta_t currentDeltaTimeUs)
@@ -120,9 +168,12 @@ bool osdSlaveCheck(timeUs_t currentTimeUs, timeDelta_t currentDeltaTimeUs)
 
         displayWrite(osdDisplayPort, 8, 12, "WAITING FOR FC");
         displayResync(osdDisplayPort);
+
+        frameResync();
+        drawing = true;
     }
 
-    return receivingScreen || displayDrawScreenQueued || stalled;
+    return frameReady || drawing;
 }
 
 /*
@@ -132,13 +183,6 @@ void osdSlaveUpdate(timeUs_t currentTimeUs)
 {
     UNUSED(currentTimeUs);
 
-#ifdef MAX7456_DMA_CHANNEL_TX
-    // don't touch buffers if DMA transaction is in progress
-    if (displayIsTransferInProgress(osdDisplayPort)) {
-        return;
-    }
-#endif // MAX7456_DMA_CHANNEL_TX
-
 #ifdef OSD_SLAVE_DEBUG
     char buff[32];
     for (int i = 0; i < 4; i ++) {
@@ -147,10 +191,27 @@ void osdSlaveUpdate(timeUs_t currentTimeUs)
     }
 #endif
 
-    if (displayDrawScreenQueued || stalled) {
+    if (frameReady) {
+        // only the display's screen buffer is written, a DMA transfer in progress is not disturbed
+        frameCommit();
+        frameReady = false;
+        drawing = true;
+
+        uint8_t ack[] = { MSP_DISPLAYPORT_FRAME_ACK };
+        mspSerialPush(MSP_DISPLAYPORT, ack, sizeof(ack), MSP_DIRECTION_REPLY);
+    }
+
+#ifdef MAX7456_DMA_CHANNEL_TX
+    if (displayIsTransferInProgress(osdDisplayPort)) {
+        return;
+    }
+#endif // MAX7456_DMA_CHANNEL_TX
+
+    // each call sends what fits in one transfer, keep going until the display shows all of it
+    if (displayIsSynced(osdDisplayPort)) {
+        drawing = false;
+    } else {
         displayDrawScreen(osdDisplayPort);
-        displayDrawScreenQueued = false;
-        receivingScreen = false;
     }
 }
 #endif // OSD_SLAVE
@@ -23,6 +23,7 @@
 
 #include "build/build_config.h"
 
+#include "common/maths.h"
 #include "common/utils.h"
 
 #include "config/parameter_group.h"
@@ -522,10 +523,56 @@ static void nopConsumer(uint8_t data)
     UNUSED(data);
 }
 
+#define SERIAL_PASSTHROUGH_CHUNK_SIZE 64
+
+// Moves what one port received to the other in one go. Ports with in place writes get the bytes straight in
+// their transmit buffer, so that TX DMA sends the whole chunk.
+static void serialPassthroughForward(serialPort_t *from, serialPort_t *to, serialConsumer *consumer)
+{
+    uint32_t count = serialRxBytesWaiting(from);
+    if (!count) {
+        return;
+    }
+
+    LED0_ON;
+    if (!(to->mode & MODE_TX)) {
+        // nowhere to send it, still let the consumer see it
+        while (count--) {
+            consumer(serialRead(from));
+        }
+        LED0_OFF;
+        return;
+    }
+
+    uint8_t chunk[SERIAL_PASSTHROUGH_CHUNK_SIZE];
+    uint8_t *data;
+    const uint32_t reserved = serialReserveWrite(to, &data);
+    if (reserved) {
+        count = MIN(count, reserved);
+    } else {
+        data = chunk;
+        count = MIN(count, MIN(serialTxBytesFree(to), sizeof(chunk)));
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        data[i] = serialRead(from);
+        consumer(data[i]);
+    }
+
+    if (reserved) {
+        serialCommitWrite(to, count);
+    } else {
+        serialWriteBuf(to, data, count);
+    }
+    LED0_OFF;
+}
+
 /*
  A high-level serial passthrough implementation. Used by cli to start an
  arbitrary serial passthrough "proxy". Optional callbacks can be given to allow
  for specialized data processing.
+ When one side is the USB VCP, the other follows the baud rate the host sets
+ after the passthrough starts, so flashing tools can change it on the fly.
  */
 void serialPassthrough(serialPort_t *left, serialPort_t *right, serialConsumer *leftC, serialConsumer *rightC)
 {
@@ -537,6 +584,19 @@ void serialPassthrough(serialPort_t *left, serialPort_t *right, serialConsumer *
     if (!rightC)
         rightC = &nopConsumer;
 
+#ifdef USE_VCP
+    serialPort_t *host = NULL;
+    serialPort_t *device = NULL;
+    if (left->identifier == SERIAL_PORT_USB_VCP) {
+        host = left;
+        device = right;
+    } else if (right->identifier == SERIAL_PORT_USB_VCP) {
+        host = right;
+        device = left;
+    }
+    uint32_t hostBaudRate = host ? usbVcpGetBaudRate(host) : 0;
+#endif
+
     LED0_OFF;
     LED1_OFF;
 
@@ -548,20 +608,17 @@ void serialPassthrough(serialPort_t *left, serialPort_t *right, serialConsumer *
         // implement a guard interval and check for `+++` as an escape sequence
         // to return to CLI command mode.
         // https://en.wikipedia.org/wiki/Escape_sequence#Modem_control
-        if (serialRxBytesWaiting(left)) {
-            LED0_ON;
-            uint8_t c = serialRead(left);
-            serialWrite(right, c);
-            leftC(c);
-            LED0_OFF;
-         }
-         if (serialRxBytesWaiting(right)) {
-             LED0_ON;
-             uint8_t c = serialRead(right);
-             serialWrite(left, c);
-             rightC(c);
-             LED0_OFF;
-         }
-     }
- }
+#ifdef USE_VCP
+        if (host && usbVcpGetBaudRate(host) != hostBaudRate) {
+            hostBaudRate = usbVcpGetBaudRate(host);
+            if (hostBaudRate) {
+                waitForSerialPortToFinishTransmitting(device);
+                serialSetBaudRate(device, hostBaudRate);
+            }
+        }
+#endif
+        serialPassthroughForward(left, right, leftC);
+        serialPassthroughForward(right, left, rightC);
+    }
+}
  #endif
@@ -24,6 +24,9 @@
 
 #ifdef  USE_SERIAL_4WAY_BLHELI_INTERFACE
 
+#include "common/crc.h"
+#include "common/maths.h"
+
 #include "drivers/buf_writer.h"
 #include "drivers/io.h"
 #include "drivers/serial.h"
@@ -274,51 +277,6 @@ void esc4wayRelease(void)
 #define ACK_I_INVALID_PARAM     0x09
 #define ACK_D_GENERAL_ERROR     0x0F
 
-/* Copyright (c) 2002, 2003, 2004  Marek Michalkiewicz
-   Copyright (c) 2005, 2007 Joerg Wunsch
-   Copyright (c) 2013 Dave Hylands
-   Copyright (c) 2013 Frederic Nadeau
-   All rights reserved.
-
-   Redistribution and use in source and binary forms, with or without
-   modification, are permitted provided that the following conditions are met:
-
-   * Redistributions of source code must retain the above copyright
-     notice, this list of conditions and the following disclaimer.
-
-   * Redistributions in binary form must reproduce the above copyright
-     notice, this list of conditions and the following disclaimer in
-     the documentation and/or other materials provided with the
-     distribution.
-
-   * Neither the name of the copyright holders nor the names of
-     contributors may be used to endorse or promote products derived
-     from this software without specific prior written permission.
-
-  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
-  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
-  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
-  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
-  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
-  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
-  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
-  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
-  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
-  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
-  POSSIBILITY OF SUCH DAMAGE. */
-uint16_t _crc_xmodem_update (uint16_t crc, uint8_t data) {
-        int i;
-
-        crc = crc ^ ((uint16_t)data << 8);
-        for (i=0; i < 8; i++) {
-            if (crc & 0x8000)
-                crc = (crc << 1) ^ 0x1021;
-            else
-                crc <<= 1;
-        }
-        return crc;
-}
-// * End copyright
 
 
 #define ATMEL_DEVICE_MATCH ((pDeviceInfo->words[0] == 0x9307) || (pDeviceInfo->words[0] == 0x930A) || \
@@ -387,39 +345,40 @@ static uint8_t ReadByte(void)
     return serialRead(port);
 }
 
-static uint8_16_u CRC_in;
-static uint8_t ReadByteCrc(void)
-{
-    uint8_t b = ReadByte();
-    CRC_in.word = _crc_xmodem_update(CRC_in.word, b);
-    return b;
-}
-
-static void WriteByte(uint8_t b)
+// the host sends a whole command at once, so take it in as large blocks as have arrived
+static void ReadBuf(uint8_t *data, int len)
 {
-    serialWrite(port, b);
+    while (len > 0) {
+        const uint32_t count = serialReadBuf(port, data, len);
+        data += count;
+        len -= count;
+    }
 }
 
-static uint8_16_u CRCout;
-static void WriteByteCrc(uint8_t b)
+static void WriteBuf(const uint8_t *data, int len)
 {
-    WriteByte(b);
-    CRCout.word = _crc_xmodem_update(CRCout.word, b);
+    while (len > 0) {
+        const int count = MIN((uint32_t)len, serialTxBytesFree(port));
+        serialWriteBuf(port, data, count);
+        data += count;
+        len -= count;
+    }
 }
 
 void esc4wayProcess(serialPort_t *mspPort)
 {
 
-    uint8_t ParamBuf[256];
-    uint8_t ESC;
+    // cmd_Local_Escape/cmd_Remote_Escape, CMD, ADDR_H, ADDR_L, PARAM_LEN, PARAM[1..256], ACK (replies only), CRC_H, CRC_L
+    uint8_t frame[5 + 256 + 3];
+    uint8_t *ParamBuf = &frame[5];
     uint8_t I_PARAM_LEN;
     uint8_t CMD;
     uint8_t ACK_OUT;
-    uint8_16_u CRC_check;
+    uint16_t CRC_in;
+    uint16_t CRC_out;
     uint8_16_u Dummy;
     uint8_t O_PARAM_LEN;
     uint8_t *O_PARAM;
-    uint8_t *InBuff;
     ioMem_t ioMem;
 
     port = mspPort;
@@ -435,32 +394,25 @@ void esc4wayProcess(serialPort_t *mspPort)
     while (1) {
         // restart looking for new sequence from host
         do {
-            CRC_in.word = 0;
-            ESC = ReadByteCrc();
-        } while (ESC != cmd_Local_Escape);
+            frame[0] = ReadByte();
+        } while (frame[0] != cmd_Local_Escape);
 
         RX_LED_ON;
 
         Dummy.word = 0;
         O_PARAM = &Dummy.bytes[0];
         O_PARAM_LEN = 1;
-        CMD = ReadByteCrc();
-        ioMem.D_FLASH_ADDR_H = ReadByteCrc();
-        ioMem.D_FLASH_ADDR_L = ReadByteCrc();
-        I_PARAM_LEN = ReadByteCrc();
+        ReadBuf(&frame[1], 4);
+        CMD = frame[1];
+        ioMem.D_FLASH_ADDR_H = frame[2];
+        ioMem.D_FLASH_ADDR_L = frame[3];
+        I_PARAM_LEN = frame[4];
 
-        InBuff = ParamBuf;
-        uint8_t i = I_PARAM_LEN;
-        do {
-          *InBuff = ReadByteCrc();
-          InBuff++;
-          i--;
-        } while (i != 0);
-
-        CRC_check.bytes[1] = ReadByte();
-        CRC_check.bytes[0] = ReadByte();
+        const int paramLen = I_PARAM_LEN ? I_PARAM_LEN : 256;
+        ReadBuf(ParamBuf, paramLen + 2);
+        CRC_in = crc16_ccitt_update(0, frame, 5 + paramLen);
 
-        if (CRC_check.word == CRC_in.word) {
+        if (((ParamBuf[paramLen] << 8) | ParamBuf[paramLen + 1]) == CRC_in) {
             ACK_OUT = ACK_OK;
         } else {
             ACK_OUT = ACK_I_INVALID_CRC;
@@ -691,7 +643,7 @@ void esc4wayProcess(serialPort_t *mspPort)
                     if (ACK_OUT == ACK_OK)
                     {
                         O_PARAM_LEN = ioMem.D_NUM_BYTES;
-                        O_PARAM = (uint8_t *)&ParamBuf;
+                        O_PARAM = ParamBuf;
                     }
                     break;
                 }
@@ -732,7 +684,7 @@ void esc4wayProcess(serialPort_t *mspPort)
                     if (ACK_OUT == ACK_OK)
                     {
                         O_PARAM_LEN = ioMem.D_NUM_BYTES;
-                        O_PARAM = (uint8_t *)&ParamBuf;
+                        O_PARAM = ParamBuf;
                     }
                     break;
                 }
@@ -857,29 +809,23 @@ void esc4wayProcess(serialPort_t *mspPort)
             }
         }
 
-        CRCout.word = 0;
-
         RX_LED_OFF;
 
-        serialBeginWrite(port);
-        WriteByteCrc(cmd_Remote_Escape);
-        WriteByteCrc(CMD);
-        WriteByteCrc(ioMem.D_FLASH_ADDR_H);
-        WriteByteCrc(ioMem.D_FLASH_ADDR_L);
-        WriteByteCrc(O_PARAM_LEN);
-
-        i=O_PARAM_LEN;
-        do {
-            while (!serialTxBytesFree(port));
-
-            WriteByteCrc(*O_PARAM);
-            O_PARAM++;
-            i--;
-        } while (i > 0);
+        // the reply goes out in one piece, the parameters may still be in the command buffer
+        const int replyParamLen = O_PARAM_LEN ? O_PARAM_LEN : 256;
+        memmove(&frame[5], O_PARAM, replyParamLen);
+        frame[0] = cmd_Remote_Escape;
+        frame[1] = CMD;
+        frame[2] = ioMem.D_FLASH_ADDR_H;
+        frame[3] = ioMem.D_FLASH_ADDR_L;
+        frame[4] = O_PARAM_LEN;
+        frame[5 + replyParamLen] = ACK_OUT;
+        CRC_out = crc16_ccitt_update(0, frame, 5 + replyParamLen + 1);
+        frame[5 + replyParamLen + 1] = CRC_out >> 8;
+        frame[5 + replyParamLen + 2] = CRC_out & 0xff;
 
-        WriteByteCrc(ACK_OUT);
-        WriteByte(CRCout.bytes[1]);
-        WriteByte(CRCout.bytes[0]);
+        serialBeginWrite(port);
+        WriteBuf(frame, 5 + replyParamLen + 3);
         serialEndWrite(port);
 
         TX_LED_OFF;
@@ -141,15 +141,28 @@ static void ByteCrc(uint8_t *bt)
     }
 }
 
-static uint8_t BL_ReadBuf(uint8_t *pstring, uint8_t len)
+// the crc is run over the whole buffer, before sending or after receiving it,
+// so the gaps between the bytes on the wire are not stretched by it
+static void BufCrc(uint8_t *pstring, uint8_t len)
 {
     // len 0 means 256
     CRC_16.word = 0;
+    do {
+        ByteCrc(pstring);
+        pstring++;
+        len--;
+    } while (len > 0);
+}
+
+static uint8_t BL_ReadBuf(uint8_t *pstring, uint8_t len)
+{
+    // len 0 means 256
+    uint8_t *buf = pstring;
+    uint8_t bufLen = len;
     LastCRC_16.word = 0;
     uint8_t  LastACK = brNONE;
     do {
         if (!suart_getc_(pstring)) goto timeout;
-        ByteCrc(pstring);
         pstring++;
         len--;
     } while (len > 0);
@@ -159,6 +172,7 @@ static uint8_t BL_ReadBuf(uint8_t *pstring, uint8_t len)
         if (!suart_getc_(&LastCRC_16.bytes[0])) goto timeout;
         if (!suart_getc_(&LastCRC_16.bytes[1])) goto timeout;
         if (!suart_getc_(&LastACK)) goto timeout;
+        BufCrc(buf, bufLen);
         if (CRC_16.word != LastCRC_16.word) {
             LastACK = brERRORCRC;
         }
@@ -171,11 +185,10 @@ timeout:
 
 static void BL_SendBuf(uint8_t *pstring, uint8_t len)
 {
+    BufCrc(pstring, len);
     ESC_OUTPUT;
-    CRC_16.word=0;
     do {
         suart_putc_(pstring);
-        ByteCrc(pstring);
         pstring++;
         len--;
     } while (len > 0);
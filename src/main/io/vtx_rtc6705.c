@@ -99,15 +99,18 @@ static void vtxRTC6705Configure(void)
 }
 
 #ifdef RTC6705_POWER_PIN
+static bool vtxRTC6705Booting = false;
+static uint32_t vtxRTC6705EnableTime;
+
 static void vtxRTC6705EnableAndConfigure(void)
 {
     WAIT_FOR_VTX;
 
     rtc6705Enable();
 
-    delay(RTC6705_BOOT_DELAY);
-
-    vtxRTC6705Configure();
+    // vtxRTC6705Process() configures the chip once it has booted, nothing else waits for it
+    vtxRTC6705EnableTime = millis();
+    vtxRTC6705Booting = true;
 }
 #endif
 
@@ -133,6 +136,16 @@ void vtxRTC6705Process(uint32_t now)
 
         configured = true;
     }
+
+#ifdef RTC6705_POWER_PIN
+    if (vtxRTC6705Booting && millis() - vtxRTC6705EnableTime >= RTC6705_BOOT_DELAY) {
+        vtxRTC6705Booting = false;
+        // band, channel and power may have been changed while it was booting
+        if (vtxRTC6705.powerIndex > 0) {
+            vtxRTC6705Configure();
+        }
+    }
+#endif
 }
 
 #ifdef VTX_COMMON
@@ -145,7 +158,11 @@ vtxDevType_e vtxRTC6705GetDeviceType(void)
 
 bool vtxRTC6705IsReady(void)
 {
+#ifdef RTC6705_POWER_PIN
+    return !vtxRTC6705Booting;
+#else
     return true;
+#endif
 }
 
 void vtxRTC6705SetBandAndChannel(uint8_t band, uint8_t channel)
@@ -30,6 +30,7 @@
 #include "cms/cms.h"
 #include "cms/cms_types.h"
 
+#include "common/crc.h"
 #include "common/printf.h"
 #include "common/utils.h"
 
@@ -201,34 +202,6 @@ static bool saDeferred = true; // saCms variable?
 #define SA_MAX_RCVLEN 11
 static uint8_t sa_rbuf[SA_MAX_RCVLEN+4]; // XXX delete 4 byte guard
 
-//
-// CRC8 computations
-//
-
-#define POLYGEN 0xd5
-
-static uint8_t CRC8(const uint8_t *data, const int8_t len)
-{
-    uint8_t crc = 0; /* start with 0 so first byte can be 'xored' in */
-    uint8_t currByte;
-
-    for (int i = 0 ; i < len ; i++) {
-        currByte = data[i];
-
-        crc ^= currByte; /* XOR-in the next input byte */
-
-        for (int i = 0; i < 8; i++) {
-            if ((crc & 0x80) != 0) {
-                crc = (uint8_t)((crc << 1) ^ POLYGEN);
-            } else {
-                crc <<= 1;
-            }
-        }
-    }
-    return crc;
-}
-
-
 static void saPrintSettings(void)
 {
 #ifdef SMARTAUDIO_DPRINTF
@@ -269,6 +242,11 @@ static int sa_adjdir = 1; // -1=going down, 1=going up
 static int sa_baudstep = 50;
 
 #define SMARTAUDIO_CMD_TIMEOUT    120
+#define SMARTAUDIO_MAX_RESENDS    3
+
+// Heart beat intervals (ms); the settings are polled fast only until the device has confirmed them
+#define SMARTAUDIO_POLLING_INTERVAL         500
+#define SMARTAUDIO_IDLE_POLLING_INTERVAL    10000
 
 static void saAutobaud(void)
 {
@@ -314,6 +292,10 @@ static uint32_t sa_lastTransmission = 0;
 static uint8_t sa_outstanding = SA_CMD_NONE; // Outstanding command
 static uint8_t sa_osbuf[32]; // Outstanding comamnd frame for retransmission
 static int sa_oslen;         // And associate length
+static uint8_t sa_resends;   // Retransmissions of the outstanding command so far
+static bool sa_confirmed;    // Device settings read back with nothing queued or outstanding
+
+static bool saQueueEmpty(void); // Forward
 
 #ifdef CMS
 void saCmsUpdate(void);
@@ -343,6 +325,7 @@ static void saProcessResponse(uint8_t *buf, int len)
         saDevice.power = buf[3];
         saDevice.mode = buf[4];
         saDevice.freq = (buf[5] << 8)|buf[6];
+        sa_confirmed = (sa_outstanding == SA_CMD_NONE) && saQueueEmpty();
 
 #ifdef SMARTAUDIO_DEBUG_MONITOR
         debug[0] = saDevice.version * 100 + saDevice.mode;
@@ -467,7 +450,7 @@ static void saReceiveFramer(uint8_t c)
         break;
 
     case S_WAITCRC:
-        if (CRC8(sa_rbuf, 2 + len) == c) {
+        if (crc8_dvb_s2_update(0, sa_rbuf, 2 + len) == c) {
             // Got a response
             saProcessResponse(sa_rbuf, len + 2);
             saStat.pktrcvd++;
@@ -485,14 +468,14 @@ static void saReceiveFramer(uint8_t c)
 
 static void saSendFrame(uint8_t *buf, int len)
 {
-    int i;
-
-    serialWrite(smartAudioSerialPort, 0x00); // Generate 1st start bit
+    uint8_t frame[sizeof(sa_osbuf) + 2];
 
-    for (i = 0 ; i < len ; i++)
-        serialWrite(smartAudioSerialPort, buf[i]);
+    // Whole frame in one write, a UART with TX DMA sends it without further interrupts
+    frame[0] = 0x00; // Generate 1st start bit
+    memcpy(&frame[1], buf, len);
+    frame[len + 1] = 0x00; // XXX Probably don't need this
 
-    serialWrite(smartAudioSerialPort, 0x00); // XXX Probably don't need this
+    serialWriteBuf(smartAudioSerialPort, frame, len + 2);
 
     sa_lastTransmission = millis();
     saStat.pktsent++;
@@ -532,6 +515,7 @@ static void saSendCmd(uint8_t *buf, int len)
 
     sa_oslen = len;
     sa_outstanding = (buf[2] >> 1);
+    sa_resends = 0;
 
     saSendFrame(sa_osbuf, sa_oslen);
 }
@@ -574,6 +558,11 @@ static void saQueueCmd(uint8_t *buf, int len)
     if (saQueueFull())
          return;
 
+    if (buf[2] != SACMD(SA_CMD_GET_SETTINGS)) {
+        // A change, poll fast until it has been read back
+        sa_confirmed = false;
+    }
+
     sa_queue[sa_qhead].buf = buf;
     sa_queue[sa_qhead].len = len;
     sa_qhead = (sa_qhead + 1) % SA_QSIZE;
@@ -611,7 +600,7 @@ static void saSetFreq(uint16_t freq)
 
     buf[4] = (freq >> 8) & 0xff;
     buf[5] = freq & 0xff;
-    buf[6] = CRC8(buf, 6);
+    buf[6] = crc8_dvb_s2_update(0, buf, 6);
 
     saQueueCmd(buf, 7);
 }
@@ -633,7 +622,7 @@ void saSetBandAndChannel(uint8_t band, uint8_t channel)
     static uint8_t buf[6] = { 0xAA, 0x55, SACMD(SA_CMD_SET_CHAN), 1 };
 
     buf[4] = band * 8 + channel;
-    buf[5] = CRC8(buf, 5);
+    buf[5] = crc8_dvb_s2_update(0, buf, 5);
 
     saQueueCmd(buf, 6);
 }
@@ -643,7 +632,7 @@ static void saSetMode(int mode)
     static uint8_t buf[6] = { 0xAA, 0x55, SACMD(SA_CMD_SET_MODE), 1 };
 
     buf[4] = (mode & 0x3f)|saLockMode;
-    buf[5] = CRC8(buf, 5);
+    buf[5] = crc8_dvb_s2_update(0, buf, 5);
 
     saQueueCmd(buf, 6);
 }
@@ -663,7 +652,7 @@ void saSetPowerByIndex(uint8_t index)
         return;
 
     buf[4] = (saDevice.version == 1) ? saPowerTable[index].valueV1 : saPowerTable[index].valueV2;
-    buf[5] = CRC8(buf, 5);
+    buf[5] = crc8_dvb_s2_update(0, buf, 5);
     saQueueCmd(buf, 6);
 }
 
@@ -693,16 +682,20 @@ bool vtxSmartAudioInit()
     return true;
 }
 
-void vtxSAProcess(uint32_t now)
+void vtxSAProcess(uint32_t currentTimeUs)
 {
     static char initPhase = 0;
+    const uint32_t now = currentTimeUs / 1000; // the transport timing is in ms
 
     if (smartAudioSerialPort == NULL)
         return;
 
-    while (serialRxBytesWaiting(smartAudioSerialPort) > 0) {
-        uint8_t c = serialRead(smartAudioSerialPort);
-        saReceiveFramer((uint16_t)c);
+    uint8_t rxBuf[SA_MAX_RCVLEN];
+    uint32_t count;
+    while ((count = serialReadBuf(smartAudioSerialPort, rxBuf, sizeof(rxBuf))) > 0) {
+        for (uint32_t i = 0; i < count; i++) {
+            saReceiveFramer(rxBuf[i]);
+        }
     }
 
     // Re-evaluate baudrate after each frame reception
@@ -728,13 +721,19 @@ void vtxSAProcess(uint32_t now)
             && (now - sa_lastTransmission > SMARTAUDIO_CMD_TIMEOUT)) {
         // Last command timed out
         // dprintf(("process: resending 0x%x\r\n", sa_outstanding));
-        // XXX Todo: Resend termination and possible offline transition
-        saResendCmd();
+        // XXX Todo: Possible offline transition
+        sa_confirmed = false;
+        if (sa_resends++ < SMARTAUDIO_MAX_RESENDS) {
+            saResendCmd();
+        } else {
+            // Give up on it, the heart beat finds out whether the device is still there
+            sa_outstanding = SA_CMD_NONE;
+        }
     } else if (!saQueueEmpty()) {
         // Command pending. Send it.
         // dprintf(("process: sending queue\r\n"));
         saSendQueue();
-    } else if (now - sa_lastTransmission >= 1000) {
+    } else if (now - sa_lastTransmission >= (sa_confirmed ? SMARTAUDIO_IDLE_POLLING_INTERVAL : SMARTAUDIO_POLLING_INTERVAL)) {
         // Heart beat for autobauding
         //dprintf(("process: sending heartbeat\r\n"));
         saGetSettings();
@@ -92,6 +92,12 @@ uint8_t trampPitMode = 0;
 // Maximum number of requests sent to try a config change
 #define TRAMP_MAX_RETRIES 2
 
+// Status query intervals, the device is polled fast only until it has reported its settings after a change
+#define TRAMP_QUERY_INTERVAL_US         (1000 * 1000)
+#define TRAMP_IDLE_QUERY_INTERVAL_US    (10 * 1000 * 1000)
+
+static bool trampSettled = false;
+
 uint32_t trampConfFreq = 0;
 uint8_t  trampFreqRetries = 0;
 
@@ -166,12 +172,14 @@ bool trampCommitChanges()
     if (trampStatus != TRAMP_STATUS_ONLINE)
         return false;
 
+    trampSettled = false;
     trampStatus = TRAMP_STATUS_SET_FREQ_PW;
     return true;
 }
 
 void trampSetPitMode(uint8_t onoff)
 {
+    trampSettled = false;
     trampCmdU16('I', onoff ? 0 : 1);
 }
 
@@ -259,8 +267,12 @@ static char trampReceive(uint32_t currentTimeUs)
     if (!trampSerialPort)
         return 0;
 
-    while (serialRxBytesWaiting(trampSerialPort)) {
-        uint8_t c = serialRead(trampSerialPort);
+    // Never more than what completes the frame under way, anything after it is left for the next call
+    uint8_t rxBuf[sizeof(trampRespBuffer)];
+    const uint32_t count = serialReadBuf(trampSerialPort, rxBuf, sizeof(trampRespBuffer) - trampReceivePos);
+
+    for (uint32_t i = 0; i < count; i++) {
+        uint8_t c = rxBuf[i];
         trampRespBuffer[trampReceivePos++] = c;
 
         switch (trampReceiveState) {
@@ -348,6 +360,8 @@ void vtxTrampProcess(uint32_t currentTimeUs)
     case 'v':
          if (trampStatus == TRAMP_STATUS_CHECK_FREQ_PW)
              trampStatus = TRAMP_STATUS_SET_FREQ_PW;
+         else if (trampStatus == TRAMP_STATUS_ONLINE)
+             trampSettled = true;
          break;
     }
 
@@ -355,7 +369,7 @@ void vtxTrampProcess(uint32_t currentTimeUs)
 
     case TRAMP_STATUS_OFFLINE:
     case TRAMP_STATUS_ONLINE:
-        if (cmp32(currentTimeUs, lastQueryTimeUs) > 1000 * 1000) { // 1s
+        if (cmp32(currentTimeUs, lastQueryTimeUs) > (trampSettled ? TRAMP_IDLE_QUERY_INTERVAL_US : TRAMP_QUERY_INTERVAL_US)) {
 
             if (trampStatus == TRAMP_STATUS_OFFLINE)
                 trampQueryR();
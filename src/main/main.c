@@ -29,10 +29,14 @@ int main(void)
 {
     init();
     while (true) {
+#ifdef SIMULATOR_LOCKSTEP
+        simulatorStep();
+#else
         scheduler();
         processLoopback();
 #ifdef SIMULATOR_BUILD
         delayMicroseconds_real(50); // max rate 20kHz
+#endif
 #endif
     }
     return 0;
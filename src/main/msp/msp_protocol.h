@@ -222,6 +222,7 @@
 
 // External OSD displayport mode messages
 #define MSP_DISPLAYPORT                 182
+#define MSP_DISPLAYPORT_FRAME_ACK       5   // MSP_DISPLAYPORT subcommand from an OSD slave, a frame has been drawn and the next can follow
 
 //
 // Multwii original MSP commands
@@ -305,7 +306,17 @@
 
 // Additional commands that are not compatible with MultiWii
 #define MSP_STATUS_EX            150    //out message         cycletime, errors_count, CPU load, sensor present etc
+#define MSP_TASK_HISTOGRAM       151    //out message         execution time and lateness histograms of a task
+#define MSP_CYCLE_TRACE          152    //out message         drains the cycle counter trace buffer
+#define MSP_MEMORY_STATS         153    //out message         static RAM use, stack size and per task peak stack usage
+#define MSP_BLACKBOX_STREAM      154    //out message         pushed while logging to blackbox_device MSP: sequence number and log bytes
+#define MSP_DATAFLASH_STREAM     155    //in message          stream a range of dataflash as MSP_DATAFLASH_READ replies until another command arrives
+#define MSP_SDCARD_STATS         156    //out message         SD card block write latency and busy time histograms, write rate and cache size
+#define MSP_EEPROM_WRITE_STATUS  157    //out message         1 while a config save started by MSP_EEPROM_WRITE is being written, 0 when done
+#define MSP_PG_READ              158    //in/out message      parameter groups by PGN (all if none given) as PGN, version, size and contents, see mspFcPgReadCommand()
+#define MSP_SET_PG               159    //in message          parameter groups as sent by MSP_PG_READ, all applied or none
 #define MSP_UID                  160    //out message         Unique device ID
+#define MSP_PERF_RECORD          161    //out message         flights, flights with errors, then the last and the worst flight's timing and error counters
 #define MSP_GPSSVINFO            164    //out message         get Signal Strength (only U-Blox)
 #define MSP_GPSSTATISTICS        166    //out message         get GPS debugging data
 #define MSP_ACC_TRIM             240    //out message         get acc angle trim values
@@ -21,17 +21,34 @@
 
 #include "platform.h"
 
+#include "common/crc.h"
+#include "common/maths.h"
 #include "common/streambuf.h"
 #include "common/utils.h"
 #include "build/debug.h"
 
+#include "drivers/time.h"
+
 #include "io/serial.h"
 
 #include "msp/msp.h"
+#include "msp/msp_protocol.h"
 #include "msp/msp_serial.h"
 
 static mspPort_t mspPorts[MAX_MSP_PORT_COUNT];
 
+// For replies to ports that can't be written in place, see mspSerialStartReply()
+static uint8_t mspSerialOutBuf[MSP_PORT_OUTBUF_SIZE];
+
+// Set by a command handler with mspSerialStartStream(), for the port the command came from
+static mspStreamFnPtr mspStreamToStart;
+
+// How long the ports may spend between them sending stream packets each time the ports are processed
+#define MSP_STREAM_TIME_BUDGET_US 5000
+
+// Port whose stream goes first next time, so that no port is always left with what the others did not use
+static uint8_t mspStreamFirstPortIndex;
+
 static void resetMspPort(mspPort_t *mspPortToReset, serialPort_t *serialPort)
 {
     memset(mspPortToReset, 0, sizeof(mspPort_t));
@@ -80,26 +97,41 @@ static bool mspSerialProcessReceivedData(mspPort_t *mspPort, uint8_t c)
             return false;
         }
     } else if (mspPort->c_state == MSP_HEADER_START) {
-        mspPort->c_state = (c == 'M') ? MSP_HEADER_M : MSP_IDLE;
-    } else if (mspPort->c_state == MSP_HEADER_M) {
+        switch (c) {
+            case 'M':
+                mspPort->mspVersion = MSP_V1;
+                mspPort->c_state = MSP_HEADER_M;
+                break;
+            case 'X':
+                mspPort->mspVersion = MSP_V2;
+                mspPort->c_state = MSP_HEADER_X;
+                break;
+            default:
+                mspPort->c_state = MSP_IDLE;
+                break;
+        }
+    } else if (mspPort->c_state == MSP_HEADER_M || mspPort->c_state == MSP_HEADER_X) {
+        const mspState_e next = (mspPort->c_state == MSP_HEADER_M) ? MSP_HEADER_ARROW : MSP_HEADER_V2;
         mspPort->c_state = MSP_IDLE;
         switch (c) {
             case '<': // COMMAND
                 mspPort->packetType = MSP_PACKET_COMMAND;
-                mspPort->c_state = MSP_HEADER_ARROW;
+                mspPort->c_state = next;
                 break;
             case '>': // REPLY
                 mspPort->packetType = MSP_PACKET_REPLY;
-                mspPort->c_state = MSP_HEADER_ARROW;
+                mspPort->c_state = next;
                 break;
             default:
                 break;
         }
+        mspPort->offset = 0;
+        mspPort->checksum = 0;
     } else if (mspPort->c_state == MSP_HEADER_ARROW) {
-        if (c > MSP_PORT_INBUF_SIZE) {
+        mspPort->dataSize = c;
+        if (mspPort->dataSize > MSP_PORT_INBUF_SIZE) {
             mspPort->c_state = MSP_IDLE;
         } else {
-            mspPort->dataSize = c;
             mspPort->offset = 0;
             mspPort->checksum = 0;
             mspPort->checksum ^= c;
@@ -118,6 +150,32 @@ static bool mspSerialProcessReceivedData(mspPort_t *mspPort, uint8_t c)
         } else {
             mspPort->c_state = MSP_IDLE;
         }
+    } else if (mspPort->c_state == MSP_HEADER_V2) {
+        // flags, then the command and payload size, both little endian
+        mspPort->checksum = crc8_dvb_s2(mspPort->checksum, c);
+        mspPort->headerV2[mspPort->offset++] = c;
+        if (mspPort->offset == sizeof(mspPort->headerV2)) {
+            mspPort->cmdMSP = mspPort->headerV2[1] | (mspPort->headerV2[2] << 8);
+            mspPort->dataSize = mspPort->headerV2[3] | (mspPort->headerV2[4] << 8);
+            mspPort->offset = 0;
+            if (mspPort->dataSize > MSP_PORT_INBUF_SIZE) {
+                mspPort->c_state = MSP_IDLE;
+            } else {
+                mspPort->c_state = mspPort->dataSize > 0 ? MSP_PAYLOAD_V2 : MSP_CHECKSUM_V2;
+            }
+        }
+    } else if (mspPort->c_state == MSP_PAYLOAD_V2) {
+        mspPort->checksum = crc8_dvb_s2(mspPort->checksum, c);
+        mspPort->inBuf[mspPort->offset++] = c;
+        if (mspPort->offset == mspPort->dataSize) {
+            mspPort->c_state = MSP_CHECKSUM_V2;
+        }
+    } else if (mspPort->c_state == MSP_CHECKSUM_V2) {
+        if (mspPort->checksum == c) {
+            mspPort->c_state = MSP_COMMAND_RECEIVED;
+        } else {
+            mspPort->c_state = MSP_IDLE;
+        }
     }
     return true;
 }
@@ -132,46 +190,121 @@ static uint8_t mspSerialChecksumBuf(uint8_t checksum, const uint8_t *data, int l
 
 #define JUMBO_FRAME_SIZE_LIMIT 255
 
-static int mspSerialEncode(mspPort_t *msp, mspPacket_t *packet)
+#define MSP_V1_HEADER_SIZE 5        // '$', 'M', direction, size, command
+#define MSP_V1_JUMBO_HEADER_SIZE 7  // with the 16 bit size after the command
+#define MSP_V2_HEADER_SIZE 8        // '$', 'X', direction, flags, 16 bit command, 16 bit size
+#define MSP_MAX_HEADER_SIZE MSP_V2_HEADER_SIZE
+#define MSP_CHECKSUM_SIZE 1
+#define CHECKSUM_STARTPOS 3         // checksum starts from the field after the direction
+
+static int mspSerialHeaderSize(mspVersion_e mspVersion, int len)
+{
+    if (mspVersion == MSP_V2) {
+        return MSP_V2_HEADER_SIZE;
+    }
+    return len < JUMBO_FRAME_SIZE_LIMIT ? MSP_V1_HEADER_SIZE : MSP_V1_JUMBO_HEADER_SIZE;
+}
+
+// Writes the header for a payload of len bytes to hdr, and returns its size
+static int mspSerialWriteHeader(uint8_t *hdr, const mspPacket_t *packet, int len, mspVersion_e mspVersion)
+{
+    hdr[0] = '$';
+    hdr[1] = mspVersion == MSP_V2 ? 'X' : 'M';
+    hdr[2] = packet->result == MSP_RESULT_ERROR ? '!' : packet->direction == MSP_DIRECTION_REPLY ? '>' : '<';
+    if (mspVersion == MSP_V2) {
+        hdr[3] = 0; // flags
+        hdr[4] = packet->cmd & 0xff;
+        hdr[5] = (packet->cmd >> 8) & 0xff;
+        hdr[6] = len & 0xff;
+        hdr[7] = (len >> 8) & 0xff;
+    } else {
+        hdr[3] = len < JUMBO_FRAME_SIZE_LIMIT ? len : JUMBO_FRAME_SIZE_LIMIT;
+        hdr[4] = packet->cmd;
+        if (len >= JUMBO_FRAME_SIZE_LIMIT) {
+            hdr[5] = len & 0xff;
+            hdr[6] = (len >> 8) & 0xff;
+        }
+    }
+    return mspSerialHeaderSize(mspVersion, len);
+}
+
+static uint8_t mspSerialChecksum(mspVersion_e mspVersion, uint8_t checksum, const uint8_t *data, int len)
+{
+    return mspVersion == MSP_V2 ? crc8_dvb_s2_update(checksum, data, len) : mspSerialChecksumBuf(checksum, data, len);
+}
+
+static int mspSerialEncode(mspPort_t *msp, mspPacket_t *packet, mspVersion_e mspVersion)
 {
     serialBeginWrite(msp->port);
     const int len = sbufBytesRemaining(&packet->buf);
-    const int mspLen = len < JUMBO_FRAME_SIZE_LIMIT ? len : JUMBO_FRAME_SIZE_LIMIT;
-    uint8_t hdr[8] = {
-        '$',
-        'M',
-        packet->result == MSP_RESULT_ERROR ? '!' : packet->direction == MSP_DIRECTION_REPLY ? '>' : '<',
-        mspLen,
-        packet->cmd
-    };
-    int hdrLen = 5;
-#define CHECKSUM_STARTPOS 3  // checksum starts from mspLen field
-    if (len >= JUMBO_FRAME_SIZE_LIMIT) {
-        hdrLen += 2;
-        hdr[5] = len & 0xff;
-        hdr[6] = (len >> 8) & 0xff;
-    }
+    uint8_t hdr[MSP_MAX_HEADER_SIZE];
+    const int hdrLen = mspSerialWriteHeader(hdr, packet, len, mspVersion);
     serialWriteBuf(msp->port, hdr, hdrLen);
-    uint8_t checksum = mspSerialChecksumBuf(0, hdr + CHECKSUM_STARTPOS, hdrLen - CHECKSUM_STARTPOS);
+    uint8_t checksum = mspSerialChecksum(mspVersion, 0, hdr + CHECKSUM_STARTPOS, hdrLen - CHECKSUM_STARTPOS);
     if (len > 0) {
         serialWriteBuf(msp->port, sbufPtr(&packet->buf), len);
-        checksum = mspSerialChecksumBuf(checksum, sbufPtr(&packet->buf), len);
+        checksum = mspSerialChecksum(mspVersion, checksum, sbufPtr(&packet->buf), len);
     }
-    serialWriteBuf(msp->port, &checksum, 1);
+    serialWriteBuf(msp->port, &checksum, MSP_CHECKSUM_SIZE);
     serialEndWrite(msp->port);
-    return sizeof(hdr) + len + 1; // header, data, and checksum
+    return hdrLen + len + MSP_CHECKSUM_SIZE;
 }
 
-static mspPostProcessFnPtr mspSerialProcessReceivedCommand(mspPort_t *msp, mspProcessCommandFnPtr mspProcessCommandFn)
+/*
+ * Points buf at the port's transmit buffer, for the reply to be written where it is sent from, when the port allows
+ * it and there is room for any reply in one piece. Otherwise points buf at mspSerialOutBuf and returns NULL.
+ * Returns where the frame starts in the transmit buffer, for mspSerialEncodeInPlace().
+ */
+static uint8_t *mspSerialStartReply(mspPort_t *msp, sbuf_t *buf)
 {
-    static uint8_t outBuf[MSP_PORT_OUTBUF_SIZE];
+    uint8_t *txBuf;
+    const uint32_t txSpace = serialReserveWrite(msp->port, &txBuf);
+
+    if (txSpace < MSP_MAX_HEADER_SIZE + MSP_PORT_MIN_REPLY_SIZE + MSP_CHECKSUM_SIZE) {
+        buf->ptr = mspSerialOutBuf;
+        buf->end = ARRAYEND(mspSerialOutBuf);
+        return NULL;
+    }
 
+    // The payload goes after the usual header, leaving room to move it up if it needs the larger v1 jumbo header
+    const int hdrLen = mspSerialHeaderSize(msp->mspVersion, 0);
+    buf->ptr = txBuf + hdrLen;
+    buf->end = txBuf + txSpace - MSP_CHECKSUM_SIZE - (MSP_MAX_HEADER_SIZE - hdrLen);
+    return txBuf;
+}
+
+// Puts the header and checksum around a payload written by mspSerialStartReply(), and sends the frame.
+static void mspSerialEncodeInPlace(mspPort_t *msp, mspPacket_t *packet, mspVersion_e mspVersion, uint8_t *txBuf)
+{
+    const int len = sbufBytesRemaining(&packet->buf);
+    const int hdrLen = mspSerialHeaderSize(mspVersion, len);
+    if (sbufPtr(&packet->buf) != txBuf + hdrLen) {
+        // Only a jumbo v1 reply gets here
+        memmove(txBuf + hdrLen, sbufPtr(&packet->buf), len);
+    }
+    mspSerialWriteHeader(txBuf, packet, len, mspVersion);
+    txBuf[hdrLen + len] = mspSerialChecksum(mspVersion, 0, txBuf + CHECKSUM_STARTPOS, hdrLen + len - CHECKSUM_STARTPOS);
+    serialCommitWrite(msp->port, hdrLen + len + MSP_CHECKSUM_SIZE);
+}
+
+static void mspSerialFinishReply(mspPort_t *msp, mspPacket_t *packet, uint8_t *replyHead, uint8_t *txBuf)
+{
+    sbufSwitchToReader(&packet->buf, replyHead); // change streambuf direction
+    if (txBuf) {
+        mspSerialEncodeInPlace(msp, packet, msp->mspVersion, txBuf);
+    } else {
+        mspSerialEncode(msp, packet, msp->mspVersion);
+    }
+}
+
+static mspPostProcessFnPtr mspSerialProcessReceivedCommand(mspPort_t *msp, mspProcessCommandFnPtr mspProcessCommandFn)
+{
     mspPacket_t reply = {
-        .buf = { .ptr = outBuf, .end = ARRAYEND(outBuf), },
         .cmd = -1,
         .result = 0,
         .direction = MSP_DIRECTION_REPLY,
     };
+    uint8_t *txBuf = mspSerialStartReply(msp, &reply.buf);
     uint8_t *outBufHead = reply.buf.ptr;
 
     mspPacket_t command = {
@@ -185,13 +318,51 @@ static mspPostProcessFnPtr mspSerialProcessReceivedCommand(mspPort_t *msp, mspPr
     const mspResult_e status = mspProcessCommandFn(&command, &reply, &mspPostProcessFn);
 
     if (status != MSP_RESULT_NO_REPLY) {
-        sbufSwitchToReader(&reply.buf, outBufHead); // change streambuf direction
-        mspSerialEncode(msp, &reply);
+        mspSerialFinishReply(msp, &reply, outBufHead, txBuf);
     }
 
+    // Any command ends the stream a port is sending, unless it starts a new one
+    msp->streamFn = mspStreamToStart;
+    mspStreamToStart = NULL;
+
     return mspPostProcessFn;
 }
 
+/*
+ * Send the packets of the port's stream while the transmit buffer is empty, for up to budgetUs, so the stream runs as
+ * fast as the link rather than at one packet per request.
+ */
+static void mspSerialProcessStream(mspPort_t *msp, timeDelta_t budgetUs)
+{
+    const timeUs_t startTimeUs = micros();
+
+    while (isSerialTransmitBufferEmpty(msp->port) && cmpTimeUs(micros(), startTimeUs) < budgetUs) {
+        mspPacket_t packet = {
+            .cmd = -1,
+            .result = 0,
+            .direction = MSP_DIRECTION_REPLY,
+        };
+        uint8_t *txBuf = mspSerialStartReply(msp, &packet.buf);
+        uint8_t *outBufHead = packet.buf.ptr;
+
+        if (!msp->streamFn(&packet)) {
+            msp->streamFn = NULL;
+            return;
+        }
+
+        mspSerialFinishReply(msp, &packet, outBufHead, txBuf);
+    }
+}
+
+/*
+ * Called by a command handler to have the port the command came from send the packets streamFn makes, after the reply,
+ * until streamFn returns false or another command arrives on the port.
+ */
+void mspSerialStartStream(mspStreamFnPtr streamFn)
+{
+    mspStreamToStart = streamFn;
+}
+
 
 static void mspSerialProcessReceivedReply(mspPort_t *msp, mspProcessReplyFnPtr mspProcessReplyFn)
 {
@@ -209,49 +380,91 @@ static void mspSerialProcessReceivedReply(mspPort_t *msp, mspProcessReplyFnPtr m
     msp->c_state = MSP_IDLE;
 }
 
+// Commands that keep something running in real time, handled before the other commands received at the same time
+static bool mspSerialIsPriorityCommand(uint16_t cmd)
+{
+    return cmd == MSP_SET_RAW_RC || cmd == MSP_DISPLAYPORT;
+}
+
 /*
  * Process MSP commands from serial ports configured as MSP ports.
  *
- * Called periodically by the scheduler.
+ * Called periodically by the scheduler. Every port gets to have one frame handled per call, RC and displayport frames
+ * first, so traffic on one port is not held up by another. Streams, which is how long transfers are split over many
+ * calls, come last and share MSP_STREAM_TIME_BUDGET_US.
  */
 void mspSerialProcess(mspEvaluateNonMspData_e evaluateNonMspData, mspProcessCommandFnPtr mspProcessCommandFn, mspProcessReplyFnPtr mspProcessReplyFn)
 {
+    // Read up to the end of the next frame on every port
     for (uint8_t portIndex = 0; portIndex < MAX_MSP_PORT_COUNT; portIndex++) {
         mspPort_t * const mspPort = &mspPorts[portIndex];
         if (!mspPort->port) {
             continue;
         }
 
-        mspPostProcessFnPtr mspPostProcessFn = NULL;
-
-        while (serialRxBytesWaiting(mspPort->port)) {
-
+        while (mspPort->c_state != MSP_COMMAND_RECEIVED && serialRxBytesWaiting(mspPort->port)) {
             const uint8_t c = serialRead(mspPort->port);
             const bool consumed = mspSerialProcessReceivedData(mspPort, c);
 
             if (!consumed && evaluateNonMspData == MSP_EVALUATE_NON_MSP_DATA) {
                 serialEvaluateNonMspData(mspPort->port, c);
             }
+        }
+    }
 
-            if (mspPort->c_state == MSP_COMMAND_RECEIVED) {
-                if (mspPort->packetType == MSP_PACKET_COMMAND) {
-                    mspPostProcessFn = mspSerialProcessReceivedCommand(mspPort, mspProcessCommandFn);
-                } else if (mspPort->packetType == MSP_PACKET_REPLY) {
-                    mspSerialProcessReceivedReply(mspPort, mspProcessReplyFn);
-                }
+    mspPostProcessFnPtr mspPostProcessFns[MAX_MSP_PORT_COUNT] = { NULL };
 
-                mspPort->c_state = MSP_IDLE;
-                break; // process one command at a time so as not to block.
+    for (int priorityPass = 0; priorityPass < 2; priorityPass++) {
+        for (uint8_t portIndex = 0; portIndex < MAX_MSP_PORT_COUNT; portIndex++) {
+            mspPort_t * const mspPort = &mspPorts[portIndex];
+            if (!mspPort->port || mspPort->c_state != MSP_COMMAND_RECEIVED) {
+                continue;
             }
+            if (priorityPass == 0 && !mspSerialIsPriorityCommand(mspPort->cmdMSP)) {
+                continue;
+            }
+
+            if (mspPort->packetType == MSP_PACKET_COMMAND) {
+                mspPostProcessFns[portIndex] = mspSerialProcessReceivedCommand(mspPort, mspProcessCommandFn);
+            } else if (mspPort->packetType == MSP_PACKET_REPLY) {
+                mspSerialProcessReceivedReply(mspPort, mspProcessReplyFn);
+            }
+
+            mspPort->c_state = MSP_IDLE;
+        }
+    }
+
+    int streamingPortCount = 0;
+    for (uint8_t portIndex = 0; portIndex < MAX_MSP_PORT_COUNT; portIndex++) {
+        mspPort_t * const mspPort = &mspPorts[portIndex];
+        if (!mspPort->port) {
+            continue;
         }
 
-        if (mspPostProcessFn) {
+        if (mspPostProcessFns[portIndex]) {
             waitForSerialPortToFinishTransmitting(mspPort->port);
-            mspPostProcessFn(mspPort->port);
+            mspPostProcessFns[portIndex](mspPort->port);
+        } else if (mspPort->streamFn && mspPort->c_state == MSP_IDLE) {
+            streamingPortCount++;
+        }
+    }
+
+    if (streamingPortCount == 0) {
+        return;
+    }
+
+    const timeDelta_t streamBudgetUs = MSP_STREAM_TIME_BUDGET_US / streamingPortCount;
+    for (uint8_t i = 0; i < MAX_MSP_PORT_COUNT; i++) {
+        const uint8_t portIndex = (mspStreamFirstPortIndex + i) % MAX_MSP_PORT_COUNT;
+        mspPort_t * const mspPort = &mspPorts[portIndex];
+        if (mspPort->port && !mspPostProcessFns[portIndex] && mspPort->streamFn && mspPort->c_state == MSP_IDLE) {
+            mspSerialProcessStream(mspPort, streamBudgetUs);
         }
     }
+    mspStreamFirstPortIndex = (mspStreamFirstPortIndex + 1) % MAX_MSP_PORT_COUNT;
 }
 
+// Returns true if any port has received data to process or a stream to send
 bool mspSerialWaiting(void)
 {
     for (uint8_t portIndex = 0; portIndex < MAX_MSP_PORT_COUNT; portIndex++) {
@@ -260,7 +473,7 @@ bool mspSerialWaiting(void)
             continue;
         }
 
-        if (serialRxBytesWaiting(mspPort->port)) {
+        if (serialRxBytesWaiting(mspPort->port) || mspPort->streamFn) {
             return true;
         }
     }
@@ -295,11 +508,56 @@ int mspSerialPush(uint8_t cmd, uint8_t *data, int datalen, mspDirection_e direct
             .direction = direction,
         };
 
-        ret = mspSerialEncode(mspPort, &push);
+        ret = mspSerialEncode(mspPort, &push, MSP_V1);
     }
     return ret; // return the number of bytes written
 }
 
+/*
+ * As mspSerialPush(), but for data streamed while flying: the USB VCP is included, and ports that don't have room for
+ * the whole packet are skipped, so a port nobody is reading neither stalls the caller nor gets a packet cut short.
+ */
+int mspSerialPushStream(uint8_t cmd, uint8_t *data, int datalen)
+{
+    int ret = 0;
+
+    for (int portIndex = 0; portIndex < MAX_MSP_PORT_COUNT; portIndex++) {
+        mspPort_t * const mspPort = &mspPorts[portIndex];
+        if (!mspPort->port) {
+            continue;
+        }
+
+        // header, data and checksum, as written by mspSerialEncode()
+        if (serialTxBytesFree(mspPort->port) < (uint32_t)(MSP_MAX_HEADER_SIZE + datalen + MSP_CHECKSUM_SIZE)) {
+            continue;
+        }
+
+        mspPacket_t push = {
+            .buf = { .ptr = data, .end = data + datalen, },
+            .cmd = cmd,
+            .result = 0,
+            .direction = MSP_DIRECTION_REPLY,
+        };
+
+        ret = mspSerialEncode(mspPort, &push, MSP_V1);
+    }
+    return ret; // return the number of bytes written
+}
+
+// The most room on any of the ports mspSerialPushStream() writes to
+uint32_t mspSerialStreamTxBytesFree(void)
+{
+    uint32_t ret = 0;
+
+    for (int portIndex = 0; portIndex < MAX_MSP_PORT_COUNT; portIndex++) {
+        const mspPort_t * const mspPort = &mspPorts[portIndex];
+        if (mspPort->port) {
+            ret = MAX(ret, serialTxBytesFree(mspPort->port));
+        }
+    }
+
+    return ret;
+}
 
 uint32_t mspSerialTxBytesFree()
 {
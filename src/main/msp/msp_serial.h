@@ -29,9 +29,18 @@ typedef enum {
     MSP_HEADER_ARROW,
     MSP_HEADER_SIZE,
     MSP_HEADER_CMD,
+    MSP_HEADER_X,
+    MSP_HEADER_V2,          // receiving the flags, command and size of an MSP v2 frame
+    MSP_PAYLOAD_V2,
+    MSP_CHECKSUM_V2,
     MSP_COMMAND_RECEIVED
 } mspState_e;
 
+typedef enum {
+    MSP_V1,                 // "$M", 8 bit command and size, XOR checksum
+    MSP_V2,                 // "$X", 16 bit command and size, CRC8 DVB-S2
+} mspVersion_e;
+
 typedef enum {
     MSP_PACKET_COMMAND,
     MSP_PACKET_REPLY
@@ -42,7 +51,11 @@ typedef enum {
     MSP_SKIP_NON_MSP_DATA
 } mspEvaluateNonMspData_e;
 
+#if defined(STM32F4) || defined(STM32F7)
+#define MSP_PORT_INBUF_SIZE 1024    // room for several parameter groups in one MSP_SET_PG
+#else
 #define MSP_PORT_INBUF_SIZE 192
+#endif
 #ifdef USE_FLASHFS
 #ifdef STM32F1
 #define MSP_PORT_DATAFLASH_BUFFER_SIZE 1024
@@ -54,16 +67,21 @@ typedef enum {
 #else
 #define MSP_PORT_OUTBUF_SIZE 256
 #endif
+// Room a handler can count on without checking, replies are written in place in a transmit buffer with at least this much
+#define MSP_PORT_MIN_REPLY_SIZE 256
 
 struct serialPort_s;
 typedef struct mspPort_s {
     struct serialPort_s *port; // null when port unused.
-    uint8_t offset;
-    uint8_t dataSize;
+    uint16_t offset;
+    uint16_t dataSize;
     uint8_t checksum;
-    uint8_t cmdMSP;
+    uint16_t cmdMSP;
     mspState_e c_state;
     mspPacketType_e packetType;
+    mspVersion_e mspVersion;   // of the last command received, replies and streams use the same
+    uint8_t headerV2[5];       // flags, command and size of an MSP v2 frame
+    mspStreamFnPtr streamFn; // null when the port isn't streaming
     uint8_t inBuf[MSP_PORT_INBUF_SIZE];
 } mspPort_t;
 
@@ -74,3 +92,6 @@ void mspSerialAllocatePorts(void);
 void mspSerialReleasePortIfAllocated(struct serialPort_s *serialPort);
 int mspSerialPush(uint8_t cmd, uint8_t *data, int datalen, mspDirection_e direction);
 uint32_t mspSerialTxBytesFree(void);
+int mspSerialPushStream(uint8_t cmd, uint8_t *data, int datalen);
+uint32_t mspSerialStreamTxBytesFree(void);
+void mspSerialStartStream(mspStreamFnPtr streamFn);
@@ -138,7 +138,7 @@ void init(void)
 
     systemState |= SYSTEM_STATE_CONFIG_LOADED;
 
-    debugMode = systemConfig()->debug_mode;
+    debugInit(systemConfig()->debug_modes, DEBUG_MODE_SLOT_COUNT);
 
     // Latch active features to be used for feature() in the remainder of init().
     latchActiveFeatures();
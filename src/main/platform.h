@@ -102,3 +102,25 @@
 #include "target.h"
 #include "target/common_fc_post.h"
 #endif
+
+// Code run every loop, copied to the ITCM RAM at startup so it runs without flash wait states
+#ifdef USE_ITCM_RAM
+#define FAST_CODE                   __attribute__((section(".tcm_code")))
+#else
+#define FAST_CODE
+#endif
+
+// Data used every loop, in the CCM or DTCM RAM. The section is zeroed at startup, so only for data without an initialiser
+#ifdef USE_FAST_RAM
+#define FAST_RAM                    __attribute__((section(".fastram_bss"), aligned(4)))
+#else
+#define FAST_RAM
+#endif
+
+// Buffers a DMA stream reads or writes, in a region the data cache leaves alone so they need no cache maintenance.
+// Zeroed at startup like FAST_RAM
+#ifdef USE_DMA_RAM
+#define DMA_RAM                     __attribute__((section(".dmaram_bss"), aligned(32)))
+#else
+#define DMA_RAM
+#endif
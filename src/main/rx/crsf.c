@@ -27,6 +27,7 @@
 #include "build/build_config.h"
 #include "build/debug.h"
 
+#include "common/crc.h"
 #include "common/maths.h"
 #include "common/utils.h"
 
@@ -37,10 +38,17 @@
 #include "io/serial.h"
 
 #include "rx/rx.h"
+#include "rx/rx_channels.h"
 #include "rx/crsf.h"
 
-#define CRSF_TIME_NEEDED_PER_FRAME_US   1000
 #define CRSF_TIME_BETWEEN_FRAMES_US     4000 // a frame is sent by the transmitter every 4 milliseconds
+#define CRSF_BAUDRATE_FALLBACK_ERRORS   25   // frames failing their CRC in a row before a negotiated rate is given up
+
+// time needed to receive the longest frame, 10 bits a byte, rounded up to the next 100us
+#define CRSF_TIME_NEEDED_PER_FRAME_US(baudRate) ((CRSF_FRAME_SIZE_MAX * 10 * 1000000 / (baudRate) / 100 + 1) * 100)
+
+// rates the receiver may propose, the ones the receivers use and the UARTs can reach
+static const uint32_t crsfBaudRates[] = { 400000, 416666, 420000, 921600, 1870000, 2250000 };
 
 #define CRSF_DIGITAL_CHANNEL_MIN 172
 #define CRSF_DIGITAL_CHANNEL_MAX 1811
@@ -48,13 +56,23 @@
 STATIC_UNIT_TESTED bool crsfFrameDone = false;
 STATIC_UNIT_TESTED crsfFrame_t crsfFrame;
 
-STATIC_UNIT_TESTED uint32_t crsfChannelData[CRSF_MAX_CHANNEL];
+// channel values already scaled to PWM range
+STATIC_UNIT_TESTED uint16_t crsfChannelData[CRSF_MAX_CHANNEL];
 
 static serialPort_t *serialPort;
 static uint32_t crsfFrameStartAt = 0;
+static timeUs_t crsfFrameDoneAt = 0;
+static uint32_t crsfTimeNeededPerFrameUs = CRSF_TIME_NEEDED_PER_FRAME_US(CRSF_BAUDRATE);
+static uint32_t crsfBaudRate = CRSF_BAUDRATE;
+static uint32_t crsfPendingBaudRate = 0;    // switched to once the response to the proposal has been sent
+static uint8_t crsfCrcErrorCount = 0;
 static uint8_t telemetryBuf[CRSF_FRAME_SIZE_MAX];
 static uint8_t telemetryBufLen = 0;
 
+// Parameter requests are answered by the telemetry task, the RX task only keeps the frame
+static crsfFrame_t crsfParameterRequest;
+static bool crsfParameterRequestPending = false;
+
 
 /*
  * CRSF protocol
@@ -62,16 +80,16 @@ static uint8_t telemetryBufLen = 0;
  * CRSF protocol uses a single wire half duplex uart connection.
  * The master sends one frame every 4ms and the slave replies between two frames from the master.
  *
- * 420000 baud
+ * 420000 baud, the receiver may negotiate a higher rate with a speed proposal command
  * not inverted
  * 8 Bit
  * 1 Stop bit
  * Big endian
  * 420000 bit/s = 46667 byte/s (including stop bit) = 21.43us per byte
- * Assume a max payload of 32 bytes (needs confirming with TBS), so max frame size of 36 bytes
- * A 36 byte frame can be transmitted in 771 microseconds.
+ * The frame length is at most 62, so max frame size of 64 bytes
+ * A 64 byte frame can be transmitted in 1524 microseconds at 420000 baud.
  *
- * CRSF_TIME_NEEDED_PER_FRAME_US is set conservatively at 1000 microseconds
+ * crsfTimeNeededPerFrameUs is the time for the longest frame at the current rate, rounded up
  *
  * Every frame has the structure:
  * <Device address> <Frame length> < Type> <Payload> < CRC>
@@ -83,27 +101,10 @@ static uint8_t telemetryBufLen = 0;
  *
  */
 
-struct crsfPayloadRcChannelsPacked_s {
-    // 176 bits of data (11 bits per channel * 16 channels) = 22 bytes.
-    unsigned int chan0 : 11;
-    unsigned int chan1 : 11;
-    unsigned int chan2 : 11;
-    unsigned int chan3 : 11;
-    unsigned int chan4 : 11;
-    unsigned int chan5 : 11;
-    unsigned int chan6 : 11;
-    unsigned int chan7 : 11;
-    unsigned int chan8 : 11;
-    unsigned int chan9 : 11;
-    unsigned int chan10 : 11;
-    unsigned int chan11 : 11;
-    unsigned int chan12 : 11;
-    unsigned int chan13 : 11;
-    unsigned int chan14 : 11;
-    unsigned int chan15 : 11;
-} __attribute__ ((__packed__));
-
-typedef struct crsfPayloadRcChannelsPacked_s crsfPayloadRcChannelsPacked_t;
+/*
+ * RC channels payload: 176 bits of data (11 bits per channel * 16 channels) = 22 bytes,
+ * packed least significant bit first and unpacked with rxUnpack11BitChannels().
+ */
 
 
 // Receive ISR callback, called back from serial port
@@ -116,7 +117,7 @@ STATIC_UNIT_TESTED void crsfDataReceive(uint16_t c)
     debug[2] = now - crsfFrameStartAt;
 #endif
 
-    if (now > crsfFrameStartAt + CRSF_TIME_NEEDED_PER_FRAME_US) {
+    if (now > crsfFrameStartAt + crsfTimeNeededPerFrameUs) {
         // We've received a character after max time needed to complete a frame,
         // so this must be the start of a new frame.
         crsfFramePosition = 0;
@@ -129,53 +130,185 @@ STATIC_UNIT_TESTED void crsfDataReceive(uint16_t c)
     // full frame length includes the length of the address and framelength fields
     const int fullFrameLength = crsfFramePosition < 3 ? 5 : crsfFrame.frame.frameLength + CRSF_FRAME_LENGTH_ADDRESS + CRSF_FRAME_LENGTH_FRAMELENGTH;
 
-    if (crsfFramePosition < fullFrameLength) {
+    if (crsfFramePosition < fullFrameLength && crsfFramePosition < (int)sizeof(crsfFrame.bytes)) {
         crsfFrame.bytes[crsfFramePosition++] = (uint8_t)c;
         crsfFrameDone = crsfFramePosition < fullFrameLength ? false : true;
+        if (crsfFrameDone) {
+            crsfFrameDoneAt = now;
+            rxSignalFrameComplete();
+        }
     }
 }
 
 STATIC_UNIT_TESTED uint8_t crsfFrameCRC(void)
 {
     // CRC includes type and payload
-    uint8_t crc = crc8_dvb_s2(0, crsfFrame.frame.type);
-    for (int ii = 0; ii < crsfFrame.frame.frameLength - CRSF_FRAME_LENGTH_TYPE_CRC; ++ii) {
-        crc = crc8_dvb_s2(crc, crsfFrame.frame.payload[ii]);
+    const uint8_t crc = crc8_dvb_s2(0, crsfFrame.frame.type);
+    const int length = crsfFrame.frame.frameLength - CRSF_FRAME_LENGTH_TYPE_CRC;
+    return length > 0 ? crc8_dvb_s2_update(crc, crsfFrame.frame.payload, length) : crc;
+}
+
+// Command frames carry a second CRC, over type and payload, with a different polynomial
+static uint8_t crsfCommandCRC(const uint8_t *data, int length)
+{
+    uint8_t crc = 0;
+    for (int ii = 0; ii < length; ++ii) {
+        crc ^= data[ii];
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 0x80) ? (crc << 1) ^ 0xBA : crc << 1;
+        }
     }
     return crc;
 }
 
+static void crsfSetBaudRate(uint32_t baudRate)
+{
+    crsfBaudRate = baudRate;
+    crsfTimeNeededPerFrameUs = CRSF_TIME_NEEDED_PER_FRAME_US(baudRate);
+    crsfCrcErrorCount = 0;
+    serialSetBaudRate(serialPort, baudRate);
+}
+
+// The new rate is used once the response, sent at the old one, has left the UART
+static void crsfUpdateBaudRate(void)
+{
+    if (crsfPendingBaudRate && isSerialTransmitBufferEmpty(serialPort)) {
+        crsfSetBaudRate(crsfPendingBaudRate);
+        crsfPendingBaudRate = 0;
+    }
+}
+
+static bool crsfIsBaudRateSupported(uint32_t baudRate)
+{
+    // soft serial and VCP ports can't follow
+    if (serialPort->identifier > SERIAL_PORT_USART8) {
+        return false;
+    }
+    for (unsigned ii = 0; ii < ARRAYLEN(crsfBaudRates); ++ii) {
+        if (crsfBaudRates[ii] == baudRate) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * 0x32 Command, general speed proposal
+ * Payload:
+ * uint8_t     Destination, origin
+ * uint8_t     Command (0x0A), sub command (0x70)
+ * uint8_t     Port id
+ * uint32_t    Baud rate
+ * uint8_t     Command CRC
+ * The response is sent straight away, in the slot after the frame, and carries the sub command 0x71,
+ * the port id and whether the rate was accepted.
+ */
+static void crsfProcessCommand(void)
+{
+    const uint8_t *payload = crsfFrame.frame.payload;
+    const int payloadLength = crsfFrame.frame.frameLength - CRSF_FRAME_LENGTH_TYPE_CRC;
+
+    if (payloadLength < 10 || payload[0] != CRSF_ADDRESS_FLIGHT_CONTROLLER
+        || payload[2] != CRSF_COMMAND_SUBCMD_GENERAL || payload[3] != CRSF_COMMAND_SUBCMD_GENERAL_CRSF_SPEED_PROPOSAL) {
+        return;
+    }
+    if (crsfCommandCRC(&crsfFrame.frame.type, payloadLength) != payload[payloadLength - 1]) {
+        return;
+    }
+    const uint8_t portId = payload[4];
+    const uint32_t baudRate = (payload[5] << 24) | (payload[6] << 16) | (payload[7] << 8) | payload[8];
+    const bool accepted = portId == 0 && crsfIsBaudRateSupported(baudRate);
+
+    uint8_t response[] = {
+        CRSF_ADDRESS_BROADCAST, 9, CRSF_FRAMETYPE_COMMAND, payload[1], CRSF_ADDRESS_FLIGHT_CONTROLLER,
+        CRSF_COMMAND_SUBCMD_GENERAL, CRSF_COMMAND_SUBCMD_GENERAL_CRSF_SPEED_RESPONSE, portId, accepted, 0, 0
+    };
+    response[9] = crsfCommandCRC(&response[2], 7);
+    response[10] = crc8_dvb_s2_update(0, &response[2], 8);
+    serialWriteBuf(serialPort, response, sizeof(response));
+
+    if (accepted && baudRate != crsfBaudRate) {
+        crsfPendingBaudRate = baudRate;
+    }
+}
+
+static void crsfStoreParameterRequest(void)
+{
+    const uint8_t destination = crsfFrame.frame.payload[0];
+    if (crsfFrame.frame.frameLength < CRSF_FRAME_LENGTH_EXT_TYPE_CRC
+        || (destination != CRSF_ADDRESS_FLIGHT_CONTROLLER && destination != CRSF_ADDRESS_BROADCAST)) {
+        return;
+    }
+    // a request that hasn't been answered yet is replaced, the script asks again if it needs to
+    memcpy(&crsfParameterRequest, &crsfFrame, crsfFrame.frame.frameLength + CRSF_FRAME_LENGTH_ADDRESS + CRSF_FRAME_LENGTH_FRAMELENGTH);
+    crsfParameterRequestPending = true;
+}
+
+static timeUs_t crsfFrameTime(void)
+{
+    return crsfFrameDoneAt;
+}
+
+static uint16_t crsfChannelToPwm(uint16_t value)
+{
+    /* conversion from RC value to PWM
+     *       RC     PWM
+     * min  172 ->  988us
+     * mid  992 -> 1500us
+     * max 1811 -> 2012us
+     * scale factor = (2012-988) / (1811-172) = 1024 / 1639
+     * offset = 988 - 172 * 1024 / 1639 = 880.53935326418548
+     */
+    return (uint32_t)value * 1024 / 1639 + 881;
+}
+
+static bool crsfCheckFrameCRC(int crcIndex)
+{
+    if (crcIndex >= 0 && crsfFrameCRC() == crsfFrame.frame.payload[crcIndex]) {
+        crsfCrcErrorCount = 0;
+        return true;
+    }
+    // a receiver that restarted, or never switched, talks at another rate
+    if (crsfBaudRate != CRSF_BAUDRATE && ++crsfCrcErrorCount >= CRSF_BAUDRATE_FALLBACK_ERRORS) {
+        crsfSetBaudRate(CRSF_BAUDRATE);
+    }
+    return false;
+}
+
 STATIC_UNIT_TESTED uint8_t crsfFrameStatus(void)
 {
+    crsfUpdateBaudRate();
+
     if (crsfFrameDone) {
         crsfFrameDone = false;
-        if (crsfFrame.frame.type == CRSF_FRAMETYPE_RC_CHANNELS_PACKED) {
-            // CRC includes type and payload of each frame
-            const uint8_t crc = crsfFrameCRC();
-            if (crc != crsfFrame.frame.payload[CRSF_FRAME_RC_CHANNELS_PAYLOAD_SIZE]) {
-                return RX_FRAME_PENDING;
-            }
+        // CRC includes type and payload of each frame; RC frames have a fixed payload size
+        const int crcIndex = crsfFrame.frame.type == CRSF_FRAMETYPE_RC_CHANNELS_PACKED
+            ? CRSF_FRAME_RC_CHANNELS_PAYLOAD_SIZE
+            : crsfFrame.frame.frameLength - CRSF_FRAME_LENGTH_TYPE_CRC;
+        if (!crsfCheckFrameCRC(crcIndex)) {
+            return RX_FRAME_DROPPED;
+        }
+
+        switch (crsfFrame.frame.type) {
+        case CRSF_FRAMETYPE_DEVICE_PING:
+        case CRSF_FRAMETYPE_PARAMETER_READ:
+        case CRSF_FRAMETYPE_PARAMETER_WRITE:
+            crsfStoreParameterRequest();
+            break;
+        case CRSF_FRAMETYPE_COMMAND:
+            crsfProcessCommand();
+            break;
+        case CRSF_FRAMETYPE_RC_CHANNELS_PACKED: {
             crsfFrame.frame.frameLength = CRSF_FRAME_RC_CHANNELS_PAYLOAD_SIZE + CRSF_FRAME_LENGTH_TYPE_CRC;
-            // unpack the RC channels
-            const crsfPayloadRcChannelsPacked_t* rcChannels = (crsfPayloadRcChannelsPacked_t*)&crsfFrame.frame.payload;
-            crsfChannelData[0] = rcChannels->chan0;
-            crsfChannelData[1] = rcChannels->chan1;
-            crsfChannelData[2] = rcChannels->chan2;
-            crsfChannelData[3] = rcChannels->chan3;
-            crsfChannelData[4] = rcChannels->chan4;
-            crsfChannelData[5] = rcChannels->chan5;
-            crsfChannelData[6] = rcChannels->chan6;
-            crsfChannelData[7] = rcChannels->chan7;
-            crsfChannelData[8] = rcChannels->chan8;
-            crsfChannelData[9] = rcChannels->chan9;
-            crsfChannelData[10] = rcChannels->chan10;
-            crsfChannelData[11] = rcChannels->chan11;
-            crsfChannelData[12] = rcChannels->chan12;
-            crsfChannelData[13] = rcChannels->chan13;
-            crsfChannelData[14] = rcChannels->chan14;
-            crsfChannelData[15] = rcChannels->chan15;
+            rxUnpack11BitChannels(crsfChannelData, crsfFrame.frame.payload, CRSF_MAX_CHANNEL);
+            for (int ii = 0; ii < CRSF_MAX_CHANNEL; ++ii) {
+                crsfChannelData[ii] = crsfChannelToPwm(crsfChannelData[ii]);
+            }
             return RX_FRAME_COMPLETE;
         }
+        default:
+            break;
+        }
     }
     return RX_FRAME_PENDING;
 }
@@ -183,15 +316,7 @@ STATIC_UNIT_TESTED uint8_t crsfFrameStatus(void)
 STATIC_UNIT_TESTED uint16_t crsfReadRawRC(const rxRuntimeConfig_t *rxRuntimeConfig, uint8_t chan)
 {
     UNUSED(rxRuntimeConfig);
-    /* conversion from RC value to PWM
-     *       RC     PWM
-     * min  172 ->  988us
-     * mid  992 -> 1500us
-     * max 1811 -> 2012us
-     * scale factor = (2012-988) / (1811-172) = 0.62477120195241
-     * offset = 988 - 172 * 0.62477120195241 = 880.53935326418548
-     */
-    return (0.62477120195241f * crsfChannelData[chan]) + 881;
+    return crsfChannelData[chan];
 }
 
 void crsfRxWriteTelemetryData(const void *data, int len)
@@ -203,14 +328,16 @@ void crsfRxWriteTelemetryData(const void *data, int len)
 
 void crsfRxSendTelemetryData(void)
 {
+    crsfUpdateBaudRate();
+
     // if there is telemetry data to write
     if (telemetryBufLen > 0) {
         // check that we are not in bi dir mode or that we are not currently receiving data (ie in the middle of an RX frame)
         // and that there is time to send the telemetry frame before the next RX frame arrives
         if (CRSF_PORT_OPTIONS & SERIAL_BIDIR) {
             const uint32_t timeSinceStartOfFrame = micros() - crsfFrameStartAt;
-            if ((timeSinceStartOfFrame < CRSF_TIME_NEEDED_PER_FRAME_US) ||
-                (timeSinceStartOfFrame > CRSF_TIME_BETWEEN_FRAMES_US - CRSF_TIME_NEEDED_PER_FRAME_US)) {
+            if ((timeSinceStartOfFrame < crsfTimeNeededPerFrameUs) ||
+                (timeSinceStartOfFrame > CRSF_TIME_BETWEEN_FRAMES_US - crsfTimeNeededPerFrameUs)) {
                 return;
             }
         }
@@ -219,10 +346,26 @@ void crsfRxSendTelemetryData(void)
     }
 }
 
+bool crsfRxIsTelemetryBufferFree(void)
+{
+    return telemetryBufLen == 0;
+}
+
+// Returns the last parameter protocol request addressed to the flight controller, NULL if there is none
+const crsfFrame_t *crsfRxGetParameterRequest(void)
+{
+    return crsfParameterRequestPending ? &crsfParameterRequest : NULL;
+}
+
+void crsfRxClearParameterRequest(void)
+{
+    crsfParameterRequestPending = false;
+}
+
 bool crsfRxInit(const rxConfig_t *rxConfig, rxRuntimeConfig_t *rxRuntimeConfig)
 {
     for (int ii = 0; ii < CRSF_MAX_CHANNEL; ++ii) {
-        crsfChannelData[ii] = (16 * rxConfig->midrc) / 10 - 1408;
+        crsfChannelData[ii] = rxConfig->midrc;
     }
 
     rxRuntimeConfig->channelCount = CRSF_MAX_CHANNEL;
@@ -230,12 +373,15 @@ bool crsfRxInit(const rxConfig_t *rxConfig, rxRuntimeConfig_t *rxRuntimeConfig)
 
     rxRuntimeConfig->rcReadRawFn = crsfReadRawRC;
     rxRuntimeConfig->rcFrameStatusFn = crsfFrameStatus;
+    rxRuntimeConfig->rcFrameTimeFn = crsfFrameTime;
 
-    const serialPortConfig_t *portConfig = findSerialPortConfig(FUNCTION_RX_SERIAL);
+    const serialPortConfig_t *portConfig = serialRxFindPortConfig();
     if (!portConfig) {
         return false;
     }
 
+    crsfBaudRate = CRSF_BAUDRATE;
+    crsfTimeNeededPerFrameUs = CRSF_TIME_NEEDED_PER_FRAME_US(CRSF_BAUDRATE);
     serialPort = openSerialPort(portConfig->identifier, 
         FUNCTION_RX_SERIAL, 
         crsfDataReceive, 
@@ -29,9 +29,25 @@ typedef enum {
     CRSF_FRAMETYPE_LINK_STATISTICS = 0x14,
     CRSF_FRAMETYPE_RC_CHANNELS_PACKED = 0x16,
     CRSF_FRAMETYPE_ATTITUDE = 0x1E,
-    CRSF_FRAMETYPE_FLIGHT_MODE = 0x21
+    CRSF_FRAMETYPE_FLIGHT_MODE = 0x21,
+    // Extended header frames, the payload starts with the destination and origin addresses
+    CRSF_FRAMETYPE_DEVICE_PING = 0x28,
+    CRSF_FRAMETYPE_DEVICE_INFO = 0x29,
+    CRSF_FRAMETYPE_PARAMETER_SETTINGS_ENTRY = 0x2B,
+    CRSF_FRAMETYPE_PARAMETER_READ = 0x2C,
+    CRSF_FRAMETYPE_PARAMETER_WRITE = 0x2D,
+    CRSF_FRAMETYPE_COMMAND = 0x32
 } crsfFrameTypes_e;
 
+enum {
+    CRSF_COMMAND_SUBCMD_GENERAL = 0x0A,
+};
+
+enum {
+    CRSF_COMMAND_SUBCMD_GENERAL_CRSF_SPEED_PROPOSAL = 0x70,     // port id, baud rate
+    CRSF_COMMAND_SUBCMD_GENERAL_CRSF_SPEED_RESPONSE = 0x71      // port id, accepted
+};
+
 enum {
     CRSF_FRAME_GPS_PAYLOAD_SIZE = 15,
     CRSF_FRAME_BATTERY_SENSOR_PAYLOAD_SIZE = 8,
@@ -42,7 +58,9 @@ enum {
     CRSF_FRAME_LENGTH_FRAMELENGTH = 1, // length of FRAMELENGTH field
     CRSF_FRAME_LENGTH_TYPE = 1, // length of TYPE field
     CRSF_FRAME_LENGTH_CRC = 1, // length of CRC field
-    CRSF_FRAME_LENGTH_TYPE_CRC = 2 // length of TYPE and CRC fields combined
+    CRSF_FRAME_LENGTH_TYPE_CRC = 2, // length of TYPE and CRC fields combined
+    CRSF_FRAME_LENGTH_EXT_TYPE_CRC = 4, // length of Extended Dest/Origin, TYPE and CRC fields combined
+    CRSF_FRAME_ORIGIN_DEST_SIZE = 2
 };
 
 enum {
@@ -52,6 +70,7 @@ enum {
     CRSF_ADDRESS_CURRENT_SENSOR = 0xC0,
     CRSF_ADDRESS_TBS_BLACKBOX = 0xC4,
     CRSF_ADDRESS_COLIBRI_RACE_FC = 0xC8,
+    CRSF_ADDRESS_FLIGHT_CONTROLLER = 0xC8,
     CRSF_ADDRESS_RESERVED2 = 0xCA,
     CRSF_ADDRESS_RACE_TAG = 0xCC,
     CRSF_ADDRESS_RADIO_TRANSMITTER = 0xEA,
@@ -59,8 +78,8 @@ enum {
     CRSF_ADDRESS_CRSF_TRANSMITTER = 0xEE
 };
 
-#define CRSF_PAYLOAD_SIZE_MAX   32 // !!TODO needs checking
-#define CRSF_FRAME_SIZE_MAX     (CRSF_PAYLOAD_SIZE_MAX + 4)
+#define CRSF_FRAME_SIZE_MAX     64 // the frame length field counts at most 62 bytes
+#define CRSF_PAYLOAD_SIZE_MAX   (CRSF_FRAME_SIZE_MAX - 4)
 
 typedef struct crsfFrameDef_s {
     uint8_t deviceAddress;
@@ -77,6 +96,9 @@ typedef union crsfFrame_u {
 
 void crsfRxWriteTelemetryData(const void *data, int len);
 void crsfRxSendTelemetryData(void);
+bool crsfRxIsTelemetryBufferFree(void);
+const crsfFrame_t *crsfRxGetParameterRequest(void);
+void crsfRxClearParameterRequest(void);
 
 struct rxConfig_s;
 struct rxRuntimeConfig_s;
@@ -64,7 +64,8 @@ static uint8_t rxBytesToIgnore;
 static uint16_t ibusChecksum;
 
 static bool ibusFrameDone = false;
-static uint32_t ibusChannelData[IBUS_MAX_CHANNEL];
+static timeUs_t ibusFrameDoneAt = 0;
+static uint16_t ibusChannelData[IBUS_MAX_CHANNEL];
 
 static uint8_t ibus[IBUS_BUFFSIZE] = { 0, };
 
@@ -116,6 +117,8 @@ static void ibusDataReceive(uint16_t c)
 
     if (ibusFramePosition == ibusFrameSize - 1) {
         ibusFrameDone = true;
+        ibusFrameDoneAt = ibusTime;
+        rxSignalFrameComplete();
     } else {
         ibusFramePosition++;
     }
@@ -154,6 +157,11 @@ static void updateChannelData(void) {
     }
 }
 
+static timeUs_t ibusFrameTime(void)
+{
+    return ibusFrameDoneAt;
+}
+
 static uint8_t ibusFrameStatus(void)
 {
     uint8_t frameStatus = RX_FRAME_PENDING;
@@ -175,6 +183,8 @@ static uint8_t ibusFrameStatus(void)
             rxBytesToIgnore = respondToIbusRequest(ibus);
 #endif
         }
+    } else {
+        frameStatus = RX_FRAME_DROPPED;
     }
 
     return frameStatus;
@@ -198,8 +208,9 @@ bool ibusInit(const rxConfig_t *rxConfig, rxRuntimeConfig_t *rxRuntimeConfig)
 
     rxRuntimeConfig->rcReadRawFn = ibusReadRawRC;
     rxRuntimeConfig->rcFrameStatusFn = ibusFrameStatus;
+    rxRuntimeConfig->rcFrameTimeFn = ibusFrameTime;
 
-    const serialPortConfig_t *portConfig = findSerialPortConfig(FUNCTION_RX_SERIAL);
+    const serialPortConfig_t *portConfig = serialRxFindPortConfig();
     if (!portConfig) {
         return false;
     }
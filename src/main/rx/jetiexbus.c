@@ -44,6 +44,7 @@
 #include "build/build_config.h"
 #include "build/debug.h"
 
+#include "common/crc.h"
 #include "common/utils.h"
 
 #include "drivers/serial.h"
@@ -204,6 +205,7 @@ static uint8_t jetiExBusFramePosition;
 static uint8_t jetiExBusFrameLength;
 
 static uint8_t jetiExBusFrameState = EXBUS_STATE_ZERO;
+static timeUs_t jetiExBusFrameDoneAt = 0;
 static uint8_t jetiExBusRequestState = EXBUS_STATE_ZERO;
 
 // Use max values for ram areas
@@ -218,8 +220,6 @@ static uint8_t jetiExBusTelemetryFrame[40];
 static uint8_t jetiExBusTransceiveState = EXBUS_TRANS_RX;
 static void sendJetiExBusTelemetry(uint8_t packetID);
 
-uint8_t calcCRC8(uint8_t *pt, uint8_t msgLen);
-
 #endif //TELEMETRY
 
 uint16_t calcCRC16(uint8_t *pt, uint8_t msgLen);
@@ -241,23 +241,6 @@ uint16_t calcCRC16(uint8_t *pt, uint8_t msgLen)
     return(crc16_data);
 }
 
-#ifdef TELEMETRY
-
-
-// Jeti Ex Telemetry CRC calculations for a frame
-uint8_t calcCRC8(uint8_t *pt, uint8_t msgLen)
-{
-    uint8_t crc=0;
-
-    for (uint8_t mlen = 0; mlen < msgLen; mlen++) {
-        crc  ^= pt[mlen];
-        crc = crc ^ (crc << 1) ^ (crc << 2) ^ (0x0e090700 >> ((crc >> 3) & 0x18));
-    }
-    return(crc);
-}
-
-#endif //TELEMETRY
-
 
 void jetiExBusDecodeChannelFrame(uint8_t *exBusFrame)
 {
@@ -345,12 +328,13 @@ static void jetiExBusDataReceive(uint16_t c)
     // Check the header for the message length
     if (jetiExBusFramePosition == EXBUS_HEADER_LEN) {
 
-        if ((jetiExBusFrameState == EXBUS_STATE_IN_PROGRESS) && (jetiExBusFrame[EXBUS_HEADER_MSG_LEN] <= EXBUS_MAX_CHANNEL_FRAME_SIZE)) {
+        // a length shorter than the header and CRC would never be reached, and the frame would run off the end of its buffer
+        if ((jetiExBusFrameState == EXBUS_STATE_IN_PROGRESS) && (jetiExBusFrame[EXBUS_HEADER_MSG_LEN] >= EXBUS_OVERHEAD) && (jetiExBusFrame[EXBUS_HEADER_MSG_LEN] <= EXBUS_MAX_CHANNEL_FRAME_SIZE)) {
             jetiExBusFrameLength = jetiExBusFrame[EXBUS_HEADER_MSG_LEN];
             return;
         }
 
-        if ((jetiExBusRequestState == EXBUS_STATE_IN_PROGRESS) && (jetiExBusFrame[EXBUS_HEADER_MSG_LEN] <= EXBUS_MAX_REQUEST_FRAME_SIZE)) {
+        if ((jetiExBusRequestState == EXBUS_STATE_IN_PROGRESS) && (jetiExBusFrame[EXBUS_HEADER_MSG_LEN] >= EXBUS_OVERHEAD) && (jetiExBusFrame[EXBUS_HEADER_MSG_LEN] <= EXBUS_MAX_REQUEST_FRAME_SIZE)) {
             jetiExBusFrameLength = jetiExBusFrame[EXBUS_HEADER_MSG_LEN];
             return;
         }
@@ -363,8 +347,11 @@ static void jetiExBusDataReceive(uint16_t c)
 
     // Done?
     if (jetiExBusFrameLength == jetiExBusFramePosition) {
-        if (jetiExBusFrameState == EXBUS_STATE_IN_PROGRESS)
+        if (jetiExBusFrameState == EXBUS_STATE_IN_PROGRESS) {
             jetiExBusFrameState = EXBUS_STATE_RECEIVED;
+            jetiExBusFrameDoneAt = now;
+            rxSignalFrameComplete();
+        }
         if (jetiExBusRequestState == EXBUS_STATE_IN_PROGRESS) {
             jetiExBusRequestState = EXBUS_STATE_RECEIVED;
             jetiTimeStampRequest = micros();
@@ -376,6 +363,11 @@ static void jetiExBusDataReceive(uint16_t c)
 
 
 // Check if it is time to read a frame from the data...
+static timeUs_t jetiExBusFrameTime(void)
+{
+    return jetiExBusFrameDoneAt;
+}
+
 static uint8_t jetiExBusFrameStatus()
 {
     if (jetiExBusFrameState != EXBUS_STATE_RECEIVED)
@@ -387,7 +379,7 @@ static uint8_t jetiExBusFrameStatus()
         return RX_FRAME_COMPLETE;
     } else {
         jetiExBusFrameState = EXBUS_STATE_ZERO;
-        return RX_FRAME_PENDING;
+        return RX_FRAME_DROPPED;
     }
 }
 
@@ -439,7 +431,7 @@ void createExTelemetrieTextMessage(uint8_t *exMessage, uint8_t messageID, const
     memcpy(&exMessage[EXTEL_HEADER_DATA + 1], sensor->label, labelLength);
     memcpy(&exMessage[EXTEL_HEADER_DATA + 1 + labelLength], sensor->unit, unitLength);
 
-    exMessage[exMessage[EXTEL_HEADER_TYPE_LEN] + EXTEL_CRC_LEN] = calcCRC8(&exMessage[EXTEL_HEADER_TYPE_LEN], exMessage[EXTEL_HEADER_TYPE_LEN]);
+    exMessage[exMessage[EXTEL_HEADER_TYPE_LEN] + EXTEL_CRC_LEN] = crc8_ccitt_update(0, &exMessage[EXTEL_HEADER_TYPE_LEN], exMessage[EXTEL_HEADER_TYPE_LEN]);
 }
 
 
@@ -480,7 +472,7 @@ uint8_t createExTelemetrieValueMessage(uint8_t *exMessage, uint8_t itemStart)
 
     messageSize = (EXTEL_HEADER_LEN + (p-&exMessage[EXTEL_HEADER_ID]));
     exMessage[EXTEL_HEADER_TYPE_LEN] = EXTEL_DATA_MSG | messageSize;
-    exMessage[messageSize + EXTEL_CRC_LEN] = calcCRC8(&exMessage[EXTEL_HEADER_TYPE_LEN], messageSize);
+    exMessage[messageSize + EXTEL_CRC_LEN] = crc8_ccitt_update(0, &exMessage[EXTEL_HEADER_TYPE_LEN], messageSize);
 
     return item;        // return the next item
 }
@@ -593,10 +585,11 @@ bool jetiExBusInit(const rxConfig_t *rxConfig, rxRuntimeConfig_t *rxRuntimeConfi
 
     rxRuntimeConfig->rcReadRawFn = jetiExBusReadRawRC;
     rxRuntimeConfig->rcFrameStatusFn = jetiExBusFrameStatus;
+    rxRuntimeConfig->rcFrameTimeFn = jetiExBusFrameTime;
 
     jetiExBusFrameReset();
 
-    const serialPortConfig_t *portConfig = findSerialPortConfig(FUNCTION_RX_SERIAL);
+    const serialPortConfig_t *portConfig = serialRxFindPortConfig();
 
     if (!portConfig) {
         return false;
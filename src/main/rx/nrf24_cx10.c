@@ -260,7 +260,7 @@ rx_spi_received_e cx10Nrf24DataReceived(uint8_t *payload)
         // read the payload, processing of payload is deferred
         if (cx10ReadPayloadIfAvailable(payload)) {
             cx10HopToNextChannel();
-            timeOfLastHop = timeNowUs;
+            timeOfLastHop = rxSpiPacketTimeUs();
             ret = RX_SPI_RECEIVED_DATA;
         }
         if (timeNowUs > timeOfLastHop + hopTimeout) {
@@ -248,7 +248,8 @@ rx_spi_received_e h8_3dNrf24DataReceived(uint8_t *payload)
     const uint32_t timeNowUs = micros();
     if ((ret == RX_SPI_RECEIVED_DATA) || (timeNowUs > timeOfLastHop + hopTimeout)) {
         h8_3dHopToNextChannel();
-        timeOfLastHop = timeNowUs;
+        // hops follow the packet arrival, not the moment the packet was read
+        timeOfLastHop = (ret == RX_SPI_RECEIVED_DATA) ? rxSpiPacketTimeUs() : timeNowUs;
     }
     return ret;
 }
@@ -359,7 +359,7 @@ rx_spi_received_e inavNrf24DataReceived(uint8_t *payload)
         }
         if ((ret == RX_SPI_RECEIVED_DATA) || (timeNowUs > timeOfLastHop + hopTimeout)) {
             inavHopToNextChannel();
-            timeOfLastHop = timeNowUs;
+            timeOfLastHop = (ret == RX_SPI_RECEIVED_DATA) ? rxSpiPacketTimeUs() : timeNowUs;
         }
         break;
     }
@@ -254,7 +254,7 @@ rx_spi_received_e symaNrf24DataReceived(uint8_t *payload)
         // read the payload, processing of payload is deferred
         if (NRF24L01_ReadPayloadIfAvailable(payload, payloadSize)) {
             symaHopToNextChannel();
-            timeOfLastHop = micros();
+            timeOfLastHop = rxSpiPacketTimeUs();
             ret = RX_SPI_RECEIVED_DATA;
         }
         if (micros() > timeOfLastHop + hopTimeout) {
@@ -197,7 +197,7 @@ void v202Nrf24SetRcDataFromPayload(uint16_t *rcData, const uint8_t *packet)
 
 static rx_spi_received_e readrx(uint8_t *packet)
 {
-    if (!(NRF24L01_ReadReg(NRF24L01_07_STATUS) & BV(NRF24L01_07_STATUS_RX_DR))) {
+    if (!rxSpiIrqAsserted() || !(NRF24L01_ReadReg(NRF24L01_07_STATUS) & BV(NRF24L01_07_STATUS_RX_DR))) {
         uint32_t t = micros() - packet_timer;
         if (t > rx_timeout) {
             switch_channel();
@@ -205,7 +205,7 @@ static rx_spi_received_e readrx(uint8_t *packet)
         }
         return RX_SPI_RECEIVED_NONE;
     }
-    packet_timer = micros();
+    packet_timer = rxSpiPacketTimeUs();
     NRF24L01_WriteReg(NRF24L01_07_STATUS, BV(NRF24L01_07_STATUS_RX_DR)); // clear the RX_DR flag
     NRF24L01_ReadPayload(packet, V2X2_PAYLOAD_SIZE);
     NRF24L01_FlushRx();
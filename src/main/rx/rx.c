@@ -35,6 +35,7 @@
 #include "config/parameter_group_ids.h"
 
 #include "drivers/adc.h"
+#include "drivers/system.h"
 #include "drivers/rx_pwm.h"
 #include "drivers/rx_spi.h"
 #include "drivers/time.h"
@@ -48,6 +49,7 @@
 #include "io/serial.h"
 
 #include "rx/rx.h"
+#include "rx/rx_link_quality.h"
 #include "rx/pwm.h"
 #include "rx/sbus.h"
 #include "rx/spektrum.h"
@@ -69,15 +71,16 @@ const char rcChannelLetters[] = "AERT12345678abcdefgh";
 uint16_t rssi = 0;                  // range: [0;1023]
 
 static bool rxDataReceived = false;
-static bool rxSignalReceived = false;
-static bool rxSignalReceivedNotDataDriven = false;
+// cleared from the tick interrupt when the link loss watchdog expires
+static volatile bool rxSignalReceived = false;
+static volatile bool rxSignalReceivedNotDataDriven = false;
+static volatile bool rxLinkLossEvent = false;
 static bool rxFlightChannelsValid = false;
 static bool rxIsInFailsafeMode = true;
 static bool rxIsInFailsafeModeNotDataDriven = true;
 static uint8_t rxChannelCount;
 
 static uint32_t rxUpdateAt = 0;
-static uint32_t needRxSignalBefore = 0;
 static uint32_t needRxSignalMaxDelayUs;
 static uint32_t suspendRxSignalUntil = 0;
 static uint8_t  skipRxSamples = 0;
@@ -92,12 +95,33 @@ uint32_t rcInvalidPulsPeriod[MAX_SUPPORTED_RC_CHANNEL_COUNT];
 #define DELAY_50_HZ (1000000 / 50)
 #define DELAY_10_HZ (1000000 / 10)
 #define DELAY_5_HZ (1000000 / 5)
+#define RX_MIN_FRAME_INTERVAL_US 500                // intervals outside these are not a frame rate
+#define RX_MAX_FRAME_INTERVAL_US (1000000 / 20)
 #define SKIP_RC_ON_SUSPEND_PERIOD 1500000           // 1.5 second period in usec (call frequency independent)
 #define SKIP_RC_SAMPLES_ON_RESUME  2                // flush 2 samples to drop wrong measurements (timing independent)
 
 rxRuntimeConfig_t rxRuntimeConfig;
 static uint8_t rcSampleIndex = 0;
 
+#ifdef USE_SERIALRX_DUAL
+static rxRuntimeConfig_t rxSecondaryRuntimeConfig;
+#endif
+// The primary link is rxRuntimeConfig, a secondary link only exists with dual serial RX
+static rxRuntimeConfig_t *rxLinkRuntimeConfig[RX_LINK_COUNT] = { &rxRuntimeConfig, NULL };
+static rxLinkStats_t rxLinkStats[RX_LINK_COUNT];
+static uint8_t rxLinkCount = 1;
+static rxLink_e rxActiveLink = RX_LINK_PRIMARY;
+#ifdef SERIAL_RX
+static uint8_t serialRxPortIndex = 0;               // which RX_SERIAL port the receiver being initialised uses
+#endif
+
+// Set by receiver drivers when a frame has been completely received, see rxSignalFrameComplete()
+static volatile bool rxFrameEvent = false;
+#ifdef USE_CYCLE_TRACE
+static volatile uint32_t rxFrameEventCycles = 0;
+static uint32_t rxFrameCycles = 0;                  // arrival of the frame that was last accepted
+#endif
+
 #ifndef RX_SPI_DEFAULT_PROTOCOL
 #define RX_SPI_DEFAULT_PROTOCOL 0
 #endif
@@ -142,7 +166,10 @@ void pgResetFn_rxConfig(rxConfig_t *rxConfig)
         .rcInterpolationInterval = 19,
         .fpvCamAngleDegrees = 0,
         .max_aux_channel = DEFAULT_AUX_CHANNEL_COUNT,
-        .airModeActivateThreshold = 1350
+        .airModeActivateThreshold = 1350,
+        .frameEventScheduling = 0,
+        .dualSerialRx = 0,
+        .serialrx_provider_secondary = SERIALRX_SBUS
     );
 
 #ifdef RX_CHANNELS_TAER
@@ -282,14 +309,94 @@ bool serialRxInit(const rxConfig_t *rxConfig, rxRuntimeConfig_t *rxRuntimeConfig
     }
     return enabled;
 }
+
+// Port of the serial receiver being initialised, the secondary receiver uses the second RX_SERIAL port
+const serialPortConfig_t *serialRxFindPortConfig(void)
+{
+    const serialPortConfig_t *portConfig = findSerialPortConfig(FUNCTION_RX_SERIAL);
+    for (int i = 0; portConfig && i < serialRxPortIndex; i++) {
+        portConfig = findNextSerialPortConfig(FUNCTION_RX_SERIAL);
+    }
+    return portConfig;
+}
+
+#ifdef USE_SERIALRX_DUAL
+// Providers handled by the same driver can't run twice, the drivers keep their state in statics
+static uint8_t serialRxDriver(uint8_t provider)
+{
+    switch (provider) {
+    case SERIALRX_SRXL:
+    case SERIALRX_SPEKTRUM2048:
+        return SERIALRX_SPEKTRUM1024;
+    case SERIALRX_XBUS_MODE_B_RJ01:
+        return SERIALRX_XBUS_MODE_B;
+    default:
+        return provider;
+    }
+}
+
+static bool serialRxInitSecondary(void)
+{
+    if (!rxConfig()->dualSerialRx
+        || serialRxDriver(rxConfig()->serialrx_provider_secondary) == serialRxDriver(rxConfig()->serialrx_provider)) {
+        return false;
+    }
+
+    // the drivers take the provider from the config they are given
+    rxConfig_t secondaryRxConfig = *rxConfig();
+    secondaryRxConfig.serialrx_provider = rxConfig()->serialrx_provider_secondary;
+
+    rxSecondaryRuntimeConfig.rcReadRawFn = nullReadRawRC;
+    rxSecondaryRuntimeConfig.rcFrameStatusFn = nullFrameStatus;
+    rxSecondaryRuntimeConfig.rcFrameTimeFn = NULL;
+
+    serialRxPortIndex = 1;
+    const bool enabled = serialRxInit(&secondaryRxConfig, &rxSecondaryRuntimeConfig);
+    serialRxPortIndex = 0;
+    if (!enabled) {
+        return false;
+    }
+
+    rxLinkRuntimeConfig[RX_LINK_SECONDARY] = &rxSecondaryRuntimeConfig;
+    rxLinkCount = 2;
+    // only channels both receivers deliver can be used, and the faster link sets the refresh rate
+    rxRuntimeConfig.channelCount = MIN(rxRuntimeConfig.channelCount, rxSecondaryRuntimeConfig.channelCount);
+    rxRuntimeConfig.rxRefreshRate = MIN(rxRuntimeConfig.rxRefreshRate, rxSecondaryRuntimeConfig.rxRefreshRate);
+    return true;
+}
+#endif
 #endif
 
+// Called from the tick interrupt when no frame re-armed the watchdog in time. Stage 1 starts here, the RX task
+// is signalled to apply the hold values and to run the failsafe phases at once rather than at its next 50Hz check.
+static void rxLinkLossWatchdogExpired(void)
+{
+    rxSignalReceived = false;
+    rxSignalReceivedNotDataDriven = false;
+    rxLinkLossEvent = true;
+}
+
+static void rxLinkLossWatchdogArm(void)
+{
+    sysTickDeadlineArm(needRxSignalMaxDelayUs);
+}
+
 void rxInit(void)
 {
     rxRuntimeConfig.rcReadRawFn = nullReadRawRC;
     rxRuntimeConfig.rcFrameStatusFn = nullFrameStatus;
+    rxRuntimeConfig.rcFrameTimeFn = NULL;
+    rxRuntimeConfig.frameTimeUs = 0;
+    rxRuntimeConfig.frameIntervalUs = 0;
     rcSampleIndex = 0;
     needRxSignalMaxDelayUs = DELAY_10_HZ;
+    sysTickDeadlineInit(rxLinkLossWatchdogExpired);
+
+    rxLinkRuntimeConfig[RX_LINK_SECONDARY] = NULL;
+    rxLinkCount = 1;
+    rxActiveLink = RX_LINK_PRIMARY;
+    memset(rxLinkStats, 0, sizeof(rxLinkStats));
+    rxLinkQualityInit();
 
     for (int i = 0; i < MAX_SUPPORTED_RC_CHANNEL_COUNT; i++) {
         rcData[i] = rxConfig()->midrc;
@@ -322,7 +429,13 @@ void rxInit(void)
             featureClear(FEATURE_RX_SERIAL);
             rxRuntimeConfig.rcReadRawFn = nullReadRawRC;
             rxRuntimeConfig.rcFrameStatusFn = nullFrameStatus;
+            rxRuntimeConfig.rcFrameTimeFn = NULL;
+        }
+#ifdef USE_SERIALRX_DUAL
+        if (enabled) {
+            serialRxInitSecondary();
         }
+#endif
     }
 #endif
 
@@ -340,6 +453,7 @@ void rxInit(void)
             featureClear(FEATURE_RX_SPI);
             rxRuntimeConfig.rcReadRawFn = nullReadRawRC;
             rxRuntimeConfig.rcFrameStatusFn = nullFrameStatus;
+            rxRuntimeConfig.rcFrameTimeFn = NULL;
         }
     }
 #endif
@@ -382,44 +496,160 @@ void resumeRxSignal(void)
     failsafeOnRxResume();
 }
 
-bool rxUpdateCheck(timeUs_t currentTimeUs, timeDelta_t currentDeltaTime)
+static void updateFrameTiming(timeUs_t frameTimeUs)
 {
-    UNUSED(currentDeltaTime);
+    const timeDelta_t intervalUs = cmpTimeUs(frameTimeUs, rxRuntimeConfig.frameTimeUs);
+
+    // a gap means frames were lost, it says nothing about the rate
+    if (rxRuntimeConfig.frameTimeUs && intervalUs >= RX_MIN_FRAME_INTERVAL_US && intervalUs <= RX_MAX_FRAME_INTERVAL_US) {
+        if (rxRuntimeConfig.frameIntervalUs) {
+            rxRuntimeConfig.frameIntervalUs += (intervalUs - rxRuntimeConfig.frameIntervalUs) / 4;
+        } else {
+            rxRuntimeConfig.frameIntervalUs = intervalUs;
+        }
+    }
+    rxRuntimeConfig.frameTimeUs = frameTimeUs;
+}
+
+// A failsafe frame only counts when no other link is delivering valid frames
+static bool rxLinkFrameWins(rxLink_e link, uint8_t linkStatus, timeUs_t linkFrameTimeUs, uint8_t frameStatus, timeUs_t frameTimeUs)
+{
+    if (linkStatus & RX_FRAME_FAILSAFE) {
+        for (int other = 0; other < rxLinkCount; other++) {
+            if (other != (int)link && rxLinkStats[other].linkUp) {
+                return false;
+            }
+        }
+        return !(frameStatus & RX_FRAME_COMPLETE);
+    }
+    if (!(frameStatus & RX_FRAME_COMPLETE) || (frameStatus & RX_FRAME_FAILSAFE)) {
+        return true;
+    }
+    // both links delivered a valid frame, the fresher one wins
+    return cmpTimeUs(linkFrameTimeUs, frameTimeUs) > 0;
+}
 
-    if (rxSignalReceived) {
-        if (currentTimeUs >= needRxSignalBefore) {
-            rxSignalReceived = false;
-            rxSignalReceivedNotDataDriven = false;
+static void recordLinkQuality(uint8_t frameStatus)
+{
+    if (frameStatus & RX_FRAME_DROPPED) {
+        rxLinkQualityRecord(RX_LQ_FRAME_DROPPED);
+    } else if (frameStatus & RX_FRAME_FAILSAFE) {
+        rxLinkQualityRecord(RX_LQ_FRAME_FAILSAFE);
+    } else if (frameStatus & RX_FRAME_COMPLETE) {
+        rxLinkQualityRecord(RX_LQ_FRAME_GOOD);
+    }
+}
+
+static uint8_t rxPollLinks(timeUs_t currentTimeUs, timeUs_t *frameTimeUs)
+{
+    uint8_t frameStatus = RX_FRAME_PENDING;
+    uint8_t droppedStatus = RX_FRAME_PENDING;
+    rxLink_e selectedLink = rxActiveLink;
+
+    for (int link = 0; link < rxLinkCount; link++) {
+        const rxRuntimeConfig_t *linkRuntimeConfig = rxLinkRuntimeConfig[link];
+        rxLinkStats_t *stats = &rxLinkStats[link];
+
+        const uint8_t linkStatus = linkRuntimeConfig->rcFrameStatusFn();
+        droppedStatus |= linkStatus & RX_FRAME_DROPPED;
+        if (linkStatus & RX_FRAME_COMPLETE) {
+            const timeUs_t linkFrameTimeUs = linkRuntimeConfig->rcFrameTimeFn ? linkRuntimeConfig->rcFrameTimeFn() : currentTimeUs;
+            stats->frameCount++;
+            if (linkStatus & RX_FRAME_FAILSAFE) {
+                stats->failsafeFrameCount++;
+            }
+            if (rxLinkFrameWins(link, linkStatus, linkFrameTimeUs, frameStatus, *frameTimeUs)) {
+                frameStatus = linkStatus;
+                *frameTimeUs = linkFrameTimeUs;
+                selectedLink = link;
+            }
+            if (!(linkStatus & RX_FRAME_FAILSAFE)) {
+                stats->lastValidFrameUs = linkFrameTimeUs;
+                stats->linkUp = true;
+            }
+        }
+        if (stats->linkUp && cmpTimeUs(currentTimeUs, stats->lastValidFrameUs) > (timeDelta_t)needRxSignalMaxDelayUs) {
+            stats->linkUp = false;
+            stats->lossCount++;
         }
     }
 
+    if (frameStatus & RX_FRAME_COMPLETE) {
+        rxActiveLink = selectedLink;
+        rxLinkStats[selectedLink].selectedFrameCount++;
+        recordLinkQuality(frameStatus);
+    } else {
+        // with two links a frame only counts as dropped when no other frame made it through
+        recordLinkQuality(droppedStatus);
+    }
+
+    DEBUG_SET(DEBUG_RX_DUAL, 0, rxActiveLink);
+    DEBUG_SET(DEBUG_RX_DUAL, 1, rxLinkStats[RX_LINK_PRIMARY].lossCount);
+    DEBUG_SET(DEBUG_RX_DUAL, 2, rxLinkStats[RX_LINK_SECONDARY].lossCount);
+    DEBUG_SET(DEBUG_RX_DUAL, 3, constrain(cmpTimeUs(rxLinkStats[RX_LINK_PRIMARY].lastValidFrameUs, rxLinkStats[RX_LINK_SECONDARY].lastValidFrameUs), INT16_MIN, INT16_MAX));
+
+    return frameStatus;
+}
+
+bool rxUpdateCheck(timeUs_t currentTimeUs, timeDelta_t currentDeltaTime)
+{
+    UNUSED(currentDeltaTime);
+
+    const bool linkLost = rxLinkLossEvent;
+    rxLinkLossEvent = false;
+
 #if defined(USE_PWM) || defined(USE_PPM)
     if (feature(FEATURE_RX_PPM)) {
         if (isPPMDataBeingReceived()) {
+            rxLinkQualityRecord(RX_LQ_FRAME_GOOD);
+            rxLinkLossWatchdogArm();
             rxSignalReceivedNotDataDriven = true;
             rxIsInFailsafeModeNotDataDriven = false;
-            needRxSignalBefore = currentTimeUs + needRxSignalMaxDelayUs;
             resetPPMDataReceivedState();
         }
     } else if (feature(FEATURE_RX_PARALLEL_PWM)) {
         if (isPWMDataBeingReceived()) {
+            rxLinkQualityRecord(RX_LQ_FRAME_GOOD);
+            rxLinkLossWatchdogArm();
             rxSignalReceivedNotDataDriven = true;
             rxIsInFailsafeModeNotDataDriven = false;
-            needRxSignalBefore = currentTimeUs + needRxSignalMaxDelayUs;
         }
     } else
 #endif
     {
         rxDataReceived = false;
-        const uint8_t frameStatus = rxRuntimeConfig.rcFrameStatusFn();
-        if (frameStatus & RX_FRAME_COMPLETE) {
-            rxDataReceived = true;
-            rxIsInFailsafeMode = (frameStatus & RX_FRAME_FAILSAFE) != 0;
-            rxSignalReceived = !rxIsInFailsafeMode;
-            needRxSignalBefore = currentTimeUs + needRxSignalMaxDelayUs;
+        // drivers that time their frames also signal them, so there is nothing to poll for until they have
+        const bool frameSignalled = rxFrameEvent;
+        if (frameSignalled || !rxFrameEventSchedulingEnabled()) {
+            rxFrameEvent = false;
+#ifdef USE_CYCLE_TRACE
+            const uint32_t frameCycles = rxFrameEventCycles;
+#endif
+            timeUs_t frameTimeUs = currentTimeUs;
+            const uint8_t frameStatus = rxPollLinks(currentTimeUs, &frameTimeUs);
+            if (frameStatus & RX_FRAME_COMPLETE) {
+                rxDataReceived = true;
+                rxIsInFailsafeMode = (frameStatus & RX_FRAME_FAILSAFE) != 0;
+                if (!rxIsInFailsafeMode) {
+                    rxLinkLossWatchdogArm();
+                }
+                rxSignalReceived = !rxIsInFailsafeMode;
+                updateFrameTiming(frameTimeUs);
+#ifdef USE_CYCLE_TRACE
+                rxFrameCycles = frameSignalled ? frameCycles : 0;
+#endif
+            }
         }
     }
-    return rxDataReceived || (currentTimeUs >= rxUpdateAt); // data driven or 50Hz
+
+    // frames the drivers reported were counted above, now count the ones that never arrived
+    rxLinkQualityUpdate(currentTimeUs, rxRuntimeConfig.frameIntervalUs ? rxRuntimeConfig.frameIntervalUs : (timeDelta_t)rxRuntimeConfig.rxRefreshRate);
+    DEBUG_SET(DEBUG_RX_LQ, 0, rxGetLinkQuality());
+    DEBUG_SET(DEBUG_RX_LQ, 1, rxGetLinkQualityStats()->eventCount[RX_LQ_FRAME_DROPPED]);
+    DEBUG_SET(DEBUG_RX_LQ, 2, rxGetLinkQualityStats()->eventCount[RX_LQ_FRAME_MISSED]);
+    DEBUG_SET(DEBUG_RX_LQ, 3, rxGetLinkQualityStats()->eventCount[RX_LQ_FRAME_FAILSAFE]);
+
+    return rxDataReceived || linkLost || (currentTimeUs >= rxUpdateAt); // data driven, link loss or 50Hz
 }
 
 static uint16_t calculateChannelMovingAverage(uint8_t chan, uint16_t sample)
@@ -492,12 +722,14 @@ STATIC_UNIT_TESTED uint16_t applyRxChannelRangeConfiguraton(int sample, const rx
 
 static void readRxChannelsApplyRanges(void)
 {
+    const rxRuntimeConfig_t *linkRuntimeConfig = rxLinkRuntimeConfig[rxActiveLink];
+
     for (int channel = 0; channel < rxChannelCount; channel++) {
 
         const uint8_t rawChannel = channel < RX_MAPPABLE_CHANNEL_COUNT ? rxConfig()->rcmap[channel] : channel;
 
         // sample the channel
-        uint16_t sample = rxRuntimeConfig.rcReadRawFn(&rxRuntimeConfig, rawChannel);
+        uint16_t sample = linkRuntimeConfig->rcReadRawFn(linkRuntimeConfig, rawChannel);
 
         // apply the rx calibration
         if (channel < NON_AUX_CHANNEL_COUNT) {
@@ -672,3 +904,51 @@ uint16_t rxGetRefreshRate(void)
 {
     return rxRuntimeConfig.rxRefreshRate;
 }
+
+timeUs_t rxGetFrameTimeUs(void)
+{
+    return rxRuntimeConfig.frameTimeUs;
+}
+
+timeDelta_t rxGetFrameIntervalUs(void)
+{
+    return rxRuntimeConfig.frameIntervalUs;
+}
+
+// Called by receiver drivers, usually from the serial receive interrupt, when a frame is complete
+void rxSignalFrameComplete(void)
+{
+#ifdef USE_CYCLE_TRACE
+    rxFrameEventCycles = getCycleCounter();
+#endif
+    rxFrameEvent = true;
+}
+
+// Only drivers that time their frames signal them, the others are still polled
+bool rxFrameEventSchedulingEnabled(void)
+{
+    for (int link = 0; link < rxLinkCount; link++) {
+        if (!rxLinkRuntimeConfig[link]->rcFrameTimeFn) {
+            return false;
+        }
+    }
+    return rxConfig()->frameEventScheduling;
+}
+
+rxLink_e rxGetActiveLink(void)
+{
+    return rxActiveLink;
+}
+
+const rxLinkStats_t *rxGetLinkStats(rxLink_e link)
+{
+    return &rxLinkStats[link];
+}
+
+#ifdef USE_CYCLE_TRACE
+// Cycle count at the arrival of the frame that was last accepted, 0 if the driver didn't signal it
+uint32_t rxGetFrameCycles(void)
+{
+    return rxFrameCycles;
+}
+#endif
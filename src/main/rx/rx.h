@@ -41,7 +41,8 @@
 typedef enum {
     RX_FRAME_PENDING = 0,
     RX_FRAME_COMPLETE = (1 << 0),
-    RX_FRAME_FAILSAFE = (1 << 1)
+    RX_FRAME_FAILSAFE = (1 << 1),
+    RX_FRAME_DROPPED = (1 << 2)     // a frame failed its CRC, or the receiver reports it lost one; only counts toward link quality
 } rxFrameState_e;
 
 typedef enum {
@@ -141,6 +142,9 @@ typedef struct rxConfig_s {
 
     uint16_t rx_min_usec;
     uint16_t rx_max_usec;
+    uint8_t frameEventScheduling;           // run the RX task as soon as the receiver driver signals a complete frame
+    uint8_t dualSerialRx;                   // run a second serial receiver on the next RX_SERIAL port, the freshest valid frame wins
+    uint8_t serialrx_provider_secondary;    // type of the second serial receiver, must differ from serialrx_provider
 } rxConfig_t;
 
 PG_DECLARE(rxConfig_t, rxConfig);
@@ -148,17 +152,39 @@ PG_DECLARE(rxConfig_t, rxConfig);
 struct rxRuntimeConfig_s;
 typedef uint16_t (*rcReadRawDataFnPtr)(const struct rxRuntimeConfig_s *rxRuntimeConfig, uint8_t chan); // used by receiver driver to return channel data
 typedef uint8_t (*rcFrameStatusFnPtr)(void);
+typedef timeUs_t (*rcFrameTimeFnPtr)(void); // used by receiver driver to return when the last complete frame arrived
 
 typedef struct rxRuntimeConfig_s {
     uint8_t          channelCount; // number of RC channels as reported by current input driver
     uint16_t         rxRefreshRate;
     rcReadRawDataFnPtr rcReadRawFn;
     rcFrameStatusFnPtr rcFrameStatusFn;
+    rcFrameTimeFnPtr rcFrameTimeFn;     // optional, frames are timed when they are noticed without it
+    timeUs_t         frameTimeUs;       // arrival of the last complete frame
+    timeDelta_t      frameIntervalUs;   // measured between frames and smoothed, 0 until known
 } rxRuntimeConfig_t;
 
 extern rxRuntimeConfig_t rxRuntimeConfig; //!!TODO remove this extern, only needed once for channelCount
 
+typedef enum {
+    RX_LINK_PRIMARY = 0,
+    RX_LINK_SECONDARY,
+    RX_LINK_COUNT
+} rxLink_e;
+
+typedef struct rxLinkStats_s {
+    uint32_t frameCount;            // complete frames, including failsafe frames
+    uint32_t failsafeFrameCount;    // frames the receiver flagged as failsafe
+    uint32_t selectedFrameCount;    // frames that were used for rcData
+    uint16_t lossCount;             // times the link went quiet for longer than the signal timeout
+    bool     linkUp;
+    timeUs_t lastValidFrameUs;
+} rxLinkStats_t;
+
+struct serialPortConfig_s;
+
 void rxInit(void);
+const struct serialPortConfig_s *serialRxFindPortConfig(void);
 bool rxUpdateCheck(timeUs_t currentTimeUs, timeDelta_t currentDeltaTimeUs);
 bool rxIsReceivingSignal(void);
 bool rxAreFlightChannelsValid(void);
@@ -173,3 +199,12 @@ void suspendRxSignal(void);
 void resumeRxSignal(void);
 
 uint16_t rxGetRefreshRate(void);
+timeUs_t rxGetFrameTimeUs(void);
+timeDelta_t rxGetFrameIntervalUs(void);
+void rxSignalFrameComplete(void);
+bool rxFrameEventSchedulingEnabled(void);
+rxLink_e rxGetActiveLink(void);
+const rxLinkStats_t *rxGetLinkStats(rxLink_e link);
+#ifdef USE_CYCLE_TRACE
+uint32_t rxGetFrameCycles(void);
+#endif
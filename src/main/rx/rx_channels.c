@@ -0,0 +1,42 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+
+#include "rx/rx_channels.h"
+
+/*
+ * Unpacks channels sent as consecutive 11 bit values, least significant bit first, as used by SBUS and CRSF.
+ * Every 8 channels fill exactly 11 bytes, so each group is unpacked with fixed shifts instead of bitfield accesses.
+ * channelCount must be a multiple of 8.
+ */
+void rxUnpack11BitChannels(uint16_t *channels, const uint8_t *packed, int channelCount)
+{
+    for (; channelCount >= 8; channelCount -= 8, channels += 8, packed += 11) {
+        const uint32_t lo = packed[0] | packed[1] << 8 | packed[2] << 16 | (uint32_t)packed[3] << 24;
+        const uint32_t mid = packed[4] | packed[5] << 8 | packed[6] << 16 | (uint32_t)packed[7] << 24;
+        const uint32_t hi = packed[8] | packed[9] << 8 | packed[10] << 16;
+        channels[0] = lo & 0x07FF;
+        channels[1] = (lo >> 11) & 0x07FF;
+        channels[2] = ((lo >> 22) | (mid << 10)) & 0x07FF;
+        channels[3] = (mid >> 1) & 0x07FF;
+        channels[4] = (mid >> 12) & 0x07FF;
+        channels[5] = ((mid >> 23) | (hi << 9)) & 0x07FF;
+        channels[6] = (hi >> 2) & 0x07FF;
+        channels[7] = (hi >> 13) & 0x07FF;
+    }
+}
@@ -0,0 +1,99 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "rx/rx_link_quality.h"
+
+/*
+ * Link quality is the share of good frames among the last RX_LINK_QUALITY_WINDOW frames.
+ * Each frame slot is one bit of history, so recording an event and reading the quality are both O(1).
+ * Frames that never arrived are counted by rxLinkQualityUpdate(), which fills the gaps once a frame is overdue.
+ */
+
+static uint32_t linkQualityHistory[(RX_LINK_QUALITY_WINDOW + 31) / 32];
+static uint8_t linkQualityIndex;
+static uint8_t linkQualityGoodCount;
+static bool linkQualityEventSinceUpdate;
+static timeUs_t linkQualityLastEventUs;
+static rxLinkQualityStats_t linkQualityStats;
+
+void rxLinkQualityInit(void)
+{
+    memset(linkQualityHistory, 0, sizeof(linkQualityHistory));
+    memset(&linkQualityStats, 0, sizeof(linkQualityStats));
+    linkQualityIndex = 0;
+    linkQualityGoodCount = 0;
+    linkQualityEventSinceUpdate = false;
+    linkQualityLastEventUs = 0;
+}
+
+void rxLinkQualityRecord(rxLinkQualityEvent_e event)
+{
+    uint32_t *word = &linkQualityHistory[linkQualityIndex / 32];
+    const uint32_t bit = 1U << (linkQualityIndex % 32);
+
+    // the oldest frame leaves the window as the new one enters
+    if (*word & bit) {
+        *word &= ~bit;
+        linkQualityGoodCount--;
+    }
+    if (event == RX_LQ_FRAME_GOOD) {
+        *word |= bit;
+        linkQualityGoodCount++;
+    }
+    if (++linkQualityIndex >= RX_LINK_QUALITY_WINDOW) {
+        linkQualityIndex = 0;
+    }
+
+    linkQualityStats.eventCount[event]++;
+    linkQualityEventSinceUpdate = true;
+}
+
+void rxLinkQualityUpdate(timeUs_t currentTimeUs, timeDelta_t frameIntervalUs)
+{
+    if (linkQualityEventSinceUpdate || frameIntervalUs <= 0) {
+        linkQualityEventSinceUpdate = false;
+        linkQualityLastEventUs = currentTimeUs;
+        return;
+    }
+
+    // allow half a frame of jitter before a frame counts as missed
+    int missedFrames = 0;
+    while (cmpTimeUs(currentTimeUs, linkQualityLastEventUs) > frameIntervalUs + frameIntervalUs / 2) {
+        if (++missedFrames > RX_LINK_QUALITY_WINDOW) {
+            // the whole window is gone already
+            linkQualityLastEventUs = currentTimeUs;
+            break;
+        }
+        rxLinkQualityRecord(RX_LQ_FRAME_MISSED);
+        linkQualityLastEventUs += frameIntervalUs;
+    }
+    linkQualityEventSinceUpdate = false;
+}
+
+uint8_t rxGetLinkQuality(void)
+{
+    return linkQualityGoodCount * 100 / RX_LINK_QUALITY_WINDOW;
+}
+
+const rxLinkQualityStats_t *rxGetLinkQualityStats(void)
+{
+    return &linkQualityStats;
+}
@@ -0,0 +1,39 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include "common/time.h"
+
+#define RX_LINK_QUALITY_WINDOW 100  // frames, so the number of good frames in the window is the percentage
+
+typedef enum {
+    RX_LQ_FRAME_GOOD = 0,
+    RX_LQ_FRAME_FAILSAFE,   // the receiver sent a frame flagged as failsafe
+    RX_LQ_FRAME_DROPPED,    // a frame arrived but failed its CRC, or the receiver reported it lost one
+    RX_LQ_FRAME_MISSED,     // nothing arrived when a frame was due
+    RX_LQ_EVENT_COUNT
+} rxLinkQualityEvent_e;
+
+typedef struct rxLinkQualityStats_s {
+    uint32_t eventCount[RX_LQ_EVENT_COUNT];
+} rxLinkQualityStats_t;
+
+void rxLinkQualityInit(void);
+void rxLinkQualityRecord(rxLinkQualityEvent_e event);
+void rxLinkQualityUpdate(timeUs_t currentTimeUs, timeDelta_t frameIntervalUs);
+uint8_t rxGetLinkQuality(void);
+const rxLinkQualityStats_t *rxGetLinkQualityStats(void);
@@ -33,6 +33,7 @@
 #include "telemetry/telemetry.h"
 #endif
 #include "rx/rx.h"
+#include "rx/rx_channels.h"
 #include "rx/sbus.h"
 
 /*
@@ -65,6 +66,8 @@ static uint16_t sbusStateFlags = 0;
 #define SBUS_FRAME_SIZE 25
 
 #define SBUS_FRAME_BEGIN_BYTE 0x0F
+#define SBUS_PACKED_CHANNEL_COUNT 16
+#define SBUS_CHANNEL_DATA_SIZE 22
 
 #define SBUS_BAUDRATE 100000
 
@@ -76,8 +79,10 @@ static uint16_t sbusStateFlags = 0;
 #define SBUS_DIGITAL_CHANNEL_MAX 1812
 
 static bool sbusFrameDone = false;
+static timeUs_t sbusFrameDoneAt = 0;
 
-static uint32_t sbusChannelData[SBUS_MAX_CHANNEL];
+// channel values already scaled to PWM range
+static uint16_t sbusChannelData[SBUS_MAX_CHANNEL];
 
 #define SBUS_FLAG_CHANNEL_17        (1 << 0)
 #define SBUS_FLAG_CHANNEL_18        (1 << 1)
@@ -87,22 +92,7 @@ static uint32_t sbusChannelData[SBUS_MAX_CHANNEL];
 struct sbusFrame_s {
     uint8_t syncByte;
     // 176 bits of data (11 bits per channel * 16 channels) = 22 bytes.
-    unsigned int chan0 : 11;
-    unsigned int chan1 : 11;
-    unsigned int chan2 : 11;
-    unsigned int chan3 : 11;
-    unsigned int chan4 : 11;
-    unsigned int chan5 : 11;
-    unsigned int chan6 : 11;
-    unsigned int chan7 : 11;
-    unsigned int chan8 : 11;
-    unsigned int chan9 : 11;
-    unsigned int chan10 : 11;
-    unsigned int chan11 : 11;
-    unsigned int chan12 : 11;
-    unsigned int chan13 : 11;
-    unsigned int chan14 : 11;
-    unsigned int chan15 : 11;
+    uint8_t channels[SBUS_CHANNEL_DATA_SIZE];
     uint8_t flags;
     /**
      * The endByte is 0x00 on FrSky and some futaba RX's, on Some SBUS2 RX's the value indicates the telemetry byte that is sent after every 4th sbus frame.
@@ -147,6 +137,8 @@ static void sbusDataReceive(uint16_t c)
             sbusFrameDone = false;
         } else {
             sbusFrameDone = true;
+            sbusFrameDoneAt = now;
+            rxSignalFrameComplete();
 #ifdef DEBUG_SBUS_PACKETS
         debug[2] = sbusFrameTime;
 #endif
@@ -154,6 +146,18 @@ static void sbusDataReceive(uint16_t c)
     }
 }
 
+static uint16_t sbusChannelToPwm(uint16_t value)
+{
+    // Linear fitting values read from OpenTX-ppmus and comparing with values received by X4R
+    // http://www.wolframalpha.com/input/?i=linear+fit+%7B173%2C+988%7D%2C+%7B1812%2C+2012%7D%2C+%7B993%2C+1500%7D
+    return (5 * value / 8) + 880;
+}
+
+static timeUs_t sbusFrameTime(void)
+{
+    return sbusFrameDoneAt;
+}
+
 static uint8_t sbusFrameStatus(void)
 {
     if (!sbusFrameDone) {
@@ -166,40 +170,31 @@ static uint8_t sbusFrameStatus(void)
     debug[1] = sbusFrame.frame.flags;
 #endif
 
-    sbusChannelData[0] = sbusFrame.frame.chan0;
-    sbusChannelData[1] = sbusFrame.frame.chan1;
-    sbusChannelData[2] = sbusFrame.frame.chan2;
-    sbusChannelData[3] = sbusFrame.frame.chan3;
-    sbusChannelData[4] = sbusFrame.frame.chan4;
-    sbusChannelData[5] = sbusFrame.frame.chan5;
-    sbusChannelData[6] = sbusFrame.frame.chan6;
-    sbusChannelData[7] = sbusFrame.frame.chan7;
-    sbusChannelData[8] = sbusFrame.frame.chan8;
-    sbusChannelData[9] = sbusFrame.frame.chan9;
-    sbusChannelData[10] = sbusFrame.frame.chan10;
-    sbusChannelData[11] = sbusFrame.frame.chan11;
-    sbusChannelData[12] = sbusFrame.frame.chan12;
-    sbusChannelData[13] = sbusFrame.frame.chan13;
-    sbusChannelData[14] = sbusFrame.frame.chan14;
-    sbusChannelData[15] = sbusFrame.frame.chan15;
+    rxUnpack11BitChannels(sbusChannelData, sbusFrame.frame.channels, SBUS_PACKED_CHANNEL_COUNT);
+    for (int ii = 0; ii < SBUS_PACKED_CHANNEL_COUNT; ++ii) {
+        sbusChannelData[ii] = sbusChannelToPwm(sbusChannelData[ii]);
+    }
 
     if (sbusFrame.frame.flags & SBUS_FLAG_CHANNEL_17) {
-        sbusChannelData[16] = SBUS_DIGITAL_CHANNEL_MAX;
+        sbusChannelData[16] = sbusChannelToPwm(SBUS_DIGITAL_CHANNEL_MAX);
     } else {
-        sbusChannelData[16] = SBUS_DIGITAL_CHANNEL_MIN;
+        sbusChannelData[16] = sbusChannelToPwm(SBUS_DIGITAL_CHANNEL_MIN);
     }
 
     if (sbusFrame.frame.flags & SBUS_FLAG_CHANNEL_18) {
-        sbusChannelData[17] = SBUS_DIGITAL_CHANNEL_MAX;
+        sbusChannelData[17] = sbusChannelToPwm(SBUS_DIGITAL_CHANNEL_MAX);
     } else {
-        sbusChannelData[17] = SBUS_DIGITAL_CHANNEL_MIN;
+        sbusChannelData[17] = sbusChannelToPwm(SBUS_DIGITAL_CHANNEL_MIN);
     }
 
+    uint8_t frameStatus = RX_FRAME_COMPLETE;
     if (sbusFrame.frame.flags & SBUS_FLAG_SIGNAL_LOSS) {
 #ifdef DEBUG_SBUS_PACKETS
         sbusStateFlags |= SBUS_STATE_SIGNALLOSS;
         debug[0] = sbusStateFlags;
 #endif
+        // the receiver missed a frame from the transmitter and repeats the last channel values
+        frameStatus |= RX_FRAME_DROPPED;
     }
     if (sbusFrame.frame.flags & SBUS_FLAG_FAILSAFE_ACTIVE) {
         // internal failsafe enabled and rx failsafe flag set
@@ -208,27 +203,25 @@ static uint8_t sbusFrameStatus(void)
         debug[0] = sbusStateFlags;
 #endif
         // RX *should* still be sending valid channel data, so use it.
-        return RX_FRAME_COMPLETE | RX_FRAME_FAILSAFE;
+        return frameStatus | RX_FRAME_FAILSAFE;
     }
 
 #ifdef DEBUG_SBUS_PACKETS
     debug[0] = sbusStateFlags;
 #endif
-    return RX_FRAME_COMPLETE;
+    return frameStatus;
 }
 
 static uint16_t sbusReadRawRC(const rxRuntimeConfig_t *rxRuntimeConfig, uint8_t chan)
 {
     UNUSED(rxRuntimeConfig);
-    // Linear fitting values read from OpenTX-ppmus and comparing with values received by X4R
-    // http://www.wolframalpha.com/input/?i=linear+fit+%7B173%2C+988%7D%2C+%7B1812%2C+2012%7D%2C+%7B993%2C+1500%7D
-    return (5 * sbusChannelData[chan] / 8) + 880;
+    return sbusChannelData[chan];
 }
 
 bool sbusInit(const rxConfig_t *rxConfig, rxRuntimeConfig_t *rxRuntimeConfig)
 {
     for (int b = 0; b < SBUS_MAX_CHANNEL; b++) {
-        sbusChannelData[b] = (16 * rxConfig->midrc) / 10 - 1408;
+        sbusChannelData[b] = rxConfig->midrc;
     }
 
     rxRuntimeConfig->channelCount = SBUS_MAX_CHANNEL;
@@ -236,8 +229,9 @@ bool sbusInit(const rxConfig_t *rxConfig, rxRuntimeConfig_t *rxRuntimeConfig)
 
     rxRuntimeConfig->rcReadRawFn = sbusReadRawRC;
     rxRuntimeConfig->rcFrameStatusFn = sbusFrameStatus;
+    rxRuntimeConfig->rcFrameTimeFn = sbusFrameTime;
 
-    const serialPortConfig_t *portConfig = findSerialPortConfig(FUNCTION_RX_SERIAL);
+    const serialPortConfig_t *portConfig = serialRxFindPortConfig();
     if (!portConfig) {
         return false;
     }
@@ -62,6 +62,7 @@
 static uint8_t spek_chan_shift;
 static uint8_t spek_chan_mask;
 static bool rcFrameComplete = false;
+static timeUs_t spekFrameDoneAt = 0;
 static bool spekHiRes = false;
 static bool srxlEnabled = false;
 
@@ -103,6 +104,8 @@ static void spektrumDataReceive(uint16_t c)
             rcFrameComplete = false;
         } else {
             rcFrameComplete = true;
+            spekFrameDoneAt = spekTime;
+            rxSignalFrameComplete();
         }
     }
 }
@@ -110,6 +113,11 @@ static void spektrumDataReceive(uint16_t c)
 static uint32_t spekChannelData[SPEKTRUM_MAX_SUPPORTED_CHANNEL_COUNT];
 static dispatchEntry_t srxlTelemetryDispatch = { .dispatch = srxlRxSendTelemetryDataDispatch};
 
+static timeUs_t spektrumFrameTime(void)
+{
+    return spekFrameDoneAt;
+}
+
 static uint8_t spektrumFrameStatus(void)
 {
     if (!rcFrameComplete) {
@@ -217,7 +225,7 @@ void spektrumBind(rxConfig_t *rxConfig)
     if (rxConfig->spektrum_bind_pin_override_ioTag) {
         bindPin = rxConfig->spektrum_bind_pin_override_ioTag;
     } else {
-        const serialPortConfig_t *portConfig = findSerialPortConfig(FUNCTION_RX_SERIAL);
+        const serialPortConfig_t *portConfig = serialRxFindPortConfig();
         if (!portConfig) {
             return;
         }
@@ -298,7 +306,7 @@ bool spektrumInit(const rxConfig_t *rxConfig, rxRuntimeConfig_t *rxRuntimeConfig
 {
     rxRuntimeConfigPtr = rxRuntimeConfig;
 
-    const serialPortConfig_t *portConfig = findSerialPortConfig(FUNCTION_RX_SERIAL);
+    const serialPortConfig_t *portConfig = serialRxFindPortConfig();
     if (!portConfig) {
         return false;
     }
@@ -315,6 +323,7 @@ bool spektrumInit(const rxConfig_t *rxConfig, rxRuntimeConfig_t *rxRuntimeConfig
 #ifdef TELEMETRY
         srxlEnabled = (feature(FEATURE_TELEMETRY) && !portShared);
 #endif
+        // Fall through
     case SERIALRX_SPEKTRUM2048:
         // 11 bit frames
         spek_chan_shift = 3;
@@ -335,6 +344,7 @@ bool spektrumInit(const rxConfig_t *rxConfig, rxRuntimeConfig_t *rxRuntimeConfig
 
     rxRuntimeConfig->rcReadRawFn = spektrumReadRawRC;
     rxRuntimeConfig->rcFrameStatusFn = spektrumFrameStatus;
+    rxRuntimeConfig->rcFrameTimeFn = spektrumFrameTime;
 
     serialPort = openSerialPort(portConfig->identifier,
         FUNCTION_RX_SERIAL,
@@ -47,6 +47,7 @@
 #define SUMD_BAUDRATE 115200
 
 static bool sumdFrameDone = false;
+static timeUs_t sumdFrameDoneAt = 0;
 static uint16_t sumdChannels[SUMD_MAX_CHANNEL];
 static uint16_t crc;
 
@@ -90,8 +91,14 @@ static void sumdDataReceive(uint16_t c)
             crc = 0;
         }
     }
-    if (sumdIndex == 2)
+    if (sumdIndex == 2) {
+        if (c > SUMD_MAX_CHANNEL) {
+            // the CRC would be looked for beyond the end of the buffer
+            sumdIndex = 0;
+            return;
+        }
         sumdChannelCount = (uint8_t)c;
+    }
     if (sumdIndex < SUMD_BUFFSIZE)
         sumd[sumdIndex] = (uint8_t)c;
     sumdIndex++;
@@ -101,6 +108,8 @@ static void sumdDataReceive(uint16_t c)
         if (sumdIndex == sumdChannelCount * 2 + 5) {
             sumdIndex = 0;
             sumdFrameDone = true;
+            sumdFrameDoneAt = sumdTime;
+            rxSignalFrameComplete();
         }
 }
 
@@ -112,6 +121,11 @@ static void sumdDataReceive(uint16_t c)
 #define SUMD_FRAME_STATE_OK 0x01
 #define SUMD_FRAME_STATE_FAILSAFE 0x81
 
+static timeUs_t sumdFrameTime(void)
+{
+    return sumdFrameDoneAt;
+}
+
 static uint8_t sumdFrameStatus(void)
 {
     uint8_t channelIndex;
@@ -127,7 +141,7 @@ static uint8_t sumdFrameStatus(void)
     // verify CRC
     if (crc != ((sumd[SUMD_BYTES_PER_CHANNEL * sumdChannelCount + SUMD_OFFSET_CHANNEL_1_HIGH] << 8) |
             (sumd[SUMD_BYTES_PER_CHANNEL * sumdChannelCount + SUMD_OFFSET_CHANNEL_1_LOW])))
-        return frameStatus;
+        return RX_FRAME_DROPPED;
 
     switch (sumd[1]) {
         case SUMD_FRAME_STATE_FAILSAFE:
@@ -144,10 +158,11 @@ static uint8_t sumdFrameStatus(void)
         sumdChannelCount = SUMD_MAX_CHANNEL;
 
     for (channelIndex = 0; channelIndex < sumdChannelCount; channelIndex++) {
+        // channels are sent in 1/8us steps, store them already scaled to PWM range
         sumdChannels[channelIndex] = (
             (sumd[SUMD_BYTES_PER_CHANNEL * channelIndex + SUMD_OFFSET_CHANNEL_1_HIGH] << 8) |
             sumd[SUMD_BYTES_PER_CHANNEL * channelIndex + SUMD_OFFSET_CHANNEL_1_LOW]
-        );
+        ) / 8;
     }
     return frameStatus;
 }
@@ -155,7 +170,7 @@ static uint8_t sumdFrameStatus(void)
 static uint16_t sumdReadRawRC(const rxRuntimeConfig_t *rxRuntimeConfig, uint8_t chan)
 {
     UNUSED(rxRuntimeConfig);
-    return sumdChannels[chan] / 8;
+    return sumdChannels[chan];
 }
 
 bool sumdInit(const rxConfig_t *rxConfig, rxRuntimeConfig_t *rxRuntimeConfig)
@@ -167,8 +182,9 @@ bool sumdInit(const rxConfig_t *rxConfig, rxRuntimeConfig_t *rxRuntimeConfig)
 
     rxRuntimeConfig->rcReadRawFn = sumdReadRawRC;
     rxRuntimeConfig->rcFrameStatusFn = sumdFrameStatus;
+    rxRuntimeConfig->rcFrameTimeFn = sumdFrameTime;
 
-    const serialPortConfig_t *portConfig = findSerialPortConfig(FUNCTION_RX_SERIAL);
+    const serialPortConfig_t *portConfig = serialRxFindPortConfig();
     if (!portConfig) {
         return false;
     }
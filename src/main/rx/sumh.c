@@ -50,6 +50,7 @@
 #define SUMH_FRAME_SIZE 21
 
 static bool sumhFrameDone = false;
+static timeUs_t sumhFrameDoneAt = 0;
 
 static uint8_t sumhFrame[SUMH_FRAME_SIZE];
 static uint32_t sumhChannels[SUMH_MAX_CHANNEL_COUNT];
@@ -75,11 +76,18 @@ static void sumhDataReceive(uint16_t c)
     if (sumhFramePosition == SUMH_FRAME_SIZE - 1) {
         // FIXME at this point the value of 'c' is unused and un tested, what should it be, is it important?
         sumhFrameDone = true;
+        sumhFrameDoneAt = sumhTime;
+        rxSignalFrameComplete();
     } else {
         sumhFramePosition++;
     }
 }
 
+static timeUs_t sumhFrameTime(void)
+{
+    return sumhFrameDoneAt;
+}
+
 static uint8_t sumhFrameStatus(void)
 {
     uint8_t channelIndex;
@@ -121,8 +129,9 @@ bool sumhInit(const rxConfig_t *rxConfig, rxRuntimeConfig_t *rxRuntimeConfig)
 
     rxRuntimeConfig->rcReadRawFn = sumhReadRawRC;
     rxRuntimeConfig->rcFrameStatusFn = sumhFrameStatus;
+    rxRuntimeConfig->rcFrameTimeFn = sumhFrameTime;
 
-    const serialPortConfig_t *portConfig = findSerialPortConfig(FUNCTION_RX_SERIAL);
+    const serialPortConfig_t *portConfig = serialRxFindPortConfig();
     if (!portConfig) {
         return false;
     }
@@ -77,6 +77,7 @@
 #define XBUS_CONVERT_TO_USEC(V) (800 + ((V * 1400) >> 12))
 
 static bool xBusFrameReceived = false;
+static timeUs_t xBusFrameDoneAt = 0;
 static bool xBusDataIncoming = false;
 static uint8_t xBusFramePosition;
 static uint8_t xBusFrameLength;
@@ -249,14 +250,23 @@ static void xBusDataReceive(uint16_t c)
         switch (xBusProvider) {
         case SERIALRX_XBUS_MODE_B:
             xBusUnpackModeBFrame(0);
+            break;
         case SERIALRX_XBUS_MODE_B_RJ01:
             xBusUnpackRJ01Frame();
+            break;
         }
         xBusDataIncoming = false;
         xBusFramePosition = 0;
+        xBusFrameDoneAt = now;
+        rxSignalFrameComplete();
     }
 }
 
+static timeUs_t xBusFrameTime(void)
+{
+    return xBusFrameDoneAt;
+}
+
 // Indicate time to read a frame from the data...
 static uint8_t xBusFrameStatus(void)
 {
@@ -317,8 +327,9 @@ bool xBusInit(const rxConfig_t *rxConfig, rxRuntimeConfig_t *rxRuntimeConfig)
 
     rxRuntimeConfig->rcReadRawFn = xBusReadRawRC;
     rxRuntimeConfig->rcFrameStatusFn = xBusFrameStatus;
+    rxRuntimeConfig->rcFrameTimeFn = xBusFrameTime;
 
-    const serialPortConfig_t *portConfig = findSerialPortConfig(FUNCTION_RX_SERIAL);
+    const serialPortConfig_t *portConfig = serialRxFindPortConfig();
     if (!portConfig) {
         return false;
     }
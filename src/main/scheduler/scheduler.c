@@ -25,6 +25,7 @@
 
 #include "build/build_config.h"
 #include "build/debug.h"
+#include "build/trace.h"
 
 #include "scheduler/scheduler.h"
 
@@ -34,6 +35,8 @@
 #include "common/time.h"
 #include "common/utils.h"
 
+#include "drivers/stack_check.h"
+#include "drivers/system.h"
 #include "drivers/time.h"
 
 // DEBUG_SCHEDULER, timings for:
@@ -48,6 +51,20 @@ static uint32_t totalWaitingTasks;
 static uint32_t totalWaitingTasksSamples;
 
 static bool calculateTaskStatistics;
+static timeUs_t taskTimeBudgetDeadline;     // time by which the running task should have returned
+
+#ifdef USE_SCHEDULER_LOAD_SHEDDING
+#define LOAD_SHEDDING_MAX_LEVEL             3   // sheddable tasks run at no less than 1/8 of their rate
+#define LOAD_SHEDDING_LATE_PERCENT          5   // shed when more of the realtime invocations than this miss a period
+#define LOAD_SHEDDING_SYSTEM_LOAD_PERCENT   100 // or when on average more than one task is waiting
+#define LOAD_SHEDDING_RECOVERY_LOAD_PERCENT 80
+#define LOAD_SHEDDING_RECOVERY_COUNT        10  // consecutive taskSystem() invocations with slack before a level is restored
+
+static uint8_t loadSheddingLevel;
+static uint8_t loadSheddingRecoveryCount;
+static uint32_t realtimeInvocations;
+static uint32_t realtimeLateInvocations;
+#endif
 uint16_t averageSystemLoadPercent = 0;
 
 
@@ -58,11 +75,27 @@ STATIC_UNIT_TESTED int taskQueueSize = 0;
 
 STATIC_UNIT_TESTED cfTask_t* taskQueueArray[TASK_COUNT + 1]; // extra item for NULL pointer at end of queue
 
+#ifdef USE_SCHEDULER_DEADLINE_QUEUE
+// Time-driven tasks are additionally kept in a binary min-heap keyed on their next deadline,
+// so the scheduler only has to look at the tasks that are actually due.
+STATIC_UNIT_TESTED cfTask_t* taskDeadlineHeap[TASK_COUNT];
+STATIC_UNIT_TESTED int taskDeadlineHeapSize = 0;
+
+// Event-driven tasks, in queue (priority) order
+static cfTask_t* eventTaskArray[TASK_COUNT];
+static int eventTaskCount = 0;
+#endif
+
 void queueClear(void)
 {
     memset(taskQueueArray, 0, sizeof(taskQueueArray));
     taskQueuePos = 0;
     taskQueueSize = 0;
+#ifdef USE_SCHEDULER_DEADLINE_QUEUE
+    memset(taskDeadlineHeap, 0, sizeof(taskDeadlineHeap));
+    taskDeadlineHeapSize = 0;
+    eventTaskCount = 0;
+#endif
 }
 
 bool queueContains(cfTask_t *task)
@@ -75,6 +108,106 @@ bool queueContains(cfTask_t *task)
     return false;
 }
 
+#ifdef USE_SCHEDULER_DEADLINE_QUEUE
+
+static inline timeUs_t taskNextExecuteAt(const cfTask_t *task)
+{
+    return task->lastExecutedAt + task->desiredPeriod;
+}
+
+static inline bool deadlineBefore(const cfTask_t *a, const cfTask_t *b)
+{
+    return cmpTimeUs(taskNextExecuteAt(a), taskNextExecuteAt(b)) < 0;
+}
+
+static void deadlineHeapSet(int index, cfTask_t *task)
+{
+    taskDeadlineHeap[index] = task;
+    task->deadlineHeapIndex = index;
+}
+
+static void deadlineHeapSiftUp(int index)
+{
+    cfTask_t *task = taskDeadlineHeap[index];
+    while (index > 0) {
+        const int parent = (index - 1) / 2;
+        if (!deadlineBefore(task, taskDeadlineHeap[parent])) {
+            break;
+        }
+        deadlineHeapSet(index, taskDeadlineHeap[parent]);
+        index = parent;
+    }
+    deadlineHeapSet(index, task);
+}
+
+static void deadlineHeapSiftDown(int index)
+{
+    cfTask_t *task = taskDeadlineHeap[index];
+    for (;;) {
+        int child = 2 * index + 1;
+        if (child >= taskDeadlineHeapSize) {
+            break;
+        }
+        if (child + 1 < taskDeadlineHeapSize && deadlineBefore(taskDeadlineHeap[child + 1], taskDeadlineHeap[child])) {
+            ++child;
+        }
+        if (!deadlineBefore(taskDeadlineHeap[child], task)) {
+            break;
+        }
+        deadlineHeapSet(index, taskDeadlineHeap[child]);
+        index = child;
+    }
+    deadlineHeapSet(index, task);
+}
+
+static bool deadlineHeapContains(const cfTask_t *task)
+{
+    return task->deadlineHeapIndex < taskDeadlineHeapSize && taskDeadlineHeap[task->deadlineHeapIndex] == task;
+}
+
+// Restores the heap property after the deadline of a task has changed
+static void deadlineHeapUpdate(cfTask_t *task)
+{
+    if (deadlineHeapContains(task)) {
+        deadlineHeapSiftUp(task->deadlineHeapIndex);
+        deadlineHeapSiftDown(task->deadlineHeapIndex);
+    }
+}
+
+static void deadlineHeapInsert(cfTask_t *task)
+{
+    deadlineHeapSet(taskDeadlineHeapSize++, task);
+    deadlineHeapSiftUp(task->deadlineHeapIndex);
+}
+
+static void deadlineHeapRemove(cfTask_t *task)
+{
+    if (!deadlineHeapContains(task)) {
+        return;
+    }
+    const int index = task->deadlineHeapIndex;
+    --taskDeadlineHeapSize;
+    if (index < taskDeadlineHeapSize) {
+        deadlineHeapSet(index, taskDeadlineHeap[taskDeadlineHeapSize]);
+        deadlineHeapUpdate(taskDeadlineHeap[index]);
+    }
+    taskDeadlineHeap[taskDeadlineHeapSize] = NULL;
+}
+
+// Refreshes the queue positions and the event-driven task list after the queue has changed
+static void queueUpdatePositions(void)
+{
+    eventTaskCount = 0;
+    for (int ii = 0; ii < taskQueueSize; ++ii) {
+        cfTask_t *task = taskQueueArray[ii];
+        task->queuePosition = ii;
+        if (task->checkFunc) {
+            eventTaskArray[eventTaskCount++] = task;
+        }
+    }
+}
+#endif
+
 bool queueAdd(cfTask_t *task)
 {
     if ((taskQueueSize >= TASK_COUNT) || queueContains(task)) {
@@ -85,6 +218,12 @@ bool queueAdd(cfTask_t *task)
             memmove(&taskQueueArray[ii+1], &taskQueueArray[ii], sizeof(task) * (taskQueueSize - ii));
             taskQueueArray[ii] = task;
             ++taskQueueSize;
+#ifdef USE_SCHEDULER_DEADLINE_QUEUE
+            queueUpdatePositions();
+            if (!task->checkFunc) {
+                deadlineHeapInsert(task);
+            }
+#endif
             return true;
         }
     }
@@ -97,6 +236,10 @@ bool queueRemove(cfTask_t *task)
         if (taskQueueArray[ii] == task) {
             memmove(&taskQueueArray[ii], &taskQueueArray[ii+1], sizeof(task) * (taskQueueSize - ii));
             --taskQueueSize;
+#ifdef USE_SCHEDULER_DEADLINE_QUEUE
+            queueUpdatePositions();
+            deadlineHeapRemove(task);
+#endif
             return true;
         }
     }
@@ -120,6 +263,60 @@ cfTask_t *queueNext(void)
     return taskQueueArray[++taskQueuePos]; // guaranteed to be NULL at end of queue
 }
 
+#ifdef USE_SCHEDULER_LOAD_SHEDDING
+static void loadSheddingSetLevel(uint8_t newLevel)
+{
+    for (int taskId = 0; taskId < TASK_COUNT; taskId++) {
+        cfTask_t *task = &cfTasks[taskId];
+        if (task->sheddable) {
+            task->desiredPeriod = (task->desiredPeriod >> loadSheddingLevel) << newLevel;
+#ifdef USE_SCHEDULER_DEADLINE_QUEUE
+            deadlineHeapUpdate(task);
+#endif
+        }
+    }
+    loadSheddingLevel = newLevel;
+}
+
+// Lowers the rate of sheddable tasks one step at a time while the realtime task misses periods, and restores them once it has had slack for a while
+static void loadSheddingUpdate(void)
+{
+    const uint32_t latePercent = realtimeInvocations ? 100 * realtimeLateInvocations / realtimeInvocations : 0;
+    const bool overloaded = latePercent > LOAD_SHEDDING_LATE_PERCENT || averageSystemLoadPercent > LOAD_SHEDDING_SYSTEM_LOAD_PERCENT;
+    const bool hasSlack = realtimeLateInvocations == 0 && averageSystemLoadPercent < LOAD_SHEDDING_RECOVERY_LOAD_PERCENT;
+    realtimeInvocations = 0;
+    realtimeLateInvocations = 0;
+
+    if (overloaded) {
+        loadSheddingRecoveryCount = 0;
+        if (loadSheddingLevel < LOAD_SHEDDING_MAX_LEVEL) {
+            loadSheddingSetLevel(loadSheddingLevel + 1);
+        }
+    } else if (hasSlack && loadSheddingLevel > 0) {
+        if (++loadSheddingRecoveryCount >= LOAD_SHEDDING_RECOVERY_COUNT) {
+            loadSheddingRecoveryCount = 0;
+            loadSheddingSetLevel(loadSheddingLevel - 1);
+        }
+    } else {
+        loadSheddingRecoveryCount = 0;
+    }
+
+    DEBUG_SET(DEBUG_LOAD_SHEDDING, 0, loadSheddingLevel);
+    DEBUG_SET(DEBUG_LOAD_SHEDDING, 1, latePercent);
+    DEBUG_SET(DEBUG_LOAD_SHEDDING, 2, averageSystemLoadPercent);
+}
+
+uint8_t schedulerGetLoadSheddingLevel(void)
+{
+    return loadSheddingLevel;
+}
+#else
+uint8_t schedulerGetLoadSheddingLevel(void)
+{
+    return 0;
+}
+#endif
+
 void taskSystem(timeUs_t currentTimeUs)
 {
     UNUSED(currentTimeUs);
@@ -133,6 +330,10 @@ void taskSystem(timeUs_t currentTimeUs)
 #if defined(SIMULATOR_BUILD)
     averageSystemLoadPercent = 0;
 #endif
+
+#ifdef USE_SCHEDULER_LOAD_SHEDDING
+    loadSheddingUpdate();
+#endif
 }
 
 #ifndef SKIP_TASK_STATISTICS
@@ -140,12 +341,54 @@ void taskSystem(timeUs_t currentTimeUs)
 timeUs_t checkFuncMaxExecutionTime;
 timeUs_t checkFuncTotalExecutionTime;
 timeUs_t checkFuncMovingSumExecutionTime;
+timeUs_t schedulingMaxTime;
+timeUs_t schedulingMovingSumTime;
+
+#ifdef USE_TASK_STATISTICS_SAMPLING
+// Only about one in TASK_STATISTICS_SAMPLE_INTERVAL executions of each task is timed, on the cycle counter, and so are the
+// check functions and the scheduler itself. The averages are those of the timed executions and the totals are scaled up by
+// the executions each stands for, the maxima are of the timed executions only and so can miss a rare long one.
+#ifndef TASK_STATISTICS_SAMPLE_INTERVAL
+#define TASK_STATISTICS_SAMPLE_INTERVAL 8
+#endif
+
+static uint32_t statisticsSampleSeed = 1;
+static uint8_t checkFuncSampleCountdown;
+static uint8_t schedulingSampleCountdown;
+
+// Executions from one timed execution to the next, random within half the interval either side of it so that a task doing
+// something different every few runs is not always timed on the same one
+STATIC_UNIT_TESTED uint8_t statisticsSampleGap(uint8_t interval)
+{
+    statisticsSampleSeed = statisticsSampleSeed * 1664525 + 1013904223;
+    return interval - interval / 2 + (statisticsSampleSeed >> 24) % (interval / 2 * 2 + 1);
+}
+
+// Returns the number of executions this one stands for when it is to be timed, 0 otherwise
+static inline uint8_t statisticsSampleDue(uint8_t *countdown)
+{
+    if (*countdown) {
+        (*countdown)--;
+        return 0;
+    }
+    const uint8_t gap = statisticsSampleGap(TASK_STATISTICS_SAMPLE_INTERVAL);
+    *countdown = gap - 1;
+    return gap;
+}
+
+static inline timeUs_t cyclesToUs(uint32_t cycles)
+{
+    return cycles / getCyclesPerMicrosecond();
+}
+#endif
 
 void getCheckFuncInfo(cfCheckFuncInfo_t *checkFuncInfo)
 {
     checkFuncInfo->maxExecutionTime = checkFuncMaxExecutionTime;
     checkFuncInfo->totalExecutionTime = checkFuncTotalExecutionTime;
     checkFuncInfo->averageExecutionTime = checkFuncMovingSumExecutionTime / MOVING_SUM_COUNT;
+    checkFuncInfo->maxSchedulingTime = schedulingMaxTime;
+    checkFuncInfo->averageSchedulingTime = schedulingMovingSumTime / MOVING_SUM_COUNT;
 }
 
 void getTaskInfo(cfTaskId_e taskId, cfTaskInfo_t * taskInfo)
@@ -159,17 +402,117 @@ void getTaskInfo(cfTaskId_e taskId, cfTaskInfo_t * taskInfo)
     taskInfo->totalExecutionTime = cfTasks[taskId].totalExecutionTime;
     taskInfo->averageExecutionTime = cfTasks[taskId].movingSumExecutionTime / MOVING_SUM_COUNT;
     taskInfo->latestDeltaTime = cfTasks[taskId].taskLatestDeltaTime;
+#ifdef USE_TASK_STACK_STATISTICS
+    taskInfo->maxStackUsage = cfTasks[taskId].maxStackUsage;
+#else
+    taskInfo->maxStackUsage = 0;
+#endif
+}
+#endif
+
+#ifdef USE_TASK_STACK_STATISTICS
+#define STACK_SAMPLE_INTERVAL_US 10000  // each sample scans the stack, so keep them rare
+
+static cfTaskId_e stackSampleTaskId;
+static timeUs_t stackSampleLastAt;
+
+// Samples one task execution at a time, going round the enabled tasks in turn
+static bool stackSampleDue(const cfTask_t *task, timeUs_t currentTimeUs)
+{
+    return task == &cfTasks[stackSampleTaskId] && cmpTimeUs(currentTimeUs, stackSampleLastAt) >= STACK_SAMPLE_INTERVAL_US;
+}
+
+static void stackSampleNextTask(timeUs_t currentTimeUs)
+{
+    stackSampleLastAt = currentTimeUs;
+    for (int i = 0; i < TASK_COUNT; i++) {
+        stackSampleTaskId = (stackSampleTaskId + 1) % TASK_COUNT;
+        if (queueContains(&cfTasks[stackSampleTaskId])) {
+            break;
+        }
+    }
+}
+#endif
+
+#ifdef USE_TASK_STATISTICS_HISTOGRAM
+static inline uint8_t taskHistogramBucket(timeUs_t value)
+{
+    if (value == 0) {
+        return 0;
+    }
+    return MIN(32 - __builtin_clz(value), TASK_HISTOGRAM_BUCKET_COUNT - 1);
+}
+
+// Called before the task runs, while lastExecutedAt still holds the previous invocation time
+static void taskHistogramAddLateness(cfTask_t *task, timeUs_t currentTimeUs)
+{
+    timeUs_t lateness;
+    if (task->checkFunc) {
+        lateness = currentTimeUs - task->lastSignaledAt;
+    } else {
+        if (task->lastExecutedAt == 0) {
+            return; // first invocation, there is no previous period to be late against
+        }
+        const timeDelta_t overrun = cmpTimeUs(currentTimeUs, task->lastExecutedAt) - task->desiredPeriod;
+        lateness = MAX(overrun, 0);
+        if (overrun >= task->desiredPeriod) {
+            task->histogram.missedPeriods += overrun / task->desiredPeriod;
+        }
+    }
+    task->histogram.lateness[taskHistogramBucket(lateness)]++;
+}
+
+bool getTaskHistogram(cfTaskId_e taskId, cfTaskHistogram_t *histogram)
+{
+    if (taskId >= TASK_COUNT) {
+        return false;
+    }
+    memcpy(histogram, &cfTasks[taskId].histogram, sizeof(*histogram));
+    return true;
+}
+
+// Returns the upper bound of the bucket holding the given percentile, expressed in parts per 10000
+timeUs_t taskHistogramPercentile(const uint32_t *buckets, uint16_t permyriad)
+{
+    uint64_t total = 0;
+    for (int i = 0; i < TASK_HISTOGRAM_BUCKET_COUNT; i++) {
+        total += buckets[i];
+    }
+    if (total == 0) {
+        return 0;
+    }
+    const uint64_t threshold = (total * permyriad + 9999) / 10000;
+    uint64_t count = 0;
+    for (int i = 0; i < TASK_HISTOGRAM_BUCKET_COUNT - 1; i++) {
+        count += buckets[i];
+        if (count >= threshold) {
+            return i == 0 ? 0 : (1 << i) - 1;
+        }
+    }
+    return 1 << (TASK_HISTOGRAM_BUCKET_COUNT - 2); // open ended bucket, report its lower bound
+}
+#else
+bool getTaskHistogram(cfTaskId_e taskId, cfTaskHistogram_t *histogram)
+{
+    UNUSED(taskId);
+    UNUSED(histogram);
+    return false;
 }
 #endif
 
 void rescheduleTask(cfTaskId_e taskId, uint32_t newPeriodMicros)
 {
-    if (taskId == TASK_SELF) {
-        cfTask_t *task = currentTask;
-        task->desiredPeriod = MAX(SCHEDULER_DELAY_LIMIT, newPeriodMicros);  // Limit delay to 100us (10 kHz) to prevent scheduler clogging
-    } else if (taskId < TASK_COUNT) {
-        cfTask_t *task = &cfTasks[taskId];
+    if (taskId == TASK_SELF || taskId < TASK_COUNT) {
+        cfTask_t *task = taskId == TASK_SELF ? currentTask : &cfTasks[taskId];
         task->desiredPeriod = MAX(SCHEDULER_DELAY_LIMIT, newPeriodMicros);  // Limit delay to 100us (10 kHz) to prevent scheduler clogging
+#ifdef USE_SCHEDULER_LOAD_SHEDDING
+        if (task->sheddable) {
+            task->desiredPeriod <<= loadSheddingLevel;  // stay shed until the realtime budget recovers
+        }
+#endif
+#ifdef USE_SCHEDULER_DEADLINE_QUEUE
+        deadlineHeapUpdate(task);
+#endif
     }
 }
 
@@ -181,10 +524,26 @@ void setTaskEnabled(cfTaskId_e taskId, bool enabled)
             queueAdd(task);
         } else {
             queueRemove(task);
+#ifdef USE_TASK_STACK_STATISTICS
+            if (task == &cfTasks[stackSampleTaskId]) {
+                // a disabled task would never be sampled, so move on
+                stackSampleNextTask(stackSampleLastAt);
+            }
+#endif
         }
     }
 }
 
+// An event-driven task with a deadline gets the highest dynamic priority when its check function fires,
+// the realtime guard interval still holds it back until a due realtime task has run
+void setTaskEventDeadline(cfTaskId_e taskId, bool eventDeadline)
+{
+    if (taskId == TASK_SELF || taskId < TASK_COUNT) {
+        cfTask_t *task = taskId == TASK_SELF ? currentTask : &cfTasks[taskId];
+        task->eventDeadline = eventDeadline;
+    }
+}
+
 timeDelta_t getTaskDeltaTime(cfTaskId_e taskId)
 {
     if (taskId == TASK_SELF) {
@@ -196,6 +555,22 @@ timeDelta_t getTaskDeltaTime(cfTaskId_e taskId)
     }
 }
 
+// Time the running task can still use before the next TASK_GYROPID invocation is due
+timeDelta_t schedulerGetTaskTimeBudgetUs(void)
+{
+    return cmpTimeUs(taskTimeBudgetDeadline, micros());
+}
+
+static timeUs_t taskTimeBudgetDeadlineFor(const cfTask_t *task, timeUs_t currentTimeUs)
+{
+    cfTask_t *pidTask = &cfTasks[TASK_GYROPID];
+    if (task != pidTask && queueContains(pidTask)) {
+        return pidTask->lastExecutedAt + pidTask->desiredPeriod;
+    }
+    // task is the PID loop itself, or there is no PID loop to protect
+    return currentTimeUs + task->desiredPeriod;
+}
+
 void schedulerSetCalulateTaskStatistics(bool calculateTaskStatisticsToUse)
 {
     calculateTaskStatistics = calculateTaskStatisticsToUse;
@@ -216,19 +591,103 @@ void schedulerResetTaskStatistics(cfTaskId_e taskId)
         cfTasks[taskId].maxExecutionTime = 0;
     }
 #endif
+#ifdef USE_TASK_STACK_STATISTICS
+    if (taskId == TASK_SELF) {
+        currentTask->maxStackUsage = 0;
+    } else if (taskId < TASK_COUNT) {
+        cfTasks[taskId].maxStackUsage = 0;
+    }
+#endif
+#ifdef USE_TASK_STATISTICS_HISTOGRAM
+    if (taskId == TASK_SELF) {
+        memset(&currentTask->histogram, 0, sizeof(currentTask->histogram));
+    } else if (taskId < TASK_COUNT) {
+        memset(&cfTasks[taskId].histogram, 0, sizeof(cfTasks[taskId].histogram));
+    }
+#endif
 }
 
 void schedulerInit(void)
 {
     calculateTaskStatistics = true;
+    totalWaitingTasks = 0;
+    totalWaitingTasksSamples = 0;
+#ifdef USE_SCHEDULER_LOAD_SHEDDING
+    loadSheddingSetLevel(0);
+    loadSheddingRecoveryCount = 0;
+    realtimeInvocations = 0;
+    realtimeLateInvocations = 0;
+#endif
     queueClear();
     queueAdd(&cfTasks[TASK_SYSTEM]);
 }
 
+// Updates the dynamic priority of an event-driven task, returns true if the task is waiting to be run
+static inline bool updateEventDrivenTask(cfTask_t *task, timeUs_t currentTimeUs)
+{
+#if defined(SCHEDULER_DEBUG)
+    const timeUs_t currentTimeBeforeCheckFuncCall = micros();
+#else
+    const timeUs_t currentTimeBeforeCheckFuncCall = currentTimeUs;
+#endif
+    // Increase priority for event driven tasks
+    if (task->dynamicPriority > 0) {
+        task->taskAgeCycles = 1 + ((currentTimeUs - task->lastSignaledAt) / task->desiredPeriod);
+        task->dynamicPriority = task->eventDeadline ? TASK_PRIORITY_MAX : 1 + task->staticPriority * task->taskAgeCycles;
+        return true;
+    } else if (task->checkFunc(currentTimeBeforeCheckFuncCall, currentTimeBeforeCheckFuncCall - task->lastExecutedAt)) {
+#if defined(SCHEDULER_DEBUG)
+        DEBUG_SET(DEBUG_SCHEDULER, 3, micros() - currentTimeBeforeCheckFuncCall);
+#endif
+#if defined(USE_TASK_STATISTICS_SAMPLING)
+        uint8_t sampleExecutions;
+        if (calculateTaskStatistics && (sampleExecutions = statisticsSampleDue(&checkFuncSampleCountdown))) {
+            const uint32_t checkFuncExecutionTime = micros() - currentTimeBeforeCheckFuncCall;
+            checkFuncMovingSumExecutionTime += checkFuncExecutionTime - checkFuncMovingSumExecutionTime / MOVING_SUM_COUNT;
+            checkFuncTotalExecutionTime += checkFuncExecutionTime * sampleExecutions;
+            checkFuncMaxExecutionTime = MAX(checkFuncMaxExecutionTime, checkFuncExecutionTime);
+        }
+#elif !defined(SKIP_TASK_STATISTICS)
+        if (calculateTaskStatistics) {
+            const uint32_t checkFuncExecutionTime = micros() - currentTimeBeforeCheckFuncCall;
+            checkFuncMovingSumExecutionTime += checkFuncExecutionTime - checkFuncMovingSumExecutionTime / MOVING_SUM_COUNT;
+            checkFuncTotalExecutionTime += checkFuncExecutionTime;   // time consumed by scheduler + task
+            checkFuncMaxExecutionTime = MAX(checkFuncMaxExecutionTime, checkFuncExecutionTime);
+        }
+#endif
+        task->lastSignaledAt = currentTimeBeforeCheckFuncCall;
+        task->taskAgeCycles = 1;
+        task->dynamicPriority = task->eventDeadline ? TASK_PRIORITY_MAX : 1 + task->staticPriority;
+        return true;
+    } else {
+        task->taskAgeCycles = 0;
+        return false;
+    }
+}
+
+#ifdef USE_SCHEDULER_DEADLINE_QUEUE
+// Tasks are not visited in queue order, so ties are broken by queue position to select the same task as a queue scan
+static inline bool taskIsPreferred(const cfTask_t *task, const cfTask_t *selectedTask, uint16_t selectedTaskDynamicPriority, bool outsideRealtimeGuardInterval)
+{
+    if (task->dynamicPriority < selectedTaskDynamicPriority || task->dynamicPriority == 0) {
+        return false;
+    }
+    if (task->dynamicPriority == selectedTaskDynamicPriority && task->queuePosition > selectedTask->queuePosition) {
+        return false;
+    }
+    return (outsideRealtimeGuardInterval) ||
+        (task->taskAgeCycles > 1) ||
+        (task->staticPriority == TASK_PRIORITY_REALTIME);
+}
+#endif
+
 void scheduler(void)
 {
     // Cache currentTime
     const timeUs_t currentTimeUs = micros();
+#ifdef USE_CYCLE_TRACE
+    const uint32_t traceStartCycles = getCycleCounter();
+#endif
 
     // Check for realtime tasks
     bool outsideRealtimeGuardInterval = true;
@@ -246,37 +705,60 @@ void scheduler(void)
 
     // Update task dynamic priorities
     uint16_t waitingTasks = 0;
+#ifdef USE_SCHEDULER_DEADLINE_QUEUE
+    // Time-driven tasks that are due form a subtree at the root of the deadline heap,
+    // so descend from the root and stop at the first task on each branch that is not yet due.
+    int dueTaskStack[TASK_COUNT];
+    int dueTaskStackSize = 0;
+    if (taskDeadlineHeapSize > 0) {
+        dueTaskStack[dueTaskStackSize++] = 0;
+    }
+    while (dueTaskStackSize > 0) {
+        const int index = dueTaskStack[--dueTaskStackSize];
+        cfTask_t *task = taskDeadlineHeap[index];
+        if (cmpTimeUs(currentTimeUs, taskNextExecuteAt(task)) < 0) {
+            continue;
+        }
+        const int child = 2 * index + 1;
+        if (child < taskDeadlineHeapSize) {
+            dueTaskStack[dueTaskStackSize++] = child;
+        }
+        if (child + 1 < taskDeadlineHeapSize) {
+            dueTaskStack[dueTaskStackSize++] = child + 1;
+        }
+
+        // Task is time-driven, dynamicPriority is last execution age (measured in desiredPeriods)
+        task->taskAgeCycles = ((currentTimeUs - task->lastExecutedAt) / task->desiredPeriod);
+        task->dynamicPriority = 1 + task->staticPriority * task->taskAgeCycles;
+        waitingTasks++;
+
+        if (taskIsPreferred(task, selectedTask, selectedTaskDynamicPriority, outsideRealtimeGuardInterval)) {
+            selectedTaskDynamicPriority = task->dynamicPriority;
+            selectedTask = task;
+        }
+    }
+
+    for (int ii = 0; ii < eventTaskCount; ++ii) {
+        cfTask_t *task = eventTaskArray[ii];
+        if (!outsideRealtimeGuardInterval && task->dynamicPriority == 0 && task->staticPriority < TASK_PRIORITY_REALTIME) {
+            // A newly signalled task could not be chosen while a realtime task is due, so defer the check function
+            task->taskAgeCycles = 0;
+            continue;
+        }
+        if (updateEventDrivenTask(task, currentTimeUs)) {
+            waitingTasks++;
+        }
+        if (taskIsPreferred(task, selectedTask, selectedTaskDynamicPriority, outsideRealtimeGuardInterval)) {
+            selectedTaskDynamicPriority = task->dynamicPriority;
+            selectedTask = task;
+        }
+    }
+#else
     for (cfTask_t *task = queueFirst(); task != NULL; task = queueNext()) {
         // Task has checkFunc - event driven
         if (task->checkFunc) {
-#if defined(SCHEDULER_DEBUG)
-            const timeUs_t currentTimeBeforeCheckFuncCall = micros();
-#else
-            const timeUs_t currentTimeBeforeCheckFuncCall = currentTimeUs;
-#endif
-            // Increase priority for event driven tasks
-            if (task->dynamicPriority > 0) {
-                task->taskAgeCycles = 1 + ((currentTimeUs - task->lastSignaledAt) / task->desiredPeriod);
-                task->dynamicPriority = 1 + task->staticPriority * task->taskAgeCycles;
+            if (updateEventDrivenTask(task, currentTimeUs)) {
                 waitingTasks++;
-            } else if (task->checkFunc(currentTimeBeforeCheckFuncCall, currentTimeBeforeCheckFuncCall - task->lastExecutedAt)) {
-#if defined(SCHEDULER_DEBUG)
-                DEBUG_SET(DEBUG_SCHEDULER, 3, micros() - currentTimeBeforeCheckFuncCall);
-#endif
-#ifndef SKIP_TASK_STATISTICS
-                if (calculateTaskStatistics) {
-                    const uint32_t checkFuncExecutionTime = micros() - currentTimeBeforeCheckFuncCall;
-                    checkFuncMovingSumExecutionTime += checkFuncExecutionTime - checkFuncMovingSumExecutionTime / MOVING_SUM_COUNT;
-                    checkFuncTotalExecutionTime += checkFuncExecutionTime;   // time consumed by scheduler + task
-                    checkFuncMaxExecutionTime = MAX(checkFuncMaxExecutionTime, checkFuncExecutionTime);
-                }
-#endif
-                task->lastSignaledAt = currentTimeBeforeCheckFuncCall;
-                task->taskAgeCycles = 1;
-                task->dynamicPriority = 1 + task->staticPriority;
-                waitingTasks++;
-            } else {
-                task->taskAgeCycles = 0;
             }
         } else {
             // Task is time-driven, dynamicPriority is last execution age (measured in desiredPeriods)
@@ -299,29 +781,89 @@ void scheduler(void)
             }
         }
     }
+#endif
 
     totalWaitingTasksSamples++;
     totalWaitingTasks += waitingTasks;
 
+#ifndef SKIP_TASK_STATISTICS
+#ifdef USE_TASK_STATISTICS_SAMPLING
+    if (calculateTaskStatistics && statisticsSampleDue(&schedulingSampleCountdown)) {
+#else
+    if (calculateTaskStatistics) {
+#endif
+        const timeUs_t schedulingTime = micros() - currentTimeUs;
+        schedulingMovingSumTime += schedulingTime - schedulingMovingSumTime / MOVING_SUM_COUNT;
+        schedulingMaxTime = MAX(schedulingMaxTime, schedulingTime);
+    }
+#endif
+
     currentTask = selectedTask;
 
     if (selectedTask) {
         // Found a task that should be run
+        TRACE_SPAN(TRACE_SCHEDULER, traceStartCycles);
+#ifdef USE_SCHEDULER_LOAD_SHEDDING
+        if (selectedTask == &cfTasks[TASK_GYROPID]) {
+            realtimeInvocations++;
+            if (cmpTimeUs(currentTimeUs, selectedTask->lastExecutedAt) >= 2 * selectedTask->desiredPeriod) {
+                realtimeLateInvocations++;
+            }
+        }
+#endif
+#ifdef USE_TASK_STATISTICS_HISTOGRAM
+        if (calculateTaskStatistics) {
+            taskHistogramAddLateness(selectedTask, currentTimeUs);
+        }
+#endif
         selectedTask->taskLatestDeltaTime = currentTimeUs - selectedTask->lastExecutedAt;
         selectedTask->lastExecutedAt = currentTimeUs;
         selectedTask->dynamicPriority = 0;
+#ifdef USE_SCHEDULER_DEADLINE_QUEUE
+        deadlineHeapUpdate(selectedTask);
+#endif
+        taskTimeBudgetDeadline = taskTimeBudgetDeadlineFor(selectedTask, currentTimeUs);
 
         // Execute task
 #ifdef SKIP_TASK_STATISTICS
         selectedTask->taskFunc(currentTimeUs);
+#else
+#ifdef USE_TASK_STATISTICS_SAMPLING
+        uint8_t sampleExecutions;
+        if (calculateTaskStatistics && (sampleExecutions = statisticsSampleDue(&selectedTask->statisticsSampleCountdown))) {
 #else
         if (calculateTaskStatistics) {
+#endif
+#ifdef USE_TASK_STACK_STATISTICS
+            const bool sampleStack = stackSampleDue(selectedTask, currentTimeUs);
+            if (sampleStack) {
+                // clear what earlier tasks left on the stack, so only this task is measured
+                stackSampleUsage();
+            }
+#endif
+#ifdef USE_TASK_STATISTICS_SAMPLING
+            const uint32_t startCycles = getCycleCounter();
+            selectedTask->taskFunc(currentTimeUs);
+            const timeUs_t taskExecutionTime = cyclesToUs(getCycleCounter() - startCycles);
+            selectedTask->movingSumExecutionTime += taskExecutionTime - selectedTask->movingSumExecutionTime / MOVING_SUM_COUNT;
+            selectedTask->totalExecutionTime += taskExecutionTime * sampleExecutions;
+#else
             const timeUs_t currentTimeBeforeTaskCall = micros();
             selectedTask->taskFunc(currentTimeBeforeTaskCall);
             const timeUs_t taskExecutionTime = micros() - currentTimeBeforeTaskCall;
             selectedTask->movingSumExecutionTime += taskExecutionTime - selectedTask->movingSumExecutionTime / MOVING_SUM_COUNT;
             selectedTask->totalExecutionTime += taskExecutionTime;   // time consumed by scheduler + task
+#endif
             selectedTask->maxExecutionTime = MAX(selectedTask->maxExecutionTime, taskExecutionTime);
+#ifdef USE_TASK_STATISTICS_HISTOGRAM
+            selectedTask->histogram.executionTime[taskHistogramBucket(taskExecutionTime)]++;
+#endif
+#ifdef USE_TASK_STACK_STATISTICS
+            if (sampleStack) {
+                selectedTask->maxStackUsage = MAX(selectedTask->maxStackUsage, stackSampleUsage());
+                stackSampleNextTask(currentTimeUs);
+            }
+#endif
         } else {
             selectedTask->taskFunc(currentTimeUs);
         }
@@ -336,3 +878,9 @@ void scheduler(void)
 
     GET_SCHEDULER_LOCALS();
 }
+
+// True when the last scheduler() call found no task to run
+bool schedulerIsIdle(void)
+{
+    return currentTask == NULL;
+}
@@ -33,6 +33,8 @@ typedef struct {
     timeUs_t     maxExecutionTime;
     timeUs_t     totalExecutionTime;
     timeUs_t     averageExecutionTime;
+    timeUs_t     maxSchedulingTime;     // time spent selecting the task to run, per scheduler pass
+    timeUs_t     averageSchedulingTime;
 } cfCheckFuncInfo_t;
 
 typedef struct {
@@ -45,8 +47,17 @@ typedef struct {
     timeUs_t     maxExecutionTime;
     timeUs_t     totalExecutionTime;
     timeUs_t     averageExecutionTime;
+    uint32_t     maxStackUsage;         // deepest stack seen while the task ran, 0 if not sampled
 } cfTaskInfo_t;
 
+#define TASK_HISTOGRAM_BUCKET_COUNT 16  // bucket 0 holds 0us, bucket n holds [2^(n-1), 2^n) us, the last bucket is open ended
+
+typedef struct {
+    uint32_t     executionTime[TASK_HISTOGRAM_BUCKET_COUNT];
+    uint32_t     lateness[TASK_HISTOGRAM_BUCKET_COUNT];    // time past the desired period, or since the event for event-driven tasks
+    uint32_t     missedPeriods;                            // whole periods skipped by time-driven tasks
+} cfTaskHistogram_t;
+
 typedef enum {
     /* Actual tasks */
     TASK_SYSTEM = 0,
@@ -62,6 +73,9 @@ typedef enum {
 #ifdef BEEPER
     TASK_BEEPER,
 #endif
+#ifdef BLACKBOX
+    TASK_BLACKBOX,
+#endif
 #ifdef GPS
     TASK_GPS,
 #endif
@@ -118,6 +132,10 @@ typedef enum {
     TASK_RCSPLIT,
 #endif
 
+#ifdef USE_ASYNC_CONFIG_SAVE
+    TASK_CONFIG_SAVE,
+#endif
+
     /* Count of real tasks */
     TASK_COUNT,
 
@@ -134,6 +152,8 @@ typedef struct {
     void (*taskFunc)(timeUs_t currentTimeUs);
     timeDelta_t desiredPeriod;      // target period of execution
     const uint8_t staticPriority;   // dynamicPriority grows in steps of this size, shouldn't be zero
+    const bool sheddable;           // rate may be lowered when the realtime task runs out of time
+    bool eventDeadline;             // once signalled, runs ahead of every task but a realtime task that is due
 
     // Scheduling
     uint16_t dynamicPriority;       // measurement of how old task was last executed, used to avoid task starvation
@@ -141,6 +161,10 @@ typedef struct {
     timeDelta_t taskLatestDeltaTime;
     timeUs_t lastExecutedAt;        // last time of invocation
     timeUs_t lastSignaledAt;        // time of invocation event for event-driven tasks
+#ifdef USE_SCHEDULER_DEADLINE_QUEUE
+    uint8_t deadlineHeapIndex;      // position in the deadline heap, time-driven tasks only
+    uint8_t queuePosition;          // position in the priority queue, used to break ties in queue order
+#endif
 
 #ifndef SKIP_TASK_STATISTICS
     // Statistics
@@ -148,6 +172,15 @@ typedef struct {
     timeUs_t maxExecutionTime;
     timeUs_t totalExecutionTime;    // total time consumed by task since boot
 #endif
+#ifdef USE_TASK_STATISTICS_SAMPLING
+    uint8_t statisticsSampleCountdown;  // executions left until the next timed one
+#endif
+#ifdef USE_TASK_STATISTICS_HISTOGRAM
+    cfTaskHistogram_t histogram;
+#endif
+#ifdef USE_TASK_STACK_STATISTICS
+    uint16_t maxStackUsage;         // bytes, including the scheduler's own frames below the task
+#endif
 } cfTask_t;
 
 extern cfTask_t cfTasks[TASK_COUNT];
@@ -155,14 +188,20 @@ extern uint16_t averageSystemLoadPercent;
 
 void getCheckFuncInfo(cfCheckFuncInfo_t *checkFuncInfo);
 void getTaskInfo(cfTaskId_e taskId, cfTaskInfo_t *taskInfo);
+bool getTaskHistogram(cfTaskId_e taskId, cfTaskHistogram_t *histogram);
+timeUs_t taskHistogramPercentile(const uint32_t *buckets, uint16_t permyriad);
 void rescheduleTask(cfTaskId_e taskId, uint32_t newPeriodMicros);
 void setTaskEnabled(cfTaskId_e taskId, bool newEnabledState);
+void setTaskEventDeadline(cfTaskId_e taskId, bool eventDeadline);
 timeDelta_t getTaskDeltaTime(cfTaskId_e taskId);
+timeDelta_t schedulerGetTaskTimeBudgetUs(void);
 void schedulerSetCalulateTaskStatistics(bool calculateTaskStatistics);
 void schedulerResetTaskStatistics(cfTaskId_e taskId);
+uint8_t schedulerGetLoadSheddingLevel(void);
 
 void schedulerInit(void);
 void scheduler(void);
+bool schedulerIsIdle(void);
 void taskSystem(timeUs_t currentTime);
 
 #define LOAD_PERCENTAGE_ONE 100
@@ -79,8 +79,9 @@ static flightDynamicsTrims_t *accelerationTrims;
 
 static uint16_t accLpfCutHz = 0;
 static biquadFilter_t accFilter[XYZ_AXIS_COUNT];
+static sensorAlignment_t accAlignment;
 
-PG_REGISTER_WITH_RESET_FN(accelerometerConfig_t, accelerometerConfig, PG_ACCELEROMETER_CONFIG, 0);
+PG_REGISTER_WITH_RESET_FN(accelerometerConfig_t, accelerometerConfig, PG_ACCELEROMETER_CONFIG, 1);
 
 void resetRollAndPitchTrims(rollAndPitchTrims_t *rollAndPitchTrims)
 {
@@ -112,7 +113,8 @@ void pgResetFn_accelerometerConfig(accelerometerConfig_t *instance)
     RESET_CONFIG_2(accelerometerConfig_t, instance,
         .acc_lpf_hz = 10,
         .acc_align = ALIGN_DEFAULT,
-        .acc_hardware = ACC_DEFAULT
+        .acc_hardware = ACC_DEFAULT,
+        .acc_burst_read = false
     );
     resetRollAndPitchTrims(&instance->accelerometerTrims);
     resetFlightDynamicsTrims(&instance->accZero);
@@ -326,6 +328,10 @@ bool accInit(uint32_t gyroSamplingInverval)
         acc.accSamplingInterval = 1000;
 #endif
     }
+    if (accelerometerConfig()->acc_burst_read && gyroSetAccBurstRead(&acc.dev)) {
+        // each read is already the mean of the gyro rate samples since the last one
+        acc.accSamplingInterval = ACC_BURST_SAMPLING_INTERVAL_US;
+    }
     if (accLpfCutHz) {
         for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
             biquadFilterInitLPF(&accFilter[axis], accLpfCutHz, acc.accSamplingInterval);
@@ -334,6 +340,7 @@ bool accInit(uint32_t gyroSamplingInverval)
     if (accelerometerConfig()->acc_align != ALIGN_DEFAULT) {
         acc.dev.accAlign = accelerometerConfig()->acc_align;
     }
+    buildAlignmentMatrix(&accAlignment, acc.dev.accAlign, 1.0f);
     return true;
 }
 
@@ -456,18 +463,23 @@ void accUpdate(rollAndPitchTrims_t *rollAndPitchTrims)
     }
     acc.isAccelUpdatedAtLeastOnce = true;
 
+    float accSample[XYZ_AXIS_COUNT];
     for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
         DEBUG_SET(DEBUG_ACCELEROMETER, axis, acc.dev.ADCRaw[axis]);
-        acc.accSmooth[axis] = acc.dev.ADCRaw[axis];
+        accSample[axis] = acc.dev.ADCRaw[axis];
     }
 
     if (accLpfCutHz) {
         for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
-            acc.accSmooth[axis] = lrintf(biquadFilterApply(&accFilter[axis], (float)acc.accSmooth[axis]));
+            accSample[axis] = biquadFilterApply(&accFilter[axis], accSample[axis]);
         }
     }
 
-    alignSensors(acc.accSmooth, acc.dev.accAlign);
+    // aligned while still in float, so the filtered sample is only rounded once
+    applyAlignmentMatrix(&accAlignment, accSample, accSample);
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        acc.accSmooth[axis] = lrintf(accSample[axis]);
+    }
 
     if (!isAccelerationCalibrationComplete()) {
         performAcclerationCalibration(rollAndPitchTrims);
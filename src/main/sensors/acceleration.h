@@ -41,6 +41,8 @@ typedef enum {
     ACC_FAKE
 } accelerationSensor_e;
 
+#define ACC_BURST_SAMPLING_INTERVAL_US 4000    // acc task interval when the acc is read with the gyro
+
 typedef struct acc_s {
     accDev_t dev;
     uint32_t accSamplingInterval;
@@ -65,6 +67,7 @@ typedef struct accelerometerConfig_s {
     uint16_t acc_lpf_hz;                    // cutoff frequency for the low pass filter used on the acc z-axis for althold in Hz
     sensor_align_e acc_align;               // acc alignment
     uint8_t acc_hardware;                   // Which acc hardware to use on boards with more than one device
+    uint8_t acc_burst_read;                 // read the acc in the gyro's SPI transfer, averaged down to the acc task rate
     flightDynamicsTrims_t accZero;
     rollAndPitchTrims_t accelerometerTrims;
 } accelerometerConfig_t;
@@ -53,8 +53,6 @@ void pgResetFn_barometerConfig(barometerConfig_t *barometerConfig)
 {
     barometerConfig->baro_sample_count = 21;
     barometerConfig->baro_noise_lpf = 600;
-    barometerConfig->baro_cf_vel = 985;
-    barometerConfig->baro_cf_alt = 965;
     barometerConfig->baro_hardware = BARO_DEFAULT;
 
     // For backward compatibility; ceate a valid default value for bus parameters
@@ -111,7 +109,7 @@ static int32_t baroTemperature = 0;
 
 static int32_t baroGroundAltitude = 0;
 static int32_t baroGroundPressure = 8*101325;
-static uint32_t baroPressureSum = 0;
+static int32_t baroPressureFiltered = 0;    // Pa, Q8 fixed point
 
 bool baroDetect(baroDev_t *dev, baroSensor_e baroHardwareToUse)
 {
@@ -213,54 +211,31 @@ void baroSetCalibrationCycles(uint16_t calibrationCyclesRequired)
 
 static bool baroReady = false;
 
-#define PRESSURE_SAMPLES_MEDIAN 3
+#define BARO_PRESSURE_FRACTION_BITS 8
+#define BARO_FILTER_GAIN_BITS       16
 
-static int32_t applyBarometerMedianFilter(int32_t newPressureReading)
+/*
+ * First order low pass on the pressure, in fixed point so the fraction survives between samples.
+ * The gain 2 / (baro_sample_count + 1) gives it the noise of a baro_sample_count long moving average
+ * at a fraction of the delay, and it needs no sample history.
+ */
+static void baroFilterPressure(uint8_t baroSampleCount, int32_t newPressureReading)
 {
-    static int32_t barometerFilterSamples[PRESSURE_SAMPLES_MEDIAN];
-    static int currentFilterSampleIndex = 0;
-    static bool medianFilterReady = false;
-    int nextSampleIndex;
-
-    nextSampleIndex = (currentFilterSampleIndex + 1);
-    if (nextSampleIndex == PRESSURE_SAMPLES_MEDIAN) {
-        nextSampleIndex = 0;
-        medianFilterReady = true;
+    static uint8_t samples = 0;
+
+    const int32_t pressure = newPressureReading << BARO_PRESSURE_FRACTION_BITS;
+    if (samples == 0 || baroSampleCount <= 1) {
+        baroPressureFiltered = pressure;
+    } else {
+        const int32_t gain = (2 << BARO_FILTER_GAIN_BITS) / (baroSampleCount + 1);
+        baroPressureFiltered += ((int64_t)(pressure - baroPressureFiltered) * gain) >> BARO_FILTER_GAIN_BITS;
     }
 
-    barometerFilterSamples[currentFilterSampleIndex] = newPressureReading;
-    currentFilterSampleIndex = nextSampleIndex;
-
-    if (medianFilterReady)
-        return quickMedianFilter3(barometerFilterSamples);
-    else
-        return newPressureReading;
-}
-
-#define PRESSURE_SAMPLE_COUNT (barometerConfig()->baro_sample_count - 1)
-
-static uint32_t recalculateBarometerTotal(uint8_t baroSampleCount, uint32_t pressureTotal, int32_t newPressureReading)
-{
-    static int32_t barometerSamples[BARO_SAMPLE_COUNT_MAX];
-    static int currentSampleIndex = 0;
-    int nextSampleIndex;
-
-    // store current pressure in barometerSamples
-    nextSampleIndex = (currentSampleIndex + 1);
-    if (nextSampleIndex == baroSampleCount) {
-        nextSampleIndex = 0;
+    if (samples < baroSampleCount) {
+        samples++;
+    } else {
         baroReady = true;
     }
-    barometerSamples[currentSampleIndex] = applyBarometerMedianFilter(newPressureReading);
-
-    // recalculate pressure total
-    // Note, the pressure total is made up of baroSampleCount - 1 samples - See PRESSURE_SAMPLE_COUNT
-    pressureTotal += barometerSamples[currentSampleIndex];
-    pressureTotal -= barometerSamples[nextSampleIndex];
-
-    currentSampleIndex = nextSampleIndex;
-
-    return pressureTotal;
 }
 
 typedef enum {
@@ -268,18 +243,52 @@ typedef enum {
     BAROMETER_NEEDS_CALCULATION
 } barometerState_e;
 
+// How long to wait before checking again on a read still on the bus
+#define BARO_READ_POLL_DELAY_US 500
+// Pressure conversions per temperature conversion, the temperature only drifts slowly
+#define BARO_PRESSURE_SAMPLES_PER_TEMPERATURE 8
 
 bool isBaroReady(void) {
     return baroReady;
 }
 
+// Starts the driver's read on the first call and returns true once it has landed,
+// so the task never waits for the bus. Drivers without a read function read in get_ut/get_up.
+static bool baroReadComplete(baroReadFuncPtr read)
+{
+    static bool readPending = false;
+
+    if (!read) {
+        return true;
+    }
+
+    if (!readPending) {
+        if (!read(&baro.dev)) {
+            return false; // bus busy with another device, try again on the next pass
+        }
+        readPending = true;
+    }
+
+    bool error;
+    if (busBusy(&baro.dev.busdev, &error)) {
+        return false;
+    }
+    readPending = false;
+
+    return !error; // a failed read is started again on the next pass
+}
+
 uint32_t baroUpdate(void)
 {
     static barometerState_e state = BAROMETER_NEEDS_SAMPLES;
+    static uint8_t pressureSamples = 0;
 
     switch (state) {
         default:
         case BAROMETER_NEEDS_SAMPLES:
+            if (!baroReadComplete(baro.dev.read_ut)) {
+                return BARO_READ_POLL_DELAY_US;
+            }
             baro.dev.get_ut(&baro.dev);
             baro.dev.start_up(&baro.dev);
             state = BAROMETER_NEEDS_CALCULATION;
@@ -287,12 +296,21 @@ uint32_t baroUpdate(void)
         break;
 
         case BAROMETER_NEEDS_CALCULATION:
+            if (!baroReadComplete(baro.dev.read_up)) {
+                return BARO_READ_POLL_DELAY_US;
+            }
             baro.dev.get_up(&baro.dev);
-            baro.dev.start_ut(&baro.dev);
+            // start the next conversion before calculating, so it runs meanwhile
+            if (++pressureSamples < BARO_PRESSURE_SAMPLES_PER_TEMPERATURE) {
+                baro.dev.start_up(&baro.dev);
+            } else {
+                pressureSamples = 0;
+                baro.dev.start_ut(&baro.dev);
+                state = BAROMETER_NEEDS_SAMPLES;
+            }
             baro.dev.calculate(&baroPressure, &baroTemperature);
-            baroPressureSum = recalculateBarometerTotal(barometerConfig()->baro_sample_count, baroPressureSum, baroPressure);
-            state = BAROMETER_NEEDS_SAMPLES;
-            return baro.dev.ut_delay;
+            baroFilterPressure(barometerConfig()->baro_sample_count, baroPressure);
+            return state == BAROMETER_NEEDS_SAMPLES ? baro.dev.ut_delay : baro.dev.up_delay;
         break;
     }
 }
@@ -304,7 +322,7 @@ int32_t baroCalculateAltitude(void)
     // calculates height from ground via baro readings
     // see: https://github.com/diydrones/ardupilot/blob/master/libraries/AP_Baro/AP_Baro.cpp#L140
     if (isBaroCalibrationComplete()) {
-        BaroAlt_tmp = lrintf((1.0f - powf((float)(baroPressureSum / PRESSURE_SAMPLE_COUNT) / 101325.0f, 0.190295f)) * 4433000.0f); // in cm
+        BaroAlt_tmp = lrintf((1.0f - powf((float)baroPressureFiltered / ((1 << BARO_PRESSURE_FRACTION_BITS) * 101325.0f), 0.190295f)) * 4433000.0f); // in cm
         BaroAlt_tmp -= baroGroundAltitude;
         baro.BaroAlt = lrintf((float)baro.BaroAlt * CONVERT_PARAMETER_TO_FLOAT(barometerConfig()->baro_noise_lpf) + (float)BaroAlt_tmp * (1.0f - CONVERT_PARAMETER_TO_FLOAT(barometerConfig()->baro_noise_lpf))); // additional LPF to reduce baro noise
     }
@@ -319,7 +337,7 @@ void performBaroCalibrationCycle(void)
     static int32_t savedGroundPressure = 0;
 
     baroGroundPressure -= baroGroundPressure / 8;
-    baroGroundPressure += baroPressureSum / PRESSURE_SAMPLE_COUNT;
+    baroGroundPressure += baroPressureFiltered >> BARO_PRESSURE_FRACTION_BITS;
     baroGroundAltitude = (1.0f - powf((baroGroundPressure / 8) / 101325.0f, 0.190295f)) * 4433000.0f;
 
     if (baroGroundPressure == savedGroundPressure)
@@ -37,10 +37,8 @@ typedef struct barometerConfig_s {
     uint8_t baro_i2c_device;
     uint8_t baro_i2c_address;
     uint8_t baro_hardware;                  // Barometer hardware to use
-    uint8_t baro_sample_count;              // size of baro filter array
+    uint8_t baro_sample_count;              // moving average length the pressure low pass matches
     uint16_t baro_noise_lpf;                // additional LPF to reduce baro noise
-    uint16_t baro_cf_vel;                   // apply Complimentary Filter to keep the calculated velocity based on baro velocity (i.e. near real velocity)
-    uint16_t baro_cf_alt;                   // apply CF to use ACC for height estimation
 } barometerConfig_t;
 
 PG_DECLARE(barometerConfig_t, barometerConfig);
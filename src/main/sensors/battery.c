@@ -57,6 +57,12 @@ static void batteryUpdateConsumptionState(void); // temporary forward reference
 
 #define VBAT_STABLE_MAX_DELTA 2
 
+// Sag model, the pack's internal resistance is learnt from how the voltage follows steps in the current
+#define BATTERY_SAG_MIN_CURRENT_STEP    500         // centiamps, smaller steps are lost in the 0.1V resolution
+#define BATTERY_SAG_MAX_RESISTANCE      500         // mOhm, anything higher is taken to be noise
+#define BATTERY_SAG_WINDOW_US           1000000     // a step has to come within this, or discharge is mistaken for sag
+#define BATTERY_SAG_LEARN_SHIFT         3           // each estimate moves the resistance 1/8 of the way
+
 // Battery monitoring stuff
 uint8_t batteryCellCount; // Note: this can be 0 when no battery is detected or when the battery voltage sensor is missing or disabled.
 uint16_t batteryWarningVoltage;
@@ -69,6 +75,10 @@ static batteryState_e batteryState;
 static batteryState_e voltageState;
 static batteryState_e consumptionState;
 
+static uint16_t batteryResistance;          // mOhm, 0 until learnt
+static uint16_t batteryRestingVoltage;      // 0.1V steps, the filtered voltage with the sag taken out
+static float vbatPidCompensation = 1.0f;    // worked out at battery task rate for the mixer
+
 #ifndef DEFAULT_CURRENT_METER_SOURCE
 #ifdef USE_VIRTUAL_CURRENT_METER
 #define DEFAULT_CURRENT_METER_SOURCE CURRENT_METER_VIRTUAL
@@ -130,10 +140,18 @@ void batteryUpdateVoltage(timeUs_t currentTimeUs)
             break;
     }
 
-    if (debugMode == DEBUG_BATTERY) {
-        debug[0] = voltageMeter.unfiltered;
-        debug[1] = voltageMeter.filtered;
+    // I x R in 0.1V steps is centiamps x mOhm / 10000
+    batteryRestingVoltage = voltageMeter.filtered + (MAX(currentMeter.amperage, 0) * batteryResistance) / 10000;
+
+    vbatPidCompensation = 1.0f;
+    if (batteryCellCount > 0 && voltageMeter.filtered > 0) {
+        // Up to 33% PID gain. Should be fine for 4,2to 3,3 difference
+        // The motors get the loaded voltage, so this goes by that rather than the resting one
+        vbatPidCompensation = constrainf((((float)batteryConfig()->vbatmaxcellvoltage * batteryCellCount) / (float)voltageMeter.filtered), 1.0f, 1.33f);
     }
+
+    DEBUG_SET(DEBUG_BATTERY, 0, voltageMeter.unfiltered);
+    DEBUG_SET(DEBUG_BATTERY, 1, voltageMeter.filtered);
 }
 
 static void updateBatteryBeeperAlert(void)
@@ -197,10 +215,8 @@ void batteryUpdatePresence(void)
         batteryCriticalVoltage = 0;
     }
 
-    if (debugMode == DEBUG_BATTERY) {
-        debug[2] = voltageState;
-        debug[3] = batteryCellCount;
-    }
+    DEBUG_SET(DEBUG_BATTERY, 2, voltageState);
+    DEBUG_SET(DEBUG_BATTERY, 3, batteryCellCount);
 
     previousVoltage = voltageMeter.filtered; // record the current value so we can detect voltage stabilisation next the presence needs updating.
 }
@@ -208,23 +224,24 @@ void batteryUpdatePresence(void)
 static void batteryUpdateVoltageState(void)
 {
     // alerts are currently used by beeper, osd and other subsystems
+    // they go by the resting voltage, so a punch out does not set them off while a tired pack still does
     switch (voltageState) {
         case BATTERY_OK:
-            if (voltageMeter.filtered <= (batteryWarningVoltage - batteryConfig()->vbathysteresis)) {
+            if (batteryRestingVoltage <= (batteryWarningVoltage - batteryConfig()->vbathysteresis)) {
                 voltageState = BATTERY_WARNING;
             }
             break;
 
         case BATTERY_WARNING:
-            if (voltageMeter.filtered <= (batteryCriticalVoltage - batteryConfig()->vbathysteresis)) {
+            if (batteryRestingVoltage <= (batteryCriticalVoltage - batteryConfig()->vbathysteresis)) {
                 voltageState = BATTERY_CRITICAL;
-            } else if (voltageMeter.filtered > batteryWarningVoltage) {
+            } else if (batteryRestingVoltage > batteryWarningVoltage) {
                 voltageState = BATTERY_OK;
             }
             break;
 
         case BATTERY_CRITICAL:
-            if (voltageMeter.filtered > batteryCriticalVoltage) {
+            if (batteryRestingVoltage > batteryCriticalVoltage) {
                 voltageState = BATTERY_WARNING;
             }
             break;
@@ -268,6 +285,9 @@ void batteryInit(void)
     voltageState = BATTERY_NOT_PRESENT;
     batteryWarningVoltage = 0;
     batteryCriticalVoltage = 0;
+    batteryResistance = 0;
+    batteryRestingVoltage = 0;
+    vbatPidCompensation = 1.0f;
 
     voltageMeterReset(&voltageMeter);
     switch (batteryConfig()->voltageMeterSource) {
@@ -333,11 +353,46 @@ static void batteryUpdateConsumptionState(void)
     }
 }
 
+/*
+ * Learns the internal resistance from a step in the current and the voltage drop that came with it, at current
+ * meter rate. The voltage and the current filters differ, so this goes by the latest samples, which line up.
+ */
+static void batteryUpdateSag(timeUs_t currentTimeUs)
+{
+    static timeUs_t referenceTimeUs;
+    static uint16_t referenceVoltage;
+    static int32_t referenceAmperage;
+
+    if (batteryConfig()->voltageMeterSource == VOLTAGE_METER_NONE) {
+        return;
+    }
+
+    const int32_t currentStep = currentMeter.amperageLatest - referenceAmperage;
+    if (ABS(currentStep) >= BATTERY_SAG_MIN_CURRENT_STEP && cmpTimeUs(currentTimeUs, referenceTimeUs) < BATTERY_SAG_WINDOW_US) {
+        // 0.1V / centiamps to mOhm
+        const int32_t estimate = (((int32_t)referenceVoltage - voltageMeter.unfiltered) * 10000) / currentStep;
+        if (estimate > 0 && estimate <= BATTERY_SAG_MAX_RESISTANCE) {
+            if (batteryResistance == 0) {
+                batteryResistance = estimate;
+            } else {
+                batteryResistance += (estimate - (int32_t)batteryResistance) / (1 << BATTERY_SAG_LEARN_SHIFT);
+            }
+        }
+    } else if (cmpTimeUs(currentTimeUs, referenceTimeUs) < BATTERY_SAG_WINDOW_US) {
+        return;
+    }
+
+    referenceTimeUs = currentTimeUs;
+    referenceVoltage = voltageMeter.unfiltered;
+    referenceAmperage = currentMeter.amperageLatest;
+}
+
 void batteryUpdateCurrentMeter(timeUs_t currentTimeUs)
 {
     UNUSED(currentTimeUs);
     if (batteryCellCount == 0) {
         currentMeterReset(&currentMeter);
+        batteryResistance = 0; // the next pack learns its own
         return;
     }
 
@@ -383,15 +438,13 @@ void batteryUpdateCurrentMeter(timeUs_t currentTimeUs)
             currentMeterReset(&currentMeter);
             break;
     }
+
+    batteryUpdateSag(currentTimeUs);
 }
 
-float calculateVbatPidCompensation(void) {
-    float batteryScaler =  1.0f;
-    if (batteryConfig()->voltageMeterSource != VOLTAGE_METER_NONE && batteryCellCount > 0) {
-        // Up to 33% PID gain. Should be fine for 4,2to 3,3 difference
-        batteryScaler =  constrainf((( (float)batteryConfig()->vbatmaxcellvoltage * batteryCellCount ) / (float) voltageMeter.filtered), 1.0f, 1.33f);
-    }
-    return batteryScaler;
+float getVbatPidCompensation(void)
+{
+    return vbatPidCompensation;
 }
 
 uint8_t calculateBatteryPercentageRemaining(void)
@@ -403,7 +456,7 @@ uint8_t calculateBatteryPercentageRemaining(void)
         if (batteryCapacity > 0) {
             batteryPercentage = constrain(((float)batteryCapacity - currentMeter.mAhDrawn) * 100 / batteryCapacity, 0, 100);
         } else {
-            batteryPercentage = constrain((((uint32_t)voltageMeter.filtered - (batteryConfig()->vbatmincellvoltage * batteryCellCount)) * 100) / ((batteryConfig()->vbatmaxcellvoltage - batteryConfig()->vbatmincellvoltage) * batteryCellCount), 0, 100);
+            batteryPercentage = constrain((((uint32_t)batteryRestingVoltage - (batteryConfig()->vbatmincellvoltage * batteryCellCount)) * 100) / ((batteryConfig()->vbatmaxcellvoltage - batteryConfig()->vbatmincellvoltage) * batteryCellCount), 0, 100);
         }
     }
 
@@ -428,6 +481,17 @@ uint16_t getBatteryVoltageLatest(void)
     return voltageMeter.unfiltered;
 }
 
+uint16_t getBatteryRestingVoltage(void)
+{
+    return batteryRestingVoltage;
+}
+
+// mOhm, 0 until a step in the current has been seen
+uint16_t getBatteryResistance(void)
+{
+    return batteryResistance;
+}
+
 uint8_t getBatteryCellCount(void)
 {
     return batteryCellCount;
@@ -65,10 +65,12 @@ void batteryUpdateAlarms(void);
 
 struct rxConfig_s;
 
-float calculateVbatPidCompensation(void);
+float getVbatPidCompensation(void);
 uint8_t calculateBatteryPercentageRemaining(void);
 uint16_t getBatteryVoltage(void);
 uint16_t getBatteryVoltageLatest(void);
+uint16_t getBatteryRestingVoltage(void);
+uint16_t getBatteryResistance(void);
 uint8_t getBatteryCellCount(void);
 
 int32_t getAmperage(void);
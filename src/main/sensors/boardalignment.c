@@ -30,8 +30,11 @@
 
 #include "boardalignment.h"
 
-static bool standardBoardAlignment = true;     // board orientation correction
-static float boardRotation[3][3];              // matrix
+static float boardRotation[3][3] = {          // matrix, identity for a standard board orientation
+    { 1.0f, 0.0f, 0.0f },
+    { 0.0f, 1.0f, 0.0f },
+    { 0.0f, 0.0f, 1.0f }
+};
 
 // no template required since defaults are zero
 PG_REGISTER(boardAlignment_t, boardAlignment, PG_BOARD_ALIGNMENT, 0);
@@ -41,14 +44,13 @@ static bool isBoardAlignmentStandard(const boardAlignment_t *boardAlignment)
     return !boardAlignment->rollDegrees && !boardAlignment->pitchDegrees && !boardAlignment->yawDegrees;
 }
 
+// Must be called before the sensors build their alignment matrices
 void initBoardAlignment(const boardAlignment_t *boardAlignment)
 {
     if (isBoardAlignmentStandard(boardAlignment)) {
         return;
     }
 
-    standardBoardAlignment = false;
-
     fp_angles_t rotationAngles;
     rotationAngles.angles.roll  = degreesToRadians(boardAlignment->rollDegrees );
     rotationAngles.angles.pitch = degreesToRadians(boardAlignment->pitchDegrees);
@@ -57,18 +59,7 @@ void initBoardAlignment(const boardAlignment_t *boardAlignment)
     buildRotationMatrix(&rotationAngles, boardRotation);
 }
 
-static void alignBoard(int32_t *vec)
-{
-    int32_t x = vec[X];
-    int32_t y = vec[Y];
-    int32_t z = vec[Z];
-
-    vec[X] = lrintf(boardRotation[0][X] * x + boardRotation[1][X] * y + boardRotation[2][X] * z);
-    vec[Y] = lrintf(boardRotation[0][Y] * x + boardRotation[1][Y] * y + boardRotation[2][Y] * z);
-    vec[Z] = lrintf(boardRotation[0][Z] * x + boardRotation[1][Z] * y + boardRotation[2][Z] * z);
-}
-
-void alignSensors(int32_t *dest, uint8_t rotation)
+static void rotateSensor(int32_t *dest, uint8_t rotation)
 {
     const int32_t x = dest[X];
     const int32_t y = dest[Y];
@@ -117,7 +108,47 @@ void alignSensors(int32_t *dest, uint8_t rotation)
         dest[Z] = -z;
         break;
     }
+}
+
+// Combines the sensor rotation, the board alignment and a scale into the one matrix that is applied to each sample
+void buildAlignmentMatrix(sensorAlignment_t *alignment, uint8_t rotation, float scale)
+{
+    for (int col = 0; col < XYZ_AXIS_COUNT; col++) {
+        // the column of the sensor rotation is where it takes the unit vector of this axis
+        int32_t unit[XYZ_AXIS_COUNT] = { 0, 0, 0 };
+        unit[col] = 1;
+        rotateSensor(unit, rotation);
+        for (int row = 0; row < XYZ_AXIS_COUNT; row++) {
+            alignment->m[row][col] = scale * (boardRotation[X][row] * unit[X] + boardRotation[Y][row] * unit[Y] + boardRotation[Z][row] * unit[Z]);
+        }
+    }
+}
+
+void applyAlignmentMatrix(const sensorAlignment_t *alignment, const float src[XYZ_AXIS_COUNT], float dest[XYZ_AXIS_COUNT])
+{
+    const float x = src[X];
+    const float y = src[Y];
+    const float z = src[Z];
+
+    dest[X] = alignment->m[X][X] * x + alignment->m[X][Y] * y + alignment->m[X][Z] * z;
+    dest[Y] = alignment->m[Y][X] * x + alignment->m[Y][Y] * y + alignment->m[Y][Z] * z;
+    dest[Z] = alignment->m[Z][X] * x + alignment->m[Z][Y] * y + alignment->m[Z][Z] * z;
+}
 
-    if (!standardBoardAlignment)
-        alignBoard(dest);
+void applyAlignmentMatrixInt(const sensorAlignment_t *alignment, int32_t *vec)
+{
+    const float src[XYZ_AXIS_COUNT] = { vec[X], vec[Y], vec[Z] };
+    float dest[XYZ_AXIS_COUNT];
+    applyAlignmentMatrix(alignment, src, dest);
+    vec[X] = lrintf(dest[X]);
+    vec[Y] = lrintf(dest[Y]);
+    vec[Z] = lrintf(dest[Z]);
+}
+
+// Builds the matrix on every call, sensors read continuously keep their own from buildAlignmentMatrix()
+void alignSensors(int32_t *dest, uint8_t rotation)
+{
+    sensorAlignment_t alignment;
+    buildAlignmentMatrix(&alignment, rotation, 1.0f);
+    applyAlignmentMatrixInt(&alignment, dest);
 }
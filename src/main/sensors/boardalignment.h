@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include "common/axis.h"
+
 #include "config/parameter_group.h"
 
 typedef struct boardAlignment_s {
@@ -27,5 +29,13 @@ typedef struct boardAlignment_s {
 
 PG_DECLARE(boardAlignment_t, boardAlignment);
 
+// sensor orientation and board alignment, and optionally the scale to physical units, combined
+typedef struct sensorAlignment_s {
+    float m[XYZ_AXIS_COUNT][XYZ_AXIS_COUNT];
+} sensorAlignment_t;
+
+void buildAlignmentMatrix(sensorAlignment_t *alignment, uint8_t rotation, float scale);
+void applyAlignmentMatrix(const sensorAlignment_t *alignment, const float src[XYZ_AXIS_COUNT], float dest[XYZ_AXIS_COUNT]);
+void applyAlignmentMatrixInt(const sensorAlignment_t *alignment, int32_t *vec);
 void alignSensors(int32_t *dest, uint8_t rotation);
 void initBoardAlignment(const boardAlignment_t *boardAlignment);
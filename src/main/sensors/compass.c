@@ -38,6 +38,7 @@
 
 #include "sensors/boardalignment.h"
 #include "sensors/compass.h"
+#include "sensors/compass_calibration.h"
 #include "sensors/gyro.h"
 #include "sensors/sensors.h"
 
@@ -61,13 +62,18 @@ PG_RESET_TEMPLATE(compassConfig_t, compassConfig,
     // xxx_hardware: 0:default/autodetect, 1: disable
     .mag_hardware = 1,
     .mag_declination = 0,
-    .interruptTag = COMPASS_INTERRUPT_TAG
+    .interruptTag = COMPASS_INTERRUPT_TAG,
+    .mag_background_calibration = false
 );
 
 #ifdef MAG
 
 static int16_t magADCRaw[XYZ_AXIS_COUNT];
 static uint8_t magInit = 0;
+static sensorAlignment_t magAlignment;
+#ifdef USE_MAG_BACKGROUND_CALIBRATION
+static magCalibration_t magBackgroundCalibration;
+#endif
 
 bool compassDetect(magDev_t *dev, magSensor_e magHardwareToUse)
 {
@@ -158,6 +164,10 @@ bool compassInit(void)
     if (compassConfig()->mag_align != ALIGN_DEFAULT) {
         magDev.magAlign = compassConfig()->mag_align;
     }
+    buildAlignmentMatrix(&magAlignment, magDev.magAlign, 1.0f);
+#ifdef USE_MAG_BACKGROUND_CALIBRATION
+    magCalibrationReset(&magBackgroundCalibration);
+#endif
     return true;
 }
 
@@ -167,11 +177,13 @@ void compassUpdate(uint32_t currentTime, flightDynamicsTrims_t *magZero)
     static flightDynamicsTrims_t magZeroTempMin;
     static flightDynamicsTrims_t magZeroTempMax;
 
-    magDev.read(magADCRaw);
+    if (!magDev.read(magADCRaw)) {
+        return; // nothing new, the sample is still on the bus or the read failed
+    }
     for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
         mag.magADC[axis] = magADCRaw[axis];
     }
-    alignSensors(mag.magADC, magDev.magAlign);
+    applyAlignmentMatrixInt(&magAlignment, mag.magADC);
 
     if (STATE(CALIBRATE_MAG)) {
         tCal = currentTime;
@@ -181,6 +193,10 @@ void compassUpdate(uint32_t currentTime, flightDynamicsTrims_t *magZero)
             magZeroTempMax.raw[axis] = mag.magADC[axis];
         }
         DISABLE_STATE(CALIBRATE_MAG);
+#ifdef USE_MAG_BACKGROUND_CALIBRATION
+        // fitted to the old offsets
+        magCalibrationReset(&magBackgroundCalibration);
+#endif
     }
 
     if (magInit) {              // we apply offset only once mag calibration is done
@@ -207,5 +223,12 @@ void compassUpdate(uint32_t currentTime, flightDynamicsTrims_t *magZero)
             saveConfigAndNotify();
         }
     }
+
+#ifdef USE_MAG_BACKGROUND_CALIBRATION
+    if (tCal == 0 && compassConfig()->mag_background_calibration) {
+        magCalibrationUpdate(&magBackgroundCalibration, mag.magADC);
+        magCalibrationApply(&magBackgroundCalibration, mag.magADC);
+    }
+#endif
 }
 #endif
@@ -46,6 +46,7 @@ typedef struct compassConfig_s {
     uint8_t mag_hardware;                   // Which mag hardware to use on boards with more than one device
     ioTag_t interruptTag;
     flightDynamicsTrims_t magZero;
+    uint8_t mag_background_calibration;     // refine the offsets and scale from the samples of normal flight
 } compassConfig_t;
 
 PG_DECLARE(compassConfig_t, compassConfig);
@@ -0,0 +1,246 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "platform.h"
+
+#ifdef USE_MAG_BACKGROUND_CALIBRATION
+
+#include "common/maths.h"
+
+#include "sensors/compass_calibration.h"
+
+/*
+ * The mag samples of normal flight are fitted to an ellipsoid A x^2 + B y^2 + C z^2 + D x + E y + F z = 1.
+ * Its centre is the hard iron offset and the ratio of its semi axes the soft iron scale. Each sample only
+ * adds to the normal equations of the fit, and the solution is worked out one column per call, so every
+ * call costs about the same. Fits are blended into the applied calibration rather than replacing it.
+ */
+
+#define MAG_CAL_SAMPLE_SPACING  0.125f  // least distance from the previous sample, in field strengths
+#define MAG_CAL_SPREAD_MIN      1.0f    // least range on each axis for a fit, in field strengths
+#define MAG_CAL_SCALE_MIN       0.8f
+#define MAG_CAL_SCALE_MAX       1.25f
+#define MAG_CAL_BLEND           0.5f    // part of a new fit moved into the applied calibration
+#define MAG_CAL_PIVOT_MIN       1e-9f
+
+static void magCalibrationStartWindow(magCalibration_t *cal)
+{
+    for (int row = 0; row < MAG_CAL_PARAM_COUNT; row++) {
+        for (int col = 0; col <= MAG_CAL_PARAM_COUNT; col++) {
+            cal->normal[row][col] = 0.0f;
+        }
+    }
+    cal->sampleCount = 0;
+    cal->state = MAG_CAL_COLLECT;
+}
+
+void magCalibrationReset(magCalibration_t *cal)
+{
+    magCalibrationStartWindow(cal);
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        cal->offset[axis] = 0.0f;
+        cal->scale[axis] = 1.0f;
+    }
+    cal->fitCount = 0;
+}
+
+static void magCalibrationAddSample(magCalibration_t *cal, const int32_t magADC[XYZ_AXIS_COUNT])
+{
+    if (cal->sampleCount == 0) {
+        const float field = sqrtf(sq((float)magADC[X]) + sq((float)magADC[Y]) + sq((float)magADC[Z]));
+        if (field < 1.0f) {
+            return;
+        }
+        cal->norm = 1.0f / field;
+    }
+
+    float v[XYZ_AXIS_COUNT];
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        v[axis] = magADC[axis] * cal->norm;
+    }
+
+    if (cal->sampleCount == 0) {
+        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            cal->min[axis] = v[axis];
+            cal->max[axis] = v[axis];
+        }
+    } else {
+        // a craft holding its attitude would fill the window with one point of the ellipsoid
+        const float distance = sq(v[X] - cal->lastSample[X]) + sq(v[Y] - cal->lastSample[Y]) + sq(v[Z] - cal->lastSample[Z]);
+        if (distance < sq(MAG_CAL_SAMPLE_SPACING)) {
+            return;
+        }
+        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            cal->min[axis] = MIN(cal->min[axis], v[axis]);
+            cal->max[axis] = MAX(cal->max[axis], v[axis]);
+        }
+    }
+
+    const float J[MAG_CAL_PARAM_COUNT] = { sq(v[X]), sq(v[Y]), sq(v[Z]), v[X], v[Y], v[Z] };
+    // only the upper triangle, it is mirrored before solving
+    for (int row = 0; row < MAG_CAL_PARAM_COUNT; row++) {
+        for (int col = row; col < MAG_CAL_PARAM_COUNT; col++) {
+            cal->normal[row][col] += J[row] * J[col];
+        }
+        cal->normal[row][MAG_CAL_PARAM_COUNT] += J[row];
+    }
+
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        cal->lastSample[axis] = v[axis];
+    }
+    cal->sampleCount++;
+}
+
+static bool magCalibrationCoverageOk(const magCalibration_t *cal)
+{
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        if (cal->max[axis] - cal->min[axis] < MAG_CAL_SPREAD_MIN) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// One Gauss-Jordan elimination step with partial pivoting, false if the equations are singular
+static bool magCalibrationSolveColumn(magCalibration_t *cal, int col)
+{
+    float (*m)[MAG_CAL_PARAM_COUNT + 1] = cal->normal;
+
+    int pivot = col;
+    for (int row = col + 1; row < MAG_CAL_PARAM_COUNT; row++) {
+        if (fabsf(m[row][col]) > fabsf(m[pivot][col])) {
+            pivot = row;
+        }
+    }
+    if (fabsf(m[pivot][col]) < MAG_CAL_PIVOT_MIN) {
+        return false;
+    }
+    if (pivot != col) {
+        for (int i = 0; i <= MAG_CAL_PARAM_COUNT; i++) {
+            const float tmp = m[col][i];
+            m[col][i] = m[pivot][i];
+            m[pivot][i] = tmp;
+        }
+    }
+
+    for (int row = 0; row < MAG_CAL_PARAM_COUNT; row++) {
+        if (row == col) {
+            continue;
+        }
+        const float factor = m[row][col] / m[col][col];
+        for (int i = col; i <= MAG_CAL_PARAM_COUNT; i++) {
+            m[row][i] -= factor * m[col][i];
+        }
+    }
+    return true;
+}
+
+static void magCalibrationFinish(magCalibration_t *cal)
+{
+    float p[MAG_CAL_PARAM_COUNT];
+    for (int i = 0; i < MAG_CAL_PARAM_COUNT; i++) {
+        p[i] = cal->normal[i][MAG_CAL_PARAM_COUNT] / cal->normal[i][i];
+    }
+
+    float g = 1.0f;
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        if (p[axis] <= 0.0f) {
+            return; // not an ellipsoid
+        }
+        g += sq(p[XYZ_AXIS_COUNT + axis]) / (4.0f * p[axis]);
+    }
+
+    float centre[XYZ_AXIS_COUNT];
+    float radius[XYZ_AXIS_COUNT];
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        centre[axis] = -p[XYZ_AXIS_COUNT + axis] / (2.0f * p[axis]);
+        radius[axis] = sqrtf(g / p[axis]);
+    }
+    const float meanRadius = (radius[X] + radius[Y] + radius[Z]) / XYZ_AXIS_COUNT;
+
+    float scale[XYZ_AXIS_COUNT];
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        scale[axis] = meanRadius / radius[axis];
+        if (scale[axis] < MAG_CAL_SCALE_MIN || scale[axis] > MAG_CAL_SCALE_MAX) {
+            return;
+        }
+    }
+
+    const float blend = cal->fitCount ? MAG_CAL_BLEND : 1.0f;
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        cal->offset[axis] += blend * (centre[axis] / cal->norm - cal->offset[axis]);
+        cal->scale[axis] += blend * (scale[axis] - cal->scale[axis]);
+    }
+    if (cal->fitCount < UINT8_MAX) {
+        cal->fitCount++;
+    }
+}
+
+// Takes one mag sample and advances the fit by one step
+void magCalibrationUpdate(magCalibration_t *cal, const int32_t magADC[XYZ_AXIS_COUNT])
+{
+    switch (cal->state) {
+    case MAG_CAL_COLLECT:
+        magCalibrationAddSample(cal, magADC);
+        if (cal->sampleCount < MAG_CAL_SAMPLE_COUNT) {
+            break;
+        }
+        if (!magCalibrationCoverageOk(cal)) {
+            magCalibrationStartWindow(cal);
+            break;
+        }
+        for (int row = 1; row < MAG_CAL_PARAM_COUNT; row++) {
+            for (int col = 0; col < row; col++) {
+                cal->normal[row][col] = cal->normal[col][row];
+            }
+        }
+        cal->solveColumn = 0;
+        cal->state = MAG_CAL_SOLVE;
+        break;
+
+    case MAG_CAL_SOLVE:
+        if (!magCalibrationSolveColumn(cal, cal->solveColumn)) {
+            magCalibrationStartWindow(cal);
+            break;
+        }
+        if (++cal->solveColumn == MAG_CAL_PARAM_COUNT) {
+            cal->state = MAG_CAL_FINISH;
+        }
+        break;
+
+    case MAG_CAL_FINISH:
+        magCalibrationFinish(cal);
+        magCalibrationStartWindow(cal);
+        break;
+    }
+}
+
+void magCalibrationApply(const magCalibration_t *cal, int32_t magADC[XYZ_AXIS_COUNT])
+{
+    if (!cal->fitCount) {
+        return;
+    }
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        magADC[axis] = lrintf((magADC[axis] - cal->offset[axis]) * cal->scale[axis]);
+    }
+}
+
+#endif
@@ -0,0 +1,51 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "common/axis.h"
+
+#define MAG_CAL_PARAM_COUNT     6   // x^2, y^2, z^2, x, y, z coefficients of an axis aligned ellipsoid
+#define MAG_CAL_SAMPLE_COUNT    300 // samples per fit
+
+typedef enum {
+    MAG_CAL_COLLECT = 0,
+    MAG_CAL_SOLVE,
+    MAG_CAL_FINISH
+} magCalibrationState_e;
+
+// Incremental least squares ellipsoid fit, the samples only ever live in the normal equations
+typedef struct magCalibration_s {
+    magCalibrationState_e state;
+    uint16_t sampleCount;
+    uint8_t solveColumn;
+    float norm;                                             // 1 / field strength of the first sample, keeps the sums near unity
+    float lastSample[XYZ_AXIS_COUNT];                       // normalised
+    float min[XYZ_AXIS_COUNT];                              // normalised
+    float max[XYZ_AXIS_COUNT];                              // normalised
+    float normal[MAG_CAL_PARAM_COUNT][MAG_CAL_PARAM_COUNT + 1]; // J'J augmented by J'1
+    float offset[XYZ_AXIS_COUNT];                           // hard iron, raw units
+    float scale[XYZ_AXIS_COUNT];                            // soft iron
+    uint8_t fitCount;                                       // fits applied since the reset, saturating
+} magCalibration_t;
+
+void magCalibrationReset(magCalibration_t *cal);
+void magCalibrationUpdate(magCalibration_t *cal, const int32_t magADC[XYZ_AXIS_COUNT]);
+void magCalibrationApply(const magCalibration_t *cal, int32_t magADC[XYZ_AXIS_COUNT]);
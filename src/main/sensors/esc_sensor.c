@@ -29,6 +29,7 @@
 #include "config/parameter_group.h"
 #include "config/parameter_group_ids.h"
 
+#include "common/crc.h"
 #include "common/maths.h"
 #include "common/utils.h"
 
@@ -92,15 +93,17 @@ typedef enum {
 
 typedef enum {
     ESC_SENSOR_TRIGGER_STARTUP = 0,
-    ESC_SENSOR_TRIGGER_READY = 1,
-    ESC_SENSOR_TRIGGER_PENDING = 2
+    ESC_SENSOR_TRIGGER_PENDING = 1
 } escSensorTriggerState_t;
 
 #define ESC_SENSOR_BAUDRATE 115200
 #define ESC_BOOTTIME 5000               // 5 seconds
-#define ESC_REQUEST_TIMEOUT 100         // 100 ms (data transfer takes only 900us)
 
 #define TELEMETRY_FRAME_SIZE 10
+#define ESC_FRAME_TIME_US (TELEMETRY_FRAME_SIZE * 10 * 1000000 / ESC_SENSOR_BAUDRATE)  // 10 bits a byte, 868us
+// the request goes out with the next DShot packet and the ESC answers within a few of its own loops,
+// an ESC that does not answer holds the shared line up for this long
+#define ESC_REQUEST_TIMEOUT_US (ESC_FRAME_TIME_US + 5000)
 static uint8_t telemetryBuffer[TELEMETRY_FRAME_SIZE] = { 0, };
 
 static volatile uint8_t *buffer;
@@ -112,11 +115,17 @@ static serialPort_t *escSensorPort = NULL;
 static escSensorData_t escSensorData[MAX_SUPPORTED_MOTORS];
 
 static escSensorTriggerState_t escSensorTriggerState = ESC_SENSOR_TRIGGER_STARTUP;
-static uint32_t escTriggerTimestamp;
+static timeUs_t escTriggerTimestamp;
 static uint8_t escSensorMotor = 0;      // motor index
 
+// running totals of the motors, kept up to date as each frame arrives
+static struct {
+    int32_t voltage;
+    int32_t current;
+    int32_t consumption;
+    int32_t rpm;
+} escSensorTotals;
 static escSensorData_t combinedEscSensorData;
-static bool combinedDataNeedsUpdate = true;
 
 static uint16_t totalTimeoutCount = 0;
 static uint16_t totalCrcErrorCount = 0;
@@ -143,36 +152,41 @@ bool isEscSensorActive(void)
     return escSensorPort != NULL;
 }
 
-escSensorData_t *getEscSensorData(uint8_t motorNumber)
+static void updateCombinedEscSensorData(void)
 {
-    if (motorNumber < getMotorCount()) {
-        return &escSensorData[motorNumber];
-    } else if (motorNumber == ESC_SENSOR_COMBINED) {
-        if (combinedDataNeedsUpdate) {
-            combinedEscSensorData.dataAge = 0;
-            combinedEscSensorData.temperature = 0;
-            combinedEscSensorData.voltage = 0;
-            combinedEscSensorData.current = 0;
-            combinedEscSensorData.consumption = 0;
-            combinedEscSensorData.rpm = 0;
-
-            for (int i = 0; i < getMotorCount(); i = i + 1) {
-                combinedEscSensorData.dataAge = MAX(combinedEscSensorData.dataAge, escSensorData[i].dataAge);
-                combinedEscSensorData.temperature = MAX(combinedEscSensorData.temperature, escSensorData[i].temperature);
-                combinedEscSensorData.voltage += escSensorData[i].voltage;
-                combinedEscSensorData.current += escSensorData[i].current;
-                combinedEscSensorData.consumption += escSensorData[i].consumption;
-                combinedEscSensorData.rpm += escSensorData[i].rpm;
-            }
+    combinedEscSensorData.dataAge = 0;
+    combinedEscSensorData.temperature = 0;
+    for (int i = 0; i < getMotorCount(); i = i + 1) {
+        combinedEscSensorData.dataAge = MAX(combinedEscSensorData.dataAge, escSensorData[i].dataAge);
+        combinedEscSensorData.temperature = MAX(combinedEscSensorData.temperature, escSensorData[i].temperature);
+    }
+
+    combinedEscSensorData.voltage = escSensorTotals.voltage / getMotorCount();
+    combinedEscSensorData.current = escSensorTotals.current;
+    combinedEscSensorData.consumption = escSensorTotals.consumption;
+    combinedEscSensorData.rpm = escSensorTotals.rpm / getMotorCount();
 
-            combinedEscSensorData.voltage = combinedEscSensorData.voltage / getMotorCount();
-            combinedEscSensorData.rpm = combinedEscSensorData.rpm / getMotorCount();
+    DEBUG_SET(DEBUG_ESC_SENSOR, DEBUG_ESC_DATA_AGE, combinedEscSensorData.dataAge);
+}
+
+static void setEscSensorData(uint8_t motorNumber, const escSensorData_t *data)
+{
+    escSensorData_t *motorData = &escSensorData[motorNumber];
 
-            combinedDataNeedsUpdate = false;
+    escSensorTotals.voltage += data->voltage - motorData->voltage;
+    escSensorTotals.current += data->current - motorData->current;
+    escSensorTotals.consumption += data->consumption - motorData->consumption;
+    escSensorTotals.rpm += data->rpm - motorData->rpm;
+    *motorData = *data;
 
-            DEBUG_SET(DEBUG_ESC_SENSOR, DEBUG_ESC_DATA_AGE, combinedEscSensorData.dataAge);
-        }
+    updateCombinedEscSensorData();
+}
 
+escSensorData_t *getEscSensorData(uint8_t motorNumber)
+{
+    if (motorNumber < getMotorCount()) {
+        return &escSensorData[motorNumber];
+    } else if (motorNumber == ESC_SENSOR_COMBINED) {
         return &combinedEscSensorData;
     } else {
         return NULL;
@@ -207,32 +221,11 @@ bool escSensorInit(void)
     for (int i = 0; i < MAX_SUPPORTED_MOTORS; i = i + 1) {
         escSensorData[i].dataAge = ESC_DATA_INVALID;
     }
+    combinedEscSensorData.dataAge = ESC_DATA_INVALID;
 
     return escSensorPort != NULL;
 }
 
-static uint8_t updateCrc8(uint8_t crc, uint8_t crc_seed)
-{
-    uint8_t crc_u = crc;
-    crc_u ^= crc_seed;
-
-    for (int i=0; i<8; i++) {
-        crc_u = ( crc_u & 0x80 ) ? 0x7 ^ ( crc_u << 1 ) : ( crc_u << 1 );
-    }
-
-    return (crc_u);
-}
-
-uint8_t calculateCrc8(const uint8_t *Buf, const uint8_t BufLen)
-{
-    uint8_t crc = 0;
-    for (int i = 0; i < BufLen; i++) {
-        crc = updateCrc8(Buf[i], crc);
-    }
-
-    return crc;
-}
-
 static uint8_t decodeEscFrame(void)
 {
     if (!isFrameComplete()) {
@@ -240,18 +233,19 @@ static uint8_t decodeEscFrame(void)
     }
 
     // Get CRC8 checksum
-    uint16_t chksum = calculateCrc8(telemetryBuffer, TELEMETRY_FRAME_SIZE - 1);
+    uint16_t chksum = crc8_ccitt_update(0, telemetryBuffer, TELEMETRY_FRAME_SIZE - 1);
     uint16_t tlmsum = telemetryBuffer[TELEMETRY_FRAME_SIZE - 1];     // last byte contains CRC value
     uint8_t frameStatus;
     if (chksum == tlmsum) {
-        escSensorData[escSensorMotor].dataAge = 0;
-        escSensorData[escSensorMotor].temperature = telemetryBuffer[0];
-        escSensorData[escSensorMotor].voltage = telemetryBuffer[1] << 8 | telemetryBuffer[2];
-        escSensorData[escSensorMotor].current = telemetryBuffer[3] << 8 | telemetryBuffer[4];
-        escSensorData[escSensorMotor].consumption = telemetryBuffer[5] << 8 | telemetryBuffer[6];
-        escSensorData[escSensorMotor].rpm = telemetryBuffer[7] << 8 | telemetryBuffer[8];
-
-        combinedDataNeedsUpdate = true;
+        const escSensorData_t data = {
+            .dataAge = 0,
+            .temperature = telemetryBuffer[0],
+            .voltage = telemetryBuffer[1] << 8 | telemetryBuffer[2],
+            .current = telemetryBuffer[3] << 8 | telemetryBuffer[4],
+            .consumption = telemetryBuffer[5] << 8 | telemetryBuffer[6],
+            .rpm = telemetryBuffer[7] << 8 | telemetryBuffer[8],
+        };
+        setEscSensorData(escSensorMotor, &data);
 
         frameStatus = ESC_SENSOR_FRAME_COMPLETE;
 
@@ -269,7 +263,7 @@ static void increaseDataAge(void)
     if (escSensorData[escSensorMotor].dataAge < ESC_DATA_INVALID) {
         escSensorData[escSensorMotor].dataAge++;
 
-        combinedDataNeedsUpdate = true;
+        updateCombinedEscSensorData();
     }
 }
 
@@ -281,6 +275,41 @@ static void selectNextMotor(void)
     }
 }
 
+static void requestEscFrame(timeUs_t currentTimeUs)
+{
+    escTriggerTimestamp = currentTimeUs;
+
+    startEscDataRead(telemetryBuffer, TELEMETRY_FRAME_SIZE);
+    motorDmaOutput_t * const motor = getMotorDmaOutput(escSensorMotor);
+    motor->requestTelemetry = true;
+
+    DEBUG_SET(DEBUG_ESC_SENSOR, DEBUG_ESC_MOTOR_INDEX, escSensorMotor + 1);
+}
+
+static bool isEscRequestTimedOut(timeUs_t currentTimeUs)
+{
+    return cmpTimeUs(currentTimeUs, escTriggerTimestamp) >= ESC_REQUEST_TIMEOUT_US;
+}
+
+// the ESCs share one telemetry line, so only one can be asked at a time,
+// the next is asked as soon as a frame is in or the request has timed out
+bool escSensorCheck(timeUs_t currentTimeUs, timeDelta_t currentDeltaTimeUs)
+{
+    UNUSED(currentDeltaTimeUs);
+
+    if (!escSensorPort) {
+        return false;
+    }
+
+    switch (escSensorTriggerState) {
+        case ESC_SENSOR_TRIGGER_STARTUP:
+            return currentTimeUs / 1000 >= ESC_BOOTTIME;
+        case ESC_SENSOR_TRIGGER_PENDING:
+            return isFrameComplete() || isEscRequestTimedOut(currentTimeUs);
+    }
+    return false;
+}
+
 void escSensorProcess(timeUs_t currentTimeUs)
 {
     const timeMs_t currentTimeMs = currentTimeUs / 1000;
@@ -293,51 +322,35 @@ void escSensorProcess(timeUs_t currentTimeUs)
         case ESC_SENSOR_TRIGGER_STARTUP:
             // Wait period of time before requesting telemetry (let the system boot first)
             if (currentTimeMs >= ESC_BOOTTIME) {
-                escSensorTriggerState = ESC_SENSOR_TRIGGER_READY;
+                requestEscFrame(currentTimeUs);
+                escSensorTriggerState = ESC_SENSOR_TRIGGER_PENDING;
             }
 
-            break;
-        case ESC_SENSOR_TRIGGER_READY:
-            escTriggerTimestamp = currentTimeMs;
-
-            startEscDataRead(telemetryBuffer, TELEMETRY_FRAME_SIZE);
-            motorDmaOutput_t * const motor = getMotorDmaOutput(escSensorMotor);
-            motor->requestTelemetry = true;
-            escSensorTriggerState = ESC_SENSOR_TRIGGER_PENDING;
-
-            DEBUG_SET(DEBUG_ESC_SENSOR, DEBUG_ESC_MOTOR_INDEX, escSensorMotor + 1);
-
             break;
         case ESC_SENSOR_TRIGGER_PENDING:
-            if (currentTimeMs < escTriggerTimestamp + ESC_REQUEST_TIMEOUT) {
-                uint8_t state = decodeEscFrame();
-                switch (state) {
-                    case ESC_SENSOR_FRAME_COMPLETE:
-                        selectNextMotor();
-                        escSensorTriggerState = ESC_SENSOR_TRIGGER_READY;
-
-                        break;
-                    case ESC_SENSOR_FRAME_FAILED:
-                        increaseDataAge();
-
-                        selectNextMotor();
-                        escSensorTriggerState = ESC_SENSOR_TRIGGER_READY;
-
-                        DEBUG_SET(DEBUG_ESC_SENSOR, DEBUG_ESC_NUM_CRC_ERRORS, ++totalCrcErrorCount);
-                        break;
-                    case ESC_SENSOR_FRAME_PENDING:
-                        break;
-                }
-            } else {
-                // Move on to next ESC, we'll come back to this one
-                increaseDataAge();
-
-                selectNextMotor();
-                escSensorTriggerState = ESC_SENSOR_TRIGGER_READY;
-
-                DEBUG_SET(DEBUG_ESC_SENSOR, DEBUG_ESC_NUM_TIMEOUTS, ++totalTimeoutCount);
+            switch (decodeEscFrame()) {
+                case ESC_SENSOR_FRAME_COMPLETE:
+                    break;
+                case ESC_SENSOR_FRAME_FAILED:
+                    increaseDataAge();
+
+                    DEBUG_SET(DEBUG_ESC_SENSOR, DEBUG_ESC_NUM_CRC_ERRORS, ++totalCrcErrorCount);
+                    break;
+                case ESC_SENSOR_FRAME_PENDING:
+                    if (!isEscRequestTimedOut(currentTimeUs)) {
+                        return;
+                    }
+                    // Move on to next ESC, we'll come back to this one
+                    increaseDataAge();
+
+                    DEBUG_SET(DEBUG_ESC_SENSOR, DEBUG_ESC_NUM_TIMEOUTS, ++totalTimeoutCount);
+                    break;
             }
 
+            // the line is free again, ask the next ESC straight away
+            selectNextMotor();
+            requestEscFrame(currentTimeUs);
+
             break;
     }
 }
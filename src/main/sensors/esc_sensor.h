@@ -39,6 +39,8 @@ typedef struct {
 #define ESC_BATTERY_AGE_MAX 10
 
 bool escSensorInit(void);
+bool isEscSensorActive(void);
+bool escSensorCheck(timeUs_t currentTimeUs, timeDelta_t currentDeltaTimeUs);
 void escSensorProcess(timeUs_t currentTime);
 
 #define ESC_SENSOR_COMBINED 255
@@ -48,4 +50,3 @@ escSensorData_t *getEscSensorData(uint8_t motorNumber);
 void startEscDataRead(uint8_t *frameBuffer, uint8_t frameLength);
 uint8_t getNumberEscBytesRead(void);
 
-uint8_t calculateCrc8(const uint8_t *Buf, const uint8_t BufLen);
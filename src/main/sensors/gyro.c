@@ -23,10 +23,12 @@
 #include "platform.h"
 
 #include "build/debug.h"
+#include "build/trace.h"
 
 #include "common/axis.h"
 #include "common/maths.h"
 #include "common/filter.h"
+#include "common/utils.h"
 
 #include "config/parameter_group.h"
 #include "config/parameter_group_ids.h"
@@ -52,8 +54,11 @@
 #include "drivers/gyro_sync.h"
 #include "drivers/io.h"
 
+#include "fc/fc_dispatch.h"
 #include "fc/runtime_config.h"
 
+#include "flight/rpm_filter.h"
+
 #include "io/beeper.h"
 #include "io/statusindicator.h"
 
@@ -61,6 +66,7 @@
 
 #include "sensors/boardalignment.h"
 #include "sensors/gyro.h"
+#include "sensors/gyro_bias.h"
 #include "sensors/gyroanalyse.h"
 #include "sensors/sensors.h"
 
@@ -68,6 +74,11 @@
 #include "hardware_revision.h"
 #endif
 
+#if defined(USE_GYRO_ISR_UPDATE) && !defined(SIMULATOR_BUILD)
+#include "build/atomic.h"
+#include "drivers/nvic.h"
+#endif
+
 gyro_t gyro;
 
 
@@ -80,31 +91,108 @@ typedef struct gyroCalibration_s {
 bool firstArmingCalibrationWasStarted = false;
 
 typedef union gyroSoftFilter_u {
-    biquadFilter_t gyroFilterLpfState[XYZ_AXIS_COUNT];
-    pt1Filter_t gyroFilterPt1State[XYZ_AXIS_COUNT];
-    firFilterDenoise_t gyroDenoiseState[XYZ_AXIS_COUNT];
+    biquadFilterXyz_t gyroFilterLpfState;
+    pt1FilterXyz_t gyroFilterPt1State;
+    firFilterDenoiseXyz_t gyroDenoiseState;
 } gyroSoftLpfFilter_t;
 
+struct gyroSensor_s;
+typedef void (*gyroFilterChainFnPtr)(struct gyroSensor_s *gyroSensor, float gyroADCf[XYZ_AXIS_COUNT]);
+
 typedef struct gyroSensor_s {
     gyroDev_t gyroDev;
     gyroCalibration_t calibration;
+    sensorAlignment_t alignment;    // sensor orientation, board alignment and scale to degrees per second
     // gyro soft filter
-    filterApplyFnPtr softLpfFilterApplyFn;
+    filterApplyXyzFnPtr softLpfFilterApplyFn;
     gyroSoftLpfFilter_t softLpfFilter;
-    void *softLpfFilterPtr[XYZ_AXIS_COUNT];
     // notch filters
-    filterApplyFnPtr notchFilter1ApplyFn;
-    biquadFilter_t notchFilter1[XYZ_AXIS_COUNT];
-    filterApplyFnPtr notchFilter2ApplyFn;
-    biquadFilter_t notchFilter2[XYZ_AXIS_COUNT];
-    filterApplyFnPtr notchFilterDynApplyFn;
-    biquadFilter_t notchFilterDyn[XYZ_AXIS_COUNT];
+    filterApplyXyzFnPtr notchFilter1ApplyFn;
+    biquadFilterXyz_t notchFilter1;
+    filterApplyXyzFnPtr notchFilter2ApplyFn;
+    biquadFilterXyz_t notchFilter2;
+#ifdef USE_GYRO_DATA_ANALYSE
+    filterApplyXyzFnPtr notchFilterDynApplyFn;
+    uint8_t notchFilterDynCount;
+    biquadFilterXyz_t notchFilterDyn[GYRO_DYN_NOTCH_COUNT_MAX];
+#endif
+    // static notch and LPF stages, fused into one function for the common combinations
+    gyroFilterChainFnPtr filterChainFn;
+    timeUs_t sampleTimeUs;          // data ready time of the sample last read
+#ifdef USE_DUAL_GYRO
+    // health, used to blend the two gyros
+    float previousRate[XYZ_AXIS_COUNT];
+    float noiseVariance;            // smoothed square of the sample to sample change
+    uint16_t unchangedCount;        // consecutive samples identical to the one before
+#endif
 } gyroSensor_t;
 
-static gyroSensor_t gyroSensor1;
+static FAST_RAM gyroSensor_t gyroSensor1;
+
+// rotation since the last gyroGetDeltaAngle(), summed at the filter rate so the attitude estimate sees every sample
+static float gyroDeltaAngle[XYZ_AXIS_COUNT];    // radians
+static float gyroConing[XYZ_AXIS_COUNT];        // coning correction, radians
+static float gyroDeltaTimeUs;
+
+#ifdef USE_DUAL_GYRO
+// When both gyros are used they share the filter chain of gyroSensor1, fusing happens before filtering
+static FAST_RAM gyroSensor_t gyroSensor2;
+static uint8_t gyroToUse;
+#endif
 
 static void gyroInitSensorFilters(gyroSensor_t *gyroSensor);
 
+#ifdef USE_GYRO_OVERFLOW_CHECK
+// A raw sample this close to full scale may have clipped. The overflow only ends once every axis has been clearly
+// back inside the range for GYRO_OVERFLOW_RESET_US, so a rate hovering at the limit does not toggle it.
+#define GYRO_OVERFLOW_TRIGGER_ADC   0x7C00  // 97% of full scale
+#define GYRO_OVERFLOW_RESET_ADC     0x7000  // 87.5% of full scale
+#define GYRO_OVERFLOW_RESET_US      50000
+#define YAW_SPIN_RECOVERED_US       20000   // time below half the threshold before a yaw spin counts as recovered
+
+static bool gyroOverflowCheckEnabled;
+static bool gyroOverflow;
+static uint16_t gyroOverflowCount;
+static bool gyroOverflowFilterReset;            // the filter chain is settled on the next sample
+static timeUs_t gyroOverflowOutOfRangeAtUs;     // last sample above GYRO_OVERFLOW_RESET_ADC
+static bool yawSpinRecoveryEnabled;
+static float yawSpinThreshold;
+static bool yawSpinDetected;
+static timeUs_t yawSpinRecoveringSinceUs;
+#endif
+
+#ifdef USE_GYRO_BIAS_TRACKING
+#define GYRO_BIAS_WINDOW_US         500000
+#define GYRO_BIAS_UPDATE_PERIOD_US  1000000
+#define GYRO_BIAS_AVERAGE_WINDOWS   10      // once settled, each stationary window moves the offset by a tenth
+
+static bool gyroBiasTrackingEnabled;
+static gyroBiasEstimator_t gyroBiasEstimator;
+static float gyroZeroBase[XYZ_AXIS_COUNT];     // the offset of gyroSensor1, as last calibrated or tracked
+static int16_t gyroZeroBaseTemperature;         // the temperature gyroZeroBase was found at
+static uint16_t gyroZeroBaseWindows;            // stationary windows, or their equivalent, averaged into gyroZeroBase
+static bool gyroZeroPresetFromTable;            // gyroZeroBase is from the table, the power up calibration can be skipped
+
+static void gyroBiasInit(void);
+
+static void gyroBiasResetEstimator(void)
+{
+    gyroBiasEstimatorInit(&gyroBiasEstimator, GYRO_BIAS_WINDOW_US / gyro.targetLooptime, gyroConfig()->gyroMovementCalibrationThreshold);
+}
+#endif
+
+// the measured gyro sample interval over the nominal one, see gyroSampleClockUpdate
+static float gyroClockScale = 1.0f;
+
+#ifdef USE_GYRO_SAMPLE_CLOCK
+#define GYRO_SAMPLE_CLOCK_UPDATE_PERIOD_US  100000
+#define GYRO_SAMPLE_CLOCK_MIN_CHANGE        0.0001f     // a smaller change is not worth setting up the filters again
+
+static gyroSampleClock_t gyroSampleClock;
+
+static void gyroSampleClockStart(void);
+#endif
+
 #define DEBUG_GYRO_CALIBRATION 3
 
 #ifdef STM32F10X
@@ -130,7 +218,15 @@ PG_RESET_TEMPLATE(gyroConfig_t, gyroConfig,
     .gyro_soft_notch_hz_1 = 400,
     .gyro_soft_notch_cutoff_1 = 300,
     .gyro_soft_notch_hz_2 = 200,
-    .gyro_soft_notch_cutoff_2 = 100
+    .gyro_soft_notch_cutoff_2 = 100,
+    .dyn_fft_window = 0,    // DYN_FFT_WINDOW_32
+    .dyn_fft_decimation = 1,
+    .dyn_notch_count = 1,
+    .gyro_use_fifo = false,
+    .gyro_bias_tracking = true,
+    .gyro_overflow_detect = true,
+    .yaw_spin_recovery = true,
+    .yaw_spin_threshold = 1950
 );
 
 
@@ -291,42 +387,11 @@ STATIC_UNIT_TESTED gyroSensor_e gyroDetect(gyroDev_t *dev)
         gyroHardware = GYRO_NONE;
     }
 
-    if (gyroHardware != GYRO_NONE) {
-        detectedSensors[SENSOR_INDEX_GYRO] = gyroHardware;
-        sensorsSet(SENSOR_GYRO);
-    }
-
-
     return gyroHardware;
 }
 
-static bool gyroInitSensor(gyroSensor_t *gyroSensor)
+static bool gyroHardwareSupports32kHz(gyroSensor_e gyroHardware)
 {
-#if defined(USE_GYRO_MPU6050) || defined(USE_GYRO_MPU3050) || defined(USE_GYRO_MPU6500) || defined(USE_GYRO_SPI_MPU6500) || defined(USE_GYRO_SPI_MPU6000) || defined(USE_ACC_MPU6050) || defined(USE_GYRO_SPI_MPU9250) || defined(USE_GYRO_SPI_ICM20601) || defined(USE_GYRO_SPI_ICM20689)
-
-#if defined(MPU_INT_EXTI)
-    gyroSensor->gyroDev.mpuIntExtiTag =  IO_TAG(MPU_INT_EXTI);
-#elif defined(USE_HARDWARE_REVISION_DETECTION)
-    gyroSensor->gyroDev.mpuIntExtiTag =  selectMPUIntExtiConfigByHardwareRevision();
-#else
-    gyroSensor->gyroDev.mpuIntExtiTag =  IO_TAG_NONE;
-#endif // MPU_INT_EXTI
-
-#ifdef USE_DUAL_GYRO
-    // set cnsPin using GYRO_n_CS_PIN defined in target.h
-    gyroSensor->gyroDev.bus.busdev_u.spi.csnPin = gyroConfig()->gyro_to_use == 0 ? IOGetByTag(IO_TAG(GYRO_0_CS_PIN)) : IOGetByTag(IO_TAG(GYRO_1_CS_PIN));
-#else
-    gyroSensor->gyroDev.bus.busdev_u.spi.csnPin = IO_NONE; // set cnsPin to IO_NONE so mpuDetect will set it according to value defined in target.h
-#endif // USE_DUAL_GYRO
-    mpuDetect(&gyroSensor->gyroDev);
-    mpuResetFn = gyroSensor->gyroDev.mpuConfiguration.resetFn; // must be set after mpuDetect
-#endif
-
-    const gyroSensor_e gyroHardware = gyroDetect(&gyroSensor->gyroDev);
-    if (gyroHardware == GYRO_NONE) {
-        return false;
-    }
-
     switch (gyroHardware) {
     case GYRO_MPU6500:
     case GYRO_MPU9250:
@@ -334,62 +399,182 @@ static bool gyroInitSensor(gyroSensor_t *gyroSensor)
     case GYRO_ICM20602:
     case GYRO_ICM20608G:
     case GYRO_ICM20689:
-        // do nothing, as gyro supports 32kHz
-        break;
+#ifdef USE_FAKE_GYRO_MODEL
+    case GYRO_FAKE:
+#endif
+        return true;
     default:
-        // gyro does not support 32kHz
+        return false;
+    }
+}
+
+bool gyroSupports32kHz(void)
+{
+    return gyroHardwareSupports32kHz(detectedSensors[SENSOR_INDEX_GYRO]);
+}
+
+// csnPin IO_NONE lets mpuDetect() pick the chip select defined in target.h
+static gyroSensor_e gyroDetectSensor(gyroSensor_t *gyroSensor, IO_t csnPin, ioTag_t mpuIntExtiTag)
+{
+#if defined(USE_GYRO_MPU6050) || defined(USE_GYRO_MPU3050) || defined(USE_GYRO_MPU6500) || defined(USE_GYRO_SPI_MPU6500) || defined(USE_GYRO_SPI_MPU6000) || defined(USE_ACC_MPU6050) || defined(USE_GYRO_SPI_MPU9250) || defined(USE_GYRO_SPI_ICM20601) || defined(USE_GYRO_SPI_ICM20689)
+    gyroSensor->gyroDev.mpuIntExtiTag = mpuIntExtiTag;
+    gyroSensor->gyroDev.bus.busdev_u.spi.csnPin = csnPin;
+    mpuDetect(&gyroSensor->gyroDev);
+#else
+    UNUSED(csnPin);
+    UNUSED(mpuIntExtiTag);
+#endif
+
+    const gyroSensor_e gyroHardware = gyroDetect(&gyroSensor->gyroDev);
+
+    if (gyroHardware != GYRO_NONE && !gyroHardwareSupports32kHz(gyroHardware)) {
         gyroConfigMutable()->gyro_use_32khz = false;
-        break;
     }
 
+    return gyroHardware;
+}
+
+#ifdef USE_DUAL_GYRO
+static bool gyroUseBoth(void)
+{
+    return gyroToUse >= GYRO_CONFIG_USE_GYRO_AVERAGE;
+}
+#endif
+
+static void gyroInitSensor(gyroSensor_t *gyroSensor)
+{
+#ifdef USE_GYRO_FIFO
+    gyroSensor->gyroDev.fifoEnabled = gyroConfig()->gyro_use_fifo && gyroSensor->gyroDev.readFifoFn;
+#ifdef USE_DUAL_GYRO
+    // the fused modes take one sample from each gyro at a time
+    if (gyroUseBoth()) {
+        gyroSensor->gyroDev.fifoEnabled = false;
+    }
+#endif
+#endif
     // Must set gyro targetLooptime before gyroDev.init and initialisation of filters
     gyro.targetLooptime = gyroSetSampleRate(&gyroSensor->gyroDev, gyroConfig()->gyro_lpf, gyroConfig()->gyro_sync_denom, gyroConfig()->gyro_use_32khz);
+    gyro.sampleLooptime = gyro.targetLooptime;
+    gyroClockScale = 1.0f;
+#ifdef USE_GYRO_FIFO
+    if (gyroSensor->gyroDev.fifoEnabled) {
+        // the gyro samples into its FIFO at the full rate, without the divider, and the loop reads gyro_sync_denom samples at a time
+        gyro.sampleLooptime = gyroSetSampleRate(&gyroSensor->gyroDev, gyroConfig()->gyro_lpf, 1, gyroConfig()->gyro_use_32khz);
+    }
+#endif
     gyroSensor->gyroDev.lpf = gyroConfig()->gyro_lpf;
     gyroSensor->gyroDev.initFn(&gyroSensor->gyroDev);
     if (gyroConfig()->gyro_align != ALIGN_DEFAULT) {
         gyroSensor->gyroDev.gyroAlign = gyroConfig()->gyro_align;
     }
+    buildAlignmentMatrix(&gyroSensor->alignment, gyroSensor->gyroDev.gyroAlign, gyroSensor->gyroDev.scale);
     gyroInitSensorFilters(gyroSensor);
-#ifdef USE_GYRO_DATA_ANALYSE
-    gyroDataAnalyseInit(gyro.targetLooptime);
-#endif
-    return true;
+}
+
+static ioTag_t gyroMpuIntExtiTag(void)
+{
+#if defined(MPU_INT_EXTI)
+    return IO_TAG(MPU_INT_EXTI);
+#elif defined(USE_HARDWARE_REVISION_DETECTION)
+    return selectMPUIntExtiConfigByHardwareRevision();
+#else
+    return IO_TAG_NONE;
+#endif // MPU_INT_EXTI
 }
 
 bool gyroInit(void)
 {
     memset(&gyro, 0, sizeof(gyro));
-    return gyroInitSensor(&gyroSensor1);
+
+#ifdef USE_DUAL_GYRO
+    gyroToUse = gyroConfig()->gyro_to_use;
+    if (gyroToUse >= GYRO_CONFIG_USE_GYRO_AVERAGE) {
+        // the second gyro only has a data ready interrupt if the target defines one, it is read when the first one is ready
+#ifdef GYRO_1_EXTI_PIN
+        const ioTag_t gyro2IntExtiTag = IO_TAG(GYRO_1_EXTI_PIN);
+#else
+        const ioTag_t gyro2IntExtiTag = IO_TAG_NONE;
+#endif
+        if (gyroDetectSensor(&gyroSensor2, IOGetByTag(IO_TAG(GYRO_1_CS_PIN)), gyro2IntExtiTag) == GYRO_NONE) {
+            // carry on with the first gyro alone
+            gyroToUse = GYRO_CONFIG_USE_GYRO_1;
+        }
+    }
+    // set cnsPin using GYRO_n_CS_PIN defined in target.h
+    const IO_t gyro1CsnPin = gyroToUse == GYRO_CONFIG_USE_GYRO_2 ? IOGetByTag(IO_TAG(GYRO_1_CS_PIN)) : IOGetByTag(IO_TAG(GYRO_0_CS_PIN));
+#else
+    const IO_t gyro1CsnPin = IO_NONE;
+#endif // USE_DUAL_GYRO
+
+    const gyroSensor_e gyroHardware = gyroDetectSensor(&gyroSensor1, gyro1CsnPin, gyroMpuIntExtiTag());
+    if (gyroHardware == GYRO_NONE) {
+        return false;
+    }
+#if defined(USE_GYRO_MPU6050) || defined(USE_GYRO_MPU3050) || defined(USE_GYRO_MPU6500) || defined(USE_GYRO_SPI_MPU6500) || defined(USE_GYRO_SPI_MPU6000) || defined(USE_ACC_MPU6050) || defined(USE_GYRO_SPI_MPU9250) || defined(USE_GYRO_SPI_ICM20601) || defined(USE_GYRO_SPI_ICM20689)
+    mpuResetFn = gyroSensor1.gyroDev.mpuConfiguration.resetFn; // must be set after mpuDetect
+#endif
+    detectedSensors[SENSOR_INDEX_GYRO] = gyroHardware;
+    sensorsSet(SENSOR_GYRO);
+
+    // both gyros are detected first, so both are set up for a sample rate they support
+    gyroInitSensor(&gyroSensor1);
+#ifdef USE_DUAL_GYRO
+    if (gyroToUse >= GYRO_CONFIG_USE_GYRO_AVERAGE) {
+        gyroInitSensor(&gyroSensor2);
+    }
+#endif
+#ifdef USE_GYRO_DMA
+    bool useDma = true;
+#ifdef USE_DUAL_GYRO
+    // the second gyro may share the bus, and its transfers would collide with the DMA
+    useDma = !gyroUseBoth();
+#endif
+    if (useDma) {
+        mpuGyroDmaInit(&gyroSensor1.gyroDev);
+    }
+#endif
+#ifdef USE_GYRO_DATA_ANALYSE
+    gyroDataAnalyseInit(gyro.sampleLooptime);
+#endif
+#ifdef USE_RPM_FILTER
+    rpmFilterInit(gyro.sampleLooptime);
+#endif
+#ifdef USE_GYRO_BIAS_TRACKING
+    gyroBiasInit();
+#endif
+#ifdef USE_GYRO_SAMPLE_CLOCK
+    gyroSampleClockStart();
+#endif
+#ifdef USE_GYRO_OVERFLOW_CHECK
+    gyroOverflowCheckEnabled = gyroConfig()->gyro_overflow_detect;
+    gyroOverflow = false;
+    yawSpinRecoveryEnabled = gyroConfig()->yaw_spin_recovery;
+    yawSpinThreshold = gyroConfig()->yaw_spin_threshold;
+    yawSpinDetected = false;
+#endif
+    return true;
 }
 
 void gyroInitFilterLpf(gyroSensor_t *gyroSensor, uint8_t lpfHz)
 {
-    gyroSensor->softLpfFilterApplyFn = nullFilterApply;
-    const uint32_t gyroFrequencyNyquist = 1000000 / 2 / gyro.targetLooptime;
+    gyroSensor->softLpfFilterApplyFn = nullFilterApplyXyz;
+    const uint32_t gyroFrequencyNyquist = 1000000 / 2 / gyro.sampleLooptime;
 
     if (lpfHz && lpfHz <= gyroFrequencyNyquist) {  // Initialisation needs to happen once samplingrate is known
         switch (gyroConfig()->gyro_soft_lpf_type) {
         case FILTER_BIQUAD:
-            gyroSensor->softLpfFilterApplyFn = (filterApplyFnPtr)biquadFilterApply;
-            for (int axis = 0; axis < 3; axis++) {
-                gyroSensor->softLpfFilterPtr[axis] = &gyroSensor->softLpfFilter.gyroFilterLpfState[axis];
-                biquadFilterInitLPF(&gyroSensor->softLpfFilter.gyroFilterLpfState[axis], lpfHz, gyro.targetLooptime);
-            }
+            gyroSensor->softLpfFilterApplyFn = (filterApplyXyzFnPtr)biquadFilterXyzApply;
+            biquadFilterXyzInitLPF(&gyroSensor->softLpfFilter.gyroFilterLpfState, lpfHz, gyro.sampleLooptime);
             break;
         case FILTER_PT1:
-            gyroSensor->softLpfFilterApplyFn = (filterApplyFnPtr)pt1FilterApply;
-            const float gyroDt = (float) gyro.targetLooptime * 0.000001f;
-            for (int axis = 0; axis < 3; axis++) {
-                gyroSensor->softLpfFilterPtr[axis] = &gyroSensor->softLpfFilter.gyroFilterPt1State[axis];
-                pt1FilterInit(&gyroSensor->softLpfFilter.gyroFilterPt1State[axis], lpfHz, gyroDt);
-            }
+            gyroSensor->softLpfFilterApplyFn = (filterApplyXyzFnPtr)pt1FilterXyzApply;
+            const float gyroDt = (float) gyro.sampleLooptime * 0.000001f;
+            pt1FilterXyzInit(&gyroSensor->softLpfFilter.gyroFilterPt1State, lpfHz, gyroDt);
             break;
         default:
-            gyroSensor->softLpfFilterApplyFn = (filterApplyFnPtr)firFilterDenoiseUpdate;
-            for (int axis = 0; axis < 3; axis++) {
-                gyroSensor->softLpfFilterPtr[axis] = &gyroSensor->softLpfFilter.gyroDenoiseState[axis];
-                firFilterDenoiseInit(&gyroSensor->softLpfFilter.gyroDenoiseState[axis], lpfHz, gyro.targetLooptime);
-            }
+            gyroSensor->softLpfFilterApplyFn = (filterApplyXyzFnPtr)firFilterDenoiseXyzUpdate;
+            memset(&gyroSensor->softLpfFilter.gyroDenoiseState, 0, sizeof(gyroSensor->softLpfFilter.gyroDenoiseState));
+            firFilterDenoiseXyzInit(&gyroSensor->softLpfFilter.gyroDenoiseState, lpfHz, gyro.sampleLooptime);
             break;
         }
     }
@@ -397,7 +582,7 @@ void gyroInitFilterLpf(gyroSensor_t *gyroSensor, uint8_t lpfHz)
 
 static uint16_t calculateNyquistAdjustedNotchHz(uint16_t notchHz, uint16_t notchCutoffHz)
 {
-    const uint32_t gyroFrequencyNyquist = 1000000 / 2 / gyro.targetLooptime;
+    const uint32_t gyroFrequencyNyquist = 1000000 / 2 / gyro.sampleLooptime;
     if (notchHz > gyroFrequencyNyquist) {
         if (notchCutoffHz < gyroFrequencyNyquist) {
             notchHz = gyroFrequencyNyquist;
@@ -411,54 +596,139 @@ static uint16_t calculateNyquistAdjustedNotchHz(uint16_t notchHz, uint16_t notch
 
 void gyroInitFilterNotch1(gyroSensor_t *gyroSensor, uint16_t notchHz, uint16_t notchCutoffHz)
 {
-    gyroSensor->notchFilter1ApplyFn = nullFilterApply;
+    gyroSensor->notchFilter1ApplyFn = nullFilterApplyXyz;
 
     notchHz = calculateNyquistAdjustedNotchHz(notchHz, notchCutoffHz);
 
     if (notchHz) {
-        gyroSensor->notchFilter1ApplyFn = (filterApplyFnPtr)biquadFilterApply;
+        gyroSensor->notchFilter1ApplyFn = (filterApplyXyzFnPtr)biquadFilterXyzApply;
         const float notchQ = filterGetNotchQ(notchHz, notchCutoffHz);
-        for (int axis = 0; axis < 3; axis++) {
-            biquadFilterInit(&gyroSensor->notchFilter1[axis], notchHz, gyro.targetLooptime, notchQ, FILTER_NOTCH);
-        }
+        biquadFilterXyzInit(&gyroSensor->notchFilter1, notchHz, gyro.sampleLooptime, notchQ, FILTER_NOTCH);
     }
 }
 
 void gyroInitFilterNotch2(gyroSensor_t *gyroSensor, uint16_t notchHz, uint16_t notchCutoffHz)
 {
-    gyroSensor->notchFilter2ApplyFn = nullFilterApply;
+    gyroSensor->notchFilter2ApplyFn = nullFilterApplyXyz;
 
     notchHz = calculateNyquistAdjustedNotchHz(notchHz, notchCutoffHz);
 
     if (notchHz) {
-        gyroSensor->notchFilter2ApplyFn = (filterApplyFnPtr)biquadFilterApply;
+        gyroSensor->notchFilter2ApplyFn = (filterApplyXyzFnPtr)biquadFilterXyzApply;
         const float notchQ = filterGetNotchQ(notchHz, notchCutoffHz);
-        for (int axis = 0; axis < 3; axis++) {
-            biquadFilterInit(&gyroSensor->notchFilter2[axis], notchHz, gyro.targetLooptime, notchQ, FILTER_NOTCH);
-        }
+        biquadFilterXyzInit(&gyroSensor->notchFilter2, notchHz, gyro.sampleLooptime, notchQ, FILTER_NOTCH);
     }
 }
 
+#ifdef USE_GYRO_DATA_ANALYSE
 void gyroInitFilterDynamicNotch(gyroSensor_t *gyroSensor)
 {
-    gyroSensor->notchFilterDynApplyFn = (filterApplyFnPtr)biquadFilterApplyDF1; // must be this function, not DF2
+    gyroSensor->notchFilterDynApplyFn = (filterApplyXyzFnPtr)biquadFilterXyzApplyDF1; // must be this function, not DF2
+    gyroSensor->notchFilterDynCount = constrain(gyroConfig()->dyn_notch_count, 1, GYRO_DYN_NOTCH_COUNT_MAX);
     const float notchQ = filterGetNotchQ(400, 390); //just any init value
-    for (int axis = 0; axis < 3; axis++) {
-        biquadFilterInit(&gyroSensor->notchFilterDyn[axis], 400, gyro.targetLooptime, notchQ, FILTER_NOTCH);
+    for (int i = 0; i < GYRO_DYN_NOTCH_COUNT_MAX; i++) {
+        biquadFilterXyzInit(&gyroSensor->notchFilterDyn[i], 400, gyro.sampleLooptime, notchQ, FILTER_NOTCH);
+    }
+}
+#endif
+
+// any combination of stages, each called through its function pointer
+#define GYRO_FILTER_FUNCTION_NAME gyroFilterChainGeneric
+#define GYRO_FILTER_NOTCH1 gyroSensor->notchFilter1ApplyFn(&gyroSensor->notchFilter1, gyroADCf)
+#define GYRO_FILTER_NOTCH2 gyroSensor->notchFilter2ApplyFn(&gyroSensor->notchFilter2, gyroADCf)
+#define GYRO_FILTER_LPF gyroSensor->softLpfFilterApplyFn(&gyroSensor->softLpfFilter, gyroADCf)
+#include "gyro_filter_impl.h"
+
+#ifdef USE_GYRO_FILTER_CHAINS
+// The common combinations, with the filters inlined so the compiler can schedule all the stages together
+
+#define GYRO_FILTER_NOTCH1_INLINE biquadFilterXyzApplyInline(&gyroSensor->notchFilter1, gyroADCf)
+#define GYRO_FILTER_NOTCH2_INLINE biquadFilterXyzApplyInline(&gyroSensor->notchFilter2, gyroADCf)
+#define GYRO_FILTER_PT1_INLINE pt1FilterXyzApplyInline(&gyroSensor->softLpfFilter.gyroFilterPt1State, gyroADCf)
+#define GYRO_FILTER_BIQUAD_INLINE biquadFilterXyzApplyInline(&gyroSensor->softLpfFilter.gyroFilterLpfState, gyroADCf)
+
+#define GYRO_FILTER_FUNCTION_NAME gyroFilterChainPt1
+#define GYRO_FILTER_NOTCH1
+#define GYRO_FILTER_NOTCH2
+#define GYRO_FILTER_LPF GYRO_FILTER_PT1_INLINE
+#include "gyro_filter_impl.h"
+
+#define GYRO_FILTER_FUNCTION_NAME gyroFilterChainNotchPt1
+#define GYRO_FILTER_NOTCH1 GYRO_FILTER_NOTCH1_INLINE
+#define GYRO_FILTER_NOTCH2
+#define GYRO_FILTER_LPF GYRO_FILTER_PT1_INLINE
+#include "gyro_filter_impl.h"
+
+#define GYRO_FILTER_FUNCTION_NAME gyroFilterChainNotch2Pt1
+#define GYRO_FILTER_NOTCH1 GYRO_FILTER_NOTCH1_INLINE
+#define GYRO_FILTER_NOTCH2 GYRO_FILTER_NOTCH2_INLINE
+#define GYRO_FILTER_LPF GYRO_FILTER_PT1_INLINE
+#include "gyro_filter_impl.h"
+
+#define GYRO_FILTER_FUNCTION_NAME gyroFilterChainBiquad
+#define GYRO_FILTER_NOTCH1
+#define GYRO_FILTER_NOTCH2
+#define GYRO_FILTER_LPF GYRO_FILTER_BIQUAD_INLINE
+#include "gyro_filter_impl.h"
+
+#define GYRO_FILTER_FUNCTION_NAME gyroFilterChainNotchBiquad
+#define GYRO_FILTER_NOTCH1 GYRO_FILTER_NOTCH1_INLINE
+#define GYRO_FILTER_NOTCH2
+#define GYRO_FILTER_LPF GYRO_FILTER_BIQUAD_INLINE
+#include "gyro_filter_impl.h"
+
+#define GYRO_FILTER_FUNCTION_NAME gyroFilterChainNotch2Biquad
+#define GYRO_FILTER_NOTCH1 GYRO_FILTER_NOTCH1_INLINE
+#define GYRO_FILTER_NOTCH2 GYRO_FILTER_NOTCH2_INLINE
+#define GYRO_FILTER_LPF GYRO_FILTER_BIQUAD_INLINE
+#include "gyro_filter_impl.h"
+
+// indexed by the number of static notches enabled
+static const gyroFilterChainFnPtr gyroFilterChainsPt1[] = { gyroFilterChainPt1, gyroFilterChainNotchPt1, gyroFilterChainNotch2Pt1 };
+static const gyroFilterChainFnPtr gyroFilterChainsBiquad[] = { gyroFilterChainBiquad, gyroFilterChainNotchBiquad, gyroFilterChainNotch2Biquad };
+
+static gyroFilterChainFnPtr gyroSelectFilterChain(const gyroSensor_t *gyroSensor)
+{
+    const bool notch1 = gyroSensor->notchFilter1ApplyFn != nullFilterApplyXyz;
+    const bool notch2 = gyroSensor->notchFilter2ApplyFn != nullFilterApplyXyz;
+    if (notch2 && !notch1) {
+        return gyroFilterChainGeneric;
+    }
+    const int notchCount = notch1 + notch2;
+
+    if (gyroSensor->softLpfFilterApplyFn == (filterApplyXyzFnPtr)pt1FilterXyzApply) {
+        return gyroFilterChainsPt1[notchCount];
     }
+    if (gyroSensor->softLpfFilterApplyFn == (filterApplyXyzFnPtr)biquadFilterXyzApply) {
+        return gyroFilterChainsBiquad[notchCount];
+    }
+    return gyroFilterChainGeneric;
 }
+#else
+static gyroFilterChainFnPtr gyroSelectFilterChain(const gyroSensor_t *gyroSensor)
+{
+    UNUSED(gyroSensor);
+    return gyroFilterChainGeneric;
+}
+#endif // USE_GYRO_FILTER_CHAINS
 
 static void gyroInitSensorFilters(gyroSensor_t *gyroSensor)
 {
     gyroInitFilterLpf(gyroSensor, gyroConfig()->gyro_soft_lpf_hz);
     gyroInitFilterNotch1(gyroSensor, gyroConfig()->gyro_soft_notch_hz_1, gyroConfig()->gyro_soft_notch_cutoff_1);
     gyroInitFilterNotch2(gyroSensor, gyroConfig()->gyro_soft_notch_hz_2, gyroConfig()->gyro_soft_notch_cutoff_2);
+#ifdef USE_GYRO_DATA_ANALYSE
     gyroInitFilterDynamicNotch(gyroSensor);
+#endif
+    gyroSensor->filterChainFn = gyroSelectFilterChain(gyroSensor);
 }
 
 void gyroInitFilters(void)
 {
     gyroInitSensorFilters(&gyroSensor1);
+#ifdef USE_RPM_FILTER
+    rpmFilterInit(gyro.sampleLooptime);
+#endif
 }
 
 bool isGyroSensorCalibrationComplete(const gyroSensor_t *gyroSensor)
@@ -468,6 +738,11 @@ bool isGyroSensorCalibrationComplete(const gyroSensor_t *gyroSensor)
 
 bool isGyroCalibrationComplete(void)
 {
+#ifdef USE_DUAL_GYRO
+    if (gyroUseBoth() && !isGyroSensorCalibrationComplete(&gyroSensor2)) {
+        return false;
+    }
+#endif
     return isGyroSensorCalibrationComplete(&gyroSensor1);
 }
 
@@ -491,10 +766,164 @@ static void gyroSetCalibrationCycles(gyroSensor_t *gyroSensor)
     gyroSensor->calibration.calibratingG = gyroCalculateCalibratingCycles();
 }
 
+#ifdef USE_GYRO_BIAS_TRACKING
+// Takes the offsets of gyroSensor as the base the tracking and temperature compensation work from
+static void gyroBiasSetBase(gyroSensor_t *gyroSensor)
+{
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        gyroZeroBase[axis] = gyroSensor->gyroDev.gyroZero[axis];
+    }
+    gyroZeroBaseTemperature = gyroGetTemperature();
+    gyroZeroBaseWindows = 2;    // a calibration is about as good as two windows
+    gyroBiasResetEstimator();
+}
+
+// Runs once a second from the dispatcher, so the temperature is read off the gyro loop
+static void gyroBiasUpdate(dispatchEntry_t *self)
+{
+    gyroReadTemperature();
+    const int16_t temperature = gyroGetTemperature();
+    gyroDev_t *gyroDev = &gyroSensor1.gyroDev;
+
+    if (!ARMING_FLAG(ARMED)) {
+        float mean[XYZ_AXIS_COUNT];
+        if (isGyroSensorCalibrationComplete(&gyroSensor1) && gyroBiasEstimatorRead(&gyroBiasEstimator, mean)) {
+            // a running average at first, so a preset offset from the table is corrected quickly, then a moving one
+            gyroZeroBaseWindows = MIN(gyroZeroBaseWindows + 1, GYRO_BIAS_AVERAGE_WINDOWS);
+            for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+                gyroZeroBase[axis] += (mean[axis] - gyroZeroBase[axis]) / gyroZeroBaseWindows;
+                gyroDev->gyroZero[axis] = lrintf(gyroZeroBase[axis]);
+            }
+            gyroZeroBaseTemperature = temperature;
+            gyroBiasTableUpdate(gyroBiasTableMutable(), temperature, mean);
+        }
+    } else {
+        // the craft moves in flight, so the offset follows the change the table has for the temperature
+        float bias[XYZ_AXIS_COUNT];
+        float baseBias[XYZ_AXIS_COUNT];
+        if (isGyroSensorCalibrationComplete(&gyroSensor1)
+            && gyroBiasTableLookup(gyroBiasTable(), temperature, bias)
+            && gyroBiasTableLookup(gyroBiasTable(), gyroZeroBaseTemperature, baseBias)) {
+            for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+                gyroDev->gyroZero[axis] = lrintf(gyroZeroBase[axis] + bias[axis] - baseBias[axis]);
+            }
+        }
+        // a window cut short by arming is not stationary
+        gyroBiasResetEstimator();
+    }
+
+    dispatchAdd(self, GYRO_BIAS_UPDATE_PERIOD_US);
+}
+
+static dispatchEntry_t gyroBiasDispatch = { .dispatch = gyroBiasUpdate };
+
+static void gyroBiasInit(void)
+{
+    gyroBiasTrackingEnabled = gyroConfig()->gyro_bias_tracking && gyroConfig()->gyroMovementCalibrationThreshold;
+#ifdef USE_DUAL_GYRO
+    if (gyroUseBoth()) {
+        gyroBiasTrackingEnabled = false;
+    }
+#endif
+    if (!gyroBiasTrackingEnabled) {
+        return;
+    }
+
+    gyroBiasResetEstimator();
+    dispatchEnable();
+    dispatchAdd(&gyroBiasDispatch, GYRO_BIAS_UPDATE_PERIOD_US);
+
+    // with an offset learnt at this temperature, the power up calibration is not needed
+    gyroReadTemperature();
+    gyroZeroPresetFromTable = gyroBiasTableLookup(gyroBiasTable(), gyroGetTemperature(), gyroZeroBase);
+}
+
+// Returns true if the offsets were set from the table instead of starting a calibration
+static bool gyroBiasPresetZero(void)
+{
+    if (!gyroZeroPresetFromTable) {
+        return false;
+    }
+    gyroZeroPresetFromTable = false;
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        gyroSensor1.gyroDev.gyroZero[axis] = lrintf(gyroZeroBase[axis]);
+    }
+    gyroSensor1.calibration.calibratingG = 0;
+    gyroZeroBaseTemperature = gyroGetTemperature();
+    gyroZeroBaseWindows = 0;
+    beeper(BEEPER_GYRO_CALIBRATED);
+    return true;
+}
+#endif
+
+#ifdef USE_GYRO_SAMPLE_CLOCK
+/*
+ * The filters, the PID controller and the loop are set up for the nominal gyro rate, while the gyro samples on its own
+ * oscillator. Once the real rate has been measured they are set up again for it, which resets the filters, so it is
+ * only done while disarmed.
+ */
+static void gyroSampleClockDispatchUpdate(dispatchEntry_t *self)
+{
+    const gyroDev_t *gyroDev = &gyroSensor1.gyroDev;
+    uint32_t count;
+    timeUs_t timeUs;
+    // the interrupt sets the time before the count, so an unchanged count was read with its own time
+    do {
+        count = gyroDev->dataReadyCount;
+        timeUs = gyroDev->dataReadyTimeUs;
+    } while (count != gyroDev->dataReadyCount);
+
+    if (gyroSampleClockUpdate(&gyroSampleClock, timeUs, count) && !ARMING_FLAG(ARMED)) {
+        const float scale = gyroSampleClock.intervalUs / gyroSampleClock.nominalIntervalUs;
+        if (fabsf(scale - gyroClockScale) > GYRO_SAMPLE_CLOCK_MIN_CHANGE) {
+            gyroClockScale = scale;
+            gyro.sampleLooptime = gyroSampleClock.intervalUs;
+            gyroInitFilters();
+#ifdef USE_GYRO_DATA_ANALYSE
+            gyroDataAnalyseInit(gyro.sampleLooptime);
+#endif
+        }
+    }
+
+    dispatchAdd(self, GYRO_SAMPLE_CLOCK_UPDATE_PERIOD_US);
+}
+
+static dispatchEntry_t gyroSampleClockDispatch = { .dispatch = gyroSampleClockDispatchUpdate };
+
+static void gyroSampleClockStart(void)
+{
+#ifdef USE_GYRO_FIFO
+    // the FIFO is read without the data ready interrupt, so there is nothing to time
+    if (gyroSensor1.gyroDev.fifoEnabled) {
+        return;
+    }
+#endif
+    gyroSampleClockInit(&gyroSampleClock, gyro.targetLooptime);
+    dispatchEnable();
+    dispatchAdd(&gyroSampleClockDispatch, GYRO_SAMPLE_CLOCK_UPDATE_PERIOD_US);
+}
+#endif
+
+// The measured over the nominal gyro sample interval, 1 until the gyro's clock has been measured
+float gyroSampleClockScale(void)
+{
+    return gyroClockScale;
+}
+
 void gyroStartCalibration(bool isFirstArmingCalibration)
 {
+#ifdef USE_GYRO_BIAS_TRACKING
+    if (!isFirstArmingCalibration && gyroBiasPresetZero()) {
+        return;
+    }
+#endif
     if (!(isFirstArmingCalibration && firstArmingCalibrationWasStarted)) {
         gyroSetCalibrationCycles(&gyroSensor1);
+#ifdef USE_DUAL_GYRO
+        if (gyroUseBoth()) {
+            gyroSetCalibrationCycles(&gyroSensor2);
+        }
+#endif
 
         if (isFirstArmingCalibration) {
             firstArmingCalibrationWasStarted = true;
@@ -537,6 +966,11 @@ STATIC_UNIT_TESTED void performGyroCalibration(gyroSensor_t *gyroSensor, uint8_t
     }
 
     if (isOnFinalGyroCalibrationCycle(&gyroSensor->calibration)) {
+#ifdef USE_GYRO_BIAS_TRACKING
+        if (gyroSensor == &gyroSensor1) {
+            gyroBiasSetBase(gyroSensor);
+        }
+#endif
         schedulerResetTaskStatistics(TASK_SELF); // so calibration cycles do not pollute tasks statistics
         if (!firstArmingCalibrationWasStarted || !isArmingDisabled()) {
             beeper(BEEPER_GYRO_CALIBRATED);
@@ -546,69 +980,471 @@ STATIC_UNIT_TESTED void performGyroCalibration(gyroSensor_t *gyroSensor, uint8_t
 
 }
 
-void gyroUpdateSensor(gyroSensor_t *gyroSensor)
+// Removes the calibrated offset from raw, then scales it to degrees per second and aligns it to the board in one multiply
+static void gyroSensorRate(const gyroSensor_t *gyroSensor, const int16_t raw[XYZ_AXIS_COUNT], float rate[XYZ_AXIS_COUNT])
 {
-    if (!gyroSensor->gyroDev.readFn(&gyroSensor->gyroDev)) {
+    const float calibrated[XYZ_AXIS_COUNT] = {
+        (int32_t)raw[X] - gyroSensor->gyroDev.gyroZero[X],
+        (int32_t)raw[Y] - gyroSensor->gyroDev.gyroZero[Y],
+        (int32_t)raw[Z] - gyroSensor->gyroDev.gyroZero[Z]
+    };
+    applyAlignmentMatrix(&gyroSensor->alignment, calibrated, rate);
+}
 
-        return;
+// Returns true if there is a new calibrated sample in gyroDev.gyroADCRaw
+static bool gyroReadSensor(gyroSensor_t *gyroSensor)
+{
+    TRACE_BEGIN(TRACE_GYRO_READ);
+#ifdef USE_GYRO_FIFO
+    // the FIFO read leaves the newest sample in gyroADCRaw, which is the one calibrated on
+    const bool dataRead = gyroSensor->gyroDev.fifoEnabled ? gyroSensor->gyroDev.readFifoFn(&gyroSensor->gyroDev) : gyroSensor->gyroDev.readFn(&gyroSensor->gyroDev);
+#else
+    const bool dataRead = gyroSensor->gyroDev.readFn(&gyroSensor->gyroDev);
+#endif
+    TRACE_END(TRACE_GYRO_READ);
+    if (!dataRead) {
+        return false;
     }
     gyroSensor->gyroDev.dataReady = false;
+    gyroSensor->sampleTimeUs = gyroSensor->gyroDev.dataReadyTimeUs;
 
-    if (isGyroSensorCalibrationComplete(gyroSensor)) {
-        // move gyro data into 32-bit variables to avoid overflows in calculations
-        gyroSensor->gyroDev.gyroADC[X] = (int32_t)gyroSensor->gyroDev.gyroADCRaw[X] - (int32_t)gyroSensor->gyroDev.gyroZero[X];
-        gyroSensor->gyroDev.gyroADC[Y] = (int32_t)gyroSensor->gyroDev.gyroADCRaw[Y] - (int32_t)gyroSensor->gyroDev.gyroZero[Y];
-        gyroSensor->gyroDev.gyroADC[Z] = (int32_t)gyroSensor->gyroDev.gyroADCRaw[Z] - (int32_t)gyroSensor->gyroDev.gyroZero[Z];
-
-        alignSensors(gyroSensor->gyroDev.gyroADC, gyroSensor->gyroDev.gyroAlign);
-    } else {
+    if (!isGyroSensorCalibrationComplete(gyroSensor)) {
         performGyroCalibration(gyroSensor, gyroConfig()->gyroMovementCalibrationThreshold);
         // Reset gyro values to zero to prevent other code from using uncalibrated data
         gyro.gyroADCf[X] = 0.0f;
         gyro.gyroADCf[Y] = 0.0f;
         gyro.gyroADCf[Z] = 0.0f;
-        // still calibrating, so no need to further process gyro data
-        return;
+        return false;
     }
 
-#ifdef USE_GYRO_DATA_ANALYSE
-    gyroDataAnalyse(&gyroSensor->gyroDev, gyroSensor->notchFilterDyn);
+#ifdef USE_GYRO_BIAS_TRACKING
+    if (gyroBiasTrackingEnabled && !ARMING_FLAG(ARMED)) {
+        gyroBiasEstimatorPush(&gyroBiasEstimator, gyroSensor->gyroDev.gyroADCRaw);
+    }
 #endif
+    return true;
+}
+
+static void gyroAccumulateDeltaAngle(const float rate[XYZ_AXIS_COUNT])
+{
+    const float dT = gyro.sampleLooptime * 1e-6f;
+    const float delta[XYZ_AXIS_COUNT] = {
+        DEGREES_TO_RADIANS(rate[X]) * dT,
+        DEGREES_TO_RADIANS(rate[Y]) * dT,
+        DEGREES_TO_RADIANS(rate[Z]) * dT
+    };
+
+    // first order coning correction, half the cross product of the rotation so far with this sample's
+    gyroConing[X] += 0.5f * (gyroDeltaAngle[Y] * delta[Z] - gyroDeltaAngle[Z] * delta[Y]);
+    gyroConing[Y] += 0.5f * (gyroDeltaAngle[Z] * delta[X] - gyroDeltaAngle[X] * delta[Z]);
+    gyroConing[Z] += 0.5f * (gyroDeltaAngle[X] * delta[Y] - gyroDeltaAngle[Y] * delta[X]);
+
+    gyroDeltaAngle[X] += delta[X];
+    gyroDeltaAngle[Y] += delta[Y];
+    gyroDeltaAngle[Z] += delta[Z];
+    gyroDeltaTimeUs += gyro.sampleLooptime;
+}
 
+static void gyroTakeDeltaAngle(float deltaAngle[XYZ_AXIS_COUNT], timeUs_t *deltaTimeUs)
+{
     for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
-        // scale gyro output to degrees per second
-        float gyroADCf = (float)gyroSensor->gyroDev.gyroADC[axis] * gyroSensor->gyroDev.scale;
+        deltaAngle[axis] = gyroDeltaAngle[axis] + gyroConing[axis];
+        gyroDeltaAngle[axis] = 0.0f;
+        gyroConing[axis] = 0.0f;
+    }
+    *deltaTimeUs = lrintf(gyroDeltaTimeUs);
+    gyroDeltaTimeUs = 0.0f;
+}
+
+// Returns the rotation vector, in radians, accumulated since the last call and the time it covers.
+// Returns false if no gyro sample has been filtered since.
+bool gyroGetDeltaAngle(float deltaAngle[XYZ_AXIS_COUNT], timeUs_t *deltaTimeUs)
+{
+#if defined(USE_GYRO_ISR_UPDATE) && !defined(SIMULATOR_BUILD)
+    // the gyro may be updated from its data ready interrupt, the simulated one only runs between scheduler steps
+    ATOMIC_BLOCK(NVIC_PRIO_MPU_INT_EXTI) {
+        gyroTakeDeltaAngle(deltaAngle, deltaTimeUs);
+    }
+#else
+    gyroTakeDeltaAngle(deltaAngle, deltaTimeUs);
+#endif
+    return *deltaTimeUs != 0;
+}
 
+#ifdef USE_GYRO_OVERFLOW_CHECK
+// Compares and nothing else, as it runs on every sample
+static void gyroCheckOverflow(const int16_t raw[XYZ_AXIS_COUNT], timeUs_t sampleTimeUs)
+{
+    const int x = ABS(raw[X]);
+    const int y = ABS(raw[Y]);
+    const int z = ABS(raw[Z]);
+    const int peak = MAX(MAX(x, y), z);
+
+    if (peak >= GYRO_OVERFLOW_RESET_ADC) {
+        gyroOverflowOutOfRangeAtUs = sampleTimeUs;
+        if (peak >= GYRO_OVERFLOW_TRIGGER_ADC && !gyroOverflow) {
+            gyroOverflow = true;
+            gyroOverflowFilterReset = true;
+            gyroOverflowCount++;
+        }
+    } else if (gyroOverflow && cmpTimeUs(sampleTimeUs, gyroOverflowOutOfRangeAtUs) > GYRO_OVERFLOW_RESET_US) {
+        gyroOverflow = false;
+    }
+}
+
+// Settles every stage of the filter chain on rate. A clipped sample is a step the notches would ring on and the
+// LPF would lag behind, settled stages pass the clipped rate straight through instead.
+static void gyroResetSensorFilters(gyroSensor_t *gyroSensor, const float rate[XYZ_AXIS_COUNT])
+{
+    biquadFilterXyzReset(&gyroSensor->notchFilter1, rate);
+    biquadFilterXyzReset(&gyroSensor->notchFilter2, rate);
 #ifdef USE_GYRO_DATA_ANALYSE
-        // Apply Dynamic Notch filtering
-        if (axis == 0)
-            DEBUG_SET(DEBUG_FFT, 0, lrintf(gyroADCf)); // store raw data
+    for (int i = 0; i < gyroSensor->notchFilterDynCount; i++) {
+        biquadFilterXyzReset(&gyroSensor->notchFilterDyn[i], rate);
+    }
+#endif
+    // the FIR denoise filter is a moving average, it is left to flush itself
+    if (gyroSensor->softLpfFilterApplyFn == (filterApplyXyzFnPtr)pt1FilterXyzApply) {
+        pt1FilterXyzReset(&gyroSensor->softLpfFilter.gyroFilterPt1State, rate);
+    } else if (gyroSensor->softLpfFilterApplyFn == (filterApplyXyzFnPtr)biquadFilterXyzApply) {
+        biquadFilterXyzReset(&gyroSensor->softLpfFilter.gyroFilterLpfState, rate);
+    }
+}
 
-        if (isDynamicFilterActive())
-            gyroADCf = gyroSensor->notchFilterDynApplyFn(&gyroSensor->notchFilterDyn[axis], gyroADCf);
+// A clipped yaw rate says nothing about how fast the craft really spins, so the recovery holds while the gyro overflows
+static void gyroCheckYawSpin(timeUs_t currentTimeUs)
+{
+    const float yawRate = fabsf(gyro.gyroUnfiltered[Z]);
 
-        if (axis == 0)
-            DEBUG_SET(DEBUG_FFT, 1, lrintf(gyroADCf)); // store data after dynamic notch
+    if (yawSpinDetected) {
+        if (gyroOverflow || yawRate >= yawSpinThreshold * 0.5f) {
+            yawSpinRecoveringSinceUs = currentTimeUs;
+        } else if (cmpTimeUs(currentTimeUs, yawSpinRecoveringSinceUs) > YAW_SPIN_RECOVERED_US) {
+            yawSpinDetected = false;
+        }
+    } else if (yawRate >= yawSpinThreshold) {
+        yawSpinDetected = true;
+        yawSpinRecoveringSinceUs = currentTimeUs;
+    }
+}
 #endif
 
-        // Apply Static Notch filtering
-        DEBUG_SET(DEBUG_NOTCH, axis, lrintf(gyroADCf));
-        gyroADCf = gyroSensor->notchFilter1ApplyFn(&gyroSensor->notchFilter1[axis], gyroADCf);
-        gyroADCf = gyroSensor->notchFilter2ApplyFn(&gyroSensor->notchFilter2[axis], gyroADCf);
+bool gyroOverflowDetected(void)
+{
+#ifdef USE_GYRO_OVERFLOW_CHECK
+    return gyroOverflow;
+#else
+    return false;
+#endif
+}
 
-        // Apply LPF
-        DEBUG_SET(DEBUG_GYRO, axis, lrintf(gyroADCf));
-        gyroADCf = gyroSensor->softLpfFilterApplyFn(gyroSensor->softLpfFilterPtr[axis], gyroADCf);
+// Overflows detected since power up
+uint16_t gyroGetOverflowCount(void)
+{
+#ifdef USE_GYRO_OVERFLOW_CHECK
+    return gyroOverflowCount;
+#else
+    return 0;
+#endif
+}
 
-        gyro.gyroADCf[axis] = gyroADCf;
+bool gyroYawSpinDetected(void)
+{
+#ifdef USE_GYRO_OVERFLOW_CHECK
+    return yawSpinDetected;
+#else
+    return false;
+#endif
+}
+
+// Runs the filter chain of gyroSensor on rate, in degrees per second, and stores the result in gyro.gyroADCf
+static FAST_CODE void gyroFilterSensor(gyroSensor_t *gyroSensor, const float rate[XYZ_AXIS_COUNT])
+{
+#ifdef USE_GYRO_OVERFLOW_CHECK
+    if (gyroOverflowFilterReset) {
+        gyroOverflowFilterReset = false;
+        gyroResetSensorFilters(gyroSensor, rate);
+    }
+#endif
+
+#ifdef USE_GYRO_DATA_ANALYSE
+    TRACE_BEGIN(TRACE_GYRO_ANALYSE);
+    gyroDataAnalyse(rate, gyroSensor->notchFilterDyn);
+    TRACE_END(TRACE_GYRO_ANALYSE);
+#endif
+
+    // each stage filters all three axes in one call
+    float gyroADCf[XYZ_AXIS_COUNT] = { rate[X], rate[Y], rate[Z] };
+
+    // the unfiltered rate, so logs can be replayed through other filter settings
+    DEBUG_SET(DEBUG_GYRO, X, lrintf(gyroADCf[X]));
+    DEBUG_SET(DEBUG_GYRO, Y, lrintf(gyroADCf[Y]));
+    DEBUG_SET(DEBUG_GYRO, Z, lrintf(gyroADCf[Z]));
+
+#ifdef USE_GYRO_DATA_ANALYSE
+    // Apply Dynamic Notch filtering
+    DEBUG_SET(DEBUG_FFT, 0, lrintf(gyroADCf[X])); // store raw data
+
+    TRACE_BEGIN(TRACE_GYRO_FILTER_DYN_NOTCH);
+    if (isDynamicFilterActive()) {
+        for (int i = 0; i < gyroSensor->notchFilterDynCount; i++) {
+#ifdef USE_GYRO_FILTER_CHAINS
+            biquadFilterXyzApplyDF1Inline(&gyroSensor->notchFilterDyn[i], gyroADCf);
+#else
+            gyroSensor->notchFilterDynApplyFn(&gyroSensor->notchFilterDyn[i], gyroADCf);
+#endif
+        }
+    }
+    TRACE_END(TRACE_GYRO_FILTER_DYN_NOTCH);
+
+    DEBUG_SET(DEBUG_FFT, 1, lrintf(gyroADCf[X])); // store data after dynamic notch
+#endif
+
+#ifdef USE_RPM_FILTER
+    // Apply the motor RPM notches
+    TRACE_BEGIN(TRACE_GYRO_FILTER_RPM);
+    rpmFilterGyro(gyroADCf);
+    TRACE_END(TRACE_GYRO_FILTER_RPM);
+#endif
+
+    // Apply the static notches and LPF
+    gyroSensor->filterChainFn(gyroSensor, gyroADCf);
+
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        gyro.gyroADCf[axis] = gyroADCf[axis];
+        gyro.gyroUnfiltered[axis] = rate[axis];
+    }
+
+    gyroAccumulateDeltaAngle(gyroADCf);
+}
+
+#ifdef USE_GYRO_FIFO
+// Runs each sample read from the FIFO through the filter chain, so the filters see the full gyro rate while the loop runs slower
+static void gyroFilterSensorFifo(gyroSensor_t *gyroSensor)
+{
+    for (int i = 0; i < gyroSensor->gyroDev.fifoSampleCount; i++) {
+#ifdef USE_GYRO_OVERFLOW_CHECK
+        if (gyroOverflowCheckEnabled) {
+            gyroCheckOverflow(gyroSensor->gyroDev.fifoData[i], gyroSensor->sampleTimeUs);
+        }
+#endif
+        float rate[XYZ_AXIS_COUNT];
+        gyroSensorRate(gyroSensor, gyroSensor->gyroDev.fifoData[i], rate);
+        gyroFilterSensor(gyroSensor, rate);
+    }
+}
+#endif
+
+FAST_CODE void gyroUpdateSensor(gyroSensor_t *gyroSensor)
+{
+    if (!gyroReadSensor(gyroSensor)) {
+        return;
+    }
+#ifdef USE_GYRO_FIFO
+    if (gyroSensor->gyroDev.fifoEnabled) {
+        gyroFilterSensorFifo(gyroSensor);
+        return;
+    }
+#endif
+#ifdef USE_GYRO_OVERFLOW_CHECK
+    if (gyroOverflowCheckEnabled) {
+        gyroCheckOverflow(gyroSensor->gyroDev.gyroADCRaw, gyroSensor->sampleTimeUs);
     }
+#endif
+    float rate[XYZ_AXIS_COUNT];
+    gyroSensorRate(gyroSensor, gyroSensor->gyroDev.gyroADCRaw, rate);
+    gyroFilterSensor(gyroSensor, rate);
 }
 
-void gyroUpdate(void)
+#ifdef USE_DUAL_GYRO
+#define GYRO_BLEND_NOISE_GAIN           0.002f  // smoothing of the noise estimate, a time constant of 500 samples
+#define GYRO_BLEND_UNCHANGED_SAMPLES    32      // a real gyro never repeats itself exactly for this long
+#define GYRO_BLEND_SATURATED_ADC        32000   // close enough to full scale that the sample may be clipped
+
+// Updates the noise estimate of gyroSensor and returns false if its latest sample should not be trusted
+static bool gyroSensorUpdateHealth(gyroSensor_t *gyroSensor, const float rate[XYZ_AXIS_COUNT])
 {
-    gyroUpdateSensor(&gyroSensor1);
+    float change = 0.0f;
+    bool saturated = false;
+    bool unchanged = true;
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        const float delta = rate[axis] - gyroSensor->previousRate[axis];
+        change += delta * delta;
+        unchanged = unchanged && delta == 0.0f;
+        saturated = saturated || ABS(gyroSensor->gyroDev.gyroADCRaw[axis]) >= GYRO_BLEND_SATURATED_ADC;
+        gyroSensor->previousRate[axis] = rate[axis];
+    }
+    // both gyros see the same motion, so any difference between the estimates comes from their noise
+    gyroSensor->noiseVariance += GYRO_BLEND_NOISE_GAIN * (change - gyroSensor->noiseVariance);
+
+    if (unchanged) {
+        if (gyroSensor->unchangedCount < GYRO_BLEND_UNCHANGED_SAMPLES) {
+            gyroSensor->unchangedCount++;
+        }
+    } else {
+        gyroSensor->unchangedCount = 0;
+    }
+
+    return !saturated && gyroSensor->unchangedCount < GYRO_BLEND_UNCHANGED_SAMPLES;
 }
 
+// Returns the weight of the first gyro, the second gets the remainder
+static float gyroBlendWeight(const float rate1[XYZ_AXIS_COUNT], const float rate2[XYZ_AXIS_COUNT])
+{
+    const bool healthy1 = gyroSensorUpdateHealth(&gyroSensor1, rate1);
+    const bool healthy2 = gyroSensorUpdateHealth(&gyroSensor2, rate2);
+
+    if (healthy1 != healthy2) {
+        return healthy1 ? 1.0f : 0.0f;
+    }
+    // inverse variance weighting gives the least noisy combination for uncorrelated noise
+    const float noiseSum = gyroSensor1.noiseVariance + gyroSensor2.noiseVariance;
+    if (noiseSum <= 0.0f) {
+        return 0.5f;
+    }
+    return gyroSensor2.noiseVariance / noiseSum;
+}
+
+static void gyroUpdateDual(void)
+{
+    // read both before processing either, so the samples are as close together in time as possible
+    const bool read1 = gyroReadSensor(&gyroSensor1);
+    const bool read2 = gyroReadSensor(&gyroSensor2);
+    if (!isGyroCalibrationComplete()) {
+        // the sensor still calibrating has zeroed the output
+        return;
+    }
+
+    float rate1[XYZ_AXIS_COUNT];
+    float rate2[XYZ_AXIS_COUNT];
+    gyroSensorRate(&gyroSensor1, gyroSensor1.gyroDev.gyroADCRaw, rate1);
+    gyroSensorRate(&gyroSensor2, gyroSensor2.gyroDev.gyroADCRaw, rate2);
+
+    float weight1;
+    if (read1 && read2) {
+        weight1 = gyroToUse == GYRO_CONFIG_USE_GYRO_BLEND ? gyroBlendWeight(rate1, rate2) : 0.5f;
+    } else if (read1 || read2) {
+        // carry on with the one that was read
+        weight1 = read1 ? 1.0f : 0.0f;
+    } else {
+        return;
+    }
+#ifdef USE_GYRO_OVERFLOW_CHECK
+    // either gyro clipping clips the fused rate
+    if (gyroOverflowCheckEnabled) {
+        if (read1) {
+            gyroCheckOverflow(gyroSensor1.gyroDev.gyroADCRaw, gyroSensor1.sampleTimeUs);
+        }
+        if (read2) {
+            gyroCheckOverflow(gyroSensor2.gyroDev.gyroADCRaw, gyroSensor2.sampleTimeUs);
+        }
+    }
+#endif
+
+    float rate[XYZ_AXIS_COUNT];
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        rate[axis] = weight1 * rate1[axis] + (1.0f - weight1) * rate2[axis];
+    }
+    DEBUG_SET(DEBUG_DUAL_GYRO, 0, lrintf(weight1 * 1000));
+    DEBUG_SET(DEBUG_DUAL_GYRO, 1, lrintf(rate1[X]));
+    DEBUG_SET(DEBUG_DUAL_GYRO, 2, lrintf(rate2[X]));
+    DEBUG_SET(DEBUG_DUAL_GYRO, 3, lrintf(rate[X]));
+
+    gyroFilterSensor(&gyroSensor1, rate);
+}
+#endif
+
+// Returns the data ready time of the sample the output of gyroUpdate() is based on, 0 if the gyro is polled
+timeUs_t gyroGetSampleTimeUs(void)
+{
+    return gyroSensor1.sampleTimeUs;
+}
+
+FAST_CODE void gyroUpdate(void)
+{
+#ifdef USE_DUAL_GYRO
+    if (gyroUseBoth()) {
+        gyroUpdateDual();
+    } else
+#endif
+    {
+        gyroUpdateSensor(&gyroSensor1);
+    }
+#ifdef USE_GYRO_OVERFLOW_CHECK
+    if (yawSpinRecoveryEnabled) {
+        gyroCheckYawSpin(gyroSensor1.sampleTimeUs);
+    }
+#endif
+}
+
+#ifdef USE_LOOP_BENCHMARK
+static sensorGyroReadFuncPtr gyroSavedReadFn;
+#ifdef USE_DUAL_GYRO
+static sensorGyroReadFuncPtr gyro2SavedReadFn;
+#endif
+#ifdef USE_GYRO_ISR_UPDATE
+static sensorGyroUpdateFuncPtr gyroSavedUpdateFn;
+#endif
+#ifdef USE_GYRO_FIFO
+static bool gyroSavedFifoEnabled;
+#endif
+static int16_t gyroSyntheticSample[XYZ_AXIS_COUNT];
+
+static bool gyroReadSynthetic(gyroDev_t *gyroDev)
+{
+    gyroDev->gyroADCRaw[X] = gyroSyntheticSample[X];
+    gyroDev->gyroADCRaw[Y] = gyroSyntheticSample[Y];
+    gyroDev->gyroADCRaw[Z] = gyroSyntheticSample[Z];
+    return true;
+}
+
+// Detaches the sensor, so that gyroUpdate() runs the filter chain on the samples set by gyroSetSyntheticSample()
+void gyroSyntheticBegin(void)
+{
+#ifdef USE_GYRO_ISR_UPDATE
+    // the data ready interrupt must not run the PID loop on synthetic data
+    gyroSavedUpdateFn = gyroSensor1.gyroDev.updateFn;
+    mpuGyroSetIsrUpdate(&gyroSensor1.gyroDev, NULL);
+#endif
+    gyroSavedReadFn = gyroSensor1.gyroDev.readFn;
+    gyroSensor1.gyroDev.readFn = gyroReadSynthetic;
+#ifdef USE_GYRO_FIFO
+    gyroSavedFifoEnabled = gyroSensor1.gyroDev.fifoEnabled;
+    gyroSensor1.gyroDev.fifoEnabled = false;
+#endif
+#ifdef USE_DUAL_GYRO
+    gyro2SavedReadFn = gyroSensor2.gyroDev.readFn;
+    gyroSensor2.gyroDev.readFn = gyroReadSynthetic;
+#endif
+}
+
+void gyroSetSyntheticSample(const int16_t sample[XYZ_AXIS_COUNT])
+{
+    gyroSyntheticSample[X] = sample[X];
+    gyroSyntheticSample[Y] = sample[Y];
+    gyroSyntheticSample[Z] = sample[Z];
+}
+
+void gyroSyntheticEnd(void)
+{
+#ifdef USE_GYRO_BIAS_TRACKING
+    // drop any window built from the synthetic data
+    gyroBiasResetEstimator();
+#endif
+    gyroSensor1.gyroDev.readFn = gyroSavedReadFn;
+#ifdef USE_GYRO_FIFO
+    // if the FIFO overflowed in the meantime, the next read resets it
+    gyroSensor1.gyroDev.fifoEnabled = gyroSavedFifoEnabled;
+#endif
+#ifdef USE_DUAL_GYRO
+    gyroSensor2.gyroDev.readFn = gyro2SavedReadFn;
+#endif
+#ifdef USE_GYRO_ISR_UPDATE
+    mpuGyroSetIsrUpdate(&gyroSensor1.gyroDev, gyroSavedUpdateFn);
+#endif
+}
+#endif
+
 void gyroReadTemperature(void)
 {
     if (gyroSensor1.gyroDev.temperatureFn) {
@@ -625,3 +1461,84 @@ int16_t gyroRateDps(int axis)
 {
     return lrintf(gyro.gyroADCf[axis] / gyroSensor1.gyroDev.scale);
 }
+
+// Reads the accelerometer in the same SPI transfer as the gyro, returns false if the gyro is not read one sample per transfer
+bool gyroSetAccBurstRead(accDev_t *acc)
+{
+#ifdef USE_DUAL_GYRO
+    if (gyroUseBoth()) {
+        return false;
+    }
+#endif
+#ifdef USE_GYRO_FIFO
+    if (gyroSensor1.gyroDev.fifoEnabled) {
+        return false;
+    }
+#endif
+#ifdef USE_SPI
+    return mpuGyroSetAccBurstRead(&gyroSensor1.gyroDev, acc);
+#else
+    UNUSED(acc);
+    return false;
+#endif
+}
+
+#ifdef USE_GYRO_ISR_UPDATE
+static void (*gyroIsrUpdateFn)(void);
+
+static bool gyroIsrUpdate(gyroDev_t *gyroDev)
+{
+    UNUSED(gyroDev);
+    gyroIsrUpdateFn();
+    return true;
+}
+
+// Sets a function to be called from the gyro data ready interrupt, returns false if the interrupt is not available
+bool gyroSetIsrUpdate(void (*updateFn)(void))
+{
+#ifndef USE_FAKE_GYRO_MODEL
+    if (gyroSensor1.gyroDev.mpuIntExtiTag == IO_TAG_NONE || gyroSensor1.gyroDev.bus.bustype != BUSTYPE_SPI) {
+        return false;
+    }
+#endif
+#ifdef USE_GYRO_FIFO
+    // the data ready interrupt is disabled when the FIFO is read
+    if (gyroSensor1.gyroDev.fifoEnabled) {
+        return false;
+    }
+#endif
+    gyroIsrUpdateFn = updateFn;
+#ifdef USE_FAKE_GYRO_MODEL
+    return fakeGyroSetIsrUpdate(&gyroSensor1.gyroDev, updateFn ? gyroIsrUpdate : NULL);
+#else
+    mpuGyroSetIsrUpdate(&gyroSensor1.gyroDev, updateFn ? gyroIsrUpdate : NULL);
+    return true;
+#endif
+}
+
+// Returns true if any device on the gyro's bus is selected, ie a transfer from task context is in progress
+bool gyroIsBusInUse(void)
+{
+#ifdef USE_FAKE_GYRO_MODEL
+    return false;
+#else
+#ifdef USE_DUAL_GYRO
+    if (gyroUseBoth() && gyroSensor2.gyroDev.bus.bustype == BUSTYPE_SPI && spiBusIsInUse(gyroSensor2.gyroDev.bus.busdev_u.spi.instance)) {
+        return true;
+    }
+#endif
+    return gyroSensor1.gyroDev.bus.bustype == BUSTYPE_SPI && spiBusIsInUse(gyroSensor1.gyroDev.bus.busdev_u.spi.instance);
+#endif
+}
+#else
+bool gyroSetIsrUpdate(void (*updateFn)(void))
+{
+    UNUSED(updateFn);
+    return false;
+}
+
+bool gyroIsBusInUse(void)
+{
+    return false;
+}
+#endif
@@ -18,6 +18,7 @@
 #pragma once
 
 #include "common/axis.h"
+#include "common/time.h"
 #include "config/parameter_group.h"
 #include "drivers/bus.h"
 #include "drivers/sensor.h"
@@ -40,9 +41,18 @@ typedef enum {
     GYRO_FAKE
 } gyroSensor_e;
 
+typedef enum {
+    GYRO_CONFIG_USE_GYRO_1 = 0,
+    GYRO_CONFIG_USE_GYRO_2,
+    GYRO_CONFIG_USE_GYRO_AVERAGE,   // mean of both gyros
+    GYRO_CONFIG_USE_GYRO_BLEND      // both gyros, weighted by how noisy and healthy each is
+} gyroToUse_e;
+
 typedef struct gyro_s {
     uint32_t targetLooptime;
+    float sampleLooptime;                   // period the filters run at, shorter than targetLooptime when the gyro FIFO is read, on the gyro's own clock once measured
     float gyroADCf[XYZ_AXIS_COUNT];
+    float gyroUnfiltered[XYZ_AXIS_COUNT];   // degrees per second before the filter chain, for logging
 } gyro_t;
 
 extern gyro_t gyro;
@@ -54,13 +64,21 @@ typedef struct gyroConfig_s {
     uint8_t  gyro_lpf;                         // gyro LPF setting - values are driver specific, in case of invalid number, a reasonable default ~30-40HZ is chosen.
     uint8_t  gyro_soft_lpf_type;
     uint8_t  gyro_soft_lpf_hz;
-    bool     gyro_isr_update;
+    bool     gyro_isr_update;                  // run gyro update, PID and motor output from the gyro data ready interrupt
     bool     gyro_use_32khz;
-    uint8_t  gyro_to_use;
+    uint8_t  gyro_to_use;                      // see gyroToUse_e, the fused modes need USE_DUAL_GYRO
     uint16_t gyro_soft_notch_hz_1;
     uint16_t gyro_soft_notch_cutoff_1;
     uint16_t gyro_soft_notch_hz_2;
     uint16_t gyro_soft_notch_cutoff_2;
+    uint8_t  dyn_fft_window;                   // see dynFftWindow_e
+    uint8_t  dyn_fft_decimation;               // divides the 1kHz FFT sample rate, for narrower bins
+    uint8_t  dyn_notch_count;                  // 1 tracks the spectrum center, 2 track the two strongest peaks
+    bool     gyro_use_fifo;                    // filter every gyro sample, read from the FIFO once per loop
+    bool     gyro_bias_tracking;               // keep learning the gyro offset while disarmed, and compensate it for temperature
+    bool     gyro_overflow_detect;             // settle the filters when a raw sample nears full scale
+    bool     yaw_spin_recovery;                // drive the rates to zero when the yaw rate exceeds yaw_spin_threshold
+    uint16_t yaw_spin_threshold;               // degrees per second
 } gyroConfig_t;
 
 PG_DECLARE(gyroConfig_t, gyroConfig);
@@ -69,6 +87,9 @@ bool gyroInit(void);
 
 void gyroInitFilters(void);
 void gyroUpdate(void);
+timeUs_t gyroGetSampleTimeUs(void);
+float gyroSampleClockScale(void);
+bool gyroGetDeltaAngle(float deltaAngle[XYZ_AXIS_COUNT], timeUs_t *deltaTimeUs);
 const busDevice_t *gyroSensorBus(void);
 struct mpuConfiguration_s;
 const struct mpuConfiguration_s *gyroMpuConfiguration(void);
@@ -80,3 +101,14 @@ bool isGyroCalibrationComplete(void);
 void gyroReadTemperature(void);
 int16_t gyroGetTemperature(void);
 int16_t gyroRateDps(int axis);
+bool gyroOverflowDetected(void);
+uint16_t gyroGetOverflowCount(void);
+bool gyroYawSpinDetected(void);
+bool gyroSetIsrUpdate(void (*updateFn)(void));
+struct accDev_s;
+bool gyroSetAccBurstRead(struct accDev_s *acc);
+bool gyroIsBusInUse(void);
+bool gyroSupports32kHz(void);
+void gyroSyntheticBegin(void);
+void gyroSetSyntheticSample(const int16_t sample[XYZ_AXIS_COUNT]);
+void gyroSyntheticEnd(void);
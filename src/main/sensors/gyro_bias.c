@@ -0,0 +1,175 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "platform.h"
+
+#ifdef USE_GYRO_BIAS_TRACKING
+
+#include "common/maths.h"
+
+#include "config/parameter_group.h"
+#include "config/parameter_group_ids.h"
+
+#include "sensors/gyro_bias.h"
+
+/*
+ * While the craft is disarmed the raw gyro samples are collected in windows. A window in which no axis
+ * spreads more than the calibration threshold is taken as stationary, and its mean as the gyro offset.
+ * The offsets are kept per temperature, so the offset can be taken from the table at power up instead
+ * of being calibrated, and can follow the temperature in flight.
+ */
+
+#define GYRO_BIAS_BIN_AVERAGE_MAX   16  // once a bin is established, new estimates move it by 1/16th
+
+PG_REGISTER(gyroBiasTable_t, gyroBiasTable, PG_GYRO_BIAS_TABLE, 0);
+
+void gyroBiasEstimatorInit(gyroBiasEstimator_t *estimator, uint16_t windowSamples, uint8_t threshold)
+{
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        estimator->sum[axis] = 0;
+        estimator->sumSquares[axis] = 0;
+    }
+    estimator->count = 0;
+    estimator->windowSamples = MAX(windowSamples, 2);
+    estimator->thresholdSquared = threshold * threshold;
+    estimator->windowReady = false;
+}
+
+// May be called from the gyro interrupt, the completed windows are picked up by gyroBiasEstimatorRead()
+void gyroBiasEstimatorPush(gyroBiasEstimator_t *estimator, const int16_t raw[XYZ_AXIS_COUNT])
+{
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        estimator->sum[axis] += raw[axis];
+        estimator->sumSquares[axis] += (int32_t)raw[axis] * raw[axis];
+    }
+    if (++estimator->count < estimator->windowSamples) {
+        return;
+    }
+
+    // the variance is only worked out once per window, so collecting the samples costs no divisions
+    bool stationary = true;
+    const int32_t n = estimator->count;
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        const int64_t sum = estimator->sum[axis];
+        const int64_t variance = (estimator->sumSquares[axis] - sum * sum / n) / (n - 1);
+        if (variance > estimator->thresholdSquared) {
+            stationary = false;
+        }
+    }
+    if (stationary && !estimator->windowReady) {
+        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            estimator->windowMean[axis] = (float)estimator->sum[axis] / n;
+        }
+        estimator->windowReady = true;
+    }
+
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        estimator->sum[axis] = 0;
+        estimator->sumSquares[axis] = 0;
+    }
+    estimator->count = 0;
+}
+
+// Returns true, and the mean of the window, if a stationary window has completed since the last call
+bool gyroBiasEstimatorRead(gyroBiasEstimator_t *estimator, float mean[XYZ_AXIS_COUNT])
+{
+    if (!estimator->windowReady) {
+        return false;
+    }
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        mean[axis] = estimator->windowMean[axis];
+    }
+    estimator->windowReady = false;
+    return true;
+}
+
+static int gyroBiasTableBin(int16_t temperature)
+{
+    return (temperature - GYRO_BIAS_TEMP_MIN) / GYRO_BIAS_TEMP_BIN_WIDTH;
+}
+
+static float gyroBiasTableBinCenter(int bin)
+{
+    return GYRO_BIAS_TEMP_MIN + GYRO_BIAS_TEMP_BIN_WIDTH * (bin + 0.5f);
+}
+
+void gyroBiasTableUpdate(gyroBiasTable_t *table, int16_t temperature, const float bias[XYZ_AXIS_COUNT])
+{
+    if (temperature < GYRO_BIAS_TEMP_MIN) {
+        return;
+    }
+    const int bin = gyroBiasTableBin(temperature);
+    if (bin >= GYRO_BIAS_TEMP_BIN_COUNT) {
+        return;
+    }
+
+    // a plain average until the bin is established, then a moving one
+    const int n = MIN(table->weight[bin] + 1, GYRO_BIAS_BIN_AVERAGE_MAX);
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        const float binBias = table->bias[bin][axis];
+        const float newBias = binBias + (bias[axis] * GYRO_BIAS_TABLE_SCALE - binBias) / n;
+        table->bias[bin][axis] = constrain(lrintf(newBias), INT16_MIN, INT16_MAX);
+    }
+    if (table->weight[bin] < UINT8_MAX) {
+        table->weight[bin]++;
+    }
+}
+
+/*
+ * Interpolates between the nearest populated bins either side of temperature. With a populated bin on
+ * one side only, it is used if temperature is within a bin width of its center. Returns false otherwise.
+ */
+bool gyroBiasTableLookup(const gyroBiasTable_t *table, int16_t temperature, float bias[XYZ_AXIS_COUNT])
+{
+    int below = -1;
+    int above = -1;
+    for (int bin = 0; bin < GYRO_BIAS_TEMP_BIN_COUNT; bin++) {
+        if (!table->weight[bin]) {
+            continue;
+        }
+        if (gyroBiasTableBinCenter(bin) <= temperature) {
+            below = bin;
+        } else if (above < 0) {
+            above = bin;
+        }
+    }
+
+    if (below >= 0 && above >= 0) {
+        const float centerBelow = gyroBiasTableBinCenter(below);
+        const float fraction = (temperature - centerBelow) / (gyroBiasTableBinCenter(above) - centerBelow);
+        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            const float biasBelow = table->bias[below][axis];
+            bias[axis] = (biasBelow + fraction * (table->bias[above][axis] - biasBelow)) / GYRO_BIAS_TABLE_SCALE;
+        }
+        return true;
+    }
+
+    const int bin = below >= 0 ? below : above;
+    if (bin < 0 || fabsf(temperature - gyroBiasTableBinCenter(bin)) > GYRO_BIAS_TEMP_BIN_WIDTH) {
+        return false;
+    }
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        bias[axis] = (float)table->bias[bin][axis] / GYRO_BIAS_TABLE_SCALE;
+    }
+    return true;
+}
+
+#endif
@@ -0,0 +1,55 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "common/axis.h"
+#include "config/parameter_group.h"
+
+#define GYRO_BIAS_TEMP_BIN_COUNT    8
+#define GYRO_BIAS_TEMP_MIN          10  // degrees C, the lower edge of the first bin
+#define GYRO_BIAS_TEMP_BIN_WIDTH    5   // degrees C
+#define GYRO_BIAS_TABLE_SCALE       16  // the table holds 1/16ths of a raw unit, so the averages in it do not get stuck on rounding
+
+// The gyro offset learnt at each temperature, in 1/GYRO_BIAS_TABLE_SCALE raw units, on the axes of the sensor
+typedef struct gyroBiasTable_s {
+    int16_t bias[GYRO_BIAS_TEMP_BIN_COUNT][XYZ_AXIS_COUNT];
+    uint8_t weight[GYRO_BIAS_TEMP_BIN_COUNT];   // estimates merged into the bin, saturating, 0 if it has none
+} gyroBiasTable_t;
+
+PG_DECLARE(gyroBiasTable_t, gyroBiasTable);
+
+// Mean and spread of the raw gyro samples over a window, the mean is the offset if the craft did not move
+typedef struct gyroBiasEstimator_s {
+    int32_t sum[XYZ_AXIS_COUNT];
+    int64_t sumSquares[XYZ_AXIS_COUNT];
+    uint16_t count;
+    uint16_t windowSamples;
+    uint32_t thresholdSquared;      // variance, in LSB squared, above which the craft is taken to have moved
+    volatile bool windowReady;
+    float windowMean[XYZ_AXIS_COUNT];
+} gyroBiasEstimator_t;
+
+void gyroBiasEstimatorInit(gyroBiasEstimator_t *estimator, uint16_t windowSamples, uint8_t threshold);
+void gyroBiasEstimatorPush(gyroBiasEstimator_t *estimator, const int16_t raw[XYZ_AXIS_COUNT]);
+bool gyroBiasEstimatorRead(gyroBiasEstimator_t *estimator, float mean[XYZ_AXIS_COUNT]);
+
+void gyroBiasTableUpdate(gyroBiasTable_t *table, int16_t temperature, const float bias[XYZ_AXIS_COUNT]);
+bool gyroBiasTableLookup(const gyroBiasTable_t *table, int16_t temperature, float bias[XYZ_AXIS_COUNT]);
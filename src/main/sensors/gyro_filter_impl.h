@@ -0,0 +1,48 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Gyro static notch and LPF filter chain, included by gyro.c once for each variant.
+ *
+ * Before including, define GYRO_FILTER_FUNCTION_NAME and each of GYRO_FILTER_NOTCH1, GYRO_FILTER_NOTCH2
+ * and GYRO_FILTER_LPF as a statement that applies that stage to gyroADCf, or as nothing to leave the stage out.
+ * They are undefined again at the end of this file.
+ */
+
+static FAST_CODE void GYRO_FILTER_FUNCTION_NAME(gyroSensor_t *gyroSensor, float gyroADCf[XYZ_AXIS_COUNT])
+{
+    UNUSED(gyroSensor);
+
+    // Apply Static Notch filtering
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        DEBUG_SET(DEBUG_NOTCH, axis, lrintf(gyroADCf[axis]));
+    }
+    TRACE_BEGIN(TRACE_GYRO_FILTER_NOTCH);
+    GYRO_FILTER_NOTCH1;
+    GYRO_FILTER_NOTCH2;
+    TRACE_END(TRACE_GYRO_FILTER_NOTCH);
+
+    // Apply LPF
+    TRACE_BEGIN(TRACE_GYRO_FILTER_LPF);
+    GYRO_FILTER_LPF;
+    TRACE_END(TRACE_GYRO_FILTER_LPF);
+}
+
+#undef GYRO_FILTER_FUNCTION_NAME
+#undef GYRO_FILTER_NOTCH1
+#undef GYRO_FILTER_NOTCH2
+#undef GYRO_FILTER_LPF
@@ -47,8 +47,8 @@
 // The FFT splits the frequency domain into an number of bins
 // A sampling frequency of 1000 and max frequency of 500 at a window size of 32 gives 16 frequency bins each with a width 31.25Hz
 // Eg [0,31), [31,62), [62, 93) etc
+// Larger windows and decimation give narrower bins, at the cost of a longer delay before a frequency change is seen
 
-#define FFT_WINDOW_SIZE                32  // max for f3 targets
 #define FFT_MIN_FREQ                  100  // not interested in filtering frequencies below 100Hz
 #define FFT_SAMPLING_RATE            1000  // allows analysis up to 500Hz which is more than motors create
 #define FFT_BPF_HZ                    200  // use a bandpass on gyro data to ignore extreme low and extreme high frequencies
@@ -60,16 +60,18 @@
 #define BIQUAD_Q 1.0f / sqrtf(2.0f)         // quality factor - butterworth
 
 static uint16_t samplingFrequency;          // gyro rate
+static uint16_t fftWindowSize;
 static uint8_t fftBinCount;
+static uint8_t dynNotchCount;
 static float fftResolution;                 // hz per bin
-static float gyroData[3][FFT_WINDOW_SIZE];  // gyro data used for frequency analysis
+static float gyroData[3][GYRO_FFT_WINDOW_SIZE_MAX];  // gyro data used for frequency analysis
 
 static arm_rfft_fast_instance_f32 fftInstance;
-static float fftData[FFT_WINDOW_SIZE];
-static float rfftData[FFT_WINDOW_SIZE];
+static float fftData[GYRO_FFT_WINDOW_SIZE_MAX];
+static float rfftData[GYRO_FFT_WINDOW_SIZE_MAX];
 static gyroFftData_t fftResult[3];
 static uint16_t fftMaxFreq = 0;             // nyquist rate
-static uint16_t fftIdx = 0;                 // use a circular buffer for the last FFT_WINDOW_SIZE samples
+static uint16_t fftIdx = 0;                 // use a circular buffer for the last fftWindowSize samples
 
 
 // accumulator for oversampled data => no aliasing and less noise
@@ -81,42 +83,62 @@ static int fftSamplingScale;
 static biquadFilter_t fftGyroFilter[3];
 
 // filter for smoothing frequency estimation
-static biquadFilter_t fftFreqFilter[3];
+static biquadFilter_t fftFreqFilter[GYRO_DYN_NOTCH_COUNT_MAX][3];
 
 // Hanning window, see https://en.wikipedia.org/wiki/Window_function#Hann_.28Hanning.29_window
-static float hanningWindow[FFT_WINDOW_SIZE];
+static float hanningWindow[GYRO_FFT_WINDOW_SIZE_MAX];
+
+// Time of the complex FFT step on an F4 for each window, that step runs the whole FFT in one gyro loop
+static const uint8_t fftStepTimeUs[DYN_FFT_WINDOW_COUNT] = {
+    16, 35,
+#ifndef STM32F3
+    70, 150
+#endif
+};
 
 void initHanning()
 {
-    for (int i = 0; i < FFT_WINDOW_SIZE; i++) {
-        hanningWindow[i] = (0.5 - 0.5 * cosf(2 * M_PIf * i / (FFT_WINDOW_SIZE - 1)));
+    for (int i = 0; i < fftWindowSize; i++) {
+        hanningWindow[i] = (0.5 - 0.5 * cosf(2 * M_PIf * i / (fftWindowSize - 1)));
     }
 }
 
 void initGyroData()
 {
     for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
-        for (int i = 0; i < FFT_WINDOW_SIZE; i++) {
+        for (int i = 0; i < GYRO_FFT_WINDOW_SIZE_MAX; i++) {
             gyroData[axis][i] = 0;
         }
     }
 }
 
-static inline int fftFreqToBin(int freq)
+// The largest window whose complex FFT takes at most half a gyro loop, the smallest window is always allowed
+static int fftWindowLimit(float targetLooptimeUs)
 {
-    return ((FFT_WINDOW_SIZE / 2 - 1) * freq) / (fftMaxFreq);
+    int window = DYN_FFT_WINDOW_32;
+    while (window < DYN_FFT_WINDOW_COUNT - 1 && fftStepTimeUs[window + 1] <= targetLooptimeUs / 2) {
+        window++;
+    }
+    return window;
 }
 
-void gyroDataAnalyseInit(uint32_t targetLooptimeUs)
+void gyroDataAnalyseInit(float targetLooptimeUs)
 {
     // initialise even if FEATURE_DYNAMIC_FILTER not set, since it may be set later
-    samplingFrequency = 1000000 / targetLooptimeUs;
-    fftSamplingScale = samplingFrequency / FFT_SAMPLING_RATE;
-    fftMaxFreq = FFT_SAMPLING_RATE / 2;
-    fftBinCount = fftFreqToBin(fftMaxFreq) + 1;
-    fftResolution = FFT_SAMPLING_RATE / FFT_WINDOW_SIZE;
-    arm_rfft_fast_init_f32(&fftInstance, FFT_WINDOW_SIZE);
-
+    fftWindowSize = GYRO_FFT_WINDOW_SIZE_MIN << MIN(gyroConfig()->dyn_fft_window, fftWindowLimit(targetLooptimeUs));
+    dynNotchCount = constrain(gyroConfig()->dyn_notch_count, 1, GYRO_DYN_NOTCH_COUNT_MAX);
+    const int decimation = MAX(gyroConfig()->dyn_fft_decimation, 1);
+    const int fftSamplingRate = FFT_SAMPLING_RATE / decimation;
+
+    samplingFrequency = lrintf(1000000 / targetLooptimeUs);
+    fftSamplingScale = MAX(samplingFrequency / fftSamplingRate, 1);
+    fftMaxFreq = fftSamplingRate / 2;
+    fftBinCount = fftWindowSize / 2;
+    fftResolution = (float)fftSamplingRate / fftWindowSize;
+    arm_rfft_fast_init_f32(&fftInstance, fftWindowSize);
+
+    fftIdx = 0;
+    fftAccCount = 0;
     initGyroData();
     initHanning();
 
@@ -124,9 +146,12 @@ void gyroDataAnalyseInit(uint32_t targetLooptimeUs)
     // at 4khz gyro loop rate this means 4khz / 4 / 3 = 333Hz => update every 3ms
     float looptime = targetLooptimeUs * 4 * 3;
     for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
-        fftResult[axis].centerFreq = 200; // any init value
-        biquadFilterInitLPF(&fftFreqFilter[axis], DYN_NOTCH_CHANGERATE, looptime);
-        biquadFilterInit(&fftGyroFilter[axis], FFT_BPF_HZ, 1000000 / FFT_SAMPLING_RATE, BIQUAD_Q, FILTER_BPF);
+        for (int i = 0; i < GYRO_DYN_NOTCH_COUNT_MAX; i++) {
+            fftResult[axis].centerFreq[i] = 200 + 100 * i; // any init value
+            biquadFilterInitLPF(&fftFreqFilter[i][axis], DYN_NOTCH_CHANGERATE, looptime);
+        }
+        // keep the bandpass below nyquist when decimating
+        biquadFilterInit(&fftGyroFilter[axis], MIN(FFT_BPF_HZ, fftMaxFreq / 2), 1000000 / fftSamplingRate, BIQUAD_Q, FILTER_BPF);
     }
 }
 
@@ -144,7 +169,7 @@ bool isDynamicFilterActive(void)
 /*
  * Collect gyro data, to be analysed in gyroDataAnalyseUpdate function
  */
-void gyroDataAnalyse(const gyroDev_t *gyroDev, biquadFilter_t *notchFilterDyn)
+void gyroDataAnalyse(const float rate[XYZ_AXIS_COUNT], biquadFilterXyz_t *notchFilterDyn)
 {
     if (!isDynamicFilterActive()) {
         return;
@@ -152,11 +177,11 @@ void gyroDataAnalyse(const gyroDev_t *gyroDev, biquadFilter_t *notchFilterDyn)
 
     // if gyro sampling is > 1kHz, accumulate multiple samples
     for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
-        fftAcc[axis] += gyroDev->gyroADC[axis];
+        fftAcc[axis] += rate[axis];
     }
     fftAccCount++;
 
-    // this runs at 1kHz
+    // this runs at 1kHz, divided by the decimation
     if (fftAccCount == fftSamplingScale) {
         fftAccCount = 0;
 
@@ -166,17 +191,110 @@ void gyroDataAnalyse(const gyroDev_t *gyroDev, biquadFilter_t *notchFilterDyn)
             sample = biquadFilterApply(&fftGyroFilter[axis], sample);
             gyroData[axis][fftIdx] = sample;
             if (axis == 0)
-                DEBUG_SET(DEBUG_FFT, 2, lrintf(sample * gyroDev->scale));
+                DEBUG_SET(DEBUG_FFT, 2, lrintf(sample));
             fftAcc[axis] = 0;
         }
 
-        fftIdx = (fftIdx + 1) % FFT_WINDOW_SIZE;
+        fftIdx = (fftIdx + 1) % fftWindowSize;
     }
 
     // calculate FFT and update filters
     gyroDataAnalyseUpdate(notchFilterDyn);
 }
 
+// weighted center of the bins either side of a peak, for a better resolution than the bin width
+static float fftPeakIndex(int peakBin)
+{
+    float sum = 0;
+    float weightedSum = 0;
+    for (int i = peakBin - 1; i <= peakBin + 1; i++) {
+        const float squaredData = fftData[i] * fftData[i];
+        sum += squaredData;
+        weightedSum += squaredData * i;
+    }
+    return sum > 0 ? weightedSum / sum : peakBin;
+}
+
+static uint16_t fftSmoothFrequency(int notch, int axis, float centerFreq)
+{
+    // don't go below the minimal cutoff frequency + 10 and don't jump around too much
+    centerFreq = constrain(centerFreq, DYN_NOTCH_MIN_CUTOFF + 10, fftMaxFreq);
+    centerFreq = biquadFilterApply(&fftFreqFilter[notch][axis], centerFreq);
+    return constrain(centerFreq, DYN_NOTCH_MIN_CUTOFF + 10, fftMaxFreq);
+}
+
+// single notch, on the weighted center of the whole spectrum
+static void fftCalcCenterFrequency(int axis)
+{
+    float fftSum = 0;
+    float fftWeightedSum = 0;
+
+    // iterate over fft data and calculate weighted indexes
+    float squaredData;
+    for (int i = 0; i < fftBinCount; i++) {
+        squaredData = fftData[i] * fftData[i];  //more weight on higher peaks
+        fftResult[axis].maxVal = MAX(fftResult[axis].maxVal, squaredData);
+        fftSum += squaredData;
+        fftWeightedSum += squaredData * (i + 1); // calculate weighted index starting at 1, not 0
+    }
+
+    // get weighted center of relevant frequency range (this way we have a better resolution than the bin width)
+    if (fftSum > 0) {
+        // idx was shifted by 1 to start at 1, not 0
+        float fftMeanIndex = (fftWeightedSum / fftSum) - 1;
+        // the index points at the center frequency of each bin so index 0 is actually 16.125Hz
+        // fftMeanIndex += 0.5;
+
+        fftResult[axis].centerFreq[0] = fftSmoothFrequency(0, axis, fftMeanIndex * fftResolution);
+        if (axis == 0) {
+            DEBUG_SET(DEBUG_FFT, 3, lrintf(fftMeanIndex * 100));
+        }
+    }
+}
+
+// two notches, on the two strongest peaks above FFT_MIN_FREQ, usually the first two motor harmonics
+static void fftCalcPeakFrequencies(int axis)
+{
+    int peakBin[GYRO_DYN_NOTCH_COUNT_MAX] = { 0, 0 };
+    float peakVal[GYRO_DYN_NOTCH_COUNT_MAX] = { 0, 0 };
+
+    const int minBin = MAX(lrintf(FFT_MIN_FREQ / fftResolution), 1);
+    for (int i = minBin; i < fftBinCount - 1; i++) {
+        const float squaredData = fftData[i] * fftData[i];
+        fftResult[axis].maxVal = MAX(fftResult[axis].maxVal, squaredData);
+        if (fftData[i] > fftData[i - 1] && fftData[i] >= fftData[i + 1]) {
+            if (squaredData > peakVal[0]) {
+                peakVal[1] = peakVal[0];
+                peakBin[1] = peakBin[0];
+                peakVal[0] = squaredData;
+                peakBin[0] = i;
+            } else if (squaredData > peakVal[1]) {
+                peakVal[1] = squaredData;
+                peakBin[1] = i;
+            }
+        }
+    }
+
+    if (!peakBin[0]) {
+        return;
+    }
+    if (!peakBin[1]) {
+        // only one peak, the notch that is closest to it follows it and the other stays where it is
+        const float freq = fftPeakIndex(peakBin[0]) * fftResolution;
+        const int notch = ABS(freq - fftResult[axis].centerFreq[0]) <= ABS(freq - fftResult[axis].centerFreq[1]) ? 0 : 1;
+        fftResult[axis].centerFreq[notch] = fftSmoothFrequency(notch, axis, freq);
+        return;
+    }
+
+    // the lower frequency peak always drives the first notch, so the notches don't swap over
+    const int lower = peakBin[0] < peakBin[1] ? 0 : 1;
+    fftResult[axis].centerFreq[0] = fftSmoothFrequency(0, axis, fftPeakIndex(peakBin[lower]) * fftResolution);
+    fftResult[axis].centerFreq[1] = fftSmoothFrequency(1, axis, fftPeakIndex(peakBin[1 - lower]) * fftResolution);
+    if (axis == 0) {
+        DEBUG_SET(DEBUG_FFT, 3, lrintf(fftPeakIndex(peakBin[lower]) * 100));
+    }
+}
+
 void stage_rfft_f32(arm_rfft_fast_instance_f32 * S, float32_t * p, float32_t * pOut);
 void arm_cfft_radix8by2_f32( arm_cfft_instance_f32 * S, float32_t * p1);
 void arm_cfft_radix8by4_f32( arm_cfft_instance_f32 * S, float32_t * p1);
@@ -195,25 +313,29 @@ typedef enum {
 } UpdateStep_e;
 
 /*
- * Analyse last gyro data from the last FFT_WINDOW_SIZE milliseconds
+ * Analyse the last fftWindowSize gyro samples. The work is split into steps, one per call, so that each
+ * gyro loop only pays for a part of it.
  */
-void gyroDataAnalyseUpdate(biquadFilter_t *notchFilterDyn)
+void gyroDataAnalyseUpdate(biquadFilterXyz_t *notchFilterDyn)
 {
     static int axis = 0;
     static int step = 0;
     arm_cfft_instance_f32 * Sint = &(fftInstance.Sint);
 
     uint32_t startTime = 0;
-    if (debugMode == (DEBUG_FFT_TIME))
+    if (DEBUG_MODE_IS_ACTIVE(DEBUG_FFT_TIME))
         startTime = micros();
 
     DEBUG_SET(DEBUG_FFT_TIME, 0, step);
     switch (step) {
         case STEP_ARM_CFFT_F32:
         {
-            switch (FFT_WINDOW_SIZE / 2) {
+            // same dispatch as arm_cfft_f32(), the complex FFT is half the window size
+            // the whole FFT runs in this step, fftWindowLimit() keeps it within half a gyro loop
+            switch (Sint->fftLen) {
             case 16:
-                // 16us
+            case 128:
+                // 16us for 16, 150us for 128
                 arm_cfft_radix8by2_f32(Sint, fftData);
                 break;
             case 32:
@@ -222,7 +344,7 @@ void gyroDataAnalyseUpdate(biquadFilter_t *notchFilterDyn)
                 break;
             case 64:
                 // 70us
-                arm_radix8_butterfly_f32(fftData, FFT_WINDOW_SIZE / 2, Sint->pTwiddle, 1);
+                arm_radix8_butterfly_f32(fftData, Sint->fftLen, Sint->pTwiddle, 1);
                 break;
             }
             DEBUG_SET(DEBUG_FFT_TIME, 1, micros() - startTime);
@@ -254,49 +376,27 @@ void gyroDataAnalyseUpdate(biquadFilter_t *notchFilterDyn)
         }
         case STEP_CALC_FREQUENCIES:
         {
-            // 13us
-            float fftSum = 0;
-            float fftWeightedSum = 0;
-
+            // 13us for a window of 32
             fftResult[axis].maxVal = 0;
-            // iterate over fft data and calculate weighted indexes
-            float squaredData;
-            for (int i = 0; i < fftBinCount; i++) {
-                squaredData = fftData[i] * fftData[i];  //more weight on higher peaks
-                fftResult[axis].maxVal = MAX(fftResult[axis].maxVal, squaredData);
-                fftSum += squaredData;
-                fftWeightedSum += squaredData * (i + 1); // calculate weighted index starting at 1, not 0
-            }
-
-            // get weighted center of relevant frequency range (this way we have a better resolution than 31.25Hz)
-            if (fftSum > 0) {
-                // idx was shifted by 1 to start at 1, not 0
-                float fftMeanIndex = (fftWeightedSum / fftSum) - 1;
-                // the index points at the center frequency of each bin so index 0 is actually 16.125Hz
-                // fftMeanIndex += 0.5;
-
-                // don't go below the minimal cutoff frequency + 10 and don't jump around too much
-                float centerFreq;
-                centerFreq = constrain(fftMeanIndex * fftResolution, DYN_NOTCH_MIN_CUTOFF + 10, fftMaxFreq);
-                centerFreq = biquadFilterApply(&fftFreqFilter[axis], centerFreq);
-                centerFreq = constrain(centerFreq, DYN_NOTCH_MIN_CUTOFF + 10, fftMaxFreq);
-                fftResult[axis].centerFreq = centerFreq;
-                if (axis == 0) {
-                    DEBUG_SET(DEBUG_FFT, 3, lrintf(fftMeanIndex * 100));
-                }
+            if (dynNotchCount == 1) {
+                fftCalcCenterFrequency(axis);
+            } else {
+                fftCalcPeakFrequencies(axis);
             }
 
-            DEBUG_SET(DEBUG_FFT_FREQ, axis, fftResult[axis].centerFreq);
+            DEBUG_SET(DEBUG_FFT_FREQ, axis, fftResult[axis].centerFreq[0]);
             DEBUG_SET(DEBUG_FFT_TIME, 1, micros() - startTime);
             break;
         }
         case STEP_UPDATE_FILTERS:
         {
-            // 7us
             // calculate new filter coefficients
-            float cutoffFreq = constrain(fftResult[axis].centerFreq - DYN_NOTCH_WIDTH, DYN_NOTCH_MIN_CUTOFF, DYN_NOTCH_MAX_CUTOFF);
-            float notchQ = filterGetNotchQApprox(fftResult[axis].centerFreq, cutoffFreq);
-            biquadFilterUpdate(&notchFilterDyn[axis], fftResult[axis].centerFreq, gyro.targetLooptime, notchQ, FILTER_NOTCH);
+            for (int i = 0; i < dynNotchCount; i++) {
+                const uint16_t centerFreq = fftResult[axis].centerFreq[i];
+                float cutoffFreq = constrain(centerFreq - DYN_NOTCH_WIDTH, DYN_NOTCH_MIN_CUTOFF, DYN_NOTCH_MAX_CUTOFF);
+                float notchQ = filterGetNotchQApprox(centerFreq, cutoffFreq);
+                biquadFilterXyzUpdateNotchAxis(&notchFilterDyn[i], axis, centerFreq, gyro.sampleLooptime, notchQ);
+            }
             DEBUG_SET(DEBUG_FFT_TIME, 1, micros() - startTime);
 
             axis = (axis + 1) % 3;
@@ -308,7 +408,7 @@ void gyroDataAnalyseUpdate(biquadFilter_t *notchFilterDyn)
             // 5us
             // apply hanning window to gyro samples and store result in fftData
             // hanning starts and ends with 0, could be skipped for minor speed improvement
-            uint8_t ringBufIdx = FFT_WINDOW_SIZE - fftIdx;
+            uint16_t ringBufIdx = fftWindowSize - fftIdx;
             arm_mult_f32(&gyroData[axis][fftIdx], &hanningWindow[0], &fftData[0], ringBufIdx);
             if (fftIdx > 0)
                 arm_mult_f32(&gyroData[axis][0], &hanningWindow[ringBufIdx], &fftData[ringBufIdx], fftIdx);
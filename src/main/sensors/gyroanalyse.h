@@ -17,18 +17,33 @@
 
 #pragma once
 
+#include "common/axis.h"
 #include "common/time.h"
 #include "common/filter.h"
 
-#define GYRO_FFT_BIN_COUNT      16 // FFT_WINDOW_SIZE / 2
+// the FFT window is configurable in powers of 2, up to what the RAM allows
+typedef enum {
+    DYN_FFT_WINDOW_32 = 0,
+    DYN_FFT_WINDOW_64,
+#ifndef STM32F3
+    DYN_FFT_WINDOW_128,
+    DYN_FFT_WINDOW_256,
+#endif
+    DYN_FFT_WINDOW_COUNT
+} dynFftWindow_e;
+
+#define GYRO_FFT_WINDOW_SIZE_MIN    32
+#define GYRO_FFT_WINDOW_SIZE_MAX    (GYRO_FFT_WINDOW_SIZE_MIN << (DYN_FFT_WINDOW_COUNT - 1))
+#define GYRO_DYN_NOTCH_COUNT_MAX    2
+
 typedef struct gyroFftData_s {
     float maxVal;
-    uint16_t centerFreq;
+    uint16_t centerFreq[GYRO_DYN_NOTCH_COUNT_MAX];
 } gyroFftData_t;
 
-void gyroDataAnalyseInit(uint32_t targetLooptime);
+void gyroDataAnalyseInit(float targetLooptimeUs);
 const gyroFftData_t *gyroFftData(int axis);
-struct gyroDev_s;
-void gyroDataAnalyse(const struct gyroDev_s *gyroDev, biquadFilter_t *notchFilterDyn);
-void gyroDataAnalyseUpdate(biquadFilter_t *notchFilterDyn);
+// notchFilterDyn is an array of the dyn_notch_count dynamic notches
+void gyroDataAnalyse(const float rate[XYZ_AXIS_COUNT], biquadFilterXyz_t *notchFilterDyn);
+void gyroDataAnalyseUpdate(biquadFilterXyz_t *notchFilterDyn);
 bool isDynamicFilterActive();
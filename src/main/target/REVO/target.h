@@ -136,6 +136,13 @@
 #define MPU_INT_EXTI            PC4
 #define USE_MPU_DATA_READY_SIGNAL
 
+#if defined(REVO)
+// The gyro has SPI1 to itself, so the data ready interrupt reads it by DMA. DMA2 streams 0 and 3 are not used otherwise.
+#define GYRO_DMA_STREAM_TX      DMA2_Stream3
+#define GYRO_DMA_STREAM_RX      DMA2_Stream0
+#define GYRO_DMA_CHANNEL        DMA_Channel_3
+#endif
+
 #if defined(AIRBOTF4) || defined(AIRBOTF4SD)
 #define MAG
 #define USE_MAG_HMC5883
@@ -171,6 +178,11 @@
 #define USE_FLASHFS
 #define USE_FLASH_M25P16
 
+#define M25P16_DMA_CHANNEL_TX               DMA1_Stream5
+#define M25P16_DMA_CHANNEL_TX_COMPLETE_FLAG DMA_FLAG_TCIF5
+#define M25P16_DMA_CLK                      RCC_AHB1Periph_DMA1
+#define M25P16_DMA_CHANNEL                  DMA_Channel_0
+
 #endif // AIRBOTF4SD
 
 
@@ -0,0 +1,408 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "platform.h"
+
+#ifdef SIMULATOR_LOCKSTEP
+
+#include "common/axis.h"
+#include "common/maths.h"
+#include "common/utils.h"
+
+#include "drivers/accgyro/accgyro_fake.h"
+
+#include "fc/fc_core.h"
+#include "fc/fc_rc.h"
+#include "fc/rc_controls.h"
+#include "fc/runtime_config.h"
+
+#include "flight/mixer.h"
+#include "flight/pid.h"
+
+#include "rx/msp.h"
+#include "rx/rx.h"
+
+#include "sensors/gyro.h"
+#include "sensors/voltage.h"
+
+#include "target/SITL/replay.h"
+
+/*
+ * Reads the CSV that blackbox_decode makes of a log and feeds each frame to the fake gyro, the fake acc,
+ * the MSP RX and the battery ADC at its logged time. The flight code runs as it would on the craft, and
+ * the P, I and D sums and the motor outputs it works out for each frame are compared with those logged.
+ *
+ * The log has the filtered gyro in gyroADC, which is filtered again here. For an exact replay, log with
+ * debug_mode = GYRO and set SITL_REPLAY_GYRO=debug, that has the gyro before the filters. RX channels are
+ * worked back from rcCommand, which is after the deadband, the throttle curve and the RC smoothing, so the
+ * setpoints only come close. Flight modes are not logged in the main frames and stay as the config has them.
+ */
+
+#define REPLAY_LINE_LENGTH      4096
+#define REPLAY_MAX_COLUMNS      160
+#define REPLAY_MAX_FIELDS       (3 * XYZ_AXIS_COUNT + MAX_SUPPORTED_MOTORS)
+#define REPLAY_ARM_STEPS        100000  // gyro periods allowed for calibration and arming
+#define REPLAY_GYRO_SCALE       16.4f   // LSB per deg/s of the fake gyro
+#define REPLAY_RX_CHANNELS      8
+
+typedef enum {
+    REPLAY_OFF = 0,
+    REPLAY_ARMING,
+    REPLAY_RUNNING,
+} replayState_e;
+
+typedef struct replayField_s {
+    char name[16];
+    int column;
+    const float *firmware;
+    double sumSquares;
+    double maxError;
+    uint32_t count;
+} replayField_t;
+
+static replayState_e replayState = REPLAY_OFF;
+static FILE *replayFile;
+static FILE *replayOutFile;
+static double replayTolerance = -1;
+static char replayLine[REPLAY_LINE_LENGTH];
+
+static double row[REPLAY_MAX_COLUMNS];
+static double nextRow[REPLAY_MAX_COLUMNS];
+static bool haveNextRow;
+static bool rowPending;             // a frame was applied and its outputs are still to be compared
+static bool disarmedEarly;
+
+static int timeColumn = -1;
+static int gyroColumn[XYZ_AXIS_COUNT] = { -1, -1, -1 };
+static int accColumn[XYZ_AXIS_COUNT] = { -1, -1, -1 };
+static int rcCommandColumn[4] = { -1, -1, -1, -1 };
+static int vbatColumn = -1;
+static double vbatScale = 1;        // to 0.1V
+
+static replayField_t fields[REPLAY_MAX_FIELDS];
+static int fieldCount;
+
+static uint64_t logStartUs;
+static uint64_t replayStartUs;
+static uint32_t armSteps;
+static uint32_t framesReplayed;
+static uint16_t vbatDeciVolts;
+
+static int splitLine(char *line, char **tokens, int maxTokens) {
+    int count = 0;
+    char *save;
+    for (char *token = strtok_r(line, ",\r\n", &save); token && count < maxTokens; token = strtok_r(NULL, ",\r\n", &save)) {
+        while (*token == ' ') {
+            token++;
+        }
+        tokens[count++] = token;
+    }
+    return count;
+}
+
+static bool readRow(double *values) {
+    if (!fgets(replayLine, sizeof(replayLine), replayFile)) {
+        return false;
+    }
+    char *tokens[REPLAY_MAX_COLUMNS];
+    const int count = splitLine(replayLine, tokens, REPLAY_MAX_COLUMNS);
+    for (int i = 0; i < REPLAY_MAX_COLUMNS; i++) {
+        values[i] = i < count ? strtod(tokens[i], NULL) : 0;
+    }
+    return count > 0;
+}
+
+static int findColumn(char **tokens, int count, const char *name) {
+    for (int i = 0; i < count; i++) {
+        if (strcmp(tokens[i], name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int findIndexedColumn(char **tokens, int count, const char *prefix, int index) {
+    char name[32];
+    snprintf(name, sizeof(name), "%s[%d]", prefix, index);
+    return findColumn(tokens, count, name);
+}
+
+static void addField(char **tokens, int count, const char *prefix, int index, const float *firmware) {
+    replayField_t *field = &fields[fieldCount];
+    snprintf(field->name, sizeof(field->name), "%s[%d]", prefix, index);
+    field->column = findColumn(tokens, count, field->name);
+    if (field->column >= 0) {
+        field->firmware = firmware;
+        fieldCount++;
+    }
+}
+
+static bool readHeader(const char *gyroField) {
+    if (!fgets(replayLine, sizeof(replayLine), replayFile)) {
+        return false;
+    }
+    char *tokens[REPLAY_MAX_COLUMNS];
+    const int count = splitLine(replayLine, tokens, REPLAY_MAX_COLUMNS);
+
+    timeColumn = findColumn(tokens, count, "time (us)");
+    if (timeColumn < 0) {
+        timeColumn = findColumn(tokens, count, "time");
+    }
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        gyroColumn[axis] = findIndexedColumn(tokens, count, gyroField, axis);
+        accColumn[axis] = findIndexedColumn(tokens, count, "accSmooth", axis);
+    }
+    for (int i = 0; i < 4; i++) {
+        rcCommandColumn[i] = findIndexedColumn(tokens, count, "rcCommand", i);
+    }
+    vbatColumn = findColumn(tokens, count, "vbatLatest (V)");
+    vbatScale = 10;
+    if (vbatColumn < 0) {
+        vbatColumn = findColumn(tokens, count, "vbatLatest");
+        vbatScale = 1;
+    }
+
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        addField(tokens, count, "axisP", axis, &axisPID_P[axis]);
+        addField(tokens, count, "axisI", axis, &axisPID_I[axis]);
+        addField(tokens, count, "axisD", axis, &axisPID_D[axis]);
+    }
+    for (int i = 0; i < MAX_SUPPORTED_MOTORS; i++) {
+        addField(tokens, count, "motor", i, &motor[i]);
+    }
+
+    return timeColumn >= 0 && gyroColumn[X] >= 0 && gyroColumn[Y] >= 0 && gyroColumn[Z] >= 0;
+}
+
+// Options come from the environment, like SITL_INSTANCE, so many replays can be started from one script
+bool replayInit(void) {
+    const char *path = getenv("SITL_REPLAY");
+    if (!path) {
+        return false;
+    }
+
+    const char *gyroField = getenv("SITL_REPLAY_GYRO");
+    if (!gyroField) {
+        gyroField = "gyroADC";
+    }
+    const char *tolerance = getenv("SITL_REPLAY_TOLERANCE");
+    if (tolerance) {
+        replayTolerance = atof(tolerance);
+    }
+
+    replayFile = fopen(path, "r");
+    if (!replayFile) {
+        printf("[replay]can not open %s\n", path);
+        exit(2);
+    }
+    if (!readHeader(gyroField)) {
+        printf("[replay]%s has no time or %s columns\n", path, gyroField);
+        exit(2);
+    }
+    haveNextRow = readRow(nextRow);
+    if (!haveNextRow) {
+        printf("[replay]%s has no frames\n", path);
+        exit(2);
+    }
+    logStartUs = nextRow[timeColumn];
+    memcpy(row, nextRow, sizeof(row));
+
+    const char *outPath = getenv("SITL_REPLAY_OUT");
+    if (outPath) {
+        replayOutFile = fopen(outPath, "w");
+        if (!replayOutFile) {
+            printf("[replay]can not write %s\n", outPath);
+            exit(2);
+        }
+        fprintf(replayOutFile, "time (us)");
+        for (int i = 0; i < fieldCount; i++) {
+            fprintf(replayOutFile, ",%s", fields[i].name);
+        }
+        fprintf(replayOutFile, "\n");
+    }
+
+    printf("[replay]%s, gyro from %s, comparing %d outputs\n", path, gyroField, fieldCount);
+    replayState = REPLAY_ARMING;
+    return true;
+}
+
+bool replayIsActive(void) {
+    return replayState != REPLAY_OFF;
+}
+
+static int16_t columnValue(int column, double scale) {
+    return column < 0 ? 0 : constrainf(lrint(row[column] * scale), INT16_MIN, INT16_MAX);
+}
+
+// inverse of the stick handling in updateRcCommands(), exact apart from inside the deadband
+static uint16_t stickChannel(int axis, double command) {
+    const int deadband = axis == YAW ? rcControlsConfig()->yaw_deadband : rcControlsConfig()->deadband;
+    if (axis == YAW && !rcControlsConfig()->yaw_control_reversed) {
+        command = -command;
+    }
+    const int offset = command == 0 ? 0 : lrint(command) + (command > 0 ? deadband : -deadband);
+    return rxConfig()->midrc + constrain(offset, -500, 500);
+}
+
+static uint16_t throttleChannel(double command) {
+    // rcLookupThrottle() only ever rises, so the least input reaching the logged command is taken
+    int low = 0;
+    int high = PWM_RANGE_MIN;
+    while (low < high) {
+        const int mid = (low + high) / 2;
+        if (rcLookupThrottle(mid) < command) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return rxConfig()->mincheck + low * (PWM_RANGE_MAX - rxConfig()->mincheck) / PWM_RANGE_MIN;
+}
+
+static void sendRx(bool sticksFromLog) {
+    uint16_t frame[REPLAY_RX_CHANNELS];
+    for (int i = 0; i < REPLAY_RX_CHANNELS; i++) {
+        frame[i] = PWM_RANGE_MIN;
+    }
+    for (int axis = ROLL; axis <= YAW; axis++) {
+        const bool logged = sticksFromLog && rcCommandColumn[axis] >= 0;
+        frame[rxConfig()->rcmap[axis]] = logged ? stickChannel(axis, row[rcCommandColumn[axis]]) : rxConfig()->midrc;
+    }
+    const bool logged = sticksFromLog && rcCommandColumn[THROTTLE] >= 0;
+    frame[rxConfig()->rcmap[THROTTLE]] = logged ? throttleChannel(row[rcCommandColumn[THROTTLE]]) : PWM_RANGE_MIN;
+    rxMspFrameReceive(frame, REPLAY_RX_CHANNELS);
+}
+
+static void applyRow(bool fromLog) {
+    if (fromLog) {
+        fakeGyroSet(fakeGyroDev, columnValue(gyroColumn[X], REPLAY_GYRO_SCALE), columnValue(gyroColumn[Y], REPLAY_GYRO_SCALE), columnValue(gyroColumn[Z], REPLAY_GYRO_SCALE));
+    } else {
+        fakeGyroSet(fakeGyroDev, 0, 0, 0); // still, so the calibration finds no offset
+    }
+    fakeAccSet(fakeAccDev, columnValue(accColumn[X], 1), columnValue(accColumn[Y], 1), columnValue(accColumn[Z], 1));
+    if (vbatColumn >= 0) {
+        vbatDeciVolts = lrint(row[vbatColumn] * vbatScale);
+    }
+    sendRx(fromLog);
+}
+
+// Sets the inputs for the coming gyro period, false once the log is done
+bool replayStep(void) {
+    if (replayState == REPLAY_ARMING) {
+        applyRow(false);
+        if (isGyroCalibrationComplete()) {
+            tryArm();
+        }
+        if (ARMING_FLAG(ARMED)) {
+            replayState = REPLAY_RUNNING;
+            replayStartUs = micros64();
+            printf("[replay]armed after %u steps\n", armSteps);
+        } else if (++armSteps > REPLAY_ARM_STEPS) {
+            printf("[replay]could not arm, arming disable flags 0x%x\n", getArmingDisableFlags());
+            exit(2);
+        }
+        return true;
+    }
+
+    // the frame logged at or before the end of this step is the one the flight code now sees
+    const uint64_t stepEndUs = micros64() + gyro.targetLooptime - replayStartUs;
+    bool newRow = false;
+    while (haveNextRow && (uint64_t)(nextRow[timeColumn] - logStartUs) <= stepEndUs) {
+        memcpy(row, nextRow, sizeof(row));
+        haveNextRow = readRow(nextRow);
+        newRow = true;
+    }
+    if (!newRow && !haveNextRow) {
+        return false;
+    }
+    if (newRow) {
+        applyRow(true);
+        rowPending = true;
+    }
+    return true;
+}
+
+// Compares the outputs of the step with those logged for the frame
+void replayCheck(void) {
+    if (!rowPending) {
+        return;
+    }
+    rowPending = false;
+    framesReplayed++;
+
+    if (!ARMING_FLAG(ARMED) && !disarmedEarly) {
+        disarmedEarly = true;
+        printf("[replay]disarmed by the flight code at %.0fus into the log\n", row[timeColumn] - logStartUs);
+    }
+
+    if (replayOutFile) {
+        fprintf(replayOutFile, "%.0f", row[timeColumn]);
+    }
+    for (int i = 0; i < fieldCount; i++) {
+        replayField_t *field = &fields[i];
+        const double error = (double)*field->firmware - row[field->column];
+        field->sumSquares += error * error;
+        field->maxError = MAX(field->maxError, fabs(error));
+        field->count++;
+        if (replayOutFile) {
+            fprintf(replayOutFile, ",%.3f", (double)*field->firmware);
+        }
+    }
+    if (replayOutFile) {
+        fprintf(replayOutFile, "\n");
+    }
+}
+
+// Prints the error of each output, the exit status is 1 if any rms error is above SITL_REPLAY_TOLERANCE
+int replayFinish(void) {
+    int status = 0;
+    printf("[replay]%u frames\n", framesReplayed);
+    printf("%-12s %12s %12s\n", "output", "rms error", "max error");
+    for (int i = 0; i < fieldCount; i++) {
+        const replayField_t *field = &fields[i];
+        const double rms = field->count ? sqrt(field->sumSquares / field->count) : 0;
+        const bool failed = replayTolerance >= 0 && rms > replayTolerance;
+        printf("%-12s %12.3f %12.3f%s\n", field->name, rms, field->maxError, failed ? "  FAIL" : "");
+        if (failed) {
+            status = 1;
+        }
+    }
+
+    fclose(replayFile);
+    if (replayOutFile) {
+        fclose(replayOutFile);
+    }
+    return status;
+}
+
+// inverse of voltageAdcToVoltage()
+uint16_t replayBatteryAdc(void) {
+    const voltageSensorADCConfig_t *config = voltageSensorADCConfig(VOLTAGE_SENSOR_ADC_VBAT);
+    if (!config->vbatscale) {
+        return 0;
+    }
+    return MIN((uint32_t)vbatDeciVolts * config->vbatresdivmultiplier * config->vbatresdivval * 0xFFF / (config->vbatscale * 33), 0xFFF);
+}
+
+#endif
@@ -0,0 +1,111 @@
+/**
+ * Copyright (c) 2017 cs8425
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license.
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#include "shmlink.h"
+
+// polls before the consumer sleeps, a packet from a fast simulator is usually only a few microseconds away
+#define SHM_SPIN_COUNT 2000
+
+static int futexWait(volatile uint32_t* addr, uint32_t val, const struct timespec* timeout) {
+    return syscall(SYS_futex, addr, FUTEX_WAIT, val, timeout, NULL, 0);
+}
+
+static int futexWake(volatile uint32_t* addr) {
+    return syscall(SYS_futex, addr, FUTEX_WAKE, 1, NULL, NULL, 0);
+}
+
+// either end may come up first, so both create the object if it is not there yet
+int shmInit(shmLink_t* link, const char* name) {
+    link->name = name;
+    link->ring = NULL;
+
+    int fd = shm_open(name, O_RDWR | O_CREAT, 0600);
+    if (fd == -1) {
+        return -2;
+    }
+    if (ftruncate(fd, sizeof(shmRing_t)) == -1) {
+        close(fd);
+        return -1;
+    }
+
+    void* mem = mmap(NULL, sizeof(shmRing_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED) {
+        return -1;
+    }
+
+    link->ring = (shmRing_t*)mem;
+    return 0;
+}
+
+int shmSend(shmLink_t* link, const void* data, size_t size) {
+    shmRing_t* ring = link->ring;
+
+    if (size > SHM_SLOT_SIZE) {
+        return -1;
+    }
+
+    const uint32_t head = ring->head;
+    if (head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) >= SHM_RING_SLOTS) {
+        return -1; // full, dropped like a datagram
+    }
+
+    shmSlot_t* slot = &ring->slot[head & (SHM_RING_SLOTS - 1)];
+    memcpy(slot->data, data, size);
+    slot->size = size;
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_SEQ_CST);
+
+    if (__atomic_load_n(&ring->waiting, __ATOMIC_SEQ_CST)) {
+        futexWake(&ring->head);
+    }
+    return size;
+}
+
+int shmRecv(shmLink_t* link, void* data, size_t size, uint32_t timeout_ms) {
+    shmRing_t* ring = link->ring;
+    const uint32_t tail = ring->tail;
+    uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+
+    for (int i = 0; head == tail && i < SHM_SPIN_COUNT; i++) {
+        head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    }
+
+    if (head == tail) {
+        struct timespec timeout;
+        timeout.tv_sec = timeout_ms / 1000;
+        timeout.tv_nsec = (timeout_ms % 1000) * 1000000UL;
+
+        __atomic_store_n(&ring->waiting, 1, __ATOMIC_SEQ_CST);
+        // the kernel only sleeps if head still holds the value seen here, so a send in between is not missed
+        while ((head = __atomic_load_n(&ring->head, __ATOMIC_SEQ_CST)) == tail) {
+            if (futexWait(&ring->head, tail, &timeout) == -1 && errno == ETIMEDOUT) {
+                break;
+            }
+        }
+        __atomic_store_n(&ring->waiting, 0, __ATOMIC_SEQ_CST);
+
+        if (head == tail) {
+            return -1;
+        }
+    }
+
+    const shmSlot_t* slot = &ring->slot[tail & (SHM_RING_SLOTS - 1)];
+    const int ret = slot->size;
+    memcpy(data, slot->data, slot->size < size ? slot->size : size);
+    __atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE); // the slot may be reused from here on
+    return ret;
+}
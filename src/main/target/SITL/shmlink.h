@@ -0,0 +1,50 @@
+/**
+ * Copyright (c) 2017 cs8425
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license.
+ */
+
+#ifndef __SHMLINK_H
+#define __SHMLINK_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Single producer, single consumer ring in a POSIX shared memory object.
+// The layout below is the contract with the simulator plugin, both ends map the same object.
+
+#define SHM_RING_SLOTS      8       // power of two
+#define SHM_SLOT_SIZE       256     // bytes, fits fdm_packet and servo_packet
+
+typedef struct {
+	uint32_t size;
+	uint8_t data[SHM_SLOT_SIZE];
+} shmSlot_t;
+
+typedef struct {
+	volatile uint32_t head;     // slots written, only moved by the producer, the futex word
+	volatile uint32_t tail;     // slots read, only moved by the consumer
+	volatile uint32_t waiting;  // consumer is asleep on head
+	shmSlot_t slot[SHM_RING_SLOTS];
+} shmRing_t;
+
+typedef struct {
+	shmRing_t* ring;
+	const char* name;
+} shmLink_t;
+
+int shmInit(shmLink_t* link, const char* name);
+int shmRecv(shmLink_t* link, void* data, size_t size, uint32_t timeout_ms);
+int shmSend(shmLink_t* link, const void* data, size_t size);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
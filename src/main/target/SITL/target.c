@@ -15,6 +15,7 @@
  * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -23,11 +24,13 @@
 #include <errno.h>
 #include <time.h>
 
+#include "drivers/adc.h"
 #include "drivers/io.h"
 #include "drivers/dma.h"
 #include "drivers/serial.h"
 #include "drivers/serial_tcp.h"
 #include "drivers/system.h"
+#include "drivers/time.h"
 #include "drivers/pwm_output.h"
 #include "drivers/light_led.h"
 
@@ -40,57 +43,78 @@ const timerHardware_t timerHardware[1]; // unused
 
 #include "config/feature.h"
 #include "fc/config.h"
+#include "fc/fc_init.h"
 #include "scheduler/scheduler.h"
+#include "sensors/gyro.h"
 
 #include "rx/rx.h"
 
 #include "dyad.h"
 #include "target/SITL/udplink.h"
+#ifdef SIMULATOR_LOCKSTEP
+#include "target/SITL/replay.h"
+#endif
+#ifdef SIMULATOR_SHM
+#include "target/SITL/shmlink.h"
+#endif
 
 static fdm_packet fdmPkt;
 static servo_packet pwmPkt;
 
 static struct timespec start_time;
+static int simInstance = 0;
+static char eepromFileName[32] = EEPROM_FILENAME;
 static double simRate = 1.0;
 static pthread_t tcpWorker, udpWorker;
 static bool workerRunning = true;
 static udpLink_t stateLink, pwmLink;
+#ifdef SIMULATOR_SHM
+static shmLink_t stateShm, pwmShm;
+static char stateShmName[32] = SIMULATOR_SHM_STATE_NAME;
+static char pwmShmName[32] = SIMULATOR_SHM_PWM_NAME;
+static bool useShm = false;
+#endif
 static pthread_mutex_t updateLock;
 static pthread_mutex_t mainLoopLock;
 
+#ifdef SIMULATOR_LOCKSTEP
+// only moved by simulatorStep() and the delays, so a run does not depend on the host
+static volatile uint64_t simTimeUs = 0;
+#endif
+
 int timeval_sub(struct timespec *result, struct timespec *x, struct timespec *y);
 
 int lockMainPID(void) {
     return pthread_mutex_trylock(&mainLoopLock);
 }
 
+// shared memory when it could be set up, udp otherwise
+static int simRecv(void* data, size_t size, uint32_t timeout_ms) {
+#ifdef SIMULATOR_SHM
+    if (useShm) {
+        return shmRecv(&stateShm, data, size, timeout_ms);
+    }
+#endif
+    return udpRecv(&stateLink, data, size, timeout_ms);
+}
+
+static int simSend(const void* data, size_t size) {
+#ifdef SIMULATOR_SHM
+    if (useShm) {
+        return shmSend(&pwmShm, data, size);
+    }
+#endif
+    return udpSend(&pwmLink, data, size);
+}
+
 #define RAD2DEG (180.0 / M_PI)
 #define ACC_SCALE (256 / 9.80665)
 #define GYRO_SCALE (16.4)
 void sendMotorUpdate() {
-    udpSend(&pwmLink, &pwmPkt, sizeof(servo_packet));
+    simSend(&pwmPkt, sizeof(servo_packet));
 }
-void updateState(const fdm_packet* pkt) {
-    static double last_timestamp = 0; // in seconds
-    static uint64_t last_realtime = 0; // in uS
-    static struct timespec last_ts; // last packet
-
-    struct timespec now_ts;
-    clock_gettime(CLOCK_MONOTONIC, &now_ts);
-
-    const uint64_t realtime_now = micros64_real();
-    if (realtime_now > last_realtime + 500*1e3) { // 500ms timeout
-        last_timestamp = pkt->timestamp;
-        last_realtime = realtime_now;
-        sendMotorUpdate();
-        return;
-    }
-
-    const double deltaSim = pkt->timestamp - last_timestamp;  // in seconds
-    if (deltaSim < 0) { // don't use old packet
-        return;
-    }
 
+static void setSensorsFromPacket(const fdm_packet* pkt, double deltaSim) {
     int16_t x,y,z;
     x = -pkt->imu_linear_acceleration_xyz[0] * ACC_SCALE;
     y = -pkt->imu_linear_acceleration_xyz[1] * ACC_SCALE;
@@ -138,8 +162,33 @@ void updateState(const fdm_packet* pkt) {
 #if defined(SIMULATOR_IMU_SYNC)
     imuSetHasNewData(deltaSim*1e6);
     imuUpdateAttitude(micros());
+#else
+    UNUSED(deltaSim);
 #endif
+}
 
+void updateState(const fdm_packet* pkt) {
+    static double last_timestamp = 0; // in seconds
+    static uint64_t last_realtime = 0; // in uS
+    static struct timespec last_ts; // last packet
+
+    struct timespec now_ts;
+    clock_gettime(CLOCK_MONOTONIC, &now_ts);
+
+    const uint64_t realtime_now = micros64_real();
+    if (realtime_now > last_realtime + 500*1e3) { // 500ms timeout
+        last_timestamp = pkt->timestamp;
+        last_realtime = realtime_now;
+        sendMotorUpdate();
+        return;
+    }
+
+    const double deltaSim = pkt->timestamp - last_timestamp;  // in seconds
+    if (deltaSim < 0) { // don't use old packet
+        return;
+    }
+
+    setSensorsFromPacket(pkt, deltaSim);
 
     if (deltaSim < 0.02 && deltaSim > 0) { // simulator should run faster than 50Hz
 //		simRate = simRate * 0.5 + (1e6 * deltaSim / (realtime_now - last_realtime)) * 0.5;
@@ -162,12 +211,13 @@ void updateState(const fdm_packet* pkt) {
 #endif
 }
 
+#ifndef SIMULATOR_LOCKSTEP
 static void* udpThread(void* data) {
     UNUSED(data);
     int n = 0;
 
     while (workerRunning) {
-        n = udpRecv(&stateLink, &fdmPkt, sizeof(fdm_packet), 100);
+        n = simRecv(&fdmPkt, sizeof(fdm_packet), 100);
         if (n == sizeof(fdm_packet)) {
 //			printf("[data]new fdm %d\n", n);
             updateState(&fdmPkt);
@@ -177,16 +227,82 @@ static void* udpThread(void* data) {
     printf("udpThread end!!\n");
     return NULL;
 }
+#endif
+
+// no tick interrupt, the tcp thread wakes up every millisecond and stands in for it
+static sysTickDeadlineFunc *sysTickDeadlineFn = NULL;
+static volatile uint32_t sysTickDeadline;
+static volatile bool sysTickDeadlineArmed = false;
+
+void sysTickDeadlineInit(sysTickDeadlineFunc *fn) {
+    sysTickDeadlineArmed = false;
+    sysTickDeadlineFn = fn;
+}
+
+void sysTickDeadlineArm(uint32_t delayUs) {
+    sysTickDeadline = millis() + delayUs / 1000 + 1;
+    sysTickDeadlineArmed = true;
+}
+
+static void sysTickDeadlineCheck(void) {
+    if (sysTickDeadlineArmed && (int32_t)(millis() - sysTickDeadline) >= 0) {
+        sysTickDeadlineArmed = false;
+        if (sysTickDeadlineFn) {
+            sysTickDeadlineFn();
+        }
+    }
+}
+
+#ifdef SIMULATOR_LOCKSTEP
+#define SIMULATOR_LOCKSTEP_MAX_TASKS 64 // bound on tasks run per step, in case one never settles
+
+void simulatorStep(void) {
+    if (replayIsActive()) {
+        if (!replayStep()) {
+            exit(replayFinish());
+        }
+    } else {
+        if (simRecv(&fdmPkt, sizeof(fdm_packet), 100) != sizeof(fdm_packet)) {
+            return;
+        }
+        setSensorsFromPacket(&fdmPkt, gyro.targetLooptime * 1e-6);
+    }
+    simTimeUs += gyro.targetLooptime;
+    sysTickDeadlineCheck();
+#ifdef USE_FAKE_GYRO_MODEL
+    fakeGyroUpdate();
+#endif
+
+    for (int i = 0; i < SIMULATOR_LOCKSTEP_MAX_TASKS; i++) {
+        scheduler();
+        processLoopback();
+        if (schedulerIsIdle()) {
+            break;
+        }
+    }
+
+    if (replayIsActive()) {
+        replayCheck();
+    } else {
+        sendMotorUpdate();
+    }
+}
+#endif
 
 static void* tcpThread(void* data) {
     UNUSED(data);
 
     dyad_init();
     dyad_setTickInterval(0.2f);
-    dyad_setUpdateTimeout(0.5f);
+    // short, as writes from the flight code are only sent from here
+    dyad_setUpdateTimeout(0.001f);
 
     while (workerRunning) {
         dyad_update();
+        tcpUpdate();
+#ifndef SIMULATOR_LOCKSTEP
+        sysTickDeadlineCheck();
+#endif
     }
 
     dyad_shutdown();
@@ -194,12 +310,79 @@ static void* tcpThread(void* data) {
     return NULL;
 }
 
+// instance 0 keeps the plain names and ports, so a single SITL runs as it always did
+static void instanceInit(void) {
+    const char *env = getenv(SIMULATOR_INSTANCE_ENV);
+    if (env) {
+        char *end;
+        const long instance = strtol(env, &end, 10);
+        if (*end != '\0' || instance < 0 || instance > SIMULATOR_INSTANCE_MAX) {
+            printf("[system]%s=%s is not an instance in 0..%d, using 0\n", SIMULATOR_INSTANCE_ENV, env, SIMULATOR_INSTANCE_MAX);
+        } else {
+            simInstance = instance;
+        }
+    }
+
+    if (simInstance) {
+        snprintf(eepromFileName, sizeof(eepromFileName), EEPROM_INSTANCE_FILENAME, simInstance);
+#ifdef SIMULATOR_SHM
+        snprintf(stateShmName, sizeof(stateShmName), "%s_%d", SIMULATOR_SHM_STATE_NAME, simInstance);
+        snprintf(pwmShmName, sizeof(pwmShmName), "%s_%d", SIMULATOR_SHM_PWM_NAME, simInstance);
+#endif
+    }
+    printf("[system]instance %d, ports offset by %d, config in %s\n", simInstance, simulatorPortOffset(), eepromFileName);
+}
+
+int simulatorPortOffset(void) {
+    return simInstance * SIMULATOR_INSTANCE_PORT_STRIDE;
+}
+
+#ifdef USE_FAKE_GYRO_MODEL
+// the model stays off, and the gyro returns each value as it is set, unless one of these is set
+static void gyroModelInit(void) {
+    const char *enable = getenv("SITL_GYRO_MODEL");
+    const char *noise = getenv("SITL_GYRO_NOISE");
+    const char *motor = getenv("SITL_GYRO_MOTOR");
+    const char *quantisation = getenv("SITL_GYRO_QUANT");
+    const char *latency = getenv("SITL_GYRO_LATENCY");
+    if (!enable && !noise && !motor && !quantisation && !latency) {
+        return;
+    }
+
+    fakeGyroModel_t model = { .motorHarmonics = 1 };
+    if (noise) {
+        model.noiseDps = atof(noise);
+    }
+    if (motor && sscanf(motor, "%f,%f,%hhu", &model.motorHz, &model.motorDps, &model.motorHarmonics) < 2) {
+        printf("[system]SITL_GYRO_MOTOR=%s is not <Hz>,<dps>[,<harmonics>]\n", motor);
+        model.motorHz = 0.0f;
+    }
+    if (quantisation) {
+        model.quantisationLsb = atoi(quantisation);
+    }
+    if (latency) {
+        model.latencyUs = atoi(latency);
+    }
+#ifdef SIMULATOR_LOCKSTEP
+    // only in lockstep does the loop thread move the time on, so only then can data ready run the loop
+    model.dataReadyInterrupt = true;
+#endif
+    fakeGyroSetModel(&model);
+    printf("[system]gyro model, noise %.1fdps, motor %.0fHz %.1fdps x%d, quantisation %dlsb, latency %dus\n",
+        (double)model.noiseDps, (double)model.motorHz, (double)model.motorDps, model.motorHarmonics, model.quantisationLsb, model.latencyUs);
+}
+#endif
+
 // system
 void systemInit(void) {
     int ret;
 
     clock_gettime(CLOCK_MONOTONIC, &start_time);
     printf("[system]Init...\n");
+    instanceInit();
+#ifdef USE_FAKE_GYRO_MODEL
+    gyroModelInit();
+#endif
 
     SystemCoreClock = 500 * 1e6; // fake 500MHz
     FLASH_Unlock();
@@ -220,17 +403,34 @@ void systemInit(void) {
         exit(1);
     }
 
-    ret = udpInit(&pwmLink, "127.0.0.1", 9002, false);
+#ifdef SIMULATOR_LOCKSTEP
+    // a replay needs no simulator, so nothing is bound and many can run side by side
+    if (replayInit()) {
+        rescheduleTask(TASK_SERIAL, 1);
+        return;
+    }
+#endif
+
+#ifdef SIMULATOR_SHM
+    useShm = shmInit(&pwmShm, pwmShmName) == 0 && shmInit(&stateShm, stateShmName) == 0;
+    printf("init shared memory link...%d\n", useShm);
+#endif
+
+    ret = udpInit(&pwmLink, "127.0.0.1", SIMULATOR_PWM_PORT + simulatorPortOffset(), false);
     printf("init PwnOut UDP link...%d\n", ret);
 
-    ret = udpInit(&stateLink, NULL, 9003, true);
+    ret = udpInit(&stateLink, NULL, SIMULATOR_STATE_PORT + simulatorPortOffset(), true);
     printf("start UDP server...%d\n", ret);
 
+#ifdef SIMULATOR_LOCKSTEP
+    printf("lockstep with the simulator, one gyro period per fdm packet\n");
+#else
     ret = pthread_create(&udpWorker, NULL, udpThread, NULL);
     if (ret != 0) {
         printf("Create udpWorker error!\n");
         exit(1);
     }
+#endif
 
     // serial can't been slow down
     rescheduleTask(TASK_SERIAL, 1);
@@ -240,14 +440,18 @@ void systemReset(void){
     printf("[system]Reset!\n");
     workerRunning = false;
     pthread_join(tcpWorker, NULL);
+#ifndef SIMULATOR_LOCKSTEP
     pthread_join(udpWorker, NULL);
+#endif
     exit(0);
 }
 void systemResetToBootloader(void) {
     printf("[system]ResetToBootloader!\n");
     workerRunning = false;
     pthread_join(tcpWorker, NULL);
+#ifndef SIMULATOR_LOCKSTEP
     pthread_join(udpWorker, NULL);
+#endif
     exit(0);
 }
 
@@ -295,6 +499,15 @@ uint64_t millis64_real() {
     return 1.0e3*((ts.tv_sec + (ts.tv_nsec*1.0e-9)) - (start_time.tv_sec + (start_time.tv_nsec*1.0e-9)));
 }
 
+#ifdef SIMULATOR_LOCKSTEP
+uint64_t micros64() {
+    return simTimeUs;
+}
+
+uint64_t millis64() {
+    return simTimeUs / 1000;
+}
+#else
 uint64_t micros64() {
     static uint64_t last = 0;
     static uint64_t out = 0;
@@ -318,6 +531,7 @@ uint64_t millis64() {
     return out*1e-6;
 //	return millis64_real();
 }
+#endif
 
 uint32_t micros(void) {
     return micros64() & 0xFFFFFFFF;
@@ -334,20 +548,31 @@ void microsleep(uint32_t usec) {
     while (nanosleep(&ts, &ts) == -1 && errno == EINTR) ;
 }
 
+#ifdef SIMULATOR_LOCKSTEP
+// nothing else moves time, a wait in the flight code just passes it
+void delayMicroseconds(uint32_t us) {
+    simTimeUs += us;
+}
+#else
 void delayMicroseconds(uint32_t us) {
     microsleep(us / simRate);
 }
+#endif
 
 void delayMicroseconds_real(uint32_t us) {
     microsleep(us);
 }
 
 void delay(uint32_t ms) {
+#ifdef SIMULATOR_LOCKSTEP
+    simTimeUs += ms * 1000ULL;
+#else
     uint64_t start = millis64();
 
     while ((millis64() - start) < ms) {
         microsleep(1000);
     }
+#endif
 }
 
 // Subtract the ‘struct timespec’ values X and Y,  storing the result in RESULT.
@@ -443,9 +668,14 @@ void pwmCompleteMotorUpdate(uint8_t motorCount) {
     pwmPkt.motor_speed[1] = motorsPwm[2] / outScale;
     pwmPkt.motor_speed[2] = motorsPwm[3] / outScale;
 
+#ifdef SIMULATOR_LOCKSTEP
+    // sent by simulatorStep() once the step is done
+    return;
+#endif
+
     // get one "fdm_packet" can only send one "servo_packet"!!
     if (pthread_mutex_trylock(&updateLock) != 0) return;
-    udpSend(&pwmLink, &pwmPkt, sizeof(servo_packet));
+    simSend(&pwmPkt, sizeof(servo_packet));
 //	printf("[pwm]%u:%u,%u,%u,%u\n", idlePulse, motorsPwm[0], motorsPwm[1], motorsPwm[2], motorsPwm[3]);
 }
 
@@ -455,6 +685,11 @@ void pwmWriteServo(uint8_t index, float value) {
 
 // ADC part
 uint16_t adcGetChannel(uint8_t channel) {
+#ifdef SIMULATOR_LOCKSTEP
+    if (channel == ADC_BATTERY && replayIsActive()) {
+        return replayBatteryAdc();
+    }
+#endif
     UNUSED(channel);
     return 0;
 }
@@ -477,7 +712,7 @@ void FLASH_Unlock(void) {
     }
 
     // open or create
-    eepromFd = fopen(EEPROM_FILENAME,"r+");
+    eepromFd = fopen(eepromFileName,"r+");
     if (eepromFd != NULL) {
         // obtain file size:
         fseek(eepromFd , 0 , SEEK_END);
@@ -491,7 +726,7 @@ void FLASH_Unlock(void) {
             eeprom[i] = (uint8_t)c;
         }
     } else {
-        eepromFd = fopen(EEPROM_FILENAME, "w+");
+        eepromFd = fopen(eepromFileName, "w+");
         fwrite(eeprom, sizeof(uint8_t), &__config_end - &__config_start, eepromFd);
     }
 }
@@ -508,7 +743,12 @@ void FLASH_Lock(void) {
 }
 
 FLASH_Status FLASH_ErasePage(uintptr_t Page_Address) {
-    UNUSED(Page_Address);
+    // Erased flash reads as 0xFF, the config store relies on this to find the end of the saved updates
+    for (uintptr_t addr = Page_Address; addr < Page_Address + 0x400 && addr < (uintptr_t)&__config_end; addr++) {
+        if (addr >= (uintptr_t)&__config_start) {
+            *((uint8_t *)addr) = 0xFF;
+        }
+    }
 //	printf("[FLASH_ErasePage]%x\n", Page_Address);
     return FLASH_COMPLETE;
 }
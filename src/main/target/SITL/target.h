@@ -32,8 +32,31 @@
 //#define SIMULATOR_IMU_SYNC
 //#define SIMULATOR_GYROPID_SYNC
 
+// each fdm packet advances time by one gyro period and runs the scheduler until it is idle,
+// the simulator then steps the flight code as fast as it can, with reproducible results
+//#define SIMULATOR_LOCKSTEP
+
+// exchange fdm_packet and servo_packet through shared memory rings instead of udp, see shmlink.h,
+// udp is still used when the shared memory can not be set up
+//#define SIMULATOR_SHM
+#define SIMULATOR_SHM_STATE_NAME "/betaflight_sitl_state"
+#define SIMULATOR_SHM_PWM_NAME "/betaflight_sitl_pwm"
+
+#if defined(SIMULATOR_LOCKSTEP) && defined(SIMULATOR_GYROPID_SYNC)
+#error "SIMULATOR_LOCKSTEP and SIMULATOR_GYROPID_SYNC can not be used together"
+#endif
+
 // file name to save config
 #define EEPROM_FILENAME "eeprom.bin"
+#define EEPROM_INSTANCE_FILENAME "eeprom_%d.bin"
+
+// several SITL can run on one host, each started with its own SITL_INSTANCE,
+// every port moves on by the stride per instance and each has its own config file
+#define SIMULATOR_INSTANCE_ENV "SITL_INSTANCE"
+#define SIMULATOR_INSTANCE_MAX 99
+#define SIMULATOR_INSTANCE_PORT_STRIDE 10 // room for the 8 UART ports
+#define SIMULATOR_PWM_PORT 9002
+#define SIMULATOR_STATE_PORT 9003
 
 #define U_ID_0 0
 #define U_ID_1 1
@@ -52,6 +75,10 @@
 
 #define GYRO
 #define USE_FAKE_GYRO
+// the fake gyro samples at the gyro rate, with FIFO, data ready, noise and latency, when SITL_GYRO_* is set
+#define USE_FAKE_GYRO_MODEL
+#define USE_GYRO_FIFO
+#define USE_GYRO_ISR_UPDATE
 
 #define MAG
 #define USE_FAKE_MAG
@@ -88,6 +115,7 @@
 #undef USE_PPM
 #undef USE_PWM
 #undef SERIAL_RX
+#undef USE_SERIALRX_DUAL
 #undef USE_SERIALRX_CRSF
 #undef USE_SERIALRX_IBUS
 #undef USE_SERIALRX_SBUS
@@ -108,6 +136,8 @@
 #undef TELEMETRY_SRXL
 #undef USE_SERIALRX_JETIEXBUS
 #undef VTX_COMMON
+#undef USE_LOOP_BENCHMARK
+#undef USE_KERNEL_BENCHMARK
 #undef VTX_CONTROL
 #undef VTX_SMARTAUDIO
 #undef VTX_TRAMP
@@ -247,4 +277,8 @@ uint64_t micros64();
 uint64_t millis64();
 
 int lockMainPID(void);
+int simulatorPortOffset(void);
+#ifdef SIMULATOR_LOCKSTEP
+void simulatorStep(void);
+#endif
 
@@ -25,6 +25,50 @@
 #undef VTX_TRAMP
 #endif
 
+// Histograms are collected alongside the regular task statistics, and only those can be sampled
+#ifdef SKIP_TASK_STATISTICS
+#undef USE_TASK_STATISTICS_HISTOGRAM
+#undef USE_TASK_STATISTICS_SAMPLING
+#endif
+
+// Per task stack usage is sampled by the scheduler on top of the stack check
+#if defined(STACK_CHECK) && !defined(SKIP_TASK_STATISTICS)
+#define USE_TASK_STACK_STATISTICS
+#endif
+
+#if !defined(USE_DSHOT)
+#undef USE_DSHOT_DMAR
+#undef USE_DSHOT_TELEMETRY
+#endif
+
+// The DShot benchmark goes by the bidirectional replies
+#if !defined(USE_DSHOT_TELEMETRY)
+#undef USE_DSHOT_BENCHMARK
+#endif
+
+// The RPM filter gets the motor speeds from the DShot ESC telemetry
+#if defined(USE_RPM_FILTER) && !(defined(USE_ESC_SENSOR) && defined(USE_DSHOT))
+#undef USE_RPM_FILTER
+#endif
+
+// The gyro FIFO is burst read over SPI, from the MPU6000, MPU6500 and ICM20689 families, or emulated by the fake gyro model
+#if defined(USE_GYRO_FIFO) && !(defined(USE_GYRO_SPI_MPU6000) || defined(USE_GYRO_SPI_MPU6500) || defined(USE_GYRO_SPI_ICM20601) || defined(USE_GYRO_SPI_ICM20689) || defined(USE_FAKE_GYRO_MODEL))
+#undef USE_GYRO_FIFO
+#endif
+
+#ifndef BLACKBOX
+#undef USE_BLACKBOX_PREROLL
+#endif
+
+// Only the flash and SD card logs are compressed
+#if defined(USE_BLACKBOX_COMPRESSION) && !(defined(BLACKBOX) && (defined(USE_FLASHFS) || defined(USE_SDCARD)))
+#undef USE_BLACKBOX_COMPRESSION
+#endif
+
+#ifndef USE_SDCARD
+#undef USE_SDCARD_STATS
+#endif
+
 #if defined(USE_QUAD_MIXER_ONLY) && defined(USE_SERVOS)
 #undef USE_SERVOS
 #endif
@@ -43,23 +43,62 @@
 #define MINIMAL_CLI
 #define USE_DSHOT
 #define USE_GYRO_DATA_ANALYSE
+#define USE_TASK_STATISTICS_SAMPLING
+// RX DMA is claimed at the end of init, once every other DMA user has had its pick
+#define USE_UART_RX_DMA
+#define USE_UART1_RX_DMA
+#define USE_UART2_RX_DMA
+#define USE_UART3_RX_DMA
+#define USE_SOFTSERIAL_DMA
+#define USE_PPM_DMA
 #endif
 
 #ifdef STM32F4
+#if defined(STM32F40_41xxx)
+// the 64K CCM of the F405, the F411 and F446 have none
+#define USE_FAST_RAM
+#endif
 #define USE_DSHOT
+#define USE_UART_RX_DMA
+#define USE_UART1_RX_DMA
+#define USE_UART2_RX_DMA
+#define USE_UART3_RX_DMA
+#define USE_UART4_RX_DMA
+#define USE_UART5_RX_DMA
+#define USE_UART6_RX_DMA
+#define USE_SOFTSERIAL_DMA
+#define USE_PPM_DMA
+#define USE_DSHOT_DMAR
+#define USE_DSHOT_TELEMETRY
+#define USE_DSHOT_BENCHMARK
 #define USE_ESC_SENSOR
+#define USE_RPM_FILTER
 #define I2C3_OVERCLOCK true
 #define TELEMETRY_IBUS
 #define USE_GYRO_DATA_ANALYSE
+#define USE_GYRO_FIFO
+#define USE_CYCLE_TRACE
+#define USE_TASK_STATISTICS_SAMPLING
+#define USE_BLACKBOX_PREROLL
+#define USE_UART_CTS
 #endif
 
 #ifdef STM32F7
+#define USE_ITCM_RAM
+#define USE_FAST_RAM
+#define USE_DMA_RAM
 #define USE_DSHOT
 #define USE_ESC_SENSOR
+#define USE_RPM_FILTER
 #define I2C3_OVERCLOCK true
 #define I2C4_OVERCLOCK true
 #define TELEMETRY_IBUS
 #define USE_GYRO_DATA_ANALYSE
+#define USE_GYRO_FIFO
+#define USE_CYCLE_TRACE
+#define USE_TASK_STATISTICS_SAMPLING
+#define USE_BLACKBOX_PREROLL
+#define USE_UART_CTS
 #endif
 
 #if defined(STM32F4) || defined(STM32F7)
@@ -96,6 +135,7 @@
 
 #if (FLASH_SIZE > 64)
 #define BLACKBOX
+#define USE_SCHEDULER_LOAD_SHEDDING
 #define LED_STRIP
 #define TELEMETRY
 #define TELEMETRY_FRSKY
@@ -108,6 +148,9 @@
 
 #if (FLASH_SIZE > 128)
 #define CMS
+#define USE_CLI_BATCH
+#define USE_SCHEDULER_DEADLINE_QUEUE
+#define USE_TASK_STATISTICS_HISTOGRAM
 #define TELEMETRY_CRSF
 #define TELEMETRY_IBUS
 #define TELEMETRY_JETIEXBUS
@@ -118,13 +161,28 @@
 #define USE_RCSPLIT
 #define USE_RX_MSP
 #define USE_SERIALRX_JETIEXBUS
+#define USE_SERIALRX_DUAL       // second serial receiver, the freshest valid frame wins
 #define USE_SENSOR_NAMES
+#define USE_SETTING_INDEX       // settings found by name with a binary search, costs two bytes of RAM a setting
 #define USE_VIRTUAL_CURRENT_METER
 #define VTX_COMMON
 #define VTX_CONTROL
 #define VTX_SMARTAUDIO
 #define VTX_TRAMP
 #define USE_CAMERA_CONTROL
+#define USE_LOOP_BENCHMARK
+#define USE_KERNEL_BENCHMARK
+#define USE_GYRO_FILTER_CHAINS
+#define USE_ITERM_RELAX
+#define USE_ABSOLUTE_CONTROL
+#define USE_GYRO_BIAS_TRACKING
+#define USE_GYRO_OVERFLOW_CHECK
+#define USE_GYRO_SAMPLE_CLOCK
+#define USE_MAG_BACKGROUND_CALIBRATION
+#define USE_BLACKBOX_COMPRESSION
+#define USE_SDCARD_STATS
+#define USE_ASYNC_CONFIG_SAVE
+#define USE_PERF_RECORD
 
 #ifdef USE_SERIALRX_SPEKTRUM
 #define USE_SPEKTRUM_BIND
@@ -29,6 +29,7 @@
 #include "config/parameter_group.h"
 #include "config/parameter_group_ids.h"
 
+#include "common/crc.h"
 #include "common/maths.h"
 #include "common/streambuf.h"
 #include "common/utils.h"
@@ -49,7 +50,10 @@
 #include "rx/crsf.h"
 
 #include "telemetry/telemetry.h"
+#include "telemetry/telemetry_scheduler.h"
+#include "telemetry/telemetry_snapshot.h"
 #include "telemetry/crsf.h"
+#include "telemetry/crsf_parameters.h"
 
 #include "fc/config.h"
 
@@ -68,12 +72,7 @@ static void crsfInitializeFrame(sbuf_t *dst)
 
 static void crsfWriteCrc(sbuf_t *dst, uint8_t *start)
 {
-    uint8_t crc = 0;
-    uint8_t *end = sbufPtr(dst);
-    for (uint8_t *ptr = start; ptr < end; ++ptr) {
-        crc = crc8_dvb_s2(crc, *ptr);
-    }
-    sbufWriteU8(dst, crc);
+    sbufWriteU8(dst, crc8_dvb_s2_update(0, start, sbufPtr(dst) - start));
 }
 
 static void crsfFinalize(sbuf_t *dst)
@@ -104,6 +103,7 @@ Type:           (uint8_t)
 CRC:            (uint8_t), crc of <Type> and <Payload>
 */
 
+#ifdef GPS
 /*
 0x02 GPS
 Payload:
@@ -119,15 +119,16 @@ void crsfFrameGps(sbuf_t *dst)
     // use sbufWrite since CRC does not include frame length
     sbufWriteU8(dst, CRSF_FRAME_GPS_PAYLOAD_SIZE + CRSF_FRAME_LENGTH_TYPE_CRC);
     sbufWriteU8(dst, CRSF_FRAMETYPE_GPS);
-    sbufWriteU32BigEndian(dst, gpsSol.llh.lat); // CRSF and betaflight use same units for degrees
-    sbufWriteU32BigEndian(dst, gpsSol.llh.lon);
-    sbufWriteU16BigEndian(dst, (gpsSol.groundSpeed * 36 + 5) / 10); // gpsSol.groundSpeed is in 0.1m/s
-    sbufWriteU16BigEndian(dst, gpsSol.groundCourse * 10); // gpsSol.groundCourse is degrees * 10
+    sbufWriteU32BigEndian(dst, telemetrySnapshot.gpsSol.llh.lat); // CRSF and betaflight use same units for degrees
+    sbufWriteU32BigEndian(dst, telemetrySnapshot.gpsSol.llh.lon);
+    sbufWriteU16BigEndian(dst, (telemetrySnapshot.gpsSol.groundSpeed * 36 + 5) / 10); // gpsSol.groundSpeed is in 0.1m/s
+    sbufWriteU16BigEndian(dst, telemetrySnapshot.gpsSol.groundCourse * 10); // gpsSol.groundCourse is degrees * 10
     //Send real GPS altitude only if it's reliable (there's a GPS fix)
-    const uint16_t altitude = (STATE(GPS_FIX) ? gpsSol.llh.alt : 0) + 1000;
+    const uint16_t altitude = (STATE(GPS_FIX) ? telemetrySnapshot.gpsSol.llh.alt : 0) + 1000;
     sbufWriteU16BigEndian(dst, altitude);
-    sbufWriteU8(dst, gpsSol.numSat);
+    sbufWriteU8(dst, telemetrySnapshot.gpsSol.numSat);
 }
+#endif
 
 /*
 0x08 Battery sensor
@@ -142,7 +143,7 @@ void crsfFrameBatterySensor(sbuf_t *dst)
     // use sbufWrite since CRC does not include frame length
     sbufWriteU8(dst, CRSF_FRAME_BATTERY_SENSOR_PAYLOAD_SIZE + CRSF_FRAME_LENGTH_TYPE_CRC);
     sbufWriteU8(dst, CRSF_FRAMETYPE_BATTERY_SENSOR);
-    sbufWriteU16BigEndian(dst, getBatteryVoltage()); // vbat is in units of 0.1V
+    sbufWriteU16BigEndian(dst, telemetrySnapshot.vbat); // vbat is in units of 0.1V
 #ifdef CLEANFLIGHT
     const amperageMeter_t *amperageMeter = getAmperageMeter(batteryConfig()->amperageMeterSource);
     const int16_t amperage = constrain(amperageMeter->amperage, -0x8000, 0x7FFF) / 10; // send amperage in 0.01 A steps, range is -320A to 320A
@@ -150,9 +151,9 @@ void crsfFrameBatterySensor(sbuf_t *dst)
     const uint32_t batteryCapacity = batteryConfig()->batteryCapacity;
     const uint8_t batteryRemainingPercentage = batteryCapacityRemainingPercentage();
 #else
-    sbufWriteU16BigEndian(dst, getAmperage() / 10);
+    sbufWriteU16BigEndian(dst, telemetrySnapshot.amperage / 10);
     const uint32_t batteryCapacity = batteryConfig()->batteryCapacity;
-    const uint8_t batteryRemainingPercentage = calculateBatteryPercentageRemaining();
+    const uint8_t batteryRemainingPercentage = telemetrySnapshot.batteryRemaining;
 #endif
     sbufWriteU8(dst, (batteryCapacity >> 16));
     sbufWriteU8(dst, (batteryCapacity >> 8));
@@ -196,9 +197,9 @@ void crsfFrameAttitude(sbuf_t *dst)
 {
      sbufWriteU8(dst, CRSF_FRAME_ATTITUDE_PAYLOAD_SIZE + CRSF_FRAME_LENGTH_TYPE_CRC);
      sbufWriteU8(dst, CRSF_FRAMETYPE_ATTITUDE);
-     sbufWriteU16BigEndian(dst, DECIDEGREES_TO_RADIANS10000(attitude.values.pitch));
-     sbufWriteU16BigEndian(dst, DECIDEGREES_TO_RADIANS10000(attitude.values.roll));
-     sbufWriteU16BigEndian(dst, DECIDEGREES_TO_RADIANS10000(attitude.values.yaw));
+     sbufWriteU16BigEndian(dst, DECIDEGREES_TO_RADIANS10000(telemetrySnapshot.attitude.values.pitch));
+     sbufWriteU16BigEndian(dst, DECIDEGREES_TO_RADIANS10000(telemetrySnapshot.attitude.values.roll));
+     sbufWriteU16BigEndian(dst, DECIDEGREES_TO_RADIANS10000(telemetrySnapshot.attitude.values.yaw));
 }
 
 /*
@@ -231,45 +232,46 @@ void crsfFrameFlightMode(sbuf_t *dst)
     *lengthPtr = sbufPtr(dst) - lengthPtr;
 }
 
-#define BV(x)  (1 << (x)) // bit value
-
-// schedule array to decide how often each type of frame is sent
-#define CRSF_SCHEDULE_COUNT_MAX     5
-static uint8_t crsfScheduleCount;
-static uint8_t crsfSchedule[CRSF_SCHEDULE_COUNT_MAX];
+// how often each type of frame is sent relative to the others
+static const telemetrySensor_t crsfSensors[] = {
+    // id                       weight  priority
+    { CRSF_FRAME_ATTITUDE       , 3    , 3 },
+    { CRSF_FRAME_BATTERY_SENSOR , 2    , 2 },
+    { CRSF_FRAME_GPS            , 2    , 1 },
+    { CRSF_FRAME_FLIGHT_MODE    , 1    , 0 },
+};
 
+static telemetryScheduler_t crsfScheduler;
 
 static void processCrsf(void)
 {
-    static uint8_t crsfScheduleIndex = 0;
-    const uint8_t currentSchedule = crsfSchedule[crsfScheduleIndex];
+    const telemetrySensor_t *sensor = telemetrySchedulerNext(&crsfScheduler);
+    if (!sensor) {
+        return;
+    }
 
     sbuf_t crsfPayloadBuf;
     sbuf_t *dst = &crsfPayloadBuf;
 
-    if (currentSchedule & BV(CRSF_FRAME_ATTITUDE)) {
-        crsfInitializeFrame(dst);
+    crsfInitializeFrame(dst);
+    switch (sensor->id) {
+    default:
+    case CRSF_FRAME_ATTITUDE:
         crsfFrameAttitude(dst);
-        crsfFinalize(dst);
-    }
-    if (currentSchedule & BV(CRSF_FRAME_BATTERY_SENSOR)) {
-        crsfInitializeFrame(dst);
+        break;
+    case CRSF_FRAME_BATTERY_SENSOR:
         crsfFrameBatterySensor(dst);
-        crsfFinalize(dst);
-    }
-    if (currentSchedule & BV(CRSF_FRAME_FLIGHT_MODE)) {
-        crsfInitializeFrame(dst);
+        break;
+    case CRSF_FRAME_FLIGHT_MODE:
         crsfFrameFlightMode(dst);
-        crsfFinalize(dst);
-    }
+        break;
 #ifdef GPS
-    if (currentSchedule & BV(CRSF_FRAME_GPS)) {
-        crsfInitializeFrame(dst);
+    case CRSF_FRAME_GPS:
         crsfFrameGps(dst);
-        crsfFinalize(dst);
-    }
+        break;
 #endif
-    crsfScheduleIndex = (crsfScheduleIndex + 1) % crsfScheduleCount;
+    }
+    crsfFinalize(dst);
 }
 
 void initCrsfTelemetry(void)
@@ -277,15 +279,14 @@ void initCrsfTelemetry(void)
     // check if there is a serial port open for CRSF telemetry (ie opened by the CRSF RX)
     // and feature is enabled, if so, set CRSF telemetry enabled
     crsfTelemetryEnabled = crsfRxIsActive();
-    int index = 0;
-    crsfSchedule[index++] = BV(CRSF_FRAME_ATTITUDE);
-    crsfSchedule[index++] = BV(CRSF_FRAME_BATTERY_SENSOR);
-    crsfSchedule[index++] = BV(CRSF_FRAME_FLIGHT_MODE);
-    if (feature(FEATURE_GPS)) {
-        crsfSchedule[index++] = BV(CRSF_FRAME_GPS);
-    }
-    crsfScheduleCount = (uint8_t)index;
+    telemetrySchedulerInit(&crsfScheduler, crsfSensors, ARRAYLEN(crsfSensors));
+#ifdef GPS
+    telemetrySchedulerEnable(&crsfScheduler, CRSF_FRAME_GPS, feature(FEATURE_GPS));
+#else
+    telemetrySchedulerEnable(&crsfScheduler, CRSF_FRAME_GPS, false);
+#endif
 
+    crsfParametersInit();
  }
 
 bool checkCrsfTelemetryState(void)
@@ -308,6 +309,11 @@ void handleCrsfTelemetry(timeUs_t currentTimeUs)
     // in between the RX frames.
     crsfRxSendTelemetryData();
 
+    // Telemetry waits while a frame is still in the buffer, parameter replies go first since a script waits for them
+    if (!crsfRxIsTelemetryBufferFree() || crsfParametersProcessRequest()) {
+        return;
+    }
+
     // Actual telemetry data only needs to be sent at a low frequency, ie 10Hz
     if (currentTimeUs >= crsfLastCycleTime + CRSF_CYCLETIME_US) {
         crsfLastCycleTime = currentTimeUs;
@@ -0,0 +1,357 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "platform.h"
+
+#ifdef TELEMETRY
+
+#include "build/version.h"
+
+#include "common/crc.h"
+#include "common/maths.h"
+#include "common/streambuf.h"
+#include "common/utils.h"
+
+#include "fc/config.h"
+#include "fc/runtime_config.h"
+#include "fc/settings.h"
+
+#include "rx/crsf.h"
+
+#include "telemetry/crsf_parameters.h"
+
+/*
+ * CRSF device parameter protocol
+ *
+ * The transmitter's configuration script pings the devices on the link, reads each parameter of
+ * a device in chunks and writes new values. Entries are built from a fixed list of CLI settings,
+ * resolved once at init, so a request costs no more than formatting one entry. The RX task only
+ * keeps the request, it is answered here from the telemetry task.
+ *
+ * Parameter 0 is the root folder, the settings follow and the last parameter is a command that
+ * saves the configuration. Values can only be changed while disarmed.
+ */
+
+#define CRSF_PARAMETER_CHUNK_SIZE       56  // a 62 byte frame less type, addresses, number, chunks remaining and CRC
+#define CRSF_PARAMETER_ENTRY_SIZE_MAX   (CRSF_PARAMETER_CHUNK_SIZE * 8)
+#define CRSF_PARAMETER_FOLDER_ROOT      0
+#define CRSF_PARAMETER_PROTOCOL_VERSION 0
+#define CRSF_PARAMETER_COMMAND_TIMEOUT  50  // 10ms units, how long the script waits before polling a command
+
+typedef enum {
+    CRSF_PARAMETER_UINT8 = 0,
+    CRSF_PARAMETER_INT8 = 1,
+    CRSF_PARAMETER_UINT16 = 2,
+    CRSF_PARAMETER_INT16 = 3,
+    CRSF_PARAMETER_TEXT_SELECTION = 9,
+    CRSF_PARAMETER_FOLDER = 11,
+    CRSF_PARAMETER_COMMAND = 13
+} crsfParameterType_e;
+
+typedef enum {
+    CRSF_COMMAND_READY = 0,
+    CRSF_COMMAND_START = 1
+} crsfCommandStatus_e;
+
+static const char * const crsfParameterNames[] = {
+    "p_roll", "i_roll", "d_roll",
+    "p_pitch", "i_pitch", "d_pitch",
+    "p_yaw", "i_yaw", "d_yaw",
+    "rc_rate", "rc_rate_yaw", "rc_expo",
+    "roll_srate", "pitch_srate", "yaw_srate",
+    "tpa_rate", "tpa_breakpoint",
+    "anti_gravity_gain", "feed_forward_smoothing",
+    "gyro_lowpass_hz", "dterm_lowpass",
+    "rc_interp", "rc_interp_ch", "rx_frame_event",
+    "small_angle",
+    "motor_pwm_protocol", "motor_pwm_rate",
+    "vbat_warning_cell_voltage",
+};
+
+static const clivalue_t *crsfParameters[ARRAYLEN(crsfParameterNames)];
+static uint8_t crsfParameterCount;
+static bool crsfConfigSaved;
+
+#define CRSF_PARAMETER_SAVE (crsfParameterCount + 1)
+
+void crsfParametersInit(void)
+{
+    crsfParameterCount = 0;
+    crsfConfigSaved = false;
+    for (unsigned ii = 0; ii < ARRAYLEN(crsfParameterNames); ++ii) {
+        for (unsigned jj = 0; jj < valueTableEntryCount; ++jj) {
+            const clivalue_t *value = &valueTable[jj];
+            if ((value->type & VALUE_MODE_MASK) != MODE_ARRAY && strcmp(value->name, crsfParameterNames[ii]) == 0) {
+                crsfParameters[crsfParameterCount++] = value;
+                break;
+            }
+        }
+    }
+}
+
+static bool crsfParameterIs16Bit(const clivalue_t *value)
+{
+    const uint8_t type = value->type & VALUE_TYPE_MASK;
+    return type == VAR_UINT16 || type == VAR_INT16;
+}
+
+static void crsfWriteParameterNumber(sbuf_t *dst, const clivalue_t *value, int32_t number)
+{
+    if (crsfParameterIs16Bit(value)) {
+        sbufWriteU16BigEndian(dst, number);
+    } else {
+        sbufWriteU8(dst, number);
+    }
+}
+
+static void crsfWriteString(sbuf_t *dst, const char *string)
+{
+    sbufWriteString(dst, string);
+    sbufWriteU8(dst, '\0');
+}
+
+/*
+Value entries:
+uint8_t     Parent folder
+uint8_t     Type
+char[]      Name ( null terminated )
+TEXT_SELECTION: char[] options ( ';' separated, null terminated ), uint8_t value, min, max, default
+numbers:    value, min, max, default ( 1 or 2 bytes, big endian )
+char[]      Units ( null terminated )
+No defaults are kept, the current value is reported as the default.
+*/
+static void crsfWriteValueEntry(sbuf_t *dst, const clivalue_t *value)
+{
+    const int32_t current = settingGetValue(value);
+
+    sbufWriteU8(dst, CRSF_PARAMETER_FOLDER_ROOT);
+    if ((value->type & VALUE_MODE_MASK) == MODE_LOOKUP) {
+        const lookupTableEntry_t *table = &lookupTables[value->config.lookup.tableIndex];
+        sbufWriteU8(dst, CRSF_PARAMETER_TEXT_SELECTION);
+        crsfWriteString(dst, value->name);
+        // options that don't fit are left out, leaving room for the fields after them
+        uint8_t optionCount = 0;
+        while (optionCount < table->valueCount && (int)strlen(table->values[optionCount]) + 8 < sbufBytesRemaining(dst)) {
+            if (optionCount > 0) {
+                sbufWriteU8(dst, ';');
+            }
+            sbufWriteString(dst, table->values[optionCount++]);
+        }
+        sbufWriteU8(dst, '\0');
+        sbufWriteU8(dst, current);
+        sbufWriteU8(dst, 0);
+        sbufWriteU8(dst, optionCount - 1);
+        sbufWriteU8(dst, current);
+    } else {
+        static const uint8_t crsfParameterTypes[] = {
+            [VAR_UINT8] = CRSF_PARAMETER_UINT8,
+            [VAR_INT8] = CRSF_PARAMETER_INT8,
+            [VAR_UINT16] = CRSF_PARAMETER_UINT16,
+            [VAR_INT16] = CRSF_PARAMETER_INT16,
+        };
+        sbufWriteU8(dst, crsfParameterTypes[value->type & VALUE_TYPE_MASK]);
+        crsfWriteString(dst, value->name);
+        crsfWriteParameterNumber(dst, value, current);
+        crsfWriteParameterNumber(dst, value, value->config.minmax.min);
+        crsfWriteParameterNumber(dst, value, value->config.minmax.max);
+        crsfWriteParameterNumber(dst, value, current);
+    }
+    crsfWriteString(dst, "");
+}
+
+// Writes the whole entry of a parameter, returns its length, 0 if there is no such parameter
+static int crsfWriteParameterEntry(uint8_t *entry, uint8_t number)
+{
+    sbuf_t entryBuf = { .ptr = entry, .end = entry + CRSF_PARAMETER_ENTRY_SIZE_MAX };
+    sbuf_t *dst = &entryBuf;
+
+    if (number == CRSF_PARAMETER_FOLDER_ROOT) {
+        // parent, type, name and the children, terminated by 0xFF
+        sbufWriteU8(dst, CRSF_PARAMETER_FOLDER_ROOT);
+        sbufWriteU8(dst, CRSF_PARAMETER_FOLDER);
+        crsfWriteString(dst, FC_FIRMWARE_NAME);
+        for (int child = 1; child <= CRSF_PARAMETER_SAVE; ++child) {
+            sbufWriteU8(dst, child);
+        }
+        sbufWriteU8(dst, 0xFF);
+    } else if (number <= crsfParameterCount) {
+        crsfWriteValueEntry(dst, crsfParameters[number - 1]);
+    } else if (number == CRSF_PARAMETER_SAVE) {
+        // parent, type, name, status, timeout and info
+        sbufWriteU8(dst, CRSF_PARAMETER_FOLDER_ROOT);
+        sbufWriteU8(dst, CRSF_PARAMETER_COMMAND);
+        crsfWriteString(dst, "Save");
+        sbufWriteU8(dst, CRSF_COMMAND_READY);
+        sbufWriteU8(dst, CRSF_PARAMETER_COMMAND_TIMEOUT);
+        crsfWriteString(dst, crsfConfigSaved ? "Saved" : "");
+    } else {
+        return 0;
+    }
+    return sbufPtr(dst) - entry;
+}
+
+static void crsfInitializeReply(sbuf_t *dst, uint8_t *frame, uint8_t type, uint8_t destination)
+{
+    dst->ptr = frame;
+    dst->end = frame + CRSF_FRAME_SIZE_MAX;
+    sbufWriteU8(dst, CRSF_ADDRESS_BROADCAST);
+    sbufWriteU8(dst, 0);    // frame length, filled in by crsfFinalizeReply()
+    sbufWriteU8(dst, type);
+    sbufWriteU8(dst, destination);
+    sbufWriteU8(dst, CRSF_ADDRESS_FLIGHT_CONTROLLER);
+}
+
+static void crsfFinalizeReply(sbuf_t *dst, uint8_t *frame)
+{
+    // frame length includes type, payload and CRC, the CRC covers type and payload
+    frame[1] = sbufPtr(dst) - &frame[2] + CRSF_FRAME_LENGTH_CRC;
+    sbufWriteU8(dst, crc8_dvb_s2_update(0, &frame[2], sbufPtr(dst) - &frame[2]));
+    crsfRxWriteTelemetryData(frame, sbufPtr(dst) - frame);
+}
+
+/*
+0x29 Device info
+Payload:
+uint8_t     Destination, origin
+char[]      Device name ( null terminated )
+uint32_t    Serial number, hardware id, software version
+uint8_t     Number of parameters, parameter protocol version
+*/
+static void crsfSendDeviceInfo(uint8_t destination)
+{
+    uint8_t frame[CRSF_FRAME_SIZE_MAX];
+    sbuf_t frameBuf;
+    sbuf_t *dst = &frameBuf;
+
+    crsfInitializeReply(dst, frame, CRSF_FRAMETYPE_DEVICE_INFO, destination);
+    crsfWriteString(dst, FC_FIRMWARE_NAME);
+    sbufWriteU32BigEndian(dst, 0);
+    sbufWriteU32BigEndian(dst, 0);
+    sbufWriteU32BigEndian(dst, (FC_VERSION_MAJOR << 16) | (FC_VERSION_MINOR << 8) | FC_VERSION_PATCH_LEVEL);
+    sbufWriteU8(dst, CRSF_PARAMETER_SAVE);     // parameters after the root folder
+    sbufWriteU8(dst, CRSF_PARAMETER_PROTOCOL_VERSION);
+    crsfFinalizeReply(dst, frame);
+}
+
+/*
+0x2B Parameter settings entry
+Payload:
+uint8_t     Destination, origin
+uint8_t     Parameter number
+uint8_t     Chunks remaining
+uint8_t[]   Chunk of the entry
+*/
+static void crsfSendParameterEntry(uint8_t destination, uint8_t number, uint8_t chunk)
+{
+    static uint8_t entry[CRSF_PARAMETER_ENTRY_SIZE_MAX];
+    const int entryLength = crsfWriteParameterEntry(entry, number);
+    const int chunkCount = (entryLength + CRSF_PARAMETER_CHUNK_SIZE - 1) / CRSF_PARAMETER_CHUNK_SIZE;
+    if (chunk >= chunkCount) {
+        return;
+    }
+    const int chunkOffset = chunk * CRSF_PARAMETER_CHUNK_SIZE;
+
+    uint8_t frame[CRSF_FRAME_SIZE_MAX];
+    sbuf_t frameBuf;
+    sbuf_t *dst = &frameBuf;
+
+    crsfInitializeReply(dst, frame, CRSF_FRAMETYPE_PARAMETER_SETTINGS_ENTRY, destination);
+    sbufWriteU8(dst, number);
+    sbufWriteU8(dst, chunkCount - chunk - 1);
+    sbufWriteData(dst, entry + chunkOffset, MIN(CRSF_PARAMETER_CHUNK_SIZE, entryLength - chunkOffset));
+    crsfFinalizeReply(dst, frame);
+}
+
+/*
+0x2D Parameter write
+Payload:
+uint8_t     Destination, origin
+uint8_t     Parameter number
+uint8_t[]   Value ( 1 or 2 bytes, big endian ), the command status for a command
+*/
+static void crsfWriteParameter(const uint8_t *payload, int payloadLength)
+{
+    const uint8_t number = payload[2];
+    const uint8_t *data = &payload[3];
+    const int dataLength = payloadLength - 3;
+
+    if (ARMING_FLAG(ARMED) || dataLength < 1) {
+        return;
+    }
+    if (number >= 1 && number <= crsfParameterCount) {
+        const clivalue_t *value = crsfParameters[number - 1];
+        int32_t newValue;
+        if (crsfParameterIs16Bit(value)) {
+            if (dataLength < 2) {
+                return;
+            }
+            newValue = (data[0] << 8) | data[1];
+            if ((value->type & VALUE_TYPE_MASK) == VAR_INT16) {
+                newValue = (int16_t)newValue;
+            }
+        } else {
+            newValue = ((value->type & VALUE_TYPE_MASK) == VAR_INT8) ? (int8_t)data[0] : data[0];
+        }
+
+        if (settingSetValue(value, newValue)) {
+            crsfConfigSaved = false;
+        }
+    } else if (number == CRSF_PARAMETER_SAVE && data[0] == CRSF_COMMAND_START) {
+        saveConfigAndNotifyAsync();
+        crsfConfigSaved = true;
+    }
+}
+
+// Answers the last parameter request, returns true if a reply has been written to the telemetry buffer
+bool crsfParametersProcessRequest(void)
+{
+    const crsfFrame_t *request = crsfRxGetParameterRequest();
+    if (!request) {
+        return false;
+    }
+
+    const uint8_t *payload = request->frame.payload;
+    const int payloadLength = request->frame.frameLength - CRSF_FRAME_LENGTH_TYPE_CRC;
+    const uint8_t origin = payload[1];
+
+    switch (request->frame.type) {
+    case CRSF_FRAMETYPE_DEVICE_PING:
+        crsfSendDeviceInfo(origin);
+        break;
+    case CRSF_FRAMETYPE_PARAMETER_READ:
+        if (payloadLength >= 4) {
+            crsfSendParameterEntry(origin, payload[2], payload[3]);
+        }
+        break;
+    case CRSF_FRAMETYPE_PARAMETER_WRITE:
+        if (payloadLength >= 3) {
+            crsfWriteParameter(payload, payloadLength);
+            // the entry is sent back, so the script shows the value that was kept
+            crsfSendParameterEntry(origin, payload[2], 0);
+        }
+        break;
+    default:
+        break;
+    }
+    crsfRxClearParameterRequest();
+    return true;
+}
+#endif
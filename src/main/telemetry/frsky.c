@@ -62,6 +62,7 @@
 #include "rx/rx.h"
 
 #include "telemetry/telemetry.h"
+#include "telemetry/telemetry_snapshot.h"
 #include "telemetry/frsky.h"
 
 #ifdef USE_ESC_SENSOR
@@ -175,15 +176,15 @@ static void sendAccel(void)
 static void sendBaro(void)
 {
     sendDataHead(ID_ALTITUDE_BP);
-    serialize16(getEstimatedAltitude() / 100);
+    serialize16(telemetrySnapshot.altitude / 100);
     sendDataHead(ID_ALTITUDE_AP);
-    serialize16(ABS(getEstimatedAltitude() % 100));
+    serialize16(ABS(telemetrySnapshot.altitude % 100));
 }
 
 #ifdef GPS
 static void sendGpsAltitude(void)
 {
-    uint16_t altitude = gpsSol.llh.alt;
+    uint16_t altitude = telemetrySnapshot.gpsSol.llh.alt;
     //Send real GPS altitude only if it's reliable (there's a GPS fix)
     if (!STATE(GPS_FIX)) {
         altitude = 0;
@@ -230,9 +231,9 @@ static void sendTemperature1(void)
 #ifdef GPS
 static void sendSatalliteSignalQualityAsTemperature2(void)
 {
-    uint16_t satellite = gpsSol.numSat;
-    if (gpsSol.hdop > GPS_BAD_QUALITY && ( (cycleNum % 16 ) < 8)) {//Every 1s
-        satellite = constrain(gpsSol.hdop, 0, GPS_MAX_HDOP_VAL);
+    uint16_t satellite = telemetrySnapshot.gpsSol.numSat;
+    if (telemetrySnapshot.gpsSol.hdop > GPS_BAD_QUALITY && ( (cycleNum % 16 ) < 8)) {//Every 1s
+        satellite = constrain(telemetrySnapshot.gpsSol.hdop, 0, GPS_MAX_HDOP_VAL);
     }
     sendDataHead(ID_TEMPRATURE2);
 
@@ -254,9 +255,9 @@ static void sendSpeed(void)
     //Speed should be sent in knots (GPS speed is in cm/s)
     sendDataHead(ID_GPS_SPEED_BP);
     //convert to knots: 1cm/s = 0.0194384449 knots
-    serialize16(gpsSol.groundSpeed * 1944 / 100000);
+    serialize16(telemetrySnapshot.gpsSol.groundSpeed * 1944 / 100000);
     sendDataHead(ID_GPS_SPEED_AP);
-    serialize16((gpsSol.groundSpeed * 1944 / 100) % 100);
+    serialize16((telemetrySnapshot.gpsSol.groundSpeed * 1944 / 100) % 100);
 }
 #endif
 
@@ -342,8 +343,8 @@ static void sendGPSLatLong(void)
     if (STATE(GPS_FIX) || gpsFixOccured == 1) {
         // If we have ever had a fix, send the last known lat/long
         gpsFixOccured = 1;
-        coord[LAT] = gpsSol.llh.lat;
-        coord[LON] = gpsSol.llh.lon;
+        coord[LAT] = telemetrySnapshot.gpsSol.llh.lat;
+        coord[LON] = telemetrySnapshot.gpsSol.llh.lon;
         sendLatLong(coord);
     } else {
         // otherwise send fake lat/long in order to display compass value
@@ -359,7 +360,7 @@ static void sendGPSLatLong(void)
 static void sendVario(void)
 {
     sendDataHead(ID_VERT_SPEED);
-    serialize16(getEstimatedVario());
+    serialize16(telemetrySnapshot.vario);
 }
 
 /*
@@ -374,7 +375,7 @@ static void sendVoltage(void)
     uint32_t cellVoltage;
     uint16_t payload;
 
-    uint8_t cellCount = getBatteryCellCount();
+    uint8_t cellCount = telemetrySnapshot.batteryCellCount;
     /*
      * Format for Voltage Data for single cells is like this:
      *
@@ -386,7 +387,7 @@ static void sendVoltage(void)
      * The actual value sent for cell voltage has resolution of 0.002 volts
      * Since vbat has resolution of 0.1 volts it has to be multiplied by 50
      */
-    cellVoltage = ((uint32_t)getBatteryVoltage() * 100 + cellCount) / (cellCount * 2);
+    cellVoltage = ((uint32_t)telemetrySnapshot.vbat * 100 + cellCount) / (cellCount * 2);
 
     // Cell number is at bit 9-12
     payload = (currentCell << 4);
@@ -409,7 +410,7 @@ static void sendVoltage(void)
  */
 static void sendVoltageAmp(void)
 {
-    uint16_t batteryVoltage = getBatteryVoltage();
+    uint16_t batteryVoltage = telemetrySnapshot.vbat;
     if (telemetryConfig()->frsky_vfas_precision == FRSKY_VFAS_PRECISION_HIGH) {
         /*
          * Use new ID 0x39 to send voltage directly in 0.1 volts resolution
@@ -420,7 +421,7 @@ static void sendVoltageAmp(void)
         uint16_t voltage = (batteryVoltage * 110) / 21;
         uint16_t vfasVoltage;
         if (telemetryConfig()->report_cell_voltage) {
-            vfasVoltage = voltage / getBatteryCellCount();
+            vfasVoltage = voltage / telemetrySnapshot.batteryCellCount;
         } else {
             vfasVoltage = voltage;
         }
@@ -434,7 +435,7 @@ static void sendVoltageAmp(void)
 static void sendAmperage(void)
 {
     sendDataHead(ID_CURRENT);
-    serialize16((uint16_t)(getAmperage() / 10));
+    serialize16((uint16_t)(telemetrySnapshot.amperage / 10));
 }
 
 static void sendFuelLevel(void)
@@ -442,16 +443,16 @@ static void sendFuelLevel(void)
     sendDataHead(ID_FUEL_LEVEL);
 
     if (batteryConfig()->batteryCapacity > 0) {
-        serialize16((uint16_t)calculateBatteryPercentageRemaining());
+        serialize16((uint16_t)telemetrySnapshot.batteryRemaining);
     } else {
-        serialize16((uint16_t)constrain(getMAhDrawn(), 0, 0xFFFF));
+        serialize16((uint16_t)constrain(telemetrySnapshot.mAhDrawn, 0, 0xFFFF));
     }
 }
 
 static void sendHeading(void)
 {
     sendDataHead(ID_COURSE_BP);
-    serialize16(DECIDEGREES_TO_DEGREES(attitude.values.yaw));
+    serialize16(DECIDEGREES_TO_DEGREES(telemetrySnapshot.attitude.values.yaw));
     sendDataHead(ID_COURSE_AP);
     serialize16(0);
 }
@@ -542,7 +543,7 @@ void handleFrSkyTelemetry(void)
         sendTemperature1();
         sendThrottleOrBatterySizeAsRpm();
 
-        if (batteryConfig()->voltageMeterSource != VOLTAGE_METER_NONE && getBatteryCellCount() > 0) {
+        if (batteryConfig()->voltageMeterSource != VOLTAGE_METER_NONE && telemetrySnapshot.batteryCellCount > 0) {
             sendVoltage();
             sendVoltageAmp();
             sendAmperage();
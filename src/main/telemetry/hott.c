@@ -87,6 +87,7 @@
 #include "flight/altitude.h"
 
 #include "telemetry/telemetry.h"
+#include "telemetry/telemetry_snapshot.h"
 #include "telemetry/hott.h"
 
 //#define HOTT_DEBUG
@@ -101,6 +102,7 @@ static uint32_t lastMessagesPreparedAt = 0;
 static uint32_t lastHottAlarmSoundTime = 0;
 
 static bool hottIsSending = false;
+static bool hottPortTimesBytes = false;    // the port holds the gap between bytes itself, see hottSendResponse()
 
 static uint8_t *hottMsg = NULL;
 static uint8_t hottMsgRemainingBytesToSendCount;
@@ -185,32 +187,32 @@ void addGPSCoordinates(HOTT_GPS_MSG_t *hottGPSMessage, int32_t latitude, int32_t
 
 void hottPrepareGPSResponse(HOTT_GPS_MSG_t *hottGPSMessage)
 {
-    hottGPSMessage->gps_satelites = gpsSol.numSat;
+    hottGPSMessage->gps_satelites = telemetrySnapshot.gpsSol.numSat;
 
     if (!STATE(GPS_FIX)) {
         hottGPSMessage->gps_fix_char = GPS_FIX_CHAR_NONE;
         return;
     }
 
-    if (gpsSol.numSat >= 5) {
+    if (telemetrySnapshot.gpsSol.numSat >= 5) {
         hottGPSMessage->gps_fix_char = GPS_FIX_CHAR_3D;
     } else {
         hottGPSMessage->gps_fix_char = GPS_FIX_CHAR_2D;
     }
 
-    addGPSCoordinates(hottGPSMessage, gpsSol.llh.lat, gpsSol.llh.lon);
+    addGPSCoordinates(hottGPSMessage, telemetrySnapshot.gpsSol.llh.lat, telemetrySnapshot.gpsSol.llh.lon);
 
     // GPS Speed is returned in cm/s (from io/gps.c) and must be sent in km/h (Hott requirement)
-    const uint16_t speed = (gpsSol.groundSpeed * 36) / 1000;
+    const uint16_t speed = (telemetrySnapshot.gpsSol.groundSpeed * 36) / 1000;
     hottGPSMessage->gps_speed_L = speed & 0x00FF;
     hottGPSMessage->gps_speed_H = speed >> 8;
 
-    hottGPSMessage->home_distance_L = GPS_distanceToHome & 0x00FF;
-    hottGPSMessage->home_distance_H = GPS_distanceToHome >> 8;
+    hottGPSMessage->home_distance_L = telemetrySnapshot.distanceToHome & 0x00FF;
+    hottGPSMessage->home_distance_H = telemetrySnapshot.distanceToHome >> 8;
 
-    uint16_t altitude = gpsSol.llh.alt;
+    uint16_t altitude = telemetrySnapshot.gpsSol.llh.alt;
     if (!STATE(GPS_FIX)) {
-        altitude = getEstimatedAltitude() / 100;
+        altitude = telemetrySnapshot.altitude / 100;
     }
 
     const uint16_t hottGpsAltitude = (altitude) + HOTT_GPS_ALTITUDE_OFFSET; // gpsSol.llh.alt in m ; offset = 500 -> O m
@@ -218,7 +220,7 @@ void hottPrepareGPSResponse(HOTT_GPS_MSG_t *hottGPSMessage)
     hottGPSMessage->altitude_L = hottGpsAltitude & 0x00FF;
     hottGPSMessage->altitude_H = hottGpsAltitude >> 8;
 
-    hottGPSMessage->home_direction = GPS_directionToHome;
+    hottGPSMessage->home_direction = telemetrySnapshot.directionToHome;
 }
 #endif
 
@@ -233,7 +235,7 @@ static inline void updateAlarmBatteryStatus(HOTT_EAM_MSG_t *hottEAMMessage)
 
     if (shouldTriggerBatteryAlarmNow()) {
         lastHottAlarmSoundTime = millis();
-        batteryState = getBatteryState();
+        batteryState = telemetrySnapshot.batteryState;
         if (batteryState == BATTERY_WARNING  || batteryState == BATTERY_CRITICAL) {
             hottEAMMessage->warning_beeps = 0x10;
             hottEAMMessage->alarm_invers1 = HOTT_EAM_ALARM1_FLAG_BATTERY_1;
@@ -247,31 +249,31 @@ static inline void updateAlarmBatteryStatus(HOTT_EAM_MSG_t *hottEAMMessage)
 
 static inline void hottEAMUpdateBattery(HOTT_EAM_MSG_t *hottEAMMessage)
 {
-    hottEAMMessage->main_voltage_L = getBatteryVoltage() & 0xFF;
-    hottEAMMessage->main_voltage_H = getBatteryVoltage() >> 8;
-    hottEAMMessage->batt1_voltage_L = getBatteryVoltage() & 0xFF;
-    hottEAMMessage->batt1_voltage_H = getBatteryVoltage() >> 8;
+    hottEAMMessage->main_voltage_L = telemetrySnapshot.vbat & 0xFF;
+    hottEAMMessage->main_voltage_H = telemetrySnapshot.vbat >> 8;
+    hottEAMMessage->batt1_voltage_L = telemetrySnapshot.vbat & 0xFF;
+    hottEAMMessage->batt1_voltage_H = telemetrySnapshot.vbat >> 8;
 
     updateAlarmBatteryStatus(hottEAMMessage);
 }
 
 static inline void hottEAMUpdateCurrentMeter(HOTT_EAM_MSG_t *hottEAMMessage)
 {
-    int32_t amp = getAmperage() / 10;
+    int32_t amp = telemetrySnapshot.amperage / 10;
     hottEAMMessage->current_L = amp & 0xFF;
     hottEAMMessage->current_H = amp >> 8;
 }
 
 static inline void hottEAMUpdateBatteryDrawnCapacity(HOTT_EAM_MSG_t *hottEAMMessage)
 {
-    int32_t mAh = getMAhDrawn() / 10;
+    int32_t mAh = telemetrySnapshot.mAhDrawn / 10;
     hottEAMMessage->batt_cap_L = mAh & 0xFF;
     hottEAMMessage->batt_cap_H = mAh >> 8;
 }
 
 static inline void hottEAMUpdateAltitude(HOTT_EAM_MSG_t *hottEAMMessage)
 {
-    const uint16_t hottEamAltitude = (getEstimatedAltitude() / 100) + HOTT_EAM_OFFSET_HEIGHT;
+    const uint16_t hottEamAltitude = (telemetrySnapshot.altitude / 100) + HOTT_EAM_OFFSET_HEIGHT;
 
     hottEAMMessage->altitude_L = hottEamAltitude & 0x00FF;
     hottEAMMessage->altitude_H = hottEamAltitude >> 8;
@@ -279,7 +281,7 @@ static inline void hottEAMUpdateAltitude(HOTT_EAM_MSG_t *hottEAMMessage)
 
 static inline void hottEAMUpdateClimbrate(HOTT_EAM_MSG_t *hottEAMMessage)
 {
-    int32_t vario = getEstimatedVario();
+    int32_t vario = telemetrySnapshot.vario;
     hottEAMMessage->climbrate_L = (30000 + vario) & 0x00FF;
     hottEAMMessage->climbrate_H = (30000 + vario) >> 8;
     hottEAMMessage->climbrate3s = 120 + (vario / 100);
@@ -396,15 +398,34 @@ void configureHoTTTelemetryPort(void)
 
     hottConfigurePortForRX();
 
+    hottPortTimesBytes = serialSetTxByteGap(hottPort, HOTT_TX_DELAY_US);
+
     hottTelemetryEnabled = true;
 }
 
+/*
+ * When the port's own bit timer keeps the gap between bytes, the whole response and its CRC
+ * are queued at once and the task only turns the port around when it has gone out.
+ * Otherwise the task writes one byte every HOTT_TX_DELAY_US.
+ */
 static void hottSendResponse(uint8_t *buffer, int length)
 {
     if (hottIsSending) {
         return;
     }
 
+    if (hottPortTimesBytes) {
+        uint8_t crc = 0;
+        for (int i = 0; i < length; i++) {
+            crc += buffer[i];
+        }
+        hottIsSending = true;
+        hottConfigurePortForTX();
+        serialWriteBuf(hottPort, buffer, length);
+        serialWrite(hottPort, crc);
+        return;
+    }
+
     hottMsg = buffer;
     hottMsgRemainingBytesToSendCount = length + HOTT_CRC_SIZE;
 }
@@ -568,6 +589,14 @@ void handleHoTTTelemetry(timeUs_t currentTimeUs)
         hottCheckSerialData(currentTimeUs);
     }
 
+    if (hottPortTimesBytes) {
+        if (hottIsSending && isSerialTransmitBufferEmpty(hottPort)) {
+            hottIsSending = false;
+            hottConfigurePortForRX();
+        }
+        return;
+    }
+
     if (!hottMsg)
         return;
 
@@ -31,6 +31,7 @@
 #include "platform.h"
 //#include "common/utils.h"
 #include "telemetry/telemetry.h"
+#include "telemetry/telemetry_snapshot.h"
 #include "telemetry/ibus_shared.h"
 
 static uint16_t calculateChecksum(const uint8_t *ibusPacket, size_t packetLength);
@@ -125,10 +126,7 @@ static uint8_t dispatchMeasurementReply(ibusAddress_t address)
 
     switch (sensorAddressTypeLookup[address - ibusBaseAddress]) {
     case IBUS_SENSOR_TYPE_EXTERNAL_VOLTAGE:
-        value = getBatteryVoltage() * 10;
-        if (telemetryConfig()->report_cell_voltage) {
-            value /= getBatteryCellCount();
-        }
+        value = telemetryConfig()->report_cell_voltage ? telemetrySnapshot.vbatCell : telemetrySnapshot.vbat * 10;
         return sendIbusMeasurement(address, value);
 
     case IBUS_SENSOR_TYPE_TEMPERATURE:
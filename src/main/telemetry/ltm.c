@@ -73,6 +73,7 @@
 #include "flight/navigation.h"
 
 #include "telemetry/telemetry.h"
+#include "telemetry/telemetry_snapshot.h"
 #include "telemetry/ltm.h"
 
 
@@ -83,39 +84,55 @@ static serialPort_t *ltmPort;
 static serialPortConfig_t *portConfig;
 static bool ltmEnabled;
 static portSharing_e ltmPortSharing;
-static uint8_t ltm_crc;
 
-static void ltm_initialise_packet(uint8_t ltm_id)
-{
-    ltm_crc = 0;
-    serialWrite(ltmPort, '$');
-    serialWrite(ltmPort, 'T');
-    serialWrite(ltmPort, ltm_id);
-}
+/*
+ * Each frame is kept encoded between sends, a byte is only rewritten when its value changed.
+ * The LTM checksum is the XOR of the payload, so a change is folded into it with the old and
+ * new byte instead of running over the frame again, and the frame goes out in one write.
+ */
+#define LTM_HEADER_SIZE         3
+#define LTM_MAX_PAYLOAD_SIZE    14
+
+typedef struct ltmFrame_s {
+    uint8_t payloadSize;
+    uint8_t buffer[LTM_HEADER_SIZE + LTM_MAX_PAYLOAD_SIZE + 1];     // header, payload, checksum
+} ltmFrame_t;
 
-static void ltm_serialise_8(uint8_t v)
+#define LTM_FRAME(id, size) { .payloadSize = (size), .buffer = { '$', 'T', (id) } }
+
+#if defined(GPS)
+static ltmFrame_t ltmGFrame = LTM_FRAME('G', 14);
+#endif
+static ltmFrame_t ltmSFrame = LTM_FRAME('S', 7);
+static ltmFrame_t ltmAFrame = LTM_FRAME('A', 6);
+static ltmFrame_t ltmOFrame = LTM_FRAME('O', 14);
+
+static void ltm_serialise_8(ltmFrame_t *frame, uint8_t offset, uint8_t v)
 {
-    serialWrite(ltmPort, v);
-    ltm_crc ^= v;
+    uint8_t *byte = &frame->buffer[LTM_HEADER_SIZE + offset];
+    if (*byte != v) {
+        frame->buffer[LTM_HEADER_SIZE + frame->payloadSize] ^= *byte ^ v;
+        *byte = v;
+    }
 }
 
-static void ltm_serialise_16(uint16_t v)
+static void ltm_serialise_16(ltmFrame_t *frame, uint8_t offset, uint16_t v)
 {
-    ltm_serialise_8((uint8_t)v);
-    ltm_serialise_8((v >> 8));
+    ltm_serialise_8(frame, offset, (uint8_t)v);
+    ltm_serialise_8(frame, offset + 1, (v >> 8));
 }
 
-static void ltm_serialise_32(uint32_t v)
+static void ltm_serialise_32(ltmFrame_t *frame, uint8_t offset, uint32_t v)
 {
-    ltm_serialise_8((uint8_t)v);
-    ltm_serialise_8((v >> 8));
-    ltm_serialise_8((v >> 16));
-    ltm_serialise_8((v >> 24));
+    ltm_serialise_8(frame, offset, (uint8_t)v);
+    ltm_serialise_8(frame, offset + 1, (v >> 8));
+    ltm_serialise_8(frame, offset + 2, (v >> 16));
+    ltm_serialise_8(frame, offset + 3, (v >> 24));
 }
 
-static void ltm_finalise(void)
+static void ltm_send(const ltmFrame_t *frame)
 {
-    serialWrite(ltmPort, ltm_crc);
+    serialWriteBuf(ltmPort, frame->buffer, LTM_HEADER_SIZE + frame->payloadSize + 1);
 }
 
 /*
@@ -133,24 +150,23 @@ static void ltm_gframe(void)
 
     if (!STATE(GPS_FIX))
         gps_fix_type = 1;
-    else if (gpsSol.numSat < 5)
+    else if (telemetrySnapshot.gpsSol.numSat < 5)
         gps_fix_type = 2;
     else
         gps_fix_type = 3;
 
-    ltm_initialise_packet('G');
-    ltm_serialise_32(gpsSol.llh.lat);
-    ltm_serialise_32(gpsSol.llh.lon);
-    ltm_serialise_8((uint8_t)(gpsSol.groundSpeed / 100));
+    ltm_serialise_32(&ltmGFrame, 0, telemetrySnapshot.gpsSol.llh.lat);
+    ltm_serialise_32(&ltmGFrame, 4, telemetrySnapshot.gpsSol.llh.lon);
+    ltm_serialise_8(&ltmGFrame, 8, (uint8_t)(telemetrySnapshot.gpsSol.groundSpeed / 100));
 
 #if defined(BARO) || defined(SONAR)
-    ltm_alt = (sensors(SENSOR_SONAR) || sensors(SENSOR_BARO)) ? getEstimatedAltitude() : gpsSol.llh.alt * 100;
+    ltm_alt = (sensors(SENSOR_SONAR) || sensors(SENSOR_BARO)) ? telemetrySnapshot.altitude : telemetrySnapshot.gpsSol.llh.alt * 100;
 #else
-    ltm_alt = gpsSol.llh.alt * 100;
+    ltm_alt = telemetrySnapshot.gpsSol.llh.alt * 100;
 #endif
-    ltm_serialise_32(ltm_alt);
-    ltm_serialise_8((gpsSol.numSat << 2) | gps_fix_type);
-    ltm_finalise();
+    ltm_serialise_32(&ltmGFrame, 9, ltm_alt);
+    ltm_serialise_8(&ltmGFrame, 13, (telemetrySnapshot.gpsSol.numSat << 2) | gps_fix_type);
+    ltm_send(&ltmGFrame);
 #endif
 }
 
@@ -189,13 +205,12 @@ static void ltm_sframe(void)
     lt_statemode = (ARMING_FLAG(ARMED)) ? 1 : 0;
     if (failsafeIsActive())
         lt_statemode |= 2;
-    ltm_initialise_packet('S');
-    ltm_serialise_16(getBatteryVoltage() * 100);    //vbat converted to mv
-    ltm_serialise_16(0);             //  current, not implemented
-    ltm_serialise_8((uint8_t)((rssi * 254) / 1023));        // scaled RSSI (uchar)
-    ltm_serialise_8(0);              // no airspeed
-    ltm_serialise_8((lt_flightmode << 2) | lt_statemode);
-    ltm_finalise();
+    ltm_serialise_16(&ltmSFrame, 0, telemetrySnapshot.vbat * 100);    //vbat converted to mv
+    ltm_serialise_16(&ltmSFrame, 2, 0);             //  current, not implemented
+    ltm_serialise_8(&ltmSFrame, 4, (uint8_t)((telemetrySnapshot.rssi * 254) / 1023));        // scaled RSSI (uchar)
+    ltm_serialise_8(&ltmSFrame, 5, 0);              // no airspeed
+    ltm_serialise_8(&ltmSFrame, 6, (lt_flightmode << 2) | lt_statemode);
+    ltm_send(&ltmSFrame);
 }
 
 /*
@@ -204,11 +219,10 @@ static void ltm_sframe(void)
  */
 static void ltm_aframe()
 {
-    ltm_initialise_packet('A');
-    ltm_serialise_16(DECIDEGREES_TO_DEGREES(attitude.values.pitch));
-    ltm_serialise_16(DECIDEGREES_TO_DEGREES(attitude.values.roll));
-    ltm_serialise_16(DECIDEGREES_TO_DEGREES(attitude.values.yaw));
-    ltm_finalise();
+    ltm_serialise_16(&ltmAFrame, 0, DECIDEGREES_TO_DEGREES(telemetrySnapshot.attitude.values.pitch));
+    ltm_serialise_16(&ltmAFrame, 2, DECIDEGREES_TO_DEGREES(telemetrySnapshot.attitude.values.roll));
+    ltm_serialise_16(&ltmAFrame, 4, DECIDEGREES_TO_DEGREES(telemetrySnapshot.attitude.values.yaw));
+    ltm_send(&ltmAFrame);
 }
 
 /*
@@ -218,18 +232,17 @@ static void ltm_aframe()
  */
 static void ltm_oframe()
 {
-    ltm_initialise_packet('O');
 #if defined(GPS)
-    ltm_serialise_32(GPS_home[LAT]);
-    ltm_serialise_32(GPS_home[LON]);
+    ltm_serialise_32(&ltmOFrame, 0, GPS_home[LAT]);
+    ltm_serialise_32(&ltmOFrame, 4, GPS_home[LON]);
 #else
-    ltm_serialise_32(0);
-    ltm_serialise_32(0);
+    ltm_serialise_32(&ltmOFrame, 0, 0);
+    ltm_serialise_32(&ltmOFrame, 4, 0);
 #endif
-    ltm_serialise_32(0);                // Don't have GPS home altitude
-    ltm_serialise_8(1);                 // OSD always ON
-    ltm_serialise_8(STATE(GPS_FIX_HOME) ? 1 : 0);
-    ltm_finalise();
+    ltm_serialise_32(&ltmOFrame, 8, 0);                // Don't have GPS home altitude
+    ltm_serialise_8(&ltmOFrame, 12, 1);                 // OSD always ON
+    ltm_serialise_8(&ltmOFrame, 13, STATE(GPS_FIX_HOME) ? 1 : 0);
+    ltm_send(&ltmOFrame);
 }
 
 static void process_ltm(void)
@@ -43,6 +43,7 @@
 #include "fc/config.h"
 #include "fc/rc_controls.h"
 #include "fc/runtime_config.h"
+#include "fc/settings.h"
 
 #include "flight/mixer.h"
 #include "flight/pid.h"
@@ -58,6 +59,7 @@
 #include "io/motors.h"
 
 #include "rx/rx.h"
+#include "rx/msp.h"
 
 #include "sensors/sensors.h"
 #include "sensors/acceleration.h"
@@ -67,6 +69,7 @@
 #include "sensors/battery.h"
 
 #include "telemetry/telemetry.h"
+#include "telemetry/telemetry_snapshot.h"
 #include "telemetry/mavlink.h"
 
 // mavlink library uses unnames unions that's causes GCC to complain if -Wpedantic is used
@@ -76,11 +79,13 @@
 #include "common/mavlink.h"
 #pragma GCC diagnostic pop
 
-#define TELEMETRY_MAVLINK_INITIAL_PORT_MODE MODE_TX
-#define TELEMETRY_MAVLINK_MAXRATE 50
+#define TELEMETRY_MAVLINK_INITIAL_PORT_MODE MODE_RXTX
+#define TELEMETRY_MAVLINK_MAXRATE 100
 #define TELEMETRY_MAVLINK_DELAY ((1000 * 1000) / TELEMETRY_MAVLINK_MAXRATE)
+#define TELEMETRY_MAVLINK_FAST_BAUDRATE 460800  // links at least this fast get the companion computer stream rates
+#define TELEMETRY_MAVLINK_TX_BUFFER_SIZE 256    // one tick of messages, all streams due at once fit
+#define TELEMETRY_MAVLINK_RX_BYTES_MAX 128      // parsed per tick, the rest waits in the port's buffer
 
-extern uint16_t rssi; // FIXME dependency on mw.c
 
 static serialPort_t *mavlinkPort = NULL;
 static serialPortConfig_t *portConfig;
@@ -97,16 +102,41 @@ static const uint8_t mavRates[] = {
     [MAV_DATA_STREAM_EXTRA2] = 10 //2Hz
 };
 
+/* Datastream rates in Hz for fast links to a companion computer */
+static const uint8_t mavRatesFast[] = {
+    [MAV_DATA_STREAM_EXTENDED_STATUS] = 5, //5Hz
+    [MAV_DATA_STREAM_RC_CHANNELS] = 50, //50Hz
+    [MAV_DATA_STREAM_POSITION] = 10, //10Hz
+    [MAV_DATA_STREAM_EXTRA1] = 100, //100Hz
+    [MAV_DATA_STREAM_EXTRA2] = 10 //10Hz
+};
+
 #define MAXSTREAMS (sizeof(mavRates) / sizeof(mavRates[0]))
 
+static const uint8_t *mavStreamRates = mavRates;
 static uint8_t mavTicks[MAXSTREAMS];
 static mavlink_message_t mavMsg;
-static uint8_t mavBuffer[MAVLINK_MAX_PACKET_LEN];
 static uint32_t lastMavlinkMessage = 0;
 
+// All messages of a tick are packed into one write, in place in the port's transmit buffer when it allows it
+static uint8_t mavTxBuffer[TELEMETRY_MAVLINK_TX_BUFFER_SIZE];
+static uint8_t *mavTxStart;
+static uint8_t *mavTxPtr;
+static uint8_t *mavTxEnd;
+
+// Parameter protocol state, the settings are sent a few per tick as the link has room for them
+#define MAVLINK_PARAM_NONE (-1)
+static int16_t mavParamCount;
+static int16_t mavParamListIndex = MAVLINK_PARAM_NONE;  // next valueTable entry of a list request
+static int16_t mavParamListNumber;                      // its parameter index
+static int16_t mavParamReadIndex = MAVLINK_PARAM_NONE;  // valueTable entry to send once
+static bool mavCommandAckPending;
+static uint16_t mavCommandAckCommand;
+static uint8_t mavCommandAckResult;
+
 static int mavlinkStreamTrigger(enum MAV_DATA_STREAM streamNum)
 {
-    uint8_t rate = (uint8_t) mavRates[streamNum];
+    uint8_t rate = mavStreamRates[streamNum];
     if (rate == 0) {
         return 0;
     }
@@ -127,10 +157,237 @@ static int mavlinkStreamTrigger(enum MAV_DATA_STREAM streamNum)
 }
 
 
-static void mavlinkSerialWrite(uint8_t * buf, uint16_t length)
+static void mavlinkBeginWrite(void)
+{
+    uint8_t *txBuf;
+    const uint32_t txSpace = serialReserveWrite(mavlinkPort, &txBuf);
+    if (txSpace >= TELEMETRY_MAVLINK_TX_BUFFER_SIZE) {
+        mavTxStart = txBuf;
+        mavTxEnd = txBuf + txSpace;
+    } else {
+        mavTxStart = mavTxBuffer;
+        mavTxEnd = mavTxBuffer + MIN(sizeof(mavTxBuffer), serialTxBytesFree(mavlinkPort));
+    }
+    mavTxPtr = mavTxStart;
+}
+
+// Appends mavMsg to the tick's write, returns false if it doesn't fit. The link is never waited for.
+static bool mavlinkSendMessage(void)
+{
+    if (mavTxEnd - mavTxPtr < MAVLINK_NUM_NON_PAYLOAD_BYTES + mavMsg.len) {
+        return false;
+    }
+    mavTxPtr += mavlink_msg_to_send_buffer(mavTxPtr, &mavMsg);
+    return true;
+}
+
+static void mavlinkEndWrite(void)
+{
+    const uint32_t length = mavTxPtr - mavTxStart;
+    if (length == 0) {
+        return;
+    }
+    if (mavTxStart == mavTxBuffer) {
+        serialWriteBuf(mavlinkPort, mavTxBuffer, length);
+    } else {
+        serialCommitWrite(mavlinkPort, length);
+    }
+}
+
+static bool mavlinkIsParam(const clivalue_t *value)
+{
+    return (value->type & VALUE_MODE_MASK) != MODE_ARRAY && strlen(value->name) <= MAVLINK_MSG_PARAM_VALUE_FIELD_PARAM_ID_LEN;
+}
+
+static int mavlinkFindParamById(const char *paramId)
+{
+    for (int i = 0; i < valueTableEntryCount; i++) {
+        if (mavlinkIsParam(&valueTable[i]) && strncmp(valueTable[i].name, paramId, MAVLINK_MSG_PARAM_VALUE_FIELD_PARAM_ID_LEN) == 0) {
+            return i;
+        }
+    }
+    return MAVLINK_PARAM_NONE;
+}
+
+// Converts between a parameter index and a valueTable entry, both ways
+static int mavlinkParamNumber(int valueIndex)
+{
+    int number = 0;
+    for (int i = 0; i < valueIndex; i++) {
+        if (mavlinkIsParam(&valueTable[i])) {
+            number++;
+        }
+    }
+    return number;
+}
+
+static int mavlinkFindParamByNumber(int number)
+{
+    for (int i = 0; i < valueTableEntryCount; i++) {
+        if (mavlinkIsParam(&valueTable[i]) && number-- == 0) {
+            return i;
+        }
+    }
+    return MAVLINK_PARAM_NONE;
+}
+
+static bool mavlinkSendParam(int valueIndex, int number)
 {
-    for (int i = 0; i < length; i++)
-        serialWrite(mavlinkPort, buf[i]);
+    static const uint8_t mavParamTypes[] = {
+        [VAR_UINT8] = MAV_PARAM_TYPE_UINT8,
+        [VAR_INT8] = MAV_PARAM_TYPE_INT8,
+        [VAR_UINT16] = MAV_PARAM_TYPE_UINT16,
+        [VAR_INT16] = MAV_PARAM_TYPE_INT16,
+    };
+    const clivalue_t *value = &valueTable[valueIndex];
+
+    mavlink_msg_param_value_pack(0, 200, &mavMsg,
+        // param_id Onboard parameter id, not terminated if it is 16 characters long
+        value->name,
+        // param_value Onboard parameter value
+        settingGetValue(value),
+        // param_type Onboard parameter type
+        mavParamTypes[value->type & VALUE_TYPE_MASK],
+        // param_count Total number of onboard parameters
+        mavParamCount,
+        // param_index Index of this onboard parameter
+        number);
+    return mavlinkSendMessage();
+}
+
+static void mavlinkSendParams(void)
+{
+    if (mavCommandAckPending) {
+        mavlink_msg_command_ack_pack(0, 200, &mavMsg, mavCommandAckCommand, mavCommandAckResult);
+        if (!mavlinkSendMessage()) {
+            return;
+        }
+        mavCommandAckPending = false;
+    }
+
+    if (mavParamReadIndex != MAVLINK_PARAM_NONE) {
+        if (!mavlinkSendParam(mavParamReadIndex, mavlinkParamNumber(mavParamReadIndex))) {
+            return;
+        }
+        mavParamReadIndex = MAVLINK_PARAM_NONE;
+    }
+
+    while (mavParamListIndex != MAVLINK_PARAM_NONE) {
+        if (mavParamListIndex >= valueTableEntryCount) {
+            mavParamListIndex = MAVLINK_PARAM_NONE;
+        } else if (!mavlinkIsParam(&valueTable[mavParamListIndex])) {
+            mavParamListIndex++;
+        } else if (mavlinkSendParam(mavParamListIndex, mavParamListNumber)) {
+            mavParamListIndex++;
+            mavParamListNumber++;
+        } else {
+            return;
+        }
+    }
+}
+
+static void mavlinkHandleRcOverride(const mavlink_message_t *msg)
+{
+    // the override takes the place of MSP_SET_RAW_RC, so it is only flown with the MSP receiver
+    static uint16_t mavOverrideFrame[8];
+
+    if (!feature(FEATURE_RX_MSP)) {
+        return;
+    }
+
+    mavlink_rc_channels_override_t rcOverride;
+    mavlink_msg_rc_channels_override_decode(msg, &rcOverride);
+    const uint16_t channels[] = {
+        rcOverride.chan1_raw, rcOverride.chan2_raw, rcOverride.chan3_raw, rcOverride.chan4_raw,
+        rcOverride.chan5_raw, rcOverride.chan6_raw, rcOverride.chan7_raw, rcOverride.chan8_raw,
+    };
+    for (unsigned i = 0; i < ARRAYLEN(mavOverrideFrame); i++) {
+        // 0 hands the channel back and UINT16_MAX leaves it alone, either way it keeps its last value here
+        if (channels[i] != 0 && channels[i] != UINT16_MAX) {
+            mavOverrideFrame[i] = channels[i];
+        }
+    }
+    rxMspFrameReceive(mavOverrideFrame, ARRAYLEN(mavOverrideFrame));
+}
+
+static void mavlinkHandleParamSet(const mavlink_message_t *msg)
+{
+    char paramId[MAVLINK_MSG_PARAM_SET_FIELD_PARAM_ID_LEN];
+    mavlink_msg_param_set_get_param_id(msg, paramId);
+    const int valueIndex = mavlinkFindParamById(paramId);
+    if (valueIndex == MAVLINK_PARAM_NONE) {
+        return;
+    }
+    if (!ARMING_FLAG(ARMED)) {
+        settingSetValue(&valueTable[valueIndex], lrintf(mavlink_msg_param_set_get_param_value(msg)));
+    }
+    // the value is sent back, so the sender sees the value that was kept
+    mavParamReadIndex = valueIndex;
+}
+
+static void mavlinkHandleCommand(const mavlink_message_t *msg)
+{
+    mavCommandAckCommand = mavlink_msg_command_long_get_command(msg);
+    if (mavCommandAckCommand == MAV_CMD_PREFLIGHT_STORAGE && mavlink_msg_command_long_get_param1(msg) == 1) {
+        if (ARMING_FLAG(ARMED)) {
+            mavCommandAckResult = MAV_RESULT_TEMPORARILY_REJECTED;
+        } else {
+            saveConfigAndNotifyAsync();
+            mavCommandAckResult = MAV_RESULT_ACCEPTED;
+        }
+    } else {
+        mavCommandAckResult = MAV_RESULT_UNSUPPORTED;
+    }
+    mavCommandAckPending = true;
+}
+
+static void mavlinkHandleMessage(const mavlink_message_t *msg)
+{
+    switch (msg->msgid) {
+    case MAVLINK_MSG_ID_RC_CHANNELS_OVERRIDE:
+        mavlinkHandleRcOverride(msg);
+        break;
+    case MAVLINK_MSG_ID_PARAM_REQUEST_LIST:
+        mavParamListIndex = 0;
+        mavParamListNumber = 0;
+        break;
+    case MAVLINK_MSG_ID_PARAM_REQUEST_READ: {
+        const int16_t number = mavlink_msg_param_request_read_get_param_index(msg);
+        if (number < 0) {
+            char paramId[MAVLINK_MSG_PARAM_REQUEST_READ_FIELD_PARAM_ID_LEN];
+            mavlink_msg_param_request_read_get_param_id(msg, paramId);
+            mavParamReadIndex = mavlinkFindParamById(paramId);
+        } else {
+            mavParamReadIndex = mavlinkFindParamByNumber(number);
+        }
+        break;
+    }
+    case MAVLINK_MSG_ID_PARAM_SET:
+        mavlinkHandleParamSet(msg);
+        break;
+    case MAVLINK_MSG_ID_COMMAND_LONG:
+        mavlinkHandleCommand(msg);
+        break;
+    default:
+        break;
+    }
+}
+
+static void mavlinkReceive(void)
+{
+    static mavlink_message_t mavRxMsg;
+    static mavlink_status_t mavRxStatus;
+
+    // a port shared with the receiver is read by the receiver
+    if (mavlinkPort == telemetrySharedPort) {
+        return;
+    }
+
+    for (int count = TELEMETRY_MAVLINK_RX_BYTES_MAX; count > 0 && serialRxBytesWaiting(mavlinkPort) > 0; count--) {
+        if (mavlink_parse_char(MAVLINK_COMM_0, serialRead(mavlinkPort), &mavRxMsg, &mavRxStatus)) {
+            mavlinkHandleMessage(&mavRxMsg);
+        }
+    }
 }
 
 void freeMAVLinkTelemetryPort(void)
@@ -144,6 +401,8 @@ void initMAVLinkTelemetry(void)
 {
     portConfig = findSerialPortConfig(FUNCTION_TELEMETRY_MAVLINK);
     mavlinkPortSharing = determinePortSharing(portConfig, FUNCTION_TELEMETRY_MAVLINK);
+
+    mavParamCount = mavlinkParamNumber(valueTableEntryCount);
 }
 
 void configureMAVLinkTelemetryPort(void)
@@ -164,6 +423,8 @@ void configureMAVLinkTelemetryPort(void)
         return;
     }
 
+    mavStreamRates = baudRates[baudRateIndex] >= TELEMETRY_MAVLINK_FAST_BAUDRATE ? mavRatesFast : mavRates;
+
     mavlinkTelemetryEnabled = true;
 }
 
@@ -190,8 +451,6 @@ void checkMAVLinkTelemetryState(void)
 
 void mavlinkSendSystemStatus(void)
 {
-    uint16_t msgLength;
-
     uint32_t onboardControlAndSensors = 35843;
 
     /*
@@ -222,11 +481,11 @@ void mavlinkSendSystemStatus(void)
         // load Maximum usage in percent of the mainloop time, (0%: 0, 100%: 1000) should be always below 1000
         0,
         // voltage_battery Battery voltage, in millivolts (1 = 1 millivolt)
-        (batteryConfig()->voltageMeterSource != VOLTAGE_METER_NONE) ? getBatteryVoltage() * 100 : 0,
+        (batteryConfig()->voltageMeterSource != VOLTAGE_METER_NONE) ? telemetrySnapshot.vbat * 100 : 0,
         // current_battery Battery current, in 10*milliamperes (1 = 10 milliampere), -1: autopilot does not measure the current
-        (batteryConfig()->currentMeterSource != CURRENT_METER_NONE) ? getAmperage() : -1,
+        (batteryConfig()->currentMeterSource != CURRENT_METER_NONE) ? telemetrySnapshot.amperage : -1,
         // battery_remaining Remaining battery energy: (0%: 0, 100%: 100), -1: autopilot estimate the remaining battery
-        (batteryConfig()->voltageMeterSource != VOLTAGE_METER_NONE) ? calculateBatteryPercentageRemaining() : 100,
+        (batteryConfig()->voltageMeterSource != VOLTAGE_METER_NONE) ? telemetrySnapshot.batteryRemaining : 100,
         // drop_rate_comm Communication drops in percent, (0%: 0, 100%: 10'000), (UART, I2C, SPI, CAN), dropped packets on all links (packets that were corrupted on reception on the MAV)
         0,
         // errors_comm Communication errors (UART, I2C, SPI, CAN), dropped packets on all links (packets that were corrupted on reception on the MAV)
@@ -239,13 +498,11 @@ void mavlinkSendSystemStatus(void)
         0,
         // errors_count4 Autopilot-specific errors
         0);
-    msgLength = mavlink_msg_to_send_buffer(mavBuffer, &mavMsg);
-    mavlinkSerialWrite(mavBuffer, msgLength);
+    mavlinkSendMessage();
 }
 
 void mavlinkSendRCChannelsAndRSSI(void)
 {
-    uint16_t msgLength;
     mavlink_msg_rc_channels_raw_pack(0, 200, &mavMsg,
         // time_boot_ms Timestamp (milliseconds since system boot)
         millis(),
@@ -268,15 +525,13 @@ void mavlinkSendRCChannelsAndRSSI(void)
         // chan8_raw RC channel 8 value, in microseconds
         (rxRuntimeConfig.channelCount >= 8) ? rcData[7] : 0,
         // rssi Receive signal strength indicator, 0: 0%, 255: 100%
-        scaleRange(rssi, 0, 1023, 0, 255));
-    msgLength = mavlink_msg_to_send_buffer(mavBuffer, &mavMsg);
-    mavlinkSerialWrite(mavBuffer, msgLength);
+        scaleRange(telemetrySnapshot.rssi, 0, 1023, 0, 255));
+    mavlinkSendMessage();
 }
 
 #if defined(GPS)
 void mavlinkSendPosition(void)
 {
-    uint16_t msgLength;
     uint8_t gpsFixType = 0;
 
     if (!sensors(SENSOR_GPS))
@@ -286,7 +541,7 @@ void mavlinkSendPosition(void)
         gpsFixType = 1;
     }
     else {
-        if (gpsSol.numSat < 5) {
+        if (telemetrySnapshot.gpsSol.numSat < 5) {
             gpsFixType = 2;
         }
         else {
@@ -300,39 +555,38 @@ void mavlinkSendPosition(void)
         // fix_type 0-1: no fix, 2: 2D fix, 3: 3D fix. Some applications will not use the value of this field unless it is at least two, so always correctly fill in the fix.
         gpsFixType,
         // lat Latitude in 1E7 degrees
-        gpsSol.llh.lat,
+        telemetrySnapshot.gpsSol.llh.lat,
         // lon Longitude in 1E7 degrees
-        gpsSol.llh.lon,
+        telemetrySnapshot.gpsSol.llh.lon,
         // alt Altitude in 1E3 meters (millimeters) above MSL
-        gpsSol.llh.alt * 1000,
+        telemetrySnapshot.gpsSol.llh.alt * 1000,
         // eph GPS HDOP horizontal dilution of position in cm (m*100). If unknown, set to: 65535
         65535,
         // epv GPS VDOP horizontal dilution of position in cm (m*100). If unknown, set to: 65535
         65535,
         // vel GPS ground speed (m/s * 100). If unknown, set to: 65535
-        gpsSol.groundSpeed,
+        telemetrySnapshot.gpsSol.groundSpeed,
         // cog Course over ground (NOT heading, but direction of movement) in degrees * 100, 0.0..359.99 degrees. If unknown, set to: 65535
-        gpsSol.groundCourse * 10,
+        telemetrySnapshot.gpsSol.groundCourse * 10,
         // satellites_visible Number of satellites visible. If unknown, set to 255
-        gpsSol.numSat);
-    msgLength = mavlink_msg_to_send_buffer(mavBuffer, &mavMsg);
-    mavlinkSerialWrite(mavBuffer, msgLength);
+        telemetrySnapshot.gpsSol.numSat);
+    mavlinkSendMessage();
 
     // Global position
     mavlink_msg_global_position_int_pack(0, 200, &mavMsg,
         // time_usec Timestamp (microseconds since UNIX epoch or microseconds since system boot)
         micros(),
         // lat Latitude in 1E7 degrees
-        gpsSol.llh.lat,
+        telemetrySnapshot.gpsSol.llh.lat,
         // lon Longitude in 1E7 degrees
-        gpsSol.llh.lon,
+        telemetrySnapshot.gpsSol.llh.lon,
         // alt Altitude in 1E3 meters (millimeters) above MSL
-        gpsSol.llh.alt * 1000,
+        telemetrySnapshot.gpsSol.llh.alt * 1000,
         // relative_alt Altitude above ground in meters, expressed as * 1000 (millimeters)
 #if defined(BARO) || defined(SONAR)
-        (sensors(SENSOR_SONAR) || sensors(SENSOR_BARO)) ? getEstimatedAltitude() * 10 : gpsSol.llh.alt * 1000,
+        (sensors(SENSOR_SONAR) || sensors(SENSOR_BARO)) ? telemetrySnapshot.altitude * 10 : telemetrySnapshot.gpsSol.llh.alt * 1000,
 #else
-        gpsSol.llh.alt * 1000,
+        telemetrySnapshot.gpsSol.llh.alt * 1000,
 #endif
         // Ground X Speed (Latitude), expressed as m/s * 100
         0,
@@ -341,10 +595,9 @@ void mavlinkSendPosition(void)
         // Ground Z Speed (Altitude), expressed as m/s * 100
         0,
         // heading Current heading in degrees, in compass units (0..360, 0=north)
-        DECIDEGREES_TO_DEGREES(attitude.values.yaw)
+        DECIDEGREES_TO_DEGREES(telemetrySnapshot.attitude.values.yaw)
     );
-    msgLength = mavlink_msg_to_send_buffer(mavBuffer, &mavMsg);
-    mavlinkSerialWrite(mavBuffer, msgLength);
+    mavlinkSendMessage();
 
     mavlink_msg_gps_global_origin_pack(0, 200, &mavMsg,
         // latitude Latitude (WGS84), expressed as * 1E7
@@ -353,36 +606,32 @@ void mavlinkSendPosition(void)
         GPS_home[LON],
         // altitude Altitude(WGS84), expressed as * 1000
         0);
-    msgLength = mavlink_msg_to_send_buffer(mavBuffer, &mavMsg);
-    mavlinkSerialWrite(mavBuffer, msgLength);
+    mavlinkSendMessage();
 }
 #endif
 
 void mavlinkSendAttitude(void)
 {
-    uint16_t msgLength;
     mavlink_msg_attitude_pack(0, 200, &mavMsg,
         // time_boot_ms Timestamp (milliseconds since system boot)
         millis(),
         // roll Roll angle (rad)
-        DECIDEGREES_TO_RADIANS(attitude.values.roll),
+        DECIDEGREES_TO_RADIANS(telemetrySnapshot.attitude.values.roll),
         // pitch Pitch angle (rad)
-        DECIDEGREES_TO_RADIANS(-attitude.values.pitch),
+        DECIDEGREES_TO_RADIANS(-telemetrySnapshot.attitude.values.pitch),
         // yaw Yaw angle (rad)
-        DECIDEGREES_TO_RADIANS(attitude.values.yaw),
+        DECIDEGREES_TO_RADIANS(telemetrySnapshot.attitude.values.yaw),
         // rollspeed Roll angular speed (rad/s)
         0,
         // pitchspeed Pitch angular speed (rad/s)
         0,
         // yawspeed Yaw angular speed (rad/s)
         0);
-    msgLength = mavlink_msg_to_send_buffer(mavBuffer, &mavMsg);
-    mavlinkSerialWrite(mavBuffer, msgLength);
+    mavlinkSendMessage();
 }
 
 void mavlinkSendHUDAndHeartbeat(void)
 {
-    uint16_t msgLength;
     float mavAltitude = 0;
     float mavGroundSpeed = 0;
     float mavAirSpeed = 0;
@@ -391,7 +640,7 @@ void mavlinkSendHUDAndHeartbeat(void)
 #if defined(GPS)
     // use ground speed if source available
     if (sensors(SENSOR_GPS)) {
-        mavGroundSpeed = gpsSol.groundSpeed / 100.0f;
+        mavGroundSpeed = telemetrySnapshot.gpsSol.groundSpeed / 100.0f;
     }
 #endif
 
@@ -399,18 +648,18 @@ void mavlinkSendHUDAndHeartbeat(void)
 #if defined(BARO) || defined(SONAR)
     if (sensors(SENSOR_SONAR) || sensors(SENSOR_BARO)) {
         // Baro or sonar generally is a better estimate of altitude than GPS MSL altitude
-        mavAltitude = getEstimatedAltitude() / 100.0;
+        mavAltitude = telemetrySnapshot.altitude / 100.0;
     }
 #if defined(GPS)
     else if (sensors(SENSOR_GPS)) {
         // No sonar or baro, just display altitude above MLS
-        mavAltitude = gpsSol.llh.alt;
+        mavAltitude = telemetrySnapshot.gpsSol.llh.alt;
     }
 #endif
 #elif defined(GPS)
     if (sensors(SENSOR_GPS)) {
         // No sonar or baro, just display altitude above MLS
-        mavAltitude = gpsSol.llh.alt;
+        mavAltitude = telemetrySnapshot.gpsSol.llh.alt;
     }
 #endif
 
@@ -420,15 +669,14 @@ void mavlinkSendHUDAndHeartbeat(void)
         // groundspeed Current ground speed in m/s
         mavGroundSpeed,
         // heading Current heading in degrees, in compass units (0..360, 0=north)
-        DECIDEGREES_TO_DEGREES(attitude.values.yaw),
+        DECIDEGREES_TO_DEGREES(telemetrySnapshot.attitude.values.yaw),
         // throttle Current throttle setting in integer percent, 0 to 100
         scaleRange(constrain(rcData[THROTTLE], PWM_RANGE_MIN, PWM_RANGE_MAX), PWM_RANGE_MIN, PWM_RANGE_MAX, 0, 100),
         // alt Current altitude (MSL), in meters, if we have sonar or baro use them, otherwise use GPS (less accurate)
         mavAltitude,
         // climb Current climb rate in meters/second
         mavClimbRate);
-    msgLength = mavlink_msg_to_send_buffer(mavBuffer, &mavMsg);
-    mavlinkSerialWrite(mavBuffer, msgLength);
+    mavlinkSendMessage();
 
 
     uint8_t mavModes = MAV_MODE_FLAG_MANUAL_INPUT_ENABLED;
@@ -509,13 +757,14 @@ void mavlinkSendHUDAndHeartbeat(void)
         mavCustomMode,
         // system_status System status flag, see MAV_STATE ENUM
         mavSystemState);
-    msgLength = mavlink_msg_to_send_buffer(mavBuffer, &mavMsg);
-    mavlinkSerialWrite(mavBuffer, msgLength);
+    mavlinkSendMessage();
 }
 
 void processMAVLinkTelemetry(void)
 {
     // is executed @ TELEMETRY_MAVLINK_MAXRATE rate
+    mavlinkBeginWrite();
+
     if (mavlinkStreamTrigger(MAV_DATA_STREAM_EXTENDED_STATUS)) {
         mavlinkSendSystemStatus();
     }
@@ -537,6 +786,11 @@ void processMAVLinkTelemetry(void)
     if (mavlinkStreamTrigger(MAV_DATA_STREAM_EXTRA2)) {
         mavlinkSendHUDAndHeartbeat();
     }
+
+    // parameters use whatever room the streams left
+    mavlinkSendParams();
+
+    mavlinkEndWrite();
 }
 
 void handleMAVLinkTelemetry(void)
@@ -549,10 +803,16 @@ void handleMAVLinkTelemetry(void)
         return;
     }
 
+    mavlinkReceive();
+
     uint32_t now = micros();
     if ((now - lastMavlinkMessage) >= TELEMETRY_MAVLINK_DELAY) {
         processMAVLinkTelemetry();
-        lastMavlinkMessage = now;
+        // keep the average rate when the task period doesn't divide the message period, but don't catch up after a stall
+        lastMavlinkMessage += TELEMETRY_MAVLINK_DELAY;
+        if ((now - lastMavlinkMessage) >= TELEMETRY_MAVLINK_DELAY) {
+            lastMavlinkMessage = now;
+        }
     }
 }
 
@@ -57,6 +57,8 @@
 #include "rx/msp.h"
 
 #include "telemetry/telemetry.h"
+#include "telemetry/telemetry_scheduler.h"
+#include "telemetry/telemetry_snapshot.h"
 #include "telemetry/smartport.h"
 
 enum
@@ -113,36 +115,37 @@ enum
     FSSP_DATAID_A4         = 0x0910
 };
 
-const uint16_t frSkyDataIdTable[] = {
-    FSSP_DATAID_SPEED     ,
-    FSSP_DATAID_VFAS      ,
-    FSSP_DATAID_CURRENT   ,
-    //FSSP_DATAID_RPM       ,
-    FSSP_DATAID_ALTITUDE  ,
-    FSSP_DATAID_FUEL      ,
-    //FSSP_DATAID_ADC1      ,
-    //FSSP_DATAID_ADC2      ,
-    FSSP_DATAID_LATLONG   ,
-    FSSP_DATAID_LATLONG   , // twice
-    //FSSP_DATAID_CAP_USED  ,
-    FSSP_DATAID_VARIO     ,
-    //FSSP_DATAID_CELLS     ,
-    //FSSP_DATAID_CELLS_LAST,
-    FSSP_DATAID_HEADING   ,
-    FSSP_DATAID_ACCX      ,
-    FSSP_DATAID_ACCY      ,
-    FSSP_DATAID_ACCZ      ,
-    FSSP_DATAID_T1        ,
-    FSSP_DATAID_T2        ,
-    FSSP_DATAID_GPS_ALT   ,
-    FSSP_DATAID_A4        ,
-    0
+// how often each data id is sent relative to the others, fast-changing values get more of the slots
+static const telemetrySensor_t frSkySensors[] = {
+    // id                     weight  priority
+    { FSSP_DATAID_VARIO      , 4    , 5 },
+    { FSSP_DATAID_CURRENT    , 3    , 4 },
+    { FSSP_DATAID_VFAS       , 3    , 4 },
+    { FSSP_DATAID_ALTITUDE   , 3    , 3 },
+    { FSSP_DATAID_A4         , 2    , 3 },
+    { FSSP_DATAID_HEADING    , 2    , 2 },
+    { FSSP_DATAID_SPEED      , 2    , 2 },
+    { FSSP_DATAID_LATLONG    , 2    , 2 }, // latitude and longitude alternate
+    { FSSP_DATAID_FUEL       , 1    , 1 },
+    { FSSP_DATAID_GPS_ALT    , 1    , 1 },
+    { FSSP_DATAID_ACCX       , 1    , 0 },
+    { FSSP_DATAID_ACCY       , 1    , 0 },
+    { FSSP_DATAID_ACCZ       , 1    , 0 },
+    { FSSP_DATAID_T1         , 1    , 0 },
+    { FSSP_DATAID_T2         , 1    , 0 },
+    //{ FSSP_DATAID_RPM        , 0    , 0 },
+    //{ FSSP_DATAID_ADC1       , 0    , 0 },
+    //{ FSSP_DATAID_ADC2       , 0    , 0 },
+    //{ FSSP_DATAID_CAP_USED   , 0    , 0 },
+    //{ FSSP_DATAID_CELLS      , 0    , 0 },
+    //{ FSSP_DATAID_CELLS_LAST , 0    , 0 },
 };
 
+static telemetryScheduler_t smartPortScheduler;
+
 #define __USE_C99_MATH // for roundf()
 #define SMARTPORT_BAUD 57600
 #define SMARTPORT_UART_MODE MODE_RXTX
-#define SMARTPORT_SERVICE_TIMEOUT_MS 1 // max allowed time to find a value to send
 
 static serialPort_t *smartPortSerialPort = NULL; // The 'SmartPort'(tm) Port.
 static serialPortConfig_t *portConfig;
@@ -151,9 +154,7 @@ static bool smartPortTelemetryEnabled =  false;
 static portSharing_e smartPortPortSharing;
 
 char smartPortState = SPSTATE_UNINITIALIZED;
-static uint8_t smartPortHasRequest = 0;
-static uint8_t smartPortIdCnt = 0;
-static uint32_t smartPortLastRequestTime = 0;
+static volatile uint32_t smartPortLastRequestTime = 0;
 
 typedef struct smartPortFrame_s {
     uint8_t  sensorId;
@@ -171,7 +172,16 @@ typedef struct smartPortFrame_s {
 
 static smartPortFrame_t smartPortRxBuffer;
 static uint8_t smartPortRxBytes = 0;
-static bool smartPortFrameReceived = false;
+// a complete frame from the master, handed from the RX interrupt to the telemetry task
+static smartPortFrame_t smartPortRxFrame;
+static volatile bool smartPortFrameReceived = false;
+
+// The reply to the next poll of our sensor id. The telemetry task builds it ahead of time and the
+// RX interrupt sends it as soon as the poll arrives, so the reply always lands in the time slot.
+#define SMARTPORT_TX_FRAME_SIZE_MAX ((SMARTPORT_PAYLOAD_SIZE + 2) * 2) // frame id, payload and crc, each possibly escaped
+static uint8_t smartPortTxFrame[SMARTPORT_TX_FRAME_SIZE_MAX];
+static uint8_t smartPortTxFrameBuildLength;
+static volatile uint8_t smartPortTxFrameLength = 0; // non-zero while a reply waits for the poll
 
 #define SMARTPORT_MSP_VERSION    1
 #define SMARTPORT_MSP_VER_SHIFT  5
@@ -196,17 +206,29 @@ enum {
     SMARTPORT_MSP_ERROR=2
 };
 
+static void smartPortSendPreparedFrame(void)
+{
+    const uint8_t length = smartPortTxFrameLength;
+    if (!length) {
+        // nothing ready, the slot goes unused
+        return;
+    }
+    // never wait for room in here, a reply that doesn't fit is dropped
+    if (serialTxBytesFree(smartPortSerialPort) >= length) {
+        serialWriteBuf(smartPortSerialPort, smartPortTxFrame, length);
+    }
+    smartPortTxFrameLength = 0;
+}
+
+// Called from the serial RX interrupt for every byte
 static void smartPortDataReceive(uint16_t c)
 {
     static bool skipUntilStart = true;
     static bool byteStuffing = false;
     static uint16_t checksum = 0;
 
-    uint32_t now = millis();
-
     if (c == FSSP_START_STOP) {
         smartPortRxBytes = 0;
-        smartPortHasRequest = 0;
         skipUntilStart = false;
         return;
     } else if (skipUntilStart) {
@@ -215,11 +237,11 @@ static void smartPortDataReceive(uint16_t c)
 
     uint8_t* rxBuffer = (uint8_t*)&smartPortRxBuffer;
     if (smartPortRxBytes == 0) {
-        if ((c == FSSP_SENSOR_ID1) && (serialRxBytesWaiting(smartPortSerialPort) == 0)) {
-
-            // our slot is starting...
-            smartPortLastRequestTime = now;
-            smartPortHasRequest = 1;
+        if (c == FSSP_SENSOR_ID1) {
+            // our slot is starting, answer right away
+            smartPortLastRequestTime = millis();
+            smartPortSendPreparedFrame();
+            skipUntilStart = true;
         } else if (c == FSSP_SENSOR_ID2) {
             rxBuffer[smartPortRxBytes++] = c;
             checksum = 0;
@@ -243,7 +265,9 @@ static void smartPortDataReceive(uint16_t c)
         rxBuffer[smartPortRxBytes++] = c;
 
         if (smartPortRxBytes == SMARTPORT_FRAME_SIZE) {
-            if (c == (0xFF - checksum)) {
+            // a frame the task hasn't picked up yet is kept, the master repeats unanswered requests
+            if (c == (0xFF - checksum) && !smartPortFrameReceived) {
+                smartPortRxFrame = smartPortRxBuffer;
                 smartPortFrameReceived = true;
             }
             skipUntilStart = true;
@@ -259,11 +283,11 @@ static void smartPortSendByte(uint8_t c, uint16_t *crcp)
 {
     // smart port escape sequence
     if (c == FSSP_DLE || c == FSSP_START_STOP) {
-        serialWrite(smartPortSerialPort, FSSP_DLE);
-        serialWrite(smartPortSerialPort, c ^ FSSP_DLE_XOR);
+        smartPortTxFrame[smartPortTxFrameBuildLength++] = FSSP_DLE;
+        smartPortTxFrame[smartPortTxFrameBuildLength++] = c ^ FSSP_DLE_XOR;
     }
     else {
-        serialWrite(smartPortSerialPort, c);
+        smartPortTxFrame[smartPortTxFrameBuildLength++] = c;
     }
 
     if (crcp == NULL)
@@ -276,14 +300,20 @@ static void smartPortSendByte(uint8_t c, uint16_t *crcp)
     *crcp = crc;
 }
 
+// Builds the reply for the next poll, only called while no reply is waiting
 static void smartPortSendPackageEx(uint8_t frameId, uint8_t* data)
 {
     uint16_t crc = 0;
+    smartPortTxFrameBuildLength = 0;
     smartPortSendByte(frameId, &crc);
     for (unsigned i = 0; i < SMARTPORT_PAYLOAD_SIZE; i++) {
         smartPortSendByte(*data++, &crc);
     }
     smartPortSendByte(0xFF - (uint8_t)crc, NULL);
+
+    // the frame must be complete before the RX interrupt can see its length
+    __sync_synchronize();
+    smartPortTxFrameLength = smartPortTxFrameBuildLength;
 }
 
 static void smartPortSendPackage(uint16_t id, uint32_t val)
@@ -304,6 +334,16 @@ void initSmartPortTelemetry(void)
 {
     portConfig = findSerialPortConfig(FUNCTION_TELEMETRY_SMARTPORT);
     smartPortPortSharing = determinePortSharing(portConfig, FUNCTION_TELEMETRY_SMARTPORT);
+
+    telemetrySchedulerInit(&smartPortScheduler, frSkySensors, ARRAYLEN(frSkySensors));
+    // don't spend slots on ids that can never be sent
+    const bool gpsPresent = feature(FEATURE_GPS);
+    telemetrySchedulerEnable(&smartPortScheduler, FSSP_DATAID_SPEED, gpsPresent);
+    telemetrySchedulerEnable(&smartPortScheduler, FSSP_DATAID_LATLONG, gpsPresent);
+    telemetrySchedulerEnable(&smartPortScheduler, FSSP_DATAID_GPS_ALT, gpsPresent);
+    const bool baroPresent = sensors(SENSOR_BARO);
+    telemetrySchedulerEnable(&smartPortScheduler, FSSP_DATAID_ALTITUDE, baroPresent);
+    telemetrySchedulerEnable(&smartPortScheduler, FSSP_DATAID_VARIO, baroPresent);
 }
 
 void freeSmartPortTelemetryPort(void)
@@ -323,7 +363,9 @@ void configureSmartPortTelemetryPort(void)
 
     portOptions_t portOptions = (telemetryConfig()->halfDuplex ? SERIAL_BIDIR : SERIAL_UNIDIR) | (telemetryConfig()->telemetry_inverted ? SERIAL_NOT_INVERTED : SERIAL_INVERTED);
 
-    smartPortSerialPort = openSerialPort(portConfig->identifier, FUNCTION_TELEMETRY_SMARTPORT, NULL, SMARTPORT_BAUD, SMARTPORT_UART_MODE, portOptions);
+    smartPortTxFrameLength = 0;
+    smartPortFrameReceived = false;
+    smartPortSerialPort = openSerialPort(portConfig->identifier, FUNCTION_TELEMETRY_SMARTPORT, smartPortDataReceive, SMARTPORT_BAUD, SMARTPORT_UART_MODE, portOptions);
 
     if (!smartPortSerialPort) {
         return;
@@ -544,8 +586,6 @@ void handleSmartPortMspFrame(smartPortFrame_t* sp_frame)
 
 void handleSmartPortTelemetry(void)
 {
-    uint32_t smartPortLastServiceTime = millis();
-
     if (!smartPortTelemetryEnabled) {
         return;
     }
@@ -554,42 +594,38 @@ void handleSmartPortTelemetry(void)
         return;
     }
 
-    while (serialRxBytesWaiting(smartPortSerialPort) > 0) {
-        uint8_t c = serialRead(smartPortSerialPort);
-        smartPortDataReceive(c);
-    }
-
+    // bytes are received and polls answered in the RX interrupt, the task only handles
+    // complete frames from the master and prepares the reply for the next poll
     if (smartPortFrameReceived) {
-        smartPortFrameReceived = false;
         // do not check the physical ID here again
         // unless we start receiving other sensors' packets
-        if (smartPortRxBuffer.frameId == FSSP_MSPC_FRAME) {
+        if (smartPortRxFrame.frameId == FSSP_MSPC_FRAME) {
 
             // Pass only the payload: skip sensorId & frameId
-            handleSmartPortMspFrame(&smartPortRxBuffer);
+            handleSmartPortMspFrame(&smartPortRxFrame);
         }
+        smartPortFrameReceived = false;
     }
 
-    while (smartPortHasRequest) {
-        // Ensure we won't get stuck in the loop if there happens to be nothing available to send in a timely manner - dump the slot if we loop in there for too long.
-        if ((millis() - smartPortLastServiceTime) > SMARTPORT_SERVICE_TIMEOUT_MS) {
-            smartPortHasRequest = 0;
-            return;
-        }
+    if (smartPortTxFrameLength) {
+        // the prepared reply hasn't been polled yet
+        return;
+    }
 
-        if (smartPortMspReplyPending) {
-            smartPortMspReplyPending = smartPortSendMspReply();
-            smartPortHasRequest = 0;
-            return;
-        }
+    if (smartPortMspReplyPending) {
+        smartPortMspReplyPending = smartPortSendMspReply();
+        return;
+    }
 
-        // we can send back any data we want, our table keeps track of the order and frequency of each data type we send
-        uint16_t id = frSkyDataIdTable[smartPortIdCnt];
-        if (id == 0) { // end of table reached, loop back
-            smartPortIdCnt = 0;
-            id = frSkyDataIdTable[smartPortIdCnt];
+    // every sensor gets at most one chance to provide a value, the slot is left empty if none can
+    bool needsFrame = true;
+    for (int tries = smartPortScheduler.sensorCount; needsFrame && tries > 0; tries--) {
+        // we can send back any data we want, the scheduler keeps track of the order and frequency of each data type we send
+        const telemetrySensor_t *sensor = telemetrySchedulerNext(&smartPortScheduler);
+        if (!sensor) {
+            return;
         }
-        smartPortIdCnt++;
+        const uint16_t id = sensor->id;
 
         int32_t tmpi;
         uint32_t tmp2 = 0;
@@ -602,41 +638,41 @@ void handleSmartPortTelemetry(void)
                 if (sensors(SENSOR_GPS) && STATE(GPS_FIX)) {
                     //convert to knots: 1cm/s = 0.0194384449 knots
                     //Speed should be sent in knots/1000 (GPS speed is in cm/s)
-                    uint32_t tmpui = gpsSol.groundSpeed * 1944 / 100;
+                    uint32_t tmpui = telemetrySnapshot.gpsSol.groundSpeed * 1944 / 100;
                     smartPortSendPackage(id, tmpui);
-                    smartPortHasRequest = 0;
+                    needsFrame = false;
                 }
                 break;
 #endif
             case FSSP_DATAID_VFAS       :
-                if (batteryConfig()->voltageMeterSource != VOLTAGE_METER_NONE && getBatteryCellCount() > 0) {
+                if (batteryConfig()->voltageMeterSource != VOLTAGE_METER_NONE && telemetrySnapshot.batteryCellCount > 0) {
                     uint16_t vfasVoltage;
                     if (telemetryConfig()->report_cell_voltage) {
-                        vfasVoltage = getBatteryVoltage() / getBatteryCellCount();
+                        vfasVoltage = telemetrySnapshot.vbat / telemetrySnapshot.batteryCellCount;
                     } else {
-                        vfasVoltage = getBatteryVoltage();
+                        vfasVoltage = telemetrySnapshot.vbat;
                     }
                     smartPortSendPackage(id, vfasVoltage * 10); // given in 0.1V, convert to volts
-                    smartPortHasRequest = 0;
+                    needsFrame = false;
                 }
                 break;
             case FSSP_DATAID_CURRENT    :
                 if (batteryConfig()->currentMeterSource != CURRENT_METER_NONE) {
-                    smartPortSendPackage(id, getAmperage() / 10); // given in 10mA steps, unknown requested unit
-                    smartPortHasRequest = 0;
+                    smartPortSendPackage(id, telemetrySnapshot.amperage / 10); // given in 10mA steps, unknown requested unit
+                    needsFrame = false;
                 }
                 break;
             //case FSSP_DATAID_RPM        :
             case FSSP_DATAID_ALTITUDE   :
                 if (sensors(SENSOR_BARO)) {
-                    smartPortSendPackage(id, getEstimatedAltitude()); // unknown given unit, requested 100 = 1 meter
-                    smartPortHasRequest = 0;
+                    smartPortSendPackage(id, telemetrySnapshot.altitude); // unknown given unit, requested 100 = 1 meter
+                    needsFrame = false;
                 }
                 break;
             case FSSP_DATAID_FUEL       :
                 if (batteryConfig()->currentMeterSource != CURRENT_METER_NONE) {
-                    smartPortSendPackage(id, getMAhDrawn()); // given in mAh, unknown requested unit
-                    smartPortHasRequest = 0;
+                    smartPortSendPackage(id, telemetrySnapshot.mAhDrawn); // given in mAh, unknown requested unit
+                    needsFrame = false;
                 }
                 break;
             //case FSSP_DATAID_ADC1       :
@@ -647,44 +683,45 @@ void handleSmartPortTelemetry(void)
                     uint32_t tmpui = 0;
                     // the same ID is sent twice, one for longitude, one for latitude
                     // the MSB of the sent uint32_t helps FrSky keep track
-                    // the even/odd bit of our counter helps us keep track
-                    if (smartPortIdCnt & 1) {
-                        tmpui = abs(gpsSol.llh.lon);  // now we have unsigned value and one bit to spare
+                    static bool sendLongitude = false;
+                    sendLongitude = !sendLongitude;
+                    if (sendLongitude) {
+                        tmpui = abs(telemetrySnapshot.gpsSol.llh.lon);  // now we have unsigned value and one bit to spare
                         tmpui = (tmpui + tmpui / 2) / 25 | 0x80000000;  // 6/100 = 1.5/25, division by power of 2 is fast
-                        if (gpsSol.llh.lon < 0) tmpui |= 0x40000000;
+                        if (telemetrySnapshot.gpsSol.llh.lon < 0) tmpui |= 0x40000000;
                     }
                     else {
-                        tmpui = abs(gpsSol.llh.lat);  // now we have unsigned value and one bit to spare
+                        tmpui = abs(telemetrySnapshot.gpsSol.llh.lat);  // now we have unsigned value and one bit to spare
                         tmpui = (tmpui + tmpui / 2) / 25;  // 6/100 = 1.5/25, division by power of 2 is fast
-                        if (gpsSol.llh.lat < 0) tmpui |= 0x40000000;
+                        if (telemetrySnapshot.gpsSol.llh.lat < 0) tmpui |= 0x40000000;
                     }
                     smartPortSendPackage(id, tmpui);
-                    smartPortHasRequest = 0;
+                    needsFrame = false;
                 }
                 break;
 #endif
             //case FSSP_DATAID_CAP_USED   :
             case FSSP_DATAID_VARIO      :
                 if (sensors(SENSOR_BARO)) {
-                    smartPortSendPackage(id, getEstimatedVario()); // unknown given unit but requested in 100 = 1m/s
-                    smartPortHasRequest = 0;
+                    smartPortSendPackage(id, telemetrySnapshot.vario); // unknown given unit but requested in 100 = 1m/s
+                    needsFrame = false;
                 }
                 break;
             case FSSP_DATAID_HEADING    :
-                smartPortSendPackage(id, attitude.values.yaw * 10); // given in 10*deg, requested in 10000 = 100 deg
-                smartPortHasRequest = 0;
+                smartPortSendPackage(id, telemetrySnapshot.attitude.values.yaw * 10); // given in 10*deg, requested in 10000 = 100 deg
+                needsFrame = false;
                 break;
             case FSSP_DATAID_ACCX       :
                 smartPortSendPackage(id, 100 * acc.accSmooth[X] / acc.dev.acc_1G); // Multiply by 100 to show as x.xx g on Taranis
-                smartPortHasRequest = 0;
+                needsFrame = false;
                 break;
             case FSSP_DATAID_ACCY       :
                 smartPortSendPackage(id, 100 * acc.accSmooth[Y] / acc.dev.acc_1G);
-                smartPortHasRequest = 0;
+                needsFrame = false;
                 break;
             case FSSP_DATAID_ACCZ       :
                 smartPortSendPackage(id, 100 * acc.accSmooth[Z] / acc.dev.acc_1G);
-                smartPortHasRequest = 0;
+                needsFrame = false;
                 break;
             case FSSP_DATAID_T1         :
                 // we send all the flags as decimal digits for easy reading
@@ -730,18 +767,18 @@ void handleSmartPortTelemetry(void)
                     tmpi += 4000;
 
                 smartPortSendPackage(id, (uint32_t)tmpi);
-                smartPortHasRequest = 0;
+                needsFrame = false;
                 break;
             case FSSP_DATAID_T2         :
                 if (sensors(SENSOR_GPS)) {
 #ifdef GPS
                     // provide GPS lock status
-                    smartPortSendPackage(id, (STATE(GPS_FIX) ? 1000 : 0) + (STATE(GPS_FIX_HOME) ? 2000 : 0) + gpsSol.numSat);
-                    smartPortHasRequest = 0;
+                    smartPortSendPackage(id, (STATE(GPS_FIX) ? 1000 : 0) + (STATE(GPS_FIX_HOME) ? 2000 : 0) + telemetrySnapshot.gpsSol.numSat);
+                    needsFrame = false;
 #endif
                 } else if (feature(FEATURE_GPS)) {
                     smartPortSendPackage(id, 0);
-                    smartPortHasRequest = 0;
+                    needsFrame = false;
                 } else if (telemetryConfig()->pidValuesAsTelemetry) {
                     switch (t2Cnt) {
                         case 0:
@@ -771,26 +808,26 @@ void handleSmartPortTelemetry(void)
                         t2Cnt = 0;
                     }
                     smartPortSendPackage(id, tmp2);
-                    smartPortHasRequest = 0;
+                    needsFrame = false;
                 }
                 break;
 #ifdef GPS
             case FSSP_DATAID_GPS_ALT    :
                 if (sensors(SENSOR_GPS) && STATE(GPS_FIX)) {
-                    smartPortSendPackage(id, gpsSol.llh.alt * 100); // given in 0.1m , requested in 10 = 1m (should be in mm, probably a bug in opentx, tested on 2.0.1.7)
-                    smartPortHasRequest = 0;
+                    smartPortSendPackage(id, telemetrySnapshot.gpsSol.llh.alt * 100); // given in 0.1m , requested in 10 = 1m (should be in mm, probably a bug in opentx, tested on 2.0.1.7)
+                    needsFrame = false;
                 }
                 break;
 #endif
             case FSSP_DATAID_A4         :
-                if (batteryConfig()->voltageMeterSource != VOLTAGE_METER_NONE && getBatteryCellCount() > 0) {
-                    smartPortSendPackage(id, getBatteryVoltage() * 10 / getBatteryCellCount()); // given in 0.1V, convert to volts
-                    smartPortHasRequest = 0;
+                if (batteryConfig()->voltageMeterSource != VOLTAGE_METER_NONE && telemetrySnapshot.batteryCellCount > 0) {
+                    smartPortSendPackage(id, telemetrySnapshot.vbatCell); // given in 0.01V
+                    needsFrame = false;
                 }
                 break;
             default:
                 break;
-                // if nothing is sent, smartPortHasRequest isn't cleared, we already incremented the counter, just loop back to the start
+                // if nothing is sent, needsFrame isn't cleared, the scheduler already moved on, just loop back to the start
         }
     }
 }
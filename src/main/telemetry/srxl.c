@@ -45,6 +45,7 @@
 #include "rx/spektrum.h"
 
 #include "telemetry/telemetry.h"
+#include "telemetry/telemetry_snapshot.h"
 #include "telemetry/srxl.h"
 
 #include "fc/config.h"
@@ -161,7 +162,7 @@ void srxlFrameRpm(sbuf_t *dst)
     srxlSerialize8(dst, SRXL_FRAMETYPE_TELE_RPM);
     srxlSerialize8(dst, SRXL_FRAMETYPE_SID);
     srxlSerialize16(dst, 0xFFFF); // pulse leading edges
-    srxlSerialize16(dst, getBatteryVoltage() * 10);   // vbat is in units of 0.1V
+    srxlSerialize16(dst, telemetrySnapshot.vbat * 10);   // vbat is in units of 0.1V
     srxlSerialize16(dst, 0x7FFF); // temperature
     srxlSerialize8(dst, 0xFF);    // dbmA
     srxlSerialize8(dst, 0xFF);    // dbmB
@@ -200,9 +201,9 @@ void srxlFramePowerBox(sbuf_t *dst)
 {
     srxlSerialize8(dst, SRXL_FRAMETYPE_POWERBOX);
     srxlSerialize8(dst, SRXL_FRAMETYPE_SID);
-    srxlSerialize16(dst, getBatteryVoltage() * 10); // vbat is in units of 0.1V - vbat1
-    srxlSerialize16(dst, getBatteryVoltage() * 10); // vbat is in units of 0.1V - vbat2
-    srxlSerialize16(dst, getAmperage() / 10);
+    srxlSerialize16(dst, telemetrySnapshot.vbat * 10); // vbat is in units of 0.1V - vbat1
+    srxlSerialize16(dst, telemetrySnapshot.vbat * 10); // vbat is in units of 0.1V - vbat2
+    srxlSerialize16(dst, telemetrySnapshot.amperage / 10);
     srxlSerialize16(dst, 0xFFFF);
 
     srxlSerialize16(dst, 0xFFFF); // spare
@@ -43,6 +43,7 @@
 #include "rx/rx.h"
 
 #include "telemetry/telemetry.h"
+#include "telemetry/telemetry_snapshot.h"
 #include "telemetry/frsky.h"
 #include "telemetry/hott.h"
 #include "telemetry/smartport.h"
@@ -169,6 +170,8 @@ void telemetryCheckState(void)
 
 void telemetryProcess(uint32_t currentTime)
 {
+    telemetrySnapshotUpdate();
+
 #ifdef TELEMETRY_FRSKY
     handleFrSkyTelemetry();
 #endif
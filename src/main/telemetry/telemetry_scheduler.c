@@ -0,0 +1,91 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "platform.h"
+
+#ifdef TELEMETRY
+
+#include "telemetry/telemetry_scheduler.h"
+
+static void telemetrySchedulerReset(telemetryScheduler_t *scheduler)
+{
+    scheduler->weightSum = 0;
+    for (int i = 0; i < scheduler->sensorCount; i++) {
+        if (scheduler->enabledMask & (1U << i)) {
+            scheduler->weightSum += scheduler->sensors[i].weight;
+        }
+    }
+    memset(scheduler->credit, 0, sizeof(scheduler->credit));
+}
+
+void telemetrySchedulerInit(telemetryScheduler_t *scheduler, const telemetrySensor_t *sensors, uint8_t sensorCount)
+{
+    if (sensorCount > TELEMETRY_SCHEDULER_SENSOR_COUNT_MAX) {
+        sensorCount = TELEMETRY_SCHEDULER_SENSOR_COUNT_MAX;
+    }
+    scheduler->sensors = sensors;
+    scheduler->sensorCount = sensorCount;
+    scheduler->enabledMask = 0;
+    for (int i = 0; i < sensorCount; i++) {
+        if (sensors[i].weight > 0) {
+            scheduler->enabledMask |= 1U << i;
+        }
+    }
+    telemetrySchedulerReset(scheduler);
+}
+
+void telemetrySchedulerEnable(telemetryScheduler_t *scheduler, uint16_t id, bool enabled)
+{
+    for (int i = 0; i < scheduler->sensorCount; i++) {
+        if (scheduler->sensors[i].id == id) {
+            if (enabled && scheduler->sensors[i].weight > 0) {
+                scheduler->enabledMask |= 1U << i;
+            } else {
+                scheduler->enabledMask &= ~(1U << i);
+            }
+        }
+    }
+    telemetrySchedulerReset(scheduler);
+}
+
+// Smooth weighted round robin: every enabled sensor earns its weight in credit each slot,
+// the one with the most credit is sent and pays back the sum of all weights.
+// A sensor with twice the weight of another is sent twice as often, and never in long bursts.
+const telemetrySensor_t *telemetrySchedulerNext(telemetryScheduler_t *scheduler)
+{
+    int best = -1;
+    for (int i = 0; i < scheduler->sensorCount; i++) {
+        if (!(scheduler->enabledMask & (1U << i))) {
+            continue;
+        }
+        scheduler->credit[i] += scheduler->sensors[i].weight;
+        if (best < 0 || scheduler->credit[i] > scheduler->credit[best]
+            || (scheduler->credit[i] == scheduler->credit[best] && scheduler->sensors[i].priority > scheduler->sensors[best].priority)) {
+            best = i;
+        }
+    }
+    if (best < 0) {
+        return NULL;
+    }
+    scheduler->credit[best] -= scheduler->weightSum;
+    return &scheduler->sensors[best];
+}
+#endif
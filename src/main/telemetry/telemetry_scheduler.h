@@ -0,0 +1,41 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#define TELEMETRY_SCHEDULER_SENSOR_COUNT_MAX 32
+
+// One entry per value a protocol can send in a slot.
+// Each sensor gets weight slots out of every weightSum slots, spread evenly,
+// so fast-changing values can be sent more often than static ones within the same bus bandwidth.
+typedef struct telemetrySensor_s {
+    uint16_t id;                        // protocol specific, eg SmartPort data id or CRSF frame type
+    uint8_t weight;                     // share of the slots, relative to the other enabled sensors
+    uint8_t priority;                   // breaks ties, higher is sent first
+} telemetrySensor_t;
+
+typedef struct telemetryScheduler_s {
+    const telemetrySensor_t *sensors;
+    uint8_t sensorCount;
+    uint32_t enabledMask;
+    uint16_t weightSum;                 // of the enabled sensors
+    int16_t credit[TELEMETRY_SCHEDULER_SENSOR_COUNT_MAX];
+} telemetryScheduler_t;
+
+void telemetrySchedulerInit(telemetryScheduler_t *scheduler, const telemetrySensor_t *sensors, uint8_t sensorCount);
+void telemetrySchedulerEnable(telemetryScheduler_t *scheduler, uint16_t id, bool enabled);
+const telemetrySensor_t *telemetrySchedulerNext(telemetryScheduler_t *scheduler);
@@ -0,0 +1,64 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "platform.h"
+
+#ifdef TELEMETRY
+
+#include "config/parameter_group.h"
+
+#include "drivers/io_types.h"
+
+#include "flight/altitude.h"
+#include "flight/imu.h"
+#include "flight/navigation.h"
+
+#include "io/gps.h"
+
+#include "rx/rx.h"
+
+#include "sensors/battery.h"
+
+#include "telemetry/telemetry_snapshot.h"
+
+telemetrySnapshot_t telemetrySnapshot;
+
+void telemetrySnapshotUpdate(void)
+{
+    telemetrySnapshot.vbat = getBatteryVoltage();
+    telemetrySnapshot.batteryCellCount = getBatteryCellCount();
+    telemetrySnapshot.vbatCell = telemetrySnapshot.batteryCellCount ? telemetrySnapshot.vbat * 10 / telemetrySnapshot.batteryCellCount : 0;
+    telemetrySnapshot.batteryRemaining = calculateBatteryPercentageRemaining();
+    telemetrySnapshot.batteryState = getBatteryState();
+    telemetrySnapshot.amperage = getAmperage();
+    telemetrySnapshot.mAhDrawn = getMAhDrawn();
+
+    telemetrySnapshot.altitude = getEstimatedAltitude();
+    telemetrySnapshot.vario = getEstimatedVario();
+    telemetrySnapshot.rssi = rssi;
+    telemetrySnapshot.attitude = attitude;
+
+#ifdef GPS
+    telemetrySnapshot.gpsSol = gpsSol;
+    telemetrySnapshot.distanceToHome = GPS_distanceToHome;
+    telemetrySnapshot.directionToHome = GPS_directionToHome;
+#endif
+}
+#endif
@@ -0,0 +1,50 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "flight/imu.h"
+
+#include "io/gps.h"
+
+#include "sensors/battery.h"
+
+// The values the telemetry protocols send, read once per telemetry task run.
+// Every protocol serialises from here, so running several of them costs the reads only once,
+// and the values in one message all come from the same moment.
+typedef struct telemetrySnapshot_s {
+    uint16_t vbat;                      // 0.1V
+    uint16_t vbatCell;                  // 0.01V, average over the cells, 0 while the cell count is unknown
+    uint8_t batteryCellCount;
+    uint8_t batteryRemaining;           // percent
+    batteryState_e batteryState;
+    int32_t amperage;                   // 0.01A
+    int32_t mAhDrawn;
+    int32_t altitude;                   // cm, estimated
+    int32_t vario;                      // cm/s
+    uint16_t rssi;                      // 0-1023
+    attitudeEulerAngles_t attitude;     // 0.1 degree
+#ifdef GPS
+    gpsSolutionData_t gpsSol;
+    uint16_t distanceToHome;            // m
+    int16_t directionToHome;            // degrees
+#endif
+} telemetrySnapshot_t;
+
+extern telemetrySnapshot_t telemetrySnapshot;
+
+void telemetrySnapshotUpdate(void);
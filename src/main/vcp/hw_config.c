@@ -291,9 +291,9 @@ uint32_t CDC_Send_DATA(const uint8_t *ptrBuffer, uint32_t sendLength)
         return 0;
     }
 
-    // We can only put 64 bytes in the buffer
-    if (sendLength > 64 / 2) {
-        sendLength = 64 / 2;
+    // The endpoint buffer holds one full packet
+    if (sendLength > VIRTUAL_COM_PORT_DATA_SIZE) {
+        sendLength = VIRTUAL_COM_PORT_DATA_SIZE;
     }
 
     // Try to load some bytes if we can
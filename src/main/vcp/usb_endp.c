@@ -33,6 +33,8 @@
 #include "usb_istr.h"
 #include "usb_pwr.h"
 
+#include "drivers/serial.h"
+
 /* Private typedef -----------------------------------------------------------*/
 /* Private define ------------------------------------------------------------*/
 
@@ -70,6 +72,7 @@ void EP3_OUT_Callback(void)
 {
     receiveLength = GetEPRxCount(ENDP3);                                              // HJI
     PMAToUserBufferCopy((unsigned char*)receiveBuffer, ENDP3_RXADDR, receiveLength);  // HJI
+    serialSignalRxEvent();
 }
 
 /************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
@@ -52,6 +52,7 @@
 #include "usbd_cdc.h"
 #include "usbd_cdc_interface.h"
 #include "stdbool.h"
+#include "drivers/serial.h"
 #include "drivers/time.h"
 
 /* Private typedef -----------------------------------------------------------*/
@@ -265,6 +266,7 @@ static int8_t CDC_Itf_Receive(uint8_t* Buf, uint32_t *Len)
 {
     rxAvailable = *Len;
     rxBuffPtr = Buf;
+    serialSignalRxEvent();
     return (USBD_OK);
 }
 
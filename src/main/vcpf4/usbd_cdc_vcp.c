@@ -24,14 +24,16 @@
 #endif /* USB_OTG_HS_INTERNAL_DMA_ENABLED */
 
 /* Includes ------------------------------------------------------------------*/
+#include <string.h>
+
 #include "usbd_cdc_vcp.h"
 #include "stm32f4xx_conf.h"
 #include "stdbool.h"
+#include "drivers/serial.h"
 #include "drivers/time.h"
 
 LINE_CODING g_lc;
 
-extern __IO uint8_t USB_Tx_State;
 __IO uint32_t bDeviceState = UNCONNECTED; /* USB device status */
 
 /* These are external variables imported from CDC core to be used for IN transfer management. */
@@ -174,6 +176,43 @@ uint32_t CDC_Send_FreeBytes(void)
     return ((APP_Rx_ptr_out - APP_Rx_ptr_in) + (-((int)(APP_Rx_ptr_out <= APP_Rx_ptr_in)) & APP_RX_DATA_SIZE)) - 1;
 }
 
+/*******************************************************************************
+ * Function Name  : CDC_Send_Reserve.
+ * Description    : Point *data at the free space in the IN buffer that can be
+ *                  written without wrapping. Nothing is sent until the bytes
+ *                  are published with CDC_Send_Commit().
+ * Input          : None.
+ * Output         : Where to write.
+ * Return         : Number of bytes that can be written there.
+ *******************************************************************************/
+uint32_t CDC_Send_Reserve(uint8_t **data)
+{
+    const uint32_t in = APP_Rx_ptr_in;
+    // The CDC core leaves ptr_out at the end of the buffer until its next transfer
+    const uint32_t out = APP_Rx_ptr_out % APP_RX_DATA_SIZE;
+
+    *data = &APP_Rx_Buffer[in];
+    if (out > in) {
+        return out - in - 1;
+    }
+    return APP_RX_DATA_SIZE - in - (out == 0 ? 1 : 0);
+}
+
+/*******************************************************************************
+ * Function Name  : CDC_Send_Commit.
+ * Description    : Publish count bytes written after CDC_Send_Reserve(), for
+ *                  the CDC core to send from the next SOF on.
+ * Input          : Number of bytes, no more than CDC_Send_Reserve() returned.
+ * Output         : None.
+ * Return         : None.
+ *******************************************************************************/
+void CDC_Send_Commit(uint32_t count)
+{
+    // The data has to be in the buffer before the SOF interrupt can see the new ptr_in
+    __DMB();
+    APP_Rx_ptr_in = (APP_Rx_ptr_in + count) % APP_RX_DATA_SIZE;
+}
+
 /**
  * @brief  VCP_DataTx
  *         CDC data to be sent to the Host (app) over USB
@@ -184,19 +223,23 @@ uint32_t CDC_Send_FreeBytes(void)
 static uint16_t VCP_DataTx(const uint8_t* Buf, uint32_t Len)
 {
     /*
-        make sure that any paragraph end frame is not in play
-        could just check for: USB_CDC_ZLP, but better to be safe
-        and wait for any existing transmission to complete.
+        The CDC core only ever reads between ptr_out and the ptr_in it saw at the start of a transfer, so data can be
+        added while a transfer is in progress. It is copied in at most two pieces per pass, and the transfer starts
+        on the next SOF.
     */
-    while (USB_Tx_State != 0);
-
-    for (uint32_t i = 0; i < Len; i++) {
-        APP_Rx_Buffer[APP_Rx_ptr_in] = Buf[i];
-        APP_Rx_ptr_in = (APP_Rx_ptr_in + 1) % APP_RX_DATA_SIZE;
-
-        while (CDC_Send_FreeBytes() == 0) {
+    while (Len > 0) {
+        uint8_t *data;
+        const uint32_t space = CDC_Send_Reserve(&data);
+        if (space == 0) {
             delay(1);
+            continue;
         }
+
+        const uint32_t count = Len < space ? Len : space;
+        memcpy(data, Buf, count);
+        CDC_Send_Commit(count);
+        Buf += count;
+        Len -= count;
     }
 
     return USBD_OK;
@@ -252,6 +295,7 @@ static uint16_t VCP_DataRx(uint8_t* Buf, uint32_t Len)
         APP_Tx_Buffer[APP_Tx_ptr_in] = Buf[i];
         APP_Tx_ptr_in = (APP_Tx_ptr_in + 1) % APP_TX_DATA_SIZE;
     }
+    serialSignalRxEvent();
 
     return USBD_OK;
 }
@@ -53,7 +53,7 @@
 #define CDC_DATA_MAX_PACKET_SIZE       64   /* Endpoint IN & OUT Packet size */
 #define CDC_CMD_PACKET_SZE             8    /* Control Endpoint Packet size */
 
-#define CDC_IN_FRAME_INTERVAL          15    /* Number of frames between IN transfers */
+#define CDC_IN_FRAME_INTERVAL          1     /* Number of frames between IN transfers, a transfer is as many 64 byte packets as there is data for */
 #define APP_RX_DATA_SIZE               2048  /* Total size of IN (outbound from FC) buffer:
                                                  APP_RX_DATA_SIZE*8/MAX_BAUDARATE*1000 should be > CDC_IN_FRAME_INTERVAL */
 #define APP_TX_DATA_SIZE               2048  /* total size of the OUT (inbound to FC) buffer */
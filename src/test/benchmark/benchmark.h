@@ -0,0 +1,54 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/*
+ * Host micro benchmarks of the hot paths. A benchmark runs its code the given number of times,
+ * benchmark_main.cc picks the count, times the runs and compares them with a saved baseline.
+ *
+ * BENCHMARK(filterApply)
+ * {
+ *     for (uint32_t i = 0; i < iterations; i++) {
+ *         benchmarkKeep(filterApply(&filter, input[i & 0xff]));
+ *     }
+ * }
+ */
+
+typedef void benchmarkFunc_t(uint32_t iterations);
+
+int benchmarkRegister(const char *name, benchmarkFunc_t *fn);
+
+#define BENCHMARK(name) \
+    static void name(uint32_t iterations); \
+    static const int name##Registered __attribute__((unused)) = benchmarkRegister(#name, name); \
+    static void name(uint32_t iterations)
+
+// makes the compiler produce a value the benchmark has no other use for
+template <typename T>
+inline void benchmarkKeep(const T &value)
+{
+    __asm__ volatile("" : : "r,m"(value) : "memory");
+}
+
+// makes the compiler assume any memory may have been read or written
+inline void benchmarkClobber(void)
+{
+    __asm__ volatile("" : : : "memory");
+}
@@ -0,0 +1,181 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "benchmark.h"
+
+/*
+ * Runs every registered benchmark and reports the time per iteration, the best of a few repeats
+ * so that the figure is what the code costs rather than what the host was doing at the time.
+ *
+ *   --out=<file>        write the results as name,ns per iteration
+ *   --baseline=<file>   results saved by an earlier --out, a benchmark slower than that by more than
+ *                       the tolerance is a regression and makes the exit status non zero
+ *   --tolerance=<pct>   allowed slow down, 10% by default
+ *   --filter=<text>     only run the benchmarks with text in their name
+ */
+
+#define BENCHMARK_MIN_RUN_NS    20000000    // a timed run is at least this long, well above the clock resolution
+#define BENCHMARK_REPEATS       5
+#define BENCHMARK_TOLERANCE_PCT 10.0
+
+typedef struct benchmark_s {
+    const char *name;
+    benchmarkFunc_t *fn;
+} benchmark_t;
+
+static std::vector<benchmark_t> &benchmarks(void)
+{
+    static std::vector<benchmark_t> registered;
+    return registered;
+}
+
+int benchmarkRegister(const char *name, benchmarkFunc_t *fn)
+{
+    benchmarks().push_back({ name, fn });
+    return 0;
+}
+
+static uint64_t nowNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static uint64_t timeRun(benchmarkFunc_t *fn, uint32_t iterations)
+{
+    const uint64_t start = nowNs();
+    fn(iterations);
+    return nowNs() - start;
+}
+
+static double runBenchmark(const benchmark_t *benchmark, uint32_t *iterationsOut)
+{
+    // doubling the count also warms the caches and the branch predictors up
+    uint32_t iterations = 1;
+    while (timeRun(benchmark->fn, iterations) < BENCHMARK_MIN_RUN_NS && iterations < (1u << 30)) {
+        iterations *= 2;
+    }
+
+    double best = 0;
+    for (int i = 0; i < BENCHMARK_REPEATS; i++) {
+        const double ns = (double)timeRun(benchmark->fn, iterations) / iterations;
+        if (i == 0 || ns < best) {
+            best = ns;
+        }
+    }
+    *iterationsOut = iterations;
+    return best;
+}
+
+static std::map<std::string, double> readResults(const char *path)
+{
+    std::map<std::string, double> results;
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "no baseline in %s, nothing to compare with\n", path);
+        return results;
+    }
+    char name[128];
+    double ns;
+    while (fscanf(file, "%127[^,\n],%lf\n", name, &ns) == 2) {
+        results[name] = ns;
+    }
+    fclose(file);
+    return results;
+}
+
+static const char *option(const char *arg, const char *name)
+{
+    const size_t length = strlen(name);
+    return strncmp(arg, name, length) == 0 ? arg + length : NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *outPath = NULL;
+    const char *baselinePath = NULL;
+    const char *filter = NULL;
+    double tolerance = BENCHMARK_TOLERANCE_PCT;
+
+    for (int i = 1; i < argc; i++) {
+        const char *value;
+        if ((value = option(argv[i], "--out="))) {
+            outPath = value;
+        } else if ((value = option(argv[i], "--baseline="))) {
+            baselinePath = value;
+        } else if ((value = option(argv[i], "--tolerance="))) {
+            tolerance = atof(value);
+        } else if ((value = option(argv[i], "--filter="))) {
+            filter = value;
+        } else {
+            fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    const std::map<std::string, double> baseline = baselinePath ? readResults(baselinePath) : std::map<std::string, double>();
+    FILE *out = NULL;
+    if (outPath && !(out = fopen(outPath, "w"))) {
+        fprintf(stderr, "can not write %s\n", outPath);
+        return 2;
+    }
+
+    int regressions = 0;
+    printf("%-40s %12s %12s %10s\n", "benchmark", "ns/iter", "iterations", "change");
+    for (const benchmark_t &benchmark : benchmarks()) {
+        if (filter && !strstr(benchmark.name, filter)) {
+            continue;
+        }
+
+        uint32_t iterations;
+        const double ns = runBenchmark(&benchmark, &iterations);
+        printf("%-40s %12.3f %12u", benchmark.name, ns, iterations);
+
+        const auto saved = baseline.find(benchmark.name);
+        if (saved != baseline.end() && saved->second > 0) {
+            const double change = 100.0 * (ns - saved->second) / saved->second;
+            const bool regressed = change > tolerance;
+            printf(" %+9.1f%%%s", change, regressed ? "  REGRESSION" : "");
+            regressions += regressed;
+        }
+        printf("\n");
+
+        if (out) {
+            fprintf(out, "%s,%.3f\n", benchmark.name, ns);
+        }
+    }
+
+    if (out) {
+        fclose(out);
+    }
+    if (regressions) {
+        printf("%d benchmark(s) more than %.1f%% slower than the baseline\n", regressions, tolerance);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,89 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdarg.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "blackbox/blackbox_encoding.h"
+    #include "blackbox/blackbox_io.h"
+}
+
+#include "benchmark.h"
+
+#define FRAME_COUNT 64  // power of two
+
+// the bytes only go to a counter, so the figures are the encoding alone
+static uint32_t bytesWritten;
+
+static int32_t frames[FRAME_COUNT][8];
+
+// small deltas with the odd zero field and the odd large one, as P frames have
+static const int framesReady = []() {
+    for (int i = 0; i < FRAME_COUNT; i++) {
+        for (int j = 0; j < 8; j++) {
+            const int32_t value = ((i * 31 + j * 17) % 41) - 20;
+            frames[i][j] = (i + j) % 5 == 0 ? 0 : (i + j) % 13 == 0 ? value * 1000 : value;
+        }
+    }
+    return 0;
+}();
+
+BENCHMARK(blackboxWriteTag8_8SVB)
+{
+    for (uint32_t i = 0; i < iterations; i++) {
+        blackboxWriteTag8_8SVB(frames[i & (FRAME_COUNT - 1)], 8);
+    }
+    benchmarkKeep(bytesWritten);
+}
+
+BENCHMARK(blackboxWriteTag8_4S16)
+{
+    for (uint32_t i = 0; i < iterations; i++) {
+        blackboxWriteTag8_4S16(frames[i & (FRAME_COUNT - 1)]);
+    }
+    benchmarkKeep(bytesWritten);
+}
+
+BENCHMARK(blackboxWriteTag2_3S32)
+{
+    for (uint32_t i = 0; i < iterations; i++) {
+        blackboxWriteTag2_3S32(frames[i & (FRAME_COUNT - 1)]);
+    }
+    benchmarkKeep(bytesWritten);
+}
+
+BENCHMARK(blackboxWriteSignedVBArray)
+{
+    for (uint32_t i = 0; i < iterations; i++) {
+        blackboxWriteSignedVBArray(frames[i & (FRAME_COUNT - 1)], 8);
+    }
+    benchmarkKeep(bytesWritten);
+}
+
+// STUBS
+
+extern "C" {
+    int32_t blackboxHeaderBudget;
+
+    void blackboxWrite(uint8_t value) { bytesWritten += value | 1; }
+    void blackboxWriteBuf(const uint8_t *data, int count) { bytesWritten += data[0] + count; }
+    int blackboxPrint(const char *s) { bytesWritten += s[0]; return 1; }
+    int tfp_format(void *, void (*)(void *, char), const char *, va_list) { return 0; }
+}
@@ -0,0 +1,109 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <math.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "common/filter.h"
+    #include "common/maths.h"
+}
+
+#include "benchmark.h"
+
+#define SAMPLE_COUNT    256 // power of two
+#define LOOPTIME_US     125
+
+static float samples[SAMPLE_COUNT];
+
+// a tone with some noise on it, as a gyro axis would give
+static const int samplesReady = []() {
+    for (int i = 0; i < SAMPLE_COUNT; i++) {
+        samples[i] = 200.0f * sinf(2 * M_PIf * i / SAMPLE_COUNT) + (float)((i * 7919) % 97) - 48.0f;
+    }
+    return 0;
+}();
+
+BENCHMARK(biquadFilterApply_lpf)
+{
+    biquadFilter_t filter;
+    biquadFilterInitLPF(&filter, 100, LOOPTIME_US);
+    for (uint32_t i = 0; i < iterations; i++) {
+        benchmarkKeep(biquadFilterApply(&filter, samples[i & (SAMPLE_COUNT - 1)]));
+    }
+}
+
+BENCHMARK(biquadFilterApply_notch)
+{
+    biquadFilter_t filter;
+    biquadFilterInit(&filter, 260, LOOPTIME_US, filterGetNotchQ(260, 160), FILTER_NOTCH);
+    for (uint32_t i = 0; i < iterations; i++) {
+        benchmarkKeep(biquadFilterApply(&filter, samples[i & (SAMPLE_COUNT - 1)]));
+    }
+}
+
+BENCHMARK(biquadFilterApplyDF1)
+{
+    biquadFilter_t filter;
+    biquadFilterInitLPF(&filter, 100, LOOPTIME_US);
+    for (uint32_t i = 0; i < iterations; i++) {
+        benchmarkKeep(biquadFilterApplyDF1(&filter, samples[i & (SAMPLE_COUNT - 1)]));
+    }
+}
+
+BENCHMARK(biquadFilterXyzApply)
+{
+    biquadFilterXyz_t filter;
+    biquadFilterXyzInitLPF(&filter, 100, LOOPTIME_US);
+    for (uint32_t i = 0; i < iterations; i++) {
+        float values[XYZ_AXIS_COUNT] = { samples[i & (SAMPLE_COUNT - 1)], samples[(i + 1) & (SAMPLE_COUNT - 1)], samples[(i + 2) & (SAMPLE_COUNT - 1)] };
+        biquadFilterXyzApply(&filter, values);
+        benchmarkKeep(values);
+    }
+}
+
+BENCHMARK(pt1FilterApply)
+{
+    pt1Filter_t filter;
+    pt1FilterInit(&filter, 100, LOOPTIME_US * 1e-6f);
+    for (uint32_t i = 0; i < iterations; i++) {
+        benchmarkKeep(pt1FilterApply(&filter, samples[i & (SAMPLE_COUNT - 1)]));
+    }
+}
+
+BENCHMARK(firFilterUpdate)
+{
+    float buf[8];
+    firFilter_t filter;
+    firFilterInit(&filter, buf, 8, NULL);
+    for (uint32_t i = 0; i < iterations; i++) {
+        firFilterUpdate(&filter, samples[i & (SAMPLE_COUNT - 1)]);
+        benchmarkClobber();
+    }
+    benchmarkKeep(buf);
+}
+
+BENCHMARK(firFilterDenoiseUpdate)
+{
+    static firFilterDenoise_t filter;
+    firFilterDenoiseInit(&filter, 100, LOOPTIME_US);
+    for (uint32_t i = 0; i < iterations; i++) {
+        benchmarkKeep(firFilterDenoiseUpdate(&filter, samples[i & (SAMPLE_COUNT - 1)]));
+    }
+}
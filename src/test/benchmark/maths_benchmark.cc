@@ -0,0 +1,114 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <math.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "common/crc.h"
+    #include "common/maths.h"
+}
+
+#include "benchmark.h"
+
+#define SAMPLE_COUNT    256 // power of two
+
+static float angles[SAMPLE_COUNT];
+static float ys[SAMPLE_COUNT];
+static float xs[SAMPLE_COUNT];
+static uint8_t frame[64];
+
+// spread over the whole range, so every branch of the approximations is taken
+static const int samplesReady = []() {
+    for (int i = 0; i < SAMPLE_COUNT; i++) {
+        angles[i] = -M_PIf + 2 * M_PIf * i / SAMPLE_COUNT;
+        ys[i] = 500.0f * sinf(angles[i]);
+        xs[i] = 500.0f * cosf(3 * angles[i]);
+    }
+    for (unsigned i = 0; i < sizeof(frame); i++) {
+        frame[i] = i * 37;
+    }
+    return 0;
+}();
+
+BENCHMARK(sin_approx)
+{
+    for (uint32_t i = 0; i < iterations; i++) {
+        benchmarkKeep(sin_approx(angles[i & (SAMPLE_COUNT - 1)]));
+    }
+}
+
+BENCHMARK(cos_approx)
+{
+    for (uint32_t i = 0; i < iterations; i++) {
+        benchmarkKeep(cos_approx(angles[i & (SAMPLE_COUNT - 1)]));
+    }
+}
+
+// against sin_approx plus cos_approx of the same angle
+BENCHMARK(sincos_approx)
+{
+    float sinx, cosx;
+    for (uint32_t i = 0; i < iterations; i++) {
+        sincos_approx(angles[i & (SAMPLE_COUNT - 1)], &sinx, &cosx);
+        benchmarkKeep(sinx);
+        benchmarkKeep(cosx);
+    }
+}
+
+BENCHMARK(sincos3_approx)
+{
+    float sinx[3], cosx[3];
+    for (uint32_t i = 0; i < iterations; i++) {
+        sincos3_approx(&angles[i & (SAMPLE_COUNT - 4)], sinx, cosx); // 4 aligned, the three stay in the table
+        benchmarkClobber();
+    }
+}
+
+BENCHMARK(atan2_approx)
+{
+    for (uint32_t i = 0; i < iterations; i++) {
+        benchmarkKeep(atan2_approx(ys[i & (SAMPLE_COUNT - 1)], xs[i & (SAMPLE_COUNT - 1)]));
+    }
+}
+
+BENCHMARK(acos_approx)
+{
+    for (uint32_t i = 0; i < iterations; i++) {
+        benchmarkKeep(acos_approx(ys[i & (SAMPLE_COUNT - 1)] / 500.0f));
+    }
+}
+
+// per byte, the cost that matters for the MSP v2 and CRSF frames
+BENCHMARK(crc8_dvb_s2)
+{
+    uint8_t crc = 0;
+    for (uint32_t i = 0; i < iterations; i++) {
+        crc = crc8_dvb_s2(crc, frame[i & (sizeof(frame) - 1)]);
+    }
+    benchmarkKeep(crc);
+}
+
+BENCHMARK(crc8_dvb_s2_update_64)
+{
+    for (uint32_t i = 0; i < iterations; i++) {
+        benchmarkClobber();
+        benchmarkKeep(crc8_dvb_s2_update(0, frame, sizeof(frame)));
+    }
+}
@@ -0,0 +1,124 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "build/debug.h"
+
+    #include "common/axis.h"
+    #include "common/maths.h"
+
+    #include "config/parameter_group.h"
+    #include "config/parameter_group_ids.h"
+
+    #include "fc/rc_controls.h"
+    #include "fc/runtime_config.h"
+
+    #include "flight/mixer.h"
+    #include "flight/pid.h"
+
+    #include "rx/rx.h"
+}
+
+#include "benchmark.h"
+
+#define SAMPLE_COUNT    256 // power of two
+
+static float pidSums[SAMPLE_COUNT][XYZ_AXIS_COUNT];
+
+// PID sums that now and then drive the mix past the motor range, so the scaling is taken too
+static const int samplesReady = []() {
+    for (int i = 0; i < SAMPLE_COUNT; i++) {
+        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            pidSums[i][axis] = 300.0f * sinf(2 * M_PIf * (i + 50 * axis) / SAMPLE_COUNT) + (float)((i * 7919 + axis) % 61) - 30.0f;
+        }
+    }
+    return 0;
+}();
+
+static void runMixTable(mixerMode_e mixerMode, uint32_t iterations)
+{
+    pgResetAll();
+    rxConfigMutable()->mincheck = 1100;
+    rxConfigMutable()->midrc = 1500;
+    pidProfilesMutable(0)->pidSumLimit = PIDSUM_LIMIT;
+    pidProfilesMutable(0)->pidSumLimitYaw = PIDSUM_LIMIT_YAW;
+    mixerInit(mixerMode);
+    mixerConfigureOutput();
+    pidInitMixer(pidProfilesMutable(0));
+
+    for (uint32_t i = 0; i < iterations; i++) {
+        const float *sum = pidSums[i & (SAMPLE_COUNT - 1)];
+        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            axisPID_P[axis] = sum[axis];
+        }
+        rcCommand[THROTTLE] = 1200 + (i & 511);
+        mixTable(0);
+    }
+    benchmarkKeep(motor);
+}
+
+BENCHMARK(mixTable_quadx)
+{
+    runMixTable(MIXER_QUADX, iterations);
+}
+
+BENCHMARK(mixTable_octoflatx)
+{
+    runMixTable(MIXER_OCTOFLATX, iterations);
+}
+
+// STUBS
+
+extern "C" {
+    PG_REGISTER_ARRAY(pidProfile_t, MAX_PROFILE_COUNT, pidProfiles, PG_PID_PROFILE, 0);
+    PG_REGISTER(rxConfig_t, rxConfig, PG_RX_CONFIG, 0);
+    PG_REGISTER(flight3DConfig_t, flight3DConfig, PG_MOTOR_3D_CONFIG, 0);
+
+    uint8_t armingFlags;
+    uint16_t flightModeFlags;
+    uint8_t stateFlags;
+    int32_t debug[DEBUG_VALUE_COUNT];
+    uint32_t debugModeMask;
+    uint8_t debugModeOffset[DEBUG_COUNT];
+    float rcCommand[4];
+    float axisPID_P[3], axisPID_I[3], axisPID_D[3], axisPID_F[3];
+    uint32_t targetPidLooptime = 125;
+    int16_t rcData[MAX_SUPPORTED_RC_CHANNEL_COUNT];
+
+    uint32_t micros(void) { return 0; }
+    uint32_t millis(void) { return 0; }
+    void delay(uint32_t) {}
+    void delayMicroseconds(uint32_t) {}
+
+    bool feature(uint32_t) { return false; }
+    bool isAirmodeActive(void) { return true; }
+    bool isMotorsReversed(void) { return false; }
+    bool failsafeIsActive(void) { return false; }
+    float getVbatPidCompensation(void) { return 1.0f; }
+
+    bool isMotorProtocolDshot(void) { return false; }
+    bool pwmAreMotorsEnabled(void) { return true; }
+    void pwmWriteMotor(uint8_t, float) {}
+    void pwmShutdownPulsesForAllMotors(uint8_t) {}
+    void pwmCompleteMotorUpdate(uint8_t) {}
+}
@@ -0,0 +1,145 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "build/debug.h"
+
+    #include "common/axis.h"
+    #include "common/maths.h"
+
+    #include "config/parameter_group.h"
+
+    #include "drivers/accgyro/accgyro.h"
+
+    #include "fc/runtime_config.h"
+
+    #include "flight/imu.h"
+    #include "flight/pid.h"
+
+    #include "io/beeper.h"
+
+    #include "scheduler/scheduler.h"
+
+    #include "sensors/acceleration.h"
+    #include "sensors/gyro.h"
+    #include "sensors/sensors.h"
+}
+
+#include "benchmark.h"
+
+#define SAMPLE_COUNT    256 // power of two
+#define LOOPTIME_US     125
+
+extern "C" {
+    pidProfile_t *currentPidProfile;
+    gyro_t gyro;
+}
+
+static float gyroSamples[SAMPLE_COUNT][XYZ_AXIS_COUNT];
+static float setpoints[XYZ_AXIS_COUNT];
+
+// stick input on every axis and a gyro that follows it with some noise, so no term is idle
+static const int samplesReady = []() {
+    for (int i = 0; i < SAMPLE_COUNT; i++) {
+        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            gyroSamples[i][axis] = 150.0f * sinf(2 * M_PIf * (i + 40 * axis) / SAMPLE_COUNT) + (float)((i * 7919 + axis) % 31) - 15.0f;
+        }
+    }
+    return 0;
+}();
+
+static void runPidController(uint32_t iterations)
+{
+    const rollAndPitchTrims_t angleTrim = { { 0, 0 } };
+    timeUs_t currentTimeUs = 0;
+
+    for (uint32_t i = 0; i < iterations; i++) {
+        const float *sample = gyroSamples[i & (SAMPLE_COUNT - 1)];
+        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            gyro.gyroADCf[axis] = sample[axis];
+            setpoints[axis] = sample[axis] * 1.1f;
+        }
+        pidController(currentPidProfile, &angleTrim, currentTimeUs);
+        currentTimeUs += LOOPTIME_US;
+    }
+    benchmarkKeep(axisPID_P);
+}
+
+static void setUpPid(void)
+{
+    pgResetAll();
+    currentPidProfile = pidProfilesMutable(0);
+    gyro.targetLooptime = LOOPTIME_US;
+    pidSetTargetLooptime(LOOPTIME_US);
+    pidInit(currentPidProfile);
+    pidStabilisationState(PID_STABILISATION_ON);
+}
+
+// rate mode with the default profile
+BENCHMARK(pidController_acro)
+{
+    setUpPid();
+    flightModeFlags = 0;
+    runPidController(iterations);
+}
+
+// the level controller runs on roll and pitch as well
+BENCHMARK(pidController_angle)
+{
+    setUpPid();
+    flightModeFlags = ANGLE_MODE;
+    runPidController(iterations);
+    flightModeFlags = 0;
+}
+
+// STUBS
+
+extern "C" {
+    uint8_t armingFlags;
+    uint16_t flightModeFlags;
+    uint8_t stateFlags;
+    attitudeEulerAngles_t attitude;
+    int16_t GPS_angle[ANGLE_INDEX_COUNT];
+    int32_t debug[DEBUG_VALUE_COUNT];
+    uint32_t debugModeMask;
+    uint8_t debugModeOffset[DEBUG_COUNT];
+    acc_t acc;
+
+    uint32_t micros(void) { return 0; }
+    uint32_t millis(void) { return 0; }
+
+    void beeper(beeperMode_e) {}
+    void systemBeep(bool) {}
+    bool sensors(uint32_t) { return true; }
+
+    float getThrottlePIDAttenuation(void) { return 1.0f; }
+    float getMotorMixRange(void) { return 0.2f; }
+    float getSetpointRate(int axis) { return setpoints[axis]; }
+    float getSetpointRateDerivative(int axis) { return setpoints[axis] * 0.1f; }
+    float getRcDeflection(int axis) { return setpoints[axis] / 1000.0f; }
+    float getRcDeflectionAbs(int axis) { return fabsf(setpoints[axis]) / 1000.0f; }
+    void pidInitMixer(const pidProfile_t *) {}
+    bool mixerIsOutputSaturated(int, float) { return false; }
+    bool gyroYawSpinDetected(void) { return false; }
+    float gyroSampleClockScale(void) { return 1.0f; }
+}
@@ -0,0 +1,87 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "common/printf.h"
+    #include "common/typeconversion.h"
+
+    #include "drivers/serial.h"
+}
+
+#include "benchmark.h"
+
+#define SAMPLE_COUNT    256 // power of two
+
+static int32_t values[SAMPLE_COUNT];
+static char buf[32];
+
+// the spread of an OSD screen, mostly short numbers with the odd large one
+static const int samplesReady = []() {
+    for (int i = 0; i < SAMPLE_COUNT; i++) {
+        values[i] = (i * 7919) % (i & 1 ? 100 : 20000) - (i & 2 ? 50 : 0);
+    }
+    return 0;
+}();
+
+BENCHMARK(tfp_sprintf_int)
+{
+    for (uint32_t i = 0; i < iterations; i++) {
+        tfp_sprintf(buf, "%5d", values[i & (SAMPLE_COUNT - 1)]);
+        benchmarkClobber();
+    }
+}
+
+BENCHMARK(fmtInt)
+{
+    for (uint32_t i = 0; i < iterations; i++) {
+        fmtInt(buf, values[i & (SAMPLE_COUNT - 1)], 5, ' ');
+        benchmarkClobber();
+    }
+}
+
+// the battery voltage element
+BENCHMARK(tfp_sprintf_fixed)
+{
+    for (uint32_t i = 0; i < iterations; i++) {
+        const int32_t value = values[i & (SAMPLE_COUNT - 1)] & 0x1ff;
+        tfp_sprintf(buf, "%d.%1dV", value / 10, value % 10);
+        benchmarkClobber();
+    }
+}
+
+BENCHMARK(fmtFixed)
+{
+    for (uint32_t i = 0; i < iterations; i++) {
+        char *p = fmtFixed(buf, values[i & (SAMPLE_COUNT - 1)] & 0x1ff, 1, 0);
+        *p++ = 'V';
+        *p = '\0';
+        benchmarkClobber();
+    }
+}
+
+// STUBS
+
+extern "C" {
+void serialWrite(serialPort_t *, uint8_t) {}
+uint32_t serialTxBytesFree(const serialPort_t *) { return 0; }
+bool isSerialTransmitBufferEmpty(const serialPort_t *) { return true; }
+}
@@ -0,0 +1,118 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+extern "C" {
+    #include "platform.h"
+    #include "build/debug.h"
+
+    #include "common/utils.h"
+
+    #include "scheduler/scheduler.h"
+}
+
+#include "benchmark.h"
+
+#define TASK_RUN_US 20
+#define TASK_PERIOD_HZ(hz) (1000000 / (hz))
+
+static void benchTask(timeUs_t);
+static bool benchCheck(timeUs_t, timeDelta_t);
+
+extern "C" {
+    int32_t debug[DEBUG_VALUE_COUNT];
+    uint32_t debugModeMask;
+    uint8_t debugModeOffset[DEBUG_COUNT];
+
+    // every reading moves the clock a little, every task run a lot more
+    static uint32_t simulatedTime;
+    uint32_t micros(void) { return simulatedTime++; }
+
+    // the rates and priorities of the flight code, with tasks that do nothing but take time
+    cfTask_t cfTasks[TASK_COUNT] = {
+        [TASK_SYSTEM] =             { "SYSTEM", NULL, NULL, taskSystem, TASK_PERIOD_HZ(10), TASK_PRIORITY_MEDIUM_HIGH },
+        [TASK_GYROPID] =            { "PID", NULL, NULL, benchTask, TASK_PERIOD_HZ(8000), TASK_PRIORITY_REALTIME },
+        [TASK_ACCEL] =              { "ACC", NULL, NULL, benchTask, TASK_PERIOD_HZ(1000), TASK_PRIORITY_MEDIUM },
+        [TASK_ATTITUDE] =           { "ATTITUDE", NULL, NULL, benchTask, TASK_PERIOD_HZ(100), TASK_PRIORITY_MEDIUM },
+        [TASK_RX] =                 { "RX", NULL, benchCheck, benchTask, TASK_PERIOD_HZ(50), TASK_PRIORITY_HIGH },
+        [TASK_SERIAL] =             { "SERIAL", NULL, NULL, benchTask, TASK_PERIOD_HZ(100), TASK_PRIORITY_LOW },
+        [TASK_DISPATCH] =           { "DISPATCH", NULL, NULL, benchTask, TASK_PERIOD_HZ(1000), TASK_PRIORITY_HIGH },
+        [TASK_BATTERY_VOLTAGE] =    { "BATTERY_VOLTAGE", NULL, NULL, benchTask, TASK_PERIOD_HZ(50), TASK_PRIORITY_MEDIUM },
+        [TASK_BATTERY_CURRENT] =    { "BATTERY_CURRENT", NULL, NULL, benchTask, TASK_PERIOD_HZ(50), TASK_PRIORITY_MEDIUM },
+        [TASK_BATTERY_ALERTS] =     { "BATTERY_ALERTS", NULL, NULL, benchTask, TASK_PERIOD_HZ(5), TASK_PRIORITY_LOW },
+        [TASK_BEEPER] =             { "BEEPER", NULL, NULL, benchTask, TASK_PERIOD_HZ(100), TASK_PRIORITY_LOW },
+        [TASK_BLACKBOX] =           { "BLACKBOX", NULL, NULL, benchTask, TASK_PERIOD_HZ(1000), TASK_PRIORITY_LOW },
+        [TASK_GPS] =                { "GPS", NULL, NULL, benchTask, TASK_PERIOD_HZ(100), TASK_PRIORITY_MEDIUM },
+        [TASK_COMPASS] =            { "COMPASS", NULL, NULL, benchTask, TASK_PERIOD_HZ(10), TASK_PRIORITY_LOW },
+        [TASK_BARO] =               { "BARO", NULL, NULL, benchTask, TASK_PERIOD_HZ(20), TASK_PRIORITY_LOW },
+        [TASK_ALTITUDE] =           { "ALTITUDE", NULL, NULL, benchTask, TASK_PERIOD_HZ(40), TASK_PRIORITY_LOW },
+    };
+}
+
+static const cfTaskId_e enabledOrder[] = {
+    TASK_SYSTEM, TASK_GYROPID, TASK_RX, TASK_SERIAL,
+    TASK_ACCEL, TASK_ATTITUDE, TASK_DISPATCH, TASK_BATTERY_VOLTAGE,
+    TASK_BATTERY_CURRENT, TASK_BATTERY_ALERTS, TASK_BEEPER, TASK_BLACKBOX,
+    TASK_GPS, TASK_COMPASS, TASK_BARO, TASK_ALTITUDE,
+};
+
+static void benchTask(timeUs_t)
+{
+    simulatedTime += TASK_RUN_US;
+}
+
+static bool benchCheck(timeUs_t, timeDelta_t currentDeltaTimeUs)
+{
+    return currentDeltaTimeUs > TASK_PERIOD_HZ(50);
+}
+
+static void runScheduler(unsigned taskCount, uint32_t iterations)
+{
+    simulatedTime = 0;
+    for (unsigned i = 0; i < ARRAYLEN(enabledOrder); i++) {
+        cfTask_t *task = &cfTasks[enabledOrder[i]];
+        task->dynamicPriority = 0;
+        task->lastExecutedAt = 0;
+        task->lastSignaledAt = 0;
+        setTaskEnabled(enabledOrder[i], false);
+    }
+    schedulerInit();
+    for (unsigned i = 0; i < taskCount; i++) {
+        setTaskEnabled(enabledOrder[i], true);
+    }
+
+    for (uint32_t i = 0; i < iterations; i++) {
+        scheduler();
+    }
+}
+
+BENCHMARK(scheduler_4_tasks)
+{
+    runScheduler(4, iterations);
+}
+
+BENCHMARK(scheduler_8_tasks)
+{
+    runScheduler(8, iterations);
+}
+
+BENCHMARK(scheduler_16_tasks)
+{
+    runScheduler(ARRAYLEN(enabledOrder), iterations);
+}
@@ -0,0 +1,450 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+extern "C" {
+    #include "platform.h"
+    #include "build/debug.h"
+
+    #include "common/maths.h"
+    #include "common/utils.h"
+
+    #include "scheduler/scheduler.h"
+}
+
+/*
+ * Runs scheduler.c on a virtual clock, with tasks that do nothing but take time, so the scheduling
+ * of the flight code can be studied on the host. Every task run takes a time drawn from the
+ * distribution of that task, the event-driven tasks are signalled by synthetic sources at their
+ * rate, and the report gives what the flight code would see: the jitter of the PID loop, the PID
+ * periods it missed and how long each task waited for its turn. The Makefile builds this once per
+ * scheduler variant, so a change to the scheduler is judged by running the same load through all.
+ *
+ *   --profile=<file>    execution times from a target, the output of the CLI 'tasks hist' command.
+ *                       Only the tasks listed are run, SYSTEM and PID always are. Its figures are
+ *                       histogram bucket upper bounds, so a profile errs on the slow side.
+ *   --seconds=<n>       simulated time, 10 by default
+ *   --seed=<n>          runs with the same seed, profile and options are identical
+ *   --pid-hz=<n>        PID loop rate, 8000 by default
+ *   --rx-hz=<n>         rate of the RX frames, 150 by default
+ *   --rx-deadline       RX frames are event deadlines, as with rx frame event scheduling
+ *   --scale=<factor>    multiplies the execution times of every task but the PID loop
+ *   --pass-us=<us>      time a scheduler pass takes before it runs a task, 2 by default
+ */
+
+#define SIM_SECONDS_DEFAULT     10
+#define SIM_SECONDS_MAX         3600    // timeUs_t wraps after 71 minutes
+#define SIM_PID_HZ_DEFAULT      8000
+#define SIM_RX_HZ_DEFAULT       150
+#define SIM_PASS_US_DEFAULT     2.0f
+#define SIM_EVENT_JITTER        0.1f    // events arrive within this part of their period of the nominal time
+#define SIM_EXEC_TAIL           1.25f   // longest run past p99.9, which a profile does not say
+
+#define TASK_PERIOD_HZ(hz) (1000000 / (hz))
+
+typedef struct simTask_s {
+    // load
+    float execUs[3];            // p50, p99 and p99.9 of the execution time, all 0 if the task is not run
+    float eventHz;              // rate of the events signalling an event-driven task
+
+    // events
+    uint64_t nextEventNs;
+    uint64_t pendingSinceNs;
+    bool pending;
+
+    // results
+    uint64_t lastStartNs;
+    uint64_t execNs;
+    uint32_t runs;
+    uint32_t missed;            // whole periods skipped, or events replaced by the next before the task ran
+    std::vector<float> latencyUs;
+    std::vector<float> intervalUs;
+} simTask_t;
+
+static simTask_t simTasks[TASK_COUNT];
+static uint64_t simTimeNs;
+static float simScale = 1.0f;
+static uint64_t simRandomState;
+
+template <cfTaskId_e taskId> static void simTaskRun(timeUs_t currentTimeUs);
+template <cfTaskId_e taskId> static bool simTaskCheck(timeUs_t currentTimeUs, timeDelta_t currentDeltaTimeUs);
+static void simTaskSystem(timeUs_t currentTimeUs);
+
+#define SIM_TIME_TASK(id, name, hz, priority, sheddable) \
+    [id] = { name, NULL, NULL, simTaskRun<id>, TASK_PERIOD_HZ(hz), priority, sheddable }
+#define SIM_EVENT_TASK(id, name, hz, priority) \
+    [id] = { name, NULL, simTaskCheck<id>, simTaskRun<id>, TASK_PERIOD_HZ(hz), priority }
+
+extern "C" {
+    int32_t debug[DEBUG_VALUE_COUNT];
+    uint32_t debugModeMask;
+    uint8_t debugModeOffset[DEBUG_COUNT];
+
+    uint32_t micros(void) { return simTimeNs / 1000; }
+
+    // the rates, priorities and shedding of fc_tasks.c
+    cfTask_t cfTasks[TASK_COUNT] = {
+        [TASK_SYSTEM] = { "SYSTEM", NULL, NULL, simTaskSystem, TASK_PERIOD_HZ(10), TASK_PRIORITY_MEDIUM_HIGH },
+        SIM_TIME_TASK(TASK_GYROPID, "PID", SIM_PID_HZ_DEFAULT, TASK_PRIORITY_REALTIME, false),
+        SIM_TIME_TASK(TASK_ACCEL, "ACCEL", 1000, TASK_PRIORITY_MEDIUM, false),
+        SIM_TIME_TASK(TASK_ATTITUDE, "ATTITUDE", 100, TASK_PRIORITY_MEDIUM, false),
+        SIM_EVENT_TASK(TASK_RX, "RX", 50, TASK_PRIORITY_HIGH),
+        SIM_EVENT_TASK(TASK_SERIAL, "SERIAL", 100, TASK_PRIORITY_LOW),
+        SIM_TIME_TASK(TASK_DISPATCH, "DISPATCH", 1000, TASK_PRIORITY_HIGH, false),
+        SIM_TIME_TASK(TASK_BATTERY_VOLTAGE, "BATTERY_VOLTAGE", 50, TASK_PRIORITY_MEDIUM, false),
+        SIM_TIME_TASK(TASK_BATTERY_CURRENT, "BATTERY_CURRENT", 50, TASK_PRIORITY_MEDIUM, false),
+        SIM_TIME_TASK(TASK_BATTERY_ALERTS, "BATTERY_ALERTS", 5, TASK_PRIORITY_MEDIUM, false),
+        SIM_TIME_TASK(TASK_BEEPER, "BEEPER", 100, TASK_PRIORITY_LOW, false),
+        SIM_EVENT_TASK(TASK_BLACKBOX, "BLACKBOX", 1000, TASK_PRIORITY_MEDIUM),
+        SIM_TIME_TASK(TASK_GPS, "GPS", 100, TASK_PRIORITY_MEDIUM, false),
+        SIM_TIME_TASK(TASK_COMPASS, "COMPASS", 40, TASK_PRIORITY_LOW, true),
+        SIM_TIME_TASK(TASK_BARO, "BARO", 20, TASK_PRIORITY_LOW, false),
+        SIM_TIME_TASK(TASK_ALTITUDE, "ALTITUDE", 40, TASK_PRIORITY_LOW, false),
+        SIM_TIME_TASK(TASK_DASHBOARD, "DASHBOARD", 100, TASK_PRIORITY_LOW, true),
+        SIM_TIME_TASK(TASK_TELEMETRY, "TELEMETRY", 250, TASK_PRIORITY_LOW, true),
+        SIM_TIME_TASK(TASK_LEDSTRIP, "LEDSTRIP", 100, TASK_PRIORITY_LOW, true),
+        SIM_TIME_TASK(TASK_TRANSPONDER, "TRANSPONDER", 250, TASK_PRIORITY_LOW, false),
+        SIM_TIME_TASK(TASK_OSD, "OSD", 60, TASK_PRIORITY_LOW, false),
+        SIM_TIME_TASK(TASK_CMS, "CMS", 60, TASK_PRIORITY_LOW, false),
+    };
+}
+
+typedef struct simLoad_s {
+    cfTaskId_e taskId;
+    float execUs[3];
+    float eventHz;
+} simLoad_t;
+
+// used without a profile, roughly an F4 at 8kHz with a receiver, blackbox, GPS and OSD
+static const simLoad_t defaultLoad[] = {
+    { TASK_SYSTEM,          { 3, 5, 8 },        0 },
+    { TASK_GYROPID,         { 45, 60, 80 },     0 },
+    { TASK_ACCEL,           { 12, 16, 20 },     0 },
+    { TASK_ATTITUDE,        { 25, 32, 40 },     0 },
+    { TASK_RX,              { 25, 50, 90 },     SIM_RX_HZ_DEFAULT },
+    { TASK_SERIAL,          { 15, 150, 400 },   10 },
+    { TASK_DISPATCH,        { 1, 2, 3 },        0 },
+    { TASK_BATTERY_VOLTAGE, { 6, 10, 14 },      0 },
+    { TASK_BATTERY_CURRENT, { 4, 6, 10 },       0 },
+    { TASK_BATTERY_ALERTS,  { 3, 5, 8 },        0 },
+    { TASK_BEEPER,          { 2, 4, 6 },        0 },
+    { TASK_BLACKBOX,        { 20, 45, 120 },    1000 },
+    { TASK_GPS,             { 8, 25, 60 },      0 },
+    { TASK_COMPASS,         { 10, 15, 25 },     0 },
+    { TASK_BARO,            { 10, 20, 30 },     0 },
+    { TASK_ALTITUDE,        { 6, 10, 15 },      0 },
+    { TASK_TELEMETRY,       { 3, 20, 60 },      0 },
+    { TASK_LEDSTRIP,        { 5, 60, 120 },     0 },
+    { TASK_OSD,             { 20, 400, 900 },   0 },
+};
+
+// xorshift64*, the same sequence on every host
+static float simRandom(void)
+{
+    simRandomState ^= simRandomState >> 12;
+    simRandomState ^= simRandomState << 25;
+    simRandomState ^= simRandomState >> 27;
+    return (float)((simRandomState * 0x2545F4914F6CDD1DULL) >> 40) / (float)(1 << 24);
+}
+
+// Draws from the distribution through the three percentiles, linear in between, the fastest run half the median
+static float simExecutionTimeUs(const simTask_t *task)
+{
+    static const float quantile[] = { 0.0f, 0.5f, 0.99f, 0.999f, 1.0f };
+    const float value[] = { task->execUs[0] / 2, task->execUs[0], task->execUs[1], task->execUs[2], task->execUs[2] * SIM_EXEC_TAIL };
+
+    const float u = simRandom();
+    int i = 1;
+    while (i < (int)ARRAYLEN(quantile) - 1 && u > quantile[i]) {
+        i++;
+    }
+    return value[i - 1] + (value[i] - value[i - 1]) * (u - quantile[i - 1]) / (quantile[i] - quantile[i - 1]);
+}
+
+static void simEventsUpdate(simTask_t *task)
+{
+    if (task->eventHz <= 0) {
+        return;
+    }
+    const float periodNs = 1e9f / task->eventHz;
+    while (task->nextEventNs <= simTimeNs) {
+        if (task->pending) {
+            task->missed++;
+        } else {
+            task->pendingSinceNs = task->nextEventNs;
+            task->pending = true;
+        }
+        task->nextEventNs += (uint64_t)(periodNs * (1.0f + SIM_EVENT_JITTER * (2 * simRandom() - 1)));
+    }
+}
+
+template <cfTaskId_e taskId>
+static bool simTaskCheck(timeUs_t currentTimeUs, timeDelta_t currentDeltaTimeUs)
+{
+    UNUSED(currentTimeUs);
+    UNUSED(currentDeltaTimeUs);
+
+    simTask_t *task = &simTasks[taskId];
+    simEventsUpdate(task);
+    return task->pending;
+}
+
+template <cfTaskId_e taskId>
+static void simTaskRun(timeUs_t currentTimeUs)
+{
+    simTask_t *task = &simTasks[taskId];
+    const cfTask_t *cfTask = &cfTasks[taskId];
+
+    if (cfTask->checkFunc) {
+        simEventsUpdate(task);
+        if (task->pending) {
+            task->latencyUs.push_back((simTimeNs - task->pendingSinceNs) / 1000.0f);
+            task->pending = false;
+        }
+    } else if (task->runs) {
+        // the scheduler took the pass start as the time of this run, and no time passes before the task is called
+        const timeDelta_t lateness = cmpTimeUs(currentTimeUs, task->lastStartNs / 1000) - cfTask->desiredPeriod;
+        task->latencyUs.push_back(MAX(lateness, 0));
+        task->missed += MAX(lateness, 0) / cfTask->desiredPeriod;
+    }
+    if (task->runs) {
+        task->intervalUs.push_back((simTimeNs - task->lastStartNs) / 1000.0f);
+    }
+    task->lastStartNs = simTimeNs;
+    task->runs++;
+
+    const float scale = taskId == TASK_GYROPID ? 1.0f : simScale;
+    const uint64_t execNs = (uint64_t)(simExecutionTimeUs(task) * scale * 1000);
+    task->execNs += execNs;
+    simTimeNs += execNs;
+}
+
+static void simTaskSystem(timeUs_t currentTimeUs)
+{
+    taskSystem(currentTimeUs);
+    simTaskRun<TASK_SYSTEM>(currentTimeUs);
+}
+
+static cfTaskId_e simTaskByName(const char *name)
+{
+    for (int taskId = 0; taskId < TASK_COUNT; taskId++) {
+        if (strcmp(cfTasks[taskId].taskName, name) == 0) {
+            return (cfTaskId_e)taskId;
+        }
+    }
+    return TASK_NONE;
+}
+
+// Reads the lines of 'tasks hist' and ignores the rest, so a whole CLI session can be saved as a profile
+static bool simReadProfile(const char *path)
+{
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "can not read %s\n", path);
+        return false;
+    }
+
+    int loaded = 0;
+    char line[256];
+    while (fgets(line, sizeof(line), file)) {
+        int id;
+        char name[32];
+        float exec[3];
+        if (sscanf(line, "%d - (%31[^)]) %f %f %f", &id, name, &exec[0], &exec[1], &exec[2]) != 5) {
+            continue;
+        }
+        const char *trimmed = name + strspn(name, " ");
+        const cfTaskId_e taskId = simTaskByName(trimmed);
+        if (taskId == TASK_NONE) {
+            fprintf(stderr, "task %s is not simulated\n", trimmed);
+            continue;
+        }
+        for (int i = 0; i < 3; i++) {
+            // a run under a microsecond falls in bucket 0, which reads as 0
+            simTasks[taskId].execUs[i] = MAX(exec[i], 1.0f);
+        }
+        loaded++;
+    }
+    fclose(file);
+
+    if (!loaded) {
+        fprintf(stderr, "no 'tasks hist' lines in %s\n", path);
+        return false;
+    }
+    return true;
+}
+
+static float simPercentile(std::vector<float> &values, float percent)
+{
+    if (values.empty()) {
+        return 0;
+    }
+    const size_t index = std::min(values.size() - 1, (size_t)(values.size() * percent / 100));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+static void simReport(float seconds, uint32_t seed, const uint64_t sheddingTimeNs[])
+{
+    printf("scheduler:");
+#ifdef USE_SCHEDULER_DEADLINE_QUEUE
+    printf(" deadline queue");
+#else
+    printf(" queue scan");
+#endif
+#ifdef USE_SCHEDULER_LOAD_SHEDDING
+    printf(", load shedding");
+#endif
+    uint64_t busyNs = 0;
+    for (int taskId = 0; taskId < TASK_COUNT; taskId++) {
+        busyNs += simTasks[taskId].execNs;
+    }
+    printf("\nsimulated %.1fs, seed %u, tasks busy %.1f%%\n", (double)seconds, seed, 100.0 * busyNs / (seconds * 1e9));
+
+    simTask_t *pid = &simTasks[TASK_GYROPID];
+    const float periodUs = cfTasks[TASK_GYROPID].desiredPeriod;
+    double sum = 0;
+    double sumSquares = 0;
+    uint32_t late = 0;
+    for (const float interval : pid->intervalUs) {
+        sum += interval;
+        sumSquares += (double)interval * interval;
+        late += interval >= 2 * periodUs;
+    }
+    const size_t count = MAX(pid->intervalUs.size(), 1u);
+    const double mean = sum / count;
+    printf("PID loop: %.0fus period, %.0fHz achieved, interval mean %.1fus sd %.1fus max %.1fus, %u late by a period or more, %u periods missed\n",
+        (double)periodUs, pid->runs / seconds, mean, sqrt(MAX(sumSquares / count - mean * mean, 0.0)),
+        (double)(pid->intervalUs.empty() ? 0 : *std::max_element(pid->intervalUs.begin(), pid->intervalUs.end())),
+        late, pid->missed);
+#ifdef USE_SCHEDULER_LOAD_SHEDDING
+    printf("load shedding level 0-3:");
+    for (int level = 0; level < 4; level++) {
+        printf(" %.1f%%", 100.0 * sheddingTimeNs[level] / (seconds * 1e9));
+    }
+    printf(" of the time\n");
+#else
+    UNUSED(sheddingTimeNs);
+#endif
+
+    printf("\n%-16s %8s %8s %8s   %8s %8s %8s %8s %8s\n", "task", "rate/hz", "exec/us", "load", "wait/us p50", "p99", "p99.9", "max", "missed");
+    for (int taskId = 0; taskId < TASK_COUNT; taskId++) {
+        simTask_t *task = &simTasks[taskId];
+        if (!task->runs) {
+            continue;
+        }
+        std::vector<float> &latency = task->latencyUs;
+        printf("%-16s %8.1f %8.1f %7.1f%%   %11.1f %8.1f %8.1f %8.1f %8u\n",
+            cfTasks[taskId].taskName, task->runs / seconds, task->execNs / 1000.0 / task->runs, 100.0 * task->execNs / (seconds * 1e9),
+            (double)simPercentile(latency, 50), (double)simPercentile(latency, 99), (double)simPercentile(latency, 99.9f),
+            (double)(latency.empty() ? 0 : *std::max_element(latency.begin(), latency.end())), task->missed);
+    }
+}
+
+static const char *option(const char *arg, const char *name)
+{
+    const size_t length = strlen(name);
+    return strncmp(arg, name, length) == 0 ? arg + length : NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *profilePath = NULL;
+    float seconds = SIM_SECONDS_DEFAULT;
+    uint32_t seed = 1;
+    uint32_t pidHz = SIM_PID_HZ_DEFAULT;
+    float rxHz = SIM_RX_HZ_DEFAULT;
+    bool rxDeadline = false;
+    float passUs = SIM_PASS_US_DEFAULT;
+
+    for (int i = 1; i < argc; i++) {
+        const char *value;
+        if ((value = option(argv[i], "--profile="))) {
+            profilePath = value;
+        } else if ((value = option(argv[i], "--seconds="))) {
+            seconds = constrainf(atof(value), 1, SIM_SECONDS_MAX);
+        } else if ((value = option(argv[i], "--seed="))) {
+            seed = strtoul(value, NULL, 0);
+        } else if ((value = option(argv[i], "--pid-hz="))) {
+            pidHz = constrain(atoi(value), 100, 32000);
+        } else if ((value = option(argv[i], "--rx-hz="))) {
+            rxHz = atof(value);
+        } else if (strcmp(argv[i], "--rx-deadline") == 0) {
+            rxDeadline = true;
+        } else if ((value = option(argv[i], "--scale="))) {
+            simScale = atof(value);
+        } else if ((value = option(argv[i], "--pass-us="))) {
+            passUs = atof(value);
+        } else {
+            fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    if (profilePath) {
+        if (!simReadProfile(profilePath)) {
+            return 2;
+        }
+        // a profile taken with the statistics off still needs the tasks that drive the scheduler
+        for (const simLoad_t &load : defaultLoad) {
+            simTask_t *task = &simTasks[load.taskId];
+            if ((load.taskId == TASK_SYSTEM || load.taskId == TASK_GYROPID) && !task->execUs[0]) {
+                memcpy(task->execUs, load.execUs, sizeof(load.execUs));
+            }
+        }
+    } else {
+        for (const simLoad_t &load : defaultLoad) {
+            memcpy(simTasks[load.taskId].execUs, load.execUs, sizeof(load.execUs));
+        }
+    }
+    for (const simLoad_t &load : defaultLoad) {
+        simTasks[load.taskId].eventHz = load.eventHz;
+    }
+    simTasks[TASK_RX].eventHz = rxHz;
+    simTasks[TASK_BLACKBOX].eventHz = MIN(simTasks[TASK_BLACKBOX].eventHz, pidHz);
+    simRandomState = 0x9E3779B97F4A7C15ULL * (seed + 1);
+
+    schedulerInit();
+    schedulerSetCalulateTaskStatistics(true);
+    for (int taskId = 0; taskId < TASK_COUNT; taskId++) {
+        setTaskEnabled((cfTaskId_e)taskId, simTasks[taskId].execUs[0] > 0);
+        simTasks[taskId].nextEventNs = (uint64_t)(1e9f * simRandom() / MAX(simTasks[taskId].eventHz, 1.0f));
+    }
+    rescheduleTask(TASK_GYROPID, TASK_PERIOD_HZ(pidHz));
+    setTaskEventDeadline(TASK_RX, rxDeadline);
+
+    const uint64_t endNs = (uint64_t)(seconds * 1e9);
+    const uint64_t passNs = (uint64_t)(passUs * 1000);
+    uint64_t sheddingTimeNs[4] = { 0 };
+    while (simTimeNs < endNs) {
+        const uint64_t passStartNs = simTimeNs;
+        simTimeNs += passNs;
+        scheduler();
+        sheddingTimeNs[MIN(schedulerGetLoadSheddingLevel(), 3)] += simTimeNs - passStartNs;
+    }
+
+    simReport(seconds, seed, sheddingTimeNs);
+    return 0;
+}
@@ -266,3 +266,21 @@ TEST(AlignSensorTest, ClockwiseTwoSeventyDegreesFlip)
     testCWFlip(CW270_DEG_FLIP, 270);
 }
 
+
+TEST(AlignSensorTest, ScaledMatrixMatchesRotation)
+{
+    for (int rotation = CW0_DEG; rotation <= CW270_DEG_FLIP; rotation++) {
+        int32_t expected[XYZ_AXIS_COUNT] = { 3, -5, 7 };
+        alignSensors(expected, rotation);
+
+        sensorAlignment_t alignment;
+        buildAlignmentMatrix(&alignment, rotation, 0.5f);
+        const float src[XYZ_AXIS_COUNT] = { 3, -5, 7 };
+        float dest[XYZ_AXIS_COUNT];
+        applyAlignmentMatrix(&alignment, src, dest);
+
+        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            EXPECT_FLOAT_EQ(0.5f * expected[axis], dest[axis]) << "rotation " << rotation << " axis " << axis;
+        }
+    }
+}
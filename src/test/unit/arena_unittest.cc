@@ -0,0 +1,71 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "common/arena.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+static uint8_t pool[100] __attribute__((aligned(ARENA_ALIGNMENT)));
+
+TEST(ArenaTest, TestAllocIsAlignedAndZeroed)
+{
+    memset(pool, 0xAA, sizeof(pool));
+    arenaInit(pool, sizeof(pool));
+
+    uint8_t *a = (uint8_t *)arenaAlloc(3);
+    uint8_t *b = (uint8_t *)arenaAlloc(8);
+
+    EXPECT_EQ(pool, a);
+    EXPECT_EQ(pool + 4, b);
+    EXPECT_EQ(0, b[7]);
+    EXPECT_EQ(0, a[3]);
+    EXPECT_EQ(sizeof(pool) - 12, arenaFree());
+}
+
+TEST(ArenaTest, TestAllocFailsWhenFull)
+{
+    arenaInit(pool, sizeof(pool));
+
+    EXPECT_EQ(NULL, arenaAlloc(0));
+    EXPECT_EQ(NULL, arenaAlloc(sizeof(pool) + 1));
+
+    EXPECT_EQ(pool, arenaAlloc(sizeof(pool)));
+    EXPECT_EQ(0, arenaFree());
+    EXPECT_EQ(NULL, arenaAlloc(1));
+}
+
+TEST(ArenaTest, TestAllocRemainingTakesWholeUnits)
+{
+    arenaInit(pool, sizeof(pool));
+    arenaAlloc(10);
+
+    size_t size;
+    EXPECT_EQ(pool + 12, arenaAllocRemaining(32, &size));
+    EXPECT_EQ(64, size);
+    EXPECT_EQ(24, arenaFree());
+
+    EXPECT_EQ(NULL, arenaAllocRemaining(32, &size));
+    EXPECT_EQ(0, size);
+}
@@ -148,6 +148,9 @@ bool i2cBusReadRegisterBuffer(busDevice_t*, uint8_t, uint8_t*, uint8_t) {return
 bool i2cBusWriteRegister(busDevice_t*, uint8_t, uint8_t) {return true;}
 bool spiBusReadRegisterBuffer(busDevice_t*, uint8_t, uint8_t*, uint8_t) {return true;}
 bool spiBusWriteRegister(busDevice_t*, uint8_t, uint8_t) {return true;}
+bool busReadRegisterBufferStart(const busDevice_t*, uint8_t, uint8_t*, uint8_t) {return true;}
+bool busWriteRegisterStart(const busDevice_t*, uint8_t, uint8_t) {return true;}
+void spiBusSetDivisor(busDevice_t*, uint16_t) {}
 
 
 void spiSetDivisor() {
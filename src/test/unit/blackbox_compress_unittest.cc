@@ -0,0 +1,197 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "blackbox/blackbox_compress.h"
+
+    #include "common/maths.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+#define TEST_DATA_SIZE 4096
+
+static uint8_t block[BLACKBOX_COMPRESSION_HEADER_SIZE + 2 * BLACKBOX_COMPRESSION_BLOCK_SIZE];
+static int blockLength;
+
+static int readLength(const uint8_t **in, int nibble)
+{
+    int length = nibble;
+    if (nibble == 15) {
+        uint8_t byte;
+        do {
+            byte = *(*in)++;
+            length += byte;
+        } while (byte == 255);
+    }
+    return length;
+}
+
+// Reference decoder for one block, returns the number of bytes decoded or -1 if the block is malformed
+static int decodeBlock(const uint8_t *in, int inLength, uint8_t *out)
+{
+    if (inLength < BLACKBOX_COMPRESSION_HEADER_SIZE || in[0] != BLACKBOX_COMPRESSION_BLOCK_MARKER) {
+        return -1;
+    }
+    const int payloadLength = in[1] | (in[2] << 8);
+    const int rawLength = in[3] | (in[4] << 8);
+    if (payloadLength + BLACKBOX_COMPRESSION_HEADER_SIZE != inLength) {
+        return -1;
+    }
+
+    const uint8_t *pos = in + BLACKBOX_COMPRESSION_HEADER_SIZE;
+    const uint8_t *end = pos + payloadLength;
+    int outLength = 0;
+    while (pos < end) {
+        const uint8_t token = *pos++;
+        const int literalCount = readLength(&pos, token >> 4);
+        memcpy(&out[outLength], pos, literalCount);
+        pos += literalCount;
+        outLength += literalCount;
+
+        if (token & 0x0F) {
+            const int offset = pos[0] | (pos[1] << 8);
+            pos += 2;
+            const int matchLength = readLength(&pos, token & 0x0F) + BLACKBOX_COMPRESSION_MIN_MATCH - 1;
+            if (offset == 0 || offset > outLength) {
+                return -1;
+            }
+            for (int i = 0; i < matchLength; i++, outLength++) {
+                out[outLength] = out[outLength - offset];
+            }
+        }
+    }
+    return outLength == rawLength ? outLength : -1;
+}
+
+static void finishBlock(void)
+{
+    const uint8_t *data;
+    blockLength = blackboxCompressorFinishBlock(&data);
+    ASSERT_LE(blockLength, (int)sizeof(block));
+    memcpy(block, data, blockLength);
+}
+
+// Feeds the data in chunks like the frame buffer does, returns the total size of the compressed blocks
+static int compressAndVerify(const uint8_t *data, int length, int chunkSize)
+{
+    static uint8_t decoded[TEST_DATA_SIZE];
+    int decodedLength = 0;
+    int compressedLength = 0;
+
+    blackboxCompressorReset();
+    for (int pos = 0; pos < length; ) {
+        const int chunk = MIN(chunkSize, length - pos);
+        const int taken = blackboxCompressorAppend(&data[pos], chunk);
+        pos += taken;
+        if (taken < chunk || pos == length) {
+            finishBlock();
+            const int blockDecoded = decodeBlock(block, blockLength, &decoded[decodedLength]);
+            EXPECT_LT(0, blockDecoded);
+            if (blockDecoded < 0) {
+                return -1;
+            }
+            decodedLength += blockDecoded;
+            compressedLength += blockLength;
+        }
+    }
+    EXPECT_TRUE(blackboxCompressorIsEmpty());
+
+    EXPECT_EQ(length, decodedLength);
+    EXPECT_EQ(0, memcmp(data, decoded, length));
+    return compressedLength;
+}
+
+TEST(BlackboxCompressTest, TestIncompressibleDataRoundTrips)
+{
+    static uint8_t data[TEST_DATA_SIZE];
+    uint32_t seed = 0x12345678;
+    for (int i = 0; i < TEST_DATA_SIZE; i++) {
+        seed = seed * 1664525 + 1013904223;
+        data[i] = seed >> 24;
+    }
+
+    const int compressed = compressAndVerify(data, TEST_DATA_SIZE, 128);
+
+    // random data can't be compressed, but it must not grow by more than the block and sequence headers
+    EXPECT_LT(TEST_DATA_SIZE, compressed);
+    EXPECT_GT(TEST_DATA_SIZE + TEST_DATA_SIZE / 32, compressed);
+}
+
+TEST(BlackboxCompressTest, TestRepetitiveDataCompresses)
+{
+    // frames that mostly repeat, like P frames of a craft sitting still, with a changing counter
+    static uint8_t data[TEST_DATA_SIZE];
+    for (int i = 0; i < TEST_DATA_SIZE; i++) {
+        const int frameOffset = i % 23;
+        data[i] = frameOffset == 0 ? 'P' : frameOffset == 5 ? (uint8_t)(i / 23) : frameOffset * 3;
+    }
+
+    const int compressed = compressAndVerify(data, TEST_DATA_SIZE, 128);
+    EXPECT_GT(TEST_DATA_SIZE / 2, compressed);
+
+    // the chunk size changes where the matches are cut, but never the result
+    compressAndVerify(data, TEST_DATA_SIZE, 1);
+    compressAndVerify(data, TEST_DATA_SIZE, 7);
+    compressAndVerify(data, TEST_DATA_SIZE, BLACKBOX_COMPRESSION_BLOCK_SIZE);
+}
+
+TEST(BlackboxCompressTest, TestLongRunsUseLengthBytes)
+{
+    static uint8_t data[TEST_DATA_SIZE];
+    memset(data, 0xAA, sizeof(data));
+
+    // a run compresses to a few bytes per block, as the match overlaps what it copies
+    const int compressed = compressAndVerify(data, TEST_DATA_SIZE, BLACKBOX_COMPRESSION_BLOCK_SIZE);
+    const int blockCount = TEST_DATA_SIZE / BLACKBOX_COMPRESSION_BLOCK_SIZE;
+    EXPECT_GE(blockCount * (BLACKBOX_COMPRESSION_HEADER_SIZE + 8), compressed);
+}
+
+TEST(BlackboxCompressTest, TestBlocksAreIndependent)
+{
+    uint8_t data[64];
+    for (unsigned i = 0; i < sizeof(data); i++) {
+        data[i] = i & 0x0F;
+    }
+
+    blackboxCompressorReset();
+    EXPECT_TRUE(blackboxCompressorIsEmpty());
+    EXPECT_EQ((int)sizeof(data), blackboxCompressorAppend(data, sizeof(data)));
+    EXPECT_FALSE(blackboxCompressorIsEmpty());
+    finishBlock();
+    EXPECT_EQ(BLACKBOX_COMPRESSION_BLOCK_MARKER, block[0]);
+    EXPECT_EQ(sizeof(data), (unsigned)(block[3] | (block[4] << 8)));
+
+    // the same data again must not refer back to the previous block
+    EXPECT_EQ((int)sizeof(data), blackboxCompressorAppend(data, sizeof(data)));
+    const uint8_t *second;
+    const int secondLength = blackboxCompressorFinishBlock(&second);
+    EXPECT_EQ(blockLength, secondLength);
+    EXPECT_EQ(0, memcmp(block, second, blockLength));
+
+    uint8_t decoded[sizeof(data)];
+    EXPECT_EQ((int)sizeof(data), decodeBlock(second, secondLength, decoded));
+    EXPECT_EQ(0, memcmp(data, decoded, sizeof(data)));
+}
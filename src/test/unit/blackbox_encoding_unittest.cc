@@ -240,12 +240,100 @@ TEST(BlackboxTest, TestWriteTag2_3SVariable_BITS887)
     EXPECT_EQ(0, buf[3]); // ensure next byte has not been written
     buf += 3;
 }
+
+TEST(BlackboxTest, TestWriteTag2_3S32)
+{
+    serialTestResetBuffers();
+    uint8_t *buf = &serialWriteBuffer[0];
+    int32_t v[3];
+
+    // 4 bits per field  ss00 1111 2222 3333
+    v[0] = -8;
+    v[1] = 7;
+    v[2] = 2;
+    blackboxWriteTag2_3S32(v);
+    EXPECT_EQ(0x48, buf[0]); // 01001000
+    EXPECT_EQ(0x72, buf[1]);
+    EXPECT_EQ(0, buf[2]); // ensure next byte has not been written
+    buf += 2;
+
+    // 6 bits per field  ss11 1111 0022 2222 0033 3333
+    v[0] = 31;
+    v[1] = -32;
+    v[2] = 0;
+    blackboxWriteTag2_3S32(v);
+    EXPECT_EQ(0x9F, buf[0]); // 10011111
+    EXPECT_EQ(0xE0, buf[1]);
+    EXPECT_EQ(0x00, buf[2]);
+    EXPECT_EQ(0, buf[3]); // ensure next byte has not been written
+    buf += 3;
+
+    // 32 bits: one byte, three bytes and four bytes
+    v[0] = -128;
+    v[1] = 0x123456;
+    v[2] = INT32_MIN;
+    blackboxWriteTag2_3S32(v);
+    EXPECT_EQ(0xF8, buf[0]); // 11 11 10 00
+    EXPECT_EQ(0x80, buf[1]);
+    EXPECT_EQ(0x56, buf[2]);
+    EXPECT_EQ(0x34, buf[3]);
+    EXPECT_EQ(0x12, buf[4]);
+    EXPECT_EQ(0x00, buf[5]);
+    EXPECT_EQ(0x00, buf[6]);
+    EXPECT_EQ(0x00, buf[7]);
+    EXPECT_EQ(0x80, buf[8]);
+    // the encoder stores whole words, but must only account for the bytes it used
+    EXPECT_EQ(9 + 5, serialWritePos);
+}
+
+TEST(BlackboxTest, TestWriteTag8_4S16)
+{
+    serialTestResetBuffers();
+    uint8_t *buf = &serialWriteBuffer[0];
+    int32_t v[4];
+
+    // all zero is just the selector
+    v[0] = 0;
+    v[1] = 0;
+    v[2] = 0;
+    v[3] = 0;
+    blackboxWriteTag8_4S16(v);
+    EXPECT_EQ(0x00, buf[0]);
+    EXPECT_EQ(1, serialWritePos);
+    buf += 1;
+
+    // 4 bit, 8 bit, zero and 16 bit fields, packed high nibble first
+    v[0] = -1;
+    v[1] = 0x7F;
+    v[2] = 0;
+    v[3] = -300;
+    blackboxWriteTag8_4S16(v);
+    EXPECT_EQ(0xC9, buf[0]); // 11 00 10 01
+    EXPECT_EQ(0xF7, buf[1]);
+    EXPECT_EQ(0xFF, buf[2]);
+    EXPECT_EQ(0xED, buf[3]);
+    EXPECT_EQ(0x40, buf[4]); // the leftover nibble
+    EXPECT_EQ(1 + 5, serialWritePos);
+    buf += 5;
+
+    // two 4 bit fields share a byte
+    v[0] = 3;
+    v[1] = -8;
+    v[2] = 0;
+    v[3] = 0;
+    blackboxWriteTag8_4S16(v);
+    EXPECT_EQ(0x05, buf[0]); // 00 00 01 01
+    EXPECT_EQ(0x38, buf[1]);
+    EXPECT_EQ(1 + 5 + 2, serialWritePos);
+}
+
 // STUBS
 extern "C" {
 PG_REGISTER(blackboxConfig_t, blackboxConfig, PG_BLACKBOX_CONFIG, 0);
 int32_t blackboxHeaderBudget;
 void mspSerialAllocatePorts(void) {}
 void blackboxWrite(uint8_t value) {serialWrite(blackboxPort, value);}
+void blackboxWriteBuf(const uint8_t *data, int count) {serialWriteBuf(blackboxPort, data, count);}
 int blackboxPrint(const char *s)
 {
     const uint8_t *pos = (uint8_t*)s;
@@ -0,0 +1,178 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <stdint.h>
+#include <stdbool.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "blackbox/blackbox_preroll.h"
+
+    #include "fc/runtime_config.h"
+
+    #include "flight/mixer.h"
+
+    #include "sensors/gyro.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+// one sample every 1000us
+#define TEST_PREROLL_SECONDS 1
+#define TEST_INTERVAL_US (TEST_PREROLL_SECONDS * 1000000 / BLACKBOX_PREROLL_SAMPLE_COUNT)
+
+static bool failsafeActive;
+static bool crashRecoveryActive;
+
+// takes count samples, with the gyro roll value counting up from first
+static timeUs_t captureSamples(timeUs_t time, int first, int count)
+{
+    for (int i = 0; i < count; i++) {
+        gyro.gyroADCf[0] = first + i;
+        blackboxPrerollCapture(time);
+        time += TEST_INTERVAL_US;
+    }
+    return time;
+}
+
+static int dumpSamples(int *firstRoll, int *lastRoll)
+{
+    int count = 0;
+    const flightLogEvent_prerollSample_t *sample;
+    while ((sample = blackboxPrerollNextDumpSample())) {
+        if (count == 0) {
+            *firstRoll = sample->gyroADC[0];
+        }
+        *lastRoll = sample->gyroADC[0];
+        count++;
+    }
+    return count;
+}
+
+TEST(BlackboxPrerollTest, TestDumpIsOldestFirst)
+{
+    blackboxPrerollInit(TEST_PREROLL_SECONDS);
+    captureSamples(TEST_INTERVAL_US, 0, 10);
+
+    blackboxPrerollStartDump();
+    int first = -1, last = -1;
+    EXPECT_EQ(10, dumpSamples(&first, &last));
+    EXPECT_EQ(0, first);
+    EXPECT_EQ(9, last);
+
+    // the ring is emptied by the dump
+    blackboxPrerollStartDump();
+    EXPECT_EQ(NULL, blackboxPrerollNextDumpSample());
+}
+
+TEST(BlackboxPrerollTest, TestRingKeepsTheLatestSamples)
+{
+    blackboxPrerollInit(TEST_PREROLL_SECONDS);
+    captureSamples(TEST_INTERVAL_US, 0, BLACKBOX_PREROLL_SAMPLE_COUNT + 50);
+
+    blackboxPrerollStartDump();
+    int first = -1, last = -1;
+    EXPECT_EQ(BLACKBOX_PREROLL_SAMPLE_COUNT, dumpSamples(&first, &last));
+    EXPECT_EQ(50, first);
+    EXPECT_EQ(BLACKBOX_PREROLL_SAMPLE_COUNT + 49, last);
+}
+
+TEST(BlackboxPrerollTest, TestSamplingIsRateLimitedAndPausedWhileDumping)
+{
+    blackboxPrerollInit(TEST_PREROLL_SECONDS);
+
+    // samples closer together than the interval are skipped
+    timeUs_t time = TEST_INTERVAL_US;
+    for (int i = 0; i < 10; i++) {
+        gyro.gyroADCf[0] = i;
+        blackboxPrerollCapture(time + i);
+    }
+    time += TEST_INTERVAL_US;
+
+    blackboxPrerollStartDump();
+    const flightLogEvent_prerollSample_t *sample = blackboxPrerollNextDumpSample();
+    ASSERT_TRUE(sample != NULL);
+    EXPECT_EQ(0, sample->gyroADC[0]);
+    EXPECT_EQ((uint32_t)TEST_INTERVAL_US, sample->time);
+
+    // nothing is sampled until the dump is finished
+    time = captureSamples(time, 100, 5);
+    EXPECT_EQ(NULL, blackboxPrerollNextDumpSample());
+
+    captureSamples(time, 200, 3);
+    blackboxPrerollStartDump();
+    int first = -1, last = -1;
+    EXPECT_EQ(3, dumpSamples(&first, &last));
+    EXPECT_EQ(200, first);
+}
+
+TEST(BlackboxPrerollTest, TestTriggersStartADumpOnce)
+{
+    blackboxPrerollInit(TEST_PREROLL_SECONDS);
+    failsafeActive = false;
+    crashRecoveryActive = false;
+    timeUs_t time = captureSamples(TEST_INTERVAL_US, 0, 5);
+
+    blackboxPrerollCheckTriggers();
+    EXPECT_EQ(NULL, blackboxPrerollNextDumpSample());
+
+    failsafeActive = true;
+    blackboxPrerollCheckTriggers();
+    int first = -1, last = -1;
+    EXPECT_EQ(5, dumpSamples(&first, &last));
+
+    // staying in failsafe doesn't trigger again
+    time = captureSamples(time, 10, 5);
+    blackboxPrerollCheckTriggers();
+    EXPECT_EQ(NULL, blackboxPrerollNextDumpSample());
+
+    failsafeActive = false;
+    blackboxPrerollCheckTriggers();
+    crashRecoveryActive = true;
+    blackboxPrerollCheckTriggers();
+    const flightLogEvent_prerollSample_t *sample = blackboxPrerollNextDumpSample();
+    ASSERT_TRUE(sample != NULL);
+    EXPECT_EQ(10, sample->gyroADC[0]);
+    // the samples hold the state
+    EXPECT_EQ(FLIGHT_LOG_PREROLL_FAILSAFE | FLIGHT_LOG_PREROLL_ARMED, sample->flags & ~FLIGHT_LOG_PREROLL_RX_SIGNAL);
+}
+
+TEST(BlackboxPrerollTest, TestOffTakesNoSamples)
+{
+    blackboxPrerollInit(0);
+    captureSamples(TEST_INTERVAL_US, 0, 10);
+    blackboxPrerollStartDump();
+    EXPECT_EQ(NULL, blackboxPrerollNextDumpSample());
+}
+
+// STUBS
+extern "C" {
+gyro_t gyro;
+float rcCommand[4];
+float motor[MAX_SUPPORTED_MOTORS];
+uint8_t armingFlags = ARMED;
+
+uint8_t getMotorCount(void) { return 4; }
+armingDisableFlags_e getArmingDisableFlags(void) { return (armingDisableFlags_e)0; }
+bool rxIsReceivingSignal(void) { return true; }
+bool failsafeIsActive(void) { return failsafeActive; }
+bool pidCrashRecoveryActive(void) { return crashRecoveryActive; }
+bool isGyroCalibrationComplete(void) { return true; }
+}
@@ -21,6 +21,7 @@ extern "C" {
     #include "platform.h"
 
     #include "blackbox/blackbox.h"
+    #include "build/debug.h"
     #include "common/utils.h"
 
     #include "config/parameter_group.h"
@@ -358,7 +359,7 @@ uint8_t armingFlags;
 uint8_t stateFlags;
 const uint32_t baudRates[] = {0, 9600, 19200, 38400, 57600, 115200, 230400, 250000,
         400000, 460800, 500000, 921600, 1000000, 1500000, 2000000, 2470000}; // see baudRate_e
-uint8_t debugMode;
+debugType_e debugModeForSlot(int slot) { UNUSED(slot); return DEBUG_NONE; }
 int32_t blackboxHeaderBudget;
 gpsSolutionData_t gpsSol;
 int32_t GPS_home[2];
@@ -371,21 +372,24 @@ struct pidProfile_s;
 struct pidProfile_s *currentPidProfile;
 uint32_t targetPidLooptime;
 
-uint32_t rcModeActivationMask;
+boxBitmask_t rcModeActivationMask;
 
 void mspSerialAllocatePorts(void) {}
 uint32_t getArmingBeepTimeMicros(void) {return 0;}
 uint16_t getBatteryVoltageLatest(void) {return 0;}
 uint8_t getMotorCount() {return 4;}
-bool IS_RC_MODE_ACTIVE(boxId_e) {return false;}
 bool isModeActivationConditionPresent(boxId_e) {return false;}
 uint32_t millis(void) {return 0;}
+uint32_t micros(void) {return 0;}
 bool sensors(uint32_t) {return false;}
 void serialWrite(serialPort_t *, uint8_t) {}
 uint32_t serialTxBytesFree(const serialPort_t *) {return 0;}
+void serialWriteBuf(serialPort_t *, const uint8_t *, int) {}
 bool isSerialTransmitBufferEmpty(const serialPort_t *) {return false;}
 bool feature(uint32_t) {return false;}
 void mspSerialReleasePortIfAllocated(serialPort_t *) {}
+int mspSerialPushStream(uint8_t, uint8_t *, int) {return 0;}
+uint32_t mspSerialStreamTxBytesFree(void) {return 0;}
 serialPortConfig_t *findSerialPortConfig(serialPortFunction_e ) {return NULL;}
 serialPort_t *findSharedSerialPort(uint16_t , serialPortFunction_e ) {return NULL;}
 serialPort_t *openSerialPort(serialPortIdentifier_e, serialPortFunction_e, serialReceiveCallbackPtr, uint32_t, portMode_t, portOptions_t) {return NULL;}
@@ -394,5 +398,6 @@ portSharing_e determinePortSharing(const serialPortConfig_t *, serialPortFunctio
 failsafePhase_e failsafePhase(void) {return FAILSAFE_IDLE;}
 bool rxAreFlightChannelsValid(void) {return false;}
 bool rxIsReceivingSignal(void) {return false;}
+uint8_t schedulerGetLoadSheddingLevel(void) {return 0;}
 
 }
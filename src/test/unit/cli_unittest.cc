@@ -264,5 +264,15 @@ void generateLedConfig(ledConfig_t *, char *, size_t) {}
 bool isSerialTransmitBufferEmpty(const serialPort_t *) {return true; }
 void serialWrite(serialPort_t *, uint8_t ch) { printf("%c", ch);}
 
+const clivalue_t *settingFind(const char *name, uint8_t length)
+{
+    for (int i = 0; i < valueTableEntryCount; i++) {
+        if (strncasecmp(name, valueTable[i].name, length) == 0 && valueTable[i].name[length] == '\0') {
+            return &valueTable[i];
+        }
+    }
+    return NULL;
+}
+
 
 }
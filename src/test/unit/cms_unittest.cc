@@ -28,6 +28,7 @@
 extern "C" {
     #include "platform.h"
     #include "target.h"
+    #include "build/debug.h"
     #include "cms/cms.h"
     #include "cms/cms_types.h"
     #include "fc/runtime_config.h"
@@ -133,12 +134,13 @@ CMS_Menu menuMain = {
     menuMainEntries,
 };
 uint8_t armingFlags;
-int16_t debug[4];
+int32_t debug[DEBUG_VALUE_COUNT];
 int16_t rcData[18];
 void delay(uint32_t) {}
 uint32_t micros(void) { return 0; }
 uint32_t millis(void) { return 0; }
 void saveConfigAndNotify(void) {}
+void saveConfigAndNotifyAsync(void) {}
 void stopMotors(void) {}
 void stopPwmAllMotors(void) {}
 void systemReset(void) {}
@@ -19,6 +19,7 @@
 #include <stdbool.h>
 
 #include <limits.h>
+#include <string.h>
 
 #include <math.h>
 
@@ -145,3 +146,133 @@ TEST(FilterUnittest, TestFirFilterApply)
     expected = 7.0f * 26.0f + 6.0 * 27.0 + 5.0 * 28.0 + 4.0f * 29.0f;
     EXPECT_FLOAT_EQ(expected, firFilterApply(&filter));
 }
+
+TEST(FilterUnittest, TestXyzFiltersMatchSingleAxis)
+{
+    pt1Filter_t pt1[3];
+    biquadFilter_t notch[3];
+    biquadFilter_t lpf[3];
+    pt1FilterXyz_t pt1Xyz;
+    biquadFilterXyz_t notchXyz;
+    biquadFilterXyz_t lpfXyz;
+
+    // pt1FilterInit() leaves the state alone, pt1FilterXyzInit() clears it
+    memset(pt1, 0, sizeof(pt1));
+    for (int axis = 0; axis < 3; axis++) {
+        pt1FilterInit(&pt1[axis], 90, 0.000125f);
+        biquadFilterInit(&notch[axis], 200, 125, filterGetNotchQ(200, 150), FILTER_NOTCH);
+        biquadFilterInitLPF(&lpf[axis], 100, 125);
+    }
+    pt1FilterXyzInit(&pt1Xyz, 90, 0.000125f);
+    biquadFilterXyzInit(&notchXyz, 200, 125, filterGetNotchQ(200, 150), FILTER_NOTCH);
+    biquadFilterXyzInitLPF(&lpfXyz, 100, 125);
+
+    // move the notch on one axis only, as the dynamic notch does
+    biquadFilterUpdate(&notch[1], 300, 125, filterGetNotchQ(300, 250), FILTER_NOTCH);
+    biquadFilterXyzUpdate(&notchXyz, 1, 300, 125, filterGetNotchQ(300, 250), FILTER_NOTCH);
+
+    for (int i = 0; i < 100; i++) {
+        float values[3];
+        float valuesDF1[3];
+        float valuesPt1[3];
+        float expected[3];
+        float expectedDF1[3];
+        float expectedPt1[3];
+        for (int axis = 0; axis < 3; axis++) {
+            const float input = 100.0f * sinf(i * 0.3f * (axis + 1)) + axis;
+            values[axis] = input;
+            valuesPt1[axis] = input;
+            expected[axis] = biquadFilterApply(&lpf[axis], biquadFilterApply(&notch[axis], input));
+            expectedPt1[axis] = pt1FilterApply(&pt1[axis], input);
+        }
+        biquadFilterXyzApply(&notchXyz, values);
+        biquadFilterXyzApply(&lpfXyz, values);
+        pt1FilterXyzApply(&pt1Xyz, valuesPt1);
+
+        for (int axis = 0; axis < 3; axis++) {
+            EXPECT_FLOAT_EQ(expected[axis], values[axis]);
+            EXPECT_FLOAT_EQ(expectedPt1[axis], valuesPt1[axis]);
+        }
+
+        // the DF1 form keeps its state apart from the DF2 form, so the same notch can be checked with it
+        for (int axis = 0; axis < 3; axis++) {
+            valuesDF1[axis] = values[axis];
+            expectedDF1[axis] = biquadFilterApplyDF1(&notch[axis], values[axis]);
+        }
+        biquadFilterXyzApplyDF1(&notchXyz, valuesDF1);
+        for (int axis = 0; axis < 3; axis++) {
+            EXPECT_FLOAT_EQ(expectedDF1[axis], valuesDF1[axis]);
+        }
+    }
+}
+
+TEST(FilterUnittest, TestXyzNotchUpdateMatchesInit)
+{
+    biquadFilter_t notch;
+    biquadFilterXyz_t notchXyz;
+
+    biquadFilterInit(&notch, 250, 125, 5.0f, FILTER_NOTCH);
+    biquadFilterXyzInit(&notchXyz, 400, 125, 5.0f, FILTER_NOTCH);
+    biquadFilterXyzUpdateNotch(&notchXyz, 250, 125, 5.0f);
+
+    // same coefficients on every axis, to within the sine table interpolation: sin and cos are within 2e-5,
+    // b1 and a1 are scaled by 2 * cos so they get twice that
+    for (int axis = 0; axis < 3; axis++) {
+        EXPECT_NEAR(notch.b0, notchXyz.b0[axis], 2e-5f);
+        EXPECT_NEAR(notch.b1, notchXyz.b1[axis], 4e-5f);
+        EXPECT_NEAR(notch.b2, notchXyz.b2[axis], 2e-5f);
+        EXPECT_NEAR(notch.a1, notchXyz.a1[axis], 4e-5f);
+        EXPECT_NEAR(notch.a2, notchXyz.a2[axis], 2e-5f);
+    }
+
+    // across the whole range up to nyquist, on one axis only
+    for (int freq = 20; freq < 4000; freq += 97) {
+        biquadFilterInit(&notch, freq, 125, 3.0f, FILTER_NOTCH);
+        biquadFilterXyzUpdateNotchAxis(&notchXyz, 2, freq, 125, 3.0f);
+        EXPECT_NEAR(notch.b0, notchXyz.b0[2], 2e-5f);
+        EXPECT_NEAR(notch.b1, notchXyz.b1[2], 4e-5f);
+        EXPECT_NEAR(notch.a2, notchXyz.a2[2], 2e-5f);
+    }
+    // the other axes are untouched, still at 250Hz
+    biquadFilterInit(&notch, 250, 125, 5.0f, FILTER_NOTCH);
+    EXPECT_NEAR(notch.b1, notchXyz.b1[0], 4e-5f);
+    EXPECT_NEAR(notch.b1, notchXyz.b1[1], 4e-5f);
+
+    // pass through leaves the samples as they are
+    biquadFilterXyzSetPassthrough(&notchXyz);
+    float values[3] = { 1.0f, -2.0f, 3.0f };
+    biquadFilterXyzApplyDF1(&notchXyz, values);
+    EXPECT_FLOAT_EQ(1.0f, values[0]);
+    EXPECT_FLOAT_EQ(-2.0f, values[1]);
+    EXPECT_FLOAT_EQ(3.0f, values[2]);
+}
+
+TEST(FilterUnittest, TestXyzFiltersResetSettlesOnInput)
+{
+    pt1FilterXyz_t pt1Xyz;
+    biquadFilterXyz_t notchXyz;
+    biquadFilterXyz_t lpfXyz;
+    pt1FilterXyzInit(&pt1Xyz, 90, 0.000125f);
+    biquadFilterXyzInit(&notchXyz, 200, 125, filterGetNotchQ(200, 150), FILTER_NOTCH);
+    biquadFilterXyzInitLPF(&lpfXyz, 100, 125);
+
+    const float clipped[3] = { 2000.0f, -2000.0f, 500.0f };
+    pt1FilterXyzReset(&pt1Xyz, clipped);
+    biquadFilterXyzReset(&notchXyz, clipped);
+    biquadFilterXyzReset(&lpfXyz, clipped);
+
+    // a constant input then comes straight through, in either biquad form
+    for (int i = 0; i < 10; i++) {
+        float pt1Values[3] = { clipped[0], clipped[1], clipped[2] };
+        float notchValues[3] = { clipped[0], clipped[1], clipped[2] };
+        float lpfValues[3] = { clipped[0], clipped[1], clipped[2] };
+        pt1FilterXyzApply(&pt1Xyz, pt1Values);
+        biquadFilterXyzApplyDF1(&notchXyz, notchValues);
+        biquadFilterXyzApply(&lpfXyz, lpfValues);
+        for (int axis = 0; axis < 3; axis++) {
+            EXPECT_NEAR(clipped[axis], pt1Values[axis], 1e-3f);
+            EXPECT_NEAR(clipped[axis], notchValues[axis], 1e-2f);
+            EXPECT_NEAR(clipped[axis], lpfValues[axis], 1e-2f);
+        }
+    }
+}
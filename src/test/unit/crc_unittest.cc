@@ -0,0 +1,61 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdint.h>
+
+extern "C" {
+    #include "common/crc.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+static const uint8_t check[] = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+
+// bit by bit reference for the tables
+static uint8_t crc8Reference(uint8_t crc, uint8_t a, uint8_t poly)
+{
+    crc ^= a;
+    for (int i = 0; i < 8; i++) {
+        crc = (crc & 0x80) ? (crc << 1) ^ poly : crc << 1;
+    }
+    return crc;
+}
+
+TEST(CrcTest, CheckValues)
+{
+    // the standard check values of each crc for "123456789"
+    EXPECT_EQ(0x31C3, crc16_ccitt_update(0, check, sizeof(check)));
+    EXPECT_EQ(0xBC, crc8_dvb_s2_update(0, check, sizeof(check)));
+    EXPECT_EQ(0xF4, crc8_ccitt_update(0, check, sizeof(check)));
+}
+
+TEST(CrcTest, TablesMatchReference)
+{
+    for (int crc = 0; crc < 256; crc++) {
+        for (int a = 0; a < 256; a++) {
+            EXPECT_EQ(crc8Reference(crc, a, 0xD5), crc8_dvb_s2(crc, a));
+            EXPECT_EQ(crc8Reference(crc, a, 0x07), crc8_ccitt(crc, a));
+        }
+    }
+}
+
+TEST(CrcTest, UpdateContinuesSpan)
+{
+    const uint8_t head = crc8_dvb_s2_update(0, check, 4);
+    EXPECT_EQ(crc8_dvb_s2_update(0, check, sizeof(check)), crc8_dvb_s2_update(head, &check[4], sizeof(check) - 4));
+    EXPECT_EQ(0x12, crc8_ccitt_update(0x12, check, 0));
+}
@@ -0,0 +1,76 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "build/debug.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+TEST(DebugUnittest, TestModesGetBanksInOrder)
+{
+    const uint8_t modes[] = { DEBUG_GYRO, DEBUG_PIDLOOP };
+    debugInit(modes, 2);
+
+    EXPECT_EQ(DEBUG_GYRO, debugModeForSlot(0));
+    EXPECT_EQ(DEBUG_PIDLOOP, debugModeForSlot(1));
+
+    DEBUG_SET(DEBUG_GYRO, 2, 100000);
+    DEBUG_SET(DEBUG_PIDLOOP, 1, -5);
+    DEBUG_SET(DEBUG_BATTERY, 0, 7);     // not active
+
+    EXPECT_EQ(100000, debug[2]);
+    EXPECT_EQ(-5, debug[DEBUG_MODE_VALUE_COUNT + 1]);
+    for (int i = 0; i < DEBUG_VALUE_COUNT; i++) {
+        if (i != 2 && i != DEBUG_MODE_VALUE_COUNT + 1) {
+            EXPECT_EQ(0, debug[i]);
+        }
+    }
+}
+
+TEST(DebugUnittest, TestUnusedModesTakeNoBank)
+{
+    const uint8_t modes[] = { DEBUG_NONE, DEBUG_BATTERY, DEBUG_BATTERY };
+    debugInit(modes, 3);
+
+    EXPECT_TRUE(DEBUG_MODE_IS_ACTIVE(DEBUG_BATTERY));
+    EXPECT_FALSE(DEBUG_MODE_IS_ACTIVE(DEBUG_NONE));
+    EXPECT_EQ(DEBUG_BATTERY, debugModeForSlot(0));
+    EXPECT_EQ(DEBUG_NONE, debugModeForSlot(1));
+
+    DEBUG_SET(DEBUG_BATTERY, 3, 42);
+    EXPECT_EQ(42, debug[3]);
+}
+
+TEST(DebugUnittest, TestModesBeyondTheBanksAreDropped)
+{
+    uint8_t modes[DEBUG_MODE_SLOT_COUNT + 1];
+    for (int i = 0; i <= DEBUG_MODE_SLOT_COUNT; i++) {
+        modes[i] = DEBUG_CYCLETIME + i;
+    }
+    debugInit(modes, DEBUG_MODE_SLOT_COUNT + 1);
+
+    EXPECT_TRUE(DEBUG_MODE_IS_ACTIVE(modes[DEBUG_MODE_SLOT_COUNT - 1]));
+    EXPECT_FALSE(DEBUG_MODE_IS_ACTIVE(modes[DEBUG_MODE_SLOT_COUNT]));
+    EXPECT_EQ(DEBUG_NONE, debugModeForSlot(DEBUG_MODE_SLOT_COUNT));
+}
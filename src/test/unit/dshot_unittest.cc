@@ -0,0 +1,143 @@
+/*
+ * This file is part of Betaflight.
+ *
+ * Betaflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Betaflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Betaflight. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "drivers/dshot.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+#define BIT_TICKS 20                    // DShot bit length in timer ticks
+#define REPLY_BIT_TICKS (BIT_TICKS * 4 / 5)
+
+static const uint8_t gcrEncode[16] = {
+    0x19, 0x1b, 0x12, 0x13, 0x1d, 0x15, 0x16, 0x17,
+    0x1a, 0x09, 0x0a, 0x0b, 0x1e, 0x0d, 0x0e, 0x0f
+};
+
+static uint32_t edges[DSHOT_TELEMETRY_INPUT_LEN];
+
+// encodes a 12 bit reply as an ESC would send it, and returns the counter values at its edges
+static int encodeReply(uint16_t value, uint32_t startTicks, int jitterTicks, bool trailingEdge)
+{
+    uint16_t packet = value << 4;
+    const uint16_t csum = (value ^ (value >> 4) ^ (value >> 8)) & 0xf;
+    packet |= ~csum & 0xf;
+
+    uint32_t gcr = 0;
+    for (int nibble = 3; nibble >= 0; nibble--) {
+        gcr = (gcr << 5) | gcrEncode[(packet >> (4 * nibble)) & 0xf];
+    }
+    // a start bit, then an edge for every 1
+    gcr |= 1 << 20;
+
+    int count = 0;
+    for (int bit = 20; bit >= 0; bit--) {
+        if (gcr & (1 << bit)) {
+            const int jitter = (count & 1) ? jitterTicks : -jitterTicks;
+            edges[count++] = (startTicks + (20 - bit) * REPLY_BIT_TICKS + jitter) & 0xffff;
+        }
+    }
+    if (trailingEdge) {
+        // the line returns to idle after the last bit
+        edges[count++] = (startTicks + 23 * REPLY_BIT_TICKS) & 0xffff;
+    }
+    return count;
+}
+
+// the reply for a given eRPM, as a 3 bit shift and a 9 bit period in us
+static uint16_t erpmReply(uint32_t erpm)
+{
+    uint32_t periodUs = 60000000 / erpm;
+    uint16_t shift = 0;
+    while (periodUs > 0x1ff) {
+        periodUs >>= 1;
+        shift++;
+    }
+    return (shift << 9) | periodUs;
+}
+
+TEST(DshotUnittest, TestDecodeErpm)
+{
+    // 20000 rpm on a 14 pole motor
+    const uint32_t erpm = 140000;
+    const int count = encodeReply(erpmReply(erpm), 1000, 0, false);
+    const uint32_t decoded = dshotDecodeTelemetry(edges, count, BIT_TICKS);
+    EXPECT_NEAR(erpm / 100, decoded, erpm / 100 / 100);
+}
+
+TEST(DshotUnittest, TestDecodeRange)
+{
+    for (uint32_t erpm = 2000; erpm < 300000; erpm += 997) {
+        const uint16_t reply = erpmReply(erpm);
+        // the counter wraps part way through some of the replies
+        const int count = encodeReply(reply, 0xffff - erpm % 200, 3, true);
+        const uint32_t periodUs = (reply & 0x1ff) << (reply >> 9);
+        EXPECT_EQ((600000 + periodUs / 2) / periodUs, dshotDecodeTelemetry(edges, count, BIT_TICKS));
+    }
+}
+
+TEST(DshotUnittest, TestDecodeStopped)
+{
+    const int count = encodeReply(0x0fff, 100, 0, true);
+    EXPECT_EQ(0, dshotDecodeTelemetry(edges, count, BIT_TICKS));
+}
+
+TEST(DshotUnittest, TestCorruptRepliesAreRejected)
+{
+    // nothing captured
+    EXPECT_EQ(DSHOT_TELEMETRY_INVALID, dshotDecodeTelemetry(edges, 0, BIT_TICKS));
+
+    int count = encodeReply(erpmReply(50000), 100, 0, false);
+    ASSERT_EQ(count >= 4, true);
+
+    // a missing edge breaks the GCR code or the checksum
+    edges[2] = edges[3];
+    EXPECT_EQ(DSHOT_TELEMETRY_INVALID, dshotDecodeTelemetry(edges, count, BIT_TICKS));
+
+    // a glitch shorter than half a bit
+    count = encodeReply(erpmReply(50000), 100, 0, false);
+    edges[1] = edges[0] + 2;
+    EXPECT_EQ(DSHOT_TELEMETRY_INVALID, dshotDecodeTelemetry(edges, count, BIT_TICKS));
+
+    // the first edges missed, too few bits
+    count = encodeReply(erpmReply(50000), 100, 0, false);
+    EXPECT_EQ(DSHOT_TELEMETRY_INVALID, dshotDecodeTelemetry(edges + 4, count - 4, BIT_TICKS));
+}
+
+TEST(DshotUnittest, TestEveryValueRoundTrips)
+{
+    for (uint32_t value = 0; value < 0x1000; value++) {
+        const int count = encodeReply(value, 5000, 2, value & 1);
+        const uint32_t periodUs = (value & 0x1ff) << (value >> 9);
+        uint32_t expected;
+        if (value == 0x0fff) {
+            expected = 0;
+        } else if (periodUs == 0) {
+            expected = DSHOT_TELEMETRY_INVALID;
+        } else {
+            expected = (600000 + periodUs / 2) / periodUs;
+        }
+        EXPECT_EQ(expected, dshotDecodeTelemetry(edges, count, BIT_TICKS)) << "value " << value;
+    }
+}
@@ -0,0 +1,181 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "common/utils.h"
+
+    #include "fc/fc_dispatch.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+extern "C" {
+    uint32_t simulatedTime = 0;
+    uint32_t micros(void) { return simulatedTime; }
+}
+
+#define MAX_DISPATCHED 8
+
+static int dispatchedCount;
+static dispatchEntry_t *dispatched[MAX_DISPATCHED];
+static uint32_t dispatchedAt[MAX_DISPATCHED];
+static uint32_t now;
+
+static void recordDispatch(dispatchEntry_t *self)
+{
+    if (dispatchedCount < MAX_DISPATCHED) {
+        dispatched[dispatchedCount] = self;
+        dispatchedAt[dispatchedCount] = now;
+    }
+    dispatchedCount++;
+}
+
+static void resetDispatched(void)
+{
+    dispatchedCount = 0;
+}
+
+// runs the dispatcher at the given period, like the dispatch task, up to the given time
+static void runUntil(uint32_t until, uint32_t periodUs)
+{
+    for (; cmp32(until, now) > 0; now += periodUs) {
+        simulatedTime = now;
+        dispatchProcess(now);
+    }
+    simulatedTime = now;
+}
+
+TEST(DispatchUnittest, TestDispatchOrderAndPrecision)
+{
+    static dispatchEntry_t a = { .dispatch = recordDispatch };
+    static dispatchEntry_t b = { .dispatch = recordDispatch };
+    static dispatchEntry_t c = { .dispatch = recordDispatch };
+
+    now = 1000;
+    simulatedTime = now;
+    resetDispatched();
+
+    dispatchAdd(&c, 300);
+    dispatchAdd(&a, 100);
+    dispatchAdd(&b, 200);
+    EXPECT_TRUE(dispatchIsPending(&a));
+
+    // process more often than the wheel ticks, so the dispatch times show its resolution
+    runUntil(2000, 5);
+
+    EXPECT_EQ(3, dispatchedCount);
+    EXPECT_EQ(&a, dispatched[0]);
+    EXPECT_EQ(&b, dispatched[1]);
+    EXPECT_EQ(&c, dispatched[2]);
+    EXPECT_FALSE(dispatchIsPending(&a));
+
+    // never early, and within one tick of when it was due
+    EXPECT_LE(1100, dispatchedAt[0]);
+    EXPECT_GT(1100 + 16 + 5, dispatchedAt[0]);
+    EXPECT_LE(1200, dispatchedAt[1]);
+    EXPECT_GT(1200 + 16 + 5, dispatchedAt[1]);
+    EXPECT_LE(1300, dispatchedAt[2]);
+    EXPECT_GT(1300 + 16 + 5, dispatchedAt[2]);
+}
+
+TEST(DispatchUnittest, TestLongDelaysAreCascaded)
+{
+    static dispatchEntry_t shortEntry = { .dispatch = recordDispatch };
+    static dispatchEntry_t mediumEntry = { .dispatch = recordDispatch };
+    static dispatchEntry_t longEntry = { .dispatch = recordDispatch };
+    static dispatchEntry_t veryLongEntry = { .dispatch = recordDispatch };
+
+    // start close to the wrap of the time counter
+    now = 0xffffffff - 500000;
+    simulatedTime = now;
+    resetDispatched();
+
+    dispatchAdd(&veryLongEntry, 30000000);  // beyond the span of the wheel
+    dispatchAdd(&longEntry, 2000000);
+    dispatchAdd(&mediumEntry, 20000);
+    dispatchAdd(&shortEntry, 300);
+
+    const uint32_t start = now;
+    runUntil(start + 31000000, 1000);
+
+    EXPECT_EQ(4, dispatchedCount);
+    EXPECT_EQ(&shortEntry, dispatched[0]);
+    EXPECT_EQ(&mediumEntry, dispatched[1]);
+    EXPECT_EQ(&longEntry, dispatched[2]);
+    EXPECT_EQ(&veryLongEntry, dispatched[3]);
+
+    // the dispatcher runs every 1ms, so that is the precision here
+    EXPECT_LE(300, dispatchedAt[0] - start);
+    EXPECT_GT(300 + 1000 + 16, dispatchedAt[0] - start);
+    EXPECT_LE(20000, dispatchedAt[1] - start);
+    EXPECT_GT(20000 + 1000 + 16, dispatchedAt[1] - start);
+    EXPECT_LE(2000000, dispatchedAt[2] - start);
+    EXPECT_GT(2000000 + 1000 + 16, dispatchedAt[2] - start);
+    EXPECT_LE(30000000, dispatchedAt[3] - start);
+    EXPECT_GT(30000000 + 1000 + 16, dispatchedAt[3] - start);
+}
+
+static dispatchEntry_t repeatEntry;
+
+static void repeatDispatch(dispatchEntry_t *self)
+{
+    recordDispatch(self);
+    if (dispatchedCount < 3) {
+        dispatchAdd(self, 500);
+    }
+}
+
+TEST(DispatchUnittest, TestHandlerCanReplanSelf)
+{
+    repeatEntry.dispatch = repeatDispatch;
+
+    now = 5000;
+    simulatedTime = now;
+    resetDispatched();
+
+    dispatchAdd(&repeatEntry, 500);
+    runUntil(10000, 100);
+
+    EXPECT_EQ(3, dispatchedCount);
+    EXPECT_LE(5500, dispatchedAt[0]);
+    EXPECT_LE(dispatchedAt[0] + 500, dispatchedAt[1]);
+    EXPECT_LE(dispatchedAt[1] + 500, dispatchedAt[2]);
+    EXPECT_FALSE(dispatchIsPending(&repeatEntry));
+}
+
+TEST(DispatchUnittest, TestAddPendingEntryIsIgnored)
+{
+    static dispatchEntry_t entry = { .dispatch = recordDispatch };
+
+    now = 20000;
+    simulatedTime = now;
+    resetDispatched();
+
+    dispatchAdd(&entry, 1000);
+    dispatchAdd(&entry, 100);
+    runUntil(22000, 10);
+
+    // dispatched once, at the original time
+    EXPECT_EQ(1, dispatchedCount);
+    EXPECT_LE(21000, dispatchedAt[0]);
+}
@@ -0,0 +1,329 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "common/arena.h"
+
+    #include "drivers/flash.h"
+    #include "drivers/flash_m25p16.h"
+
+    #include "io/flashfs.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+#define TEST_FLASH_SIZE (64 * 1024)
+
+static uint8_t flashMemory[TEST_FLASH_SIZE];
+
+// what the arena has left is less than a page more than the write buffer needs
+static uint8_t arenaPool[FLASHFS_ARENA_SIZE + M25P16_PAGESIZE - 4] __attribute__((aligned(ARENA_ALIGNMENT)));
+
+// The page program being sent, it only reaches the flash once the transfer completes, as with DMA
+static const uint8_t *transferData;
+static uint32_t transferAddress;
+static int transferLength;
+static int transferPollsRemaining;
+static int transferPolls;
+
+static int programCount;
+static bool programCrossedPage;
+
+static void resetFlash(int pollsPerTransfer)
+{
+    transferPolls = pollsPerTransfer;
+
+    arenaInit(arenaPool, sizeof(arenaPool));
+    flashfsEraseCompletely();
+    flashfsInit();
+
+    programCount = 0;
+    programCrossedPage = false;
+}
+
+static void completeTransfer(void)
+{
+    for (int i = 0; i < transferLength; i++) {
+        flashMemory[transferAddress + i] &= transferData[i];
+    }
+    transferData = NULL;
+}
+
+static void fillPattern(uint8_t *data, int length, uint8_t seed)
+{
+    for (int i = 0; i < length; i++) {
+        data[i] = seed + i * 7;
+    }
+}
+
+TEST(FlashfsUnittest, TestWriteBufferIsWholePagesOfArena)
+{
+    resetFlash(0);
+
+    EXPECT_EQ(FLASHFS_WRITE_BUFFER_SIZE, flashfsGetWriteBufferSize());
+    EXPECT_EQ(FLASHFS_WRITE_BUFFER_SIZE, flashfsGetWriteBufferFreeSpace());
+    EXPECT_EQ(M25P16_PAGESIZE - 4, arenaFree());
+}
+
+TEST(FlashfsUnittest, TestOnlyWholePagesAreProgrammedUntilFlushed)
+{
+    resetFlash(0);
+    EXPECT_EQ(0, flashfsGetOffset());
+
+    uint8_t data[500];
+    fillPattern(data, sizeof(data), 1);
+
+    for (int i = 0; i < 5; i++) {
+        flashfsWrite(data + i * 100, 100, false);
+    }
+    EXPECT_EQ(500, flashfsGetOffset());
+
+    // The first page was programmed when it filled, the second is still being filled
+    EXPECT_EQ(1, programCount);
+    EXPECT_EQ(500 - M25P16_PAGESIZE, FLASHFS_WRITE_BUFFER_SIZE - flashfsGetWriteBufferFreeSpace());
+
+    EXPECT_FALSE(flashfsFlushAsync(false));
+    EXPECT_EQ(1, programCount);
+
+    EXPECT_TRUE(flashfsFlushAsync(true));
+    EXPECT_EQ(2, programCount);
+    EXPECT_FALSE(programCrossedPage);
+
+    EXPECT_EQ(0, memcmp(data, flashMemory, sizeof(data)));
+    EXPECT_EQ(0xff, flashMemory[sizeof(data)]);
+}
+
+TEST(FlashfsUnittest, TestBufferIsKeptUntilTransferCompletes)
+{
+    resetFlash(10);
+
+    uint8_t data[2 * M25P16_PAGESIZE + 16];
+    fillPattern(data, sizeof(data), 2);
+
+    flashfsWrite(data, M25P16_PAGESIZE, false);
+    EXPECT_EQ(1, programCount);
+    EXPECT_FALSE(flashfsIsReady());
+
+    // The page being sent still takes up room in the buffer
+    EXPECT_EQ(FLASHFS_WRITE_BUFFER_SIZE - M25P16_PAGESIZE, flashfsGetWriteBufferFreeSpace());
+
+    flashfsWrite(data + M25P16_PAGESIZE, M25P16_PAGESIZE, false);
+    EXPECT_EQ(0, flashfsGetWriteBufferFreeSpace());
+
+    // No room, so this is dropped
+    flashfsWrite(data + 2 * M25P16_PAGESIZE, 16, false);
+    EXPECT_EQ(2 * M25P16_PAGESIZE, flashfsGetOffset());
+
+    // The second page is only started once the first has been sent
+    while (!flashfsFlushAsync(false)) {
+    }
+    EXPECT_EQ(2, programCount);
+    EXPECT_EQ(FLASHFS_WRITE_BUFFER_SIZE, flashfsGetWriteBufferFreeSpace());
+
+    EXPECT_EQ(0, memcmp(data, flashMemory, 2 * M25P16_PAGESIZE));
+    EXPECT_EQ(0xff, flashMemory[2 * M25P16_PAGESIZE]);
+}
+
+TEST(FlashfsUnittest, TestUnalignedStartProgramsToPageBoundaries)
+{
+    resetFlash(2);
+    flashfsSeekAbs(100);
+
+    uint8_t data[300];
+    fillPattern(data, sizeof(data), 3);
+
+    flashfsWrite(data, sizeof(data), false);
+    EXPECT_EQ(400, flashfsGetOffset());
+    EXPECT_EQ(1, programCount);
+
+    flashfsFlushSync();
+    EXPECT_EQ(2, programCount);
+    EXPECT_FALSE(programCrossedPage);
+    EXPECT_EQ(FLASHFS_WRITE_BUFFER_SIZE, flashfsGetWriteBufferFreeSpace());
+
+    EXPECT_EQ(0xff, flashMemory[99]);
+    EXPECT_EQ(0, memcmp(data, flashMemory + 100, sizeof(data)));
+    EXPECT_EQ(0xff, flashMemory[400]);
+}
+
+TEST(FlashfsUnittest, TestSyncWriteLargerThanBuffer)
+{
+    resetFlash(1);
+    flashfsSeekAbs(10);
+
+    uint8_t data[3 * FLASHFS_WRITE_BUFFER_SIZE + 50];
+    fillPattern(data, sizeof(data), 4);
+
+    flashfsWrite(data, sizeof(data), true);
+    flashfsFlushSync();
+    EXPECT_FALSE(programCrossedPage);
+
+    uint8_t readBack[sizeof(data)];
+    EXPECT_EQ((int)sizeof(data), flashfsReadAbs(10, readBack, sizeof(readBack)));
+    EXPECT_EQ(0, memcmp(data, readBack, sizeof(data)));
+}
+
+TEST(FlashfsUnittest, TestWritesPastEndAreDropped)
+{
+    resetFlash(0);
+    flashfsSeekAbs(TEST_FLASH_SIZE - 16);
+
+    uint8_t data[64];
+    fillPattern(data, sizeof(data), 5);
+
+    flashfsWrite(data, sizeof(data), false);
+    flashfsFlushSync();
+
+    EXPECT_TRUE(flashfsIsEOF());
+    EXPECT_EQ(0, memcmp(data, flashMemory + TEST_FLASH_SIZE - 16, 16));
+    EXPECT_EQ(FLASHFS_WRITE_BUFFER_SIZE, flashfsGetWriteBufferFreeSpace());
+}
+
+TEST(FlashfsUnittest, TestInitFindsEndOfLogs)
+{
+    resetFlash(0);
+    EXPECT_EQ(0, flashfsGetOffset());
+
+    // A log ending part way through a page
+    uint8_t data[3 * M25P16_PAGESIZE + 37];
+    fillPattern(data, sizeof(data), 6);
+    data[sizeof(data) - 1] = 0;
+
+    flashfsWrite(data, sizeof(data), true);
+    flashfsFlushSync();
+
+    flashfsInit();
+    EXPECT_EQ(sizeof(data), flashfsGetOffset());
+
+    // A second log appended to the first, ending with bytes that look erased
+    memset(data, 0xff, sizeof(data));
+    data[0] = 0;
+    flashfsWrite(data, 20, false);
+    flashfsFlushSync();
+
+    flashfsInit();
+    EXPECT_EQ(sizeof(data) + 1, flashfsGetOffset());
+
+    // A log ending on a page boundary
+    const int length = 4 * M25P16_PAGESIZE - flashfsGetOffset();
+    fillPattern(data, length, 7);
+    data[length - 1] = 0;
+    flashfsWrite(data, length, true);
+    flashfsFlushSync();
+
+    flashfsInit();
+    EXPECT_EQ(4 * M25P16_PAGESIZE, flashfsGetOffset());
+}
+
+TEST(FlashfsUnittest, TestInitFindsFullFlash)
+{
+    resetFlash(0);
+    memset(flashMemory, 0, sizeof(flashMemory));
+
+    flashfsInit();
+    EXPECT_TRUE(flashfsIsEOF());
+}
+
+// STUBS
+
+extern "C" {
+
+static flashGeometry_t geometry = {
+    .sectors = TEST_FLASH_SIZE / (256 * M25P16_PAGESIZE),
+    .pagesPerSector = 256,
+    .pageSize = M25P16_PAGESIZE,
+    .sectorSize = 256 * M25P16_PAGESIZE,
+    .totalSize = TEST_FLASH_SIZE
+};
+
+const flashGeometry_t* m25p16_getGeometry(void)
+{
+    return &geometry;
+}
+
+bool m25p16_isTransferInProgress(void)
+{
+    if (transferData && transferPollsRemaining-- <= 0) {
+        completeTransfer();
+    }
+    return transferData != NULL;
+}
+
+bool m25p16_isReady(void)
+{
+    return !m25p16_isTransferInProgress();
+}
+
+bool m25p16_waitForReady(uint32_t timeoutMillis)
+{
+    UNUSED(timeoutMillis);
+    while (!m25p16_isReady()) {
+    }
+    return true;
+}
+
+void m25p16_pageProgramAsync(uint32_t address, const uint8_t *data, int length)
+{
+    m25p16_waitForReady(0);
+
+    if (address / M25P16_PAGESIZE != (address + length - 1) / M25P16_PAGESIZE || address + length > TEST_FLASH_SIZE) {
+        programCrossedPage = true;
+        return;
+    }
+
+    programCount++;
+    transferData = data;
+    transferAddress = address;
+    transferLength = length;
+    transferPollsRemaining = transferPolls;
+    m25p16_isTransferInProgress();
+}
+
+void m25p16_pageProgram(uint32_t address, const uint8_t *data, int length)
+{
+    m25p16_pageProgramAsync(address, data, length);
+    m25p16_waitForReady(0);
+}
+
+int m25p16_readBytes(uint32_t address, uint8_t *buffer, int length)
+{
+    m25p16_waitForReady(0);
+    if (address + length > TEST_FLASH_SIZE) {
+        length = TEST_FLASH_SIZE - address;
+    }
+    memcpy(buffer, flashMemory + address, length);
+    return length;
+}
+
+void m25p16_eraseSector(uint32_t address)
+{
+    memset(flashMemory + address, 0xff, geometry.sectorSize);
+}
+
+void m25p16_eraseCompletely(void)
+{
+    memset(flashMemory, 0xff, sizeof(flashMemory));
+}
+
+}
@@ -413,7 +413,7 @@ TEST(FlightFailsafeTest, TestFailsafeNotActivatedWhenDisarmedAndRXLossIsDetected
 extern "C" {
 int16_t rcData[MAX_SUPPORTED_RC_CHANNEL_COUNT];
 float rcCommand[4];
-int16_t debug[DEBUG16_VALUE_COUNT];
+int32_t debug[DEBUG_VALUE_COUNT];
 bool isUsingSticksToArm = true;
 
 PG_REGISTER(rxConfig_t, rxConfig, PG_RX_CONFIG, 0);
@@ -454,4 +454,6 @@ bool isUsingSticksForArming(void)
 }
 
 void beeperConfirmationBeeps(uint8_t beepCount) { UNUSED(beepCount); }
+
+uint8_t rxGetLinkQuality(void) { return 100; }
 }
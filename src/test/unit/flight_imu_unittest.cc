@@ -200,7 +200,7 @@ TEST(FlightImuTest, TestSmallAngle)
 // STUBS
 
 extern "C" {
-uint32_t rcModeActivationMask;
+boxBitmask_t rcModeActivationMask;
 float rcCommand[4];
 int16_t rcData[MAX_SUPPORTED_RC_CHANNEL_COUNT];
 
@@ -210,8 +210,9 @@ mag_t mag;
 
 gpsSolutionData_t gpsSol;
 
-uint8_t debugMode;
-int16_t debug[DEBUG16_VALUE_COUNT];
+uint32_t debugModeMask;
+uint8_t debugModeOffset[DEBUG_COUNT];
+int32_t debug[DEBUG_VALUE_COUNT];
 
 uint8_t stateFlags;
 uint16_t flightModeFlags;
@@ -238,6 +239,13 @@ bool sensors(uint32_t mask)
 uint32_t millis(void) { return 0; }
 uint32_t micros(void) { return 0; }
 
+bool gyroGetDeltaAngle(float deltaAngle[XYZ_AXIS_COUNT], timeUs_t *deltaTimeUs)
+{
+    deltaAngle[X] = deltaAngle[Y] = deltaAngle[Z] = 0.0f;
+    *deltaTimeUs = 0;
+    return false;
+}
+
 bool isBaroCalibrationComplete(void) { return true; }
 void performBaroCalibrationCycle(void) {}
 int32_t baroCalculateAltitude(void) { return 0; }
@@ -61,6 +61,13 @@ extern "C" {
     uint32_t serialRxBytesWaiting(const serialPort_t *) { return 0; }
     uint8_t serialRead(serialPort_t *) { return 0; }
     void serialWrite(serialPort_t *, uint8_t) {}
+    void serialWriteBuf(serialPort_t *, const uint8_t *, int) {}
+    uint32_t serialTxBytesFree(const serialPort_t *) { return 0; }
+    uint32_t serialReserveWrite(serialPort_t *, uint8_t **) { return 0; }
+    void serialCommitWrite(serialPort_t *, uint32_t) {}
+    void serialSetBaudRate(serialPort_t *, uint32_t) {}
+
+    uint32_t usbVcpGetBaudRate(serialPort_t *) { return 0; }
 
     serialPort_t *usbVcpOpen(void) { return NULL; }
 
@@ -195,6 +195,18 @@ TEST(MathsUnittest, TestApplyDeadband)
     EXPECT_EQ(applyDeadband(-11, 10), -1);
 }
 
+TEST(MathsUnittest, TestFApplyDeadband)
+{
+    EXPECT_FLOAT_EQ(fapplyDeadband(0.0f, 0.0f), 0.0f);
+    EXPECT_FLOAT_EQ(fapplyDeadband(1.5f, 0.0f), 1.5f);
+
+    EXPECT_FLOAT_EQ(fapplyDeadband(2.5f, 2.5f), 0.0f);
+    EXPECT_FLOAT_EQ(fapplyDeadband(-2.0f, 2.5f), 0.0f);
+
+    EXPECT_FLOAT_EQ(fapplyDeadband(3.0f, 2.5f), 0.5f);
+    EXPECT_FLOAT_EQ(fapplyDeadband(-3.0f, 2.5f), -0.5f);
+}
+
 void expectVectorsAreEqual(struct fp_vector *a, struct fp_vector *b, float absTol)
 {
     EXPECT_NEAR(a->X, b->X, absTol);
@@ -247,6 +259,41 @@ TEST(MathsUnittest, TestFastTrigonometrySinCos)
     EXPECT_LE(cosError, 3.5e-6);
 }
 
+TEST(MathsUnittest, TestFastTrigonometrySinCosPair)
+{
+    double sinError = 0;
+    double cosError = 0;
+    for (float x = -10 * M_PI; x < 10 * M_PI; x += M_PI / 300) {
+        float sinResult, cosResult;
+        sincos_approx(x, &sinResult, &cosResult);
+        EXPECT_EQ(sin_approx(x), sinResult);
+        sinError = MAX(sinError, fabs(sinResult - sinf(x)));
+        cosError = MAX(cosError, fabs(cosResult - cosf(x)));
+    }
+    printf("sincos_approx maximum absolute error = %e, %e\n", sinError, cosError);
+    EXPECT_LE(sinError, 3e-6);
+    EXPECT_LE(cosError, 3.5e-6);
+
+    // out of range input gives 0, as sin_approx does
+    float sinResult, cosResult;
+    sincos_approx(100.0f, &sinResult, &cosResult);
+    EXPECT_EQ(0.0f, sinResult);
+    EXPECT_EQ(0.0f, cosResult);
+}
+
+TEST(MathsUnittest, TestFastTrigonometrySinCos3)
+{
+    const float x[3] = { -2.5f, 0.3f, 3.1f };
+    float sinResult[3], cosResult[3];
+    sincos3_approx(x, sinResult, cosResult);
+    for (int i = 0; i < 3; i++) {
+        float sinExpected, cosExpected;
+        sincos_approx(x[i], &sinExpected, &cosExpected);
+        EXPECT_EQ(sinExpected, sinResult[i]);
+        EXPECT_EQ(cosExpected, cosResult[i]);
+    }
+}
+
 TEST(MathsUnittest, TestFastTrigonometryATan2)
 {
     double error = 0;
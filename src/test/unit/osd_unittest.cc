@@ -46,6 +46,8 @@ extern "C" {
 
     #include "rx/rx.h"
 
+    #include "scheduler/scheduler.h"
+
     void osdRefresh(timeUs_t currentTimeUs);
     void osdFormatTime(char * buff, osd_timer_precision_e precision, timeUs_t time);
     void osdFormatTimer(char *buff, bool showSymbol, int timerIndex);
@@ -53,7 +55,7 @@ extern "C" {
     uint16_t rssi;
     attitudeEulerAngles_t attitude;
     pidProfile_t *currentPidProfile;
-    int16_t debug[DEBUG16_VALUE_COUNT];
+    int32_t debug[DEBUG_VALUE_COUNT];
     int16_t rcData[MAX_SUPPORTED_RC_CHANNEL_COUNT];
     uint8_t GPS_numSat;
     uint16_t GPS_distanceToHome;
@@ -576,15 +578,17 @@ extern "C" {
         UNUSED(beepCount);
     }
 
-    bool IS_RC_MODE_ACTIVE(boxId_e boxId) {
-        UNUSED(boxId);
-        return false;
-    }
+    boxBitmask_t rcModeActivationMask;
 
     uint32_t micros() {
         return simulationTime;
     }
 
+    timeDelta_t schedulerGetTaskTimeBudgetUs(void) {
+        // enough for every element to be drawn in one refresh
+        return 1000;
+    }
+
     bool isBeeperOn() {
         return false;
     }
@@ -647,4 +651,12 @@ extern "C" {
         UNUSED(pDisplay);
         return false;
     }
+
+    bool failsafeIsLinkDegraded(void) {
+        return false;
+    }
+
+    uint8_t rxGetLinkQuality(void) {
+        return 100;
+    }
 }
@@ -34,10 +34,10 @@ extern "C" {
 PG_REGISTER_WITH_RESET_TEMPLATE(motorConfig_t, motorConfig, PG_MOTOR_CONFIG, 1);
 
 PG_RESET_TEMPLATE(motorConfig_t, motorConfig,
+    .dev = {.motorPwmRate = 400},
     .minthrottle = 1150,
     .maxthrottle = 1850,
     .mincommand = 1000,
-    .dev = {.motorPwmRate = 400}
 );
 }
 
@@ -83,6 +83,33 @@ TEST(ParameterGroupsfTest, Test_pgFind)
     EXPECT_EQ(400, motorConfig3.dev.motorPwmRate);
 }
 
+TEST(ParameterGroupsfTest, Test_pgGeneration)
+{
+    pgResetAll();
+    const uint16_t generation = motorConfigGeneration();
+    EXPECT_EQ(generation, motorConfigGeneration());
+
+    // a write through any pointer counts
+    motorConfig_t *config = motorConfigMutable();
+    config->minthrottle = 1070;
+    const uint16_t changedGeneration = motorConfigGeneration();
+    EXPECT_NE(generation, changedGeneration);
+    EXPECT_EQ(changedGeneration, motorConfigGeneration());
+
+    // writing the same value again does not
+    config->minthrottle = 1070;
+    EXPECT_EQ(changedGeneration, motorConfigGeneration());
+
+    // nor does loading what the group already holds
+    motorConfig_t stored;
+    pgStore(pgFind(PG_MOTOR_CONFIG), &stored, sizeof(stored));
+    pgLoad(pgFind(PG_MOTOR_CONFIG), &stored, sizeof(stored), 1);
+    EXPECT_EQ(changedGeneration, motorConfigGeneration());
+
+    pgResetAll();
+    EXPECT_NE(changedGeneration, motorConfigGeneration());
+}
+
 // STUBS
 
 extern "C" {
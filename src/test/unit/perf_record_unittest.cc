@@ -0,0 +1,130 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "fc/fc_dispatch.h"
+    #include "fc/perf_record.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+static perfRecord_t record;
+
+static void resetRecord(void)
+{
+    memset(&record, 0, sizeof(record));
+}
+
+TEST(PerfRecordUnittest, TestHealthyFlightsCountWithoutSaving)
+{
+    resetRecord();
+    perfFlightStats_t flight;
+    memset(&flight, 0, sizeof(flight));
+    flight.maxLoopLatenessUs = 15;
+    flight.peakSystemLoadPercent = 40;
+
+    // the first flight sets the worst, so it is saved
+    EXPECT_TRUE(perfRecordAddFlight(&record, &flight));
+
+    // the same flight again is neither an error nor a new worst
+    EXPECT_FALSE(perfRecordAddFlight(&record, &flight));
+    flight.peakSystemLoadPercent = 35;
+    EXPECT_FALSE(perfRecordAddFlight(&record, &flight));
+
+    EXPECT_EQ(3, record.flights);
+    EXPECT_EQ(0, record.flightsWithErrors);
+    EXPECT_EQ(35, record.lastFlight.peakSystemLoadPercent);
+    EXPECT_EQ(40, record.worstFlight.peakSystemLoadPercent);
+    EXPECT_EQ(15, record.worstFlight.maxLoopLatenessUs);
+}
+
+TEST(PerfRecordUnittest, TestErrorsAreAlwaysSaved)
+{
+    resetRecord();
+    perfFlightStats_t flight;
+    memset(&flight, 0, sizeof(flight));
+    flight.uartOverruns = 3;
+
+    EXPECT_TRUE(perfRecordAddFlight(&record, &flight));
+    // no new worst, but the flight still had errors
+    EXPECT_TRUE(perfRecordAddFlight(&record, &flight));
+
+    flight.uartOverruns = 0;
+    flight.missedLoopPeriods = 1;
+    EXPECT_TRUE(perfRecordAddFlight(&record, &flight));
+
+    EXPECT_EQ(3, record.flights);
+    EXPECT_EQ(3, record.flightsWithErrors);
+    EXPECT_EQ(0, record.lastFlight.uartOverruns);
+    EXPECT_EQ(3, record.worstFlight.uartOverruns);
+    EXPECT_EQ(1, record.worstFlight.missedLoopPeriods);
+}
+
+TEST(PerfRecordUnittest, TestWorstIsTakenFieldByField)
+{
+    resetRecord();
+    perfFlightStats_t flight;
+    memset(&flight, 0, sizeof(flight));
+    flight.gyroOverflows = 2;
+    flight.sdcardMaxWriteLatencyMs = 10;
+    perfRecordAddFlight(&record, &flight);
+
+    memset(&flight, 0, sizeof(flight));
+    flight.spiErrors = 1;
+    flight.sdcardMaxWriteLatencyMs = 30;
+    perfRecordAddFlight(&record, &flight);
+
+    EXPECT_EQ(2, record.worstFlight.gyroOverflows);
+    EXPECT_EQ(1, record.worstFlight.spiErrors);
+    EXPECT_EQ(30, record.worstFlight.sdcardMaxWriteLatencyMs);
+    EXPECT_EQ(0, record.lastFlight.gyroOverflows);
+}
+
+TEST(PerfRecordUnittest, TestCountsSaturate)
+{
+    resetRecord();
+    record.flights = UINT16_MAX;
+    record.flightsWithErrors = UINT16_MAX;
+    perfFlightStats_t flight;
+    memset(&flight, 0, sizeof(flight));
+    flight.i2cErrors = 1;
+
+    perfRecordAddFlight(&record, &flight);
+
+    EXPECT_EQ(UINT16_MAX, record.flights);
+    EXPECT_EQ(UINT16_MAX, record.flightsWithErrors);
+}
+
+// STUBS
+
+extern "C" {
+    uint16_t averageSystemLoadPercent = 0;
+
+    void dispatchEnable(void) {}
+    void dispatchAdd(dispatchEntry_t *, int) {}
+    void writeEEPROMAsync(void) {}
+    uint32_t uartGetOverrunCounter(void) { return 0; }
+    uint16_t gyroGetOverflowCount(void) { return 0; }
+    uint32_t blackboxGetDroppedFrames(void) { return 0; }
+}
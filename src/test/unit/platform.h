@@ -19,6 +19,10 @@
 
 #define USE_PARAMETER_GROUPS
 
+#define FAST_CODE
+#define FAST_RAM
+#define DMA_RAM
+
 #define U_ID_0 0
 #define U_ID_1 1
 #define U_ID_2 2
@@ -51,6 +55,7 @@ typedef enum {
 typedef struct
 {
     void *test;
+    uint32_t BSRR;
 } GPIO_TypeDef;
 
 typedef struct
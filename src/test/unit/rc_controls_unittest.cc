@@ -76,6 +76,7 @@ TEST_F(RcControlsModesTest, updateActivatedModesWithAllInputsAtMidde)
     }
 
     // when
+    analyzeModeActivationConditions();
     updateActivatedModes();
 
     // then
@@ -167,6 +168,7 @@ TEST_F(RcControlsModesTest, updateActivatedModesUsingValidAuxConfigurationAndRXV
     bitArraySet(&activeBoxIds, 5);
 
     // when
+    analyzeModeActivationConditions();
     updateActivatedModes();
 
     // then
@@ -178,6 +180,52 @@ TEST_F(RcControlsModesTest, updateActivatedModesUsingValidAuxConfigurationAndRXV
     }
 }
 
+TEST_F(RcControlsModesTest, updateActivatedModesOnlyReevaluatesChangedAuxChannels)
+{
+    // given
+    memset(modeActivationConditionsMutable(0), 0, sizeof(modeActivationCondition_t) * MAX_MODE_ACTIVATION_CONDITION_COUNT);
+    modeActivationConditionsMutable(0)->modeId = (boxId_e)0;
+    modeActivationConditionsMutable(0)->auxChannelIndex = AUX1 - NON_AUX_CHANNEL_COUNT;
+    modeActivationConditionsMutable(0)->range.startStep = CHANNEL_VALUE_TO_STEP(1700);
+    modeActivationConditionsMutable(0)->range.endStep = CHANNEL_VALUE_TO_STEP(2100);
+
+    for (int index = AUX1; index < MAX_SUPPORTED_RC_CHANNEL_COUNT; index++) {
+        rcData[index] = PWM_RANGE_MIDDLE;
+    }
+    rcData[AUX1] = PWM_RANGE_MAX;
+
+    analyzeModeActivationConditions();
+    updateActivatedModes();
+    EXPECT_EQ(true, IS_RC_MODE_ACTIVE((boxId_e)0));
+
+    // when the mode state is cleared and the aux channels only move within their current steps
+    boxBitmask_t mask;
+    memset(&mask, 0, sizeof(mask));
+    rcModeUpdate(&mask);
+    rcData[AUX1] = PWM_RANGE_MAX + 10;
+    rcData[AUX2] = PWM_RANGE_MIDDLE + 10;
+    updateActivatedModes();
+
+    // then no condition is evaluated again
+    EXPECT_EQ(0, getAuxChannelChangedMask());
+    EXPECT_EQ(false, IS_RC_MODE_ACTIVE((boxId_e)0));
+
+    // when the channel moves out of the range
+    rcData[AUX1] = PWM_RANGE_MIDDLE;
+    updateActivatedModes();
+
+    // then only that channel is reported as changed
+    EXPECT_EQ(1 << (AUX1 - NON_AUX_CHANNEL_COUNT), getAuxChannelChangedMask());
+    EXPECT_EQ(false, IS_RC_MODE_ACTIVE((boxId_e)0));
+
+    // when it moves back in
+    rcData[AUX1] = PWM_RANGE_MAX;
+    updateActivatedModes();
+
+    // then
+    EXPECT_EQ(true, IS_RC_MODE_ACTIVE((boxId_e)0));
+}
+
 enum {
     COUNTER_QUEUE_CONFIRMATION_BEEP,
     COUNTER_CHANGE_CONTROL_RATE_PROFILE
@@ -487,6 +535,46 @@ TEST_F(RcControlsAdjustmentsTest, processRcRateProfileAdjustments)
     EXPECT_EQ(adjustmentStateMask, expectedAdjustmentStateMask);
 }
 
+TEST_F(RcControlsAdjustmentsTest, updateAdjustmentStatesForChangedChannels)
+{
+    // given a range on AUX1 and one on AUX2, both covering the whole channel
+    memset(adjustmentRangesMutable(0), 0, sizeof(adjustmentRange_t) * MAX_ADJUSTMENT_RANGE_COUNT);
+    adjustmentRange_t *rateRange = adjustmentRangesMutable(0);
+    rateRange->auxChannelIndex = AUX1 - NON_AUX_CHANNEL_COUNT;
+    rateRange->range.startStep = CHANNEL_VALUE_TO_STEP(CHANNEL_RANGE_MIN);
+    rateRange->range.endStep = CHANNEL_VALUE_TO_STEP(CHANNEL_RANGE_MAX);
+    rateRange->adjustmentFunction = ADJUSTMENT_RC_RATE;
+    rateRange->adjustmentIndex = 0;
+    adjustmentRange_t *pidRange = adjustmentRangesMutable(1);
+    *pidRange = *rateRange;
+    pidRange->auxChannelIndex = AUX2 - NON_AUX_CHANNEL_COUNT;
+    pidRange->adjustmentFunction = ADJUSTMENT_PITCH_ROLL_P;
+    pidRange->adjustmentIndex = 1;
+
+    for (int index = AUX1; index < MAX_SUPPORTED_RC_CHANNEL_COUNT; index++) {
+        rcData[index] = PWM_RANGE_MIDDLE;
+    }
+
+    // when every channel is checked after the ranges were set up
+    analyzeModeActivationConditions();
+    updateActivatedModes();
+    updateAdjustmentStates();
+
+    // then both ranges are active
+    EXPECT_EQ(ADJUSTMENT_RC_RATE, adjustmentStates[0].config->adjustmentFunction);
+    EXPECT_EQ(ADJUSTMENT_PITCH_ROLL_P, adjustmentStates[1].config->adjustmentFunction);
+
+    // when only AUX1 moves
+    resetAdjustmentStates();
+    rcData[AUX1] = PWM_RANGE_MAX;
+    updateActivatedModes();
+    updateAdjustmentStates();
+
+    // then only its range is checked again
+    EXPECT_EQ(ADJUSTMENT_RC_RATE, adjustmentStates[0].config->adjustmentFunction);
+    EXPECT_EQ(NULL, adjustmentStates[1].config);
+}
+
 static const adjustmentConfig_t pidPitchAndRollPAdjustmentConfig = {
     .adjustmentFunction = ADJUSTMENT_PITCH_ROLL_P,
     .mode = ADJUSTMENT_MODE_STEP,
@@ -673,6 +761,8 @@ void saveConfigAndNotify(void) {}
 void generateThrottleCurve(void) {}
 void changePidProfile(uint8_t) {}
 void pidInitConfig(const pidProfile_t *) {}
+void pidInitGains(const pidProfile_t *) {}
+void writeEEPROMAsync(void) {}
 void accSetCalibrationCycles(uint16_t) {}
 void gyroStartCalibration(void) {}
 void applyAndSaveAccelerometerTrimsDelta(rollAndPitchTrims_t*) {}
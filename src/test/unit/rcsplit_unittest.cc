@@ -170,6 +170,7 @@ TEST(RCSplitTest, TestWifiModeChangeWithDeviceUnready)
     rcData[modeActivationConditions(1)->auxChannelIndex + NON_AUX_CHANNEL_COUNT] = 900;
     rcData[modeActivationConditions(2)->auxChannelIndex + NON_AUX_CHANNEL_COUNT] = 900;
 
+    analyzeModeActivationConditions();
     updateActivatedModes();
 
     // runn process loop
@@ -219,6 +220,7 @@ TEST(RCSplitTest, TestWifiModeChangeWithDeviceReady)
     rcData[modeActivationConditions(1)->auxChannelIndex + NON_AUX_CHANNEL_COUNT] = 2000;
     rcData[modeActivationConditions(2)->auxChannelIndex + NON_AUX_CHANNEL_COUNT] = 1700;
 
+    analyzeModeActivationConditions();
     updateActivatedModes();
 
     // runn process loop
@@ -272,6 +274,7 @@ TEST(RCSplitTest, TestWifiModeChangeCombine)
     rcData[modeActivationConditions(0)->auxChannelIndex + NON_AUX_CHANNEL_COUNT] = 1700;
     rcData[modeActivationConditions(1)->auxChannelIndex + NON_AUX_CHANNEL_COUNT] = 2000;
     rcData[modeActivationConditions(2)->auxChannelIndex + NON_AUX_CHANNEL_COUNT] = 1700;
+    analyzeModeActivationConditions();
     updateActivatedModes();
 
     // runn process loop
@@ -325,12 +328,8 @@ extern "C" {
             s.vTable = NULL;
 
             // common serial initialisation code should move to serialPort::init()
-            s.rxBufferHead = s.rxBufferTail = 0;
-            s.txBufferHead = s.txBufferTail = 0;
-            s.rxBufferSize = 0;
-            s.txBufferSize = 0;
-            s.rxBuffer = s.rxBuffer;
-            s.txBuffer = s.txBuffer;
+            ringBufferInit(&s.rxBuffer, NULL, 0);
+            ringBufferInit(&s.txBuffer, NULL, 0);
 
             // callback works for IRQ-based RX ONLY
             s.rxCallback = NULL;
@@ -399,26 +398,6 @@ extern "C" {
             sbufWriteData(dst, string, strlen(string));
         }
     }
-    void sbufWriteU8(sbuf_t *dst, uint8_t val) 
-    { 
-        UNUSED(dst); UNUSED(val); 
-
-        if (testData.isAllowBufferReadWrite) {
-            *dst->ptr++ = val;
-        }
-    }
-    
-    void sbufWriteData(sbuf_t *dst, const void *data, int len)
-    {
-        UNUSED(dst); UNUSED(data); UNUSED(len); 
-
-        if (testData.isAllowBufferReadWrite) {
-            memcpy(dst->ptr, data, len);
-            dst->ptr += len;
-            
-        }
-    }
-
     // modifies streambuf so that written data are prepared for reading
     void sbufSwitchToReader(sbuf_t *buf, uint8_t *base)
     {
@@ -0,0 +1,157 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+extern "C" {
+    #include "common/ringbuffer.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+#define TEST_BUFFER_SIZE 16
+
+static volatile uint8_t storage[TEST_BUFFER_SIZE];
+static ringBuffer_t rb;
+
+TEST(RingBufferUnittest, TestPushPop)
+{
+    ringBufferInit(&rb, storage, TEST_BUFFER_SIZE);
+    EXPECT_TRUE(ringBufferIsEmpty(&rb));
+    EXPECT_EQ(0, ringBufferCount(&rb));
+    EXPECT_EQ(TEST_BUFFER_SIZE - 1, ringBufferFree(&rb));
+
+    // one slot is kept empty, so only size - 1 bytes fit
+    for (int i = 0; i < TEST_BUFFER_SIZE - 1; i++) {
+        EXPECT_TRUE(ringBufferPush(&rb, i));
+    }
+    EXPECT_FALSE(ringBufferPush(&rb, 0xff));
+    EXPECT_EQ(TEST_BUFFER_SIZE - 1, ringBufferCount(&rb));
+    EXPECT_EQ(0, ringBufferFree(&rb));
+
+    for (int i = 0; i < TEST_BUFFER_SIZE - 1; i++) {
+        EXPECT_EQ(i, ringBufferPop(&rb));
+    }
+    EXPECT_TRUE(ringBufferIsEmpty(&rb));
+
+    // popping an empty buffer leaves it empty
+    EXPECT_EQ(0, ringBufferPop(&rb));
+    EXPECT_TRUE(ringBufferIsEmpty(&rb));
+}
+
+TEST(RingBufferUnittest, TestBulkWriteReadWraps)
+{
+    ringBufferInit(&rb, storage, TEST_BUFFER_SIZE);
+
+    // move the indices close to the end so the bulk operations have to wrap
+    uint8_t scratch[TEST_BUFFER_SIZE];
+    EXPECT_EQ(12, ringBufferWrite(&rb, scratch, 12));
+    EXPECT_EQ(12, ringBufferRead(&rb, scratch, 12));
+
+    uint8_t data[TEST_BUFFER_SIZE];
+    for (int i = 0; i < TEST_BUFFER_SIZE; i++) {
+        data[i] = 0x10 + i;
+    }
+
+    // only size - 1 bytes are accepted
+    EXPECT_EQ(TEST_BUFFER_SIZE - 1, ringBufferWrite(&rb, data, TEST_BUFFER_SIZE));
+    EXPECT_EQ(0, ringBufferWrite(&rb, data, 1));
+    EXPECT_EQ(TEST_BUFFER_SIZE - 1, ringBufferCount(&rb));
+
+    uint8_t out[TEST_BUFFER_SIZE] = { 0 };
+    EXPECT_EQ(5, ringBufferRead(&rb, out, 5));
+    EXPECT_EQ(TEST_BUFFER_SIZE - 1 - 5, ringBufferRead(&rb, out + 5, TEST_BUFFER_SIZE));
+    for (int i = 0; i < TEST_BUFFER_SIZE - 1; i++) {
+        EXPECT_EQ(data[i], out[i]);
+    }
+    EXPECT_TRUE(ringBufferIsEmpty(&rb));
+    EXPECT_EQ(0, ringBufferRead(&rb, out, 1));
+}
+
+TEST(RingBufferUnittest, TestPeekContiguous)
+{
+    ringBufferInit(&rb, storage, TEST_BUFFER_SIZE);
+
+    volatile uint8_t *data;
+    EXPECT_EQ(0, ringBufferPeekContiguous(&rb, &data));
+
+    uint8_t scratch[TEST_BUFFER_SIZE];
+    ringBufferWrite(&rb, scratch, 10);
+    ringBufferRead(&rb, scratch, 10);
+
+    const uint8_t bytes[] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+    EXPECT_EQ(sizeof(bytes), ringBufferWrite(&rb, bytes, sizeof(bytes)));
+
+    // the first region runs up to the end of the storage
+    EXPECT_EQ(6, ringBufferPeekContiguous(&rb, &data));
+    EXPECT_EQ(&storage[10], data);
+    EXPECT_EQ(1, data[0]);
+    EXPECT_EQ(6, data[5]);
+
+    // peeking does not consume
+    EXPECT_EQ(sizeof(bytes), ringBufferCount(&rb));
+
+    ringBufferAdvance(&rb, 6);
+    EXPECT_EQ(2, ringBufferPeekContiguous(&rb, &data));
+    EXPECT_EQ(&storage[0], data);
+    EXPECT_EQ(7, data[0]);
+    EXPECT_EQ(8, data[1]);
+
+    ringBufferAdvance(&rb, 2);
+    EXPECT_TRUE(ringBufferIsEmpty(&rb));
+    EXPECT_EQ(0, ringBufferPeekContiguous(&rb, &data));
+}
+
+TEST(RingBufferUnittest, TestReserveContiguous)
+{
+    ringBufferInit(&rb, storage, TEST_BUFFER_SIZE);
+
+    // an empty buffer starting at 0 can take all but the one slot that is always left empty
+    volatile uint8_t *data;
+    EXPECT_EQ(TEST_BUFFER_SIZE - 1, ringBufferReserveContiguous(&rb, &data));
+    EXPECT_EQ(&storage[0], data);
+
+    uint8_t scratch[TEST_BUFFER_SIZE];
+    ringBufferWrite(&rb, scratch, 10);
+    ringBufferRead(&rb, scratch, 10);
+
+    // with the tail away from 0 the region runs up to the end of the storage
+    EXPECT_EQ(TEST_BUFFER_SIZE - 10, ringBufferReserveContiguous(&rb, &data));
+    EXPECT_EQ(&storage[10], data);
+    for (int i = 0; i < 6; i++) {
+        data[i] = i + 1;
+    }
+
+    // nothing is visible until it is committed
+    EXPECT_TRUE(ringBufferIsEmpty(&rb));
+    ringBufferCommit(&rb, 6);
+    EXPECT_EQ(6, ringBufferCount(&rb));
+
+    // the region after the commit wraps to the start and stops one short of the tail
+    EXPECT_EQ(9, ringBufferReserveContiguous(&rb, &data));
+    EXPECT_EQ(&storage[0], data);
+    ringBufferRead(&rb, scratch, 3);
+    EXPECT_EQ(12, ringBufferReserveContiguous(&rb, &data));
+    EXPECT_EQ(&storage[0], data);
+
+    uint8_t out[3];
+    EXPECT_EQ(3, ringBufferRead(&rb, out, 3));
+    EXPECT_EQ(4, out[0]);
+    EXPECT_EQ(6, out[2]);
+}
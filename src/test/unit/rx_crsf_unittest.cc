@@ -26,6 +26,7 @@ extern "C" {
 
     #include "build/debug.h"
 
+    #include "common/crc.h"
     #include "common/maths.h"
     #include "common/utils.h"
 
@@ -41,7 +42,7 @@ extern "C" {
 
     extern bool crsfFrameDone;
     extern crsfFrame_t crsfFrame;
-    extern uint32_t crsfChannelData[CRSF_MAX_CHANNEL];
+    extern uint16_t crsfChannelData[CRSF_MAX_CHANNEL];
 
     uint32_t dummyTimeUs;
 }
@@ -107,6 +108,9 @@ TEST(CrossFireTest, CRC)
     EXPECT_EQ(crc1, crc2);
 }
 
+// channel data is scaled to PWM range when the frame is decoded
+#define CRSF_PWM(value) ((value) * 1024 / 1639 + 881)
+
 TEST(CrossFireTest, TestCrsfFrameStatus)
 {
     crsfFrameDone = true;
@@ -125,7 +129,7 @@ TEST(CrossFireTest, TestCrsfFrameStatus)
     EXPECT_EQ(CRSF_FRAME_RC_CHANNELS_PAYLOAD_SIZE + CRSF_FRAME_LENGTH_TYPE_CRC, crsfFrame.frame.frameLength);
     EXPECT_EQ(CRSF_FRAMETYPE_RC_CHANNELS_PACKED, crsfFrame.frame.type);
     for (int ii = 0; ii < CRSF_MAX_CHANNEL; ++ii) {
-        EXPECT_EQ(0, crsfChannelData[ii]);
+        EXPECT_EQ(CRSF_PWM(0), crsfChannelData[ii]);
     }
 }
 
@@ -175,22 +179,22 @@ TEST(CrossFireTest, TestCrsfFrameStatusUnpacking)
     EXPECT_EQ(CRSF_ADDRESS_CRSF_RECEIVER, crsfFrame.frame.deviceAddress);
     EXPECT_EQ(CRSF_FRAME_RC_CHANNELS_PAYLOAD_SIZE + CRSF_FRAME_LENGTH_TYPE_CRC, crsfFrame.frame.frameLength);
     EXPECT_EQ(CRSF_FRAMETYPE_RC_CHANNELS_PACKED, crsfFrame.frame.type);
-    EXPECT_EQ(0x7ff, crsfChannelData[0]);
-    EXPECT_EQ(0x1f, crsfChannelData[1]);
-    EXPECT_EQ(0, crsfChannelData[2]);
-    EXPECT_EQ(172, crsfChannelData[3]);  //  172 = 0x0ac, 0001 0101100, bits 33-43
-    EXPECT_EQ(0, crsfChannelData[4]);
-    EXPECT_EQ(992, crsfChannelData[5]);  //  992 = 0x3e0, 01 1110000 0, bits 55-65
-    EXPECT_EQ(0, crsfChannelData[6]);
-    EXPECT_EQ(1811, crsfChannelData[7]); // 1811 = 0x713, 1110 0010 011, bits 77-87
-    EXPECT_EQ(0, crsfChannelData[8]);
-    EXPECT_EQ(0, crsfChannelData[9]);
-    EXPECT_EQ(0, crsfChannelData[10]);
-    EXPECT_EQ(0, crsfChannelData[11]);
-    EXPECT_EQ(0, crsfChannelData[12]);
-    EXPECT_EQ(0, crsfChannelData[13]);
-    EXPECT_EQ(0, crsfChannelData[14]);
-    EXPECT_EQ(0, crsfChannelData[15]);
+    EXPECT_EQ(CRSF_PWM(0x7ff), crsfChannelData[0]);
+    EXPECT_EQ(CRSF_PWM(0x1f), crsfChannelData[1]);
+    EXPECT_EQ(CRSF_PWM(0), crsfChannelData[2]);
+    EXPECT_EQ(CRSF_PWM(172), crsfChannelData[3]);  //  172 = 0x0ac, 0001 0101100, bits 33-43
+    EXPECT_EQ(CRSF_PWM(0), crsfChannelData[4]);
+    EXPECT_EQ(CRSF_PWM(992), crsfChannelData[5]);  //  992 = 0x3e0, 01 1110000 0, bits 55-65
+    EXPECT_EQ(CRSF_PWM(0), crsfChannelData[6]);
+    EXPECT_EQ(CRSF_PWM(1811), crsfChannelData[7]); // 1811 = 0x713, 1110 0010 011, bits 77-87
+    EXPECT_EQ(CRSF_PWM(0), crsfChannelData[8]);
+    EXPECT_EQ(CRSF_PWM(0), crsfChannelData[9]);
+    EXPECT_EQ(CRSF_PWM(0), crsfChannelData[10]);
+    EXPECT_EQ(CRSF_PWM(0), crsfChannelData[11]);
+    EXPECT_EQ(CRSF_PWM(0), crsfChannelData[12]);
+    EXPECT_EQ(CRSF_PWM(0), crsfChannelData[13]);
+    EXPECT_EQ(CRSF_PWM(0), crsfChannelData[14]);
+    EXPECT_EQ(CRSF_PWM(0), crsfChannelData[15]);
 }
 
 const uint8_t capturedData[] = {
@@ -220,10 +224,10 @@ TEST(CrossFireTest, TestCapturedData)
     EXPECT_EQ(CRSF_ADDRESS_BROADCAST, crsfFrame.frame.deviceAddress);
     EXPECT_EQ(CRSF_FRAME_RC_CHANNELS_PAYLOAD_SIZE + CRSF_FRAME_LENGTH_TYPE_CRC, crsfFrame.frame.frameLength);
     EXPECT_EQ(CRSF_FRAMETYPE_RC_CHANNELS_PACKED, crsfFrame.frame.type);
-    EXPECT_EQ(189, crsfChannelData[0]);
-    EXPECT_EQ(993, crsfChannelData[1]);
-    EXPECT_EQ(978, crsfChannelData[2]);
-    EXPECT_EQ(983, crsfChannelData[3]);
+    EXPECT_EQ(CRSF_PWM(189), crsfChannelData[0]);
+    EXPECT_EQ(CRSF_PWM(993), crsfChannelData[1]);
+    EXPECT_EQ(CRSF_PWM(978), crsfChannelData[2]);
+    EXPECT_EQ(CRSF_PWM(983), crsfChannelData[3]);
     uint8_t crc = crsfFrameCRC();
     EXPECT_EQ(crc, crsfFrame.frame.payload[CRSF_FRAME_RC_CHANNELS_PAYLOAD_SIZE]);
     EXPECT_EQ(999, crsfReadRawRC(NULL, 0));
@@ -242,10 +246,10 @@ TEST(CrossFireTest, TestCapturedData)
     EXPECT_EQ(CRSF_ADDRESS_BROADCAST, crsfFrame.frame.deviceAddress);
     EXPECT_EQ(CRSF_FRAME_RC_CHANNELS_PAYLOAD_SIZE + CRSF_FRAME_LENGTH_TYPE_CRC, crsfFrame.frame.frameLength);
     EXPECT_EQ(CRSF_FRAMETYPE_RC_CHANNELS_PACKED, crsfFrame.frame.type);
-    EXPECT_EQ(189, crsfChannelData[0]);
-    EXPECT_EQ(993, crsfChannelData[1]);
-    EXPECT_EQ(978, crsfChannelData[2]);
-    EXPECT_EQ(981, crsfChannelData[3]);
+    EXPECT_EQ(CRSF_PWM(189), crsfChannelData[0]);
+    EXPECT_EQ(CRSF_PWM(993), crsfChannelData[1]);
+    EXPECT_EQ(CRSF_PWM(978), crsfChannelData[2]);
+    EXPECT_EQ(CRSF_PWM(981), crsfChannelData[3]);
     crc = crsfFrameCRC();
     EXPECT_EQ(crc, crsfFrame.frame.payload[CRSF_FRAME_RC_CHANNELS_PAYLOAD_SIZE]);
 }
@@ -269,15 +273,48 @@ TEST(CrossFireTest, TestCrsfDataReceive)
     EXPECT_EQ(crc, crsfFrame.frame.payload[CRSF_FRAME_RC_CHANNELS_PAYLOAD_SIZE]);
 }
 
+TEST(CrossFireTest, TestCrsfParameterRequest)
+{
+    crsfRxClearParameterRequest();
+
+    // device ping addressed to another device is ignored
+    crsfFrameDone = true;
+    crsfFrame.frame.deviceAddress = CRSF_ADDRESS_CRSF_RECEIVER;
+    crsfFrame.frame.frameLength = CRSF_FRAME_LENGTH_EXT_TYPE_CRC;
+    crsfFrame.frame.type = CRSF_FRAMETYPE_DEVICE_PING;
+    crsfFrame.frame.payload[0] = CRSF_ADDRESS_CRSF_RECEIVER;
+    crsfFrame.frame.payload[1] = CRSF_ADDRESS_RADIO_TRANSMITTER;
+    crsfFrame.frame.payload[2] = crsfFrameCRC();
+    EXPECT_EQ(RX_FRAME_PENDING, crsfFrameStatus());
+    EXPECT_EQ(NULL, crsfRxGetParameterRequest());
+
+    // device ping addressed to the flight controller is kept for the telemetry task
+    crsfFrameDone = true;
+    crsfFrame.frame.payload[0] = CRSF_ADDRESS_FLIGHT_CONTROLLER;
+    crsfFrame.frame.payload[2] = crsfFrameCRC();
+    EXPECT_EQ(RX_FRAME_PENDING, crsfFrameStatus());
+    const crsfFrame_t *request = crsfRxGetParameterRequest();
+    EXPECT_NE((const crsfFrame_t *)NULL, request);
+    EXPECT_EQ(CRSF_FRAMETYPE_DEVICE_PING, request->frame.type);
+    EXPECT_EQ(CRSF_ADDRESS_RADIO_TRANSMITTER, request->frame.payload[1]);
+
+    crsfRxClearParameterRequest();
+    EXPECT_EQ(NULL, crsfRxGetParameterRequest());
+}
+
 // STUBS
 
 extern "C" {
 
-int16_t debug[DEBUG16_VALUE_COUNT];
+int32_t debug[DEBUG_VALUE_COUNT];
 uint32_t micros(void) {return dummyTimeUs;}
 serialPort_t *openSerialPort(serialPortIdentifier_e, serialPortFunction_e, serialReceiveCallbackPtr, uint32_t, portMode_t, portOptions_t) {return NULL;}
 serialPortConfig_t *findSerialPortConfig(serialPortFunction_e ) {return NULL;}
+const serialPortConfig_t *serialRxFindPortConfig(void) {return NULL;}
 void serialWriteBuf(serialPort_t *, const uint8_t *, int) {}
 bool telemetryCheckRxPortShared(const serialPortConfig_t *) {return false;}
 serialPort_t *telemetrySharedPort = NULL;
+void rxSignalFrameComplete(void) {}
+void serialSetBaudRate(serialPort_t *, uint32_t) {}
+bool isSerialTransmitBufferEmpty(const serialPort_t *) { return true; }
 }
@@ -67,6 +67,8 @@ uint32_t micros(void)
     return microseconds_stub_value;
 }
 
+void rxSignalFrameComplete(void) {}
+
 #define SERIAL_BUFFER_SIZE 256
 #define SERIAL_PORT_DUMMY_IDENTIFIER  (serialPortIdentifier_e)0x1234
 
@@ -98,9 +100,8 @@ bool isSerialPortShared(const serialPortConfig_t *portConfig,
     return portIsShared;
 }
 
-serialPortConfig_t *findSerialPortConfig(serialPortFunction_e function)
+const serialPortConfig_t *serialRxFindPortConfig(void)
 {
-    EXPECT_EQ(function, FUNCTION_RX_SERIAL);
     return findSerialPortConfig_stub_retval;
 }
 
@@ -315,7 +316,8 @@ TEST_F(IbusRxProtocollUnitTest, Test_IA6B_OnePacketReceivedWithBadCrc)
         stub_serialRxCallback(packet[i]);
     }
 
-    //no frame complete
+    //no frame complete, the frame is reported as dropped once
+    EXPECT_EQ(RX_FRAME_DROPPED, rxRuntimeConfig.rcFrameStatusFn());
     EXPECT_EQ(RX_FRAME_PENDING, rxRuntimeConfig.rcFrameStatusFn());
 
     //check that channel values have not been updated
@@ -397,7 +399,8 @@ TEST_F(IbusRxProtocollUnitTest, Test_IA6_OnePacketReceivedBadCrc)
         stub_serialRxCallback(packet[i]);
     }
 
-    //no frame complete
+    //no frame complete, the frame is reported as dropped once
+    EXPECT_EQ(RX_FRAME_DROPPED, rxRuntimeConfig.rcFrameStatusFn());
     EXPECT_EQ(RX_FRAME_PENDING, rxRuntimeConfig.rcFrameStatusFn());
 
     //check that channel values have not been updated
@@ -0,0 +1,113 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <stdint.h>
+#include <stdbool.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "rx/rx_link_quality.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+#define FRAME_INTERVAL_US 10000
+
+TEST(RxLinkQualityTest, TestGoodFramesFillTheWindow)
+{
+    rxLinkQualityInit();
+    EXPECT_EQ(0, rxGetLinkQuality());
+
+    for (int i = 0; i < RX_LINK_QUALITY_WINDOW / 2; i++) {
+        rxLinkQualityRecord(RX_LQ_FRAME_GOOD);
+    }
+    EXPECT_EQ(50, rxGetLinkQuality());
+
+    for (int i = 0; i < RX_LINK_QUALITY_WINDOW; i++) {
+        rxLinkQualityRecord(RX_LQ_FRAME_GOOD);
+    }
+    EXPECT_EQ(100, rxGetLinkQuality());
+    EXPECT_EQ((uint32_t)RX_LINK_QUALITY_WINDOW * 3 / 2, rxGetLinkQualityStats()->eventCount[RX_LQ_FRAME_GOOD]);
+}
+
+TEST(RxLinkQualityTest, TestBadFramesReplaceTheOldest)
+{
+    rxLinkQualityInit();
+    for (int i = 0; i < RX_LINK_QUALITY_WINDOW; i++) {
+        rxLinkQualityRecord(RX_LQ_FRAME_GOOD);
+    }
+
+    for (int i = 0; i < 10; i++) {
+        rxLinkQualityRecord(RX_LQ_FRAME_DROPPED);
+    }
+    for (int i = 0; i < 5; i++) {
+        rxLinkQualityRecord(RX_LQ_FRAME_FAILSAFE);
+    }
+    EXPECT_EQ(85, rxGetLinkQuality());
+    EXPECT_EQ(10U, rxGetLinkQualityStats()->eventCount[RX_LQ_FRAME_DROPPED]);
+    EXPECT_EQ(5U, rxGetLinkQualityStats()->eventCount[RX_LQ_FRAME_FAILSAFE]);
+
+    // the bad frames leave the window again
+    for (int i = 0; i < RX_LINK_QUALITY_WINDOW; i++) {
+        rxLinkQualityRecord(RX_LQ_FRAME_GOOD);
+    }
+    EXPECT_EQ(100, rxGetLinkQuality());
+}
+
+TEST(RxLinkQualityTest, TestMissingFramesAreCounted)
+{
+    rxLinkQualityInit();
+    timeUs_t timeUs = 1000000;
+
+    for (int i = 0; i < RX_LINK_QUALITY_WINDOW; i++) {
+        rxLinkQualityRecord(RX_LQ_FRAME_GOOD);
+        timeUs += FRAME_INTERVAL_US;
+        rxLinkQualityUpdate(timeUs, FRAME_INTERVAL_US);
+    }
+    EXPECT_EQ(100, rxGetLinkQuality());
+
+    // a late frame within the jitter allowance is not a loss
+    rxLinkQualityUpdate(timeUs + FRAME_INTERVAL_US + FRAME_INTERVAL_US / 4, FRAME_INTERVAL_US);
+    EXPECT_EQ(0U, rxGetLinkQualityStats()->eventCount[RX_LQ_FRAME_MISSED]);
+
+    // nothing for 10 frame intervals
+    timeUs += 10 * FRAME_INTERVAL_US;
+    rxLinkQualityUpdate(timeUs, FRAME_INTERVAL_US);
+    EXPECT_EQ(9U, rxGetLinkQualityStats()->eventCount[RX_LQ_FRAME_MISSED]);
+    EXPECT_EQ(91, rxGetLinkQuality());
+
+    // the link comes back, the gap is not counted twice
+    rxLinkQualityRecord(RX_LQ_FRAME_GOOD);
+    timeUs += FRAME_INTERVAL_US;
+    rxLinkQualityUpdate(timeUs, FRAME_INTERVAL_US);
+    EXPECT_EQ(9U, rxGetLinkQualityStats()->eventCount[RX_LQ_FRAME_MISSED]);
+}
+
+TEST(RxLinkQualityTest, TestLongLossEmptiesTheWindow)
+{
+    rxLinkQualityInit();
+    for (int i = 0; i < RX_LINK_QUALITY_WINDOW; i++) {
+        rxLinkQualityRecord(RX_LQ_FRAME_GOOD);
+    }
+    rxLinkQualityUpdate(1000000, FRAME_INTERVAL_US);
+
+    rxLinkQualityUpdate(1000000 + 1000 * FRAME_INTERVAL_US, FRAME_INTERVAL_US);
+    EXPECT_EQ(0, rxGetLinkQuality());
+}
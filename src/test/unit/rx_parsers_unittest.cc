@@ -0,0 +1,661 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "build/debug.h"
+
+    #include "common/crc.h"
+    #include "common/maths.h"
+    #include "common/utils.h"
+
+    #include "config/feature.h"
+
+    #include "fc/fc_dispatch.h"
+
+    #include "io/serial.h"
+
+    #include "rx/rx.h"
+    #include "rx/crsf.h"
+    #include "rx/ibus.h"
+    #include "rx/jetiexbus.h"
+    #include "rx/sbus.h"
+    #include "rx/spektrum.h"
+    #include "rx/sumd.h"
+    #include "rx/sumh.h"
+    #include "rx/xbus.h"
+
+    #include "telemetry/ibus_shared.h"
+    #include "telemetry/telemetry.h"
+
+    uint16_t calcCRC16(uint8_t *pt, uint8_t msgLen);
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+/*
+ * Drives every serial RX parser, byte by byte through its receive callback and at the line rate of the
+ * protocol, with clean frames, frames with a bit flipped, and random noise, and reports what parsing costs
+ * on the host and how often noise or corruption gets through as a frame.
+ *
+ * A frame counts as accepted when the frame status is complete without failsafe or dropped, that is when
+ * its channels would be used. Protocols without a checksum accept much of what looks like a frame, their
+ * figures are reported but only the clean and resync runs are checked for them.
+ *
+ * A recorded stream is replayed too if RX_CAPTURE names one, with RX_CAPTURE_PROTOCOL naming its protocol
+ * as in the table below. It is a text file with one byte per line, the time it arrived in microseconds
+ * followed by its value in hex, as exported by most logic analysers.
+ *
+ * The host cycle counts only compare parser changes and builds with each other.
+ */
+
+#define FRAME_COUNT         2000
+#define NOISE_BYTE_COUNT    200000
+#define NOISE_BURST_MAX     64
+#define CHANNEL_TOLERANCE   2   // us, for the rounding of each protocol's scaling
+
+typedef int (*buildFrameFnPtr)(uint8_t *frame, const uint16_t *channels, uint32_t frameIndex);
+
+typedef struct rxProtocol_s {
+    const char *name;
+    SerialRXType provider;
+    bool (*init)(const rxConfig_t *rxConfig, rxRuntimeConfig_t *rxRuntimeConfig);
+    buildFrameFnPtr buildFrame;
+    uint32_t baudRate;
+    uint8_t bitsPerByte;
+    uint32_t frameIntervalUs;
+    bool checksummed;
+} rxProtocol_t;
+
+typedef struct parseStats_s {
+    uint32_t byteCount;
+    uint32_t framesSent;
+    uint32_t framesAccepted;
+    uint32_t framesDropped;
+    uint32_t channelMismatches;
+    uint64_t receiveCycles;
+    uint64_t statusCycles;
+} parseStats_t;
+
+static serialReceiveCallbackPtr rxCallback;
+static rxRuntimeConfig_t runtimeConfig;
+static uint64_t fakeTimeNs;
+static bool frameSignalled;
+static uint32_t randomState;
+
+extern "C" {
+    int32_t debug[DEBUG_VALUE_COUNT];
+    uint32_t debugModeMask;
+    uint8_t debugModeOffset[DEBUG_COUNT];
+
+    uint32_t getCycleCounter(void)
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        return (uint32_t)__builtin_ia32_rdtsc();
+#else
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return (uint32_t)(now.tv_sec * 1000000000ULL + now.tv_nsec);
+#endif
+    }
+}
+
+// xorshift, so that the streams are the same with every C library
+static uint32_t randomNext(void)
+{
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState;
+}
+
+static uint16_t crc16Ccitt(uint16_t crc, const uint8_t *data, int length)
+{
+    for (int ii = 0; ii < length; ++ii) {
+        crc ^= (uint16_t)data[ii] << 8;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+static void pack11BitChannels(uint8_t *packed, const uint16_t *values, int count)
+{
+    memset(packed, 0, count * 11 / 8);
+    for (int ii = 0; ii < count; ++ii) {
+        const int bitOffset = ii * 11;
+        for (int bit = 0; bit < 11; ++bit) {
+            if (values[ii] & (1 << bit)) {
+                packed[(bitOffset + bit) / 8] |= 1 << ((bitOffset + bit) % 8);
+            }
+        }
+    }
+}
+
+static int buildSbusFrame(uint8_t *frame, const uint16_t *channels, uint32_t frameIndex)
+{
+    UNUSED(frameIndex);
+    uint16_t values[16];
+    for (int ii = 0; ii < 16; ++ii) {
+        values[ii] = (channels[ii] - 880) * 8 / 5;
+    }
+    frame[0] = 0x0F;
+    pack11BitChannels(&frame[1], values, 16);
+    frame[23] = 0; // flags
+    frame[24] = 0;
+    return 25;
+}
+
+static int buildCrsfFrame(uint8_t *frame, const uint16_t *channels, uint32_t frameIndex)
+{
+    UNUSED(frameIndex);
+    uint16_t values[CRSF_MAX_CHANNEL];
+    for (int ii = 0; ii < CRSF_MAX_CHANNEL; ++ii) {
+        values[ii] = ((channels[ii] - 881) * 1639 + 1023) / 1024;
+    }
+    frame[0] = CRSF_ADDRESS_FLIGHT_CONTROLLER;
+    frame[1] = CRSF_FRAME_RC_CHANNELS_PAYLOAD_SIZE + CRSF_FRAME_LENGTH_TYPE_CRC;
+    frame[2] = CRSF_FRAMETYPE_RC_CHANNELS_PACKED;
+    pack11BitChannels(&frame[3], values, CRSF_MAX_CHANNEL);
+    frame[25] = crc8_dvb_s2_update(0, &frame[2], CRSF_FRAME_RC_CHANNELS_PAYLOAD_SIZE + CRSF_FRAME_LENGTH_TYPE);
+    return 26;
+}
+
+static int buildIbusFrame(uint8_t *frame, const uint16_t *channels, uint32_t frameIndex)
+{
+    UNUSED(frameIndex);
+    frame[0] = 0x20;
+    frame[1] = 0x40;
+    for (int ii = 0; ii < 14; ++ii) {
+        frame[2 + ii * 2] = channels[ii] & 0xff;
+        frame[3 + ii * 2] = channels[ii] >> 8;
+    }
+    uint16_t checksum = 0xffff;
+    for (int ii = 0; ii < 30; ++ii) {
+        checksum -= frame[ii];
+    }
+    frame[30] = checksum & 0xff;
+    frame[31] = checksum >> 8;
+    return 32;
+}
+
+static int buildSumdFrame(uint8_t *frame, const uint16_t *channels, uint32_t frameIndex)
+{
+    UNUSED(frameIndex);
+    frame[0] = 0xA8;
+    frame[1] = 0x01;
+    frame[2] = 16;
+    for (int ii = 0; ii < 16; ++ii) {
+        const uint16_t value = channels[ii] * 8;
+        frame[3 + ii * 2] = value >> 8;
+        frame[4 + ii * 2] = value & 0xff;
+    }
+    const uint16_t crc = crc16Ccitt(0, frame, 35);
+    frame[35] = crc >> 8;
+    frame[36] = crc & 0xff;
+    return 37;
+}
+
+static int buildSumhFrame(uint8_t *frame, const uint16_t *channels, uint32_t frameIndex)
+{
+    UNUSED(frameIndex);
+    frame[0] = 0xA8;
+    frame[1] = 0x01;
+    frame[2] = 8;
+    for (int ii = 0; ii < 8; ++ii) {
+        const uint16_t value = (channels[ii] + 375) * 32 / 5;
+        frame[3 + ii * 2] = value >> 8;
+        frame[4 + ii * 2] = value & 0xff;
+    }
+    frame[19] = 0;
+    frame[20] = 0;
+    return 21;
+}
+
+static int buildSpektrumFrame(uint8_t *frame, const uint16_t *channels, uint32_t frameIndex)
+{
+    // 2048 mode, the twelve channels are split over two frames
+    const int firstChannel = (frameIndex & 1) ? 5 : 0;
+    frame[0] = 0;
+    frame[1] = 0;
+    for (int ii = 0; ii < 7; ++ii) {
+        const int channel = firstChannel + ii;
+        const uint16_t value = (channel << 11) | ((channels[channel] - 988) * 2);
+        frame[2 + ii * 2] = value >> 8;
+        frame[3 + ii * 2] = value & 0xff;
+    }
+    return SPEK_FRAME_SIZE;
+}
+
+static int buildXbusFrame(uint8_t *frame, const uint16_t *channels, uint32_t frameIndex)
+{
+    UNUSED(frameIndex);
+    frame[0] = 0xA1;
+    for (int ii = 0; ii < 12; ++ii) {
+        const uint16_t value = ((channels[ii] - 800) * 4096 + 1399) / 1400;
+        frame[1 + ii * 2] = value >> 8;
+        frame[2 + ii * 2] = value & 0xff;
+    }
+    const uint16_t crc = crc16Ccitt(0, frame, 25);
+    frame[25] = crc >> 8;
+    frame[26] = crc & 0xff;
+    return 27;
+}
+
+static int buildJetiExBusFrame(uint8_t *frame, const uint16_t *channels, uint32_t frameIndex)
+{
+    frame[0] = 0x3E;
+    frame[1] = 0x03;
+    frame[2] = 40;
+    frame[3] = frameIndex & 0xff;
+    frame[4] = 0x31;
+    frame[5] = 32;
+    for (int ii = 0; ii < 16; ++ii) {
+        const uint16_t value = channels[ii] * 8;
+        frame[6 + ii * 2] = value & 0xff;
+        frame[7 + ii * 2] = value >> 8;
+    }
+    const uint16_t crc = calcCRC16(frame, 38);
+    frame[38] = crc & 0xff;
+    frame[39] = crc >> 8;
+    return 40;
+}
+
+static const rxProtocol_t rxProtocols[] = {
+    { "SBUS",      SERIALRX_SBUS,         sbusInit,      buildSbusFrame,      100000, 12,  9000, false },
+    { "SUMD",      SERIALRX_SUMD,         sumdInit,      buildSumdFrame,      115200, 10, 10000, true },
+    { "SUMH",      SERIALRX_SUMH,         sumhInit,      buildSumhFrame,      115200, 10, 11000, false },
+    { "SPEKTRUM",  SERIALRX_SPEKTRUM2048, spektrumInit,  buildSpektrumFrame,  115200, 10, 11000, false },
+    { "XBUS",      SERIALRX_XBUS_MODE_B,  xBusInit,      buildXbusFrame,      115200, 10, 14000, true },
+    { "JETIEXBUS", SERIALRX_JETIEXBUS,    jetiExBusInit, buildJetiExBusFrame, 125000, 10, 10000, true },
+    { "CRSF",      SERIALRX_CRSF,         crsfRxInit,    buildCrsfFrame,      CRSF_BAUDRATE, 10, 4000, true },
+    { "IBUS",      SERIALRX_IBUS,         ibusInit,      buildIbusFrame,      115200, 10,  7000, true },
+};
+#define RX_PROTOCOL_COUNT ARRAYLEN(rxProtocols)
+
+static const rxProtocol_t *findProtocol(const char *name)
+{
+    for (unsigned ii = 0; ii < RX_PROTOCOL_COUNT; ++ii) {
+        if (strcmp(rxProtocols[ii].name, name) == 0) {
+            return &rxProtocols[ii];
+        }
+    }
+    return NULL;
+}
+
+static void initProtocol(const rxProtocol_t *protocol)
+{
+    rxConfig_t rxConfig;
+    memset(&rxConfig, 0, sizeof(rxConfig));
+    rxConfig.serialrx_provider = protocol->provider;
+    rxConfig.midrc = 1500;
+    memset(&runtimeConfig, 0, sizeof(runtimeConfig));
+    rxCallback = NULL;
+
+    EXPECT_TRUE(protocol->init(&rxConfig, &runtimeConfig));
+    ASSERT_TRUE(rxCallback != NULL);
+
+    // far enough from the last byte of any earlier run for every parser to start over
+    fakeTimeNs += 100 * 1000 * 1000;
+    frameSignalled = false;
+}
+
+static void pollFrameStatus(parseStats_t *stats)
+{
+    const uint32_t start = getCycleCounter();
+    const uint8_t status = runtimeConfig.rcFrameStatusFn();
+    stats->statusCycles += getCycleCounter() - start;
+
+    if (status & RX_FRAME_DROPPED) {
+        stats->framesDropped++;
+    } else if ((status & RX_FRAME_COMPLETE) && !(status & RX_FRAME_FAILSAFE)) {
+        stats->framesAccepted++;
+    }
+}
+
+static void feedByte(const rxProtocol_t *protocol, uint8_t c, parseStats_t *stats)
+{
+    // the byte is handed over once its stop bits are in
+    fakeTimeNs += protocol->bitsPerByte * 1000000000ULL / protocol->baudRate;
+
+    const uint32_t start = getCycleCounter();
+    rxCallback(c);
+    stats->receiveCycles += getCycleCounter() - start;
+    stats->byteCount++;
+
+    if (frameSignalled) {
+        frameSignalled = false;
+        pollFrameStatus(stats);
+    }
+}
+
+static void waitUntilNextFrame(const rxProtocol_t *protocol, int frameLength)
+{
+    fakeTimeNs += (uint64_t)protocol->frameIntervalUs * 1000
+        - (uint64_t)frameLength * protocol->bitsPerByte * 1000000000ULL / protocol->baudRate;
+}
+
+static void makeChannels(uint16_t *channels, uint32_t frameIndex)
+{
+    // every channel sweeps at its own rate, so the frames differ from one to the next
+    for (int ii = 0; ii < 16; ++ii) {
+        channels[ii] = 1000 + (frameIndex * (ii + 1) * 7) % 1001;
+    }
+}
+
+static void checkChannels(const rxProtocol_t *protocol, const uint16_t *channels, uint32_t frameIndex, parseStats_t *stats)
+{
+    // spektrum sends half of its channels in each frame
+    const int firstChannel = protocol->provider == SERIALRX_SPEKTRUM2048 ? ((frameIndex & 1) ? 5 : 0) : 0;
+    const int lastChannel = protocol->provider == SERIALRX_SPEKTRUM2048 ? firstChannel + 7 : MIN(runtimeConfig.channelCount, 16);
+    for (int ii = firstChannel; ii < lastChannel; ++ii) {
+        const int value = runtimeConfig.rcReadRawFn(&runtimeConfig, ii);
+        if (ABS(value - channels[ii]) > CHANNEL_TOLERANCE) {
+            stats->channelMismatches++;
+            return;
+        }
+    }
+}
+
+static void runCleanFrames(const rxProtocol_t *protocol, parseStats_t *stats)
+{
+    uint8_t frame[64];
+    uint16_t channels[16];
+
+    initProtocol(protocol);
+    for (uint32_t ii = 0; ii < FRAME_COUNT; ++ii) {
+        makeChannels(channels, ii);
+        const int length = protocol->buildFrame(frame, channels, ii);
+        const uint32_t acceptedBefore = stats->framesAccepted;
+        for (int jj = 0; jj < length; ++jj) {
+            feedByte(protocol, frame[jj], stats);
+        }
+        stats->framesSent++;
+        if (stats->framesAccepted != acceptedBefore) {
+            checkChannels(protocol, channels, ii, stats);
+        }
+        waitUntilNextFrame(protocol, length);
+    }
+}
+
+static void runCorruptedFrames(const rxProtocol_t *protocol, parseStats_t *stats)
+{
+    uint8_t frame[64];
+    uint16_t channels[16];
+
+    initProtocol(protocol);
+    for (uint32_t ii = 0; ii < FRAME_COUNT; ++ii) {
+        makeChannels(channels, ii);
+        const int length = protocol->buildFrame(frame, channels, ii);
+        const uint32_t bit = randomNext() % (length * 8);
+        frame[bit / 8] ^= 1 << (bit % 8);
+        const uint32_t acceptedBefore = stats->framesAccepted;
+        for (int jj = 0; jj < length; ++jj) {
+            feedByte(protocol, frame[jj], stats);
+        }
+        stats->framesSent++;
+        if (stats->framesAccepted != acceptedBefore) {
+            checkChannels(protocol, channels, ii, stats);
+        }
+        waitUntilNextFrame(protocol, length);
+    }
+}
+
+static void runNoise(const rxProtocol_t *protocol, parseStats_t *stats)
+{
+    initProtocol(protocol);
+    while (stats->byteCount < NOISE_BYTE_COUNT) {
+        // mostly back to back, with a gap now and then that lets the parsers start over
+        if ((randomNext() & 0x1f) == 0) {
+            fakeTimeNs += (uint64_t)(randomNext() % 20000) * 1000;
+        }
+        feedByte(protocol, randomNext() & 0xff, stats);
+    }
+}
+
+// noise up to the usual gap before a frame, then a clean frame, which has to be decoded
+static void runResync(const rxProtocol_t *protocol, parseStats_t *stats)
+{
+    uint8_t frame[64];
+    uint16_t channels[16];
+    parseStats_t noiseStats;
+    memset(&noiseStats, 0, sizeof(noiseStats));
+
+    initProtocol(protocol);
+    for (uint32_t ii = 0; ii < FRAME_COUNT; ++ii) {
+        const int burstLength = 1 + randomNext() % NOISE_BURST_MAX;
+        for (int jj = 0; jj < burstLength; ++jj) {
+            feedByte(protocol, randomNext() & 0xff, &noiseStats);
+        }
+        waitUntilNextFrame(protocol, 0);
+
+        makeChannels(channels, ii);
+        const int length = protocol->buildFrame(frame, channels, ii);
+        for (int jj = 0; jj < length; ++jj) {
+            feedByte(protocol, frame[jj], stats);
+        }
+        stats->framesSent++;
+        waitUntilNextFrame(protocol, length);
+    }
+}
+
+static double perMillion(uint32_t count, uint32_t total)
+{
+    return total ? count * 1000000.0 / total : 0.0;
+}
+
+TEST(RxParsersTest, CleanFramesAreAllDecoded)
+{
+    printf("\n%-10s %8s %8s %8s %12s %12s\n", "protocol", "sent", "decoded", "wrong", "cycles/frame", "cycles/byte");
+    for (unsigned ii = 0; ii < RX_PROTOCOL_COUNT; ++ii) {
+        const rxProtocol_t *protocol = &rxProtocols[ii];
+        parseStats_t stats;
+        memset(&stats, 0, sizeof(stats));
+        runCleanFrames(protocol, &stats);
+
+        const uint64_t cycles = stats.receiveCycles + stats.statusCycles;
+        printf("%-10s %8u %8u %8u %12.0f %12.1f\n", protocol->name, stats.framesSent, stats.framesAccepted,
+            stats.channelMismatches, (double)cycles / stats.framesSent, (double)stats.receiveCycles / stats.byteCount);
+
+        EXPECT_EQ(stats.framesSent, stats.framesAccepted) << protocol->name;
+        EXPECT_EQ(0u, stats.channelMismatches) << protocol->name;
+        EXPECT_EQ(0u, stats.framesDropped) << protocol->name;
+    }
+}
+
+TEST(RxParsersTest, CorruptedChannelsAreRejectedByChecksum)
+{
+    printf("\n%-10s %8s %8s %8s %8s\n", "protocol", "flipped", "accepted", "wrong", "dropped");
+    randomState = 0x1234567;
+    for (unsigned ii = 0; ii < RX_PROTOCOL_COUNT; ++ii) {
+        const rxProtocol_t *protocol = &rxProtocols[ii];
+        parseStats_t stats;
+        memset(&stats, 0, sizeof(stats));
+        runCorruptedFrames(protocol, &stats);
+
+        printf("%-10s %8u %8u %8u %8u\n", protocol->name, stats.framesSent, stats.framesAccepted, stats.channelMismatches, stats.framesDropped);
+
+        if (protocol->checksummed) {
+            // every checksum here catches a single flipped bit, only bits outside it, like the CRSF address, get through
+            EXPECT_EQ(0u, stats.channelMismatches) << protocol->name;
+        }
+    }
+}
+
+TEST(RxParsersTest, NoiseIsRarelyTakenForFrames)
+{
+    printf("\n%-10s %8s %8s %8s %14s\n", "protocol", "bytes", "accepted", "dropped", "accepted/Mbyte");
+    randomState = 0x89abcdef;
+    for (unsigned ii = 0; ii < RX_PROTOCOL_COUNT; ++ii) {
+        const rxProtocol_t *protocol = &rxProtocols[ii];
+        parseStats_t stats;
+        memset(&stats, 0, sizeof(stats));
+        runNoise(protocol, &stats);
+
+        const double falseFrameRate = perMillion(stats.framesAccepted, stats.byteCount);
+        printf("%-10s %8u %8u %8u %14.1f\n", protocol->name, stats.byteCount, stats.framesAccepted, stats.framesDropped, falseFrameRate);
+
+        if (protocol->checksummed) {
+            EXPECT_LT(falseFrameRate, 10.0) << protocol->name;
+        }
+    }
+}
+
+TEST(RxParsersTest, ParsersResyncAfterNoise)
+{
+    printf("\n%-10s %8s %8s\n", "protocol", "sent", "decoded");
+    randomState = 0x2468ace;
+    for (unsigned ii = 0; ii < RX_PROTOCOL_COUNT; ++ii) {
+        const rxProtocol_t *protocol = &rxProtocols[ii];
+        parseStats_t stats;
+        memset(&stats, 0, sizeof(stats));
+        runResync(protocol, &stats);
+
+        printf("%-10s %8u %8u\n", protocol->name, stats.framesSent, stats.framesAccepted);
+
+        EXPECT_EQ(stats.framesSent, stats.framesAccepted) << protocol->name;
+    }
+}
+
+TEST(RxParsersTest, RecordedStreamsAreDecoded)
+{
+    // two RC frames captured from a crossfire receiver
+    static const uint8_t crsfCapture[] = {
+        0x00,0x18,0x16,0xBD,0x08,0x9F,0xF4,0xAE,0xF7,0xBD,0xEF,0x7D,0xEF,0xFB,0xAD,0xFD,0x45,0x2B,0x5A,0x01,0x00,0x00,0x00,0x00,0x00,0x6C,
+        0x00,0x18,0x16,0xBD,0x08,0x9F,0xF4,0xAA,0xF7,0xBD,0xEF,0x7D,0xEF,0xFB,0xAD,0xFD,0x45,0x2B,0x5A,0x01,0x00,0x00,0x00,0x00,0x00,0x94,
+    };
+    const rxProtocol_t *protocol = findProtocol("CRSF");
+    const int frameLength = sizeof(crsfCapture) / 2;
+    parseStats_t stats;
+    memset(&stats, 0, sizeof(stats));
+
+    initProtocol(protocol);
+    for (int ii = 0; ii < FRAME_COUNT; ++ii) {
+        const uint8_t *frame = &crsfCapture[(ii & 1) * frameLength];
+        for (int jj = 0; jj < frameLength; ++jj) {
+            feedByte(protocol, frame[jj], &stats);
+        }
+        stats.framesSent++;
+        waitUntilNextFrame(protocol, frameLength);
+    }
+    printf("\n%-10s %8u frames replayed, %u decoded, %.0f cycles/frame\n", protocol->name, stats.framesSent, stats.framesAccepted,
+        (double)(stats.receiveCycles + stats.statusCycles) / stats.framesSent);
+    EXPECT_EQ(stats.framesSent, stats.framesAccepted);
+
+    const char *captureFile = getenv("RX_CAPTURE");
+    if (!captureFile) {
+        return;
+    }
+    const char *protocolName = getenv("RX_CAPTURE_PROTOCOL");
+    protocol = protocolName ? findProtocol(protocolName) : NULL;
+    ASSERT_TRUE(protocol != NULL) << "RX_CAPTURE_PROTOCOL must name one of the protocols";
+    FILE *file = fopen(captureFile, "r");
+    ASSERT_TRUE(file != NULL) << captureFile;
+
+    memset(&stats, 0, sizeof(stats));
+    initProtocol(protocol);
+    const uint64_t startNs = fakeTimeNs;
+    unsigned timeUs, value;
+    while (fscanf(file, "%u %x", &timeUs, &value) == 2) {
+        // feedByte adds the byte time back on
+        fakeTimeNs = startNs + (uint64_t)timeUs * 1000 - protocol->bitsPerByte * 1000000000ULL / protocol->baudRate;
+        feedByte(protocol, value, &stats);
+    }
+    fclose(file);
+    printf("%-10s %8u bytes replayed from %s, %u frames decoded, %u dropped\n", protocol->name, stats.byteCount, captureFile,
+        stats.framesAccepted, stats.framesDropped);
+}
+
+// STUBS
+
+extern "C" {
+
+uint32_t micros(void)
+{
+    return fakeTimeNs / 1000;
+}
+
+uint32_t millis(void)
+{
+    return fakeTimeNs / 1000000;
+}
+
+static serialPort_t serialTestInstance;
+static serialPortConfig_t serialTestConfig;
+
+const serialPortConfig_t *serialRxFindPortConfig(void)
+{
+    return &serialTestConfig;
+}
+
+serialPort_t *openSerialPort(serialPortIdentifier_e, serialPortFunction_e, serialReceiveCallbackPtr callback, uint32_t, portMode_t, portOptions_t)
+{
+    rxCallback = callback;
+    return &serialTestInstance;
+}
+
+void rxSignalFrameComplete(void)
+{
+    frameSignalled = true;
+}
+
+void serialWrite(serialPort_t *, uint8_t) {}
+void serialWriteBuf(serialPort_t *, const uint8_t *, int) {}
+void serialSetBaudRate(serialPort_t *, uint32_t) {}
+void serialSetMode(serialPort_t *, portMode_t) {}
+bool isSerialTransmitBufferEmpty(const serialPort_t *) { return true; }
+uint32_t serialRxBytesWaiting(const serialPort_t *) { return 0; }
+uint32_t serialTxBytesFree(const serialPort_t *) { return 0; }
+
+uint32_t uartTotalRxBytesWaiting(const serialPort_t *) { return 0; }
+bool isSerialPortShared(const serialPortConfig_t *, uint16_t, serialPortFunction_e) { return false; }
+
+bool feature(uint32_t) { return false; }
+
+uint16_t getBatteryVoltage(void) { return 0; }
+int32_t getAmperage(void) { return 0; }
+int32_t getMAhDrawn(void) { return 0; }
+int32_t getEstimatedAltitude(void) { return 0; }
+
+bool telemetryCheckRxPortShared(const serialPortConfig_t *) { return false; }
+serialPort_t *telemetrySharedPort = NULL;
+void initSharedIbusTelemetry(serialPort_t *) {}
+uint8_t respondToIbusRequest(uint8_t const * const) { return 0; }
+
+bool isChecksumOkIa6b(const uint8_t *ibusPacket, const uint8_t length)
+{
+    uint16_t checksum = 0xffff;
+    for (int ii = 0; ii < length - 2; ++ii) {
+        checksum -= ibusPacket[ii];
+    }
+    return checksum == (ibusPacket[length - 2] | (ibusPacket[length - 1] << 8));
+}
+
+void dispatchAdd(dispatchEntry_t *, int) {}
+void dispatchEnable(void) {}
+
+}
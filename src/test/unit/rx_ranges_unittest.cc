@@ -23,21 +23,21 @@
 extern "C" {
     #include "platform.h"
 
+    #include "build/debug.h"
     #include "drivers/io.h"
     #include "common/maths.h"
     #include "config/parameter_group_ids.h"
     #include "fc/rc_controls.h"
     #include "fc/rc_modes.h"
+    #include "io/serial.h"
     #include "rx/rx.h"
 }
 
 #include "unittest_macros.h"
 #include "gtest/gtest.h"
 
-#define DE_ACTIVATE_ALL_BOXES   0
-
 extern "C" {
-uint32_t rcModeActivationMask;
+boxBitmask_t rcModeActivationMask;
 
 extern uint16_t applyRxChannelRangeConfiguraton(int sample, const rxChannelRangeConfig_t *range);
 }
@@ -46,7 +46,7 @@ extern uint16_t applyRxChannelRangeConfiguraton(int sample, const rxChannelRange
 
 TEST(RxChannelRangeTest, TestRxChannelRanges)
 {
-    rcModeActivationMask = DE_ACTIVATE_ALL_BOXES;   // BOXFAILSAFE must be OFF
+    memset(&rcModeActivationMask, 0, sizeof(rcModeActivationMask)); // BOXFAILSAFE must be OFF
 
     // No signal, special condition
     EXPECT_EQ(0, applyRxChannelRangeConfiguraton(0, RANGE_CONFIGURATION(1000, 2000)));
@@ -100,12 +100,19 @@ TEST(RxChannelRangeTest, TestRxChannelRanges)
 // stubs
 extern "C" {
 
+uint32_t debugModeMask;
+uint8_t debugModeOffset[DEBUG_COUNT];
+int32_t debug[DEBUG_VALUE_COUNT];
+
 void failsafeOnRxSuspend(uint32_t ) {}
 void failsafeOnRxResume(void) {}
 
 uint32_t micros(void) { return 0; }
 uint32_t millis(void) { return 0; }
 
+void sysTickDeadlineInit(void (*)(void)) {}
+void sysTickDeadlineArm(uint32_t) {}
+
 void rxPwmInit(rxRuntimeConfig_t *rxRuntimeConfig, rcReadRawDataFnPtr *callback)
 {
     UNUSED(rxRuntimeConfig);
@@ -218,5 +225,15 @@ void failsafeOnValidDataFailed(void)
 {
 }
 
+serialPortConfig_t *findSerialPortConfig(serialPortFunction_e)
+{
+    return NULL;
+}
+
+serialPortConfig_t *findNextSerialPortConfig(serialPortFunction_e)
+{
+    return NULL;
+}
+
 }
 
@@ -23,7 +23,9 @@
 extern "C" {
     #include "platform.h"
 
+    #include "build/debug.h"
     #include "drivers/io.h"
+    #include "io/serial.h"
     #include "rx/rx.h"
     #include "fc/rc_modes.h"
     #include "common/maths.h"
@@ -170,6 +172,10 @@ TEST(RxTest, TestInvalidFlightChannels)
 // STUBS
 
 extern "C" {
+    uint32_t debugModeMask;
+    uint8_t debugModeOffset[DEBUG_COUNT];
+    int32_t debug[DEBUG_VALUE_COUNT];
+
     void failsafeOnValidDataFailed() {}
     void failsafeOnValidDataReceived() {}
 
@@ -179,6 +185,9 @@ extern "C" {
     uint32_t micros(void) { return 0; }
     uint32_t millis(void) { return 0; }
 
+    void sysTickDeadlineInit(void (*)(void)) {}
+    void sysTickDeadlineArm(uint32_t) {}
+
     bool isPPMDataBeingReceived(void) {
         return testData.isPPMDataBeingReceived;
     }
@@ -200,4 +209,7 @@ extern "C" {
     void xBusInit(const rxConfig_t *, rxRuntimeConfig_t *) {}
     void rxMspInit(const rxConfig_t *, rxRuntimeConfig_t *) {}
     void rxPwmInit(const rxConfig_t *, rxRuntimeConfig_t *) {}
+
+    serialPortConfig_t *findSerialPortConfig(serialPortFunction_e) { return NULL; }
+    serialPortConfig_t *findNextSerialPortConfig(serialPortFunction_e) { return NULL; }
 }
@@ -0,0 +1,162 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Runs the scheduler tests against the deadline-ordered task queue (USE_SCHEDULER_DEADLINE_QUEUE),
+// the scheduler must make exactly the same choices as with the linear queue scan.
+// The task statistics are sampled (USE_TASK_STATISTICS_SAMPLING) with every execution timed, so they come out the same too.
+#include <algorithm>
+
+#include "scheduler_unittest.cc"
+
+extern "C" {
+    extern cfTask_t* taskDeadlineHeap[];
+    extern int taskDeadlineHeapSize;
+
+    uint8_t statisticsSampleGap(uint8_t interval);
+}
+
+static void disableAllTasks(void)
+{
+    for (int taskId = 0; taskId < TASK_COUNT; ++taskId) {
+        setTaskEnabled(static_cast<cfTaskId_e>(taskId), false);
+    }
+}
+
+TEST(SchedulerDeadlineUnittest, TestEventTasksNotInHeap)
+{
+    queueClear();
+    disableAllTasks();
+    setTaskEnabled(TASK_GYROPID, true);
+    setTaskEnabled(TASK_RX, true);
+    setTaskEnabled(TASK_SERIAL, true);
+    EXPECT_EQ(3, taskQueueSize);
+    // TASK_RX is event driven, so only the time-driven tasks are kept in the heap
+    EXPECT_EQ(2, taskDeadlineHeapSize);
+
+    setTaskEnabled(TASK_SERIAL, false);
+    EXPECT_EQ(1, taskDeadlineHeapSize);
+    EXPECT_EQ(&cfTasks[TASK_GYROPID], taskDeadlineHeap[0]);
+
+    setTaskEnabled(TASK_GYROPID, false);
+    EXPECT_EQ(0, taskDeadlineHeapSize);
+}
+
+TEST(SchedulerDeadlineUnittest, TestHeapOrderedByDeadline)
+{
+    queueClear();
+    disableAllTasks();
+    simulatedTime = 100000;
+
+    cfTasks[TASK_ACCEL].lastExecutedAt = simulatedTime - 2000;              // due at +8000
+    cfTasks[TASK_SERIAL].lastExecutedAt = simulatedTime - 9000;             // due at +1000
+    cfTasks[TASK_BATTERY_VOLTAGE].lastExecutedAt = simulatedTime - 15000;   // due at +5000
+    cfTasks[TASK_GYROPID].lastExecutedAt = simulatedTime;                   // due at +1000, added last
+    setTaskEnabled(TASK_ACCEL, true);
+    setTaskEnabled(TASK_SERIAL, true);
+    setTaskEnabled(TASK_BATTERY_VOLTAGE, true);
+    EXPECT_EQ(&cfTasks[TASK_SERIAL], taskDeadlineHeap[0]);
+
+    setTaskEnabled(TASK_GYROPID, true);
+    EXPECT_EQ(4, taskDeadlineHeapSize);
+
+    // nothing is due yet
+    scheduler();
+    EXPECT_EQ(static_cast<cfTask_t*>(0), unittest_scheduler_selectedTask);
+    EXPECT_EQ(0, unittest_scheduler_waitingTasks);
+
+    // TASK_SERIAL and TASK_GYROPID are due, the realtime task wins
+    simulatedTime += 1000;
+    scheduler();
+    EXPECT_EQ(&cfTasks[TASK_GYROPID], unittest_scheduler_selectedTask);
+    EXPECT_EQ(2, unittest_scheduler_waitingTasks);
+    EXPECT_EQ(&cfTasks[TASK_SERIAL], taskDeadlineHeap[0]);
+
+    // TASK_SERIAL is still due and now runs
+    scheduler();
+    EXPECT_EQ(&cfTasks[TASK_SERIAL], unittest_scheduler_selectedTask);
+    EXPECT_EQ(1, unittest_scheduler_waitingTasks);
+    EXPECT_EQ(&cfTasks[TASK_GYROPID], taskDeadlineHeap[0]);
+}
+
+TEST(SchedulerDeadlineUnittest, TestRescheduleUpdatesHeap)
+{
+    queueClear();
+    disableAllTasks();
+    simulatedTime = 200000;
+
+    cfTasks[TASK_ACCEL].lastExecutedAt = simulatedTime;
+    cfTasks[TASK_SERIAL].lastExecutedAt = simulatedTime;
+    setTaskEnabled(TASK_ACCEL, true);
+    setTaskEnabled(TASK_SERIAL, true);
+    // TASK_ACCEL period is 10000us
+    rescheduleTask(TASK_SERIAL, 20000);
+    EXPECT_EQ(&cfTasks[TASK_ACCEL], taskDeadlineHeap[0]);
+    rescheduleTask(TASK_SERIAL, 6000);
+    EXPECT_EQ(&cfTasks[TASK_SERIAL], taskDeadlineHeap[0]);
+
+    // after running TASK_SERIAL is next due at +12000, after TASK_ACCEL
+    simulatedTime += 6000;
+    scheduler();
+    EXPECT_EQ(&cfTasks[TASK_SERIAL], unittest_scheduler_selectedTask);
+    EXPECT_EQ(&cfTasks[TASK_ACCEL], taskDeadlineHeap[0]);
+
+    rescheduleTask(TASK_SERIAL, TASK_PERIOD_HZ(100));
+}
+
+TEST(SchedulerDeadlineUnittest, TestCheckFuncDeferredWhileRealtimeDue)
+{
+    queueClear();
+    disableAllTasks();
+    simulatedTime = 300000;
+
+    setTaskEnabled(TASK_GYROPID, true);
+    setTaskEnabled(TASK_RX, true);
+    cfTasks[TASK_GYROPID].lastExecutedAt = simulatedTime - 1000;
+    cfTasks[TASK_RX].lastExecutedAt = simulatedTime - 1000;
+    cfTasks[TASK_RX].dynamicPriority = 0;
+
+    // TASK_GYROPID is due, so the RX check function should not be called
+    scheduler();
+    EXPECT_EQ(&cfTasks[TASK_GYROPID], unittest_scheduler_selectedTask);
+    EXPECT_EQ(300000 + TEST_PID_LOOP_TIME, simulatedTime);
+
+    // TASK_GYROPID is not due, so the RX check function is called
+    scheduler();
+    EXPECT_EQ(static_cast<cfTask_t*>(0), unittest_scheduler_selectedTask);
+    EXPECT_EQ(300000 + TEST_PID_LOOP_TIME + TEST_UPDATE_RX_CHECK_TIME, simulatedTime);
+}
+
+TEST(SchedulerDeadlineUnittest, TestStatisticsSampleGap)
+{
+    for (int i = 0; i < 100; i++) {
+        EXPECT_EQ(1, statisticsSampleGap(1));
+    }
+
+    // spread around the interval, on average the interval
+    uint32_t sum = 0;
+    uint8_t minGap = UINT8_MAX;
+    uint8_t maxGap = 0;
+    for (int i = 0; i < 9000; i++) {
+        const uint8_t gap = statisticsSampleGap(8);
+        sum += gap;
+        minGap = std::min(minGap, gap);
+        maxGap = std::max(maxGap, gap);
+    }
+    EXPECT_EQ(4, minGap);
+    EXPECT_EQ(12, maxGap);
+    EXPECT_NEAR(8.0, sum / 9000.0, 0.1);
+}
@@ -19,6 +19,8 @@
 
 extern "C" {
     #include "platform.h"
+    #include "build/debug.h"
+
     #include "scheduler/scheduler.h"
 }
 
@@ -42,9 +44,15 @@ extern "C" {
     uint8_t unittest_scheduler_selectedTaskDynPrio;
     uint16_t unittest_scheduler_waitingTasks;
 
+    int32_t debug[DEBUG_VALUE_COUNT];
+    uint32_t debugModeMask;
+    uint8_t debugModeOffset[DEBUG_COUNT];
+
     // set up micros() to simulate time
     uint32_t simulatedTime = 0;
     uint32_t micros(void) { return simulatedTime; }
+    uint32_t getCycleCounter(void) { return simulatedTime * 168; }
+    uint32_t getCyclesPerMicrosecond(void) { return 168; }
 
     // set up tasks to take a simulated representative time to execute
     void taskMainPidLoop(timeUs_t) { simulatedTime += TEST_PID_LOOP_TIME; }
@@ -116,13 +124,14 @@ extern "C" {
             .taskFunc = taskUpdateBatteryVoltage,
             .desiredPeriod = TASK_PERIOD_HZ(50),
             .staticPriority = TASK_PRIORITY_MEDIUM,
+            .sheddable = true,
         }
     };
 }
 
 TEST(SchedulerUnittest, TestPriorites)
 {
-    EXPECT_EQ(20, TASK_COUNT);
+    EXPECT_EQ(21, TASK_COUNT);
 
     EXPECT_EQ(TASK_PRIORITY_MEDIUM_HIGH, cfTasks[TASK_SYSTEM].staticPriority);
     EXPECT_EQ(TASK_PRIORITY_REALTIME, cfTasks[TASK_GYROPID].staticPriority);
@@ -391,3 +400,139 @@ TEST(SchedulerUnittest, TestTwoTasks)
     scheduler();
     EXPECT_EQ(&cfTasks[TASK_ACCEL], unittest_scheduler_selectedTask);
 }
+
+#ifdef USE_TASK_STATISTICS_HISTOGRAM
+TEST(SchedulerUnittest, TestTaskHistogram)
+{
+    schedulerInit();
+    for (int taskId = 0; taskId < TASK_COUNT; ++taskId) {
+        setTaskEnabled(static_cast<cfTaskId_e>(taskId), false);
+    }
+    setTaskEnabled(TASK_GYROPID, true);
+    schedulerResetTaskStatistics(TASK_GYROPID);
+    cfTasks[TASK_GYROPID].lastExecutedAt = 1000;
+    simulatedTime = 4000;
+    // TASK_GYROPID runs 2000us late, having missed two whole periods
+    scheduler();
+    EXPECT_EQ(&cfTasks[TASK_GYROPID], unittest_scheduler_selectedTask);
+
+    cfTaskHistogram_t histogram;
+    EXPECT_TRUE(getTaskHistogram(TASK_GYROPID, &histogram));
+    EXPECT_EQ(2, histogram.missedPeriods);
+    EXPECT_EQ(1, histogram.lateness[11]);           // 2000us is in [1024, 2048)
+    EXPECT_EQ(1, histogram.executionTime[10]);      // TEST_PID_LOOP_TIME is in [512, 1024)
+
+    // next run is on time
+    simulatedTime = 5000;
+    scheduler();
+    EXPECT_TRUE(getTaskHistogram(TASK_GYROPID, &histogram));
+    EXPECT_EQ(2, histogram.missedPeriods);
+    EXPECT_EQ(1, histogram.lateness[0]);
+    EXPECT_EQ(2, histogram.executionTime[10]);
+
+    schedulerResetTaskStatistics(TASK_GYROPID);
+    EXPECT_TRUE(getTaskHistogram(TASK_GYROPID, &histogram));
+    EXPECT_EQ(0, histogram.missedPeriods);
+    EXPECT_EQ(0, histogram.lateness[11]);
+    EXPECT_EQ(0, histogram.executionTime[10]);
+
+    EXPECT_FALSE(getTaskHistogram(TASK_NONE, &histogram));
+}
+
+TEST(SchedulerUnittest, TestTaskHistogramPercentile)
+{
+    uint32_t buckets[TASK_HISTOGRAM_BUCKET_COUNT] = { 0 };
+    EXPECT_EQ(0, taskHistogramPercentile(buckets, 9900));
+
+    buckets[4] = 989;
+    buckets[8] = 10;
+    buckets[12] = 1;
+    EXPECT_EQ(15, taskHistogramPercentile(buckets, 5000));
+    EXPECT_EQ(255, taskHistogramPercentile(buckets, 9900));
+    EXPECT_EQ(255, taskHistogramPercentile(buckets, 9990));
+    EXPECT_EQ(4095, taskHistogramPercentile(buckets, 10000));
+
+    buckets[TASK_HISTOGRAM_BUCKET_COUNT - 1] = 1000;
+    EXPECT_EQ(1 << (TASK_HISTOGRAM_BUCKET_COUNT - 2), taskHistogramPercentile(buckets, 9990));
+}
+#endif
+
+TEST(SchedulerUnittest, TestTaskTimeBudget)
+{
+    schedulerInit();
+    for (int taskId = 0; taskId < TASK_COUNT; ++taskId) {
+        setTaskEnabled(static_cast<cfTaskId_e>(taskId), false);
+    }
+    cfTasks[TASK_GYROPID].lastExecutedAt = 100000;
+    cfTasks[TASK_ACCEL].lastExecutedAt = 100000 - 10000 + 200;
+    setTaskEnabled(TASK_GYROPID, true);
+    setTaskEnabled(TASK_ACCEL, true);
+
+    // TASK_ACCEL is due, TASK_GYROPID is not due until 101000
+    simulatedTime = 100200;
+    scheduler();
+    EXPECT_EQ(&cfTasks[TASK_ACCEL], unittest_scheduler_selectedTask);
+    // TASK_ACCEL consumed TEST_UPDATE_ACCEL_TIME of the 800us that were left
+    EXPECT_EQ(800 - TEST_UPDATE_ACCEL_TIME, schedulerGetTaskTimeBudgetUs());
+
+    // the PID loop itself is given its own period
+    simulatedTime = 101000;
+    scheduler();
+    EXPECT_EQ(&cfTasks[TASK_GYROPID], unittest_scheduler_selectedTask);
+    EXPECT_EQ(cfTasks[TASK_GYROPID].desiredPeriod - TEST_PID_LOOP_TIME, schedulerGetTaskTimeBudgetUs());
+
+    // without the PID loop a task is bounded by its own period
+    setTaskEnabled(TASK_GYROPID, false);
+    simulatedTime = cfTasks[TASK_ACCEL].lastExecutedAt + cfTasks[TASK_ACCEL].desiredPeriod;
+    scheduler();
+    EXPECT_EQ(&cfTasks[TASK_ACCEL], unittest_scheduler_selectedTask);
+    EXPECT_EQ(cfTasks[TASK_ACCEL].desiredPeriod - TEST_UPDATE_ACCEL_TIME, schedulerGetTaskTimeBudgetUs());
+}
+
+#ifdef USE_SCHEDULER_LOAD_SHEDDING
+TEST(SchedulerUnittest, TestLoadShedding)
+{
+    schedulerInit();
+    for (int taskId = 0; taskId < TASK_COUNT; ++taskId) {
+        setTaskEnabled(static_cast<cfTaskId_e>(taskId), false);
+    }
+    const timeDelta_t batteryPeriod = cfTasks[TASK_BATTERY_VOLTAGE].desiredPeriod;
+    const timeDelta_t accelPeriod = cfTasks[TASK_ACCEL].desiredPeriod;
+    setTaskEnabled(TASK_GYROPID, true);
+    simulatedTime = 100000;
+    cfTasks[TASK_GYROPID].lastExecutedAt = simulatedTime;
+    taskSystem(simulatedTime);
+    EXPECT_EQ(0, schedulerGetLoadSheddingLevel());
+
+    // the PID loop misses periods, so sheddable tasks are slowed down one step per taskSystem() invocation
+    for (int i = 0; i < 10; i++) {
+        simulatedTime = cfTasks[TASK_GYROPID].lastExecutedAt + 3 * cfTasks[TASK_GYROPID].desiredPeriod;
+        scheduler();
+        EXPECT_EQ(&cfTasks[TASK_GYROPID], unittest_scheduler_selectedTask);
+        scheduler();
+    }
+    taskSystem(simulatedTime);
+    EXPECT_EQ(1, schedulerGetLoadSheddingLevel());
+    EXPECT_EQ(2 * batteryPeriod, cfTasks[TASK_BATTERY_VOLTAGE].desiredPeriod);
+    EXPECT_EQ(accelPeriod, cfTasks[TASK_ACCEL].desiredPeriod);
+
+    // a task rescheduled while shed stays shed
+    rescheduleTask(TASK_BATTERY_VOLTAGE, batteryPeriod);
+    EXPECT_EQ(2 * batteryPeriod, cfTasks[TASK_BATTERY_VOLTAGE].desiredPeriod);
+
+    // once the PID loop runs on time again the rate is restored, but only after a while
+    for (int i = 0; i < 9; i++) {
+        simulatedTime = cfTasks[TASK_GYROPID].lastExecutedAt + cfTasks[TASK_GYROPID].desiredPeriod;
+        scheduler();
+        EXPECT_EQ(&cfTasks[TASK_GYROPID], unittest_scheduler_selectedTask);
+        for (int j = 0; j < 4; j++) {
+            scheduler(); // idle passes, keeping the system load low
+        }
+        taskSystem(simulatedTime);
+        EXPECT_EQ(1, schedulerGetLoadSheddingLevel());
+    }
+    taskSystem(simulatedTime);
+    EXPECT_EQ(0, schedulerGetLoadSheddingLevel());
+    EXPECT_EQ(batteryPeriod, cfTasks[TASK_BATTERY_VOLTAGE].desiredPeriod);
+}
+#endif
@@ -0,0 +1,112 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "common/axis.h"
+
+    #include "sensors/compass_calibration.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+static const float testOffset[XYZ_AXIS_COUNT] = { 50, -30, 80 };
+static const float testRadius[XYZ_AXIS_COUNT] = { 440, 380, 400 };
+
+static magCalibration_t cal;
+
+// point i of n spread evenly over the distorted field ellipsoid
+static void ellipsoidSample(int i, int n, int32_t sample[XYZ_AXIS_COUNT])
+{
+    const float z = 1.0f - (2.0f * i + 1.0f) / n;
+    const float r = sqrtf(1.0f - z * z);
+    const float phi = i * 2.39996323f; // golden angle
+    const float unit[XYZ_AXIS_COUNT] = { r * cosf(phi), r * sinf(phi), z };
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        sample[axis] = lrintf(testOffset[axis] + testRadius[axis] * unit[axis]);
+    }
+}
+
+TEST(SensorCompassCalibrationUnittest, TestFitRecoversHardAndSoftIron)
+{
+    magCalibrationReset(&cal);
+
+    int32_t sample[XYZ_AXIS_COUNT];
+    for (int i = 0; i < MAG_CAL_SAMPLE_COUNT; i++) {
+        ellipsoidSample(i, MAG_CAL_SAMPLE_COUNT, sample);
+        magCalibrationUpdate(&cal, sample);
+    }
+    EXPECT_EQ(MAG_CAL_SOLVE, cal.state);
+
+    // one column of the solution per update, then the fit is applied
+    for (int i = 0; i < MAG_CAL_PARAM_COUNT + 1; i++) {
+        EXPECT_EQ(0, cal.fitCount);
+        magCalibrationUpdate(&cal, sample);
+    }
+    EXPECT_EQ(1, cal.fitCount);
+    EXPECT_EQ(MAG_CAL_COLLECT, cal.state);
+
+    const float meanRadius = (testRadius[X] + testRadius[Y] + testRadius[Z]) / 3;
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        EXPECT_NEAR(testOffset[axis], cal.offset[axis], 1.0f);
+        EXPECT_NEAR(meanRadius / testRadius[axis], cal.scale[axis], 0.01f);
+    }
+
+    // corrected samples lie on a sphere
+    for (int i = 0; i < 20; i++) {
+        ellipsoidSample(i * 7, 140, sample);
+        magCalibrationApply(&cal, sample);
+        const float length = sqrtf((float)sample[X] * sample[X] + (float)sample[Y] * sample[Y] + (float)sample[Z] * sample[Z]);
+        EXPECT_NEAR(meanRadius, length, 4.0f);
+    }
+}
+
+TEST(SensorCompassCalibrationUnittest, TestYawOnlyIsNotFitted)
+{
+    magCalibrationReset(&cal);
+
+    // level flight only turns the field around z, which leaves C unobservable
+    for (int i = 0; i < 4 * MAG_CAL_SAMPLE_COUNT; i++) {
+        const float phi = i * 0.7f;
+        const int32_t sample[XYZ_AXIS_COUNT] = { (int32_t)lrintf(300 * cosf(phi)), (int32_t)lrintf(300 * sinf(phi)), 200 };
+        magCalibrationUpdate(&cal, sample);
+    }
+    EXPECT_EQ(0, cal.fitCount);
+
+    int32_t sample[XYZ_AXIS_COUNT] = { 100, -200, 300 };
+    magCalibrationApply(&cal, sample);
+    EXPECT_EQ(100, sample[X]);
+    EXPECT_EQ(-200, sample[Y]);
+    EXPECT_EQ(300, sample[Z]);
+}
+
+TEST(SensorCompassCalibrationUnittest, TestCloseSamplesAreSkipped)
+{
+    magCalibrationReset(&cal);
+
+    const int32_t sample[XYZ_AXIS_COUNT] = { 300, 0, 200 };
+    for (int i = 0; i < 10; i++) {
+        magCalibrationUpdate(&cal, sample);
+    }
+    EXPECT_EQ(1, cal.sampleCount);
+}
@@ -0,0 +1,165 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "common/axis.h"
+
+    #include "sensors/gyro_bias.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+#define TEST_WINDOW_SAMPLES 100
+#define TEST_THRESHOLD 48
+
+static gyroBiasEstimator_t estimator;
+
+// a square wave of the given amplitude around offset, so the mean is offset and the deviation amplitude
+static void pushWindow(const int16_t offset[XYZ_AXIS_COUNT], int16_t amplitude)
+{
+    for (int i = 0; i < TEST_WINDOW_SAMPLES; i++) {
+        const int16_t sign = (i & 1) ? 1 : -1;
+        const int16_t sample[XYZ_AXIS_COUNT] = {
+            (int16_t)(offset[X] + sign * amplitude),
+            (int16_t)(offset[Y] - sign * amplitude),
+            (int16_t)(offset[Z] + sign * amplitude),
+        };
+        gyroBiasEstimatorPush(&estimator, sample);
+    }
+}
+
+TEST(SensorGyroBiasUnittest, TestStationaryWindowGivesMean)
+{
+    gyroBiasEstimatorInit(&estimator, TEST_WINDOW_SAMPLES, TEST_THRESHOLD);
+
+    float mean[XYZ_AXIS_COUNT];
+    EXPECT_FALSE(gyroBiasEstimatorRead(&estimator, mean));
+
+    const int16_t offset[XYZ_AXIS_COUNT] = { 12, -7, 300 };
+    pushWindow(offset, 10);
+
+    EXPECT_TRUE(gyroBiasEstimatorRead(&estimator, mean));
+    EXPECT_FLOAT_EQ(12, mean[X]);
+    EXPECT_FLOAT_EQ(-7, mean[Y]);
+    EXPECT_FLOAT_EQ(300, mean[Z]);
+
+    // each window is read once
+    EXPECT_FALSE(gyroBiasEstimatorRead(&estimator, mean));
+}
+
+TEST(SensorGyroBiasUnittest, TestMovingWindowIsDropped)
+{
+    gyroBiasEstimatorInit(&estimator, TEST_WINDOW_SAMPLES, TEST_THRESHOLD);
+
+    const int16_t offset[XYZ_AXIS_COUNT] = { 0, 0, 0 };
+    pushWindow(offset, TEST_THRESHOLD + 10);
+
+    float mean[XYZ_AXIS_COUNT];
+    EXPECT_FALSE(gyroBiasEstimatorRead(&estimator, mean));
+
+    // the next window starts afresh
+    const int16_t stillOffset[XYZ_AXIS_COUNT] = { 5, 6, 7 };
+    pushWindow(stillOffset, 2);
+    EXPECT_TRUE(gyroBiasEstimatorRead(&estimator, mean));
+    EXPECT_FLOAT_EQ(5, mean[X]);
+}
+
+TEST(SensorGyroBiasUnittest, TestUnreadWindowIsKept)
+{
+    gyroBiasEstimatorInit(&estimator, TEST_WINDOW_SAMPLES, TEST_THRESHOLD);
+
+    const int16_t first[XYZ_AXIS_COUNT] = { 1, 2, 3 };
+    const int16_t second[XYZ_AXIS_COUNT] = { 4, 5, 6 };
+    pushWindow(first, 0);
+    pushWindow(second, 0);
+
+    // a window is only published once the previous one has been read
+    float mean[XYZ_AXIS_COUNT];
+    EXPECT_TRUE(gyroBiasEstimatorRead(&estimator, mean));
+    EXPECT_FLOAT_EQ(1, mean[X]);
+    EXPECT_FLOAT_EQ(3, mean[Z]);
+}
+
+TEST(SensorGyroBiasUnittest, TestTableLookupInterpolates)
+{
+    gyroBiasTable_t table;
+    memset(&table, 0, sizeof(table));
+
+    float bias[XYZ_AXIS_COUNT];
+    EXPECT_FALSE(gyroBiasTableLookup(&table, 30, bias));
+
+    // bin 2 covers 20-24C, centered on 22.5C, bin 4 covers 30-34C, centered on 32.5C
+    const float cool[XYZ_AXIS_COUNT] = { 10, -10, 0 };
+    const float warm[XYZ_AXIS_COUNT] = { 30, -20, 100 };
+    gyroBiasTableUpdate(&table, 22, cool);
+    gyroBiasTableUpdate(&table, 33, warm);
+    EXPECT_EQ(1, table.weight[2]);
+    EXPECT_EQ(1, table.weight[4]);
+    EXPECT_EQ(10 * GYRO_BIAS_TABLE_SCALE, table.bias[2][X]);
+
+    EXPECT_TRUE(gyroBiasTableLookup(&table, 27, bias));
+    EXPECT_FLOAT_EQ(19, bias[X]);
+    EXPECT_FLOAT_EQ(-14.5f, bias[Y]);
+    EXPECT_FLOAT_EQ(45, bias[Z]);
+
+    // beyond the populated bins, the nearest is used within a bin width of its center
+    EXPECT_TRUE(gyroBiasTableLookup(&table, 36, bias));
+    EXPECT_FLOAT_EQ(30, bias[X]);
+    EXPECT_TRUE(gyroBiasTableLookup(&table, 18, bias));
+    EXPECT_FLOAT_EQ(10, bias[X]);
+    EXPECT_FALSE(gyroBiasTableLookup(&table, 40, bias));
+    EXPECT_FALSE(gyroBiasTableLookup(&table, 15, bias));
+}
+
+TEST(SensorGyroBiasUnittest, TestTableUpdateAverages)
+{
+    gyroBiasTable_t table;
+    memset(&table, 0, sizeof(table));
+
+    const float a[XYZ_AXIS_COUNT] = { 10, 0, 0 };
+    const float b[XYZ_AXIS_COUNT] = { 20, 0, 0 };
+    gyroBiasTableUpdate(&table, 25, a);
+    gyroBiasTableUpdate(&table, 26, b);
+    EXPECT_EQ(2, table.weight[3]);
+    EXPECT_EQ(15 * GYRO_BIAS_TABLE_SCALE, table.bias[3][X]);
+
+    // out of range temperatures are ignored
+    gyroBiasTableUpdate(&table, GYRO_BIAS_TEMP_MIN - 1, a);
+    gyroBiasTableUpdate(&table, GYRO_BIAS_TEMP_MIN + GYRO_BIAS_TEMP_BIN_COUNT * GYRO_BIAS_TEMP_BIN_WIDTH, a);
+    for (int bin = 0; bin < GYRO_BIAS_TEMP_BIN_COUNT; bin++) {
+        EXPECT_EQ(bin == 3 ? 2 : 0, table.weight[bin]);
+    }
+
+    // an established bin moves slowly, but all the way, and its weight saturates
+    gyroBiasTableUpdate(&table, 25, b);
+    EXPECT_EQ(3, table.weight[3]);
+    EXPECT_NEAR(16.7f * GYRO_BIAS_TABLE_SCALE, table.bias[3][X], 1);
+    for (int i = 0; i < 300; i++) {
+        gyroBiasTableUpdate(&table, 25, b);
+    }
+    EXPECT_EQ(UINT8_MAX, table.weight[3]);
+    float bias[XYZ_AXIS_COUNT];
+    EXPECT_TRUE(gyroBiasTableLookup(&table, 25, bias));
+    EXPECT_NEAR(20, bias[X], 0.5f);
+}
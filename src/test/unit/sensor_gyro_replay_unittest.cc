@@ -0,0 +1,449 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include <vector>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "build/debug.h"
+    #include "build/trace.h"
+
+    #include "common/axis.h"
+    #include "common/maths.h"
+    #include "common/utils.h"
+
+    #include "config/parameter_group.h"
+
+    #include "drivers/accgyro/accgyro.h"
+    #include "drivers/accgyro/accgyro_fake.h"
+
+    #include "fc/config.h"
+    #include "fc/runtime_config.h"
+
+    #include "flight/imu.h"
+    #include "flight/pid.h"
+    #include "flight/rpm_filter.h"
+
+    #include "io/beeper.h"
+
+    #include "scheduler/scheduler.h"
+
+    #include "sensors/acceleration.h"
+    #include "sensors/esc_sensor.h"
+    #include "sensors/gyro.h"
+    #include "sensors/sensors.h"
+
+    extern gyroDev_t *fakeGyroDev;
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+/*
+ * Runs gyro traces through the real gyro filter chain and PID controller, and reports what each stage
+ * costs on the host, and the gain and delay of the filter chain at a few frequencies.
+ *
+ * A synthetic trace is always run, so the figures can be compared between builds. A trace from a log,
+ * recorded at the gyro rate with debug_mode = GYRO and decoded to CSV by blackbox_decode, is replayed
+ * too if GYRO_REPLAY_CSV names it. GYRO_REPLAY_FIELD picks other columns than debug[0] to debug[2].
+ *
+ * The host cycle counts only compare configurations and builds with each other, the target cost of a
+ * configuration is measured on the board with the loop benchmark.
+ */
+
+#define SYNTHETIC_LOOPTIME_US   125
+#define SYNTHETIC_SAMPLES       8000    // one second, a whole number of periods of every tone below
+
+typedef struct trace_s {
+    uint32_t looptimeUs;
+    std::vector<int16_t> samples[XYZ_AXIS_COUNT];
+} trace_t;
+
+static const float reportFrequencies[] = { 10, 20, 50, 100, 150, 200, 300, 400 };
+#define REPORT_FREQUENCY_COUNT ARRAYLEN(reportFrequencies)
+#define REPORT_LEVEL_MIN 1.0f   // dps
+
+typedef struct replayResult_s {
+    uint64_t stageCycles[TRACE_POINT_COUNT];
+    uint32_t stageCount[TRACE_POINT_COUNT];
+    uint64_t pidCycles;
+    float gainDb[XYZ_AXIS_COUNT][REPORT_FREQUENCY_COUNT];
+    float delayUs[XYZ_AXIS_COUNT][REPORT_FREQUENCY_COUNT];
+    float inputLevel[XYZ_AXIS_COUNT][REPORT_FREQUENCY_COUNT];   // amplitude of the input at the frequency
+    float changeRmsIn[XYZ_AXIS_COUNT];      // of the sample to sample change, which is mostly noise
+    float changeRmsOut[XYZ_AXIS_COUNT];
+    uint32_t sampleCount;
+} replayResult_t;
+
+extern "C" {
+    int32_t debug[DEBUG_VALUE_COUNT];
+    uint32_t debugModeMask;
+    uint8_t debugModeOffset[DEBUG_COUNT];
+
+    static bool escSensorActive = false;
+
+    uint32_t getCycleCounter(void)
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        return (uint32_t)__builtin_ia32_rdtsc();
+#else
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return (uint32_t)(now.tv_sec * 1000000000ULL + now.tv_nsec);
+#endif
+    }
+}
+
+static void drainTrace(replayResult_t *result)
+{
+    static uint32_t beginCycles[TRACE_POINT_COUNT];
+    traceEvent_t events[TRACE_BUFFER_SIZE];
+    uint32_t lostCount;
+    int count;
+    while ((count = traceRead(events, TRACE_BUFFER_SIZE, &lostCount)) > 0) {
+        for (int i = 0; i < count; i++) {
+            const uint8_t point = events[i].point & ~TRACE_EVENT_END;
+            if (events[i].point & TRACE_EVENT_END) {
+                result->stageCycles[point] += events[i].cycles - beginCycles[point];
+                result->stageCount[point]++;
+            } else {
+                beginCycles[point] = events[i].cycles;
+            }
+        }
+    }
+}
+
+// the single bin DFT of samples at frequency, which must have a whole number of periods in the samples
+static void binDft(const std::vector<float> &samples, float frequency, uint32_t looptimeUs, float *re, float *im)
+{
+    const double omega = 2 * M_PI * frequency * looptimeUs * 1e-6;
+    double sumRe = 0;
+    double sumIm = 0;
+    for (size_t i = 0; i < samples.size(); i++) {
+        sumRe += samples[i] * cos(omega * i);
+        sumIm -= samples[i] * sin(omega * i);
+    }
+    *re = sumRe;
+    *im = sumIm;
+}
+
+static float changeRms(const std::vector<float> &samples)
+{
+    double sum = 0;
+    for (size_t i = 1; i < samples.size(); i++) {
+        const float change = samples[i] - samples[i - 1];
+        sum += change * change;
+    }
+    return samples.size() < 2 ? 0 : sqrt(sum / (samples.size() - 1));
+}
+
+static void replay(const trace_t *trace, replayResult_t *result)
+{
+    memset(result, 0, sizeof(*result));
+
+    // the filters are set up for the sample rate of the trace
+    gyroConfigMutable()->gyro_sync_denom = MAX(1, lrintf(trace->looptimeUs / 125.0f));
+    gyroInit();
+    pidSetTargetLooptime(gyro.targetLooptime);
+    pidInit(currentPidProfile);
+
+    const size_t count = trace->samples[X].size();
+    std::vector<float> input[XYZ_AXIS_COUNT];
+    std::vector<float> output[XYZ_AXIS_COUNT];
+
+    const rollAndPitchTrims_t trims = { .raw = { 0, 0 } };
+    debugModeMask = 1U << DEBUG_CYCLE_TRACE;
+    for (size_t i = 0; i < count; i++) {
+        fakeGyroSet(fakeGyroDev, trace->samples[X][i], trace->samples[Y][i], trace->samples[Z][i]);
+        gyroUpdate();
+
+        const uint32_t pidStartCycles = getCycleCounter();
+        pidController(currentPidProfile, &trims, i * gyro.targetLooptime);
+        result->pidCycles += getCycleCounter() - pidStartCycles;
+
+        drainTrace(result);
+        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            input[axis].push_back(trace->samples[axis][i] * fakeGyroDev->scale);
+            output[axis].push_back(gyro.gyroADCf[axis]);
+        }
+    }
+    debugModeMask = 0;
+    result->sampleCount = count;
+
+    // the transfer of the filter chain at each frequency, from the ratio of the two spectra there
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        result->changeRmsIn[axis] = changeRms(input[axis]);
+        result->changeRmsOut[axis] = changeRms(output[axis]);
+        for (unsigned f = 0; f < REPORT_FREQUENCY_COUNT; f++) {
+            float inRe, inIm, outRe, outIm;
+            binDft(input[axis], reportFrequencies[f], gyro.targetLooptime, &inRe, &inIm);
+            binDft(output[axis], reportFrequencies[f], gyro.targetLooptime, &outRe, &outIm);
+            const float inMagnitude = sqrtf(inRe * inRe + inIm * inIm);
+            const float outMagnitude = sqrtf(outRe * outRe + outIm * outIm);
+            result->inputLevel[axis][f] = 2 * inMagnitude / count;
+            result->gainDb[axis][f] = 20 * log10f(outMagnitude / inMagnitude);
+            float phase = atan2f(outIm, outRe) - atan2f(inIm, inRe);
+            while (phase > 0) {
+                phase -= 2 * M_PI;
+            }
+            result->delayUs[axis][f] = -phase / (2 * M_PI * reportFrequencies[f]) * 1e6f;
+        }
+    }
+}
+
+static void printResult(const char *name, const replayResult_t *result)
+{
+    // in the order of tracePoint_e
+    static const char *stageNames[TRACE_POINT_COUNT] = {
+        "scheduler",
+        "gyro read",
+        "gyro analyse",
+        "dynamic notch",
+        "static notches",
+        "lpf",
+        "pid",
+        "mixer",
+        "motor write",
+        "rpm notches",
+    };
+
+    printf("%s: %u samples at %uus\n", name, result->sampleCount, gyro.targetLooptime);
+    printf("  %-24s %12s\n", "stage", "host cycles");
+    for (int point = 0; point < TRACE_POINT_COUNT; point++) {
+        if (result->stageCount[point]) {
+            printf("  %-24s %12.1f\n", stageNames[point], (double)result->stageCycles[point] / result->stageCount[point]);
+        }
+    }
+    printf("  %-24s %12.1f\n", "pidController", (double)result->pidCycles / result->sampleCount);
+
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        printf("  axis %d: noise attenuation %.1fdB\n", axis, 20 * log10f(result->changeRmsIn[axis] / result->changeRmsOut[axis]));
+        printf("  %8s %10s %8s %10s\n", "Hz", "level dps", "gain dB", "delay us");
+        for (unsigned f = 0; f < REPORT_FREQUENCY_COUNT; f++) {
+            // the gain and delay are meaningless where the input has next to nothing, and the delay is only known modulo the period
+            if (result->inputLevel[axis][f] < REPORT_LEVEL_MIN) {
+                continue;
+            }
+            printf("  %8.0f %10.2f %8.1f %10.0f\n", reportFrequencies[f], result->inputLevel[axis][f], result->gainDb[axis][f], result->delayUs[axis][f]);
+        }
+    }
+}
+
+// a slow stick movement, with motor noise at 150Hz and 400Hz and some broadband noise
+static void syntheticTrace(trace_t *trace)
+{
+    trace->looptimeUs = SYNTHETIC_LOOPTIME_US;
+    uint32_t seed = 0x12345678;
+    for (int i = 0; i < SYNTHETIC_SAMPLES; i++) {
+        const float t = i * SYNTHETIC_LOOPTIME_US * 1e-6f;
+        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            seed = seed * 1664525 + 1013904223;
+            const float noise = (int)((seed >> 16) & 0x1f) - 16;
+            const float sample = 300 * sinf(2 * M_PI * 10 * t + axis)
+                + 20 * sinf(2 * M_PI * 150 * t)
+                + 40 * sinf(2 * M_PI * 400 * t + axis)
+                + noise;
+            trace->samples[axis].push_back(lrintf(sample));
+        }
+    }
+}
+
+static int csvColumn(const std::vector<std::string> &header, const std::string &name)
+{
+    for (size_t i = 0; i < header.size(); i++) {
+        if (header[i] == name) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static std::vector<std::string> csvSplit(const char *line)
+{
+    std::vector<std::string> fields;
+    std::string field;
+    for (const char *c = line; *c && *c != '\n' && *c != '\r'; c++) {
+        if (*c == ',') {
+            fields.push_back(field);
+            field.clear();
+        } else if (*c != ' ' || !field.empty()) {
+            field += *c;
+        }
+    }
+    fields.push_back(field);
+    return fields;
+}
+
+static bool csvTrace(const char *path, const char *field, trace_t *trace)
+{
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        return false;
+    }
+
+    static char line[4096];
+    if (!fgets(line, sizeof(line), file)) {
+        fclose(file);
+        return false;
+    }
+    const std::vector<std::string> header = csvSplit(line);
+    const int timeColumn = csvColumn(header, "time (us)");
+    int columns[XYZ_AXIS_COUNT];
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        columns[axis] = csvColumn(header, std::string(field) + "[" + std::to_string(axis) + "]");
+        if (columns[axis] < 0) {
+            fclose(file);
+            return false;
+        }
+    }
+
+    // the sample period is taken from the log, which must have been recorded at the gyro rate
+    long firstTime = -1;
+    long lastTime = -1;
+    while (fgets(line, sizeof(line), file)) {
+        const std::vector<std::string> fields = csvSplit(line);
+        if (fields.size() < header.size()) {
+            continue;
+        }
+        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            trace->samples[axis].push_back(constrain(atoi(fields[columns[axis]].c_str()), INT16_MIN, INT16_MAX));
+        }
+        if (timeColumn >= 0) {
+            lastTime = atol(fields[timeColumn].c_str());
+            if (firstTime < 0) {
+                firstTime = lastTime;
+            }
+        }
+    }
+    fclose(file);
+
+    const size_t count = trace->samples[X].size();
+    trace->looptimeUs = (timeColumn >= 0 && count > 1) ? (lastTime - firstTime) / (count - 1) : SYNTHETIC_LOOPTIME_US;
+    return count > 0;
+}
+
+class GyroReplayTest : public ::testing::Test {
+protected:
+    virtual void SetUp() {
+        pgResetAll();
+        currentPidProfile = pidProfilesMutable(0);
+    }
+};
+
+TEST_F(GyroReplayTest, TestSyntheticTrace)
+{
+    trace_t trace;
+    syntheticTrace(&trace);
+
+    replayResult_t result;
+    replay(&trace, &result);
+    printResult("synthetic", &result);
+
+    // every stage that ran was traced
+    EXPECT_EQ(SYNTHETIC_SAMPLES, result.stageCount[TRACE_GYRO_READ]);
+    EXPECT_EQ(SYNTHETIC_SAMPLES, result.stageCount[TRACE_GYRO_FILTER_NOTCH]);
+    EXPECT_EQ(SYNTHETIC_SAMPLES, result.stageCount[TRACE_GYRO_FILTER_LPF]);
+
+    // with the default filters, the stick movement passes, a little late, and the motor noise does not
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        EXPECT_NEAR(0, result.gainDb[axis][0], 1);
+        EXPECT_LT(0, result.delayUs[axis][0]);
+        EXPECT_GT(5000, result.delayUs[axis][0]);
+        EXPECT_GT(-10, result.gainDb[axis][REPORT_FREQUENCY_COUNT - 1]);
+        EXPECT_GT(result.changeRmsIn[axis], 2 * result.changeRmsOut[axis]);
+    }
+}
+
+TEST_F(GyroReplayTest, TestLogTrace)
+{
+    const char *path = getenv("GYRO_REPLAY_CSV");
+    if (!path) {
+        return;
+    }
+    const char *field = getenv("GYRO_REPLAY_FIELD");
+
+    trace_t trace;
+    ASSERT_TRUE(csvTrace(path, field ? field : "debug", &trace));
+
+    replayResult_t result;
+    replay(&trace, &result);
+    printResult(path, &result);
+}
+
+TEST_F(GyroReplayTest, TestRpmFilterInitAtBoot)
+{
+    escSensorActive = true;
+
+    // the notches are set up by gyroInit(), without waiting for the filter settings to be changed
+    rpmFilterConfigMutable()->rpm_notch_harmonics = 3;
+    gyroInit();
+    EXPECT_TRUE(isRpmFilterEnabled());
+
+    rpmFilterConfigMutable()->rpm_notch_harmonics = 0;
+    gyroInit();
+    EXPECT_FALSE(isRpmFilterEnabled());
+
+    escSensorActive = false;
+}
+
+// STUBS
+
+extern "C" {
+    uint8_t armingFlags;
+    uint16_t flightModeFlags;
+    uint8_t stateFlags;
+    attitudeEulerAngles_t attitude;
+    int16_t GPS_angle[ANGLE_INDEX_COUNT];
+    pidProfile_t *currentPidProfile;
+
+    uint32_t micros(void) { return 0; }
+    uint32_t millis(void) { return 0; }
+    void delay(uint32_t) {}
+    void delayMicroseconds(uint32_t) {}
+
+    void beeper(beeperMode_e) {}
+    void beeperConfirmationBeeps(uint8_t) {}
+    void systemBeep(bool) {}
+    bool isArmingDisabled(void) { return false; }
+    void schedulerResetTaskStatistics(cfTaskId_e) {}
+    bool sensors(uint32_t) { return false; }
+    void sensorsSet(uint32_t) {}
+    uint8_t detectedSensors[SENSOR_INDEX_COUNT];
+
+    float getThrottlePIDAttenuation(void) { return 1.0f; }
+    float getMotorMixRange(void) { return 0.0f; }
+    float getSetpointRate(int) { return 0.0f; }
+    float getSetpointRateDerivative(int) { return 0.0f; }
+    float getRcDeflection(int) { return 0.0f; }
+    float getRcDeflectionAbs(int) { return 0.0f; }
+    void pidInitMixer(const pidProfile_t *) {}
+    bool mixerIsOutputSaturated(int, float) { return false; }
+    bool mpuGyroSetAccBurstRead(gyroDev_t *, accDev_t *) { return false; }
+
+    uint8_t getMotorCount(void) { return 4; }
+    bool isEscSensorActive(void) { return escSensorActive; }
+    escSensorData_t *getEscSensorData(uint8_t) { return NULL; }
+}
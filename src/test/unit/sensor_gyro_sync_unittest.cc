@@ -0,0 +1,112 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "drivers/gyro_sync.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+#define TEST_NOMINAL_INTERVAL_US    125.0f
+#define TEST_UPDATE_PERIOD_US       100000
+
+static gyroSampleClock_t sampleClock;
+static double interruptTimeUs;
+static uint32_t interruptCount;
+static timeUs_t nowUs;
+
+static void resetClock(void)
+{
+    gyroSampleClockInit(&sampleClock, TEST_NOMINAL_INTERVAL_US);
+    interruptTimeUs = 1000;
+    interruptCount = 0;
+    nowUs = 1000;
+}
+
+// runs the gyro for the given time, then lets the estimator see the latest interrupt, returns true once it measured
+static bool runFor(timeUs_t durationUs, float intervalUs)
+{
+    bool measured = false;
+    for (const timeUs_t endUs = nowUs + durationUs; nowUs < endUs; nowUs += TEST_UPDATE_PERIOD_US) {
+        while (interruptTimeUs + intervalUs <= nowUs + TEST_UPDATE_PERIOD_US) {
+            interruptTimeUs += intervalUs;
+            interruptCount++;
+        }
+        measured |= gyroSampleClockUpdate(&sampleClock, (timeUs_t)interruptTimeUs, interruptCount);
+    }
+    return measured;
+}
+
+TEST(SensorGyroSyncUnittest, TestNominalUntilMeasured)
+{
+    resetClock();
+
+    EXPECT_FLOAT_EQ(TEST_NOMINAL_INTERVAL_US, sampleClock.intervalUs);
+    // the first window only gives an interval to compare the next one with
+    EXPECT_FALSE(runFor(GYRO_SAMPLE_CLOCK_WINDOW_US + TEST_UPDATE_PERIOD_US, 127.5f));
+    EXPECT_FLOAT_EQ(TEST_NOMINAL_INTERVAL_US, sampleClock.intervalUs);
+}
+
+TEST(SensorGyroSyncUnittest, TestMeasuresSlowClock)
+{
+    resetClock();
+
+    EXPECT_TRUE(runFor(3 * GYRO_SAMPLE_CLOCK_WINDOW_US, 127.5f));
+    EXPECT_NEAR(127.5f, sampleClock.intervalUs, 0.01f);
+}
+
+TEST(SensorGyroSyncUnittest, TestPolledGyroIsNotMeasured)
+{
+    resetClock();
+
+    for (int i = 0; i < 50; i++) {
+        EXPECT_FALSE(gyroSampleClockUpdate(&sampleClock, 0, 0));
+    }
+    EXPECT_FLOAT_EQ(TEST_NOMINAL_INTERVAL_US, sampleClock.intervalUs);
+}
+
+TEST(SensorGyroSyncUnittest, TestWindowWithLostInterruptsIsRejected)
+{
+    resetClock();
+    runFor(GYRO_SAMPLE_CLOCK_WINDOW_US + TEST_UPDATE_PERIOD_US, 125.5f);
+
+    // a 20ms stall, say a flash write, loses the interrupts in it
+    nowUs += 20000;
+    interruptTimeUs = nowUs;
+    EXPECT_FALSE(runFor(GYRO_SAMPLE_CLOCK_WINDOW_US, 125.5f));
+    EXPECT_FLOAT_EQ(TEST_NOMINAL_INTERVAL_US, sampleClock.intervalUs);
+
+    // the window after it agrees with none before it, the one after that does
+    EXPECT_FALSE(runFor(GYRO_SAMPLE_CLOCK_WINDOW_US, 125.5f));
+    EXPECT_TRUE(runFor(GYRO_SAMPLE_CLOCK_WINDOW_US + TEST_UPDATE_PERIOD_US, 125.5f));
+    EXPECT_NEAR(125.5f, sampleClock.intervalUs, 0.01f);
+}
+
+TEST(SensorGyroSyncUnittest, TestOtherRateIsRejected)
+{
+    resetClock();
+
+    // the gyro running at half the rate is a setup problem, not its clock
+    EXPECT_FALSE(runFor(5 * GYRO_SAMPLE_CLOCK_WINDOW_US, 2 * TEST_NOMINAL_INTERVAL_US));
+    EXPECT_FLOAT_EQ(TEST_NOMINAL_INTERVAL_US, sampleClock.intervalUs);
+}
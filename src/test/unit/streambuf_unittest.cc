@@ -0,0 +1,91 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "common/streambuf.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+TEST(StreamBufferTest, TestLittleEndianRoundTrip)
+{
+    uint8_t buffer[16];
+    sbuf_t sbuf = { .ptr = buffer, .end = buffer + sizeof(buffer) };
+
+    sbufWriteU8(&sbuf, 0x12);
+    sbufWriteU16(&sbuf, 0x3456);
+    sbufWriteU32(&sbuf, 0x789abcde);
+    sbufWriteU16BigEndian(&sbuf, 0xf00d);
+    EXPECT_EQ(9, sbuf.ptr - buffer);
+
+    const uint8_t expected[] = { 0x12, 0x56, 0x34, 0xde, 0xbc, 0x9a, 0x78, 0xf0, 0x0d };
+    EXPECT_EQ(0, memcmp(expected, buffer, sizeof(expected)));
+
+    sbufSwitchToReader(&sbuf, buffer);
+    EXPECT_EQ(9, sbufBytesRemaining(&sbuf));
+    EXPECT_EQ(0x12, sbufReadU8(&sbuf));
+    EXPECT_EQ(0x3456, sbufReadU16(&sbuf));
+    EXPECT_EQ(0x789abcdeU, sbufReadU32(&sbuf));
+    EXPECT_EQ(2, sbufBytesRemaining(&sbuf));
+}
+
+TEST(StreamBufferTest, TestReserve)
+{
+    uint8_t buffer[8];
+    sbuf_t sbuf = { .ptr = buffer, .end = buffer + sizeof(buffer) };
+
+    sbufWriteU8(&sbuf, 1);
+    uint8_t *data = sbufReserve(&sbuf, 4);
+    EXPECT_EQ(buffer + 1, data);
+    EXPECT_EQ(buffer + 5, sbuf.ptr);
+
+    data = sbufPutU16(data, 0x0302);
+    data[0] = 4;
+    data[1] = 5;
+    const uint8_t expected[] = { 1, 2, 3, 4, 5 };
+    EXPECT_EQ(0, memcmp(expected, buffer, sizeof(expected)));
+
+    // no room, nothing is written
+    EXPECT_EQ(NULL, sbufReserve(&sbuf, 4));
+    EXPECT_EQ(buffer + 5, sbuf.ptr);
+
+    // exactly the room left
+    EXPECT_EQ(buffer + 5, sbufReserve(&sbuf, 3));
+    EXPECT_EQ(0, sbufBytesRemaining(&sbuf));
+}
+
+TEST(StreamBufferTest, TestReadView)
+{
+    uint8_t buffer[] = { 1, 0x34, 0x12, 9 };
+    sbuf_t sbuf = { .ptr = buffer, .end = buffer + sizeof(buffer) };
+
+    EXPECT_EQ(1, sbufReadU8(&sbuf));
+    const uint8_t *data = sbufReadView(&sbuf, 2);
+    EXPECT_EQ(buffer + 1, data);
+    EXPECT_EQ(0x1234, sbufGetU16(data));
+
+    // a short payload is refused without consuming it
+    EXPECT_EQ(NULL, sbufReadView(&sbuf, 2));
+    EXPECT_EQ(1, sbufBytesRemaining(&sbuf));
+    EXPECT_EQ(9, sbufReadU8(&sbuf));
+}
@@ -29,6 +29,7 @@ extern "C" {
     #include "common/axis.h"
     #include "common/filter.h"
     #include "common/gps_conversion.h"
+    #include "common/crc.h"
     #include "common/maths.h"
 
     #include "config/parameter_group.h"
@@ -52,6 +53,7 @@ extern "C" {
 
     #include "telemetry/crsf.h"
     #include "telemetry/telemetry.h"
+    #include "telemetry/telemetry_snapshot.h"
 
     bool airMode;
 
@@ -90,6 +92,7 @@ TEST(TelemetryCrsfTest, TestGPS)
 {
     uint8_t frame[CRSF_FRAME_SIZE_MAX];
 
+    telemetrySnapshotUpdate();
     int frameLen = getCrsfFrame(frame, CRSF_FRAME_GPS);
     EXPECT_EQ(CRSF_FRAME_GPS_PAYLOAD_SIZE + FRAME_HEADER_FOOTER_LEN, frameLen);
     EXPECT_EQ(CRSF_ADDRESS_BROADCAST, frame[0]); // address
@@ -116,6 +119,7 @@ TEST(TelemetryCrsfTest, TestGPS)
     gpsSol.groundSpeed = 163;                 // speed in 0.1m/s, 16.3 m/s = 58.68 km/h, so CRSF (km/h *10) value is 587
     gpsSol.numSat = 9;
     gpsSol.groundCourse = 1479;     // degrees * 10
+    telemetrySnapshotUpdate();
     frameLen = getCrsfFrame(frame, CRSF_FRAME_GPS);
     lattitude = frame[3] << 24 | frame[4] << 16 | frame[5] << 8 | frame[6];
     EXPECT_EQ(560000000, lattitude);
@@ -137,6 +141,7 @@ TEST(TelemetryCrsfTest, TestBattery)
     uint8_t frame[CRSF_FRAME_SIZE_MAX];
 
     testBatteryVoltage = 0; // 0.1V units
+    telemetrySnapshotUpdate();
     int frameLen = getCrsfFrame(frame, CRSF_FRAME_BATTERY_SENSOR);
     EXPECT_EQ(CRSF_FRAME_BATTERY_SENSOR_PAYLOAD_SIZE + FRAME_HEADER_FOOTER_LEN, frameLen);
     EXPECT_EQ(CRSF_ADDRESS_BROADCAST, frame[0]); // address
@@ -155,6 +160,7 @@ TEST(TelemetryCrsfTest, TestBattery)
     testBatteryVoltage = 33; // 3.3V = 3300 mv
     testAmperage = 2960; // = 29.60A = 29600mA - amperage is in 0.01A steps
     batteryConfigMutable()->batteryCapacity = 1234;
+    telemetrySnapshotUpdate();
     frameLen = getCrsfFrame(frame, CRSF_FRAME_BATTERY_SENSOR);
     voltage = frame[3] << 8 | frame[4]; // mV * 100
     EXPECT_EQ(33, voltage);
@@ -174,6 +180,7 @@ TEST(TelemetryCrsfTest, TestAttitude)
     attitude.values.pitch = 0;
     attitude.values.roll = 0;
     attitude.values.yaw = 0;
+    telemetrySnapshotUpdate();
     int frameLen = getCrsfFrame(frame, CRSF_FRAME_ATTITUDE);
     EXPECT_EQ(CRSF_FRAME_ATTITUDE_PAYLOAD_SIZE + FRAME_HEADER_FOOTER_LEN, frameLen);
     EXPECT_EQ(CRSF_ADDRESS_BROADCAST, frame[0]); // address
@@ -190,6 +197,7 @@ TEST(TelemetryCrsfTest, TestAttitude)
     attitude.values.pitch = 678; // decidegrees == 1.183333232852155 rad
     attitude.values.roll = 1495; // 2.609267231731523 rad
     attitude.values.yaw = -1799; //3.139847324337799 rad
+    telemetrySnapshotUpdate();
     frameLen = getCrsfFrame(frame, CRSF_FRAME_ATTITUDE);
     pitch = frame[3] << 8 | frame[4]; // rad / 10000
     EXPECT_EQ(11833, pitch);
@@ -206,6 +214,7 @@ TEST(TelemetryCrsfTest, TestFlightMode)
 
     // nothing set, so ACRO mode
     airMode = false;
+    telemetrySnapshotUpdate();
     int frameLen = getCrsfFrame(frame, CRSF_FRAME_FLIGHT_MODE);
     EXPECT_EQ(5 + FRAME_HEADER_FOOTER_LEN, frameLen);
     EXPECT_EQ(CRSF_ADDRESS_BROADCAST, frame[0]); // address
@@ -221,6 +230,7 @@ TEST(TelemetryCrsfTest, TestFlightMode)
 
     enableFlightMode(ANGLE_MODE);
     EXPECT_EQ(ANGLE_MODE, FLIGHT_MODE(ANGLE_MODE));
+    telemetrySnapshotUpdate();
     frameLen = getCrsfFrame(frame, CRSF_FRAME_FLIGHT_MODE);
     EXPECT_EQ(5 + FRAME_HEADER_FOOTER_LEN, frameLen);
     EXPECT_EQ(CRSF_ADDRESS_BROADCAST, frame[0]); // address
@@ -236,6 +246,7 @@ TEST(TelemetryCrsfTest, TestFlightMode)
     disableFlightMode(ANGLE_MODE);
     enableFlightMode(HORIZON_MODE);
     EXPECT_EQ(HORIZON_MODE, FLIGHT_MODE(HORIZON_MODE));
+    telemetrySnapshotUpdate();
     frameLen = getCrsfFrame(frame, CRSF_FRAME_FLIGHT_MODE);
     EXPECT_EQ(4 + FRAME_HEADER_FOOTER_LEN, frameLen);
     EXPECT_EQ(CRSF_ADDRESS_BROADCAST, frame[0]); // address
@@ -249,6 +260,7 @@ TEST(TelemetryCrsfTest, TestFlightMode)
 
     disableFlightMode(HORIZON_MODE);
     airMode = true;
+    telemetrySnapshotUpdate();
     frameLen = getCrsfFrame(frame, CRSF_FRAME_FLIGHT_MODE);
     EXPECT_EQ(4 + FRAME_HEADER_FOOTER_LEN, frameLen);
     EXPECT_EQ(CRSF_ADDRESS_BROADCAST, frame[0]); // address
@@ -265,7 +277,7 @@ TEST(TelemetryCrsfTest, TestFlightMode)
 
 extern "C" {
 
-int16_t debug[DEBUG16_VALUE_COUNT];
+int32_t debug[DEBUG_VALUE_COUNT];
 
 const uint32_t baudRates[] = {0, 9600, 19200, 38400, 57600, 115200, 230400, 250000, 400000}; // see baudRate_e
 
@@ -275,7 +287,9 @@ uint8_t useHottAlarmSoundPeriod (void) { return 0; }
 attitudeEulerAngles_t attitude = { { 0, 0, 0 } };     // absolute angle inclination in multiple of 0.1 degree    180 deg = 1800
 
 uint16_t GPS_distanceToHome;        // distance to home point in meters
+int16_t GPS_directionToHome;
 gpsSolutionData_t gpsSol;
+uint16_t rssi;
 
 void beeperConfirmationBeeps(uint8_t beepCount) {UNUSED(beepCount);}
 
@@ -293,6 +307,7 @@ serialPort_t *openSerialPort(serialPortIdentifier_e, serialPortFunction_e, seria
 void closeSerialPort(serialPort_t *) {}
 
 serialPortConfig_t *findSerialPortConfig(serialPortFunction_e) {return NULL;}
+const serialPortConfig_t *serialRxFindPortConfig(void) {return NULL;}
 
 bool telemetryDetermineEnabledState(portSharing_e) {return true;}
 bool telemetryCheckRxPortShared(const serialPortConfig_t *) {return true;}
@@ -317,4 +332,15 @@ uint8_t calculateBatteryPercentageRemaining(void) {
     return 67;
 }
 
+uint8_t getBatteryCellCount(void) { return 1; }
+int32_t getMAhDrawn(void) { return 0; }
+int32_t getEstimatedAltitude(void) { return 0; }
+int32_t getEstimatedVario(void) { return 0; }
+
+void rxSignalFrameComplete(void) {}
+void serialSetBaudRate(serialPort_t *, uint32_t) {}
+bool isSerialTransmitBufferEmpty(const serialPort_t *) { return true; }
+void crsfParametersInit(void) {}
+bool crsfParametersProcessRequest(void) { return false; }
+
 }
@@ -38,6 +38,7 @@ extern "C" {
 
     #include "fc/runtime_config.h"
 
+    #include "flight/imu.h"
     #include "flight/pid.h"
 
     #include "io/gps.h"
@@ -163,7 +164,7 @@ TEST(TelemetryHottTest, PrepareGPSMessage_Altitude1m)
 
 extern "C" {
 
-int16_t debug[DEBUG16_VALUE_COUNT];
+int32_t debug[DEBUG_VALUE_COUNT];
 
 uint8_t stateFlags;
 
@@ -213,6 +214,26 @@ void serialWrite(serialPort_t *instance, uint8_t ch)
     UNUSED(ch);
 }
 
+void serialWriteBuf(serialPort_t *instance, const uint8_t *data, int count)
+{
+    UNUSED(instance);
+    UNUSED(data);
+    UNUSED(count);
+}
+
+bool serialSetTxByteGap(serialPort_t *instance, uint32_t gapUs)
+{
+    UNUSED(instance);
+    UNUSED(gapUs);
+    return false;
+}
+
+bool isSerialTransmitBufferEmpty(const serialPort_t *instance)
+{
+    UNUSED(instance);
+    return true;
+}
+
 void serialSetMode(serialPort_t *instance, portMode_t mode)
 {
     UNUSED(instance);
@@ -277,4 +298,15 @@ int32_t getMAhDrawn(void) {
     return testMAhDrawn;
 }
 
+uint8_t calculateBatteryPercentageRemaining(void) {
+    return 0;
+}
+
+uint8_t getBatteryCellCount(void) {
+    return 0;
+}
+
+attitudeEulerAngles_t attitude;
+uint16_t rssi;
+
 }
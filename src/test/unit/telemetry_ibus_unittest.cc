@@ -25,6 +25,7 @@ extern "C" {
 #include "io/serial.h"
 #include "fc/rc_controls.h"
 #include "telemetry/telemetry.h"
+#include "telemetry/telemetry_snapshot.h"
 #include "telemetry/ibus.h"
 #include "sensors/gyro.h"
 #include "sensors/battery.h"
@@ -72,6 +73,21 @@ uint8_t getBatteryCellCount(void) {
     return testBatteryCellCount;
 }
 
+uint8_t calculateBatteryPercentageRemaining(void) { return 0; }
+batteryState_e getBatteryState(void) { return BATTERY_OK; }
+int32_t getAmperage(void) { return 0; }
+int32_t getMAhDrawn(void) { return 0; }
+int32_t getEstimatedAltitude(void) { return 0; }
+int32_t getEstimatedVario(void) { return 0; }
+
+extern "C" {
+attitudeEulerAngles_t attitude;
+gpsSolutionData_t gpsSol;
+uint16_t GPS_distanceToHome;
+int16_t GPS_directionToHome;
+uint16_t rssi;
+}
+
 static serialPortStub_t serialWriteStub;
 static serialPortStub_t serialReadStub;
 
@@ -299,6 +315,7 @@ protected:
 
         //when polling ibus
         for (int i = 0; i<10; i++) {
+            telemetrySnapshotUpdate();
             handleIbusTelemetry();
         }
 
@@ -0,0 +1,120 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+extern "C" {
+#include <platform.h>
+#include "common/utils.h"
+
+#include "telemetry/telemetry_scheduler.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+static const telemetrySensor_t testSensors[] = {
+    { 10, 4, 0 },
+    { 20, 2, 0 },
+    { 30, 1, 1 },
+    { 40, 1, 0 },
+    { 50, 0, 0 },   // never sent
+};
+
+static int countsOver(telemetryScheduler_t *scheduler, int slots, int *counts)
+{
+    memset(counts, 0, sizeof(int) * ARRAYLEN(testSensors));
+    int sent = 0;
+    for (int i = 0; i < slots; i++) {
+        const telemetrySensor_t *sensor = telemetrySchedulerNext(scheduler);
+        if (sensor) {
+            counts[sensor - testSensors]++;
+            sent++;
+        }
+    }
+    return sent;
+}
+
+TEST(TelemetrySchedulerUnittest, SlotsAreSharedByWeight)
+{
+    telemetryScheduler_t scheduler;
+    telemetrySchedulerInit(&scheduler, testSensors, ARRAYLEN(testSensors));
+
+    int counts[ARRAYLEN(testSensors)];
+    EXPECT_EQ(80, countsOver(&scheduler, 80, counts));
+    EXPECT_EQ(40, counts[0]);
+    EXPECT_EQ(20, counts[1]);
+    EXPECT_EQ(10, counts[2]);
+    EXPECT_EQ(10, counts[3]);
+    EXPECT_EQ(0, counts[4]);
+}
+
+TEST(TelemetrySchedulerUnittest, SendsAreSpreadEvenly)
+{
+    telemetryScheduler_t scheduler;
+    telemetrySchedulerInit(&scheduler, testSensors, ARRAYLEN(testSensors));
+
+    // every sensor is sent at least once within one round of weightSum slots, wherever the round starts
+    int lastSent[ARRAYLEN(testSensors)] = { 0 };
+    for (int slot = 1; slot <= 80; slot++) {
+        const telemetrySensor_t *sensor = telemetrySchedulerNext(&scheduler);
+        ASSERT_TRUE(sensor != NULL);
+        lastSent[sensor - testSensors] = slot;
+        for (unsigned i = 0; i < 4; i++) {
+            EXPECT_LE(slot - lastSent[i], 8);
+        }
+    }
+}
+
+TEST(TelemetrySchedulerUnittest, PriorityBreaksTies)
+{
+    telemetryScheduler_t scheduler;
+    telemetrySchedulerInit(&scheduler, testSensors, ARRAYLEN(testSensors));
+    telemetrySchedulerEnable(&scheduler, 10, false);
+    telemetrySchedulerEnable(&scheduler, 20, false);
+
+    // 30 and 40 have the same weight, 30 has the higher priority
+    EXPECT_EQ(30, telemetrySchedulerNext(&scheduler)->id);
+    EXPECT_EQ(40, telemetrySchedulerNext(&scheduler)->id);
+    EXPECT_EQ(30, telemetrySchedulerNext(&scheduler)->id);
+}
+
+TEST(TelemetrySchedulerUnittest, DisabledSensorsAreSkipped)
+{
+    telemetryScheduler_t scheduler;
+    telemetrySchedulerInit(&scheduler, testSensors, ARRAYLEN(testSensors));
+    telemetrySchedulerEnable(&scheduler, 10, false);
+
+    int counts[ARRAYLEN(testSensors)];
+    EXPECT_EQ(40, countsOver(&scheduler, 40, counts));
+    EXPECT_EQ(0, counts[0]);
+    EXPECT_EQ(20, counts[1]);
+    EXPECT_EQ(10, counts[2]);
+    EXPECT_EQ(10, counts[3]);
+
+    // a sensor without weight can't be enabled
+    telemetrySchedulerEnable(&scheduler, 50, true);
+    EXPECT_EQ(40, countsOver(&scheduler, 40, counts));
+    EXPECT_EQ(0, counts[4]);
+
+    telemetrySchedulerEnable(&scheduler, 20, false);
+    telemetrySchedulerEnable(&scheduler, 30, false);
+    telemetrySchedulerEnable(&scheduler, 40, false);
+    EXPECT_TRUE(telemetrySchedulerNext(&scheduler) == NULL);
+}
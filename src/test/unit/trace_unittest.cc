@@ -0,0 +1,130 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "build/debug.h"
+    #include "build/trace.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+extern "C" {
+    int32_t debug[DEBUG_VALUE_COUNT];
+    uint32_t debugModeMask;
+    uint8_t debugModeOffset[DEBUG_COUNT];
+
+    uint32_t simulatedCycles = 0;
+    uint32_t getCycleCounter(void) { return simulatedCycles; }
+}
+
+static void drainTrace(void)
+{
+    traceEvent_t events[TRACE_BUFFER_SIZE];
+    uint32_t lostCount;
+    while (traceRead(events, TRACE_BUFFER_SIZE, &lostCount) > 0);
+}
+
+TEST(TraceUnittest, TestDisabledByDebugMode)
+{
+    drainTrace();
+    debugModeMask = 0;
+    TRACE_BEGIN(TRACE_PID);
+    TRACE_END(TRACE_PID);
+
+    traceEvent_t events[4];
+    uint32_t lostCount;
+    EXPECT_EQ(0, traceRead(events, 4, &lostCount));
+    EXPECT_EQ(0, lostCount);
+}
+
+TEST(TraceUnittest, TestRecordAndRead)
+{
+    drainTrace();
+    debugModeMask = 1U << DEBUG_CYCLE_TRACE;
+    memset(debug, 0, sizeof(debug));
+
+    simulatedCycles = 1000;
+    TRACE_BEGIN(TRACE_PID);
+    simulatedCycles = 1500;
+    TRACE_END(TRACE_PID);
+    TRACE_SPAN(TRACE_SCHEDULER, 1200);
+
+    traceEvent_t events[8];
+    uint32_t lostCount;
+    EXPECT_EQ(4, traceRead(events, 8, &lostCount));
+    EXPECT_EQ(0, lostCount);
+    EXPECT_EQ(1000, events[0].cycles);
+    EXPECT_EQ(TRACE_PID | TRACE_EVENT_BEGIN, events[0].point);
+    EXPECT_EQ(1500, events[1].cycles);
+    EXPECT_EQ(TRACE_PID | TRACE_EVENT_END, events[1].point);
+    EXPECT_EQ(1200, events[2].cycles);
+    EXPECT_EQ(TRACE_SCHEDULER | TRACE_EVENT_BEGIN, events[2].point);
+    EXPECT_EQ(1500, events[3].cycles);
+    EXPECT_EQ(TRACE_SCHEDULER | TRACE_EVENT_END, events[3].point);
+
+    // PID duration is logged to debug[1] for blackbox
+    EXPECT_EQ(500, debug[1]);
+
+    // nothing left to read
+    EXPECT_EQ(0, traceRead(events, 8, &lostCount));
+}
+
+TEST(TraceUnittest, TestReadInChunks)
+{
+    drainTrace();
+    debugModeMask = 1U << DEBUG_CYCLE_TRACE;
+
+    for (int i = 0; i < 10; i++) {
+        simulatedCycles = i;
+        TRACE_BEGIN(TRACE_MIXER);
+    }
+
+    traceEvent_t events[4];
+    uint32_t lostCount;
+    EXPECT_EQ(4, traceRead(events, 4, &lostCount));
+    EXPECT_EQ(0, events[0].cycles);
+    EXPECT_EQ(4, traceRead(events, 4, &lostCount));
+    EXPECT_EQ(4, events[0].cycles);
+    EXPECT_EQ(2, traceRead(events, 4, &lostCount));
+    EXPECT_EQ(9, events[1].cycles);
+}
+
+TEST(TraceUnittest, TestOverwriteReportsLostEvents)
+{
+    drainTrace();
+    debugModeMask = 1U << DEBUG_CYCLE_TRACE;
+
+    const int recorded = TRACE_BUFFER_SIZE + 10;
+    for (int i = 0; i < recorded; i++) {
+        simulatedCycles = i;
+        TRACE_BEGIN(TRACE_GYRO_READ);
+    }
+
+    traceEvent_t events[TRACE_BUFFER_SIZE];
+    uint32_t lostCount;
+    EXPECT_EQ(TRACE_BUFFER_SIZE, traceRead(events, TRACE_BUFFER_SIZE, &lostCount));
+    EXPECT_EQ(10, lostCount);
+    // the oldest events were overwritten, the most recent ones are kept
+    EXPECT_EQ(10, events[0].cycles);
+    EXPECT_EQ(recorded - 1, events[TRACE_BUFFER_SIZE - 1].cycles);
+}
@@ -32,7 +32,6 @@ extern "C" {
 #include "gtest/gtest.h"
 
 extern "C" {
-    STATIC_UNIT_TESTED extern uint16_t dmaBufferOffset;
     STATIC_UNIT_TESTED void updateTransponderDMABufferIlap(transponder_t *transponder, const uint8_t* transponderData);
     STATIC_UNIT_TESTED void updateTransponderDMABufferArcitimer(transponder_t *transponder, const uint8_t* transponderData);
 }
@@ -58,15 +57,20 @@ TEST(transponderTest, updateTransponderDMABufferArcitimer) {
     };
     uint8_t* transponderData = data;
     transponder_t transponder;
-    transponder.dma_buffer_size = TRANSPONDER_DMA_BUFFER_SIZE_ARCITIMER;
     transponder.bitToggleOne = 78;
-    memset(&(transponder.transponderIrDMABuffer.arcitimer), 0, TRANSPONDER_DMA_BUFFER_SIZE_ARCITIMER);
 
     updateTransponderDMABufferArcitimer(&transponder, transponderData);
+
+    transponderIrDMAValue_t waveform[TRANSPONDER_DMA_BUFFER_SIZE_ARCITIMER];
+    transponderIrWaveformRewind(&transponder);
+    EXPECT_TRUE(transponderIrWaveformFill(&transponder, waveform, TRANSPONDER_DMA_BUFFER_SIZE_ARCITIMER));
     uint16_t i;
-    for(i = 0; i < transponder.dma_buffer_size; i++) {
-        EXPECT_EQ(transponder.transponderIrDMABuffer.arcitimer[i], excepted[i]);
+    for(i = 0; i < TRANSPONDER_DMA_BUFFER_SIZE_ARCITIMER; i++) {
+        EXPECT_EQ(waveform[i], excepted[i]);
     }
+
+    // nothing is left after the whole waveform has been expanded
+    EXPECT_FALSE(transponderIrWaveformFill(&transponder, waveform, TRANSPONDER_DMA_RING_SIZE));
 }
 
 TEST(transponderTest, updateTransponderDMABufferIlap) {
@@ -94,13 +98,19 @@ TEST(transponderTest, updateTransponderDMABufferIlap) {
 
     uint8_t* transponderData = data;
     transponder_t transponder;
-    transponder.dma_buffer_size = TRANSPONDER_DMA_BUFFER_SIZE_ILAP;
     transponder.bitToggleOne = 78;
 
     updateTransponderDMABufferIlap(&transponder, transponderData);
 
+    // expand in ring-half sized pieces, the way the DMA interrupt does
+    transponderIrDMAValue_t waveform[TRANSPONDER_DMA_BUFFER_SIZE_ILAP + TRANSPONDER_DMA_RING_SIZE / 2];
+    transponderIrWaveformRewind(&transponder);
+    for (unsigned offset = 0; offset < TRANSPONDER_DMA_BUFFER_SIZE_ILAP; offset += TRANSPONDER_DMA_RING_SIZE / 2) {
+        EXPECT_TRUE(transponderIrWaveformFill(&transponder, &waveform[offset], TRANSPONDER_DMA_RING_SIZE / 2));
+    }
+
      uint16_t i;
-     for(i = 0; i < transponder.dma_buffer_size; i++) {
-        EXPECT_EQ(transponder.transponderIrDMABuffer.ilap[i], excepted[i]);
+     for(i = 0; i < TRANSPONDER_DMA_BUFFER_SIZE_ILAP; i++) {
+        EXPECT_EQ(waveform[i], excepted[i]);
      }
 }
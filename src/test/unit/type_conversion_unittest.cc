@@ -0,0 +1,100 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "common/typeconversion.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+TEST(TypeConversionTest, TestFmtUint)
+{
+    char buf[FMT_INT_BUFFER_LENGTH];
+
+    char *end = fmtUint(buf, 0, 0, ' ');
+    EXPECT_STREQ("0", buf);
+    EXPECT_EQ(buf + 1, end);
+
+    fmtUint(buf, 4294967295u, 0, ' ');
+    EXPECT_STREQ("4294967295", buf);
+
+    fmtUint(buf, 7, 3, ' ');
+    EXPECT_STREQ("  7", buf);
+
+    fmtUint(buf, 7, 3, '0');
+    EXPECT_STREQ("007", buf);
+
+    // width is a minimum, longer values are not cut
+    fmtUint(buf, 12345, 3, ' ');
+    EXPECT_STREQ("12345", buf);
+}
+
+TEST(TypeConversionTest, TestFmtIntMatchesPrintf)
+{
+    const int32_t values[] = { 0, 1, -1, 9, 10, 99, 100, -100, 101, 999, 1000, 65535, -32768, 2147483647, (int32_t)0x80000000 };
+    char buf[FMT_INT_BUFFER_LENGTH];
+    char expected[16];
+
+    for (unsigned i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        char *end = fmtInt(buf, values[i], 0, ' ');
+        snprintf(expected, sizeof(expected), "%d", values[i]);
+        EXPECT_STREQ(expected, buf);
+        EXPECT_EQ(buf + strlen(buf), end);
+
+        fmtInt(buf, values[i], 5, ' ');
+        snprintf(expected, sizeof(expected), "%5d", values[i]);
+        EXPECT_STREQ(expected, buf);
+
+        fmtInt(buf, values[i], 5, '0');
+        snprintf(expected, sizeof(expected), "%05d", values[i]);
+        EXPECT_STREQ(expected, buf);
+    }
+}
+
+TEST(TypeConversionTest, TestFmtFixed)
+{
+    char buf[FMT_INT_BUFFER_LENGTH];
+
+    fmtFixed(buf, 126, 1, 0);
+    EXPECT_STREQ("12.6", buf);
+
+    fmtFixed(buf, 5, 2, 0);
+    EXPECT_STREQ("0.05", buf);
+
+    fmtFixed(buf, -5, 2, 0);
+    EXPECT_STREQ("-0.05", buf);
+
+    fmtFixed(buf, 1234, 2, 7);
+    EXPECT_STREQ("  12.34", buf);
+
+    fmtFixed(buf, 42, 0, 0);
+    EXPECT_STREQ("42", buf);
+
+    char *end = fmtFixed(buf, 420, 2, 0);
+    EXPECT_STREQ("4.20", buf);
+    EXPECT_EQ(buf + 4, end);
+
+    fmtFixed(buf, 123456789, 9, 0);
+    EXPECT_STREQ("0.123456789", buf);
+}
@@ -89,6 +89,12 @@ static bool displayPortTestIsTransferInProgress(const displayPort_t *displayPort
     return 0;
 }
 
+static bool displayPortTestIsSynced(const displayPort_t *displayPort)
+{
+    UNUSED(displayPort);
+    return true;
+}
+
 static int displayPortTestHeartbeat(displayPort_t *displayPort)
 {
     UNUSED(displayPort);
@@ -115,6 +121,7 @@ static const displayPortVTable_t testDisplayPortVTable = {
     .writeString = displayPortTestWriteString,
     .writeChar = displayPortTestWriteChar,
     .isTransferInProgress = displayPortTestIsTransferInProgress,
+    .isSynced = displayPortTestIsSynced,
     .heartbeat = displayPortTestHeartbeat,
     .resync = displayPortTestResync,
     .txBytesFree = displayPortTestTxBytesFree
@@ -43,6 +43,8 @@ TEST(WS2812, updateDMABuffer) {
 
     // and
     dmaBufferOffset = 0;
+    BIT_COMPARE_1 = 2;
+    BIT_COMPARE_0 = 1;
 
     // when
 #if 0